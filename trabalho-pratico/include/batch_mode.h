@@ -26,13 +26,40 @@
 #ifndef BATCH_MODE_H
 #define BATCH_MODE_H
 
+#include <stddef.h>
+
 #include "testing/performance_metrics.h"
 
 /**
- * @brief Starts batch mode.
+ * @brief Default path of the [container](@ref query_output_container.h) where batch mode writes
+ *        query outputs to, when it's asked not to create a file for each query.
+ */
+#define BATCH_MODE_CONTAINER_PATH "Resultados/outputs.container"
+
+/**
+ * @brief Format of the paths of the [containers](@ref query_output_container.h) where
+ *        ::batch_mode_run_jobs writes the outputs of each job to (given the job's index).
+ */
+#define BATCH_MODE_JOB_CONTAINER_PATH_FORMAT "Resultados/job%zu.container"
+
+/**
+ * @brief Name of the file, in the cache directory, where ::batch_mode_run_streaming keeps a
+ *        snapshot of its database.
+ */
+#define BATCH_MODE_SNAPSHOT_FILE_NAME ".database_snapshot"
+
+/**
+ * @brief   Starts batch mode.
+ * @details By default, the output of each query is written to its own file,
+ *          `Resultados/command<line>_output.txt`. For large query files, creating that many files
+ *          becomes the bottleneck, so all outputs can be written to a single
+ *          [container](@ref query_output_container.h) instead.
  *
  * @param dataset_dir     Path to the directory containing the dataset.
- * @param query_file_path Path to the file containing the queries
+ * @param query_file_path Path to the file containing the queries (in text, or
+ *                        [compiled](@ref query_file_compiler.h)).
+ * @param container_path  Path to the container where to write all query outputs to, or `NULL` to
+ *                        write the output of each query to its own file.
  * @param metrics         Where to register program performance data to. Can be `NULL` for no
  *                        profiling.
  *
@@ -45,6 +72,80 @@
  */
 int batch_mode_run(const char            *dataset_dir,
                    const char            *query_file_path,
+                   const char            *container_path,
                    performance_metrics_t *metrics);
 
+/**
+ * @brief   Starts batch mode, overlapping query parsing, query execution and output.
+ * @details The query file is parsed in a background thread while the dataset is being loaded.
+ *          Queries that don't need statistical data are executed as soon as the database is ready,
+ *          without waiting for the rest of the file to be parsed, and only a bounded number of them
+ *          is kept in memory at once. Their outputs are written to files by a separate writer
+ *          thread. The remaining queries are dispatched together once the whole file is parsed,
+ *          like in ::batch_mode_run.
+ *
+ *          Given a @p cache_dir, the database is loaded with ::dataset_loader_load_cached, from a
+ *          snapshot kept there, so that running many query files against the same dataset only
+ *          parses it once. Reusable statistical data is also kept in @p cache_dir (see
+ *          ::query_statistics_store_t), so that later runs skip generating it. When each query is
+ *          outputted to its own file, outputs are also kept there (see ::query_result_cache_t),
+ *          and queries already executed on a previous run are copied from there instead of being
+ *          executed again. Profiling isn't supported, as measurements of different tasks would
+ *          overlap.
+ *
+ *          The program is expected to exit right after this, so the database and the parsed
+ *          queries are only freed in builds with `FREE_AT_EXIT` defined (see the `Makefile`).
+ *
+ * @param dataset_dir     Path to the directory containing the dataset.
+ * @param cache_dir       Path to the directory where to keep data across runs, or `NULL` not to
+ *                        write anything outside of `Resultados`.
+ * @param query_file_path Path to the file containing the queries (in text, or
+ *                        [compiled](@ref query_file_compiler.h)).
+ * @param container_path  Path to the container where to write all query outputs to, or `NULL` to
+ *                        write the output of each query to its own file.
+ * @param binary          Whether to output [binary records](@ref query_writer_binary_format),
+ *                        meant to be read by other programs, instead of text. Files of binary
+ *                        output are named `Resultados/command<line>_output.bin`.
+ *
+ * @retval 0 Success
+ * @retval 1 Fatal failure (allocation / file IO errors). A message will also be printed to
+ *         `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref batch_mode_examples).
+ */
+int batch_mode_run_streaming(const char *dataset_dir,
+                             const char *cache_dir,
+                             const char *query_file_path,
+                             const char *container_path,
+                             int         binary);
+
+/**
+ * @brief   Starts batch mode for many query files at once, sharing a single database.
+ * @details The database is loaded once (like in ::batch_mode_run_streaming), and then a process is
+ *          forked for every query file. Forked processes only read the database, so its pages are
+ *          never copied, and memory usage doesn't grow with the number of jobs (indexes built
+ *          lazily while executing queries are the exception, as each job builds its own). Job `i`
+ *          writes all its outputs to the container at ::BATCH_MODE_JOB_CONTAINER_PATH_FORMAT.
+ *          Like in ::batch_mode_run_streaming, the database is only freed in builds with
+ *          `FREE_AT_EXIT` defined.
+ *
+ * @param dataset_dir      Path to the directory containing the dataset.
+ * @param cache_dir        Path to the directory where to keep data across runs (like in
+ *                         ::batch_mode_run_streaming), or `NULL`.
+ * @param njobs            Number of query files in @p query_file_paths.
+ * @param query_file_paths Paths to the files containing the queries of each job.
+ *
+ * @retval 0 Success
+ * @retval 1 Fatal failure (allocation / file IO errors) in the parent process or in any job. A
+ *         message will also be printed to `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref batch_mode_examples).
+ */
+int batch_mode_run_jobs(const char *dataset_dir,
+                        const char *cache_dir,
+                        size_t      njobs,
+                        char *const query_file_paths[njobs]);
+
 #endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    benchmark_mode.h
+ * @brief   Benchmark mode (repeatedly load a dataset and run a batch of queries).
+ * @details Unlike the test program, that runs batch mode once (measuring a cold run), this mode
+ *          loads the dataset and replays the query file multiple times, discarding warmup
+ *          iterations, and reports the mean and a 95 % confidence interval of every measurement.
+ *          Query outputs are kept in memory, so that file writing doesn't add noise to the
+ *          results.
+ *
+ * @anchor benchmark_mode_examples
+ * ### Examples
+ *
+ * Build and run the benchmark with `make benchmark DATASET=dataset QUERIES=input.txt`, or run
+ * `./programa-benchmark dataset input.txt -i 20 -w 3` directly. See benchmark.c for all options.
+ * To see where scaling flattens, run `./programa-benchmark dataset input.txt -s`.
+ */
+
+#ifndef BENCHMARK_MODE_H
+#define BENCHMARK_MODE_H
+
+#include <stddef.h>
+
+/**
+ * @struct benchmark_mode_options_t
+ * @brief  Configuration of a benchmark.
+ *
+ * @var benchmark_mode_options_t::dataset_dir
+ *     @brief Path to the directory containing the dataset.
+ * @var benchmark_mode_options_t::query_file_path
+ *     @brief Path to the file containing the queries.
+ * @var benchmark_mode_options_t::load_iterations
+ *     @brief Number of times to load the dataset (at least `1`).
+ * @var benchmark_mode_options_t::warmup_iterations
+ *     @brief Number of times to run the queries before starting to measure.
+ * @var benchmark_mode_options_t::iterations
+ *     @brief Number of measured runs of the queries (at least `1`).
+ * @var benchmark_mode_options_t::parallel
+ *     @brief   Whether to run queries in parallel, like in batch mode.
+ *     @details Per-type measurements require queries to run on a single thread, so only the total
+ *              time of each iteration is measured when this is set. Warmup runs are still done on
+ *              a single thread, and the costs of query types measured in them are used to
+ *              schedule the most expensive work first in measured runs.
+ * @var benchmark_mode_options_t::numa
+ *     @brief Whether, in parallel benchmarks, to pin threads to NUMA nodes and to replicate
+ *            database indices in every node (see ::database_replicate_indexes).
+ * @var benchmark_mode_options_t::scaling
+ *     @brief   Whether to measure how the benchmark scales with the number of threads.
+ *     @details The benchmark is run with 1, 2, 4, ... threads (see ::thread_count_set), up to the
+ *              number of processors, each time in a new process. The time, speedup and parallel
+ *              efficiency of each dataset step, of the whole load, of each query type (run on its
+ *              own) and of the query file are reported for every thread count. Dataset steps are
+ *              measured in profiled loads, where files are loaded one after another, in addition
+ *              to the unprofiled loads used for the whole load.
+ *              ::benchmark_mode_options_t::parallel and ::benchmark_mode_options_t::numa are
+ *              ignored.
+ */
+typedef struct {
+    const char *dataset_dir;
+    const char *query_file_path;
+    size_t      load_iterations, warmup_iterations, iterations;
+    int         parallel, numa, scaling;
+} benchmark_mode_options_t;
+
+/**
+ * @brief Runs a benchmark and prints its results to `stdout`.
+ *
+ * @param options Configuration of the benchmark.
+ *
+ * @retval 0 Success
+ * @retval 1 Fatal failure (allocation / file IO errors). A message will also be printed to
+ *           `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref benchmark_mode_examples).
+ */
+int benchmark_mode_run(const benchmark_mode_options_t *options);
+
+#endif
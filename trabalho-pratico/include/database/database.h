@@ -50,16 +50,27 @@
  *
  *  - Users:       ::database_add_user;
  *  - Flights:     ::database_add_flight (remove a flight using ::database_invalidate_flight);
- *  - Reservation: ::database_add_reservation;
- *  - Passengers:  ::database_add_passengers (passengers must be added all at once).
+ *  - Reservation: ::database_add_reservation or ::database_add_reservations_batch;
+ *  - Passengers:  ::database_add_passengers or ::database_add_passengers_batch (a flight's
+ *                 passengers must be added all at once).
+ *
+ * These methods are serialized by a lock inside the database, so they can be called from multiple
+ * threads at once. However, reading from a manager while another thread modifies it is not safe:
+ * e.g., ::user_manager_get_by_id may only be used concurrently with ::database_add_reservation
+ * after all users have been added.
+ *
+ * A fully loaded database can also be saved to (and loaded from) a binary file, with the
+ * [database_snapshot](@ref database_snapshot.h) module.
  */
 
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include "database/database_statistics.h"
 #include "database/flight_manager.h"
 #include "database/reservation_manager.h"
 #include "database/user_manager.h"
+#include "utils/numa_topology.h"
 
 /** @brief A collection of managers of the different entities. */
 typedef struct database database_t;
@@ -75,9 +86,13 @@ typedef struct database database_t;
 database_t *database_create(void);
 
 /**
- * @brief   Creates a deep copy of a database.
- * @details Databases usually contain lots of data, possibly even gigabytes! Keep that in mind for
- *          performance and memory usage reasons.
+ * @brief   Creates a copy of a database.
+ * @details No data is copied: @p database and its clone share all managers, until one of them is
+ *          modified. Then, only the managers being modified are copied (copy-on-write), which can
+ *          take a while, as databases usually contain lots of data.
+ *
+ *          Because shared managers are never modified, a database and its clones can be read from
+ *          different threads. However, @p database can't be modified while it's being cloned.
  *
  * @param database Database to be cloned.
  *
@@ -107,6 +122,177 @@ const reservation_manager_t *database_get_reservations(const database_t *databas
  */
 const flight_manager_t *database_get_flights(const database_t *database);
 
+/**
+ * @brief   Gets the statistics about the contents of a database.
+ * @details Statistics are updated as entities are added (see
+ *          [database_statistics](@ref database_statistics.h)), so they're always available, even
+ *          for databases loaded from snapshots.
+ *
+ * @param   database Database to get the statistics from.
+ * @returns The statistics of @p database.
+ */
+const database_statistics_t *database_get_statistics(const database_t *database);
+
+/**
+ * @brief   Makes room in a database for a number of entities.
+ * @details Call this before loading a dataset whose size is known (or estimated) beforehand, so
+ *          that the lookup tables of the managers don't need to grow multiple times, and so that
+ *          their pools are allocated at once.
+ *
+ * @param database      Database to be prepared.
+ * @param nusers        Total number of users @p database is expected to contain.
+ * @param nflights      Total number of flights @p database is expected to contain.
+ * @param nreservations Total number of reservations @p database is expected to contain.
+ * @param npassengers   Number of passengers (user-flight relations) expected to be added to
+ *                      @p database.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int database_reserve(database_t *database,
+                     size_t      nusers,
+                     size_t      nflights,
+                     size_t      nreservations,
+                     size_t      npassengers);
+
+/**
+ * @brief   Frees memory a database allocated but isn't using.
+ * @details Call this once a database is fully loaded, so that the memory of a long-lived process
+ *          matches the data it holds. Unused reservations (see ::database_reserve) are freed,
+ *          lookup tables are rebuilt at their final size, user associations are compacted (see
+ *          ::user_manager_compact) and free memory in the heap is returned to the operating system.
+ *          Invalidated flights are removed from storage, moving the remaining ones (see
+ *          ::flight_manager_shrink_to_fit), so @p database mustn't be read from meanwhile, and
+ *          pointers to its flights must not be kept across this call. Managers shared with clones
+ *          (see ::database_clone) are left unchanged.
+ *
+ * @param database Database to be compacted.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (some memory may not have been freed).
+ */
+int database_compact(database_t *database);
+
+/**
+ * @brief   Reorders the entities of a database in memory, so that common index lookups go through
+ *          sequential memory.
+ * @details Flights are clustered by origin and departure date (see ::flight_manager_cluster), and
+ *          reservations by hotel and beginning date (see ::reservation_manager_cluster). The
+ *          associations of users are already stored contiguously, one user after the other, once
+ *          they're compacted (see ::user_manager_compact). Indices are discarded, so that they're
+ *          rebuilt over the new layout. Like ::database_compact, @p database mustn't be read from
+ *          meanwhile, pointers to its flights and reservations must not be kept across this call,
+ *          and managers shared with clones are left unchanged.
+ *
+ * @param database Database to be reordered.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (the managers that couldn't be reordered are left unchanged).
+ */
+int database_cluster(database_t *database);
+
+/** @brief Identifier of an index of a manager in a database, that is built when needed. */
+typedef enum {
+    DATABASE_INDEX_USER_NAMES,               /**< See ::USER_MANAGER_INDEX_NAMES. */
+    DATABASE_INDEX_USER_IDS,                 /**< See ::USER_MANAGER_INDEX_IDS. */
+    DATABASE_INDEX_USER_BITMAPS,             /**< See ::USER_MANAGER_INDEX_BITMAPS. */
+    DATABASE_INDEX_USER_PASSENGERS,          /**< See ::USER_MANAGER_INDEX_PASSENGERS. */
+    DATABASE_INDEX_FLIGHT_COLUMNS,           /**< See ::FLIGHT_MANAGER_INDEX_COLUMNS. */
+    DATABASE_INDEX_FLIGHT_ORIGIN_DEPARTURES, /**< See ::FLIGHT_MANAGER_INDEX_ORIGIN_DEPARTURES. */
+    DATABASE_INDEX_FLIGHT_ROUTE_DEPARTURES,  /**< See ::FLIGHT_MANAGER_INDEX_ROUTE_DEPARTURES. */
+    DATABASE_INDEX_FLIGHT_AIRPORTS,          /**< See ::FLIGHT_MANAGER_INDEX_AIRPORTS. */
+    DATABASE_INDEX_RESERVATION_COLUMNS,      /**< See ::RESERVATION_MANAGER_INDEX_COLUMNS. */
+    DATABASE_INDEX_RESERVATION_HOTELS,       /**< See ::RESERVATION_MANAGER_INDEX_HOTELS. */
+    DATABASE_INDEX_RESERVATION_HOTEL_IDS,    /**< See ::RESERVATION_MANAGER_INDEX_HOTEL_IDS. */
+    DATABASE_INDEX_COUNT                     /**< Number of indices. */
+} database_index_t;
+
+/** @brief A set of ::database_index_t, as a bitmask (see ::DATABASE_INDEX_SET). */
+typedef uint32_t database_index_set_t;
+
+/** @brief Set containing only the index @p index (a ::database_index_t). */
+#define DATABASE_INDEX_SET(index) ((database_index_set_t) 1 << (index))
+
+/** @brief Set of all ::database_index_t. */
+#define DATABASE_INDEX_SET_ALL (DATABASE_INDEX_SET(DATABASE_INDEX_COUNT) - 1)
+
+/** @brief When the indices of a database are built. */
+typedef enum {
+    DATABASE_INDEX_POLICY_EAGER, /**< All indices are built once a dataset is loaded. */
+    DATABASE_INDEX_POLICY_LAZY   /**< Indices are only built when they're first needed. */
+} database_index_policy_t;
+
+/**
+ * @brief   Sets when the indices of a database are built.
+ * @details The policy is read by ::dataset_loader_load (and similar methods), and is inherited by
+ *          clones (::database_clone). Databases start with ::DATABASE_INDEX_POLICY_EAGER. Either
+ *          way, the query dispatcher builds the indices a list of queries needs before running it
+ *          (see ::query_type_get_indexes).
+ *
+ * @param database Database to set the policy of.
+ * @param policy   When to build the indices of @p database.
+ */
+void database_set_index_policy(database_t *database, database_index_policy_t policy);
+
+/**
+ * @brief  Gets when the indices of a database are built.
+ * @param  database Database to get the policy of.
+ * @return The policy set by ::database_set_index_policy.
+ */
+database_index_policy_t database_get_index_policy(const database_t *database);
+
+/** @brief How the entities of a database are ordered in memory once a dataset is loaded. */
+typedef enum {
+    DATABASE_LAYOUT_POLICY_LOAD_ORDER, /**< Entities are kept in the order of the dataset files. */
+    DATABASE_LAYOUT_POLICY_CLUSTERED   /**< Entities are reordered with ::database_cluster. */
+} database_layout_policy_t;
+
+/**
+ * @brief   Sets how the entities of a database are ordered in memory once a dataset is loaded.
+ * @details The policy is read by ::dataset_loader_load (and similar methods), and is inherited by
+ *          clones (::database_clone). Databases start with ::DATABASE_LAYOUT_POLICY_LOAD_ORDER.
+ *          Clustering takes time and temporarily doubles the memory used by flights and
+ *          reservations, so it's meant for databases that answer many queries.
+ *
+ * @param database Database to set the policy of.
+ * @param policy   How to order the entities of @p database.
+ */
+void database_set_layout_policy(database_t *database, database_layout_policy_t policy);
+
+/**
+ * @brief  Gets how the entities of a database are ordered in memory once a dataset is loaded.
+ * @param  database Database to get the policy of.
+ * @return The policy set by ::database_set_layout_policy.
+ */
+database_layout_policy_t database_get_layout_policy(const database_t *database);
+
+/**
+ * @brief   Builds an index of a database, if it isn't built yet.
+ * @details Indices are always built when first needed, so this only moves that work to an earlier
+ *          point. Like adding entities, this must not be done while other threads add to
+ *          @p database. Concurrent calls for the same index build it only once.
+ *
+ * @param database Database whose index is to be built.
+ * @param index    Index to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int database_build_index(const database_t *database, database_index_t index);
+
+/**
+ * @brief   Builds many indices of a database concurrently.
+ * @details Independent indices (e.g.: users by name, flights by origin, reservations by hotel) are
+ *          built on as many threads as there are processors, the most expensive ones first.
+ *
+ * @param database Database whose indices are to be built.
+ * @param indices  Indices to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (some indices may not have been built, and will be when needed).
+ */
+int database_build_indexes(const database_t *database, database_index_set_t indices);
+
 /**
  * @brief Adds a user to @p database.
  *
@@ -122,23 +308,48 @@ int database_add_user(database_t *database, const user_t *user);
  * @brief Adds a reservation to @p database.
  *
  * @param database    Database to add @p reservation to.
+ * @param hotel_names Dictionary with the hotel name of @p reservation.
  * @param reservation Reservation to be added to @p database.
  *
  * @retval 0 Success.
  * @retval 1 Allocation failure.
  */
-int database_add_reservation(database_t *database, const reservation_t *reservation);
+int database_add_reservation(database_t                *database,
+                             const string_dictionary_t *hotel_names,
+                             const reservation_t       *reservation);
+
+/**
+ * @brief   Adds many reservations to @p database.
+ * @details Equivalent to calling ::database_add_reservation for every reservation, but the
+ *          database is only locked once, and the reservations of the batch are associated with
+ *          their users in bulk (see ::user_manager_add_user_reservation_associations).
+ *
+ * @param database     Database to add @p reservations to.
+ * @param hotel_names  Dictionary with the hotel names of @p reservations.
+ * @param n            Number of reservations in @p reservations.
+ * @param reservations Reservations to be added to @p database.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure. Some reservations may have already been added.
+ */
+int database_add_reservations_batch(database_t                *database,
+                                    const string_dictionary_t *hotel_names,
+                                    size_t                     n,
+                                    const reservation_t *const reservations[n]);
 
 /**
  * @brief Adds a flight to @p database.
  *
  * @param database Database to add @p flight to.
+ * @param strings  Dictionary with the airline and plane model of @p flight.
  * @param flight   Flight to be added to @p database.
  *
  * @retval 0 Success.
  * @retval 1 Allocation failure.
  */
-int database_add_flight(database_t *database, const flight_t *flight);
+int database_add_flight(database_t                *database,
+                        const string_dictionary_t *strings,
+                        const flight_t            *flight);
 
 /**
  * @brief   Removes a flight from a database.
@@ -150,6 +361,7 @@ int database_add_flight(database_t *database, const flight_t *flight);
  *
  * @retval 0 Flight was in @p database and was invalidated.
  * @retval 1 Flight not in @p database to begin with.
+ * @retval 2 Allocation failure (flights shared with a clone of @p database couldn't be copied).
  */
 int database_invalidate_flight(database_t *database, flight_id_t id);
 
@@ -158,18 +370,86 @@ int database_invalidate_flight(database_t *database, flight_id_t id);
  * @details All passengers of a flight must be added in bulk.
  *
  * @param database  Database to add passenger relations to.
- * @param flight_id Identifier of the flight to be associated with @p user_ids.
- * @param user_ids  Identifiers of the users to add @p flight_id to.
- * @param n         Number of users in @p user_ids.
+ * @param flight_id Identifier of the flight to be associated with @p users.
+ * @param users     Ordinals of the users to add @p flight_id to (see ::user_manager_get_ordinal).
+ * @param n         Number of users in @p users.
  *
  * @retval 0 Success.
  * @retval 1 Allocation failure, user / flight not found, or too many passengers for number of
  *           flight seats.
  */
-int database_add_passengers(database_t       *database,
-                            flight_id_t       flight_id,
-                            size_t            n,
-                            const char *const user_ids[n]);
+int database_add_passengers(database_t          *database,
+                            flight_id_t          flight_id,
+                            size_t               n,
+                            const user_ordinal_t users[n]);
+
+/**
+ * @struct database_flight_passengers_t
+ * @brief  The passengers of a flight, in a batch added with ::database_add_passengers_batch.
+ *
+ * @var database_flight_passengers_t::flight_id
+ *     @brief Identifier of the flight.
+ * @var database_flight_passengers_t::npassengers
+ *     @brief Number of users in the batch (after the ones of the previous flight) that are
+ *            passengers of ::database_flight_passengers_t::flight_id.
+ * @var database_flight_passengers_t::failed
+ *     @brief Set by ::database_add_passengers_batch to whether ::database_add_passengers would have
+ *            failed for this flight.
+ */
+typedef struct {
+    flight_id_t flight_id;
+    size_t      npassengers;
+    int         failed;
+} database_flight_passengers_t;
+
+/**
+ * @brief   Adds the passengers of multiple flights to the user manager in a database.
+ * @details Equivalent to calling ::database_add_passengers for every flight, but the database is
+ *          only locked once for the whole batch. All passengers of a flight must still be in the
+ *          same batch. A flight failing doesn't stop the others from being added.
+ *
+ * @param database Database to add passenger relations to.
+ * @param nflights Number of flights in @p flights.
+ * @param flights  Flights in the batch, in the same order as their passengers in @p users. Their
+ *                 ::database_flight_passengers_t::failed fields will be set.
+ * @param users    Ordinals of the passengers of all flights in @p flights, one flight after the
+ *                 other.
+ *
+ * @retval 0 Success.
+ * @retval 1 At least one flight failed (see ::database_flight_passengers_t::failed).
+ */
+int database_add_passengers_batch(database_t                  *database,
+                                  size_t                       nflights,
+                                  database_flight_passengers_t flights[nflights],
+                                  const user_ordinal_t        *users);
+
+/**
+ * @brief   Replicates small indices that queries read very often in every NUMA node.
+ * @details Replicates the index of users by name and the per-hotel ratings and index of
+ *          reservations (see ::user_manager_replicate_indexes and
+ *          ::reservation_manager_replicate_indexes). Threads pinned to a node read their node's
+ *          replicas. Must not be done while other threads read from @p database, and replicas are
+ *          discarded when new entities are added.
+ *
+ * @param database Database whose indices are to be replicated.
+ * @param topology NUMA nodes to replicate indices in.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (some indices may not have been replicated).
+ */
+int database_replicate_indexes(const database_t *database, const numa_topology_t *topology);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a database.
+ * @details The sum of the memory usage of all managers (see ::user_manager_get_memory_usage,
+ *          ::reservation_manager_get_memory_usage and ::flight_manager_get_memory_usage). Managers
+ *          shared with clones (see ::database_clone) are counted in full.
+ *
+ * @param database Database to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p database.
+ */
+size_t database_get_memory_usage(const database_t *database);
 
 /**
  * @brief Frees memory used by a database.
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    database_arrow.h
+ * @brief   Export of the entities in a database as Arrow arrays and files.
+ * @details Users, flights and reservations are exported as record batches, through the
+ *          [Arrow C data interface](@ref arrow.h), so that validated data can be handed to other
+ *          tools (e.g.: `pandas`, DuckDB) without being parsed again. Columns kept by the
+ *          [flight](@ref flight_manager_get_columns) and
+ *          [reservation](@ref reservation_manager_get_columns) managers are exported without being
+ *          copied, when their representation matches Arrow's. Other columns (strings, dates, and
+ *          every column of users) are copied.
+ *
+ *          Identifiers of flights and reservations are exported as numbers (without the `Book`
+ *          prefix of reservations), dates as days since the UNIX epoch, and dates with times as
+ *          seconds since the UNIX epoch. Reservations without a rating have a null `rating`.
+ *
+ * ### Example
+ *
+ * ```c
+ * struct ArrowSchema schema;
+ * struct ArrowArray  array;
+ * if (!database_arrow_export(database, DATABASE_ARROW_TABLE_FLIGHTS, &schema, &array)) {
+ *     // Hand schema and array to a consumer, that must call their release callbacks
+ *     // (e.g.: pyarrow.RecordBatch._import_from_c).
+ * }
+ *
+ * database_arrow_write_file(database, DATABASE_ARROW_TABLE_FLIGHTS, "flights.arrow");
+ * ```
+ */
+
+#ifndef DATABASE_ARROW_H
+#define DATABASE_ARROW_H
+
+#include "database/database.h"
+#include "utils/arrow.h"
+
+/** @brief An entity type in a ::database_t that can be exported. */
+typedef enum {
+    DATABASE_ARROW_TABLE_USERS,        /**< @brief Columns of a ::user_t. */
+    DATABASE_ARROW_TABLE_FLIGHTS,      /**< @brief Columns of a ::flight_t. */
+    DATABASE_ARROW_TABLE_RESERVATIONS, /**< @brief Columns of a ::reservation_t. */
+    DATABASE_ARROW_TABLE_COUNT         /**< @brief Number of entity types. */
+} database_arrow_table_t;
+
+/**
+ * @brief  Gets the name of a table, used for naming files.
+ * @param  table Table to get the name of.
+ * @return `users`, `flights` or `reservations`.
+ */
+const char *database_arrow_table_get_name(database_arrow_table_t table);
+
+/**
+ * @brief   Exports all entities of a type in a database as a record batch.
+ * @details Both @p schema and @p array are owned by the caller, and must be released with their
+ *          `release` callbacks. Data borrowed from @p database is only valid until it's modified
+ *          or freed, even if @p array hasn't been released yet.
+ *
+ * @param database Database to be exported.
+ * @param table    Type of the entities to be exported.
+ * @param schema   Where to write the type of the record batch to.
+ * @param array    Where to write the record batch to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (nothing is written to @p schema or @p array).
+ */
+int database_arrow_export(const database_t      *database,
+                          database_arrow_table_t table,
+                          struct ArrowSchema    *schema,
+                          struct ArrowArray     *array);
+
+/**
+ * @brief Writes all entities of a type in a database to an Arrow IPC (Feather V2) file.
+ *
+ * @param database Database to be exported.
+ * @param table    Type of the entities to be exported.
+ * @param path     Path to the file to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or IO failure.
+ */
+int database_arrow_write_file(const database_t      *database,
+                              database_arrow_table_t table,
+                              const char            *path);
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    database_handle.h
+ * @brief   A replaceable database, that can be atomically swapped while it's being read.
+ * @details Readers must hold a ::database_reference_t (see ::database_handle_acquire) while using
+ *          the database. When a new database is swapped in with ::database_handle_swap, the old one
+ *          is only `free`d after its last reference is released, so that a dataset can be loaded
+ *          in the background while queries keep running on the previous one.
+ *
+ * @anchor database_handle_examples
+ * ### Example
+ *
+ * ```c
+ * database_handle_t *handle = database_handle_create();
+ *
+ * // Reader thread
+ * database_reference_t *reference = database_handle_acquire(handle);
+ * if (reference) {
+ *     const database_t *database = database_reference_get(reference);
+ *     // Run queries on database here
+ *     database_reference_release(reference);
+ * }
+ *
+ * // Loader thread (database_t *new_database loaded by dataset_loader_load)
+ * if (database_handle_swap(handle, new_database))
+ *     database_free(new_database);
+ *
+ * // After all threads are done
+ * database_handle_free(handle);
+ * ```
+ */
+
+#ifndef DATABASE_HANDLE_H
+#define DATABASE_HANDLE_H
+
+#include "database/database.h"
+
+/** @brief A replaceable database. */
+typedef struct database_handle database_handle_t;
+
+/** @brief A reference to a database kept alive while a reader uses it. */
+typedef struct database_reference database_reference_t;
+
+/**
+ * @brief   Creates a new handle, containing no database.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::database_handle_free.
+ * @return  The new handle, or `NULL` on failure.
+ */
+database_handle_t *database_handle_create(void);
+
+/**
+ * @brief   Gets a reference to the current database in a handle.
+ * @details The returned reference must be released with ::database_reference_release. The database
+ *          it refers to won't be `free`d, even if it's replaced, until that happens.
+ *
+ * @param handle Handle to get the current database from.
+ *
+ * @return A reference to the current database, or `NULL` if @p handle contains no database.
+ */
+database_reference_t *database_handle_acquire(database_handle_t *handle);
+
+/**
+ * @brief   Replaces the database in a handle.
+ * @details The previous database is `free`d once all references to it are released.
+ *
+ * @param handle   Handle to be modified.
+ * @param database New database, whose ownership is transferred to @p handle on success. Can be
+ *                 `NULL`, to leave @p handle with no database.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p handle is left unchanged, and @p database is still owned by the
+ *           caller).
+ */
+int database_handle_swap(database_handle_t *handle, database_t *database);
+
+/**
+ * @brief   Frees memory used by a handle.
+ * @details Its database is only `free`d after all references to it are released.
+ * @param   handle Handle to be `free`d.
+ */
+void database_handle_free(database_handle_t *handle);
+
+/**
+ * @brief  Gets the database a reference refers to.
+ * @param  reference Reference obtained from ::database_handle_acquire.
+ * @return The database @p reference refers to.
+ */
+const database_t *database_reference_get(const database_reference_t *reference);
+
+/**
+ * @brief Releases a reference to a database, `free`ing the database if it has been replaced and
+ *        this was its last reference.
+ * @param reference Reference obtained from ::database_handle_acquire.
+ */
+void database_reference_release(database_reference_t *reference);
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    database_registry.h
+ * @brief   Databases of many datasets, kept in memory under a memory budget.
+ * @details Switching to a dataset that was recently used shouldn't require loading it again. A
+ *          registry keeps the databases of many datasets resident, as long as their total memory
+ *          usage (see ::database_get_memory_usage) stays under a budget. Once that's exceeded,
+ *          the least recently used databases are evicted: they're saved to a
+ *          [snapshot](@ref database_snapshot.h) (if that wasn't done before) and `free`d, so that
+ *          they can be quickly loaded again on demand.
+ *
+ *          Databases are handed out as clones (see ::database_clone), so a database can keep being
+ *          queried after it's evicted, until its clone is `free`d.
+ *
+ * @anchor database_registry_examples
+ * ### Example
+ *
+ * ```c
+ * database_t *database = database_registry_acquire(registry, path, snapshot_path, fingerprint);
+ * if (!database) {
+ *     database = database_create();
+ *     dataset_loader_load(database, path, NULL, NULL);
+ *     database_registry_add(registry, path, snapshot_path, fingerprint, database, 0);
+ * }
+ *
+ * // Run your queries on database here
+ * database_free(database);
+ * ```
+ *
+ * A registry isn't thread-safe.
+ */
+
+#ifndef DATABASE_REGISTRY_H
+#define DATABASE_REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "database/database.h"
+
+/** @brief Databases of many datasets, kept in memory under a memory budget. */
+typedef struct database_registry database_registry_t;
+
+/**
+ * @brief   Creates a new empty registry.
+ * @details The returned value must be `free`d with ::database_registry_free.
+ *
+ * @param memory_budget Maximum number of bytes used by resident databases. The most recently used
+ *                      database is always kept, even if it alone exceeds this limit.
+ *
+ * @return The new registry, or `NULL` on allocation failure.
+ */
+database_registry_t *database_registry_create(size_t memory_budget);
+
+/**
+ * @brief   Gets the database of a dataset, if it's resident or can be loaded from a snapshot.
+ * @details The database is marked as the most recently used one. A resident database loaded from a
+ *          different version of the dataset (different @p fingerprint) is discarded.
+ *
+ * @param registry      Registry to get the database from.
+ * @param dataset_path  Path to the directory containing the dataset.
+ * @param snapshot_path Where the snapshot of the dataset's database is kept.
+ * @param fingerprint   Identifier of the current version of the dataset (see
+ *                      ::dataset_input_get_fingerprint).
+ *
+ * @return A clone of the database, that must be `free`d with ::database_free, or `NULL` if the
+ *         dataset must be loaded again (or on allocation failure).
+ */
+database_t *database_registry_acquire(database_registry_t *registry,
+                                      const char          *dataset_path,
+                                      const char          *snapshot_path,
+                                      uint64_t             fingerprint);
+
+/**
+ * @brief   Adds the database of a dataset to a registry, as the most recently used one.
+ * @details Any database previously registered for the same dataset is replaced. Least recently
+ *          used databases are evicted to stay under the memory budget.
+ *
+ * @param registry      Registry to be modified.
+ * @param dataset_path  Path to the directory containing the dataset.
+ * @param snapshot_path Where to save the snapshot of @p database to, when it's evicted.
+ * @param fingerprint   Identifier of the version of the dataset @p database was loaded from.
+ * @param database      Fully loaded database. Only a clone of it is kept, so @p database is still
+ *                      owned by the caller.
+ * @param saved         Whether a snapshot of @p database is already in @p snapshot_path.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int database_registry_add(database_registry_t *registry,
+                          const char          *dataset_path,
+                          const char          *snapshot_path,
+                          uint64_t             fingerprint,
+                          const database_t    *database,
+                          int                  saved);
+
+/**
+ * @brief  Gets the number of bytes used by the databases resident in a registry.
+ * @param  registry Registry to get the memory usage of.
+ * @return The memory usage of all resident databases, measured when each one was last used.
+ */
+size_t database_registry_get_memory_usage(const database_registry_t *registry);
+
+/**
+ * @brief   Frees memory used by a registry.
+ * @details Resident databases are `free`d without being saved to their snapshots. Clones handed
+ *          out by ::database_registry_acquire remain valid.
+ *
+ * @param registry Registry to be `free`d.
+ */
+void database_registry_free(database_registry_t *registry);
+
+#endif
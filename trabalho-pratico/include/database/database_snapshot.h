@@ -0,0 +1,73 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    database_snapshot.h
+ * @brief   Binary snapshots of fully loaded databases.
+ * @details Loading a dataset requires parsing and validating every line of its CSV files. A
+ *          snapshot stores only the entities that were accepted into a ::database_t, in a binary
+ *          format, so that the same dataset can be loaded again without any parsing or validation.
+ *
+ * Snapshots are tied to a `fingerprint`, a number that identifies the dataset the snapshot was
+ * created from (see ::dataset_input_get_fingerprint). Loading a snapshot whose fingerprint (or
+ * format version) doesn't match fails, so that outdated snapshots are never used.
+ *
+ * ### Example
+ *
+ * ```c
+ * database_t *database = database_snapshot_load("snapshot.bin", fingerprint);
+ * if (!database) {
+ *     database = database_create();
+ *     dataset_loader_load(database, "/path/to/dataset/directory", NULL, NULL);
+ *     database_snapshot_save(database, "snapshot.bin", fingerprint);
+ * }
+ * ```
+ */
+
+#ifndef DATABASE_SNAPSHOT_H
+#define DATABASE_SNAPSHOT_H
+
+#include <stdint.h>
+
+#include "database/database.h"
+
+/**
+ * @brief Writes a snapshot of a database to a file.
+ *
+ * @param database    Database to be saved.
+ * @param path        Path to the file where to write the snapshot to.
+ * @param fingerprint Identifier of the dataset @p database was loaded from.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int database_snapshot_save(const database_t *database, const char *path, uint64_t fingerprint);
+
+/**
+ * @brief Loads a database from a snapshot file.
+ *
+ * @param path        Path to the snapshot file.
+ * @param fingerprint Identifier of the dataset the snapshot is expected to have been created from.
+ *
+ * @return A new database, that must be `free`d with ::database_free, or `NULL` if the snapshot
+ *         can't be read, is corrupt, was created from a different dataset (@p fingerprint doesn't
+ *         match) or by another version of this program. `NULL` is also returned on allocation
+ *         failure.
+ */
+database_t *database_snapshot_load(const char *path, uint64_t fingerprint);
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    database_statistics.h
+ * @brief   Cheap statistics about the contents of a database, collected as it's loaded.
+ * @details Planning decisions (whether to scan or to use indexes, how much memory to preallocate,
+ *          how to schedule work) need to know the shape of the data, not only its size. These
+ *          statistics are kept up to date by the [database](@ref database.h) as entities are
+ *          added to it, with constant work per entity, so they're available as soon as a dataset
+ *          (or snapshot) is loaded, without iterating through the managers again:
+ *
+ *          - Number of users, flights, reservations and passengers;
+ *          - Number of flights departing from or arriving at each airport;
+ *          - Number of reservations in each hotel;
+ *          - First and last dates of user accounts, flights and reservations;
+ *          - Average number of associations (flights and reservations) per user.
+ *
+ *          Statistics only count what's added: invalidated flights (see
+ *          ::database_invalidate_flight) are still counted.
+ *
+ * @anchor database_statistics_examples
+ * ### Examples
+ *
+ * ```c
+ * const database_statistics_t *statistics = database_get_statistics(database);
+ *
+ * printf("%zu reservations in %zu hotels\n",
+ *        database_statistics_get_reservation_count(statistics),
+ *        database_statistics_get_hotel_count(statistics));
+ * printf("Hotel 1001 has %zu reservations\n",
+ *        database_statistics_get_hotel_frequency(statistics, 1001));
+ *
+ * date_t first, last;
+ * if (!database_statistics_get_reservation_dates(statistics, &first, &last))
+ *     printf("Reservations span %" PRIi64 " days\n", date_diff(last, first));
+ * ```
+ */
+
+#ifndef DATABASE_STATISTICS_H
+#define DATABASE_STATISTICS_H
+
+#include <stddef.h>
+
+#include "types/flight.h"
+#include "types/reservation.h"
+#include "types/user.h"
+#include "utils/date.h"
+#include "utils/date_and_time.h"
+
+/** @brief Statistics about the contents of a database. */
+typedef struct database_statistics database_statistics_t;
+
+/**
+ * @brief   Creates statistics for an empty database.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::database_statistics_free.
+ *
+ * @return The new statistics, or `NULL` on allocation failure.
+ */
+database_statistics_t *database_statistics_create(void);
+
+/**
+ * @brief   Creates a copy of some statistics (e.g.: for a cloned database).
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::database_statistics_free.
+ *
+ * @param statistics Statistics to be copied.
+ *
+ * @return The copy of @p statistics, or `NULL` on allocation failure.
+ */
+database_statistics_t *database_statistics_clone(const database_statistics_t *statistics);
+
+/**
+ * @brief Counts a user added to a database.
+ *
+ * @param statistics Statistics to be modified.
+ * @param user       User that was added.
+ */
+void database_statistics_add_user(database_statistics_t *statistics, const user_t *user);
+
+/**
+ * @brief Counts a flight added to a database.
+ *
+ * @param statistics Statistics to be modified.
+ * @param flight     Flight that was added.
+ */
+void database_statistics_add_flight(database_statistics_t *statistics, const flight_t *flight);
+
+/**
+ * @brief Counts a reservation added to a database.
+ *
+ * @param statistics  Statistics to be modified.
+ * @param reservation Reservation that was added.
+ */
+void database_statistics_add_reservation(database_statistics_t *statistics,
+                                         const reservation_t   *reservation);
+
+/**
+ * @brief Counts passengers added to a database.
+ *
+ * @param statistics  Statistics to be modified.
+ * @param npassengers Number of passengers added to a flight.
+ */
+void database_statistics_add_passengers(database_statistics_t *statistics, size_t npassengers);
+
+/**
+ * @brief  Gets the number of users added to a database.
+ * @param  statistics Statistics of the database.
+ * @return The number of users in the database.
+ */
+size_t database_statistics_get_user_count(const database_statistics_t *statistics);
+
+/**
+ * @brief  Gets the number of flights added to a database.
+ * @param  statistics Statistics of the database.
+ * @return The number of flights in the database (including invalidated ones).
+ */
+size_t database_statistics_get_flight_count(const database_statistics_t *statistics);
+
+/**
+ * @brief  Gets the number of reservations added to a database.
+ * @param  statistics Statistics of the database.
+ * @return The number of reservations in the database.
+ */
+size_t database_statistics_get_reservation_count(const database_statistics_t *statistics);
+
+/**
+ * @brief  Gets the number of passengers added to a database.
+ * @param  statistics Statistics of the database.
+ * @return The number of passengers (associations between users and flights) in the database.
+ */
+size_t database_statistics_get_passenger_count(const database_statistics_t *statistics);
+
+/**
+ * @brief   Gets the average number of associations of each user.
+ * @details Every passenger and every reservation is associated with a user.
+ *
+ * @param statistics Statistics of the database.
+ *
+ * @return The number of passengers and reservations per user, or `0` if there are no users.
+ */
+double database_statistics_get_associations_per_user(const database_statistics_t *statistics);
+
+/**
+ * @brief  Gets the number of distinct airports flights depart from or arrive at.
+ * @param  statistics Statistics of the database.
+ * @return The number of airports in the database.
+ */
+size_t database_statistics_get_airport_count(const database_statistics_t *statistics);
+
+/**
+ * @brief Gets the number of flights departing from or arriving at an airport.
+ *
+ * @param statistics Statistics of the database.
+ * @param airport    Airport to get the number of flights of.
+ *
+ * @return The number of flights of @p airport (flights from and to it are counted twice).
+ */
+size_t database_statistics_get_airport_frequency(const database_statistics_t *statistics,
+                                                 airport_code_t               airport);
+
+/**
+ * @brief  Gets the number of distinct hotels with reservations.
+ * @param  statistics Statistics of the database.
+ * @return The number of hotels in the database.
+ */
+size_t database_statistics_get_hotel_count(const database_statistics_t *statistics);
+
+/**
+ * @brief Gets the number of reservations in a hotel.
+ *
+ * @param statistics Statistics of the database.
+ * @param hotel      Hotel to get the number of reservations of.
+ *
+ * @return The number of reservations in @p hotel.
+ */
+size_t database_statistics_get_hotel_frequency(const database_statistics_t *statistics,
+                                               hotel_id_t                   hotel);
+
+/**
+ * @brief Gets the range of account creation dates of users.
+ *
+ * @param statistics Statistics of the database.
+ * @param first      Where to write the earliest account creation date to.
+ * @param last       Where to write the latest account creation date to.
+ *
+ * @retval 0 Success.
+ * @retval 1 There are no users (@p first and @p last aren't written).
+ */
+int database_statistics_get_user_dates(const database_statistics_t *statistics,
+                                       date_and_time_t             *first,
+                                       date_and_time_t             *last);
+
+/**
+ * @brief Gets the range of scheduled departure dates of flights.
+ *
+ * @param statistics Statistics of the database.
+ * @param first      Where to write the earliest scheduled departure date to.
+ * @param last       Where to write the latest scheduled departure date to.
+ *
+ * @retval 0 Success.
+ * @retval 1 There are no flights (@p first and @p last aren't written).
+ */
+int database_statistics_get_flight_dates(const database_statistics_t *statistics,
+                                         date_and_time_t             *first,
+                                         date_and_time_t             *last);
+
+/**
+ * @brief Gets the range of dates covered by reservations.
+ *
+ * @param statistics Statistics of the database.
+ * @param first      Where to write the earliest beginning date of a reservation to.
+ * @param last       Where to write the latest end date of a reservation to.
+ *
+ * @retval 0 Success.
+ * @retval 1 There are no reservations (@p first and @p last aren't written).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref database_statistics_examples).
+ */
+int database_statistics_get_reservation_dates(const database_statistics_t *statistics,
+                                              date_t                      *first,
+                                              date_t                      *last);
+
+/**
+ * @brief  Gets the number of bytes of memory used by some statistics.
+ * @param  statistics Statistics to get the memory usage of.
+ * @return The memory usage of @p statistics, in bytes.
+ */
+size_t database_statistics_get_memory_usage(const database_statistics_t *statistics);
+
+/**
+ * @brief Frees memory used by some statistics.
+ * @param statistics Statistics to be `free`d.
+ */
+void database_statistics_free(database_statistics_t *statistics);
+
+#endif
@@ -34,11 +34,11 @@
  * #include "utils/pool.h"
  *
  * int iter_callback(void *user_data, const flight_t *flight) {
- *     (void) user_data;
+ *     const string_dictionary_t *strings = user_data;
  *
  *     const flight_id_t id          = flight_get_id(flight);
- *     const char       *airline     = flight_get_const_airline(flight);
- *     const char       *passport    = flight_get_const_plane_model(flight);
+ *     const char       *airline     = flight_get_const_airline(strings, flight);
+ *     const char       *passport    = flight_get_const_plane_model(strings, flight);
  *     uint16_t          total_seats = flight_get_total_seats(flight);
  *
  *     char origin[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
@@ -87,7 +87,8 @@
  *         return 1;
  *     }
  *
- *     flight_manager_iter(database_get_flights(database), iter_callback, NULL);
+ *     const flight_manager_t *flights = database_get_flights(database);
+ *     flight_manager_iter(flights, iter_callback, (void *) flight_manager_get_strings(flights));
  *
  *     database_free(database);
  *     return 0;
@@ -107,6 +108,7 @@
 #define FLIGHT_MANAGER_H
 
 #include "types/flight.h"
+#include "utils/prefix_index.h"
 
 /** @brief A data type that contains and manages all flights in a database. */
 typedef struct flight_manager flight_manager_t;
@@ -123,6 +125,85 @@ typedef struct flight_manager flight_manager_t;
  */
 typedef int (*flight_manager_iter_callback_t)(void *user_data, const flight_t *flight);
 
+/**
+ * @brief   Callback type for flight manager iterations over groups of flights.
+ * @details Method called by ::flight_manager_iter_blocks and ::flight_manager_iter_blocks_parallel
+ *          for groups of flights in a ::flight_manager_t, so that a single call is made for many
+ *          flights. Invalid flights are skipped.
+ *
+ * @param user_data Argument passed to ::flight_manager_iter_blocks, that is then passed to every
+ *                  callback, so that this method can change the program's state.
+ * @param flights   Array of @p n pointers to flights in the manager. Only valid during this call.
+ * @param n         Number of elements in @p flights. Never `0`.
+ *
+ * @return `0` on success, or any other value to order iteration to stop.
+ */
+typedef int (*flight_manager_iter_blocks_callback_t)(void           *user_data,
+                                                     const flight_t *const *flights,
+                                                     size_t          n);
+
+/**
+ * @struct  flight_manager_columns_t
+ * @brief   Some fields of consecutive valid flights, each one stored in a separate array.
+ * @details Element `i` of every array belongs to the same flight (see
+ *          ::flight_manager_iter_columns).
+ *
+ * @var flight_manager_columns_t::id
+ *     @brief Identifiers of the flights.
+ * @var flight_manager_columns_t::origin
+ *     @brief Origin airports of the flights.
+ * @var flight_manager_columns_t::destination
+ *     @brief Destination airports of the flights.
+ * @var flight_manager_columns_t::origin_ordinal
+ *     @brief   Indices of the origin airports of the flights in
+ *              ::flight_manager_columns_t::airports.
+ *     @details Per-airport aggregations can be arrays of ::flight_manager_columns_t::nairports
+ *              elements indexed by these, without hashing airport codes.
+ * @var flight_manager_columns_t::destination_ordinal
+ *     @brief Indices of the destination airports of the flights in
+ *            ::flight_manager_columns_t::airports.
+ * @var flight_manager_columns_t::airports
+ *     @brief   Dictionary of all airports of all flights in the manager, in alphabetical order.
+ *     @details The same for every block of an iteration.
+ * @var flight_manager_columns_t::nairports
+ *     @brief Number of elements in ::flight_manager_columns_t::airports.
+ * @var flight_manager_columns_t::schedule_departure_date
+ *     @brief Scheduled departure dates of the flights.
+ * @var flight_manager_columns_t::real_departure_date
+ *     @brief Real departure dates of the flights.
+ * @var flight_manager_columns_t::number_of_passengers
+ *     @brief Number of passengers of the flights.
+ */
+typedef struct {
+    const flight_id_t     *id;
+    const airport_code_t  *origin;
+    const airport_code_t  *destination;
+    const uint16_t        *origin_ordinal;
+    const uint16_t        *destination_ordinal;
+    const airport_code_t  *airports;
+    size_t                 nairports;
+    const date_and_time_t *schedule_departure_date;
+    const date_and_time_t *real_departure_date;
+    const uint16_t        *number_of_passengers;
+} flight_manager_columns_t;
+
+/**
+ * @brief   Callback type for column-wise flight manager iterations.
+ * @details Method called by ::flight_manager_iter_columns for every block of flights in a
+ *          ::flight_manager_t.
+ *
+ * @param user_data Argument passed to ::flight_manager_iter_columns, that is then passed to every
+ *                  callback, so that this method can change the program's state.
+ * @param columns   Fields of the flights in the block.
+ * @param n         Number of flights in the block (number of elements in each array in
+ *                  @p columns).
+ *
+ * @return `0` on success, or any other value to order iteration to stop.
+ */
+typedef int (*flight_manager_iter_columns_callback_t)(void                           *user_data,
+                                                      const flight_manager_columns_t *columns,
+                                                      size_t                          n);
+
 /**
  * @brief   Instantiates a new ::flight_manager_t.
  * @details The returned value is owned by the caller and should be `free`d with
@@ -147,12 +228,61 @@ flight_manager_t *flight_manager_clone(const flight_manager_t *manager);
  * @brief Adds a flight to a flight manager.
  *
  * @param manager Flight manager to add @p flight to.
+ * @param strings Dictionary with the airline and plane model of @p flight.
  * @param flight  Flight to add to @p manager.
  *
  * @retval 0 Success.
  * @retval 1 Allocation failure.
  */
-int flight_manager_add_flight(flight_manager_t *manager, const flight_t *flight);
+int flight_manager_add_flight(flight_manager_t          *manager,
+                              const string_dictionary_t *strings,
+                              const flight_t            *flight);
+
+/**
+ * @brief   Makes room in a flight manager for a number of flights.
+ * @details Call this before adding many flights whose number is known beforehand, so that the
+ *          manager's lookup table doesn't need to grow multiple times, and so that its pool is
+ *          allocated at once.
+ *
+ * @param manager Flight manager to be prepared.
+ * @param n       Total number of flights @p manager is expected to contain.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int flight_manager_reserve(flight_manager_t *manager, size_t n);
+
+/**
+ * @brief   Frees memory a flight manager allocated but isn't using.
+ * @details Undoes unused reservations made by ::flight_manager_reserve and shrinks the lookup
+ *          table to the range of identifiers in use. If any flight was invalidated (see
+ *          ::flight_manager_invalidate_by_id), valid flights are moved to new storage without the
+ *          invalidated ones, so that iterations don't go through (nor check the validity of) dead
+ *          flights. Pointers to flights obtained before this call are then no longer valid, and
+ *          lookups in @p manager mustn't happen meanwhile.
+ *
+ * @param manager Flight manager to be shrunk.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (some memory may not have been freed).
+ */
+int flight_manager_shrink_to_fit(flight_manager_t *manager);
+
+/**
+ * @brief   Moves the flights of a flight manager so that flights from the same origin are close.
+ * @details Flights are stored in the order of ::flight_manager_iter_origin_departures (by origin,
+ *          and from the latest to the earliest departure), instead of the order they were added
+ *          in, so that iterating through an airport's departures goes through sequential memory.
+ *          Invalidated flights are removed, like in ::flight_manager_shrink_to_fit. Pointers to
+ *          flights obtained before this call are then no longer valid, and lookups in @p manager
+ *          mustn't happen meanwhile. Requires enough memory for a second copy of all flights.
+ *
+ * @param manager Flight manager whose flights are reordered.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p manager is left unchanged).
+ */
+int flight_manager_cluster(flight_manager_t *manager);
 
 /**
  * @brief Adds a number of passengers to a flight in a flight manager.
@@ -177,10 +307,42 @@ int flight_manager_add_passagers(flight_manager_t *manager, flight_id_t id, int
  */
 const flight_t *flight_manager_get_by_id(const flight_manager_t *manager, flight_id_t id);
 
+/**
+ * @brief   Gets many flights in a flight manager from their identifiers.
+ * @details Same as calling ::flight_manager_get_by_id for every identifier, but all flights are
+ *          found and prefetched before being returned, so that reading them doesn't wait for one
+ *          cache miss at a time.
+ *
+ * @param manager Flight manager to search in.
+ * @param n       Number of flights to look for.
+ * @param ids     Identifiers of the flights to look for.
+ * @param flights Where to write the found flights to (`NULL` for identifiers not in @p manager).
+ */
+void flight_manager_get_by_ids(const flight_manager_t *manager,
+                               size_t                  n,
+                               const flight_id_t       ids[n],
+                               const flight_t         *flights[n]);
+
+/**
+ * @brief  Gets the number of flights in a flight manager.
+ * @param  manager Flight manager to get the number of flights from.
+ * @return The number of (valid) flights in @p manager.
+ */
+size_t flight_manager_get_length(const flight_manager_t *manager);
+
+/**
+ * @brief  Gets the dictionary of airlines and plane models of the flights in a flight manager.
+ * @param  manager Flight manager to get the dictionary from.
+ * @return The dictionary to be passed to string getters of flights in @p manager (e.g.:
+ *         ::flight_get_const_airline).
+ */
+const string_dictionary_t *flight_manager_get_strings(const flight_manager_t *manager);
+
 /**
  * @brief   Invalidates a flight stored in a manager.
  * @details Memory can't be `free`d by deleting a flight, given the internal structure of the
- *          manager. However, the deleted flight won't appear in later lookups or iterations.
+ *          manager, until ::flight_manager_shrink_to_fit is called. However, the deleted flight
+ *          won't appear in later lookups or iterations.
  *
  * @param manager Flight manager remove a flight from.
  * @param id      Identifier of the flight to invalidate.
@@ -204,6 +366,329 @@ int flight_manager_iter(const flight_manager_t        *manager,
                         flight_manager_iter_callback_t callback,
                         void                          *user_data);
 
+/**
+ * @brief   Iterates through every flight in a flight manager, calling a callback for groups of
+ *          flights.
+ * @details Flights are provided in the same order as ::flight_manager_iter. Invalid flights are
+ *          skipped.
+ *
+ * @param manager   Flight manager to iterate through.
+ * @param callback  Method to be called for every group of flights stored in @p manager.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int flight_manager_iter_blocks(const flight_manager_t                *manager,
+                               flight_manager_iter_blocks_callback_t callback,
+                               void                                  *user_data);
+
+/**
+ * @brief   Iterates through every flight in a flight manager, splitting groups of flights across
+ *          multiple threads.
+ * @details Each thread is given a disjoint range of the manager's flights. Callbacks in different
+ *          threads are called concurrently, so they mustn't modify the same data, and @p manager
+ *          mustn't be modified during the iteration.
+ *
+ * @param manager   Flight manager to iterate through.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method to be called for every group of flights stored in @p manager.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by the last @p callback of a thread (threads ordered
+ *         as @p user_data), or `0` if no thread was stopped.
+ */
+int flight_manager_iter_blocks_parallel(const flight_manager_t                *manager,
+                                        size_t                                nthreads,
+                                        flight_manager_iter_blocks_callback_t callback,
+                                        void *const                           *user_data);
+
+/**
+ * @brief   Iterates through blocks of flights in a flight manager, field by field.
+ * @details Scans that only need a few fields of every flight should prefer this method to
+ *          ::flight_manager_iter, as only those fields are read from memory, in a way that can be
+ *          easily vectorized.
+ *
+ *          The columns are built the first time this method is called, and kept until flights are
+ *          added to, modified or invalidated in @p manager. Building the columns is thread-safe,
+ *          but modifying @p manager while iterating over it isn't.
+ *
+ *          Flights are partitioned by the month of their scheduled departure date: they're
+ *          provided from the earliest month to the latest one, and in no particular order within
+ *          a month. See ::flight_manager_iter_columns_between.
+ *
+ * @param manager   Flight manager to iterate over.
+ * @param callback  Method called for every block of flights in @p manager.
+ * @param user_data Argument passed to @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback), or `1` if the columns couldn't be allocated.
+ */
+int flight_manager_iter_columns(const flight_manager_t                *manager,
+                                flight_manager_iter_columns_callback_t callback,
+                                void                                  *user_data);
+
+/**
+ * @brief   Iterates through blocks of flights in a flight manager, field by field, splitting the
+ *          blocks across multiple threads.
+ * @details See ::flight_manager_iter_columns. Each thread is given a disjoint range of consecutive
+ *          blocks. Callbacks in different threads are called concurrently, so they mustn't modify
+ *          the same data.
+ *
+ * @param manager   Flight manager to iterate through.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method called for every block of flights in @p manager.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by the last @p callback of a thread (threads ordered
+ *         as @p user_data), `1` if the columns couldn't be allocated, or `0` on success.
+ */
+int flight_manager_iter_columns_parallel(const flight_manager_t                *manager,
+                                         size_t                                 nthreads,
+                                         flight_manager_iter_columns_callback_t callback,
+                                         void *const                           *user_data);
+
+/**
+ * @brief   Iterates through blocks of flights in a flight manager, field by field, skipping the
+ *          months outside a range of scheduled departure dates.
+ * @details See ::flight_manager_iter_columns. Only the partitions of the months between @p begin
+ *          and @p end are iterated through, and blocks whose earliest and latest scheduled
+ *          departure dates are both outside that range are skipped. Some provided flights may
+ *          still be outside the range, and must be filtered out by @p callback.
+ *
+ * @param manager   Flight manager to iterate over.
+ * @param begin     Earliest scheduled departure date (inclusive) of the flights that are needed.
+ * @param end       Latest scheduled departure date (inclusive) of the flights that are needed.
+ * @param callback  Method called for every block of flights that may be in the range.
+ * @param user_data Argument passed to @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback), or `1` if the columns couldn't be allocated.
+ */
+int flight_manager_iter_columns_between(const flight_manager_t                *manager,
+                                        date_t                                 begin,
+                                        date_t                                 end,
+                                        flight_manager_iter_columns_callback_t callback,
+                                        void                                  *user_data);
+
+/**
+ * @brief   Iterates through blocks of flights in a flight manager, field by field, skipping the
+ *          months outside a range of scheduled departure dates, and splitting the blocks across
+ *          multiple threads.
+ * @details See ::flight_manager_iter_columns_between and ::flight_manager_iter_columns_parallel.
+ *
+ * @param manager   Flight manager to iterate through.
+ * @param begin     Earliest scheduled departure date (inclusive) of the flights that are needed.
+ * @param end       Latest scheduled departure date (inclusive) of the flights that are needed.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method called for every block of flights that may be in the range.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by the last @p callback of a thread (threads ordered
+ *         as @p user_data), `1` if the columns couldn't be allocated, or `0` on success.
+ */
+int flight_manager_iter_columns_between_parallel(const flight_manager_t                *manager,
+                                                 date_t                                 begin,
+                                                 date_t                                 end,
+                                                 size_t                                 nthreads,
+                                                 flight_manager_iter_columns_callback_t callback,
+                                                 void *const                           *user_data);
+
+/**
+ * @brief   Gets the fields of all flights in a flight manager, each one in a single array.
+ * @details Rows are in the same order as in ::flight_manager_iter_columns. The arrays are owned by
+ *          @p manager, and are only valid until flights are added to, modified or invalidated in
+ *          it.
+ *
+ * @param manager Flight manager to get the columns from.
+ * @param columns Where to output the columns to.
+ * @param n       Where to output the number of flights (of elements in each column) to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int flight_manager_get_columns(const flight_manager_t   *manager,
+                               flight_manager_columns_t *columns,
+                               size_t                   *n);
+
+/**
+ * @brief   Iterates through the flights departing from an airport during a range of time.
+ * @details Flights are provided from the latest to the earliest scheduled departure date, with
+ *          ties broken by flight identifier (in ascending order).
+ *
+ *          An index of flights by origin and scheduled departure date is built the first time this
+ *          method is called, and kept until flights are added to or invalidated in @p manager.
+ *          Building the index is thread-safe, but modifying @p manager while iterating over it
+ *          isn't.
+ *
+ * @param manager   Flight manager to iterate over.
+ * @param origin    Origin airport of all iterated flights.
+ * @param begin     Earliest scheduled departure date (inclusive) of all iterated flights.
+ * @param end       Latest scheduled departure date (inclusive) of all iterated flights.
+ * @param callback  Method called for every matching flight in @p manager.
+ * @param user_data Argument passed to @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int flight_manager_iter_origin_departures(const flight_manager_t        *manager,
+                                          airport_code_t                 origin,
+                                          date_and_time_t                begin,
+                                          date_and_time_t                end,
+                                          flight_manager_iter_callback_t callback,
+                                          void                          *user_data);
+
+/**
+ * @brief   Iterates through a range of the flights departing from an airport during a range of
+ *          time.
+ * @details See ::flight_manager_iter_origin_departures. Flights outside of the range aren't looked
+ *          at, so pages of results can be obtained without iterating through previous ones.
+ *
+ * @param manager   Flight manager to iterate over.
+ * @param origin    Origin airport of all iterated flights.
+ * @param begin     Earliest scheduled departure date (inclusive) of all iterated flights.
+ * @param end       Latest scheduled departure date (inclusive) of all iterated flights.
+ * @param offset    Number of matching flights, in the order of
+ *                  ::flight_manager_iter_origin_departures, to be left out at the beginning.
+ * @param limit     Maximum number of flights to be iterated over (`SIZE_MAX` for no limit).
+ * @param callback  Method called for every flight in the range.
+ * @param user_data Argument passed to @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int flight_manager_iter_origin_departures_range(const flight_manager_t        *manager,
+                                                airport_code_t                 origin,
+                                                date_and_time_t                begin,
+                                                date_and_time_t                end,
+                                                size_t                         offset,
+                                                size_t                         limit,
+                                                flight_manager_iter_callback_t callback,
+                                                void                          *user_data);
+
+/**
+ * @brief   Iterates through the flights of a route (from an airport to another) during a range of
+ *          time.
+ * @details Flights are provided in the same order as in ::flight_manager_iter_origin_departures.
+ *
+ *          An index of flights by origin, destination and scheduled departure date is built the
+ *          first time this method is called, and kept until flights are added to or invalidated in
+ *          @p manager. Building the index is thread-safe, but modifying @p manager while iterating
+ *          over it isn't. Lookups take logarithmic time, and only matching flights are visited.
+ *
+ * @param manager     Flight manager to iterate over.
+ * @param origin      Origin airport of all iterated flights.
+ * @param destination Destination airport of all iterated flights.
+ * @param begin       Earliest scheduled departure date (inclusive) of all iterated flights.
+ * @param end         Latest scheduled departure date (inclusive) of all iterated flights.
+ * @param callback    Method called for every matching flight in @p manager.
+ * @param user_data   Argument passed to @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int flight_manager_iter_route_departures(const flight_manager_t        *manager,
+                                         airport_code_t                 origin,
+                                         airport_code_t                 destination,
+                                         date_and_time_t                begin,
+                                         date_and_time_t                end,
+                                         flight_manager_iter_callback_t callback,
+                                         void                          *user_data);
+
+/**
+ * @brief   Iterates through a range of the flights of a route during a range of time.
+ * @details See ::flight_manager_iter_route_departures. Flights outside of the range aren't looked
+ *          at, so pages of results can be obtained without iterating through previous ones.
+ *
+ * @param manager     Flight manager to iterate over.
+ * @param origin      Origin airport of all iterated flights.
+ * @param destination Destination airport of all iterated flights.
+ * @param begin       Earliest scheduled departure date (inclusive) of all iterated flights.
+ * @param end         Latest scheduled departure date (inclusive) of all iterated flights.
+ * @param offset      Number of matching flights, in the order of
+ *                    ::flight_manager_iter_route_departures, to be left out at the beginning.
+ * @param limit       Maximum number of flights to be iterated over (`SIZE_MAX` for no limit).
+ * @param callback    Method called for every flight in the range.
+ * @param user_data   Argument passed to @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int flight_manager_iter_route_departures_range(const flight_manager_t        *manager,
+                                               airport_code_t                 origin,
+                                               airport_code_t                 destination,
+                                               date_and_time_t                begin,
+                                               date_and_time_t                end,
+                                               size_t                         offset,
+                                               size_t                         limit,
+                                               flight_manager_iter_callback_t callback,
+                                               void                          *user_data);
+
+/**
+ * @brief   Iterates through the codes of all airports (origins and destinations of valid flights)
+ *          that start with a prefix.
+ * @details Codes are iterated in byte order. An index of codes is built when this is first called
+ *          (and after flights are added or invalidated), so that following lookups are quick
+ *          enough to be done on every keystroke (e.g.: for autocompletion).
+ *
+ * @param manager   Flight manager to iterate through.
+ * @param prefix    Prefix that all iterated airport codes must start with.
+ * @param callback  Method to be called for every matching airport code.
+ * @param user_data Pointer to be passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int flight_manager_iter_airport_prefix(const flight_manager_t      *manager,
+                                       const char                  *prefix,
+                                       prefix_index_iter_callback_t callback,
+                                       void                        *user_data);
+
+/** @brief Indices of a flight manager that are built the first time they're needed. */
+typedef enum {
+    FLIGHT_MANAGER_INDEX_COLUMNS,           /**< See ::flight_manager_iter_columns. */
+    FLIGHT_MANAGER_INDEX_ORIGIN_DEPARTURES, /**< See ::flight_manager_iter_origin_departures. */
+    FLIGHT_MANAGER_INDEX_ROUTE_DEPARTURES,  /**< See ::flight_manager_iter_route_departures. */
+    FLIGHT_MANAGER_INDEX_AIRPORTS,          /**< See ::flight_manager_iter_airport_prefix. */
+    FLIGHT_MANAGER_INDEX_COUNT              /**< Number of indices. */
+} flight_manager_index_t;
+
+/**
+ * @brief   Builds an index of a flight manager, if it isn't built yet.
+ * @details Different indices can be built concurrently, from different threads, but not while
+ *          flights are being added to @p manager.
+ *
+ * @param manager Flight manager to build an index of.
+ * @param index   Index to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int flight_manager_build_index(const flight_manager_t *manager, flight_manager_index_t index);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a flight manager.
+ * @details Includes all flights, their strings, identifier lookup tables and any indices that are
+ *          currently built.
+ *
+ * @param manager Flight manager to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p manager.
+ */
+size_t flight_manager_get_memory_usage(const flight_manager_t *manager);
+
+/**
+ * @brief  Gets the number of bytes of memory allocated for strings in a flight manager.
+ * @param  manager Flight manager to get the memory usage of.
+ * @return The number of bytes allocated by the string pool of @p manager (already included in
+ *         ::flight_manager_get_memory_usage).
+ */
+size_t flight_manager_get_strings_memory_usage(const flight_manager_t *manager);
+
 /**
  * @brief Frees memory used by a flight manager.
  * @param manager Flight manager whose memory is to be `free`'d.
@@ -34,10 +34,11 @@
  *
  * // Callback called for every reservation in the database, that prints it to the screen.
  * int iter_callback(void *user_data, const reservation_t *reservation) {
- *     (void) user_data;
+ *     const string_dictionary_t *hotel_names = user_data;
  *
- *     const char      *user_id         = reservation_get_const_user_id(reservation);
- *     const char      *hotel_name      = reservation_get_const_hotel_name(reservation);
+ *     user_ordinal_t   user            = reservation_get_user(reservation);
+ *     const char      *hotel_name      =
+ *         reservation_get_const_hotel_name(hotel_names, reservation);
  *     reservation_id_t id              = reservation_get_id(reservation);
  *     uint8_t          rating          = reservation_get_rating(reservation);
  *     hotel_id_t       hotel_id        = reservation_get_hotel_id(reservation);
@@ -61,10 +62,10 @@
  *     char reservation_id_str[RESERVATION_ID_SPRINTF_MIN_BUFFER_SIZE];
  *     reservation_id_sprintf(reservation_id_str, id);
  *
- *     printf("--- RESERVATION ---\nuser_id: %s\nhotel_name: %s\nincludes_breakfast: %s\n"
+ *     printf("--- RESERVATION ---\nuser: %" PRIu32 "\nhotel_name: %s\nincludes_breakfast: %s\n"
  *            "begin_date: %s\nend_date: %s\nid: %s\nrating: " PRIu8 "\nhotel_id: %s\n"
  *            "hotel_stars: " PRIu8 "\n city_tax: " PRIu8 "\nprice_per_night: " PRIu16 "\n\n",
- *            user_id,
+ *            user,
  *            hotel_name,
  *            includes_breakfast,
  *            begin_date,
@@ -91,7 +92,10 @@
  *         return 1;
  *     }
  *
- *     reservation_manager_iter(database_get_reservations(database), iter_callback, NULL);
+ *     const reservation_manager_t *reservations = database_get_reservations(database);
+ *     reservation_manager_iter(reservations,
+ *                              iter_callback,
+ *                              (void *) reservation_manager_get_hotel_names(reservations));
  *
  *     database_free(database);
  *     return 0;
@@ -111,6 +115,9 @@
 #define RESERVATION_MANAGER_H
 
 #include "types/reservation.h"
+#include "utils/compressed_bitmap.h"
+#include "utils/numa_topology.h"
+#include "utils/prefix_index.h"
 
 /** @brief A data type that contains and manages all reservations in a database. */
 typedef struct reservation_manager reservation_manager_t;
@@ -128,6 +135,85 @@ typedef struct reservation_manager reservation_manager_t;
 typedef int (*reservation_manager_iter_callback_t)(void                *user_data,
                                                    const reservation_t *reservation);
 
+/**
+ * @brief   Callback type for reservation manager iterations over groups of reservations.
+ * @details Method called by ::reservation_manager_iter_blocks and
+ *          ::reservation_manager_iter_blocks_parallel for groups of reservations in a
+ *          ::reservation_manager_t, so that a single call is made for many reservations.
+ *
+ * @param user_data    Argument passed to ::reservation_manager_iter_blocks, that is then passed to
+ *                     every callback, so that this method can change the program's state.
+ * @param reservations Array of @p n pointers to reservations in the manager. Only valid during
+ *                     this call.
+ * @param n            Number of elements in @p reservations. Never `0`.
+ *
+ * @return `0` on success, or any other value to order iteration to stop.
+ */
+typedef int (*reservation_manager_iter_blocks_callback_t)(void                *user_data,
+                                                          const reservation_t *const *reservations,
+                                                          size_t               n);
+
+/**
+ * @struct  reservation_manager_columns_t
+ * @brief   Some fields of consecutive reservations, each one stored in a separate array.
+ * @details Element `i` of every array belongs to the same reservation (see
+ *          ::reservation_manager_iter_columns).
+ *
+ * @var reservation_manager_columns_t::id
+ *     @brief Identifiers of the reservations.
+ * @var reservation_manager_columns_t::hotel_id
+ *     @brief Identifiers of the hotels of the reservations.
+ * @var reservation_manager_columns_t::hotel_stars
+ *     @brief Number of stars of the hotels of the reservations.
+ * @var reservation_manager_columns_t::begin_date
+ *     @brief Beginning dates of the reservations.
+ * @var reservation_manager_columns_t::end_date
+ *     @brief End dates of the reservations.
+ * @var reservation_manager_columns_t::price_per_night
+ *     @brief Prices per night of the reservations.
+ * @var reservation_manager_columns_t::city_tax
+ *     @brief City taxes of the reservations.
+ * @var reservation_manager_columns_t::rating
+ *     @brief Ratings of the reservations (see ::RESERVATION_NO_RATING).
+ * @var reservation_manager_columns_t::includes_breakfast
+ *     @brief Whether each reservation includes breakfast.
+ */
+typedef struct {
+    const reservation_id_t     *id;
+    const hotel_id_t           *hotel_id;
+    const uint8_t              *hotel_stars;
+    const date_t               *begin_date;
+    const date_t               *end_date;
+    const uint16_t             *price_per_night;
+    const uint8_t              *city_tax;
+    const uint8_t              *rating;
+    const includes_breakfast_t *includes_breakfast;
+} reservation_manager_columns_t;
+
+/** @brief A field of reservations with few values, indexed by ::reservation_manager_get_bitmap. */
+typedef enum {
+    RESERVATION_MANAGER_BITMAP_STARS,    /**< @brief Values are numbers of stars (1 to 5). */
+    RESERVATION_MANAGER_BITMAP_BREAKFAST /**< @brief Values are ::includes_breakfast_t's. */
+} reservation_manager_bitmap_field_t;
+
+/**
+ * @brief   Callback type for column-wise reservation manager iterations.
+ * @details Method called by ::reservation_manager_iter_columns for every block of reservations in
+ *          a ::reservation_manager_t.
+ *
+ * @param user_data Argument passed to ::reservation_manager_iter_columns, that is then passed to
+ *                  every callback, so that this method can change the program's state.
+ * @param columns   Fields of the reservations in the block.
+ * @param n         Number of reservations in the block (number of elements in each array in
+ *                  @p columns).
+ *
+ * @return `0` on success, or any other value to order iteration to stop.
+ */
+typedef int (*reservation_manager_iter_columns_callback_t)(
+    void                                *user_data,
+    const reservation_manager_columns_t *columns,
+    size_t                               n);
+
 /**
  * @brief   Instantiates a new ::reservation_manager_t.
  * @details The returned value is owned by the called and should be `free`'d with
@@ -152,13 +238,68 @@ reservation_manager_t *reservation_manager_clone(const reservation_manager_t *ma
  * @brief Adds a reservation to a reservation manager.
  *
  * @param manager     Reservation manager to add @p reservation to.
+ * @param hotel_names Dictionary with the hotel name of @p reservation.
  * @param reservation Reservation to be added to @p manager.
  *
  * @retval 0 Success.
  * @retval 1 Allocation failure.
  */
-int reservation_manager_add_reservation(reservation_manager_t *manager,
-                                        const reservation_t   *reservation);
+int reservation_manager_add_reservation(reservation_manager_t     *manager,
+                                        const string_dictionary_t *hotel_names,
+                                        const reservation_t       *reservation);
+
+/**
+ * @brief   Makes room in a reservation manager for a number of reservations.
+ * @details Call this before adding many reservations whose number is known beforehand, so that the
+ *          manager's lookup table doesn't need to grow multiple times, and so that its pool is
+ *          allocated at once.
+ *
+ * @param manager Reservation manager to be prepared.
+ * @param n       Total number of reservations @p manager is expected to contain.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int reservation_manager_reserve(reservation_manager_t *manager, size_t n);
+
+/**
+ * @brief   Frees memory a reservation manager allocated but isn't using.
+ * @details Undoes unused reservations made by ::reservation_manager_reserve and shrinks the lookup
+ *          table to the range of identifiers in use. Reservations aren't moved, but lookups in
+ *          @p manager mustn't happen meanwhile.
+ *
+ * @param manager Reservation manager to be shrunk.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (some memory may not have been freed).
+ */
+int reservation_manager_shrink_to_fit(reservation_manager_t *manager);
+
+/**
+ * @brief   Moves the reservations of a reservation manager so that reservations in the same hotel
+ *          are contiguous.
+ * @details Reservations are stored in the order of ::reservation_manager_iter_hotel (by hotel, and
+ *          from the latest to the earliest beginning date), instead of the order they were added
+ *          in, so that iterating through a hotel's reservations goes through sequential memory.
+ *          Pointers to reservations obtained before this call are then no longer valid, and lookups
+ *          in @p manager mustn't happen meanwhile. Requires enough memory for a second copy of all
+ *          reservations.
+ *
+ * @param manager Reservation manager whose reservations are reordered.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p manager is left unchanged).
+ */
+int reservation_manager_cluster(reservation_manager_t *manager);
+
+/**
+ * @brief  Gets the dictionary of hotel names of the reservations in a reservation manager.
+ * @param  manager Reservation manager to get the dictionary from.
+ * @return The dictionary to be passed to ::reservation_get_const_hotel_name for reservations in
+ *         @p manager.
+ */
+const string_dictionary_t *
+    reservation_manager_get_hotel_names(const reservation_manager_t *manager);
 
 /**
  * @brief Gets a reservation stored in a reservation manager by its identifier.
@@ -171,6 +312,44 @@ int reservation_manager_add_reservation(reservation_manager_t *manager,
 const reservation_t *reservation_manager_get_by_id(const reservation_manager_t *manager,
                                                    reservation_id_t             id);
 
+/**
+ * @brief   Gets many reservations in a reservation manager from their identifiers.
+ * @details Same as calling ::reservation_manager_get_by_id for every identifier, but all
+ *          reservations are found and prefetched before being returned, so that reading them
+ *          doesn't wait for one cache miss at a time.
+ *
+ * @param manager      Reservation manager to search in.
+ * @param n            Number of reservations to look for.
+ * @param ids          Identifiers of the reservations to look for.
+ * @param reservations Where to write the found reservations to (`NULL` for identifiers not in
+ *                     @p manager).
+ */
+void reservation_manager_get_by_ids(const reservation_manager_t *manager,
+                                    size_t                       n,
+                                    const reservation_id_t       ids[n],
+                                    const reservation_t         *reservations[n]);
+
+/**
+ * @brief  Gets the number of reservations in a reservation manager.
+ * @param  manager Reservation manager to get the number of reservations from.
+ * @return The number of reservations in @p manager.
+ */
+size_t reservation_manager_get_length(const reservation_manager_t *manager);
+
+/**
+ * @brief   Gets the ratings of all reservations in a hotel.
+ * @details Ratings are accumulated as reservations are added, so this runs in constant time.
+ *
+ * @param manager Reservation manager where to perform the lookup.
+ * @param hotel   Identifier of the hotel.
+ * @param sum     Where to write the sum of the ratings of all reservations in @p hotel to.
+ * @param count   Where to write the number of reservations in @p hotel to.
+ */
+void reservation_manager_get_hotel_ratings(const reservation_manager_t *manager,
+                                           hotel_id_t                   hotel,
+                                           uint64_t                    *sum,
+                                           size_t                      *count);
+
 /**
  * @brief Iterates through every reservation in a reservation manager, calling a callback for each
  *        one.
@@ -190,6 +369,350 @@ int reservation_manager_iter(const reservation_manager_t        *manager,
                              reservation_manager_iter_callback_t callback,
                              void                               *user_data);
 
+/**
+ * @brief   Iterates through every reservation in a reservation manager, calling a callback for
+ *          groups of reservations.
+ * @details Reservations are provided in the same order as ::reservation_manager_iter.
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param callback  Method to be called for every group of reservations stored in @p manager.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int reservation_manager_iter_blocks(const reservation_manager_t                *manager,
+                                    reservation_manager_iter_blocks_callback_t callback,
+                                    void                                       *user_data);
+
+/**
+ * @brief   Iterates through every reservation in a reservation manager, splitting groups of
+ *          reservations across multiple threads.
+ * @details Each thread is given a disjoint range of the manager's reservations. Callbacks in
+ *          different threads are called concurrently, so they mustn't modify the same data, and
+ *          @p manager mustn't be modified during the iteration.
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method to be called for every group of reservations stored in @p manager.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by the last @p callback of a thread (threads ordered
+ *         as @p user_data), or `0` if no thread was stopped.
+ */
+int reservation_manager_iter_blocks_parallel(const reservation_manager_t                *manager,
+                                             size_t                                     nthreads,
+                                             reservation_manager_iter_blocks_callback_t callback,
+                                             void *const                                *user_data);
+
+/**
+ * @brief   Iterates through blocks of reservations in a reservation manager, field by field.
+ * @details Scans that only need a few fields of every reservation should prefer this method to
+ *          ::reservation_manager_iter, as only those fields are read from memory, in a way that can
+ *          be easily vectorized.
+ *
+ *          The columns are built the first time this method is called, and kept until a new
+ *          reservation is added to @p manager. Building the columns is thread-safe, but adding
+ *          reservations while iterating over them isn't.
+ *
+ *          Reservations are partitioned by the month of their beginning date: they're provided
+ *          from the earliest month to the latest one, and in no particular order within a month.
+ *          See ::reservation_manager_iter_columns_between.
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param callback  Method to be called for every block of reservations in @p manager.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int reservation_manager_iter_columns(const reservation_manager_t                *manager,
+                                     reservation_manager_iter_columns_callback_t callback,
+                                     void                                       *user_data);
+
+/**
+ * @brief   Gets the reservations with a given value in a field, as a bitmap of their rows.
+ * @details A row is the position of a reservation in the iteration order of
+ *          ::reservation_manager_iter_columns (the `i`-th reservation of a block starting at row
+ *          `offset` is in row `offset + i`). Bitmaps are built with the columns, and kept until a
+ *          new reservation is added to @p manager, so counting the reservations that match many
+ *          values is a matter of intersecting bitmaps (see ::compressed_bitmap_and_count). This can
+ *          be called from many threads at once.
+ *
+ * @param manager Reservation manager to get the bitmap from.
+ * @param field   Field of reservations to be looked at.
+ * @param value   Value of @p field that all reservations in the bitmap must have.
+ *
+ * @return A bitmap of rows (empty if no reservation has @p value), valid until a reservation is
+ *         added to @p manager, or `NULL` on allocation failure.
+ */
+const compressed_bitmap_t *
+    reservation_manager_get_bitmap(const reservation_manager_t       *manager,
+                                   reservation_manager_bitmap_field_t field,
+                                   uint32_t                           value);
+
+/**
+ * @brief   Iterates through blocks of reservations in a reservation manager, field by field,
+ *          splitting the blocks across multiple threads.
+ * @details See ::reservation_manager_iter_columns. Each thread is given a disjoint range of
+ *          consecutive blocks. Callbacks in different threads are called concurrently, so they
+ *          mustn't modify the same data.
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method called for every block of reservations in @p manager.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by the last @p callback of a thread (threads ordered
+ *         as @p user_data), `1` if the columns couldn't be allocated, or `0` on success.
+ */
+int reservation_manager_iter_columns_parallel(
+    const reservation_manager_t                *manager,
+    size_t                                      nthreads,
+    reservation_manager_iter_columns_callback_t callback,
+    void *const                                *user_data);
+
+/**
+ * @brief   Iterates through blocks of reservations in a reservation manager, field by field,
+ *          skipping the months that can't have stays overlapping a range of dates.
+ * @details See ::reservation_manager_iter_columns. All reservations that begin on or before
+ *          @p end, and end on or after @p begin, are provided. Whole months are iterated through,
+ *          only skipping blocks whose earliest beginning and latest end dates rule out any
+ *          overlap, so other reservations may be provided too, and must be filtered out by
+ *          @p callback.
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param begin     First day of the range of dates (inclusive).
+ * @param end       Last day of the range of dates (inclusive).
+ * @param callback  Method to be called for every block of reservations that may be in the range.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int reservation_manager_iter_columns_between(
+    const reservation_manager_t                *manager,
+    date_t                                      begin,
+    date_t                                      end,
+    reservation_manager_iter_columns_callback_t callback,
+    void                                       *user_data);
+
+/**
+ * @brief   Iterates through blocks of reservations in a reservation manager, field by field,
+ *          skipping the months that can't have stays overlapping a range of dates, and splitting
+ *          the blocks across multiple threads.
+ * @details See ::reservation_manager_iter_columns_between and
+ *          ::reservation_manager_iter_columns_parallel.
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param begin     First day of the range of dates (inclusive).
+ * @param end       Last day of the range of dates (inclusive).
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method called for every block of reservations that may be in the range.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by the last @p callback of a thread (threads ordered
+ *         as @p user_data), `1` if the columns couldn't be allocated, or `0` on success.
+ */
+int reservation_manager_iter_columns_between_parallel(
+    const reservation_manager_t                *manager,
+    date_t                                      begin,
+    date_t                                      end,
+    size_t                                      nthreads,
+    reservation_manager_iter_columns_callback_t callback,
+    void *const                                *user_data);
+
+/**
+ * @brief   Gets the fields of all reservations in a reservation manager, each one in a single
+ *          array.
+ * @details Rows are in the same order as in ::reservation_manager_iter_columns. The arrays are
+ *          owned by @p manager, and are only valid until reservations are added to, modified or
+ *          invalidated in it.
+ *
+ * @param manager Reservation manager to get the columns from.
+ * @param columns Where to output the columns to.
+ * @param n       Where to output the number of reservations (of elements in each column) to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int reservation_manager_get_columns(const reservation_manager_t   *manager,
+                                    reservation_manager_columns_t *columns,
+                                    size_t                        *n);
+
+/**
+ * @brief   Iterates through every reservation in a hotel, calling a callback for each one.
+ * @details Reservations are provided from the latest to the earliest beginning date, with ties
+ *          broken by reservation identifier (in ascending order).
+ *
+ *          An index of reservations by hotel is built the first time this method is called, and
+ *          kept until a new reservation is added to @p manager. Building the index is thread-safe,
+ *          but adding reservations while iterating over them isn't.
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param hotel     Identifier of the hotel whose reservations are to be iterated through.
+ * @param callback  Method to be called for every reservation in @p hotel.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int reservation_manager_iter_hotel(const reservation_manager_t        *manager,
+                                   hotel_id_t                          hotel,
+                                   reservation_manager_iter_callback_t callback,
+                                   void                               *user_data);
+
+/**
+ * @struct  reservation_manager_hotel_columns_t
+ * @brief   Some fields of all reservations in a hotel, each one stored in a separate array.
+ * @details Element `i` of every array belongs to the `i`-th reservation in the order of
+ *          ::reservation_manager_iter_hotel (latest beginning date first).
+ *
+ * @var reservation_manager_hotel_columns_t::begin_date
+ *     @brief Beginning dates of the reservations.
+ * @var reservation_manager_hotel_columns_t::end_date
+ *     @brief End dates of the reservations.
+ * @var reservation_manager_hotel_columns_t::price_per_night
+ *     @brief Prices per night of the reservations.
+ */
+typedef struct {
+    const date_t   *begin_date;
+    const date_t   *end_date;
+    const uint16_t *price_per_night;
+} reservation_manager_hotel_columns_t;
+
+/**
+ * @brief   Gets the dates and prices of all reservations in a hotel, as columns.
+ * @details Filters over dates can then be applied to many reservations at once (see
+ *          date_overlap.h), instead of reservation by reservation. The columns are kept with the
+ *          index of ::reservation_manager_iter_hotel, built the first time it's needed, and are
+ *          only valid until a new reservation is added to @p manager.
+ *
+ * @param manager Reservation manager to get the columns from.
+ * @param hotel   Identifier of the hotel whose reservations are wanted.
+ * @param columns Where to output the columns to.
+ * @param n       Where to output the number of reservations in @p hotel to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int reservation_manager_get_hotel_columns(const reservation_manager_t         *manager,
+                                          hotel_id_t                           hotel,
+                                          reservation_manager_hotel_columns_t *columns,
+                                          size_t                              *n);
+
+/**
+ * @brief   Iterates through a range of the reservations in a hotel, calling a callback for each
+ *          one.
+ * @details See ::reservation_manager_iter_hotel. Reservations outside of the range aren't looked
+ *          at, so pages of results can be obtained without iterating through previous ones.
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param hotel     Identifier of the hotel whose reservations are to be iterated through.
+ * @param offset    Number of reservations, in the order of ::reservation_manager_iter_hotel, to be
+ *                  left out at the beginning.
+ * @param limit     Maximum number of reservations to be iterated through (`SIZE_MAX` for no
+ *                  limit).
+ * @param callback  Method to be called for every reservation in the range.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int reservation_manager_iter_hotel_range(const reservation_manager_t        *manager,
+                                         hotel_id_t                          hotel,
+                                         size_t                              offset,
+                                         size_t                              limit,
+                                         reservation_manager_iter_callback_t callback,
+                                         void                               *user_data);
+
+/**
+ * @brief   Iterates through the identifiers of all hotels (with reservations) that start with a
+ *          prefix.
+ * @details Identifiers are iterated in byte order. An index of identifiers is built when this is
+ *          first called (and after new reservations are added), so that following lookups are
+ *          quick enough to be done on every keystroke (e.g.: for autocompletion).
+ *
+ * @param manager   Reservation manager to iterate through.
+ * @param prefix    Prefix that all iterated hotel identifiers must start with.
+ * @param callback  Method to be called for every matching identifier.
+ * @param user_data Pointer to be passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int reservation_manager_iter_hotel_id_prefix(const reservation_manager_t *manager,
+                                             const char                  *prefix,
+                                             prefix_index_iter_callback_t callback,
+                                             void                        *user_data);
+
+/**
+ * @brief   Replicates the ratings of hotels and the index of reservations by hotel in every NUMA
+ *          node.
+ * @details The index is built if needed. Threads pinned to a node (see
+ *          ::numa_topology_pin_thread) read from that node's replica in
+ *          ::reservation_manager_get_hotel_ratings and ::reservation_manager_iter_hotel_range.
+ *          Replicas are discarded when a new reservation is added. Like adding reservations, this
+ *          must not be done while other threads read from @p manager.
+ *
+ * @param manager  Reservation manager whose indices are to be replicated.
+ * @param topology NUMA nodes to replicate the indices in.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (no replicas were made).
+ */
+int reservation_manager_replicate_indexes(const reservation_manager_t *manager,
+                                          const numa_topology_t       *topology);
+
+/** @brief Indices of a reservation manager that are built the first time they're needed. */
+typedef enum {
+    RESERVATION_MANAGER_INDEX_COLUMNS,   /**< See ::reservation_manager_iter_columns. */
+    RESERVATION_MANAGER_INDEX_HOTELS,    /**< See ::reservation_manager_iter_hotel_range. */
+    RESERVATION_MANAGER_INDEX_HOTEL_IDS, /**< See ::reservation_manager_iter_hotel_id_prefix. */
+    RESERVATION_MANAGER_INDEX_COUNT      /**< Number of indices. */
+} reservation_manager_index_t;
+
+/**
+ * @brief   Builds an index of a reservation manager, if it isn't built yet.
+ * @details Different indices can be built concurrently, from different threads, but not while
+ *          reservations are being added to @p manager.
+ *
+ * @param manager Reservation manager to build an index of.
+ * @param index   Index to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int reservation_manager_build_index(const reservation_manager_t *manager,
+                                    reservation_manager_index_t  index);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a reservation manager.
+ * @details Includes all reservations, their strings, identifier lookup tables and any indices that
+ *          are currently built.
+ *
+ * @param manager Reservation manager to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p manager.
+ */
+size_t reservation_manager_get_memory_usage(const reservation_manager_t *manager);
+
+/**
+ * @brief  Gets the number of bytes of memory allocated for strings in a reservation manager.
+ * @param  manager Reservation manager to get the memory usage of.
+ * @return The number of bytes allocated by the string pool of @p manager (already included in
+ *         ::reservation_manager_get_memory_usage).
+ */
+size_t reservation_manager_get_strings_memory_usage(const reservation_manager_t *manager);
+
 /**
  * @brief Frees memory used by a reservation manager.
  * @param manager Reservation manager whose memory is to be `free`d.
@@ -84,7 +84,9 @@
  * ```
  *
  * Another operation (other than iteration) that can be performed on a ::user_manager_t is a lookup
- * by user identifier (::user_manager_get_by_id).
+ * by user identifier (::user_manager_get_by_id). Each user is also given a dense numeric handle
+ * (a ::user_ordinal_t, see ::user_manager_get_ordinal), which other entities store instead of the
+ * user's identifier, and which can be looked up with ::user_manager_get_by_ordinal.
  *
  * If you'd rather not use a database, you could create the user manager yourself with
  * ::user_manager_create, add users to it using ::user_manager_add_user, and free it in the end
@@ -98,11 +100,22 @@
 #include "types/flight_id.h"
 #include "types/reservation_id.h"
 #include "types/user.h"
-#include "utils/single_pool_id_linked_list.h"
+#include "types/user_ordinal.h"
+#include "utils/compressed_bitmap.h"
+#include "utils/date_and_time.h"
+#include "utils/numa_topology.h"
+#include "utils/prefix_index.h"
 
 /** @brief A data type that contains and manages all users in a database. */
 typedef struct user_manager user_manager_t;
 
+/** @brief A field of users with few possible values, indexed by ::user_manager_get_bitmap. */
+typedef enum {
+    USER_MANAGER_BITMAP_ACCOUNT_STATUS, /**< @brief Values are ::account_status_t's. */
+    USER_MANAGER_BITMAP_SEX,            /**< @brief Values are ::sex_t's. */
+    USER_MANAGER_BITMAP_COUNTRY_CODE    /**< @brief Values are ::country_code_t's. */
+} user_manager_bitmap_field_t;
+
 /**
  * @brief   Callback type for user manager iterations.
  * @details Method called by ::user_manager_iter for every item in a ::user_manager_t.
@@ -115,6 +128,23 @@ typedef struct user_manager user_manager_t;
  */
 typedef int (*user_manager_iter_callback_t)(void *user_data, const user_t *user);
 
+/**
+ * @brief   Callback type for user manager iterations over groups of users.
+ * @details Method called by ::user_manager_iter_blocks and ::user_manager_iter_blocks_parallel
+ *          for groups of users in a ::user_manager_t, so that a single call is made for many
+ *          users.
+ *
+ * @param user_data Argument passed to ::user_manager_iter_blocks, that is then passed to every
+ *                  callback, so that this method can change the program's state.
+ * @param users     Array of @p n pointers to users in the manager. Only valid during this call.
+ * @param n         Number of elements in @p users. Never `0`.
+ *
+ * @return `0` on success, or any other value to order iteration to stop.
+ */
+typedef int (*user_manager_iter_blocks_callback_t)(void         *user_data,
+                                                   const user_t *const *users,
+                                                   size_t        n);
+
 /**
  * @brief   Callback type for user manager iterations with flight (passengers) information.
  * @details Method called by ::user_manager_iter_with_flights for every item in a ::user_manager_t.
@@ -122,14 +152,29 @@ typedef int (*user_manager_iter_callback_t)(void *user_data, const user_t *user)
  * @param user_data Argument passed to ::user_manager_iter_with_flights, that is then passed to
  *                  every callback, so that this method can change the program's state.
  * @param user      User in the manager.
- * @param flights   Flights related to @p user (passengers).
+ * @param flights   Flights related to @p user (passengers). Only valid during this callback. Can
+ *                  be `NULL` if @p nflights is `0`.
+ * @param nflights  Number of elements in @p flights.
  *
  * @return `0` on success, or any other value to order iteration to stop.
  */
-typedef int (*user_manager_iter_with_flights_callback_t)(
-    void                               *user_data,
-    const user_t                       *user,
-    const single_pool_id_linked_list_t *flights);
+typedef int (*user_manager_iter_with_flights_callback_t)(void              *user_data,
+                                                         const user_t      *user,
+                                                         const flight_id_t *flights,
+                                                         size_t             nflights);
+
+/**
+ * @brief   Callback type for getting the date of an entity associated with a user.
+ * @details Used to sort the flights and reservations of each user (see
+ *          ::user_manager_set_association_dates).
+ *
+ * @param date_data Argument passed to ::user_manager_set_association_dates.
+ * @param id        Identifier of the flight or reservation whose date is to be found.
+ *
+ * @return The date of the entity identified by @p id.
+ */
+typedef date_and_time_t (*user_manager_association_date_callback_t)(const void *date_data,
+                                                                    uint32_t    id);
 
 /**
  * @brief   Instantiates a new ::user_manager_t.
@@ -152,7 +197,9 @@ user_manager_t *user_manager_create(void);
 user_manager_t *user_manager_clone(const user_manager_t *manager);
 
 /**
- * @brief Adds a user to a user manager.
+ * @brief   Adds a user to a user manager.
+ * @details The user is given the next available ::user_ordinal_t, unless it replaces another user
+ *          with the same identifier, whose ordinal (but none of its associations) it inherits.
  *
  * @param manager User manager to add @p user to.
  * @param user    User to be added to @p manager.
@@ -162,32 +209,139 @@ user_manager_t *user_manager_clone(const user_manager_t *manager);
  */
 int user_manager_add_user(user_manager_t *manager, const user_t *user);
 
+/**
+ * @brief   Makes room in a user manager for a number of users and associations.
+ * @details Call this before adding many users whose number is known beforehand, so that the
+ *          manager's lookup tables don't need to grow multiple times, and so that its pools are
+ *          allocated at once.
+ *
+ * @param manager       User manager to be prepared.
+ * @param nusers        Total number of users @p manager is expected to contain.
+ * @param nassociations Number of user-flight and user-reservation associations expected to be
+ *                      added to @p manager.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int user_manager_reserve(user_manager_t *manager, size_t nusers, size_t nassociations);
+
+/**
+ * @brief   Frees memory a user manager allocated but isn't using.
+ * @details Undoes unused reservations made by ::user_manager_reserve and shrinks the lookup table
+ *          to the number of users. Users aren't moved, but lookups in @p manager mustn't happen
+ *          meanwhile.
+ *
+ * @param manager User manager to be shrunk.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (some memory may not have been freed).
+ */
+int user_manager_shrink_to_fit(user_manager_t *manager);
+
 /**
  * @brief Adds a user-flight relation (passenger) to a user manager.
  *
  * @param manager   User manager to add the passenger relation to.
- * @param user_id   Identifier of the user to add @p flight_id to.
- * @param flight_id Identifier of the flight to be associated with @p user_id.
+ * @param user      Ordinal of the user to add @p flight_id to.
+ * @param flight_id Identifier of the flight to be associated with @p user.
  *
  * @retval 0 Success.
  * @retval 1 User not found or allocation failure.
  */
 int user_manager_add_user_flight_association(user_manager_t *manager,
-                                             const char     *user_id,
+                                             user_ordinal_t  user,
                                              flight_id_t     flight_id);
 /**
  * @brief Adds a user-reservation relation to a user manager.
  *
  * @param manager        User manager to add @p reservation_id to.
- * @param user_id        Identifier of the user to add @p reservation_id to.
- * @param reservation_id Identifier of the reservation to be associated with @p user_id.
+ * @param user           Ordinal of the user to add @p reservation_id to.
+ * @param reservation_id Identifier of the reservation to be associated with @p user.
+ * @param price          Total price of the reservation in cents (see
+ *                       ::reservation_calculate_price_cents), added to the user's total spent
+ *                       (see ::user_manager_get_by_id_with_totals).
  *
  * @retval 0 Success.
  * @retval 1 User not found or allocation failure.
  */
 int user_manager_add_user_reservation_association(user_manager_t  *manager,
-                                                  const char      *user_id,
-                                                  reservation_id_t reservation_id);
+                                                  user_ordinal_t   user,
+                                                  reservation_id_t reservation_id,
+                                                  uint64_t         price);
+
+/**
+ * @brief   Adds many user-flight relations (passengers) of the same flight to a user manager.
+ * @details Equivalent to calling ::user_manager_add_user_flight_association for every user, but
+ *          users are prefetched ahead of being modified, and repeated users in a row are only
+ *          looked up once.
+ *
+ * @param manager   User manager to add the passenger relations to.
+ * @param flight_id Identifier of the flight to be associated with @p users.
+ * @param n         Number of users in @p users.
+ * @param users     Ordinals of the users to add @p flight_id to.
+ *
+ * @retval 0 Success.
+ * @retval 1 User not found or allocation failure. Associations before the failing one remain.
+ */
+int user_manager_add_user_flight_associations(user_manager_t      *manager,
+                                              flight_id_t          flight_id,
+                                              size_t               n,
+                                              const user_ordinal_t users[n]);
+
+/**
+ * @brief   Adds many user-reservation relations to a user manager.
+ * @details Equivalent to calling ::user_manager_add_user_reservation_association for every
+ *          reservation, but users are prefetched ahead of being modified, and repeated users in a
+ *          row are only looked up once.
+ *
+ * @param manager         User manager to add @p reservation_ids to.
+ * @param n               Number of relations to add.
+ * @param users           Ordinals of the users of every reservation.
+ * @param reservation_ids Identifiers of the reservations to be associated with @p users.
+ * @param prices          Total prices of the reservations in cents.
+ *
+ * @retval 0 Success.
+ * @retval 1 User not found or allocation failure. Associations before the failing one remain.
+ */
+int user_manager_add_user_reservation_associations(user_manager_t        *manager,
+                                                   size_t                 n,
+                                                   const user_ordinal_t   users[n],
+                                                   const reservation_id_t reservation_ids[n],
+                                                   const uint64_t         prices[n]);
+
+/**
+ * @brief   Sets how to get the dates of the flights and reservations associated with users.
+ * @details When set, the flights and the reservations of each user are sorted by date (most recent
+ *          first) and then by identifier, when associations are moved to contiguous arrays (see
+ *          ::user_manager_get_flights_by_id). Associations already in those arrays are only sorted
+ *          again after more associations are added.
+ *
+ * @param manager          User manager whose associations are to be sorted.
+ * @param flight_date      Method that gets the date of a flight. Can be `NULL`, not to sort
+ *                         flights.
+ * @param reservation_date Method that gets the date of a reservation. Can be `NULL`, not to sort
+ *                         reservations.
+ * @param date_data        Pointer passed to @p flight_date and @p reservation_date. Must live for
+ *                         as long as @p manager.
+ */
+void user_manager_set_association_dates(user_manager_t                          *manager,
+                                        user_manager_association_date_callback_t flight_date,
+                                        user_manager_association_date_callback_t reservation_date,
+                                        const void                              *date_data);
+
+/**
+ * @brief   Moves all associations added since the last lookup to the contiguous arrays that
+ *          lookups use.
+ * @details This usually happens lazily, on the first lookup that needs associations. After this
+ *          succeeds, and until more associations are added, lookups don't call the methods set by
+ *          ::user_manager_set_association_dates.
+ *
+ * @param manager Manager whose associations are to be moved.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int user_manager_compact(const user_manager_t *manager);
 
 /**
  * @brief Gets a user stored in a user manager by its identifier.
@@ -200,30 +354,117 @@ int user_manager_add_user_reservation_association(user_manager_t  *manager,
 const user_t *user_manager_get_by_id(const user_manager_t *manager, const char *id);
 
 /**
- * @brief Given a user identifier, gets the flights that user travelled in (passengers).
+ * @brief  Gets the number of users in a user manager.
+ * @param  manager User manager to get the number of users from.
+ * @return The number of users in @p manager.
+ */
+size_t user_manager_get_length(const user_manager_t *manager);
+
+/**
+ * @brief Gets the ordinal of a user stored in a user manager.
  *
  * @param manager User manager where to perform the lookup.
  * @param id      Identifier of the user to find.
+ * @param ordinal Where to output the ordinal of the user to.
  *
- * @return A linked list of flight identifiers if the user was found, `NULL` if it was not.
- *         To distinguish between an empty list and a lookup failure, call ::user_manager_get_by_id
- *         and check its return value.
+ * @retval 0 Success.
+ * @retval 1 User not found (nothing is outputted).
  */
-const single_pool_id_linked_list_t *user_manager_get_flights_by_id(const user_manager_t *manager,
-                                                                   const char           *id);
+int user_manager_get_ordinal(const user_manager_t *manager,
+                             const char           *id,
+                             user_ordinal_t       *ordinal);
 
 /**
- * @brief Given a user identifier, gets the bookings that user booked.
+ * @brief   Gets the ordinals of many users stored in a user manager.
+ * @details Same as calling ::user_manager_get_ordinal for every identifier, but done as a join
+ *          (see ::string_hash_table_lookup_batch), for when linking many relations (e.g.:
+ *          passengers, reservations) to their users.
+ *
+ * @param manager  User manager where to perform the lookups.
+ * @param n        Number of users to look for.
+ * @param ids      Identifiers of the users to find.
+ * @param ordinals Where to output the ordinal of each user to.
+ * @param found    Where to output whether each user was found to (`0` or `1`). For users that
+ *                 weren't found, nothing is written to @p ordinals.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (nothing is outputted).
+ */
+int user_manager_get_ordinals(const user_manager_t *manager,
+                              size_t                n,
+                              const char *const     ids[n],
+                              user_ordinal_t        ordinals[n],
+                              uint8_t               found[n]);
+
+/**
+ * @brief Gets a user stored in a user manager by its ordinal.
  *
  * @param manager User manager where to perform the lookup.
- * @param id      Identifier of the user to find.
+ * @param ordinal Ordinal of the user to find (see ::user_manager_get_ordinal).
+ *
+ * @return A pointer to a ::user_t if it's found, `NULL` if it's not.
+ */
+const user_t *user_manager_get_by_ordinal(const user_manager_t *manager, user_ordinal_t ordinal);
+
+/**
+ * @brief   Gets a user stored in a user manager by its identifier, along with totals about it.
+ * @details These totals are kept up-to-date while associations are added, so this method is as
+ *          fast as ::user_manager_get_by_id.
+ *
+ * @param manager       User manager where to perform the lookup.
+ * @param id            Identifier of the user to find.
+ * @param nflights      Where to output the number of flights the user travelled in to.
+ * @param nreservations Where to output the number of reservations the user booked to.
+ * @param total_spent   Where to output the sum of the prices of the user's reservations to, in
+ *                      cents.
+ *
+ * @return A pointer to a ::user_t if it's found, `NULL` if it's not (nothing is outputted).
+ */
+const user_t *user_manager_get_by_id_with_totals(const user_manager_t *manager,
+                                                 const char           *id,
+                                                 size_t               *nflights,
+                                                 size_t               *nreservations,
+                                                 uint64_t             *total_spent);
+
+/**
+ * @brief   Given a user identifier, gets the flights that user travelled in (passengers).
+ * @details Associations are stored in compressed contiguous arrays (see utils/varint.h), built
+ *          from the associations added since the last lookup the first time they're needed.
+ *          Building these arrays is thread-safe, but adding associations while reading them isn't.
+ *
+ * @param manager  User manager where to perform the lookup.
+ * @param id       Identifier of the user to find.
+ * @param flights  Where to output the array of flight identifiers to. It's decoded to the calling
+ *                 thread's scratch arena (see ::scratch_arena_allocate), and is only valid until
+ *                 it's reset. Can be `NULL` if @p nflights is `0`.
+ * @param nflights Where to output the number of elements in @p flights to.
+ *
+ * @retval 0 Success.
+ * @retval 1 User not found or allocation failure.
+ */
+int user_manager_get_flights_by_id(const user_manager_t *manager,
+                                   const char           *id,
+                                   const flight_id_t   **flights,
+                                   size_t               *nflights);
+
+/**
+ * @brief   Given a user identifier, gets the bookings that user booked.
+ * @details See ::user_manager_get_flights_by_id for how associations are stored.
+ *
+ * @param manager       User manager where to perform the lookup.
+ * @param id            Identifier of the user to find.
+ * @param reservations  Where to output the array of reservation identifiers to. It's decoded to
+ *                      the calling thread's scratch arena, and is only valid until it's reset.
+ *                      Can be `NULL` if @p nreservations is `0`.
+ * @param nreservations Where to output the number of elements in @p reservations to.
  *
- * @return A linked list of reservation IDs if the user was found, `NULL` if it was not.
- *         To distinguish between an empty list and a lookup failure, call ::user_manager_get_by_id
- *         and check its return value.
+ * @retval 0 Success.
+ * @retval 1 User not found or allocation failure.
  */
-const single_pool_id_linked_list_t *
-    user_manager_get_reservations_by_id(const user_manager_t *manager, const char *id);
+int user_manager_get_reservations_by_id(const user_manager_t    *manager,
+                                        const char              *id,
+                                        const reservation_id_t **reservations,
+                                        size_t                  *nreservations);
 
 /**
  * @brief Iterates through every user in a user manager, calling a callback for each one.
@@ -243,6 +484,44 @@ int user_manager_iter(const user_manager_t        *manager,
                       user_manager_iter_callback_t callback,
                       void                        *user_data);
 
+/**
+ * @brief   Iterates through every user in a user manager, calling a callback for groups of
+ *          users.
+ * @details Users are provided in the same order as ::user_manager_iter.
+ *
+ * @param manager   User manager to iterate through.
+ * @param callback  Method to be called for every group of users stored in @p manager.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int user_manager_iter_blocks(const user_manager_t                *manager,
+                             user_manager_iter_blocks_callback_t callback,
+                             void                                *user_data);
+
+/**
+ * @brief   Iterates through every user in a user manager, splitting groups of users across
+ *          multiple threads.
+ * @details Each thread is given a disjoint range of the manager's users. Callbacks in different
+ *          threads are called concurrently, so they mustn't modify the same data, and @p manager
+ *          mustn't be modified during the iteration.
+ *
+ * @param manager   User manager to iterate through.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method to be called for every group of users stored in @p manager.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by the last @p callback of a thread (threads ordered
+ *         as @p user_data), or `0` if no thread was stopped.
+ */
+int user_manager_iter_blocks_parallel(const user_manager_t                *manager,
+                                      size_t                              nthreads,
+                                      user_manager_iter_blocks_callback_t callback,
+                                      void *const                         *user_data);
+
 /**
  * @brief   Iterates through every user in a user manager, calling a callback for each one.
  * @details Flights related to every user (passengers) are also provided to callbacks, unlike in
@@ -254,12 +533,174 @@ int user_manager_iter(const user_manager_t        *manager,
  *                  state.
  *
  * @return The return value of the last-called @p callback (`0` means success, another value means
- *         the iteration was stopped by a callback).
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
  */
 int user_manager_iter_with_flights(const user_manager_t                     *manager,
                                    user_manager_iter_with_flights_callback_t callback,
                                    void                                     *user_data);
 
+/**
+ * @brief   Iterates through the users whose names start with a prefix, in alphabetical order.
+ * @details Users are ordered by name and then by identifier, with the collation rules of
+ *          `en_US.UTF-8` (or of the current locale, if that locale isn't available).
+ *
+ *          An index of users by name is built the first time this method is called, and kept until
+ *          a new user is added to @p manager. Building the index is thread-safe, but adding users
+ *          while iterating over them isn't. Matches are sorted in memory allocated from the
+ *          calling thread's arena (see ::scratch_arena_allocate), which is only freed when that
+ *          arena is reset.
+ *
+ * @param manager   User manager to iterate thorugh.
+ * @param prefix    Prefix that the names of all iterated users must start with.
+ * @param callback  Method to be called for every matching user stored in @p manager.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int user_manager_iter_name_prefix(const user_manager_t        *manager,
+                                  const char                  *prefix,
+                                  user_manager_iter_callback_t callback,
+                                  void                        *user_data);
+
+/**
+ * @brief   Iterates through the identifiers of all users that start with a prefix.
+ * @details Identifiers are iterated in byte order. An index of identifiers (a radix tree) is built
+ *          when this is first called (and after new users are added), so that following lookups
+ *          are quick enough to be done on every keystroke (e.g.: for autocompletion).
+ *
+ * @param manager   User manager to iterate through.
+ * @param prefix    Prefix that all iterated identifiers must start with.
+ * @param callback  Method to be called for every matching identifier.
+ * @param user_data Pointer to be passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int user_manager_iter_id_prefix(const user_manager_t        *manager,
+                                const char                  *prefix,
+                                prefix_index_iter_callback_t callback,
+                                void                        *user_data);
+
+/**
+ * @brief   Iterates through all users whose identifiers aren't lower than a given one.
+ * @details Users are iterated in byte order of their identifiers, using the same index as
+ *          ::user_manager_iter_id_prefix. Stopping the iteration from @p callback is how a range
+ *          of identifiers can be iterated through.
+ *
+ * @param manager   User manager to iterate through.
+ * @param begin     Lowest identifier to be iterated through (doesn't need to belong to a user).
+ * @param callback  Method to be called for every user.
+ * @param user_data Pointer to be passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback). `1` is also returned on allocation failure.
+ */
+int user_manager_iter_ids_from(const user_manager_t        *manager,
+                               const char                  *begin,
+                               user_manager_iter_callback_t callback,
+                               void                        *user_data);
+
+/**
+ * @brief   Gets the users with a given value in a field, as a bitmap of their ordinals.
+ * @details Bitmaps for all fields in ::user_manager_bitmap_field_t are built when this is first
+ *          called (and after new users are added), so that counting the users that match many
+ *          values (e.g.: active users in a country) is a matter of intersecting bitmaps (see
+ *          ::compressed_bitmap_and_count). This can be called from many threads at once.
+ *
+ * @param manager User manager to get the bitmap from.
+ * @param field   Field of users to be looked at.
+ * @param value   Value of @p field that all users in the bitmap must have.
+ *
+ * @return A bitmap of ::user_ordinal_t's (empty if no user has @p value), valid until a user is
+ *         added to @p manager, or `NULL` on allocation failure.
+ */
+const compressed_bitmap_t *user_manager_get_bitmap(const user_manager_t       *manager,
+                                                   user_manager_bitmap_field_t field,
+                                                   uint32_t                    value);
+
+/**
+ * @brief   Given a flight identifier, gets the users that travelled in it (passengers).
+ * @details Passengers are kept in a reverse index of the flights of all users, in compressed
+ *          sparse row form (the users of every flight, one flight after the other, and where each
+ *          flight begins), so that a flight's `k` passengers are found in `O(k)`. The index is
+ *          built from the associations added while loading passengers when this is first called
+ *          (or by ::user_manager_build_index), and discarded when users or flight associations
+ *          are added. This can be called from many threads at once.
+ *
+ * @param manager   User manager where to perform the lookup.
+ * @param flight_id Identifier of the flight whose passengers are to be found.
+ * @param users     Where to output the array of ordinals of the passengers to, in ascending order.
+ *                  It's owned by @p manager, and only valid until users or flight associations are
+ *                  added. Can be `NULL` if @p nusers is `0`.
+ * @param nusers    Where to output the number of elements in @p users to (`0` for flights
+ *                  without passengers).
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int user_manager_get_passengers_by_flight(const user_manager_t  *manager,
+                                          flight_id_t            flight_id,
+                                          const user_ordinal_t **users,
+                                          size_t                *nusers);
+
+/**
+ * @brief   Replicates the index of users by name in every NUMA node.
+ * @details The index is built if needed. Threads pinned to a node (see ::numa_topology_pin_thread)
+ *          read from that node's replica in ::user_manager_iter_name_prefix. Replicas are
+ *          discarded when a new user is added. Like adding users, this must not be done while
+ *          other threads read from @p manager.
+ *
+ * @param manager  User manager whose index is to be replicated.
+ * @param topology NUMA nodes to replicate the index in.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (no replicas were made).
+ */
+int user_manager_replicate_indexes(const user_manager_t *manager, const numa_topology_t *topology);
+
+/** @brief Indices of a user manager that are built the first time they're needed. */
+typedef enum {
+    USER_MANAGER_INDEX_NAMES,      /**< See ::user_manager_iter_name_prefix. */
+    USER_MANAGER_INDEX_IDS,        /**< See ::user_manager_iter_ids_from. */
+    USER_MANAGER_INDEX_BITMAPS,    /**< See ::user_manager_get_bitmap. */
+    USER_MANAGER_INDEX_PASSENGERS, /**< See ::user_manager_get_passengers_by_flight. */
+    USER_MANAGER_INDEX_COUNT       /**< Number of indices. */
+} user_manager_index_t;
+
+/**
+ * @brief   Builds an index of a user manager, if it isn't built yet.
+ * @details Different indices can be built concurrently, from different threads, but not while
+ *          users are being added to @p manager.
+ *
+ * @param manager User manager to build an index of.
+ * @param index   Index to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int user_manager_build_index(const user_manager_t *manager, user_manager_index_t index);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a user manager.
+ * @details Includes all users, their strings, identifier lookup tables and any indices that are
+ *          currently built.
+ *
+ * @param manager User manager to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p manager.
+ */
+size_t user_manager_get_memory_usage(const user_manager_t *manager);
+
+/**
+ * @brief  Gets the number of bytes of memory allocated for strings in a user manager.
+ * @param  manager User manager to get the memory usage of.
+ * @return The number of bytes allocated by the string pool of @p manager (already included in
+ *         ::user_manager_get_memory_usage).
+ */
+size_t user_manager_get_strings_memory_usage(const user_manager_t *manager);
+
 /**
  * @brief Frees memory used by a user manager.
  * @param manager User manager whose memory is to be `free`d.
@@ -26,6 +26,11 @@
  * [dataset_input](@ref dataset_input.h). See the source code of ::dataset_loader_load
  * for a good example on how to use both of these modules. Error reporting funtions
  * (`dataset_error_output_report_*_error`) are used in individual file dataset loaders (`*_loader`).
+ *
+ * Reported lines are appended to a large buffer per file, which a background thread writes to
+ * disk, so that parsing doesn't block on IO. The order of the lines reported to each file is kept,
+ * and they're only guaranteed to be written once ::dataset_error_output_free is called. Lines can
+ * be reported from multiple threads.
  */
 
 #ifndef DATASET_ERROR_OUTPUT_H
@@ -72,6 +77,18 @@ void dataset_error_output_report_flight_error(dataset_error_output_t *output,
 void dataset_error_output_report_passenger_error(dataset_error_output_t *output,
                                                  const char             *error_line);
 
+/**
+ * @brief   Writes a line to the `passengers_errors.csv` file, given the fields of the passenger.
+ * @details Avoids having to build the line in a buffer before reporting it.
+ *
+ * @param output    The contained of the error file.
+ * @param flight_id Identifier of the passenger's flight.
+ * @param user_id   Identifier of the passenger's user.
+ */
+void dataset_error_output_report_passenger_ids_error(dataset_error_output_t *output,
+                                                     const char             *flight_id,
+                                                     const char             *user_id);
+
 /**
  * @brief Writes a line to the `reservations_errors.csv` file.
  * @param output     The contained of the error file.
@@ -81,7 +98,24 @@ void dataset_error_output_report_reservation_error(dataset_error_output_t *outpu
                                                    const char             *error_line);
 
 /**
- * @brief Closes all file handles in @p input and `free`s the data structure.
+ * @brief   Copies all error files from a directory to another.
+ * @details Used to keep the error files of a dataset next to a
+ *          [snapshot](@ref database_snapshot.h) of its database, so that they can be restored
+ *          when the snapshot is loaded instead of the dataset.
+ *
+ * @param from Directory containing the error files, written by a ::dataset_error_output_t that
+ *             was already `free`d.
+ * @param to   Directory where to write copies of the error files to. If that directory does not
+ *             exist, it'll be created aswell (but not its parents).
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure (some files in @p to may have already been overwritten).
+ */
+int dataset_error_output_copy(const char *from, const char *to);
+
+/**
+ * @brief Writes all buffered lines, closes all file handles in @p input and `free`s the data
+ *        structure.
  * @param input Value to be deleted, allocated by ::dataset_error_output_create.
  *
  * #### Example
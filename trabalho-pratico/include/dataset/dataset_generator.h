@@ -0,0 +1,89 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    dataset_generator.h
+ * @brief   Generator of synthetic datasets, for scale testing.
+ * @details Writes `users.csv`, `flights.csv`, `passengers.csv` and `reservations.csv` (see
+ *          [dataset_loader](@ref dataset_loader.h)), whose sizes are proportional to a scale factor
+ *          (`1` is approximately the size of the large dataset provided with the project), and a
+ *          matching query file.
+ *
+ *          Some of the rows are made invalid on purpose, by replacing one of their fields with a
+ *          value that breaks one of the rules enforced by the loaders. Every generated field is
+ *          checked with the same parsing functions that the loaders use (e.g.:
+ *          ::email_validate_string_const, ::airport_code_from_string), so that valid rows are
+ *          known to be loaded and invalid ones to be rejected. Disagreements (which mean that the
+ *          generator and the loaders have gone out of sync) are reported to `stderr`.
+ *
+ *          Data is skewed like real data: a few hotels get most reservations, and a few hub
+ *          airports get most flights. Generation is deterministic for a given seed.
+ *
+ * @anchor dataset_generator_examples
+ * ### Examples
+ *
+ * Generate a dataset ten times larger than the large dataset, with 2 % of invalid rows:
+ *
+ * ```bash
+ * $ make generator
+ * $ ./programa-gerador big-dataset -s 10 -e 0.02
+ * $ ./programa-principal big-dataset big-dataset/input.txt
+ * ```
+ */
+
+#ifndef DATASET_GENERATOR_H
+#define DATASET_GENERATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @struct dataset_generator_options_t
+ * @brief  Configuration of a dataset to be generated.
+ *
+ * @var dataset_generator_options_t::output_dir
+ *     @brief Directory where to write the dataset files to. Must already exist.
+ * @var dataset_generator_options_t::scale
+ *     @brief Scale factor of the number of rows in each file.
+ * @var dataset_generator_options_t::invalid_fraction
+ *     @brief Fraction (between `0` and `1`) of rows to be made invalid on purpose.
+ * @var dataset_generator_options_t::nqueries
+ *     @brief Number of queries to write to `input.txt`.
+ * @var dataset_generator_options_t::seed
+ *     @brief Seed of the pseudo-random number generator.
+ */
+typedef struct {
+    const char *output_dir;
+    double      scale, invalid_fraction;
+    size_t      nqueries;
+    uint64_t    seed;
+} dataset_generator_options_t;
+
+/**
+ * @brief Generates a dataset and a query file.
+ *
+ * @param options Configuration of the dataset.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure. A message will also be printed to `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref dataset_generator_examples).
+ */
+int dataset_generator_generate(const dataset_generator_options_t *options);
+
+#endif
@@ -46,29 +46,94 @@
 #ifndef DATASET_INPUT_H
 #define DATASET_INPUT_H
 
+#include <stdint.h>
+
 #include "database/database.h"
 #include "dataset/dataset_error_output.h"
+#include "dataset/dataset_parser.h"
+#include "utils/mapped_file.h"
 
 /** @brief Collection of file handles for all dataset input files. */
 typedef struct dataset_input dataset_input_t;
 
 /**
- * @brief  Attempts to open all file handles for dataset input files.
- * @param  path Path to the directory containing the files.
- * @return A collection of file handles that must be `free`'d with ::dataset_input_free, or `NULL`
- *         on IO / allocation error.
+ * @brief   Attempts to open all file handles for dataset input files.
+ * @details Compressed files are decompressed in parallel, each on its own thread.
+ * @param   path Path to the directory containing the files.
+ * @return  A collection of file handles that must be `free`'d with ::dataset_input_free, or
+ *          `NULL` on IO / allocation error.
  *
  * #### Example
  * See [the header file's documentation](@ref dataset_input_examples).
  */
 dataset_input_t *dataset_input_create(const char *path);
 
+/**
+ * @brief   Makes room in a database for the contents of a dataset.
+ * @details The number of rows in each file is estimated when the files are opened, and passed to
+ *          ::database_reserve, so that the managers of @p database are sized once, before loading.
+ *
+ * @param input    Collection of file handles for dataset input.
+ * @param database Database that the dataset is going to be loaded into.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int dataset_input_reserve(const dataset_input_t *input, database_t *database);
+
+/**
+ * @brief   Calculates a number that identifies the current version of a dataset's files.
+ * @details It's calculated from the metadata of the files (location, size and modification time)
+ *          and from a few samples of their contents (beginning, middle and end), so it's very
+ *          quick to calculate. Any modification to the dataset's files will change it. Used to
+ *          detect outdated [database snapshots](@ref database_snapshot.h).
+ *
+ * @param path        Path to the directory containing the dataset files.
+ * @param fingerprint Where to write the fingerprint to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failed to get information about (or to read) one of the files.
+ */
+int dataset_input_get_fingerprint(const char *path, uint64_t *fingerprint);
+
+/**
+ * @brief Gets the size (in bytes) of each dataset input file.
+ *
+ * @param input        Collection of file handles for dataset input.
+ * @param users        Where to write the size of `users.csv` to.
+ * @param flights      Where to write the size of `flights.csv` to.
+ * @param passengers   Where to write the size of `passengers.csv` to.
+ * @param reservations Where to write the size of `reservations.csv` to.
+ */
+void dataset_input_get_sizes(const dataset_input_t *input,
+                             size_t                *users,
+                             size_t                *flights,
+                             size_t                *passengers,
+                             size_t                *reservations);
+
+/**
+ * @brief   Gets the contents of each dataset input file, already decompressed.
+ * @details Files are owned by @p input.
+ *
+ * @param input        Collection of file handles for dataset input.
+ * @param users        Where to write `users.csv` to.
+ * @param flights      Where to write `flights.csv` to.
+ * @param passengers   Where to write `passengers.csv` to.
+ * @param reservations Where to write `reservations.csv` to.
+ */
+void dataset_input_get_files(const dataset_input_t *input,
+                             const mapped_file_t  **users,
+                             const mapped_file_t  **flights,
+                             const mapped_file_t  **passengers,
+                             const mapped_file_t  **reservations);
+
 /**
  * @brief Loads all the users in a dataset into a @p database.
  *
  * @param input    Collection of file handles for dataset input.
  * @param output   Collection of file handles for dataset error output.
  * @param database Database to load the new users into.
+ * @param progress Where to report parsing progress to. Can be `NULL`.
  *
  * @retval 0 Success.
  * @retval 1 Failure.
@@ -76,9 +141,10 @@ dataset_input_t *dataset_input_create(const char *path);
  * #### Example
  * See [the header file's documentation](@ref dataset_input_examples).
  */
-int dataset_input_load_users(dataset_input_t        *input,
-                             dataset_error_output_t *output,
-                             database_t             *database);
+int dataset_input_load_users(dataset_input_t                 *input,
+                             dataset_error_output_t          *output,
+                             database_t                      *database,
+                             const dataset_parser_progress_t *progress);
 
 /**
  * @brief Loads all the flights in a dataset into a @p database.
@@ -86,6 +152,7 @@ int dataset_input_load_users(dataset_input_t        *input,
  * @param input    Collection of file handles for dataset input.
  * @param output   Collection of file handles for dataset error output.
  * @param database Database to load the new flights into.
+ * @param progress Where to report parsing progress to. Can be `NULL`.
  *
  * @retval 0 Success.
  * @retval 1 Failure.
@@ -93,9 +160,10 @@ int dataset_input_load_users(dataset_input_t        *input,
  * #### Example
  * See [the header file's documentation](@ref dataset_input_examples).
  */
-int dataset_input_load_flights(dataset_input_t        *input,
-                               dataset_error_output_t *output,
-                               database_t             *database);
+int dataset_input_load_flights(dataset_input_t                 *input,
+                               dataset_error_output_t          *output,
+                               database_t                      *database,
+                               const dataset_parser_progress_t *progress);
 
 /**
  * @brief Loads all the user-flight relationships (passengers) in a dataset into a @p database.
@@ -103,6 +171,7 @@ int dataset_input_load_flights(dataset_input_t        *input,
  * @param input    Collection of file handles for dataset input.
  * @param output   Collection of file handles for dataset error output.
  * @param database Database to load the new passengers into.
+ * @param progress Where to report parsing progress to. Can be `NULL`.
  *
  * @retval 0 Success.
  * @retval 1 Failure.
@@ -110,9 +179,10 @@ int dataset_input_load_flights(dataset_input_t        *input,
  * #### Example
  * See [the header file's documentation](@ref dataset_input_examples).
  */
-int dataset_input_load_passengers(dataset_input_t        *input,
-                                  dataset_error_output_t *output,
-                                  database_t             *database);
+int dataset_input_load_passengers(dataset_input_t                 *input,
+                                  dataset_error_output_t          *output,
+                                  database_t                      *database,
+                                  const dataset_parser_progress_t *progress);
 
 /**
  * @brief Loads all the reservations in a dataset into a @p database.
@@ -120,6 +190,7 @@ int dataset_input_load_passengers(dataset_input_t        *input,
  * @param input    Collection of file handles for dataset input.
  * @param output   Collection of file handles for dataset error output.
  * @param database Database to load the new reservations into.
+ * @param progress Where to report parsing progress to. Can be `NULL`.
  *
  * @retval 0 Success.
  * @retval 1 Failure.
@@ -127,9 +198,10 @@ int dataset_input_load_passengers(dataset_input_t        *input,
  * #### Example
  * See [the header file's documentation](@ref dataset_input_examples).
  */
-int dataset_input_load_reservations(dataset_input_t        *input,
-                                    dataset_error_output_t *output,
-                                    database_t             *database);
+int dataset_input_load_reservations(dataset_input_t                 *input,
+                                    dataset_error_output_t          *output,
+                                    database_t                      *database,
+                                    const dataset_parser_progress_t *progress);
 
 /**
  * @brief Closes all file handles in @p input and `free`s the data structure.
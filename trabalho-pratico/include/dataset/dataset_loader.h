@@ -25,6 +25,12 @@
  *          - `passengers.csv`;
  *          - `reservations.csv`.
  *
+ *          Files are loaded in a pipeline: `users.csv` and `flights.csv` are parsed concurrently,
+ *          on different threads, and `reservations.csv` and `passengers.csv` start being parsed as
+ *          soon as the files they depend on are loaded (see
+ *          [dataset_input's dependency graph](@ref dataset_input.h)). Only the additions to the
+ *          database are serialized.
+ *
  * @anchor dataset_loader_examples
  * ### Example
  *
@@ -44,7 +50,8 @@
  * @param dataset_path Path to the directory containing the dataset.
  * @param errors_path  Path to the directory where to output error files to.
  * @param metrics      Where to register program performance data to. Can be `NULL` for no
- *                     profiling.
+ *                     profiling. When profiling, files are loaded sequentially, on the calling
+ *                     thread, so that resource usage can be attributed to each one of them.
  *
  * @retval 0 Success.
  * @retval 1 Fatal failure (IO or allocation). Errors in the dataset won't cause this method to
@@ -58,4 +65,70 @@ int dataset_loader_load(database_t            *database,
                         const char            *errors_path,
                         performance_metrics_t *metrics);
 
+/**
+ * @brief   Loads a dataset from a [snapshot](@ref database_snapshot.h), parsing it only if needed.
+ * @details When the snapshot in @p snapshot_path was created from the same version of the dataset
+ *          (see ::dataset_input_get_fingerprint), it's loaded instead of the dataset, and the error
+ *          files kept with it are copied to @p errors_path. Otherwise, the dataset is parsed with
+ *          ::dataset_loader_load, and a new snapshot (and a copy of the error files, in
+ *          `snapshot_path.errors`) is saved for the next time. Failing to save a snapshot (e.g.:
+ *          read-only directory) isn't an error. Without a @p snapshot_path, the dataset is always
+ *          parsed, and nothing is saved.
+ *
+ * @param dataset_path  Path to the directory containing the dataset.
+ * @param errors_path   Path to the directory where to output error files to. Can be `NULL`.
+ * @param snapshot_path Path to the snapshot file. Can be `NULL`.
+ * @param metrics       Where to register program performance data to, if the dataset is parsed.
+ *                      Can be `NULL` for no profiling.
+ *
+ * @return A new database, that must be `free`d with ::database_free, or `NULL` on fatal failure
+ *         (IO or allocation).
+ */
+database_t *dataset_loader_load_cached(const char            *dataset_path,
+                                       const char            *errors_path,
+                                       const char            *snapshot_path,
+                                       performance_metrics_t *metrics);
+
+/**
+ * @brief   Callback that reports the progress of loading a file of a dataset.
+ * @details Called once for every file before loading starts (with @p bytes set to `0`), while it's
+ *          parsed, and once more when it's done. Calls for different files may happen concurrently,
+ *          from different threads.
+ *
+ * @param user_data   Pointer provided to ::dataset_loader_load_with_progress.
+ * @param file        File whose progress is being reported.
+ * @param bytes       Number of bytes of @p file already loaded.
+ * @param total_bytes Size of @p file, in bytes.
+ * @param rows        Number of lines of @p file already loaded.
+ *
+ * @return `0` to continue loading, another value to cancel it.
+ */
+typedef int (*dataset_loader_progress_callback_t)(void                              *user_data,
+                                                  performance_metrics_dataset_step_t file,
+                                                  size_t                             bytes,
+                                                  size_t                             total_bytes,
+                                                  size_t                             rows);
+
+/**
+ * @brief   Parses a dataset in @p dataset_path and stores the data in @p database, reporting
+ *          progress along the way.
+ * @details Like ::dataset_loader_load, without profiling. Meant to be run on a worker thread, so
+ *          that a user interface can keep showing progress while the dataset is loaded.
+ *
+ * @param database     Database where to store the dataset data in.
+ * @param dataset_path Path to the directory containing the dataset.
+ * @param errors_path  Path to the directory where to output error files to.
+ * @param callback     Method called to report the progress of loading each file.
+ * @param user_data    Pointer passed to @p callback.
+ *
+ * @retval 0 Success.
+ * @retval 1 Fatal failure (IO or allocation), or loading cancelled by @p callback. @p database
+ *           will be left partially loaded.
+ */
+int dataset_loader_load_with_progress(database_t                        *database,
+                                      const char                        *dataset_path,
+                                      const char                        *errors_path,
+                                      dataset_loader_progress_callback_t callback,
+                                      void                              *user_data);
+
 #endif
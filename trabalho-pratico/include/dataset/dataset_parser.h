@@ -47,6 +47,7 @@
  *
  * #include "dataset/dataset_parser.h"
  * #include "utils/fixed_n_delimiter_parser.h"
+ * #include "utils/mapped_file.h"
  * #include "utils/string_utils.h"
  *
  * #define TEST_FILE "testfile.txt"
@@ -96,8 +97,9 @@
  * // Print line before parsing. Here, it's used for tracing purposes, but, in practice, this
  * // callback usually serves to store the current line being parsed, in case there's a need to
  * // report an error.
- * int before_parse_token(void *user_data, char *token) {
+ * int before_parse_token(void *user_data, char *token, size_t offset) {
  *     (void) user_data;
+ *     (void) offset;
  *     printf("Parsing line: %s\n", token);
  *     return 0;
  * }
@@ -124,8 +126,8 @@
  * }
  *
  * int main(void) {
- *     int   retcode = 0;
- *     FILE *file    = fopen(TEST_FILE, "r");
+ *     int            retcode = 0;
+ *     mapped_file_t *file    = mapped_file_open(TEST_FILE);
  *     if (!file) {
  *         fputs("Failed to open file \"" TEST_FILE "\"!\n", stderr);
  *         return 1;
@@ -143,7 +145,7 @@
  *                                    add_to_reject_from_database);
  *
  *     person_dataset_t dataset = {0};
- *     int parse_result = dataset_parser_parse(file, grammar, &dataset);
+ *     int parse_result = dataset_parser_parse(file, grammar, &dataset, NULL);
  *     if (parse_result) {
  *         fputs("Parsing failure!\n", stderr);
  *         retcode = 1;
@@ -160,7 +162,7 @@
  *     }
  *
  * CLEANUP:
- *     fclose(file);
+ *     mapped_file_close(file);
  *     fixed_n_delimiter_parser_grammar_free(token_grammar);
  *     dataset_parser_grammar_free(grammar);
  *
@@ -186,14 +188,37 @@
  *
  * For information about single-line parsing, refer to
  * [fixed_n_delimiter_parser's examples](@ref fixed_n_delimiter_parser_examples).
+ *
+ * ### Parallel parsing
+ *
+ * Large files can be parsed with ::dataset_parser_parse_parallel, that splits a file into chunks
+ * (at first-order delimiter boundaries) and parses them on multiple threads. Each chunk gets its
+ * own `user_data`, created by a ::dataset_parser_chunk_create_callback, where results must be
+ * staged. These are then committed by a ::dataset_parser_chunk_commit_callback, called in the
+ * same order as the chunks appear in the file, one at a time. As long as all side effects are
+ * delayed until a commit, the results will be exactly the same as those of a sequential parse.
+ *
+ * ### Progress
+ *
+ * Both parsing methods can report how much of a file has been parsed, after every chunk, through a
+ * ::dataset_parser_progress_t. Its callback can also stop parsing (e.g.: when the user cancels
+ * loading a dataset).
+ *
+ * ### Instrumentation
+ *
+ * A ::dataset_parser_progress_t can also ask for the time spent in each phase of parsing (IO,
+ * tokenization, validation and commits) to be measured, in a ::dataset_parser_phases_t. Every
+ * thread accumulates its own measurements, only adding them to the shared ones when it's done
+ * parsing, so that threads don't contend with each other while measuring.
  */
 
 #ifndef DATASET_PARSER_H
 #define DATASET_PARSER_H
 
-#include <stdio.h>
+#include <stdint.h>
 
 #include "utils/fixed_n_delimiter_parser.h"
+#include "utils/mapped_file.h"
 
 /** @brief The grammar definition for a dataset parser. */
 typedef struct dataset_parser_grammar dataset_parser_grammar_t;
@@ -207,12 +232,16 @@ typedef struct dataset_parser_grammar dataset_parser_grammar_t;
  *                  the program's state.
  * @param unparsed  Token to be parsed. Do not store in @p user_data without copying it first, as
  *                  the lifetime of @p unparsed is limited to this method.
+ * @param offset    Offset of @p unparsed in the file, so that it can be read again from the file's
+ *                  contents after this method returns.
  *
  * @return `0` on success, another value for immediate termination of parsing. It's recommeneded
  *         that these values are positive, as negative values have special meanings (see
  *         ::DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE).
  */
-typedef int (*dataset_parser_token_before_parse_callback)(void *user_data, char *unparsed);
+typedef int (*dataset_parser_token_before_parse_callback)(void  *user_data,
+                                                          char  *unparsed,
+                                                          size_t offset);
 
 /**
  * @brief   Callback for each token delimited by the first-order delimiter in a dataset parser
@@ -271,6 +300,73 @@ dataset_parser_grammar_t *dataset_parser_grammar_clone(const dataset_parser_gram
  */
 void dataset_parser_grammar_free(dataset_parser_grammar_t *grammar);
 
+/**
+ * @brief   Callback that reports how much of a file has been parsed.
+ * @details Called after every chunk of the file is parsed (and committed, in
+ *          ::dataset_parser_parse_parallel). Calls for the same file never happen concurrently, but
+ *          they may come from any thread.
+ *
+ * @param progress_data ::dataset_parser_progress_t::user_data.
+ * @param bytes         Number of bytes of the file already parsed.
+ * @param tokens        Number of first-order tokens (e.g.: CSV lines) already parsed.
+ *
+ * @return `0` to continue parsing, another value to stop it (same rules as the return value of
+ *         ::dataset_parser_token_callback).
+ */
+typedef int (*dataset_parser_progress_callback)(void *progress_data, size_t bytes, size_t tokens);
+
+/**
+ * @struct  dataset_parser_phases_t
+ * @brief   Time spent in each phase of parsing a file, and how much of it was parsed.
+ * @details Times are summed over all threads that parsed the file, so, in
+ *          ::dataset_parser_parse_parallel, they can add up to more than the time parsing took.
+ *
+ * @var dataset_parser_phases_t::io_time
+ *     @brief Time (in nanoseconds) spent waiting for the file to be read from disk.
+ * @var dataset_parser_phases_t::tokenize_time
+ *     @brief Time (in nanoseconds) spent splitting the file into first-order tokens (e.g.: lines)
+ *            and copying them.
+ * @var dataset_parser_phases_t::validate_time
+ *     @brief   Time (in nanoseconds) spent in the callbacks of the grammar, parsing and validating
+ *              tokens.
+ *     @details Splitting tokens into fields is interleaved with those callbacks, so it's also
+ *              counted here. In ::dataset_parser_parse, where there are no commits, this also
+ *              includes adding results to the database.
+ * @var dataset_parser_phases_t::commit_time
+ *     @brief Time (in nanoseconds) spent in ::dataset_parser_chunk_commit_callback.
+ * @var dataset_parser_phases_t::bytes
+ *     @brief Number of bytes parsed.
+ * @var dataset_parser_phases_t::tokens
+ *     @brief Number of first-order tokens parsed.
+ * @var dataset_parser_phases_t::rejected_tokens
+ *     @brief Number of first-order tokens that ::fixed_n_delimiter_parser_parse_string failed to
+ *            parse (e.g.: the header and invalid lines of a CSV file).
+ */
+typedef struct {
+    uint64_t io_time, tokenize_time, validate_time, commit_time;
+    size_t   bytes, tokens, rejected_tokens;
+} dataset_parser_phases_t;
+
+/**
+ * @struct dataset_parser_progress_t
+ * @brief  Where to report the progress of parsing a file to.
+ *
+ * @var dataset_parser_progress_t::callback
+ *     @brief Method called after every chunk of the file is parsed. Can be `NULL`.
+ * @var dataset_parser_progress_t::user_data
+ *     @brief Pointer passed to ::dataset_parser_progress_t::callback.
+ * @var dataset_parser_progress_t::phases
+ *     @brief   Where to add the time spent in each phase of parsing to. Can be `NULL`, for no
+ *              measurements.
+ *     @details Only modified once every thread is done parsing, so it doesn't need to be
+ *              protected from other threads.
+ */
+typedef struct {
+    dataset_parser_progress_callback callback;
+    void                            *user_data;
+    dataset_parser_phases_t         *phases;
+} dataset_parser_progress_t;
+
 /** @brief Value returned by ::dataset_parser_parse when allocations fail. */
 #define DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE -1
 
@@ -281,14 +377,100 @@ void dataset_parser_grammar_free(dataset_parser_grammar_t *grammar);
  * @param grammar   Grammar that defines the parser to be used.
  * @param user_data Pointer passed to every callback in @p grammar, so that they can edit the
  *                  program's state.
+ * @param progress  Where to report parsing progress to. Can be `NULL`.
  *
  * @returns `0` on success. Other values are allowed, and happen when any of the callbacks in
- *          @p grammar return a non-`0` value, which is then returned by ::dataset_parser_parse.
- *          Also, ::DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE is returned when allocations fail.
+ *          @p grammar (or the one in @p progress) return a non-`0` value, which is then returned by
+ *          ::dataset_parser_parse. Also, ::DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE is returned
+ *          when allocations fail.
  *
  * #### Examples
  * See [the header file's documentation](@ref dataset_parser_examples).
  */
-int dataset_parser_parse(FILE *file, const dataset_parser_grammar_t *grammar, void *user_data);
+int dataset_parser_parse(const mapped_file_t             *file,
+                         const dataset_parser_grammar_t  *grammar,
+                         void                            *user_data,
+                         const dataset_parser_progress_t *progress);
+
+/**
+ * @brief   Callback that creates the staging data for a chunk of a file parsed by
+ *          ::dataset_parser_parse_parallel.
+ * @details The returned value will be passed to all the callbacks in the parser's grammar while the
+ *          chunk is parsed. This may be called from multiple threads at once.
+ *
+ * @param user_data Pointer provided to ::dataset_parser_parse_parallel.
+ * @param offset    Offset of the beginning of the chunk in the file (`0` for the first chunk).
+ *
+ * @return The staging data for the chunk, or `NULL` on allocation failure.
+ */
+typedef void *(*dataset_parser_chunk_create_callback)(void *user_data, size_t offset);
+
+/**
+ * @brief   Callback called after all lines of a chunk of a file are parsed, on the thread that
+ *          parsed them.
+ * @details Meant for work done in bulk for a whole chunk (e.g.: looking up all identifiers at
+ *          once), that shouldn't wait for the commit of previous chunks. This may be called from
+ *          multiple threads at once, for different chunks.
+ *
+ * @param user_data  Pointer provided to ::dataset_parser_parse_parallel.
+ * @param chunk_data Data created by a ::dataset_parser_chunk_create_callback, after the chunk is
+ *                   parsed.
+ *
+ * @return `0` on success, another value for termination of parsing (same rules as the return value
+ *         of ::dataset_parser_token_callback).
+ */
+typedef int (*dataset_parser_chunk_finish_callback)(void *user_data, void *chunk_data);
+
+/**
+ * @brief   Callback that commits the results staged while parsing a chunk of a file.
+ * @details Chunks are committed in the order they appear in the file, and never concurrently.
+ *
+ * @param user_data  Pointer provided to ::dataset_parser_parse_parallel.
+ * @param chunk_data Data created by a ::dataset_parser_chunk_create_callback, after the chunk is
+ *                   parsed.
+ *
+ * @return `0` on success, another value for termination of parsing (same rules as the return value
+ *         of ::dataset_parser_token_callback).
+ */
+typedef int (*dataset_parser_chunk_commit_callback)(void *user_data, void *chunk_data);
+
+/**
+ * @brief Callback that frees the data created by a ::dataset_parser_chunk_create_callback.
+ * @param chunk_data Data to be freed.
+ */
+typedef void (*dataset_parser_chunk_free_callback)(void *chunk_data);
+
+/**
+ * @brief   Parses a file on multiple threads, using a parser defined by @p grammar.
+ * @details The file is split into chunks, which are parsed in parallel, with their results staged
+ *          in data created by @p create_chunk. These are then committed by @p commit_chunk, in file
+ *          order. If the file is small, or threads can't be created, parsing happens on the calling
+ *          thread.
+ *
+ * @param file         File to parse.
+ * @param grammar      Grammar that defines the parser to be used. Its callbacks must be safe to
+ *                     call from multiple threads, as long as the `user_data`s are different.
+ * @param create_chunk Callback that creates the `user_data` for the callbacks in @p grammar, for
+ *                     each chunk.
+ * @param finish_chunk Callback called after each chunk is parsed, before it's committed. Can be
+ *                     `NULL`.
+ * @param commit_chunk Callback that commits the results staged in the data for a chunk.
+ * @param free_chunk   Callback that frees the data for a chunk.
+ * @param user_data    Pointer passed to @p create_chunk, @p finish_chunk and @p commit_chunk.
+ * @param progress     Where to report parsing progress to, after every commit. Can be `NULL`.
+ *
+ * @returns `0` on success. Other values are allowed, and happen when any of the callbacks return a
+ *          non-`0` value. ::DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE is returned when
+ *          allocations fail (including when @p create_chunk returns `NULL`). Results staged in a
+ *          chunk where a callback failed are not committed, nor are those in chunks after it.
+ */
+int dataset_parser_parse_parallel(const mapped_file_t                 *file,
+                                  const dataset_parser_grammar_t      *grammar,
+                                  dataset_parser_chunk_create_callback create_chunk,
+                                  dataset_parser_chunk_finish_callback finish_chunk,
+                                  dataset_parser_chunk_commit_callback commit_chunk,
+                                  dataset_parser_chunk_free_callback   free_chunk,
+                                  void                                *user_data,
+                                  const dataset_parser_progress_t     *progress);
 
 #endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    dataset_partitioner.h
+ * @brief   Splits a dataset into many smaller datasets (shards), partitioned by user.
+ * @details Every user is assigned to a shard by the hash of its identifier
+ *          (::dataset_partitioner_get_shard). Each shard gets the users assigned to it, along with
+ *          their reservations and passengers (user-flight relations), so that every query about a
+ *          single user can be answered by a single shard. Flights are copied to every shard.
+ *
+ *          Shards are datasets themselves, and can be loaded with
+ *          [dataset_loader](@ref dataset_loader.h). Lines are distributed without being parsed:
+ *          dataset errors are reported when each shard is loaded, by the shard that owns the line.
+ *          Lines too short to have a user identifier are kept in the first shard. Note that
+ *          flights with more passengers than seats are detected per shard, so flights whose
+ *          passengers only exceed their seats across many shards will be considered valid.
+ *
+ * @anchor dataset_partitioner_examples
+ * ### Examples
+ *
+ * ```c
+ * if (dataset_partitioner_partition("dataset", "dataset/.shards", 4))
+ *     return 1;
+ *
+ * char shard_path[PATH_MAX];
+ * snprintf(shard_path, PATH_MAX, DATASET_PARTITIONER_SHARD_PATH_FORMAT, "dataset/.shards", 0);
+ * database_t *database = dataset_loader_load_cached(shard_path, NULL, "shard.snapshot", NULL);
+ * ```
+ */
+
+#ifndef DATASET_PARTITIONER_H
+#define DATASET_PARTITIONER_H
+
+#include <stddef.h>
+
+/**
+ * @brief Format of the path of the directory of a shard, given the path of the partitioned dataset
+ *        (a string) and the index of the shard (a `size_t`).
+ */
+#define DATASET_PARTITIONER_SHARD_PATH_FORMAT "%s/%zu"
+
+/**
+ * @brief   Gets the shard a user is assigned to.
+ * @details Uses 64-bit FNV-1a, so that the assignment is the same across processes and machines.
+ *
+ * @param user_id Identifier of the user (doesn't need to be null-terminated).
+ * @param length  Number of characters in @p user_id.
+ * @param nshards Number of shards in the partitioned dataset.
+ *
+ * @return The index of the shard that owns the user with identifier @p user_id.
+ */
+size_t dataset_partitioner_get_shard(const char *user_id, size_t length, size_t nshards);
+
+/**
+ * @brief   Splits a dataset into @p nshards shards.
+ * @details The shard with index `i` is written to the directory
+ *          ::DATASET_PARTITIONER_SHARD_PATH_FORMAT. A fingerprint of @p dataset_path (see
+ *          ::dataset_input_get_fingerprint) is kept in @p partition_path, and partitioning is
+ *          skipped when it matches the current dataset, so that shards (and
+ *          [snapshots](@ref database_snapshot.h) created from them) are reused across runs.
+ *
+ * @param dataset_path   Path to the directory containing the dataset.
+ * @param partition_path Path to the directory where to write shards to. Created if it doesn't
+ *                       exist.
+ * @param nshards        Number of shards. Mustn't be `0`.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref dataset_partitioner_examples).
+ */
+int dataset_partitioner_partition(const char *dataset_path,
+                                  const char *partition_path,
+                                  size_t      nshards);
+
+#endif
@@ -22,27 +22,30 @@
 #ifndef PASSENGERS_LOADER_H
 #define PASSENGERS_LOADER_H
 
-#include <stdio.h>
-
 #include "database/database.h"
 #include "dataset/dataset_error_output.h"
+#include "dataset/dataset_parser.h"
+#include "utils/mapped_file.h"
 
 /**
  * @brief Parses a `passengers.csv` dataset file.
  *
- * @param passengers_stream File stream with passenger data to be loaded. It is assumed this stream
- *                          is ordered by flight identifier.
- * @param flights_stream    File stream with flight data to be printed in case of errors. It is
- *                          assumed this stream is also ordered by flight identifier.
- * @param database          Database to add users-flight relations (passengers) to.
- * @param output            Where to output dataset errors to.
+ * @param passengers_file File with passenger data to be loaded. It is assumed this file is ordered
+ *                        by flight identifier.
+ * @param flights_file    File with flight data to be printed in case of errors. It is assumed this
+ *                        file is also ordered by flight identifier.
+ * @param database        Database to add users-flight relations (passengers) to.
+ * @param output          Where to output dataset errors to.
+ * @param progress        Where to report the progress of parsing @p passengers_file to. Can be
+ *                        `NULL`.
  *
  * @retval 0 Success.
- * @retval 1 Allocation failure.
+ * @retval 1 Allocation failure (or parsing stopped by @p progress).
  */
-int passengers_loader_load(FILE                   *passengers_stream,
-                           FILE                   *flights_stream,
-                           database_t             *database,
-                           dataset_error_output_t *output);
+int passengers_loader_load(const mapped_file_t             *passengers_file,
+                           const mapped_file_t             *flights_file,
+                           database_t                      *database,
+                           dataset_error_output_t          *output,
+                           const dataset_parser_progress_t *progress);
 
 #endif
@@ -22,21 +22,25 @@
 #ifndef USERS_LOADER_H
 #define USERS_LOADER_H
 
-#include <stdio.h>
-
 #include "database/database.h"
 #include "dataset/dataset_error_output.h"
+#include "dataset/dataset_parser.h"
+#include "utils/mapped_file.h"
 
 /**
  * @brief Parses a `users.csv` dataset file.
  *
- * @param stream   File stream with user data to be loaded.
+ * @param file     File with user data to be loaded.
  * @param database Database to add users to.
  * @param output   Where to output dataset errors to.
+ * @param progress Where to report parsing progress to. Can be `NULL`.
  *
  * @retval 0 Success.
- * @retval 1 Allocation failure.
+ * @retval 1 Allocation failure (or parsing stopped by @p progress).
  */
-int users_loader_load(FILE *stream, database_t *database, dataset_error_output_t *output);
+int users_loader_load(const mapped_file_t             *file,
+                      database_t                      *database,
+                      dataset_error_output_t          *output,
+                      const dataset_parser_progress_t *progress);
 
 #endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    export_mode.h
+ * @brief   Export mode (write the dataset's tables as Arrow IPC files).
+ * @details The dataset is loaded (and validated) like in batch mode, and each of its tables is
+ *          written to a file in the [Arrow IPC file format](@ref database_arrow.h), that can be
+ *          read by pandas (`pyarrow.feather.read_table`), Polars or DuckDB without parsing (and
+ *          validating) the dataset again.
+ *
+ * @anchor export_mode_examples
+ * ### Examples
+ *
+ * Run `./programa-principal -e dataset exported` to write `exported/users.arrow`,
+ * `exported/flights.arrow` and `exported/reservations.arrow`.
+ */
+
+#ifndef EXPORT_MODE_H
+#define EXPORT_MODE_H
+
+/**
+ * @brief   Starts export mode.
+ * @details Error files of the dataset are written to `Resultados`, like in batch mode.
+ *
+ * @param dataset_dir Path to the directory containing the dataset.
+ * @param cache_dir   Path to the directory where a snapshot of the database is kept, or `NULL` for
+ *                    no snapshot.
+ * @param output_dir  Path to the directory where to write the exported tables to. Created if it
+ *                    doesn't exist.
+ *
+ * @retval 0 Success.
+ * @retval 1 Fatal failure (allocation / file IO errors). A message will also be printed to
+ *           `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref export_mode_examples).
+ */
+int export_mode_run(const char *dataset_dir, const char *cache_dir, const char *output_dir);
+
+#endif
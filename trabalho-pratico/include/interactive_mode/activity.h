@@ -98,6 +98,18 @@ activity_t *activity_create(activity_keypress_callback_t  keypress_callback,
  */
 const void *activity_run(activity_t *activity);
 
+/**
+ * @brief   Starts an event loop to run an activity that is re-rendered periodically.
+ * @details Like ::activity_run, but the activity is also rendered every @p interval milliseconds
+ *          without user input, so that it can show data that changes in the background.
+ *
+ * @param activity Activity to be run.
+ * @param interval Maximum time between renders, in milliseconds.
+ *
+ * @return The `activity_data` value provided to ::activity_create.
+ */
+const void *activity_run_refreshing(activity_t *activity, int interval);
+
 /**
  * @brief   Frees memory for an activity generated by ::activity_create.
  * @details You should only use this method if you're creating your own activity.
@@ -41,6 +41,11 @@
  *
  *   Usage  tips
  * ```
+ *
+ * Directories are listed in a background thread, and the first sub-directories are shown while
+ * others are still being listed. Sub-directories that contain all files of a dataset are shown in
+ * bold. Listings are kept while the dataset picker is open, so that going back to a directory is
+ * instant (`R` lists the current directory again).
  */
 
 #ifndef ACTIVITY_DATASET_PICKER_H
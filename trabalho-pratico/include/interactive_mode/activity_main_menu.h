@@ -25,15 +25,19 @@
  * following on screen:
  *
  * ```text
- * +--MAIN MENU---+
- * |              |
- * | Load dataset |
- * |              |
- * | Run query    |
- * |              |
- * | Leave        |
- * |              |
- * +--------------+
+ * +---MAIN MENU----+
+ * |                |
+ * | Load dataset   |
+ * |                |
+ * | Run query      |
+ * |                |
+ * | Run query file |
+ * |                |
+ * | License        |
+ * |                |
+ * | Leave          |
+ * |                |
+ * +----------------+
  * ```
  */
 
@@ -42,10 +46,11 @@
 
 /** @brief Action the user chose to perform in the main menu. */
 typedef enum {
-    ACTIVITY_MAIN_MENU_LOAD_DATASET, /**< Load a dataset. */
-    ACTIVITY_MAIN_MENU_RUN_QUERY,    /**< Run a query. */
-    ACTIVITY_MAIN_MENU_LICENSE,      /**< Read the application's license. */
-    ACTIVITY_MAIN_MENU_LEAVE         /**< Leave the application. */
+    ACTIVITY_MAIN_MENU_LOAD_DATASET,   /**< Load a dataset. */
+    ACTIVITY_MAIN_MENU_RUN_QUERY,      /**< Run a query. */
+    ACTIVITY_MAIN_MENU_RUN_QUERY_FILE, /**< Run all queries in a file. */
+    ACTIVITY_MAIN_MENU_LICENSE,        /**< Read the application's license. */
+    ACTIVITY_MAIN_MENU_LEAVE           /**< Leave the application. */
 } activity_main_menu_chosen_option_t;
 
 /**
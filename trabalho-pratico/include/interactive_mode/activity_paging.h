@@ -26,6 +26,9 @@
  * strings in the said array, and whether lines should be grouped in blocks (the definition of a
  * block can also be found on the documentation for ::activity_paging_run).
  *
+ * For very long outputs, ::activity_paging_run_source can be used instead, so that lines are only
+ * requested (and converted for display) when they're shown on screen.
+ *
  * The generated pages will look like the following on screen. In this example there are three lines
  * per block and three total blocks (one hidden on the next page).
  *
@@ -46,6 +49,28 @@
 
 #include <stddef.h>
 
+/**
+ * @brief   Method called by the paginator to get a line of text.
+ * @details Only the lines in the page being displayed are requested, and the returned string only
+ *          needs to be valid until the next call.
+ *
+ * @param source_data Pointer passed to ::activity_paging_run_source.
+ * @param i           Index of the line to get.
+ *
+ * @return The @p i-th line of text, a null-terminated UTF-8 string.
+ */
+typedef const char *(*activity_paging_source_t)(void *source_data, size_t i);
+
+/**
+ * @brief Method called by the paginator to get the number of lines generated so far.
+ *
+ * @param source_data Pointer passed to ::activity_paging_run_stream.
+ * @param complete    Where to output whether all lines have been generated to.
+ *
+ * @return The number of lines that can be obtained with the ::activity_paging_source_t.
+ */
+typedef size_t (*activity_paging_count_t)(void *source_data, int *complete);
+
 /**
  * @brief Runs a TUI activity for a paginator.
  *
@@ -68,4 +93,45 @@
  */
 int activity_paging_run(size_t n, const char *const lines[n], int blocking, const char *title);
 
+/**
+ * @brief   Runs a TUI activity for a paginator, whose lines are requested when needed.
+ * @details See ::activity_paging_run. Lines are pulled from @p get_line as pages are displayed, so
+ *          that the time and memory needed before the first page is shown don't depend on @p n.
+ *
+ * @param n           The number of lines.
+ * @param get_line    Method called to get each line.
+ * @param source_data Pointer passed to @p get_line.
+ * @param blocking    If text blocks should be considered in page separation.
+ * @param title       The title of the activity.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int activity_paging_run_source(size_t                   n,
+                               activity_paging_source_t get_line,
+                               void                    *source_data,
+                               int                      blocking,
+                               const char              *title);
+
+/**
+ * @brief   Runs a TUI activity for a paginator, whose lines are still being generated.
+ * @details See ::activity_paging_run_source. The screen is periodically rendered again, showing
+ *          lines as they're generated, and the user can leave (ESC) before they all are. Both
+ *          @p get_count and @p get_line may need to synchronize with whatever generates the lines.
+ *
+ * @param get_count   Method called to get the number of lines generated so far.
+ * @param get_line    Method called to get each line.
+ * @param source_data Pointer passed to @p get_count and @p get_line.
+ * @param blocking    If text blocks should be considered in page separation.
+ * @param title       The title of the activity.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int activity_paging_run_stream(activity_paging_count_t  get_count,
+                               activity_paging_source_t get_line,
+                               void                    *source_data,
+                               int                      blocking,
+                               const char              *title);
+
 #endif
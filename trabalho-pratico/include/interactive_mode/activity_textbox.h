@@ -39,11 +39,54 @@
  * ```
  *
  * If the user's input doesn't fit on the screen, the textbox will scroll and only show part of it.
+ *
+ * A textbox can also suggest completions for the word being typed, using
+ * ::activity_textbox_run_with_completion. Suggestions are listed below the text field, and `TAB`
+ * replaces the last word of the input with the first one:
+ *
+ * ```text
+ * +-------------+
+ * |             |
+ * |    TITLE    |
+ * |             |
+ * | +---------+ |
+ * | | INPUT   | |
+ * | +---------+ |
+ * |             |
+ * | SUGGESTION  |
+ * | SUGGESTION  |
+ * | ...         |
+ * |             |
+ * +-------------+
+ * ```
  */
 
 #ifndef ACTIVITY_TEXTBOX_H
 #define ACTIVITY_TEXTBOX_H
 
+#include <stddef.h>
+
+/** @brief Maximum number of completions shown by ::activity_textbox_run_with_completion. */
+#define ACTIVITY_TEXTBOX_MAX_COMPLETIONS 5
+
+/**
+ * @brief   Callback type for suggesting completions of a textbox's input.
+ * @details Called every time the input of a textbox changes, so it must be quick.
+ *
+ * @param completion_data Argument passed to ::activity_textbox_run_with_completion.
+ * @param text            Current input, in UTF-8.
+ * @param completions     Where to write suggestions to. Each suggestion replaces the last word
+ *                        (text after the last space) of @p text, and must be allocated with
+ *                        `g_malloc`, as the textbox will `g_free` it.
+ * @param max_completions Maximum number of elements that can be written to @p completions.
+ *
+ * @return The number of suggestions written to @p completions.
+ */
+typedef size_t (*activity_textbox_completion_callback_t)(void       *completion_data,
+                                                         const char *text,
+                                                         char      **completions,
+                                                         size_t      max_completions);
+
 /**
  * @brief Runs a TUI activity for a textbox.
  *
@@ -63,4 +106,25 @@
  */
 char *activity_textbox_run(const char *title, const char *initial_value, size_t text_field_width);
 
+/**
+ * @brief Runs a TUI activity for a textbox that suggests completions for its input.
+ *
+ * @param title            The title of the textbox that will be shown on the screen.
+ * @param initial_value    Initial text in the textbox.
+ * @param text_field_width Width of the textbox's text field. See ::activity_textbox_run.
+ * @param completion       Method that suggests completions for the input. May be `NULL`, for a
+ *                         textbox just like the one created by ::activity_textbox_run.
+ * @param completion_data  Pointer passed to every call of @p completion.
+ *
+ * @return The same as ::activity_textbox_run.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref activity_textbox_examples).
+ */
+char *activity_textbox_run_with_completion(const char                            *title,
+                                           const char                            *initial_value,
+                                           size_t                                 text_field_width,
+                                           activity_textbox_completion_callback_t completion,
+                                           void                                  *completion_data);
+
 #endif
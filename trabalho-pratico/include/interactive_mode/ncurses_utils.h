@@ -55,6 +55,10 @@
  *
  * If you have a UTF-32 string, please use ::ncurses_measure_unicode_string.
  *
+ * Widths of characters in the Basic Multilingual Plane (which includes CJK characters) are looked
+ * up in a table built on first use, so that measuring them doesn't go through glib's Unicode
+ * tables every time. ASCII characters are measured without any lookup.
+ *
  * #### String width limiting
  *
  * Before rendering a string in a limited space, you might want to know how many characters you
@@ -69,9 +73,8 @@
  * convert it to UTF-32 in the following way:
  *
  * ```c
- * glong length;
- * size_t width;
- * gunichar *utf32 = g_utf8_to_ucs4_fast("花火!", -1, &length);
+ * size_t     length, width;
+ * unichar_t *utf32 = ncurses_utf8_to_unicode("花火!", &length);
  * ```
  *
  * - `ncurses_prefix_from_maximum_length(utf32, length, &width)` will return 1, referring to the
@@ -111,6 +114,22 @@ typedef uint32_t unichar_t;
  */
 void ncurses_render_rectangle(int x, int y, int width, int height);
 
+/**
+ * @brief   Converts a UTF-8 string to UTF-32.
+ * @details Like `g_utf8_to_ucs4_fast`, @p str isn't validated beforehand, but invalid sequences are
+ *          replaced by `U+FFFD`. Runs of ASCII characters, the most common case, are converted many
+ *          at a time.
+ *
+ * @param str    Null-terminated UTF-8 string to be converted.
+ * @param length Where to write the number of codepoints in the output to. Can be `NULL`.
+ *
+ * @return A null-terminated UTF-32 string, that must be `free`d with `g_free`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref ncurses_utils_examples).
+ */
+unichar_t *ncurses_utf8_to_unicode(const char *str, size_t *length);
+
 /**
  * @brief   Writes an UTF-32 to an `ncurses` window.
  * @details Similar to `addnwstr`, but for a 32-bit codepoints, instead of whatever mess `wchar_t`
@@ -143,9 +162,6 @@ int ncurses_measure_character(unichar_t c);
  *          described ::ncurses_measure_character. Emojis (or any other multi-codepoint character
  *          not formed by diacritics) aren't supported. Multi-line strings aren't supported as well.
  *
- *          This function is somewhat slow, as it requires lots of lookups in Unicode tables. Try to
- *          keep its use to a minimum.
- *
  * @param str Null-terminated UTF-32 string to have its width measured.
  *
  * @return The width of @p str, in relation to a single-width character. A monospace font is
@@ -163,9 +179,6 @@ size_t ncurses_measure_unicode_string(const unichar_t *str);
  *          described ::ncurses_measure_character. Emojis (or any other multi-codepoint character
  *          not formed by diacritics) aren't supported. Multi-line strings aren't supported as well.
  *
- *          This function is somewhat slow, as it requires lots of lookups in Unicode tables.
- *          Try to keep its use to a minimum.
- *
  * @param str Null-terminated UTF-8 string to have its width measured.
  *
  * @return The width of @p str, in relation to a single-width character. A monospace font is
@@ -182,9 +195,6 @@ size_t ncurses_measure_string(const char *str);
  * @details Emojis (or any other multi-codepoint character not formed by diacritics) aren't
  *          supported. Multi-line strings aren't supported as well.
  *
- *          This function is somewhat slow, as it requires lots of lookups in Unicode tables. Try to
- *          keep its use to a minimum.
- *
  * @param str   Null-terminated UTF-32 string to have its width limited.
  * @param max   Maximum width limit.
  * @param width Where the width of the longest printable prefix will be placed. Can be `NULL`.
@@ -203,9 +213,6 @@ size_t ncurses_prefix_from_maximum_length(const unichar_t *str, size_t max, size
  * @details Emojis (or any other multi-codepoint character not formed by diacritics) aren't
  *          supported. Multi-line strings aren't supported as well.
  *
- *          This function is somewhat slow, as it requires lots of lookups in Unicode tables. Try to
- *          keep its use to a minimum.
- *
  * @param str   Null-terminated UTF-32 string to have its width limited.
  * @param len   Length of @p str.
  * @param max   Maximum width limit.
@@ -14,23 +14,66 @@
  * limitations under the License.
  */
 
+
 /**
  * @file    screen_loading_dataset.h
- * @brief   An `ncurses` screen that shows that a dataset is being loaded and that the program may
- *          become unresponsive.
+ * @brief   An `ncurses` screen that shows the progress of loading a dataset.
  * @details Its appearance on screen will be the following:
  *
  * ```text
- * +------------------------------------------------------------+
- * |                                                            |
- * | Loading dataset. The application will become unresponsive. |
- * |                                                            |
- * +------------------------------------------------------------+
+ * +------------------------------------------------+
+ * |                                                |
+ * | Loading dataset ...                            |
+ * |                                                |
+ * | users.csv         100%       10000 rows        |
+ * | flights.csv       100%        1000 rows        |
+ * | passengers.csv     42%      123456 rows        |
+ * | reservations.csv   37%       54321 rows        |
+ * |                                                |
+ * | [##################                     ]  47% |
+ * | 23.4 MiB/s, 00:12 remaining                    |
+ * |                                                |
+ * | ESC to cancel, ENTER to hide                   |
+ * |                                                |
+ * +------------------------------------------------+
  * ```
+ *
+ * When no progress information is available (e.g.: while loading a database snapshot), only the
+ * first line is shown.
+ */
+
+#ifndef SCREEN_LOADING_DATASET_H
+#define SCREEN_LOADING_DATASET_H
+
+#include <stddef.h>
+
+#include "testing/performance_metrics.h"
+
+/**
+ * @struct screen_loading_dataset_progress_t
+ * @brief  Progress of loading each file of a dataset, indexed by
+ *         ::performance_metrics_dataset_step_t.
+ *
+ * @var screen_loading_dataset_progress_t::bytes
+ *     @brief Number of bytes of each file already loaded.
+ * @var screen_loading_dataset_progress_t::total_bytes
+ *     @brief Size of each file, in bytes.
+ * @var screen_loading_dataset_progress_t::rows
+ *     @brief Number of lines of each file already loaded.
+ * @var screen_loading_dataset_progress_t::elapsed
+ *     @brief Number of seconds since loading started.
  */
+typedef struct {
+    size_t bytes[PERFORMANCE_METRICS_DATASET_FILE_COUNT];
+    size_t total_bytes[PERFORMANCE_METRICS_DATASET_FILE_COUNT];
+    size_t rows[PERFORMANCE_METRICS_DATASET_FILE_COUNT];
+    double elapsed;
+} screen_loading_dataset_progress_t;
 
 /**
- * @brief Renders an `ncurses`'s screen that shows that a dataset is being loaded and that the
- *        program may become unresponsive.
+ * @brief Renders an `ncurses`'s screen that shows the progress of loading a dataset.
+ * @param progress Progress of loading each file. Can be `NULL` when it isn't known.
  */
-void screen_loading_dataset_render(void);
+void screen_loading_dataset_render(const screen_loading_dataset_progress_t *progress);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    screen_running_queries.h
+ * @brief   An `ncurses` screen that shows the progress of running a query file.
+ * @details Its appearance on screen will be the following:
+ *
+ * ```text
+ * +------------------------------------------------+
+ * |                                                |
+ * | Running queries ...                            |
+ * |                                                |
+ * | Query 1      100%         120 / 120            |
+ * | Query 2       42%         126 / 300            |
+ * | Query 8        0%           0 / 45             |
+ * |                                                |
+ * | [##################                     ]  47% |
+ * | 1234.5 queries/s, 00:12 remaining              |
+ * |                                                |
+ * | ESC to cancel                                  |
+ * |                                                |
+ * +------------------------------------------------+
+ * ```
+ *
+ * Only query types present in the query file are listed. While statistical data is being generated,
+ * the first line reads `Preparing statistical data ...` instead.
+ */
+
+#ifndef SCREEN_RUNNING_QUERIES_H
+#define SCREEN_RUNNING_QUERIES_H
+
+#include "queries/query_dispatcher.h"
+
+/**
+ * @brief Renders an `ncurses`'s screen that shows the progress of running a query file.
+ *
+ * @param progress Snapshot of the progress of the queries being run (not accessed atomically).
+ * @param elapsed  Number of seconds since queries started being executed.
+ */
+void screen_running_queries_render(const query_dispatcher_progress_t *progress, double elapsed);
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    load_mode.h
+ * @brief   Load mode (replay a workload against a running server, and measure its latencies).
+ * @details Queries from a workload recorded by [server mode](@ref server_mode.h) (or from a query
+ *          file) are sent to a server at the times they were recorded, or at a target rate,
+ *          evenly spaced or as a Poisson process. The load is open-loop: queries are sent when
+ *          they're due, whether or not earlier ones were answered, through a few connections that
+ *          pipeline them. The latency of a query is measured from when it was due, not from when
+ *          it was sent, so that a server that falls behind isn't hidden by a slower load.
+ *
+ *          The achieved throughput and the latency percentiles of every query type are printed
+ *          once all queries are answered.
+ *
+ * @anchor load_mode_examples
+ * ### Examples
+ *
+ * With a server running on `/tmp/li3.sock` (see server_mode.h), run
+ * `./programa-carga /tmp/li3.sock workload.txt` to replay a recorded workload at its original
+ * speed, or `./programa-carga /tmp/li3.sock input.txt -q 5000 -p -r 10 -b` to send the queries in
+ * a query file ten times over, as Poisson arrivals at 5000 queries per second, using the binary
+ * protocol. See load.c for all options.
+ */
+
+#ifndef LOAD_MODE_H
+#define LOAD_MODE_H
+
+#include <stddef.h>
+
+/** @brief When queries are sent to the server. */
+typedef enum {
+    LOAD_MODE_ARRIVALS_RECORDED, /**< At the times in the workload, scaled by the speed. */
+    LOAD_MODE_ARRIVALS_UNIFORM,  /**< Evenly spaced, at the target rate. */
+    LOAD_MODE_ARRIVALS_POISSON   /**< As a Poisson process, whose mean is the target rate. */
+} load_mode_arrivals_t;
+
+/**
+ * @struct load_mode_options_t
+ * @brief  Configuration of a load test.
+ *
+ * @var load_mode_options_t::socket_path
+ *     @brief Path to the Unix domain socket the server is listening on.
+ * @var load_mode_options_t::workload_path
+ *     @brief Path to the workload file, or query file, to be replayed (see
+ *            [workload](@ref workload.h)).
+ * @var load_mode_options_t::arrivals
+ *     @brief   When queries are sent to the server.
+ *     @details ::LOAD_MODE_ARRIVALS_RECORDED requires a workload file, with arrival times.
+ * @var load_mode_options_t::rate
+ *     @brief Target number of queries per second, for ::LOAD_MODE_ARRIVALS_UNIFORM and
+ *            ::LOAD_MODE_ARRIVALS_POISSON.
+ * @var load_mode_options_t::speed
+ *     @brief How much faster than recorded to send queries, for ::LOAD_MODE_ARRIVALS_RECORDED.
+ * @var load_mode_options_t::repetitions
+ *     @brief Number of times the workload is sent (at least `1`), one after another.
+ * @var load_mode_options_t::connections
+ *     @brief Number of connections to the server (at least `1`), to which queries are sent in
+ *            turns.
+ * @var load_mode_options_t::binary
+ *     @brief Whether to use the binary protocol, instead of sending text queries.
+ * @var load_mode_options_t::compress
+ *     @brief Whether to ask for compressed replies, when using the binary protocol.
+ */
+typedef struct {
+    const char          *socket_path;
+    const char          *workload_path;
+    load_mode_arrivals_t arrivals;
+    double               rate, speed;
+    size_t               repetitions, connections;
+    int                  binary, compress;
+} load_mode_options_t;
+
+/**
+ * @brief Runs a load test and prints its results to `stdout`.
+ *
+ * @param options Configuration of the load test.
+ *
+ * @retval 0 Success (even if some queries failed).
+ * @retval 1 Fatal failure (allocation / socket / file IO errors, or all connections closed). A
+ *           message will also be printed to `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref load_mode_examples).
+ */
+int load_mode_run(const load_mode_options_t *options);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    partitioned_mode.h
+ * @brief   Partitioned mode (answer queries with the dataset split among many processes).
+ * @details The dataset is split into shards by [dataset_partitioner](@ref dataset_partitioner.h),
+ *          one for each worker process. Users, their reservations and their passengers (user-flight
+ *          relations) are only kept by the shard that owns them, so no process needs to hold the
+ *          whole dataset in memory. Flights are kept by every shard.
+ *
+ *          A coordinator (the parent process) reads a query file, like in batch mode, and decides
+ *          which shards each query is sent to:
+ *
+ *          - Queries about users (queries 1 and 2) are routed to the shard owning the user;
+ *          - Queries about flights alone (queries 5 and 7) are routed to the first shard;
+ *          - Queries 1 (for flights and reservations), 3, 6, 8 and 10 are scattered to every
+ *            shard, and the partial results are merged (e.g.: sums of ratings and their counts,
+ *            for query 3, or passengers per airport, for query 6).
+ *
+ *          Other queries (and approximate queries) aren't supported, and no output is written for
+ *          them. Shards communicate with the coordinator through Unix domain sockets, with the
+ *          same protocol as [server mode](@ref server_mode.h), so that they could be moved to
+ *          other machines.
+ *
+ * @anchor partitioned_mode_examples
+ * ### Examples
+ *
+ * Run `./programa-principal -p dataset queries.txt 4` to answer the queries in `queries.txt` with
+ * the dataset split among 4 processes. Outputs are written to `Resultados`, like in batch mode.
+ */
+
+#ifndef PARTITIONED_MODE_H
+#define PARTITIONED_MODE_H
+
+#include <stddef.h>
+
+/**
+ * @brief   Starts partitioned mode.
+ * @details Shards are kept in @p dataset_dir, and reused by later runs with the same number of
+ *          shards, if the dataset doesn't change. Each shard also keeps a
+ *          [snapshot](@ref database_snapshot.h) of its database.
+ *
+ * @param dataset_dir     Path to the directory containing the dataset.
+ * @param query_file_path Path to the file containing the queries.
+ * @param nshards         Number of shards (and of worker processes). Mustn't be `0`.
+ *
+ * @retval 0 Success.
+ * @retval 1 Fatal failure (allocation / file IO errors, or a worker process failed). A message
+ *           will also be printed to `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref partitioned_mode_examples).
+ */
+int partitioned_mode_run(const char *dataset_dir, const char *query_file_path, size_t nshards);
+
+#endif
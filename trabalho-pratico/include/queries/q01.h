@@ -73,4 +73,19 @@
  */
 query_type_t *q01_create(void);
 
+/**
+ * @brief Executes a query of type 1.
+ *
+ * @param database   Database where to get users / reservations / flights from
+ * @param statistics `NULL`, as this query does not generate statistical data.
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's output to.
+ *
+ * @retval 0 Always successful.
+ */
+int q01_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
@@ -49,4 +49,22 @@
  */
 query_type_t *q02_create(void);
 
+/**
+ * @brief   Executes a query of type 2.
+ * @details The user manager keeps the flights and the reservations of each user sorted in the
+ *          order required by this query, so they only need to be merged.
+ *
+ * @param database   Database to get information from.
+ * @param statistics Always `NULL`, as this query does not use statistic data.
+ * @param instance   Query instance to be executed.
+ * @param output     Where to output query results to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int q02_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
@@ -43,4 +43,21 @@
  */
 query_type_t *q03_create(void);
 
+/**
+ * @brief   Method called to execute a query of type 3.
+ * @details Ratings are accumulated by the reservation manager (see
+ *          ::reservation_manager_get_hotel_ratings), so no statistical data is needed.
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Always successful.
+ */
+int q03_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
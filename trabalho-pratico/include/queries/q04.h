@@ -43,4 +43,22 @@
  */
 query_type_t *q04_create(void);
 
+/**
+ * @brief   Method called to execute a query of type 4.
+ * @details Reservations are looked up in the reservation manager's index of hotels (see
+ *          ::reservation_manager_iter_hotel), that already provides them in the desired order.
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int q04_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
@@ -44,4 +44,22 @@
  */
 query_type_t *q05_create(void);
 
+/**
+ * @brief   Method called to execute a query of type 5.
+ * @details Flights are looked up in the flight manager's index of departures (see
+ *          ::flight_manager_iter_origin_departures), that already provides them in the desired
+ *          order.
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Always successful.
+ */
+int q05_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
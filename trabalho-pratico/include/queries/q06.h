@@ -16,7 +16,9 @@
 
 /**
  * @file  q06.h
- * @brief List the top N airports with the most passengers, for a given year.
+ * @brief   List the top N airports with the most passengers, for a given year.
+ * @details Approximate queries (e.g.: `6A`) only count a sample of the flights, and also output the
+ *          half-width of a 95% confidence interval of each count (`passengers_error`).
  *
  * ### Examples
  *
@@ -27,6 +29,7 @@
  * 6F 2023 10
  * 6F 2022 10
  * 6F 2021 10
+ * 6A 2023 10
  * ```
  */
 
@@ -43,4 +46,23 @@
  */
 query_type_t *q06_create(void);
 
+/**
+ * @brief   Executes a query of type 6.
+ * @details Prints the top N airports with the most passangers in a given year.
+ *
+ * @param database   Database to get data from (not used, as all data is collected in
+ *                   ::__q06_generate_statistics).
+ * @param statistics Statistics generated by ::__q06_generate_statistics (a pointer to a
+ *                   ::q06_statistical_data_t).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int q06_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
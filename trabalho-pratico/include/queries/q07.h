@@ -16,7 +16,10 @@
 
 /**
  * @file  q07.h
- * @brief A query to that lists the top N airports by median of departure delays.
+ * @brief   A query to that lists the top N airports by median of departure delays.
+ * @details Approximate queries (e.g.: `7A`) summarize delays in a ::t_digest_t instead of keeping
+ *          all of them, and also output an upper bound of the error of each median
+ *          (`median_error`).
  *
  * ### Examples
  *
@@ -25,6 +28,7 @@
  * 7 20
  * 7F 10
  * 7F 20
+ * 7A 10
  * ```
  */
 
@@ -41,4 +45,21 @@
  */
 query_type_t *q07_create(void);
 
+/**
+ * @brief Executes a query of type 7.
+ *
+ * @param database   Database to get data from (not used, as all data is collected in
+ *                   ::__q07_generate_statistics).
+ * @param statistics Value returned by ::__q07_generate_statistics_end (a pointer to a
+ *                   ::q07_statistical_data_t).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's output to.
+ *
+ * @retval 0 Always successful.
+ */
+int q07_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
@@ -47,4 +47,25 @@
  */
 query_type_t *q08_create(void);
 
+/**
+ * @brief   Method called to execute a query of type 8.
+ * @details Revenue during a range of dates is the difference between two values in
+ *          ::q08_hotel_revenue_t::cumulative. When queries are answered from indexes (see
+ *          ::__q08_index_cost), the reservations of the hotel are iterated through instead.
+ *
+ * @param database   Database to get data from (only used when there's no statistical data).
+ * @param statistics Statistical data generated by ::__q08_generate_statistics_end (a
+ *                   ::GConstKeyHashTable associating hotel identifiers with
+ *                   ::q08_hotel_revenue_t), or `NULL`.
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int q08_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
@@ -45,4 +45,22 @@
  */
 query_type_t *q09_create(void);
 
+/**
+ * @brief   Executes a query of type 9.
+ * @details Users are looked up in the user manager's index of names (see
+ *          ::user_manager_iter_name_prefix), that already provides them in the desired order.
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's output to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int q09_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
@@ -43,4 +43,21 @@
  */
 query_type_t *q10_create(void);
 
+/**
+ * @brief Method called to execute a query of type 10.
+ *
+ * @param database   Database to get data from (not used, as all data is collected in
+ *                   ::__q10_generate_statistics).
+ * @param statistics Statistical data generated by ::__q10_generate_statistics (a pointer to a
+ *                   ::q10_statistical_data_t).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Always successful.
+ */
+int q10_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
 #endif
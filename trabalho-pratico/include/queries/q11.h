@@ -0,0 +1,67 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  q11.h
+ * @brief A query to present the flights of a route (from an airport to another), or the delay
+ *        statistics of that route.
+ *
+ * With a time frame, every flight of the route scheduled to depart during it is listed, along with
+ * its delay. Without one, a single object is outputted, with the number of flights and passengers
+ * of the route, and its average and maximum delays (in seconds).
+ *
+ * ### Examples
+ *
+ * ```text
+ * 11 LIS MAD "2021/01/01 00:00:00" "2022/12/31 23:59:59"
+ * 11 AMS LIS "2023/01/01 00:00:00" "2023/05/31 23:59:59"
+ * 11 LIS MAD
+ * 11F LIS MAD "2021/01/01 00:00:00" "2022/12/31 23:59:59"
+ * 11F AMS LIS
+ * ```
+ */
+
+#ifndef Q11_H
+#define Q11_H
+
+#include "queries/query_type.h"
+
+/**
+ * @brief   Initializes the definition of queries of type 11.
+ * @details This is done automatically in [query_type_list](@ref query_type_list.c).
+ * @return  On success, a pointer to a ::query_type_t that must be deleted with ::query_type_free,
+ *          or `NULL` allocation on failure.
+ */
+query_type_t *q11_create(void);
+
+/**
+ * @brief   Method called to execute a query of type 11.
+ * @details Flights are looked up in the flight manager's index of routes (see
+ *          ::flight_manager_iter_route_departures), so only the flights of the route are visited.
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Always successful.
+ */
+int q11_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
+#endif
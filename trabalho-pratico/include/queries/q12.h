@@ -0,0 +1,82 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    q12.h
+ * @brief   A query to count or list the flights, reservations or users that match a set of filters.
+ * @details The first argument is the entity to filter (`flights`, `reservations` or `users`), and
+ *          the second is what to output: `count` for a single object with the number of matches,
+ *          or `ids` for the identifiers of all matches. Then, every filter is three arguments: a
+ *          column, a comparison operator (`=`, `!=`, `<`, `<=`, `>` or `>=`) and a value. A row
+ *          matches the query when it matches all filters. Flight and reservation identifiers are
+ *          outputted in ascending order, and users in the order they were loaded in.
+ *
+ *          Flights can be filtered by `origin` and `destination` (airport codes), `departure`
+ *          (scheduled departure date, with time), `delay` (in seconds) and `passengers`.
+ *          Reservations can be filtered by `hotel` (hotel identifier), `stars`, `rating` (`0` for
+ *          no rating), `begin` and `end` (dates), `price` (price per night) and `breakfast`. Users
+ *          can only be filtered with `=`, by `status` (account status), `sex` and `country`.
+ *
+ *          Filters are evaluated over the columns of the database, block by block, without any
+ *          branches, so that the compiler can vectorize them. Users, and reservation counts where
+ *          every filter is `stars =` or `breakfast =`, are found by intersecting bitmap indexes
+ *          instead (see ::user_manager_get_bitmap and ::reservation_manager_get_bitmap).
+ *
+ * ### Examples
+ *
+ * ```text
+ * 12 flights count origin = LIS delay >= 3600
+ * 12 flights ids origin = LIS destination != MAD departure >= "2023/01/01 00:00:00"
+ * 12 reservations count stars >= 4 rating <= 2
+ * 12 reservations count stars = 5 breakfast = true
+ * 12 users count status = active country = PT
+ * 12F reservations ids hotel = HTL10001 begin >= 2023/05/01 end < 2023/06/01
+ * ```
+ */
+
+#ifndef Q12_H
+#define Q12_H
+
+#include "queries/query_type.h"
+
+/**
+ * @brief   Initializes the definition of queries of type 12.
+ * @details This is done automatically in [query_type_list](@ref query_type_list.c).
+ * @return  On success, a pointer to a ::query_type_t that must be deleted with ::query_type_free,
+ *          or `NULL` allocation on failure.
+ */
+query_type_t *q12_create(void);
+
+/**
+ * @brief   Method called to execute a query of type 12.
+ * @details The columns of the filtered entity are scanned block by block (see
+ *          ::flight_manager_iter_columns and ::reservation_manager_iter_columns), unless the query
+ *          can be answered by intersecting bitmaps (see ::__q12_execute_bitmaps).
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int q12_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    q13.h
+ * @brief   A query to list the passengers of a flight.
+ * @details The only argument is a flight identifier. For every user that travelled in that flight,
+ *          its identifier and name are outputted, in the order users were loaded in. Flights
+ *          without passengers (or that don't exist) have no output.
+ *
+ * ### Examples
+ *
+ * ```text
+ * 13 0000000029
+ * 13 0000000444
+ * 13F 0000000946
+ * ```
+ */
+
+#ifndef Q13_H
+#define Q13_H
+
+#include "queries/query_type.h"
+
+/**
+ * @brief   Initializes the definition of queries of type 13.
+ * @details This is done automatically in [query_type_list](@ref query_type_list.c).
+ * @return  On success, a pointer to a ::query_type_t that must be deleted with ::query_type_free,
+ *          or `NULL` allocation on failure.
+ */
+query_type_t *q13_create(void);
+
+/**
+ * @brief   Method called to execute a query of type 13.
+ * @details Passengers are looked up in the user manager's reverse index of flights (see
+ *          ::user_manager_get_passengers_by_flight), so that no users are scanned, and only the
+ *          ones in the requested page are outputted.
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance to be executed.
+ * @param output     Where to write the query's result to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int q13_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output);
+
+#endif
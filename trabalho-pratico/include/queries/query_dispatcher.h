@@ -31,41 +31,186 @@
 #ifndef QUERY_DISPATCHER_H
 #define QUERY_DISPATCHER_H
 
+#include <stdint.h>
+
 #include "database/database.h"
 #include "queries/query_instance_list.h"
+#include "queries/query_statistics_cache.h"
+#include "queries/query_type_list.h"
 #include "testing/performance_metrics.h"
+#include "utils/cancellation.h"
+#include "utils/numa_topology.h"
+
+/**
+ * @struct  query_dispatcher_progress_t
+ * @brief   Progress of ::query_dispatcher_dispatch_list_with_progress.
+ * @details All fields are accessed atomically (with `g_atomic_int_*`, or through
+ *          ::cancellation_cancel), so that they can be read and set from other threads while
+ *          queries are dispatched. Initialize all fields to `0`.
+ *
+ * @var query_dispatcher_progress_t::total
+ *     @brief Number of queries of each type (indexed by type number), set before statistical data
+ *            starts being generated.
+ * @var query_dispatcher_progress_t::done
+ *     @brief Number of queries of each type (indexed by type number) already executed.
+ * @var query_dispatcher_progress_t::executing
+ *     @brief Whether statistical data has been generated, and queries are being executed.
+ * @var query_dispatcher_progress_t::cancellation
+ *     @brief   Requested by other threads for queries not yet executed to be skipped (their
+ *              outputs are left empty), and for running queries to stop early.
+ *     @details A deadline can also be set, before dispatching queries.
+ */
+typedef struct {
+    int            total[QUERY_TYPE_LIST_COUNT + 1];
+    int            done[QUERY_TYPE_LIST_COUNT + 1];
+    int            executing;
+    cancellation_t cancellation;
+} query_dispatcher_progress_t;
+
+/**
+ * @struct  query_dispatcher_costs_t
+ * @brief   Measured costs of each query type, used to start the most expensive work first.
+ * @details Can be filled from the metrics of a previous run, with
+ *          ::query_dispatcher_costs_from_metrics. All arrays are indexed by type number.
+ *
+ * @var query_dispatcher_costs_t::statistics
+ *     @brief Time (in microseconds) taken to generate statistical data for all queries of a type.
+ * @var query_dispatcher_costs_t::execution
+ *     @brief Average time (in microseconds) taken to execute a single query of a type.
+ * @var query_dispatcher_costs_t::measured
+ *     @brief Whether the costs of a query type were measured (the other fields are `0` if not).
+ */
+typedef struct {
+    uint64_t statistics[QUERY_TYPE_LIST_COUNT + 1];
+    uint64_t execution[QUERY_TYPE_LIST_COUNT + 1];
+    int      measured[QUERY_TYPE_LIST_COUNT + 1];
+} query_dispatcher_costs_t;
+
+/**
+ * @brief Gets the costs of the query types measured in a run of ::query_dispatcher_dispatch_list.
+ *
+ * @param costs   Where to write the costs to. Types without executed queries aren't measured.
+ * @param metrics Performance metrics passed to ::query_dispatcher_dispatch_list.
+ */
+void query_dispatcher_costs_from_metrics(query_dispatcher_costs_t    *costs,
+                                         const performance_metrics_t *metrics);
+
+/**
+ * @brief   Sets how much memory the statistical data of each query type may take.
+ * @details Applies to all following dispatches. When the statistical data for all queries of a
+ *          type is estimated to go over @p bytes (see ::query_type_scan_t::estimate_size), those
+ *          queries are run after all others, in groups small enough for their statistical data to
+ *          fit in the budget. Each group's statistical data is freed before the next one's is
+ *          generated, and isn't kept in any ::query_statistics_cache_t, nor measured when
+ *          profiling.
+ *
+ * @param bytes Memory budget, in bytes, or `0` for no budget (the default).
+ */
+void query_dispatcher_set_statistics_budget(size_t bytes);
 
 /**
  * @brief   Runs a single query.
  * @details If you want to run multiple queries, do not call this method multiple times, as that
  *          will be very innefficient. Queries generate statistical data, shared by all queries of
  *          the same type to improve performance. That can only be taken advantage of by using
- *          ::query_dispatcher_dispatch_list.
+ *          ::query_dispatcher_dispatch_list, or by using a @p cache, when a query type's
+ *          statistical data doesn't depend on query arguments.
  *
  * @param database       Database, so that the query can get information.
+ * @param cache          Statistical data kept from previous queries on @p database. Can be `NULL`.
  * @param query_instance Query to be run.
  * @param output         Where the query's result should be written to.
  *
  * @retval 0 Query preparation success. Running the query itself might have silently failed.
  * @retval 1 Allocation failure or invalid @p query_instance.
  */
-int query_dispatcher_dispatch_single(const database_t       *database,
-                                     const query_instance_t *query_instance,
-                                     query_writer_t         *output);
+int query_dispatcher_dispatch_single(const database_t         *database,
+                                     query_statistics_cache_t *cache,
+                                     const query_instance_t   *query_instance,
+                                     query_writer_t           *output);
 
 /**
- * @brief Runs a list of queries.
+ * @brief   Runs a list of queries.
+ * @details The statistical data for every query type is generated in parallel, and then the
+ *          queries are executed by a pool of threads, that steal queries from each other when
+ *          they run out of work. Queries with large outputs may be executed in chunks, by multiple
+ *          threads (see ::query_type_count_results_callback_t). Queries only read from
+ *          @p database, and each query (or chunk) writes to its own output, so no synchronization
+ *          is needed by query types.
+ *
+ *          Execution stops early if the calling thread's current cancellation is requested (see
+ *          ::cancellation_set_current), leaving the outputs of unfinished queries incomplete.
+ *
+ *          Work for the most expensive query types is started first, so that it doesn't end up
+ *          running alone on a single thread at the end. Costs are estimated from the size of the
+ *          database and the number of queries, unless measured costs are provided (see
+ *          ::query_dispatcher_dispatch_list_with_hints).
  *
  * @param database            Database, so that the queries can get information.
+ * @param cache               Statistical data kept from previous queries on @p database, that is
+ *                            used instead of generating it again, and where reusable statistical
+ *                            data will be added to. Can be `NULL`.
  * @param query_instance_list List of queries to be run. Cannot be `const`, as this list may get
  *                            sorted. However, no new items will be added to it.
  * @param outputs             Where the queries' results will be written to. These should be in
  *                            the same order as @p query_instance_list after being sorted.
+ * @param nthreads            Maximum number of threads to use. `0` uses one thread per processor.
  * @param metrics             Where to write profiling data to. Can be `NULL` for no profiling.
+ *                            When profiling, only one thread is used, so that measurements of
+ *                            different queries don't overlap.
+ */
+void query_dispatcher_dispatch_list(const database_t         *database,
+                                    query_statistics_cache_t *cache,
+                                    query_instance_list_t    *query_instance_list,
+                                    query_writer_t *const    *outputs,
+                                    size_t                    nthreads,
+                                    performance_metrics_t    *metrics);
+
+/**
+ * @brief   Runs a list of queries, reporting progress.
+ * @details Like ::query_dispatcher_dispatch_list, but the number of executed queries of each type
+ *          is written to @p progress as they finish, and execution can be cancelled through it.
+ *          Without @p progress, queries are cancelled through the calling thread's current
+ *          cancellation (see ::cancellation_set_current).
+ *
+ * @param database            Database, so that the queries can get information.
+ * @param cache               See ::query_dispatcher_dispatch_list.
+ * @param query_instance_list See ::query_dispatcher_dispatch_list.
+ * @param outputs             See ::query_dispatcher_dispatch_list.
+ * @param nthreads            See ::query_dispatcher_dispatch_list.
+ * @param metrics             See ::query_dispatcher_dispatch_list.
+ * @param progress            Where to report progress to. Can be `NULL`.
+ */
+void query_dispatcher_dispatch_list_with_progress(const database_t            *database,
+                                                  query_statistics_cache_t    *cache,
+                                                  query_instance_list_t       *query_instance_list,
+                                                  query_writer_t *const       *outputs,
+                                                  size_t                       nthreads,
+                                                  performance_metrics_t       *metrics,
+                                                  query_dispatcher_progress_t *progress);
+
+/**
+ * @brief   Runs a list of queries, using hints about how to schedule them.
+ * @details Like ::query_dispatcher_dispatch_list, but without profiling. The costs of query types
+ *          are taken from @p costs (see ::query_dispatcher_dispatch_list for how work is ordered),
+ *          and worker threads are pinned to the NUMA nodes in @p topology, so that they read from
+ *          node-local replicas of indices (see ::database_replicate_indexes).
+ *
+ * @param database            Database, so that the queries can get information.
+ * @param cache               See ::query_dispatcher_dispatch_list.
+ * @param query_instance_list See ::query_dispatcher_dispatch_list.
+ * @param outputs             See ::query_dispatcher_dispatch_list.
+ * @param nthreads            See ::query_dispatcher_dispatch_list.
+ * @param costs               Measured costs of query types. Can be `NULL`.
+ * @param topology            NUMA nodes to pin worker threads to. Can be `NULL`, for threads not
+ *                            to be pinned.
  */
-void query_dispatcher_dispatch_list(const database_t      *database,
-                                    query_instance_list_t *query_instance_list,
-                                    query_writer_t *const *outputs,
-                                    performance_metrics_t *metrics);
+void query_dispatcher_dispatch_list_with_hints(const database_t               *database,
+                                               query_statistics_cache_t       *cache,
+                                               query_instance_list_t          *query_instance_list,
+                                               query_writer_t *const          *outputs,
+                                               size_t                          nthreads,
+                                               const query_dispatcher_costs_t *costs,
+                                               const numa_topology_t          *topology);
 
 #endif
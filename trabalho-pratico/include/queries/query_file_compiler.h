@@ -0,0 +1,134 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    query_file_compiler.h
+ * @brief   Compiled query files, containing already parsed queries in a binary format.
+ * @details The same query files are often run against many datasets. A compiled query file stores
+ *          the queries of a text query file after they're parsed (type, line in the text file,
+ *          formatting flag, page and arguments), so that they can be read back from a mapped file
+ *          without tokenizing any line or calling any ::query_type_parse_arguments_callback_t.
+ *
+ *          The arguments of each query are stored as they are in memory, followed by the data they
+ *          refer to (see ::query_type_save_arguments_callback_t), so compiled query files can only
+ *          be read by builds of this program with the same ABI. Queries are stored grouped by
+ *          type, in the order of ::query_instance_list_iter.
+ *
+ * @anchor query_file_compiler_examples
+ * ### Examples
+ *
+ * ```c
+ * FILE *input = fopen("queries.txt", "r"); // Error handling omitted
+ * query_instance_list_t *list = query_file_parser_parse(input);
+ * fclose(input);
+ *
+ * query_file_compiler_save(list, "queries.bin");
+ * query_instance_list_free(list);
+ * ```
+ *
+ * Later, possibly in another run of the program:
+ *
+ * ```c
+ * query_instance_list_t *list = query_file_compiler_load_or_parse("queries.bin");
+ * ```
+ *
+ * ::query_file_compiler_load_or_parse also accepts text query files, so programs that take a query
+ * file from the user don't need to know which kind of file they were given.
+ */
+
+#ifndef QUERY_FILE_COMPILER_H
+#define QUERY_FILE_COMPILER_H
+
+#include "queries/query_file_parser.h"
+#include "queries/query_instance_list.h"
+
+/**
+ * @brief Writes a list of parsed queries to a compiled query file.
+ *
+ * @param list List of queries to be written. Cannot be constant, as internal sorting may occur.
+ * @param path Path to the file where to write the queries to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_file_compiler_examples).
+ */
+int query_file_compiler_save(query_instance_list_t *list, const char *path);
+
+/**
+ * @brief Parses a text query file and writes its queries to a compiled query file.
+ *
+ * @param query_file_path Path to the text query file to be parsed.
+ * @param path            Path to the file where to write the compiled queries to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int query_file_compiler_compile(const char *query_file_path, const char *path);
+
+/**
+ * @brief  Checks if a file is a compiled query file, and not a text one.
+ * @param  path Path to the file to be checked.
+ * @return Whether @p path can be read and starts like a compiled query file.
+ */
+int query_file_compiler_is_compiled(const char *path);
+
+/**
+ * @brief   Reads the queries in a compiled query file.
+ * @details The file is mapped while it's read, and isn't referred to by the returned list.
+ *
+ * @param path Path to the compiled query file.
+ *
+ * @return A pointer to a ::query_instance_list_t, that must later be `free`'d by
+ *         ::query_instance_list_free, or `NULL` if the file can't be read, is corrupt or was
+ *         compiled by another version of this program. `NULL` is also returned on allocation
+ *         failure.
+ */
+query_instance_list_t *query_file_compiler_load(const char *path);
+
+/**
+ * @brief   Reads the queries in a compiled query file, calling a callback for each query.
+ * @details Like ::query_file_parser_iter, queries aren't kept in memory after @p callback returns.
+ *
+ * @param path      Path to the compiled query file.
+ * @param callback  Method called for every query in the file, in the order they were saved.
+ * @param user_data Pointer passed to every call of @p callback, so that it can keep state.
+ *
+ * @return `0` on success, `1` on IO or allocation failure (or if the file is corrupt), or the value
+ *         returned by @p callback, in case it ordered reading to stop.
+ */
+int query_file_compiler_iter(const char                      *path,
+                             query_file_parser_iter_callback_t callback,
+                             void                             *user_data);
+
+/**
+ * @brief   Reads the queries in a query file, be it compiled or in text.
+ * @details Compiled query files are read with ::query_file_compiler_load, and text query files are
+ *          parsed with ::query_file_parser_parse_path.
+ *
+ * @param path Path to the query file.
+ *
+ * @return A pointer to a ::query_instance_list_t, that must later be `free`'d by
+ *         ::query_instance_list_free, or `NULL` on IO or allocation failure, or if a compiled
+ *         query file is corrupt.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_file_compiler_examples).
+ */
+query_instance_list_t *query_file_compiler_load_or_parse(const char *path);
+
+#endif
@@ -24,6 +24,9 @@
  * To parse a file with queries, open the file with `fopen` and pass it to
  * ::query_file_parser_parse. In the end, don't forget to close the file and to free the resulting
  * ::query_instance_list_t using ::query_instance_list_free. See batch_mode.c for a code example.
+ *
+ * When the file is too large for all of its queries to be kept in memory, use
+ * ::query_file_parser_iter instead, to handle each query as soon as it's parsed.
  */
 
 #ifndef QUERY_FILE_PARSER_H
@@ -47,4 +50,46 @@
  */
 query_instance_list_t *query_file_parser_parse(FILE *input);
 
+/**
+ * @brief   Parses a file containg a query in each line, splitting the work across multiple threads.
+ * @details The file is mapped to memory (see ::mapped_file_open) and split in chunks at line
+ *          boundaries, one per thread (see ::thread_count_get), that are parsed at the same time
+ *          into separate lists. Those are then merged without copies (see
+ *          ::query_instance_list_merge), with line numbers relative to the whole file. Small files
+ *          are parsed in a single thread. The resulting list is the same as the one
+ *          ::query_file_parser_parse would return for the same file.
+ *
+ * @param  path Path to the file to be parsed.
+ * @return A pointer to a ::query_instance_list_t, that must later be `free`'d by
+ *         ::query_instance_list_free, or `NULL` on IO / allocation failure.
+ */
+query_instance_list_t *query_file_parser_parse_path(const char *path);
+
+/**
+ * @brief Callback type for ::query_file_parser_iter, called for every query parsed successfully.
+ *
+ * @param user_data Pointer provided to ::query_file_parser_iter.
+ * @param instance  Parsed query. It's only valid until this callback returns, so it must be cloned
+ *                  (see ::query_instance_clone) to be kept.
+ *
+ * @return `0` to continue parsing, any other value to stop.
+ */
+typedef int (*query_file_parser_iter_callback_t)(void *user_data, const query_instance_t *instance);
+
+/**
+ * @brief   Parses a file containg a query in each line, calling a callback for each query.
+ * @details Unlike ::query_file_parser_parse, queries aren't kept in memory after @p callback
+ *          returns. Queries whose parsing fails are silently skipped.
+ *
+ * @param input     Input file stream to be read.
+ * @param callback  Method called for every query parsed successfully, in file order.
+ * @param user_data Pointer passed to every call of @p callback, so that it can keep state.
+ *
+ * @return `0` on success, `1` on allocation failure, or the value returned by @p callback, in case
+ *         it ordered parsing to stop.
+ */
+int query_file_parser_iter(FILE                             *input,
+                           query_file_parser_iter_callback_t callback,
+                           void                             *user_data);
+
 #endif
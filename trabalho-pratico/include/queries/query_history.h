@@ -0,0 +1,168 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    query_history.h
+ * @brief   Queries issued in interactive mode, and their cached results.
+ * @details The text of the most recent queries is kept, so that it can be suggested to the user
+ *          again. The output of queries is also kept in a least-recently-used cache with a memory
+ *          budget, so that an identical query (same type, formatting and arguments, no matter how
+ *          it was spaced or quoted) can be shown again without being run.
+ *
+ * @anchor query_history_examples
+ * ### Examples
+ *
+ * Before running a query, look up its output with ::query_history_lookup_result. After a query
+ * runs, store its output with ::query_history_add_result. Cached results are only valid for the
+ * database they were generated from, so they must be discarded with
+ * ::query_history_clear_results when another database is loaded.
+ *
+ * ```c
+ * size_t             nlines;
+ * const char *const *lines = query_history_lookup_result(history, query, query_str, &nlines);
+ * if (!lines) {
+ *     query_writer_t *writer = query_writer_create(NULL, query_instance_get_formatted(query));
+ *     query_dispatcher_dispatch_single(database, NULL, query, writer);
+ *
+ *     lines = query_writer_get_lines(writer, &nlines);
+ *     query_history_add_result(history, query, query_str, lines, nlines); // Lines are copied
+ *     ...
+ * }
+ * ```
+ *
+ * A history isn't thread-safe.
+ */
+
+#ifndef QUERY_HISTORY_H
+#define QUERY_HISTORY_H
+
+#include <stddef.h>
+
+#include "queries/query_instance.h"
+
+/** @brief Queries issued in interactive mode, and their cached results. */
+typedef struct query_history query_history_t;
+
+/** @brief Maximum number of queries whose text is kept in a ::query_history_t. */
+#define QUERY_HISTORY_MAX_QUERIES 64
+
+/**
+ * @brief Callback type for iterations over the queries in a history.
+ *
+ * @param user_data Argument passed to ::query_history_iter_queries.
+ * @param query_str Text of a query in the history.
+ *
+ * @return `0` to continue iterating, any other value to stop.
+ */
+typedef int (*query_history_iter_callback_t)(void *user_data, const char *query_str);
+
+/**
+ * @brief   Creates a new empty query history.
+ * @details The returned value must be `free`d with ::query_history_free.
+ *
+ * @param memory_budget Maximum number of bytes used by cached query results. Least recently used
+ *                      results are discarded to stay under this limit.
+ *
+ * @return The new history, or `NULL` on allocation failure.
+ */
+query_history_t *query_history_create(size_t memory_budget);
+
+/**
+ * @brief   Adds the text of a query to a history.
+ * @details If the same text is already in @p history, it's moved to the most recent position. The
+ *          oldest query is discarded once there are more than ::QUERY_HISTORY_MAX_QUERIES.
+ *
+ * @param history   History to be modified.
+ * @param query_str Text of the query (copied).
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int query_history_add_query(query_history_t *history, const char *query_str);
+
+/**
+ * @brief Iterates through the queries in a history that start with a prefix, from the most recent
+ *        to the oldest.
+ *
+ * @param history   History to iterate through.
+ * @param prefix    Prefix that the text of all iterated queries must start with.
+ * @param callback  Method to be called for every matching query.
+ * @param user_data Pointer to be passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback.
+ */
+int query_history_iter_queries(const query_history_t        *history,
+                               const char                   *prefix,
+                               query_history_iter_callback_t callback,
+                               void                         *user_data);
+
+/**
+ * @brief   Caches the output of a query.
+ * @details Outputs larger than the memory budget of @p history aren't cached.
+ *
+ * @param history   History to be modified.
+ * @param query     Parsed query.
+ * @param query_str Text @p query was parsed from.
+ * @param lines     Lines outputted by @p query (copied).
+ * @param n         Number of elements in @p lines.
+ *
+ * @retval 0 Success (even if the result wasn't cached for being too large).
+ * @retval 1 Allocation or tokenization failure.
+ */
+int query_history_add_result(query_history_t        *history,
+                             const query_instance_t *query,
+                             const char             *query_str,
+                             const char *const      *lines,
+                             size_t                  n);
+
+/**
+ * @brief   Looks up the cached output of a query.
+ * @details Marks the result as the most recently used one.
+ *
+ * @param history   History where to perform the lookup.
+ * @param query     Parsed query.
+ * @param query_str Text @p query was parsed from.
+ * @param n         Where to output the number of lines in the result to.
+ *
+ * @return The lines outputted by @p query, or `NULL` if they're not cached. These are valid until
+ *         @p history is modified.
+ */
+const char *const *query_history_lookup_result(query_history_t        *history,
+                                               const query_instance_t *query,
+                                               const char             *query_str,
+                                               size_t                 *n);
+
+/**
+ * @brief Discards all cached query results (but not the text of queries) in a history.
+ * @param history History to be modified.
+ */
+void query_history_clear_results(query_history_t *history);
+
+/**
+ * @brief  Gets the number of bytes of memory allocated by a query history.
+ * @param  history History to get the memory usage of.
+ * @return The number of bytes allocated by @p history, including cached results.
+ */
+size_t query_history_get_memory_usage(const query_history_t *history);
+
+/**
+ * @brief Frees memory used by a query history.
+ * @param history History to be `free`d.
+ */
+void query_history_free(query_history_t *history);
+
+#endif
@@ -26,20 +26,29 @@
  *
  * - ::query_instance_set_type;
  * - ::query_instance_set_formatted;
+ * - ::query_instance_set_approximate (0 by default);
  * - ::query_instance_set_line_in_file (use 1 if not a query in a file);
- * - ::query_instance_set_argument_data (using the ::query_type_parse_arguments_callback_t method
- *   for your query type).
+ * - ::query_instance_parse_arguments (using the ::query_type_parse_arguments_callback_t method for
+ *   your query type).
  *
  * To run the query you created, see ::query_dispatcher_dispatch_single. In the end, don't forget to
  * call ::query_instance_free.
+ *
+ * Query instances and their arguments can be allocated in pools (see ::query_instance_create and
+ * ::query_instance_parse_arguments), so that parsing large query files doesn't require many
+ * allocations.
  */
 
 #ifndef QUERY_INSTANCE_H
 #define QUERY_INSTANCE_H
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "utils/pool.h"
+#include "utils/string_pool.h"
+
 /* clang-format off */
 #ifndef query_instance_typedef
     /** @cond FALSE */
@@ -54,19 +63,33 @@
 #include "queries/query_type.h"
 
 /**
- * @brief  Creates a new query instance.
+ * @brief Creates a new query instance.
+ *
+ * @param allocator Pool where to allocate the query instance. Its element size must be the value
+ *                  returned by ::query_instance_sizeof. Can be `NULL`, so that malloc is used
+ *                  instead of a pool.
+ *
  * @return A pointer to a new ::query_instance_t, that should be `free`d with ::query_instance_free,
  *         or `NULL` on failure.
  */
-query_instance_t *query_instance_create(void);
+query_instance_t *query_instance_create(pool_t *allocator);
 
 /**
- * @brief  Creates a deep copy of a query instance.
- * @param  query Query to be copied.
+ * @brief Creates a deep copy of a query instance.
+ *
+ * @param allocator        Pool where to allocate the query instance. Its element size must be the
+ *                         value returned by ::query_instance_sizeof. Can be `NULL`, so that malloc
+ *                         is used instead of a pool.
+ * @param string_allocator Pool where to allocate the strings in the query's arguments. Can be
+ *                         `NULL`, so that `strdup` is used instead of a pool.
+ * @param query            Query to be copied.
+ *
  * @return A pointer to a copy of @p query, that must be `free`d with ::query_instance_free, `NULL`
- *         on allocation failure / or invalid query type.
+ *         on allocation failure.
  */
-query_instance_t *query_instance_clone(const query_instance_t *query);
+query_instance_t *query_instance_clone(pool_t                 *allocator,
+                                       string_pool_t          *string_allocator,
+                                       const query_instance_t *query);
 
 /**
  * @brief Sets the type of a query instance.
@@ -82,6 +105,18 @@ void query_instance_set_type(query_instance_t *query, const query_type_t *type);
  */
 void query_instance_set_formatted(query_instance_t *query, int formatted);
 
+/**
+ * @brief   Sets whether or not a query's output can be approximate.
+ * @details Approximate queries (an `A` after the query number, like `F` for formatting) may be
+ *          answered from statistical data that trades exactness for speed or memory, in which case
+ *          error bounds are reported in their output. Query types without an approximate mode
+ *          answer them exactly. By default, queries are exact.
+ *
+ * @param query       Query instance to have its approximation flag set.
+ * @param approximate Whether or not the query's output can be approximate.
+ */
+void query_instance_set_approximate(query_instance_t *query, int approximate);
+
 /**
  * @brief Sets the number of the line a query instance was on.
  * @param query        Query instance to have its line number in the file set.
@@ -90,17 +125,67 @@ void query_instance_set_formatted(query_instance_t *query, int formatted);
  */
 void query_instance_set_line_in_file(query_instance_t *query, size_t line_in_file);
 
+/** @brief Value of ::query_instance_get_limit for queries whose output isn't limited. */
+#define QUERY_INSTANCE_NO_LIMIT SIZE_MAX
+
 /**
- * @brief   Adds parsed arguments to a query. Its data type will depend on the query's type.
- * @details For any query instance, ::query_instance_set_type must be called before this setter.
+ * @brief   Sets which objects of a query's output are to be outputted (a page of results).
+ * @details By default, a query has an offset of `0` and no limit (::QUERY_INSTANCE_NO_LIMIT).
  *
- * @param query           Query instance to have its arguments set.
- * @param argument_data   Data resulting from parsing the query's arguments.
+ * @param query  Query instance to have its page set.
+ * @param offset Number of objects at the beginning of the query's output to be left out.
+ * @param limit  Maximum number of objects to be outputted, after the first @p offset.
+ */
+void query_instance_set_page(query_instance_t *query, size_t offset, size_t limit);
+
+/**
+ * @brief   Parses the arguments of a query, storing them in the query instance.
+ * @details For any query instance, ::query_instance_set_type must be called before this method.
+ *          Arguments are parsed with the type's ::query_type_parse_arguments_callback_t, and their
+ *          data type will depend on the query's type.
+ *
+ * @param allocator Pool where to allocate strings in the arguments. Can be `NULL`, so that
+ *                  `strdup` is used instead of a pool.
+ * @param query     Query instance to have its arguments set.
+ * @param argc      Number of query arguments.
+ * @param argv      Arguments of the query (see ::query_type_parse_arguments_callback_t).
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure, allocation failure or query type not set.
+ */
+int query_instance_parse_arguments(string_pool_t    *allocator,
+                                   query_instance_t *query,
+                                   size_t            argc,
+                                   char *const       argv[argc]);
+
+/**
+ * @brief   Sets the arguments of a query to ones read from a
+ *          [compiled query file](@ref query_file_compiler.h), without parsing them again.
+ * @details For any query instance, ::query_instance_set_type must be called before this method.
+ *          Data referred to by the arguments is read with the type's
+ *          ::query_type_load_arguments_callback_t.
+ *
+ * @param allocator      Pool where to allocate strings in the arguments. Can be `NULL`, so that
+ *                       `strdup` is used instead of a pool.
+ * @param query          Query instance to have its arguments set.
+ * @param args_data      ::QUERY_TYPE_ARGUMENTS_MAX_SIZE bytes of saved arguments (see
+ *                       ::query_instance_get_argument_data).
+ * @param arguments      Unparsed arguments of the saved query (see
+ *                       ::query_instance_get_arguments).
+ * @param arguments_size Number of bytes in @p arguments.
+ * @param contents       Data written by the type's ::query_type_save_arguments_callback_t.
+ * @param size           Number of bytes in @p contents.
  *
  * @retval 0 Success.
- * @retval 1 Allocation failure or query type not set.
+ * @retval 1 Corrupt @p contents, allocation failure or query type not set.
  */
-int query_instance_set_argument_data(query_instance_t *query, const void *argument_data);
+int query_instance_load_arguments(string_pool_t    *allocator,
+                                  query_instance_t *query,
+                                  const void       *args_data,
+                                  const char       *arguments,
+                                  size_t            arguments_size,
+                                  const char       *contents,
+                                  size_t            size);
 
 /**
  * @brief  Gets the type of a query instance.
@@ -116,6 +201,25 @@ const query_type_t *query_instance_get_type(const query_instance_t *query);
  */
 int query_instance_get_formatted(const query_instance_t *query);
 
+/**
+ * @brief  Gets whether or not a query's output can be approximate.
+ * @param  query Query instance to get the approximation flag from.
+ * @return Whether or not @p query 's output can be approximate.
+ */
+int query_instance_get_approximate(const query_instance_t *query);
+
+/**
+ * @brief   Checks if all queries in a set can have approximate outputs.
+ * @details Statistical data is shared by all queries of the same type, so it can only be
+ *          approximate when this is true for the queries it's generated for.
+ *
+ * @param n         Number of elements in @p instances.
+ * @param instances Queries to be checked.
+ *
+ * @return `1` if @p n isn't `0` and every query in @p instances is approximate, `0` otherwise.
+ */
+int query_instance_are_all_approximate(size_t n, const query_instance_t *const instances[n]);
+
 /**
  * @brief  Gets the number of the line a query instance was on.
  * @param  query Query instance to get the line number from.
@@ -123,6 +227,21 @@ int query_instance_get_formatted(const query_instance_t *query);
  */
 size_t query_instance_get_line_in_file(const query_instance_t *query);
 
+/**
+ * @brief  Gets the number of objects at the beginning of a query's output to be left out.
+ * @param  query Query instance to get the offset from.
+ * @return The offset of @p query 's page (see ::query_instance_set_page).
+ */
+size_t query_instance_get_offset(const query_instance_t *query);
+
+/**
+ * @brief  Gets the maximum number of objects to be outputted by a query.
+ * @param  query Query instance to get the limit from.
+ * @return The limit of @p query 's page (see ::query_instance_set_page), or
+ *         ::QUERY_INSTANCE_NO_LIMIT.
+ */
+size_t query_instance_get_limit(const query_instance_t *query);
+
 /**
  * @brief  Gets a query instance's parsed arguments.
  * @param  query Query instance to get parsed arguments from.
@@ -131,6 +250,50 @@ size_t query_instance_get_line_in_file(const query_instance_t *query);
  */
 const void *query_instance_get_argument_data(const query_instance_t *query);
 
+/**
+ * @brief   Gets a hash of the arguments of a query instance, before they were parsed.
+ * @details Instances whose arguments were never parsed have a hash of `0`.
+ *
+ * @param query Query instance to get the hash of the arguments from.
+ *
+ * @return A 64-bit hash of the arguments (strings) ::query_instance_parse_arguments was called
+ *         with.
+ */
+uint64_t query_instance_get_arguments_hash(const query_instance_t *query);
+
+/**
+ * @brief   Gets the arguments of a query instance, before they were parsed.
+ * @details Instances whose arguments were never parsed have no arguments.
+ *
+ * @param query Query instance to get the arguments from.
+ * @param size  Where to write the number of bytes in the returned arguments to.
+ *
+ * @return The arguments (strings) ::query_instance_parse_arguments was called with, each followed
+ *         by its null terminator, or `NULL` if there are none.
+ */
+const char *query_instance_get_arguments(const query_instance_t *query, size_t *size);
+
+/**
+ * @brief   Checks if two query instances are repetitions of the same query.
+ * @details Instances are the same query if they have the same type, the same formatting flag, the
+ *          same page, and the same arguments (see ::query_instance_get_arguments). Their outputs
+ *          will then be equal.
+ *
+ * @param a First query instance.
+ * @param b Second query instance.
+ *
+ * @retval 0 @p a and @p b are different queries.
+ * @retval 1 @p a and @p b are the same query.
+ */
+int query_instance_is_same_query(const query_instance_t *a, const query_instance_t *b);
+
+/**
+ * @brief   Gets the size of a ::query_instance_t in memory.
+ * @details Useful for pool allocation.
+ * @return  `sizeof(query_instance_t)`.
+ */
+size_t query_instance_sizeof(void);
+
 /**
  * @brief Frees memory used by a query instance.
  * @param query Query instance to be `free`d.
@@ -36,11 +36,15 @@
  * }
  * ```
  *
- * - Add query instances to it, using ::query_instance_list_add.
+ * - Add query instances to it, using ::query_instance_list_add. To avoid copies (e.g.: when parsing
+ *   a file), instances can also be created directly in the list, with
+ *   ::query_instance_list_add_empty.
  * - When done using the list, free it with ::query_instance_list_free.
  *
- * There are two types of list iterations. Before any of these iterations, the list will be sorted
- * by query type order.
+ * There are two types of list iterations. In both, queries are grouped by query type (in order of
+ * type number), and queries of the same type are ordered by line in the file. Each query is placed
+ * in its type's group as soon as it's added, so no sorting is needed before iterating, unless
+ * queries are added out of order.
  *
  * - Query by query iteration using ::query_instance_list_iter. An example of this can be found in
  *   batch_mode.c, to open all files to write query outputs in.
@@ -57,7 +61,7 @@
  *   5 | 3  Erin
  *   ```
  *
- *   This will be sorted, becoming:
+ *   This will be grouped, becoming:
  *
  *   ```text
  *   1 | 1  Alice
@@ -68,7 +72,10 @@
  *   ```
  *
  *   Then, three callbacks will be performed: one for Alice and Carol, another one for Bob and Dan,
- *   and finally, one for Erin.
+ *   and finally, one for Erin. The instances passed to each callback are contiguous in memory, and
+ *   remain valid until the list is modified or freed. Each query type also has its own pool of
+ *   instances, so that the instances themselves (and the arguments inside them) are stored next
+ *   to each other, usually in the same order they're passed to the callback.
  */
 
 #ifndef QUERY_INSTANCE_LIST_H
@@ -76,7 +83,7 @@
 
 #include "queries/query_instance.h"
 
-/** @brief A list of ::query_instance_t, sorted by query type. */
+/** @brief A list of ::query_instance_t, grouped by query type. */
 typedef struct query_instance_list query_instance_list_t;
 
 /**
@@ -135,6 +142,51 @@ query_instance_list_t *query_instance_list_clone(const query_instance_list_t *li
  */
 int query_instance_list_add(query_instance_list_t *list, const query_instance_t *query);
 
+/**
+ * @brief   Creates a new query instance at the end of a list, to be filled in by the caller.
+ * @details Unlike ::query_instance_list_add, no copy is made: the instance is allocated in a pool
+ *          owned by @p list, and strings in its arguments must be allocated in the string pool
+ *          placed in @p string_allocator (e.g.: by ::query_parser_parse_string). If the instance
+ *          can't be filled in, remove it with ::query_instance_list_remove_last.
+ *
+ * @param list             List of query instances to add an instance to.
+ * @param string_allocator Where to output the string pool for strings in the instance's arguments.
+ *
+ * @return The new query instance, owned by @p list, or `NULL` on allocation failure.
+ */
+query_instance_t *query_instance_list_add_empty(query_instance_list_t *list,
+                                                string_pool_t        **string_allocator);
+
+/**
+ * @brief   Removes the last query instance from a list.
+ * @details Meant to be called right after ::query_instance_list_add_empty, if the new instance
+ *          couldn't be filled in. Its memory is only reclaimed when @p list is freed.
+ *
+ * @param list List of query instances to be modified. Mustn't be empty.
+ */
+void query_instance_list_remove_last(query_instance_list_t *list);
+
+/**
+ * @brief   Moves all query instances from a list to the end of another one.
+ * @details No instance is copied: @p list takes ownership of @p other, whose memory is only freed
+ *          alongside @p list. This is meant for joining lists filled in separately (e.g.: by
+ *          different threads, each parsing part of a file), so that they're iterated through as a
+ *          single one.
+ *
+ * @param list        List of query instances to add the instances of @p other to.
+ * @param other       List whose instances are moved to @p list. It mustn't be used after this
+ *                    call, and it's freed on failure.
+ * @param line_offset Number to add to the line in the file (see ::query_instance_get_line_in_file)
+ *                    of every instance of @p other (e.g.: the number of lines before the part of
+ *                    the file parsed into @p other).
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p list is left unchanged).
+ */
+int query_instance_list_merge(query_instance_list_t *list,
+                              query_instance_list_t *other,
+                              size_t                 line_offset);
+
 /**
  * @brief Iterates over every set of queries of each type in a query instance list.
  *
@@ -143,7 +195,7 @@ int query_instance_list_add(query_instance_list_t *list, const query_instance_t
  * @param user_data Value passed to @p callback, so that it can modify the program's state.
  *
  * @return The last value returned by @p callback (will always be `0` on success, meaning iteration
- *         reached the end).
+ *         reached the end), or `1` on allocation failure.
  *
  * #### Examples
  * See [the header file's documentation](@ref query_instance_list_examples).
@@ -160,7 +212,7 @@ int query_instance_list_iter_types(query_instance_list_t                  *list,
  * @param user_data Value passed to @p callback, so that it can modify the program's state.
  *
  * @return The last value returned by @p callback (will always be `0` on success, meaning iteration
- *         reached the end).
+ *         reached the end), or `1` on allocation failure.
  *
  * #### Examples
  * See [the header file's documentation](@ref query_instance_list_examples).
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    query_output_cache.h
+ * @brief   Outputs of popular queries, kept in memory and shared between threads.
+ * @details Unlike a [result cache](@ref query_result_cache.h), that keeps every output in files
+ *          between runs, this cache is meant for a long-running server, whose traffic is skewed
+ *          towards a few popular queries (e.g.: lookups of the same users and hotels). Repeated
+ *          queries are answered without touching the database.
+ *
+ *          The cache is split into shards, each with its own lock, so that threads looking up
+ *          different queries rarely contend. Each shard keeps its outputs in least-recently-used
+ *          order, within a byte budget. New outputs are only admitted if their query has been
+ *          looked up more often, recently, than the output they'd evict (TinyLFU). Lookup
+ *          frequencies are estimated in a small count-min sketch, that is periodically halved, so
+ *          that one-off queries don't flush popular ones out of the cache.
+ *
+ *          Outputs are identified by everything that makes two queries have the same output (see
+ *          ::query_instance_is_same_query), and by the database they were generated from. When a
+ *          database is modified (e.g.: by ::database_invalidate_flight) or replaced, the cache must
+ *          be invalidated with ::query_output_cache_invalidate. A query executed while that happens
+ *          may be outdated, so outputs are only added if the cache wasn't invalidated since their
+ *          query started (see ::query_output_cache_get_generation).
+ *
+ * @anchor query_output_cache_examples
+ * ### Examples
+ *
+ * ```c
+ * query_output_cache_t *cache = query_output_cache_create(64 << 20); // 64 MiB
+ * if (!cache)
+ *     return 1;
+ *
+ * // In any thread, before reading the database to be queried
+ * const unsigned int generation = query_output_cache_get_generation(cache);
+ *
+ * GString *output = g_string_new("");
+ * size_t   nlines;
+ * if (query_output_cache_get(cache, database, query, output, &nlines)) {
+ *     // Cache miss: execute the query, writing its lines to output, each ending in '\n'
+ *     query_output_cache_put(cache, generation, database, query, output->str, output->len, nlines);
+ * }
+ *
+ * // After modifying the database
+ * query_output_cache_invalidate(cache);
+ *
+ * query_output_cache_free(cache);
+ * ```
+ */
+
+#ifndef QUERY_OUTPUT_CACHE_H
+#define QUERY_OUTPUT_CACHE_H
+
+#include <glib.h>
+#include <stddef.h>
+
+#include "database/database.h"
+#include "queries/query_instance.h"
+
+/** @brief Outputs of popular queries, kept in memory. */
+typedef struct query_output_cache query_output_cache_t;
+
+/**
+ * @brief   Creates a new empty cache of query outputs.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::query_output_cache_free.
+ *
+ * @param capacity Maximum number of bytes used by cached outputs (and their bookkeeping).
+ *
+ * @return The new cache, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_cache_examples).
+ */
+query_output_cache_t *query_output_cache_create(size_t capacity);
+
+/**
+ * @brief   Gets the current generation of a cache, before executing a query.
+ * @details The generation changes whenever the cache is invalidated. It must be read before the
+ *          query starts (and before the database being queried is read), and passed to
+ *          ::query_output_cache_put.
+ *
+ * @param cache Cache to get the generation from.
+ *
+ * @return The current generation of @p cache.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_cache_examples).
+ */
+unsigned int query_output_cache_get_generation(query_output_cache_t *cache);
+
+/**
+ * @brief   Looks up the cached output of a query.
+ * @details The lookup is counted towards the popularity of @p query, whether it's found or not.
+ *          Can be called from any thread.
+ *
+ * @param cache    Cache where to look the output up.
+ * @param database Database @p query is executed on.
+ * @param query    Query whose output is wanted.
+ * @param output   Where to append the output to, on a hit. Every line ends in `'\n'`.
+ * @param nlines   Where to write the number of lines in the output to, on a hit.
+ *
+ * @retval 0 Success (cache hit).
+ * @retval 1 The output isn't cached, and must be generated.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_cache_examples).
+ */
+int query_output_cache_get(query_output_cache_t   *cache,
+                           const database_t       *database,
+                           const query_instance_t *query,
+                           GString                *output,
+                           size_t                 *nlines);
+
+/**
+ * @brief   Offers the output of a query to a cache.
+ * @details The output is copied, and is only kept if the cache wasn't invalidated since
+ *          @p generation, and if @p query is more popular than the outputs it would evict. Outputs
+ *          too large for a fraction of the cache are never kept. Can be called from any thread.
+ *
+ * @param cache      Cache to add the output to.
+ * @param generation Value of ::query_output_cache_get_generation before @p query was executed.
+ * @param database   Database @p query was executed on.
+ * @param query      Query that was executed successfully. Queries whose arguments weren't parsed
+ *                   are ignored, as their outputs can't be told apart.
+ * @param output     Output of @p query, with every line ending in `'\n'`.
+ * @param length     Number of bytes in @p output.
+ * @param nlines     Number of lines in @p output.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_cache_examples).
+ */
+void query_output_cache_put(query_output_cache_t   *cache,
+                            unsigned int            generation,
+                            const database_t       *database,
+                            const query_instance_t *query,
+                            const char             *output,
+                            size_t                  length,
+                            size_t                  nlines);
+
+/**
+ * @brief   Removes all outputs from a cache, after the database changes.
+ * @details Lookup frequencies are kept, as a changed database doesn't change which queries are
+ *          popular. Outputs of queries that started before this call won't be added to the cache.
+ *
+ * @param cache Cache to be invalidated.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_cache_examples).
+ */
+void query_output_cache_invalidate(query_output_cache_t *cache);
+
+/**
+ * @brief  Gets the number of bytes used by the outputs in a cache (and their bookkeeping).
+ * @param  cache Cache to get the memory usage from.
+ * @return The memory usage of @p cache, that never exceeds its capacity.
+ */
+size_t query_output_cache_get_memory_usage(query_output_cache_t *cache);
+
+/**
+ * @brief Frees memory used by a cache, and all outputs in it.
+ * @param cache Cache to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_cache_examples).
+ */
+void query_output_cache_free(query_output_cache_t *cache);
+
+#endif
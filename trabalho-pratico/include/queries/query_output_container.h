@@ -0,0 +1,200 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    query_output_container.h
+ * @brief   A single file containing the outputs of many queries.
+ * @details Writing the output of every query to its own file makes the file system the bottleneck
+ *          for large query files (an inode is created for every query). A container keeps all
+ *          outputs in a single file instead: payloads are concatenated in the order they're
+ *          finished, followed by a table mapping the identifier of each query (its line in the
+ *          query file) to the position of its payload.
+ *
+ *          The file has the following layout (all integers are 64-bit and in the machine's byte
+ *          order, so containers aren't portable between architectures):
+ *
+ *          - A header, containing ::QUERY_OUTPUT_CONTAINER_MAGIC, the number of entries and the
+ *            offset of the table in the file;
+ *          - All payloads, concatenated (in no particular order);
+ *          - The table: an `(identifier, offset, length)` triplet for each entry, sorted by
+ *            identifier.
+ *
+ *          The header is only written when the container is closed, so an unfinished container is
+ *          never mistaken for a valid one.
+ *
+ * @anchor query_output_container_examples
+ * ### Examples
+ *
+ * Containers are usually written to through a [query writer](@ref query_writer.h) (see
+ * ::query_writer_create_in_container). The following example prints every entry in a container:
+ *
+ * ```c
+ * query_output_container_reader_t *reader = query_output_container_reader_open("outputs.bin");
+ * if (!reader)
+ *     return 1;
+ *
+ * for (size_t i = 0; i < query_output_container_reader_get_count(reader); ++i) {
+ *     uint64_t    id;
+ *     const char *payload;
+ *     size_t      length;
+ *     query_output_container_reader_get_entry(reader, i, &id, &payload, &length);
+ *
+ *     printf("Query %" PRIu64 ":\n%.*s\n", id, (int) length, payload);
+ * }
+ *
+ * query_output_container_reader_close(reader);
+ * ```
+ */
+
+#ifndef QUERY_OUTPUT_CONTAINER_H
+#define QUERY_OUTPUT_CONTAINER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Sequence of bytes at the beginning of every container file. */
+#define QUERY_OUTPUT_CONTAINER_MAGIC "LI3QOUT1"
+
+/** @brief A container file being written to. */
+typedef struct query_output_container query_output_container_t;
+
+/**
+ * @brief Creates a new container file, replacing any existing file.
+ *
+ * @param path Path to the container file.
+ *
+ * @return A pointer to a ::query_output_container_t that must be deleted with
+ *         ::query_output_container_free, or `NULL` on IO / allocation failure.
+ */
+query_output_container_t *query_output_container_create(const char *path);
+
+/**
+ * @brief   Writes the output of a query to a container.
+ * @details Can be called from many threads at once.
+ *
+ * @param container  Container to write to.
+ * @param id         Identifier of the query (its line in the query file).
+ * @param payload    Output of the query (doesn't need to be null-terminated).
+ * @param length     Number of characters in @p payload.
+ * @param out_offset Where to write the position of @p payload in the container to, so that it can
+ *                   be shared with ::query_output_container_add_link. Can be `NULL`.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int query_output_container_add(query_output_container_t *container,
+                               uint64_t                  id,
+                               const char               *payload,
+                               size_t                    length,
+                               uint64_t                 *out_offset);
+
+/**
+ * @brief   Adds an entry to a container whose output is the same as the one of an existing entry.
+ * @details Can be called from many threads at once. No payload is written, so repeated queries
+ *          don't make the container grow.
+ *
+ * @param container Container to write to.
+ * @param id        Identifier of the query (its line in the query file).
+ * @param offset    Position of the payload, as outputted by ::query_output_container_add.
+ * @param length    Number of characters in the payload.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int query_output_container_add_link(query_output_container_t *container,
+                                    uint64_t                  id,
+                                    uint64_t                  offset,
+                                    size_t                    length);
+
+/**
+ * @brief   Finishes writing a container, by writing its table and its header.
+ * @details Nothing else can be added to @p container after it's closed. This does nothing if
+ *          @p container was already closed.
+ *
+ * @param container Container to be closed.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure (now or while adding an entry).
+ */
+int query_output_container_close(query_output_container_t *container);
+
+/**
+ * @brief   Frees memory allocated by ::query_output_container_create.
+ * @details If @p container hasn't been closed yet, ::query_output_container_close is called first
+ *          (ignoring errors).
+ *
+ * @param container Value returned by ::query_output_container_create.
+ */
+void query_output_container_free(query_output_container_t *container);
+
+/** @brief A container file being read from. */
+typedef struct query_output_container_reader query_output_container_reader_t;
+
+/**
+ * @brief Opens a container file for reading.
+ *
+ * @param path Path to the container file.
+ *
+ * @return A pointer to a ::query_output_container_reader_t that must be deleted with
+ *         ::query_output_container_reader_close, or `NULL` on IO / allocation failure, or if the
+ *         file isn't a valid container.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_container_examples).
+ */
+query_output_container_reader_t *query_output_container_reader_open(const char *path);
+
+/**
+ * @brief  Gets the number of entries in a container.
+ * @param  reader Container to get the number of entries from.
+ * @return The number of entries in @p reader.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_container_examples).
+ */
+size_t query_output_container_reader_get_count(const query_output_container_reader_t *reader);
+
+/**
+ * @brief Gets an entry in a container. Entries are sorted by identifier.
+ *
+ * @param reader      Container to get the entry from.
+ * @param i           Index of the entry. Must be lower than the value of
+ *                    ::query_output_container_reader_get_count.
+ * @param out_id      Where to write the identifier of the query to.
+ * @param out_payload Where to write a pointer to the query's output to (not null-terminated),
+ *                    valid until ::query_output_container_reader_close is called.
+ * @param out_length  Where to write the number of characters in the query's output to.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_container_examples).
+ */
+void query_output_container_reader_get_entry(const query_output_container_reader_t *reader,
+                                             size_t                                 i,
+                                             uint64_t                              *out_id,
+                                             const char                           **out_payload,
+                                             size_t                                *out_length);
+
+/**
+ * @brief Frees memory allocated by ::query_output_container_reader_open.
+ * @param reader Value returned by ::query_output_container_reader_open.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref query_output_container_examples).
+ */
+void query_output_container_reader_close(query_output_container_reader_t *reader);
+
+#endif
@@ -33,12 +33,10 @@
  *                               "3  \"unknown query\" \"number\"",
  *                               "3F \"unknown formatted\" \"query\""};
  *
- *     GPtrArray *aux = g_ptr_array_new();
- *
  *     for (size_t i = 0; i < 4; ++i) {
- *         query_instance_t *query = query_instance_create();
+ *         query_instance_t *query = query_instance_create(NULL);
  *
- *         int result = query_parser_parse_string_const(query, queries[i], aux);
+ *         int result = query_parser_parse_string_const(NULL, query, queries[i]);
  *         if (result)
  *             fprintf(stderr, "Failed to parse query: %s\n", queries[i]);
  *         else if (query_instance_get_formatted(query))
@@ -50,7 +48,6 @@
  *     }
  *
  *     query_type_list_free(query_list);
- *     g_ptr_array_unref(aux);
  *     return 0;
  * }
  * ```
@@ -71,10 +68,15 @@
  * Like in query_tokenizer.h, you can have arguments inside or outside of quotes, and multiple
  * consecutive spaces are allowed both in quotes (kept) or outside quotes (discarded).
  *
- * It should be noted that, because we're parsing multiple queries, we used an external `GPtrArray`
- * that we provided to ::query_parser_parse_string_const. This way, we avoid many allocations. For
- * parsing a single query, you can pass `NULL` to the mentioned method's `aux` paramater, and it'll
- * automatically allocate and de-allocate a new array.
+ * A query may end in `LIMIT n`, `OFFSET m` or `LIMIT n OFFSET m`, so that only a page of its
+ * results is outputted: the first `m` objects are left out, and at most `n` objects are outputted
+ * after those (see ::query_instance_set_page). These clauses aren't passed to the query's
+ * ::query_type_parse_arguments_callback_t. Keywords must be in uppercase and outside of quotes, so
+ * `2 "LIMIT" "10"` is still a query with two arguments.
+ *
+ * Parsing is done in a single pass over the query, without any memory allocations (other than the
+ * ones done by the ::query_type_parse_arguments_callback_t). A string pool can be provided as the
+ * `allocator` of strings in query arguments, instead of `NULL` (`strdup`).
  */
 
 #ifndef QUERY_PARSER_H
@@ -85,20 +87,21 @@
 /**
  * @brief Parses a **MODIFIABLE** string containing a query.
  *
- * @param output Where the parsed query is placed. This **will be modified on failure** too.
- * @param input  String to parse, that will be modified during parsing, but then restored to its
- *               original form, assuming none of the ::query_type_parse_arguments_callback_t
- *               modifies its argument tokens.
- * @param aux    Auxiliary `GPtrArray`, that can be provided to be modified and avoid memory
- *               allocations. If `NULL`, a new array will be instantiated.
+ * @param allocator Where to allocate strings in the query's arguments. Can be `NULL`, so that
+ *                  `strdup` is used instead of a pool.
+ * @param output    Where the parsed query is placed. This **will be modified on failure** too.
+ * @param input     String to parse, that will be modified during parsing, but then restored to its
+ *                  original form, assuming none of the ::query_type_parse_arguments_callback_t
+ *                  modifies its argument tokens.
  *
  * @retval 0 Parsing success.
- * @retval 1 Parsing failure.
+ * @retval 1 Parsing failure (including queries with too many arguments, and page clauses with
+ *           invalid numbers).
  *
  * ### Examples
  * See [the header file's documentation](@ref query_parser_examples).
  */
-int query_parser_parse_string(query_instance_t *output, char *input, GPtrArray *aux);
+int query_parser_parse_string(string_pool_t *allocator, query_instance_t *output, char *input);
 
 /** @brief Value returned by ::query_parser_parse_string_const when `malloc` fails. */
 #define QUERY_PARSER_PARSE_CONST_RET_FAILED_MALLOC -1
@@ -108,10 +111,10 @@ int query_parser_parse_string(query_instance_t *output, char *input, GPtrArray *
  * @details The current implementation copies the provided string to a temporary buffer. Keep that
  *          in mind for performance reasons.
  *
- * @param output Where the parsed query is placed. This **will be modified on failure** too.
- * @param input  String to parse.
- * @param aux    Auxiliary `GPtrArray`, that can be provided to be modified and avoid memory
- *               memory allocations. If `NULL`, a new array will be instantiated.
+ * @param allocator Where to allocate strings in the query's arguments. Can be `NULL`, so that
+ *                  `strdup` is used instead of a pool.
+ * @param output    Where the parsed query is placed. This **will be modified on failure** too.
+ * @param input     String to parse.
  *
  * @retval 0                                          Parsing success.
  * @retval 1                                          Parsing failure.
@@ -120,6 +123,8 @@ int query_parser_parse_string(query_instance_t *output, char *input, GPtrArray *
  * ### Examples
  * See [the header file's documentation](@ref query_parser_examples).
  */
-int query_parser_parse_string_const(query_instance_t *output, const char *input, GPtrArray *aux);
+int query_parser_parse_string_const(string_pool_t    *allocator,
+                                    query_instance_t *output,
+                                    const char       *input);
 
 #endif
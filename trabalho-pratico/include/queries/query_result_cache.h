@@ -0,0 +1,116 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    query_result_cache.h
+ * @brief   Query outputs kept in files, between runs of the program on the same dataset.
+ * @details Many query files are run again and again against an unchanged dataset, with mostly the
+ *          same queries. The output of every query is copied to a directory after it's executed,
+ *          and copied back (or reflinked, when the file system supports it) when the same query is
+ *          found on a later run, instead of executing it again.
+ *
+ *          Outputs are identified by the dataset's `fingerprint` (see
+ *          ::dataset_input_get_fingerprint), like [database snapshots](@ref database_snapshot.h),
+ *          and by everything that makes two queries have the same output (see
+ *          ::query_instance_is_same_query), so that outdated outputs are never used. The arguments
+ *          of every query are kept next to its output and compared when it's looked up, as file
+ *          names only contain a hash of them. Outputs of other datasets (or other versions of the
+ *          program) are never removed from the directory, and can be deleted at any time.
+ *
+ * @anchor query_result_cache_examples
+ * ### Examples
+ *
+ * ```c
+ * query_result_cache_t *cache = query_result_cache_create("cache/.query_results", fingerprint);
+ * if (!cache)
+ *     return 1;
+ *
+ * if (query_result_cache_get(cache, query, 0, "Resultados/command1_output.txt")) {
+ *     // Cache miss: execute the query, writing its output to "Resultados/command1_output.txt"
+ *     query_result_cache_put(cache, query, 0, "Resultados/command1_output.txt");
+ * }
+ *
+ * query_result_cache_free(cache);
+ * ```
+ */
+
+#ifndef QUERY_RESULT_CACHE_H
+#define QUERY_RESULT_CACHE_H
+
+#include <stdint.h>
+
+#include "queries/query_instance.h"
+
+/** @brief Query outputs kept in a directory. */
+typedef struct query_result_cache query_result_cache_t;
+
+/**
+ * @brief Creates a handle to a directory of query outputs.
+ *
+ * @param directory   Path to the directory where outputs are kept. Created if it doesn't exist.
+ * @param fingerprint Identifier of the dataset queries are executed on.
+ *
+ * @return A new ::query_result_cache_t, that must be freed with ::query_result_cache_free, or
+ *         `NULL` on allocation failure, or if @p directory can't be created.
+ */
+query_result_cache_t *query_result_cache_create(const char *directory, uint64_t fingerprint);
+
+/**
+ * @brief Copies the cached output of a query to a file.
+ *
+ * @param cache       Cache where to look the output up.
+ * @param query       Query whose output is wanted.
+ * @param binary      Whether the output must be in [binary](@ref query_writer_binary_format).
+ * @param output_path Where to copy the output to. Replaced if it already exists.
+ *
+ * @retval 0 Success (cache hit).
+ * @retval 1 The output isn't cached, or IO failure. @p output_path may have been left incomplete,
+ *           and the query must be executed.
+ */
+int query_result_cache_get(const query_result_cache_t *cache,
+                           const query_instance_t     *query,
+                           int                         binary,
+                           const char                 *output_path);
+
+/**
+ * @brief   Adds the output of a query to a cache.
+ * @details Outputs are copied to a temporary directory first (unique to each call), so that a
+ *          failure never leaves an incomplete output behind, and threads or processes adding the
+ *          same output at once don't interfere with each other. Outputs already in the cache (or
+ *          of another query whose arguments have the same hash) are never replaced.
+ *
+ * @param cache       Cache to add the output to.
+ * @param query       Query that was executed.
+ * @param binary      Whether the output is in [binary](@ref query_writer_binary_format).
+ * @param output_path File the complete output of @p query was written to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure, @p query's arguments weren't parsed (outputs can't be told apart), or
+ *           there's already an output in the cache for @p query's hash.
+ */
+int query_result_cache_put(const query_result_cache_t *cache,
+                           const query_instance_t     *query,
+                           int                         binary,
+                           const char                 *output_path);
+
+/**
+ * @brief Frees a handle to a directory of query outputs (the files in it are kept).
+ * @param cache Cache to be freed.
+ */
+void query_result_cache_free(query_result_cache_t *cache);
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    query_statistics_cache.h
+ * @brief   Statistical data kept between dispatches of queries on the same database.
+ * @details Only query types whose statistical data doesn't depend on query arguments (see
+ *          ::query_type_has_reusable_statistics) can have their data cached. This is especially
+ *          useful in interactive mode, where queries are dispatched one at a time.
+ *
+ * @anchor query_statistics_cache_examples
+ * ### Examples
+ *
+ * Create a cache with ::query_statistics_cache_create and give it to
+ * ::query_dispatcher_dispatch_single or ::query_dispatcher_dispatch_list. The data in a cache
+ * is only valid for the database it was generated from, so the cache must be emptied with
+ * ::query_statistics_cache_clear when another database is loaded. When the cache is no longer
+ * needed, free it with ::query_statistics_cache_free.
+ *
+ * ```c
+ * query_statistics_cache_t *cache = query_statistics_cache_create();
+ * if (!cache)
+ *     return 1;
+ *
+ * query_dispatcher_dispatch_single(database, cache, query_a, output_a);
+ * query_dispatcher_dispatch_single(database, cache, query_b, output_b); // Reuses statistics
+ *
+ * query_statistics_cache_free(cache);
+ * ```
+ *
+ * A cache can also be backed by a [store](@ref query_statistics_store.h) (see
+ * ::query_statistics_cache_set_store), for statistical data to be kept across runs of the program.
+ *
+ * A cache isn't thread-safe. However, the dispatcher only accesses it from the calling thread.
+ */
+
+#ifndef QUERY_STATISTICS_CACHE_H
+#define QUERY_STATISTICS_CACHE_H
+
+#include "queries/query_statistics_store.h"
+#include "queries/query_type.h"
+
+/** @brief Statistical data for multiple query types, kept between query dispatches. */
+typedef struct query_statistics_cache query_statistics_cache_t;
+
+/**
+ * @brief  Creates a new empty cache of statistical data.
+ * @return A new ::query_statistics_cache_t, that must be freed with ::query_statistics_cache_free,
+ *         or `NULL` on allocation failure.
+ */
+query_statistics_cache_t *query_statistics_cache_create(void);
+
+/**
+ * @brief   Sets the store backing a cache.
+ * @details When statistical data isn't in the cache, it's looked up in @p store before being
+ *          generated, and exact data added to the cache is also written to @p store.
+ *
+ * @param cache Cache to be modified.
+ * @param store Store to back @p cache, that must outlive it (or `NULL`, not to use a store).
+ */
+void query_statistics_cache_set_store(query_statistics_cache_t *cache,
+                                      query_statistics_store_t *store);
+
+/**
+ * @brief Gets the cached statistical data for a query type. *
+ * @param cache       Cache to get statistical data from.
+ * @param type        Query type whose statistical data is wanted.
+ * @param approximate Whether approximate statistical data (see ::query_instance_get_approximate)
+ *                    is acceptable. Exact data is always acceptable.
+ *
+ * @return The statistical data for @p type, or `NULL` if it isn't in @p cache (or if it's
+ *         approximate and @p approximate is false) nor in its store. This data is owned by
+ *         @p cache.
+ */
+void *query_statistics_cache_get(query_statistics_cache_t *cache,
+                                 const query_type_t       *type,
+                                 int                       approximate);
+
+/**
+ * @brief Adds statistical data for a query type to a cache.
+ *
+ * @param cache       Cache to add statistical data to.
+ * @param type        Query type that generated @p statistics. Its
+ *                    ::query_type_free_statistics_callback_t will be used to free @p statistics.
+ * @param statistics  Statistical data to be cached. On success, it becomes owned by @p cache.
+ *                    There must not be exact data cached for @p type already. Approximate data
+ *                    cached for @p type is replaced (and freed).
+ * @param approximate Whether @p statistics was generated for approximate queries only.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure. @p statistics is still owned by the caller.
+ */
+int query_statistics_cache_put(query_statistics_cache_t *cache,
+                               const query_type_t       *type,
+                               void                     *statistics,
+                               int                       approximate);
+
+/**
+ * @brief   Removes (and frees) all statistical data in a cache.
+ * @details The cache also stops using its store.
+ * @param   cache Cache to be emptied.
+ */
+void query_statistics_cache_clear(query_statistics_cache_t *cache);
+
+/**
+ * @brief   Gets how many lookups in a cache found statistical data.
+ * @details Lookups (::query_statistics_cache_get) that load data from the cache's store are hits.
+ *
+ * @param cache  Cache to get the number of lookups from.
+ * @param hits   Where to write the number of lookups that found statistical data to.
+ * @param misses Where to write the number of lookups that didn't find statistical data to.
+ */
+void query_statistics_cache_get_lookup_counts(const query_statistics_cache_t *cache,
+                                              size_t                         *hits,
+                                              size_t                         *misses);
+
+/**
+ * @brief Frees a cache, and all the statistical data in it.
+ * @param cache Cache to be freed.
+ */
+void query_statistics_cache_free(query_statistics_cache_t *cache);
+
+#endif
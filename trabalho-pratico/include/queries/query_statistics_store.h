@@ -0,0 +1,117 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    query_statistics_store.h
+ * @brief   Statistical data kept in files, between runs of the program on the same dataset.
+ * @details Like a [cache](@ref query_statistics_cache.h), but on disk: statistical data that
+ *          doesn't depend on query arguments (see ::query_type_has_reusable_statistics) is written
+ *          to a file after it's first generated, and mapped back to memory on later runs, so that
+ *          running many query files against the same dataset only generates it once. Only query
+ *          types with a ::query_type_persistence_t can have their data stored.
+ *
+ *          Each query type has its own file, `<prefix><type number>`. Files are tied to a dataset
+ *          `fingerprint` (see ::dataset_input_get_fingerprint), like
+ *          [database snapshots](@ref database_snapshot.h), so that outdated data is never used.
+ *
+ * @anchor query_statistics_store_examples
+ * ### Examples
+ *
+ * A store is usually given to a ::query_statistics_cache_t, that looks up data in it before
+ * generating it, and saves newly generated data to it:
+ *
+ * ```c
+ * query_statistics_store_t *store = query_statistics_store_create("dataset/.stats_", fingerprint);
+ * query_statistics_cache_t *cache = query_statistics_cache_create();
+ * if (!store || !cache)
+ *     return 1; // Memory leak, just for simplicity
+ *
+ * query_statistics_cache_set_store(cache, store);
+ * query_dispatcher_dispatch_list(database, cache, queries, outputs, 0, NULL);
+ *
+ * query_statistics_cache_free(cache);
+ * query_statistics_store_free(store);
+ * ```
+ */
+
+#ifndef QUERY_STATISTICS_STORE_H
+#define QUERY_STATISTICS_STORE_H
+
+#include <stdint.h>
+
+#include "queries/query_type.h"
+#include "utils/mapped_file.h"
+
+/** @brief Statistical data for multiple query types, kept in files. */
+typedef struct query_statistics_store query_statistics_store_t;
+
+/**
+ * @brief Creates a handle to a store of statistical data.
+ *
+ * @param path_prefix Beginning of the path of every file in the store. Files don't need to exist.
+ * @param fingerprint Identifier of the dataset the stored data is generated from.
+ *
+ * @return A new ::query_statistics_store_t, that must be freed with ::query_statistics_store_free,
+ *         or `NULL` on allocation failure.
+ */
+query_statistics_store_t *query_statistics_store_create(const char *path_prefix,
+                                                        uint64_t    fingerprint);
+
+/**
+ * @brief   Writes the statistical data of a query type to a store.
+ * @details Data is written to a temporary file first (unique to the process), so that a failure
+ *          never leaves a corrupt file behind, and processes saving the same data at once don't
+ *          interfere with each other.
+ *
+ * @param store      Store to write the data to.
+ * @param type       Query type that generated @p statistics. Must have a
+ *                   ::query_type_persistence_t.
+ * @param statistics Statistical data to be written. Must not be approximate (see
+ *                   ::query_instance_get_approximate).
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int query_statistics_store_save(const query_statistics_store_t *store,
+                                const query_type_t             *type,
+                                const void                     *statistics);
+
+/**
+ * @brief Reads the statistical data of a query type from a store.
+ *
+ * @param store Store to read the data from.
+ * @param type  Query type whose statistical data is wanted.
+ * @param file  Where to write the mapped file the data was read from to. It must be closed with
+ *              ::mapped_file_close, after the returned data is freed with
+ *              ::query_type_persistence_t::free_loaded.
+ *
+ * @return The statistical data for @p type, or `NULL` if @p type doesn't have a
+ *         ::query_type_persistence_t, if its file doesn't exist, is corrupt or was created for
+ *         another dataset (or by another version of the program). `NULL` is also returned on
+ *         allocation failure.
+ */
+void *query_statistics_store_load(const query_statistics_store_t *store,
+                                  const query_type_t             *type,
+                                  mapped_file_t                 **file);
+
+/**
+ * @brief Frees a handle to a store of statistical data (the files in it are kept).
+ * @param store Store to be freed.
+ */
+void query_statistics_store_free(query_statistics_store_t *store);
+
+#endif
@@ -65,8 +65,39 @@
 #ifndef QUERY_TOKENIZER_H
 #define QUERY_TOKENIZER_H
 
+#include <stddef.h>
+
 #include "utils/tokenize_iter_callback.h"
 
+/**
+ * @struct query_tokenizer_span_t
+ * @brief  A token in a query, that isn't null-terminated (it points to the query's string).
+ *
+ * @var query_tokenizer_span_t::begin
+ *     @brief Pointer to the first character of the token (after the quote, for quoted tokens).
+ * @var query_tokenizer_span_t::length
+ *     @brief Number of characters in the token (not including quotes).
+ */
+typedef struct {
+    const char *begin;
+    size_t      length;
+} query_tokenizer_span_t;
+
+/**
+ * @brief   Finds the next token in a query, without modifying it or allocating any memory.
+ * @details The same tokens as ::query_tokenizer_tokenize are produced, in a single pass over the
+ *          query. The character right after each token is always a space, a quote or the string's
+ *          null terminator, so that it can be temporarily replaced by a null terminator.
+ *
+ * @param iter  Pointer to the position in the query where to start looking from, that will be
+ *              updated to point after the found token. Initialize it with the query's string.
+ * @param token Where to output the found token to.
+ *
+ * @retval 0 Success.
+ * @retval 1 No more tokens in the query.
+ */
+int query_tokenizer_next(const char **iter, query_tokenizer_span_t *token);
+
 /**
  * @brief Splits a **MODIFIABLE** string into query tokens.
  *
@@ -26,29 +26,61 @@
  * The following summary is for people who are interested in implementing their own queries. If
  * you just want to use existing queries, see query_type_list.h.
  *
- * Check out implementations of existing queries (q01.c to q10.c). In summary, here is what each
+ * Check out implementations of existing queries (q01.c to q13.c). In summary, here is what each
  * callback that needs to be defined does:
  *
  * - ::query_type_parse_arguments_callback_t parses arguments after the query type + formatting
  *   flag. For example, in `1f a b c`, this method is called with {"a", "b", "c"} for `argv` and `3`
  *   for `argc`. Note that the values in `argv` must be copied in case you want to store them for
- *   later, as they may change when parsing a query file. The function must return the value that
- *   will be stored in ::query_instance::argument_data (or `NULL` on failure).
+ *   later, as they may change when parsing a query file. Parsed arguments are written to memory
+ *   inside the ::query_instance_t (up to ::QUERY_TYPE_ARGUMENTS_MAX_SIZE bytes), so that no
+ *   allocations are needed.
  *
  * - ::query_type_clone_arguments_callback_t creates deep clones of the values generated by
- *   ::query_type_parse_arguments_callback_t, so that a ::query_instance_t can also be copied.
+ *   ::query_type_parse_arguments_callback_t, so that a ::query_instance_t can also be copied. This
+ *   method is only needed if arguments refer to other data (e.g.: strings).
  *
- * - ::query_type_free_arguments_callback_t `free`s data generated by
- *   ::query_type_parse_arguments_callback_t.
+ * - ::query_type_free_arguments_callback_t `free`s data referred to by the values generated by
+ *   ::query_type_parse_arguments_callback_t. This method is only needed if arguments refer to other
+ *   data (e.g.: strings).
+ *
+ * - ::query_type_save_arguments_callback_t and ::query_type_load_arguments_callback_t write the
+ *   data referred to by the values generated by ::query_type_parse_arguments_callback_t to a
+ *   [compiled query file](@ref query_file_compiler.h) and read it back. These methods are only
+ *   needed if arguments refer to other data (e.g.: strings), as the values themselves are always
+ *   written as they are.
  *
  * - ::query_type_generate_statistics_callback_t generates statistical data to be used for the
  *   execution of all queries of the same type. This method is optional.
  *
+ * - ::query_type_scan_t is an alternative to ::query_type_generate_statistics_callback_t, for
+ *   queries whose statistical data is generated by iterating through the database's managers. It
+ *   splits statistics generation in a part that runs before, during and after those iterations,
+ *   so that data for multiple query types can be generated in a single pass over each manager.
+ *   This is optional. If iteration callbacks can fill in partial data that is merged later, each
+ *   pass can also be split across multiple threads.
+ *
  * - ::query_type_free_statistics_callback_t frees data generated by
- *   ::query_type_generate_statistics_callback_t. This method is optional.
+ *   ::query_type_generate_statistics_callback_t (or ::query_type_scan_t). This method is optional.
+ *
+ * - ::query_type_persistence_t writes reusable statistical data to a file and reads it back, so
+ *   that it can be kept in a [store](@ref query_statistics_store.h) across runs of the program.
+ *   This is optional.
  *
  * - ::query_type_execute_callback_t executes a query.
  *
+ * - ::query_type_count_results_callback_t counts the objects a query outputs, without executing it,
+ *   so that queries with large outputs can be executed in parallel, one page at a time. This
+ *   method is optional.
+ *
+ * - ::query_type_estimate_results_callback_t estimates the number of objects a query outputs,
+ *   without executing it, so that space for them can be reserved beforehand. This method is
+ *   optional.
+ *
+ * Query types also declare the database indices (::database_index_set_t) they read from, so that
+ * those can be built before the queries are run, when a database's indices are only built on
+ * demand (see ::DATABASE_INDEX_POLICY_LAZY).
+ *
  * After defining these methods, create a constructor for your query using ::query_type_create.
  * Remember that any ::query_type_create call must have a ::query_type_free match. This is usually
  * automatically handled by query_type_list.c. If you're creating a new query, you must modify
@@ -61,9 +93,11 @@
 #define QUERY_TYPE_H
 
 #include <stddef.h>
+#include <stdio.h>
 
 #include "database/database.h"
 #include "queries/query_writer.h"
+#include "utils/string_pool.h"
 
 /** @cond FALSE */
 /* clang-format off */
@@ -78,37 +112,90 @@
 /** @brief A definition of a query. */
 typedef struct query_type query_type_t;
 
+/** @brief Maximum size (in bytes) of the arguments of a query, stored in a ::query_instance_t. */
+#define QUERY_TYPE_ARGUMENTS_MAX_SIZE 32
+
 /**
  * @brief Type of the method called for parsing query arguments.
  *
- * @param argc Number of query arguments.
- * @param argv Arguments of the query. These won't include the query type or whether the query's
- *             output must be formatted. Also, do not store these pointers without first making a
- *             copy of each string. They are non-constant so that you can modify them during your
- *             parsing, but will be quickly discarded.
+ * @param allocator Where to allocate strings the arguments refer to. Can be `NULL`, so that
+ *                  `strdup` is used instead of a pool.
+ * @param output    Where to write the parsed arguments to (::QUERY_TYPE_ARGUMENTS_MAX_SIZE suitably
+ *                  aligned bytes). Nothing must be left allocated in it on failure.
+ * @param argc      Number of query arguments.
+ * @param argv      Arguments of the query. These won't include the query type or whether the
+ *                  query's output must be formatted. Also, do not store these pointers without
+ *                  first making a copy of each string. They are non-constant so that you can modify
+ *                  them during your parsing, but will be quickly discarded.
  *
- * @return `NULL` on failure, other value on success. This value will be stored in
- *         ::query_instance::argument_data.
+ * @retval 0 Success.
+ * @retval 1 Parsing or allocation failure.
  */
-typedef void *(*query_type_parse_arguments_callback_t)(size_t argc, char *const argv[argc]);
+typedef int (*query_type_parse_arguments_callback_t)(string_pool_t *allocator,
+                                                     void          *output,
+                                                     size_t         argc,
+                                                     char *const    argv[argc]);
 
 /**
  * @brief   Type of the method called for cloning query arguments.
- * @details This exists for the sake of ::query_instance_t also being cloneable.
+ * @details This exists for the sake of ::query_instance_t also being cloneable. @p output already
+ *          contains a shallow copy of @p args_data, so only data it refers to must be copied.
  *
- * @param args_data Value returned by ::query_type_parse_arguments_callback_t.
+ * @param allocator Where to allocate strings the arguments refer to. Can be `NULL`, so that
+ *                  `strdup` is used instead of a pool.
+ * @param output    Where the clone of @p args_data is placed.
+ * @param args_data Arguments written by ::query_type_parse_arguments_callback_t.
  *
- * @return A deep clone of @p args, `NULL` on allocation failure.
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
  */
-typedef void *(*query_type_clone_arguments_callback_t)(const void *args_data);
+typedef int (*query_type_clone_arguments_callback_t)(string_pool_t *allocator,
+                                                     void          *output,
+                                                     const void    *args_data);
 
 /**
- * @brief Type of the method called for `free`ing what was returned by
- *        ::query_type_parse_arguments_callback_t.
- * @param args_data Non-`NULL` value returned by ::query_type_parse_arguments_callback_t.
+ * @brief   Type of the method called for `free`ing the data referred to by arguments written by
+ *          ::query_type_parse_arguments_callback_t.
+ * @details Only called for arguments parsed or cloned without an allocator.
+ *
+ * @param args_data Arguments written by ::query_type_parse_arguments_callback_t.
  */
 typedef void (*query_type_free_arguments_callback_t)(void *args_data);
 
+/**
+ * @brief   Type of the method called for writing the data referred to by query arguments to a
+ *          [compiled query file](@ref query_file_compiler.h).
+ * @details The ::QUERY_TYPE_ARGUMENTS_MAX_SIZE bytes of @p args_data are already written as they
+ *          are, so only data they refer to must be written.
+ *
+ * @param args_data Arguments written by ::query_type_parse_arguments_callback_t.
+ * @param file      File where to write the data referred to by @p args_data to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+typedef int (*query_type_save_arguments_callback_t)(const void *args_data, FILE *file);
+
+/**
+ * @brief   Type of the method called for reading the data written by
+ *          ::query_type_save_arguments_callback_t.
+ * @details @p output already contains a copy of the arguments that were saved, so only the data
+ *          they refer to must be read (like in ::query_type_clone_arguments_callback_t).
+ *
+ * @param allocator Where to allocate strings the arguments refer to. Can be `NULL`, so that
+ *                  `strdup` is used instead of a pool.
+ * @param output    Arguments to be fixed up, referring to @p contents in no way after returning.
+ * @param contents  Data written by ::query_type_save_arguments_callback_t (not null-terminated).
+ * @param size      Number of bytes in @p contents.
+ *
+ * @retval 0 Success.
+ * @retval 1 Corrupt @p contents or allocation failure. Nothing must be left allocated.
+ */
+typedef int (*query_type_load_arguments_callback_t)(string_pool_t *allocator,
+                                                    void          *output,
+                                                    const char    *contents,
+                                                    size_t         size);
+
 /**
  * @brief   Type of the method called to generate statistical data before running all queries of the
  *          same type.
@@ -126,22 +213,215 @@ typedef void *(*query_type_generate_statistics_callback_t)(
     size_t                        n,
     const query_instance_t *const instances[n]);
 
+/**
+ * @brief   Type of method called to finish generating statistical data, after all iterations
+ *          through the database's managers in a ::query_type_scan_t are done.
+ *
+ * @param database  Database to collect statistical information from.
+ * @param scan_data Data returned by ::query_type_scan_t::begin, after being filled in by all
+ *                  iteration callbacks. This method is responsible for freeing it, if it's not the
+ *                  returned value.
+ *
+ * @return `NULL` on failure, another value on success. Statistical data will be global to all
+ *         queries of the same type.
+ */
+typedef void *(*query_type_scan_end_callback_t)(const database_t *database, void *scan_data);
+
+/**
+ * @brief   Type of method called to add partial statistical data to the data it was created for.
+ * @details Merges happen after all iterations through the database are over, and before
+ *          ::query_type_scan_t::end is called.
+ *
+ * @param scan_data    Data returned by ::query_type_scan_t::begin.
+ * @param partial_data Data returned by ::query_type_scan_t::partial_begin, after being filled in by
+ *                     iteration callbacks. It must be freed by this method, even on failure.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure (the queries of this type won't be executed).
+ */
+typedef int (*query_type_scan_merge_callback_t)(void *scan_data, void *partial_data);
+
+/**
+ * @brief   Type of method called to estimate the cost of answering queries without a scan.
+ * @details When answering queries from the database's indexes is estimated to be cheaper than
+ *          iterating through all managers in a ::query_type_scan_t, no statistical data is
+ *          generated, and ::query_type_execute_callback_t is called with `NULL` statistics.
+ *
+ * @param database  Database the queries will be answered from.
+ * @param n         Number of query instances in @p instances.
+ * @param instances List of query instances that will need to be processed.
+ *
+ * @return The estimated number of database entities to be looked up, to answer all queries in
+ *         @p instances from indexes.
+ */
+typedef size_t (*query_type_scan_index_cost_callback_t)(
+    const database_t             *database,
+    size_t                        n,
+    const query_instance_t *const instances[n]);
+
+/**
+ * @brief   Type of method called to find the range of dates the statistical data of some queries
+ *          depends on.
+ * @details When the statistical data won't be reused by other queries, flights and reservations
+ *          outside this range aren't iterated through (see ::flight_manager_iter_columns_between
+ *          and ::reservation_manager_iter_columns_between). Iteration callbacks may still be
+ *          called for some entities outside the range.
+ *
+ * @param n         Number of query instances in @p instances.
+ * @param instances List of query instances that will need to be processed.
+ * @param begin     Where to write the first date (inclusive) the queries depend on to.
+ * @param end       Where to write the last date (inclusive) the queries depend on to.
+ *
+ * @retval 0 @p begin and @p end were written.
+ * @retval 1 The queries depend on all dates.
+ */
+typedef int (*query_type_scan_date_range_callback_t)(size_t                        n,
+                                                     const query_instance_t *const instances[n],
+                                                     date_t                       *begin,
+                                                     date_t                       *end);
+
+/**
+ * @brief   Type of method called to estimate how much memory the statistical data of some queries
+ *          will take.
+ * @details When a memory budget for statistical data is set (see
+ *          ::query_dispatcher_set_statistics_budget) and this estimate goes over it, queries are
+ *          split into smaller groups, each with its own statistical data, generated and freed
+ *          before the next group's. For that to pay off, the estimate should depend on the queries
+ *          themselves (e.g., through ::query_type_scan_date_range_callback_t).
+ *
+ * @param database  Database the statistical data will be generated from.
+ * @param n         Number of query instances in @p instances.
+ * @param instances List of query instances that will need to be processed.
+ *
+ * @return The estimated size of the statistical data, in bytes.
+ */
+typedef size_t (*query_type_scan_size_callback_t)(const database_t             *database,
+                                                  size_t                        n,
+                                                  const query_instance_t *const instances[n]);
+
+/**
+ * @struct  query_type_scan_t
+ * @brief   Statistics generation that relies on iterations through the database's managers.
+ * @details When multiple query types need to iterate through the same manager, that's done only
+ *          once, and the callbacks of each query type are called for each element. Iteration
+ *          callbacks for different managers may be called at the same time, on different threads,
+ *          so they must not modify the same data.
+ *
+ *          If both ::query_type_scan_t::partial_begin and ::query_type_scan_t::merge are provided,
+ *          iterations through a manager may be split across multiple threads. Each thread fills in
+ *          its own partial statistical data, passed to iteration callbacks instead of `scan_data`,
+ *          and merged into `scan_data` after the iteration. Partial data that's written to for
+ *          every element (counters, sums, ...) should be allocated with ::cache_line_calloc, so
+ *          that threads don't slow each other down by writing to the same cache lines. Partial
+ *          data is always merged in the order of the threads' sub-ranges, so floating-point sums
+ *          and ties are the same in every run with the same number of threads.
+ *
+ * @var query_type_scan_t::begin
+ *     @brief Method called before any iteration, to create the data (`scan_data`) passed to all
+ *            iteration callbacks as `user_data`. Cannot be `NULL`.
+ * @var query_type_scan_t::foreach_user
+ *     @brief Method called for every user in the database. Can be `NULL`.
+ * @var query_type_scan_t::foreach_flights
+ *     @brief Method called for every block of flights in the database (see
+ *            ::flight_manager_iter_columns). Can be `NULL`.
+ * @var query_type_scan_t::foreach_reservations
+ *     @brief Method called for every block of reservations in the database (see
+ *            ::reservation_manager_iter_columns). Can be `NULL`.
+ * @var query_type_scan_t::end
+ *     @brief Method called after all iterations, that returns the final statistical data. Can be
+ *            `NULL`, for `scan_data` to be used as statistical data.
+ * @var query_type_scan_t::partial_begin
+ *     @brief Method called to create the partial data of each thread in a parallel iteration,
+ *            passed to iteration callbacks as `user_data`. Can be `NULL`, for iterations not to
+ *            be split across threads.
+ * @var query_type_scan_t::merge
+ *     @brief Method called to merge the partial data of each thread in a parallel iteration into
+ *            `scan_data`. Can be `NULL`, for iterations not to be split across threads.
+ * @var query_type_scan_t::index_cost
+ *     @brief Method called to choose between scanning the database and answering each query from
+ *            indexes. Can be `NULL`, for queries to always be answered after a scan.
+ * @var query_type_scan_t::date_range
+ *     @brief Method called to restrict iterations through flights and reservations to a range of
+ *            dates. Can be `NULL`, for all flights and reservations to always be iterated through.
+ * @var query_type_scan_t::estimate_size
+ *     @brief Method called to keep statistical data under a memory budget. Can be `NULL`, for
+ *            queries never to be split into smaller groups.
+ */
+typedef struct {
+    query_type_generate_statistics_callback_t   begin;
+    user_manager_iter_callback_t                foreach_user;
+    flight_manager_iter_columns_callback_t      foreach_flights;
+    reservation_manager_iter_columns_callback_t foreach_reservations;
+    query_type_scan_end_callback_t              end;
+    query_type_generate_statistics_callback_t   partial_begin;
+    query_type_scan_merge_callback_t            merge;
+    query_type_scan_index_cost_callback_t       index_cost;
+    query_type_scan_date_range_callback_t       date_range;
+    query_type_scan_size_callback_t             estimate_size;
+} query_type_scan_t;
+
 /**
  * @brief   Type of method called to free data generated by
  *          ::query_type_generate_statistics_callback_t.
- * @details Can be `NULL` if the query type's ::query_type_generate_statistics_callback_t is also
- *          `NULL`.
+ * @details Can be `NULL` if the query type's ::query_type_generate_statistics_callback_t and
+ *          ::query_type_scan_t are also `NULL`.
  *
  * @param   statistics Non-`NULL` value returned by ::query_type_generate_statistics_callback_t.
  */
 typedef void (*query_type_free_statistics_callback_t)(void *statistics);
 
+/**
+ * @brief Type of method called to write statistical data to a file.
+ *
+ * @param statistics Non-`NULL` value returned by ::query_type_generate_statistics_callback_t (or
+ *                   by ::query_type_load_statistics_callback_t).
+ * @param file       File where to write @p statistics to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+typedef int (*query_type_save_statistics_callback_t)(const void *statistics, FILE *file);
+
+/**
+ * @brief Type of method called to read statistical data written by
+ *        ::query_type_save_statistics_callback_t.
+ *
+ * @param contents Contents of a mapped file, written by ::query_type_save_statistics_callback_t.
+ *                 These stay mapped until the returned statistics are freed, so statistical data
+ *                 can point to them instead of being copied.
+ * @param size     Number of bytes in @p contents.
+ *
+ * @return Statistical data equal to the one that was saved, or `NULL` if @p contents are corrupt
+ *         or on allocation failure.
+ */
+typedef void *(*query_type_load_statistics_callback_t)(const char *contents, size_t size);
+
+/**
+ * @struct query_type_persistence_t
+ * @brief  How to keep reusable statistical data of a query type in files.
+ *
+ * @var query_type_persistence_t::save
+ *     @brief Method called to write statistical data to a file.
+ * @var query_type_persistence_t::load
+ *     @brief Method called to read statistical data from a file.
+ * @var query_type_persistence_t::free_loaded
+ *     @brief Method called to free statistical data returned by
+ *            ::query_type_persistence_t::load. Can be `NULL` if that data only points to the
+ *            mapped file.
+ */
+typedef struct {
+    query_type_save_statistics_callback_t save;
+    query_type_load_statistics_callback_t load;
+    query_type_free_statistics_callback_t free_loaded;
+} query_type_persistence_t;
+
 /**
  * @brief Type of method called to execute a query.
  *
  * @param database   Database to perform data lookups.
  * @param statistics Data generated by ::query_type_generate_statistics_callback_t, or `NULL` if
- *                   that callback isn't defined for a given query type.
+ *                   that callback isn't defined for a given query type (or if queries are answered
+ *                   from indexes, see ::query_type_scan_index_cost_callback_t).
  * @param instance   Query instance to execute.
  * @param output     Where to write query results to.
  *
@@ -152,10 +432,58 @@ typedef int (*query_type_execute_callback_t)(const database_t       *database,
                                              const query_instance_t *instance,
                                              query_writer_t         *output);
 
+/**
+ * @brief   Type of method called to count the objects in the output of a query, without executing
+ *          it.
+ * @details Can be `NULL`. When provided, queries with large outputs may be split in pages (see
+ *          ::query_instance_set_page), executed concurrently, each to its own
+ *          ::query_writer_t. ::query_type_execute_callback_t must then be able to skip to the
+ *          beginning of a page quickly, without iterating through previous objects.
+ *
+ * @param database   Database to perform data lookups.
+ * @param statistics See ::query_type_execute_callback_t.
+ * @param instance   Query instance whose results are to be counted.
+ *
+ * @return The number of objects in the output of @p instance, ignoring its page.
+ */
+typedef size_t (*query_type_count_results_callback_t)(const database_t       *database,
+                                                      const void             *statistics,
+                                                      const query_instance_t *instance);
+
+/**
+ * @brief   Type of method called to estimate the number of objects in the output of a query,
+ *          without executing it.
+ * @details Can be `NULL`. When provided, space for that many objects is reserved in the query's
+ *          ::query_writer_t (see ::query_writer_reserve_objects) before it's executed, so that
+ *          large outputs don't grow one reallocation at a time. It must be much cheaper than
+ *          executing the query, and overestimates waste memory until the query is over.
+ *
+ * @param database   Database to perform data lookups.
+ * @param statistics See ::query_type_execute_callback_t.
+ * @param instance   Query instance whose results are to be estimated.
+ *
+ * @return The estimated number of objects in the output of @p instance, ignoring its page.
+ */
+typedef size_t (*query_type_estimate_results_callback_t)(const database_t       *database,
+                                                         const void             *statistics,
+                                                         const query_instance_t *instance);
+
 /**
  * @brief   Creates a query type, defining its behavior.
  * @details For parameter description, see the description for the type of each parameter.
- *          @p type_number is a number that identifies a query (e.g.: q01.h -> `1`).
+ *          @p type_number is a number that identifies a query (e.g.: q01.h -> `1`). @p scan is
+ *          copied and can be `NULL`. @p clone_arguments, @p free_arguments, @p save_arguments and
+ *          @p load_arguments can be `NULL` if arguments don't refer to other data. If both
+ *          @p generate_statistics and @p scan are provided, @p scan is preferred.
+ *          @p reusable_statistics must only be non-zero if the statistical data generated doesn't
+ *          depend on the queries it's generated for, so that it can be kept in a
+ *          [cache](@ref query_statistics_cache.h) and used for other queries. @p persistence is
+ *          copied and can be `NULL`, for statistical data not to be kept in files (it's ignored
+ *          unless @p reusable_statistics is non-zero). @p count_results can be `NULL`, for queries
+ *          not to be split in pages. @p estimate_results can be `NULL`, for no space to be reserved
+ *          for query outputs. @p indexes are the database indices read when generating statistics
+ *          for or executing this query, other than the ones needed to iterate through managers in
+ *          @p scan.
  *
  * @return A pointer to a new ::query_type_t, that must be `free`d with ::query_type_free. `NULL`
  *         can be returned on allocation failure.
@@ -167,9 +495,17 @@ query_type_t *query_type_create(size_t                                    type_n
                                 query_type_parse_arguments_callback_t     parse_arguments,
                                 query_type_clone_arguments_callback_t     clone_arguments,
                                 query_type_free_arguments_callback_t      free_arguments,
+                                query_type_save_arguments_callback_t      save_arguments,
+                                query_type_load_arguments_callback_t      load_arguments,
                                 query_type_generate_statistics_callback_t generate_statistics,
+                                const query_type_scan_t                  *scan,
                                 query_type_free_statistics_callback_t     free_statistics,
-                                query_type_execute_callback_t             execute);
+                                int                                       reusable_statistics,
+                                const query_type_persistence_t           *persistence,
+                                query_type_execute_callback_t             execute,
+                                query_type_count_results_callback_t       count_results,
+                                query_type_estimate_results_callback_t    estimate_results,
+                                database_index_set_t                      indexes);
 
 /**
  * @brief  Creates a deep copy of a query type.
@@ -210,6 +546,24 @@ query_type_clone_arguments_callback_t
 query_type_free_arguments_callback_t
     query_type_get_free_arguments_callback(const query_type_t *type);
 
+/**
+ * @brief  Gets the method called for saving query arguments from a ::query_type_t.
+ * @param  type ::query_type_t to get the method called for saving query arguments from.
+ * @return @p type 's method called for saving data referred to by query arguments, or `NULL` if
+ *         it doesn't have one.
+ */
+query_type_save_arguments_callback_t
+    query_type_get_save_arguments_callback(const query_type_t *type);
+
+/**
+ * @brief  Gets the method called for loading query arguments from a ::query_type_t.
+ * @param  type ::query_type_t to get the method called for loading query arguments from.
+ * @return @p type 's method called for loading data referred to by query arguments, or `NULL` if
+ *         it doesn't have one.
+ */
+query_type_load_arguments_callback_t
+    query_type_get_load_arguments_callback(const query_type_t *type);
+
 /**
  * @brief  Gets the method called for generating statistical data from a ::query_type_t.
  * @param  type ::query_type_t to get the method called for generating statistical data from.
@@ -218,6 +572,14 @@ query_type_free_arguments_callback_t
 query_type_generate_statistics_callback_t
     query_type_get_generate_statistics_callback(const query_type_t *type);
 
+/**
+ * @brief  Gets the description of how to generate statistical data by iterating through the
+ *         database, from a ::query_type_t.
+ * @param  type ::query_type_t to get the ::query_type_scan_t from.
+ * @return @p type 's ::query_type_scan_t, or `NULL` if it doesn't have one.
+ */
+const query_type_scan_t *query_type_get_scan(const query_type_t *type);
+
 /**
  * @brief  Gets the method called for `free`ing statistical data from a ::query_type_t.
  * @param  type ::query_type_t to get the method called for `free`ing statistical data from.
@@ -226,6 +588,33 @@ query_type_generate_statistics_callback_t
 query_type_free_statistics_callback_t
     query_type_get_free_statistics_callback(const query_type_t *type);
 
+/**
+ * @brief  Checks if the statistical data of a ::query_type_t doesn't depend on query arguments.
+ * @param  type ::query_type_t to be checked.
+ * @return Whether statistical data generated by @p type can be reused for any other query of the
+ *         same type.
+ */
+int query_type_has_reusable_statistics(const query_type_t *type);
+
+/**
+ * @brief  Gets how to keep the statistical data of a ::query_type_t in files.
+ * @param  type ::query_type_t to get the ::query_type_persistence_t from.
+ * @return @p type 's ::query_type_persistence_t, or `NULL` if it doesn't have one (or if its
+ *         statistical data isn't reusable).
+ */
+const query_type_persistence_t *query_type_get_persistence(const query_type_t *type);
+
+/**
+ * @brief   Checks if the queries of a ::query_type_t need statistical data to be executed.
+ * @details Queries that don't need statistical data can be executed one by one, as soon as they're
+ *          parsed, without waiting for the other queries of the same type.
+ *
+ * @param  type ::query_type_t to be checked.
+ * @return Whether @p type has a ::query_type_generate_statistics_callback_t or a
+ *         ::query_type_scan_t.
+ */
+int query_type_needs_statistics(const query_type_t *type);
+
 /**
  * @brief  Gets the method called for executing a query from a ::query_type_t.
  * @param  type ::query_type_t to get the method called for query execution from.
@@ -233,6 +622,30 @@ query_type_free_statistics_callback_t
  */
 query_type_execute_callback_t query_type_get_execute_callback(const query_type_t *type);
 
+/**
+ * @brief  Gets the method called for counting the results of a query from a ::query_type_t.
+ * @param  type ::query_type_t to get the method called for counting query results from.
+ * @return @p type 's method called for counting query results, or `NULL` if it doesn't have one.
+ */
+query_type_count_results_callback_t
+    query_type_get_count_results_callback(const query_type_t *type);
+
+/**
+ * @brief  Gets the method called for estimating the results of a query from a ::query_type_t.
+ * @param  type ::query_type_t to get the method called for estimating query results from.
+ * @return @p type 's method called for estimating query results, or `NULL` if it doesn't have one.
+ */
+query_type_estimate_results_callback_t
+    query_type_get_estimate_results_callback(const query_type_t *type);
+
+/**
+ * @brief  Gets the database indices a query type reads from.
+ * @param  type ::query_type_t to get the indices from.
+ * @return The indices @p type reads from, including the ones needed for the iterations in its
+ *         ::query_type_scan_t.
+ */
+database_index_set_t query_type_get_indexes(const query_type_t *type);
+
 /**
  * @brief Frees memory in a ::query_type_t.
  * @param query Query to be deleted.
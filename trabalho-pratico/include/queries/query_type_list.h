@@ -41,7 +41,27 @@
 #include "queries/query_type.h"
 
 /** @brief Number of queries supported (1 to ::QUERY_TYPE_LIST_COUNT). */
-#define QUERY_TYPE_LIST_COUNT 10
+#define QUERY_TYPE_LIST_COUNT 13
+
+/**
+ * @brief   X-macro over all supported query types, in order.
+ * @details `X(number, prefix)` is expanded for every query type, where `prefix` is the name of the
+ *          module that defines it (e.g.: `q01`, providing `q01_create` and `q01_execute`).
+ */
+#define QUERY_TYPE_LIST_FOREACH(X)                                                                 \
+    X(1, q01)                                                                                      \
+    X(2, q02)                                                                                      \
+    X(3, q03)                                                                                      \
+    X(4, q04)                                                                                      \
+    X(5, q05)                                                                                      \
+    X(6, q06)                                                                                      \
+    X(7, q07)                                                                                      \
+    X(8, q08)                                                                                      \
+    X(9, q09)                                                                                      \
+    X(10, q10)                                                                                     \
+    X(11, q11)                                                                                     \
+    X(12, q12)                                                                                     \
+    X(13, q13)
 
 /**
  * @brief   Gets a query definition by its numerical identifier (type).
@@ -56,4 +76,41 @@
  */
 const query_type_t *query_type_list_get_by_index(size_t index);
 
+/**
+ * @brief   Executes a query, calling its type's execution method directly.
+ * @details Unlike ::query_type_get_execute_callback, the execution method isn't called through a
+ *          function pointer, but through a `switch` generated from ::QUERY_TYPE_LIST_FOREACH.
+ *          Direct calls avoid loading the method from the query's type, which matters for cheap
+ *          queries that are executed very often.
+ *
+ * @param database   Database to perform data lookups.
+ * @param statistics Statistical data for the query's type (see ::query_type_execute_callback_t).
+ * @param instance   Query instance to execute.
+ * @param output     Where to write query results to.
+ *
+ * @return The value returned by the query type's execution method, or `1` if the query's type is
+ *         unknown.
+ */
+int query_type_list_execute(const database_t       *database,
+                            const void             *statistics,
+                            const query_instance_t *instance,
+                            query_writer_t         *output);
+
+/**
+ * @brief   Reserves space in a query's output for the objects it's expected to write, before it's
+ *          executed.
+ * @details Does nothing if the query's type doesn't have a
+ *          ::query_type_estimate_results_callback_t. Only objects in the query's page are
+ *          considered (see ::query_writer_reserve_objects).
+ *
+ * @param database   Database the query will be executed on.
+ * @param statistics Statistical data for the query's type (see ::query_type_execute_callback_t).
+ * @param instance   Query instance to be executed.
+ * @param output     Where the query's results will be written to.
+ */
+void query_type_list_reserve_output(const database_t       *database,
+                                    const void             *statistics,
+                                    const query_instance_t *instance,
+                                    query_writer_t         *output);
+
 #endif
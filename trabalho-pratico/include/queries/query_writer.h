@@ -31,7 +31,7 @@
  *
  * for (size_t i = 0; i < 5; ++i) {
  *     query_writer_write_new_object(writer);
- *     query_writer_write_new_field(writer, "value", "%zu", i);
+ *     query_writer_write_new_field_unsigned(writer, "value", i);
  *     query_writer_write_new_field(writer, "double", "%zu", 2 * i);
  * }
  * ```
@@ -83,30 +83,178 @@
  * ```
  *
  * Alternatively, we can provide an output file directly to ::query_writer_create, but
- * ::query_writer_get_lines wouldn't work.
+ * ::query_writer_get_lines wouldn't work. Output is kept in memory, and the file is only written
+ * (with a single system call) when ::query_writer_close or ::query_writer_free are called. This
+ * way, many writers can exist at the same time without keeping as many files open. Output can
+ * also be written to a [container](@ref query_output_container.h) shared by many queries, with
+ * ::query_writer_create_in_container.
+ *
+ * Fields can be written with a `printf` format string (::query_writer_write_new_field), or with
+ * a typed field writer, such as ::query_writer_write_new_field_unsigned. The latter is preferred
+ * for queries with large outputs, as values are formatted without parsing any format string.
+ *
+ * Only a page of objects can be outputted (see ::query_writer_set_page): objects outside of it are
+ * ignored, but still counted, so that formatted output keeps its numbering. Queries that can find
+ * the objects in the page directly (e.g.: in a slice of an index) should skip the ones before it
+ * with ::query_writer_skip_objects, and stop once ::query_writer_is_page_full.
+ *
+ * The output of queries with many objects can be written concurrently, in chunks created with
+ * ::query_writer_create_chunk, each with its own page.
+ *
+ * When outputting to a list of strings, lines can also be read with ::query_writer_get_line_count
+ * and ::query_writer_get_line from another thread, while the query is still running.
+ *
+ * @anchor query_writer_binary_format
+ * ### Binary output
+ *
+ * Output meant to be read by other programs, rather than people, can be written in binary (see
+ * ::query_writer_set_binary), avoiding the cost of formatting numbers and dates, and of parsing
+ * them back. Every object is a record, made of a 32-bit length (the number of bytes after it) and
+ * of its fields, in the order they'd have in text. Each field is:
+ *
+ * - Its type, a single byte (a ::query_writer_binary_type_t);
+ * - The length of its key, a single byte, followed by the key's characters;
+ * - Its value, whose layout depends on its type (see ::query_writer_binary_type_t).
+ *
+ * All integers are little-endian, and strings aren't null-terminated. Objects aren't numbered,
+ * but ones outside of the page (see ::query_writer_set_page) are still left out.
  */
 
 #ifndef QUERY_WRITER_H
 #define QUERY_WRITER_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "queries/query_output_container.h"
+#include "types/airport_code.h"
+#include "utils/date.h"
+#include "utils/date_and_time.h"
+
 /** @brief Information about where to output query results to. */
 typedef struct query_writer query_writer_t;
 
+/**
+ * @brief   Type of a field in [binary output](@ref query_writer_binary_format).
+ * @details Dates are a 16-bit year, followed by a byte for the month and another for the day. Dates
+ *          and times are followed by a byte for the hours, another for the minutes and another for
+ *          the seconds.
+ */
+typedef enum {
+    QUERY_WRITER_BINARY_TYPE_STRING        = 1, /**< @brief 32-bit length and characters. */
+    QUERY_WRITER_BINARY_TYPE_UNSIGNED      = 2, /**< @brief 64-bit unsigned integer. */
+    QUERY_WRITER_BINARY_TYPE_SIGNED        = 3, /**< @brief 64-bit signed integer. */
+    QUERY_WRITER_BINARY_TYPE_DECIMAL       = 4, /**< @brief 64-bit IEEE 754 number. */
+    QUERY_WRITER_BINARY_TYPE_CENTS         = 5, /**< @brief 64-bit unsigned hundredths. */
+    QUERY_WRITER_BINARY_TYPE_DATE          = 6, /**< @brief 4 bytes (see above). */
+    QUERY_WRITER_BINARY_TYPE_DATE_AND_TIME = 7  /**< @brief 7 bytes (see above). */
+} query_writer_binary_type_t;
+
 /**
  * @brief Creates a place where to output query results to.
  *
- * @param out_file_path Path to file to try to open for writing. Can be `NULL`, so that query
- *                      results are outputted an internal list of strings.
+ * @param out_file_path Path to file to write to, when the writer is closed. Can be `NULL`, so
+ *                      that query results are outputted an internal list of strings.
  * @param formatted     Whether the output of the query should be formatted (pretty printed).
  *
  * @return A pointer to a ::query_writer_t that must be deleted with ::query_writer_free. `NULL`
- *         will be returned on both IO and allocation failures.
+ *         will be returned on allocation failure.
  *
  * #### Examples
  * See [the header file's documentation](@ref query_writer_examples).
  */
 query_writer_t *query_writer_create(const char *out_file_path, int formatted);
 
+/**
+ * @brief   Creates a place where to output query results to, that is written to a container.
+ * @details Like when writing to a file, output is kept in memory until the writer is closed.
+ *
+ * @param container Container to write to when the writer is closed. Must outlive the writer.
+ * @param id        Identifier of the query's entry in @p container.
+ * @param formatted Whether the output of the query should be formatted (pretty printed).
+ *
+ * @return A pointer to a ::query_writer_t that must be deleted with ::query_writer_free. `NULL`
+ *         will be returned on allocation failure.
+ */
+query_writer_t *query_writer_create_in_container(query_output_container_t *container,
+                                                 uint64_t                  id,
+                                                 int                       formatted);
+
+/**
+ * @brief   Creates a place where to output a chunk of the results of a query, to be later appended
+ *          to another query writer.
+ * @details Chunks are kept in memory and, unlike writers, can't be closed. Different chunks of the
+ *          same query can be written to concurrently, each with its own page (see
+ *          ::query_writer_set_page), and then appended in order with ::query_writer_append_chunk.
+ *
+ * @param writer Writer the chunk will be appended to. Mustn't output to a list of strings.
+ *
+ * @return A pointer to a ::query_writer_t that must be deleted with ::query_writer_free. `NULL`
+ *         will be returned on allocation failure, or if @p writer outputs to a list of strings.
+ */
+query_writer_t *query_writer_create_chunk(const query_writer_t *writer);
+
+/**
+ * @brief Appends the output of a chunk (see ::query_writer_create_chunk) to a query writer.
+ *
+ * @param writer Writer to append @p chunk to.
+ * @param chunk  Chunk created for @p writer, whose objects come after the ones already in
+ *               @p writer.
+ */
+void query_writer_append_chunk(query_writer_t *writer, const query_writer_t *chunk);
+
+/**
+ * @brief   Sets which objects written to a query writer are to be outputted (a page of results).
+ * @details Must be called before any object is written. By default, all objects are outputted.
+ *
+ * @param writer Writer to set the page of.
+ * @param offset Number of objects at the beginning of the output to be left out.
+ * @param limit  Maximum number of objects to be outputted, after the first @p offset (`SIZE_MAX`
+ *               for no limit).
+ */
+void query_writer_set_page(query_writer_t *writer, size_t offset, size_t limit);
+
+/**
+ * @brief   Reserves space for the objects a query writer is expected to output.
+ * @details Meant to be called before a query is executed, with an estimate of the number of objects
+ *          in its page (see ::query_type_estimate_results_callback_t), so that large outputs don't
+ *          go through many reallocations. The space reserved is capped, so that bad estimates don't
+ *          waste too much memory. This is only a hint: allocation failures are ignored.
+ *
+ * @param writer   Writer to reserve space in.
+ * @param nobjects Estimated number of objects to be outputted.
+ */
+void query_writer_reserve_objects(query_writer_t *writer, size_t nobjects);
+
+/**
+ * @brief   Makes a query writer output [binary records](@ref query_writer_binary_format) instead of
+ *          text, whether it was created formatted or not.
+ * @details Must be called before any object is written. Chunks created afterwards (see
+ *          ::query_writer_create_chunk) are also binary. Writers that output to a list of strings
+ *          can't be made binary, and this does nothing to them.
+ *
+ * @param writer Writer to output binary records to.
+ */
+void query_writer_set_binary(query_writer_t *writer);
+
+/**
+ * @brief   Counts objects as if they had been written outside of the writer's page.
+ * @details Meant for queries that find the objects in a page directly, so that the ones before it
+ *          aren't even generated.
+ *
+ * @param writer Writer to skip objects in.
+ * @param n      Number of objects to be skipped.
+ */
+void query_writer_skip_objects(query_writer_t *writer, size_t n);
+
+/**
+ * @brief  Checks if no more objects will be outputted by a query writer, because its page is
+ *         over.
+ * @param  writer Writer to be checked.
+ * @return Whether the next object written to @p writer would be after the writer's page.
+ */
+int query_writer_is_page_full(const query_writer_t *writer);
+
 /**
  * @brief Marks that a new object will start to be written (a new flight, a new user, ...).
  * @param writer Where to write a query's output to.
@@ -117,7 +265,9 @@ query_writer_t *query_writer_create(const char *out_file_path, int formatted);
 void query_writer_write_new_object(query_writer_t *writer);
 
 /**
- * @brief Writes a field of an object to a query writer.
+ * @brief   Writes a field of an object to a query writer.
+ * @details In [binary output](@ref query_writer_binary_format), the formatted value is a
+ *          ::QUERY_WRITER_BINARY_TYPE_STRING.
  *
  * @param writer Where to write the query's output to.
  * @param key    Name of the field being outputted.
@@ -130,6 +280,124 @@ void query_writer_write_new_object(query_writer_t *writer);
 void query_writer_write_new_field(query_writer_t *writer, const char *key, const char *format, ...)
     __attribute__((format(printf, 3, 4)));
 
+/**
+ * @brief   Writes a string field of an object to a query writer.
+ * @details Like the other typed field writers, this is faster than ::query_writer_write_new_field,
+ *          as no `printf` format string needs to be parsed.
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param value  Value of the field.
+ */
+void query_writer_write_new_field_string(query_writer_t *writer,
+                                         const char     *key,
+                                         const char     *value);
+
+/**
+ * @brief Writes an unsigned integer field of an object to a query writer.
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param value  Value of the field.
+ */
+void query_writer_write_new_field_unsigned(query_writer_t *writer,
+                                           const char     *key,
+                                           uint64_t        value);
+
+/**
+ * @brief Writes a signed integer field of an object to a query writer.
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param value  Value of the field.
+ */
+void query_writer_write_new_field_signed(query_writer_t *writer, const char *key, int64_t value);
+
+/**
+ * @brief   Writes a decimal number field of an object to a query writer, with three decimal places.
+ * @details The output is the same as the one of `printf("%.3f", value)`, including rounding.
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param value  Value of the field.
+ */
+void query_writer_write_new_field_decimal(query_writer_t *writer, const char *key, double value);
+
+/**
+ * @brief   Writes a field of an object to a query writer, from an amount in cents.
+ * @details The output is the same as the one of ::query_writer_write_new_field_decimal for
+ *          `cents / 100.0`, but no floating-point arithmetic is needed.
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param cents  Value of the field, in hundredths.
+ */
+void query_writer_write_new_field_cents(query_writer_t *writer, const char *key, uint64_t cents);
+
+/**
+ * @brief Writes a date field of an object to a query writer (see ::date_sprintf).
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param value  Value of the field.
+ */
+void query_writer_write_new_field_date(query_writer_t *writer, const char *key, date_t value);
+
+/**
+ * @brief Writes a date and time field of an object to a query writer (see
+ *        ::date_and_time_sprintf).
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param value  Value of the field.
+ */
+void query_writer_write_new_field_date_and_time(query_writer_t *writer,
+                                                const char     *key,
+                                                date_and_time_t value);
+
+/**
+ * @brief   Writes an airport code field of an object to a query writer (see
+ *          ::airport_code_sprintf).
+ * @details In [binary output](@ref query_writer_binary_format), the code is a
+ *          ::QUERY_WRITER_BINARY_TYPE_STRING.
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param value  Value of the field.
+ */
+void query_writer_write_new_field_airport_code(query_writer_t *writer,
+                                               const char     *key,
+                                               airport_code_t  value);
+
+/**
+ * @brief   Writes everything outputted to a query writer to its file (or container).
+ * @details Nothing else can be written to @p writer after it's closed. This does nothing if `NULL`
+ *          was provided as a file path to ::query_writer_create, or if @p writer was already
+ *          closed.
+ *
+ * @param writer Writer to be closed.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure (some output may have been lost).
+ */
+int query_writer_close(query_writer_t *writer);
+
+/**
+ * @brief   Closes a query writer, making its file a hard link to the file of another writer.
+ * @details Meant for queries identical to an already executed one, whose output would be the same.
+ *          Nothing must have been written to @p writer. If both writers output to the same
+ *          container, the entry of @p writer shares the payload of @p original instead.
+ *
+ * @param writer   Writer to be closed. Its file is replaced, if it already exists.
+ * @param original Writer to share the file of. Must have already been closed.
+ *
+ * @retval 0 Success.
+ * @retval 1 Any of the writers has no file nor container, @p original wasn't closed or
+ *           lost output, or linking failed (e.g.: on a file system without hard links). @p writer
+ *           isn't closed, so that the query can still be executed normally.
+ */
+int query_writer_close_as_link(query_writer_t *writer, const query_writer_t *original);
+
 /**
  * @brief   Gets the lines outputted by a query writer.
  * @details Will only work if `NULL` was provided as a file path to ::query_writer_create.
@@ -146,7 +414,42 @@ void query_writer_write_new_field(query_writer_t *writer, const char *key, const
 const char *const *query_writer_get_lines(query_writer_t *writer, size_t *out_n);
 
 /**
- * @brief Frees memory allocated by ::query_writer_create.
+ * @brief   Gets the number of complete lines outputted by a query writer so far.
+ * @details Can be called from another thread while the query is writing to @p writer. Unlike
+ *          ::query_writer_get_lines, an unfinished last line of unformatted output isn't counted
+ *          (nor flushed).
+ *
+ * @param writer Writer that was created with a `NULL` file path.
+ *
+ * @return The number of lines that can be obtained with ::query_writer_get_line.
+ */
+size_t query_writer_get_line_count(query_writer_t *writer);
+
+/**
+ * @brief   Gets a line outputted by a query writer.
+ * @details Can be called from another thread while the query is writing to @p writer.
+ *
+ * @param writer Writer that was created with a `NULL` file path.
+ * @param i      Index of the line. Must be lower than the value of ::query_writer_get_line_count.
+ *
+ * @return The @p i-th line, valid until @p writer is `free`d.
+ */
+const char *query_writer_get_line(query_writer_t *writer, size_t i);
+
+/**
+ * @brief   Makes a query writer ignore further output.
+ * @details Can be called from another thread, to stop the output of a query no one is waiting
+ *          for from growing. Lines already written are kept.
+ *
+ * @param writer Writer to be cancelled.
+ */
+void query_writer_cancel(query_writer_t *writer);
+
+/**
+ * @brief   Frees memory allocated by ::query_writer_create.
+ * @details If @p writer hasn't been closed yet, ::query_writer_close is called first (ignoring
+ *          errors).
+ *
  * @param writer Non-`NULL` value returned by ::query_writer_create.
  *
  * #### Examples
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    server_mode.h
+ * @brief   Server mode (answer queries received through a Unix domain socket).
+ * @details The dataset is loaded only once, and then queries can be sent by clients connected to a
+ *          socket, without paying the cost of loading the dataset for every batch of queries.
+ *
+ *          Clients send one query per line, with the same syntax as in query files. For every
+ *          query, the server replies with a line containing the number of lines in the query's
+ *          output (or `-1`, if the query is invalid or couldn't be executed), followed by those
+ *          lines. Queries in the same connection are answered in order.
+ *
+ *          Clients that send many queries can use a binary protocol instead, by starting the
+ *          connection with ::SERVER_MODE_BINARY_MAGIC (which the server sends back). Every request
+ *          and reply is then a frame prefixed by its size, and arguments are sent one by one, so
+ *          they don't need to be quoted and tokenized. Up to ::SERVER_MODE_MAX_PIPELINE requests
+ *          per connection are executed at the same time, without waiting for previous replies,
+ *          and replies are sent as soon as they're ready (in any order). Replies can be compressed
+ *          in the LZ4 block format (see [lz4_block](@ref lz4_block.h)), to save bandwidth on
+ *          queries with large outputs. All integers are little-endian:
+ *
+ *          | Request field | Type    | Description                                              |
+ *          | ------------- | ------- | -------------------------------------------------------- |
+ *          | Size          | `u32`   | Number of bytes in the frame, after this field           |
+ *          | Identifier    | `u32`   | Chosen by the client, and repeated in the reply          |
+ *          | Query         | `u8`    | Number of the query                                      |
+ *          | Flags         | `u8`    | Bitwise OR of ::server_mode_request_flags_t values       |
+ *          | Arguments     | `u8`    | Number of arguments                                      |
+ *          | Offset        | `u64`   | Results to skip (see ::query_instance_set_page)          |
+ *          | Limit         | `u64`   | Maximum number of results, or `UINT64_MAX` for no limit  |
+ *          | Argument      | `u16`   | Length of an argument, followed by its bytes and a `\0`  |
+ *
+ *          | Reply field   | Type    | Description                                              |
+ *          | ------------- | ------- | -------------------------------------------------------- |
+ *          | Size          | `u32`   | Number of bytes in the frame, after this field           |
+ *          | Identifier    | `u32`   | Identifier of the request being replied to               |
+ *          | Status        | `u8`    | `0` on success, `1` for invalid or failed queries        |
+ *          | Encoding      | `u8`    | A ::server_mode_reply_encoding_t                         |
+ *          | Lines         | `u32`   | Number of lines in the query's output                    |
+ *          | Length        | `u32`   | Size of the payload, once decompressed                   |
+ *          | Payload       | `u8[]`  | Output lines, each terminated by `\n`                    |
+ *
+ *          Malformed frames (too large, or ending before their size) close the connection.
+ *
+ *          All connections are handled by a single thread, using `epoll`, that hands queries to a
+ *          pool of worker threads (one per processor). This way, idle clients don't occupy worker
+ *          threads, and the number of clients doesn't limit how many queries run concurrently.
+ *
+ *          Queries are queued in two priority classes, so that heavy queries (ones that need
+ *          statistical data, and query types that recently took over a millisecond on average)
+ *          don't starve light lookups. Workers always take light queries first, a quarter
+ *          of them only take light queries, and heavy queries execute waiting light ones at block
+ *          boundaries (see ::cancellation_yield_callback_t). This way, the latency of light
+ *          queries stays flat while analytics run.
+ *
+ *          Queries that need statistical data (e.g.: query 8), sent by different clients within
+ *          a short window of time, are executed together in a batch. This way, statistical data is
+ *          generated once for all queries of the same type, as in batch mode.
+ *
+ *          The outputs of popular queries are kept in memory (see
+ *          [query_output_cache](@ref query_output_cache.h)), so that repeated queries (e.g.: the
+ *          same user looked up by many clients) are answered without touching the database. The
+ *          cache is emptied when the dataset is reloaded.
+ *
+ *          Optionally, live metrics (queries per type, latencies, cache hit rates, memory usage)
+ *          are served over HTTP, by the same event loop, to be scraped by Prometheus. Queries can
+ *          also be recorded with their arrival times (see [workload](@ref workload.h)), to be
+ *          replayed later by [load mode](@ref load_mode.h).
+ *
+ *          Sending `SIGHUP` to the server reloads the dataset in the background. Queries keep
+ *          being answered with the old database until the new one is loaded, and the old database
+ *          is only freed once no query is reading it (see [epoch](@ref epoch.h)).
+ *
+ * @anchor server_mode_examples
+ * ### Examples
+ *
+ * Start the server with `./programa-principal -s dataset /tmp/li3.sock`. Then, using a tool like
+ * `socat`, queries can be sent in the shell:
+ *
+ * ```bash
+ * $ printf '1 Book0000000001\n' | socat - UNIX-CONNECT:/tmp/li3.sock
+ * 1
+ * HTL1001;Hotel Ibis;3;2023/10/01;2023/10/04;False;3;180.000
+ * ```
+ *
+ * Started with `./programa-principal -s dataset /tmp/li3.sock 1000 9100`, the server also serves
+ * metrics on `http://127.0.0.1:9100/metrics`. Adding `workload.txt` after the port records all
+ * received queries to that file.
+ */
+
+#ifndef SERVER_MODE_H
+#define SERVER_MODE_H
+
+/** @brief Default time (in microseconds) to wait for queries to join a batch. */
+#define SERVER_MODE_DEFAULT_BATCH_WINDOW 1000
+
+/** @brief First bytes sent by clients (and echoed by the server) to use the binary protocol. */
+#define SERVER_MODE_BINARY_MAGIC "LI3B"
+
+/** @brief Maximum number of requests of a binary connection being executed at the same time. */
+#define SERVER_MODE_MAX_PIPELINE 64
+
+/** @brief Maximum number of arguments in a request of the binary protocol. */
+#define SERVER_MODE_MAX_ARGUMENTS 32
+
+/** @brief Flags of a request in the binary protocol (see server_mode.h). */
+typedef enum {
+    SERVER_MODE_REQUEST_FORMATTED   = 1, /**< Formatted output, like `F` in a text query. */
+    SERVER_MODE_REQUEST_APPROXIMATE = 2, /**< Approximate output, like `A` in a text query. */
+    SERVER_MODE_REQUEST_COMPRESS    = 4  /**< The reply's payload may be compressed. */
+} server_mode_request_flags_t;
+
+/** @brief Encoding of the payload of a reply in the binary protocol (see server_mode.h). */
+typedef enum {
+    SERVER_MODE_REPLY_ENCODING_RAW, /**< Output lines as-is. */
+    SERVER_MODE_REPLY_ENCODING_LZ4  /**< Output lines compressed in the LZ4 block format. */
+} server_mode_reply_encoding_t;
+
+/**
+ * @brief   Starts server mode.
+ * @details Returns after `SIGINT` or `SIGTERM` is received, once all connected clients have
+ *          disconnected. `SIGHUP` reloads the dataset from @p dataset_dir.
+ *
+ * @param dataset_dir   Path to the directory containing the dataset.
+ * @param cache_dir     Path to the directory where a snapshot of the database is kept, to speed up
+ *                      future loads of the same dataset. `NULL` disables snapshots.
+ * @param socket_path   Path where to create the Unix domain socket. It mustn't exist.
+ * @param batch_window  Time (in microseconds) to wait for other clients' queries, before executing
+ *                      a batch of queries that need statistical data. `0` disables batching.
+ * @param metrics_port  TCP port (on `127.0.0.1`) where to serve live metrics over HTTP, in
+ *                      Prometheus' text format (see [live_metrics](@ref live_metrics.h)). `0`
+ *                      disables the metrics endpoint.
+ * @param workload_path Path to the file where to record received queries (see
+ *                      [workload](@ref workload.h)). `NULL` disables recording.
+ *
+ * @retval 0 Success.
+ * @retval 1 Fatal failure (allocation / socket / file IO errors). A message will also be printed
+ *           to `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref server_mode_examples).
+ */
+int server_mode_run(const char    *dataset_dir,
+                    const char    *cache_dir,
+                    const char    *socket_path,
+                    unsigned long  batch_window,
+                    unsigned short metrics_port,
+                    const char    *workload_path);
+
+#endif
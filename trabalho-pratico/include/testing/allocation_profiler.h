@@ -0,0 +1,164 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    allocation_profiler.h
+ * @brief   Counts heap allocations made in each phase of the program.
+ * @details Differences in the size of the process, measured by performance events, don't show
+ *          how many allocations were made, nor memory that was allocated and freed within a single
+ *          phase. This profiler counts every call to `malloc`,
+ *          `calloc`, `realloc`, aligned allocation functions and `free`, including those made by
+ *          libraries (e.g.: GLib), attributing them to the phase the program said it was in (see
+ *          ::allocation_profiler_set_phase).
+ *
+ *          Allocations are only seen in programs linked with src/testing/allocation_hooks.c, that
+ *          replaces the C library's allocation functions. In other programs,
+ *          ::allocation_profiler_start always fails, and nothing else is affected.
+ *
+ *          Counters are updated atomically, so allocations in multiple threads are all counted.
+ *          However, there's a single current phase for the whole process, so parallel work should
+ *          only be profiled when all threads are working in the same phase.
+ *
+ * @anchor allocation_profiler_examples
+ * ### Examples
+ *
+ * ```c
+ * allocation_profiler_t *profiler = allocation_profiler_start(2);
+ * if (!profiler)
+ *     return 1; // Not linked with allocation hooks
+ *
+ * allocation_profiler_set_phase(profiler, 1); // Phase 0 is everything outside other phases
+ * do_work();
+ * allocation_profiler_set_phase(profiler, 0);
+ *
+ * allocation_profiler_stop(profiler);
+ *
+ * allocation_profiler_counts_t counts;
+ * allocation_profiler_get_counts(profiler, 1, &counts);
+ * printf("%" PRIu64 " allocations, %" PRIu64 " bytes\n", counts.allocations, counts.bytes);
+ * allocation_profiler_free(profiler);
+ * ```
+ */
+
+#ifndef ALLOCATION_PROFILER_H
+#define ALLOCATION_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Counts heap allocations made in each phase of the program. */
+typedef struct allocation_profiler allocation_profiler_t;
+
+/**
+ * @struct allocation_profiler_counts_t
+ * @brief  Allocations made in a phase of the program.
+ *
+ * @var allocation_profiler_counts_t::allocations
+ *     @brief Number of allocations (a `realloc` counts as an allocation and a `free`).
+ * @var allocation_profiler_counts_t::frees
+ *     @brief Number of blocks freed.
+ * @var allocation_profiler_counts_t::bytes
+ *     @brief Total number of bytes allocated (usable size of every block).
+ * @var allocation_profiler_counts_t::peak_live_bytes
+ *     @brief Maximum growth of the bytes allocated and not yet freed in the whole process, since
+ *            the phase was entered.
+ */
+typedef struct {
+    uint64_t allocations, frees, bytes, peak_live_bytes;
+} allocation_profiler_counts_t;
+
+/**
+ * @brief   Starts counting allocations.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::allocation_profiler_free, after calling ::allocation_profiler_stop. The program starts
+ *          in phase `0`.
+ *
+ * @param nphases Number of phases allocations are attributed to, including phase `0`.
+ *
+ * @return The new profiler, or `NULL` on failure (allocation failure, another profiler already
+ *         running, or the program not being linked with allocation hooks).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref allocation_profiler_examples).
+ */
+allocation_profiler_t *allocation_profiler_start(size_t nphases);
+
+/**
+ * @brief Sets what phase the program is in, to attribute the following allocations to.
+ *
+ * @param profiler Profiler to be modified. Can be `NULL`, for nothing to be done.
+ * @param phase    New phase, less than the number of phases in ::allocation_profiler_start.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref allocation_profiler_examples).
+ */
+void allocation_profiler_set_phase(allocation_profiler_t *profiler, size_t phase);
+
+/**
+ * @brief Stops counting allocations.
+ * @param profiler Running profiler.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref allocation_profiler_examples).
+ */
+void allocation_profiler_stop(allocation_profiler_t *profiler);
+
+/**
+ * @brief Gets the allocations made in a phase of the program.
+ *
+ * @param profiler Profiler to get counts from.
+ * @param phase    Phase to get counts for.
+ * @param out      Where to write the counts to.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref allocation_profiler_examples).
+ */
+void allocation_profiler_get_counts(const allocation_profiler_t  *profiler,
+                                    size_t                        phase,
+                                    allocation_profiler_counts_t *out);
+
+/**
+ * @brief Frees memory used by an allocation profiler.
+ * @param profiler Profiler to be `free`d. Must not be running.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref allocation_profiler_examples).
+ */
+void allocation_profiler_free(allocation_profiler_t *profiler);
+
+/**
+ * @brief   Marks allocation functions as replaced by ones that count allocations.
+ * @details Only to be called by src/testing/allocation_hooks.c.
+ */
+void allocation_profiler_enable_hooks(void);
+
+/**
+ * @brief   Counts an allocation in the current phase.
+ * @details Only to be called by src/testing/allocation_hooks.c. Must not allocate memory.
+ *
+ * @param bytes Usable size of the allocated block.
+ */
+void allocation_profiler_count_allocation(size_t bytes);
+
+/**
+ * @brief   Counts a block being freed in the current phase.
+ * @details Only to be called by src/testing/allocation_hooks.c. Must not allocate memory.
+ *
+ * @param bytes Usable size of the freed block.
+ */
+void allocation_profiler_count_free(size_t bytes);
+
+#endif
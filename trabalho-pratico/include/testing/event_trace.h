@@ -0,0 +1,159 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    event_trace.h
+ * @brief   Timeline of what every thread was doing, in Chrome's trace event format.
+ * @details While a trace is running, code marks the beginning and the end of interesting spans of
+ *          work (dataset loading steps, statistical data generation, query execution, output
+ *          writing, ...) with ::event_trace_begin and ::event_trace_end. Each thread records its
+ *          events into its own preallocated buffer, without any locking, so the cost of an event
+ *          is reading the clock and a few stores. When no trace is running, both methods return
+ *          right away.
+ *
+ *          After the trace is stopped, it can be written as JSON in Chrome's trace event format,
+ *          to be opened in `chrome://tracing` or [Perfetto](https://ui.perfetto.dev), where spans
+ *          of different threads can be seen side by side.
+ *
+ *          Only one trace can run at a time, as the places where events are recorded are spread
+ *          throughout the program.
+ *
+ * @anchor event_trace_examples
+ * ### Examples
+ *
+ * ```c
+ * event_trace_t *trace = event_trace_start(0);
+ * if (!trace)
+ *     return 1;
+ *
+ * event_trace_begin("statistics", "query", 3); // Shown as "query 3"
+ * do_work();
+ * event_trace_end();
+ *
+ * event_trace_stop(trace);
+ * event_trace_write_json(trace, stdout);
+ * event_trace_free(trace);
+ * ```
+ */
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/** @brief Timeline of what every thread was doing. */
+typedef struct event_trace event_trace_t;
+
+/** @brief Default maximum number of events recorded by each thread, in ::event_trace_start. */
+#define EVENT_TRACE_DEFAULT_MAX_EVENTS 65536
+
+/**
+ * @brief   Starts recording events from all threads.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::event_trace_free, after calling ::event_trace_stop. Buffers are only allocated for
+ *          threads that record events.
+ *
+ * @param max_events Number of events to allocate space for, in each thread. Once full, further
+ *                   events are only counted as dropped. `0` for ::EVENT_TRACE_DEFAULT_MAX_EVENTS.
+ *
+ * @return The new trace, or `NULL` on failure (allocation failure, or another trace already
+ *         running).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref event_trace_examples).
+ */
+event_trace_t *event_trace_start(size_t max_events);
+
+/**
+ * @brief   Marks the beginning of a span of work in the calling thread.
+ * @details Must be followed by ::event_trace_end in the same thread. Spans can be nested.
+ *
+ * @param category Category of the span (e.g.: `"dataset"`). Must be valid while the trace exists
+ *                 (preferably, a string literal).
+ * @param name     Name of the span (e.g.: `"users"`). Must be valid while the trace exists.
+ * @param number   Number appended to @p name (e.g.: a query type), or `0` for none.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref event_trace_examples).
+ */
+void event_trace_begin(const char *category, const char *name, size_t number);
+
+/**
+ * @brief Marks the end of the last span of work started by the calling thread.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref event_trace_examples).
+ */
+void event_trace_end(void);
+
+/**
+ * @brief   Stops recording events.
+ * @details Threads that may still be recording events must have finished before the trace is
+ *          written or `free`d.
+ *
+ * @param trace Running trace.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref event_trace_examples).
+ */
+void event_trace_stop(event_trace_t *trace);
+
+/**
+ * @brief  Gets the number of events recorded in a trace.
+ * @param  trace   Trace to get the number of events from.
+ * @param  dropped Where to output the number of events that didn't fit in the trace to. Can be
+ *                 `NULL`.
+ * @return The number of recorded events, from all threads.
+ */
+size_t event_trace_get_event_count(const event_trace_t *trace, size_t *dropped);
+
+/**
+ * @brief   Writes the events of a stopped trace in Chrome's trace event format (JSON).
+ * @details Each thread is identified by the order in which it recorded its first event.
+ *
+ * @param trace  Stopped trace.
+ * @param output Where to write the trace to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO error.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref event_trace_examples).
+ */
+int event_trace_write_json(const event_trace_t *trace, FILE *output);
+
+/**
+ * @brief Writes the events of a stopped trace to a file, in Chrome's trace event format (JSON).
+ *
+ * @param trace Stopped trace.
+ * @param path  Path to the file to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO error.
+ */
+int event_trace_write_file(const event_trace_t *trace, const char *path);
+
+/**
+ * @brief Frees memory used by a trace.
+ * @param trace Trace to be `free`d. Must not be running.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref event_trace_examples).
+ */
+void event_trace_free(event_trace_t *trace);
+
+#endif
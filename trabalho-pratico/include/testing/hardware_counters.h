@@ -0,0 +1,143 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    hardware_counters.h
+ * @brief   Hardware performance counters (cycles, cache misses, ...) of the current process.
+ * @details Counters are opened with `perf_event_open`, as a single group, so that all of them are
+ *          scheduled onto the CPU's performance monitoring unit together and ratios between them
+ *          (e.g.: instructions per cycle) are meaningful. Threads created after the counters are
+ *          opened are also counted.
+ *
+ *          Counters are always running: to measure a task, read them before and after it, and
+ *          subtract the values (see ::hardware_counters_values_subtract).
+ *
+ *          Opening counters fails when they're not supported (e.g.: in virtual machines) or not
+ *          allowed (see `/proc/sys/kernel/perf_event_paranoid`). This is to be expected, and
+ *          callers should do without them.
+ *
+ * @anchor hardware_counters_examples
+ * ### Examples
+ *
+ * ```c
+ * hardware_counters_t *counters = hardware_counters_open();
+ * if (!counters) {
+ *     fputs("Hardware counters not available!\n", stderr);
+ *     return 1;
+ * }
+ *
+ * hardware_counters_values_t before, after;
+ * hardware_counters_read(counters, &before);
+ * do_work();
+ * hardware_counters_read(counters, &after);
+ * hardware_counters_values_subtract(&after, &before);
+ *
+ * printf("IPC: %.2lf\n",
+ *        (double) after.values[HARDWARE_COUNTER_INSTRUCTIONS] /
+ *            after.values[HARDWARE_COUNTER_CYCLES]);
+ * hardware_counters_close(counters);
+ * ```
+ */
+
+#ifndef HARDWARE_COUNTERS_H
+#define HARDWARE_COUNTERS_H
+
+#include <stdint.h>
+
+/** @brief A hardware event that can be counted. */
+typedef enum {
+    HARDWARE_COUNTER_CYCLES,        /**< @brief CPU cycles. */
+    HARDWARE_COUNTER_INSTRUCTIONS,  /**< @brief Retired instructions. */
+    HARDWARE_COUNTER_CACHE_MISSES,  /**< @brief Misses in the last level cache. */
+    HARDWARE_COUNTER_BRANCH_MISSES, /**< @brief Mispredicted branches. */
+    HARDWARE_COUNTER_LLC_LOADS,     /**< @brief Loads that reached the last level cache. */
+    HARDWARE_COUNTER_COUNT,         /**< @brief Number of counters (not a counter). */
+} hardware_counter_t;
+
+/** @brief A set of open hardware counters. */
+typedef struct hardware_counters hardware_counters_t;
+
+/**
+ * @struct hardware_counters_values_t
+ * @brief  Values of all counters in a ::hardware_counters_t at some point in time (or differences
+ *         between two points in time).
+ *
+ * @var hardware_counters_values_t::values
+ *     @brief Value of each counter, indexed by ::hardware_counter_t. Values are scaled when the
+ *            kernel had to multiplex counters.
+ */
+typedef struct {
+    uint64_t values[HARDWARE_COUNTER_COUNT];
+} hardware_counters_values_t;
+
+/**
+ * @brief   Opens and starts all hardware counters for the current process.
+ * @details The returned value is owned by the caller, and should be closed with
+ *          ::hardware_counters_close.
+ *
+ * @return The open counters, or `NULL` if they aren't available.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref hardware_counters_examples).
+ */
+hardware_counters_t *hardware_counters_open(void);
+
+/**
+ * @brief Reads the current values of a set of hardware counters.
+ *
+ * @param counters Counters to be read.
+ * @param output   Where to write the values of the counters to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure (@p output is left with unspecified values).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref hardware_counters_examples).
+ */
+int hardware_counters_read(const hardware_counters_t *counters, hardware_counters_values_t *output);
+
+/**
+ * @brief Subtracts a set of counter values from another one.
+ *
+ * @param values  Values to be subtracted from, and where the result is written to.
+ * @param earlier Values read before @p values.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref hardware_counters_examples).
+ */
+void hardware_counters_values_subtract(hardware_counters_values_t       *values,
+                                       const hardware_counters_values_t *earlier);
+
+/**
+ * @brief Adds a set of counter values to another one.
+ *
+ * @param values Values to be added to, and where the result is written to.
+ * @param other  Values to add to @p values.
+ */
+void hardware_counters_values_add(hardware_counters_values_t       *values,
+                                  const hardware_counters_values_t *other);
+
+/**
+ * @brief Stops and closes a set of hardware counters.
+ * @param counters Counters to be closed.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref hardware_counters_examples).
+ */
+void hardware_counters_close(hardware_counters_t *counters);
+
+#endif
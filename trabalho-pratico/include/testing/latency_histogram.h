@@ -0,0 +1,137 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    latency_histogram.h
+ * @brief   A fixed-size histogram of latencies, from which percentiles can be calculated.
+ * @details Buckets are log-linear (as in HdrHistogram): values under
+ *          ::LATENCY_HISTOGRAM_SUB_BUCKETS are counted exactly, and larger values are grouped in
+ *          buckets whose width is, at most, `1 / 64` of their lower bound. Recording a value is
+ *          `O(1)` and the histogram never grows, so it can be used even when too many values are
+ *          recorded for all of them to be kept.
+ *
+ * @anchor latency_histogram_examples
+ * ### Examples
+ *
+ * ```c
+ * latency_histogram_t *histogram = latency_histogram_create();
+ * if (!histogram)
+ *     return 1;
+ *
+ * for (uint64_t i = 1; i <= 1000; ++i)
+ *     latency_histogram_record(histogram, i);
+ *
+ * printf("p50: %" PRIu64 "\n", latency_histogram_get_percentile(histogram, 50.0));
+ * printf("p99: %" PRIu64 "\n", latency_histogram_get_percentile(histogram, 99.0));
+ * printf("max: %" PRIu64 "\n", latency_histogram_get_max(histogram));
+ * latency_histogram_free(histogram);
+ * ```
+ *
+ * The percentiles printed are upper bounds of the buckets containing them (`503` and `991`), while
+ * the maximum is exact (`1000`).
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+/** @brief A fixed-size histogram of latencies. */
+typedef struct latency_histogram latency_histogram_t;
+
+/** @brief Number of values counted exactly, and number of buckets per power of two times two. */
+#define LATENCY_HISTOGRAM_SUB_BUCKETS 128
+
+/**
+ * @brief   Creates a new empty histogram.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::latency_histogram_free.
+ *
+ * @return The new histogram, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref latency_histogram_examples).
+ */
+latency_histogram_t *latency_histogram_create(void);
+
+/**
+ * @brief  Creates a deep clone of a histogram.
+ * @param  histogram Histogram to be cloned.
+ * @return A new histogram, that must be deleted using ::latency_histogram_free, or `NULL` on
+ *         allocation failure.
+ */
+latency_histogram_t *latency_histogram_clone(const latency_histogram_t *histogram);
+
+/**
+ * @brief Adds a value to a histogram.
+ *
+ * @param histogram Histogram to be modified.
+ * @param value     Value (e.g.: a time in microseconds) to be recorded.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref latency_histogram_examples).
+ */
+void latency_histogram_record(latency_histogram_t *histogram, uint64_t value);
+
+/**
+ * @brief  Gets the number of values recorded in a histogram.
+ * @param  histogram Histogram to get the number of values from.
+ * @return The number of values recorded in @p histogram.
+ */
+uint64_t latency_histogram_get_count(const latency_histogram_t *histogram);
+
+/**
+ * @brief  Gets the sum of all values recorded in a histogram.
+ * @param  histogram Histogram to get the sum of values from.
+ * @return The exact sum of all values recorded in @p histogram.
+ */
+uint64_t latency_histogram_get_total(const latency_histogram_t *histogram);
+
+/**
+ * @brief  Gets the highest value recorded in a histogram.
+ * @param  histogram Histogram to get the maximum from.
+ * @return The exact highest value recorded in @p histogram, or `0` if it's empty.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref latency_histogram_examples).
+ */
+uint64_t latency_histogram_get_max(const latency_histogram_t *histogram);
+
+/**
+ * @brief Gets a percentile of the values recorded in a histogram.
+ *
+ * @param histogram  Histogram to get the percentile from.
+ * @param percentile Percentile to calculate, between `0.0` and `100.0` (e.g.: `99.9`).
+ *
+ * @return The upper bound of the bucket containing the value at @p percentile (never greater
+ *         than ::latency_histogram_get_max), or `0` if @p histogram is empty.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref latency_histogram_examples).
+ */
+uint64_t latency_histogram_get_percentile(const latency_histogram_t *histogram, double percentile);
+
+/**
+ * @brief Frees memory used by a histogram.
+ * @param histogram Histogram to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref latency_histogram_examples).
+ */
+void latency_histogram_free(latency_histogram_t *histogram);
+
+#endif
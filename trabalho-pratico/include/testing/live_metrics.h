@@ -0,0 +1,169 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    live_metrics.h
+ * @brief   Counters of a long-running program, exported in Prometheus' text format.
+ * @details Unlike ::performance_metrics_t, measured once for the whole program, these counters are
+ *          updated while the program runs, and can be read at any time (e.g.: by an HTTP endpoint
+ *          scraped by Prometheus).
+ *
+ *          Every thread that executes queries records them in its own ::live_metrics_shard_t,
+ *          with no locks or atomic read-modify-write operations. Reading the metrics adds up the
+ *          values in all shards. Other values (e.g.: memory usage) are set as a whole, with
+ *          ::live_metrics_set_value.
+ *
+ * @anchor live_metrics_examples
+ * ### Examples
+ *
+ * ```c
+ * live_metrics_t       *metrics = live_metrics_create();
+ * live_metrics_shard_t *shard   = live_metrics_add_shard(metrics); // Once per thread
+ *
+ * live_metrics_shard_record_query(shard, 1, 250, 0); // Query 1 took 250us and didn't fail
+ * live_metrics_set_value(metrics, LIVE_METRICS_VALUE_CONNECTIONS, 3);
+ *
+ * GString *text = g_string_new("");
+ * live_metrics_write_prometheus(metrics, text);
+ * ```
+ *
+ * The output (abbreviated) looks like:
+ *
+ * ```
+ * # HELP li3_queries_total Number of queries executed.
+ * # TYPE li3_queries_total counter
+ * li3_queries_total{type="1"} 1
+ * ...
+ * # TYPE li3_query_latency_seconds histogram
+ * li3_query_latency_seconds_bucket{type="1",le="0.000256"} 1
+ * ...
+ * li3_connections 3
+ * ```
+ */
+
+#ifndef LIVE_METRICS_H
+#define LIVE_METRICS_H
+
+#include <glib.h>
+#include <stdint.h>
+
+/** @brief Counters of a long-running program. */
+typedef struct live_metrics live_metrics_t;
+
+/** @brief Counters updated by a single thread, that are part of a ::live_metrics_t. */
+typedef struct live_metrics_shard live_metrics_shard_t;
+
+/**
+ * @brief   Number of buckets in query latency histograms (excluding `+Inf`).
+ * @details The upper bound of bucket `i` is `2^i` microseconds, up to about 16 seconds.
+ */
+#define LIVE_METRICS_LATENCY_BUCKETS 25
+
+/** @brief Values in a ::live_metrics_t that aren't counted by each thread. */
+typedef enum {
+    LIVE_METRICS_VALUE_CONNECTIONS,         /**< @brief Number of connected clients. */
+    LIVE_METRICS_VALUE_CACHE_HITS,          /**< @brief Statistical data found in the cache. */
+    LIVE_METRICS_VALUE_CACHE_MISSES,        /**< @brief Statistical data not in the cache. */
+    LIVE_METRICS_VALUE_USERS,               /**< @brief Number of users loaded. */
+    LIVE_METRICS_VALUE_FLIGHTS,             /**< @brief Number of flights loaded. */
+    LIVE_METRICS_VALUE_RESERVATIONS,        /**< @brief Number of reservations loaded. */
+    LIVE_METRICS_VALUE_USERS_MEMORY,        /**< @brief Bytes allocated for users. */
+    LIVE_METRICS_VALUE_FLIGHTS_MEMORY,      /**< @brief Bytes allocated for flights. */
+    LIVE_METRICS_VALUE_RESERVATIONS_MEMORY, /**< @brief Bytes allocated for reservations. */
+    LIVE_METRICS_VALUE_LOAD_TIME,           /**< @brief Time taken to load the dataset, in us. */
+    LIVE_METRICS_VALUE_OUTPUT_CACHE_MEMORY, /**< @brief Bytes used by cached query outputs. */
+    LIVE_METRICS_VALUE_COUNT                /**< @brief Number of values. */
+} live_metrics_value_t;
+
+/**
+ * @brief   Creates a new set of metrics, where everything is `0`.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::live_metrics_free.
+ *
+ * @return The new metrics, or `NULL` on allocation failure.
+ */
+live_metrics_t *live_metrics_create(void);
+
+/**
+ * @brief   Creates the counters of a thread.
+ * @details This takes a lock, so it should be done once per thread, before recording anything.
+ *
+ * @param metrics Metrics the shard is part of, that owns it.
+ *
+ * @return The new shard, valid until @p metrics is `free`d, or `NULL` on allocation failure.
+ */
+live_metrics_shard_t *live_metrics_add_shard(live_metrics_t *metrics);
+
+/**
+ * @brief   Records the execution of a query.
+ * @details Must only be called from the thread that owns @p shard.
+ *
+ * @param shard       Counters of the calling thread.
+ * @param type_number Type of the executed query (`1` to ::QUERY_TYPE_LIST_COUNT). `0` for invalid
+ *                    queries, that couldn't be parsed.
+ * @param latency     Time taken to execute the query, in microseconds.
+ * @param failed      Whether the query failed to execute.
+ */
+void live_metrics_shard_record_query(live_metrics_shard_t *shard,
+                                     size_t                type_number,
+                                     uint64_t              latency,
+                                     int                   failed);
+
+/**
+ * @brief   Records a lookup of a query's output in a cache of outputs.
+ * @details Must only be called from the thread that owns @p shard. Queries answered from the cache
+ *          must still be recorded with ::live_metrics_shard_record_query.
+ *
+ * @param shard       Counters of the calling thread.
+ * @param type_number Type of the looked up query (`1` to ::QUERY_TYPE_LIST_COUNT).
+ * @param hit         Whether the output was found in the cache.
+ */
+void live_metrics_shard_record_output_cache(live_metrics_shard_t *shard,
+                                            size_t                type_number,
+                                            int                   hit);
+
+/**
+ * @brief   Sets a value in a set of metrics.
+ * @details Can be called from any thread, but concurrent calls for the same value must be
+ *          serialized by the caller.
+ *
+ * @param metrics Metrics to be modified.
+ * @param value   Which value to set.
+ * @param number  New value.
+ */
+void live_metrics_set_value(live_metrics_t *metrics, live_metrics_value_t value, uint64_t number);
+
+/**
+ * @brief   Writes all metrics in Prometheus' text exposition format.
+ * @details Can be called while other threads record data. Values from different shards may not be
+ *          a consistent snapshot, but every counter is monotonic.
+ *
+ * @param metrics Metrics to be written.
+ * @param output  Where to append the text to.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref live_metrics_examples).
+ */
+void live_metrics_write_prometheus(live_metrics_t *metrics, GString *output);
+
+/**
+ * @brief Frees memory used by a set of metrics, and all of its shards.
+ * @param metrics Metrics to be `free`d.
+ */
+void live_metrics_free(live_metrics_t *metrics);
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    metrics_comparison.h
+ * @brief   Comparison of metrics exported from two builds, for regression detection.
+ * @details Reads CSV files written by [metrics_export](@ref metrics_export.h) (e.g.: with
+ *          `./programa-testes ... --csv file`), from repeated runs of a baseline build and of a
+ *          candidate build. The times and memory usage of dataset steps, per-type statistical data
+ *          generation, latency percentiles and totals, hardware counters and the peak memory of the
+ *          program are compared, using Welch's t-test (at a 95 % confidence level) over the runs
+ *          of each build. Per-query execution times and test results aren't compared.
+ *
+ *          For every metric, lower values are considered better. Significant changes are printed
+ *          as regressions and improvements, ranked by their relative change.
+ *
+ * @anchor metrics_comparison_examples
+ * ### Examples
+ *
+ * ```c
+ * metrics_comparison_t *const comparison = metrics_comparison_create();
+ * if (!comparison)
+ *     return 1;
+ *
+ * if (metrics_comparison_add_file(comparison, METRICS_COMPARISON_SIDE_BASELINE, "old1.csv") ||
+ *     metrics_comparison_add_file(comparison, METRICS_COMPARISON_SIDE_BASELINE, "old2.csv") ||
+ *     metrics_comparison_add_file(comparison, METRICS_COMPARISON_SIDE_CANDIDATE, "new1.csv") ||
+ *     metrics_comparison_add_file(comparison, METRICS_COMPARISON_SIDE_CANDIDATE, "new2.csv")) {
+ *
+ *     metrics_comparison_free(comparison);
+ *     return 1;
+ * }
+ *
+ * const size_t nregressions = metrics_comparison_print(stdout, comparison, 0.01);
+ * metrics_comparison_free(comparison);
+ * return nregressions != 0;
+ * ```
+ *
+ * See compare.c for the command-line tool that does this.
+ */
+
+#ifndef METRICS_COMPARISON_H
+#define METRICS_COMPARISON_H
+
+#include <stdio.h>
+
+/** @brief Build a set of exported metrics comes from. */
+typedef enum {
+    METRICS_COMPARISON_SIDE_BASELINE,  /**< @brief The build being compared against. */
+    METRICS_COMPARISON_SIDE_CANDIDATE, /**< @brief The build being evaluated. */
+} metrics_comparison_side_t;
+
+/** @brief Number of values in ::metrics_comparison_side_t. */
+#define METRICS_COMPARISON_SIDE_COUNT 2
+
+/** @brief Exported metrics of two builds, to be compared. */
+typedef struct metrics_comparison metrics_comparison_t;
+
+/**
+ * @brief  Creates an empty comparison, without any runs of either build.
+ * @return A new comparison, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref metrics_comparison_examples).
+ */
+metrics_comparison_t *metrics_comparison_create(void);
+
+/**
+ * @brief Adds the metrics of a run, read from a CSV file, to a comparison.
+ *
+ * @param comparison Comparison to be modified.
+ * @param side       Build the run comes from.
+ * @param path       Path to a file written by ::metrics_export_write_file, in
+ *                   ::METRICS_EXPORT_FORMAT_CSV.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure to read the file, invalid file, or allocation failure. Metrics read before the
+ *           failure are kept in @p comparison.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref metrics_comparison_examples).
+ */
+int metrics_comparison_add_file(metrics_comparison_t     *comparison,
+                                metrics_comparison_side_t side,
+                                const char               *path);
+
+/**
+ * @brief   Prints the regressions and improvements of the candidate build over the baseline.
+ * @details Metrics measured in less than two runs of either build can't be tested for
+ *          significance, so all of their changes larger than @p threshold are printed, marked as
+ *          untested. Metrics missing from either build are ignored.
+ *
+ * @param output     Stream where to print the comparison to.
+ * @param comparison Comparison to be printed.
+ * @param threshold  Minimum relative change (e.g.: `0.01` for 1 %) for a significant change to be
+ *                   printed.
+ *
+ * @return The number of printed regressions.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref metrics_comparison_examples).
+ */
+size_t metrics_comparison_print(FILE                       *output,
+                                const metrics_comparison_t *comparison,
+                                double                      threshold);
+
+/**
+ * @brief Frees memory used by a comparison.
+ * @param comparison Comparison to be deleted.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref metrics_comparison_examples).
+ */
+void metrics_comparison_free(metrics_comparison_t *comparison);
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    metrics_export.h
+ * @brief   Machine-readable export of ::performance_metrics_t and ::test_diff_t.
+ * @details Unlike [performance_metrics_output](@ref performance_metrics_output.h), that formats
+ *          data for humans, this module writes every measurement (with fixed units) in a format
+ *          that can be stored and compared across builds (e.g.: in CI).
+ *
+ *          All times are in microseconds and all memory amounts are in KiB.
+ *
+ * @anchor metrics_export_example
+ * ### Example
+ *
+ * See test.c for usage examples. In JSON, the output looks like:
+ *
+ * ```json
+ * {
+ *   "dataset": [
+ *     {
+ *       "step": "users",
+ *       "event": {"time_us": 51230, "memory_kib": 10240},
+ *       "phases": {"io_us": 2010, "tokenize_us": 9120, "validate_us": 30400, "commit_us": 0,
+ *                  "bytes": 16780000, "rows": 100001, "rejected_rows": 4820}
+ *     },
+ *     ...
+ *   ],
+ *   "queries": [
+ *     {
+ *       "type": 1,
+ *       "statistics": null,
+ *       "latency": {"count": 50, "total_us": 120, "p50_us": 2, "p90_us": 4, "p99_us": 9,
+ *                   "p99_9_us": 9, "max_us": 9},
+ *       "executions": [{"line": 1, "time_us": 3}, ...]
+ *     },
+ *     ...
+ *   ],
+ *   "program": {"time_us": 1502310, "peak_memory_kib": 5300000},
+ *   "diff": {"extra_files": [], "missing_files": [], "errors": [{"file": "...", "line": 3}]}
+ * }
+ * ```
+ *
+ * In CSV, every measurement is a row, with the columns `section,name,line,metric,value` (e.g.:
+ * `query,1,10,time_us,3`, or `dataset,users,,memory_kib,10240`).
+ */
+
+#ifndef METRICS_EXPORT_H
+#define METRICS_EXPORT_H
+
+#include <stdio.h>
+
+#include "testing/performance_metrics.h"
+#include "testing/test_diff.h"
+
+/** @brief Format to export metrics in. */
+typedef enum {
+    METRICS_EXPORT_FORMAT_JSON, /**< @brief A single JSON object. */
+    METRICS_EXPORT_FORMAT_CSV,  /**< @brief CSV with one measurement per row (and a header). */
+} metrics_export_format_t;
+
+/**
+ * @brief Writes performance metrics and test results in a machine-readable format.
+ *
+ * @param output  Stream where to write the exported data to.
+ * @param format  Format of the exported data.
+ * @param metrics Performance metrics to be exported. Must have been measured with
+ *                ::performance_metrics_measure_whole_program.
+ * @param diff    Test results to be exported. Can be `NULL`, for them not to be exported.
+ *
+ * @retval 0 Success.
+ * @retval 1 Output or allocation failure.
+ */
+int metrics_export_write(FILE                        *output,
+                         metrics_export_format_t      format,
+                         const performance_metrics_t *metrics,
+                         const test_diff_t           *diff);
+
+/**
+ * @brief Writes performance metrics and test results in a machine-readable format to a file.
+ *
+ * @param path    Path to the file to be created (or overwritten).
+ * @param format  Format of the exported data.
+ * @param metrics Performance metrics to be exported.
+ * @param diff    Test results to be exported. Can be `NULL`, for them not to be exported.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure to open or write to the file, or allocation failure.
+ */
+int metrics_export_write_file(const char                  *path,
+                              metrics_export_format_t      format,
+                              const performance_metrics_t *metrics,
+                              const test_diff_t           *diff);
+
+#endif
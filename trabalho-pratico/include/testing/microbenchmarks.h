@@ -0,0 +1,73 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    microbenchmarks.h
+ * @brief   Isolated benchmarks of the primitives in `utils` that the loaders and queries rely on.
+ * @details Each benchmark runs one operation (e.g.: allocating an item in a ::pool_t, parsing a
+ *          date) `n` times, for several values of `n`, and reports the time per operation and the
+ *          memory per operation. Only the operations themselves are timed: generating their inputs
+ *          is not.
+ *
+ *          Small sizes are repeated until at least a million operations are run, so that the time
+ *          measurements (in microseconds) are precise. The best of all repetitions is reported,
+ *          as noise can only make a benchmark slower. Memory is measured once per size, as the
+ *          difference in virtual memory (page granularity) while running the operations, so it's
+ *          only meaningful for large sizes.
+ *
+ * @anchor microbenchmarks_examples
+ * ### Examples
+ *
+ * Run every benchmark with `make microbenchmark`, or only the ones whose names contain a string
+ * with `./programa-microbenchmark -f hash -r 10`. See microbenchmark.c for all options.
+ */
+
+#ifndef MICROBENCHMARKS_H
+#define MICROBENCHMARKS_H
+
+#include <stddef.h>
+
+/**
+ * @struct microbenchmarks_options_t
+ * @brief  Configuration of a run of the microbenchmarks.
+ *
+ * @var microbenchmarks_options_t::filter
+ *     @brief Only benchmarks whose names contain this string are run. `NULL` to run all of them.
+ * @var microbenchmarks_options_t::repetitions
+ *     @brief Number of times to measure each benchmark at each size (at least `1`).
+ * @var microbenchmarks_options_t::max_size
+ *     @brief Largest number of operations per benchmark (sizes are powers of ten from `1000`).
+ */
+typedef struct {
+    const char *filter;
+    size_t      repetitions, max_size;
+} microbenchmarks_options_t;
+
+/**
+ * @brief Runs the microbenchmarks and prints their results to `stdout`.
+ *
+ * @param options Configuration of the run.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or measurement failure. A message will also be printed to `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref microbenchmarks_examples).
+ */
+int microbenchmarks_run(const microbenchmarks_options_t *options);
+
+#endif
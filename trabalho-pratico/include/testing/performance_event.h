@@ -15,8 +15,12 @@
  */
 
 /**
- * @file  performance_event.h
- * @brief Information about elapsed time and difference in used memory while running a task.
+ * @file    performance_event.h
+ * @brief   Information about elapsed time and difference in used memory while running a task.
+ * @details Events can be measured in two modes (see ::performance_event_mode_t). The default one
+ *          (::performance_event_start_measuring) is precise, but measuring is slow enough to
+ *          overshadow tiny tasks, such as the execution of a single query. For those, use
+ *          ::performance_event_start_measuring_lightweight.
  *
  * @anchor performance_event_example
  * ### Example
@@ -63,6 +67,30 @@
 /** @brief Information about elapsed time and difference in used memory while running a task. */
 typedef struct performance_event performance_event_t;
 
+/** @brief How a ::performance_event_t is measured. */
+typedef enum {
+    /**
+     * @brief CPU time (user and system) from `getrusage`, and virtual memory size from parsing
+     *        `/proc/self/status`.
+     */
+    PERFORMANCE_EVENT_MODE_RUSAGE,
+
+    /**
+     * @brief Wall-clock time from `CLOCK_MONOTONIC`, and virtual memory size read from an already
+     *        open `/proc/self/statm` (see ::performance_event_open_memory_source).
+     */
+    PERFORMANCE_EVENT_MODE_LIGHTWEIGHT,
+} performance_event_mode_t;
+
+/**
+ * @brief   Opens the file used to sample memory usage in ::PERFORMANCE_EVENT_MODE_LIGHTWEIGHT.
+ * @details Keep this file open for as long as events are measured with it, so that each
+ *          measurement is a single `pread` call. Close it with `close`.
+ *
+ * @return A file descriptor for `/proc/self/statm`, or `-1` on failure.
+ */
+int performance_event_open_memory_source(void);
+
 /**
  * @brief  Starts collecting data to measure the performance of a task.
  * @return A new performance event, that must be deleted with ::performance_event_free, or `NULL` in
@@ -74,7 +102,23 @@ typedef struct performance_event performance_event_t;
 performance_event_t *performance_event_start_measuring(void);
 
 /**
- * @brief  Creates a deep clone of a performance event.
+ * @brief Starts collecting data to measure the performance of a task, in
+ *        ::PERFORMANCE_EVENT_MODE_LIGHTWEIGHT.
+ *
+ * @param memory_source File returned by ::performance_event_open_memory_source, that must remain
+ *                      open until the event is stopped. Can be `-1`, for memory not to be
+ *                      measured (always `0`).
+ *
+ * @return A new performance event, that must be deleted with ::performance_event_free, or `NULL` in
+ *         case of failure (allocation or measurement).
+ */
+performance_event_t *performance_event_start_measuring_lightweight(int memory_source);
+
+/**
+ * @brief   Creates a deep clone of a performance event.
+ * @details In ::PERFORMANCE_EVENT_MODE_LIGHTWEIGHT, the clone uses the same memory source file as
+ *          @p perf.
+ *
  * @param  perf Performance event to be cloned.
  * @return A pointer to a new ::performance_event_t, that must be deleted using
  *         ::performance_event_free. `NULL` is possible on allocation failure.
@@ -93,12 +137,21 @@ performance_event_t *performance_event_clone(const performance_event_t *perf);
  */
 int performance_event_stop_measuring(performance_event_t *perf);
 
+/**
+ * @brief  Gets how a performance event is measured.
+ * @param  perf Performance event to get the measurement mode from.
+ * @return The measurement mode of @p perf.
+ */
+performance_event_mode_t performance_event_get_mode(const performance_event_t *perf);
+
 /**
  * @brief Gets the time it took to run a task, in microseconds.
  * @param perf Performance event to get the elapsed time from. ::performance_event_stop_measuring
  *             must have been called before this method.
  *
- * @return The time that it took to run a task, in microseconds.
+ * @return The time that it took to run a task, in microseconds. This is CPU time in
+ *         ::PERFORMANCE_EVENT_MODE_RUSAGE, and wall-clock time in
+ *         ::PERFORMANCE_EVENT_MODE_LIGHTWEIGHT.
  *
  * #### Examples
  * See [the header file's documentation](@ref performance_event_example).
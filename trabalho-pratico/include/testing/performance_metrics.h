@@ -33,7 +33,14 @@
 #ifndef PERFORMANCE_METRICS_H
 #define PERFORMANCE_METRICS_H
 
+#include "database/database.h"
+#include "dataset/dataset_parser.h"
+#include "queries/query_type_list.h"
+#include "testing/allocation_profiler.h"
+#include "testing/hardware_counters.h"
+#include "testing/latency_histogram.h"
 #include "testing/performance_event.h"
+#include "testing/sampling_profiler.h"
 
 /** @brief Step of loading a dataset, whose performance must be measured. */
 typedef enum {
@@ -41,10 +48,29 @@ typedef enum {
     PERFORMANCE_METRICS_DATASET_STEP_FLIGHTS,      /**< @brief Loading `flights.csv`.       */
     PERFORMANCE_METRICS_DATASET_STEP_PASSENGERS,   /**< @brief Loading `passengers.csv`.    */
     PERFORMANCE_METRICS_DATASET_STEP_RESERVATIONS, /**< @brief Loading `reservations.csv`.  */
+    PERFORMANCE_METRICS_DATASET_STEP_INDEXES,      /**< @brief Building database indices.   */
     PERFORMANCE_METRICS_DATASET_STEP_DONE,         /**< @brief Done loading the dataset.    */
     PERFORMANCE_METRICS_DATASET_STEP_NOT_STARTED,  /**< @brief Not yet loading the dataset. */
 } performance_metrics_dataset_step_t;
 
+/** @brief Number of ::performance_metrics_dataset_step_t that load a file of the dataset. */
+#define PERFORMANCE_METRICS_DATASET_FILE_COUNT PERFORMANCE_METRICS_DATASET_STEP_INDEXES
+
+/**
+ * @brief Number of phases of an allocation profiler attached to performance metrics (see
+ *        ::performance_metrics_set_allocation_profiler).
+ */
+#define PERFORMANCE_METRICS_ALLOCATION_PHASES                                                      \
+    (1 + PERFORMANCE_METRICS_DATASET_STEP_DONE + 2 * QUERY_TYPE_LIST_COUNT)
+
+/** @brief Part of the database whose memory usage is measured. */
+typedef enum {
+    PERFORMANCE_METRICS_STRUCTURE_USERS,        /**< @brief The ::user_manager_t.        */
+    PERFORMANCE_METRICS_STRUCTURE_FLIGHTS,      /**< @brief The ::flight_manager_t.      */
+    PERFORMANCE_METRICS_STRUCTURE_RESERVATIONS, /**< @brief The ::reservation_manager_t. */
+    PERFORMANCE_METRICS_STRUCTURE_COUNT,        /**< @brief Number of structures.        */
+} performance_metrics_structure_t;
+
 /** @brief Performance information about different parts of the application. */
 typedef struct performance_metrics performance_metrics_t;
 
@@ -58,6 +84,19 @@ typedef struct performance_metrics performance_metrics_t;
  */
 performance_metrics_t *performance_metrics_create(void);
 
+/**
+ * @brief   Initializes a set of performance metrics for the whole application, choosing how its
+ *          events are measured.
+ * @details ::performance_metrics_create is the same as calling this method with
+ *          ::PERFORMANCE_EVENT_MODE_RUSAGE.
+ *
+ * @param mode How all events in the new metrics are measured.
+ *
+ * @return A pointer to a new ::performance_metrics_t, that must be deleted using
+ *         ::performance_metrics_free. `NULL` is possible on failure.
+ */
+performance_metrics_t *performance_metrics_create_with_mode(performance_event_mode_t mode);
+
 /**
  * @brief  Creates a deep clone of a ::performance_metrics_t.
  * @param  metrics Performance metrics to be cloned.
@@ -66,6 +105,19 @@ performance_metrics_t *performance_metrics_create(void);
  */
 performance_metrics_t *performance_metrics_clone(const performance_metrics_t *metrics);
 
+/**
+ * @brief   Starts measuring hardware counters (see ::hardware_counters_t) alongside every
+ *          performance event.
+ * @details Must be called before any measurement. Counters of clones of @p metrics can be read,
+ *          but clones don't measure new counter values.
+ *
+ * @param metrics Performance metrics to be modified.
+ *
+ * @retval 0 Success.
+ * @retval 1 Hardware counters not available (measuring continues without them).
+ */
+int performance_metrics_enable_hardware_counters(performance_metrics_t *metrics);
+
 /**
  * @brief   Measures a performance event for a step of loading a dataset.
  * @details Measuring failures are reported to `stderr`.
@@ -80,6 +132,20 @@ performance_metrics_t *performance_metrics_clone(const performance_metrics_t *me
 void performance_metrics_measure_dataset(performance_metrics_t             *metrics,
                                          performance_metrics_dataset_step_t step);
 
+/**
+ * @brief   Stores how long each phase of parsing a file of the dataset took.
+ * @details Reported by the dataset loader after ::performance_metrics_measure_dataset is called for
+ *          @p step, and before the next step starts.
+ *
+ * @param metrics Performance metrics to be modified. Can be `NULL`, for no performance profiling.
+ * @param step    Step of dataset loading that loaded a file (one of the first
+ *                ::PERFORMANCE_METRICS_DATASET_FILE_COUNT steps). Other steps are ignored.
+ * @param phases  Time spent in each phase of parsing, and number of bytes and rows parsed.
+ */
+void performance_metrics_set_dataset_phases(performance_metrics_t             *metrics,
+                                            performance_metrics_dataset_step_t step,
+                                            const dataset_parser_phases_t     *phases);
+
 /**
  * @brief   Starts measuring a performance event for the generation of statistical data for a query.
  * @details When the query's data is generated, call
@@ -133,6 +199,56 @@ void performance_metrics_stop_measuring_query_execution(performance_metrics_t *m
                                                         size_t                 query_type,
                                                         size_t                 line_in_file);
 
+/**
+ * @brief   Chooses whether the performance event of every executed query is kept.
+ * @details When events aren't kept (e.g.: for large query files), only the latency histograms
+ *          (see ::performance_metrics_get_query_latencies) are updated, and
+ *          ::performance_metrics_get_query_execution_measurements outputs no measurements. Events
+ *          are kept by default.
+ *
+ * @param metrics Performance metrics to be modified.
+ * @param keep    Whether to keep the event of every query.
+ */
+void performance_metrics_set_keep_query_events(performance_metrics_t *metrics, int keep);
+
+/**
+ * @brief   Attaches a sampling profiler, whose samples will be tagged with the query being
+ *          processed.
+ * @details Statistical data generation is tagged with the query type, and execution with the
+ *          query type and the query's line in the query file. The profiler isn't owned by
+ *          @p metrics, and it must outlive its measurements.
+ *
+ * @param metrics  Performance metrics to be modified.
+ * @param profiler Running profiler, or `NULL` to detach the current one.
+ */
+void performance_metrics_set_profiler(performance_metrics_t *metrics,
+                                      sampling_profiler_t   *profiler);
+
+/**
+ * @brief   Attaches an allocation profiler, whose phases will be set to the task being measured.
+ * @details Each dataset loading step, and statistical data generation and execution of each query
+ *          type, are a separate phase, and everything else is phase `0`. The profiler must have
+ *          been started with ::PERFORMANCE_METRICS_ALLOCATION_PHASES phases. It isn't owned by
+ *          @p metrics, and its counts must be copied (by detaching it) before it's `free`d.
+ *
+ * @param metrics  Performance metrics to be modified.
+ * @param profiler Running profiler, or `NULL` to detach the current one, copying its counts into
+ *                 @p metrics.
+ */
+void performance_metrics_set_allocation_profiler(performance_metrics_t *metrics,
+                                                 allocation_profiler_t *profiler);
+
+/**
+ * @brief   Measures how much memory each part of a database is using.
+ * @details Call this after all queries are executed, so that indices built on demand are accounted
+ *          for.
+ *
+ * @param metrics  Performance metrics to be modified. Can be `NULL`, for no performance profiling.
+ * @param database Database whose memory usage is measured.
+ */
+void performance_metrics_measure_database_memory(performance_metrics_t *metrics,
+                                                 const database_t      *database);
+
 /**
  * @brief   Measures execution time and peak memory usage of the whole program.
  * @details Must be called after the program is done executing and before @p metrics are displayed.
@@ -175,6 +291,41 @@ const performance_event_t *
     performance_metrics_get_query_statistics_measurement(const performance_metrics_t *metrics,
                                                          size_t                       query_type);
 
+/**
+ * @brief   Gets how much memory a part of the database was using in a ::performance_metrics_t.
+ * @details See ::performance_metrics_measure_database_memory.
+ *
+ * @param metrics     Performance metrics to get memory information from.
+ * @param structure   Part of the database whose memory usage is returned.
+ * @param out_total   Where to output the number of bytes used by @p structure to.
+ * @param out_strings Where to output how many of the bytes in @p out_total are used by strings.
+ *
+ * @retval 0 Success.
+ * @retval 1 The memory usage of the database hasn't been measured.
+ */
+int performance_metrics_get_structure_memory(const performance_metrics_t    *metrics,
+                                             performance_metrics_structure_t structure,
+                                             size_t                         *out_total,
+                                             size_t                         *out_strings);
+
+/**
+ * @brief   Gets how much memory the statistical data of a query type is using in a
+ *          ::performance_metrics_t.
+ * @details This is the growth of the heap while the statistical data is generated, so temporary
+ *          allocations freed before generation ends aren't accounted for. It can only be measured
+ *          with the GNU C library, and if statistics are generated in a single thread.
+ *
+ * @param metrics    Performance metrics to get memory information from.
+ * @param query_type Type of the query whose statistical data's memory usage is returned.
+ * @param out_bytes  Where to output the number of bytes of the statistical data to.
+ *
+ * @retval 0 Success.
+ * @retval 1 The memory usage of the statistical data hasn't been measured (or failed to be).
+ */
+int performance_metrics_get_query_statistics_memory(const performance_metrics_t *metrics,
+                                                    size_t                       query_type,
+                                                    size_t                      *out_bytes);
+
 /**
  * @brief   Gets the time measurements from executions of all queries of type @p query_type in a
  *          ::performance_metrics_t.
@@ -196,6 +347,128 @@ size_t performance_metrics_get_query_execution_measurements(const performance_me
                                                             size_t   **out_line_numbers,
                                                             uint64_t **out_times);
 
+/**
+ * @brief Gets how long each phase of parsing a file of the dataset took.
+ *
+ * @param metrics Performance metrics to get parsing phases from.
+ * @param step    Step of dataset loading to be considered.
+ *
+ * @return The phases reported with ::performance_metrics_set_dataset_phases, or `NULL` if @p step
+ *         doesn't load a file or its phases weren't measured.
+ */
+const dataset_parser_phases_t *
+    performance_metrics_get_dataset_phases(const performance_metrics_t       *metrics,
+                                           performance_metrics_dataset_step_t step);
+
+/**
+ * @brief Gets the heap allocations made during a step of dataset loading.
+ *
+ * @param metrics Performance metrics to get allocation counts from.
+ * @param step    Phase of dataset loading to be considered. Musn't be
+ *                ::PERFORMANCE_METRICS_DATASET_STEP_DONE or
+ *                ::PERFORMANCE_METRICS_DATASET_STEP_NOT_STARTED.
+ *
+ * @return The allocations made during @p step, or `NULL` if no allocation profiler was attached
+ *         and detached (see ::performance_metrics_set_allocation_profiler).
+ */
+const allocation_profiler_counts_t *
+    performance_metrics_get_dataset_allocations(const performance_metrics_t       *metrics,
+                                                performance_metrics_dataset_step_t step);
+
+/**
+ * @brief Gets the heap allocations made while generating statistical data for a query type.
+ *
+ * @param metrics    Performance metrics to get allocation counts from.
+ * @param query_type Query type to get allocation counts for.
+ *
+ * @return The allocations made generating statistical data for @p query_type, or `NULL` if no
+ *         allocation profiler was attached and detached.
+ */
+const allocation_profiler_counts_t *
+    performance_metrics_get_query_statistics_allocations(const performance_metrics_t *metrics,
+                                                         size_t                       query_type);
+
+/**
+ * @brief Gets the heap allocations made while executing all queries of a type.
+ *
+ * @param metrics    Performance metrics to get allocation counts from.
+ * @param query_type Query type to get allocation counts for.
+ *
+ * @return The allocations made executing queries of @p query_type, or `NULL` if no allocation
+ *         profiler was attached and detached.
+ */
+const allocation_profiler_counts_t *
+    performance_metrics_get_query_execution_allocations(const performance_metrics_t *metrics,
+                                                        size_t                       query_type);
+
+/**
+ * @brief Gets the heap allocations made outside of all other measured tasks.
+ *
+ * @param metrics Performance metrics to get allocation counts from.
+ *
+ * @return The allocations made outside of other measured tasks (e.g.: parsing queries), or `NULL`
+ *         if no allocation profiler was attached and detached.
+ */
+const allocation_profiler_counts_t *
+    performance_metrics_get_other_allocations(const performance_metrics_t *metrics);
+
+/**
+ * @brief Gets the hardware counter values measured for a step of dataset loading.
+ *
+ * @param metrics Performance metrics to get hardware counter values from.
+ * @param step    Phase of dataset loading to be considered. Musn't be
+ *                ::PERFORMANCE_METRICS_DATASET_STEP_DONE or
+ *                ::PERFORMANCE_METRICS_DATASET_STEP_NOT_STARTED.
+ *
+ * @return The difference in hardware counter values over @p step, or `NULL` if hardware counters
+ *         weren't enabled (see ::performance_metrics_enable_hardware_counters).
+ */
+const hardware_counters_values_t *
+    performance_metrics_get_dataset_counters(const performance_metrics_t       *metrics,
+                                             performance_metrics_dataset_step_t step);
+
+/**
+ * @brief Gets the hardware counter values measured for query statistical data generation.
+ *
+ * @param metrics    Performance metrics to get hardware counter values from.
+ * @param query_type Query type whose statistical data generation has been profiled.
+ *
+ * @return The difference in hardware counter values over statistical data generation, or `NULL`
+ *         if hardware counters weren't enabled (see
+ *         ::performance_metrics_enable_hardware_counters).
+ */
+const hardware_counters_values_t *
+    performance_metrics_get_query_statistics_counters(const performance_metrics_t *metrics,
+                                                      size_t                       query_type);
+
+/**
+ * @brief Gets the hardware counter values measured for the execution of all queries of a type.
+ *
+ * @param metrics    Performance metrics to get hardware counter values from.
+ * @param query_type Query type whose executions have been profiled.
+ *
+ * @return The sum of differences in hardware counter values over every query's execution, or
+ *         `NULL` if hardware counters weren't enabled (see
+ *         ::performance_metrics_enable_hardware_counters).
+ */
+const hardware_counters_values_t *
+    performance_metrics_get_query_execution_counters(const performance_metrics_t *metrics,
+                                                     size_t                       query_type);
+
+/**
+ * @brief   Gets a histogram of the execution times of all queries of a type.
+ * @details Unlike ::performance_metrics_get_query_execution_measurements, this is available even
+ *          when query events aren't kept (see ::performance_metrics_set_keep_query_events).
+ *
+ * @param metrics    Performance metrics to get performance information from.
+ * @param query_type Query type whose executions have been profiled.
+ *
+ * @return A histogram of execution times (in microseconds) of queries of type @p query_type.
+ */
+const latency_histogram_t *
+    performance_metrics_get_query_latencies(const performance_metrics_t *metrics,
+                                            size_t                       query_type);
+
 /**
  * @brief   Gets the time it took to run the whole program from a ::performance_metrics_t.
  * @details Must be called after ::performance_metrics_measure_whole_program.
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    sample_statistics.h
+ * @brief   Statistics of sets of measurements (e.g.: of repeated benchmark iterations).
+ * @details Used by [benchmark mode](@ref benchmark_mode.h) for confidence intervals, and by
+ *          [metrics comparison](@ref metrics_comparison.h) for significance testing. Critical
+ *          values are always for a two-tailed 95 % confidence level.
+ *
+ * @anchor sample_statistics_examples
+ * ### Examples
+ *
+ * ```c
+ * const double samples[4] = {10.0, 12.0, 11.0, 13.0};
+ * const double mean       = sample_statistics_mean(4, samples);     // 11.5
+ * const double variance   = sample_statistics_variance(4, samples); // 1.666...
+ * const double t          = sample_statistics_t_critical_value(3);  // 3.182
+ * printf("%lf ± %lf\n", mean, t * sqrt(variance / 4));
+ * ```
+ */
+
+#ifndef SAMPLE_STATISTICS_H
+#define SAMPLE_STATISTICS_H
+
+#include <stddef.h>
+
+/**
+ * @brief  Calculates the mean of a set of samples.
+ *
+ * @param n       Number of samples in @p samples.
+ * @param samples Samples to calculate the mean of.
+ *
+ * @return The mean of @p samples, or `0` if there are no samples.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref sample_statistics_examples).
+ */
+double sample_statistics_mean(size_t n, const double samples[n]);
+
+/**
+ * @brief  Calculates the (unbiased) variance of a set of samples.
+ *
+ * @param n       Number of samples in @p samples.
+ * @param samples Samples to calculate the variance of.
+ *
+ * @return The variance of @p samples, or `0` if there are less than two samples.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref sample_statistics_examples).
+ */
+double sample_statistics_variance(size_t n, const double samples[n]);
+
+/**
+ * @brief  Gets the two-tailed critical value of Student's t-distribution, for a 95 % confidence
+ *         level.
+ *
+ * @param degrees_of_freedom Degrees of freedom of the distribution. Non-integer values (e.g.: from
+ *                           Welch's t-test) are rounded down. Must be at least `1`.
+ *
+ * @return The critical value of t.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref sample_statistics_examples).
+ */
+double sample_statistics_t_critical_value(double degrees_of_freedom);
+
+#endif
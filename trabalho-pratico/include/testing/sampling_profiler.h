@@ -0,0 +1,149 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    sampling_profiler.h
+ * @brief   Statistical profiler that samples the call stack of the process on `SIGPROF`.
+ * @details While the profiler is running, `SIGPROF` is delivered at a fixed rate of CPU time
+ *          (`ITIMER_PROF`), and the signal handler records the current call stack (with
+ *          `backtrace`) into a preallocated buffer. Each sample is tagged with what the program
+ *          said it was doing at that moment (see ::sampling_profiler_set_tag), so that cost can be
+ *          attributed to query types and to individual lines of a query file.
+ *
+ *          Samples are written in the "collapsed stack" format of `flamegraph.pl` (and
+ *          compatible tools, such as `inferno` or speedscope): one line per distinct stack, with
+ *          frames from the outermost to the innermost separated by `;`, followed by the number of
+ *          samples. The tag is the outermost frame (e.g.: `query3;line42;...`).
+ *
+ *          Only one profiler can run at a time, as signal handlers are process-wide. Function
+ *          names are only known for exported symbols, so programs should be linked with
+ *          `-rdynamic`. Other frames are written as addresses.
+ *
+ * @anchor sampling_profiler_examples
+ * ### Examples
+ *
+ * ```c
+ * sampling_profiler_t *profiler = sampling_profiler_start(0, 0);
+ * if (!profiler)
+ *     return 1;
+ *
+ * sampling_profiler_set_tag(profiler, 3, 42); // Executing query 3 in line 42
+ * do_work();
+ * sampling_profiler_set_tag(profiler, 0, 0);
+ *
+ * sampling_profiler_stop(profiler);
+ * sampling_profiler_write_collapsed(profiler, stdout);
+ * sampling_profiler_free(profiler);
+ * ```
+ *
+ * The output can be turned into a flame graph with `flamegraph.pl profile.txt > profile.svg`.
+ */
+
+#ifndef SAMPLING_PROFILER_H
+#define SAMPLING_PROFILER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/** @brief Statistical profiler that samples the call stack of the process on `SIGPROF`. */
+typedef struct sampling_profiler sampling_profiler_t;
+
+/** @brief Default sampling frequency of ::sampling_profiler_start, in samples per CPU second. */
+#define SAMPLING_PROFILER_DEFAULT_FREQUENCY 997
+
+/** @brief Default maximum number of samples of ::sampling_profiler_start. */
+#define SAMPLING_PROFILER_DEFAULT_MAX_SAMPLES 65536
+
+/**
+ * @brief   Starts sampling the call stack of the process.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::sampling_profiler_free, after calling ::sampling_profiler_stop.
+ *
+ * @param frequency   Samples per second of CPU time. `0` for
+ *                    ::SAMPLING_PROFILER_DEFAULT_FREQUENCY.
+ * @param max_samples Number of samples to allocate space for. Once full, further samples are only
+ *                    counted as dropped. `0` for ::SAMPLING_PROFILER_DEFAULT_MAX_SAMPLES.
+ *
+ * @return The new profiler, or `NULL` on failure (allocation failure, another profiler already
+ *         running, or failure to set up the signal handler or the timer).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref sampling_profiler_examples).
+ */
+sampling_profiler_t *sampling_profiler_start(unsigned int frequency, size_t max_samples);
+
+/**
+ * @brief   Sets what the program is doing, to tag the following samples with.
+ * @details This is cheap (two stores), so it can be called around every query.
+ *
+ * @param profiler   Profiler to be modified. Can be `NULL`, for nothing to be done.
+ * @param query_type Type of the query being processed, or `0` when no query is being processed.
+ * @param line       Line of the query in the query file, or `0` when generating the statistical
+ *                   data of @p query_type.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref sampling_profiler_examples).
+ */
+void sampling_profiler_set_tag(sampling_profiler_t *profiler, size_t query_type, size_t line);
+
+/**
+ * @brief Stops sampling, restoring the previous `SIGPROF` handler.
+ *
+ * @param profiler Running profiler.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure to stop the timer or to restore the signal handler.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref sampling_profiler_examples).
+ */
+int sampling_profiler_stop(sampling_profiler_t *profiler);
+
+/**
+ * @brief  Gets the number of samples taken by a profiler.
+ * @param  profiler Profiler to get the number of samples from.
+ * @param  dropped  Where to output the number of samples that didn't fit in the profiler to. Can
+ *                  be `NULL`.
+ * @return The number of recorded samples.
+ */
+size_t sampling_profiler_get_sample_count(const sampling_profiler_t *profiler, size_t *dropped);
+
+/**
+ * @brief   Writes the samples of a stopped profiler in the collapsed stack format.
+ * @details Frames inside the profiler's signal handler are omitted.
+ *
+ * @param profiler Stopped profiler.
+ * @param output   Where to write the collapsed stacks to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure or IO error.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref sampling_profiler_examples).
+ */
+int sampling_profiler_write_collapsed(const sampling_profiler_t *profiler, FILE *output);
+
+/**
+ * @brief Frees memory used by a profiler.
+ * @param profiler Profiler to be `free`d. Must not be running.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref sampling_profiler_examples).
+ */
+void sampling_profiler_free(sampling_profiler_t *profiler);
+
+#endif
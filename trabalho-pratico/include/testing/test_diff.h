@@ -17,7 +17,8 @@
 /**
  * @file    test_diff.h
  * @brief   Information about differences between generated and expected program output.
- * @details Compares two directories.
+ * @details Compares two directories, or a directory and a
+ *          [container of query outputs](@ref query_output_container.h) with a directory.
  *
  * @anchor test_diff_example
  * ### Example
@@ -46,6 +47,28 @@ typedef struct test_diff test_diff_t;
  */
 test_diff_t *test_diff_create(const char *results, const char *expected);
 
+/**
+ * @brief   Generates the difference between a directory of expected results and the program's
+ *          results, where query outputs were written to a container.
+ * @details Each entry in the container is compared as if it were the file
+ *          `command<identifier>_output.txt` in @p results. Other files in @p results (e.g.: dataset
+ *          errors) are compared as in ::test_diff_create.
+ *
+ * @param results        Directory where the program's output was placed into.
+ * @param container_path Path to the container with the outputs of queries. If it's in @p results,
+ *                       it must be written as `results/<file name>` to be ignored as a result.
+ * @param expected       Directory containing expected program results.
+ *
+ * @return A valid pointer to a ::test_diff_t, that must be `free`d with ::test_diff_free, or
+ *         `NULL` in case of an allocation or IO error, or if the container isn't valid.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref test_diff_example).
+ */
+test_diff_t *test_diff_create_with_container(const char *results,
+                                             const char *container_path,
+                                             const char *expected);
+
 /**
  * @brief  Creates a deep clone of @p diff.
  * @param  diff Difference test results to be cloned.
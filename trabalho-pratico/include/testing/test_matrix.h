@@ -0,0 +1,143 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    test_matrix.h
+ * @brief   Many test cases, run concurrently and reported together.
+ * @details A test matrix is read from a manifest file, with one test case per line: the path to a
+ *          dataset, the path to a query file and the path to the directory of expected results,
+ *          separated by whitespace. Empty lines and lines starting with `#` are ignored.
+ *
+ *          Test cases are run in the order they appear in the manifest, but all cases of the same
+ *          dataset share a single database, loaded once (from a snapshot in the dataset's
+ *          directory, like the one ::batch_mode_run_streaming keeps in its cache directory). Each
+ *          case runs in its own forked process, which only reads the database, so that cases don't
+ *          interfere with each other's resource usage measurements, and up to a given number of
+ *          cases run at once.
+ *
+ *          The outputs of case `i` are written to a container in
+ *          ::TEST_MATRIX_CASE_CONTAINER_PATH_FORMAT, and compared with its expected results
+ *          alongside the dataset's error files. Its
+ *          [performance metrics](@ref performance_metrics.h) and
+ *          [differences](@ref test_diff.h) are written to ::TEST_MATRIX_CASE_REPORT_PATH_FORMAT,
+ *          and all reports are then gathered into a single one, followed by a table summarizing
+ *          every case.
+ *
+ * @anchor test_matrix_examples
+ * ### Examples
+ *
+ * A manifest could look like the following:
+ *
+ * ```text
+ * # dataset           queries                      expected results
+ * datasets/small      tests/small/input.txt        tests/small/output
+ * datasets/small      tests/small/errors.txt       tests/small/errors
+ * datasets/large      tests/large/input.txt        tests/large/output
+ * ```
+ *
+ * It can be run as follows:
+ *
+ * ```c
+ * test_matrix_t *matrix = test_matrix_load("manifest.txt");
+ * if (!matrix)
+ *     return 1;
+ *
+ * const int retval = test_matrix_run(matrix, 4, PERFORMANCE_EVENT_MODE_RUSAGE, stdout);
+ * test_matrix_free(matrix);
+ * return retval;
+ * ```
+ */
+
+#ifndef TEST_MATRIX_H
+#define TEST_MATRIX_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "testing/performance_event.h"
+
+/** @brief Directory where test matrices write their outputs and reports to. */
+#define TEST_MATRIX_DIRECTORY "Resultados/matrix"
+
+/**
+ * @brief Format of the paths of the [containers](@ref query_output_container.h) where the outputs
+ *        of each test case are written to (given the case's index in the manifest).
+ */
+#define TEST_MATRIX_CASE_CONTAINER_PATH_FORMAT TEST_MATRIX_DIRECTORY "/case%zu.container"
+
+/**
+ * @brief Format of the paths of the files where the report of each test case is written to (given
+ *        the case's index in the manifest).
+ */
+#define TEST_MATRIX_CASE_REPORT_PATH_FORMAT TEST_MATRIX_DIRECTORY "/case%zu.txt"
+
+/** @brief Test cases read from a manifest file. */
+typedef struct test_matrix test_matrix_t;
+
+/**
+ * @brief  Reads a test matrix from a manifest file.
+ * @param  path Path to the manifest file.
+ * @return A new test matrix, that must be deleted with ::test_matrix_free, or `NULL` on IO or
+ *         allocation failure, or if a line of the manifest doesn't have exactly three fields.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref test_matrix_examples).
+ */
+test_matrix_t *test_matrix_load(const char *path);
+
+/**
+ * @brief  Gets the number of test cases in a test matrix.
+ * @param  matrix Test matrix to get the number of cases of.
+ * @return The number of test cases in @p matrix.
+ */
+size_t test_matrix_get_length(const test_matrix_t *matrix);
+
+/**
+ * @brief   Runs all test cases in a test matrix and reports their results.
+ * @details When a dataset is parsed, instead of loaded from a snapshot, its loading measurements
+ *          are included in the reports of all of its cases. The total time of each case only
+ *          covers its own process, after the dataset is loaded. Each case executes its queries on a
+ *          single thread, so that measurements of different queries don't overlap.
+ *
+ * @param matrix Test cases to be run.
+ * @param njobs  Maximum number of test cases running at once. `0` runs one per processor (see
+ *               ::thread_count_get).
+ * @param mode   How to measure the performance of each case.
+ * @param report Where to write the reports of all test cases to.
+ *
+ * @retval 0 All test cases were run, whether their outputs were correct or not.
+ * @retval 1 Failure to run some test case (e.g.: missing dataset, IO or allocation errors). A
+ *           message will also be printed to `stderr`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref test_matrix_examples).
+ */
+int test_matrix_run(const test_matrix_t     *matrix,
+                    size_t                   njobs,
+                    performance_event_mode_t mode,
+                    FILE                    *report);
+
+/**
+ * @brief Frees memory used by a test matrix.
+ * @param matrix Test matrix to be deleted.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref test_matrix_examples).
+ */
+void test_matrix_free(test_matrix_t *matrix);
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    workload.h
+ * @brief   Streams of queries received by a server, recorded with their arrival times.
+ * @details A workload file starts with the line ::WORKLOAD_FILE_HEADER, followed by one line per
+ *          query: the time it arrived at the server (in microseconds since recording started), a
+ *          space, and the query, with the same syntax as in query files. Query files (without the
+ *          header) can be read as workloads without arrival times.
+ *
+ *          Workloads are recorded by [server mode](@ref server_mode.h) and replayed by
+ *          [load mode](@ref load_mode.h).
+ *
+ * @anchor workload_examples
+ * ### Examples
+ *
+ * ```c
+ * workload_recorder_t *recorder = workload_recorder_create("workload.txt");
+ * if (!recorder)
+ *     return 1;
+ *
+ * workload_recorder_record(recorder, "1 Book0000000001", 16);
+ * workload_recorder_record(recorder, "4 HTL1001", 9);
+ * workload_recorder_free(recorder);
+ *
+ * workload_t *workload = workload_load("workload.txt");
+ * for (size_t i = 0; i < workload_get_length(workload); ++i)
+ *     printf("%" PRIu64 " us: %s\n", workload_get_time(workload, i),
+ *            workload_get_query(workload, i));
+ * workload_free(workload);
+ * ```
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief First line of every workload file. */
+#define WORKLOAD_FILE_HEADER "# LI3 workload"
+
+/** @brief Writes queries to a workload file, as they arrive. */
+typedef struct workload_recorder workload_recorder_t;
+
+/** @brief Queries read from a workload file (or from a query file). */
+typedef struct workload workload_t;
+
+/**
+ * @brief   Creates a workload file and starts recording.
+ * @details Arrival times are relative to when this function is called.
+ *
+ * @param path Path to the workload file, which is truncated if it already exists.
+ *
+ * @return A new recorder, that must be deleted with ::workload_recorder_free, or `NULL` on failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref workload_examples).
+ */
+workload_recorder_t *workload_recorder_create(const char *path);
+
+/**
+ * @brief   Records that a query has arrived.
+ * @details Not thread-safe. Queries containing line breaks can't be recorded, and are ignored.
+ *
+ * @param recorder Recorder to write the query to.
+ * @param query    Query, with the same syntax as in query files. Doesn't need to be
+ *                 null-terminated.
+ * @param length   Number of characters in @p query.
+ *
+ * @retval 0 Success (or ignored query).
+ * @retval 1 IO failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref workload_examples).
+ */
+int workload_recorder_record(workload_recorder_t *recorder, const char *query, size_t length);
+
+/**
+ * @brief Writes all queries recorded so far to the workload file.
+ *
+ * @param recorder Recorder to be flushed.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int workload_recorder_flush(workload_recorder_t *recorder);
+
+/**
+ * @brief Stops recording, closing the workload file.
+ *
+ * @param recorder Recorder to be deleted.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure (the file may be incomplete).
+ */
+int workload_recorder_free(workload_recorder_t *recorder);
+
+/**
+ * @brief   Reads a workload file, or a query file.
+ * @details Empty lines are skipped. In workload files, lines that don't start with an arrival time
+ *          make loading fail, and arrival times must not decrease.
+ *
+ * @param path Path to the file to be read.
+ *
+ * @return The read workload, that must be deleted with ::workload_free, or `NULL` on failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref workload_examples).
+ */
+workload_t *workload_load(const char *path);
+
+/**
+ * @brief  Gets the number of queries in a workload.
+ * @param  workload Workload to get the number of queries from.
+ * @return The number of queries in @p workload.
+ */
+size_t workload_get_length(const workload_t *workload);
+
+/**
+ * @brief  Gets whether a workload was read with the arrival times of its queries.
+ * @param  workload Workload read by ::workload_load.
+ * @return `1` for workload files, `0` for query files.
+ */
+int workload_has_times(const workload_t *workload);
+
+/**
+ * @brief Gets a query in a workload.
+ *
+ * @param workload Workload to get the query from.
+ * @param i        Index of the query, lower than ::workload_get_length.
+ *
+ * @return The null-terminated query, without a line terminator.
+ */
+const char *workload_get_query(const workload_t *workload, size_t i);
+
+/**
+ * @brief Gets the arrival time of a query in a workload.
+ *
+ * @param workload Workload to get the arrival time from.
+ * @param i        Index of the query, lower than ::workload_get_length.
+ *
+ * @return The time the query arrived, in microseconds since the start of the recording. Always `0`
+ *         for workloads without arrival times (see ::workload_has_times).
+ */
+uint64_t workload_get_time(const workload_t *workload, size_t i);
+
+/**
+ * @brief Frees a workload read by ::workload_load.
+ * @param workload Workload to be deleted.
+ */
+void workload_free(workload_t *workload);
+
+#endif
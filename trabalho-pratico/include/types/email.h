@@ -55,10 +55,12 @@
 #define EMAIL_H
 
 /**
- * @brief Verifies if a **MODIFIABLE** string is a valid email.
+ * @brief   Verifies if a string is a valid email.
+ * @details The whole string is classified in a single pass (16 characters at a time, when SSE2 is
+ *          available), without being modified. This is the same as ::email_validate_string_const,
+ *          kept for callers with modifiable strings.
  *
- * @param input String to validate, that will be modified during parsing, but then restored to its
- *              original form. Must be in the format `"user@domain.tld"`.
+ * @param input String to validate. Must be in the format `"user@domain.tld"`.
  *
  * @retval 0 Valid email.
  * @retval 1 Validation failure.
@@ -71,14 +73,13 @@
 int email_validate_string(char *input);
 
 /**
- * @brief  Verifies if a string is a valid email.
- * @details The current implementation copies the provided string to a temporary buffer. Keep that
- *          in mind for performance reasons.
+ * @brief   Verifies if a string is a valid email.
+ * @details See ::email_validate_string.
  *
  * @param input String to validate. Must be in the format `"user@domain.tld"`.
  *
  * @retval 0 Valid email.
- * @retval 1 Validation or allocation failure.
+ * @retval 1 Validation failure.
  *
  * #### Examples
  * See [the header file's documentation](@ref email_examples).
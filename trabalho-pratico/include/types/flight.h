@@ -24,6 +24,16 @@
  *          Also, keep in mind that some setters can fail due to invalid values, returning a non-`0`
  *          value.
  *
+ *          Airlines and plane models are stored as codes in a ::string_dictionary_t (usually the
+ *          one of the ::flight_manager_t the flight belongs to), so that flights are smaller and
+ *          these fields can be compared as integers. That dictionary must be provided to read
+ *          them as strings.
+ *
+ *          When built with `PACKED_RECORDS` defined (`make PACKED_RECORDS=1`), dates are stored in
+ *          32 bits, as seconds since ::FLIGHT_PACKED_DATE_EPOCH, so that flights are smaller and
+ *          scans over them move fewer bytes. Date setters then also fail for dates that can't be
+ *          represented (before ::FLIGHT_PACKED_DATE_EPOCH or over 133 years after it).
+ *
  * @anchor flight_examples
  * ### Examples
  *
@@ -39,11 +49,14 @@
 #include "types/flight_id.h"
 #include "utils/date_and_time.h"
 #include "utils/pool.h"
-#include "utils/string_pool_no_duplicates.h"
+#include "utils/string_dictionary.h"
 
 /** @brief A flight. */
 typedef struct flight flight_t;
 
+/** @brief Earliest date that can be stored in a flight, when built with `PACKED_RECORDS`. */
+#define FLIGHT_PACKED_DATE_EPOCH ((date_and_time_t) 1970 * DATE_DAYS_PER_YEAR * 24 * 60 * 60)
+
 /**
  * @brief   Creates a new flight with uninitialized fields.
  * @details Before using this flight, set all its fields using the setters in this module.
@@ -59,48 +72,46 @@ flight_t *flight_create(pool_t *allocator);
 /**
  * @brief Creates a deep clone of a flight.
  *
- * @param allocator        Pool where to allocate the flight. The pool's `item_size` (see
- *                         ::pool_create_from_size) must be the value returned by ::flight_sizeof.
- *                         Can be `NULL`, so that malloc is used instead of a pool.
- * @param string_allocator Pool where to allocate the strings of a flight. Can be `NULL`, so that
- *                         `strdup` is used instead of a pool.
- * @param flight           Flight to be cloned.
+ * @param allocator      Pool where to allocate the flight. The pool's `item_size` (see
+ *                       ::pool_create_from_size) must be the value returned by ::flight_sizeof.
+ *                       Can be `NULL`, so that malloc is used instead of a pool.
+ * @param strings        Dictionary where to encode the strings of the new flight.
+ * @param flight_strings Dictionary with the strings of @p flight. Can be the same as @p strings,
+ *                       for the codes to just be copied.
+ * @param flight         Flight to be cloned.
  *
  * @return A deep-clone of @p flight (`NULL` on allocation failure).
  */
-flight_t *flight_clone(pool_t                      *allocator,
-                       string_pool_no_duplicates_t *string_allocator,
-                       const flight_t              *flight);
+flight_t *flight_clone(pool_t                    *allocator,
+                       string_dictionary_t       *strings,
+                       const string_dictionary_t *flight_strings,
+                       const flight_t            *flight);
 
 /**
  * @brief Sets a flight's airline.
  *
- * @param allocator Where to copy @p airline to. Can be `NULL`, so that `strdup` is used instead of
- *                  a pool.
- * @param flight    Flight to have its airline set.
- * @param airline   Airline of the flight. Musn't be empty.
+ * @param strings Where to encode @p airline in.
+ * @param flight  Flight to have its airline set.
+ * @param airline Airline of the flight. Musn't be empty.
  *
  * @retval 0 Success.
  * @retval 1 Failure due to empty @p airline or allocation failure. @p flight wasn't modified.
  */
-int flight_set_airline(string_pool_no_duplicates_t *allocator,
-                       flight_t                    *flight,
-                       const char                  *airline);
+int flight_set_airline(string_dictionary_t *strings, flight_t *flight, const char *airline);
 
 /**
  * @brief Sets a flight's plane model.
  *
- * @param allocator   Where to copy @p airline to. Can be `NULL`, so that `strdup` is used instead
- *                    of a pool.
+ * @param strings     Where to encode @p plane_model in.
  * @param flight      Flight to have its plane model set.
  * @param plane_model Plane model of the flight. Musn't be empty.
  *
  * @retval 0 Success.
  * @retval 1 Failure due to empty @p plane_model or allocation failure. @p flight wasn't modified.
  */
-int flight_set_plane_model(string_pool_no_duplicates_t *allocator,
-                           flight_t                    *flight,
-                           const char                  *plane_model);
+int flight_set_plane_model(string_dictionary_t *strings,
+                           flight_t            *flight,
+                           const char          *plane_model);
 
 /**
  * @brief Sets a flight's origin airport.
@@ -131,7 +142,8 @@ void flight_set_id(flight_t *flight, flight_id_t id);
  *                                that comparsion won't be performed.
  *
  * @retval 0 Success.
- * @retval 1 Failure because @p schedule_departure_date doesn't come before `schedule_arrival_date`.
+ * @retval 1 Failure because @p schedule_departure_date doesn't come before `schedule_arrival_date`,
+ *           or can't be represented (see `PACKED_RECORDS`).
  *           @p flight wasn't modified.
  */
 int flight_set_schedule_departure_date(flight_t *flight, date_and_time_t schedule_departure_date);
@@ -144,7 +156,8 @@ int flight_set_schedule_departure_date(flight_t *flight, date_and_time_t schedul
  *                                initialized, that comparison won't be performed.
  *
  * @retval 0 Success.
- * @retval 1 Failure because @p schedule_arrival_date doesn't come after `schedule_departure_date`.
+ * @retval 1 Failure because @p schedule_arrival_date doesn't come after `schedule_departure_date`,
+ *           or can't be represented (see `PACKED_RECORDS`).
  *           @p flight wasn't modified.
  */
 int flight_set_schedule_arrival_date(flight_t *flight, date_and_time_t schedule_arrival_date);
@@ -181,8 +194,11 @@ int flight_set_number_of_passengers(flight_t *flight, uint16_t number_of_passeng
  *
  * @param flight              Flight to have its real departure date set.
  * @param real_departure_date Real departure date of the flight.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure because @p real_departure_date can't be represented (see `PACKED_RECORDS`).
  */
-void flight_set_real_departure_date(flight_t *flight, date_and_time_t real_departure_date);
+int flight_set_real_departure_date(flight_t *flight, date_and_time_t real_departure_date);
 
 /**
  * @brief Sets a flight's total number of seats.
@@ -209,18 +225,35 @@ int flight_set_total_seats(flight_t *flight, uint16_t total_seats);
 void flight_reset_seats(flight_t *flight);
 
 /**
- * @brief  Gets a flight's airline.
+ * @brief  Gets the code of a flight's airline.
  * @param  flight Flight to get the airline from.
+ * @return The code of the flight's airline, in the dictionary it was set with.
+ */
+string_code_t flight_get_airline_code(const flight_t *flight);
+
+/**
+ * @brief  Gets a flight's airline.
+ * @param  strings Dictionary the flight's airline was encoded in.
+ * @param  flight  Flight to get the airline from.
  * @return The flight's airline.
  */
-const char *flight_get_const_airline(const flight_t *flight);
+const char *flight_get_const_airline(const string_dictionary_t *strings, const flight_t *flight);
 
 /**
- * @brief  Gets a flight's plane model.
+ * @brief  Gets the code of a flight's plane model.
  * @param  flight Flight to get the plane model from.
+ * @return The code of the flight's plane model, in the dictionary it was set with.
+ */
+string_code_t flight_get_plane_model_code(const flight_t *flight);
+
+/**
+ * @brief  Gets a flight's plane model.
+ * @param  strings Dictionary the flight's plane model was encoded in.
+ * @param  flight  Flight to get the plane model from.
  * @return The flight's plane model.
  */
-const char *flight_get_const_plane_model(const flight_t *flight);
+const char *flight_get_const_plane_model(const string_dictionary_t *strings,
+                                         const flight_t            *flight);
 
 /**
  * @brief  Gets a flight's origin airport.
@@ -21,6 +21,10 @@
  * @details See what fields define a reservation (and thus available through getters and setters) in
  *          the [struct's documentation](@ref reservation).
  *
+ *          Hotel names are stored as codes in a ::string_dictionary_t (usually the one of the
+ *          ::reservation_manager_t the reservation belongs to), that must be provided to read them
+ *          as strings.
+ *
  * @anchor reservation_examples
  * ### Examples
  *
@@ -35,10 +39,10 @@
 #include "types/hotel_id.h"
 #include "types/includes_breakfast.h"
 #include "types/reservation_id.h"
+#include "types/user_ordinal.h"
 #include "utils/date.h"
 #include "utils/pool.h"
-#include "utils/string_pool.h"
-#include "utils/string_pool_no_duplicates.h"
+#include "utils/string_dictionary.h"
 
 /** @brief Value of a reservation's rating when it's not specified. */
 #define RESERVATION_NO_RATING 0
@@ -64,39 +68,32 @@ reservation_t *reservation_create(pool_t *allocator);
  * @param allocator            Pool where to allocate the reservation. Its element size must be the
  *                             value returned by ::reservation_sizeof. Can be `NULL`, so that malloc
  *                             is used instead of a pool.
- * @param user_id_allocator    Pool where to allocate the user identifier in a reservation. Can be
- *                             `NULL`, so that `strdup` is used instead of a pool.
- * @param hotel_name_allocator Pool where to allocate the hotel name in a reservation. Can be
- *                             `NULL`, so that `strdup` is used instead of a pool.
- * @param reservation          Reservation to be cloned.
+ * @param hotel_names             Dictionary where to encode the hotel name of the new
+ *                                reservation.
+ * @param reservation_hotel_names Dictionary with the hotel name of @p reservation. Can be the same
+ *                                as @p hotel_names, for the code to just be copied.
+ * @param reservation             Reservation to be cloned.
  *
  * @return A deep-clone of @p reservation (`NULL` on allocation failure).
  */
-reservation_t *reservation_clone(pool_t                      *allocator,
-                                 string_pool_t               *user_id_allocator,
-                                 string_pool_no_duplicates_t *hotel_name_allocator,
-                                 const reservation_t         *reservation);
+reservation_t *reservation_clone(pool_t                    *allocator,
+                                 string_dictionary_t       *hotel_names,
+                                 const string_dictionary_t *reservation_hotel_names,
+                                 const reservation_t       *reservation);
 
 /**
- * @brief Sets a the identifier of the user that booked a reservation.
- *
- * @param allocator   Where to copy @p user_id to. Can be `NULL`, so that `strdup` is used instead
- *                    of a pool.
- * @param reservation Reservation to have its user identifier set.
- * @param user_id     Identifier of the user that booked a reservation. Musn't be empty.
+ * @brief Sets the user that booked a reservation.
  *
- * @retval 0 Success.
- * @retval 1 Failure due to empty @p user_id or allocation failure. @p reservation wasn't modified.
+ * @param reservation Reservation to have its user set.
+ * @param user        Ordinal of the user that booked the reservation (see
+ *                    ::user_manager_get_ordinal).
  */
-int reservation_set_user_id(string_pool_t *allocator,
-                            reservation_t *reservation,
-                            const char    *user_id);
+void reservation_set_user(reservation_t *reservation, user_ordinal_t user);
 
 /**
  * @brief Sets the name of the hotel in a reservation.
  *
- * @param allocator   Where to copy @p hotel_name to. Can be `NULL`, so that `strdup` is used
- *                    instead of a pool.
+ * @param hotel_names Where to encode @p hotel_name in.
  * @param reservation Reservation to have its hotel name set.
  * @param hotel_name  Hotel name of the reservation. Musn't be empty.
  *
@@ -104,9 +101,9 @@ int reservation_set_user_id(string_pool_t *allocator,
  * @retval 1 Failure due to empty @p hotel_name or allocation failure. @p reservation wasn't
  *           modified.
  */
-int reservation_set_hotel_name(string_pool_no_duplicates_t *allocator,
-                               reservation_t               *reservation,
-                               const char                  *hotel_name);
+int reservation_set_hotel_name(string_dictionary_t *hotel_names,
+                               reservation_t       *reservation,
+                               const char          *hotel_name);
 
 /**
  * @brief Sets whether a reservation includes breakfast.
@@ -209,18 +206,27 @@ void reservation_set_city_tax(reservation_t *reservation, uint8_t city_tax);
 int reservation_set_price_per_night(reservation_t *reservation, uint16_t price_per_night);
 
 /**
- * @brief  Gets a reservation's user identifier.
- * @param  reservation Reservation to get the user identifier from.
- * @return The reservation's user identifier.
+ * @brief  Gets the user that booked a reservation.
+ * @param  reservation Reservation to get the user from.
+ * @return The ordinal of the reservation's user (see ::user_manager_get_by_ordinal).
  */
-const char *reservation_get_const_user_id(const reservation_t *reservation);
+user_ordinal_t reservation_get_user(const reservation_t *reservation);
+
+/**
+ * @brief  Gets the code of a reservation's hotel name.
+ * @param  reservation Reservation to get the hotel name from.
+ * @return The code of the reservation's hotel name, in the dictionary it was set with.
+ */
+string_code_t reservation_get_hotel_name_code(const reservation_t *reservation);
 
 /**
  * @brief  Gets a reservation's hotel name.
+ * @param  hotel_names Dictionary the reservation's hotel name was encoded in.
  * @param  reservation Reservation to get the hotel name from.
  * @return The reservation's hotel name.
  */
-const char *reservation_get_const_hotel_name(const reservation_t *reservation);
+const char *reservation_get_const_hotel_name(const string_dictionary_t *hotel_names,
+                                             const reservation_t       *reservation);
 
 /**
  * @brief  Gets whether or not a reservation includes breakfast.
@@ -321,11 +327,16 @@ void reservation_invalidate(reservation_t *reservation);
 double reservation_calculate_hotel_profit(const reservation_t *reservation);
 
 /**
- * @brief  Calculates the price a ::user_t payed for @p reservation.
- * @param  reservation Reservation to use to calculate user price.
- * @return The price a ::user_t payed for @p reservation.
+ * @brief   Calculates the price a ::user_t payed for @p reservation, in cents.
+ * @details Because prices per night are integers and city taxes are percentages, the price in
+ *          cents is always an integer, and no floating-point arithmetic is needed. Sums of these
+ *          prices are exact.
+ *
+ * @param reservation Reservation to use to calculate user price.
+ *
+ * @return The price a ::user_t payed for @p reservation, in hundredths of a currency unit.
  */
-double reservation_calculate_price(const reservation_t *reservation);
+uint64_t reservation_calculate_price_cents(const reservation_t *reservation);
 
 /**
  * @brief Frees the memory used for a given reservation.
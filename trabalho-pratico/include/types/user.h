@@ -21,6 +21,11 @@
  * @details See what fields define a user (and thus available through getters and setters) in the
  *          [struct's documentation](@ref user).
  *
+ *          Short identifiers (shorter than ::USER_INLINE_ID_SIZE) and the first
+ *          ::USER_NAME_PREFIX_SIZE bytes of a user's name are kept inside the user itself, so that
+ *          scans that output identifiers or compare names (see ::user_compare_name) rarely need to
+ *          read from a string pool.
+ *
  * @anchor user_examples
  * ### Examples
  *
@@ -42,6 +47,12 @@
 /** @brief A user. */
 typedef struct user user_t;
 
+/** @brief Size of the buffer for identifiers in a ::user_t, including the null terminator. */
+#define USER_INLINE_ID_SIZE 24
+
+/** @brief Number of bytes of the name of a user kept in a ::user_t. */
+#define USER_NAME_PREFIX_SIZE 8
+
 /**
  * @brief   Creates a new user with uninitialized fields.
  * @details Before using this user, set all its fields using the setters in this module.
@@ -68,7 +79,22 @@ user_t *user_create(pool_t *allocator);
 user_t *user_clone(pool_t *allocator, string_pool_t *string_allocator, const user_t *user);
 
 /**
- * @brief Sets a user's identifier.
+ * @brief   Creates a shallow clone of a user, that shares its strings with the original user.
+ * @details Strings are never `free`d by the clone, so they must be allocated in a pool that outlives
+ *          it (see the `allocator` parameter of ::user_set_id, for example).
+ *
+ * @param allocator Pool where to allocate the user. Its element size must be the value returned by
+ *                  ::user_sizeof. Can be `NULL`, so that malloc is used, instead of a pool.
+ * @param user      User to be cloned.
+ *
+ * @return A shallow clone of @p user (`NULL` on allocation failure).
+ */
+user_t *user_clone_shallow(pool_t *allocator, const user_t *user);
+
+/**
+ * @brief   Sets a user's identifier.
+ * @details Identifiers shorter than ::USER_INLINE_ID_SIZE are stored in @p user, and @p allocator
+ *          isn't used.
  *
  * @param allocator Pool where to allocate @p id. `NULL` can be provided so that `strdup` is used
  *                  instead of a pool.
@@ -161,8 +187,12 @@ int user_set_account_creation_date(user_t *user, date_and_time_t account_creatio
 void user_reset_dates(user_t *user);
 
 /**
- * @brief  Gets a user's identifier.
- * @param  user User to get the identifier from.
+ * @brief   Gets a user's identifier.
+ * @details Short identifiers are stored inside of @p user, so the returned string mustn't outlive
+ *          it, nor be used after the identifier is changed.
+ *
+ * @param user User to get the identifier from.
+ *
  * @return The user's identifier.
  */
 const char *user_get_const_id(const user_t *user);
@@ -174,6 +204,34 @@ const char *user_get_const_id(const user_t *user);
  */
 const char *user_get_const_name(const user_t *user);
 
+/**
+ * @brief   Compares the name of a user with a string.
+ * @details Same as `strcmp(user_get_const_name(user), str)`, but the name is only read from its
+ *          string pool when its first ::USER_NAME_PREFIX_SIZE bytes are equal to @p str's.
+ *
+ * @param user User whose name is to be compared.
+ * @param str  String to compare the name of @p user with.
+ *
+ * @return A negative value, `0`, or a positive value, if the name of @p user is, respectively,
+ *         lower than, equal to, or greater than @p str (in byte order).
+ */
+int user_compare_name(const user_t *user, const char *str);
+
+/**
+ * @brief   Compares the beginning of the name of a user with a prefix.
+ * @details Same as `strncmp(user_get_const_name(user), prefix, length)`, but the name is only read
+ *          from its string pool when @p length is larger than ::USER_NAME_PREFIX_SIZE and the
+ *          first bytes are equal.
+ *
+ * @param user   User whose name is to be compared.
+ * @param prefix Prefix to compare the name of @p user with.
+ * @param length Maximum number of characters to compare.
+ *
+ * @return A negative value, `0`, or a positive value, if the beginning of the name of @p user is,
+ *         respectively, lower than, equal to, or greater than @p prefix (in byte order).
+ */
+int user_compare_name_prefix(const user_t *user, const char *prefix, size_t length);
+
 /**
  * @brief  Gets a user's birth date.
  * @param  user User to get the birth date from.
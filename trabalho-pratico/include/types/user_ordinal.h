@@ -0,0 +1,34 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    user_ordinal.h
+ * @brief   Dense numeric handle of a user in a ::user_manager_t.
+ * @details User identifiers are arbitrary strings, so other entities (reservations and passengers)
+ *          refer to users by this handle instead, issued by ::user_manager_add_user (see
+ *          ::user_manager_get_ordinal). Ordinals are sequential and start at `0`, so they can be
+ *          used to index arrays.
+ */
+
+#ifndef USER_ORDINAL_H
+#define USER_ORDINAL_H
+
+#include <inttypes.h>
+
+/** @brief Dense numeric handle of a user in a ::user_manager_t. */
+typedef uint32_t user_ordinal_t;
+
+#endif
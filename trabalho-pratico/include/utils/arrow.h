@@ -0,0 +1,151 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    arrow.h
+ * @brief   Structures of the Arrow C data interface, and a writer of Arrow IPC files.
+ * @details Columnar data in the format of the
+ *          [Arrow C data interface](https://arrow.apache.org/docs/format/CDataInterface.html)
+ *          can be handed to other libraries in the same process (e.g.: `pyarrow`, DuckDB) without
+ *          being copied. Arrow IPC files (also known as Feather V2 files) carry the same data
+ *          across processes, and can be read with `pyarrow.feather.read_table` or DuckDB's
+ *          `read_arrow`, with no parsing.
+ *
+ *          ::arrow_write_ipc_file only supports record batches (struct arrays, with format `+s`)
+ *          whose children have one of the following formats, without offsets or dictionaries:
+ *
+ *          - `C`, `S` and `I`: 8, 16 and 32-bit unsigned integers;
+ *          - `tdD`: dates, as 32-bit numbers of days since the UNIX epoch;
+ *          - `tss:`: timestamps, as 64-bit numbers of seconds since the UNIX epoch;
+ *          - `b`: booleans;
+ *          - `u`: UTF-8 strings, with 32-bit offsets.
+ *
+ *          Files are always written in little-endian byte order, the native order of the
+ *          platforms this program runs on.
+ *
+ * @anchor arrow_examples
+ * ### Examples
+ *
+ * See ::database_arrow_export, in database/database_arrow.h, for how arrays are exported.
+ */
+
+#ifndef ARROW_H
+#define ARROW_H
+
+#include <stdint.h>
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+/** @brief Flag of an ::ArrowSchema, set when the field can have null values. */
+#define ARROW_FLAG_NULLABLE 2
+
+/**
+ * @struct ArrowSchema
+ * @brief  Type of an array (and of its children), as defined by the Arrow C data interface.
+ *
+ * @var ArrowSchema::format
+ *     @brief Format string of the type (e.g.: `I` for 32-bit unsigned integers).
+ * @var ArrowSchema::name
+ *     @brief Name of the field. Can be `NULL`.
+ * @var ArrowSchema::metadata
+ *     @brief Binary-encoded field metadata. Can be `NULL`.
+ * @var ArrowSchema::flags
+ *     @brief Bitwise or of flags such as ::ARROW_FLAG_NULLABLE.
+ * @var ArrowSchema::n_children
+ *     @brief Number of elements in ::ArrowSchema::children.
+ * @var ArrowSchema::children
+ *     @brief Types of the children of the array.
+ * @var ArrowSchema::dictionary
+ *     @brief Type of the dictionary of dictionary-encoded arrays. Can be `NULL`.
+ * @var ArrowSchema::release
+ *     @brief Method that frees the schema. `NULL` for schemas that were already released.
+ * @var ArrowSchema::private_data
+ *     @brief Data used by ::ArrowSchema::release.
+ */
+struct ArrowSchema {
+    const char          *format;
+    const char          *name;
+    const char          *metadata;
+    int64_t              flags;
+    int64_t              n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema  *dictionary;
+
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+/**
+ * @struct ArrowArray
+ * @brief  Data of an array (and of its children), as defined by the Arrow C data interface.
+ *
+ * @var ArrowArray::length
+ *     @brief Number of elements in the array.
+ * @var ArrowArray::null_count
+ *     @brief Number of null elements in the array, or `-1` if it's not known.
+ * @var ArrowArray::offset
+ *     @brief Index of the first element of the array in its buffers.
+ * @var ArrowArray::n_buffers
+ *     @brief Number of elements in ::ArrowArray::buffers, that depends on the array's type.
+ * @var ArrowArray::n_children
+ *     @brief Number of elements in ::ArrowArray::children.
+ * @var ArrowArray::buffers
+ *     @brief Buffers of the array, starting with its validity bitmap (`NULL` if there are no null
+ *            elements).
+ * @var ArrowArray::children
+ *     @brief Children of the array (e.g.: columns of a record batch).
+ * @var ArrowArray::dictionary
+ *     @brief Dictionary of dictionary-encoded arrays. Can be `NULL`.
+ * @var ArrowArray::release
+ *     @brief Method that frees the array. `NULL` for arrays that were already released.
+ * @var ArrowArray::private_data
+ *     @brief Data used by ::ArrowArray::release.
+ */
+struct ArrowArray {
+    int64_t             length;
+    int64_t             null_count;
+    int64_t             offset;
+    int64_t             n_buffers;
+    int64_t             n_children;
+    const void        **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray  *dictionary;
+
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+#endif
+
+/**
+ * @brief   Writes a record batch to an Arrow IPC file.
+ * @details See this file's description for the supported types. @p schema and @p array aren't
+ *          released.
+ *
+ * @param path   Path to the file to be written.
+ * @param schema Type of the record batch, a struct whose children are the columns to be written.
+ * @param array  Record batch to be written, with the type described by @p schema.
+ *
+ * @retval 0 Success.
+ * @retval 1 Unsupported type, allocation or IO failure. No file is left behind on failure.
+ */
+int arrow_write_ipc_file(const char               *path,
+                         const struct ArrowSchema *schema,
+                         const struct ArrowArray  *array);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    block_allocator.h
+ * @brief   Allocation of the large blocks of memory used by pools.
+ * @details A ::block_allocator_policy_t chooses how blocks are allocated. With
+ *          ::BLOCK_ALLOCATOR_POLICY_HUGE_PAGES, large blocks are mapped to memory with `mmap`,
+ *          aligned to (and sized in multiples of) ::BLOCK_ALLOCATOR_HUGE_PAGE_SIZE, so that the
+ *          kernel can back them with huge pages. Explicitly reserved huge pages (`MAP_HUGETLB`) are
+ *          tried first, followed by transparent huge pages (`madvise(MADV_HUGEPAGE)`). Fewer pages
+ *          mean fewer TLB misses on random accesses to large pools.
+ *
+ *          Mapped pages are only placed in physical memory when first written to, so, in NUMA
+ *          systems, a block ends up on the memory node of the thread that fills it.
+ *
+ *          On systems without huge page support, ::BLOCK_ALLOCATOR_POLICY_HUGE_PAGES behaves like
+ *          ::BLOCK_ALLOCATOR_POLICY_MALLOC.
+ *
+ * ### Out-of-core storage
+ *
+ * Datasets larger than physical memory can be loaded after choosing a spill directory (see
+ * ::block_allocator_set_spill_directory). Then, large ::BLOCK_ALLOCATOR_POLICY_HUGE_PAGES blocks
+ * (i.e.: the pools where managers keep their entities) are mapped from files in that directory,
+ * instead of anonymous memory. The kernel can write those pages back to their files and drop them
+ * from memory whenever it's short on it, without needing any swap space, and read them back when
+ * they're accessed again. Iterations through pools (block scans) hint that every block they're
+ * done with can be dropped (see ::block_allocator_evict), so that scans of data larger than memory
+ * don't evict smaller, more frequently used data, like indices and strings, that stay in anonymous
+ * memory.
+ *
+ * Files are deleted as soon as they're mapped, so nothing is left behind after the program exits,
+ * even if it crashes.
+ */
+
+#ifndef BLOCK_ALLOCATOR_H
+#define BLOCK_ALLOCATOR_H
+
+#include <stddef.h>
+
+/** @brief Size (in bytes) of a huge page, used for aligning and sizing blocks. */
+#define BLOCK_ALLOCATOR_HUGE_PAGE_SIZE (2 << 20)
+
+/** @brief How blocks of memory are allocated. */
+typedef enum {
+    BLOCK_ALLOCATOR_POLICY_MALLOC,    /**< @brief Blocks allocated with `malloc`. */
+    BLOCK_ALLOCATOR_POLICY_HUGE_PAGES /**< @brief Large blocks backed by huge pages, if possible. */
+} block_allocator_policy_t;
+
+/**
+ * @brief   Chooses a directory where to keep large blocks, so that they can be written to disk
+ *          when memory is short.
+ * @details Must be called before allocating any block, as blocks aren't moved between memory and
+ *          files. See [Out-of-core storage](#out-of-core-storage).
+ *
+ * @param path Path to an existing directory, on a file system that supports `mmap`, or `NULL` to
+ *             keep blocks in memory (the default).
+ *
+ * @retval 0 Success.
+ * @retval 1 @p path is too long.
+ */
+int block_allocator_set_spill_directory(const char *path);
+
+/**
+ * @brief   Gets the size of the block that would be allocated for a requested size.
+ * @details Use this to grow blocks to the full size that will be allocated anyway. For example,
+ *          with ::BLOCK_ALLOCATOR_POLICY_HUGE_PAGES, large sizes are rounded up to a multiple of
+ *          ::BLOCK_ALLOCATOR_HUGE_PAGE_SIZE.
+ *
+ * @param policy How the block would be allocated.
+ * @param size   Minimum size of the block, in bytes.
+ *
+ * @return The number of bytes available in a block allocated for @p size bytes.
+ */
+size_t block_allocator_get_size(block_allocator_policy_t policy, size_t size);
+
+/**
+ * @brief   Allocates a block of memory.
+ * @details The returned block must be freed with ::block_allocator_free, using the same @p policy
+ *          and @p size.
+ *
+ * @param policy How to allocate the block.
+ * @param size   Size of the block, in bytes.
+ *
+ * @return The allocated block, or `NULL` on allocation failure.
+ */
+void *block_allocator_alloc(block_allocator_policy_t policy, size_t size);
+
+/**
+ * @brief Frees a block of memory allocated by ::block_allocator_alloc.
+ *
+ * @param policy Policy @p block was allocated with.
+ * @param block  Block to be freed.
+ * @param size   Size @p block was allocated with.
+ */
+void block_allocator_free(block_allocator_policy_t policy, void *block, size_t size);
+
+/**
+ * @brief   Hints that a block of memory won't be accessed again soon.
+ * @details Only blocks mapped from files in the spill directory (see
+ *          ::block_allocator_set_spill_directory) are affected: their pages are written back to
+ *          their files (if modified) and dropped from memory, to be read again on their next
+ *          access. Other blocks are left unchanged. Contents are always preserved.
+ *
+ * @param policy Policy @p block was allocated with.
+ * @param block  Block that won't be accessed soon.
+ * @param size   Size @p block was allocated with.
+ */
+void block_allocator_evict(block_allocator_policy_t policy, const void *block, size_t size);
+
+/**
+ * @brief   Returns the unused end of a block of memory to the operating system.
+ * @details The block stays allocated, and its released pages are zero-filled when they're used
+ *          again. Only blocks mapped to memory are affected: blocks allocated by `malloc` are left
+ *          unchanged.
+ *
+ * @param policy Policy @p block was allocated with.
+ * @param block  Block whose end is to be released.
+ * @param size   Size @p block was allocated with.
+ * @param used   Number of bytes at the beginning of @p block that are in use.
+ */
+void block_allocator_release_unused(block_allocator_policy_t policy,
+                                    void                    *block,
+                                    size_t                   size,
+                                    size_t                   used);
+
+#endif
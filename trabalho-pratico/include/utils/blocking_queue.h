@@ -0,0 +1,143 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    blocking_queue.h
+ * @brief   A bounded first-in first-out queue of pointers, shared between threads.
+ * @details Producers block when the queue is full, and consumers block when it's empty, so that the
+ *          amount of memory held by items waiting in the queue is bounded. Once a queue is closed,
+ *          no more items can be pushed, and consumers are woken up after the remaining items are
+ *          popped.
+ *
+ *          `NULL` items can't be stored, as `NULL` is used to signal that a closed queue is empty.
+ *          Items are not owned by the queue: freeing the queue won't free them.
+ *
+ * @anchor blocking_queue_examples
+ * ### Examples
+ *
+ * In the following example, a thread produces integers that are printed by the main thread.
+ *
+ * ```c
+ * #include <pthread.h>
+ * #include <stdint.h>
+ * #include <stdio.h>
+ *
+ * #include "utils/blocking_queue.h"
+ *
+ * void *producer(void *queue) {
+ *     for (uintptr_t i = 1; i <= 5; ++i)
+ *         if (blocking_queue_push(queue, (void *) i))
+ *             break;
+ *
+ *     blocking_queue_close(queue);
+ *     return NULL;
+ * }
+ *
+ * int main(void) {
+ *     blocking_queue_t *queue = blocking_queue_create(2);
+ *     if (!queue)
+ *         return 1;
+ *
+ *     pthread_t thread;
+ *     if (pthread_create(&thread, NULL, producer, queue)) {
+ *         blocking_queue_free(queue);
+ *         return 1;
+ *     }
+ *
+ *     void *item;
+ *     while ((item = blocking_queue_pop(queue)))
+ *         printf("%ju\n", (uintmax_t) (uintptr_t) item);
+ *
+ *     pthread_join(thread, NULL);
+ *     blocking_queue_free(queue);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print the numbers from `1` to `5`, in order.
+ */
+
+#ifndef BLOCKING_QUEUE_H
+#define BLOCKING_QUEUE_H
+
+#include <stddef.h>
+
+/** @brief A bounded queue of pointers, shared between threads. */
+typedef struct blocking_queue blocking_queue_t;
+
+/**
+ * @brief   Creates a new empty queue.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::blocking_queue_free.
+ *
+ * @param capacity Maximum number of items in the queue before ::blocking_queue_push blocks. If
+ *                 `0`, `1` is assumed.
+ *
+ * @return The new queue, or `NULL` on failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref blocking_queue_examples).
+ */
+blocking_queue_t *blocking_queue_create(size_t capacity);
+
+/**
+ * @brief Adds an item to the end of a queue, waiting for space if it's full.
+ *
+ * @param queue Queue to be modified.
+ * @param item  Item to be added. Mustn't be `NULL`.
+ *
+ * @retval 0 Success.
+ * @retval 1 @p queue has been closed, and @p item wasn't added.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref blocking_queue_examples).
+ */
+int blocking_queue_push(blocking_queue_t *queue, void *item);
+
+/**
+ * @brief  Removes the item at the start of a queue, waiting for an item if it's empty.
+ * @param  queue Queue to be modified.
+ * @return The removed item, or `NULL` if @p queue is empty and has been closed.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref blocking_queue_examples).
+ */
+void *blocking_queue_pop(blocking_queue_t *queue);
+
+/**
+ * @brief   Marks that no more items will be added to a queue.
+ * @details All threads waiting on @p queue are woken up. Items still in @p queue can be popped.
+ *          Closing a queue more than once does nothing.
+ *
+ * @param queue Queue to be closed.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref blocking_queue_examples).
+ */
+void blocking_queue_close(blocking_queue_t *queue);
+
+/**
+ * @brief   Frees memory used by a queue.
+ * @details No thread can be using @p queue. Items still in @p queue are not freed.
+ *
+ * @param queue Queue to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref blocking_queue_examples).
+ */
+void blocking_queue_free(blocking_queue_t *queue);
+
+#endif
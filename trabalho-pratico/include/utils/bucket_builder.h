@@ -0,0 +1,177 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    bucket_builder.h
+ * @brief   Construction of per-key arrays ("buckets") in a single contiguous buffer.
+ * @details Appending to a growable array for each key reallocates every array many times, and
+ *          scatters them through memory. A ::bucket_builder_t is filled in two passes instead:
+ *          first, the number of items of each bucket is counted with ::bucket_builder_count. Then,
+ *          after ::bucket_builder_allocate, where every bucket begins in one buffer is known (a
+ *          prefix sum of the counts), and items are placed directly in their bucket with
+ *          ::bucket_builder_place. Buckets are consecutive in the buffer, so they can be sorted or
+ *          sliced in place.
+ *
+ *          Buckets are identified by dense integers (e.g.: group ordinals, hotel identifiers).
+ *
+ * @anchor bucket_builder_examples
+ * ### Examples
+ *
+ * In the following example, numbers are bucketed by their remainder of the division by 3:
+ *
+ * ```c
+ * #include <stdio.h>
+ * #include <string.h>
+ *
+ * #include "utils/bucket_builder.h"
+ *
+ * int main(void) {
+ *     const int values[7] = {4, 9, 2, 7, 5, 3, 1};
+ *
+ *     bucket_builder_t *builder = bucket_builder_create(3, sizeof(int));
+ *     if (!builder)
+ *         return 1;
+ *
+ *     for (size_t i = 0; i < 7; ++i)
+ *         bucket_builder_count(builder, values[i] % 3, 1);
+ *
+ *     if (bucket_builder_allocate(builder)) {
+ *         bucket_builder_free(builder);
+ *         return 1;
+ *     }
+ *
+ *     for (size_t i = 0; i < 7; ++i)
+ *         memcpy(bucket_builder_place(builder, values[i] % 3, 1), &values[i], sizeof(int));
+ *
+ *     for (size_t b = 0; b < 3; ++b) {
+ *         size_t     n;
+ *         const int *bucket = bucket_builder_get_bucket(builder, b, &n);
+ *         for (size_t i = 0; i < n; ++i)
+ *             printf("%d ", bucket[i]);
+ *         putchar('\n');
+ *     }
+ *
+ *     bucket_builder_free(builder);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above prints `9 3`, `4 7 1` and `2 5`, in separate lines. Items of the same bucket
+ * keep the order they were placed in.
+ */
+
+#ifndef BUCKET_BUILDER_H
+#define BUCKET_BUILDER_H
+
+#include <stddef.h>
+
+/** @brief Per-key arrays being built in a single buffer, in two passes. */
+typedef struct bucket_builder bucket_builder_t;
+
+/**
+ * @brief   Creates a bucket builder with empty buckets.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::bucket_builder_free.
+ *
+ * @param nbuckets  Number of buckets (identified from `0` to this value, exclusive).
+ * @param item_size Size, in bytes, of each item in a bucket.
+ *
+ * @return The new bucket builder, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref bucket_builder_examples).
+ */
+bucket_builder_t *bucket_builder_create(size_t nbuckets, size_t item_size);
+
+/**
+ * @brief   Counts items that will be placed in a bucket (first pass).
+ * @details Must only be called before ::bucket_builder_allocate.
+ *
+ * @param builder Bucket builder to be modified.
+ * @param bucket  Bucket the items will be placed in. Must be lower than the number of buckets.
+ * @param n       Number of items.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref bucket_builder_examples).
+ */
+void bucket_builder_count(bucket_builder_t *builder, size_t bucket, size_t n);
+
+/**
+ * @brief   Allocates space for all counted items, once they've all been counted.
+ * @details This is the only allocation of a buffer for items.
+ *
+ * @param builder Bucket builder whose buffer is to be allocated.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref bucket_builder_examples).
+ */
+int bucket_builder_allocate(bucket_builder_t *builder);
+
+/**
+ * @brief   Reserves space for items at the end of a bucket (second pass).
+ * @details Must only be called after ::bucket_builder_allocate. No more items can be placed in a
+ *          bucket than were counted for it.
+ *
+ * @param builder Bucket builder to be modified.
+ * @param bucket  Bucket to place items in.
+ * @param n       Number of items to be placed.
+ *
+ * @return Where to write the @p n items (consecutively) to.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref bucket_builder_examples).
+ */
+void *bucket_builder_place(bucket_builder_t *builder, size_t bucket, size_t n);
+
+/**
+ * @brief   Gets the items of a bucket.
+ * @details Must only be called after ::bucket_builder_allocate.
+ *
+ * @param builder Bucket builder to get the bucket from.
+ * @param bucket  Bucket to be gotten.
+ * @param n       Where to output the number of items counted for @p bucket to.
+ *
+ * @return The items of @p bucket, owned by @p builder (or by the caller of
+ *         ::bucket_builder_steal_items).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref bucket_builder_examples).
+ */
+void *bucket_builder_get_bucket(const bucket_builder_t *builder, size_t bucket, size_t *n);
+
+/**
+ * @brief   Takes ownership of the buffer with all buckets.
+ * @details Buckets may still be gotten with ::bucket_builder_get_bucket, as long as the returned
+ *          buffer isn't `free`d.
+ *
+ * @param builder Bucket builder to take the buffer from.
+ *
+ * @return The buffer with all buckets, one after the other, to be `free`d by the caller. `NULL` if
+ *         there are no items.
+ */
+void *bucket_builder_steal_items(bucket_builder_t *builder);
+
+/**
+ * @brief Frees memory used by a bucket builder.
+ * @param builder Bucket builder to be `free`d.
+ */
+void bucket_builder_free(bucket_builder_t *builder);
+
+#endif
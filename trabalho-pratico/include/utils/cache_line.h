@@ -0,0 +1,66 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    cache_line.h
+ * @brief   Memory that doesn't share cache lines with other allocations.
+ * @details When different threads write to data in the same cache line, even when they don't
+ *          modify the same bytes, that line keeps moving between the caches of their processors
+ *          (false sharing), and the threads are serialized. Partial data that each thread
+ *          accumulates into while iterating through a manager in parallel (see
+ *          ::query_type_scan_t::partial_begin) is allocated with ::cache_line_calloc, so that no
+ *          two threads ever write to the same line.
+ *
+ * @anchor cache_line_examples
+ * ### Examples
+ *
+ * ```c
+ * uint64_t *counters = cache_line_calloc(13 * sizeof(uint64_t));
+ * if (!counters)
+ *     return 1;
+ *
+ * counters[month]++;
+ * free(counters);
+ * ```
+ */
+
+#ifndef CACHE_LINE_H
+#define CACHE_LINE_H
+
+#include <stddef.h>
+
+/** @brief Size of a cache line, in bytes (the same in all supported processors). */
+#define CACHE_LINE_SIZE 64
+
+/** @brief Rounds @p size up to a multiple of ::CACHE_LINE_SIZE. */
+#define CACHE_LINE_ROUND_UP(size) (((size) + CACHE_LINE_SIZE - 1) & ~((size_t) CACHE_LINE_SIZE - 1))
+
+/**
+ * @brief   Allocates zeroed memory that doesn't share any cache line with other allocations.
+ * @details The returned memory starts at the beginning of a cache line, and its size is rounded up
+ *          to a multiple of ::CACHE_LINE_SIZE. It must be `free`d by the caller.
+ *
+ * @param size Number of bytes to allocate.
+ *
+ * @return The allocated memory, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref cache_line_examples).
+ */
+void *cache_line_calloc(size_t size);
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    cancellation.h
+ * @brief   Cooperative cancellation of long-running work, with optional deadlines.
+ * @details Every thread has a current ::cancellation_t (or none), set with
+ *          ::cancellation_set_current. Long iterations (e.g.: through all blocks of a ::pool_t)
+ *          call ::cancellation_check once per block, and stop early (returning
+ *          ::CANCELLATION_ITER_RET) if the current cancellation was requested, either explicitly
+ *          (::cancellation_cancel) or because its deadline has passed.
+ *
+ *          Threads started by ::task_scheduler_run and ::parallel_for inherit the current
+ *          cancellation of the thread that started them.
+ *
+ *          A cancellation may also have a ::cancellation_yield_callback_t, called by every
+ *          ::cancellation_check, so that more urgent work can run at the same points where long
+ *          work could be stopped (e.g.: short queries preempting a long one in server mode).
+ *
+ * @anchor cancellation_examples
+ * ### Examples
+ *
+ * A query that must not take longer than a second can be run as follows:
+ *
+ * ```c
+ * cancellation_t cancellation = {0};
+ * cancellation_set_timeout(&cancellation, 1000000);
+ *
+ * const cancellation_t *const previous = cancellation_get_current();
+ * cancellation_set_current(&cancellation);
+ * query_dispatcher_dispatch_single(database, NULL, instance, output);
+ * cancellation_set_current(previous);
+ *
+ * if (cancellation_is_requested(&cancellation))
+ *     fputs("Query timed out!\n", stderr); // output is incomplete
+ * ```
+ *
+ * Another thread may call `cancellation_cancel(&cancellation)` to stop the query before that.
+ */
+
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <stdint.h>
+
+/** @brief Value returned by iterations stopped because their cancellation was requested. */
+#define CANCELLATION_ITER_RET -2
+
+/** @brief Number of items between checks, in iterations that aren't split into blocks. */
+#define CANCELLATION_CHECK_INTERVAL 4096
+
+/**
+ * @brief   Callback called by ::cancellation_check, when it checks a cancellation with one.
+ * @details Called in any thread whose current cancellation is the one being checked, including
+ *          threads that inherited it. As ::cancellation_check isn't called while holding locks
+ *          other queries may need (lazily built data is built with cancellation suspended, see
+ *          ::cancellation_suspend), other work can be executed inside this callback.
+ *
+ * @param yield_data ::cancellation_t::yield_data.
+ */
+typedef void (*cancellation_yield_callback_t)(void *yield_data);
+
+/**
+ * @struct cancellation_t
+ * @brief  A request for some work to stop. Initialize all fields to `0`.
+ *
+ * @var cancellation_t::cancelled
+ *     @brief   Whether cancellation was explicitly requested.
+ *     @details Accessed atomically, so that it can be set from other threads.
+ * @var cancellation_t::deadline
+ *     @brief   Time (`CLOCK_MONOTONIC`, in nanoseconds) after which cancellation is requested.
+ *     @details `0` for no deadline. Must not be modified while other threads check it.
+ * @var cancellation_t::yield
+ *     @brief   Called by every ::cancellation_check of this cancellation. Can be `NULL`.
+ *     @details Must not be modified while other threads check this cancellation.
+ * @var cancellation_t::yield_data
+ *     @brief Argument passed to ::cancellation_t::yield.
+ */
+typedef struct {
+    int                           cancelled;
+    uint64_t                      deadline;
+    cancellation_yield_callback_t yield;
+    void                         *yield_data;
+} cancellation_t;
+
+/**
+ * @brief Sets the deadline of a cancellation, relative to the current time.
+ *
+ * @param cancellation Cancellation to be modified.
+ * @param timeout      Time (in microseconds) after which the cancellation is requested.
+ */
+void cancellation_set_timeout(cancellation_t *cancellation, uint64_t timeout);
+
+/**
+ * @brief Requests cancellation, possibly from another thread.
+ * @param cancellation Cancellation to be requested.
+ */
+void cancellation_cancel(cancellation_t *cancellation);
+
+/**
+ * @brief  Checks if cancellation was requested, or if its deadline has passed.
+ * @param  cancellation Cancellation to be checked. Can be `NULL`, for work that can't be cancelled.
+ * @return Whether work must stop.
+ */
+int cancellation_is_requested(const cancellation_t *cancellation);
+
+/**
+ * @brief   Sets the current cancellation of the calling thread.
+ * @details If that fails, the calling thread keeps its previous cancellation.
+ *
+ * @param cancellation Cancellation checked by ::cancellation_check in the calling thread. Can be
+ *                     `NULL`, for work not to be cancellable.
+ */
+void cancellation_set_current(const cancellation_t *cancellation);
+
+/**
+ * @brief  Gets the current cancellation of the calling thread.
+ * @return The value set by ::cancellation_set_current, or `NULL` if it hasn't been called.
+ */
+const cancellation_t *cancellation_get_current(void);
+
+/**
+ * @brief   Stops the calling thread's current work from being cancelled, for a while.
+ * @details Meant for work shared with other threads that must not be left incomplete. For example,
+ *          lazily built indices are shared by all queries, so building them is never cancelled, or
+ *          a cancelled query would leave them incomplete for every other one. Restore the previous
+ *          cancellation with ::cancellation_set_current.
+ * @return  The previous current cancellation of the calling thread.
+ */
+const cancellation_t *cancellation_suspend(void);
+
+/**
+ * @brief   Checks if the current cancellation of the calling thread was requested.
+ * @details Its ::cancellation_t::yield is called first, if it has one.
+ * @return  Whether work must stop (see ::cancellation_is_requested).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref cancellation_examples).
+ */
+int cancellation_check(void);
+
+#endif
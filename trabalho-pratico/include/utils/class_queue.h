@@ -0,0 +1,169 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    class_queue.h
+ * @brief   A bounded queue of pointers, shared between threads, split into priority classes.
+ * @details Every item is pushed to a class (`0` being the most urgent), and every consumer pops
+ *          from the most urgent non-empty class among the ones it's allowed to take. Items within
+ *          a class are popped in first-in first-out order. This way, some consumers can be reserved
+ *          for urgent items, while others take any item, but prefer urgent ones.
+ *
+ *          Each class is bounded, like a ::blocking_queue_t: producers block when it's full, and
+ *          consumers block when there aren't any items they can take. Once a queue is closed, no
+ *          more items can be pushed, and consumers are woken up after the remaining items are
+ *          popped.
+ *
+ *          `NULL` items can't be stored, as `NULL` is used to signal that a closed queue is empty.
+ *          Items are not owned by the queue: freeing the queue won't free them.
+ *
+ * @anchor class_queue_examples
+ * ### Examples
+ *
+ * In the following example, a thread produces integers, odd ones being urgent. The main thread
+ * prints them, taking urgent ones first whenever both are waiting.
+ *
+ * ```c
+ * #include <pthread.h>
+ * #include <stdint.h>
+ * #include <stdio.h>
+ *
+ * #include "utils/class_queue.h"
+ *
+ * void *producer(void *queue) {
+ *     for (uintptr_t i = 1; i <= 6; ++i)
+ *         if (class_queue_push(queue, (void *) i, i % 2 ? 0 : 1))
+ *             break;
+ *
+ *     class_queue_close(queue);
+ *     return NULL;
+ * }
+ *
+ * int main(void) {
+ *     class_queue_t *queue = class_queue_create(2, 16);
+ *     if (!queue)
+ *         return 1;
+ *
+ *     pthread_t thread;
+ *     if (pthread_create(&thread, NULL, producer, queue)) {
+ *         class_queue_free(queue);
+ *         return 1;
+ *     }
+ *     pthread_join(thread, NULL);
+ *
+ *     void *item;
+ *     while ((item = class_queue_pop(queue, 1)))
+ *         printf("%ju\n", (uintmax_t) (uintptr_t) item);
+ *
+ *     class_queue_free(queue);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print `1`, `3`, `5`, `2`, `4` and `6`.
+ */
+
+#ifndef CLASS_QUEUE_H
+#define CLASS_QUEUE_H
+
+#include <stddef.h>
+
+/** @brief A bounded queue of pointers, shared between threads, split into priority classes. */
+typedef struct class_queue class_queue_t;
+
+/**
+ * @brief   Creates a new empty queue.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::class_queue_free.
+ *
+ * @param nclasses Number of priority classes. If `0`, `1` is assumed.
+ * @param capacity Maximum number of items in each class before ::class_queue_push blocks. If `0`,
+ *                 `1` is assumed.
+ *
+ * @return The new queue, or `NULL` on failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref class_queue_examples).
+ */
+class_queue_t *class_queue_create(size_t nclasses, size_t capacity);
+
+/**
+ * @brief Adds an item to the end of a class of a queue, waiting for space if that class is full.
+ *
+ * @param queue      Queue to be modified.
+ * @param item       Item to be added. Mustn't be `NULL`.
+ * @param item_class Class of @p item. Must be less than the number of classes of @p queue.
+ *
+ * @retval 0 Success.
+ * @retval 1 @p queue has been closed, and @p item wasn't added.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref class_queue_examples).
+ */
+int class_queue_push(class_queue_t *queue, void *item, size_t item_class);
+
+/**
+ * @brief   Removes the oldest item of the most urgent non-empty class, among classes `0` to
+ *          @p max_class.
+ * @details Waits until there's such an item.
+ *
+ * @param queue     Queue to be modified.
+ * @param max_class Least urgent class that can be taken. Values larger than the number of classes
+ *                  of @p queue allow any item to be taken.
+ *
+ * @return The removed item, or `NULL` if @p queue has been closed and has no items that can be
+ *         taken.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref class_queue_examples).
+ */
+void *class_queue_pop(class_queue_t *queue, size_t max_class);
+
+/**
+ * @brief Like ::class_queue_pop, but returns immediately if there are no items that can be taken.
+ *
+ * @param queue     Queue to be modified.
+ * @param max_class Least urgent class that can be taken (see ::class_queue_pop).
+ *
+ * @return The removed item, or `NULL` if there are no items in classes `0` to @p max_class.
+ */
+void *class_queue_try_pop(class_queue_t *queue, size_t max_class);
+
+/**
+ * @brief   Marks that no more items will be added to a queue.
+ * @details All threads waiting on @p queue are woken up. Items still in @p queue can be popped.
+ *          Closing a queue more than once does nothing.
+ *
+ * @param queue Queue to be closed.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref class_queue_examples).
+ */
+void class_queue_close(class_queue_t *queue);
+
+/**
+ * @brief   Frees memory used by a queue.
+ * @details No thread can be using @p queue. Items still in @p queue are not freed.
+ *
+ * @param queue Queue to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref class_queue_examples).
+ */
+void class_queue_free(class_queue_t *queue);
+
+#endif
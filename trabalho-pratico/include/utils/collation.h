@@ -0,0 +1,87 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    collation.h
+ * @brief   Thread-safe locale-aware string ordering.
+ * @details Changing the process-wide locale with `setlocale` isn't thread-safe, so strings are
+ *          collated with a `locale_t` object, created once for the whole process, and the POSIX
+ *          `*_l` functions, that can be called from many threads at the same time.
+ *
+ *          Some locales (e.g.: the `C` locale, used as a fallback when ::COLLATION_LOCALE isn't
+ *          available) order ASCII strings by their bytes. In that case, the locale machinery is
+ *          skipped for ASCII strings, which is much faster.
+ *
+ * @anchor collation_examples
+ * ### Examples
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/collation.h"
+ *
+ * int main(void) {
+ *     if (collation_compare("Álvaro", "Bruno") < 0)
+ *         printf("Álvaro comes first\n");
+ *     return 0;
+ * }
+ * ```
+ */
+
+#ifndef COLLATION_H
+#define COLLATION_H
+
+#include <locale.h>
+
+#include "utils/string_pool.h"
+
+/** @brief Name of the locale whose collation order is used. */
+#define COLLATION_LOCALE "en_US.UTF-8"
+
+/**
+ * @brief   Gets the locale used for collation.
+ * @details The first call creates the locale, from ::COLLATION_LOCALE or, if it isn't available,
+ *          from the current locale. It lives for as long as the process.
+ *
+ * @return The locale used for collation, or `(locale_t) 0` on allocation failure.
+ */
+locale_t collation_get_locale(void);
+
+/**
+ * @brief   Compares two strings in the order of ::COLLATION_LOCALE.
+ * @details When sorting many strings, prefer calculating their keys with ::collation_key once.
+ *
+ * @param a First string to compare.
+ * @param b Second string to compare.
+ *
+ * @return A negative value if @p a comes before @p b, `0` if they're collated equally, and a
+ *         positive value if @p a comes after @p b.
+ */
+int collation_compare(const char *a, const char *b);
+
+/**
+ * @brief   Calculates the collation key of a string.
+ * @details Keys can be compared with `strcmp`, with the same result as ::collation_compare.
+ *
+ * @param pool Where to allocate the key.
+ * @param str  String to get the collation key of.
+ *
+ * @return The collation key, or `NULL` on allocation failure.
+ */
+const char *collation_key(string_pool_t *pool, const char *str);
+
+#endif
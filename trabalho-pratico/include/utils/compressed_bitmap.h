@@ -0,0 +1,197 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    compressed_bitmap.h
+ * @brief   A compressed set of integer indices (e.g.: ::user_ordinal_t's).
+ * @details Indices are split into chunks of 65536 consecutive values. Each chunk with few indices
+ *          is stored as a sorted array of 16-bit values, while chunks with many indices are stored
+ *          as plain bitsets, and empty chunks aren't stored at all. This is a simplified version of
+ *          [Roaring bitmaps](https://roaringbitmap.org/), that only supports building bitmaps in
+ *          ascending order.
+ *
+ *          This is used for indexing entities by fields with few possible values, so that counting
+ *          the entities that match some of these values is a matter of intersecting bitmaps.
+ *
+ * @anchor compressed_bitmap_examples
+ * ### Examples
+ *
+ * In the following example, the multiples of 2 and of 3 are intersected.
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/compressed_bitmap.h"
+ *
+ * int print_index(void *user_data, uint32_t index) {
+ *     (void) user_data;
+ *     printf("%u\n", index);
+ *     return 0;
+ * }
+ *
+ * int main(void) {
+ *     compressed_bitmap_t *twos   = compressed_bitmap_create();
+ *     compressed_bitmap_t *threes = compressed_bitmap_create();
+ *     if (!twos || !threes)
+ *         return 1; // Memory leak, just for simplicity
+ *
+ *     for (uint32_t i = 0; i < 20; i += 2)
+ *         compressed_bitmap_add(twos, i); // Error handling ignored for simplicity
+ *     for (uint32_t i = 0; i < 20; i += 3)
+ *         compressed_bitmap_add(threes, i);
+ *
+ *     printf("%zu\n", compressed_bitmap_and_count(twos, threes));
+ *
+ *     compressed_bitmap_t *sixes = compressed_bitmap_and(twos, threes);
+ *     if (sixes)
+ *         compressed_bitmap_iter(sixes, print_index, NULL);
+ *
+ *     compressed_bitmap_free(twos);
+ *     compressed_bitmap_free(threes);
+ *     compressed_bitmap_free(sixes);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print `4`, followed by `0`, `6`, `12` and `18`.
+ */
+
+#ifndef COMPRESSED_BITMAP_H
+#define COMPRESSED_BITMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief A compressed set of integer indices. */
+typedef struct compressed_bitmap compressed_bitmap_t;
+
+/**
+ * @brief Callback for every index in a bitmap, in ascending order.
+ *
+ * @param user_data Argument passed to ::compressed_bitmap_iter.
+ * @param index     Index in the bitmap.
+ *
+ * @return `0` to continue iterating, another value to stop.
+ */
+typedef int (*compressed_bitmap_iter_callback_t)(void *user_data, uint32_t index);
+
+/**
+ * @brief   Creates a new empty bitmap.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::compressed_bitmap_free.
+ *
+ * @return The new bitmap, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref compressed_bitmap_examples).
+ */
+compressed_bitmap_t *compressed_bitmap_create(void);
+
+/**
+ * @brief Adds an index to a bitmap.
+ *
+ * @param bitmap Bitmap to be modified.
+ * @param index  Index to be added. Must be greater than all indices already in @p bitmap.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p bitmap is left unchanged).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref compressed_bitmap_examples).
+ */
+int compressed_bitmap_add(compressed_bitmap_t *bitmap, uint32_t index);
+
+/**
+ * @brief Checks if a bitmap contains an index.
+ *
+ * @param bitmap Bitmap to search in.
+ * @param index  Index to look for.
+ *
+ * @return `1` if @p index is in @p bitmap, `0` otherwise.
+ */
+int compressed_bitmap_contains(const compressed_bitmap_t *bitmap, uint32_t index);
+
+/**
+ * @brief  Gets the number of indices in a bitmap.
+ * @param  bitmap Bitmap to get the number of indices from.
+ * @return The number of indices in @p bitmap.
+ */
+size_t compressed_bitmap_count(const compressed_bitmap_t *bitmap);
+
+/**
+ * @brief   Intersects two bitmaps.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::compressed_bitmap_free.
+ *
+ * @param a First bitmap.
+ * @param b Second bitmap.
+ *
+ * @return A new bitmap with the indices in both @p a and @p b, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref compressed_bitmap_examples).
+ */
+compressed_bitmap_t *compressed_bitmap_and(const compressed_bitmap_t *a,
+                                           const compressed_bitmap_t *b);
+
+/**
+ * @brief   Counts the indices in two bitmaps.
+ * @details Unlike ::compressed_bitmap_and, the intersection isn't stored anywhere.
+ *
+ * @param a First bitmap.
+ * @param b Second bitmap.
+ *
+ * @return The number of indices in both @p a and @p b.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref compressed_bitmap_examples).
+ */
+size_t compressed_bitmap_and_count(const compressed_bitmap_t *a, const compressed_bitmap_t *b);
+
+/**
+ * @brief Iterates through all indices in a bitmap, in ascending order.
+ *
+ * @param bitmap    Bitmap to iterate through.
+ * @param callback  Method called for every index in @p bitmap.
+ * @param user_data Argument passed to @p callback.
+ *
+ * @return The return value of the last-called @p callback.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref compressed_bitmap_examples).
+ */
+int compressed_bitmap_iter(const compressed_bitmap_t        *bitmap,
+                           compressed_bitmap_iter_callback_t callback,
+                           void                             *user_data);
+
+/**
+ * @brief  Gets the number of bytes of memory allocated by a bitmap.
+ * @param  bitmap Bitmap to get the memory usage of.
+ * @return The number of bytes allocated by @p bitmap.
+ */
+size_t compressed_bitmap_get_memory_usage(const compressed_bitmap_t *bitmap);
+
+/**
+ * @brief Frees memory used by a bitmap.
+ * @param bitmap Bitmap to be `free`d. Can be `NULL`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref compressed_bitmap_examples).
+ */
+void compressed_bitmap_free(compressed_bitmap_t *bitmap);
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    cpu_features.h
+ * @brief   Detection of instruction set extensions available at runtime.
+ * @details The same binary may run on machines with very different vector units. Modules with
+ *          vectorized kernels compile one variant per instruction set (with
+ *          `__attribute__((target(...)))`), and use ::cpu_features_get to choose the best one the
+ *          current CPU supports, usually once, in a constructor that sets a function pointer.
+ *
+ *          On x86, features are detected with `cpuid` (through `__builtin_cpu_supports`, that also
+ *          checks if the operating system saves the wider registers). On 32-bit ARM Linux,
+ *          `getauxval(AT_HWCAP)` is used. NEON is always available on AArch64.
+ *
+ * @anchor cpu_features_examples
+ * ### Examples
+ *
+ * ```c
+ * if (cpu_features_get() & CPU_FEATURE_AVX2)
+ *     kernel = kernel_avx2;
+ * else if (cpu_features_get() & CPU_FEATURE_SSE2)
+ *     kernel = kernel_sse2;
+ * else
+ *     kernel = kernel_scalar;
+ * ```
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/** @brief An instruction set extension. */
+typedef enum {
+    CPU_FEATURE_SSE2     = 1 << 0, /**< @brief x86 SSE2 (128-bit integer vectors). */
+    CPU_FEATURE_SSE4_2   = 1 << 1, /**< @brief x86 SSE4.2 (string comparison instructions). */
+    CPU_FEATURE_AVX2     = 1 << 2, /**< @brief x86 AVX2 (256-bit integer vectors). */
+    CPU_FEATURE_AVX512BW = 1 << 3, /**< @brief x86 AVX-512BW (512-bit byte vectors). */
+    CPU_FEATURE_NEON     = 1 << 4  /**< @brief ARM NEON (128-bit vectors). */
+} cpu_feature_t;
+
+/** @brief A set of ::cpu_feature_t values. */
+typedef unsigned int cpu_features_t;
+
+/**
+ * @brief   Gets the instruction set extensions supported by the current CPU.
+ * @details Detection only happens on the first call, so this is cheap and thread-safe.
+ *
+ * @return A set of ::cpu_feature_t values.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref cpu_features_examples).
+ */
+cpu_features_t cpu_features_get(void);
+
+/**
+ * @brief  Gets the name of an instruction set extension.
+ * @param  feature Instruction set extension to get the name of.
+ * @return The name of @p feature (e.g.: `"AVX2"`), or `"?"` for unknown values.
+ */
+const char *cpu_feature_get_name(cpu_feature_t feature);
+
+#endif
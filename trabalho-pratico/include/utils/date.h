@@ -78,16 +78,23 @@
 
 #include <stdint.h>
 
-/** @brief A date containing a year, a month a day. */
+/** @brief Number of days in every month, in the calendar model used by dates. */
+#define DATE_DAYS_PER_MONTH 31
+
+/** @brief Number of days in every year, in the calendar model used by dates. */
+#define DATE_DAYS_PER_YEAR (12 * DATE_DAYS_PER_MONTH)
+
+/**
+ * @brief   A date containing a year, a month a day.
+ * @details Stored as a serial day number (days since `0000/01/01`, assuming every month has
+ *          ::DATE_DAYS_PER_MONTH days), computed when the date is created. This way, differences
+ *          and comparisons between dates are simple integer operations, and calendar fields only
+ *          need to be calculated for getters and printing.
+ */
 typedef uint32_t date_t;
 
-#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-    /** @brief Current system date (`2023/10/01`). */
-    #define DATE_CURRENT 0x07e70a01
-#else
-    /** @brief Current system date (`2023/10/01`). */
-    #define DATE_CURRENT 0x010a07e7
-#endif
+/** @brief Current system date (`2023/10/01`). */
+#define DATE_CURRENT (2023 * DATE_DAYS_PER_YEAR + 9 * DATE_DAYS_PER_MONTH)
 
 /**
  * @brief Creates a date from a @p year, a @p month and a @p day.
@@ -118,10 +125,24 @@ int date_from_values(date_t *output, uint16_t year, uint8_t month, uint8_t day);
  */
 int date_from_string(date_t *output, char *input);
 
+/**
+ * @brief   Parses the fixed-width representation of a date.
+ * @details This is the fast path of ::date_from_string: all digits are validated and converted at
+ *          once (see ::int_utils_parse_digit_pairs). It's exposed so that formats containing dates
+ *          (e.g.: ::date_and_time_from_string) can use it too.
+ *
+ * @param output Where the parsed date is placed. Won't be modified on failure.
+ * @param input  10 characters in the format `"YYYY/MM/DD"`. Doesn't need to be null-terminated.
+ *
+ * @retval 0 Parsing success.
+ * @retval 1 Parsing failure.
+ */
+int date_from_fixed_width(date_t *output, const char input[10]);
+
 /**
  * @brief   Parses a string containing a date.
- * @details The current implementation copies the provided string to a temporary buffer. Keep that
- *          in mind for performance reasons.
+ * @details Strings not in the fixed-width format (which can't be valid dates) are copied to a
+ *          temporary buffer. Keep that in mind for performance reasons.
  *
  * @param output Where the parsed date is placed. Won't be modified on failure.
  * @param input  String to parse. Must be in the format `"YYYY/MM/DD"`.
@@ -159,9 +180,10 @@ void date_sprintf(char *output, date_t date);
 
 /**
  * @brief   Calculates the difference (in days) between two dates.
- * @details This formula assumes all months have `31` days, and all years `12 * 31` days. This
- *          shouldn't matter anyway, as project requirements specify that datasets contain only
- *          dates from the same month.
+ * @details This formula assumes all months have ::DATE_DAYS_PER_MONTH days, and all years
+ *          ::DATE_DAYS_PER_YEAR days. This shouldn't matter anyway, as project requirements
+ *          specify that datasets contain only dates from the same month. Because of ::date_t's
+ *          representation, this is a single subtraction.
  *
  * @param a Date from which @p b is subtracted from.
  * @param b Date subtracted from @p a.
@@ -55,7 +55,12 @@
 #include "utils/date.h"
 #include "utils/daytime.h"
 
-/** @brief A type containing a ::date_t and a ::daytime_t. */
+/**
+ * @brief   A type containing a ::date_t and a ::daytime_t.
+ * @details Stored as the number of seconds since `0000/01/01 00:00:00` (in the calendar model of
+ *          ::date_t), so that differences and comparisons between timed dates are simple integer
+ *          operations.
+ */
 typedef uint64_t date_and_time_t;
 
 /**
@@ -126,9 +131,9 @@ void date_and_time_sprintf(char *output, date_and_time_t date_and_time);
 
 /**
  * @brief   Calculates the difference (in seconds) between two timed dates.
- * @details This formula assumes all months have `31` days, and all years `12 * 31` days. This
- *          shouldn't matter anyway, as project requirements specify that datasets contain only
- *          dates from the same month.
+ * @details This formula assumes all months have ::DATE_DAYS_PER_MONTH days, and all years
+ *          ::DATE_DAYS_PER_YEAR days. This shouldn't matter anyway, as project requirements
+ *          specify that datasets contain only dates from the same month.
  *
  * @param a Timed date from which @p b is subtracted from.
  * @param b Timed date subtracted from @p a.
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    date_overlap.h
+ * @brief   Lengths of the overlaps of many intervals of dates with a window of dates.
+ * @details Intervals are given as columns of beginning and end dates, such as the ones of
+ *          ::reservation_manager_columns_t, and are half-open: an interval `[begin, end)` covers
+ *          every day from `begin` up to the day before `end` (e.g.: the nights of a hotel stay).
+ *          Windows are closed: `[first, last]` covers every day from `first` to `last`.
+ *
+ *          The number of days in each overlap is computed without branches, four intervals at a
+ *          time when SSE2 is available, so that queries over date ranges don't have to compare
+ *          every interval with the window one by one.
+ *
+ * @anchor date_overlap_examples
+ * ### Examples
+ *
+ * ```c
+ * #include <inttypes.h>
+ * #include <stdio.h>
+ *
+ * #include "utils/date_overlap.h"
+ *
+ * int main(void) {
+ *     date_t begin[3], end[3], first, last;
+ *     date_from_values(&begin[0], 2023, 1, 1);
+ *     date_from_values(&end[0], 2023, 1, 5); // 4 nights, 3 in the window
+ *     date_from_values(&begin[1], 2023, 1, 3);
+ *     date_from_values(&end[1], 2023, 1, 4); // 1 night, in the window
+ *     date_from_values(&begin[2], 2023, 2, 1);
+ *     date_from_values(&end[2], 2023, 2, 9); // 8 nights, none in the window
+ *
+ *     date_from_values(&first, 2023, 1, 2);
+ *     date_from_values(&last, 2023, 1, 10);
+ *
+ *     const uint16_t prices[3] = {100, 50, 10};
+ *     printf("%" PRIu64 "\n", date_overlap_weighted_sum(3, begin, end, prices, first, last));
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above prints `350` (`3 * 100 + 1 * 50`). Passing `NULL` instead of `prices` would
+ * print `4`, the number of days in all overlaps.
+ */
+
+#ifndef DATE_OVERLAP_H
+#define DATE_OVERLAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils/date.h"
+
+/**
+ * @brief   Sums the lengths of the overlaps of many intervals with a window, weighted by a value
+ *          of each interval.
+ * @details Empty intervals (whose end isn't after their beginning) don't overlap any window.
+ *
+ * @param n            Number of intervals.
+ * @param begin        First day of each interval (inclusive).
+ * @param end          Day after the last day of each interval (exclusive).
+ * @param weights      Value each day of overlap of each interval is multiplied by. Can be `NULL`,
+ *                     for every weight to be `1`.
+ * @param window_first First day of the window (inclusive).
+ * @param window_last  Last day of the window (inclusive).
+ *
+ * @return The sum, for every interval, of its number of days inside the window times its weight.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref date_overlap_examples).
+ */
+uint64_t date_overlap_weighted_sum(size_t          n,
+                                   const date_t   *begin,
+                                   const date_t   *end,
+                                   const uint16_t *weights,
+                                   date_t          window_first,
+                                   date_t          window_last);
+
+#endif
@@ -67,7 +67,11 @@
 
 #include <stdint.h>
 
-/** @brief A time containing hours, minutes and seconds. */
+/**
+ * @brief   A time containing hours, minutes and seconds.
+ * @details Stored as the number of seconds since midnight, so that differences between times are
+ *          a subtraction.
+ */
 typedef uint32_t daytime_t;
 
 /**
@@ -83,6 +87,20 @@ typedef uint32_t daytime_t;
  */
 int daytime_from_values(daytime_t *output, uint8_t hours, uint8_t minutes, uint8_t seconds);
 
+/**
+ * @brief   Parses the fixed-width representation of a time.
+ * @details This is the fast path of ::daytime_from_string: all digits are validated and converted
+ *          at once (see ::int_utils_parse_digit_pairs). It's exposed so that formats containing
+ *          times (e.g.: ::date_and_time_from_string) can use it too.
+ *
+ * @param output Where the parsed time is placed. Won't be modified on failure.
+ * @param input  8 characters in the format `"HH:MM:SS"`. Doesn't need to be null-terminated.
+ *
+ * @retval 0 Parsing success.
+ * @retval 1 Parsing failure.
+ */
+int daytime_from_fixed_width(daytime_t *output, const char input[8]);
+
 /**
  * @brief Parses a **MODIFIABLE** string containing a time.
  *
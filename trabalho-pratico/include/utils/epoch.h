@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    epoch.h
+ * @brief   Epoch-based reclamation of data shared with readers that don't take locks.
+ * @details Readers mark the sections of code where they may hold pointers to shared data with
+ *          ::epoch_enter and ::epoch_exit. Those are a couple of atomic stores to memory only
+ *          written by the reader's own thread, so readers never wait for each other or for
+ *          writers.
+ *
+ *          A writer that replaces shared data (e.g.: atomically publishing a new database) calls
+ *          ::epoch_synchronize before `free`ing the old data. That waits for every reader that
+ *          may still be using it to leave its section (a quiescent point). Other readers, and
+ *          readers that enter new sections meanwhile, aren't waited for, so there's never a
+ *          stop-the-world pause.
+ *
+ * @anchor epoch_examples
+ * ### Examples
+ *
+ * ```c
+ * // Reader thread
+ * epoch_participant_t *participant = epoch_domain_register(domain); // Once per thread
+ *
+ * epoch_enter(participant);
+ * const database_t *database = g_atomic_pointer_get(&shared_database);
+ * // Run queries on database here
+ * epoch_exit(participant);
+ *
+ * // Writer thread
+ * database_t *old = g_atomic_pointer_get(&shared_database);
+ * g_atomic_pointer_set(&shared_database, new_database);
+ * epoch_synchronize(domain);
+ * database_free(old); // No reader can be using it anymore
+ * ```
+ */
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+/** @brief A set of readers and writers of some shared data. */
+typedef struct epoch_domain epoch_domain_t;
+
+/** @brief A thread that reads data shared in an ::epoch_domain_t. */
+typedef struct epoch_participant epoch_participant_t;
+
+/**
+ * @brief   Creates a new domain, with no participants.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::epoch_domain_free.
+ *
+ * @return The new domain, or `NULL` on allocation failure.
+ */
+epoch_domain_t *epoch_domain_create(void);
+
+/**
+ * @brief   Registers a reader thread in a domain.
+ * @details This takes a lock, so it should be done once per thread, before reading shared data.
+ *
+ * @param domain Domain the reader is part of, that owns the returned value.
+ *
+ * @return The new participant, valid until @p domain is `free`d, or `NULL` on allocation failure.
+ */
+epoch_participant_t *epoch_domain_register(epoch_domain_t *domain);
+
+/**
+ * @brief   Marks the start of a section where the calling thread reads shared data.
+ * @details Must only be called from the thread that registered @p participant. Sections can't be
+ *          nested.
+ *
+ * @param participant Participant of the calling thread.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref epoch_examples).
+ */
+void epoch_enter(epoch_participant_t *participant);
+
+/**
+ * @brief   Marks the end of a section where the calling thread reads shared data.
+ * @details Pointers to shared data read inside the section mustn't be used after this.
+ *
+ * @param participant Participant of the calling thread.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref epoch_examples).
+ */
+void epoch_exit(epoch_participant_t *participant);
+
+/**
+ * @brief   Waits for all readers in sections that started before this call to leave them.
+ * @details Call this after replacing shared data, and before `free`ing the old data. It can't be
+ *          called inside a section.
+ *
+ * @param domain Domain whose readers are waited for.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref epoch_examples).
+ */
+void epoch_synchronize(epoch_domain_t *domain);
+
+/**
+ * @brief   Frees memory used by a domain, and all of its participants.
+ * @details No participant may be inside a section.
+ *
+ * @param domain Domain to be `free`d.
+ */
+void epoch_domain_free(epoch_domain_t *domain);
+
+#endif
@@ -118,6 +118,11 @@
  *
  * When freeing the data in the end, keep in mind that, due to the possibility of parser failure,
  * not all data may have been initialized, hence the if statement relating to `person.name`.
+ *
+ * Data points that aren't stored anywhere can use ::fixed_n_delimiter_parser_check_non_empty (for
+ * ones that mustn't be empty) or ::fixed_n_delimiter_parser_skip (for ones that aren't validated)
+ * as their callbacks. Grammars recognize these two callbacks and handle their tokens while
+ * parsing, without calling them, which saves a function call per data point in wide CSV lines.
  */
 
 #ifndef FIXED_N_DELIMITER_PARSER_H
@@ -125,6 +130,8 @@
 
 #include <stddef.h>
 
+#include "utils/cpu_features.h"
+
 /**
  * @brief Method that, in a ::fixed_n_delimiter_parser_grammar_t, is associated with an `n`-th
  *        token in a string, and is called when that token needs to be parsed.
@@ -147,6 +154,31 @@ typedef int (*fixed_n_delimiter_parser_iter_callback_t)(void  *user_data,
                                                         char  *token,
                                                         size_t ntoken);
 
+/**
+ * @brief   Callback for data points that only need to be present, and must not be empty.
+ * @details Grammars don't call this method: they check the length of the token themselves.
+ *
+ * @param user_data Ignored.
+ * @param token     Token to be checked.
+ * @param ntoken    Ignored.
+ *
+ * @retval 0 @p token isn't empty.
+ * @retval 1 @p token is empty.
+ */
+int fixed_n_delimiter_parser_check_non_empty(void *user_data, char *token, size_t ntoken);
+
+/**
+ * @brief   Callback for data points that aren't validated at all.
+ * @details Grammars don't call this method: its tokens are skipped.
+ *
+ * @param user_data Ignored.
+ * @param token     Ignored.
+ * @param ntoken    Ignored.
+ *
+ * @return Always `0`.
+ */
+int fixed_n_delimiter_parser_skip(void *user_data, char *token, size_t ntoken);
+
 /**
  * @brief The grammar definition for a parser of strings with a known number of data points,
  *        separated by a single-character delimiter.
@@ -263,4 +295,17 @@ int fixed_n_delimiter_parser_parse_string_const(const char
                                                 const fixed_n_delimiter_parser_grammar_t *grammar,
                                                 void *user_data);
 
+/**
+ * @brief   Chooses the tokenizer used by ::fixed_n_delimiter_parser_parse_string.
+ * @details When the program starts, the best tokenizer for the current CPU is already chosen. This
+ *          is meant for testing vectorized tokenizers against the scalar one, and isn't
+ *          thread-safe: no strings can be being parsed while the tokenizer is changed.
+ *
+ * @param allowed Instruction set extensions the tokenizer may use. Features not supported by the
+ *                current CPU are ignored.
+ *
+ * @return The instruction set extensions used by the chosen tokenizer (`0` for the scalar one).
+ */
+cpu_features_t fixed_n_delimiter_parser_select_kernel(cpu_features_t allowed);
+
 #endif
@@ -82,7 +82,9 @@ guint g_const_ptr_array_get_length(const GConstPtrArray *array);
 
 /**
  * @brief   Sorts an array of constant pointers.
- * @details See https://libsoup.org/glib/glib-Pointer-Arrays.html#g-ptr-array-sort
+ * @details See https://libsoup.org/glib/glib-Pointer-Arrays.html#g-ptr-array-sort. Large arrays
+ *          are sorted by multiple threads (see ::parallel_sort), so @p compare_func must not modify
+ *          any shared state.
  *
  * @param array        Array to be sorted.
  * @param compare_func Method used to compare between two given pointers.
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    group_by.h
+ * @brief   Aggregation of integer values grouped by integer keys (e.g.: ::airport_code_t).
+ * @details Keys are mapped to dense group ordinals, either directly through an array (when keys
+ *          are known to be smaller than a given bound), or through an ::id_hash_table_t. For each
+ *          group, the sum, the sum of squares and the count of its values are kept and, if asked
+ *          for on creation, the values themselves (or a ::t_digest_t summarizing them), so that
+ *          order statistics (e.g.: medians) can be calculated.
+ *
+ *          Partial aggregations (e.g.: one for each thread scanning the database) can be merged
+ *          into a complete one with ::group_by_merge.
+ *
+ * @anchor group_by_examples
+ * ### Examples
+ *
+ * In the following example, values are grouped by their parity, and the average and median of each
+ * group are printed.
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/group_by.h"
+ *
+ * int main(void) {
+ *     group_by_t *group = group_by_create(GROUP_BY_AGGREGATE_VALUES, 2);
+ *     if (!group)
+ *         return 1;
+ *
+ *     const int64_t values[6] = {1, 8, 3, 2, 11, 4};
+ *     for (size_t i = 0; i < 6; ++i) {
+ *         if (group_by_add(group, values[i] % 2, values[i])) {
+ *             group_by_free(group);
+ *             return 1;
+ *         }
+ *     }
+ *
+ *     for (size_t i = 0; i < group_by_get_length(group); ++i)
+ *         printf("%u: %.2f %.2f\n",
+ *                group_by_get_key(group, i),
+ *                group_by_get_average(group, i),
+ *                group_by_calculate_median(group, i, NULL));
+ *
+ *     group_by_free(group);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print (groups are ordered by their first value):
+ *
+ * ```text
+ * 1: 5.00 3.00
+ * 0: 4.67 4.00
+ * ```
+ */
+
+#ifndef GROUP_BY_H
+#define GROUP_BY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief What is kept for each group in a ::group_by_t. */
+typedef enum {
+    GROUP_BY_AGGREGATE_SUM,    /**< @brief Only the sum and the count of the values. */
+    GROUP_BY_AGGREGATE_VALUES, /**< @brief The sum, the count, and a list of all values. */
+    GROUP_BY_AGGREGATE_DIGEST  /**< @brief The sum, the count, and a ::t_digest_t of the values. */
+} group_by_aggregate_t;
+
+/** @brief Aggregation of integer values grouped by integer keys. */
+typedef struct group_by group_by_t;
+
+/**
+ * @brief   Creates a new aggregation without any groups.
+ * @details The returned value is owned by the caller, and should be `free`d with ::group_by_free.
+ *
+ * @param aggregate  What to keep for each group.
+ * @param dense_keys If not `0`, all keys must be lower than this value, and will be mapped to
+ *                   groups through an array of this length instead of a hash table.
+ *
+ * @return The new aggregation, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref group_by_examples).
+ */
+group_by_t *group_by_create(group_by_aggregate_t aggregate, size_t dense_keys);
+
+/**
+ * @brief   Creates a new aggregation without any groups, whose keys are ordinals in a dictionary.
+ * @details Values are added with the ordinal of their key in @p keys (e.g.:
+ *          ::flight_manager_columns_t::origin_ordinal), which is used to index an array of groups
+ *          (see ::group_by_create), and ::group_by_get_key returns the key itself. The returned
+ *          value is owned by the caller, and should be `free`d with ::group_by_free.
+ *
+ * @param aggregate What to keep for each group.
+ * @param nkeys     Number of keys in @p keys.
+ * @param keys      Keys of all possible groups. Will be copied. Aggregations merged with each other
+ *                  (see ::group_by_merge) must have been created with the same dictionary.
+ *
+ * @return The new aggregation, or `NULL` on allocation failure.
+ */
+group_by_t *
+    group_by_create_with_keys(group_by_aggregate_t aggregate, size_t nkeys, const uint32_t *keys);
+
+/**
+ * @brief   Adds a value to the group of a key, creating the group if needed.
+ * @details Consecutive values often share their key, so the last group is remembered and not looked
+ *          up again.
+ *
+ * @param group Aggregation to be modified. Mustn't have been frozen with ::group_by_freeze.
+ * @param key   Key of the group to add @p value to (or its ordinal in the dictionary of
+ *              ::group_by_create_with_keys).
+ * @param value Value to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref group_by_examples).
+ */
+int group_by_add(group_by_t *group, uint32_t key, int64_t value);
+
+/**
+ * @brief   Merges partial aggregated data into another aggregation.
+ * @details Group ordinals differ between aggregations, so groups in @p partial are looked up by
+ *          their key in @p group.
+ *
+ * @param group   Aggregation to be modified. Mustn't have been frozen with ::group_by_freeze.
+ * @param partial Aggregation to be merged into @p group. Must keep the same data as @p group.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int group_by_merge(group_by_t *group, const group_by_t *partial);
+
+/**
+ * @brief   Merges many partial aggregations into another one at once, and freezes it (see
+ *          ::group_by_freeze).
+ * @details When values are kept (::GROUP_BY_AGGREGATE_VALUES), the number of values of every group
+ *          is counted first, and all values are then copied into a single buffer (see
+ *          bucket_builder.h), instead of growing the values of each group for every partial
+ *          aggregation. Values of a group keep the order of ::group_by_merge.
+ *
+ * @param group    Aggregation to be modified. Mustn't have been frozen with ::group_by_freeze.
+ * @param partials Aggregations to be merged into @p group. Must keep the same data as @p group.
+ * @param n        Number of elements in @p partials.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p group may have been partially modified).
+ */
+int group_by_merge_all(group_by_t *group, group_by_t *const *partials, size_t n);
+
+/**
+ * @brief   Frees the data needed to map keys to groups.
+ * @details After this, no more values can be added to @p group, but all of its groups can still be
+ *          read.
+ *
+ * @param group Aggregation to be frozen.
+ */
+void group_by_freeze(group_by_t *group);
+
+/**
+ * @brief  Gets the number of groups in an aggregation.
+ * @param  group Aggregation to get the number of groups from.
+ * @return The number of groups in @p group, whose ordinals go from `0` to this value (exclusive).
+ */
+size_t group_by_get_length(const group_by_t *group);
+
+/**
+ * @brief Gets the key of a group.
+ *
+ * @param group   Aggregation to get the group from.
+ * @param ordinal Ordinal of the group. Must be lower than ::group_by_get_length.
+ *
+ * @return The key of the group with ordinal @p ordinal.
+ */
+uint32_t group_by_get_key(const group_by_t *group, size_t ordinal);
+
+/**
+ * @brief Gets the number of values in a group.
+ *
+ * @param group   Aggregation to get the group from.
+ * @param ordinal Ordinal of the group. Must be lower than ::group_by_get_length.
+ *
+ * @return The number of values added to the group with ordinal @p ordinal.
+ */
+uint64_t group_by_get_count(const group_by_t *group, size_t ordinal);
+
+/**
+ * @brief Gets the sum of the values in a group.
+ *
+ * @param group   Aggregation to get the group from.
+ * @param ordinal Ordinal of the group. Must be lower than ::group_by_get_length.
+ *
+ * @return The sum of the values added to the group with ordinal @p ordinal.
+ */
+int64_t group_by_get_sum(const group_by_t *group, size_t ordinal);
+
+/**
+ * @brief   Gets the sum of the squares of the values in a group.
+ * @details Useful for estimating the variance of sums of sampled values.
+ *
+ * @param group   Aggregation to get the group from.
+ * @param ordinal Ordinal of the group. Must be lower than ::group_by_get_length.
+ *
+ * @return The sum of the squares of the values added to the group with ordinal @p ordinal.
+ */
+double group_by_get_sum_of_squares(const group_by_t *group, size_t ordinal);
+
+/**
+ * @brief Gets the average of the values in a group.
+ *
+ * @param group   Aggregation to get the group from.
+ * @param ordinal Ordinal of the group. Must be lower than ::group_by_get_length.
+ *
+ * @return The average of the values added to the group with ordinal @p ordinal.
+ */
+double group_by_get_average(const group_by_t *group, size_t ordinal);
+
+/**
+ * @brief   Calculates the median of the values in a group.
+ * @details See ::int_utils_median_int64 and ::t_digest_quantile. The values in the group are
+ *          reordered.
+ *
+ * @param group   Aggregation to get the group from. Must have been created with
+ *                ::GROUP_BY_AGGREGATE_VALUES or ::GROUP_BY_AGGREGATE_DIGEST.
+ * @param ordinal Ordinal of the group. Must be lower than ::group_by_get_length.
+ * @param error   Where to write an upper bound of the absolute error of the median to (always `0`
+ *                for ::GROUP_BY_AGGREGATE_VALUES). Can be `NULL`.
+ *
+ * @return The median (exact or approximate) of the values added to the group with ordinal
+ *         @p ordinal.
+ */
+double group_by_calculate_median(group_by_t *group, size_t ordinal, double *error);
+
+/**
+ * @brief Frees memory used by an aggregation.
+ * @param group Aggregation to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref group_by_examples).
+ */
+void group_by_free(group_by_t *group);
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    id_hash_table.h
+ * @brief   A hash table whose keys are integer identifiers (e.g.: ::flight_id_t).
+ * @details Unlike a `GHashTable`, the hash function is known at compile time, and all entries are
+ *          stored inline in a single array (open addressing with Robin Hood linear probing). Hashes
+ *          are cached in each entry, so that probing rarely needs to look at keys.
+ *
+ *          Values are not owned by the table: freeing the table won't free them.
+ *
+ * @anchor id_hash_table_examples
+ * ### Examples
+ *
+ * In the following example, some identifiers are associated with strings, which are then looked up.
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/id_hash_table.h"
+ *
+ * int main(void) {
+ *     id_hash_table_t *table = id_hash_table_create(0);
+ *     if (!table)
+ *         return 1;
+ *
+ *     char *values[3] = {"zero", "one", "two"};
+ *     for (uint32_t i = 0; i < 3; ++i) {
+ *         if (id_hash_table_insert(table, i, values[i]) == 1) {
+ *             id_hash_table_free(table);
+ *             return 1;
+ *         }
+ *     }
+ *
+ *     id_hash_table_remove(table, 1);
+ *
+ *     for (uint32_t i = 0; i < 4; ++i) {
+ *         const char *value = id_hash_table_lookup(table, i);
+ *         printf("%u: %s\n", i, value ? value : "(not found)");
+ *     }
+ *
+ *     id_hash_table_free(table);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print:
+ *
+ * ```text
+ * 0: zero
+ * 1: (not found)
+ * 2: two
+ * 3: (not found)
+ * ```
+ */
+
+#ifndef ID_HASH_TABLE_H
+#define ID_HASH_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief A hash table whose keys are integer identifiers. */
+typedef struct id_hash_table id_hash_table_t;
+
+/**
+ * @brief   Creates a new empty hash table.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::id_hash_table_free.
+ *
+ * @param capacity Number of entries that can be inserted before the table needs to grow (see
+ *                 ::id_hash_table_reserve). Can be `0`.
+ *
+ * @return The new hash table, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref id_hash_table_examples).
+ */
+id_hash_table_t *id_hash_table_create(size_t capacity);
+
+/**
+ * @brief   Makes room in a hash table for a number of entries.
+ * @details Call this before inserting many entries whose number is known beforehand, so that the
+ *          table doesn't need to grow (and rehash all its entries) multiple times.
+ *
+ * @param table Hash table to be grown, if needed.
+ * @param n     Total number of entries @p table must be able to contain without growing.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ */
+int id_hash_table_reserve(id_hash_table_t *table, size_t n);
+
+/**
+ * @brief   Shrinks a hash table to the smallest capacity that can hold its entries.
+ * @details Meant for tables that won't grow anymore, such as after space was reserved for more
+ *          entries than were inserted.
+ *
+ * @param table Hash table to be shrunk, if possible.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ */
+int id_hash_table_shrink_to_fit(id_hash_table_t *table);
+
+/**
+ * @brief Associates a key with a value in a hash table.
+ *
+ * @param table Hash table to be modified.
+ * @param key   Key to be inserted.
+ * @param value Value to associate with @p key.
+ *
+ * @retval 0 Success (@p key wasn't in @p table).
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ * @retval 2 Success (@p key was in @p table, and its value was replaced).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref id_hash_table_examples).
+ */
+int id_hash_table_insert(id_hash_table_t *table, uint32_t key, void *value);
+
+/**
+ * @brief Gets the value associated with a key in a hash table.
+ *
+ * @param table Hash table where to perform the lookup.
+ * @param key   Key to look for.
+ *
+ * @return The value associated with @p key, or `NULL` if @p key isn't in @p table.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref id_hash_table_examples).
+ */
+void *id_hash_table_lookup(const id_hash_table_t *table, uint32_t key);
+
+/**
+ * @brief   Gets the values associated with many keys in a hash table.
+ * @details Same as calling ::id_hash_table_lookup for every key, but the entries of up to
+ *          ::PREFETCH_BATCH_SIZE keys are prefetched before any of them is read, so that the cache
+ *          misses of independent lookups overlap.
+ *
+ * @param table  Hash table where to perform the lookups.
+ * @param n      Number of keys to look for.
+ * @param keys   Keys to look for.
+ * @param values Where to write the value associated with each key to (`NULL` for missing keys).
+ */
+void id_hash_table_lookup_batch(const id_hash_table_t *table,
+                                size_t                 n,
+                                const uint32_t         keys[n],
+                                void                  *values[n]);
+
+/**
+ * @brief Removes a key (and its associated value) from a hash table.
+ *
+ * @param table Hash table to be modified.
+ * @param key   Key to be removed.
+ *
+ * @retval 0 Success.
+ * @retval 1 @p key wasn't in @p table.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref id_hash_table_examples).
+ */
+int id_hash_table_remove(id_hash_table_t *table, uint32_t key);
+
+/**
+ * @brief  Gets the number of entries in a hash table.
+ * @param  table Hash table to get the number of entries from.
+ * @return The number of entries in @p table.
+ */
+size_t id_hash_table_get_length(const id_hash_table_t *table);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a hash table.
+ * @details Values aren't owned by the table, so they aren't accounted for.
+ *
+ * @param table Hash table to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p table, including empty entries.
+ */
+size_t id_hash_table_get_memory_usage(const id_hash_table_t *table);
+
+/**
+ * @brief Frees memory used by a hash table.
+ * @param table Hash table to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref id_hash_table_examples).
+ */
+void id_hash_table_free(id_hash_table_t *table);
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    id_map.h
+ * @brief   A map from integer identifiers (e.g.: ::flight_id_t) to pointers.
+ * @details While the keys in the map are compact (there aren't many identifiers missing between
+ *          the lowest and the highest key), values are stored in an array indexed by the key, and
+ *          lookups don't need to hash anything. Once keys become sparse, the map switches to an
+ *          ::id_hash_table_t, and stays that way.
+ *
+ *          `NULL` values can't be stored, as they're used to mark missing keys. Values are not
+ *          owned by the map: freeing the map won't free them.
+ *
+ * @anchor id_map_examples
+ * ### Examples
+ *
+ * The interface of this map is the same as the one of ::id_hash_table_t. See
+ * [its examples](@ref id_hash_table_examples).
+ */
+
+#ifndef ID_MAP_H
+#define ID_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief A map from integer identifiers to pointers. */
+typedef struct id_map id_map_t;
+
+/**
+ * @brief   Creates a new empty map.
+ * @details The returned value is owned by the caller, and should be `free`d with ::id_map_free.
+ * @return  The new map, or `NULL` on allocation failure.
+ */
+id_map_t *id_map_create(void);
+
+/**
+ * @brief   Makes room in a map for a number of entries.
+ * @details Call this before inserting many entries whose number is known beforehand, so that the
+ *          map doesn't need to grow multiple times.
+ *
+ * @param map Map to be grown, if needed.
+ * @param n   Total number of entries @p map must be able to contain without growing.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p map is left unchanged).
+ */
+int id_map_reserve(id_map_t *map, size_t n);
+
+/**
+ * @brief   Shrinks a map to the smallest size that can hold its entries.
+ * @details Meant for maps that won't grow anymore. Space reserved with ::id_map_reserve is
+ *          forgotten.
+ *
+ * @param map Map to be shrunk, if possible.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p map is left unchanged).
+ */
+int id_map_shrink_to_fit(id_map_t *map);
+
+/**
+ * @brief Associates a key with a value in a map.
+ *
+ * @param map   Map to be modified.
+ * @param key   Key to be inserted.
+ * @param value Value to associate with @p key. Mustn't be `NULL`.
+ *
+ * @retval 0 Success (@p key wasn't in @p map).
+ * @retval 1 Allocation failure (@p map is left unchanged).
+ * @retval 2 Success (@p key was in @p map, and its value was replaced).
+ */
+int id_map_insert(id_map_t *map, uint32_t key, void *value);
+
+/**
+ * @brief Gets the value associated with a key in a map.
+ *
+ * @param map Map where to perform the lookup.
+ * @param key Key to look for.
+ *
+ * @return The value associated with @p key, or `NULL` if @p key isn't in @p map.
+ */
+void *id_map_lookup(const id_map_t *map, uint32_t key);
+
+/**
+ * @brief   Gets the values associated with many keys in a map.
+ * @details Same as calling ::id_map_lookup for every key. In sparse mode, lookups are batched (see
+ *          ::id_hash_table_lookup_batch).
+ *
+ * @param map    Map where to perform the lookups.
+ * @param n      Number of keys to look for.
+ * @param keys   Keys to look for.
+ * @param values Where to write the value associated with each key to (`NULL` for missing keys).
+ */
+void id_map_lookup_batch(const id_map_t *map, size_t n, const uint32_t keys[n], void *values[n]);
+
+/**
+ * @brief Removes a key (and its associated value) from a map.
+ *
+ * @param map Map to be modified.
+ * @param key Key to be removed.
+ *
+ * @retval 0 Success.
+ * @retval 1 @p key wasn't in @p map.
+ */
+int id_map_remove(id_map_t *map, uint32_t key);
+
+/**
+ * @brief  Gets the number of entries in a map.
+ * @param  map Map to get the number of entries from.
+ * @return The number of entries in @p map.
+ */
+size_t id_map_get_length(const id_map_t *map);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a map.
+ * @details Values aren't owned by the map, so they aren't accounted for.
+ *
+ * @param map Map to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p map, in either dense or sparse mode.
+ */
+size_t id_map_get_memory_usage(const id_map_t *map);
+
+/**
+ * @brief Frees memory used by a map.
+ * @param map Map to be `free`d.
+ */
+void id_map_free(id_map_t *map);
+
+#endif
@@ -38,6 +38,7 @@
 #define INT_UTILS_H
 
 #include <inttypes.h>
+#include <stddef.h>
 
 /**
  * @brief Determines the minimum of two numbers.
@@ -75,4 +76,67 @@
  */
 int int_utils_parse_positive(uint64_t *output, const char *input);
 
+/**
+ * @brief   Loads 8 characters into an integer, the first character in its least significant byte.
+ * @details Meant for parsing with SWAR arithmetic (see ::int_utils_parse_digit_pairs),
+ *          independently of the machine's endianness. Compilers turn this into a single load on
+ *          little-endian machines.
+ *
+ * @param input 8 characters to be loaded (null terminators aren't special).
+ *
+ * @return The characters in @p input, packed into an integer.
+ */
+uint64_t int_utils_load_chars(const char input[8]);
+
+/**
+ * @brief   Parses 8 decimal digits as 4 numbers of two digits each, at once.
+ * @details Digits are validated and converted with a few arithmetic operations on the whole
+ *          integer, without looping or branching on individual characters.
+ *
+ * @param output Where to place the parsed numbers (the first one from the two least significant
+ *               bytes of @p chars). Always written to, even on failure.
+ * @param chars  8 characters, as returned by ::int_utils_load_chars.
+ *
+ * @retval 0 Parsing success.
+ * @retval 1 Parsing failure (not all characters are decimal digits).
+ */
+int int_utils_parse_digit_pairs(uint8_t output[4], uint64_t chars);
+
+/**
+ * @brief   Writes a number with a fixed number of decimal digits, padded with leading zeros.
+ * @details No null terminator is written. Digits that don't fit in @p width are discarded.
+ *
+ * @param output Where to write the digits to. Must be at least @p width characters long.
+ * @param value  Number to be written.
+ * @param width  Number of digits to be written.
+ */
+void int_utils_write_fixed(char *output, uint64_t value, size_t width);
+
+/** @brief Minimum size of the buffer passed to ::int_utils_sprint_unsigned. */
+#define INT_UTILS_SPRINT_MIN_BUFFER_SIZE 21
+
+/**
+ * @brief   Prints an unsigned integer in base `10`, like `printf("%" PRIu64, value)`.
+ * @details Digits are written two at a time, from a table, without any `printf` format parsing.
+ *
+ * @param output Where to print the number to. Must be at least
+ *               ::INT_UTILS_SPRINT_MIN_BUFFER_SIZE characters long.
+ * @param value  Number to be printed.
+ *
+ * @return The number of characters written to @p output, not including the null terminator.
+ */
+size_t int_utils_sprint_unsigned(char *output, uint64_t value);
+
+/**
+ * @brief   Calculates the median of an array of integers.
+ * @details Introselect is used, so this runs in linear time, but @p values are reordered. For an
+ *          even number of values, the mean of the two middle values is returned.
+ *
+ * @param values Values to calculate the median of. Will be reordered.
+ * @param n      Number of elements in @p values. Must not be `0`.
+ *
+ * @return The median of @p values.
+ */
+double int_utils_median_int64(int64_t *values, size_t n);
+
 #endif
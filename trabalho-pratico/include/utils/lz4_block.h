@@ -0,0 +1,101 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    lz4_block.h
+ * @brief   Compression of byte buffers in the LZ4 block format.
+ * @details Data is encoded as a sequence of literal runs and back-references (offset and length)
+ *          to earlier occurrences of the same bytes, found with a hash table of 4-byte sequences.
+ *          Compression is fast, and decompression is just copying bytes, so it's meant for
+ *          payloads that would otherwise be sent as-is, like replies to queries in
+ *          [server mode](@ref server_mode.h).
+ *
+ *          The output follows the [LZ4 block format](https://github.com/lz4/lz4), so it can be
+ *          decompressed with `LZ4_decompress_safe` from `liblz4`. Blocks don't store their
+ *          decompressed size, which must be known by the caller.
+ *
+ * @anchor lz4_block_examples
+ * ### Examples
+ *
+ * ```c
+ * #include <stdio.h>
+ * #include <string.h>
+ *
+ * #include "utils/lz4_block.h"
+ *
+ * int main(void) {
+ *     const char *const text = "ab;ab;ab;ab;ab;ab;ab;ab;ab;ab;ab;ab;ab;ab;ab;ab\n";
+ *     const size_t      n    = strlen(text);
+ *
+ *     uint8_t      compressed[LZ4_BLOCK_COMPRESS_BOUND(64)];
+ *     const size_t length = lz4_block_compress((const uint8_t *) text, n, compressed, n - 1);
+ *     if (!length) {
+ *         fputs("Not compressible!\n", stderr);
+ *         return 1;
+ *     }
+ *
+ *     char decompressed[64];
+ *     lz4_block_decompress(compressed, length, (uint8_t *) decompressed, sizeof(decompressed));
+ *     printf("%zu -> %zu bytes\n", n, length);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print `48 -> 13 bytes`.
+ */
+
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Maximum size of the compressed form of @p n bytes (when they're not compressible). */
+#define LZ4_BLOCK_COMPRESS_BOUND(n) ((n) + (n) / 255 + 16)
+
+/** @brief Value returned by ::lz4_block_decompress for blocks that can't be decompressed. */
+#define LZ4_BLOCK_DECOMPRESS_FAILED SIZE_MAX
+
+/**
+ * @brief Compresses a buffer into an LZ4 block.
+ *
+ * @param input    Data to be compressed.
+ * @param length   Number of bytes in @p input. Must be less than `UINT32_MAX`.
+ * @param output   Where to write the compressed block to.
+ * @param capacity Number of bytes available in @p output. Using ::LZ4_BLOCK_COMPRESS_BOUND of
+ *                 @p length guarantees success, and a smaller value can be used to give up on
+ *                 data that doesn't compress well.
+ *
+ * @return The number of bytes written to @p output, or `0` if the block doesn't fit in
+ *         @p capacity bytes.
+ */
+size_t lz4_block_compress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity);
+
+/**
+ * @brief Decompresses an LZ4 block.
+ *
+ * @param input    Block to be decompressed.
+ * @param length   Number of bytes in @p input.
+ * @param output   Where to write the decompressed data to.
+ * @param capacity Number of bytes available in @p output.
+ *
+ * @return The number of bytes written to @p output, or ::LZ4_BLOCK_DECOMPRESS_FAILED if @p input
+ *         is malformed, or decompresses to more than @p capacity bytes.
+ */
+size_t lz4_block_decompress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity);
+
+#endif
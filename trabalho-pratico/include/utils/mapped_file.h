@@ -0,0 +1,240 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    mapped_file.h
+ * @brief   A read-only file, whose contents are mapped to memory.
+ * @details Mapping a file to memory avoids the copies and system calls of buffered `FILE` streams:
+ *          the file's contents are read directly from the page cache. Files that can't be mapped
+ *          (e.g.: pipes) are fully read into a heap buffer instead, transparently.
+ *
+ *          A mapped file is never modified, so it may be read by many threads at once.
+ *
+ * @anchor mapped_file_examples
+ * ### Examples
+ *
+ * Consider the following plain text file, `testfile.txt`:
+ *
+ * ```
+ * Split this
+ * text file by
+ *
+ * the newline character
+ * ```
+ *
+ * The file can be mapped, and ::mapped_file_tokenize will tokenize it, calling `callback` for every
+ * token.
+ *
+ * ```c
+ * mapped_file_t *file = mapped_file_open("testfile.txt"); // Error handling omitted
+ * mapped_file_tokenize(file, NULL, '\n', callback, NULL);
+ * mapped_file_close(file);
+ * ```
+ *
+ * - `callback("Split this", NULL)`;
+ * - `callback("text file by", NULL)`;
+ * - `callback("", NULL)`;
+ * - `callback("the newline character", NULL)`.
+ *
+ * Each token is copied to a buffer owned by ::mapped_file_tokenize before being passed to the
+ * callback, so that it can be modified and null-terminated without touching the mapped file.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+#include "utils/tokenize_iter_callback.h"
+
+/** @brief A read-only file, whose contents are mapped to memory. */
+typedef struct mapped_file mapped_file_t;
+
+/**
+ * @brief   Opens a file and maps its contents to memory.
+ * @details If the file can't be mapped, it will be read onto a heap buffer instead.
+ *
+ * @param path Path to the file to be opened.
+ *
+ * @return A pointer to a new ::mapped_file_t, that must be deleted with ::mapped_file_close, or
+ *         `NULL` on IO / allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref mapped_file_examples).
+ */
+mapped_file_t *mapped_file_open(const char *path);
+
+/**
+ * @brief   Opens a compressed file and decompresses it to memory.
+ * @details The file is decompressed by an external program (e.g.: `gzip` or `zstd`), run as
+ *          `decompressor -dc -- path`, whose output is read through a pipe, so that no decompressed
+ *          copy is written to disk. The whole output is kept in a heap buffer.
+ *
+ * @param path         Path to the file to be opened.
+ * @param decompressor Name of the program that decompresses @p path, looked up in `PATH`.
+ *
+ * @return A pointer to a new ::mapped_file_t, that must be deleted with ::mapped_file_close, or
+ *         `NULL` on IO / allocation failure, or if @p decompressor fails (e.g.: corrupt input).
+ */
+mapped_file_t *mapped_file_open_decompressed(const char *path, const char *decompressor);
+
+/**
+ * @brief   Gets the contents of a mapped file.
+ * @details The contents are not null-terminated. Use ::mapped_file_get_size.
+ *
+ * @param file File to get the contents from.
+ *
+ * @return The contents of @p file, valid until ::mapped_file_close is called.
+ */
+const char *mapped_file_get_contents(const mapped_file_t *file);
+
+/**
+ * @brief  Gets the size of a mapped file.
+ * @param  file File to get the size of.
+ * @return The number of bytes in @p file.
+ */
+size_t mapped_file_get_size(const mapped_file_t *file);
+
+/**
+ * @brief   Starts reading a region of a mapped file from disk in the background.
+ * @details Call this for the region that's going to be read next while processing the current one,
+ *          so that reading doesn't stall on page faults (very slow on network file systems). Files
+ *          read onto heap buffers are already in memory, so nothing is done for them.
+ *
+ * @param file  File to read ahead.
+ * @param begin Offset of the beginning of the region.
+ * @param end   Offset of the end of the region (exclusive). Can be past the end of @p file.
+ */
+void mapped_file_prefetch(const mapped_file_t *file, size_t begin, size_t end);
+
+/**
+ * @brief   Reads a region of a mapped file from disk, waiting for it to be in memory.
+ * @details Reads a byte of every page in the region, so that all page faults happen here. Used to
+ *          measure the time spent on IO separately from the time spent processing the region.
+ *          Files read onto heap buffers are already in memory, so nothing is done for them.
+ *
+ * @param file  File to read.
+ * @param begin Offset of the beginning of the region.
+ * @param end   Offset of the end of the region (exclusive). Can be past the end of @p file.
+ */
+void mapped_file_touch(const mapped_file_t *file, size_t begin, size_t end);
+
+/**
+ * @brief Value returned by ::mapped_file_tokenize and ::mapped_file_tokenize_range when allocations
+ *        fail.
+ */
+#define MAPPED_FILE_TOKENIZE_RET_ALLOCATION_FAILURE -1
+
+/**
+ * @brief Splits a mapped file into tokens, separated by @p delimiter.
+ *
+ * @param file      File to tokenize.
+ * @param offset    Where to start tokenizing @p file from. When this method returns, the offset
+ *                  right after the last processed token will be written here, so that
+ *                  tokenization can be resumed later (like reading from a `FILE` stream). Can be
+ *                  `NULL`, for tokenization to start at the beginning of @p file.
+ * @param delimiter Character to separate tokens. It won't be part of those tokens.
+ * @param callback  Function called for every token read. The token may be modified, but it's only
+ *                  valid until @p callback returns.
+ * @param user_data Pointer passed to every call of @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return `0` on success, otherwise, the return value from @p callback in case it ordered the
+ *         tokenization to stop. ::MAPPED_FILE_TOKENIZE_RET_ALLOCATION_FAILURE may also be returned
+ *         on allocation failures.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref mapped_file_examples).
+ */
+int mapped_file_tokenize(const mapped_file_t     *file,
+                         size_t                  *offset,
+                         char                     delimiter,
+                         tokenize_iter_callback_t callback,
+                         void                    *user_data);
+
+/**
+ * @brief   Splits a region of a mapped file into tokens, separated by @p delimiter.
+ * @details Because mapped files are never modified, different regions of the same file can be
+ *          tokenized by different threads at once.
+ *
+ * @param file      File to tokenize.
+ * @param begin     Offset where to start tokenizing @p file from.
+ * @param end       Offset of the end of the region to tokenize (exclusive). If it's not the offset
+ *                  right after a @p delimiter, the last token will be cut short.
+ * @param delimiter Character to separate tokens. It won't be part of those tokens.
+ * @param callback  Function called for every token read. The token may be modified, but it's only
+ *                  valid until @p callback returns.
+ * @param user_data Pointer passed to every call of @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return `0` on success, otherwise, the return value from @p callback in case it ordered the
+ *         tokenization to stop. ::MAPPED_FILE_TOKENIZE_RET_ALLOCATION_FAILURE may also be returned
+ *         on allocation failures.
+ */
+int mapped_file_tokenize_range(const mapped_file_t     *file,
+                               size_t                   begin,
+                               size_t                   end,
+                               char                     delimiter,
+                               tokenize_iter_callback_t callback,
+                               void                    *user_data);
+
+/**
+ * @brief Callback for ::mapped_file_tokenize_range_with_offsets, called for every token read.
+ *
+ * @param user_data Pointer provided to ::mapped_file_tokenize_range_with_offsets.
+ * @param token     The token that was read. It may be modified, but it's only valid until this
+ *                  callback returns.
+ * @param offset    Offset of the beginning of @p token in the file.
+ *
+ * @return `0` on success, other value for immediate termination of tokenization.
+ */
+typedef int (*mapped_file_tokenize_offset_callback_t)(void *user_data, char *token, size_t offset);
+
+/**
+ * @brief   Splits a region of a mapped file into tokens, reporting where each token is in the file.
+ * @brief   Splits a region of a mapped file into tokens, also reporting the offset of each one.
+ *          so that it can be found again in the file's contents (which, unlike the token, aren't
+ *          modified and outlive tokenization).
+ *
+ * @param file      File to tokenize.
+ * @param begin     Offset where to start tokenizing @p file from.
+ * @param end       Offset of the end of the region to tokenize (exclusive).
+ * @param delimiter Character to separate tokens. It won't be part of those tokens.
+ * @param callback  Function called for every token read.
+ * @param user_data Pointer passed to every call of @p callback.
+ *
+ * @return `0` on success, otherwise, the return value from @p callback in case it ordered the
+ *         tokenization to stop. ::MAPPED_FILE_TOKENIZE_RET_ALLOCATION_FAILURE may also be returned
+ *         on allocation failures.
+ */
+int mapped_file_tokenize_range_with_offsets(const mapped_file_t                  *file,
+                                            size_t                                begin,
+                                            size_t                                end,
+                                            char                                  delimiter,
+                                            mapped_file_tokenize_offset_callback_t callback,
+                                            void                                 *user_data);
+
+/**
+ * @brief Closes a mapped file, unmapping its contents.
+ * @param file File to be closed.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref mapped_file_examples).
+ */
+void mapped_file_close(mapped_file_t *file);
+
+#endif
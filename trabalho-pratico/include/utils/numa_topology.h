@@ -0,0 +1,174 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    numa_topology.h
+ * @brief   The NUMA nodes of the machine, and the processors in each of them.
+ * @details On machines with multiple NUMA nodes (e.g.: multiple sockets), memory is closer to the
+ *          processors of one node than to the others. Threads can be pinned to a node, and data
+ *          they read very often can be replicated in each node, so that every thread reads from
+ *          memory close to it. Linux places a page in the node of the thread that first writes to
+ *          it, so a replica is local to the node whose thread allocates and fills it.
+ *
+ *          The topology is read from `/sys/devices/system/node`. When it isn't available, the
+ *          machine is considered to have a single node, and pinning threads does nothing.
+ *
+ * @anchor numa_topology_examples
+ * ### Examples
+ *
+ * The following example prints the node each thread ran in:
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/numa_topology.h"
+ *
+ * int print_node(void *user_data, size_t node) {
+ *     (void) user_data;
+ *     printf("Running in node %zu (%zu)\n", node, numa_topology_get_thread_node());
+ *     return 0;
+ * }
+ *
+ * int main(void) {
+ *     numa_topology_t *topology = numa_topology_create();
+ *     if (!topology)
+ *         return 1;
+ *
+ *     printf("%zu nodes\n", numa_topology_get_node_count(topology));
+ *     numa_topology_run_on_nodes(topology, print_node, NULL);
+ *     numa_topology_free(topology);
+ *     return 0;
+ * }
+ * ```
+ *
+ * On a single-socket machine, this example should print:
+ *
+ * ```text
+ * 1 nodes
+ * Running in node 0 (0)
+ * ```
+ */
+
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include <stddef.h>
+
+/** @brief The NUMA nodes of the machine. */
+typedef struct numa_topology numa_topology_t;
+
+/**
+ * @brief Type of the method called by ::numa_topology_run_on_nodes in each node.
+ *
+ * @param user_data Pointer passed to ::numa_topology_run_on_nodes.
+ * @param node      Node the calling thread is pinned to.
+ *
+ * @return `0` on success, any other value on failure.
+ */
+typedef int (*numa_topology_node_callback_t)(void *user_data, size_t node);
+
+/**
+ * @brief  Reads the NUMA topology of the machine.
+ * @return The topology of the machine (with a single node if it can't be read), or `NULL` on
+ *         allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref numa_topology_examples).
+ */
+numa_topology_t *numa_topology_create(void);
+
+/**
+ * @brief  Gets the number of NUMA nodes (with processors) in a topology.
+ * @param  topology Topology to get the number of nodes from.
+ * @return The number of nodes in @p topology (at least `1`).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref numa_topology_examples).
+ */
+size_t numa_topology_get_node_count(const numa_topology_t *topology);
+
+/**
+ * @brief   Pins the calling thread to the processors of a NUMA node.
+ * @details The node is remembered, so that it can be gotten with ::numa_topology_get_thread_node,
+ *          even if pinning fails.
+ *
+ * @param topology Topology of the machine.
+ * @param node     Node to pin the calling thread to (from `0` to the number of nodes `- 1`).
+ *
+ * @retval 0 Success.
+ * @retval 1 The thread couldn't be pinned.
+ */
+int numa_topology_pin_thread(const numa_topology_t *topology, size_t node);
+
+/**
+ * @brief   Pins the calling thread to a single processor of a NUMA node.
+ * @details Like ::numa_topology_pin_thread, but the thread can't migrate between the processors of
+ *          the node, so that its caches are never left behind.
+ *
+ * @param topology  Topology of the machine.
+ * @param node      Node to pin the calling thread to (from `0` to the number of nodes `- 1`).
+ * @param processor Index of the processor in @p node. If greater than the number of processors in
+ *                  the node, processors are reused in a round-robin fashion.
+ *
+ * @retval 0 Success.
+ * @retval 1 The thread couldn't be pinned.
+ */
+int numa_topology_pin_thread_to_processor(const numa_topology_t *topology,
+                                          size_t                 node,
+                                          size_t                 processor);
+
+/**
+ * @brief   Gets the NUMA node the calling thread was pinned to.
+ * @details Threads that were never pinned (with ::numa_topology_pin_thread) are considered to be
+ *          in node `0`.
+ *
+ * @return The node the calling thread was pinned to.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref numa_topology_examples).
+ */
+size_t numa_topology_get_thread_node(void);
+
+/**
+ * @brief   Calls a method once in each NUMA node, from a thread pinned to that node.
+ * @details Useful for building replicas of data, that are local to each node. Threads run
+ *          concurrently, and this method only returns after all of them finish.
+ *
+ * @param topology  Topology of the machine.
+ * @param callback  Method called once for every node.
+ * @param user_data Pointer passed to every call of @p callback.
+ *
+ * @retval 0 Success.
+ * @retval 1 A thread couldn't be created, or @p callback failed for one of the nodes.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref numa_topology_examples).
+ */
+int numa_topology_run_on_nodes(const numa_topology_t        *topology,
+                               numa_topology_node_callback_t callback,
+                               void                         *user_data);
+
+/**
+ * @brief Frees memory used by a NUMA topology.
+ * @param topology Topology to be freed.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref numa_topology_examples).
+ */
+void numa_topology_free(numa_topology_t *topology);
+
+#endif
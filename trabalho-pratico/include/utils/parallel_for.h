@@ -0,0 +1,106 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    parallel_for.h
+ * @brief   Splitting a range of indices across multiple threads.
+ * @details A range `[0, n)` is divided in contiguous and disjoint sub-ranges, one per thread, of
+ *          (approximately) the same length. Sub-ranges are run by the program's
+ *          [shared thread pool](@ref thread_pool.h), so that nested and concurrent calls don't
+ *          create more threads than there are processors. This is meant for long-running work,
+ *          such as iterating through a whole pool.
+ *
+ * @anchor parallel_for_examples
+ * ### Examples
+ *
+ * The following example sums an array of integers using four threads:
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/parallel_for.h"
+ *
+ * #define N 1000000
+ * int array[N];
+ *
+ * int sum_range(void *user_data, size_t begin, size_t end) {
+ *     long *sum = user_data;
+ *     for (size_t i = begin; i < end; ++i)
+ *         *sum += array[i];
+ *     return 0;
+ * }
+ *
+ * int main(void) {
+ *     for (size_t i = 0; i < N; ++i)
+ *         array[i] = i % 10;
+ *
+ *     long  sums[4]        = {0};
+ *     void *thread_data[4] = {&sums[0], &sums[1], &sums[2], &sums[3]};
+ *     parallel_for(N, 4, sum_range, thread_data);
+ *
+ *     printf("%ld\n", sums[0] + sums[1] + sums[2] + sums[3]);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print `4500000`.
+ */
+
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <stddef.h>
+
+/**
+ * @brief Callback type for ::parallel_for, called once in each thread.
+ *
+ * @param user_data Pointer provided to ::parallel_for for this thread.
+ * @param begin     First index in the thread's range.
+ * @param end       Index after the last one in the thread's range. Always greater than @p begin.
+ *
+ * @return `0` on success, or any other value to be returned by ::parallel_for.
+ */
+typedef int (*parallel_for_callback_t)(void *user_data, size_t begin, size_t end);
+
+/**
+ * @brief   Calls a callback for disjoint sub-ranges of `[0, n)`, each one in a different thread.
+ * @details The first sub-range is processed in the calling thread, as are sub-ranges no worker of
+ *          the shared pool has started by the time it's done (see ::thread_pool_parallel_for). If
+ *          the pool is unavailable, a thread is created for every other sub-range instead (or,
+ *          if that also fails, the sub-range is processed in the calling thread). Empty sub-ranges
+ *          (when @p n is lower than @p nthreads) are skipped. This method only returns after all
+ *          sub-ranges have been processed.
+ *
+ * @param n         Number of indices to split across threads.
+ * @param nthreads  Number of sub-ranges (at most, threads) to split `[0, n)` into. If `0`, `1` is
+ *                  assumed.
+ * @param callback  Method called for every non-empty sub-range.
+ * @param user_data Array of @p nthreads pointers. The `i`-th sub-range is processed with
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by @p callback (sub-ranges ordered by index), or `0`
+ *         if all callbacks succeeded.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref parallel_for_examples).
+ */
+int parallel_for(size_t                  n,
+                 size_t                  nthreads,
+                 parallel_for_callback_t callback,
+                 void *const            *user_data);
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    parallel_sort.h
+ * @brief   Sorting of large arrays using multiple threads.
+ * @details Arrays with fewer than ::PARALLEL_SORT_THRESHOLD elements are sorted in the calling
+ *          thread. Larger arrays are split into one run for each thread in the
+ *          [shared thread pool](@ref thread_pool.h) (plus the calling thread), runs are sorted
+ *          concurrently, and then merged in pairs, with each round of merges also done in
+ *          parallel.
+ *
+ *          Sorting can be stable (equal elements keep their relative order), like `g_array_sort`
+ *          and `g_ptr_array_sort`, or unstable, like `qsort`. Unstable sorting is a bit faster when
+ *          arrays are small, as it doesn't need a temporary buffer.
+ *
+ * @anchor parallel_sort_examples
+ * ### Examples
+ *
+ * In the following example, pairs of integers are sorted by their first element, and those with
+ * the same first element keep their original order:
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/parallel_sort.h"
+ *
+ * typedef struct {
+ *     int key, value;
+ * } pair_t;
+ *
+ * int compare_pairs(const void *a, const void *b) {
+ *     const int key_a = ((const pair_t *) a)->key, key_b = ((const pair_t *) b)->key;
+ *     return (key_a > key_b) - (key_a < key_b);
+ * }
+ *
+ * int main(void) {
+ *     pair_t pairs[5] = {{3, 0}, {1, 1}, {3, 2}, {2, 3}, {1, 4}};
+ *     if (parallel_sort(pairs, 5, sizeof(pair_t), compare_pairs, 1))
+ *         return 1;
+ *
+ *     for (size_t i = 0; i < 5; ++i)
+ *         printf("%d %d\n", pairs[i].key, pairs[i].value);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print:
+ *
+ * ```text
+ * 1 1
+ * 1 4
+ * 2 3
+ * 3 0
+ * 3 2
+ * ```
+ */
+
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include <stddef.h>
+
+/**
+ * @brief   Minimum number of elements for an array to be sorted by multiple threads.
+ * @details Below this, the cost of waking up workers is larger than the time saved.
+ */
+#define PARALLEL_SORT_THRESHOLD (1 << 16)
+
+/**
+ * @brief  Function that establishes the order of elements, like the ones taken by `qsort`.
+ * @param  a Pointer to the first element.
+ * @param  b Pointer to the second element.
+ * @return A negative value if @p a comes before @p b, `0` if they're equal, and a positive value
+ *         if @p a comes after @p b.
+ */
+typedef int (*parallel_sort_compare_t)(const void *a, const void *b);
+
+/**
+ * @brief   Sorts an array, using multiple threads if it's large enough.
+ * @details @p compare may be called concurrently from many threads, so it must not modify any
+ *          shared state.
+ *
+ * @param base    Array to be sorted.
+ * @param n       Number of elements in @p base.
+ * @param size    Size of each element, in bytes.
+ * @param compare Function that establishes the order of elements.
+ * @param stable  Whether equal elements must keep their relative order.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (only possible when @p stable is set). @p base is left unchanged.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref parallel_sort_examples).
+ */
+int parallel_sort(void *base, size_t n, size_t size, parallel_sort_compare_t compare, int stable);
+
+#endif
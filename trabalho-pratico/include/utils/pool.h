@@ -20,6 +20,9 @@
 #include <inttypes.h>
 #include <stddef.h>
 
+#include "utils/block_allocator.h"
+#include "utils/cancellation.h"
+
 /**
  * @file    pool.h
  * @brief   A pool allocator for structures of the same size.
@@ -108,6 +111,39 @@ typedef struct pool pool_t;
  */
 typedef int (*pool_iter_callback_t)(void *user_data, const void *item);
 
+/**
+ * @brief   Callback type for pool iterations over contiguous spans of items.
+ * @details Method called by ::pool_iter_blocks and ::pool_iter_blocks_parallel for every block in
+ *          a ::pool_t.
+ *
+ * @param user_data Argument passed to ::pool_iter_blocks, that is passed to every callback, so that
+ *                  this method can change the program's state.
+ * @param items     Array of @p n contiguous items in the pool. You must convert it to its correct
+ *                  type (type provided to ::pool_create).
+ * @param n         Number of items in @p items. Never `0`.
+ *
+ * @return `0` on success, or any other value to order pool iteration to stop.
+ */
+typedef int (*pool_iter_blocks_callback_t)(void *user_data, const void *items, size_t n);
+
+/**
+ * @brief   Callback type for pool iterations over arrays of pointers to items.
+ * @details Method called by ::pool_iter_pointers and ::pool_iter_pointers_parallel. Useful for
+ *          pools of opaque types, whose size isn't known by the caller.
+ *
+ * @param user_data Argument passed to ::pool_iter_pointers, that is passed to every callback, so
+ *                  that this method can change the program's state.
+ * @param items     Array of @p n pointers to items in the pool. Only valid during this call.
+ * @param n         Number of pointers in @p items. Never `0`, and never more than
+ *                  ::POOL_ITER_POINTERS_CAPACITY.
+ *
+ * @return `0` on success, or any other value to order pool iteration to stop.
+ */
+typedef int (*pool_iter_pointers_callback_t)(void *user_data, const void *const *items, size_t n);
+
+/** @brief Maximum number of pointers passed to each ::pool_iter_pointers_callback_t. */
+#define POOL_ITER_POINTERS_CAPACITY 256
+
 /**
  * @brief   Creates a pool from the size of its elements.
  * @details Unless you are using opaque types with a `*_sizeof` function exposed
@@ -138,6 +174,56 @@ pool_t *pool_create_from_size(size_t item_size, size_t block_capacity);
  */
 #define pool_create(type, block_capacity) pool_create_from_size(sizeof(type), block_capacity)
 
+/**
+ * @brief   Creates a pool from the size of its elements, choosing how its blocks are allocated.
+ * @details Unless you are using opaque types with a `*_sizeof` function exposed
+ *          (e.g.: ::user_sizeof), **use ::pool_create_with_policy instead.** The returned value is
+ *          owned by the caller, and should be freed with ::pool_free.
+ *
+ *          The capacity of each block may be increased, to fill all the memory allocated for it
+ *          (e.g.: the rest of a huge page). Arrays larger than a block are always allocated with
+ *          `malloc`.
+ *
+ * @param item_size      The size (in bytes) of the type of item to be allocated in this pool.
+ * @param block_capacity The minimum size (in items) of each block of the pool.
+ * @param policy         How to allocate blocks. ::BLOCK_ALLOCATOR_POLICY_HUGE_PAGES is meant for
+ *                       large pools, accessed randomly.
+ *
+ * @return The newly created pool, or `NULL` on allocation failure.
+ */
+pool_t *pool_create_from_size_with_policy(size_t                   item_size,
+                                          size_t                   block_capacity,
+                                          block_allocator_policy_t policy);
+
+/**
+ * @brief   Creates a pool, choosing how its blocks are allocated.
+ * @details The returned value is owned by the caller, and should be freed with ::pool_free. See
+ *          ::pool_create_from_size_with_policy.
+ *
+ * @param type           The type of the item in the pool (for example, `int`).
+ * @param block_capacity A `size_t` with the minimum number of items in each pool block.
+ * @param policy         A ::block_allocator_policy_t, how to allocate blocks.
+ *
+ * @return A pointer to a ::pool_t, or `NULL` on failure.
+ */
+#define pool_create_with_policy(type, block_capacity, policy)                                      \
+    pool_create_from_size_with_policy(sizeof(type), block_capacity, policy)
+
+/**
+ * @brief   Makes room in a pool for a number of items.
+ * @details Call this before allocating many items whose number is known beforehand, so that all
+ *          blocks are allocated at once. Blocks allocated in advance are only freed by
+ *          ::pool_free.
+ *
+ * @param pool Pool to be grown, if needed.
+ * @param n    Number of items that must be allocatable (with ::pool_alloc_item or
+ *             ::pool_put_item) without allocating blocks.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (blocks allocated until the failure are kept).
+ */
+int pool_reserve(pool_t *pool, size_t n);
+
 /**
  * @brief   Allocates space for an item in a pool. **Use ::pool_alloc_item instead.**
  * @details That item does not need to be `free`'d, as that's done when @p pool itself is freed in
@@ -186,6 +272,11 @@ void *__pool_alloc_items(pool_t *pool, size_t n);
  *          freed in ::pool_free. However, keep in mind that the pool must oulive the allocated
  *          items.
  *
+ *          Arrays are kept contiguous, so, when there isn't enough space left in the current block,
+ *          the rest of it is skipped. Arrays larger than a block get a block of their own. Pool
+ *          iterations (e.g.: ::pool_iter) still visit every item, so whole batches of records can
+ *          be allocated at once.
+ *
  * @param type Type of the items in the pool. It's expected to be the same type used in
  *             ::pool_create. Otherwise, this will result in undefined behavior.
  * @param pool A `pool_t *` in which the items will be allocated.
@@ -238,9 +329,6 @@ void *__pool_put_item(pool_t *pool, const void *item_location);
  *          freed in ::pool_free. However, keep in mind that the pool must oulive the allocated
  *          items. This method needs to be exposed so that the ::pool_put_items macro works.
  *
- *          Also, due to the inner workings of this method, **pool iterations won't work** if this
- *          function is ever called for a given pool.
- *
  * @param pool           Pool to add the item to.
  * @param items_location Location of the items to be allocated and copied. It must be a
  *                       `const type *`, where `type` is the type provided to ::pool_create.
@@ -257,8 +345,9 @@ void *__pool_put_items(pool_t *pool, const void *items_location, size_t n);
  *          freed in ::pool_free. However, keep in mind that the pool must oulive the allocated
  *          items.
  *
- *          Also, due to the inner workings of this method, **pool iterations won't work** if this
- *          function is ever called for a given pool.
+ *          Items allocated this way are still visited by pool iterations (e.g.: ::pool_iter), so
+ *          whole batches of records can be allocated at once. When there isn't enough space left
+ *          in the current block, the rest of it is skipped.
  *
  * @param pool           Pool to add the item to.
  * @param items_location Location of the items to be allocated and copied. It must be a `type *`,
@@ -272,13 +361,9 @@ void *__pool_put_items(pool_t *pool, const void *items_location, size_t n);
     ((type *) __pool_put_items(pool, items_location, n))
 
 /**
- * @brief Value returned by ::pool_iter due to failure, because ::pool_put_items has been called
- *        before.
- */
-#define POOL_ITER_RET_ADDED_ARRAY -1
-
-/**
- * @brief Iterates through every item in the pool, calling @p callback for each one.
+ * @brief   Iterates through every item in the pool, calling @p callback for each one.
+ * @details Items are visited in the order they were allocated in, except for arrays larger than a
+ *          block (see ::pool_alloc_items), that are visited after all other items.
  *
  * @param pool      Pool to iterate thorugh.
  * @param callback  Method called for every item stored in @p pool.
@@ -286,14 +371,90 @@ void *__pool_put_items(pool_t *pool, const void *items_location, size_t n);
  *                  state.
  *
  * @return The return value of the last-called @p callback (values other than `0` order iteration
- *         to stop). ::POOL_ITER_RET_ADDED_ARRAY can be returned if ::pool_put_items has been
- *         called before.
+ *         to stop). ::CANCELLATION_ITER_RET can be returned if the calling thread's cancellation is
+ *         requested (checked before every block, see ::cancellation_check).
  *
  * #### Examples
  * See [the header file's documentation](@ref pool_examples).
  */
 int pool_iter(const pool_t *pool, pool_iter_callback_t callback, void *user_data);
 
+/**
+ * @brief   Iterates through every block in the pool, calling @p callback for the items in each one.
+ * @details Unlike ::pool_iter, only one (indirect) call is made for many items, so that @p callback
+ *          can loop through them with no function call overhead.
+ *
+ * @param pool      Pool to iterate thorugh.
+ * @param callback  Method called for every non-empty block in @p pool.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (values other than `0` order iteration
+ *         to stop). ::CANCELLATION_ITER_RET can be returned if the calling thread's cancellation is
+ *         requested (checked before every block, see ::cancellation_check).
+ */
+int pool_iter_blocks(const pool_t *pool, pool_iter_blocks_callback_t callback, void *user_data);
+
+/**
+ * @brief   Iterates through every item in the pool, in arrays of pointers to them.
+ * @details Items are provided in the same order as ::pool_iter, in groups of up to
+ *          ::POOL_ITER_POINTERS_CAPACITY.
+ *
+ * @param pool      Pool to iterate thorugh.
+ * @param callback  Method called for every group of items in @p pool.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (values other than `0` order iteration
+ *         to stop). ::CANCELLATION_ITER_RET can be returned if the calling thread's cancellation is
+ *         requested (checked before every block, see ::cancellation_check).
+ */
+int pool_iter_pointers(const pool_t                 *pool,
+                       pool_iter_pointers_callback_t callback,
+                       void                         *user_data);
+
+/**
+ * @brief   Iterates through every block in the pool, splitting blocks across multiple threads.
+ * @details The blocks of @p pool are divided in @p nthreads disjoint ranges of consecutive blocks,
+ *          and each range is iterated through in its own thread. If a thread can't be created, its
+ *          range is iterated through in the calling thread. Callbacks in different threads are
+ *          called concurrently, so they mustn't modify the same data, and @p pool mustn't be
+ *          modified during the iteration.
+ *
+ * @param pool      Pool to iterate thorugh.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method called for every non-empty block in @p pool.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by the last @p callback of a thread (threads ordered
+ *         as @p user_data), or `0` if no thread was stopped. A thread stopping doesn't stop any
+ *         other. ::CANCELLATION_ITER_RET can be returned if the calling thread's cancellation is
+ *         requested.
+ */
+int pool_iter_blocks_parallel(const pool_t               *pool,
+                              size_t                      nthreads,
+                              pool_iter_blocks_callback_t callback,
+                              void *const                *user_data);
+
+/**
+ * @brief   Iterates through every item in the pool, in arrays of pointers to them, splitting the
+ *          pool's blocks across multiple threads.
+ * @details See ::pool_iter_pointers and ::pool_iter_blocks_parallel.
+ *
+ * @param pool      Pool to iterate thorugh.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param callback  Method called for every group of items in @p pool.
+ * @param user_data Array of @p nthreads pointers. Every @p callback in the `i`-th thread is passed
+ *                  `user_data[i]`.
+ *
+ * @return Same as ::pool_iter_blocks_parallel.
+ */
+int pool_iter_pointers_parallel(const pool_t                 *pool,
+                                size_t                        nthreads,
+                                pool_iter_pointers_callback_t callback,
+                                void *const                  *user_data);
+
 /**
  * @brief   Removes all elements from @p pool.
  * @details Keep in mind that all values allocated using @p pool will no longer be valid (this will
@@ -305,6 +466,28 @@ int pool_iter(const pool_t *pool, pool_iter_callback_t callback, void *user_data
  */
 void pool_empty(pool_t *pool);
 
+/**
+ * @brief   Frees memory allocated by a pool that isn't in use.
+ * @details Blocks reserved with ::pool_reserve but never used are freed, and the unused end of the
+ *          last block is returned to the operating system, when possible (see
+ *          ::block_allocator_release_unused). Items in the pool aren't moved, and new items can
+ *          still be allocated afterwards.
+ *
+ * @param pool Pool to be shrunk.
+ */
+void pool_shrink_to_fit(pool_t *pool);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a pool.
+ * @details Includes all allocated blocks, even if they're not yet (or no longer) in use, and the
+ *          bookkeeping of the pool itself.
+ *
+ * @param pool Pool to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p pool.
+ */
+size_t pool_get_memory_usage(const pool_t *pool);
+
 /**
  * @brief Frees memory allocated by a pool.
  * @param pool Pool to be freed.
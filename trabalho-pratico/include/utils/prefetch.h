@@ -0,0 +1,44 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    prefetch.h
+ * @brief   Software prefetching hints.
+ * @details Batched lookups (see ::id_hash_table_lookup_batch, for example) first find where all of
+ *          their results are, and ask for that memory to be loaded into the cache, before reading
+ *          any of it. That way, the latency of many cache misses overlaps, instead of each lookup
+ *          waiting for the previous one. Compilers that don't support prefetching ignore the
+ *          hints.
+ */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+/** @brief Maximum number of lookups whose memory is prefetched before any of it is read. */
+#define PREFETCH_BATCH_SIZE 16
+
+#ifdef __GNUC__
+/**
+ * @brief Hints that the memory at @p address will be read soon.
+ * @param address Address to be prefetched. Can be invalid (e.g.: `NULL`).
+ */
+#define prefetch_read(address) __builtin_prefetch((address), 0, 3)
+#else
+#define prefetch_read(address) ((void) (address))
+#endif
+
+#endif
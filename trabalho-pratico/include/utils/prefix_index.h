@@ -0,0 +1,167 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    prefix_index.h
+ * @brief   A sorted set of strings, that can be searched by prefix.
+ * @details Strings are added to the index and then sorted once, with ::prefix_index_build. After
+ *          that, all strings starting with a prefix are found with two binary searches, in
+ *          `O(log n)` time, no matter how many strings there are. This is fast enough for looking
+ *          identifiers up as the user types them (e.g.: for autocompletion).
+ *
+ * @anchor prefix_index_examples
+ * ### Examples
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/prefix_index.h"
+ *
+ * int print_callback(void *user_data, const char *str) {
+ *     (void) user_data;
+ *     puts(str);
+ *     return 0;
+ * }
+ *
+ * int main(void) {
+ *     prefix_index_t *index = prefix_index_create();
+ *     if (!index)
+ *         return 1;
+ *
+ *     const char *strings[] = {"LIS", "LHR", "OPO", "LAX", "LIS"};
+ *     for (size_t i = 0; i < 5; ++i) {
+ *         if (prefix_index_add(index, strings[i])) {
+ *             prefix_index_free(index);
+ *             return 1;
+ *         }
+ *     }
+ *
+ *     prefix_index_build(index);
+ *     prefix_index_iter_prefix(index, "L", print_callback, NULL);
+ *
+ *     prefix_index_free(index);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print (duplicates are removed):
+ *
+ * ```text
+ * LAX
+ * LHR
+ * LIS
+ * ```
+ */
+
+#ifndef PREFIX_INDEX_H
+#define PREFIX_INDEX_H
+
+#include <stddef.h>
+
+/** @brief A sorted set of strings, that can be searched by prefix. */
+typedef struct prefix_index prefix_index_t;
+
+/**
+ * @brief Callback called for every string in a ::prefix_index_t that starts with a prefix.
+ *
+ * @param user_data Argument passed to ::prefix_index_iter_prefix.
+ * @param str       String that starts with the prefix.
+ *
+ * @return `0` to continue iterating, another value to stop.
+ */
+typedef int (*prefix_index_iter_callback_t)(void *user_data, const char *str);
+
+/**
+ * @brief   Creates a new empty index.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::prefix_index_free.
+ * @return  The new index, or `NULL` on allocation failure.
+ */
+prefix_index_t *prefix_index_create(void);
+
+/**
+ * @brief   Adds a string to an index, without copying it.
+ * @details @p str must outlive @p index. ::prefix_index_build must be called before the index is
+ *          searched again.
+ *
+ * @param index Index to be modified.
+ * @param str   String to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p index is left unchanged).
+ */
+int prefix_index_add(prefix_index_t *index, const char *str);
+
+/**
+ * @brief   Adds a copy of a string to an index.
+ * @details ::prefix_index_build must be called before the index is searched again.
+ *
+ * @param index Index to be modified.
+ * @param str   String to be copied and added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p index is left unchanged).
+ */
+int prefix_index_add_copy(prefix_index_t *index, const char *str);
+
+/**
+ * @brief Sorts the strings in an index and removes duplicates, so that it can be searched.
+ * @param index Index to be built.
+ */
+void prefix_index_build(prefix_index_t *index);
+
+/**
+ * @brief Iterates through all strings in an index that start with a prefix, in byte order.
+ *
+ * @param index     Index built with ::prefix_index_build.
+ * @param prefix    Prefix that all iterated strings must start with.
+ * @param callback  Method called for every matching string.
+ * @param user_data Pointer passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int prefix_index_iter_prefix(const prefix_index_t        *index,
+                             const char                  *prefix,
+                             prefix_index_iter_callback_t callback,
+                             void                        *user_data);
+
+/**
+ * @brief  Gets the number of strings in an index.
+ * @param  index Index to get the number of strings from.
+ * @return The number of strings in @p index (with duplicates, if it hasn't been built).
+ */
+size_t prefix_index_get_length(const prefix_index_t *index);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by an index.
+ * @details Strings added with ::prefix_index_add aren't owned by the index, so they aren't
+ *          accounted for.
+ *
+ * @param index Index to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p index.
+ */
+size_t prefix_index_get_memory_usage(const prefix_index_t *index);
+
+/**
+ * @brief Frees memory used by an index.
+ * @param index Index to be `free`d.
+ */
+void prefix_index_free(prefix_index_t *index);
+
+#endif
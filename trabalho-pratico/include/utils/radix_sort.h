@@ -0,0 +1,109 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    radix_sort.h
+ * @brief   Sorting of values by integer keys, without comparison functions.
+ * @details Every value to be sorted is paired with an unsigned 64-bit key, where all of its sort
+ *          criteria are packed, from the most significant to the least significant bits. For
+ *          example, to sort reservations from the latest to the earliest begin date, and then by
+ *          identifier, a key can be `(uint64_t) (UINT32_MAX - date) << 32 | id`.
+ *
+ *          Pairs are sorted with a least significant digit radix sort, one byte at a time, in
+ *          `O(n)` time. Bytes that are the same in all keys are skipped, so small keys are sorted
+ *          in fewer passes. Sorting is stable, so criteria that don't fit in a single key can be
+ *          sorted by with multiple calls, from the least significant criterion to the most
+ *          significant one.
+ *
+ * @anchor radix_sort_examples
+ * ### Examples
+ *
+ * In the following example, names are sorted by descending age, and then by height:
+ *
+ * ```c
+ * #include <stdint.h>
+ * #include <stdio.h>
+ *
+ * #include "utils/radix_sort.h"
+ *
+ * typedef struct {
+ *     const char *name;
+ *     uint32_t    age, height;
+ * } person_t;
+ *
+ * int main(void) {
+ *     const person_t people[4] = {{"José Silva", 60, 176},
+ *                                 {"José Matos", 20, 184},
+ *                                 {"Humberto Gomes", 19, 175},
+ *                                 {"José Lopes", 20, 170}};
+ *
+ *     radix_sort_item_t items[4], tmp[4];
+ *     for (size_t i = 0; i < 4; ++i) {
+ *         items[i].key   = (uint64_t) (UINT32_MAX - people[i].age) << 32 | people[i].height;
+ *         items[i].value = &people[i];
+ *     }
+ *     radix_sort(items, tmp, 4);
+ *
+ *     for (size_t i = 0; i < 4; ++i)
+ *         printf("%s\n", ((const person_t *) items[i].value)->name);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print:
+ *
+ * ```text
+ * José Silva
+ * José Lopes
+ * José Matos
+ * Humberto Gomes
+ * ```
+ */
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @struct radix_sort_item_t
+ * @brief  A value to be sorted by ::radix_sort.
+ *
+ * @var radix_sort_item_t::key
+ *     @brief Sort criteria of ::radix_sort_item_t::value, packed in an integer.
+ * @var radix_sort_item_t::value
+ *     @brief Value being sorted, not accessed by ::radix_sort.
+ */
+typedef struct {
+    uint64_t    key;
+    const void *value;
+} radix_sort_item_t;
+
+/**
+ * @brief Sorts items by ascending key, keeping the relative order of items with equal keys.
+ *
+ * @param items Items to be sorted.
+ * @param tmp   Temporary buffer, with space for @p n items. Its contents are left unspecified.
+ * @param n     Number of elements in @p items.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref radix_sort_examples).
+ */
+void radix_sort(radix_sort_item_t *items, radix_sort_item_t *tmp, size_t n);
+
+#endif
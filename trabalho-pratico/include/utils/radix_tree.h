@@ -0,0 +1,202 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    radix_tree.h
+ * @brief   An adaptive radix tree (ART) that maps strings to values, in byte order.
+ * @details Keys are split into bytes, and every inner node branches on one of them. Nodes grow
+ *          as they gain children (holding up to 4, 16, 48 or 256 of them), so that sparse nodes
+ *          stay small, and chains of nodes with a single child are collapsed into a prefix stored
+ *          in their only descendant (path compression). A lookup then visits at most as many nodes
+ *          as the key has bytes, usually much fewer, without hashing the key.
+ *
+ *          Unlike in a hash table, keys are kept in order, so the ones that start with a prefix,
+ *          or that come after a given key, can be iterated through directly, without sorting. Keys
+ *          aren't copied: only pointers to them are kept (e.g.: to strings in a ::string_pool_t).
+ *          Removals aren't supported.
+ *
+ * @anchor radix_tree_examples
+ * ### Examples
+ *
+ * ```c
+ * #include <stdint.h>
+ * #include <stdio.h>
+ *
+ * #include "utils/radix_tree.h"
+ *
+ * int print_callback(void *user_data, const char *key, void *value) {
+ *     (void) user_data;
+ *     printf("%s: %d\n", key, (int) (intptr_t) value);
+ *     return 0;
+ * }
+ *
+ * int main(void) {
+ *     radix_tree_t *tree = radix_tree_create();
+ *     if (!tree)
+ *         return 1;
+ *
+ *     const char *keys[] = {"LIS", "LHR", "OPO", "LAX", "LISBON"};
+ *     for (size_t i = 0; i < 5; ++i) {
+ *         if (radix_tree_insert(tree, keys[i], (void *) (intptr_t) i) == 1) {
+ *             radix_tree_free(tree);
+ *             return 1;
+ *         }
+ *     }
+ *
+ *     printf("%d\n", (int) (intptr_t) radix_tree_lookup(tree, "OPO"));
+ *     radix_tree_iter_prefix(tree, "L", print_callback, NULL);
+ *
+ *     radix_tree_free(tree);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print:
+ *
+ * ```text
+ * 2
+ * LAX: 3
+ * LHR: 1
+ * LIS: 0
+ * LISBON: 4
+ * ```
+ */
+
+#ifndef RADIX_TREE_H
+#define RADIX_TREE_H
+
+#include <stddef.h>
+
+/** @brief An adaptive radix tree that maps strings to values. */
+typedef struct radix_tree radix_tree_t;
+
+/**
+ * @brief Callback called for every key in an iteration over a ::radix_tree_t.
+ *
+ * @param user_data Argument passed to ::radix_tree_iter_prefix or ::radix_tree_iter_from.
+ * @param key       Key in the tree.
+ * @param value     Value associated with @p key.
+ *
+ * @return `0` to continue iterating, another value to stop.
+ */
+typedef int (*radix_tree_iter_callback_t)(void *user_data, const char *key, void *value);
+
+/**
+ * @brief   Creates a new empty radix tree.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::radix_tree_free.
+ * @return  The new tree, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref radix_tree_examples).
+ */
+radix_tree_t *radix_tree_create(void);
+
+/**
+ * @brief   Associates a key with a value in a radix tree.
+ * @details @p key isn't copied, so it must outlive @p tree.
+ *
+ * @param tree  Tree to be modified.
+ * @param key   Key to be inserted.
+ * @param value Value to associate with @p key.
+ *
+ * @retval 0 Success (@p key wasn't in @p tree).
+ * @retval 1 Allocation failure (@p tree is left unchanged).
+ * @retval 2 Success (@p key was in @p tree, and both the stored key and its value were replaced).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref radix_tree_examples).
+ */
+int radix_tree_insert(radix_tree_t *tree, const char *key, void *value);
+
+/**
+ * @brief Gets the value associated with a key in a radix tree.
+ *
+ * @param tree Tree where to perform the lookup.
+ * @param key  Key to look for.
+ *
+ * @return The value associated with @p key, or `NULL` if it isn't in @p tree.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref radix_tree_examples).
+ */
+void *radix_tree_lookup(const radix_tree_t *tree, const char *key);
+
+/**
+ * @brief Iterates through all keys in a radix tree that start with a prefix, in byte order.
+ *
+ * @param tree      Tree to iterate through.
+ * @param prefix    Prefix that all iterated keys must start with.
+ * @param callback  Method called for every matching key.
+ * @param user_data Pointer passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref radix_tree_examples).
+ */
+int radix_tree_iter_prefix(const radix_tree_t        *tree,
+                           const char                *prefix,
+                           radix_tree_iter_callback_t callback,
+                           void                      *user_data);
+
+/**
+ * @brief   Iterates through all keys in a radix tree not lower than a key, in byte order.
+ * @details Subtrees of keys lower than @p begin are skipped without being visited. For ranges
+ *          with an upper bound, @p callback should stop the iteration once it's reached.
+ *
+ * @param tree      Tree to iterate through.
+ * @param begin     Lower bound (inclusive) of the iterated keys. Doesn't need to be in @p tree.
+ * @param callback  Method called for every key from @p begin onwards.
+ * @param user_data Pointer passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int radix_tree_iter_from(const radix_tree_t        *tree,
+                         const char                *begin,
+                         radix_tree_iter_callback_t callback,
+                         void                      *user_data);
+
+/**
+ * @brief  Gets the number of keys in a radix tree.
+ * @param  tree Tree to get the number of keys from.
+ * @return The number of keys in @p tree.
+ */
+size_t radix_tree_get_length(const radix_tree_t *tree);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a radix tree.
+ * @details Keys aren't owned by the tree, so they aren't accounted for.
+ *
+ * @param tree Tree to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p tree.
+ */
+size_t radix_tree_get_memory_usage(const radix_tree_t *tree);
+
+/**
+ * @brief Frees memory used by a radix tree.
+ * @param tree Tree to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref radix_tree_examples).
+ */
+void radix_tree_free(radix_tree_t *tree);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    scratch_arena.h
+ * @brief   Per-thread memory for temporary data, freed all at once.
+ * @details Every thread has its own arena, created the first time it allocates from it, and freed
+ *          when the thread terminates. Allocations are never freed individually: instead, the whole
+ *          arena is reset with ::scratch_arena_reset, which keeps its first block, so that later
+ *          allocations don't need to go through `malloc`.
+ *
+ *          This is meant for temporary data deep inside query execution (e.g.: the matches of a
+ *          prefix search in ::user_manager_iter_name_prefix), that would otherwise be allocated and
+ *          freed for every query. The code executing the queries resets the arena between them.
+ *
+ * @anchor scratch_arena_examples
+ * ### Examples
+ *
+ * The following example sums the integers in ranges of sizes, using the arena for a temporary
+ * array:
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/scratch_arena.h"
+ *
+ * int main(void) {
+ *     for (size_t n = 1; n <= 1000; n *= 10) {
+ *         int *const numbers = scratch_arena_allocate(sizeof(int) * n);
+ *         if (!numbers)
+ *             return 1;
+ *
+ *         int sum = 0;
+ *         for (size_t i = 0; i < n; ++i) {
+ *             numbers[i] = (int) i;
+ *             sum += numbers[i];
+ *         }
+ *         printf("%zu: %d\n", n, sum);
+ *
+ *         scratch_arena_reset(); // numbers is no longer valid
+ *     }
+ *
+ *     return 0;
+ * }
+ * ```
+ */
+
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <stddef.h>
+
+/**
+ * @brief   Allocates memory from the arena of the calling thread.
+ * @details The returned memory is suitably aligned for any type, and is only valid until the next
+ *          call to ::scratch_arena_reset in the same thread. It must not be passed to `free`.
+ *
+ * @param size Number of bytes to allocate.
+ *
+ * @return A pointer to the allocated memory, or `NULL` on allocation failure.
+ */
+void *scratch_arena_allocate(size_t size);
+
+/**
+ * @brief   Frees all memory allocated from the arena of the calling thread.
+ * @details The first block of the arena is kept for future allocations. Nothing is done if the
+ *          calling thread never allocated from its arena.
+ */
+void scratch_arena_reset(void);
+
+#endif
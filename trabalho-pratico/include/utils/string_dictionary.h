@@ -0,0 +1,150 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    string_dictionary.h
+ * @brief   A dictionary that encodes strings subject to repetition as small integer codes.
+ * @details Only one copy of each string is stored. Every new string is assigned the next code
+ *          (starting at `0`), so that records can store a ::string_code_t instead of a pointer, and
+ *          comparing or grouping strings becomes an integer operation. This is meant for fields
+ *          with few distinct values (e.g.: airlines), as a dictionary can only hold up to
+ *          ::STRING_DICTIONARY_MAX_LENGTH strings.
+ *
+ * @anchor string_dictionary_examples
+ * ### Examples
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/string_dictionary.h"
+ *
+ * int main(void) {
+ *     string_dictionary_t *dictionary = string_dictionary_create(4096);
+ *     if (!dictionary)
+ *         return 1;
+ *
+ *     const char   *strings[4] = {"TAP", "Ryanair", "TAP", "Iberia"};
+ *     string_code_t codes[4];
+ *     for (size_t i = 0; i < 4; ++i) {
+ *         if (string_dictionary_encode(dictionary, strings[i], &codes[i])) {
+ *             string_dictionary_free(dictionary);
+ *             return 1;
+ *         }
+ *     }
+ *
+ *     for (size_t i = 0; i < 4; ++i)
+ *         printf("%u: %s\n", codes[i], string_dictionary_decode(dictionary, codes[i]));
+ *
+ *     string_dictionary_free(dictionary);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print:
+ *
+ * ```text
+ * 0: TAP
+ * 1: Ryanair
+ * 0: TAP
+ * 2: Iberia
+ * ```
+ */
+
+#ifndef STRING_DICTIONARY_H
+#define STRING_DICTIONARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief A dictionary that encodes strings as small integer codes. */
+typedef struct string_dictionary string_dictionary_t;
+
+/** @brief Code of a string in a ::string_dictionary_t. */
+typedef uint16_t string_code_t;
+
+/** @brief Maximum number of different strings in a ::string_dictionary_t. */
+#define STRING_DICTIONARY_MAX_LENGTH ((size_t) UINT16_MAX + 1)
+
+/**
+ * @brief   Creates a new empty dictionary.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::string_dictionary_free.
+ *
+ * @param block_capacity The number of characters of each block in the pool where strings are
+ *                       stored. See ::string_pool_create for more information.
+ *
+ * @return The new dictionary, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_dictionary_examples).
+ */
+string_dictionary_t *string_dictionary_create(size_t block_capacity);
+
+/**
+ * @brief Gets the code of a string in a dictionary, adding it to the dictionary if needed.
+ *
+ * @param dictionary Dictionary to look up @p str in.
+ * @param str        String to be encoded.
+ * @param code       Where to output the code of @p str to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure, or @p dictionary is full (::STRING_DICTIONARY_MAX_LENGTH).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_dictionary_examples).
+ */
+int string_dictionary_encode(string_dictionary_t *dictionary,
+                             const char          *str,
+                             string_code_t       *code);
+
+/**
+ * @brief Gets the string associated with a code in a dictionary.
+ *
+ * @param dictionary Dictionary where to perform the lookup.
+ * @param code       Code returned by ::string_dictionary_encode on @p dictionary.
+ *
+ * @return The string with code @p code, owned by @p dictionary.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_dictionary_examples).
+ */
+const char *string_dictionary_decode(const string_dictionary_t *dictionary, string_code_t code);
+
+/**
+ * @brief  Gets the number of strings in a dictionary.
+ * @param  dictionary Dictionary to get the number of strings from.
+ * @return The number of strings in @p dictionary. Codes range from `0` to this value (exclusive).
+ */
+size_t string_dictionary_get_length(const string_dictionary_t *dictionary);
+
+/**
+ * @brief  Gets the number of bytes of memory allocated by a dictionary.
+ * @param  dictionary Dictionary to get the memory usage of.
+ * @return The number of bytes allocated by @p dictionary, including both its strings and its
+ *         tables.
+ */
+size_t string_dictionary_get_memory_usage(const string_dictionary_t *dictionary);
+
+/**
+ * @brief Frees memory used by a dictionary.
+ * @param dictionary Dictionary to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_dictionary_examples).
+ */
+void string_dictionary_free(string_dictionary_t *dictionary);
+
+#endif
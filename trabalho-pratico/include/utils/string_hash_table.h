@@ -0,0 +1,289 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    string_hash_table.h
+ * @brief   A hash table whose keys are strings (e.g.: user identifiers).
+ * @details Unlike a `GHashTable`, the hash function is known at compile time, and all entries are
+ *          stored inline in a single array (open addressing with Robin Hood linear probing). Hashes
+ *          are cached in each entry, so that strings are only compared when hashes match.
+ *
+ *          Neither keys nor values are owned by the table: keys aren't copied, and must outlive
+ *          the table.
+ *
+ * @anchor string_hash_table_examples
+ * ### Examples
+ *
+ * In the following example, some strings are associated with numbers, which are then looked up.
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/string_hash_table.h"
+ *
+ * int main(void) {
+ *     string_hash_table_t *table = string_hash_table_create(0);
+ *     if (!table)
+ *         return 1;
+ *
+ *     const char *keys[3] = {"zero", "one", "two"};
+ *     int         values[3] = {0, 1, 2};
+ *     for (size_t i = 0; i < 3; ++i) {
+ *         if (string_hash_table_insert(table, keys[i], &values[i]) == 1) {
+ *             string_hash_table_free(table);
+ *             return 1;
+ *         }
+ *     }
+ *
+ *     string_hash_table_remove(table, "one");
+ *
+ *     const char *lookups[4] = {"zero", "one", "two", "three"};
+ *     for (size_t i = 0; i < 4; ++i) {
+ *         const int *value = string_hash_table_lookup(table, lookups[i]);
+ *         if (value)
+ *             printf("%s: %d\n", lookups[i], *value);
+ *         else
+ *             printf("%s: (not found)\n", lookups[i]);
+ *     }
+ *
+ *     string_hash_table_free(table);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print:
+ *
+ * ```text
+ * zero: 0
+ * one: (not found)
+ * two: 2
+ * three: (not found)
+ * ```
+ */
+
+#ifndef STRING_HASH_TABLE_H
+#define STRING_HASH_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief A hash table whose keys are strings. */
+typedef struct string_hash_table string_hash_table_t;
+
+/**
+ * @brief   Creates a new empty hash table.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::string_hash_table_free.
+ *
+ * @param capacity Number of entries that can be inserted before the table needs to grow (see
+ *                 ::string_hash_table_reserve). Can be `0`.
+ *
+ * @return The new hash table, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_hash_table_examples).
+ */
+string_hash_table_t *string_hash_table_create(size_t capacity);
+
+/**
+ * @brief   Makes room in a hash table for a number of entries.
+ * @details Call this before inserting many entries whose number is known beforehand, so that the
+ *          table doesn't need to grow (and rehash all its entries) multiple times.
+ *
+ * @param table Hash table to be grown, if needed.
+ * @param n     Total number of entries @p table must be able to contain without growing.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ */
+int string_hash_table_reserve(string_hash_table_t *table, size_t n);
+
+/**
+ * @brief   Shrinks a hash table to the smallest capacity that can hold its entries.
+ * @details Meant for tables that won't grow anymore, such as after space was reserved for more
+ *          entries than were inserted.
+ *
+ * @param table Hash table to be shrunk, if possible.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ */
+int string_hash_table_shrink_to_fit(string_hash_table_t *table);
+
+/**
+ * @brief   Hashes a key, as done by the hash table.
+ * @details Uses 32-bit FNV-1a. `0` is reserved for empty entries, and never returned. Use this with
+ *          ::string_hash_table_lookup_with_hash and ::string_hash_table_insert_with_hash, so that a
+ *          key that is looked up and then inserted is only hashed once.
+ *
+ * @param key Key to be hashed.
+ *
+ * @return The hash of @p key.
+ */
+uint32_t string_hash_table_hash(const char *key);
+
+/**
+ * @brief Associates a key with a value in a hash table.
+ *
+ * @param table Hash table to be modified.
+ * @param key   Key to be inserted.
+ * @param value Value to associate with @p key.
+ *
+ * @retval 0 Success (@p key wasn't in @p table).
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ * @retval 2 Success (@p key was in @p table, and its value was replaced).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_hash_table_examples).
+ */
+int string_hash_table_insert(string_hash_table_t *table, const char *key, void *value);
+
+/**
+ * @brief Same as ::string_hash_table_insert, for a key whose hash is already known.
+ *
+ * @param table Hash table to be modified.
+ * @param key   Key to be inserted.
+ * @param hash  Hash of @p key, from ::string_hash_table_hash.
+ * @param value Value to associate with @p key.
+ *
+ * @retval 0 Success (@p key wasn't in @p table).
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ * @retval 2 Success (@p key was in @p table, and its value was replaced).
+ */
+int string_hash_table_insert_with_hash(string_hash_table_t *table,
+                                       const char          *key,
+                                       uint32_t             hash,
+                                       void                *value);
+
+/**
+ * @brief Gets the value associated with a key in a hash table.
+ *
+ * @param table Hash table where to perform the lookup.
+ * @param key   Key to look for.
+ *
+ * @return The value associated with @p key, or `NULL` if @p key isn't in @p table.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_hash_table_examples).
+ */
+void *string_hash_table_lookup(const string_hash_table_t *table, const char *key);
+
+/**
+ * @brief Same as ::string_hash_table_lookup, for a key whose hash is already known.
+ *
+ * @param table Hash table where to perform the lookup.
+ * @param key   Key to look for.
+ * @param hash  Hash of @p key, from ::string_hash_table_hash.
+ *
+ * @return The value associated with @p key, or `NULL` if @p key isn't in @p table.
+ */
+void *string_hash_table_lookup_with_hash(const string_hash_table_t *table,
+                                         const char                *key,
+                                         uint32_t                   hash);
+
+/**
+ * @brief   Gets the values associated with many keys in a hash table.
+ * @details Same as calling ::string_hash_table_lookup for every key, but meant for joins with
+ *          many more keys than fit in the cache. Keys are first partitioned by the region of the
+ *          table they map to, each about the size of a cache, and then looked up one partition at
+ *          a time, so that the table is swept in order instead of being read at random. Within a
+ *          partition, the entries of up to ::PREFETCH_BATCH_SIZE keys are prefetched before any of
+ *          them is read.
+ *
+ *          If memory for partitioning can't be allocated, keys are looked up in the order they're
+ *          given.
+ *
+ * @param table  Hash table where to perform the lookups.
+ * @param n      Number of keys to look for.
+ * @param keys   Keys to look for.
+ * @param values Where to write the value associated with each key to (`NULL` for missing keys).
+ */
+void string_hash_table_lookup_batch(const string_hash_table_t *table,
+                                    size_t                     n,
+                                    const char *const          keys[n],
+                                    void                      *values[n]);
+
+/**
+ * @brief Removes a key (and its associated value) from a hash table.
+ *
+ * @param table Hash table to be modified.
+ * @param key   Key to be removed.
+ *
+ * @retval 0 Success.
+ * @retval 1 @p key wasn't in @p table.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_hash_table_examples).
+ */
+int string_hash_table_remove(string_hash_table_t *table, const char *key);
+
+/**
+ * @brief   Callback type for hash table iterations.
+ * @details Method called by ::string_hash_table_iter for every entry in a ::string_hash_table_t.
+ *
+ * @param user_data Argument passed to ::string_hash_table_iter, that is then passed to every
+ *                  callback, so that this method can change the program's state.
+ * @param key       Key of the entry.
+ * @param value     Value associated with @p key.
+ *
+ * @return `0` on success, or any other value to order iteration to stop.
+ */
+typedef int (*string_hash_table_iter_callback_t)(void *user_data, const char *key, void *value);
+
+/**
+ * @brief   Iterates through every entry in a hash table, calling a callback for each one.
+ * @details Entries are visited in no particular order. @p table must not be modified while it's
+ *          being iterated through.
+ *
+ * @param table     Hash table to iterate through.
+ * @param callback  Method to be called for every entry in @p table.
+ * @param user_data Pointer to be passed to every @p callback, so that it can modify the program's
+ *                  state.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int string_hash_table_iter(const string_hash_table_t        *table,
+                           string_hash_table_iter_callback_t callback,
+                           void                             *user_data);
+
+/**
+ * @brief  Gets the number of entries in a hash table.
+ * @param  table Hash table to get the number of entries from.
+ * @return The number of entries in @p table.
+ */
+size_t string_hash_table_get_length(const string_hash_table_t *table);
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by a hash table.
+ * @details Keys and values aren't owned by the table, so they aren't accounted for.
+ *
+ * @param table Hash table to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p table, including empty entries.
+ */
+size_t string_hash_table_get_memory_usage(const string_hash_table_t *table);
+
+/**
+ * @brief Frees memory used by a hash table.
+ * @param table Hash table to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref string_hash_table_examples).
+ */
+void string_hash_table_free(string_hash_table_t *table);
+
+#endif
@@ -19,6 +19,9 @@
 
 #include <inttypes.h>
 
+#include "utils/block_allocator.h"
+#include "utils/pool.h"
+
 /**
  * @file    string_pool.h
  * @brief   An allocator for strings.
@@ -101,6 +104,18 @@ typedef struct string_pool string_pool_t;
  */
 string_pool_t *string_pool_create(size_t block_capacity);
 
+/**
+ * @brief   Creates a string pool, choosing how its blocks are allocated.
+ * @details The returned value is owned by the caller, that should be freed with ::string_pool_free.
+ *
+ * @param block_capacity The minimum number of characters in each block in the pool.
+ * @param policy         How to allocate blocks. See ::pool_create_from_size_with_policy.
+ *
+ * @return The newly created pool, or `NULL` on failure.
+ */
+string_pool_t *string_pool_create_with_policy(size_t                   block_capacity,
+                                              block_allocator_policy_t policy);
+
 /**
  * @brief   Allocates space for a string in the pool.
  * @details That string does not need to be `free`'d, as that's done when @p pool itself is freed in
@@ -133,6 +148,12 @@ char *string_pool_allocate(string_pool_t *pool, size_t length);
  */
 char *string_pool_put(string_pool_t *pool, const char *str);
 
+/**
+ * @brief Frees memory allocated by a string pool that isn't in use. See ::pool_shrink_to_fit.
+ * @param pool String pool to be shrunk.
+ */
+void string_pool_shrink_to_fit(string_pool_t *pool);
+
 /**
  * @brief   Removes all strings from @p pool.
  * @details Keep in mind that all strings allocated using @p pool will no longer be valid (this will
@@ -144,6 +165,13 @@ char *string_pool_put(string_pool_t *pool, const char *str);
  */
 void string_pool_empty(string_pool_t *pool);
 
+/**
+ * @brief  Gets the number of bytes of memory allocated by a string pool.
+ * @param  pool String pool to get the memory usage of.
+ * @return The number of bytes allocated by @p pool (see ::pool_get_memory_usage).
+ */
+size_t string_pool_get_memory_usage(const string_pool_t *pool);
+
 /**
  * @brief Frees memory allocated by a string pool.
  * @param pool String pool to be freed.
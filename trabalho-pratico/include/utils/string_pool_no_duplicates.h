@@ -22,7 +22,10 @@
  * @brief   An allocator for strings subject to repetition, of which only one copy will be
  *          allocated.
  * @details Allocations are slightly slower than on a string pool, but memroy usage should improve
- *          by a lot if a string is repeated many times over.
+ *          by a lot if a string is repeated many times over. Strings are looked up in an
+ *          open-addressed hash table, that caches the hash and the length of every string.
+ *          Callers that already know both (see ::string_pool_no_duplicates_hash) can use
+ *          ::string_pool_no_duplicates_put_hashed.
  *
  * @anchor string_pool_no_duplicates_examples
  * ### Examples
@@ -83,6 +86,11 @@
  * `string_0` and `string_1`, despite the amount of times we call ::string_pool_no_duplicates_put,
  * meaning that only those strings are really allocated.
  */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief A string pool that only stores one copy of each string. */
 typedef struct string_pool_no_duplicates string_pool_no_duplicates_t;
 
 /**
@@ -118,6 +126,41 @@ string_pool_no_duplicates_t *string_pool_no_duplicates_create(size_t block_capac
  */
 const char *string_pool_no_duplicates_put(string_pool_no_duplicates_t *pool, const char *str);
 
+/**
+ * @brief   Calculates the hash of a string, as used by ::string_pool_no_duplicates_put_hashed.
+ * @details The length of the string is calculated in the same pass.
+ *
+ * @param str    String to be hashed.
+ * @param length Where to output the length of @p str to.
+ *
+ * @return The hash of @p str.
+ */
+uint32_t string_pool_no_duplicates_hash(const char *str, size_t *length);
+
+/**
+ * @brief   Same as ::string_pool_no_duplicates_put, for a string whose length and hash are known.
+ * @details @p str doesn't need to be null-terminated, so this can be used on tokens that are
+ *          still part of a larger string.
+ *
+ * @param pool   Pool to allocate the string in, if necessary.
+ * @param str    String to be copied to the pool, if necessary.
+ * @param length Number of characters in @p str.
+ * @param hash   Hash of @p str, as calculated by ::string_pool_no_duplicates_hash.
+ *
+ * @return The pointer to the (null-terminated) string in @p pool, or `NULL` on allocation failure.
+ */
+const char *string_pool_no_duplicates_put_hashed(string_pool_no_duplicates_t *pool,
+                                                 const char                  *str,
+                                                 size_t                       length,
+                                                 uint32_t                     hash);
+
+/**
+ * @brief  Gets the number of bytes of memory allocated by a string pool without duplicates.
+ * @param  pool Pool to get the memory usage of.
+ * @return The number of bytes allocated by @p pool, including both its strings and its table.
+ */
+size_t string_pool_no_duplicates_get_memory_usage(const string_pool_no_duplicates_t *pool);
+
 /**
  * @brief Frees memory allocated by a string pool without duplicates.
  * @param pool Pool data to be freed.
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    t_digest.h
+ * @brief   Approximate quantiles of a stream of values, in bounded memory.
+ * @details A [t-digest](https://arxiv.org/abs/1902.04023) summarizes values as a list of
+ *          centroids (a mean and a weight). Centroids near the extremes of the distribution are
+ *          kept small, and centroids near the median can grow, so that quantiles are accurate
+ *          where it matters the most, without keeping every value.
+ *
+ *          This is a merging digest: values are buffered and, when the buffer fills up, sorted and
+ *          merged into the existing centroids. Digests built by different threads can be combined
+ *          with ::t_digest_merge.
+ *
+ * @anchor t_digest_examples
+ * ### Examples
+ *
+ * In the following example, the median of a million values is approximated.
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/t_digest.h"
+ *
+ * int main(void) {
+ *     t_digest_t *digest = t_digest_create();
+ *     if (!digest)
+ *         return 1;
+ *
+ *     for (size_t i = 0; i < 1000000; ++i) {
+ *         if (t_digest_add(digest, (double) ((i * 7919) % 1000000))) {
+ *             t_digest_free(digest);
+ *             return 1;
+ *         }
+ *     }
+ *
+ *     double error;
+ *     const double median = t_digest_quantile(digest, 0.5, &error);
+ *     printf("%.0f +/- %.0f\n", median, error);
+ *
+ *     t_digest_free(digest);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print a value close to `500000`, and a small error.
+ */
+
+#ifndef T_DIGEST_H
+#define T_DIGEST_H
+
+#include <stddef.h>
+
+/** @brief Approximate quantiles of a stream of values. */
+typedef struct t_digest t_digest_t;
+
+/**
+ * @brief   Creates a new digest without any values.
+ * @details The returned value is owned by the caller, and should be `free`d with ::t_digest_free.
+ * @return  The new digest, or `NULL` on allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref t_digest_examples).
+ */
+t_digest_t *t_digest_create(void);
+
+/**
+ * @brief Adds a value to a digest.
+ *
+ * @param digest Digest to be modified.
+ * @param value  Value to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref t_digest_examples).
+ */
+int t_digest_add(t_digest_t *digest, double value);
+
+/**
+ * @brief Adds all values summarized in a digest to another digest.
+ *
+ * @param digest Digest to be modified.
+ * @param other  Digest to be merged into @p digest.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int t_digest_merge(t_digest_t *digest, const t_digest_t *other);
+
+/**
+ * @brief Gets the number of values added to a digest.
+ * @param digest Digest to get the number of values from.
+ * @return The number of values added to @p digest (including merged ones).
+ */
+size_t t_digest_get_count(const t_digest_t *digest);
+
+/**
+ * @brief   Approximates a quantile of the values in a digest.
+ * @details Buffered values are merged into centroids first, so @p digest is modified.
+ *
+ * @param digest Digest to get the quantile from. Mustn't be empty.
+ * @param q      Quantile to be approximated, between `0` and `1` (e.g.: `0.5` for the median).
+ * @param error  Where to write an upper bound of the absolute error of the approximation to: the
+ *               estimate is interpolated between two centroids, and the true quantile is assumed
+ *               to be between their means. `0` when both centroids are single values, in which
+ *               case the estimate is exact. Can be `NULL`.
+ *
+ * @return The approximate value of the quantile @p q.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref t_digest_examples).
+ */
+double t_digest_quantile(t_digest_t *digest, double q, double *error);
+
+/**
+ * @brief  Gets the number of bytes of memory used by a digest.
+ * @param  digest Digest to get the memory usage of.
+ * @return The number of bytes allocated for @p digest.
+ */
+size_t t_digest_get_memory_usage(const t_digest_t *digest);
+
+/**
+ * @brief Frees memory used by a digest.
+ * @param digest Digest to be `free`d. Can be `NULL`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref t_digest_examples).
+ */
+void t_digest_free(t_digest_t *digest);
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    table_stream.h
+ * @brief   A table of information that is drawn one row at a time, as rows are produced.
+ * @details Unlike a ::table_t, a stream doesn't keep its rows in memory, so it can be used for
+ *          tables with an arbitrary number of rows. Because of that, column widths must be known
+ *          before the first row is drawn: they are set with ::table_stream_fit_column, from a
+ *          sample of the cells or from the widest value a known format can produce. Cells wider
+ *          than their column still get drawn, but misaligned.
+ *
+ *          Tables drawn by a stream look exactly like tables drawn by ::table_draw.
+ *
+ * @anchor table_stream_examples
+ * ### Example
+ *
+ * The following example draws the same table as the one in
+ * [table.h's examples](@ref table_examples) to `stdout`.
+ *
+ * ```c
+ * table_stream_t *stream = table_stream_create(stdout, 3);
+ * if (!stream)
+ *     return 1;
+ *
+ * table_stream_fit_column(stream, 0, "Row 1");
+ * table_stream_fit_column(stream, 1, "Column 1");
+ * table_stream_fit_column(stream, 2, "Column 2");
+ *
+ * table_stream_set_cell(stream, 1, "Column 1");
+ * table_stream_set_cell(stream, 2, "Column 2");
+ * table_stream_end_row(stream);
+ *
+ * table_stream_set_cell(stream, 0, "Row 1");
+ * table_stream_set_cell(stream, 1, "%lf", 1.00);
+ * table_stream_end_row(stream);
+ *
+ * table_stream_free(stream);
+ * ```
+ */
+
+#ifndef TABLE_STREAM_H
+#define TABLE_STREAM_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/** @brief A table that is drawn one row at a time. */
+typedef struct table_stream table_stream_t;
+
+/**
+ * @brief   Creates a new table stream.
+ * @details The first row to be drawn is the table's header, whose first cell is never drawn.
+ *
+ * @param output Where to draw the table to.
+ * @param width  Width of the table. This includes its header. Must be at least `2`.
+ *
+ * @return A pointer to a new table stream that must later be deleted with ::table_stream_free, or
+ *         `NULL` on allocation failure / invalid @p width.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref table_stream_examples).
+ */
+table_stream_t *table_stream_create(FILE *output, size_t width);
+
+/**
+ * @brief   Widens a column of a table stream, so that it can fit some text.
+ * @details Only has effect before the first row is drawn.
+ *
+ * @param stream Table stream to be modified.
+ * @param x      Index of the column.
+ * @param format How to format the text to fit (`printf` format string).
+ * @param ...    Objects to be formatted accoring to @p format.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref table_stream_examples).
+ */
+void table_stream_fit_column(table_stream_t *stream, size_t x, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief   Modifies the text of a cell in the row being built by a table stream.
+ * @details Cells whose text isn't set are filled with hyphens.
+ *
+ * @param stream Table stream whose current row is to be modified.
+ * @param x      Horizontal position of the cell.
+ * @param format How to format the cell's text (`printf` format string).
+ * @param ...    Objects to be formatted accoring to @p format.
+ *
+ * @return 0 Success.
+ * @return 1 Out-of-bounds position.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref table_stream_examples).
+ */
+int table_stream_set_cell(table_stream_t *stream, size_t x, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief   Draws the row being built by a table stream, and starts a new empty row.
+ * @details The first row drawn is the table's header.
+ *
+ * @param stream Table stream whose current row is to be drawn.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref table_stream_examples).
+ */
+void table_stream_end_row(table_stream_t *stream);
+
+/**
+ * @brief   Frees memory used by a table stream.
+ * @details A row that wasn't ended with ::table_stream_end_row isn't drawn.
+ *
+ * @param stream Table stream to be `free`d.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref table_stream_examples).
+ */
+void table_stream_free(table_stream_t *stream);
+
+#endif
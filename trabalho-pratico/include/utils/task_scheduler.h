@@ -0,0 +1,168 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    task_scheduler.h
+ * @brief   A work-stealing scheduler of independent tasks, run on multiple threads.
+ * @details Each thread (worker) has its own double-ended queue of tasks. Workers take tasks from
+ *          the back of their own queue and, when it's empty, steal tasks from the front of the
+ *          queues of other workers. This way, when task costs are very uneven, no worker is left
+ *          idle while others still have tasks waiting.
+ *
+ *          Running tasks may split their work by spawning new tasks, which are added to the queue
+ *          of the worker running them (and may be stolen by other workers). Tasks can't wait for
+ *          others to finish: the last one to finish should be the one to join their results.
+ *
+ * @anchor task_scheduler_examples
+ * ### Examples
+ *
+ * The following example sums an array of integers, splitting the sum in tasks of at most `1000`
+ * elements each:
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/task_scheduler.h"
+ *
+ * #define N 1000000
+ * int  array[N];
+ * long sums[N / 1000];
+ *
+ * void sum_chunk(task_scheduler_t *scheduler, size_t worker, void *user_data, size_t i) {
+ *     (void) scheduler;
+ *     (void) worker;
+ *     (void) user_data;
+ *
+ *     for (size_t j = i * 1000; j < (i + 1) * 1000; ++j)
+ *         sums[i] += array[j];
+ * }
+ *
+ * int main(void) {
+ *     for (size_t i = 0; i < N; ++i)
+ *         array[i] = i % 10;
+ *
+ *     if (task_scheduler_run(4, N / 1000, sum_chunk, NULL))
+ *         return 1;
+ *
+ *     long sum = 0;
+ *     for (size_t i = 0; i < N / 1000; ++i)
+ *         sum += sums[i];
+ *     printf("%ld\n", sum);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print `4500000`.
+ */
+
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <stddef.h>
+
+#include "utils/numa_topology.h"
+
+/** @brief A set of workers running tasks, inside a call to ::task_scheduler_run. */
+typedef struct task_scheduler task_scheduler_t;
+
+/**
+ * @brief Type of the method called to run a task.
+ *
+ * @param scheduler Scheduler running the task, for new tasks to be spawned
+ *                  (::task_scheduler_spawn).
+ * @param worker    Index of the worker running the task (from `0` to the number of workers
+ *                  `- 1`).
+ * @param user_data Pointer provided alongside the task.
+ * @param index     Index provided alongside the task.
+ */
+typedef void (*task_scheduler_callback_t)(task_scheduler_t *scheduler,
+                                          size_t            worker,
+                                          void             *user_data,
+                                          size_t            index);
+
+/**
+ * @brief   Runs a set of tasks, and all tasks spawned by them, on multiple threads.
+ * @details Tasks are initially dealt to workers in a round-robin fashion, and each worker starts
+ *          with its tasks of lowest index. So, if tasks are sorted from most to least expensive,
+ *          the most expensive ones start first, on different workers. The first worker is the
+ *          calling thread, and the others run in the program's
+ *          [shared thread pool](@ref thread_pool.h), so that schedulers running concurrently (or
+ *          other parallel work) don't oversubscribe the machine's processors. Threads are only
+ *          created for workers when the pool is unavailable, and if they can't be created, fewer
+ *          workers are used. This method only returns after all tasks have finished.
+ *
+ * @param nthreads  Maximum number of workers (threads). If `0`, `1` is assumed.
+ * @param ntasks    Number of initial tasks.
+ * @param callback  Method called for every initial task, with indices from `0` to @p ntasks
+ *                  `- 1`.
+ * @param user_data Pointer passed to every call of @p callback.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (no tasks were run).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref task_scheduler_examples).
+ */
+int task_scheduler_run(size_t                    nthreads,
+                       size_t                    ntasks,
+                       task_scheduler_callback_t callback,
+                       void                     *user_data);
+
+/**
+ * @brief   Runs a set of tasks, like ::task_scheduler_run, with threads pinned to NUMA nodes.
+ * @details Workers are split into contiguous blocks, one per node, so that idle workers steal from
+ *          others in the same node first. The first worker (the calling thread) isn't pinned.
+ *          Workers running in the shared thread pool are already pinned to the NUMA nodes of the
+ *          machine, so @p topology is only used when the pool is unavailable.
+ *
+ * @param topology  NUMA nodes to pin worker threads to. Can be `NULL`, for threads not to be
+ *                  pinned.
+ * @param nthreads  See ::task_scheduler_run.
+ * @param ntasks    See ::task_scheduler_run.
+ * @param callback  See ::task_scheduler_run.
+ * @param user_data See ::task_scheduler_run.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (no tasks were run).
+ */
+int task_scheduler_run_pinned(const numa_topology_t    *topology,
+                              size_t                    nthreads,
+                              size_t                    ntasks,
+                              task_scheduler_callback_t callback,
+                              void                     *user_data);
+
+/**
+ * @brief   Spawns a new task, from inside a running task.
+ * @details The task is added to the back of the queue of @p worker, so it's likely to run soon, and
+ *          in the same thread. Idle workers may steal it.
+ *
+ * @param scheduler Scheduler running the task that spawns the new one.
+ * @param worker    Worker running the task that spawns the new one.
+ * @param callback  Method called to run the new task.
+ * @param user_data `user_data` parameter for @p callback.
+ * @param index     `index` parameter for @p callback.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (the task wasn't spawned, and should be run by the caller).
+ */
+int task_scheduler_spawn(task_scheduler_t         *scheduler,
+                         size_t                    worker,
+                         task_scheduler_callback_t callback,
+                         void                     *user_data,
+                         size_t                    index);
+
+#endif
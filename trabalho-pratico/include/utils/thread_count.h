@@ -0,0 +1,71 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    thread_count.h
+ * @brief   Number of threads parallel work is split across.
+ * @details By default, one thread per online processor is used. A lower limit can be set (e.g.: by
+ *          the scaling benchmark in benchmark_mode.h), which affects every module that starts
+ *          parallel work: dataset parsing, index building, query dispatching, batch mode executors,
+ *          server mode workers, and the [shared thread pool](@ref thread_pool.h).
+ *
+ * @anchor thread_count_examples
+ * ### Examples
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/thread_count.h"
+ *
+ * int main(void) {
+ *     printf("%zu\n", thread_count_get()); // Number of processors
+ *     thread_count_set(2);
+ *     printf("%zu\n", thread_count_get()); // At most 2
+ *     return 0;
+ * }
+ * ```
+ */
+
+#ifndef THREAD_COUNT_H
+#define THREAD_COUNT_H
+
+#include <stddef.h>
+
+/**
+ * @brief  Gets the number of threads parallel work should be split across.
+ * @return The number of online processors, or the limit set with ::thread_count_set, if lower.
+ *         Always at least `1`.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref thread_count_examples).
+ */
+size_t thread_count_get(void);
+
+/**
+ * @brief   Limits the number of threads parallel work is split across.
+ * @details Must be called before any parallel work starts, as the
+ *          [shared thread pool](@ref thread_pool.h) is only sized once. A process created with
+ *          `fork` gets a pool of its own, so this can be called right after forking.
+ *
+ * @param limit Maximum number of threads, or `0` to use one thread per processor.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref thread_count_examples).
+ */
+void thread_count_set(size_t limit);
+
+#endif
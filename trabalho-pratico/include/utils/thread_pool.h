@@ -0,0 +1,219 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    thread_pool.h
+ * @brief   A fixed set of worker threads, shared by all parallel work in the program.
+ * @details Creating threads for every parallel operation (and for operations nested in others)
+ *          leads to more running threads than processors, and to the cost of creating them every
+ *          time. A pool keeps a fixed number of workers, that run submitted tasks until the pool
+ *          is freed. Every worker has its own double-ended queue of tasks: tasks submitted from a
+ *          worker go to the back of its own queue, while other tasks are dealt to workers in a
+ *          round-robin fashion. Idle workers steal tasks from the front of the queues of others.
+ *
+ *          Waiting for a task (::thread_pool_future_wait) that hasn't started yet runs it in the
+ *          waiting thread. So, tasks can wait for others (even when all workers are busy) without
+ *          deadlocks, as long as they don't wait for tasks submitted after them.
+ *
+ *          Workers can be pinned to the NUMA nodes of the machine, or to single processors (see
+ *          ::thread_pool_affinity_t). The program has a shared pool (::thread_pool_get_shared),
+ *          used by [parallel_for](@ref parallel_for.h) and by the
+ *          [task scheduler](@ref task_scheduler.h), so that parallel features never oversubscribe
+ *          the machine's processors.
+ *
+ * @anchor thread_pool_examples
+ * ### Examples
+ *
+ * The following example sums two halves of an array of integers concurrently:
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/thread_pool.h"
+ *
+ * #define N 1000000
+ * int array[N];
+ *
+ * typedef struct {
+ *     size_t begin, end;
+ *     long   sum;
+ * } half_t;
+ *
+ * int sum_half(void *user_data) {
+ *     half_t *half = user_data;
+ *     for (size_t i = half->begin; i < half->end; ++i)
+ *         half->sum += array[i];
+ *     return 0;
+ * }
+ *
+ * int main(void) {
+ *     for (size_t i = 0; i < N; ++i)
+ *         array[i] = i % 10;
+ *
+ *     thread_pool_t *pool = thread_pool_get_shared();
+ *     if (!pool)
+ *         return 1;
+ *
+ *     half_t                first  = {0, N / 2, 0}, second = {N / 2, N, 0};
+ *     thread_pool_future_t *future = thread_pool_submit(pool, sum_half, &second);
+ *     sum_half(&first);
+ *     if (!future || thread_pool_future_wait(future))
+ *         return 1;
+ *
+ *     printf("%ld\n", first.sum + second.sum);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print `4500000`. Work split in blocks of a range, such as this one, can
+ * be done more easily with ::thread_pool_parallel_for.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+#include "utils/numa_topology.h"
+#include "utils/parallel_for.h"
+
+/** @brief A fixed set of worker threads, running submitted tasks. */
+typedef struct thread_pool thread_pool_t;
+
+/** @brief A task submitted to a ::thread_pool_t, whose result can be waited for. */
+typedef struct thread_pool_future thread_pool_future_t;
+
+/** @brief How the workers of a ::thread_pool_t are pinned to processors. */
+typedef enum {
+    THREAD_POOL_AFFINITY_NONE,     /**< @brief Workers aren't pinned. */
+    THREAD_POOL_AFFINITY_NODE,     /**< @brief Workers are pinned to NUMA nodes. */
+    THREAD_POOL_AFFINITY_PROCESSOR /**< @brief Workers are pinned to single processors. */
+} thread_pool_affinity_t;
+
+/**
+ * @brief   Type of the method called to run a task.
+ * @details Runs with the current [cancellation](@ref cancellation.h) of the thread that submitted
+ *          the task.
+ *
+ * @param user_data Pointer provided alongside the task.
+ *
+ * @return Any value, returned by ::thread_pool_future_wait.
+ */
+typedef int (*thread_pool_callback_t)(void *user_data);
+
+/**
+ * @brief   Creates a pool of worker threads.
+ * @details Workers are split into contiguous blocks, one per NUMA node, so that idle workers steal
+ *          from others in the same node first. With ::THREAD_POOL_AFFINITY_PROCESSOR, the workers
+ *          in each node are pinned to different processors of that node. Workers still run if they
+ *          can't be pinned.
+ *
+ * @param nthreads Number of workers. If `0`, `1` is assumed.
+ * @param topology NUMA nodes of the machine, that must outlive the pool. Can be `NULL` for workers
+ *                 not to be pinned.
+ * @param affinity How to pin workers to processors. Ignored if @p topology is `NULL`.
+ *
+ * @return A pool that must be freed with ::thread_pool_free, or `NULL` on failure (allocation, or
+ *         no thread could be created). Fewer workers than @p nthreads may have been created.
+ */
+thread_pool_t *thread_pool_create(size_t                 nthreads,
+                                  const numa_topology_t *topology,
+                                  thread_pool_affinity_t affinity);
+
+/**
+ * @brief   Gets the pool of worker threads shared by the whole program.
+ * @details Created on first use, with a worker for every thread in ::thread_count_get but one (the
+ *          calling thread of parallel operations usually works too), pinned to the NUMA nodes of
+ *          the machine. It lives until the program exits, and mustn't be freed. A process created
+ *          with `fork` doesn't inherit its parent's workers, so it gets a pool of its own.
+ *
+ * @return The shared pool, or `NULL` if it couldn't be created, or if ::thread_count_get is `1`
+ *         (parallel work should then be done in the calling thread).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref thread_pool_examples).
+ */
+thread_pool_t *thread_pool_get_shared(void);
+
+/**
+ * @brief  Gets the number of workers in a pool.
+ * @param  pool Pool to get the number of workers from.
+ * @return The number of worker threads in @p pool.
+ */
+size_t thread_pool_get_thread_count(const thread_pool_t *pool);
+
+/**
+ * @brief Submits a task to be run by a pool.
+ *
+ * @param pool      Pool to run the task.
+ * @param callback  Method called to run the task.
+ * @param user_data Pointer passed to @p callback.
+ *
+ * @return A future that must be waited for with ::thread_pool_future_wait, or `NULL` on allocation
+ *         failure (the task won't be run, and should be run by the caller).
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref thread_pool_examples).
+ */
+thread_pool_future_t *
+    thread_pool_submit(thread_pool_t *pool, thread_pool_callback_t callback, void *user_data);
+
+/**
+ * @brief   Waits for a task submitted to a pool to finish, and frees its future.
+ * @details If the task hasn't started yet, it's run in the calling thread.
+ *
+ * @param future Value returned by ::thread_pool_submit.
+ *
+ * @return The value returned by the task.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref thread_pool_examples).
+ */
+int thread_pool_future_wait(thread_pool_future_t *future);
+
+/**
+ * @brief   Calls a callback for disjoint sub-ranges of `[0, n)`, concurrently, in a pool.
+ * @details Like ::parallel_for, but sub-ranges are tasks in @p pool, rather than new threads. The
+ *          first sub-range is processed in the calling thread, as well as other sub-ranges no
+ *          worker has started by the time it's done.
+ *
+ * @param pool      Pool to run the sub-ranges.
+ * @param n         Number of indices to split in sub-ranges.
+ * @param nblocks   Number of sub-ranges to split `[0, n)` into. If `0`, `1` is assumed.
+ * @param callback  Method called for every non-empty sub-range.
+ * @param user_data Array of @p nblocks pointers. The `i`-th sub-range is processed with
+ *                  `user_data[i]`.
+ *
+ * @return The first non-zero value returned by @p callback (sub-ranges ordered by index), or `0`
+ *         if all callbacks succeeded.
+ */
+int thread_pool_parallel_for(thread_pool_t          *pool,
+                             size_t                  n,
+                             size_t                  nblocks,
+                             parallel_for_callback_t callback,
+                             void *const            *user_data);
+
+/**
+ * @brief   Frees a pool of worker threads.
+ * @details Waits for all submitted tasks to finish first. Mustn't be called from a worker of
+ *          @p pool, nor for the pool returned by ::thread_pool_get_shared.
+ *
+ * @param pool Pool to be freed.
+ */
+void thread_pool_free(thread_pool_t *pool);
+
+#endif
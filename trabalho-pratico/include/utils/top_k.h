@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    top_k.h
+ * @brief   Selection of the first `k` elements of an array, without sorting the whole array.
+ * @details Queries that output the "top N" of something only need the first `N` elements of their
+ *          sorted data. Using a bounded heap, these can be found and sorted in `O(n log k)` time,
+ *          instead of the `O(n log n)` time taken to sort the whole array.
+ *
+ *          A ::top_k_array_t goes further, for data shared by queries with different values of
+ *          `N`: the array's sorted prefix is only extended when a query asks for more elements than
+ *          were previously sorted.
+ *
+ * @anchor top_k_examples
+ * ### Examples
+ *
+ * In the following example, the three lowest numbers in an array are found:
+ *
+ * ```c
+ * int compare_ints(const void *a, const void *b) {
+ *     const int int_a = *(const int *) a, int_b = *(const int *) b;
+ *     return (int_a > int_b) - (int_a < int_b);
+ * }
+ *
+ * int main(void) {
+ *     int values[8] = {7, 3, 9, 1, 8, 2, 6, 5};
+ *     top_k_select(values, 8, sizeof(int), 3, compare_ints);
+ *
+ *     for (size_t i = 0; i < 3; ++i)
+ *         printf("%d\n", values[i]);
+ *     return 0;
+ * }
+ * ```
+ *
+ * `1`, `2` and `3` are printed, in that order. The other values are left in an unspecified order.
+ */
+
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <stddef.h>
+
+/**
+ * @brief  Function that establishes the order of elements, like the ones taken by `qsort`.
+ * @param  a Pointer to the first element.
+ * @param  b Pointer to the second element.
+ * @return A negative value if @p a comes before @p b, `0` if they're equal, and a positive value
+ *         if @p a comes after @p b.
+ */
+typedef int (*top_k_compare_t)(const void *a, const void *b);
+
+/**
+ * @brief   Moves the first @p k elements (according to @p compare) to the beginning of an array,
+ *          sorted.
+ * @details Runs in `O(n log k)` time, without allocating memory. Elements after the first @p k are
+ *          left in an unspecified order.
+ *
+ * @param base    Array of elements to be reordered.
+ * @param n       Number of elements in @p base.
+ * @param size    Size of each element, in bytes.
+ * @param k       Number of elements to be selected. If greater than @p n, the whole array is
+ *                sorted.
+ * @param compare Function that establishes the order of elements.
+ *
+ * #### Examples
+ * See [the header file's documentation](@ref top_k_examples).
+ */
+void top_k_select(void *base, size_t n, size_t size, size_t k, top_k_compare_t compare);
+
+/** @brief An array whose prefix is sorted as needed, so that it can be read by many threads. */
+typedef struct top_k_array top_k_array_t;
+
+/**
+ * @brief Creates a new ::top_k_array_t.
+ *
+ * @param items   Array of elements, allocated with `malloc`. The ::top_k_array_t takes ownership
+ *                of it, even on failure.
+ * @param n       Number of elements in @p items.
+ * @param size    Size of each element, in bytes.
+ * @param compare Function that establishes the order of elements.
+ *
+ * @return A pointer to a ::top_k_array_t that must be deleted with ::top_k_array_free, or `NULL`
+ *         on allocation failure.
+ */
+top_k_array_t *top_k_array_create(void *items, size_t n, size_t size, top_k_compare_t compare);
+
+/**
+ * @brief   Gets the first elements of a ::top_k_array_t, sorting them if needed.
+ * @details Can be called from many threads at once. The returned elements are never reordered
+ *          again, as later calls only sort what comes after them.
+ *
+ * @param array Array to get the elements from.
+ * @param k     Number of elements needed. If greater than the size of @p array, all elements are
+ *              sorted.
+ * @param out_n Where to write the number of sorted elements that can be read to (the minimum
+ *              between @p k and the size of @p array).
+ *
+ * @return A pointer to the first element of @p array, valid until ::top_k_array_free is called.
+ */
+const void *top_k_array_get(top_k_array_t *array, size_t k, size_t *out_n);
+
+/**
+ * @brief Frees memory allocated by ::top_k_array_create.
+ * @param array Value returned by ::top_k_array_create.
+ */
+void top_k_array_free(top_k_array_t *array);
+
+#endif
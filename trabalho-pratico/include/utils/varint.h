@@ -0,0 +1,98 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file    varint.h
+ * @brief   Compression of arrays of 32-bit integers as variable-length deltas.
+ * @details Every value is stored as the difference to the value before it (the first one is
+ *          compared to `0`). Differences are zigzag-encoded (`0, -1, 1, -2, ...` become
+ *          `0, 1, 2, 3, ...`), so that arrays don't need to be sorted, and then written in 7-bit
+ *          groups, least significant first, with the most significant bit of every byte set when
+ *          more bytes follow. Arrays of close values, such as identifiers of entities loaded around
+ *          the same time, take one or two bytes per value instead of four.
+ *
+ *          Encoded arrays don't store their length, which must be kept by the caller.
+ *
+ * @anchor varint_examples
+ * ### Examples
+ *
+ * ```c
+ * #include <stdio.h>
+ *
+ * #include "utils/varint.h"
+ *
+ * int main(void) {
+ *     const uint32_t values[4] = {1000, 1002, 999, 1500};
+ *     uint8_t        encoded[VARINT_MAX_LENGTH * 4];
+ *     const size_t   length = varint_encode_deltas(values, 4, encoded);
+ *
+ *     uint32_t decoded[4];
+ *     varint_decode_deltas(encoded, 4, decoded);
+ *
+ *     printf("%zu bytes\n", length);
+ *     for (size_t i = 0; i < 4; ++i)
+ *         printf("%u\n", decoded[i]);
+ *     return 0;
+ * }
+ * ```
+ *
+ * The example above should print `6 bytes`, followed by the original values.
+ */
+
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Maximum number of bytes a single encoded value can take. */
+#define VARINT_MAX_LENGTH 5
+
+/**
+ * @brief Encodes an array of integers as variable-length deltas.
+ *
+ * @param values Values to be encoded.
+ * @param n      Number of elements in @p values.
+ * @param out    Where to write the encoded values to. Must have space for ::VARINT_MAX_LENGTH
+ *               times @p n bytes.
+ *
+ * @return The number of bytes written to @p out.
+ */
+size_t varint_encode_deltas(const uint32_t *values, size_t n, uint8_t *out);
+
+/**
+ * @brief Counts the bytes ::varint_encode_deltas would write, without writing them.
+ *
+ * @param values Values to be encoded.
+ * @param n      Number of elements in @p values.
+ *
+ * @return The number of bytes needed to encode @p values.
+ */
+size_t varint_get_encoded_length(const uint32_t *values, size_t n);
+
+/**
+ * @brief Decodes an array of integers encoded by ::varint_encode_deltas.
+ *
+ * @param in  Encoded values.
+ * @param n   Number of values to decode from @p in.
+ * @param out Where to write the @p n decoded values to.
+ *
+ * @return A pointer to the first byte in @p in after the decoded values.
+ */
+const uint8_t *varint_decode_deltas(const uint8_t *in, size_t n, uint32_t *out);
+
+#endif
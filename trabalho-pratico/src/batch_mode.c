@@ -23,24 +23,86 @@
  */
 
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
+#include "batch_mode.h"
+#include "dataset/dataset_input.h"
 #include "dataset/dataset_loader.h"
 #include "queries/query_dispatcher.h"
+#include "queries/query_file_compiler.h"
 #include "queries/query_file_parser.h"
+#include "queries/query_result_cache.h"
+#include "utils/blocking_queue.h"
+#include "utils/scratch_arena.h"
+#include "utils/thread_count.h"
+
+/**
+ * @brief Gets the path of the file, in the `Resultados` directory, where a query is outputted to.
+ *
+ * @param binary   Whether the output is binary (see ::query_writer_set_binary).
+ * @param instance Query whose output will be written.
+ * @param path     Where to write the path to.
+ */
+void __batch_mode_get_output_path(int binary, const query_instance_t *instance, char *path) {
+    sprintf(path,
+            "Resultados/command%zu_output.%s",
+            query_instance_get_line_in_file(instance),
+            binary ? "bin" : "txt");
+}
+
+/**
+ * @brief Creates the writer to which the output of a query will be written to.
+ *
+ * @param container Container where to write the output to. If `NULL`, the output is written to its
+ *                  own file, in the `Resultados` directory.
+ * @param binary    Whether to output [binary records](@ref query_writer_binary_format) instead of
+ *                  text. Files of binary output end in `.bin` instead of `.txt`.
+ * @param instance  Query whose output will be written.
+ *
+ * @return A writer that must be `free`d with ::query_writer_free, or `NULL` on allocation failure.
+ */
+query_writer_t *__batch_mode_create_writer(query_output_container_t *container,
+                                           int                       binary,
+                                           const query_instance_t   *instance) {
+    const size_t line      = query_instance_get_line_in_file(instance);
+    const int    formatted = query_instance_get_formatted(instance);
+
+    query_writer_t *writer;
+    if (container) {
+        writer = query_writer_create_in_container(container, line, formatted);
+    } else {
+        /* Parent directory creation is assured by error file output while loading the dataset */
+        char path[PATH_MAX];
+        __batch_mode_get_output_path(binary, instance, path);
+        writer = query_writer_create(path, formatted);
+    }
+
+    if (writer && binary)
+        query_writer_set_binary(writer);
+    return writer;
+}
 
 /**
  * @struct batch_mode_iter_data_t
  * @brief  Data structure used for query iteration in ::__batch_mode_init_file_callback.
  *
+ * @var batch_mode_iter_data_t::container
+ *     @brief Container where to write query outputs to (`NULL` for a file per query).
+ * @var batch_mode_iter_data_t::binary
+ *     @brief Whether query outputs are binary (see ::query_writer_set_binary).
  * @var batch_mode_iter_data_t::outputs
  *     @brief Where to write opened query output writers to.
  * @var batch_mode_iter_data_t::i
  *     @brief Index of the query being currently dealt with.
  */
 typedef struct {
-    query_writer_t **const outputs;
-    size_t                 i;
+    query_output_container_t *const container;
+    const int                       binary;
+    query_writer_t **const          outputs;
+    size_t                          i;
 } batch_mode_iter_data_t;
 
 /**
@@ -52,12 +114,8 @@ typedef struct {
 int __batch_mode_init_file_callback(void *user_data, const query_instance_t *instance) {
     batch_mode_iter_data_t *const iter_data = user_data;
 
-    /* Parent directory creation is assured by error file output while loading the dataset */
-    char path[PATH_MAX];
-    sprintf(path, "Resultados/command%zu_output.txt", query_instance_get_line_in_file(instance));
-
     iter_data->outputs[iter_data->i] =
-        query_writer_create(path, query_instance_get_formatted(instance));
+        __batch_mode_create_writer(iter_data->container, iter_data->binary, instance);
 
     if (!iter_data->outputs[iter_data->i]) {
         /* On failure, delete all writers already created */
@@ -72,35 +130,40 @@ int __batch_mode_init_file_callback(void *user_data, const query_instance_t *ins
 
 int batch_mode_run(const char            *dataset_dir,
                    const char            *query_file_path,
+                   const char            *container_path,
                    performance_metrics_t *metrics) {
 
     int retval = 0;
 
-    FILE *const query_file = fopen(query_file_path, "r");
-    if (!query_file) {
+    query_instance_list_t *const query_instance_list =
+        query_file_compiler_load_or_parse(query_file_path);
+    if (!query_instance_list) {
         retval = 1;
         fputs("Failed to read query file!\n", stderr);
         goto DEFER_1;
     }
 
-    query_instance_list_t *const query_instance_list = query_file_parser_parse(query_file);
-    if (!query_instance_list) {
-        retval = 1;
-        fputs("Failed to allocate list of queries!\n", stderr);
-        goto DEFER_2;
-    }
-
     database_t *const database = database_create();
     if (!database) {
         retval = 1;
         fputs("Failed to allocate database!\n", stderr);
-        goto DEFER_3;
+        goto DEFER_2;
     }
 
+    /* The query dispatcher builds only the indices that the queries in the file need */
+    database_set_index_policy(database, DATABASE_INDEX_POLICY_LAZY);
     if (dataset_loader_load(database, dataset_dir, "Resultados", metrics)) {
         retval = 1;
         fputs("Failed to load dataset files!\n", stderr);
-        goto DEFER_4;
+        goto DEFER_3;
+    }
+
+    query_output_container_t *const container =
+        container_path ? query_output_container_create(container_path) : NULL;
+    if (container_path && !container) {
+        retval = 1;
+        fputs("Failed to create query output container!\n", stderr);
+        goto DEFER_3;
     }
 
     query_writer_t **const query_outputs =
@@ -111,7 +174,7 @@ int batch_mode_run(const char            *dataset_dir,
         goto DEFER_4;
     }
 
-    batch_mode_iter_data_t iter_data = {.outputs = query_outputs, .i = 0};
+    batch_mode_iter_data_t iter_data = {.container = container, .outputs = query_outputs, .i = 0};
     if (query_instance_list_iter(query_instance_list,
                                  __batch_mode_init_file_callback,
                                  &iter_data)) {
@@ -120,19 +183,771 @@ int batch_mode_run(const char            *dataset_dir,
         goto DEFER_5;
     }
 
-    query_dispatcher_dispatch_list(database, query_instance_list, query_outputs, metrics);
+    query_dispatcher_dispatch_list(database,
+                                   NULL,
+                                   query_instance_list,
+                                   query_outputs,
+                                   0,
+                                   metrics);
+    performance_metrics_measure_database_memory(metrics, database);
 
     for (size_t i = 0; i < query_instance_list_get_length(query_instance_list); ++i)
         query_writer_free(query_outputs[i]);
 
+    if (container && query_output_container_close(container)) {
+        retval = 1;
+        fputs("Failed to write query output container!\n", stderr);
+    }
+
 DEFER_5:
     free(query_outputs);
 DEFER_4:
-    database_free(database);
+    if (container)
+        query_output_container_free(container);
 DEFER_3:
+    database_free(database);
+DEFER_2:
     query_instance_list_free(query_instance_list);
+DEFER_1:
+    return retval;
+}
+
+/**
+ * @brief Beginning of the names of the files, in the cache directory, where
+ *        ::batch_mode_run_streaming keeps statistical data (see ::query_statistics_store_t).
+ */
+#define BATCH_MODE_STATISTICS_FILE_PREFIX ".query_statistics_"
+
+/**
+ * @brief Name of the directory, in the cache directory, where ::batch_mode_run_streaming keeps
+ *        query outputs (see ::query_result_cache_t).
+ */
+#define BATCH_MODE_RESULTS_DIRECTORY_NAME ".query_results"
+
+/** @brief Maximum number of parsed queries waiting to be executed in ::batch_mode_run_streaming. */
+#define BATCH_MODE_STREAMING_PENDING_QUERIES 4096
+
+/** @brief Maximum number of query outputs waiting to be written in ::batch_mode_run_streaming. */
+#define BATCH_MODE_STREAMING_PENDING_OUTPUTS 1024
+
+/**
+ * @brief   Whether the database and the queries are freed before batch mode returns.
+ * @details Batch mode is followed by the program's exit, where the operating system drops all
+ *          memory at once, which is much faster than freeing every pool and hash table of a large
+ *          database. Leak checkers report that memory as lost, so it's only freed in builds with
+ *          `FREE_AT_EXIT` defined (debug builds, and `make FREE_AT_EXIT=1`).
+ */
+#ifdef FREE_AT_EXIT
+    #define BATCH_MODE_FREE_AT_EXIT 1
+#else
+    #define BATCH_MODE_FREE_AT_EXIT 0
+#endif
+
+/**
+ * @struct batch_mode_parser_data_t
+ * @brief  Data used by the query file parsing thread in ::batch_mode_run_streaming.
+ *
+ * @var batch_mode_parser_data_t::query_file
+ *     @brief File to parse queries from.
+ * @var batch_mode_parser_data_t::compiled_path
+ *     @brief   Path to ::batch_mode_parser_data_t::query_file, if it's a compiled query file.
+ *     @details `NULL` for text query files. Compiled query files are mapped instead of being read
+ *              from ::batch_mode_parser_data_t::query_file.
+ * @var batch_mode_parser_data_t::stateful_queries
+ *     @brief Where to add queries that need statistical data to, to be dispatched once all queries
+ *            are parsed.
+ * @var batch_mode_parser_data_t::stateless_queries
+ *     @brief Where to push queries that don't need statistical data to, to be executed as soon as
+ *            possible. Closed when parsing ends.
+ * @var batch_mode_parser_data_t::retval
+ *     @brief Value returned by ::query_file_parser_iter (or ::query_file_compiler_iter).
+ */
+typedef struct {
+    FILE *const                  query_file;
+    const char *const            compiled_path;
+    query_instance_list_t *const stateful_queries;
+    blocking_queue_t *const      stateless_queries;
+    int                          retval;
+} batch_mode_parser_data_t;
+
+/**
+ * @brief Called for each parsed query, to hand it over to who will execute it.
+ *
+ * @param user_data A pointer to a ::batch_mode_parser_data_t.
+ * @param instance  Query that was parsed.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ * @retval 2 ::batch_mode_parser_data_t::stateless_queries was closed (execution was cancelled).
+ */
+int __batch_mode_streaming_parse_callback(void *user_data, const query_instance_t *instance) {
+    batch_mode_parser_data_t *const parser_data = user_data;
+
+    if (query_type_needs_statistics(query_instance_get_type(instance)))
+        return query_instance_list_add(parser_data->stateful_queries, instance);
+
+    query_instance_t *const clone = query_instance_clone(NULL, NULL, instance);
+    if (!clone)
+        return 1;
+
+    if (blocking_queue_push(parser_data->stateless_queries, clone)) {
+        query_instance_free(clone);
+        return 2;
+    }
+    return 0;
+}
+
+/**
+ * @brief  Entry point of the query file parsing thread in ::batch_mode_run_streaming.
+ * @param  parser_data A pointer to a ::batch_mode_parser_data_t.
+ * @return Always `NULL`.
+ */
+void *__batch_mode_parser_thread(void *parser_data) {
+    batch_mode_parser_data_t *const data = parser_data;
+
+    const query_file_parser_iter_callback_t callback = __batch_mode_streaming_parse_callback;
+    if (data->compiled_path)
+        data->retval = query_file_compiler_iter(data->compiled_path, callback, data);
+    else
+        data->retval = query_file_parser_iter(data->query_file, callback, data);
+    blocking_queue_close(data->stateless_queries); /* Let executors finish */
+    return NULL;
+}
+
+/**
+ * @struct batch_mode_executor_data_t
+ * @brief  Data used by a thread that executes stateless queries in ::batch_mode_run_streaming.
+ *
+ * @var batch_mode_executor_data_t::database
+ *     @brief Database, so that queries can get information.
+ * @var batch_mode_executor_data_t::container
+ *     @brief Container where to write query outputs to (`NULL` for a file per query).
+ * @var batch_mode_executor_data_t::binary
+ *     @brief Whether query outputs are binary (see ::query_writer_set_binary).
+ * @var batch_mode_executor_data_t::results
+ *     @brief Outputs of previous runs, looked up before executing queries (or `NULL`).
+ * @var batch_mode_executor_data_t::queries
+ *     @brief Queries to be executed (and then `free`d).
+ * @var batch_mode_executor_data_t::outputs
+ *     @brief Where to push finished query writers to, so that they're written by the writer
+ *            thread. If `NULL`, writers are written and `free`d by the executor itself.
+ * @var batch_mode_executor_data_t::failed
+ *     @brief Whether the output of a query couldn't be created.
+ */
+typedef struct {
+    const database_t           *database;
+    query_output_container_t   *container;
+    int                         binary;
+    const query_result_cache_t *results;
+    blocking_queue_t           *queries, *outputs;
+    int                         failed;
+} batch_mode_executor_data_t;
+
+/**
+ * @brief  Entry point of a thread that executes stateless queries in ::batch_mode_run_streaming.
+ * @param  executor_data A pointer to a ::batch_mode_executor_data_t.
+ * @return Always `NULL`.
+ */
+void *__batch_mode_executor_thread(void *executor_data) {
+    batch_mode_executor_data_t *const data = executor_data;
+
+    query_instance_t *instance;
+    while ((instance = blocking_queue_pop(data->queries))) {
+        char path[PATH_MAX];
+        __batch_mode_get_output_path(data->binary, instance, path);
+        if (data->results && !query_result_cache_get(data->results, instance, data->binary, path)) {
+            query_instance_free(instance);
+            continue;
+        }
+
+        query_writer_t *const output =
+            __batch_mode_create_writer(data->container, data->binary, instance);
+        if (output) {
+            query_writer_set_page(output,
+                                  query_instance_get_offset(instance),
+                                  query_instance_get_limit(instance));
+            query_type_list_reserve_output(data->database, NULL, instance, output);
+            const int failed = query_type_list_execute(data->database, NULL, instance, output);
+            scratch_arena_reset();
+
+            /* Outputs are only cached once they're complete in their files */
+            if (data->results && !failed && !query_writer_close(output))
+                query_result_cache_put(data->results, instance, data->binary, path);
+
+            if (!data->outputs || blocking_queue_push(data->outputs, output))
+                query_writer_free(output); /* Write output file now, ignoring errors */
+        } else {
+            data->failed = 1;
+        }
+
+        query_instance_free(instance);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   Entry point of the thread that writes query outputs in ::batch_mode_run_streaming.
+ * @details Writes (and `free`s) every query writer until the queue of outputs is closed.
+ *
+ * @param  outputs A ::blocking_queue_t of ::query_writer_t.
+ * @return Always `NULL`.
+ */
+void *__batch_mode_writer_thread(void *outputs) {
+    query_writer_t *output;
+    while ((output = blocking_queue_pop(outputs)))
+        query_writer_free(output); /* Ignore IO errors */
+    return NULL;
+}
+
+/**
+ * @brief Executes a list of queries that need statistical data.
+ *
+ * @param database            Database, so that the queries can get information.
+ * @param query_instance_list Queries to be executed.
+ * @param container           Container where to write query outputs to (`NULL` for a file per
+ *                            query).
+ * @param binary              Whether query outputs are binary (see ::query_writer_set_binary).
+ * @param cache               Cache of statistical data (backed by a store), or `NULL`.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message will also be printed to `stderr`.
+ */
+int __batch_mode_dispatch_list(const database_t         *database,
+                               query_instance_list_t    *query_instance_list,
+                               query_output_container_t *container,
+                               int                       binary,
+                               query_statistics_cache_t *cache) {
+    const size_t length = query_instance_list_get_length(query_instance_list);
+    if (length == 0)
+        return 0;
+
+    query_writer_t **const query_outputs = malloc(sizeof(query_writer_t *) * length);
+    if (!query_outputs) {
+        fputs("Failed to allocate list of query outputs!\n", stderr);
+        return 1;
+    }
+
+    batch_mode_iter_data_t iter_data = {.container = container,
+                                        .binary    = binary,
+                                        .outputs   = query_outputs,
+                                        .i         = 0};
+    if (query_instance_list_iter(query_instance_list,
+                                 __batch_mode_init_file_callback,
+                                 &iter_data)) {
+        fputs("Failed to open one of the query outputs!\n", stderr);
+        free(query_outputs);
+        return 1;
+    }
+
+    query_dispatcher_dispatch_list(database, cache, query_instance_list, query_outputs, 0, NULL);
+
+    for (size_t i = 0; i < length; ++i)
+        query_writer_free(query_outputs[i]);
+    free(query_outputs);
+    return 0;
+}
+
+/**
+ * @struct batch_mode_results_data_t
+ * @brief  Data used while looking up and adding query outputs to a ::query_result_cache_t.
+ *
+ * @var batch_mode_results_data_t::results
+ *     @brief Outputs of previous runs.
+ * @var batch_mode_results_data_t::binary
+ *     @brief Whether query outputs are binary (see ::query_writer_set_binary).
+ * @var batch_mode_results_data_t::misses
+ *     @brief Where to add queries whose output isn't in ::batch_mode_results_data_t::results to.
+ */
+typedef struct {
+    const query_result_cache_t *const results;
+    const int                         binary;
+    query_instance_list_t *const      misses;
+} batch_mode_results_data_t;
+
+/**
+ * @brief Called for each query, to copy its output from a ::query_result_cache_t, or to keep it
+ *        to be executed if that isn't possible.
+ *
+ * @param user_data A pointer to a ::batch_mode_results_data_t.
+ * @param instance  Query to be looked up.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __batch_mode_get_result_callback(void *user_data, const query_instance_t *instance) {
+    batch_mode_results_data_t *const data = user_data;
+
+    char path[PATH_MAX];
+    __batch_mode_get_output_path(data->binary, instance, path);
+    if (!query_result_cache_get(data->results, instance, data->binary, path))
+        return 0;
+    return query_instance_list_add(data->misses, instance);
+}
+
+/**
+ * @brief Called for each executed query, to add its output to a ::query_result_cache_t.
+ *
+ * @param user_data A pointer to a ::batch_mode_results_data_t.
+ * @param instance  Query that was executed.
+ *
+ * @retval 0 Always successful (failing to cache an output isn't an error).
+ */
+int __batch_mode_put_result_callback(void *user_data, const query_instance_t *instance) {
+    const batch_mode_results_data_t *const data = user_data;
+
+    char path[PATH_MAX];
+    __batch_mode_get_output_path(data->binary, instance, path);
+    query_result_cache_put(data->results, instance, data->binary, path);
+    return 0;
+}
+
+/**
+ * @brief Executes all queries that need statistical data, after they've all been parsed.
+ *
+ * @param database            Database, so that the queries can get information.
+ * @param query_instance_list Queries to be executed.
+ * @param container           Container where to write query outputs to (`NULL` for a file per
+ *                            query).
+ * @param binary              Whether query outputs are binary (see ::query_writer_set_binary).
+ * @param cache               Cache of statistical data (backed by a store), or `NULL`.
+ * @param results             Outputs of previous runs, or `NULL`. Only queries whose output isn't
+ *                            here are executed, and their outputs are then added to it.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message will also be printed to `stderr`.
+ */
+int __batch_mode_dispatch_stateful(const database_t           *database,
+                                   query_instance_list_t      *query_instance_list,
+                                   query_output_container_t   *container,
+                                   int                         binary,
+                                   query_statistics_cache_t   *cache,
+                                   const query_result_cache_t *results) {
+    if (!results)
+        return __batch_mode_dispatch_list(database, query_instance_list, container, binary, cache);
+
+    query_instance_list_t *const misses = query_instance_list_create();
+    if (!misses) {
+        fputs("Failed to allocate list of queries!\n", stderr);
+        return 1;
+    }
+
+    int                       retval = 1;
+    batch_mode_results_data_t data   = {.results = results, .binary = binary, .misses = misses};
+    if (query_instance_list_iter(query_instance_list, __batch_mode_get_result_callback, &data)) {
+        fputs("Failed to allocate list of queries!\n", stderr);
+        goto DEFER_1;
+    }
+
+    retval = __batch_mode_dispatch_list(database, misses, container, binary, cache);
+    if (!retval)
+        query_instance_list_iter(misses, __batch_mode_put_result_callback, &data);
+
+DEFER_1:
+    query_instance_list_free(misses);
+    return retval;
+}
+
+/**
+ * @brief   Executes all queries in ::batch_mode_run_streaming, after the dataset is loaded.
+ * @details Stateless queries are executed while the query file is still being parsed, and the
+ *          remaining queries are dispatched after parsing ends.
+ *
+ * @param database      Database, so that the queries can get information.
+ * @param parser_thread Thread parsing the query file (joined by this method).
+ * @param parser_data   Data used by @p parser_thread.
+ * @param outputs       Empty queue where to push query writers to, to be written by a writer
+ *                      thread.
+ * @param container     Container where to write query outputs to (`NULL` for a file per query).
+ * @param binary        Whether query outputs are binary (see ::query_writer_set_binary).
+ * @param cache         Cache of statistical data for stateful queries, or `NULL`.
+ * @param results       Outputs of previous runs, or `NULL` (must be `NULL` with a @p container).
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message will also be printed to `stderr`.
+ */
+int __batch_mode_execute_streaming(const database_t           *database,
+                                   pthread_t                   parser_thread,
+                                   batch_mode_parser_data_t   *parser_data,
+                                   blocking_queue_t           *outputs,
+                                   query_output_container_t   *container,
+                                   int                         binary,
+                                   query_statistics_cache_t   *cache,
+                                   const query_result_cache_t *results) {
+    int retval = 0;
+
+    /* Start executing stateless queries, while the rest of the file is parsed */
+    pthread_t writer_thread;
+    const int has_writer_thread =
+        !pthread_create(&writer_thread, NULL, __batch_mode_writer_thread, outputs);
+
+    const size_t nexecutors = thread_count_get();
+
+    /* The last element is used by the calling thread */
+    batch_mode_executor_data_t executor_data[nexecutors + 1];
+    pthread_t                  executor_threads[nexecutors];
+    for (size_t i = 0; i <= nexecutors; ++i)
+        executor_data[i] =
+            (batch_mode_executor_data_t){.database  = database,
+                                         .container = container,
+                                         .binary    = binary,
+                                         .results   = results,
+                                         .queries   = parser_data->stateless_queries,
+                                         .outputs   = has_writer_thread ? outputs : NULL,
+                                         .failed    = 0};
+
+    size_t nstarted = 0;
+    for (; nstarted < nexecutors; ++nstarted)
+        if (pthread_create(executor_threads + nstarted,
+                           NULL,
+                           __batch_mode_executor_thread,
+                           executor_data + nstarted))
+            break; /* Keep going with the threads that were created */
+
+    pthread_join(parser_thread, NULL);
+    if (parser_data->retval) {
+        retval = 1;
+        fputs("Failed to allocate list of queries!\n", stderr);
+    } else if (__batch_mode_dispatch_stateful(database,
+                                              parser_data->stateful_queries,
+                                              container,
+                                              binary,
+                                              cache,
+                                              results)) {
+        retval = 1;
+    }
+
+    /* Help with the remaining stateless queries (needed if no executor could be started) */
+    __batch_mode_executor_thread(executor_data + nexecutors);
+    for (size_t i = 0; i < nstarted; ++i)
+        pthread_join(executor_threads[i], NULL);
+
+    for (size_t i = 0; i <= nexecutors; ++i) {
+        if (executor_data[i].failed) {
+            retval = 1;
+            fputs("Failed to open one of the query outputs!\n", stderr);
+            break;
+        }
+    }
+
+    blocking_queue_close(outputs);
+    if (has_writer_thread)
+        pthread_join(writer_thread, NULL);
+    return retval;
+}
+
+/**
+ * @brief   Creates a cache of statistical data, backed by a store in the cache directory.
+ * @details Failing to create the cache isn't an error: statistics just aren't kept across runs.
+ *
+ * @param dataset_dir Path to the directory containing the dataset.
+ * @param cache_dir   Path to the directory where to keep the store, or `NULL` for no cache.
+ * @param store       Where to write the store backing the returned cache to (`NULL` on failure).
+ *                    It must be freed with ::query_statistics_store_free, after the cache.
+ *
+ * @return A cache that must be freed with ::query_statistics_cache_free, or `NULL` on failure.
+ */
+query_statistics_cache_t *__batch_mode_create_cache(const char                *dataset_dir,
+                                                    const char                *cache_dir,
+                                                    query_statistics_store_t **store) {
+    *store = NULL;
+
+    uint64_t fingerprint;
+    if (!cache_dir || dataset_input_get_fingerprint(dataset_dir, &fingerprint))
+        return NULL;
+
+    char store_prefix[PATH_MAX];
+    if (snprintf(store_prefix, PATH_MAX, "%s/" BATCH_MODE_STATISTICS_FILE_PREFIX, cache_dir) >=
+        PATH_MAX)
+        return NULL;
+
+    *store = query_statistics_store_create(store_prefix, fingerprint);
+    if (!*store)
+        return NULL;
+
+    query_statistics_cache_t *const cache = query_statistics_cache_create();
+    if (!cache) {
+        query_statistics_store_free(*store);
+        *store = NULL;
+        return NULL;
+    }
+
+    query_statistics_cache_set_store(cache, *store);
+    return cache;
+}
+
+/**
+ * @brief   Creates a cache of query outputs, in the cache directory.
+ * @details Failing to create the cache isn't an error: outputs just aren't kept across runs.
+ *
+ * @param dataset_dir Path to the directory containing the dataset.
+ * @param cache_dir   Path to the directory where to keep the outputs, or `NULL` for no cache.
+ *
+ * @return A cache that must be freed with ::query_result_cache_free, or `NULL` on failure.
+ */
+query_result_cache_t *__batch_mode_create_results(const char *dataset_dir, const char *cache_dir) {
+    uint64_t fingerprint;
+    if (!cache_dir || dataset_input_get_fingerprint(dataset_dir, &fingerprint))
+        return NULL;
+
+    char directory[PATH_MAX];
+    if (snprintf(directory, PATH_MAX, "%s/" BATCH_MODE_RESULTS_DIRECTORY_NAME, cache_dir) >=
+        PATH_MAX)
+        return NULL;
+
+    return query_result_cache_create(directory, fingerprint);
+}
+
+/**
+ * @brief Stops the query file parsing thread in ::batch_mode_run_streaming, before any query is
+ *        executed.
+ *
+ * @param parser_thread     Thread parsing the query file (joined by this method).
+ * @param stateless_queries Queue where @p parser_thread pushes queries to. Closed and emptied by
+ *                          this method.
+ */
+void __batch_mode_cancel_parser(pthread_t parser_thread, blocking_queue_t *stateless_queries) {
+    blocking_queue_close(stateless_queries); /* Order the parser to stop */
+    pthread_join(parser_thread, NULL);
+    for (query_instance_t *instance; (instance = blocking_queue_pop(stateless_queries));)
+        query_instance_free(instance);
+}
+
+int batch_mode_run_streaming(const char *dataset_dir,
+                             const char *cache_dir,
+                             const char *query_file_path,
+                             const char *container_path,
+                             int         binary) {
+    int retval = 0;
+
+    FILE *const query_file = fopen(query_file_path, "r");
+    if (!query_file) {
+        retval = 1;
+        fputs("Failed to read query file!\n", stderr);
+        goto DEFER_1;
+    }
+
+    query_instance_list_t *const stateful_queries = query_instance_list_create();
+    if (!stateful_queries) {
+        retval = 1;
+        fputs("Failed to allocate list of queries!\n", stderr);
+        goto DEFER_2;
+    }
+
+    blocking_queue_t *const stateless_queries =
+        blocking_queue_create(BATCH_MODE_STREAMING_PENDING_QUERIES);
+    if (!stateless_queries) {
+        retval = 1;
+        fputs("Failed to allocate queue of queries!\n", stderr);
+        goto DEFER_3;
+    }
+
+    blocking_queue_t *const outputs = blocking_queue_create(BATCH_MODE_STREAMING_PENDING_OUTPUTS);
+    if (!outputs) {
+        retval = 1;
+        fputs("Failed to allocate queue of query outputs!\n", stderr);
+        goto DEFER_4;
+    }
+
+    /* Parse queries while the dataset is being loaded */
+    const char *const compiled_path =
+        query_file_compiler_is_compiled(query_file_path) ? query_file_path : NULL;
+    batch_mode_parser_data_t parser_data = {.query_file        = query_file,
+                                            .compiled_path     = compiled_path,
+                                            .stateful_queries  = stateful_queries,
+                                            .stateless_queries = stateless_queries,
+                                            .retval            = 0};
+    pthread_t                parser_thread;
+    if (pthread_create(&parser_thread, NULL, __batch_mode_parser_thread, &parser_data)) {
+        retval = 1;
+        fputs("Failed to start query parsing thread!\n", stderr);
+        goto DEFER_5;
+    }
+
+    /* Many query files are run against the same dataset: only parse it once */
+    char snapshot_path[PATH_MAX];
+    if (cache_dir &&
+        snprintf(snapshot_path, PATH_MAX, "%s/" BATCH_MODE_SNAPSHOT_FILE_NAME, cache_dir) >=
+            PATH_MAX)
+        cache_dir = NULL; /* Path too long: just don't keep any cache */
+
+    database_t *const database = dataset_loader_load_cached(dataset_dir,
+                                                            "Resultados",
+                                                            cache_dir ? snapshot_path : NULL,
+                                                            NULL);
+    if (!database) {
+        retval = 1;
+        fputs("Failed to load dataset files!\n", stderr);
+        __batch_mode_cancel_parser(parser_thread, stateless_queries);
+        goto DEFER_5;
+    }
+
+    /* Creating the container requires the output directory, created by the dataset loader */
+    query_output_container_t *const container =
+        container_path ? query_output_container_create(container_path) : NULL;
+    if (container_path && !container) {
+        retval = 1;
+        fputs("Failed to create query output container!\n", stderr);
+        __batch_mode_cancel_parser(parser_thread, stateless_queries);
+        goto DEFER_6;
+    }
+
+    /* Outputs in a container can't be copied from the cache */
+    query_statistics_store_t       *store;
+    query_statistics_cache_t *const cache =
+        __batch_mode_create_cache(dataset_dir, cache_dir, &store);
+    query_result_cache_t *const     results =
+        container ? NULL : __batch_mode_create_results(dataset_dir, cache_dir);
+    if (__batch_mode_execute_streaming(database,
+                                       parser_thread,
+                                       &parser_data,
+                                       outputs,
+                                       container,
+                                       binary,
+                                       cache,
+                                       results))
+        retval = 1;
+
+    if (results)
+        query_result_cache_free(results);
+    if (cache)
+        query_statistics_cache_free(cache);
+    if (store)
+        query_statistics_store_free(store);
+
+    if (container) {
+        if (query_output_container_close(container)) {
+            retval = 1;
+            fputs("Failed to write query output container!\n", stderr);
+        }
+        query_output_container_free(container);
+    }
+
+DEFER_6:
+    if (BATCH_MODE_FREE_AT_EXIT)
+        database_free(database);
+DEFER_5:
+    blocking_queue_free(outputs);
+DEFER_4:
+    blocking_queue_free(stateless_queries);
+DEFER_3:
+    if (BATCH_MODE_FREE_AT_EXIT)
+        query_instance_list_free(stateful_queries);
 DEFER_2:
     fclose(query_file);
 DEFER_1:
     return retval;
 }
+
+/**
+ * @brief   Runs a query file in a process forked by ::batch_mode_run_jobs.
+ * @details The database was loaded by the parent process, and is only read, so its pages stay
+ *          shared with the parent and with the other jobs.
+ *
+ * @param database        Database loaded by the parent process.
+ * @param dataset_dir     Path to the directory containing the dataset.
+ * @param cache_dir       Path to the directory where statistics files are kept, or `NULL`.
+ * @param query_file_path Path to the file containing the queries.
+ * @param container_path  Path to the container where to write all query outputs to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message will also be printed to `stderr`.
+ */
+int __batch_mode_run_job(const database_t *database,
+                         const char       *dataset_dir,
+                         const char       *cache_dir,
+                         const char       *query_file_path,
+                         const char       *container_path) {
+    int retval = 0;
+
+    query_instance_list_t *const query_instance_list =
+        query_file_compiler_load_or_parse(query_file_path);
+    if (!query_instance_list) {
+        fputs("Failed to read query file!\n", stderr);
+        return 1;
+    }
+
+    query_output_container_t *const container = query_output_container_create(container_path);
+    if (!container) {
+        retval = 1;
+        fputs("Failed to create query output container!\n", stderr);
+        goto DEFER_1;
+    }
+
+    query_statistics_store_t       *store;
+    query_statistics_cache_t *const cache =
+        __batch_mode_create_cache(dataset_dir, cache_dir, &store);
+    if (__batch_mode_dispatch_list(database, query_instance_list, container, 0, cache))
+        retval = 1;
+
+    if (cache)
+        query_statistics_cache_free(cache);
+    if (store)
+        query_statistics_store_free(store);
+
+    if (query_output_container_close(container)) {
+        retval = 1;
+        fputs("Failed to write query output container!\n", stderr);
+    }
+    query_output_container_free(container);
+
+DEFER_1:
+    query_instance_list_free(query_instance_list);
+    return retval;
+}
+
+int batch_mode_run_jobs(const char *dataset_dir,
+                        const char *cache_dir,
+                        size_t      njobs,
+                        char *const query_file_paths[njobs]) {
+    char snapshot_path[PATH_MAX];
+    if (cache_dir &&
+        snprintf(snapshot_path, PATH_MAX, "%s/" BATCH_MODE_SNAPSHOT_FILE_NAME, cache_dir) >=
+            PATH_MAX)
+        cache_dir = NULL; /* Path too long: just don't keep any cache */
+
+    database_t *const database = dataset_loader_load_cached(dataset_dir,
+                                                            "Resultados",
+                                                            cache_dir ? snapshot_path : NULL,
+                                                            NULL);
+    if (!database) {
+        fputs("Failed to load dataset files!\n", stderr);
+        return 1;
+    }
+
+    /* Pending output would be written once by every process */
+    fflush(stdout);
+    fflush(stderr);
+
+    int    retval   = 0;
+    size_t nstarted = 0;
+    pid_t  pids[njobs];
+    for (; nstarted < njobs; ++nstarted) {
+        pids[nstarted] = fork();
+        if (pids[nstarted] < 0) {
+            retval = 1;
+            fputs("Failed to start query job!\n", stderr);
+            break; /* Still wait for the jobs that were started */
+        } else if (pids[nstarted] == 0) {
+            char container_path[PATH_MAX];
+            snprintf(container_path, PATH_MAX, BATCH_MODE_JOB_CONTAINER_PATH_FORMAT, nstarted);
+
+            const int job_retval = __batch_mode_run_job(database,
+                                                        dataset_dir,
+                                                        cache_dir,
+                                                        query_file_paths[nstarted],
+                                                        container_path);
+            _exit(job_retval); /* Don't free the database shared with the parent */
+        }
+    }
+
+    for (size_t i = 0; i < nstarted; ++i) {
+        int status;
+        if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+            retval = 1;
+    }
+
+    if (BATCH_MODE_FREE_AT_EXIT)
+        database_free(database);
+    return retval;
+}
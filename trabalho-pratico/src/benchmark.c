@@ -0,0 +1,95 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  benchmark.c
+ * @brief Contains the entry point to the benchmark program.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "benchmark_mode.h"
+#include "utils/int_utils.h"
+
+/**
+ * @brief Parses the value of a numeric command-line option.
+ *
+ * @param output Where to write the parsed value to, only on success.
+ * @param value  Value of the option. Can be `NULL`, if the option was the last argument.
+ *
+ * @retval 0 Success.
+ * @retval 1 Missing or invalid value.
+ */
+int __benchmark_parse_count(size_t *output, const char *value) {
+    uint64_t parsed;
+    if (!value || int_utils_parse_positive(&parsed, value))
+        return 1;
+
+    *output = parsed;
+    return 0;
+}
+
+/**
+ * @brief The entry point to the benchmark program.
+ * @retval 0 Success
+ * @retval 1 Failure
+ */
+int main(int argc, char **argv) {
+    benchmark_mode_options_t options = {.load_iterations   = 1,
+                                        .warmup_iterations = 1,
+                                        .iterations        = 10,
+                                        .parallel          = 0,
+                                        .numa              = 0,
+                                        .scaling           = 0};
+
+    int valid = argc >= 3;
+    for (int i = 3; valid && i < argc; ++i) {
+        const char *const value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-l") == 0) {
+            valid = !__benchmark_parse_count(&options.load_iterations, value);
+            i++;
+        } else if (strcmp(argv[i], "-w") == 0) {
+            valid = !__benchmark_parse_count(&options.warmup_iterations, value);
+            i++;
+        } else if (strcmp(argv[i], "-i") == 0) {
+            valid = !__benchmark_parse_count(&options.iterations, value);
+            i++;
+        } else if (strcmp(argv[i], "-p") == 0) {
+            options.parallel = 1;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            options.numa = 1;
+        } else if (strcmp(argv[i], "-s") == 0) {
+            options.scaling = 1;
+        } else {
+            valid = 0;
+        }
+    }
+
+    if (!valid || options.load_iterations == 0 || options.iterations == 0) {
+        fputs("Invalid command-line arguments! Usage:\n", stderr);
+        fputs("./programa-benchmark [dataset] [query file] [-l load iterations] "
+              "[-w warmup iterations] [-i iterations] [-p [-n]] [-s]\n",
+              stderr);
+        return 1;
+    }
+
+    options.dataset_dir     = argv[1];
+    options.query_file_path = argv[2];
+    return benchmark_mode_run(&options);
+}
@@ -0,0 +1,909 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  benchmark_mode.c
+ * @brief Implementation of methods in benchmark_mode.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref benchmark_mode_examples).
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "benchmark_mode.h"
+#include "dataset/dataset_loader.h"
+#include "queries/query_dispatcher.h"
+#include "queries/query_file_compiler.h"
+#include "queries/query_type_list.h"
+#include "testing/performance_metrics.h"
+#include "testing/sample_statistics.h"
+#include "utils/numa_topology.h"
+#include "utils/table.h"
+#include "utils/thread_count.h"
+
+/** @brief Row of a scaling benchmark's report for the time of loading the whole dataset. */
+#define BENCHMARK_MODE_SCALING_LOAD_ROW PERFORMANCE_METRICS_DATASET_STEP_DONE
+
+/** @brief First row of a scaling benchmark's report for the time of each query type. */
+#define BENCHMARK_MODE_SCALING_TYPES_ROW (BENCHMARK_MODE_SCALING_LOAD_ROW + 1)
+
+/** @brief Row of a scaling benchmark's report for the time of running the whole query file. */
+#define BENCHMARK_MODE_SCALING_FILE_ROW (BENCHMARK_MODE_SCALING_TYPES_ROW + QUERY_TYPE_LIST_COUNT)
+
+/** @brief Number of rows in a scaling benchmark's report. */
+#define BENCHMARK_MODE_SCALING_ROW_COUNT (BENCHMARK_MODE_SCALING_FILE_ROW + 1)
+
+/** @brief Maximum number of thread counts a scaling benchmark is run with. */
+#define BENCHMARK_MODE_SCALING_MAX_RUNS 64
+
+/**
+ * @struct benchmark_mode_samples_t
+ * @brief  Measurements taken across all iterations of a benchmark.
+ *
+ * @var benchmark_mode_samples_t::load_times
+ *     @brief Time (in microseconds) of each dataset load.
+ * @var benchmark_mode_samples_t::iteration_times
+ *     @brief Wall-clock time (in microseconds) of each measured run of the queries.
+ * @var benchmark_mode_samples_t::type_times
+ *     @brief   Time (in microseconds) spent on each query type (statistical data generation and
+ *              execution) in each measured run of the queries.
+ *     @details `QUERY_TYPE_LIST_COUNT * iterations` elements, where the times of each query type
+ *              are contiguous. Not measured in parallel benchmarks.
+ * @var benchmark_mode_samples_t::type_counts
+ *     @brief Number of queries of each type in the query file.
+ */
+typedef struct {
+    double *load_times, *iteration_times, *type_times;
+    size_t  type_counts[QUERY_TYPE_LIST_COUNT];
+} benchmark_mode_samples_t;
+
+/**
+ * @brief  Calculates the half-width of the 95 % confidence interval of the mean of a set of
+ *         samples, using Student's t-distribution.
+ *
+ * @param n       Number of samples in @p samples.
+ * @param samples Samples to calculate the confidence interval of.
+ *
+ * @return The half-width of the confidence interval, or `0` if there are less than two samples.
+ */
+double __benchmark_mode_confidence_interval(size_t n, const double samples[n]) {
+    if (n < 2)
+        return 0;
+
+    const double t = sample_statistics_t_critical_value(n - 1);
+    return t * sqrt(sample_statistics_variance(n, samples) / n);
+}
+
+/**
+ * @brief Loads the dataset as many times as requested, keeping the last loaded database.
+ *
+ * @param options  Configuration of the benchmark.
+ * @param samples  Where to write the time of each load to.
+ * @param database Where to write the last loaded database to, only on success.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message is printed to `stderr`.
+ */
+int __benchmark_mode_load(const benchmark_mode_options_t *options,
+                          benchmark_mode_samples_t       *samples,
+                          database_t                    **database) {
+    for (size_t i = 0; i < options->load_iterations; ++i) {
+        database_t *const new_database = database_create();
+        if (!new_database) {
+            fputs("Failed to allocate database!\n", stderr);
+            return 1;
+        }
+
+        performance_event_t *const event = performance_event_start_measuring_lightweight(-1);
+        if (!event || dataset_loader_load(new_database, options->dataset_dir, "Resultados", NULL) ||
+            performance_event_stop_measuring(event)) {
+
+            fputs("Failed to load dataset files!\n", stderr);
+            if (event)
+                performance_event_free(event);
+            database_free(new_database);
+            return 1;
+        }
+
+        samples->load_times[i] = performance_event_get_elapsed_time(event);
+        performance_event_free(event);
+
+        /* Keep only the last database, so that memory usage doesn't grow with iterations */
+        if (i + 1 < options->load_iterations)
+            database_free(new_database);
+        else
+            *database = new_database;
+    }
+    return 0;
+}
+
+/**
+ * @struct benchmark_mode_iter_data_t
+ * @brief  Data structure used for query iteration in ::__benchmark_mode_init_writer_callback.
+ *
+ * @var benchmark_mode_iter_data_t::outputs
+ *     @brief Where to write created query output writers to.
+ * @var benchmark_mode_iter_data_t::i
+ *     @brief Index of the query being currently dealt with.
+ */
+typedef struct {
+    query_writer_t **const outputs;
+    size_t                 i;
+} benchmark_mode_iter_data_t;
+
+/**
+ * @brief Called for each query, to create the in-memory writer its output will be written to.
+ *
+ * @param user_data A pointer to a ::benchmark_mode_iter_data_t.
+ * @param instance  Query whose output will be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (all writers already created are freed).
+ */
+int __benchmark_mode_init_writer_callback(void *user_data, const query_instance_t *instance) {
+    benchmark_mode_iter_data_t *const iter_data = user_data;
+
+    iter_data->outputs[iter_data->i] =
+        query_writer_create(NULL, query_instance_get_formatted(instance));
+
+    if (!iter_data->outputs[iter_data->i]) {
+        for (size_t j = 0; j < iter_data->i; ++j)
+            query_writer_free(iter_data->outputs[j]);
+        return 1;
+    }
+
+    iter_data->i++;
+    return 0;
+}
+
+/**
+ * @struct benchmark_mode_schedule_t
+ * @brief  How queries are scheduled in parallel benchmarks.
+ *
+ * @var benchmark_mode_schedule_t::costs
+ *     @brief Costs of query types, measured in the last profiled run.
+ * @var benchmark_mode_schedule_t::topology
+ *     @brief NUMA nodes to pin threads to (see ::benchmark_mode_options_t::numa). Can be `NULL`.
+ */
+typedef struct {
+    query_dispatcher_costs_t costs;
+    numa_topology_t         *topology;
+} benchmark_mode_schedule_t;
+
+/**
+ * @brief Runs all queries once.
+ *
+ * @param options             Configuration of the benchmark.
+ * @param database            Database to run the queries on.
+ * @param query_instance_list Queries to be run.
+ * @param samples             Where to write measurements to. Can be `NULL` for a warmup run.
+ * @param iteration           Index of the measured run (ignored if @p samples is `NULL`).
+ * @param schedule            How to schedule parallel runs. Its costs are updated after profiled
+ *                            runs.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure. A message is printed to `stderr`.
+ */
+int __benchmark_mode_run_queries(const benchmark_mode_options_t *options,
+                                 const database_t               *database,
+                                 query_instance_list_t          *query_instance_list,
+                                 benchmark_mode_samples_t       *samples,
+                                 size_t                          iteration,
+                                 benchmark_mode_schedule_t      *schedule) {
+    int          retval = 0;
+    const size_t n      = query_instance_list_get_length(query_instance_list);
+
+    query_writer_t **const outputs = malloc(sizeof(query_writer_t *) * n);
+    if (!outputs) {
+        retval = 1;
+        fputs("Failed to allocate list of query outputs!\n", stderr);
+        goto DEFER_1;
+    }
+
+    benchmark_mode_iter_data_t iter_data = {.outputs = outputs, .i = 0};
+    if (query_instance_list_iter(query_instance_list,
+                                 __benchmark_mode_init_writer_callback,
+                                 &iter_data)) {
+        retval = 1;
+        fputs("Failed to allocate query outputs!\n", stderr);
+        goto DEFER_2;
+    }
+
+    /*
+     * Per-type measurements without the overhead of keeping an event for every query. Parallel
+     * benchmarks profile warmup runs, for their costs to be used in the measured ones.
+     */
+    performance_metrics_t *metrics = NULL;
+    if (!options->parallel || !samples) {
+        metrics = performance_metrics_create_with_mode(PERFORMANCE_EVENT_MODE_LIGHTWEIGHT);
+        if (!metrics) {
+            retval = 1;
+            fputs("Failed to allocate performance metrics!\n", stderr);
+            goto DEFER_3;
+        }
+        performance_metrics_set_keep_query_events(metrics, 0);
+    }
+
+    performance_event_t *const event = performance_event_start_measuring_lightweight(-1);
+    if (!event) {
+        retval = 1;
+        fputs("Failed to measure benchmark iteration!\n", stderr);
+        goto DEFER_4;
+    }
+
+    if (metrics)
+        query_dispatcher_dispatch_list(database, NULL, query_instance_list, outputs, 0, metrics);
+    else
+        query_dispatcher_dispatch_list_with_hints(database,
+                                                  NULL,
+                                                  query_instance_list,
+                                                  outputs,
+                                                  0,
+                                                  &schedule->costs,
+                                                  schedule->topology);
+    if (performance_event_stop_measuring(event)) {
+        retval = 1;
+        fputs("Failed to measure benchmark iteration!\n", stderr);
+        goto DEFER_5;
+    }
+
+    if (metrics)
+        query_dispatcher_costs_from_metrics(&schedule->costs, metrics);
+
+    if (samples) {
+        samples->iteration_times[iteration] = performance_event_get_elapsed_time(event);
+
+        for (size_t i = 0; metrics && i < QUERY_TYPE_LIST_COUNT; ++i) {
+            const latency_histogram_t *const latencies =
+                performance_metrics_get_query_latencies(metrics, i + 1);
+            const performance_event_t *const statistics =
+                performance_metrics_get_query_statistics_measurement(metrics, i + 1);
+
+            samples->type_counts[i] = latency_histogram_get_count(latencies);
+            samples->type_times[i * options->iterations + iteration] =
+                latency_histogram_get_total(latencies) +
+                (statistics ? performance_event_get_elapsed_time(statistics) : 0);
+        }
+    }
+
+DEFER_5:
+    performance_event_free(event);
+DEFER_4:
+    if (metrics)
+        performance_metrics_free(metrics);
+DEFER_3:
+    for (size_t i = 0; i < n; ++i)
+        query_writer_free(outputs[i]);
+DEFER_2:
+    free(outputs);
+DEFER_1:
+    return retval;
+}
+
+/**
+ * @brief Prints a measurement as its mean and confidence interval, in milliseconds.
+ *
+ * @param name    Name of what was measured.
+ * @param n       Number of samples in @p samples.
+ * @param samples Measurements (in microseconds).
+ */
+void __benchmark_mode_print_measurement(const char *name, size_t n, const double samples[n]) {
+    printf("%s: %.3lf ms ± %.3lf ms (n = %zu)\n",
+           name,
+           sample_statistics_mean(n, samples) / 1000,
+           __benchmark_mode_confidence_interval(n, samples) / 1000,
+           n);
+}
+
+/**
+ * @brief Prints the time and throughput of every query type in a benchmark.
+ *
+ * @param options Configuration of the benchmark.
+ * @param samples Measurements taken during the benchmark.
+ */
+void __benchmark_mode_print_types(const benchmark_mode_options_t *options,
+                                  const benchmark_mode_samples_t *samples) {
+    size_t nrows = 0;
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
+        if (samples->type_counts[i])
+            nrows++;
+
+    table_t *const table = table_create(5, nrows + 1);
+    if (!table)
+        return;
+    table_insert_format(table, 1, 0, "Count");
+    table_insert_format(table, 2, 0, "Time (ms)");
+    table_insert_format(table, 3, 0, "95 %% CI (ms)");
+    table_insert_format(table, 4, 0, "Throughput (queries/s)");
+
+    size_t row = 1;
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        if (!samples->type_counts[i])
+            continue;
+
+        const size_t        n     = options->iterations;
+        const double *const times = samples->type_times + i * n;
+        const double        mean  = sample_statistics_mean(n, times);
+        const double        ci    = __benchmark_mode_confidence_interval(n, times);
+
+        table_insert_format(table, 0, row, "Query %zu", i + 1);
+        table_insert_format(table, 1, row, "%zu", samples->type_counts[i]);
+        table_insert_format(table, 2, row, "%.3lf", mean / 1000);
+        table_insert_format(table, 3, row, "± %.3lf", ci / 1000);
+        if (mean > 0)
+            table_insert_format(table, 4, row, "%.1lf", samples->type_counts[i] * 1e6 / mean);
+        row++;
+    }
+
+    table_draw(stdout, table);
+    table_free(table);
+}
+
+/**
+ * @brief Loads the dataset and runs the queries of a benchmark, once samples are allocated.
+ *
+ * @param options Configuration of the benchmark.
+ * @param samples Where to write measurements to.
+ *
+ * @retval 0 Success
+ * @retval 1 Fatal failure. A message will also be printed to `stderr`.
+ */
+int __benchmark_mode_run_with_samples(const benchmark_mode_options_t *options,
+                                      benchmark_mode_samples_t       *samples) {
+    int retval = 0;
+
+    query_instance_list_t *const query_instance_list =
+        query_file_compiler_load_or_parse(options->query_file_path);
+    if (!query_instance_list) {
+        retval = 1;
+        fputs("Failed to read query file!\n", stderr);
+        goto DEFER_1;
+    }
+
+    database_t *database;
+    if (__benchmark_mode_load(options, samples, &database)) {
+        retval = 1;
+        goto DEFER_2;
+    }
+
+    benchmark_mode_schedule_t schedule = {.costs = {{0}, {0}, {0}}, .topology = NULL};
+    if (options->parallel && options->numa) {
+        schedule.topology = numa_topology_create();
+        if (!schedule.topology) {
+            retval = 1;
+            fputs("Failed to allocate NUMA topology!\n", stderr);
+            goto DEFER_3;
+        }
+
+        if (database_replicate_indexes(database, schedule.topology)) {
+            retval = 1;
+            fputs("Failed to replicate database indices!\n", stderr);
+            goto DEFER_4;
+        }
+    }
+
+    for (size_t i = 0; i < options->warmup_iterations; ++i) {
+        if (__benchmark_mode_run_queries(options,
+                                         database,
+                                         query_instance_list,
+                                         NULL,
+                                         0,
+                                         &schedule)) {
+            retval = 1;
+            goto DEFER_4;
+        }
+    }
+
+    for (size_t i = 0; i < options->iterations; ++i) {
+        if (__benchmark_mode_run_queries(options,
+                                         database,
+                                         query_instance_list,
+                                         samples,
+                                         i,
+                                         &schedule)) {
+            retval = 1;
+            goto DEFER_4;
+        }
+    }
+
+    __benchmark_mode_print_measurement("Dataset loading",
+                                       options->load_iterations,
+                                       samples->load_times);
+    __benchmark_mode_print_measurement("Query file",
+                                       options->iterations,
+                                       samples->iteration_times);
+    if (!options->parallel) {
+        putchar('\n');
+        __benchmark_mode_print_types(options, samples);
+    }
+
+DEFER_4:
+    if (schedule.topology)
+        numa_topology_free(schedule.topology);
+DEFER_3:
+    database_free(database);
+DEFER_2:
+    query_instance_list_free(query_instance_list);
+DEFER_1:
+    return retval;
+}
+
+/**
+ * @struct benchmark_mode_scaling_t
+ * @brief  Mean times (in microseconds) measured by a scaling benchmark, with a single thread count.
+ *
+ * @var benchmark_mode_scaling_t::times
+ *     @brief   Time of each row of the report.
+ *     @details Dataset steps come first (indexed by ::performance_metrics_dataset_step_t), followed
+ *              by ::BENCHMARK_MODE_SCALING_LOAD_ROW, ::BENCHMARK_MODE_SCALING_TYPES_ROW and
+ *              ::BENCHMARK_MODE_SCALING_FILE_ROW.
+ */
+typedef struct {
+    double times[BENCHMARK_MODE_SCALING_ROW_COUNT];
+} benchmark_mode_scaling_t;
+
+/**
+ * @brief   Loads the dataset as many times as requested, measuring each step and the whole load.
+ * @details When profiling, dataset files are loaded one after another (see ::dataset_loader_load),
+ *          so each dataset step is measured in a load of its own, and the whole load in another
+ *          one, without profiling. Only the last database loaded without profiling is kept.
+ *
+ * @param options  Configuration of the benchmark.
+ * @param result   Where to add the mean time of each step and of the whole load to.
+ * @param database Where to write the last loaded database to, only on success.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message is printed to `stderr`.
+ */
+int __benchmark_mode_scaling_load(const benchmark_mode_options_t *options,
+                                  benchmark_mode_scaling_t       *result,
+                                  database_t                    **database) {
+    const size_t n = options->load_iterations;
+    for (size_t i = 0; i < n; ++i) {
+        database_t *const            profiled_database = database_create();
+        performance_metrics_t *const metrics =
+            performance_metrics_create_with_mode(PERFORMANCE_EVENT_MODE_LIGHTWEIGHT);
+        if (!profiled_database || !metrics) {
+            fputs("Failed to allocate database!\n", stderr);
+            if (profiled_database)
+                database_free(profiled_database);
+            if (metrics)
+                performance_metrics_free(metrics);
+            return 1;
+        }
+
+        const int profiled_retval =
+            dataset_loader_load(profiled_database, options->dataset_dir, "Resultados", metrics);
+        for (size_t j = 0; !profiled_retval && j < PERFORMANCE_METRICS_DATASET_STEP_DONE; ++j) {
+            const performance_event_t *const event =
+                performance_metrics_get_dataset_measurement(metrics, j);
+            if (event)
+                result->times[j] += (double) performance_event_get_elapsed_time(event) / n;
+        }
+
+        database_free(profiled_database);
+        performance_metrics_free(metrics);
+        if (profiled_retval) {
+            fputs("Failed to load dataset files!\n", stderr);
+            return 1;
+        }
+
+        /* One load without profiling, for the time of the whole load */
+        double                   load_time;
+        database_t              *new_database;
+        benchmark_mode_options_t single_load = *options;
+        single_load.load_iterations          = 1;
+        if (__benchmark_mode_load(&single_load,
+                                  &(benchmark_mode_samples_t){.load_times = &load_time},
+                                  &new_database))
+            return 1;
+        result->times[BENCHMARK_MODE_SCALING_LOAD_ROW] += load_time / n;
+
+        if (i + 1 < n)
+            database_free(new_database);
+        else
+            *database = new_database;
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs a list of queries once, with as many threads as ::thread_count_get allows.
+ *
+ * @param database            Database to run the queries on.
+ * @param query_instance_list Queries to be run.
+ * @param time                Where to add the time (in microseconds) it took to run the queries to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message is printed to `stderr`.
+ */
+int __benchmark_mode_scaling_time_queries(const database_t      *database,
+                                          query_instance_list_t *query_instance_list,
+                                          double                *time) {
+    int          retval = 0;
+    const size_t n      = query_instance_list_get_length(query_instance_list);
+
+    query_writer_t **const outputs = malloc(sizeof(query_writer_t *) * n);
+    if (!outputs) {
+        fputs("Failed to allocate list of query outputs!\n", stderr);
+        return 1;
+    }
+
+    benchmark_mode_iter_data_t iter_data = {.outputs = outputs, .i = 0};
+    if (query_instance_list_iter(query_instance_list,
+                                 __benchmark_mode_init_writer_callback,
+                                 &iter_data)) {
+        retval = 1;
+        fputs("Failed to allocate query outputs!\n", stderr);
+        goto DEFER_1;
+    }
+
+    performance_event_t *const event = performance_event_start_measuring_lightweight(-1);
+    if (!event) {
+        retval = 1;
+        fputs("Failed to measure benchmark iteration!\n", stderr);
+        goto DEFER_2;
+    }
+
+    query_dispatcher_dispatch_list(database, NULL, query_instance_list, outputs, 0, NULL);
+    if (performance_event_stop_measuring(event)) {
+        retval = 1;
+        fputs("Failed to measure benchmark iteration!\n", stderr);
+    } else {
+        *time += performance_event_get_elapsed_time(event);
+    }
+
+    performance_event_free(event);
+DEFER_2:
+    for (size_t i = 0; i < n; ++i)
+        query_writer_free(outputs[i]);
+DEFER_1:
+    free(outputs);
+    return retval;
+}
+
+/**
+ * @brief Measures all rows of a scaling benchmark's report, with the current thread count.
+ *
+ * @param options             Configuration of the benchmark.
+ * @param query_instance_list All queries in the query file.
+ * @param type_lists          Queries of each type (`NULL` for types not in the query file).
+ * @param result              Where to write the mean time of each row to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message is printed to `stderr`.
+ */
+int __benchmark_mode_scaling_run(const benchmark_mode_options_t *options,
+                                 query_instance_list_t          *query_instance_list,
+                                 query_instance_list_t *const    type_lists[QUERY_TYPE_LIST_COUNT],
+                                 benchmark_mode_scaling_t       *result) {
+    *result = (benchmark_mode_scaling_t){.times = {0}};
+
+    database_t *database;
+    if (__benchmark_mode_scaling_load(options, result, &database))
+        return 1;
+
+    int    retval = 0;
+    double ignored;
+    for (size_t i = 0; !retval && i < options->warmup_iterations; ++i)
+        retval = __benchmark_mode_scaling_time_queries(database, query_instance_list, &ignored);
+
+    double *const times = result->times;
+    for (size_t i = 0; !retval && i < options->iterations; ++i) {
+        retval = __benchmark_mode_scaling_time_queries(database,
+                                                       query_instance_list,
+                                                       &times[BENCHMARK_MODE_SCALING_FILE_ROW]);
+
+        /* Each type on its own, so that its scaling isn't hidden by work of other types */
+        for (size_t j = 0; !retval && j < QUERY_TYPE_LIST_COUNT; ++j)
+            if (type_lists[j])
+                retval = __benchmark_mode_scaling_time_queries(
+                    database,
+                    type_lists[j],
+                    &times[BENCHMARK_MODE_SCALING_TYPES_ROW + j]);
+    }
+
+    for (size_t i = BENCHMARK_MODE_SCALING_TYPES_ROW; i < BENCHMARK_MODE_SCALING_ROW_COUNT; ++i)
+        times[i] /= options->iterations;
+
+    database_free(database);
+    return retval;
+}
+
+/**
+ * @brief   Measures all rows of a scaling benchmark's report with a given number of threads.
+ * @details The benchmark is run in a child process, so that the shared thread pool (see
+ *          ::thread_pool_get_shared) is created with the requested number of threads, and so that
+ *          caches from previous runs (e.g.: database indices) don't affect measurements.
+ *
+ * @param options             Configuration of the benchmark.
+ * @param query_instance_list All queries in the query file.
+ * @param type_lists          Queries of each type (`NULL` for types not in the query file).
+ * @param nthreads            Number of threads to run the benchmark with.
+ * @param result              Where to write the mean time of each row to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message is printed to `stderr`.
+ */
+int __benchmark_mode_scaling_measure(const benchmark_mode_options_t *options,
+                                     query_instance_list_t          *query_instance_list,
+                                     query_instance_list_t *const type_lists[QUERY_TYPE_LIST_COUNT],
+                                     size_t                       nthreads,
+                                     benchmark_mode_scaling_t    *result) {
+    int fds[2];
+    if (pipe(fds)) {
+        fputs("Failed to create pipe for scaling benchmark!\n", stderr);
+        return 1;
+    }
+
+    /* Pending output would be written once by every process */
+    fflush(stdout);
+    fflush(stderr);
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        fputs("Failed to start scaling benchmark run!\n", stderr);
+        close(fds[0]);
+        close(fds[1]);
+        return 1;
+    } else if (pid == 0) {
+        close(fds[0]);
+        thread_count_set(nthreads);
+
+        int retval = __benchmark_mode_scaling_run(options, query_instance_list, type_lists, result);
+        if (!retval && write(fds[1], result, sizeof(benchmark_mode_scaling_t)) !=
+                           (ssize_t) sizeof(benchmark_mode_scaling_t))
+            retval = 1;
+
+        close(fds[1]);
+        _exit(retval);
+    }
+
+    close(fds[1]);
+    size_t  nread = 0;
+    ssize_t count = 0;
+    while (nread < sizeof(benchmark_mode_scaling_t)) {
+        count = read(fds[0], (char *) result + nread, sizeof(benchmark_mode_scaling_t) - nread);
+        if (count > 0)
+            nread += count;
+        else if (count == 0 || errno != EINTR)
+            break;
+    }
+    close(fds[0]);
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) ||
+        nread < sizeof(benchmark_mode_scaling_t)) {
+
+        fprintf(stderr, "Scaling benchmark run with %zu threads failed!\n", nthreads);
+        return 1;
+    }
+    return 0;
+}
+
+/** @brief What is shown in a table printed by ::__benchmark_mode_print_scaling. */
+typedef enum {
+    BENCHMARK_MODE_SCALING_TABLE_TIME,      /**< @brief Mean time (in milliseconds). */
+    BENCHMARK_MODE_SCALING_TABLE_SPEEDUP,   /**< @brief Speedup over a single thread. */
+    BENCHMARK_MODE_SCALING_TABLE_EFFICIENCY /**< @brief Speedup divided by thread count. */
+} benchmark_mode_scaling_table_t;
+
+/**
+ * @brief Prints a table of a scaling benchmark's report to `stdout`.
+ *
+ * @param kind      What to print in the table.
+ * @param type_rows Whether each query type was in the query file.
+ * @param nruns     Number of thread counts the benchmark was run with.
+ * @param nthreads  Thread count in each run. The first one must be `1`.
+ * @param results   Measurements of each run.
+ */
+void __benchmark_mode_print_scaling(benchmark_mode_scaling_table_t kind,
+                                    const int                      type_rows[QUERY_TYPE_LIST_COUNT],
+                                    size_t                         nruns,
+                                    const size_t                   nthreads[nruns],
+                                    const benchmark_mode_scaling_t results[nruns]) {
+
+    const char *const step_names[PERFORMANCE_METRICS_DATASET_STEP_DONE] = {"Users",
+                                                                           "Flights",
+                                                                           "Passengers",
+                                                                           "Reservations",
+                                                                           "Indices"};
+    const char *const titles[] = {"Time (ms)", "Speedup", "Parallel efficiency (%)"};
+
+    size_t nrows = 0;
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
+        if (type_rows[i])
+            nrows++;
+    nrows += BENCHMARK_MODE_SCALING_ROW_COUNT - QUERY_TYPE_LIST_COUNT;
+
+    table_t *const table = table_create(nruns + 1, nrows + 1);
+    if (!table)
+        return;
+
+    table_insert_format(table, 0, 0, "%s", titles[kind]);
+    for (size_t i = 0; i < nruns; ++i)
+        table_insert_format(table, i + 1, 0, "%zu thread(s)", nthreads[i]);
+
+    size_t y = 1;
+    for (size_t row = 0; row < BENCHMARK_MODE_SCALING_ROW_COUNT; ++row) {
+        if (row < BENCHMARK_MODE_SCALING_LOAD_ROW) {
+            table_insert_format(table, 0, y, "Dataset: %s", step_names[row]);
+        } else if (row == BENCHMARK_MODE_SCALING_LOAD_ROW) {
+            table_insert_format(table, 0, y, "Dataset loading");
+        } else if (row < BENCHMARK_MODE_SCALING_FILE_ROW) {
+            const size_t type = row - BENCHMARK_MODE_SCALING_TYPES_ROW;
+            if (!type_rows[type])
+                continue;
+            table_insert_format(table, 0, y, "Query %zu", type + 1);
+        } else {
+            table_insert_format(table, 0, y, "Query file");
+        }
+
+        for (size_t i = 0; i < nruns; ++i) {
+            const double time    = results[i].times[row];
+            const double speedup = time > 0 ? results[0].times[row] / time : 0;
+
+            if (kind == BENCHMARK_MODE_SCALING_TABLE_TIME)
+                table_insert_format(table, i + 1, y, "%.3lf", time / 1000);
+            else if (time <= 0)
+                continue;
+            else if (kind == BENCHMARK_MODE_SCALING_TABLE_SPEEDUP)
+                table_insert_format(table, i + 1, y, "%.2lf", speedup);
+            else
+                table_insert_format(table, i + 1, y, "%.1lf", speedup * 100 / nthreads[i]);
+        }
+        y++;
+    }
+
+    table_draw(stdout, table);
+    table_free(table);
+}
+
+/**
+ * @brief Called for each set of queries of the same type, to copy them to a list of their own.
+ *
+ * @param user_data   An array of ::QUERY_TYPE_LIST_COUNT lists, indexed by query type number
+ *                    minus one.
+ * @param n           Number of queries in @p instances.
+ * @param instances   Queries of the same type.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __benchmark_mode_split_types_callback(void                         *user_data,
+                                          size_t                        n,
+                                          const query_instance_t *const instances[n]) {
+    query_instance_list_t **const type_lists = user_data;
+
+    const size_t type = query_type_get_type_number(query_instance_get_type(instances[0])) - 1;
+    if (type >= QUERY_TYPE_LIST_COUNT)
+        return 0;
+
+    type_lists[type] = query_instance_list_create();
+    if (!type_lists[type])
+        return 1;
+
+    for (size_t i = 0; i < n; ++i)
+        if (query_instance_list_add(type_lists[type], instances[i]))
+            return 1;
+    return 0;
+}
+
+/**
+ * @brief Runs a scaling benchmark (see ::benchmark_mode_options_t::scaling) and prints its report.
+ *
+ * @param options Configuration of the benchmark.
+ *
+ * @retval 0 Success
+ * @retval 1 Fatal failure. A message will also be printed to `stderr`.
+ */
+int __benchmark_mode_run_scaling(const benchmark_mode_options_t *options) {
+    int retval = 0;
+
+    query_instance_list_t *const query_instance_list =
+        query_file_compiler_load_or_parse(options->query_file_path);
+    if (!query_instance_list) {
+        fputs("Failed to read query file!\n", stderr);
+        return 1;
+    }
+
+    query_instance_list_t *type_lists[QUERY_TYPE_LIST_COUNT] = {0};
+    if (query_instance_list_iter_types(query_instance_list,
+                                       __benchmark_mode_split_types_callback,
+                                       type_lists)) {
+        retval = 1;
+        fputs("Failed to allocate lists of queries!\n", stderr);
+        goto DEFER_1;
+    }
+
+    /* 1, 2, 4, ... threads, always ending with all the threads the machine has */
+    const size_t maximum = thread_count_get();
+    size_t       nthreads[BENCHMARK_MODE_SCALING_MAX_RUNS];
+    size_t       nruns = 0;
+    for (size_t n = 1; n < maximum && nruns < BENCHMARK_MODE_SCALING_MAX_RUNS - 1; n *= 2)
+        nthreads[nruns++] = n;
+    nthreads[nruns++] = maximum;
+
+    benchmark_mode_scaling_t results[BENCHMARK_MODE_SCALING_MAX_RUNS];
+    for (size_t i = 0; i < nruns; ++i) {
+        if (__benchmark_mode_scaling_measure(options,
+                                             query_instance_list,
+                                             type_lists,
+                                             nthreads[i],
+                                             &results[i])) {
+            retval = 1;
+            goto DEFER_1;
+        }
+    }
+
+    int type_rows[QUERY_TYPE_LIST_COUNT];
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
+        type_rows[i] = type_lists[i] != NULL;
+
+    __benchmark_mode_print_scaling(BENCHMARK_MODE_SCALING_TABLE_TIME,
+                                   type_rows,
+                                   nruns,
+                                   nthreads,
+                                   results);
+    putchar('\n');
+    __benchmark_mode_print_scaling(BENCHMARK_MODE_SCALING_TABLE_SPEEDUP,
+                                   type_rows,
+                                   nruns,
+                                   nthreads,
+                                   results);
+    putchar('\n');
+    __benchmark_mode_print_scaling(BENCHMARK_MODE_SCALING_TABLE_EFFICIENCY,
+                                   type_rows,
+                                   nruns,
+                                   nthreads,
+                                   results);
+
+DEFER_1:
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
+        if (type_lists[i])
+            query_instance_list_free(type_lists[i]);
+    query_instance_list_free(query_instance_list);
+    return retval;
+}
+
+int benchmark_mode_run(const benchmark_mode_options_t *options) {
+    if (options->scaling)
+        return __benchmark_mode_run_scaling(options);
+
+    benchmark_mode_samples_t samples = {
+        .load_times      = malloc(sizeof(double) * options->load_iterations),
+        .iteration_times = malloc(sizeof(double) * options->iterations),
+        .type_times      = calloc(QUERY_TYPE_LIST_COUNT * options->iterations, sizeof(double)),
+        .type_counts     = {0}};
+
+    int retval = 1;
+    if (samples.load_times && samples.iteration_times && samples.type_times)
+        retval = __benchmark_mode_run_with_samples(options, &samples);
+    else
+        fputs("Failed to allocate benchmark samples!\n", stderr);
+
+    free(samples.load_times);
+    free(samples.iteration_times);
+    free(samples.type_times);
+    return retval;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  compare.c
+ * @brief Contains the entry point to the metrics comparison program.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testing/metrics_comparison.h"
+
+/**
+ * @brief The entry point to the metrics comparison program.
+ * @retval 0 Success, and no regressions were found.
+ * @retval 1 Failure.
+ * @retval 2 Regressions were found.
+ */
+int main(int argc, char **argv) {
+    metrics_comparison_t *const comparison = metrics_comparison_create();
+    if (!comparison) {
+        fputs("Failed to allocate metrics comparison!\n", stderr);
+        return 1;
+    }
+
+    double threshold  = 1.0;
+    size_t nbaselines = 0, ncandidates = 0;
+    int    valid      = 1;
+    for (int i = 1; valid && i < argc; i += 2) {
+        const char *const value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!value) {
+            valid = 0;
+        } else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "-c") == 0) {
+            const int baseline = argv[i][1] == 'b';
+            if (metrics_comparison_add_file(comparison,
+                                            baseline ? METRICS_COMPARISON_SIDE_BASELINE
+                                                     : METRICS_COMPARISON_SIDE_CANDIDATE,
+                                            value)) {
+                fprintf(stderr, "Failed to read metrics from \"%s\"!\n", value);
+                metrics_comparison_free(comparison);
+                return 1;
+            }
+
+            if (baseline)
+                nbaselines++;
+            else
+                ncandidates++;
+        } else if (strcmp(argv[i], "-t") == 0) {
+            char *end;
+            threshold = strtod(value, &end);
+            valid     = end != value && !*end && threshold >= 0;
+        } else {
+            valid = 0;
+        }
+    }
+
+    if (!valid || nbaselines == 0 || ncandidates == 0) {
+        fputs("Invalid command-line arguments! Usage:\n", stderr);
+        fputs("./programa-comparador -b baseline.csv [-b ...] -c candidate.csv [-c ...] "
+              "[-t threshold (%)]\n",
+              stderr);
+        metrics_comparison_free(comparison);
+        return 1;
+    }
+
+    const size_t nregressions = metrics_comparison_print(stdout, comparison, threshold / 100);
+    metrics_comparison_free(comparison);
+    return nregressions ? 2 : 0;
+}
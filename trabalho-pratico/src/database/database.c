@@ -22,9 +22,24 @@
  * See [the header file's documentation](@ref database_examples).
  */
 
+#include <glib.h>
+#include <pthread.h>
 #include <stdlib.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 #include "database/database.h"
+#include "utils/int_utils.h"
+#include "utils/task_scheduler.h"
+#include "utils/thread_count.h"
+#include "utils/thread_pool.h"
+
+/**
+ * @brief Maximum number of reservations added to the reservation manager, in
+ *        ::database_add_reservations_batch, before their users are associated with them.
+ */
+#define DATABASE_RESERVATIONS_BATCH_SIZE 256
 
 /**
  * @struct database
@@ -36,12 +51,251 @@
  *     @brief All reservations and reservations relationships.
  * @var database::flights
  *     @brief All flights and flight relationships.
+ * @var database::users_references
+ *     @brief   Number of databases sharing ::database::users.
+ *     @details Managers are shared between a database and its clones (see ::database_clone), and
+ *              only copied when one of them is modified while shared. This counter is allocated
+ *              separately, so that it's shared by all databases referencing the same manager.
+ * @var database::reservations_references
+ *     @brief Number of databases sharing ::database::reservations.
+ * @var database::flights_references
+ *     @brief Number of databases sharing ::database::flights.
+ * @var database::statistics
+ *     @brief Statistics about the contents of the managers, updated as entities are added.
+ * @var database::write_lock
+ *     @brief   Lock held while modifying the database.
+ *     @details Allows for different parts of the dataset to be loaded by different threads.
+ * @var database::index_policy
+ *     @brief When the indices of the managers are built (see ::database_set_index_policy).
+ * @var database::layout_policy
+ *     @brief How entities are ordered in memory once loaded (see ::database_set_layout_policy).
  */
 struct database {
+    user_manager_t          *users;
+    reservation_manager_t   *reservations;
+    flight_manager_t        *flights;
+    gint                    *users_references, *reservations_references, *flights_references;
+    database_statistics_t   *statistics;
+    pthread_mutex_t          write_lock;
+    database_index_policy_t  index_policy;
+    database_layout_policy_t layout_policy;
+};
+
+/**
+ * @brief Gets the scheduled departure date of a flight, for sorting the flights of each user.
+ *
+ * @param database_data Database where the flight is stored.
+ * @param id            Identifier of the flight.
+ *
+ * @return The scheduled departure date of the flight, or `0` if it doesn't exist.
+ */
+date_and_time_t __database_flight_date(const void *database_data, uint32_t id) {
+    const database_t *const database = database_data;
+    const flight_t *const   flight   = flight_manager_get_by_id(database->flights, id);
+    return flight ? flight_get_schedule_departure_date(flight) : 0;
+}
+
+/**
+ * @brief Gets the beginning date of a reservation, for sorting the reservations of each user.
+ *
+ * @param database_data Database where the reservation is stored.
+ * @param id            Identifier of the reservation.
+ *
+ * @return The beginning date (at `00:00:00`) of the reservation, or `0` if it doesn't exist.
+ */
+date_and_time_t __database_reservation_date(const void *database_data, uint32_t id) {
+    const database_t *const    database    = database_data;
+    const reservation_t *const reservation =
+        reservation_manager_get_by_id(database->reservations, id);
+    if (!reservation)
+        return 0;
+
+    date_and_time_t date;
+    date_and_time_from_values(&date, reservation_get_begin_date(reservation), 0 /* 00:00:00 */);
+    return date;
+}
+
+/**
+ * @brief  Creates a reference counter for a manager owned by a single database.
+ * @return A counter with a single reference, or `NULL` on allocation failure.
+ */
+gint *__database_references_create(void) {
+    gint *const references = malloc(sizeof(gint));
+    if (references)
+        *references = 1;
+    return references;
+}
+
+/**
+ * @brief   Drops a reference to a shared manager.
+ * @details @p references is `free`d when the last reference is dropped.
+ *
+ * @param references Reference counter of the manager.
+ *
+ * @retval 0 The manager is still referenced by other databases.
+ * @retval 1 That was the last reference, and the manager must be `free`d.
+ */
+int __database_references_release(gint *references) {
+    if (!g_atomic_int_dec_and_test(references))
+        return 0;
+
+    free(references);
+    return 1;
+}
+
+/** @brief A manager of a ::database_t, in sets of managers to be modified by ::__database_own. */
+typedef enum {
+    DATABASE_MANAGER_USERS        = 1 << 0, /**< @brief ::database::users */
+    DATABASE_MANAGER_RESERVATIONS = 1 << 1, /**< @brief ::database::reservations */
+    DATABASE_MANAGER_FLIGHTS      = 1 << 2, /**< @brief ::database::flights */
+} database_manager_t;
+
+/**
+ * @struct database_clone_data_t
+ * @brief  Managers of a database being cloned concurrently by ::__database_own.
+ *
+ * @var database_clone_data_t::database
+ *     @brief Database whose managers are being cloned.
+ * @var database_clone_data_t::users
+ *     @brief Clone of ::database::users, or `NULL` if it wasn't cloned.
+ * @var database_clone_data_t::reservations
+ *     @brief Clone of ::database::reservations, or `NULL` if it wasn't cloned.
+ * @var database_clone_data_t::flights
+ *     @brief Clone of ::database::flights, or `NULL` if it wasn't cloned.
+ */
+typedef struct {
+    const database_t      *database;
     user_manager_t        *users;
     reservation_manager_t *reservations;
     flight_manager_t      *flights;
-};
+} database_clone_data_t;
+
+/**
+ * @brief  Clones the user manager of a database, as a ::thread_pool_callback_t.
+ * @param  clone_data A pointer to a ::database_clone_data_t.
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_clone_users(void *clone_data) {
+    database_clone_data_t *const data = clone_data;
+    data->users                       = user_manager_clone(data->database->users);
+    return !data->users;
+}
+
+/**
+ * @brief  Clones the reservation manager of a database, as a ::thread_pool_callback_t.
+ * @param  clone_data A pointer to a ::database_clone_data_t.
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_clone_reservations(void *clone_data) {
+    database_clone_data_t *const data = clone_data;
+    data->reservations                = reservation_manager_clone(data->database->reservations);
+    return !data->reservations;
+}
+
+/**
+ * @brief  Clones the flight manager of a database, as a ::thread_pool_callback_t.
+ * @param  clone_data A pointer to a ::database_clone_data_t.
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_clone_flights(void *clone_data) {
+    database_clone_data_t *const data = clone_data;
+    data->flights                     = flight_manager_clone(data->database->flights);
+    return !data->flights;
+}
+
+/**
+ * @brief   Makes sure some of a database's managers aren't shared, so that they can be modified.
+ * @details Shared managers are copied, each in a different thread of the
+ *          [shared thread pool](@ref thread_pool.h), as they don't depend on each other.
+ *
+ * @param database Database whose managers are to be modified.
+ * @param managers Bitwise or of the ::database_manager_t to be modified.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p database is left unchanged).
+ */
+int __database_own(database_t *database, int managers) {
+    thread_pool_callback_t tasks[3];
+    size_t                 ntasks = 0;
+    if ((managers & DATABASE_MANAGER_USERS) && g_atomic_int_get(database->users_references) > 1)
+        tasks[ntasks++] = __database_clone_users;
+    if ((managers & DATABASE_MANAGER_RESERVATIONS) &&
+        g_atomic_int_get(database->reservations_references) > 1)
+        tasks[ntasks++] = __database_clone_reservations;
+    if ((managers & DATABASE_MANAGER_FLIGHTS) && g_atomic_int_get(database->flights_references) > 1)
+        tasks[ntasks++] = __database_clone_flights;
+
+    database_clone_data_t data = {.database     = database,
+                                  .users        = NULL,
+                                  .reservations = NULL,
+                                  .flights      = NULL};
+
+    /* The first clone is made in this thread, and others if they can't be submitted */
+    thread_pool_t *const  pool       = ntasks > 1 ? thread_pool_get_shared() : NULL;
+    thread_pool_future_t *futures[3] = {NULL, NULL, NULL};
+    for (size_t i = 1; i < ntasks; ++i)
+        if (pool)
+            futures[i] = thread_pool_submit(pool, tasks[i], &data);
+
+    int failure = 0;
+    for (size_t i = 0; i < ntasks; ++i)
+        if (!futures[i])
+            failure |= tasks[i](&data);
+    for (size_t i = 1; i < ntasks; ++i)
+        if (futures[i])
+            failure |= thread_pool_future_wait(futures[i]);
+
+    gint *const users_references = data.users ? __database_references_create() : NULL;
+    gint *const reservations_references =
+        data.reservations ? __database_references_create() : NULL;
+    gint *const flights_references = data.flights ? __database_references_create() : NULL;
+    if (failure || (data.users && !users_references) ||
+        (data.reservations && !reservations_references) ||
+        (data.flights && !flights_references)) {
+
+        free(users_references);
+        free(reservations_references);
+        free(flights_references);
+        if (data.users)
+            user_manager_free(data.users);
+        if (data.reservations)
+            reservation_manager_free(data.reservations);
+        if (data.flights)
+            flight_manager_free(data.flights);
+        return 1;
+    }
+
+    /* Other databases may have been freed meanwhile, leaving the original managers unreferenced */
+    if (data.users) {
+        if (__database_references_release(database->users_references))
+            user_manager_free(database->users);
+        database->users            = data.users;
+        database->users_references = users_references;
+    }
+    if (data.reservations) {
+        if (__database_references_release(database->reservations_references))
+            reservation_manager_free(database->reservations);
+        database->reservations            = data.reservations;
+        database->reservations_references = reservations_references;
+    }
+    if (data.flights) {
+        if (__database_references_release(database->flights_references))
+            flight_manager_free(database->flights);
+        database->flights            = data.flights;
+        database->flights_references = flights_references;
+    }
+
+    /* The user manager may have been shared with a database that has since been freed */
+    if (managers & DATABASE_MANAGER_USERS)
+        user_manager_set_association_dates(database->users,
+                                           __database_flight_date,
+                                           __database_reservation_date,
+                                           database);
+    return 0;
+}
 
 database_t *database_create(void) {
     database_t *const database = malloc(sizeof(database_t));
@@ -60,8 +314,43 @@ database_t *database_create(void) {
     if (!database->flights)
         goto DEFER_4;
 
+    database->users_references = __database_references_create();
+    if (!database->users_references)
+        goto DEFER_5;
+
+    database->reservations_references = __database_references_create();
+    if (!database->reservations_references)
+        goto DEFER_6;
+
+    database->flights_references = __database_references_create();
+    if (!database->flights_references)
+        goto DEFER_7;
+
+    database->statistics = database_statistics_create();
+    if (!database->statistics)
+        goto DEFER_8;
+
+    if (pthread_mutex_init(&database->write_lock, NULL))
+        goto DEFER_9;
+
+    database->index_policy  = DATABASE_INDEX_POLICY_EAGER;
+    database->layout_policy = DATABASE_LAYOUT_POLICY_LOAD_ORDER;
+    user_manager_set_association_dates(database->users,
+                                       __database_flight_date,
+                                       __database_reservation_date,
+                                       database);
     return database;
 
+DEFER_9:
+    database_statistics_free(database->statistics);
+DEFER_8:
+    free(database->flights_references);
+DEFER_7:
+    free(database->reservations_references);
+DEFER_6:
+    free(database->users_references);
+DEFER_5:
+    flight_manager_free(database->flights);
 DEFER_4:
     reservation_manager_free(database->reservations);
 DEFER_3:
@@ -73,32 +362,39 @@ DEFER_1:
 }
 
 database_t *database_clone(const database_t *database) {
+    /* A shared user manager must never need to sort associations with another database's data */
+    if (user_manager_compact(database->users))
+        return NULL;
+
     database_t *const clone = malloc(sizeof(database_t));
-    if (!database)
-        goto DEFER_1;
+    if (!clone)
+        return NULL;
 
-    clone->users = user_manager_clone(database->users);
-    if (!clone->users)
-        goto DEFER_2;
+    clone->statistics = database_statistics_clone(database->statistics);
+    if (!clone->statistics) {
+        free(clone);
+        return NULL;
+    }
 
-    clone->reservations = reservation_manager_clone(database->reservations);
-    if (!clone->reservations)
-        goto DEFER_3;
+    if (pthread_mutex_init(&clone->write_lock, NULL)) {
+        database_statistics_free(clone->statistics);
+        free(clone);
+        return NULL;
+    }
 
-    clone->flights = flight_manager_clone(database->flights);
-    if (!clone->flights)
-        goto DEFER_4;
+    clone->users                   = database->users;
+    clone->reservations            = database->reservations;
+    clone->flights                 = database->flights;
+    clone->users_references        = database->users_references;
+    clone->reservations_references = database->reservations_references;
+    clone->flights_references      = database->flights_references;
+    clone->index_policy            = database->index_policy;
+    clone->layout_policy           = database->layout_policy;
 
+    g_atomic_int_inc(clone->users_references);
+    g_atomic_int_inc(clone->reservations_references);
+    g_atomic_int_inc(clone->flights_references);
     return clone;
-
-DEFER_4:
-    reservation_manager_free(clone->reservations);
-DEFER_3:
-    user_manager_free(clone->users);
-DEFER_2:
-    free(clone);
-DEFER_1:
-    return NULL;
 }
 
 const user_manager_t *database_get_users(const database_t *database) {
@@ -113,47 +409,375 @@ const flight_manager_t *database_get_flights(const database_t *database) {
     return database->flights;
 }
 
-int database_add_user(database_t *database, const user_t *user) {
-    return user_manager_add_user(database->users, user);
+const database_statistics_t *database_get_statistics(const database_t *database) {
+    return database->statistics;
+}
+
+int database_reserve(database_t *database,
+                     size_t      nusers,
+                     size_t      nflights,
+                     size_t      nreservations,
+                     size_t      npassengers) {
+    /* Every passenger and reservation is associated with a user */
+    const size_t nassociations = npassengers + nreservations;
+
+    pthread_mutex_lock(&database->write_lock);
+    const int retval = __database_own(database,
+                                      DATABASE_MANAGER_USERS | DATABASE_MANAGER_RESERVATIONS |
+                                          DATABASE_MANAGER_FLIGHTS) ||
+                       user_manager_reserve(database->users, nusers, nassociations) ||
+                       flight_manager_reserve(database->flights, nflights) ||
+                       reservation_manager_reserve(database->reservations, nreservations);
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
+}
+
+int database_compact(database_t *database) {
+    int retval = 0;
+    pthread_mutex_lock(&database->write_lock);
+
+    /* Shared managers may be being read by other databases */
+    if (g_atomic_int_get(database->users_references) == 1)
+        retval |= user_manager_compact(database->users) ||
+                  user_manager_shrink_to_fit(database->users);
+    if (g_atomic_int_get(database->flights_references) == 1)
+        retval |= flight_manager_shrink_to_fit(database->flights);
+    if (g_atomic_int_get(database->reservations_references) == 1)
+        retval |= reservation_manager_shrink_to_fit(database->reservations);
+
+    pthread_mutex_unlock(&database->write_lock);
+
+#ifdef __GLIBC__
+    malloc_trim(0); /* Temporary allocations while loading leave the heap fragmented */
+#endif
+    return retval;
+}
+
+int database_cluster(database_t *database) {
+    int retval = 0;
+    pthread_mutex_lock(&database->write_lock);
+
+    /* Shared managers may be being read by other databases */
+    if (g_atomic_int_get(database->flights_references) == 1)
+        retval |= flight_manager_cluster(database->flights);
+    if (g_atomic_int_get(database->reservations_references) == 1)
+        retval |= reservation_manager_cluster(database->reservations);
+
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
+}
+
+/**
+ * @struct database_index_entry_t
+ * @brief  How to build a ::database_index_t, in ::database_index_registry.
+ *
+ * @var database_index_entry_t::manager
+ *     @brief Which manager the index belongs to.
+ * @var database_index_entry_t::index
+ *     @brief Index of the manager (::user_manager_index_t, ::flight_manager_index_t or
+ *            ::reservation_manager_index_t).
+ */
+typedef struct {
+    enum {
+        DATABASE_INDEX_MANAGER_USERS,       /**< Index of the ::user_manager_t. */
+        DATABASE_INDEX_MANAGER_FLIGHTS,     /**< Index of the ::flight_manager_t. */
+        DATABASE_INDEX_MANAGER_RESERVATIONS /**< Index of the ::reservation_manager_t. */
+    } manager;
+    int index;
+} database_index_entry_t;
+
+/** @brief Builder of every ::database_index_t, indexed by it. */
+const database_index_entry_t database_index_registry[DATABASE_INDEX_COUNT] = {
+    {DATABASE_INDEX_MANAGER_USERS,        USER_MANAGER_INDEX_NAMES              },
+    {DATABASE_INDEX_MANAGER_USERS,        USER_MANAGER_INDEX_IDS                },
+    {DATABASE_INDEX_MANAGER_USERS,        USER_MANAGER_INDEX_BITMAPS            },
+    {DATABASE_INDEX_MANAGER_USERS,        USER_MANAGER_INDEX_PASSENGERS         },
+    {DATABASE_INDEX_MANAGER_FLIGHTS,      FLIGHT_MANAGER_INDEX_COLUMNS          },
+    {DATABASE_INDEX_MANAGER_FLIGHTS,      FLIGHT_MANAGER_INDEX_ORIGIN_DEPARTURES},
+    {DATABASE_INDEX_MANAGER_FLIGHTS,      FLIGHT_MANAGER_INDEX_ROUTE_DEPARTURES },
+    {DATABASE_INDEX_MANAGER_FLIGHTS,      FLIGHT_MANAGER_INDEX_AIRPORTS         },
+    {DATABASE_INDEX_MANAGER_RESERVATIONS, RESERVATION_MANAGER_INDEX_COLUMNS     },
+    {DATABASE_INDEX_MANAGER_RESERVATIONS, RESERVATION_MANAGER_INDEX_HOTELS      },
+    {DATABASE_INDEX_MANAGER_RESERVATIONS, RESERVATION_MANAGER_INDEX_HOTEL_IDS   },
+};
+
+/** @brief All ::database_index_t, from the most to the least expensive to build. */
+const database_index_t database_index_build_order[DATABASE_INDEX_COUNT] = {
+    DATABASE_INDEX_USER_NAMES,
+    DATABASE_INDEX_FLIGHT_ORIGIN_DEPARTURES,
+    DATABASE_INDEX_FLIGHT_ROUTE_DEPARTURES,
+    DATABASE_INDEX_RESERVATION_HOTELS,
+    DATABASE_INDEX_RESERVATION_COLUMNS,
+    DATABASE_INDEX_FLIGHT_COLUMNS,
+    DATABASE_INDEX_USER_IDS,
+    DATABASE_INDEX_USER_BITMAPS,
+    DATABASE_INDEX_USER_PASSENGERS,
+    DATABASE_INDEX_RESERVATION_HOTEL_IDS,
+    DATABASE_INDEX_FLIGHT_AIRPORTS};
+
+void database_set_index_policy(database_t *database, database_index_policy_t policy) {
+    database->index_policy = policy;
+}
+
+database_index_policy_t database_get_index_policy(const database_t *database) {
+    return database->index_policy;
+}
+
+void database_set_layout_policy(database_t *database, database_layout_policy_t policy) {
+    database->layout_policy = policy;
+}
+
+database_layout_policy_t database_get_layout_policy(const database_t *database) {
+    return database->layout_policy;
+}
+
+int database_build_index(const database_t *database, database_index_t index) {
+    const database_index_entry_t *const entry = &database_index_registry[index];
+    switch (entry->manager) {
+        case DATABASE_INDEX_MANAGER_USERS:
+            return user_manager_build_index(database->users, entry->index);
+        case DATABASE_INDEX_MANAGER_FLIGHTS:
+            return flight_manager_build_index(database->flights, entry->index);
+        case DATABASE_INDEX_MANAGER_RESERVATIONS:
+            return reservation_manager_build_index(database->reservations, entry->index);
+        default:
+            return 0;
+    }
 }
 
-int database_add_reservation(database_t *database, const reservation_t *reservation) {
-    if (reservation_manager_add_reservation(database->reservations, reservation))
+/**
+ * @struct database_build_indexes_data_t
+ * @brief  Data shared by all tasks of ::database_build_indexes.
+ *
+ * @var database_build_indexes_data_t::database
+ *     @brief Database whose indices are being built.
+ * @var database_build_indexes_data_t::indices
+ *     @brief Indices to be built, one per task.
+ * @var database_build_indexes_data_t::failed
+ *     @brief Whether building each index in ::database_build_indexes_data_t::indices failed.
+ */
+typedef struct {
+    const database_t *database;
+    database_index_t  indices[DATABASE_INDEX_COUNT];
+    int               failed[DATABASE_INDEX_COUNT];
+} database_build_indexes_data_t;
+
+/**
+ * @brief Builds an index in ::database_build_indexes_data_t::indices.
+ *
+ * @param scheduler Scheduler running the task. Not used.
+ * @param worker    Worker running the task. Not used.
+ * @param user_data A pointer to a ::database_build_indexes_data_t.
+ * @param index     Index of the task in ::database_build_indexes_data_t::indices.
+ */
+void __database_build_index_task(task_scheduler_t *scheduler,
+                                 size_t            worker,
+                                 void             *user_data,
+                                 size_t            index) {
+    (void) scheduler;
+    (void) worker;
+    database_build_indexes_data_t *const data = user_data;
+    data->failed[index] = database_build_index(data->database, data->indices[index]);
+}
+
+int database_build_indexes(const database_t *database, database_index_set_t indices) {
+    database_build_indexes_data_t data = {.database = database, .failed = {0}};
+
+    size_t ntasks = 0;
+    for (size_t i = 0; i < DATABASE_INDEX_COUNT; ++i)
+        if (indices & DATABASE_INDEX_SET(database_index_build_order[i]))
+            data.indices[ntasks++] = database_index_build_order[i];
+    if (ntasks == 0)
+        return 0;
+
+    if (task_scheduler_run(thread_count_get(), ntasks, __database_build_index_task, &data))
         return 1;
 
-    return user_manager_add_user_reservation_association(database->users,
-                                                         reservation_get_const_user_id(reservation),
-                                                         reservation_get_id(reservation));
+    int retval = 0;
+    for (size_t i = 0; i < ntasks; ++i)
+        retval |= data.failed[i];
+    return retval;
+}
+
+int database_add_user(database_t *database, const user_t *user) {
+    pthread_mutex_lock(&database->write_lock);
+    const int retval = __database_own(database, DATABASE_MANAGER_USERS) ||
+                       user_manager_add_user(database->users, user);
+    if (!retval)
+        database_statistics_add_user(database->statistics, user);
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
 }
 
-int database_add_flight(database_t *database, const flight_t *flight) {
-    return flight_manager_add_flight(database->flights, flight);
+int database_add_reservation(database_t                *database,
+                             const string_dictionary_t *hotel_names,
+                             const reservation_t       *reservation) {
+    int retval = 1;
+    pthread_mutex_lock(&database->write_lock);
+
+    if (!__database_own(database, DATABASE_MANAGER_RESERVATIONS | DATABASE_MANAGER_USERS) &&
+        !reservation_manager_add_reservation(database->reservations, hotel_names, reservation))
+        retval = user_manager_add_user_reservation_association(
+            database->users,
+            reservation_get_user(reservation),
+            reservation_get_id(reservation),
+            reservation_calculate_price_cents(reservation));
+
+    if (!retval)
+        database_statistics_add_reservation(database->statistics, reservation);
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
+}
+
+int database_add_reservations_batch(database_t                *database,
+                                    const string_dictionary_t *hotel_names,
+                                    size_t                     n,
+                                    const reservation_t *const reservations[n]) {
+    int retval = 1;
+    pthread_mutex_lock(&database->write_lock);
+    if (__database_own(database, DATABASE_MANAGER_RESERVATIONS | DATABASE_MANAGER_USERS))
+        goto DEFER_1;
+
+    /* User associations are deferred, so that they're added in bulk after each group */
+    for (size_t begin = 0; begin < n; begin += DATABASE_RESERVATIONS_BATCH_SIZE) {
+        const size_t batch = min(n - begin, DATABASE_RESERVATIONS_BATCH_SIZE);
+
+        user_ordinal_t   users[DATABASE_RESERVATIONS_BATCH_SIZE];
+        reservation_id_t ids[DATABASE_RESERVATIONS_BATCH_SIZE];
+        uint64_t         prices[DATABASE_RESERVATIONS_BATCH_SIZE];
+        for (size_t i = 0; i < batch; ++i) {
+            const reservation_t *const reservation = reservations[begin + i];
+            if (reservation_manager_add_reservation(database->reservations,
+                                                    hotel_names,
+                                                    reservation))
+                goto DEFER_1;
+
+            users[i]  = reservation_get_user(reservation);
+            ids[i]    = reservation_get_id(reservation);
+            prices[i] = reservation_calculate_price_cents(reservation);
+        }
+
+        if (user_manager_add_user_reservation_associations(database->users,
+                                                           batch,
+                                                           users,
+                                                           ids,
+                                                           prices))
+            goto DEFER_1;
+
+        for (size_t i = 0; i < batch; ++i)
+            database_statistics_add_reservation(database->statistics, reservations[begin + i]);
+    }
+
+    retval = 0;
+DEFER_1:
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
+}
+
+int database_add_flight(database_t                *database,
+                        const string_dictionary_t *strings,
+                        const flight_t            *flight) {
+    pthread_mutex_lock(&database->write_lock);
+    const int retval = __database_own(database, DATABASE_MANAGER_FLIGHTS) ||
+                       flight_manager_add_flight(database->flights, strings, flight);
+    if (!retval)
+        database_statistics_add_flight(database->statistics, flight);
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
 }
 
 int database_invalidate_flight(database_t *database, flight_id_t id) {
-    return flight_manager_invalidate_by_id(database->flights, id);
+    pthread_mutex_lock(&database->write_lock);
+    int retval = 1;
+    if (flight_manager_get_by_id(database->flights, id))
+        retval = __database_own(database, DATABASE_MANAGER_FLIGHTS)
+                     ? 2
+                     : flight_manager_invalidate_by_id(database->flights, id);
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
 }
 
-int database_add_passengers(database_t       *database,
-                            flight_id_t       flight_id,
-                            size_t            n,
-                            const char *const user_ids[n]) {
-    if (flight_manager_add_passagers(database->flights, flight_id, n))
+/**
+ * @brief Adds passengers to a database, as in ::database_add_passengers, without locking it.
+ *
+ * @param database  Database to add passenger relations to. Its lock must be held.
+ * @param flight_id Identifier of the flight to be associated with @p users.
+ * @param n         Number of users in @p users.
+ * @param users     Ordinals of the users to add @p flight_id to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure, user / flight not found, or too many passengers for number of
+ *           flight seats.
+ */
+int __database_add_passengers_locked(database_t           *database,
+                                     flight_id_t           flight_id,
+                                     size_t                n,
+                                     const user_ordinal_t *users) {
+
+    if (__database_own(database, DATABASE_MANAGER_FLIGHTS | DATABASE_MANAGER_USERS) ||
+        flight_manager_add_passagers(database->flights, flight_id, n))
         return 1;
 
-    for (size_t i = 0; i < n; ++i) {
-        if (user_manager_add_user_flight_association(database->users, user_ids[i], flight_id)) {
-            /* Revert the n passengers added and fail. Additions to users are non-reversible. */
-            flight_manager_add_passagers(database->flights, flight_id, -n);
-            return 1;
-        }
+    if (user_manager_add_user_flight_associations(database->users, flight_id, n, users)) {
+        /* Revert the n passengers added and fail. Additions to users are non-reversible. */
+        flight_manager_add_passagers(database->flights, flight_id, -n);
+        return 1;
     }
+
+    database_statistics_add_passengers(database->statistics, n);
     return 0;
 }
 
+int database_add_passengers(database_t          *database,
+                            flight_id_t          flight_id,
+                            size_t               n,
+                            const user_ordinal_t users[n]) {
+    pthread_mutex_lock(&database->write_lock);
+    const int retval = __database_add_passengers_locked(database, flight_id, n, users);
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
+}
+
+int database_add_passengers_batch(database_t                  *database,
+                                  size_t                       nflights,
+                                  database_flight_passengers_t flights[nflights],
+                                  const user_ordinal_t        *users) {
+    int retval = 0;
+    pthread_mutex_lock(&database->write_lock);
+
+    for (size_t i = 0; i < nflights; ++i) {
+        flights[i].failed  = __database_add_passengers_locked(database,
+                                                             flights[i].flight_id,
+                                                             flights[i].npassengers,
+                                                             users);
+        retval            |= flights[i].failed;
+        users             += flights[i].npassengers;
+    }
+
+    pthread_mutex_unlock(&database->write_lock);
+    return retval;
+}
+
+int database_replicate_indexes(const database_t *database, const numa_topology_t *topology) {
+    const int users_failed = user_manager_replicate_indexes(database->users, topology);
+    return reservation_manager_replicate_indexes(database->reservations, topology) || users_failed;
+}
+
+size_t database_get_memory_usage(const database_t *database) {
+    return sizeof(database_t) + database_statistics_get_memory_usage(database->statistics) +
+           user_manager_get_memory_usage(database->users) +
+           reservation_manager_get_memory_usage(database->reservations) +
+           flight_manager_get_memory_usage(database->flights);
+}
+
 void database_free(database_t *database) {
-    user_manager_free(database->users);
-    reservation_manager_free(database->reservations);
-    flight_manager_free(database->flights);
+    if (__database_references_release(database->users_references))
+        user_manager_free(database->users);
+    if (__database_references_release(database->reservations_references))
+        reservation_manager_free(database->reservations);
+    if (__database_references_release(database->flights_references))
+        flight_manager_free(database->flights);
+    database_statistics_free(database->statistics);
+    pthread_mutex_destroy(&database->write_lock);
     free(database);
 }
@@ -0,0 +1,827 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  database_arrow.c
+ * @brief Implementation of methods in include/database/database_arrow.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "database/database_arrow.h"
+#include "utils/int_utils.h"
+
+/** @brief Number of entities looked up at once by identifier (see ::flight_manager_get_by_ids). */
+#define DATABASE_ARROW_LOOKUP_BATCH 256
+
+/** @brief Initial number of bytes allocated for the characters of a column of strings. */
+#define DATABASE_ARROW_STRINGS_INITIAL_CAPACITY 4096
+
+/** @brief Number of seconds in a day. */
+#define DATABASE_ARROW_SECONDS_PER_DAY 86400
+
+/**
+ * @struct database_arrow_field_t
+ * @brief  Description of a column of an exported table.
+ *
+ * @var database_arrow_field_t::name
+ *     @brief Name of the column.
+ * @var database_arrow_field_t::format
+ *     @brief Arrow format string of the column's type.
+ * @var database_arrow_field_t::nullable
+ *     @brief Whether the column can have null values.
+ */
+typedef struct {
+    const char *name;
+    const char *format;
+    int         nullable;
+} database_arrow_field_t;
+
+/** @brief Columns of an exported table of users. */
+typedef enum {
+    DATABASE_ARROW_USER_ID,               /**< @brief See ::user_get_const_id. */
+    DATABASE_ARROW_USER_NAME,             /**< @brief See ::user_get_const_name. */
+    DATABASE_ARROW_USER_BIRTH_DATE,       /**< @brief See ::user_get_birth_date. */
+    DATABASE_ARROW_USER_SEX,              /**< @brief See ::user_get_sex. */
+    DATABASE_ARROW_USER_PASSPORT,         /**< @brief See ::user_get_const_passport. */
+    DATABASE_ARROW_USER_COUNTRY_CODE,     /**< @brief See ::user_get_country_code. */
+    DATABASE_ARROW_USER_ACCOUNT_CREATION, /**< @brief See ::user_get_account_creation_date. */
+    DATABASE_ARROW_USER_ACTIVE,           /**< @brief See ::user_get_account_status. */
+    DATABASE_ARROW_USER_COLUMNS           /**< @brief Number of columns. */
+} database_arrow_user_column_t;
+
+/** @brief Columns of an exported table of flights. */
+typedef enum {
+    DATABASE_ARROW_FLIGHT_ID,                      /**< @brief Borrowed from the manager. */
+    DATABASE_ARROW_FLIGHT_AIRLINE,                 /**< @brief Copied. */
+    DATABASE_ARROW_FLIGHT_PLANE_MODEL,             /**< @brief Copied. */
+    DATABASE_ARROW_FLIGHT_TOTAL_SEATS,             /**< @brief Copied. */
+    DATABASE_ARROW_FLIGHT_ORIGIN,                  /**< @brief Copied. */
+    DATABASE_ARROW_FLIGHT_DESTINATION,             /**< @brief Copied. */
+    DATABASE_ARROW_FLIGHT_SCHEDULE_DEPARTURE_DATE, /**< @brief Copied. */
+    DATABASE_ARROW_FLIGHT_SCHEDULE_ARRIVAL_DATE,   /**< @brief Copied. */
+    DATABASE_ARROW_FLIGHT_REAL_DEPARTURE_DATE,     /**< @brief Copied. */
+    DATABASE_ARROW_FLIGHT_NUMBER_OF_PASSENGERS,    /**< @brief Borrowed from the manager. */
+    DATABASE_ARROW_FLIGHT_COLUMNS                  /**< @brief Number of columns. */
+} database_arrow_flight_column_t;
+
+/** @brief Columns of an exported table of reservations. */
+typedef enum {
+    DATABASE_ARROW_RESERVATION_ID,                 /**< @brief Borrowed from the manager. */
+    DATABASE_ARROW_RESERVATION_USER_ID,            /**< @brief Copied. */
+    DATABASE_ARROW_RESERVATION_HOTEL_ID,           /**< @brief Borrowed from the manager. */
+    DATABASE_ARROW_RESERVATION_HOTEL_NAME,         /**< @brief Copied. */
+    DATABASE_ARROW_RESERVATION_HOTEL_STARS,        /**< @brief Borrowed from the manager. */
+    DATABASE_ARROW_RESERVATION_CITY_TAX,           /**< @brief Borrowed from the manager. */
+    DATABASE_ARROW_RESERVATION_BEGIN_DATE,         /**< @brief Copied. */
+    DATABASE_ARROW_RESERVATION_END_DATE,           /**< @brief Copied. */
+    DATABASE_ARROW_RESERVATION_PRICE_PER_NIGHT,    /**< @brief Borrowed from the manager. */
+    DATABASE_ARROW_RESERVATION_INCLUDES_BREAKFAST, /**< @brief Copied. */
+    DATABASE_ARROW_RESERVATION_RATING,             /**< @brief Borrowed, with a validity bitmap. */
+    DATABASE_ARROW_RESERVATION_COLUMNS             /**< @brief Number of columns. */
+} database_arrow_reservation_column_t;
+
+/** @brief Description of every ::database_arrow_user_column_t. */
+const database_arrow_field_t database_arrow_user_fields[DATABASE_ARROW_USER_COLUMNS] = {
+    {"id", "u", 0},
+    {"name", "u", 0},
+    {"birth_date", "tdD", 0},
+    {"sex", "u", 0},
+    {"passport", "u", 0},
+    {"country_code", "u", 0},
+    {"account_creation", "tss:", 0},
+    {"active", "b", 0}
+};
+
+/** @brief Description of every ::database_arrow_flight_column_t. */
+const database_arrow_field_t database_arrow_flight_fields[DATABASE_ARROW_FLIGHT_COLUMNS] = {
+    {"id", "I", 0},
+    {"airline", "u", 0},
+    {"plane_model", "u", 0},
+    {"total_seats", "S", 0},
+    {"origin", "u", 0},
+    {"destination", "u", 0},
+    {"schedule_departure_date", "tss:", 0},
+    {"schedule_arrival_date", "tss:", 0},
+    {"real_departure_date", "tss:", 0},
+    {"number_of_passengers", "S", 0}
+};
+
+/** @brief Description of every ::database_arrow_reservation_column_t. */
+const database_arrow_field_t
+    database_arrow_reservation_fields[DATABASE_ARROW_RESERVATION_COLUMNS] = {
+    {"id", "I", 0},
+    {"user_id", "u", 0},
+    {"hotel_id", "S", 0},
+    {"hotel_name", "u", 0},
+    {"hotel_stars", "C", 0},
+    {"city_tax", "C", 0},
+    {"begin_date", "tdD", 0},
+    {"end_date", "tdD", 0},
+    {"price_per_night", "S", 0},
+    {"includes_breakfast", "b", 0},
+    {"rating", "C", 1}
+};
+
+/** @brief Names of every ::database_arrow_table_t. */
+const char *const database_arrow_table_names[DATABASE_ARROW_TABLE_COUNT] = {"users",
+                                                                            "flights",
+                                                                            "reservations"};
+
+/**
+ * @struct database_arrow_column_t
+ * @brief  Private data of an exported column (::ArrowArray::private_data).
+ *
+ * @var database_arrow_column_t::buffers
+ *     @brief Buffers of the column, pointed to by ::ArrowArray::buffers.
+ * @var database_arrow_column_t::owned
+ *     @brief Buffers allocated for the column, freed when it's released. Buffers borrowed from the
+ *            database aren't in this array.
+ */
+typedef struct {
+    const void *buffers[3];
+    void       *owned[3];
+} database_arrow_column_t;
+
+/**
+ * @struct database_arrow_batch_t
+ * @brief  Private data of an exported record batch (::ArrowArray::private_data).
+ *
+ * @var database_arrow_batch_t::children
+ *     @brief Columns of the record batch.
+ * @var database_arrow_batch_t::pointers
+ *     @brief Pointers to every element of ::database_arrow_batch_t::children, pointed to by
+ *            ::ArrowArray::children.
+ * @var database_arrow_batch_t::buffers
+ *     @brief Buffers of the record batch (only a `NULL` validity bitmap).
+ */
+typedef struct {
+    struct ArrowArray  *children;
+    struct ArrowArray **pointers;
+    const void         *buffers[1];
+} database_arrow_batch_t;
+
+/**
+ * @struct database_arrow_schema_t
+ * @brief  Private data of the type of an exported record batch (::ArrowSchema::private_data).
+ *
+ * @var database_arrow_schema_t::children
+ *     @brief Types of the columns of the record batch.
+ * @var database_arrow_schema_t::pointers
+ *     @brief Pointers to every element of ::database_arrow_schema_t::children, pointed to by
+ *            ::ArrowSchema::children.
+ */
+typedef struct {
+    struct ArrowSchema  *children;
+    struct ArrowSchema **pointers;
+} database_arrow_schema_t;
+
+/**
+ * @struct database_arrow_strings_t
+ * @brief  A column of strings being filled.
+ *
+ * @var database_arrow_strings_t::column
+ *     @brief Column being filled, that owns the offsets and the characters.
+ * @var database_arrow_strings_t::offsets
+ *     @brief Index of the first character of every string, and the end of the last one.
+ * @var database_arrow_strings_t::n
+ *     @brief Number of strings already added.
+ * @var database_arrow_strings_t::length
+ *     @brief Number of characters already added.
+ * @var database_arrow_strings_t::capacity
+ *     @brief Number of characters that fit in the column's buffer of characters.
+ */
+typedef struct {
+    database_arrow_column_t *column;
+    int32_t                 *offsets;
+    size_t                   n, length, capacity;
+} database_arrow_strings_t;
+
+const char *database_arrow_table_get_name(database_arrow_table_t table) {
+    return database_arrow_table_names[table];
+}
+
+/**
+ * @brief Releases an exported column (::ArrowArray::release).
+ * @param array Column to be released.
+ */
+void __database_arrow_release_column(struct ArrowArray *array) {
+    database_arrow_column_t *const column = array->private_data;
+    for (size_t i = 0; i < 3; ++i)
+        free(column->owned[i]);
+
+    free(column);
+    array->release = NULL;
+}
+
+/**
+ * @brief   Releases an exported record batch (::ArrowArray::release).
+ * @details Columns moved elsewhere by the consumer (already marked as released) are skipped.
+ *
+ * @param array Record batch to be released.
+ */
+void __database_arrow_release_batch(struct ArrowArray *array) {
+    database_arrow_batch_t *const batch = array->private_data;
+    for (int64_t i = 0; i < array->n_children; ++i)
+        if (batch->children[i].release)
+            batch->children[i].release(&batch->children[i]);
+
+    free(batch->children);
+    free(batch->pointers);
+    free(batch);
+    array->release = NULL;
+}
+
+/**
+ * @brief   Releases the type of an exported column (::ArrowSchema::release).
+ * @details Nothing is allocated for types of columns, as their names and formats are constant.
+ *
+ * @param schema Type to be released.
+ */
+void __database_arrow_release_field(struct ArrowSchema *schema) {
+    schema->release = NULL;
+}
+
+/**
+ * @brief Releases the type of an exported record batch (::ArrowSchema::release).
+ * @param schema Type to be released.
+ */
+void __database_arrow_release_schema(struct ArrowSchema *schema) {
+    database_arrow_schema_t *const private = schema->private_data;
+    for (int64_t i = 0; i < schema->n_children; ++i)
+        if (private->children[i].release)
+            private->children[i].release(&private->children[i]);
+
+    free(private->children);
+    free(private->pointers);
+    free(private);
+    schema->release = NULL;
+}
+
+/**
+ * @brief Creates the type of an exported record batch.
+ *
+ * @param fields   Description of every column.
+ * @param ncolumns Number of elements in @p fields.
+ * @param schema   Where to write the type to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_arrow_create_schema(const database_arrow_field_t *fields,
+                                   size_t                        ncolumns,
+                                   struct ArrowSchema           *schema) {
+
+    database_arrow_schema_t *const private = malloc(sizeof(database_arrow_schema_t));
+    if (!private)
+        return 1;
+
+    private->children = malloc(sizeof(struct ArrowSchema) * ncolumns);
+    private->pointers = malloc(sizeof(struct ArrowSchema *) * ncolumns);
+    if (!private->children || !private->pointers) {
+        free(private->children);
+        free(private->pointers);
+        free(private);
+        return 1;
+    }
+
+    for (size_t i = 0; i < ncolumns; ++i) {
+        private->children[i] = (struct ArrowSchema) {
+            .format       = fields[i].format,
+            .name         = fields[i].name,
+            .metadata     = NULL,
+            .flags        = fields[i].nullable ? ARROW_FLAG_NULLABLE : 0,
+            .n_children   = 0,
+            .children     = NULL,
+            .dictionary   = NULL,
+            .release      = __database_arrow_release_field,
+            .private_data = NULL};
+        private->pointers[i] = &private->children[i];
+    }
+
+    *schema = (struct ArrowSchema) {.format       = "+s",
+                                    .name         = NULL,
+                                    .metadata     = NULL,
+                                    .flags        = 0,
+                                    .n_children   = (int64_t) ncolumns,
+                                    .children     = private->pointers,
+                                    .dictionary   = NULL,
+                                    .release      = __database_arrow_release_schema,
+                                    .private_data = private};
+    return 0;
+}
+
+/**
+ * @brief   Creates an exported record batch, whose columns are yet to be filled.
+ * @details Every column starts with no buffers (see ::database_arrow_column_t::buffers) and no
+ *          null values.
+ *
+ * @param fields   Description of every column.
+ * @param ncolumns Number of elements in @p fields.
+ * @param n        Number of rows in the record batch.
+ * @param array    Where to write the record batch to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_arrow_create_batch(const database_arrow_field_t *fields,
+                                  size_t                        ncolumns,
+                                  size_t                        n,
+                                  struct ArrowArray            *array) {
+
+    database_arrow_batch_t *const batch = malloc(sizeof(database_arrow_batch_t));
+    if (!batch)
+        return 1;
+
+    batch->children   = malloc(sizeof(struct ArrowArray) * ncolumns);
+    batch->pointers   = malloc(sizeof(struct ArrowArray *) * ncolumns);
+    batch->buffers[0] = NULL;
+    if (!batch->children || !batch->pointers) {
+        free(batch->children);
+        free(batch->pointers);
+        free(batch);
+        return 1;
+    }
+
+    *array = (struct ArrowArray) {.length       = (int64_t) n,
+                                  .null_count   = 0,
+                                  .offset       = 0,
+                                  .n_buffers    = 1,
+                                  .n_children   = 0, /* Incremented as columns are created */
+                                  .buffers      = batch->buffers,
+                                  .children     = batch->pointers,
+                                  .dictionary   = NULL,
+                                  .release      = __database_arrow_release_batch,
+                                  .private_data = batch};
+
+    for (size_t i = 0; i < ncolumns; ++i) {
+        database_arrow_column_t *const column = calloc(1, sizeof(database_arrow_column_t));
+        if (!column) {
+            array->release(array);
+            return 1;
+        }
+
+        batch->children[i] = (struct ArrowArray) {
+            .length       = (int64_t) n,
+            .null_count   = 0,
+            .offset       = 0,
+            .n_buffers    = strcmp(fields[i].format, "u") == 0 ? 3 : 2,
+            .n_children   = 0,
+            .buffers      = column->buffers,
+            .children     = NULL,
+            .dictionary   = NULL,
+            .release      = __database_arrow_release_column,
+            .private_data = column};
+        batch->pointers[i] = &batch->children[i];
+        array->n_children++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Gets the private data of a column of a record batch created by
+ *        ::__database_arrow_create_batch.
+ *
+ * @param array Record batch.
+ * @param i     Index of the column.
+ *
+ * @return The column's ::database_arrow_column_t.
+ */
+database_arrow_column_t *__database_arrow_get_column(const struct ArrowArray *array, size_t i) {
+    return array->children[i]->private_data;
+}
+
+/**
+ * @brief Makes a column of a record batch use a buffer of the database, without copying it.
+ *
+ * @param array Record batch.
+ * @param i     Index of the column.
+ * @param data  Values of the column.
+ */
+void __database_arrow_borrow(const struct ArrowArray *array, size_t i, const void *data) {
+    __database_arrow_get_column(array, i)->buffers[1] = data;
+}
+
+/**
+ * @brief Allocates a zeroed buffer for a column of a record batch.
+ *
+ * @param array  Record batch.
+ * @param i      Index of the column.
+ * @param buffer Index of the buffer in the column.
+ * @param size   Number of bytes to allocate.
+ *
+ * @return The allocated buffer, or `NULL` on allocation failure.
+ */
+void *__database_arrow_allocate(const struct ArrowArray *array,
+                                size_t                   i,
+                                size_t                   buffer,
+                                size_t                   size) {
+
+    database_arrow_column_t *const column = __database_arrow_get_column(array, i);
+    void *const                    data   = calloc(max(size, 1), 1);
+    column->owned[buffer]   = data;
+    column->buffers[buffer] = data;
+    return data;
+}
+
+/**
+ * @brief Starts filling a column of strings of a record batch.
+ *
+ * @param strings Where to write the state of the column being filled to.
+ * @param array   Record batch.
+ * @param i       Index of the column.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_arrow_strings_init(database_arrow_strings_t *strings,
+                                  const struct ArrowArray  *array,
+                                  size_t                    i) {
+
+    strings->column   = __database_arrow_get_column(array, i);
+    const size_t offsets_size = sizeof(int32_t) * ((size_t) array->length + 1);
+    strings->offsets  = __database_arrow_allocate(array, i, 1, offsets_size);
+    strings->n        = 0;
+    strings->length   = 0;
+    strings->capacity = DATABASE_ARROW_STRINGS_INITIAL_CAPACITY;
+    return !strings->offsets || !__database_arrow_allocate(array, i, 2, strings->capacity);
+}
+
+/**
+ * @brief Adds a string to the next row of a column of strings.
+ *
+ * @param strings Column being filled, initialized with ::__database_arrow_strings_init.
+ * @param str     String to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure, or too many characters for 32-bit offsets.
+ */
+int __database_arrow_strings_append(database_arrow_strings_t *strings, const char *str) {
+    const size_t length = strlen(str);
+    if (strings->length + length > INT32_MAX)
+        return 1;
+
+    if (strings->length + length > strings->capacity) {
+        size_t new_capacity = strings->capacity;
+        while (new_capacity < strings->length + length)
+            new_capacity *= 2;
+
+        char *const data = realloc(strings->column->owned[2], new_capacity);
+        if (!data)
+            return 1;
+
+        strings->column->owned[2]   = data;
+        strings->column->buffers[2] = data;
+        strings->capacity           = new_capacity;
+    }
+
+    memcpy((char *) strings->column->owned[2] + strings->length, str, length);
+    strings->length                 += length;
+    strings->offsets[++strings->n]   = (int32_t) strings->length;
+    return 0;
+}
+
+/**
+ * @brief   Gets the number of days between the UNIX epoch and a date.
+ * @details Days are counted in the proleptic Gregorian calendar, like Arrow's `date32`.
+ *
+ * @param date Date to convert.
+ *
+ * @return The number of days between `1970/01/01` and @p date.
+ */
+int32_t __database_arrow_date(date_t date) {
+    const int64_t month = date_get_month(date), day = date_get_day(date);
+    const int64_t year  = (int64_t) date_get_year(date) - (month <= 2);
+    const int64_t era   = (year >= 0 ? year : year - 399) / 400;
+
+    const int64_t year_of_era = year - era * 400;
+    const int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int64_t day_of_era =
+        year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return (int32_t) (era * 146097 + day_of_era - 719468);
+}
+
+/**
+ * @brief  Gets the number of seconds between the UNIX epoch and a date and time.
+ * @param  date_and_time Date and time to convert.
+ * @return The number of seconds between `1970/01/01 00:00:00` and @p date_and_time.
+ */
+int64_t __database_arrow_timestamp(date_and_time_t date_and_time) {
+    const daytime_t time = date_and_time_get_time(date_and_time);
+    return (int64_t) __database_arrow_date(date_and_time_get_date(date_and_time)) *
+               DATABASE_ARROW_SECONDS_PER_DAY +
+           daytime_get_hours(time) * 3600 + daytime_get_minutes(time) * 60 +
+           daytime_get_seconds(time);
+}
+
+/**
+ * @brief Sets a bit in an Arrow bitmap (of booleans or of valid values).
+ *
+ * @param bitmap Bitmap to modify, initially zeroed.
+ * @param i      Index of the bit to set.
+ * @param value  Value of the bit.
+ */
+void __database_arrow_set_bit(uint8_t *bitmap, size_t i, int value) {
+    bitmap[i / 8] |= (uint8_t) ((value != 0) << (i % 8));
+}
+
+/**
+ * @brief Fills the columns of an exported table of users.
+ *
+ * @param users Users to be exported.
+ * @param array Record batch created with ::database_arrow_user_fields.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_arrow_fill_users(const user_manager_t *users, const struct ArrowArray *array) {
+    const size_t             n = (size_t) array->length;
+    database_arrow_strings_t ids, names, sexes, passports, countries;
+
+    int retval = __database_arrow_strings_init(&ids, array, DATABASE_ARROW_USER_ID) ||
+                 __database_arrow_strings_init(&names, array, DATABASE_ARROW_USER_NAME) ||
+                 __database_arrow_strings_init(&sexes, array, DATABASE_ARROW_USER_SEX) ||
+                 __database_arrow_strings_init(&passports, array, DATABASE_ARROW_USER_PASSPORT) ||
+                 __database_arrow_strings_init(&countries, array, DATABASE_ARROW_USER_COUNTRY_CODE);
+
+    int32_t *const birth_dates =
+        __database_arrow_allocate(array, DATABASE_ARROW_USER_BIRTH_DATE, 1, sizeof(int32_t) * n);
+    int64_t *const creation_dates = __database_arrow_allocate(array,
+                                                              DATABASE_ARROW_USER_ACCOUNT_CREATION,
+                                                              1,
+                                                              sizeof(int64_t) * n);
+    uint8_t *const active =
+        __database_arrow_allocate(array, DATABASE_ARROW_USER_ACTIVE, 1, (n + 7) / 8);
+    if (retval || !birth_dates || !creation_dates || !active)
+        return 1;
+
+    for (size_t i = 0; i < n && !retval; ++i) {
+        const user_t *const user = user_manager_get_by_ordinal(users, (user_ordinal_t) i);
+
+        char sex[SEX_SPRINTF_MIN_BUFFER_SIZE], country[COUNTRY_CODE_SPRINTF_MIN_BUFFER_SIZE];
+        sex_sprintf(sex, user_get_sex(user));
+        country_code_sprintf(country, user_get_country_code(user));
+
+        retval = __database_arrow_strings_append(&ids, user_get_const_id(user)) ||
+                 __database_arrow_strings_append(&names, user_get_const_name(user)) ||
+                 __database_arrow_strings_append(&sexes, sex) ||
+                 __database_arrow_strings_append(&passports, user_get_const_passport(user)) ||
+                 __database_arrow_strings_append(&countries, country);
+
+        birth_dates[i]    = __database_arrow_date(user_get_birth_date(user));
+        creation_dates[i] = __database_arrow_timestamp(user_get_account_creation_date(user));
+        __database_arrow_set_bit(active,
+                                 i,
+                                 user_get_account_status(user) == ACCOUNT_STATUS_ACTIVE);
+    }
+    return retval;
+}
+
+/**
+ * @brief Fills the columns of an exported table of flights.
+ *
+ * @param flights Flights to be exported.
+ * @param columns Columns of @p flights (see ::flight_manager_get_columns).
+ * @param array   Record batch created with ::database_arrow_flight_fields.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_arrow_fill_flights(const flight_manager_t         *flights,
+                                  const flight_manager_columns_t *columns,
+                                  const struct ArrowArray        *array) {
+
+    const size_t               n       = (size_t) array->length;
+    const string_dictionary_t *strings = flight_manager_get_strings(flights);
+
+    __database_arrow_borrow(array, DATABASE_ARROW_FLIGHT_ID, columns->id);
+    __database_arrow_borrow(array,
+                            DATABASE_ARROW_FLIGHT_NUMBER_OF_PASSENGERS,
+                            columns->number_of_passengers);
+
+    database_arrow_strings_t airlines, models, origins, destinations;
+    int retval =
+        __database_arrow_strings_init(&airlines, array, DATABASE_ARROW_FLIGHT_AIRLINE) ||
+        __database_arrow_strings_init(&models, array, DATABASE_ARROW_FLIGHT_PLANE_MODEL) ||
+        __database_arrow_strings_init(&origins, array, DATABASE_ARROW_FLIGHT_ORIGIN) ||
+        __database_arrow_strings_init(&destinations, array, DATABASE_ARROW_FLIGHT_DESTINATION);
+
+    uint16_t *const total_seats = __database_arrow_allocate(
+        array, DATABASE_ARROW_FLIGHT_TOTAL_SEATS, 1, sizeof(uint16_t) * n);
+    int64_t *const schedule_departures = __database_arrow_allocate(
+        array, DATABASE_ARROW_FLIGHT_SCHEDULE_DEPARTURE_DATE, 1, sizeof(int64_t) * n);
+    int64_t *const schedule_arrivals = __database_arrow_allocate(
+        array, DATABASE_ARROW_FLIGHT_SCHEDULE_ARRIVAL_DATE, 1, sizeof(int64_t) * n);
+    int64_t *const real_departures = __database_arrow_allocate(
+        array, DATABASE_ARROW_FLIGHT_REAL_DEPARTURE_DATE, 1, sizeof(int64_t) * n);
+    if (retval || !total_seats || !schedule_departures || !schedule_arrivals || !real_departures)
+        return 1;
+
+    /* Fields not kept in columns are read from flights, many of them looked up at once */
+    for (size_t begin = 0; begin < n && !retval; begin += DATABASE_ARROW_LOOKUP_BATCH) {
+        const size_t    batch_size = min(n - begin, DATABASE_ARROW_LOOKUP_BATCH);
+        const flight_t *batch[DATABASE_ARROW_LOOKUP_BATCH];
+        flight_manager_get_by_ids(flights, batch_size, columns->id + begin, batch);
+
+        for (size_t j = 0; j < batch_size && !retval; ++j) {
+            const size_t          i      = begin + j;
+            const flight_t *const flight = batch[j];
+            if (!flight)
+                return 1; /* Columns only have valid flights, so this shouldn't happen */
+
+            char origin[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
+            char destination[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
+            airport_code_sprintf(origin, columns->origin[i]);
+            airport_code_sprintf(destination, columns->destination[i]);
+
+            retval =
+                __database_arrow_strings_append(&airlines,
+                                                flight_get_const_airline(strings, flight)) ||
+                __database_arrow_strings_append(&models,
+                                                flight_get_const_plane_model(strings, flight)) ||
+                __database_arrow_strings_append(&origins, origin) ||
+                __database_arrow_strings_append(&destinations, destination);
+
+            total_seats[i] = flight_get_total_seats(flight);
+            schedule_departures[i] =
+                __database_arrow_timestamp(columns->schedule_departure_date[i]);
+            schedule_arrivals[i] =
+                __database_arrow_timestamp(flight_get_schedule_arrival_date(flight));
+            real_departures[i] = __database_arrow_timestamp(columns->real_departure_date[i]);
+        }
+    }
+    return retval;
+}
+
+/**
+ * @brief Fills the columns of an exported table of reservations.
+ *
+ * @param database Database whose reservations are to be exported.
+ * @param columns  Columns of the reservations (see ::reservation_manager_get_columns).
+ * @param array    Record batch created with ::database_arrow_reservation_fields.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __database_arrow_fill_reservations(const database_t                    *database,
+                                       const reservation_manager_columns_t *columns,
+                                       const struct ArrowArray             *array) {
+
+    const size_t                       n            = (size_t) array->length;
+    const user_manager_t *const        users        = database_get_users(database);
+    const reservation_manager_t *const reservations = database_get_reservations(database);
+    const string_dictionary_t *const   hotel_names =
+        reservation_manager_get_hotel_names(reservations);
+
+    __database_arrow_borrow(array, DATABASE_ARROW_RESERVATION_ID, columns->id);
+    __database_arrow_borrow(array, DATABASE_ARROW_RESERVATION_HOTEL_ID, columns->hotel_id);
+    __database_arrow_borrow(array, DATABASE_ARROW_RESERVATION_HOTEL_STARS, columns->hotel_stars);
+    __database_arrow_borrow(array, DATABASE_ARROW_RESERVATION_CITY_TAX, columns->city_tax);
+    __database_arrow_borrow(array,
+                            DATABASE_ARROW_RESERVATION_PRICE_PER_NIGHT,
+                            columns->price_per_night);
+    __database_arrow_borrow(array, DATABASE_ARROW_RESERVATION_RATING, columns->rating);
+
+    database_arrow_strings_t user_ids, names;
+    int retval =
+        __database_arrow_strings_init(&user_ids, array, DATABASE_ARROW_RESERVATION_USER_ID) ||
+        __database_arrow_strings_init(&names, array, DATABASE_ARROW_RESERVATION_HOTEL_NAME);
+
+    int32_t *const begin_dates = __database_arrow_allocate(
+        array, DATABASE_ARROW_RESERVATION_BEGIN_DATE, 1, sizeof(int32_t) * n);
+    int32_t *const end_dates = __database_arrow_allocate(
+        array, DATABASE_ARROW_RESERVATION_END_DATE, 1, sizeof(int32_t) * n);
+    uint8_t *const breakfast = __database_arrow_allocate(
+        array, DATABASE_ARROW_RESERVATION_INCLUDES_BREAKFAST, 1, (n + 7) / 8);
+    uint8_t *const rated =
+        __database_arrow_allocate(array, DATABASE_ARROW_RESERVATION_RATING, 0, (n + 7) / 8);
+    if (retval || !begin_dates || !end_dates || !breakfast || !rated)
+        return 1;
+
+    int64_t unrated = 0;
+    for (size_t i = 0; i < n; ++i) {
+        begin_dates[i] = __database_arrow_date(columns->begin_date[i]);
+        end_dates[i]   = __database_arrow_date(columns->end_date[i]);
+        __database_arrow_set_bit(breakfast,
+                                 i,
+                                 columns->includes_breakfast[i] == INCLUDES_BREAKFAST_TRUE);
+        __database_arrow_set_bit(rated, i, columns->rating[i] != RESERVATION_NO_RATING);
+        unrated += columns->rating[i] == RESERVATION_NO_RATING;
+    }
+    array->children[DATABASE_ARROW_RESERVATION_RATING]->null_count = unrated;
+
+    /* Fields not kept in columns are read from reservations, many of them looked up at once */
+    for (size_t begin = 0; begin < n && !retval; begin += DATABASE_ARROW_LOOKUP_BATCH) {
+        const size_t         batch_size = min(n - begin, DATABASE_ARROW_LOOKUP_BATCH);
+        const reservation_t *batch[DATABASE_ARROW_LOOKUP_BATCH];
+        reservation_manager_get_by_ids(reservations, batch_size, columns->id + begin, batch);
+
+        for (size_t j = 0; j < batch_size && !retval; ++j) {
+            const reservation_t *const reservation = batch[j];
+            if (!reservation)
+                return 1; /* Columns only have valid reservations, so this shouldn't happen */
+
+            const user_t *const user =
+                user_manager_get_by_ordinal(users, reservation_get_user(reservation));
+            retval = !user ||
+                     __database_arrow_strings_append(&user_ids, user_get_const_id(user)) ||
+                     __database_arrow_strings_append(
+                         &names,
+                         reservation_get_const_hotel_name(hotel_names, reservation));
+        }
+    }
+    return retval;
+}
+
+int database_arrow_export(const database_t      *database,
+                          database_arrow_table_t table,
+                          struct ArrowSchema    *schema,
+                          struct ArrowArray     *array) {
+
+    const database_arrow_field_t *fields;
+    size_t                        ncolumns, n;
+    flight_manager_columns_t      flight_columns;
+    reservation_manager_columns_t reservation_columns;
+
+    switch (table) {
+        case DATABASE_ARROW_TABLE_USERS:
+            fields   = database_arrow_user_fields;
+            ncolumns = DATABASE_ARROW_USER_COLUMNS;
+            n        = user_manager_get_length(database_get_users(database));
+            break;
+        case DATABASE_ARROW_TABLE_FLIGHTS:
+            fields   = database_arrow_flight_fields;
+            ncolumns = DATABASE_ARROW_FLIGHT_COLUMNS;
+            if (flight_manager_get_columns(database_get_flights(database), &flight_columns, &n))
+                return 1;
+            break;
+        default:
+            fields   = database_arrow_reservation_fields;
+            ncolumns = DATABASE_ARROW_RESERVATION_COLUMNS;
+            if (reservation_manager_get_columns(database_get_reservations(database),
+                                                &reservation_columns,
+                                                &n))
+                return 1;
+            break;
+    }
+
+    if (__database_arrow_create_schema(fields, ncolumns, schema))
+        return 1;
+    if (__database_arrow_create_batch(fields, ncolumns, n, array))
+        goto DEFER_1;
+
+    int retval;
+    switch (table) {
+        case DATABASE_ARROW_TABLE_USERS:
+            retval = __database_arrow_fill_users(database_get_users(database), array);
+            break;
+        case DATABASE_ARROW_TABLE_FLIGHTS:
+            retval = __database_arrow_fill_flights(database_get_flights(database),
+                                                   &flight_columns,
+                                                   array);
+            break;
+        default:
+            retval = __database_arrow_fill_reservations(database, &reservation_columns, array);
+            break;
+    }
+
+    if (retval)
+        goto DEFER_2;
+    return 0;
+
+DEFER_2:
+    array->release(array);
+DEFER_1:
+    schema->release(schema);
+    return 1;
+}
+
+int database_arrow_write_file(const database_t      *database,
+                              database_arrow_table_t table,
+                              const char            *path) {
+
+    struct ArrowSchema schema;
+    struct ArrowArray  array;
+    if (database_arrow_export(database, table, &schema, &array))
+        return 1;
+
+    const int retval = arrow_write_ipc_file(path, &schema, &array);
+    array.release(&array);
+    schema.release(&schema);
+    return retval;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  database_handle.c
+ * @brief Implementation of methods in include/database/database_handle.h
+ *
+ * ### Example
+ * See [the header file's documentation](@ref database_handle_examples).
+ */
+
+#include <glib.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "database/database_handle.h"
+
+/**
+ * @struct database_reference
+ * @brief  A reference-counted database.
+ *
+ * @var database_reference::database
+ *     @brief Database being referred to.
+ * @var database_reference::references
+ *     @brief Number of readers holding this reference, plus one while it's the current database
+ *            of a ::database_handle_t.
+ */
+struct database_reference {
+    database_t *database;
+    gint        references;
+};
+
+/**
+ * @struct database_handle
+ * @brief  A replaceable database.
+ *
+ * @var database_handle::lock
+ *     @brief Lock that guards ::database_handle::current.
+ * @var database_handle::current
+ *     @brief Reference to the current database. `NULL` when the handle contains no database.
+ */
+struct database_handle {
+    pthread_mutex_t       lock;
+    database_reference_t *current;
+};
+
+database_handle_t *database_handle_create(void) {
+    database_handle_t *const handle = malloc(sizeof(database_handle_t));
+    if (!handle)
+        return NULL;
+
+    if (pthread_mutex_init(&handle->lock, NULL)) {
+        free(handle);
+        return NULL;
+    }
+
+    handle->current = NULL;
+    return handle;
+}
+
+database_reference_t *database_handle_acquire(database_handle_t *handle) {
+    pthread_mutex_lock(&handle->lock);
+    database_reference_t *const reference = handle->current;
+    if (reference)
+        g_atomic_int_inc(&reference->references);
+    pthread_mutex_unlock(&handle->lock);
+
+    return reference;
+}
+
+int database_handle_swap(database_handle_t *handle, database_t *database) {
+    database_reference_t *reference = NULL;
+    if (database) {
+        reference = malloc(sizeof(database_reference_t));
+        if (!reference)
+            return 1;
+
+        reference->database   = database;
+        reference->references = 1;
+    }
+
+    pthread_mutex_lock(&handle->lock);
+    database_reference_t *const old = handle->current;
+    handle->current                 = reference;
+    pthread_mutex_unlock(&handle->lock);
+
+    /* Releasing outside the lock, as freeing a large database may take a while */
+    if (old)
+        database_reference_release(old);
+    return 0;
+}
+
+void database_handle_free(database_handle_t *handle) {
+    if (handle->current)
+        database_reference_release(handle->current);
+
+    pthread_mutex_destroy(&handle->lock);
+    free(handle);
+}
+
+const database_t *database_reference_get(const database_reference_t *reference) {
+    return reference->database;
+}
+
+void database_reference_release(database_reference_t *reference) {
+    if (!g_atomic_int_dec_and_test(&reference->references))
+        return;
+
+    database_free(reference->database);
+    free(reference);
+}
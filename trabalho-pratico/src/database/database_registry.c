@@ -0,0 +1,211 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  database_registry.c
+ * @brief Implementation of methods in include/database/database_registry.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref database_registry_examples).
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+
+#include "database/database_registry.h"
+#include "database/database_snapshot.h"
+
+/**
+ * @struct database_registry_entry_t
+ * @brief  The resident database of a dataset.
+ *
+ * @var database_registry_entry_t::dataset_path
+ *     @brief Path to the dataset's directory, key in ::database_registry::entries.
+ * @var database_registry_entry_t::snapshot_path
+ *     @brief Where to save a snapshot of ::database_registry_entry_t::database to.
+ * @var database_registry_entry_t::fingerprint
+ *     @brief Identifier of the version of the dataset the database was loaded from.
+ * @var database_registry_entry_t::database
+ *     @brief Resident database (may share managers with clones handed out).
+ * @var database_registry_entry_t::memory
+ *     @brief Memory usage of ::database_registry_entry_t::database, when it was last used.
+ * @var database_registry_entry_t::saved
+ *     @brief Whether ::database_registry_entry_t::snapshot_path is up-to-date.
+ * @var database_registry_entry_t::link
+ *     @brief Node of this entry in ::database_registry::lru.
+ */
+typedef struct {
+    char       *dataset_path, *snapshot_path;
+    uint64_t    fingerprint;
+    database_t *database;
+    size_t      memory;
+    int         saved;
+    GList       link;
+} database_registry_entry_t;
+
+/**
+ * @struct database_registry
+ * @brief  Databases of many datasets, kept in memory under a memory budget.
+ *
+ * @var database_registry::entries
+ *     @brief Map from dataset paths to ::database_registry_entry_t.
+ * @var database_registry::lru
+ *     @brief Resident databases, from the most recently used to the least recently used.
+ * @var database_registry::memory
+ *     @brief Sum of ::database_registry_entry_t::memory for all entries.
+ * @var database_registry::memory_budget
+ *     @brief Maximum value of ::database_registry::memory (see ::database_registry_create).
+ */
+struct database_registry {
+    GHashTable *entries;
+    GQueue      lru;
+    size_t      memory, memory_budget;
+};
+
+database_registry_t *database_registry_create(size_t memory_budget) {
+    database_registry_t *const registry = malloc(sizeof(database_registry_t));
+    if (!registry)
+        return NULL;
+
+    registry->entries       = g_hash_table_new(g_str_hash, g_str_equal);
+    registry->memory        = 0;
+    registry->memory_budget = memory_budget;
+    g_queue_init(&registry->lru);
+    return registry;
+}
+
+/**
+ * @brief Removes an entry from a registry.
+ *
+ * @param registry Registry to be modified.
+ * @param entry    Entry in @p registry to be removed and `free`d.
+ * @param save     Whether to save a snapshot of the entry's database first, if needed. Failing to
+ *                 save it isn't an error: the dataset will have to be loaded again.
+ */
+void __database_registry_remove(database_registry_t       *registry,
+                                database_registry_entry_t *entry,
+                                int                        save) {
+
+    if (save && !entry->saved)
+        database_snapshot_save(entry->database, entry->snapshot_path, entry->fingerprint);
+
+    g_hash_table_remove(registry->entries, entry->dataset_path);
+    g_queue_unlink(&registry->lru, &entry->link);
+    registry->memory -= entry->memory;
+
+    database_free(entry->database);
+    g_free(entry->dataset_path);
+    g_free(entry->snapshot_path);
+    free(entry);
+}
+
+/**
+ * @brief Marks an entry as the most recently used one, and evicts others to stay under budget.
+ *
+ * @param registry Registry to be modified.
+ * @param entry    Entry in @p registry that was used.
+ */
+void __database_registry_touch(database_registry_t *registry, database_registry_entry_t *entry) {
+    g_queue_unlink(&registry->lru, &entry->link);
+    g_queue_push_head_link(&registry->lru, &entry->link);
+
+    /* Indices may have been built since the last measurement */
+    registry->memory -= entry->memory;
+    entry->memory     = database_get_memory_usage(entry->database);
+    registry->memory += entry->memory;
+
+    while (registry->memory > registry->memory_budget && g_queue_peek_tail(&registry->lru) != entry)
+        __database_registry_remove(registry, g_queue_peek_tail(&registry->lru), 1);
+}
+
+database_t *database_registry_acquire(database_registry_t *registry,
+                                      const char          *dataset_path,
+                                      const char          *snapshot_path,
+                                      uint64_t             fingerprint) {
+
+    database_registry_entry_t *const entry = g_hash_table_lookup(registry->entries, dataset_path);
+    if (entry) {
+        if (entry->fingerprint == fingerprint) {
+            __database_registry_touch(registry, entry);
+            return database_clone(entry->database);
+        }
+
+        __database_registry_remove(registry, entry, 0); /* Outdated */
+    }
+
+    /* Not resident: reload from the snapshot, if it's up-to-date */
+    database_t *const database = database_snapshot_load(snapshot_path, fingerprint);
+    if (!database)
+        return NULL;
+
+    const int failed =
+        database_registry_add(registry, dataset_path, snapshot_path, fingerprint, database, 1);
+    if (failed)
+        return database; /* Not resident, but still usable */
+
+    database_t *const clone = database_clone(database);
+    database_free(database);
+    return clone;
+}
+
+int database_registry_add(database_registry_t *registry,
+                          const char          *dataset_path,
+                          const char          *snapshot_path,
+                          uint64_t             fingerprint,
+                          const database_t    *database,
+                          int                  saved) {
+
+    database_registry_entry_t *const existing =
+        g_hash_table_lookup(registry->entries, dataset_path);
+    if (existing)
+        __database_registry_remove(registry, existing, 0);
+
+    database_registry_entry_t *const entry = malloc(sizeof(database_registry_entry_t));
+    if (!entry)
+        return 1;
+
+    entry->database = database_clone(database);
+    if (!entry->database) {
+        free(entry);
+        return 1;
+    }
+
+    entry->dataset_path  = g_strdup(dataset_path);
+    entry->snapshot_path = g_strdup(snapshot_path);
+    entry->fingerprint   = fingerprint;
+    entry->memory        = 0;
+    entry->saved         = saved;
+    entry->link.data     = entry;
+    entry->link.prev     = NULL;
+    entry->link.next     = NULL;
+
+    g_queue_push_head_link(&registry->lru, &entry->link);
+    g_hash_table_insert(registry->entries, entry->dataset_path, entry);
+    __database_registry_touch(registry, entry);
+    return 0;
+}
+
+size_t database_registry_get_memory_usage(const database_registry_t *registry) {
+    return registry->memory;
+}
+
+void database_registry_free(database_registry_t *registry) {
+    while (!g_queue_is_empty(&registry->lru))
+        __database_registry_remove(registry, g_queue_peek_head(&registry->lru), 0);
+    g_hash_table_unref(registry->entries);
+    free(registry);
+}
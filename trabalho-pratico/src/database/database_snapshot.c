@@ -0,0 +1,697 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  database_snapshot.c
+ * @brief Implementation of methods in include/database/database_snapshot.h
+ *
+ * @details A snapshot file starts with a ::database_snapshot_header_t, followed by all users,
+ *          flights and reservations, in the order they were added to the database. Then, for every
+ *          user (in the same order), come the identifiers of the flights they travelled in.
+ *          Numbers are stored in the native byte order, and strings are stored with their length
+ *          (including the null terminator) before them, so that they can be used directly from the
+ *          mapped file.
+ *
+ *          Entities are added back to the database in the same order, so that every manager (and
+ *          every list of user relations) ends up exactly like it was when the snapshot was saved.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "database/database_snapshot.h"
+#include "utils/mapped_file.h"
+
+/** @brief Value of ::database_snapshot_header_t::magic. */
+#define DATABASE_SNAPSHOT_MAGIC "LI3SNAP"
+
+/** @brief Version of the snapshot format. Must be incremented on every change to the format. */
+#define DATABASE_SNAPSHOT_VERSION 2
+
+/** @brief Number of characters in each block of the dictionaries used while loading snapshots. */
+#define DATABASE_SNAPSHOT_STRINGS_POOL_BLOCK_CAPACITY 4096
+
+/**
+ * @struct database_snapshot_header_t
+ * @brief  Beginning of a snapshot file.
+ *
+ * @var database_snapshot_header_t::magic
+ *     @brief Always ::DATABASE_SNAPSHOT_MAGIC, to identify snapshot files.
+ * @var database_snapshot_header_t::version
+ *     @brief Version of the format of the file (::DATABASE_SNAPSHOT_VERSION).
+ * @var database_snapshot_header_t::header_size
+ *     @brief   Size of this `struct`.
+ *     @details Detects snapshots created by builds of this program with a different ABI.
+ * @var database_snapshot_header_t::fingerprint
+ *     @brief Identifier of the dataset the snapshot was created from.
+ * @var database_snapshot_header_t::nusers
+ *     @brief Number of users in the snapshot.
+ * @var database_snapshot_header_t::nflights
+ *     @brief Number of flights in the snapshot.
+ * @var database_snapshot_header_t::nreservations
+ *     @brief Number of reservations in the snapshot.
+ */
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t fingerprint;
+    uint64_t nusers, nflights, nreservations;
+} database_snapshot_header_t;
+
+/**
+ * @struct database_snapshot_writer_t
+ * @brief  Data needed while writing a snapshot file.
+ *
+ * @var database_snapshot_writer_t::file
+ *     @brief File being written.
+ * @var database_snapshot_writer_t::users
+ *     @brief Users in the database, to write user identifiers instead of ordinals.
+ * @var database_snapshot_writer_t::flight_strings
+ *     @brief Dictionary of airlines and plane models in the database, to write strings instead of
+ *            codes.
+ * @var database_snapshot_writer_t::hotel_names
+ *     @brief Dictionary of hotel names in the database, to write strings instead of codes.
+ * @var database_snapshot_writer_t::count
+ *     @brief Number of entities written in the current section of the file.
+ */
+typedef struct {
+    FILE                      *file;
+    const user_manager_t      *users;
+    const string_dictionary_t *flight_strings, *hotel_names;
+    uint64_t                   count;
+} database_snapshot_writer_t;
+
+/**
+ * @brief Writes raw data to a snapshot file.
+ *
+ * @param writer Snapshot being written.
+ * @param data   Data to write.
+ * @param size   Number of bytes in @p data.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __database_snapshot_write(database_snapshot_writer_t *writer, const void *data, size_t size) {
+    return fwrite(data, 1, size, writer->file) != size;
+}
+
+/**
+ * @brief Writes a string (and its length) to a snapshot file.
+ *
+ * @param writer Snapshot being written.
+ * @param str    String to write.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __database_snapshot_write_string(database_snapshot_writer_t *writer, const char *str) {
+    const uint32_t length = strlen(str) + 1;
+    return __database_snapshot_write(writer, &length, sizeof(uint32_t)) ||
+           __database_snapshot_write(writer, str, length);
+}
+
+/**
+ * @brief Writes a user to a snapshot file.
+ *
+ * @param writer_data A pointer to a ::database_snapshot_writer_t.
+ * @param user        User to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __database_snapshot_write_user(void *writer_data, const user_t *user) {
+    database_snapshot_writer_t *const writer = writer_data;
+    writer->count++;
+
+    const date_t          birth_date            = user_get_birth_date(user);
+    const date_and_time_t account_creation_date = user_get_account_creation_date(user);
+    const country_code_t  country_code          = user_get_country_code(user);
+    const uint8_t         sex                   = user_get_sex(user);
+    const uint8_t         account_status        = user_get_account_status(user);
+
+    return __database_snapshot_write_string(writer, user_get_const_id(user)) ||
+           __database_snapshot_write_string(writer, user_get_const_name(user)) ||
+           __database_snapshot_write_string(writer, user_get_const_passport(user)) ||
+           __database_snapshot_write(writer, &birth_date, sizeof(date_t)) ||
+           __database_snapshot_write(writer, &account_creation_date, sizeof(date_and_time_t)) ||
+           __database_snapshot_write(writer, &country_code, sizeof(country_code_t)) ||
+           __database_snapshot_write(writer, &sex, sizeof(uint8_t)) ||
+           __database_snapshot_write(writer, &account_status, sizeof(uint8_t));
+}
+
+/**
+ * @brief Writes a flight to a snapshot file.
+ *
+ * @param writer_data A pointer to a ::database_snapshot_writer_t.
+ * @param flight      Flight to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __database_snapshot_write_flight(void *writer_data, const flight_t *flight) {
+    database_snapshot_writer_t *const writer = writer_data;
+    writer->count++;
+
+    const flight_id_t     id                 = flight_get_id(flight);
+    const uint16_t        total_seats        = flight_get_total_seats(flight);
+    const airport_code_t  origin             = flight_get_origin(flight);
+    const airport_code_t  destination        = flight_get_destination(flight);
+    const date_and_time_t schedule_departure = flight_get_schedule_departure_date(flight);
+    const date_and_time_t schedule_arrival   = flight_get_schedule_arrival_date(flight);
+    const date_and_time_t real_departure     = flight_get_real_departure_date(flight);
+
+    const string_dictionary_t *const strings     = writer->flight_strings;
+    const char *const                airline     = flight_get_const_airline(strings, flight);
+    const char *const                plane_model = flight_get_const_plane_model(strings, flight);
+
+    return __database_snapshot_write(writer, &id, sizeof(flight_id_t)) ||
+           __database_snapshot_write_string(writer, airline) ||
+           __database_snapshot_write_string(writer, plane_model) ||
+           __database_snapshot_write(writer, &total_seats, sizeof(uint16_t)) ||
+           __database_snapshot_write(writer, &origin, sizeof(airport_code_t)) ||
+           __database_snapshot_write(writer, &destination, sizeof(airport_code_t)) ||
+           __database_snapshot_write(writer, &schedule_departure, sizeof(date_and_time_t)) ||
+           __database_snapshot_write(writer, &schedule_arrival, sizeof(date_and_time_t)) ||
+           __database_snapshot_write(writer, &real_departure, sizeof(date_and_time_t));
+}
+
+/**
+ * @brief Writes a reservation to a snapshot file.
+ *
+ * @param writer_data A pointer to a ::database_snapshot_writer_t.
+ * @param reservation Reservation to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __database_snapshot_write_reservation(void *writer_data, const reservation_t *reservation) {
+    database_snapshot_writer_t *const writer = writer_data;
+    writer->count++;
+
+    const reservation_id_t id                 = reservation_get_id(reservation);
+    const hotel_id_t       hotel_id           = reservation_get_hotel_id(reservation);
+    const uint8_t          hotel_stars        = reservation_get_hotel_stars(reservation);
+    const uint8_t          city_tax           = reservation_get_city_tax(reservation);
+    const date_t           begin_date         = reservation_get_begin_date(reservation);
+    const date_t           end_date           = reservation_get_end_date(reservation);
+    const uint16_t         price_per_night    = reservation_get_price_per_night(reservation);
+    const uint8_t          includes_breakfast = reservation_get_includes_breakfast(reservation);
+    const uint8_t          rating             = reservation_get_rating(reservation);
+    const user_t *const    user =
+        user_manager_get_by_ordinal(writer->users, reservation_get_user(reservation));
+
+    return __database_snapshot_write(writer, &id, sizeof(reservation_id_t)) ||
+           __database_snapshot_write_string(writer, user_get_const_id(user)) ||
+           __database_snapshot_write(writer, &hotel_id, sizeof(hotel_id_t)) ||
+           __database_snapshot_write_string(
+               writer,
+               reservation_get_const_hotel_name(writer->hotel_names, reservation)) ||
+           __database_snapshot_write(writer, &hotel_stars, sizeof(uint8_t)) ||
+           __database_snapshot_write(writer, &city_tax, sizeof(uint8_t)) ||
+           __database_snapshot_write(writer, &begin_date, sizeof(date_t)) ||
+           __database_snapshot_write(writer, &end_date, sizeof(date_t)) ||
+           __database_snapshot_write(writer, &price_per_night, sizeof(uint16_t)) ||
+           __database_snapshot_write(writer, &includes_breakfast, sizeof(uint8_t)) ||
+           __database_snapshot_write(writer, &rating, sizeof(uint8_t));
+}
+
+/**
+ * @brief Writes the flights a user travelled in (passengers) to a snapshot file.
+ *
+ * @param writer_data A pointer to a ::database_snapshot_writer_t.
+ * @param user        User the flights are associated with. Not used, as users are written in the
+ *                    same order as their flights.
+ * @param flights     Flights @p user travelled in.
+ * @param nflights    Number of elements in @p flights.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __database_snapshot_write_passengers(void              *writer_data,
+                                         const user_t      *user,
+                                         const flight_id_t *flights,
+                                         size_t             nflights) {
+    (void) user;
+    database_snapshot_writer_t *const writer = writer_data;
+
+    const uint32_t n = nflights;
+    if (__database_snapshot_write(writer, &n, sizeof(uint32_t)))
+        return 1;
+
+    return nflights && __database_snapshot_write(writer, flights, sizeof(flight_id_t) * nflights);
+}
+
+int database_snapshot_save(const database_t *database, const char *path, uint64_t fingerprint) {
+    /* Write to a temporary file first, so that a failure never leaves a corrupt snapshot behind */
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, PATH_MAX, "%s.tmp", path) >= PATH_MAX)
+        return 1;
+
+    database_snapshot_writer_t writer = {
+        .file           = fopen(tmp_path, "wb"),
+        .users          = database_get_users(database),
+        .flight_strings = flight_manager_get_strings(database_get_flights(database)),
+        .hotel_names    = reservation_manager_get_hotel_names(database_get_reservations(database)),
+        .count          = 0};
+    if (!writer.file)
+        return 1;
+
+    database_snapshot_header_t header = {.magic       = DATABASE_SNAPSHOT_MAGIC,
+                                         .version     = DATABASE_SNAPSHOT_VERSION,
+                                         .header_size = sizeof(database_snapshot_header_t),
+                                         .fingerprint = fingerprint};
+
+    /* Header is written again when the number of entities is known */
+    if (__database_snapshot_write(&writer, &header, sizeof(database_snapshot_header_t)))
+        goto DEFER_1;
+
+    if (user_manager_iter(database_get_users(database), __database_snapshot_write_user, &writer))
+        goto DEFER_1;
+    header.nusers = writer.count;
+    writer.count  = 0;
+
+    if (flight_manager_iter(database_get_flights(database),
+                            __database_snapshot_write_flight,
+                            &writer))
+        goto DEFER_1;
+    header.nflights = writer.count;
+    writer.count    = 0;
+
+    if (reservation_manager_iter(database_get_reservations(database),
+                                 __database_snapshot_write_reservation,
+                                 &writer))
+        goto DEFER_1;
+    header.nreservations = writer.count;
+
+    if (user_manager_iter_with_flights(database_get_users(database),
+                                       __database_snapshot_write_passengers,
+                                       &writer))
+        goto DEFER_1;
+
+    if (fseek(writer.file, 0, SEEK_SET) ||
+        __database_snapshot_write(&writer, &header, sizeof(database_snapshot_header_t)))
+        goto DEFER_1;
+
+    if (fclose(writer.file)) {
+        remove(tmp_path);
+        return 1;
+    }
+
+    if (rename(tmp_path, path)) {
+        remove(tmp_path);
+        return 1;
+    }
+    return 0;
+
+DEFER_1:
+    fclose(writer.file);
+    remove(tmp_path);
+    return 1;
+}
+
+/**
+ * @struct database_snapshot_reader_t
+ * @brief  Data needed while reading a snapshot file.
+ *
+ * @var database_snapshot_reader_t::contents
+ *     @brief Contents of the snapshot file.
+ * @var database_snapshot_reader_t::size
+ *     @brief Number of bytes in ::database_snapshot_reader_t::contents.
+ * @var database_snapshot_reader_t::offset
+ *     @brief Offset in ::database_snapshot_reader_t::contents of the next item to be read.
+ */
+typedef struct {
+    const char *contents;
+    size_t      size, offset;
+} database_snapshot_reader_t;
+
+/**
+ * @brief Reads raw data from a snapshot file.
+ *
+ * @param reader Snapshot being read.
+ * @param output Where to write the read data to.
+ * @param size   Number of bytes to read.
+ *
+ * @retval 0 Success.
+ * @retval 1 Unexpected end of file.
+ */
+int __database_snapshot_read(database_snapshot_reader_t *reader, void *output, size_t size) {
+    if (size > reader->size - reader->offset)
+        return 1;
+
+    memcpy(output, reader->contents + reader->offset, size);
+    reader->offset += size;
+    return 0;
+}
+
+/**
+ * @brief Reads a string from a snapshot file.
+ *
+ * @param reader Snapshot being read.
+ * @param output Where to write a pointer to the string to. It points to the contents of the
+ *               snapshot file, so it's only valid while the file is mapped.
+ *
+ * @retval 0 Success.
+ * @retval 1 Unexpected end of file or string not null-terminated.
+ */
+int __database_snapshot_read_string(database_snapshot_reader_t *reader, const char **output) {
+    uint32_t length;
+    if (__database_snapshot_read(reader, &length, sizeof(uint32_t)))
+        return 1;
+    if (length == 0 || length > reader->size - reader->offset)
+        return 1;
+
+    const char *const str = reader->contents + reader->offset;
+    if (str[length - 1])
+        return 1;
+
+    reader->offset += length;
+    *output = str;
+    return 0;
+}
+
+/**
+ * @brief Reads users from a snapshot file and adds them to a database.
+ *
+ * @param reader   Snapshot being read.
+ * @param database Where to add the read users to.
+ * @param n        Number of users to read.
+ * @param users    Where to write the ordinal of every user to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Corrupt snapshot or allocation failure.
+ */
+int __database_snapshot_load_users(database_snapshot_reader_t *reader,
+                                   database_t                 *database,
+                                   size_t                      n,
+                                   user_ordinal_t              users[n]) {
+    user_t *const user = user_create(NULL);
+    if (!user)
+        return 1;
+
+    int retval = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const char     *id, *name, *passport;
+        date_t          birth_date;
+        date_and_time_t account_creation_date;
+        country_code_t  country_code;
+        uint8_t         sex, account_status;
+
+        if (__database_snapshot_read_string(reader, &id) ||
+            __database_snapshot_read_string(reader, &name) ||
+            __database_snapshot_read_string(reader, &passport) ||
+            __database_snapshot_read(reader, &birth_date, sizeof(date_t)) ||
+            __database_snapshot_read(reader, &account_creation_date, sizeof(date_and_time_t)) ||
+            __database_snapshot_read(reader, &country_code, sizeof(country_code_t)) ||
+            __database_snapshot_read(reader, &sex, sizeof(uint8_t)) ||
+            __database_snapshot_read(reader, &account_status, sizeof(uint8_t))) {
+
+            retval = 1;
+            break;
+        }
+
+        /* Same order as in the users loader, for date validation to succeed */
+        user_reset_dates(user);
+        if (user_set_id(NULL, user, id) || user_set_name(NULL, user, name) ||
+            user_set_birth_date(user, birth_date) || user_set_passport(NULL, user, passport) ||
+            user_set_account_creation_date(user, account_creation_date)) {
+
+            retval = 1;
+            break;
+        }
+        user_set_sex(user, sex);
+        user_set_country_code(user, country_code);
+        user_set_account_status(user, account_status);
+
+        if (database_add_user(database, user) ||
+            user_manager_get_ordinal(database_get_users(database), id, &users[i])) {
+            retval = 1;
+            break;
+        }
+    }
+
+    user_free(user);
+    return retval;
+}
+
+/**
+ * @brief Reads flights from a snapshot file and adds them to a database.
+ *
+ * @param reader   Snapshot being read.
+ * @param database Where to add the read flights to.
+ * @param n        Number of flights to read.
+ *
+ * @retval 0 Success.
+ * @retval 1 Corrupt snapshot or allocation failure.
+ */
+int __database_snapshot_load_flights(database_snapshot_reader_t *reader,
+                                     database_t                 *database,
+                                     size_t                      n) {
+    string_dictionary_t *const strings =
+        string_dictionary_create(DATABASE_SNAPSHOT_STRINGS_POOL_BLOCK_CAPACITY);
+    if (!strings)
+        return 1;
+
+    flight_t *const flight = flight_create(NULL);
+    if (!flight) {
+        string_dictionary_free(strings);
+        return 1;
+    }
+
+    int retval = 0;
+    for (size_t i = 0; i < n; ++i) {
+        flight_id_t     id;
+        const char     *airline, *plane_model;
+        uint16_t        total_seats;
+        airport_code_t  origin, destination;
+        date_and_time_t schedule_departure, schedule_arrival, real_departure;
+
+        if (__database_snapshot_read(reader, &id, sizeof(flight_id_t)) ||
+            __database_snapshot_read_string(reader, &airline) ||
+            __database_snapshot_read_string(reader, &plane_model) ||
+            __database_snapshot_read(reader, &total_seats, sizeof(uint16_t)) ||
+            __database_snapshot_read(reader, &origin, sizeof(airport_code_t)) ||
+            __database_snapshot_read(reader, &destination, sizeof(airport_code_t)) ||
+            __database_snapshot_read(reader, &schedule_departure, sizeof(date_and_time_t)) ||
+            __database_snapshot_read(reader, &schedule_arrival, sizeof(date_and_time_t)) ||
+            __database_snapshot_read(reader, &real_departure, sizeof(date_and_time_t))) {
+
+            retval = 1;
+            break;
+        }
+
+        /* Passengers are added later, so that they're counted like in the passengers loader */
+        flight_reset_seats(flight);
+        flight_set_number_of_passengers(flight, 0);
+        flight_reset_schedule_dates(flight);
+        flight_set_id(flight, id);
+        flight_set_origin(flight, origin);
+        flight_set_destination(flight, destination);
+        if (flight_set_real_departure_date(flight, real_departure) ||
+            flight_set_airline(strings, flight, airline) ||
+            flight_set_plane_model(strings, flight, plane_model) ||
+            flight_set_total_seats(flight, total_seats) ||
+            flight_set_schedule_departure_date(flight, schedule_departure) ||
+            flight_set_schedule_arrival_date(flight, schedule_arrival) ||
+            database_add_flight(database, strings, flight)) {
+
+            retval = 1;
+            break;
+        }
+    }
+
+    flight_free(flight);
+    string_dictionary_free(strings);
+    return retval;
+}
+
+/**
+ * @brief Reads reservations from a snapshot file and adds them to a database.
+ *
+ * @param reader   Snapshot being read.
+ * @param database Where to add the read reservations to.
+ * @param n        Number of reservations to read.
+ *
+ * @retval 0 Success.
+ * @retval 1 Corrupt snapshot or allocation failure.
+ */
+int __database_snapshot_load_reservations(database_snapshot_reader_t *reader,
+                                          database_t                 *database,
+                                          size_t                      n) {
+    string_dictionary_t *const hotel_names =
+        string_dictionary_create(DATABASE_SNAPSHOT_STRINGS_POOL_BLOCK_CAPACITY);
+    if (!hotel_names)
+        return 1;
+
+    reservation_t *const reservation = reservation_create(NULL);
+    if (!reservation) {
+        string_dictionary_free(hotel_names);
+        return 1;
+    }
+
+    int retval = 0;
+    for (size_t i = 0; i < n; ++i) {
+        reservation_id_t id;
+        const char      *user_id, *hotel_name;
+        user_ordinal_t   user;
+        hotel_id_t       hotel_id;
+        uint8_t          hotel_stars, city_tax, includes_breakfast, rating;
+        date_t           begin_date, end_date;
+        uint16_t         price_per_night;
+
+        if (__database_snapshot_read(reader, &id, sizeof(reservation_id_t)) ||
+            __database_snapshot_read_string(reader, &user_id) ||
+            __database_snapshot_read(reader, &hotel_id, sizeof(hotel_id_t)) ||
+            __database_snapshot_read_string(reader, &hotel_name) ||
+            __database_snapshot_read(reader, &hotel_stars, sizeof(uint8_t)) ||
+            __database_snapshot_read(reader, &city_tax, sizeof(uint8_t)) ||
+            __database_snapshot_read(reader, &begin_date, sizeof(date_t)) ||
+            __database_snapshot_read(reader, &end_date, sizeof(date_t)) ||
+            __database_snapshot_read(reader, &price_per_night, sizeof(uint16_t)) ||
+            __database_snapshot_read(reader, &includes_breakfast, sizeof(uint8_t)) ||
+            __database_snapshot_read(reader, &rating, sizeof(uint8_t)) ||
+            user_manager_get_ordinal(database_get_users(database), user_id, &user)) {
+
+            retval = 1;
+            break;
+        }
+
+        reservation_reset_dates(reservation);
+        reservation_set_id(reservation, id);
+        reservation_set_hotel_id(reservation, hotel_id);
+        reservation_set_city_tax(reservation, city_tax);
+        reservation_set_includes_breakfast(reservation, includes_breakfast);
+        reservation_set_user(reservation, user);
+        if (reservation_set_hotel_name(hotel_names, reservation, hotel_name) ||
+            reservation_set_hotel_stars(reservation, hotel_stars) ||
+            reservation_set_begin_date(reservation, begin_date) ||
+            reservation_set_end_date(reservation, end_date) ||
+            reservation_set_price_per_night(reservation, price_per_night) ||
+            reservation_set_rating(reservation, rating) ||
+            database_add_reservation(database, hotel_names, reservation)) {
+
+            retval = 1;
+            break;
+        }
+    }
+
+    reservation_free(reservation);
+    string_dictionary_free(hotel_names);
+    return retval;
+}
+
+/**
+ * @brief Reads user-flight relations (passengers) from a snapshot file and adds them to a database.
+ *
+ * @param reader   Snapshot being read.
+ * @param database Where to add the read passengers to.
+ * @param n        Number of users in the snapshot.
+ * @param users    Ordinal of every user in the snapshot, in the order they were read.
+ *
+ * @retval 0 Success.
+ * @retval 1 Corrupt snapshot or allocation failure.
+ */
+int __database_snapshot_load_passengers(database_snapshot_reader_t *reader,
+                                        database_t                 *database,
+                                        size_t                      n,
+                                        const user_ordinal_t        users[n]) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t nflights;
+        if (__database_snapshot_read(reader, &nflights, sizeof(uint32_t)))
+            return 1;
+        if (nflights > (reader->size - reader->offset) / sizeof(flight_id_t))
+            return 1;
+
+        /* Lists are prepended to, so add flights in reverse order to get the same list */
+        const char *const flights = reader->contents + reader->offset;
+        for (size_t j = nflights; j > 0; --j) {
+            flight_id_t id;
+            memcpy(&id, flights + (j - 1) * sizeof(flight_id_t), sizeof(flight_id_t));
+
+            if (database_add_passengers(database, id, 1, users + i))
+                return 1;
+        }
+        reader->offset += nflights * sizeof(flight_id_t);
+    }
+
+    return 0;
+}
+
+database_t *database_snapshot_load(const char *path, uint64_t fingerprint) {
+    mapped_file_t *const file = mapped_file_open(path);
+    if (!file)
+        return NULL;
+
+    database_snapshot_reader_t reader = {.contents = mapped_file_get_contents(file),
+                                         .size     = mapped_file_get_size(file),
+                                         .offset   = 0};
+
+    database_snapshot_header_t header;
+    if (__database_snapshot_read(&reader, &header, sizeof(database_snapshot_header_t)))
+        goto DEFER_1;
+
+    if (memcmp(header.magic, DATABASE_SNAPSHOT_MAGIC, sizeof(DATABASE_SNAPSHOT_MAGIC)) ||
+        header.version != DATABASE_SNAPSHOT_VERSION ||
+        header.header_size != sizeof(database_snapshot_header_t) ||
+        header.fingerprint != fingerprint)
+        goto DEFER_1;
+
+    /* Every user takes more than an ordinal in the file, so this allocation is bounded */
+    if (header.nusers > reader.size / sizeof(user_ordinal_t))
+        goto DEFER_1;
+
+    user_ordinal_t *const users = malloc(sizeof(user_ordinal_t) * (header.nusers + 1));
+    if (!users)
+        goto DEFER_1;
+
+    database_t *const database = database_create();
+    if (!database)
+        goto DEFER_2;
+
+    /*
+     * Failing to reserve space isn't an error. Bound the counts, as the header may be corrupt. The
+     * number of passengers isn't stored in the header.
+     */
+    const size_t max_entities = reader.size / sizeof(uint32_t);
+    database_reserve(database,
+                     header.nusers,
+                     header.nflights < max_entities ? header.nflights : max_entities,
+                     header.nreservations < max_entities ? header.nreservations : max_entities,
+                     0);
+
+    if (__database_snapshot_load_users(&reader, database, header.nusers, users) ||
+        __database_snapshot_load_flights(&reader, database, header.nflights) ||
+        __database_snapshot_load_reservations(&reader, database, header.nreservations) ||
+        __database_snapshot_load_passengers(&reader, database, header.nusers, users) ||
+        reader.offset != reader.size)
+        goto DEFER_3;
+
+    free(users);
+    mapped_file_close(file);
+    return database;
+
+DEFER_3:
+    database_free(database);
+DEFER_2:
+    free(users);
+DEFER_1:
+    mapped_file_close(file);
+    return NULL;
+}
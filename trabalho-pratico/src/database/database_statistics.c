@@ -0,0 +1,246 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  database_statistics.c
+ * @brief Implementation of methods in include/database/database_statistics.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref database_statistics_examples).
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+
+#include "database/database_statistics.h"
+#include "utils/int_utils.h"
+
+/**
+ * @struct database_statistics
+ * @brief  Statistics about the contents of a database.
+ *
+ * @var database_statistics::nusers
+ *     @brief Number of users.
+ * @var database_statistics::nflights
+ *     @brief Number of flights.
+ * @var database_statistics::nreservations
+ *     @brief Number of reservations.
+ * @var database_statistics::npassengers
+ *     @brief Number of passengers.
+ * @var database_statistics::airports
+ *     @brief Number of flights (as `GUINT_TO_POINTER`) of each airport (::airport_code_t).
+ * @var database_statistics::hotels
+ *     @brief Number of reservations (as `GUINT_TO_POINTER`) of each hotel (::hotel_id_t).
+ * @var database_statistics::first_user
+ *     @brief Earliest account creation date. Only valid when ::database_statistics::nusers isn't
+ *            `0`.
+ * @var database_statistics::last_user
+ *     @brief Latest account creation date.
+ * @var database_statistics::first_flight
+ *     @brief Earliest scheduled departure date. Only valid when ::database_statistics::nflights
+ *            isn't `0`.
+ * @var database_statistics::last_flight
+ *     @brief Latest scheduled departure date.
+ * @var database_statistics::first_reservation
+ *     @brief Earliest beginning date of a reservation. Only valid when
+ *            ::database_statistics::nreservations isn't `0`.
+ * @var database_statistics::last_reservation
+ *     @brief Latest end date of a reservation.
+ */
+struct database_statistics {
+    size_t nusers, nflights, nreservations, npassengers;
+
+    GHashTable *airports, *hotels;
+
+    date_and_time_t first_user, last_user;
+    date_and_time_t first_flight, last_flight;
+    date_t          first_reservation, last_reservation;
+};
+
+database_statistics_t *database_statistics_create(void) {
+    database_statistics_t *const statistics = malloc(sizeof(database_statistics_t));
+    if (!statistics)
+        return NULL;
+
+    statistics->nusers        = 0;
+    statistics->nflights      = 0;
+    statistics->nreservations = 0;
+    statistics->npassengers   = 0;
+    statistics->airports      = g_hash_table_new(g_direct_hash, g_direct_equal);
+    statistics->hotels        = g_hash_table_new(g_direct_hash, g_direct_equal);
+    return statistics;
+}
+
+/**
+ * @brief Copies an entry of a histogram to another, for `g_hash_table_foreach`.
+ *
+ * @param key       Key of the entry.
+ * @param value     Frequency of @p key.
+ * @param user_data Histogram (`GHashTable`) where to copy the entry to.
+ */
+void __database_statistics_copy_entry(gpointer key, gpointer value, gpointer user_data) {
+    g_hash_table_insert(user_data, key, value);
+}
+
+database_statistics_t *database_statistics_clone(const database_statistics_t *statistics) {
+    database_statistics_t *const clone = malloc(sizeof(database_statistics_t));
+    if (!clone)
+        return NULL;
+
+    *clone          = *statistics;
+    clone->airports = g_hash_table_new(g_direct_hash, g_direct_equal);
+    clone->hotels   = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    g_hash_table_foreach(statistics->airports, __database_statistics_copy_entry, clone->airports);
+    g_hash_table_foreach(statistics->hotels, __database_statistics_copy_entry, clone->hotels);
+    return clone;
+}
+
+/**
+ * @brief Increments the frequency of a key in a histogram.
+ *
+ * @param histogram Histogram (::database_statistics::airports or ::database_statistics::hotels).
+ * @param key       Key whose frequency is to be incremented.
+ */
+void __database_statistics_count(GHashTable *histogram, guint key) {
+    const guint frequency = GPOINTER_TO_UINT(g_hash_table_lookup(histogram, GUINT_TO_POINTER(key)));
+    g_hash_table_insert(histogram, GUINT_TO_POINTER(key), GUINT_TO_POINTER(frequency + 1));
+}
+
+void database_statistics_add_user(database_statistics_t *statistics, const user_t *user) {
+    const date_and_time_t date = user_get_account_creation_date(user);
+    statistics->first_user     = statistics->nusers ? min(statistics->first_user, date) : date;
+    statistics->last_user      = statistics->nusers ? max(statistics->last_user, date) : date;
+    statistics->nusers++;
+}
+
+void database_statistics_add_flight(database_statistics_t *statistics, const flight_t *flight) {
+    const date_and_time_t date = flight_get_schedule_departure_date(flight);
+    statistics->first_flight   = statistics->nflights ? min(statistics->first_flight, date) : date;
+    statistics->last_flight    = statistics->nflights ? max(statistics->last_flight, date) : date;
+    statistics->nflights++;
+
+    __database_statistics_count(statistics->airports, flight_get_origin(flight));
+    __database_statistics_count(statistics->airports, flight_get_destination(flight));
+}
+
+void database_statistics_add_reservation(database_statistics_t *statistics,
+                                         const reservation_t   *reservation) {
+    const date_t begin = reservation_get_begin_date(reservation);
+    const date_t end   = reservation_get_end_date(reservation);
+    if (statistics->nreservations) {
+        statistics->first_reservation = min(statistics->first_reservation, begin);
+        statistics->last_reservation  = max(statistics->last_reservation, end);
+    } else {
+        statistics->first_reservation = begin;
+        statistics->last_reservation  = end;
+    }
+    statistics->nreservations++;
+
+    __database_statistics_count(statistics->hotels, reservation_get_hotel_id(reservation));
+}
+
+void database_statistics_add_passengers(database_statistics_t *statistics, size_t npassengers) {
+    statistics->npassengers += npassengers;
+}
+
+size_t database_statistics_get_user_count(const database_statistics_t *statistics) {
+    return statistics->nusers;
+}
+
+size_t database_statistics_get_flight_count(const database_statistics_t *statistics) {
+    return statistics->nflights;
+}
+
+size_t database_statistics_get_reservation_count(const database_statistics_t *statistics) {
+    return statistics->nreservations;
+}
+
+size_t database_statistics_get_passenger_count(const database_statistics_t *statistics) {
+    return statistics->npassengers;
+}
+
+double database_statistics_get_associations_per_user(const database_statistics_t *statistics) {
+    if (!statistics->nusers)
+        return 0.0;
+    return (double) (statistics->npassengers + statistics->nreservations) /
+           (double) statistics->nusers;
+}
+
+size_t database_statistics_get_airport_count(const database_statistics_t *statistics) {
+    return g_hash_table_size(statistics->airports);
+}
+
+size_t database_statistics_get_airport_frequency(const database_statistics_t *statistics,
+                                                 airport_code_t               airport) {
+    return GPOINTER_TO_UINT(g_hash_table_lookup(statistics->airports, GUINT_TO_POINTER(airport)));
+}
+
+size_t database_statistics_get_hotel_count(const database_statistics_t *statistics) {
+    return g_hash_table_size(statistics->hotels);
+}
+
+size_t database_statistics_get_hotel_frequency(const database_statistics_t *statistics,
+                                               hotel_id_t                   hotel) {
+    return GPOINTER_TO_UINT(g_hash_table_lookup(statistics->hotels, GUINT_TO_POINTER(hotel)));
+}
+
+int database_statistics_get_user_dates(const database_statistics_t *statistics,
+                                       date_and_time_t             *first,
+                                       date_and_time_t             *last) {
+    if (!statistics->nusers)
+        return 1;
+
+    *first = statistics->first_user;
+    *last  = statistics->last_user;
+    return 0;
+}
+
+int database_statistics_get_flight_dates(const database_statistics_t *statistics,
+                                         date_and_time_t             *first,
+                                         date_and_time_t             *last) {
+    if (!statistics->nflights)
+        return 1;
+
+    *first = statistics->first_flight;
+    *last  = statistics->last_flight;
+    return 0;
+}
+
+int database_statistics_get_reservation_dates(const database_statistics_t *statistics,
+                                              date_t                      *first,
+                                              date_t                      *last) {
+    if (!statistics->nreservations)
+        return 1;
+
+    *first = statistics->first_reservation;
+    *last  = statistics->last_reservation;
+    return 0;
+}
+
+size_t database_statistics_get_memory_usage(const database_statistics_t *statistics) {
+    /* Estimate of the size of a GHashTable entry: key, value and cached hash */
+    const size_t nentries =
+        g_hash_table_size(statistics->airports) + g_hash_table_size(statistics->hotels);
+    return sizeof(database_statistics_t) + nentries * (2 * sizeof(gpointer) + sizeof(guint));
+}
+
+void database_statistics_free(database_statistics_t *statistics) {
+    g_hash_table_unref(statistics->airports);
+    g_hash_table_unref(statistics->hotels);
+    free(statistics);
+}
@@ -23,10 +23,128 @@
  */
 
 #include <glib.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "database/flight_manager.h"
+#include "utils/cancellation.h"
+#include "utils/glib/GConstPtrArray.h"
+#include "utils/id_hash_table.h"
+#include "utils/id_map.h"
+#include "utils/prefetch.h"
+#include "utils/int_utils.h"
+#include "utils/parallel_for.h"
+#include "utils/prefix_index.h"
+#include "utils/radix_sort.h"
+
+/**
+ * @struct  flight_manager_departures_index_t
+ * @brief   Index of flights by origin and scheduled departure date, for range lookups.
+ * @details Built when it's first needed, and discarded when flights are added or invalidated.
+ *
+ * @var flight_manager_departures_index_t::lock
+ *     @brief Lock that protects the index from being built by multiple threads.
+ * @var flight_manager_departures_index_t::flights
+ *     @brief All valid flights, sorted by origin, and then in the order described in
+ *            ::flight_manager_iter_origin_departures. Flights from the same airport are
+ *            contiguous. `NULL` when the index isn't built.
+ * @var flight_manager_departures_index_t::routes
+ *     @brief All valid flights, sorted by origin, destination, and then in the order described in
+ *            ::flight_manager_iter_route_departures. Flights in the same route are contiguous.
+ *            `NULL` until needed.
+ * @var flight_manager_departures_index_t::airports
+ *     @brief Codes of all origin and destination airports, for
+ *            ::flight_manager_iter_airport_prefix. `NULL` until needed.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    GConstPtrArray *flights;
+    GConstPtrArray *routes;
+    prefix_index_t *airports;
+} flight_manager_departures_index_t;
+
+/**
+ * @struct  flight_manager_columns_zone_t
+ * @brief   Summary of a block of rows in a ::flight_manager_columns_index_t (a zone map), so that
+ *          blocks that can't match a date-bounded iteration are skipped without being read.
+ *
+ * @var flight_manager_columns_zone_t::min_departure
+ *     @brief Earliest scheduled departure date in the block.
+ * @var flight_manager_columns_zone_t::max_departure
+ *     @brief Latest scheduled departure date in the block.
+ */
+typedef struct {
+    date_t min_departure, max_departure;
+} flight_manager_columns_zone_t;
+
+/**
+ * @struct  flight_manager_columns_index_t
+ * @brief   Some fields of all valid flights, stored column by column.
+ * @details Built when it's first needed, and discarded when flights are added, modified or
+ *          invalidated. Rows are partitioned by the month of their scheduled departure date, so
+ *          that iterations bounded by dates only go through the partitions they need.
+ *
+ * @var flight_manager_columns_index_t::lock
+ *     @brief Lock that protects the columns from being built by multiple threads.
+ * @var flight_manager_columns_index_t::built
+ *     @brief Whether the columns are up-to-date.
+ * @var flight_manager_columns_index_t::id
+ *     @brief Identifier of every flight.
+ * @var flight_manager_columns_index_t::origin
+ *     @brief Origin airport of every flight.
+ * @var flight_manager_columns_index_t::destination
+ *     @brief Destination airport of every flight.
+ * @var flight_manager_columns_index_t::origin_ordinal
+ *     @brief Index of the origin airport of every flight in
+ *            ::flight_manager_columns_index_t::airports.
+ * @var flight_manager_columns_index_t::destination_ordinal
+ *     @brief Index of the destination airport of every flight in
+ *            ::flight_manager_columns_index_t::airports.
+ * @var flight_manager_columns_index_t::airports
+ *     @brief   All distinct airports of flights, in alphabetical order.
+ *     @details Airport codes are made of three ASCII letters, so there are at most `26 ^ 3`
+ *              airports, and their indices fit in a `uint16_t`.
+ * @var flight_manager_columns_index_t::nairports
+ *     @brief Number of elements in ::flight_manager_columns_index_t::airports.
+ * @var flight_manager_columns_index_t::schedule_departure_date
+ *     @brief Scheduled departure date of every flight.
+ * @var flight_manager_columns_index_t::real_departure_date
+ *     @brief Real departure date of every flight.
+ * @var flight_manager_columns_index_t::number_of_passengers
+ *     @brief Number of passengers of every flight.
+ * @var flight_manager_columns_index_t::n
+ *     @brief Number of flights (of elements in each column).
+ * @var flight_manager_columns_index_t::partitions
+ *     @brief   Index of the first row of every month, from
+ *              ::flight_manager_columns_index_t::first_month onwards.
+ *     @details Has ::flight_manager_columns_index_t::npartitions `+ 1` elements, the last one
+ *              being ::flight_manager_columns_index_t::n.
+ * @var flight_manager_columns_index_t::first_month
+ *     @brief Earliest month (see ::date_generate_dayless) of a scheduled departure date.
+ * @var flight_manager_columns_index_t::npartitions
+ *     @brief Number of months between the earliest and latest scheduled departure dates.
+ * @var flight_manager_columns_index_t::zones
+ *     @brief Summary of every block of ::FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY rows.
+ */
+typedef struct {
+    pthread_mutex_t  lock;
+    int              built;
+    flight_id_t     *id;
+    airport_code_t  *origin, *destination;
+    uint16_t        *origin_ordinal, *destination_ordinal;
+    airport_code_t  *airports;
+    size_t           nairports;
+    date_and_time_t *schedule_departure_date, *real_departure_date;
+    uint16_t        *number_of_passengers;
+    size_t           n;
+    size_t          *partitions;
+    uint32_t         first_month;
+    size_t           npartitions;
+
+    flight_manager_columns_zone_t *zones;
+} flight_manager_columns_index_t;
 
 /**
  * @struct flight_manager
@@ -35,14 +153,24 @@
  * @var flight_manager::flights
  *     @brief Allocator for flights in the manager.
  * @var flight_manager::strings
- *     @brief Allocator for strings in the manager.
+ *     @brief Dictionary of the airlines and plane models of flights in the manager.
  * @var flight_manager::id_flights_rel
- *     @brief Hash table for ::flight_id_t -> ::flight_t mapping.
+ *     @brief Map for ::flight_id_t -> ::flight_t mapping.
+ * @var flight_manager::departures_index
+ *     @brief Index of flights for ::flight_manager_iter_origin_departures.
+ * @var flight_manager::columns
+ *     @brief Columns of flight fields for ::flight_manager_iter_columns.
+ * @var flight_manager::ninvalid
+ *     @brief   Number of invalidated flights still in ::flight_manager::flights.
+ *     @details When `0`, iterations don't need to check for the validity of every flight.
  */
 struct flight_manager {
-    pool_t                      *flights;
-    string_pool_no_duplicates_t *strings;
-    GHashTable                  *id_flights_rel;
+    pool_t                            *flights;
+    string_dictionary_t               *strings;
+    id_map_t                          *id_flights_rel;
+    flight_manager_departures_index_t *departures_index;
+    flight_manager_columns_index_t    *columns;
+    size_t                             ninvalid;
 };
 
 /** @brief Number of flights in each block of ::flight_manager::flights. */
@@ -51,27 +179,105 @@ struct flight_manager {
 /** @brief Number of characters in each block of ::flight_manager::strings. */
 #define FLIGHT_MANAGER_STRINGS_POOL_BLOCK_CAPACITY 100000
 
+/** @brief Maximum number of flights in each block provided by ::flight_manager_iter_columns. */
+#define FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY 4096
+
 flight_manager_t *flight_manager_create(void) {
     flight_manager_t *const manager = malloc(sizeof(flight_manager_t));
     if (!manager)
-        return NULL;
+        goto DEFER_1;
 
-    manager->flights =
-        pool_create_from_size(flight_sizeof(), FLIGHT_MANAGER_FLIGHTS_POOL_BLOCK_CAPACITY);
-    if (!manager->flights) {
-        free(manager);
-        return NULL;
-    }
+    manager->flights = pool_create_from_size_with_policy(flight_sizeof(),
+                                                         FLIGHT_MANAGER_FLIGHTS_POOL_BLOCK_CAPACITY,
+                                                         BLOCK_ALLOCATOR_POLICY_HUGE_PAGES);
+    if (!manager->flights)
+        goto DEFER_2;
 
-    manager->strings = string_pool_no_duplicates_create(FLIGHT_MANAGER_STRINGS_POOL_BLOCK_CAPACITY);
-    if (!manager->strings) {
-        pool_free(manager->flights);
-        free(manager);
-        return NULL;
-    }
+    manager->strings = string_dictionary_create(FLIGHT_MANAGER_STRINGS_POOL_BLOCK_CAPACITY);
+    if (!manager->strings)
+        goto DEFER_3;
+
+    manager->departures_index = malloc(sizeof(flight_manager_departures_index_t));
+    if (!manager->departures_index)
+        goto DEFER_4;
+
+    if (pthread_mutex_init(&manager->departures_index->lock, NULL))
+        goto DEFER_5;
+    manager->departures_index->flights  = NULL;
+    manager->departures_index->routes   = NULL;
+    manager->departures_index->airports = NULL;
+
+    manager->columns = malloc(sizeof(flight_manager_columns_index_t));
+    if (!manager->columns)
+        goto DEFER_6;
 
-    manager->id_flights_rel = g_hash_table_new(g_direct_hash, g_direct_equal);
+    if (pthread_mutex_init(&manager->columns->lock, NULL))
+        goto DEFER_7;
+    manager->columns->built                   = 0;
+    manager->columns->id                      = NULL;
+    manager->columns->origin                  = NULL;
+    manager->columns->destination             = NULL;
+    manager->columns->origin_ordinal          = NULL;
+    manager->columns->destination_ordinal     = NULL;
+    manager->columns->airports                = NULL;
+    manager->columns->nairports               = 0;
+    manager->columns->schedule_departure_date = NULL;
+    manager->columns->real_departure_date     = NULL;
+    manager->columns->number_of_passengers    = NULL;
+    manager->columns->n                       = 0;
+    manager->columns->partitions              = NULL;
+    manager->columns->first_month             = 0;
+    manager->columns->npartitions             = 0;
+    manager->columns->zones                   = NULL;
+
+    manager->id_flights_rel = id_map_create();
+    if (!manager->id_flights_rel)
+        goto DEFER_8;
+
+    manager->ninvalid = 0;
     return manager;
+
+DEFER_8:
+    pthread_mutex_destroy(&manager->columns->lock);
+DEFER_7:
+    free(manager->columns);
+DEFER_6:
+    pthread_mutex_destroy(&manager->departures_index->lock);
+DEFER_5:
+    free(manager->departures_index);
+DEFER_4:
+    string_dictionary_free(manager->strings);
+DEFER_3:
+    pool_free(manager->flights);
+DEFER_2:
+    free(manager);
+DEFER_1:
+    return NULL;
+}
+
+/**
+ * @struct flight_manager_clone_callback_data_t
+ * @brief  Type of `user_data` parameter in ::__flight_manager_clone_callback.
+ *
+ * @var flight_manager_clone_callback_data_t::clone
+ *     @brief Manager where to add flights to.
+ * @var flight_manager_clone_callback_data_t::strings
+ *     @brief Dictionary of the manager being cloned.
+ */
+typedef struct {
+    flight_manager_t *const          clone;
+    const string_dictionary_t *const strings;
+} flight_manager_clone_callback_data_t;
+
+/**
+ * @brief  Callback for ::flight_manager_iter that adds every flight to a clone of a manager.
+ * @param  user_data A pointer to a ::flight_manager_clone_callback_data_t.
+ * @param  flight    Flight to be added to the clone.
+ * @return The value returned by ::flight_manager_add_flight.
+ */
+int __flight_manager_clone_callback(void *user_data, const flight_t *flight) {
+    const flight_manager_clone_callback_data_t *const data = user_data;
+    return flight_manager_add_flight(data->clone, data->strings, flight);
 }
 
 flight_manager_t *flight_manager_clone(const flight_manager_t *manager) {
@@ -79,9 +285,9 @@ flight_manager_t *flight_manager_clone(const flight_manager_t *manager) {
     if (!clone)
         return NULL;
 
-    if (flight_manager_iter(manager,
-                            (flight_manager_iter_callback_t) flight_manager_add_flight,
-                            clone)) {
+    flight_manager_clone_callback_data_t data = {.clone = clone, .strings = manager->strings};
+    if (flight_manager_reserve(clone, id_map_get_length(manager->id_flights_rel)) ||
+        flight_manager_iter(manager, __flight_manager_clone_callback, &data)) {
 
         flight_manager_free(clone);
         return NULL;
@@ -90,14 +296,78 @@ flight_manager_t *flight_manager_clone(const flight_manager_t *manager) {
     return clone;
 }
 
-int flight_manager_add_flight(flight_manager_t *manager, const flight_t *flight) {
-    flight_t *const pool_flight = flight_clone(manager->flights, manager->strings, flight);
+/**
+ * @brief Discards a flight manager's index of departures, so that it's built again when needed.
+ * @param manager Manager whose index is no longer valid.
+ */
+void __flight_manager_invalidate_departures_index(flight_manager_t *manager) {
+    flight_manager_departures_index_t *const index = manager->departures_index;
+    if (index->flights) {
+        g_const_ptr_array_unref(index->flights);
+        index->flights = NULL;
+    }
+    if (index->routes) {
+        g_const_ptr_array_unref(index->routes);
+        index->routes = NULL;
+    }
+    if (index->airports) {
+        prefix_index_free(index->airports);
+        index->airports = NULL;
+    }
+}
+
+/**
+ * @brief Discards a flight manager's columns, so that they're built again when needed.
+ * @param columns Columns (::flight_manager::columns) that are no longer valid.
+ */
+void __flight_manager_invalidate_columns(flight_manager_columns_index_t *columns) {
+    if (!columns->built)
+        return;
+
+    free(columns->id);
+    free(columns->origin);
+    free(columns->destination);
+    free(columns->origin_ordinal);
+    free(columns->destination_ordinal);
+    free(columns->airports);
+    free(columns->schedule_departure_date);
+    free(columns->real_departure_date);
+    free(columns->number_of_passengers);
+    free(columns->partitions);
+    free(columns->zones);
+    columns->id                      = NULL;
+    columns->origin                  = NULL;
+    columns->destination             = NULL;
+    columns->origin_ordinal          = NULL;
+    columns->destination_ordinal     = NULL;
+    columns->airports                = NULL;
+    columns->nairports               = 0;
+    columns->schedule_departure_date = NULL;
+    columns->real_departure_date     = NULL;
+    columns->number_of_passengers    = NULL;
+    columns->n                       = 0;
+    columns->partitions              = NULL;
+    columns->first_month             = 0;
+    columns->npartitions             = 0;
+    columns->zones                   = NULL;
+    columns->built                   = 0;
+}
+
+int flight_manager_add_flight(flight_manager_t          *manager,
+                              const string_dictionary_t *strings,
+                              const flight_t            *flight) {
+    flight_t *const pool_flight = flight_clone(manager->flights, manager->strings, strings, flight);
     if (!pool_flight)
         return 1;
+    __flight_manager_invalidate_departures_index(manager);
+    __flight_manager_invalidate_columns(manager->columns);
 
     flight_id_t flight_id = flight_get_id(flight);
-    if (!g_hash_table_insert(manager->id_flights_rel, GUINT_TO_POINTER(flight_id), pool_flight)) {
+    const int   inserted  = id_map_insert(manager->id_flights_rel, flight_id, pool_flight);
+    if (inserted == 1)
+        return 1;
 
+    if (inserted == 2) {
         /* Do not fatally fail (just print a warning). Show must go on. */
         char id_str[FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE];
         flight_id_sprintf(id_str, flight_id);
@@ -107,25 +377,161 @@ int flight_manager_add_flight(flight_manager_t *manager, const flight_t *flight)
     return 0;
 }
 
+int flight_manager_reserve(flight_manager_t *manager, size_t n) {
+    const size_t length = id_map_get_length(manager->id_flights_rel);
+    return id_map_reserve(manager->id_flights_rel, n) ||
+           pool_reserve(manager->flights, n > length ? n - length : 0);
+}
+
+/**
+ * @struct flight_manager_remove_invalid_data_t
+ * @brief  Type of `user_data` parameter in ::__flight_manager_remove_invalid_callback.
+ *
+ * @var flight_manager_remove_invalid_data_t::manager
+ *     @brief Manager whose flights are being moved.
+ * @var flight_manager_remove_invalid_data_t::flights
+ *     @brief Pool where flights are moved to.
+ * @var flight_manager_remove_invalid_data_t::moved
+ *     @brief Flights already moved to ::flight_manager_remove_invalid_data_t::flights, that
+ *            ::flight_manager::id_flights_rel must point to.
+ * @var flight_manager_remove_invalid_data_t::nmoved
+ *     @brief Number of elements in ::flight_manager_remove_invalid_data_t::moved.
+ */
+typedef struct {
+    flight_manager_t *const manager;
+    pool_t *const           flights;
+    flight_t **const        moved;
+    size_t                  nmoved;
+} flight_manager_remove_invalid_data_t;
+
+/**
+ * @brief  Callback for ::flight_manager_iter that moves a valid flight to a new pool.
+ * @param  user_data A pointer to a ::flight_manager_remove_invalid_data_t.
+ * @param  flight    Flight to be moved.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __flight_manager_remove_invalid_callback(void *user_data, const flight_t *flight) {
+    flight_manager_remove_invalid_data_t *const data    = user_data;
+    flight_manager_t *const                     manager = data->manager;
+
+    flight_t *const moved = flight_clone(data->flights, manager->strings, manager->strings, flight);
+    if (!moved)
+        return 1;
+
+    /* Flights whose identifiers were repeated are kept, but they can't be looked up */
+    if (id_map_lookup(manager->id_flights_rel, flight_get_id(flight)) == flight)
+        data->moved[data->nmoved++] = moved;
+    return 0;
+}
+
+/**
+ * @brief   Removes invalidated flights from a manager's pool, so that they aren't iterated over.
+ * @details Valid flights are moved to a new pool, in the same order.
+ *
+ * @param manager Flight manager to remove invalidated flights from.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p manager is left unchanged).
+ */
+int __flight_manager_remove_invalid(flight_manager_t *manager) {
+    if (!manager->ninvalid)
+        return 0;
+
+    const size_t     n      = id_map_get_length(manager->id_flights_rel);
+    flight_t **const moved  = malloc(n * sizeof(flight_t *));
+    int              retval = 1;
+    if (!moved)
+        return 1;
+
+    pool_t *const flights =
+        pool_create_from_size_with_policy(flight_sizeof(),
+                                          FLIGHT_MANAGER_FLIGHTS_POOL_BLOCK_CAPACITY,
+                                          BLOCK_ALLOCATOR_POLICY_HUGE_PAGES);
+    if (!flights)
+        goto DEFER_1;
+
+    flight_manager_remove_invalid_data_t data = {.manager = manager,
+                                                 .flights = flights,
+                                                 .moved   = moved,
+                                                 .nmoved  = 0};
+    if (pool_reserve(flights, n) ||
+        flight_manager_iter(manager, __flight_manager_remove_invalid_callback, &data)) {
+
+        pool_free(flights);
+        goto DEFER_1;
+    }
+
+    /* Replacing identifiers that are already in the map doesn't allocate */
+    for (size_t i = 0; i < data.nmoved; ++i)
+        id_map_insert(manager->id_flights_rel, flight_get_id(moved[i]), moved[i]);
+
+    __flight_manager_invalidate_departures_index(manager);
+    __flight_manager_invalidate_columns(manager->columns);
+    pool_free(manager->flights);
+    manager->flights  = flights;
+    manager->ninvalid = 0;
+    retval            = 0;
+
+DEFER_1:
+    free(moved);
+    return retval;
+}
+
+int flight_manager_shrink_to_fit(flight_manager_t *manager) {
+    const int retval = __flight_manager_remove_invalid(manager);
+    pool_shrink_to_fit(manager->flights);
+    return id_map_shrink_to_fit(manager->id_flights_rel) || retval;
+}
+
 int flight_manager_add_passagers(flight_manager_t *manager, flight_id_t id, int count) {
-    flight_t *const flight = g_hash_table_lookup(manager->id_flights_rel, GUINT_TO_POINTER(id));
+    flight_t *const flight = id_map_lookup(manager->id_flights_rel, id);
     if (!flight)
         return 1;
 
+    __flight_manager_invalidate_columns(manager->columns);
     return flight_set_number_of_passengers(flight, flight_get_number_of_passengers(flight) + count);
 }
 
 const flight_t *flight_manager_get_by_id(const flight_manager_t *manager, flight_id_t id) {
-    return g_hash_table_lookup(manager->id_flights_rel, GUINT_TO_POINTER(id));
+    return id_map_lookup(manager->id_flights_rel, id);
+}
+
+void flight_manager_get_by_ids(const flight_manager_t *manager,
+                               size_t                  n,
+                               const flight_id_t       ids[n],
+                               const flight_t         *flights[n]) {
+    for (size_t begin = 0; begin < n; begin += PREFETCH_BATCH_SIZE) {
+        const size_t batch = n - begin < PREFETCH_BATCH_SIZE ? n - begin : PREFETCH_BATCH_SIZE;
+
+        void *values[PREFETCH_BATCH_SIZE];
+        id_map_lookup_batch(manager->id_flights_rel, batch, ids + begin, values);
+        for (size_t i = 0; i < batch; ++i) {
+            prefetch_read(values[i]);
+            flights[begin + i] = values[i];
+        }
+    }
+}
+
+size_t flight_manager_get_length(const flight_manager_t *manager) {
+    return id_map_get_length(manager->id_flights_rel);
+}
+
+const string_dictionary_t *flight_manager_get_strings(const flight_manager_t *manager) {
+    return manager->strings;
 }
 
 int flight_manager_invalidate_by_id(flight_manager_t *manager, flight_id_t id) {
-    flight_t *const flight = g_hash_table_lookup(manager->id_flights_rel, GUINT_TO_POINTER(id));
+    flight_t *const flight = id_map_lookup(manager->id_flights_rel, id);
     if (!flight)
         return 1;
 
     flight_invalidate(flight);
-    g_hash_table_remove(manager->id_flights_rel, GUINT_TO_POINTER(id));
+    __flight_manager_invalidate_departures_index(manager);
+    __flight_manager_invalidate_columns(manager->columns);
+    id_map_remove(manager->id_flights_rel, id);
+    manager->ninvalid++;
     return 0;
 }
 
@@ -137,10 +543,13 @@ int flight_manager_invalidate_by_id(flight_manager_t *manager, flight_id_t id) {
  *     @brief Callback to be called for every valid flight.
  * @var flight_manager_iter_flight_data_t::original_user_data.
  *     @brief `user_data` parameter for every ::flight_manager_iter_flight_data_t::callback.
+ * @var flight_manager_iter_flight_data_t::check_validity
+ *     @brief Whether the pool may contain invalidated flights (see ::flight_manager::ninvalid).
  */
 typedef struct {
     const flight_manager_iter_callback_t callback;
     void *const                          original_user_data;
+    const int                            check_validity;
 } flight_manager_iter_flight_data_t;
 
 /**
@@ -154,10 +563,9 @@ typedef struct {
  * @return The return value of the target callback, or `0` for filtered-out items.
  */
 int __flight_manager_iter_callback(void *user_data, const void *item) {
-    if (flight_is_valid((const flight_t *) item) == 0) {
-        const flight_manager_iter_flight_data_t *const helper_data = user_data;
+    const flight_manager_iter_flight_data_t *const helper_data = user_data;
+    if (!helper_data->check_validity || flight_is_valid((const flight_t *) item) == 0)
         return helper_data->callback(helper_data->original_user_data, (const flight_t *) item);
-    }
 
     return 0;
 }
@@ -167,13 +575,1265 @@ int flight_manager_iter(const flight_manager_t        *manager,
                         void                          *user_data) {
 
     flight_manager_iter_flight_data_t helper_data = {.callback           = callback,
-                                                     .original_user_data = user_data};
+                                                     .original_user_data = user_data,
+                                                     .check_validity     = manager->ninvalid != 0};
     return pool_iter(manager->flights, __flight_manager_iter_callback, &helper_data);
 }
 
+/**
+ * @struct flight_manager_iter_blocks_data_t
+ * @brief  Internal data type for the `user_data` parameter in
+ *         ::__flight_manager_iter_blocks_callback.
+ *
+ * @var flight_manager_iter_blocks_data_t::callback
+ *     @brief Callback to be called for every group of valid flights.
+ * @var flight_manager_iter_blocks_data_t::original_user_data.
+ *     @brief `user_data` parameter for every ::flight_manager_iter_blocks_data_t::callback.
+ * @var flight_manager_iter_blocks_data_t::check_validity
+ *     @brief   Whether the pool may contain invalidated flights (see ::flight_manager::ninvalid).
+ *     @details If it can't, blocks are passed to ::flight_manager_iter_blocks_data_t::callback
+ *              without being copied.
+ */
+typedef struct {
+    flight_manager_iter_blocks_callback_t callback;
+    void                                 *original_user_data;
+    int                                   check_validity;
+} flight_manager_iter_blocks_data_t;
+
+/**
+ * @brief   Callback for every group of items in the flight manager's pool.
+ * @details Auxiliary function for ::flight_manager_iter_blocks and
+ *          ::flight_manager_iter_blocks_parallel. Makes sure the target callback is only called
+ *          for valid flights.
+ *
+ * @param user_data A pointer to a ::flight_manager_iter_blocks_data_t.
+ * @param items     Pointers to ::flight_t's in a manager's pool.
+ * @param n         Number of elements in @p items.
+ *
+ * @return The return value of the target callback, or `0` if all items are filtered out.
+ */
+int __flight_manager_iter_blocks_callback(void *user_data, const void *const *items, size_t n) {
+    const flight_manager_iter_blocks_data_t *const helper_data = user_data;
+    if (!helper_data->check_validity)
+        return helper_data->callback(helper_data->original_user_data,
+                                     (const flight_t *const *) items,
+                                     n);
+
+    const flight_t *valid[POOL_ITER_POINTERS_CAPACITY];
+    size_t          nvalid = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (flight_is_valid(items[i]) == 0)
+            valid[nvalid++] = items[i];
+
+    if (!nvalid)
+        return 0;
+    return helper_data->callback(helper_data->original_user_data, valid, nvalid);
+}
+
+int flight_manager_iter_blocks(const flight_manager_t                *manager,
+                               flight_manager_iter_blocks_callback_t callback,
+                               void                                  *user_data) {
+
+    flight_manager_iter_blocks_data_t helper_data = {.callback           = callback,
+                                                     .original_user_data = user_data,
+                                                     .check_validity     = manager->ninvalid != 0};
+    return pool_iter_pointers(manager->flights,
+                              __flight_manager_iter_blocks_callback,
+                              &helper_data);
+}
+
+int flight_manager_iter_blocks_parallel(const flight_manager_t                *manager,
+                                        size_t                                nthreads,
+                                        flight_manager_iter_blocks_callback_t callback,
+                                        void *const                           *user_data) {
+    if (nthreads == 0)
+        nthreads = 1;
+
+    flight_manager_iter_blocks_data_t helper_data[nthreads];
+    void                             *helper_data_pointers[nthreads];
+    for (size_t i = 0; i < nthreads; ++i) {
+        helper_data[i] =
+            (flight_manager_iter_blocks_data_t){.callback           = callback,
+                                                .original_user_data = user_data[i],
+                                                .check_validity     = manager->ninvalid != 0};
+        helper_data_pointers[i] = &helper_data[i];
+    }
+
+    return pool_iter_pointers_parallel(manager->flights,
+                                       nthreads,
+                                       __flight_manager_iter_blocks_callback,
+                                       helper_data_pointers);
+}
+
+/**
+ * @struct flight_manager_columns_build_t
+ * @brief  Data for the iterations through all flights in ::__flight_manager_build_columns.
+ *
+ * @var flight_manager_columns_build_t::columns
+ *     @brief Columns being built.
+ * @var flight_manager_columns_build_t::last_month
+ *     @brief Latest month (see ::date_generate_dayless) of a scheduled departure date.
+ * @var flight_manager_columns_build_t::cursors
+ *     @brief Next free row of every partition of ::flight_manager_columns_build_t::columns.
+ */
+typedef struct {
+    flight_manager_columns_index_t *columns;
+    uint32_t                        last_month;
+    size_t                         *cursors;
+} flight_manager_columns_build_t;
+
+/**
+ * @brief Gets the month of a flight's scheduled departure date, which its partition is chosen by.
+ * @param flight Flight to get the month of.
+ * @return The month of @p flight (see ::date_generate_dayless).
+ */
+uint32_t __flight_manager_get_partition_month(const flight_t *flight) {
+    const date_and_time_t departure = flight_get_schedule_departure_date(flight);
+    return date_generate_dayless(date_and_time_get_date(departure));
+}
+
+/**
+ * @brief   Counts a flight and widens the range of months of the columns being built.
+ * @details Auxiliary method for ::__flight_manager_build_columns.
+ *
+ * @param user_data A pointer to a ::flight_manager_columns_build_t.
+ * @param flight    Flight to be counted.
+ *
+ * @retval 0 Always successful.
+ */
+int __flight_manager_build_columns_bounds_callback(void *user_data, const flight_t *flight) {
+    flight_manager_columns_build_t *const build = user_data;
+    const uint32_t                        month = __flight_manager_get_partition_month(flight);
+
+    build->columns->n++;
+    build->columns->first_month = min(build->columns->first_month, month);
+    build->last_month           = max(build->last_month, month);
+    return 0;
+}
+
+/**
+ * @brief   Counts a flight in the partition of its month.
+ * @details Auxiliary method for ::__flight_manager_build_columns.
+ *
+ * @param user_data A pointer to a ::flight_manager_columns_index_t, whose
+ *                  ::flight_manager_columns_index_t::partitions are being counted (offset by one).
+ * @param flight    Flight to be counted.
+ *
+ * @retval 0 Always successful.
+ */
+int __flight_manager_build_columns_count_callback(void *user_data, const flight_t *flight) {
+    flight_manager_columns_index_t *const columns = user_data;
+    columns->partitions[__flight_manager_get_partition_month(flight) - columns->first_month + 1]++;
+    return 0;
+}
+
+/**
+ * @brief   Copies the fields of a flight to the next free row of its partition.
+ * @details Auxiliary method for ::__flight_manager_build_columns.
+ *
+ * @param user_data A pointer to a ::flight_manager_columns_build_t.
+ * @param flight    Flight whose fields are to be copied.
+ *
+ * @retval 0 Always successful.
+ */
+int __flight_manager_build_columns_fill_callback(void *user_data, const flight_t *flight) {
+    flight_manager_columns_build_t *const build   = user_data;
+    flight_manager_columns_index_t *const columns = build->columns;
+    const size_t                          i =
+        build->cursors[__flight_manager_get_partition_month(flight) - columns->first_month]++;
+
+    columns->id[i]                      = flight_get_id(flight);
+    columns->origin[i]                  = flight_get_origin(flight);
+    columns->destination[i]             = flight_get_destination(flight);
+    columns->schedule_departure_date[i] = flight_get_schedule_departure_date(flight);
+    columns->real_departure_date[i]     = flight_get_real_departure_date(flight);
+    columns->number_of_passengers[i]    = flight_get_number_of_passengers(flight);
+    return 0;
+}
+
+/**
+ * @brief   Summarizes every block of rows of a flight manager's columns.
+ * @details Auxiliary method for ::__flight_manager_build_columns.
+ *
+ * @param columns Columns (::flight_manager::columns), already filled, with allocated
+ *                ::flight_manager_columns_index_t::zones.
+ */
+void __flight_manager_build_column_zones(flight_manager_columns_index_t *columns) {
+    for (size_t offset = 0; offset < columns->n; offset += FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY) {
+        const size_t end = min(columns->n, offset + FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY);
+
+        flight_manager_columns_zone_t zone = {.min_departure = UINT32_MAX, .max_departure = 0};
+        for (size_t i = offset; i < end; ++i) {
+            const date_t departure = date_and_time_get_date(columns->schedule_departure_date[i]);
+            zone.min_departure     = min(zone.min_departure, departure);
+            zone.max_departure     = max(zone.max_departure, departure);
+        }
+        columns->zones[offset / FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY] = zone;
+    }
+}
+
+/**
+ * @brief   Comparison function for `qsort`ing airport codes alphabetically.
+ * @details Auxiliary method for ::__flight_manager_build_column_airports.
+ *
+ * @param a Pointer to a `const` ::airport_code_t.
+ * @param b Pointer to a `const` ::airport_code_t.
+ *
+ * @return Comparison value between @p a and @p b.
+ */
+int __flight_manager_airport_code_compare(const void *a, const void *b) {
+    char a_str[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
+    char b_str[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
+    airport_code_sprintf(a_str, *(const airport_code_t *) a);
+    airport_code_sprintf(b_str, *(const airport_code_t *) b);
+    return strcmp(a_str, b_str);
+}
+
+/**
+ * @brief   Builds the dictionary of airports of a flight manager's columns, and numbers the
+ *          airports of every flight with it.
+ * @details Auxiliary method for ::__flight_manager_build_columns. Airports are hashed only here,
+ *          so that per-airport aggregations of column-wise iterations can be indexed by
+ *          ::flight_manager_columns_t::origin_ordinal.
+ *
+ * @param columns Columns (::flight_manager::columns), already filled, with allocated
+ *                ::flight_manager_columns_index_t::origin_ordinal and
+ *                ::flight_manager_columns_index_t::destination_ordinal.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __flight_manager_build_column_airports(flight_manager_columns_index_t *columns) {
+    id_hash_table_t *const ordinals = id_hash_table_create(0);
+    if (!ordinals)
+        return 1;
+
+    const airport_code_t *const codes[2]    = {columns->origin, columns->destination};
+    uint16_t *const             numbered[2] = {columns->origin_ordinal,
+                                               columns->destination_ordinal};
+
+    /* Find all distinct airports (consecutive flights often share them) */
+    size_t         capacity = 0;
+    airport_code_t last     = 0; /* Not a valid airport code */
+    for (size_t side = 0; side < 2; ++side) {
+        for (size_t i = 0; i < columns->n; ++i) {
+            const airport_code_t code = codes[side][i];
+            if (code == last || id_hash_table_lookup(ordinals, code))
+                continue;
+            last = code;
+
+            if (columns->nairports == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+
+                airport_code_t *const resized =
+                    realloc(columns->airports, capacity * sizeof(airport_code_t));
+                if (!resized)
+                    goto DEFER_1;
+                columns->airports = resized;
+            }
+
+            columns->airports[columns->nairports++] = code;
+            if (id_hash_table_insert(ordinals, code, (void *) 1) == 1)
+                goto DEFER_1;
+        }
+    }
+
+    /* Number airports alphabetically, so that ordinals don't depend on the order of flights */
+    qsort(columns->airports,
+          columns->nairports,
+          sizeof(airport_code_t),
+          __flight_manager_airport_code_compare);
+    for (size_t i = 0; i < columns->nairports; ++i)
+        id_hash_table_insert(ordinals, columns->airports[i], (void *) (uintptr_t) (i + 1));
+
+    for (size_t side = 0; side < 2; ++side) {
+        uint16_t ordinal = 0;
+        last             = 0;
+        for (size_t i = 0; i < columns->n; ++i) {
+            const airport_code_t code = codes[side][i];
+            if (code != last) {
+                ordinal = (uint16_t) ((uintptr_t) id_hash_table_lookup(ordinals, code) - 1);
+                last    = code;
+            }
+            numbered[side][i] = ordinal;
+        }
+    }
+
+    id_hash_table_free(ordinals);
+    return 0;
+
+DEFER_1:
+    id_hash_table_free(ordinals);
+    return 1;
+}
+
+/**
+ * @brief   Builds the columns of a flight manager, if they aren't built yet.
+ * @details Flights are sorted by the month of their scheduled departure date with a counting
+ *          sort, so that flights in the same month keep the order of the manager.
+ *
+ * @param manager Manager whose ::flight_manager::columns are to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __flight_manager_build_columns(const flight_manager_t *manager) {
+    flight_manager_columns_index_t *const columns = manager->columns;
+    if (columns->built)
+        return 0;
+
+    const cancellation_t *const cancellation = cancellation_suspend();
+
+    flight_manager_columns_build_t build = {.columns = columns, .last_month = 0, .cursors = NULL};
+    columns->n           = 0;
+    columns->first_month = UINT32_MAX;
+    flight_manager_iter(manager, __flight_manager_build_columns_bounds_callback, &build);
+
+    const size_t n       = columns->n;
+    const size_t nblocks = (n + FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY - 1) /
+                           FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY;
+    columns->npartitions = n ? build.last_month - columns->first_month + 1 : 0;
+
+    /* Always allocate at least one element, so that NULL only means failure */
+    columns->id                      = malloc(sizeof(flight_id_t) * (n + 1));
+    columns->origin                  = malloc(sizeof(airport_code_t) * (n + 1));
+    columns->destination             = malloc(sizeof(airport_code_t) * (n + 1));
+    columns->origin_ordinal          = malloc(sizeof(uint16_t) * (n + 1));
+    columns->destination_ordinal     = malloc(sizeof(uint16_t) * (n + 1));
+    columns->schedule_departure_date = malloc(sizeof(date_and_time_t) * (n + 1));
+    columns->real_departure_date     = malloc(sizeof(date_and_time_t) * (n + 1));
+    columns->number_of_passengers    = malloc(sizeof(uint16_t) * (n + 1));
+    columns->partitions              = calloc(columns->npartitions + 1, sizeof(size_t));
+    columns->zones                   = malloc(sizeof(*columns->zones) * (nblocks + 1));
+    build.cursors                    = malloc(sizeof(size_t) * (columns->npartitions + 1));
+    columns->built                   = 1;
+
+    if (!columns->id || !columns->origin || !columns->destination || !columns->origin_ordinal ||
+        !columns->destination_ordinal || !columns->schedule_departure_date ||
+        !columns->real_departure_date ||
+        !columns->number_of_passengers || !columns->partitions || !columns->zones ||
+        !build.cursors) {
+
+        free(build.cursors);
+        __flight_manager_invalidate_columns(columns);
+        cancellation_set_current(cancellation);
+        return 1;
+    }
+
+    flight_manager_iter(manager, __flight_manager_build_columns_count_callback, columns);
+    for (size_t i = 0; i < columns->npartitions; ++i) {
+        columns->partitions[i + 1] += columns->partitions[i];
+        build.cursors[i] = columns->partitions[i];
+    }
+
+    flight_manager_iter(manager, __flight_manager_build_columns_fill_callback, &build);
+    free(build.cursors);
+    __flight_manager_build_column_zones(columns);
+    if (__flight_manager_build_column_airports(columns)) {
+        __flight_manager_invalidate_columns(columns);
+        cancellation_set_current(cancellation);
+        return 1;
+    }
+
+    cancellation_set_current(cancellation);
+    return 0;
+}
+
+/**
+ * @brief   Gets the rows of the partitions of a flight manager's columns that contain a range of
+ *          scheduled departure dates.
+ *
+ * @param columns   Columns (::flight_manager::columns), already built.
+ * @param begin     Earliest scheduled departure date (inclusive).
+ * @param end       Latest scheduled departure date (inclusive).
+ * @param first_row Where to write the index of the first row in the range to.
+ * @param last_row  Where to write the index of the row after the last one in the range to.
+ */
+void __flight_manager_get_partition_rows(const flight_manager_columns_index_t *columns,
+                                         date_t                                begin,
+                                         date_t                                end,
+                                         size_t                               *first_row,
+                                         size_t                               *last_row) {
+
+    const uint32_t begin_month = date_generate_dayless(begin);
+    const uint32_t end_month   = date_generate_dayless(end);
+
+    const size_t first = begin_month <= columns->first_month
+                             ? 0
+                             : min(begin_month - columns->first_month, columns->npartitions);
+    const size_t last  = end_month < columns->first_month
+                             ? 0
+                             : min(end_month - columns->first_month + 1, columns->npartitions);
+
+    *first_row = columns->partitions[first];
+    *last_row  = columns->partitions[max(first, last)];
+}
+
+/**
+ * @struct flight_manager_columns_range_t
+ * @brief  A range of rows of a flight manager's columns to be iterated through, block by block.
+ *
+ * @var flight_manager_columns_range_t::columns
+ *     @brief Columns being iterated through.
+ * @var flight_manager_columns_range_t::first_row
+ *     @brief Index of the first row in the range.
+ * @var flight_manager_columns_range_t::last_row
+ *     @brief Index of the row after the last one in the range.
+ * @var flight_manager_columns_range_t::bounded
+ *     @brief   Whether blocks outside ::flight_manager_columns_range_t::begin and
+ *              ::flight_manager_columns_range_t::end can be skipped.
+ *     @details See ::flight_manager_columns_index_t::zones.
+ * @var flight_manager_columns_range_t::begin
+ *     @brief Earliest scheduled departure date (inclusive) of the flights that are needed.
+ * @var flight_manager_columns_range_t::end
+ *     @brief Latest scheduled departure date (inclusive) of the flights that are needed.
+ * @var flight_manager_columns_range_t::callback
+ *     @brief Method called for every block in the range (or in a thread's part of it).
+ * @var flight_manager_columns_range_t::user_data
+ *     @brief `user_data` parameter for every callback.
+ */
+typedef struct {
+    const flight_manager_columns_index_t  *columns;
+    size_t                                 first_row, last_row;
+    int                                    bounded;
+    date_t                                 begin, end;
+    flight_manager_iter_columns_callback_t callback;
+    void                                  *user_data;
+} flight_manager_columns_range_t;
+
+/**
+ * @brief   Gets the number of blocks in a range of rows of a flight manager's columns.
+ * @details Blocks are aligned to ::FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY rows from the beginning
+ *          of the columns (so that each one has a ::flight_manager_columns_zone_t), and the first
+ *          and last blocks are cut short by the range.
+ *
+ * @param range Range of rows.
+ *
+ * @return The number of blocks in @p range.
+ */
+size_t __flight_manager_columns_range_get_nblocks(const flight_manager_columns_range_t *range) {
+    if (range->last_row <= range->first_row)
+        return 0;
+
+    return (range->last_row + FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY - 1) /
+               FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY -
+           range->first_row / FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY;
+}
+
+/**
+ * @brief Calls a callback for some blocks of a range of a flight manager's columns.
+ *
+ * @param range Range of rows of the columns, with the callback to be called.
+ * @param begin Index of the first block, from the beginning of @p range.
+ * @param end   Index of the block after the last one.
+ *
+ * @return The return value of the last-called callback.
+ */
+int __flight_manager_iter_columns_range(const flight_manager_columns_range_t *range,
+                                        size_t                                begin,
+                                        size_t                                end) {
+
+    const flight_manager_columns_index_t *const columns = range->columns;
+    const size_t first_block = range->first_row / FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY;
+
+    for (size_t i = begin; i < end; ++i) {
+        if (cancellation_check())
+            return CANCELLATION_ITER_RET;
+
+        const size_t                               block_index = first_block + i;
+        const flight_manager_columns_zone_t *const zone        = &columns->zones[block_index];
+        if (range->bounded &&
+            (zone->max_departure < range->begin || zone->min_departure > range->end))
+            continue;
+
+        const size_t block_start = block_index * FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY;
+        const size_t offset      = max(range->first_row, block_start);
+        const size_t n =
+            min(range->last_row, block_start + FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY) - offset;
+
+        const flight_manager_columns_t block = {
+            .id                      = columns->id + offset,
+            .origin                  = columns->origin + offset,
+            .destination             = columns->destination + offset,
+            .origin_ordinal          = columns->origin_ordinal + offset,
+            .destination_ordinal     = columns->destination_ordinal + offset,
+            .airports                = columns->airports,
+            .nairports               = columns->nairports,
+            .schedule_departure_date = columns->schedule_departure_date + offset,
+            .real_departure_date     = columns->real_departure_date + offset,
+            .number_of_passengers    = columns->number_of_passengers + offset};
+
+        const int retval = range->callback(range->user_data, &block, n);
+        if (retval)
+            return retval;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Builds the columns of a flight manager (if needed) and returns them.
+ * @details Auxiliary method for all column-wise iterations.
+ *
+ * @param manager Manager to get the columns from.
+ *
+ * @return The columns of @p manager, or `NULL` on allocation failure.
+ */
+const flight_manager_columns_index_t *
+    __flight_manager_get_columns(const flight_manager_t *manager) {
+    flight_manager_columns_index_t *const columns = manager->columns;
+
+    pthread_mutex_lock(&columns->lock);
+    const int failure = __flight_manager_build_columns(manager);
+    pthread_mutex_unlock(&columns->lock);
+    return failure ? NULL : columns;
+}
+
+/**
+ * @brief Iterates through a range of rows of a flight manager's columns, in the calling thread.
+ *
+ * @param range Range of rows of the columns, with the callback to be called.
+ *
+ * @return The return value of the last-called callback.
+ */
+int __flight_manager_iter_columns_rows(const flight_manager_columns_range_t *range) {
+    return __flight_manager_iter_columns_range(range,
+                                               0,
+                                               __flight_manager_columns_range_get_nblocks(range));
+}
+
+/**
+ * @brief   Iterates through some blocks of a range of a flight manager's columns.
+ * @details Auxiliary method for ::__flight_manager_iter_columns_rows_parallel, called in each
+ *          thread.
+ *
+ * @param user_data A pointer to a ::flight_manager_columns_range_t.
+ * @param begin     Index of the first block.
+ * @param end       Index of the block after the last one.
+ *
+ * @return The return value of the last-called callback.
+ */
+int __flight_manager_iter_columns_range_callback(void *user_data, size_t begin, size_t end) {
+    return __flight_manager_iter_columns_range(user_data, begin, end);
+}
+
+/**
+ * @brief Iterates through a range of rows of a flight manager's columns, split across threads.
+ *
+ * @param range     Range of rows of the columns, with the callback to be called.
+ *                  ::flight_manager_columns_range_t::user_data isn't used.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param user_data Array of @p nthreads pointers, one for the callbacks of each thread.
+ *
+ * @return The first non-zero value returned by the last callback of a thread, or `0` on success.
+ */
+int __flight_manager_iter_columns_rows_parallel(const flight_manager_columns_range_t *range,
+                                                size_t                                nthreads,
+                                                void *const                          *user_data) {
+    if (nthreads == 0)
+        nthreads = 1;
+
+    flight_manager_columns_range_t data[nthreads];
+    void                          *data_pointers[nthreads];
+    for (size_t i = 0; i < nthreads; ++i) {
+        data[i]           = *range;
+        data[i].user_data = user_data[i];
+        data_pointers[i]  = &data[i];
+    }
+
+    return parallel_for(__flight_manager_columns_range_get_nblocks(range),
+                        nthreads,
+                        __flight_manager_iter_columns_range_callback,
+                        data_pointers);
+}
+
+/**
+ * @brief   Creates the range of rows of a flight manager's columns to be iterated through.
+ * @details Auxiliary method for all public column-wise iterations.
+ *
+ * @param columns   Columns (::flight_manager::columns), already built.
+ * @param dates     Range of two scheduled departure dates (inclusive) the flights must be in, or
+ *                  `NULL` for all flights to be iterated through.
+ * @param callback  Method called for every block of flights in the range.
+ * @param user_data Argument passed to @p callback.
+ *
+ * @return The range of rows of @p columns.
+ */
+flight_manager_columns_range_t
+    __flight_manager_columns_range_create(const flight_manager_columns_index_t  *columns,
+                                          const date_t                          *dates,
+                                          flight_manager_iter_columns_callback_t callback,
+                                          void                                  *user_data) {
+
+    flight_manager_columns_range_t range = {.columns   = columns,
+                                            .first_row = 0,
+                                            .last_row  = columns->n,
+                                            .bounded   = dates != NULL,
+                                            .begin     = dates ? dates[0] : 0,
+                                            .end       = dates ? dates[1] : 0,
+                                            .callback  = callback,
+                                            .user_data = user_data};
+    if (dates)
+        __flight_manager_get_partition_rows(columns,
+                                            dates[0],
+                                            dates[1],
+                                            &range.first_row,
+                                            &range.last_row);
+    return range;
+}
+
+int flight_manager_iter_columns(const flight_manager_t                *manager,
+                                flight_manager_iter_columns_callback_t callback,
+                                void                                  *user_data) {
+
+    const flight_manager_columns_index_t *const columns = __flight_manager_get_columns(manager);
+    if (!columns)
+        return 1;
+
+    const flight_manager_columns_range_t range =
+        __flight_manager_columns_range_create(columns, NULL, callback, user_data);
+    return __flight_manager_iter_columns_rows(&range);
+}
+
+int flight_manager_iter_columns_parallel(const flight_manager_t                *manager,
+                                         size_t                                 nthreads,
+                                         flight_manager_iter_columns_callback_t callback,
+                                         void *const                           *user_data) {
+
+    const flight_manager_columns_index_t *const columns = __flight_manager_get_columns(manager);
+    if (!columns)
+        return 1;
+
+    const flight_manager_columns_range_t range =
+        __flight_manager_columns_range_create(columns, NULL, callback, NULL);
+    return __flight_manager_iter_columns_rows_parallel(&range, nthreads, user_data);
+}
+
+int flight_manager_iter_columns_between(const flight_manager_t                *manager,
+                                        date_t                                 begin,
+                                        date_t                                 end,
+                                        flight_manager_iter_columns_callback_t callback,
+                                        void                                  *user_data) {
+
+    const flight_manager_columns_index_t *const columns = __flight_manager_get_columns(manager);
+    if (!columns)
+        return 1;
+
+    const date_t                         dates[2] = {begin, end};
+    const flight_manager_columns_range_t range =
+        __flight_manager_columns_range_create(columns, dates, callback, user_data);
+    return __flight_manager_iter_columns_rows(&range);
+}
+
+int flight_manager_iter_columns_between_parallel(const flight_manager_t                *manager,
+                                                 date_t                                 begin,
+                                                 date_t                                 end,
+                                                 size_t                                 nthreads,
+                                                 flight_manager_iter_columns_callback_t callback,
+                                                 void *const                           *user_data) {
+
+    const flight_manager_columns_index_t *const columns = __flight_manager_get_columns(manager);
+    if (!columns)
+        return 1;
+
+    const date_t                         dates[2] = {begin, end};
+    const flight_manager_columns_range_t range =
+        __flight_manager_columns_range_create(columns, dates, callback, NULL);
+    return __flight_manager_iter_columns_rows_parallel(&range, nthreads, user_data);
+}
+
+int flight_manager_get_columns(const flight_manager_t   *manager,
+                               flight_manager_columns_t *columns,
+                               size_t                   *n) {
+
+    const flight_manager_columns_index_t *const index = __flight_manager_get_columns(manager);
+    if (!index)
+        return 1;
+
+    columns->id                      = index->id;
+    columns->origin                  = index->origin;
+    columns->destination             = index->destination;
+    columns->origin_ordinal          = index->origin_ordinal;
+    columns->destination_ordinal     = index->destination_ordinal;
+    columns->airports                = index->airports;
+    columns->nairports               = index->nairports;
+    columns->schedule_departure_date = index->schedule_departure_date;
+    columns->real_departure_date     = index->real_departure_date;
+    columns->number_of_passengers    = index->number_of_passengers;
+    *n                               = index->n;
+    return 0;
+}
+
+/**
+ * @brief   Adds a flight to the array of flights in a departures index being built.
+ * @details Auxiliary method for ::__flight_manager_build_departures_index.
+ *
+ * @param user_data A ::GConstPtrArray of flights.
+ * @param flight    Flight to be added to @p user_data.
+ *
+ * @retval 0 Always successful.
+ */
+int __flight_manager_build_departures_index_callback(void *user_data, const flight_t *flight) {
+    g_const_ptr_array_add(user_data, flight);
+    return 0;
+}
+
+/**
+ * @brief   Function that gets the key flights are grouped by in an array of a
+ *          ::flight_manager_departures_index_t.
+ * @details Flights are sorted by this key, and then by scheduled departure date.
+ *
+ * @param flight Flight to get the key of.
+ *
+ * @return The key of @p flight.
+ */
+typedef uint64_t (*flight_manager_departures_key_t)(const flight_t *flight);
+
+/**
+ * @brief  Gets the key of a flight in ::flight_manager_departures_index_t::flights.
+ * @param  flight Flight to get the key of.
+ * @return The origin of @p flight.
+ */
+uint64_t __flight_manager_origin_key(const flight_t *flight) {
+    return flight_get_origin(flight);
+}
+
+/**
+ * @brief  Gets the key of a flight in ::flight_manager_departures_index_t::routes.
+ * @param  flight Flight to get the key of.
+ * @return The origin of @p flight in the most significant bits, and its destination in the least
+ *         significant ones.
+ */
+uint64_t __flight_manager_route_key(const flight_t *flight) {
+    return (uint64_t) flight_get_origin(flight) << 32 | flight_get_destination(flight);
+}
+
+/**
+ * @brief   Comparison function for sorting flights in a ::flight_manager_departures_index_t.
+ * @details Auxiliary method for ::__flight_manager_build_departures_index. Flights are sorted by
+ *          their key, from the latest to the earliest scheduled departure date, and then by
+ *          identifier.
+ *
+ * @param a   A pointer to a pointer to a ::flight_t.
+ * @param b   A pointer to a pointer to a ::flight_t.
+ * @param key Function that gets the key flights are grouped by.
+ *
+ * @return The comparison result between @p a and @p b.
+ */
+gint __flight_manager_departures_compare(const void *const              *a,
+                                         const void *const              *b,
+                                         flight_manager_departures_key_t key) {
+    const flight_t *const flight_a = *(const flight_t *const *) a;
+    const flight_t *const flight_b = *(const flight_t *const *) b;
+
+    const uint64_t key_a = key(flight_a);
+    const uint64_t key_b = key(flight_b);
+    if (key_a != key_b)
+        return key_a < key_b ? -1 : 1;
+
+    const int64_t crit2 = date_and_time_diff(flight_get_schedule_departure_date(flight_b),
+                                             flight_get_schedule_departure_date(flight_a));
+    if (crit2)
+        return crit2 < 0 ? -1 : 1;
+
+    const flight_id_t id_a = flight_get_id(flight_a);
+    const flight_id_t id_b = flight_get_id(flight_b);
+    return (id_a > id_b) - (id_a < id_b);
+}
+
+/**
+ * @brief   Comparison function for sorting flights in ::flight_manager_departures_index_t::flights.
+ * @details Auxiliary method for ::__flight_manager_build_departures_index.
+ *
+ * @param a A pointer to a pointer to a ::flight_t.
+ * @param b A pointer to a pointer to a ::flight_t.
+ *
+ * @return The comparison result between @p a and @p b.
+ */
+gint __flight_manager_departures_index_compare(const void *const *a, const void *const *b) {
+    return __flight_manager_departures_compare(a, b, __flight_manager_origin_key);
+}
+
+/**
+ * @brief   Comparison function for sorting flights in ::flight_manager_departures_index_t::routes.
+ * @details Auxiliary method for ::__flight_manager_build_departures_index.
+ *
+ * @param a A pointer to a pointer to a ::flight_t.
+ * @param b A pointer to a pointer to a ::flight_t.
+ *
+ * @return The comparison result between @p a and @p b.
+ */
+gint __flight_manager_routes_index_compare(const void *const *a, const void *const *b) {
+    return __flight_manager_departures_compare(a, b, __flight_manager_route_key);
+}
+
+/**
+ * @brief   Builds an array of all the flights of a flight manager, for a departures index.
+ * @details Flights are sorted with three stable radix sorts (identifier, then departure date, and
+ *          then @p key), as all criteria don't fit in a single ::radix_sort_item_t::key. If there
+ *          isn't enough memory for that, @p compare is used instead.
+ *
+ * @param manager Manager whose flights are to be sorted.
+ * @param key     Function that gets the key flights are grouped by.
+ * @param compare Comparison function equivalent to the radix sorts, used as a fallback.
+ *
+ * @return The sorted flights.
+ */
+GConstPtrArray *__flight_manager_build_departures_index(const flight_manager_t         *manager,
+                                                        flight_manager_departures_key_t key,
+                                                        GConstCompareFunc               compare) {
+    GConstPtrArray *const flights = g_const_ptr_array_new();
+
+    const cancellation_t *const cancellation = cancellation_suspend();
+    flight_manager_iter(manager, __flight_manager_build_departures_index_callback, flights);
+    cancellation_set_current(cancellation);
+
+    const size_t             n     = g_const_ptr_array_get_length(flights);
+    radix_sort_item_t *const items = malloc(sizeof(radix_sort_item_t) * n);
+    radix_sort_item_t *const tmp   = malloc(sizeof(radix_sort_item_t) * n);
+    if ((!items || !tmp) && n) {
+        free(items);
+        free(tmp);
+        g_const_ptr_array_sort(flights, compare);
+        return flights;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const flight_t *const flight = g_const_ptr_array_index(flights, i);
+        items[i].key                 = flight_get_id(flight);
+        items[i].value               = flight;
+    }
+    radix_sort(items, tmp, n);
+
+    /* Latest departures come first */
+    for (size_t i = 0; i < n; ++i)
+        items[i].key = UINT64_MAX - flight_get_schedule_departure_date(items[i].value);
+    radix_sort(items, tmp, n);
+
+    for (size_t i = 0; i < n; ++i)
+        items[i].key = key(items[i].value);
+    radix_sort(items, tmp, n);
+
+    GConstPtrArray *const sorted = g_const_ptr_array_new();
+    for (size_t i = 0; i < n; ++i)
+        g_const_ptr_array_add(sorted, items[i].value);
+
+    free(items);
+    free(tmp);
+    g_const_ptr_array_unref(flights);
+    return sorted;
+}
+
+int flight_manager_cluster(flight_manager_t *manager) {
+    /* Same order as the index of departures by origin, so that each origin's flights are close */
+    GConstPtrArray *const sorted =
+        __flight_manager_build_departures_index(manager,
+                                                __flight_manager_origin_key,
+                                                __flight_manager_departures_index_compare);
+
+    const size_t     n      = g_const_ptr_array_get_length(sorted);
+    flight_t **const moved  = malloc(n * sizeof(flight_t *));
+    size_t           nmoved = 0;
+    int              retval = 1;
+    if (!moved && n)
+        goto DEFER_1;
+
+    pool_t *flights = pool_create_from_size_with_policy(flight_sizeof(),
+                                                        FLIGHT_MANAGER_FLIGHTS_POOL_BLOCK_CAPACITY,
+                                                        BLOCK_ALLOCATOR_POLICY_HUGE_PAGES);
+    if (!flights)
+        goto DEFER_2;
+    if (pool_reserve(flights, n))
+        goto DEFER_3;
+
+    for (size_t i = 0; i < n; ++i) {
+        const flight_t *const flight = g_const_ptr_array_index(sorted, i);
+        flight_t *const clone = flight_clone(flights, manager->strings, manager->strings, flight);
+        if (!clone)
+            goto DEFER_3;
+
+        /* Flights whose identifiers were repeated are kept, but they can't be looked up */
+        if (id_map_lookup(manager->id_flights_rel, flight_get_id(flight)) == flight)
+            moved[nmoved++] = clone;
+    }
+
+    /* Replacing identifiers that are already in the map doesn't allocate */
+    for (size_t i = 0; i < nmoved; ++i)
+        id_map_insert(manager->id_flights_rel, flight_get_id(moved[i]), moved[i]);
+
+    /* Invalidated flights aren't iterated over, so they're left behind */
+    __flight_manager_invalidate_departures_index(manager);
+    __flight_manager_invalidate_columns(manager->columns);
+    manager->ninvalid = 0;
+
+    /* Free the old pool instead of the new one */
+    pool_t *const old_flights = manager->flights;
+    manager->flights          = flights;
+    flights                   = old_flights;
+    retval                    = 0;
+
+DEFER_3:
+    pool_free(flights);
+DEFER_2:
+    free(moved);
+DEFER_1:
+    g_const_ptr_array_unref(sorted);
+    return retval;
+}
+
+/**
+ * @brief   Iterates through a range of the flights with a key in a departures index.
+ * @details Auxiliary method for ::flight_manager_iter_origin_departures_range and
+ *          ::flight_manager_iter_route_departures_range.
+ *
+ * @param flights   Sorted flights (::flight_manager_departures_index_t::flights or
+ *                  ::flight_manager_departures_index_t::routes).
+ * @param key       Function that gets the key @p flights are grouped by.
+ * @param value     Key of all iterated flights.
+ * @param begin     Earliest scheduled departure date (inclusive) of all iterated flights.
+ * @param end       Latest scheduled departure date (inclusive) of all iterated flights.
+ * @param offset    Number of matching flights to be left out at the beginning.
+ * @param limit     Maximum number of flights to be iterated over (`SIZE_MAX` for no limit).
+ * @param callback  Method called for every flight in the range.
+ * @param user_data Argument passed to @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` means success, another value means
+ *         the iteration was stopped by a callback).
+ */
+int __flight_manager_iter_departures_range(const GConstPtrArray           *flights,
+                                           flight_manager_departures_key_t key,
+                                           uint64_t                        value,
+                                           date_and_time_t                 begin,
+                                           date_and_time_t                 end,
+                                           size_t                          offset,
+                                           size_t                          limit,
+                                           flight_manager_iter_callback_t  callback,
+                                           void                           *user_data) {
+
+    const size_t n = g_const_ptr_array_get_length(flights);
+
+    /* First flight with the key that doesn't depart after end */
+    size_t first = 0, last = n;
+    while (first < last) {
+        const size_t          middle = first + (last - first) / 2;
+        const flight_t *const flight = g_const_ptr_array_index(flights, middle);
+
+        const uint64_t flight_key = key(flight);
+        if (flight_key < value ||
+            (flight_key == value &&
+             date_and_time_diff(flight_get_schedule_departure_date(flight), end) > 0))
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    /* First flight after that doesn't have the key or that departs before begin */
+    last = n;
+    for (size_t low = first; low < last;) {
+        const size_t          middle = low + (last - low) / 2;
+        const flight_t *const flight = g_const_ptr_array_index(flights, middle);
+
+        if (key(flight) > value ||
+            date_and_time_diff(flight_get_schedule_departure_date(flight), begin) < 0)
+            last = middle;
+        else
+            low = middle + 1;
+    }
+
+    first += min(offset, last - first);
+    last = first + min(limit, last - first);
+
+    for (size_t i = first; i < last; ++i) {
+        if ((i - first) % CANCELLATION_CHECK_INTERVAL == 0 && cancellation_check())
+            return CANCELLATION_ITER_RET;
+
+        const int retval = callback(user_data, g_const_ptr_array_index(flights, i));
+        if (retval)
+            return retval;
+    }
+    return 0;
+}
+
+int flight_manager_iter_origin_departures(const flight_manager_t        *manager,
+                                          airport_code_t                 origin,
+                                          date_and_time_t                begin,
+                                          date_and_time_t                end,
+                                          flight_manager_iter_callback_t callback,
+                                          void                          *user_data) {
+    return flight_manager_iter_origin_departures_range(manager,
+                                                       origin,
+                                                       begin,
+                                                       end,
+                                                       0,
+                                                       SIZE_MAX,
+                                                       callback,
+                                                       user_data);
+}
+
+int flight_manager_iter_origin_departures_range(const flight_manager_t        *manager,
+                                                airport_code_t                 origin,
+                                                date_and_time_t                begin,
+                                                date_and_time_t                end,
+                                                size_t                         offset,
+                                                size_t                         limit,
+                                                flight_manager_iter_callback_t callback,
+                                                void                          *user_data) {
+
+    flight_manager_departures_index_t *const index = manager->departures_index;
+
+    pthread_mutex_lock(&index->lock);
+    if (!index->flights)
+        index->flights =
+            __flight_manager_build_departures_index(manager,
+                                                    __flight_manager_origin_key,
+                                                    __flight_manager_departures_index_compare);
+    pthread_mutex_unlock(&index->lock);
+
+    return __flight_manager_iter_departures_range(index->flights,
+                                                  __flight_manager_origin_key,
+                                                  origin,
+                                                  begin,
+                                                  end,
+                                                  offset,
+                                                  limit,
+                                                  callback,
+                                                  user_data);
+}
+
+int flight_manager_iter_route_departures(const flight_manager_t        *manager,
+                                         airport_code_t                 origin,
+                                         airport_code_t                 destination,
+                                         date_and_time_t                begin,
+                                         date_and_time_t                end,
+                                         flight_manager_iter_callback_t callback,
+                                         void                          *user_data) {
+    return flight_manager_iter_route_departures_range(manager,
+                                                      origin,
+                                                      destination,
+                                                      begin,
+                                                      end,
+                                                      0,
+                                                      SIZE_MAX,
+                                                      callback,
+                                                      user_data);
+}
+
+int flight_manager_iter_route_departures_range(const flight_manager_t        *manager,
+                                               airport_code_t                 origin,
+                                               airport_code_t                 destination,
+                                               date_and_time_t                begin,
+                                               date_and_time_t                end,
+                                               size_t                         offset,
+                                               size_t                         limit,
+                                               flight_manager_iter_callback_t callback,
+                                               void                          *user_data) {
+
+    flight_manager_departures_index_t *const index = manager->departures_index;
+
+    pthread_mutex_lock(&index->lock);
+    if (!index->routes)
+        index->routes =
+            __flight_manager_build_departures_index(manager,
+                                                    __flight_manager_route_key,
+                                                    __flight_manager_routes_index_compare);
+    pthread_mutex_unlock(&index->lock);
+
+    return __flight_manager_iter_departures_range(index->routes,
+                                                  __flight_manager_route_key,
+                                                  (uint64_t) origin << 32 | destination,
+                                                  begin,
+                                                  end,
+                                                  offset,
+                                                  limit,
+                                                  callback,
+                                                  user_data);
+}
+
+/**
+ * @struct flight_manager_build_airports_data_t
+ * @brief  Internal data type for the `user_data` parameter in
+ *         ::__flight_manager_build_airports_callback.
+ *
+ * @var flight_manager_build_airports_data_t::airports
+ *     @brief Index being built.
+ * @var flight_manager_build_airports_data_t::seen
+ *     @brief Set of airports already in ::flight_manager_build_airports_data_t::airports.
+ */
+typedef struct {
+    prefix_index_t  *airports;
+    id_hash_table_t *seen;
+} flight_manager_build_airports_data_t;
+
+/**
+ * @brief Adds an airport to the index of airport codes being built, if it's not there yet.
+ *
+ * @param data    Index being built and set of airports already in it.
+ * @param airport Airport to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __flight_manager_build_airports_add(flight_manager_build_airports_data_t *data,
+                                        airport_code_t                        airport) {
+    const int inserted = id_hash_table_insert(data->seen, airport, NULL);
+    if (inserted != 0)
+        return inserted == 1;
+
+    char code[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
+    airport_code_sprintf(code, airport);
+    return prefix_index_add_copy(data->airports, code);
+}
+
+/**
+ * @brief  Callback for ::flight_manager_iter that adds a flight's airports to an index.
+ *
+ * @param user_data A pointer to a ::flight_manager_build_airports_data_t.
+ * @param flight    Flight whose airports are to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __flight_manager_build_airports_callback(void *user_data, const flight_t *flight) {
+    return __flight_manager_build_airports_add(user_data, flight_get_origin(flight)) ||
+           __flight_manager_build_airports_add(user_data, flight_get_destination(flight));
+}
+
+/**
+ * @brief Builds the index of airport codes of a flight manager.
+ *
+ * @param manager Manager whose ::flight_manager_departures_index_t::airports is to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __flight_manager_build_airports(const flight_manager_t *manager) {
+    flight_manager_build_airports_data_t data;
+    data.airports = prefix_index_create();
+    if (!data.airports)
+        return 1;
+
+    data.seen = id_hash_table_create(0);
+    if (!data.seen) {
+        prefix_index_free(data.airports);
+        return 1;
+    }
+
+    const cancellation_t *const cancellation = cancellation_suspend();
+    const int                   retval =
+        flight_manager_iter(manager, __flight_manager_build_airports_callback, &data);
+    cancellation_set_current(cancellation);
+    id_hash_table_free(data.seen);
+    if (retval) {
+        prefix_index_free(data.airports);
+        return 1;
+    }
+
+    prefix_index_build(data.airports);
+    manager->departures_index->airports = data.airports;
+    return 0;
+}
+
+int flight_manager_iter_airport_prefix(const flight_manager_t      *manager,
+                                       const char                  *prefix,
+                                       prefix_index_iter_callback_t callback,
+                                       void                        *user_data) {
+
+    flight_manager_departures_index_t *const index = manager->departures_index;
+
+    pthread_mutex_lock(&index->lock);
+    const int failure = !index->airports && __flight_manager_build_airports(manager);
+    pthread_mutex_unlock(&index->lock);
+    if (failure)
+        return 1;
+
+    return prefix_index_iter_prefix(index->airports, prefix, callback, user_data);
+}
+
+int flight_manager_build_index(const flight_manager_t *manager, flight_manager_index_t index) {
+    flight_manager_departures_index_t *const departures = manager->departures_index;
+
+    int failure = 0;
+    switch (index) {
+        case FLIGHT_MANAGER_INDEX_COLUMNS:
+            pthread_mutex_lock(&manager->columns->lock);
+            failure = __flight_manager_build_columns(manager);
+            pthread_mutex_unlock(&manager->columns->lock);
+            break;
+        case FLIGHT_MANAGER_INDEX_ORIGIN_DEPARTURES:
+            pthread_mutex_lock(&departures->lock);
+            if (!departures->flights)
+                departures->flights = __flight_manager_build_departures_index(
+                    manager,
+                    __flight_manager_origin_key,
+                    __flight_manager_departures_index_compare);
+            pthread_mutex_unlock(&departures->lock);
+            break;
+        case FLIGHT_MANAGER_INDEX_ROUTE_DEPARTURES:
+            pthread_mutex_lock(&departures->lock);
+            if (!departures->routes)
+                departures->routes = __flight_manager_build_departures_index(
+                    manager,
+                    __flight_manager_route_key,
+                    __flight_manager_routes_index_compare);
+            pthread_mutex_unlock(&departures->lock);
+            break;
+        case FLIGHT_MANAGER_INDEX_AIRPORTS:
+            pthread_mutex_lock(&departures->lock);
+            failure = !departures->airports && __flight_manager_build_airports(manager);
+            pthread_mutex_unlock(&departures->lock);
+            break;
+        default:
+            break;
+    }
+    return failure;
+}
+
+size_t flight_manager_get_memory_usage(const flight_manager_t *manager) {
+    size_t total = sizeof(flight_manager_t) + pool_get_memory_usage(manager->flights) +
+                   string_dictionary_get_memory_usage(manager->strings) +
+                   id_map_get_memory_usage(manager->id_flights_rel);
+
+    flight_manager_departures_index_t *const departures = manager->departures_index;
+    pthread_mutex_lock(&departures->lock);
+    total += sizeof(flight_manager_departures_index_t);
+    if (departures->flights)
+        total += g_const_ptr_array_get_length(departures->flights) * sizeof(gconstpointer);
+    if (departures->routes)
+        total += g_const_ptr_array_get_length(departures->routes) * sizeof(gconstpointer);
+    if (departures->airports)
+        total += prefix_index_get_memory_usage(departures->airports);
+    pthread_mutex_unlock(&departures->lock);
+
+    flight_manager_columns_index_t *const columns = manager->columns;
+    pthread_mutex_lock(&columns->lock);
+    total += sizeof(flight_manager_columns_index_t);
+    if (columns->built)
+        total += (columns->n + 1) * (sizeof(flight_id_t) + 2 * sizeof(airport_code_t) +
+                                     2 * sizeof(date_and_time_t) + 3 * sizeof(uint16_t)) +
+                 columns->nairports * sizeof(airport_code_t) +
+                 (columns->npartitions + 1) * sizeof(size_t) +
+                 ((columns->n + FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY - 1) /
+                      FLIGHT_MANAGER_COLUMNS_BLOCK_CAPACITY +
+                  1) * sizeof(flight_manager_columns_zone_t);
+    pthread_mutex_unlock(&columns->lock);
+
+    return total;
+}
+
+size_t flight_manager_get_strings_memory_usage(const flight_manager_t *manager) {
+    return string_dictionary_get_memory_usage(manager->strings);
+}
+
 void flight_manager_free(flight_manager_t *manager) {
     pool_free(manager->flights);
-    string_pool_no_duplicates_free(manager->strings);
-    g_hash_table_unref(manager->id_flights_rel);
+    string_dictionary_free(manager->strings);
+    id_map_free(manager->id_flights_rel);
+
+    __flight_manager_invalidate_departures_index(manager);
+    pthread_mutex_destroy(&manager->departures_index->lock);
+    free(manager->departures_index);
+
+    __flight_manager_invalidate_columns(manager->columns);
+    pthread_mutex_destroy(&manager->columns->lock);
+    free(manager->columns);
     free(manager);
 }
@@ -23,10 +23,191 @@
  */
 
 #include <glib.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "database/reservation_manager.h"
+#include "utils/cancellation.h"
+#include "utils/id_map.h"
+#include "utils/prefetch.h"
+#include "utils/int_utils.h"
+#include "utils/numa_topology.h"
+#include "utils/parallel_for.h"
+#include "utils/prefix_index.h"
+#include "utils/radix_sort.h"
+
+/**
+ * @struct reservation_manager_hotel_ratings_t
+ * @brief  Ratings of all reservations in a hotel.
+ *
+ * @var reservation_manager_hotel_ratings_t::sum
+ *     @brief Sum of the ratings of all reservations in the hotel.
+ * @var reservation_manager_hotel_ratings_t::count
+ *     @brief Number of reservations in the hotel.
+ */
+typedef struct {
+    uint64_t sum;
+    uint32_t count;
+} reservation_manager_hotel_ratings_t;
+
+/**
+ * @struct reservation_manager_hotel_replica_t
+ * @brief  Copy of the indices of hotels of a reservation manager, local to a NUMA node.
+ *
+ * @var reservation_manager_hotel_replica_t::hotel_ratings
+ *     @brief Copy of ::reservation_manager::hotel_ratings.
+ * @var reservation_manager_hotel_replica_t::reservations
+ *     @brief Copy of ::reservation_manager_hotel_index_t::reservations.
+ * @var reservation_manager_hotel_replica_t::offsets
+ *     @brief Copy of ::reservation_manager_hotel_index_t::offsets.
+ */
+typedef struct {
+    reservation_manager_hotel_ratings_t *hotel_ratings;
+    const reservation_t                **reservations;
+    size_t                              *offsets;
+} reservation_manager_hotel_replica_t;
+
+/**
+ * @struct  reservation_manager_hotel_index_t
+ * @brief   Index of reservations by hotel.
+ * @details Built when it's first needed, and discarded when a new reservation is added.
+ *
+ * @var reservation_manager_hotel_index_t::lock
+ *     @brief Lock that protects the index from being built by multiple threads.
+ * @var reservation_manager_hotel_index_t::built
+ *     @brief Whether the index is up-to-date.
+ * @var reservation_manager_hotel_index_t::reservations
+ *     @brief All reservations, grouped by hotel, and then in the order described in
+ *            ::reservation_manager_iter_hotel.
+ * @var reservation_manager_hotel_index_t::offsets
+ *     @brief Position in ::reservation_manager_hotel_index_t::reservations of the first
+ *            reservation of each hotel (::RESERVATION_MANAGER_NUMBER_OF_HOTELS `+ 1` elements).
+ * @var reservation_manager_hotel_index_t::begin_date
+ *     @brief Beginning date of every reservation in
+ *            ::reservation_manager_hotel_index_t::reservations, for
+ *            ::reservation_manager_get_hotel_columns.
+ * @var reservation_manager_hotel_index_t::end_date
+ *     @brief End date of every reservation in ::reservation_manager_hotel_index_t::reservations.
+ * @var reservation_manager_hotel_index_t::price_per_night
+ *     @brief Price per night of every reservation in
+ *            ::reservation_manager_hotel_index_t::reservations.
+ * @var reservation_manager_hotel_index_t::ids
+ *     @brief Identifiers of all hotels with reservations, for
+ *            ::reservation_manager_iter_hotel_id_prefix. `NULL` until needed.
+ * @var reservation_manager_hotel_index_t::replicas
+ *     @brief Copies of the index in every NUMA node, indexed by node (see
+ *            ::reservation_manager_replicate_indexes). `NULL` if not replicated.
+ * @var reservation_manager_hotel_index_t::nreplicas
+ *     @brief Number of elements in ::reservation_manager_hotel_index_t::replicas.
+ */
+typedef struct {
+    pthread_mutex_t                      lock;
+    int                                  built;
+    const reservation_t                **reservations;
+    size_t                              *offsets;
+    date_t                              *begin_date, *end_date;
+    uint16_t                            *price_per_night;
+    prefix_index_t                      *ids;
+    reservation_manager_hotel_replica_t *replicas;
+    size_t                               nreplicas;
+} reservation_manager_hotel_index_t;
+
+/** @brief Number of possible numbers of hotel stars in a reservation (from 1 to 5). */
+#define RESERVATION_MANAGER_BITMAP_STARS_VALUES 5
+
+/** @brief Number of values of ::includes_breakfast_t. */
+#define RESERVATION_MANAGER_BITMAP_BREAKFAST_VALUES 2
+
+/**
+ * @struct  reservation_manager_columns_zone_t
+ * @brief   Summary of a block of rows in a ::reservation_manager_columns_index_t (a zone map), so
+ *          that blocks that can't match a date-bounded iteration are skipped without being read.
+ *
+ * @var reservation_manager_columns_zone_t::min_begin
+ *     @brief Earliest beginning date in the block.
+ * @var reservation_manager_columns_zone_t::max_end
+ *     @brief Latest end date in the block.
+ */
+typedef struct {
+    date_t min_begin, max_end;
+} reservation_manager_columns_zone_t;
+
+/**
+ * @struct  reservation_manager_columns_index_t
+ * @brief   Some fields of all reservations, stored column by column.
+ * @details Built when it's first needed, and discarded when a new reservation is added. Rows are
+ *          partitioned by the month of their beginning date, so that iterations bounded by dates
+ *          only go through the partitions they need.
+ *
+ * @var reservation_manager_columns_index_t::lock
+ *     @brief Lock that protects the columns from being built by multiple threads.
+ * @var reservation_manager_columns_index_t::built
+ *     @brief Whether the columns are up-to-date.
+ * @var reservation_manager_columns_index_t::id
+ *     @brief Identifier of every reservation.
+ * @var reservation_manager_columns_index_t::hotel_id
+ *     @brief Hotel of every reservation.
+ * @var reservation_manager_columns_index_t::hotel_stars
+ *     @brief Number of stars of the hotel of every reservation.
+ * @var reservation_manager_columns_index_t::begin_date
+ *     @brief Beginning date of every reservation.
+ * @var reservation_manager_columns_index_t::end_date
+ *     @brief End date of every reservation.
+ * @var reservation_manager_columns_index_t::price_per_night
+ *     @brief Price per night of every reservation.
+ * @var reservation_manager_columns_index_t::city_tax
+ *     @brief City tax of every reservation.
+ * @var reservation_manager_columns_index_t::rating
+ *     @brief Rating of every reservation.
+ * @var reservation_manager_columns_index_t::includes_breakfast
+ *     @brief Whether every reservation includes breakfast.
+ * @var reservation_manager_columns_index_t::n
+ *     @brief Number of reservations (of elements in each column).
+ * @var reservation_manager_columns_index_t::partitions
+ *     @brief   Index of the first row of every month, from
+ *              ::reservation_manager_columns_index_t::first_month onwards.
+ *     @details Has ::reservation_manager_columns_index_t::npartitions `+ 1` elements, the last one
+ *              being ::reservation_manager_columns_index_t::n.
+ * @var reservation_manager_columns_index_t::first_month
+ *     @brief Earliest month (see ::date_generate_dayless) of a beginning date.
+ * @var reservation_manager_columns_index_t::npartitions
+ *     @brief Number of months between the earliest and latest beginning dates.
+ * @var reservation_manager_columns_index_t::max_stay
+ *     @brief   Longest reservation, in days.
+ *     @details How far back from a date partitions must be looked at, for reservations that are
+ *              still ongoing on that date.
+ * @var reservation_manager_columns_index_t::zones
+ *     @brief Summary of every block of ::RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY rows.
+ * @var reservation_manager_columns_index_t::hotel_stars_bitmaps
+ *     @brief Rows of reservations in hotels with each number of stars (minus one).
+ * @var reservation_manager_columns_index_t::includes_breakfast_bitmaps
+ *     @brief Rows of reservations with each ::includes_breakfast_t.
+ * @var reservation_manager_columns_index_t::empty_bitmap
+ *     @brief Empty bitmap, returned for values no reservation has.
+ */
+typedef struct {
+    pthread_mutex_t       lock;
+    int                   built;
+    reservation_id_t     *id;
+    hotel_id_t           *hotel_id;
+    date_t               *begin_date, *end_date;
+    uint16_t             *price_per_night;
+    uint8_t              *hotel_stars, *city_tax, *rating;
+    includes_breakfast_t *includes_breakfast;
+    size_t                n;
+    size_t               *partitions;
+    uint32_t              first_month;
+    size_t                npartitions;
+    uint32_t              max_stay;
+
+    reservation_manager_columns_zone_t *zones;
+
+    compressed_bitmap_t *hotel_stars_bitmaps[RESERVATION_MANAGER_BITMAP_STARS_VALUES];
+    compressed_bitmap_t *includes_breakfast_bitmaps[RESERVATION_MANAGER_BITMAP_BREAKFAST_VALUES];
+    compressed_bitmap_t *empty_bitmap;
+} reservation_manager_columns_index_t;
 
 /**
  * @struct reservation_manager
@@ -34,28 +215,52 @@
  *
  * @var reservation_manager::reservations
  *     @brief Allocator for reservations in the manager.
- * @var reservation_manager::hotel_name_pool
- *     @brief Allocator for hotel names in reservations.
- * @var reservation_manager::user_id_pool
- *     @brief Allocators for user identifiers in reservations.
+ * @var reservation_manager::hotel_names
+ *     @brief Dictionary of hotel names in reservations.
  * @var reservation_manager::id_reservations_rel
- *     @brief Hash table for ::reservation_id_t -> ::reservation_t mapping.
+ *     @brief Map for ::reservation_id_t -> ::reservation_t mapping.
+ * @var reservation_manager::hotel_ratings
+ *     @brief Ratings of every hotel, indexed by ::hotel_id_t.
+ * @var reservation_manager::hotel_index
+ *     @brief Index of reservations for ::reservation_manager_iter_hotel.
+ * @var reservation_manager::columns
+ *     @brief Columns of reservation fields for ::reservation_manager_iter_columns.
  */
 struct reservation_manager {
-    pool_t                      *reservations;
-    string_pool_no_duplicates_t *hotel_name_pool;
-    string_pool_t               *user_id_pool;
-    GHashTable                  *id_reservations_rel;
+    pool_t                              *reservations;
+    string_dictionary_t                 *hotel_names;
+    id_map_t                            *id_reservations_rel;
+    reservation_manager_hotel_ratings_t *hotel_ratings;
+    reservation_manager_hotel_index_t   *hotel_index;
+    reservation_manager_columns_index_t *columns;
 };
 
 /** @brief Number of reservations in each block of ::reservation_manager::reservations. */
 #define RESERVATION_MANAGER_RESERVATIONS_POOL_BLOCK_CAPACITY 50000
 
+/** @brief Number of characters in each block of the pool of ::reservation_manager::hotel_names. */
+#define RESERVATION_MANAGER_STRING_POOLS_BLOCK_CAPACITY 100000
+
+/** @brief Number of elements in ::reservation_manager::hotel_ratings (all possible hotels). */
+#define RESERVATION_MANAGER_NUMBER_OF_HOTELS (UINT16_MAX + 1)
+
 /**
- * @brief Number of characters in each block of ::reservation_manager::hotel_name_pool and in
- *        ::reservation_manager::user_id_pool.
+ * @brief Maximum number of reservations in each block provided by
+ *        ::reservation_manager_iter_columns.
  */
-#define RESERVATION_MANAGER_STRING_POOLS_BLOCK_CAPACITY 100000
+#define RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY 4096
+
+/**
+ * @brief Sets all bitmaps of rows of a reservation manager's columns to `NULL`.
+ * @param columns Columns (::reservation_manager::columns) whose bitmaps are cleared (not freed).
+ */
+void __reservation_manager_clear_column_bitmaps(reservation_manager_columns_index_t *columns) {
+    for (size_t i = 0; i < RESERVATION_MANAGER_BITMAP_STARS_VALUES; ++i)
+        columns->hotel_stars_bitmaps[i] = NULL;
+    for (size_t i = 0; i < RESERVATION_MANAGER_BITMAP_BREAKFAST_VALUES; ++i)
+        columns->includes_breakfast_bitmaps[i] = NULL;
+    columns->empty_bitmap = NULL;
+}
 
 reservation_manager_t *reservation_manager_create(void) {
     reservation_manager_t *const manager = malloc(sizeof(reservation_manager_t));
@@ -63,25 +268,80 @@ reservation_manager_t *reservation_manager_create(void) {
         goto DEFER_1;
 
     manager->reservations =
-        pool_create_from_size(reservation_sizeof(),
-                              RESERVATION_MANAGER_RESERVATIONS_POOL_BLOCK_CAPACITY);
+        pool_create_from_size_with_policy(reservation_sizeof(),
+                                          RESERVATION_MANAGER_RESERVATIONS_POOL_BLOCK_CAPACITY,
+                                          BLOCK_ALLOCATOR_POLICY_HUGE_PAGES);
     if (!manager->reservations)
         goto DEFER_2;
 
-    manager->hotel_name_pool =
-        string_pool_no_duplicates_create(RESERVATION_MANAGER_STRING_POOLS_BLOCK_CAPACITY);
-    if (!manager->hotel_name_pool)
+    manager->hotel_names =
+        string_dictionary_create(RESERVATION_MANAGER_STRING_POOLS_BLOCK_CAPACITY);
+    if (!manager->hotel_names)
         goto DEFER_3;
 
-    manager->user_id_pool = string_pool_create(RESERVATION_MANAGER_STRING_POOLS_BLOCK_CAPACITY);
-    if (!manager->user_id_pool)
+    manager->hotel_ratings =
+        calloc(RESERVATION_MANAGER_NUMBER_OF_HOTELS, sizeof(reservation_manager_hotel_ratings_t));
+    if (!manager->hotel_ratings)
         goto DEFER_4;
 
-    manager->id_reservations_rel = g_hash_table_new(g_direct_hash, g_direct_equal);
+    manager->hotel_index = malloc(sizeof(reservation_manager_hotel_index_t));
+    if (!manager->hotel_index)
+        goto DEFER_5;
+
+    if (pthread_mutex_init(&manager->hotel_index->lock, NULL))
+        goto DEFER_6;
+    manager->hotel_index->built           = 0;
+    manager->hotel_index->reservations    = NULL;
+    manager->hotel_index->offsets         = NULL;
+    manager->hotel_index->begin_date      = NULL;
+    manager->hotel_index->end_date        = NULL;
+    manager->hotel_index->price_per_night = NULL;
+    manager->hotel_index->ids             = NULL;
+    manager->hotel_index->replicas        = NULL;
+    manager->hotel_index->nreplicas       = 0;
+
+    manager->columns = malloc(sizeof(reservation_manager_columns_index_t));
+    if (!manager->columns)
+        goto DEFER_7;
+
+    if (pthread_mutex_init(&manager->columns->lock, NULL))
+        goto DEFER_8;
+    manager->columns->built              = 0;
+    manager->columns->id                 = NULL;
+    manager->columns->hotel_id           = NULL;
+    manager->columns->hotel_stars        = NULL;
+    manager->columns->begin_date         = NULL;
+    manager->columns->end_date           = NULL;
+    manager->columns->price_per_night    = NULL;
+    manager->columns->city_tax           = NULL;
+    manager->columns->rating             = NULL;
+    manager->columns->includes_breakfast = NULL;
+    manager->columns->n                  = 0;
+    manager->columns->partitions         = NULL;
+    manager->columns->first_month        = 0;
+    manager->columns->npartitions        = 0;
+    manager->columns->max_stay           = 0;
+    manager->columns->zones              = NULL;
+    __reservation_manager_clear_column_bitmaps(manager->columns);
+
+    manager->id_reservations_rel = id_map_create();
+    if (!manager->id_reservations_rel)
+        goto DEFER_9;
+
     return manager;
 
+DEFER_9:
+    pthread_mutex_destroy(&manager->columns->lock);
+DEFER_8:
+    free(manager->columns);
+DEFER_7:
+    pthread_mutex_destroy(&manager->hotel_index->lock);
+DEFER_6:
+    free(manager->hotel_index);
+DEFER_5:
+    free(manager->hotel_ratings);
 DEFER_4:
-    string_pool_no_duplicates_free(manager->hotel_name_pool);
+    string_dictionary_free(manager->hotel_names);
 DEFER_3:
     pool_free(manager->reservations);
 DEFER_2:
@@ -90,15 +350,43 @@ DEFER_1:
     return NULL;
 }
 
+/**
+ * @struct reservation_manager_clone_callback_data_t
+ * @brief  Type of `user_data` parameter in ::__reservation_manager_clone_callback.
+ *
+ * @var reservation_manager_clone_callback_data_t::clone
+ *     @brief Manager where to add reservations to.
+ * @var reservation_manager_clone_callback_data_t::hotel_names
+ *     @brief Dictionary of the manager being cloned.
+ */
+typedef struct {
+    reservation_manager_t *const     clone;
+    const string_dictionary_t *const hotel_names;
+} reservation_manager_clone_callback_data_t;
+
+/**
+ * @brief  Callback for ::reservation_manager_iter that adds every reservation to a clone of a
+ *         manager.
+ * @param  user_data   A pointer to a ::reservation_manager_clone_callback_data_t.
+ * @param  reservation Reservation to be added to the clone.
+ * @return The value returned by ::reservation_manager_add_reservation.
+ */
+int __reservation_manager_clone_callback(void *user_data, const reservation_t *reservation) {
+    const reservation_manager_clone_callback_data_t *const data = user_data;
+    return reservation_manager_add_reservation(data->clone, data->hotel_names, reservation);
+}
+
 reservation_manager_t *reservation_manager_clone(const reservation_manager_t *manager) {
     reservation_manager_t *const clone = reservation_manager_create();
     if (!clone)
         return NULL;
 
-    if (reservation_manager_iter(
-            manager,
-            (reservation_manager_iter_callback_t) reservation_manager_add_reservation,
-            clone)) {
+    reservation_manager_clone_callback_data_t data = {.clone       = clone,
+                                                      .hotel_names = manager->hotel_names};
+
+    const size_t n = id_map_get_length(manager->id_reservations_rel);
+    if (reservation_manager_reserve(clone, n) ||
+        reservation_manager_iter(manager, __reservation_manager_clone_callback, &data)) {
 
         reservation_manager_free(clone);
         return NULL;
@@ -107,21 +395,119 @@ reservation_manager_t *reservation_manager_clone(const reservation_manager_t *ma
     return clone;
 }
 
-int reservation_manager_add_reservation(reservation_manager_t *manager,
-                                        const reservation_t   *reservation) {
+/**
+ * @brief Discards the replicas of the index of hotels of a reservation manager.
+ * @param index Index whose replicas (::reservation_manager_hotel_index_t::replicas) are discarded.
+ */
+void __reservation_manager_free_hotel_replicas(reservation_manager_hotel_index_t *index) {
+    for (size_t i = 0; i < index->nreplicas; ++i) {
+        free(index->replicas[i].hotel_ratings);
+        free(index->replicas[i].reservations);
+        free(index->replicas[i].offsets);
+    }
+
+    free(index->replicas);
+    index->replicas  = NULL;
+    index->nreplicas = 0;
+}
+
+/**
+ * @brief Discards a reservation manager's index of hotels, so that it's built again when needed.
+ * @param manager Manager whose index is no longer valid.
+ */
+void __reservation_manager_invalidate_hotel_index(reservation_manager_t *manager) {
+    reservation_manager_hotel_index_t *const index = manager->hotel_index;
+    __reservation_manager_free_hotel_replicas(index);
+    if (index->ids) {
+        prefix_index_free(index->ids);
+        index->ids = NULL;
+    }
+
+    if (!index->built)
+        return;
+
+    free(index->reservations);
+    free(index->offsets);
+    free(index->begin_date);
+    free(index->end_date);
+    free(index->price_per_night);
+    index->reservations    = NULL;
+    index->offsets         = NULL;
+    index->begin_date      = NULL;
+    index->end_date        = NULL;
+    index->price_per_night = NULL;
+    index->built           = 0;
+}
+
+/**
+ * @brief Discards a reservation manager's columns, so that they're built again when needed.
+ * @param columns Columns (::reservation_manager::columns) that are no longer valid.
+ */
+void __reservation_manager_invalidate_columns(reservation_manager_columns_index_t *columns) {
+    if (!columns->built)
+        return;
+
+    free(columns->id);
+    free(columns->hotel_id);
+    free(columns->hotel_stars);
+    free(columns->begin_date);
+    free(columns->end_date);
+    free(columns->price_per_night);
+    free(columns->city_tax);
+    free(columns->rating);
+    free(columns->includes_breakfast);
+    free(columns->partitions);
+    free(columns->zones);
+    for (size_t i = 0; i < RESERVATION_MANAGER_BITMAP_STARS_VALUES; ++i)
+        compressed_bitmap_free(columns->hotel_stars_bitmaps[i]);
+    for (size_t i = 0; i < RESERVATION_MANAGER_BITMAP_BREAKFAST_VALUES; ++i)
+        compressed_bitmap_free(columns->includes_breakfast_bitmaps[i]);
+    compressed_bitmap_free(columns->empty_bitmap);
+
+    columns->id                 = NULL;
+    columns->hotel_id           = NULL;
+    columns->hotel_stars        = NULL;
+    columns->begin_date         = NULL;
+    columns->end_date           = NULL;
+    columns->price_per_night    = NULL;
+    columns->city_tax           = NULL;
+    columns->rating             = NULL;
+    columns->includes_breakfast = NULL;
+    columns->n                  = 0;
+    columns->partitions         = NULL;
+    columns->first_month        = 0;
+    columns->npartitions        = 0;
+    columns->max_stay           = 0;
+    columns->zones              = NULL;
+    columns->built              = 0;
+    __reservation_manager_clear_column_bitmaps(columns);
+}
+
+int reservation_manager_add_reservation(reservation_manager_t     *manager,
+                                        const string_dictionary_t *hotel_names,
+                                        const reservation_t       *reservation) {
 
     reservation_t *const pool_reservation = reservation_clone(manager->reservations,
-                                                              manager->user_id_pool,
-                                                              manager->hotel_name_pool,
+                                                              manager->hotel_names,
+                                                              hotel_names,
                                                               reservation);
     if (!pool_reservation)
         return 1;
 
     reservation_id_t res_id = reservation_get_id(reservation);
-    if (!g_hash_table_insert(manager->id_reservations_rel,
-                             GUINT_TO_POINTER(res_id),
-                             pool_reservation)) {
+    const int        inserted =
+        id_map_insert(manager->id_reservations_rel, res_id, pool_reservation);
+    if (inserted == 1)
+        return 1;
+
+    reservation_manager_hotel_ratings_t *const ratings =
+        &manager->hotel_ratings[reservation_get_hotel_id(reservation)];
+    ratings->sum += reservation_get_rating(reservation);
+    ratings->count++;
+    __reservation_manager_invalidate_hotel_index(manager);
+    __reservation_manager_invalidate_columns(manager->columns);
 
+    if (inserted == 2) {
         /* Do not fatally fail (just print a warning). Show must go on. */
         char id_str[RESERVATION_ID_SPRINTF_MIN_BUFFER_SIZE];
         reservation_id_sprintf(id_str, res_id);
@@ -133,9 +519,75 @@ int reservation_manager_add_reservation(reservation_manager_t *manager,
     return 0;
 }
 
+int reservation_manager_reserve(reservation_manager_t *manager, size_t n) {
+    const size_t length = id_map_get_length(manager->id_reservations_rel);
+    return id_map_reserve(manager->id_reservations_rel, n) ||
+           pool_reserve(manager->reservations, n > length ? n - length : 0);
+}
+
+int reservation_manager_shrink_to_fit(reservation_manager_t *manager) {
+    pool_shrink_to_fit(manager->reservations);
+    return id_map_shrink_to_fit(manager->id_reservations_rel);
+}
+
+const string_dictionary_t *
+    reservation_manager_get_hotel_names(const reservation_manager_t *manager) {
+
+    return manager->hotel_names;
+}
+
 const reservation_t *reservation_manager_get_by_id(const reservation_manager_t *manager,
                                                    reservation_id_t             id) {
-    return g_hash_table_lookup(manager->id_reservations_rel, GUINT_TO_POINTER(id));
+    return id_map_lookup(manager->id_reservations_rel, id);
+}
+
+void reservation_manager_get_by_ids(const reservation_manager_t *manager,
+                                    size_t                       n,
+                                    const reservation_id_t       ids[n],
+                                    const reservation_t         *reservations[n]) {
+    for (size_t begin = 0; begin < n; begin += PREFETCH_BATCH_SIZE) {
+        const size_t batch = n - begin < PREFETCH_BATCH_SIZE ? n - begin : PREFETCH_BATCH_SIZE;
+
+        void *values[PREFETCH_BATCH_SIZE];
+        id_map_lookup_batch(manager->id_reservations_rel, batch, ids + begin, values);
+        for (size_t i = 0; i < batch; ++i) {
+            prefetch_read(values[i]);
+            reservations[begin + i] = values[i];
+        }
+    }
+}
+
+size_t reservation_manager_get_length(const reservation_manager_t *manager) {
+    return id_map_get_length(manager->id_reservations_rel);
+}
+
+/**
+ * @brief Gets the replica of the index of hotels for the NUMA node of the calling thread.
+ *
+ * @param index Index of hotels of a reservation manager.
+ *
+ * @return The replica for the calling thread, or `NULL` if there's none (the original index must
+ *         be used).
+ */
+const reservation_manager_hotel_replica_t *
+    __reservation_manager_get_hotel_replica(const reservation_manager_hotel_index_t *index) {
+
+    const size_t node = numa_topology_get_thread_node();
+    return node < index->nreplicas ? &index->replicas[node] : NULL;
+}
+
+void reservation_manager_get_hotel_ratings(const reservation_manager_t *manager,
+                                           hotel_id_t                   hotel,
+                                           uint64_t                    *sum,
+                                           size_t                      *count) {
+
+    const reservation_manager_hotel_replica_t *const replica =
+        __reservation_manager_get_hotel_replica(manager->hotel_index);
+    const reservation_manager_hotel_ratings_t *const ratings =
+        replica ? replica->hotel_ratings : manager->hotel_ratings;
+
+    *sum   = ratings[hotel].sum;
+    *count = ratings[hotel].count;
 }
 
 int reservation_manager_iter(const reservation_manager_t        *manager,
@@ -144,10 +596,1127 @@ int reservation_manager_iter(const reservation_manager_t        *manager,
     return pool_iter(manager->reservations, (pool_iter_callback_t) callback, user_data);
 }
 
+int reservation_manager_iter_blocks(const reservation_manager_t                *manager,
+                                    reservation_manager_iter_blocks_callback_t callback,
+                                    void                                       *user_data) {
+    return pool_iter_pointers(manager->reservations,
+                              (pool_iter_pointers_callback_t) callback,
+                              user_data);
+}
+
+int reservation_manager_iter_blocks_parallel(
+    const reservation_manager_t               *manager,
+    size_t                                     nthreads,
+    reservation_manager_iter_blocks_callback_t callback,
+    void *const                               *user_data) {
+    return pool_iter_pointers_parallel(manager->reservations,
+                                       nthreads,
+                                       (pool_iter_pointers_callback_t) callback,
+                                       user_data);
+}
+
+/**
+ * @struct reservation_manager_columns_build_t
+ * @brief  Data for the iterations through reservations in ::__reservation_manager_build_columns.
+ *
+ * @var reservation_manager_columns_build_t::columns
+ *     @brief Columns being built.
+ * @var reservation_manager_columns_build_t::last_month
+ *     @brief Latest month (see ::date_generate_dayless) of a beginning date.
+ * @var reservation_manager_columns_build_t::cursors
+ *     @brief Next free row of every partition of ::reservation_manager_columns_build_t::columns.
+ */
+typedef struct {
+    reservation_manager_columns_index_t *columns;
+    uint32_t                             last_month;
+    size_t                              *cursors;
+} reservation_manager_columns_build_t;
+
+/**
+ * @brief   Counts a reservation and widens the ranges of months and stays of the columns being
+ *          built.
+ * @details Auxiliary method for ::__reservation_manager_build_columns.
+ *
+ * @param user_data   A pointer to a ::reservation_manager_columns_build_t.
+ * @param reservation Reservation to be counted.
+ *
+ * @retval 0 Always successful.
+ */
+int __reservation_manager_build_columns_bounds(void *user_data, const reservation_t *reservation) {
+    reservation_manager_columns_build_t *const build   = user_data;
+    reservation_manager_columns_index_t *const columns = build->columns;
+
+    const date_t   begin = reservation_get_begin_date(reservation);
+    const int64_t  stay  = date_diff(reservation_get_end_date(reservation), begin);
+    const uint32_t month = date_generate_dayless(begin);
+
+    columns->n++;
+    columns->first_month = min(columns->first_month, month);
+    build->last_month    = max(build->last_month, month);
+    if (stay > 0)
+        columns->max_stay = max(columns->max_stay, (uint32_t) stay);
+    return 0;
+}
+
+/**
+ * @brief   Counts a reservation in the partition of its month.
+ * @details Auxiliary method for ::__reservation_manager_build_columns.
+ *
+ * @param user_data   A pointer to a ::reservation_manager_columns_index_t, whose
+ *                    ::reservation_manager_columns_index_t::partitions are being counted (offset
+ *                    by one).
+ * @param reservation Reservation to be counted.
+ *
+ * @retval 0 Always successful.
+ */
+int __reservation_manager_build_columns_count(void *user_data, const reservation_t *reservation) {
+    reservation_manager_columns_index_t *const columns = user_data;
+    const uint32_t month = date_generate_dayless(reservation_get_begin_date(reservation));
+
+    columns->partitions[month - columns->first_month + 1]++;
+    return 0;
+}
+
+/**
+ * @brief   Copies the fields of a reservation to the next free row of its partition.
+ * @details Auxiliary method for ::__reservation_manager_build_columns.
+ *
+ * @param user_data   A pointer to a ::reservation_manager_columns_build_t.
+ * @param reservation Reservation whose fields are to be copied.
+ *
+ * @retval 0 Always successful.
+ */
+int __reservation_manager_build_columns_fill(void *user_data, const reservation_t *reservation) {
+    reservation_manager_columns_build_t *const build   = user_data;
+    reservation_manager_columns_index_t *const columns = build->columns;
+
+    const uint32_t month = date_generate_dayless(reservation_get_begin_date(reservation));
+    const size_t   i     = build->cursors[month - columns->first_month]++;
+
+    columns->id[i]                 = reservation_get_id(reservation);
+    columns->hotel_id[i]           = reservation_get_hotel_id(reservation);
+    columns->hotel_stars[i]        = reservation_get_hotel_stars(reservation);
+    columns->begin_date[i]         = reservation_get_begin_date(reservation);
+    columns->end_date[i]           = reservation_get_end_date(reservation);
+    columns->price_per_night[i]    = reservation_get_price_per_night(reservation);
+    columns->city_tax[i]           = reservation_get_city_tax(reservation);
+    columns->rating[i]             = reservation_get_rating(reservation);
+    columns->includes_breakfast[i] = reservation_get_includes_breakfast(reservation);
+    return 0;
+}
+
+/**
+ * @brief   Builds the bitmaps of rows of a reservation manager's columns.
+ * @details Auxiliary method for ::__reservation_manager_build_columns. On failure, bitmaps are left
+ *          to be freed by ::__reservation_manager_invalidate_columns.
+ *
+ * @param columns Columns (::reservation_manager::columns), already filled.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __reservation_manager_build_column_bitmaps(reservation_manager_columns_index_t *columns) {
+    int failure = 0;
+    for (size_t i = 0; i < RESERVATION_MANAGER_BITMAP_STARS_VALUES; ++i) {
+        columns->hotel_stars_bitmaps[i] = compressed_bitmap_create();
+        failure |= !columns->hotel_stars_bitmaps[i];
+    }
+    for (size_t i = 0; i < RESERVATION_MANAGER_BITMAP_BREAKFAST_VALUES; ++i) {
+        columns->includes_breakfast_bitmaps[i] = compressed_bitmap_create();
+        failure |= !columns->includes_breakfast_bitmaps[i];
+    }
+    columns->empty_bitmap = compressed_bitmap_create();
+    if (failure || !columns->empty_bitmap)
+        return 1;
+
+    for (size_t i = 0; i < columns->n; ++i) {
+        compressed_bitmap_t *const stars =
+            columns->hotel_stars_bitmaps[columns->hotel_stars[i] - 1];
+        compressed_bitmap_t *const breakfast =
+            columns->includes_breakfast_bitmaps[columns->includes_breakfast[i]];
+
+        if (compressed_bitmap_add(stars, i) || compressed_bitmap_add(breakfast, i))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Summarizes every block of rows of a reservation manager's columns.
+ * @details Auxiliary method for ::__reservation_manager_build_columns.
+ *
+ * @param columns Columns (::reservation_manager::columns), already filled, with allocated
+ *                ::reservation_manager_columns_index_t::zones.
+ */
+void __reservation_manager_build_column_zones(reservation_manager_columns_index_t *columns) {
+    for (size_t offset = 0; offset < columns->n;
+         offset += RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY) {
+
+        const size_t end = min(columns->n, offset + RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY);
+
+        reservation_manager_columns_zone_t zone = {.min_begin = UINT32_MAX, .max_end = 0};
+        for (size_t i = offset; i < end; ++i) {
+            zone.min_begin = min(zone.min_begin, columns->begin_date[i]);
+            zone.max_end   = max(zone.max_end, columns->end_date[i]);
+        }
+        columns->zones[offset / RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY] = zone;
+    }
+}
+
+/**
+ * @brief   Builds the columns of a reservation manager, if they aren't built yet.
+ * @details Reservations are sorted by the month of their beginning date with a counting sort, so
+ *          that reservations in the same month keep the order of the manager.
+ *
+ * @param manager Manager whose ::reservation_manager::columns are to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __reservation_manager_build_columns(const reservation_manager_t *manager) {
+    reservation_manager_columns_index_t *const columns = manager->columns;
+    if (columns->built)
+        return 0;
+
+    const cancellation_t *const cancellation = cancellation_suspend();
+
+    reservation_manager_columns_build_t build = {.columns    = columns,
+                                                 .last_month = 0,
+                                                 .cursors    = NULL};
+    columns->n           = 0;
+    columns->first_month = UINT32_MAX;
+    columns->max_stay    = 0;
+    reservation_manager_iter(manager, __reservation_manager_build_columns_bounds, &build);
+
+    const size_t n       = columns->n;
+    const size_t nblocks = (n + RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY - 1) /
+                           RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY;
+    columns->npartitions = n ? build.last_month - columns->first_month + 1 : 0;
+
+    /* Always allocate at least one element, so that NULL only means failure */
+    columns->id                 = malloc(sizeof(reservation_id_t) * (n + 1));
+    columns->hotel_id           = malloc(sizeof(hotel_id_t) * (n + 1));
+    columns->hotel_stars        = malloc(sizeof(uint8_t) * (n + 1));
+    columns->begin_date         = malloc(sizeof(date_t) * (n + 1));
+    columns->end_date           = malloc(sizeof(date_t) * (n + 1));
+    columns->price_per_night    = malloc(sizeof(uint16_t) * (n + 1));
+    columns->city_tax           = malloc(sizeof(uint8_t) * (n + 1));
+    columns->rating             = malloc(sizeof(uint8_t) * (n + 1));
+    columns->includes_breakfast = malloc(sizeof(includes_breakfast_t) * (n + 1));
+    columns->partitions         = calloc(columns->npartitions + 1, sizeof(size_t));
+    columns->zones              = malloc(sizeof(*columns->zones) * (nblocks + 1));
+    build.cursors               = malloc(sizeof(size_t) * (columns->npartitions + 1));
+    columns->built              = 1;
+
+    if (!columns->id || !columns->hotel_id || !columns->hotel_stars || !columns->begin_date ||
+        !columns->end_date || !columns->price_per_night || !columns->city_tax ||
+        !columns->rating || !columns->includes_breakfast || !columns->partitions ||
+        !columns->zones || !build.cursors) {
+
+        free(build.cursors);
+        __reservation_manager_invalidate_columns(columns);
+        cancellation_set_current(cancellation);
+        return 1;
+    }
+
+    reservation_manager_iter(manager, __reservation_manager_build_columns_count, columns);
+    for (size_t i = 0; i < columns->npartitions; ++i) {
+        columns->partitions[i + 1] += columns->partitions[i];
+        build.cursors[i] = columns->partitions[i];
+    }
+
+    reservation_manager_iter(manager, __reservation_manager_build_columns_fill, &build);
+    free(build.cursors);
+    __reservation_manager_build_column_zones(columns);
+    cancellation_set_current(cancellation);
+
+    if (__reservation_manager_build_column_bitmaps(columns)) {
+        __reservation_manager_invalidate_columns(columns);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Gets the rows of the partitions of a reservation manager's columns that contain all
+ *          reservations whose stay overlaps a range of dates.
+ * @details Partitions are chosen by beginning date, so they're looked at from
+ *          ::reservation_manager_columns_index_t::max_stay days before @p begin.
+ *
+ * @param columns   Columns (::reservation_manager::columns), already built.
+ * @param begin     First day of the range (inclusive).
+ * @param end       Last day of the range (inclusive).
+ * @param first_row Where to write the index of the first row in the range to.
+ * @param last_row  Where to write the index of the row after the last one in the range to.
+ */
+void __reservation_manager_get_partition_rows(const reservation_manager_columns_index_t *columns,
+                                              date_t                                     begin,
+                                              date_t                                     end,
+                                              size_t *first_row,
+                                              size_t *last_row) {
+
+    const date_t   earliest    = begin > columns->max_stay ? begin - columns->max_stay : 0;
+    const uint32_t begin_month = date_generate_dayless(earliest);
+    const uint32_t end_month   = date_generate_dayless(end);
+
+    const size_t first = begin_month <= columns->first_month
+                             ? 0
+                             : min(begin_month - columns->first_month, columns->npartitions);
+    const size_t last  = end_month < columns->first_month
+                             ? 0
+                             : min(end_month - columns->first_month + 1, columns->npartitions);
+
+    *first_row = columns->partitions[first];
+    *last_row  = columns->partitions[max(first, last)];
+}
+
+/**
+ * @struct reservation_manager_columns_range_t
+ * @brief  A range of rows of a reservation manager's columns to be iterated through, block by
+ *         block.
+ *
+ * @var reservation_manager_columns_range_t::columns
+ *     @brief Columns being iterated through.
+ * @var reservation_manager_columns_range_t::first_row
+ *     @brief Index of the first row in the range.
+ * @var reservation_manager_columns_range_t::last_row
+ *     @brief Index of the row after the last one in the range.
+ * @var reservation_manager_columns_range_t::bounded
+ *     @brief   Whether blocks without stays overlapping the range of dates between
+ *              ::reservation_manager_columns_range_t::begin and
+ *              ::reservation_manager_columns_range_t::end can be skipped.
+ *     @details See ::reservation_manager_columns_index_t::zones.
+ * @var reservation_manager_columns_range_t::begin
+ *     @brief First day (inclusive) of the range of dates reservations must overlap.
+ * @var reservation_manager_columns_range_t::end
+ *     @brief Last day (inclusive) of the range of dates reservations must overlap.
+ * @var reservation_manager_columns_range_t::callback
+ *     @brief Method called for every block in the range (or in a thread's part of it).
+ * @var reservation_manager_columns_range_t::user_data
+ *     @brief `user_data` parameter for every callback.
+ */
+typedef struct {
+    const reservation_manager_columns_index_t  *columns;
+    size_t                                      first_row, last_row;
+    int                                         bounded;
+    date_t                                      begin, end;
+    reservation_manager_iter_columns_callback_t callback;
+    void                                       *user_data;
+} reservation_manager_columns_range_t;
+
+/**
+ * @brief   Gets the number of blocks in a range of rows of a reservation manager's columns.
+ * @details Blocks are aligned to ::RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY rows from the
+ *          beginning of the columns (so that each one has a ::reservation_manager_columns_zone_t),
+ *          and the first and last blocks are cut short by the range.
+ *
+ * @param range Range of rows.
+ *
+ * @return The number of blocks in @p range.
+ */
+size_t __reservation_manager_columns_range_get_nblocks(
+    const reservation_manager_columns_range_t *range) {
+
+    if (range->last_row <= range->first_row)
+        return 0;
+
+    return (range->last_row + RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY - 1) /
+               RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY -
+           range->first_row / RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY;
+}
+
+/**
+ * @brief Calls a callback for some blocks of a range of a reservation manager's columns.
+ *
+ * @param range Range of rows of the columns, with the callback to be called.
+ * @param begin Index of the first block, from the beginning of @p range.
+ * @param end   Index of the block after the last one.
+ *
+ * @return The return value of the last-called callback.
+ */
+int __reservation_manager_iter_columns_range(const reservation_manager_columns_range_t *range,
+                                             size_t                                     begin,
+                                             size_t                                     end) {
+
+    const reservation_manager_columns_index_t *const columns = range->columns;
+    const size_t first_block = range->first_row / RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY;
+
+    for (size_t i = begin; i < end; ++i) {
+        if (cancellation_check())
+            return CANCELLATION_ITER_RET;
+
+        const reservation_manager_columns_zone_t *const zone = &columns->zones[first_block + i];
+        if (range->bounded && (zone->min_begin > range->end || zone->max_end < range->begin))
+            continue;
+
+        const size_t block_start =
+            (first_block + i) * RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY;
+        const size_t offset      = max(range->first_row, block_start);
+        const size_t n =
+            min(range->last_row, block_start + RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY) - offset;
+
+        const reservation_manager_columns_t block = {
+            .id                 = columns->id + offset,
+            .hotel_id           = columns->hotel_id + offset,
+            .hotel_stars        = columns->hotel_stars + offset,
+            .begin_date         = columns->begin_date + offset,
+            .end_date           = columns->end_date + offset,
+            .price_per_night    = columns->price_per_night + offset,
+            .city_tax           = columns->city_tax + offset,
+            .rating             = columns->rating + offset,
+            .includes_breakfast = columns->includes_breakfast + offset};
+
+        const int retval = range->callback(range->user_data, &block, n);
+        if (retval)
+            return retval;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Builds the columns of a reservation manager (if needed) and returns them.
+ * @details Auxiliary method for all column-wise iterations and ::reservation_manager_get_bitmap.
+ *
+ * @param manager Manager to get the columns from.
+ *
+ * @return The columns of @p manager, or `NULL` on allocation failure.
+ */
+const reservation_manager_columns_index_t *
+    __reservation_manager_get_columns(const reservation_manager_t *manager) {
+    reservation_manager_columns_index_t *const columns = manager->columns;
+
+    pthread_mutex_lock(&columns->lock);
+    const int failure = __reservation_manager_build_columns(manager);
+    pthread_mutex_unlock(&columns->lock);
+    return failure ? NULL : columns;
+}
+
+const compressed_bitmap_t *
+    reservation_manager_get_bitmap(const reservation_manager_t       *manager,
+                                   reservation_manager_bitmap_field_t field,
+                                   uint32_t                           value) {
+
+    const reservation_manager_columns_index_t *const columns =
+        __reservation_manager_get_columns(manager);
+    if (!columns)
+        return NULL;
+
+    switch (field) {
+        case RESERVATION_MANAGER_BITMAP_STARS:
+            return value >= 1 && value <= RESERVATION_MANAGER_BITMAP_STARS_VALUES
+                       ? columns->hotel_stars_bitmaps[value - 1]
+                       : columns->empty_bitmap;
+        case RESERVATION_MANAGER_BITMAP_BREAKFAST:
+            return value < RESERVATION_MANAGER_BITMAP_BREAKFAST_VALUES
+                       ? columns->includes_breakfast_bitmaps[value]
+                       : columns->empty_bitmap;
+        default:
+            return columns->empty_bitmap;
+    }
+}
+
+/**
+ * @brief Iterates through a range of rows of a reservation manager's columns, in the calling
+ *        thread.
+ *
+ * @param range Range of rows of the columns, with the callback to be called.
+ *
+ * @return The return value of the last-called callback.
+ */
+int __reservation_manager_iter_columns_rows(const reservation_manager_columns_range_t *range) {
+    return __reservation_manager_iter_columns_range(
+        range,
+        0,
+        __reservation_manager_columns_range_get_nblocks(range));
+}
+
+/**
+ * @brief   Iterates through some blocks of a range of a reservation manager's columns.
+ * @details Auxiliary method for ::__reservation_manager_iter_columns_rows_parallel, called in each
+ *          thread.
+ *
+ * @param user_data A pointer to a ::reservation_manager_columns_range_t.
+ * @param begin     Index of the first block.
+ * @param end       Index of the block after the last one.
+ *
+ * @return The return value of the last-called callback.
+ */
+int __reservation_manager_iter_columns_range_callback(void *user_data, size_t begin, size_t end) {
+    return __reservation_manager_iter_columns_range(user_data, begin, end);
+}
+
+/**
+ * @brief Iterates through a range of rows of a reservation manager's columns, split across
+ *        threads.
+ *
+ * @param range     Range of rows of the columns, with the callback to be called.
+ *                  ::reservation_manager_columns_range_t::user_data isn't used.
+ * @param nthreads  Number of threads to split the iteration across. If `0`, `1` is assumed.
+ * @param user_data Array of @p nthreads pointers, one for the callbacks of each thread.
+ *
+ * @return The first non-zero value returned by the last callback of a thread, or `0` on success.
+ */
+int __reservation_manager_iter_columns_rows_parallel(
+    const reservation_manager_columns_range_t *range,
+    size_t                                     nthreads,
+    void *const                               *user_data) {
+
+    if (nthreads == 0)
+        nthreads = 1;
+
+    reservation_manager_columns_range_t data[nthreads];
+    void                               *data_pointers[nthreads];
+    for (size_t i = 0; i < nthreads; ++i) {
+        data[i]           = *range;
+        data[i].user_data = user_data[i];
+        data_pointers[i]  = &data[i];
+    }
+
+    return parallel_for(__reservation_manager_columns_range_get_nblocks(range),
+                        nthreads,
+                        __reservation_manager_iter_columns_range_callback,
+                        data_pointers);
+}
+
+/**
+ * @brief   Creates the range of rows of a reservation manager's columns to be iterated through.
+ * @details Auxiliary method for all public column-wise iterations.
+ *
+ * @param columns   Columns (::reservation_manager::columns), already built.
+ * @param dates     Range of two dates (inclusive) the stays of reservations must overlap, or `NULL`
+ *                  for all reservations to be iterated through.
+ * @param callback  Method called for every block of reservations in the range.
+ * @param user_data Argument passed to @p callback.
+ *
+ * @return The range of rows of @p columns.
+ */
+reservation_manager_columns_range_t
+    __reservation_manager_columns_range_create(const reservation_manager_columns_index_t *columns,
+                                               const date_t                              *dates,
+                                               reservation_manager_iter_columns_callback_t callback,
+                                               void *user_data) {
+
+    reservation_manager_columns_range_t range = {.columns   = columns,
+                                                 .first_row = 0,
+                                                 .last_row  = columns->n,
+                                                 .bounded   = dates != NULL,
+                                                 .begin     = dates ? dates[0] : 0,
+                                                 .end       = dates ? dates[1] : 0,
+                                                 .callback  = callback,
+                                                 .user_data = user_data};
+    if (dates)
+        __reservation_manager_get_partition_rows(columns,
+                                                 dates[0],
+                                                 dates[1],
+                                                 &range.first_row,
+                                                 &range.last_row);
+    return range;
+}
+
+int reservation_manager_iter_columns(const reservation_manager_t                *manager,
+                                     reservation_manager_iter_columns_callback_t callback,
+                                     void                                       *user_data) {
+
+    const reservation_manager_columns_index_t *const columns =
+        __reservation_manager_get_columns(manager);
+    if (!columns)
+        return 1;
+
+    const reservation_manager_columns_range_t range =
+        __reservation_manager_columns_range_create(columns, NULL, callback, user_data);
+    return __reservation_manager_iter_columns_rows(&range);
+}
+
+int reservation_manager_iter_columns_parallel(
+    const reservation_manager_t                *manager,
+    size_t                                      nthreads,
+    reservation_manager_iter_columns_callback_t callback,
+    void *const                                *user_data) {
+
+    const reservation_manager_columns_index_t *const columns =
+        __reservation_manager_get_columns(manager);
+    if (!columns)
+        return 1;
+
+    const reservation_manager_columns_range_t range =
+        __reservation_manager_columns_range_create(columns, NULL, callback, NULL);
+    return __reservation_manager_iter_columns_rows_parallel(&range, nthreads, user_data);
+}
+
+int reservation_manager_iter_columns_between(
+    const reservation_manager_t                *manager,
+    date_t                                      begin,
+    date_t                                      end,
+    reservation_manager_iter_columns_callback_t callback,
+    void                                       *user_data) {
+
+    const reservation_manager_columns_index_t *const columns =
+        __reservation_manager_get_columns(manager);
+    if (!columns)
+        return 1;
+
+    const date_t                              dates[2] = {begin, end};
+    const reservation_manager_columns_range_t range =
+        __reservation_manager_columns_range_create(columns, dates, callback, user_data);
+    return __reservation_manager_iter_columns_rows(&range);
+}
+
+int reservation_manager_iter_columns_between_parallel(
+    const reservation_manager_t                *manager,
+    date_t                                      begin,
+    date_t                                      end,
+    size_t                                      nthreads,
+    reservation_manager_iter_columns_callback_t callback,
+    void *const                                *user_data) {
+
+    const reservation_manager_columns_index_t *const columns =
+        __reservation_manager_get_columns(manager);
+    if (!columns)
+        return 1;
+
+    const date_t                              dates[2] = {begin, end};
+    const reservation_manager_columns_range_t range =
+        __reservation_manager_columns_range_create(columns, dates, callback, NULL);
+    return __reservation_manager_iter_columns_rows_parallel(&range, nthreads, user_data);
+}
+
+int reservation_manager_get_columns(const reservation_manager_t   *manager,
+                                    reservation_manager_columns_t *columns,
+                                    size_t                        *n) {
+
+    const reservation_manager_columns_index_t *const index =
+        __reservation_manager_get_columns(manager);
+    if (!index)
+        return 1;
+
+    columns->id                 = index->id;
+    columns->hotel_id           = index->hotel_id;
+    columns->hotel_stars        = index->hotel_stars;
+    columns->begin_date         = index->begin_date;
+    columns->end_date           = index->end_date;
+    columns->price_per_night    = index->price_per_night;
+    columns->city_tax           = index->city_tax;
+    columns->rating             = index->rating;
+    columns->includes_breakfast = index->includes_breakfast;
+    *n                          = index->n;
+    return 0;
+}
+
+/**
+ * @brief   Counts a reservation in the number of reservations of its hotel.
+ * @details Auxiliary method for ::__reservation_manager_build_hotel_index.
+ *
+ * @param user_data   A pointer to a ::reservation_manager_hotel_index_t.
+ * @param reservation Reservation to be counted.
+ *
+ * @retval 0 Always successful.
+ */
+int __reservation_manager_build_hotel_index_count(void                *user_data,
+                                                  const reservation_t *reservation) {
+    reservation_manager_hotel_index_t *const index = user_data;
+    index->offsets[reservation_get_hotel_id(reservation) + 1]++;
+    return 0;
+}
+
+/**
+ * @struct reservation_manager_hotel_index_sort_t
+ * @brief  Reservations being sorted by ::__reservation_manager_build_hotel_index.
+ *
+ * @var reservation_manager_hotel_index_sort_t::items
+ *     @brief Reservations and their sort keys (see ::__reservation_manager_hotel_index_key).
+ * @var reservation_manager_hotel_index_sort_t::n
+ *     @brief Number of reservations already added to
+ *            ::reservation_manager_hotel_index_sort_t::items.
+ */
+typedef struct {
+    radix_sort_item_t *items;
+    size_t             n;
+} reservation_manager_hotel_index_sort_t;
+
+/**
+ * @brief  Packs the order of a reservation within its hotel in a ::radix_sort_item_t::key.
+ * @param  reservation Reservation to get the key of.
+ * @return The begin date of @p reservation, inverted so that latest dates come first, in the most
+ *         significant bits, and the identifier of @p reservation in the least significant ones.
+ */
+uint64_t __reservation_manager_hotel_index_key(const reservation_t *reservation) {
+    return (uint64_t) (UINT32_MAX - reservation_get_begin_date(reservation)) << 32 |
+           reservation_get_id(reservation);
+}
+
+/**
+ * @brief   Adds a reservation to the ones to be sorted in a hotel index.
+ * @details Auxiliary method for ::__reservation_manager_build_hotel_index.
+ *
+ * @param user_data   A pointer to a ::reservation_manager_hotel_index_sort_t.
+ * @param reservation Reservation to be added.
+ *
+ * @retval 0 Always successful.
+ */
+int __reservation_manager_build_hotel_index_add(void *user_data, const reservation_t *reservation) {
+    reservation_manager_hotel_index_sort_t *const sort = user_data;
+    sort->items[sort->n++] =
+        (radix_sort_item_t){.key   = __reservation_manager_hotel_index_key(reservation),
+                            .value = reservation};
+    return 0;
+}
+
+/**
+ * @brief   Builds the index of reservations by hotel of a reservation manager.
+ * @details All reservations are sorted by date and identifier with a radix sort, and then grouped
+ *          by hotel with a counting sort, which keeps each hotel's reservations in order. The dates
+ *          and prices of reservations are copied into columns in that same order.
+ *
+ * @param manager Manager whose ::reservation_manager::hotel_index is to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __reservation_manager_build_hotel_index(const reservation_manager_t *manager) {
+    reservation_manager_hotel_index_t *const index = manager->hotel_index;
+
+    index->offsets = calloc(RESERVATION_MANAGER_NUMBER_OF_HOTELS + 1, sizeof(size_t));
+    if (!index->offsets)
+        return 1;
+
+    const cancellation_t *const cancellation = cancellation_suspend();
+    reservation_manager_iter(manager, __reservation_manager_build_hotel_index_count, index);
+    cancellation_set_current(cancellation);
+    for (size_t i = 1; i <= RESERVATION_MANAGER_NUMBER_OF_HOTELS; ++i)
+        index->offsets[i] += index->offsets[i - 1];
+
+    const size_t n         = index->offsets[RESERVATION_MANAGER_NUMBER_OF_HOTELS];
+    index->reservations    = malloc(sizeof(const reservation_t *) * n);
+    index->begin_date      = malloc(sizeof(date_t) * n);
+    index->end_date        = malloc(sizeof(date_t) * n);
+    index->price_per_night = malloc(sizeof(uint16_t) * n);
+    if (n && (!index->reservations || !index->begin_date || !index->end_date ||
+              !index->price_per_night))
+        goto DEFER_2;
+
+    reservation_manager_hotel_index_sort_t sort = {.items = malloc(sizeof(radix_sort_item_t) * n),
+                                                   .n     = 0};
+    if (!sort.items && n)
+        goto DEFER_2;
+
+    radix_sort_item_t *const tmp = malloc(sizeof(radix_sort_item_t) * n);
+    if (!tmp && n)
+        goto DEFER_3;
+
+    cancellation_set_current(NULL);
+    reservation_manager_iter(manager, __reservation_manager_build_hotel_index_add, &sort);
+    cancellation_set_current(cancellation);
+    radix_sort(sort.items, tmp, n);
+    free(tmp);
+
+    /* Placing moves each offset to the beginning of the next hotel. Shift them back afterwards. */
+    for (size_t i = 0; i < n; ++i) {
+        const reservation_t *const reservation = sort.items[i].value;
+        const hotel_id_t           hotel       = reservation_get_hotel_id(reservation);
+        const size_t               position    = index->offsets[hotel]++;
+
+        index->reservations[position]    = reservation;
+        index->begin_date[position]      = reservation_get_begin_date(reservation);
+        index->end_date[position]        = reservation_get_end_date(reservation);
+        index->price_per_night[position] = reservation_get_price_per_night(reservation);
+    }
+    free(sort.items);
+
+    memmove(index->offsets + 1,
+            index->offsets,
+            sizeof(size_t) * RESERVATION_MANAGER_NUMBER_OF_HOTELS);
+    index->offsets[0] = 0;
+
+    index->built = 1;
+    return 0;
+
+DEFER_3:
+    free(sort.items);
+DEFER_2:
+    free(index->reservations);
+    free(index->begin_date);
+    free(index->end_date);
+    free(index->price_per_night);
+    index->reservations    = NULL;
+    index->begin_date      = NULL;
+    index->end_date        = NULL;
+    index->price_per_night = NULL;
+    free(index->offsets);
+    index->offsets = NULL;
+    return 1;
+}
+
+/**
+ * @brief   Counts a reservation in a reservation manager's pool.
+ * @details Auxiliary method for ::reservation_manager_cluster.
+ *
+ * @param user_data   A pointer to a `size_t` to be incremented.
+ * @param reservation Reservation to be counted.
+ *
+ * @retval 0 Always successful.
+ */
+int __reservation_manager_cluster_count(void *user_data, const reservation_t *reservation) {
+    (void) reservation;
+    (*(size_t *) user_data)++;
+    return 0;
+}
+
+int reservation_manager_cluster(reservation_manager_t *manager) {
+    /* Reservations whose identifiers were repeated are in the pool (but not in the map) too */
+    const cancellation_t *const cancellation = cancellation_suspend();
+    size_t                      n            = 0;
+    reservation_manager_iter(manager, __reservation_manager_cluster_count, &n);
+    cancellation_set_current(cancellation);
+
+    int                                    retval = 1;
+    reservation_manager_hotel_index_sort_t sort   = {.items = malloc(sizeof(radix_sort_item_t) * n),
+                                                     .n     = 0};
+    if (!sort.items && n)
+        return 1;
+
+    radix_sort_item_t *const tmp = malloc(sizeof(radix_sort_item_t) * n);
+    if (!tmp && n)
+        goto DEFER_1;
+
+    /* Moved reservations that ::reservation_manager::id_reservations_rel must point to */
+    reservation_t **const moved  = malloc(sizeof(reservation_t *) * n);
+    size_t                nmoved = 0;
+    if (!moved && n)
+        goto DEFER_2;
+
+    pool_t *reservations =
+        pool_create_from_size_with_policy(reservation_sizeof(),
+                                          RESERVATION_MANAGER_RESERVATIONS_POOL_BLOCK_CAPACITY,
+                                          BLOCK_ALLOCATOR_POLICY_HUGE_PAGES);
+    if (!reservations)
+        goto DEFER_3;
+    if (pool_reserve(reservations, n))
+        goto DEFER_4;
+
+    /* Same order as the hotel index, so that each hotel's reservations are contiguous */
+    cancellation_set_current(NULL);
+    reservation_manager_iter(manager, __reservation_manager_build_hotel_index_add, &sort);
+    cancellation_set_current(cancellation);
+    radix_sort(sort.items, tmp, n);
+    for (size_t i = 0; i < n; ++i)
+        sort.items[i].key = reservation_get_hotel_id(sort.items[i].value);
+    radix_sort(sort.items, tmp, n);
+
+    for (size_t i = 0; i < n; ++i) {
+        const reservation_t *const reservation = sort.items[i].value;
+        reservation_t *const       clone       = reservation_clone(reservations,
+                                                        manager->hotel_names,
+                                                        manager->hotel_names,
+                                                        reservation);
+        if (!clone)
+            goto DEFER_4;
+
+        /* Reservations whose identifiers were repeated are kept, but they can't be looked up */
+        if (id_map_lookup(manager->id_reservations_rel, reservation_get_id(reservation)) ==
+            reservation)
+            moved[nmoved++] = clone;
+    }
+
+    /* Replacing identifiers that are already in the map doesn't allocate */
+    for (size_t i = 0; i < nmoved; ++i)
+        id_map_insert(manager->id_reservations_rel, reservation_get_id(moved[i]), moved[i]);
+
+    __reservation_manager_invalidate_hotel_index(manager);
+    __reservation_manager_invalidate_columns(manager->columns);
+
+    /* Free the old pool instead of the new one */
+    pool_t *const old_reservations = manager->reservations;
+    manager->reservations          = reservations;
+    reservations                   = old_reservations;
+    retval                         = 0;
+
+DEFER_4:
+    pool_free(reservations);
+DEFER_3:
+    free(moved);
+DEFER_2:
+    free(tmp);
+DEFER_1:
+    free(sort.items);
+    return retval;
+}
+
+int reservation_manager_iter_hotel(const reservation_manager_t        *manager,
+                                   hotel_id_t                          hotel,
+                                   reservation_manager_iter_callback_t callback,
+                                   void                               *user_data) {
+    return reservation_manager_iter_hotel_range(manager, hotel, 0, SIZE_MAX, callback, user_data);
+}
+
+int reservation_manager_iter_hotel_range(const reservation_manager_t        *manager,
+                                         hotel_id_t                          hotel,
+                                         size_t                              offset,
+                                         size_t                              limit,
+                                         reservation_manager_iter_callback_t callback,
+                                         void                               *user_data) {
+
+    reservation_manager_hotel_index_t *const index = manager->hotel_index;
+
+    pthread_mutex_lock(&index->lock);
+    const int failure = !index->built && __reservation_manager_build_hotel_index(manager);
+    pthread_mutex_unlock(&index->lock);
+    if (failure)
+        return 1;
+
+    const reservation_manager_hotel_replica_t *const replica =
+        __reservation_manager_get_hotel_replica(index);
+    const size_t *const               offsets = replica ? replica->offsets : index->offsets;
+    const reservation_t *const *const reservations =
+        replica ? replica->reservations : index->reservations;
+
+    /* A hotel's reservations are contiguous in the index, so the range is sliced directly */
+    const size_t count = offsets[hotel + 1] - offsets[hotel];
+    const size_t first = offsets[hotel] + min(offset, count);
+    const size_t last  = first + min(limit, offsets[hotel + 1] - first);
+
+    for (size_t i = first; i < last; ++i) {
+        if ((i - first) % CANCELLATION_CHECK_INTERVAL == 0 && cancellation_check())
+            return CANCELLATION_ITER_RET;
+
+        const int retval = callback(user_data, reservations[i]);
+        if (retval)
+            return retval;
+    }
+    return 0;
+}
+
+int reservation_manager_get_hotel_columns(const reservation_manager_t         *manager,
+                                          hotel_id_t                           hotel,
+                                          reservation_manager_hotel_columns_t *columns,
+                                          size_t                              *n) {
+
+    reservation_manager_hotel_index_t *const index = manager->hotel_index;
+
+    pthread_mutex_lock(&index->lock);
+    const int failure = !index->built && __reservation_manager_build_hotel_index(manager);
+    pthread_mutex_unlock(&index->lock);
+    if (failure)
+        return 1;
+
+    const size_t first       = index->offsets[hotel];
+    columns->begin_date      = index->begin_date + first;
+    columns->end_date        = index->end_date + first;
+    columns->price_per_night = index->price_per_night + first;
+    *n                       = index->offsets[hotel + 1] - first;
+    return 0;
+}
+
+/**
+ * @brief Builds the index of hotels by identifier of a reservation manager.
+ *
+ * @param manager Manager whose ::reservation_manager_hotel_index_t::ids is to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __reservation_manager_build_hotel_id_index(const reservation_manager_t *manager) {
+    prefix_index_t *const ids = prefix_index_create();
+    if (!ids)
+        return 1;
+
+    /* Hotels are known from their ratings, without iterating through all reservations */
+    for (size_t i = 0; i < RESERVATION_MANAGER_NUMBER_OF_HOTELS; ++i) {
+        if (!manager->hotel_ratings[i].count)
+            continue;
+
+        char id[HOTEL_ID_SPRINTF_MIN_BUFFER_SIZE];
+        hotel_id_sprintf(id, i);
+        if (prefix_index_add_copy(ids, id)) {
+            prefix_index_free(ids);
+            return 1;
+        }
+    }
+
+    prefix_index_build(ids);
+    manager->hotel_index->ids = ids;
+    return 0;
+}
+
+int reservation_manager_iter_hotel_id_prefix(const reservation_manager_t *manager,
+                                             const char                  *prefix,
+                                             prefix_index_iter_callback_t callback,
+                                             void                        *user_data) {
+
+    reservation_manager_hotel_index_t *const index = manager->hotel_index;
+
+    pthread_mutex_lock(&index->lock);
+    const int failure = !index->ids && __reservation_manager_build_hotel_id_index(manager);
+    pthread_mutex_unlock(&index->lock);
+    if (failure)
+        return 1;
+
+    return prefix_index_iter_prefix(index->ids, prefix, callback, user_data);
+}
+
+/**
+ * @struct reservation_manager_replicate_data_t
+ * @brief  Type of `user_data` parameter in ::__reservation_manager_replicate_indexes_callback.
+ *
+ * @var reservation_manager_replicate_data_t::manager
+ *     @brief Manager whose indices are being replicated.
+ */
+typedef struct {
+    const reservation_manager_t *manager;
+} reservation_manager_replicate_data_t;
+
+/**
+ * @brief   Builds the replica of the indices of hotels of a reservation manager for a NUMA node.
+ * @details Auxiliary method for ::reservation_manager_replicate_indexes, called in a thread pinned
+ *          to @p node, so that the replica is allocated in the node's memory.
+ *
+ * @param user_data A pointer to a ::reservation_manager_replicate_data_t.
+ * @param node      Node to build the replica for.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __reservation_manager_replicate_indexes_callback(void *user_data, size_t node) {
+    const reservation_manager_replicate_data_t *const replicate_data = user_data;
+    const reservation_manager_t *const                manager        = replicate_data->manager;
+    const reservation_manager_hotel_index_t *const    index          = manager->hotel_index;
+    reservation_manager_hotel_replica_t *const        replica        = &index->replicas[node];
+
+    const size_t n         = index->offsets[RESERVATION_MANAGER_NUMBER_OF_HOTELS];
+    const size_t ratings   = sizeof(reservation_manager_hotel_ratings_t) *
+                             RESERVATION_MANAGER_NUMBER_OF_HOTELS;
+    const size_t offsets   = sizeof(size_t) * (RESERVATION_MANAGER_NUMBER_OF_HOTELS + 1);
+    replica->hotel_ratings = malloc(ratings);
+    replica->offsets       = malloc(offsets);
+    replica->reservations  = malloc(sizeof(const reservation_t *) * max(n, 1));
+    if (!replica->hotel_ratings || !replica->offsets || !replica->reservations)
+        return 1;
+
+    memcpy(replica->hotel_ratings, manager->hotel_ratings, ratings);
+    memcpy(replica->offsets, index->offsets, offsets);
+    if (n)
+        memcpy(replica->reservations, index->reservations, sizeof(const reservation_t *) * n);
+    return 0;
+}
+
+int reservation_manager_replicate_indexes(const reservation_manager_t *manager,
+                                          const numa_topology_t       *topology) {
+
+    reservation_manager_hotel_index_t *const index  = manager->hotel_index;
+    const size_t                             nnodes = numa_topology_get_node_count(topology);
+    int                                      retval = 1;
+
+    pthread_mutex_lock(&index->lock);
+    __reservation_manager_free_hotel_replicas(index);
+    if (!index->built && __reservation_manager_build_hotel_index(manager))
+        goto DEFER_1;
+
+    index->replicas = calloc(nnodes, sizeof(reservation_manager_hotel_replica_t));
+    if (!index->replicas)
+        goto DEFER_1;
+    index->nreplicas = nnodes;
+
+    reservation_manager_replicate_data_t replicate_data = {.manager = manager};
+    retval = numa_topology_run_on_nodes(topology,
+                                        __reservation_manager_replicate_indexes_callback,
+                                        &replicate_data);
+    if (retval)
+        __reservation_manager_free_hotel_replicas(index);
+
+DEFER_1:
+    pthread_mutex_unlock(&index->lock);
+    return retval;
+}
+
+int reservation_manager_build_index(const reservation_manager_t *manager,
+                                    reservation_manager_index_t  index) {
+    reservation_manager_hotel_index_t *const hotels = manager->hotel_index;
+
+    int failure = 0;
+    switch (index) {
+        case RESERVATION_MANAGER_INDEX_COLUMNS:
+            pthread_mutex_lock(&manager->columns->lock);
+            failure = __reservation_manager_build_columns(manager);
+            pthread_mutex_unlock(&manager->columns->lock);
+            break;
+        case RESERVATION_MANAGER_INDEX_HOTELS:
+            pthread_mutex_lock(&hotels->lock);
+            failure = !hotels->built && __reservation_manager_build_hotel_index(manager);
+            pthread_mutex_unlock(&hotels->lock);
+            break;
+        case RESERVATION_MANAGER_INDEX_HOTEL_IDS:
+            pthread_mutex_lock(&hotels->lock);
+            failure = !hotels->ids && __reservation_manager_build_hotel_id_index(manager);
+            pthread_mutex_unlock(&hotels->lock);
+            break;
+        default:
+            break;
+    }
+    return failure;
+}
+
+size_t reservation_manager_get_memory_usage(const reservation_manager_t *manager) {
+    size_t total =
+        sizeof(reservation_manager_t) + pool_get_memory_usage(manager->reservations) +
+        string_dictionary_get_memory_usage(manager->hotel_names) +
+        id_map_get_memory_usage(manager->id_reservations_rel) +
+        RESERVATION_MANAGER_NUMBER_OF_HOTELS * sizeof(reservation_manager_hotel_ratings_t);
+
+    reservation_manager_hotel_index_t *const index = manager->hotel_index;
+    pthread_mutex_lock(&index->lock);
+    total += sizeof(reservation_manager_hotel_index_t);
+    if (index->ids)
+        total += prefix_index_get_memory_usage(index->ids);
+    if (index->built)
+        total += (index->nreplicas + 1) *
+                     ((RESERVATION_MANAGER_NUMBER_OF_HOTELS + 1) * sizeof(size_t) +
+                      index->offsets[RESERVATION_MANAGER_NUMBER_OF_HOTELS] *
+                          sizeof(const reservation_t *)) +
+                 index->offsets[RESERVATION_MANAGER_NUMBER_OF_HOTELS] *
+                     (2 * sizeof(date_t) + sizeof(uint16_t));
+    total += index->nreplicas * (sizeof(reservation_manager_hotel_replica_t) +
+                                 RESERVATION_MANAGER_NUMBER_OF_HOTELS *
+                                     sizeof(reservation_manager_hotel_ratings_t));
+    pthread_mutex_unlock(&index->lock);
+
+    reservation_manager_columns_index_t *const columns = manager->columns;
+    pthread_mutex_lock(&columns->lock);
+    total += sizeof(reservation_manager_columns_index_t);
+    if (columns->built) {
+        total += (columns->n + 1) * (sizeof(reservation_id_t) + sizeof(hotel_id_t) +
+                                     2 * sizeof(date_t) + sizeof(uint16_t) + 3 * sizeof(uint8_t) +
+                                     sizeof(includes_breakfast_t)) +
+                 (columns->npartitions + 1) * sizeof(size_t) +
+                 ((columns->n + RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY - 1) /
+                      RESERVATION_MANAGER_COLUMNS_BLOCK_CAPACITY +
+                  1) * sizeof(reservation_manager_columns_zone_t);
+
+        for (size_t i = 0; i < RESERVATION_MANAGER_BITMAP_STARS_VALUES; ++i)
+            total += compressed_bitmap_get_memory_usage(columns->hotel_stars_bitmaps[i]);
+        for (size_t i = 0; i < RESERVATION_MANAGER_BITMAP_BREAKFAST_VALUES; ++i)
+            total += compressed_bitmap_get_memory_usage(columns->includes_breakfast_bitmaps[i]);
+        total += compressed_bitmap_get_memory_usage(columns->empty_bitmap);
+    }
+    pthread_mutex_unlock(&columns->lock);
+
+    return total;
+}
+
+size_t reservation_manager_get_strings_memory_usage(const reservation_manager_t *manager) {
+    return string_dictionary_get_memory_usage(manager->hotel_names);
+}
+
 void reservation_manager_free(reservation_manager_t *manager) {
     pool_free(manager->reservations);
-    string_pool_no_duplicates_free(manager->hotel_name_pool);
-    string_pool_free(manager->user_id_pool);
-    g_hash_table_unref(manager->id_reservations_rel);
+    string_dictionary_free(manager->hotel_names);
+    id_map_free(manager->id_reservations_rel);
+    free(manager->hotel_ratings);
+
+    __reservation_manager_invalidate_hotel_index(manager);
+    pthread_mutex_destroy(&manager->hotel_index->lock);
+    free(manager->hotel_index);
+
+    __reservation_manager_invalidate_columns(manager->columns);
+    pthread_mutex_destroy(&manager->columns->lock);
+    free(manager->columns);
     free(manager);
 }
@@ -22,29 +22,233 @@
  * See [the header file's documentation](@ref user_manager_examples).
  */
 
+#include <glib.h>
+#include <pthread.h>
 #include <stdio.h> /* For panic purporses */
 #include <stdlib.h>
+#include <string.h>
 
 #include "database/user_manager.h"
-#include "utils/glib/GConstKeyHashTable.h"
+#include "utils/bucket_builder.h"
+#include "utils/cancellation.h"
+#include "utils/collation.h"
+#include "utils/id_hash_table.h"
+#include "utils/int_utils.h"
+#include "utils/numa_topology.h"
+#include "utils/parallel_sort.h"
+#include "utils/prefetch.h"
+#include "utils/prefix_index.h"
+#include "utils/radix_tree.h"
+#include "utils/scratch_arena.h"
+#include "utils/single_pool_id_linked_list.h"
+#include "utils/string_hash_table.h"
+#include "utils/varint.h"
 
 /**
- * @struct user_manager_user_and_data_t
- * @brief  A structure that contains a user and its related flight and reservation history.
+ * @struct  user_manager_user_and_data_t
+ * @brief   A structure that contains a user and its related flight and reservation history.
+ * @details Associations are kept in linked lists while they're being added, and moved to the
+ *          compressed contiguous arrays in ::user_manager_associations_t when they're first
+ *          needed.
  *
  * @var user_manager_user_and_data_t::user
  *     @brief User data.
- * @var user_manager_user_and_data_t::flights
- *     @brief Flight data for ::user_manager_user_and_data_t::user.
- * @var user_manager_user_and_data_t::reservations
- *     @brief Reservation data for ::user_manager_user_and_data_t::user.
+ * @var user_manager_user_and_data_t::new_flights
+ *     @brief Flights of ::user_manager_user_and_data_t::user not yet in
+ *            ::user_manager_associations_t::flights.
+ * @var user_manager_user_and_data_t::new_reservations
+ *     @brief Reservations of ::user_manager_user_and_data_t::user not yet in
+ *            ::user_manager_associations_t::reservations.
+ * @var user_manager_user_and_data_t::flights_offset
+ *     @brief Index of the first byte of the flights of ::user_manager_user_and_data_t::user in
+ *            ::user_manager_associations_t::flights.
+ * @var user_manager_user_and_data_t::reservations_offset
+ *     @brief Index of the first byte of the reservations of ::user_manager_user_and_data_t::user
+ *            in ::user_manager_associations_t::reservations.
+ * @var user_manager_user_and_data_t::nflights
+ *     @brief Number of flights of ::user_manager_user_and_data_t::user encoded in
+ *            ::user_manager_associations_t::flights.
+ * @var user_manager_user_and_data_t::nreservations
+ *     @brief Number of reservations of ::user_manager_user_and_data_t::user encoded in
+ *            ::user_manager_associations_t::reservations.
+ * @var user_manager_user_and_data_t::nnew_flights
+ *     @brief Number of elements in ::user_manager_user_and_data_t::new_flights.
+ * @var user_manager_user_and_data_t::nnew_reservations
+ *     @brief Number of elements in ::user_manager_user_and_data_t::new_reservations.
+ * @var user_manager_user_and_data_t::total_spent
+ *     @brief Sum of the prices of all reservations of ::user_manager_user_and_data_t::user, in
+ *            cents.
+ * @var user_manager_user_and_data_t::ordinal
+ *     @brief Ordinal of ::user_manager_user_and_data_t::user (its index in
+ *            ::user_manager::ordinals_rel).
  */
 typedef struct {
     const user_t *const           user;
-    single_pool_id_linked_list_t *flights;
-    single_pool_id_linked_list_t *reservations;
+    single_pool_id_linked_list_t *new_flights;
+    single_pool_id_linked_list_t *new_reservations;
+    size_t                        flights_offset, reservations_offset;
+    uint32_t                      nflights, nreservations;
+    uint32_t                      nnew_flights, nnew_reservations;
+    uint64_t                      total_spent;
+    user_ordinal_t                ordinal;
 } user_manager_user_and_data_t;
 
+/**
+ * @struct  user_manager_associations_t
+ * @brief   Flights and reservations of all users, stored contiguously (one slice per user).
+ * @details Built when it's first needed, and updated when more associations are added. Each slice
+ *          is compressed with ::varint_encode_deltas, and decoded when it's looked up.
+ *
+ * @var user_manager_associations_t::lock
+ *     @brief Lock that protects the arrays from being built by multiple threads.
+ * @var user_manager_associations_t::compacted
+ *     @brief Whether there are no associations left in linked lists.
+ * @var user_manager_associations_t::flights
+ *     @brief Flights of all users (see ::user_manager_user_and_data_t::flights_offset).
+ * @var user_manager_associations_t::reservations
+ *     @brief Reservations of all users (see ::user_manager_user_and_data_t::reservations_offset).
+ * @var user_manager_associations_t::flights_size
+ *     @brief Number of bytes in ::user_manager_associations_t::flights.
+ * @var user_manager_associations_t::reservations_size
+ *     @brief Number of bytes in ::user_manager_associations_t::reservations.
+ * @var user_manager_associations_t::max_nflights
+ *     @brief Maximum number of flights of a single user.
+ * @var user_manager_associations_t::flight_date
+ *     @brief Method used to sort the flights of each user. Can be `NULL`.
+ * @var user_manager_associations_t::reservation_date
+ *     @brief Method used to sort the reservations of each user. Can be `NULL`.
+ * @var user_manager_associations_t::date_data
+ *     @brief Pointer passed to ::user_manager_associations_t::flight_date and
+ *            ::user_manager_associations_t::reservation_date.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int             compacted;
+    uint8_t        *flights, *reservations;
+    size_t          flights_size, reservations_size;
+    uint32_t        max_nflights;
+
+    user_manager_association_date_callback_t flight_date, reservation_date;
+    const void                              *date_data;
+} user_manager_associations_t;
+
+/**
+ * @struct user_manager_name_index_entry_t
+ * @brief  A user in a ::user_manager_name_index_t.
+ *
+ * @var user_manager_name_index_entry_t::user
+ *     @brief User in the index.
+ * @var user_manager_name_index_entry_t::rank
+ *     @brief Position of ::user_manager_name_index_entry_t::user when all users are sorted by name
+ *            and identifier, in the collation order of ::COLLATION_LOCALE.
+ */
+typedef struct {
+    const user_t *user;
+    size_t        rank;
+} user_manager_name_index_entry_t;
+
+/**
+ * @struct  user_manager_name_index_t
+ * @brief   Indices of users by name and by identifier, for prefix lookups.
+ * @details Each is built when it's first needed, and discarded when a new user is added.
+ *
+ * @var user_manager_name_index_t::lock
+ *     @brief Lock that protects the indices from being built by multiple threads.
+ * @var user_manager_name_index_t::built
+ *     @brief Whether ::user_manager_name_index_t::entries is up-to-date.
+ * @var user_manager_name_index_t::entries
+ *     @brief Users, sorted by name (byte order), so that all users with names starting with the
+ *            same prefix are contiguous.
+ * @var user_manager_name_index_t::n
+ *     @brief Number of elements in ::user_manager_name_index_t::entries.
+ * @var user_manager_name_index_t::ids
+ *     @brief Users' data (::user_manager_user_and_data_t) by identifier, for ordered and prefix
+ *            iterations (::user_manager_iter_id_prefix). `NULL` until needed.
+ * @var user_manager_name_index_t::replicas
+ *     @brief Copies of ::user_manager_name_index_t::entries in every NUMA node, indexed by node
+ *            (see ::user_manager_replicate_indexes). `NULL` if not replicated.
+ * @var user_manager_name_index_t::nreplicas
+ *     @brief Number of elements in ::user_manager_name_index_t::replicas.
+ */
+typedef struct {
+    pthread_mutex_t                   lock;
+    int                               built;
+    user_manager_name_index_entry_t  *entries;
+    size_t                            n;
+    radix_tree_t                     *ids;
+    user_manager_name_index_entry_t **replicas;
+    size_t                            nreplicas;
+} user_manager_name_index_t;
+
+/** @brief Number of values of ::account_status_t and of ::sex_t. */
+#define USER_MANAGER_BITMAP_TWO_VALUES 2
+
+/**
+ * @struct  user_manager_bitmap_index_t
+ * @brief   Bitmaps of user ordinals for every value of every ::user_manager_bitmap_field_t.
+ * @details Built when first needed by ::user_manager_get_bitmap, and discarded when a user is
+ *          added.
+ *
+ * @var user_manager_bitmap_index_t::lock
+ *     @brief Lock that protects the index from being built by multiple threads.
+ * @var user_manager_bitmap_index_t::built
+ *     @brief Whether the index is up-to-date.
+ * @var user_manager_bitmap_index_t::account_status
+ *     @brief Users with each ::account_status_t.
+ * @var user_manager_bitmap_index_t::sex
+ *     @brief Users with each ::sex_t.
+ * @var user_manager_bitmap_index_t::countries
+ *     @brief `GPtrArray` of ::compressed_bitmap_t's, users in each country.
+ * @var user_manager_bitmap_index_t::country_ordinals
+ *     @brief ::id_hash_table_t that associates ::country_code_t's with their index (plus one) in
+ *            ::user_manager_bitmap_index_t::countries.
+ * @var user_manager_bitmap_index_t::empty
+ *     @brief Empty bitmap, returned for values no user has.
+ */
+typedef struct {
+    pthread_mutex_t      lock;
+    int                  built;
+    compressed_bitmap_t *account_status[USER_MANAGER_BITMAP_TWO_VALUES];
+    compressed_bitmap_t *sex[USER_MANAGER_BITMAP_TWO_VALUES];
+    GPtrArray           *countries;
+    id_hash_table_t     *country_ordinals;
+    compressed_bitmap_t *empty;
+} user_manager_bitmap_index_t;
+
+/**
+ * @struct  user_manager_passenger_index_t
+ * @brief   Reverse index of the flights of all users: the users (passengers) of every flight.
+ * @details Kept in compressed sparse row form. Built when first needed by
+ *          ::user_manager_get_passengers_by_flight, and discarded when flight associations (or
+ *          users) are added.
+ *
+ * @var user_manager_passenger_index_t::lock
+ *     @brief Lock that protects the index from being built by multiple threads.
+ * @var user_manager_passenger_index_t::built
+ *     @brief Whether the index is up-to-date.
+ * @var user_manager_passenger_index_t::flights
+ *     @brief ::id_hash_table_t that associates ::flight_id_t's with their index (plus one) in
+ *            ::user_manager_passenger_index_t::offsets.
+ * @var user_manager_passenger_index_t::offsets
+ *     @brief   Index of the first passenger of every flight in
+ *              ::user_manager_passenger_index_t::users.
+ *     @details Has ::user_manager_passenger_index_t::nflights plus one elements, the last one
+ *              being the total number of passengers.
+ * @var user_manager_passenger_index_t::users
+ *     @brief Ordinals of the passengers of every flight, one flight after the other (and in
+ *            ascending order in each flight).
+ * @var user_manager_passenger_index_t::nflights
+ *     @brief Number of flights in ::user_manager_passenger_index_t::flights.
+ */
+typedef struct {
+    pthread_mutex_t  lock;
+    int              built;
+    id_hash_table_t *flights;
+    size_t          *offsets;
+    user_ordinal_t  *users;
+    size_t           nflights;
+} user_manager_passenger_index_t;
+
 /**
  * @struct user_manager
  * @brief  A data type that contains and manages all users in a database.
@@ -54,19 +258,36 @@ typedef struct {
  * @var user_manager::user_data
  *     @brief Allocator for user data (::user_manager_user_and_data_t) in the manager.
  * @var user_manager::ll_nodes
- *     @brief Allocator for linked list nodes.
+ *     @brief Allocator for linked list nodes of associations not yet in
+ *            ::user_manager::associations.
  * @var user_manager::strings
  *     @brief Allocator for strings stored in users.
  * @var user_manager::id_users_rel
  *     @brief Hash table for user identifier (`const char *`) -> user_manager_user_and_data_t
  *            mapping.
+ * @var user_manager::ordinals_rel
+ *     @brief Array for ::user_ordinal_t -> ::user_manager_user_and_data_t mapping.
+ * @var user_manager::name_index
+ *     @brief Index of users by name, for ::user_manager_iter_name_prefix.
+ * @var user_manager::bitmap_index
+ *     @brief Bitmaps of users by field values, for ::user_manager_get_bitmap.
+ * @var user_manager::passenger_index
+ *     @brief Users of every flight, for ::user_manager_get_passengers_by_flight.
+ * @var user_manager::associations
+ *     @brief Flights and reservations of all users.
  */
 struct user_manager {
     pool_t             *users;
     pool_t             *user_data;
     pool_t             *ll_nodes;
     string_pool_t      *strings;
-    GConstKeyHashTable *id_users_rel;
+    string_hash_table_t *id_users_rel;
+    GPtrArray           *ordinals_rel;
+
+    user_manager_name_index_t      *name_index;
+    user_manager_bitmap_index_t    *bitmap_index;
+    user_manager_passenger_index_t *passenger_index;
+    user_manager_associations_t    *associations;
 };
 
 /** @brief Number of users in each block of ::user_manager::users and ::user_manager::user_data. */
@@ -78,12 +299,17 @@ struct user_manager {
 /** @brief Number of characters in each block of ::user_manager::strings. */
 #define USER_MANAGER_STRINGS_POOL_BLOCK_CAPACITY 100000
 
+/** @brief Number of characters in each block of the pool of collation keys. */
+#define USER_MANAGER_NAME_INDEX_KEYS_POOL_BLOCK_CAPACITY (1 << 20)
+
 user_manager_t *user_manager_create(void) {
     user_manager_t *const manager = malloc(sizeof(user_manager_t));
     if (!manager)
         goto DEFER_1;
 
-    manager->users = pool_create_from_size(user_sizeof(), USER_MANAGER_USERS_POOL_BLOCK_CAPACITY);
+    manager->users = pool_create_from_size_with_policy(user_sizeof(),
+                                                       USER_MANAGER_USERS_POOL_BLOCK_CAPACITY,
+                                                       BLOCK_ALLOCATOR_POLICY_HUGE_PAGES);
     if (!manager->users)
         goto DEFER_2;
 
@@ -101,9 +327,77 @@ user_manager_t *user_manager_create(void) {
     if (!manager->strings)
         goto DEFER_5;
 
-    manager->id_users_rel = g_const_key_hash_table_new(g_str_hash, g_str_equal);
+    manager->name_index = malloc(sizeof(user_manager_name_index_t));
+    if (!manager->name_index)
+        goto DEFER_6;
+
+    if (pthread_mutex_init(&manager->name_index->lock, NULL))
+        goto DEFER_7;
+    manager->name_index->built   = 0;
+    manager->name_index->entries = NULL;
+    manager->name_index->n       = 0;
+    manager->name_index->ids       = NULL;
+    manager->name_index->replicas  = NULL;
+    manager->name_index->nreplicas = 0;
+
+    manager->associations = malloc(sizeof(user_manager_associations_t));
+    if (!manager->associations)
+        goto DEFER_8;
+
+    if (pthread_mutex_init(&manager->associations->lock, NULL))
+        goto DEFER_9;
+    manager->associations->compacted         = 1;
+    manager->associations->flights           = NULL;
+    manager->associations->reservations      = NULL;
+    manager->associations->flights_size      = 0;
+    manager->associations->reservations_size = 0;
+    manager->associations->max_nflights      = 0;
+    manager->associations->flight_date       = NULL;
+    manager->associations->reservation_date  = NULL;
+    manager->associations->date_data         = NULL;
+
+    manager->id_users_rel = string_hash_table_create(0);
+    if (!manager->id_users_rel)
+        goto DEFER_10;
+    manager->ordinals_rel = g_ptr_array_new();
+
+    manager->bitmap_index = malloc(sizeof(user_manager_bitmap_index_t));
+    if (!manager->bitmap_index)
+        goto DEFER_11;
+
+    if (pthread_mutex_init(&manager->bitmap_index->lock, NULL))
+        goto DEFER_12;
+    manager->bitmap_index->built = 0;
+
+    manager->passenger_index = malloc(sizeof(user_manager_passenger_index_t));
+    if (!manager->passenger_index)
+        goto DEFER_13;
+
+    if (pthread_mutex_init(&manager->passenger_index->lock, NULL))
+        goto DEFER_14;
+    manager->passenger_index->built = 0;
+
     return manager;
 
+DEFER_14:
+    free(manager->passenger_index);
+DEFER_13:
+    pthread_mutex_destroy(&manager->bitmap_index->lock);
+DEFER_12:
+    free(manager->bitmap_index);
+DEFER_11:
+    g_ptr_array_unref(manager->ordinals_rel);
+    string_hash_table_free(manager->id_users_rel);
+DEFER_10:
+    pthread_mutex_destroy(&manager->associations->lock);
+DEFER_9:
+    free(manager->associations);
+DEFER_8:
+    pthread_mutex_destroy(&manager->name_index->lock);
+DEFER_7:
+    free(manager->name_index);
+DEFER_6:
+    string_pool_free(manager->strings);
 DEFER_5:
     pool_free(manager->ll_nodes);
 DEFER_4:
@@ -117,44 +411,359 @@ DEFER_1:
 }
 
 /**
- * @brief Method called for every ::user_manager_user_and_data_t.
+ * @struct user_manager_compaction_data_t
+ * @brief  Data needed while moving associations from linked lists to contiguous arrays.
+ *
+ * @var user_manager_compaction_data_t::manager
+ *     @brief Manager whose associations are being moved.
+ * @var user_manager_compaction_data_t::flights
+ *     @brief New array of encoded flights of all users.
+ * @var user_manager_compaction_data_t::reservations
+ *     @brief New array of encoded reservations of all users.
+ * @var user_manager_compaction_data_t::nflights
+ *     @brief Number of flights of all users.
+ * @var user_manager_compaction_data_t::nreservations
+ *     @brief Number of reservations of all users.
+ * @var user_manager_compaction_data_t::flights_size
+ *     @brief Number of bytes already written to ::user_manager_compaction_data_t::flights.
+ * @var user_manager_compaction_data_t::reservations_size
+ *     @brief Number of bytes already written to ::user_manager_compaction_data_t::reservations.
+ * @var user_manager_compaction_data_t::max_nflights
+ *     @brief Maximum number of flights of a single user moved so far.
+ * @var user_manager_compaction_data_t::keys
+ *     @brief `GArray` of ::user_manager_association_key_t, reused for sorting every user's
+ *            associations.
+ * @var user_manager_compaction_data_t::ids
+ *     @brief `GArray` of `uint32_t`, reused for decoding every user's associations.
+ */
+typedef struct {
+    const user_manager_t *const manager;
+    uint8_t                    *flights, *reservations;
+    size_t                      nflights, nreservations;
+    size_t                      flights_size, reservations_size;
+    uint32_t                    max_nflights;
+    GArray *const               keys;
+    GArray *const               ids;
+} user_manager_compaction_data_t;
+
+/**
+ * @struct user_manager_association_key_t
+ * @brief  An association and the date it's sorted by.
+ *
+ * @var user_manager_association_key_t::date
+ *     @brief Date of the flight / reservation ::user_manager_association_key_t::id.
+ * @var user_manager_association_key_t::id
+ *     @brief Identifier of a flight or of a reservation.
+ */
+typedef struct {
+    date_and_time_t date;
+    uint32_t        id;
+} user_manager_association_key_t;
+
+/**
+ * @brief Comparison function for sorting ::user_manager_association_key_t (most recent first,
+ *        then by identifier).
+ *
+ * @param a A pointer to a ::user_manager_association_key_t.
+ * @param b A pointer to a ::user_manager_association_key_t.
+ *
+ * @return The comparison result between @p a and @p b.
+ */
+int __user_manager_association_key_compare(const void *a, const void *b) {
+    const user_manager_association_key_t *const key_a = a;
+    const user_manager_association_key_t *const key_b = b;
+
+    const int64_t crit1 = date_and_time_diff(key_b->date, key_a->date);
+    if (crit1)
+        return (crit1 > 0) - (crit1 < 0);
+
+    return (key_a->id > key_b->id) - (key_a->id < key_b->id);
+}
+
+/**
+ * @brief   Sorts the associations of a user by date.
+ * @details Dates are only calculated once per association, instead of for every comparison.
+ *
+ * @param keys      `GArray` of ::user_manager_association_key_t, used as temporary storage.
+ * @param ids       Associations to be sorted.
+ * @param n         Number of elements in @p ids.
+ * @param date      Method that gets the date of an association.
+ * @param date_data Pointer passed to @p date.
+ */
+void __user_manager_sort_associations(GArray                                  *keys,
+                                      uint32_t                                *ids,
+                                      size_t                                   n,
+                                      user_manager_association_date_callback_t date,
+                                      const void                              *date_data) {
+    if (n < 2)
+        return;
+
+    g_array_set_size(keys, n);
+    user_manager_association_key_t *const key_data = (user_manager_association_key_t *) keys->data;
+    for (size_t i = 0; i < n; ++i) {
+        key_data[i].date = date(date_data, ids[i]);
+        key_data[i].id   = ids[i];
+    }
+
+    qsort(key_data,
+          n,
+          sizeof(user_manager_association_key_t),
+          __user_manager_association_key_compare);
+    for (size_t i = 0; i < n; ++i)
+        ids[i] = key_data[i].id;
+}
+
+/**
+ * @brief Counts the associations of a user, to know the size of the arrays to be allocated.
+ *
+ * @param user_data A pointer to a ::user_manager_compaction_data_t.
+ * @param key       User identifier. Not used.
+ * @param value     A pointer to a ::user_manager_user_and_data_t.
+ *
+ * @retval 0 Always, not to stop iteration.
+ */
+int __user_manager_compaction_count_callback(void *user_data, const char *key, void *value) {
+    (void) key;
+    user_manager_compaction_data_t *const     compaction_data = user_data;
+    const user_manager_user_and_data_t *const data            = value;
+
+    compaction_data->nflights      += data->nflights + data->nnew_flights;
+    compaction_data->nreservations += data->nreservations + data->nnew_reservations;
+    return 0;
+}
+
+/**
+ * @brief Moves the flights or the reservations of a user to a new contiguous array.
+ *
+ * @param compaction_data  Temporary storage for decoding and sorting associations.
+ * @param new_associations Associations of the user not yet in @p old_associations.
+ * @param old_associations Encoded associations of the user. Can be `NULL` if @p nold is `0`.
+ * @param nold             Number of associations encoded in @p old_associations.
+ * @param date             Method that gets the date of an association. Can be `NULL`, not to sort
+ *                         associations.
+ * @param out              New array, where to encode the associations to.
+ * @param out_size         Number of bytes already written to @p out. Gets updated.
+ *
+ * @return The number of associations encoded in @p out.
+ */
+size_t __user_manager_compaction_move_associations(
+    user_manager_compaction_data_t          *compaction_data,
+    const single_pool_id_linked_list_t      *new_associations,
+    const uint8_t                           *old_associations,
+    size_t                                   nold,
+    user_manager_association_date_callback_t date,
+    uint8_t                                 *out,
+    size_t                                  *out_size) {
+
+    size_t n = nold;
+    for (const single_pool_id_linked_list_t *iter = new_associations; iter;
+         iter = single_pool_id_linked_list_get_next(iter))
+        n++;
+    if (!n)
+        return 0;
+
+    g_array_set_size(compaction_data->ids, n);
+    uint32_t *const ids = (uint32_t *) compaction_data->ids->data;
+
+    /* New associations come first, like when they were kept in a single linked list */
+    size_t i = 0;
+    for (const single_pool_id_linked_list_t *iter = new_associations; iter;
+         iter = single_pool_id_linked_list_get_next(iter))
+        ids[i++] = single_pool_id_linked_list_get_value(iter);
+    if (nold)
+        varint_decode_deltas(old_associations, nold, ids + i);
+
+    if (date)
+        __user_manager_sort_associations(compaction_data->keys,
+                                         ids,
+                                         n,
+                                         date,
+                                         compaction_data->manager->associations->date_data);
+
+    *out_size += varint_encode_deltas(ids, n, out + *out_size);
+    return n;
+}
+
+/**
+ * @brief   Moves the associations of a user to the new contiguous arrays.
+ * @details Users are visited in the order they're stored in, so that
+ *          ::user_manager_iter_with_flights reads the flights array sequentially. Replaced users
+ *          (repeated identifiers) have no associations (see ::user_manager_add_user), and are
+ *          skipped.
+ *
+ * @param user_data     A pointer to a ::user_manager_compaction_data_t.
+ * @param user_and_data A pointer to a ::user_manager_user_and_data_t.
+ *
+ * @retval 0 Always, not to stop iteration.
+ */
+int __user_manager_compaction_move_callback(void *user_data, const void *user_and_data) {
+    user_manager_compaction_data_t *const     compaction_data = user_data;
+    const user_manager_user_and_data_t *const const_data      = user_and_data;
+    const user_manager_associations_t *const  associations =
+        compaction_data->manager->associations;
+
+    /* Get a mutable pointer to the same user data */
+    user_manager_user_and_data_t *const data =
+        string_hash_table_lookup(compaction_data->manager->id_users_rel,
+                                 user_get_const_id(const_data->user));
+    if (data != const_data)
+        return 0;
+
+    const size_t   flights_offset = compaction_data->flights_size;
+    const uint32_t nflights       = (uint32_t) __user_manager_compaction_move_associations(
+        compaction_data,
+        data->new_flights,
+        data->nflights ? associations->flights + data->flights_offset : NULL,
+        data->nflights,
+        associations->flight_date,
+        compaction_data->flights,
+        &compaction_data->flights_size);
+
+    const size_t   reservations_offset = compaction_data->reservations_size;
+    const uint32_t nreservations       = (uint32_t) __user_manager_compaction_move_associations(
+        compaction_data,
+        data->new_reservations,
+        data->nreservations ? associations->reservations + data->reservations_offset : NULL,
+        data->nreservations,
+        associations->reservation_date,
+        compaction_data->reservations,
+        &compaction_data->reservations_size);
+
+    compaction_data->max_nflights = max(compaction_data->max_nflights, nflights);
+
+    data->new_flights         = NULL;
+    data->new_reservations    = NULL;
+    data->nnew_flights        = 0;
+    data->nnew_reservations   = 0;
+    data->flights_offset      = flights_offset;
+    data->reservations_offset = reservations_offset;
+    data->nflights            = nflights;
+    data->nreservations       = nreservations;
+    return 0;
+}
+
+/**
+ * @brief Shrinks an array of encoded associations to the number of bytes actually written to it.
+ *
+ * @param array Array to be shrunk.
+ * @param size  Number of bytes written to @p array.
+ *
+ * @return The shrunk array (@p array itself if it can't be shrunk), or `NULL` if @p size is `0`.
+ */
+uint8_t *__user_manager_shrink_encoded(uint8_t *array, size_t size) {
+    if (!size) {
+        free(array);
+        return NULL;
+    }
+
+    uint8_t *const shrunk = realloc(array, size);
+    return shrunk ? shrunk : array;
+}
+
+/**
+ * @brief   Moves all associations in linked lists to ::user_manager::associations.
+ * @details Must be called with ::user_manager_associations_t::lock held. Nothing happens on
+ *          failure, and the linked list nodes are discarded on success.
+ *
+ * @param manager Manager whose associations are to be moved.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_compact_associations(const user_manager_t *manager) {
+    user_manager_associations_t *const associations = manager->associations;
+    if (associations->compacted)
+        return 0;
+
+    user_manager_compaction_data_t compaction_data = {
+        .manager           = manager,
+        .flights           = NULL,
+        .reservations      = NULL,
+        .nflights          = 0,
+        .nreservations     = 0,
+        .flights_size      = 0,
+        .reservations_size = 0,
+        .max_nflights      = 0,
+        .keys = g_array_new(FALSE, FALSE, sizeof(user_manager_association_key_t)),
+        .ids  = g_array_new(FALSE, FALSE, sizeof(uint32_t))};
+    string_hash_table_iter(manager->id_users_rel,
+                           __user_manager_compaction_count_callback,
+                           &compaction_data);
+
+    /* Allocate for the worst case, and shrink the arrays once their size is known */
+    const size_t nflights = compaction_data.nflights, nreservations = compaction_data.nreservations;
+    compaction_data.flights      = malloc(VARINT_MAX_LENGTH * nflights);
+    compaction_data.reservations = malloc(VARINT_MAX_LENGTH * nreservations);
+    if ((!compaction_data.flights && nflights) ||
+        (!compaction_data.reservations && nreservations)) {
+        free(compaction_data.flights);
+        free(compaction_data.reservations);
+        g_array_unref(compaction_data.keys);
+        g_array_unref(compaction_data.ids);
+        return 1;
+    }
+
+    pool_iter(manager->user_data, __user_manager_compaction_move_callback, &compaction_data);
+    g_array_unref(compaction_data.keys);
+    g_array_unref(compaction_data.ids);
+
+    free(associations->flights);
+    free(associations->reservations);
+    associations->flights =
+        __user_manager_shrink_encoded(compaction_data.flights, compaction_data.flights_size);
+    associations->reservations =
+        __user_manager_shrink_encoded(compaction_data.reservations,
+                                      compaction_data.reservations_size);
+    associations->flights_size      = compaction_data.flights_size;
+    associations->reservations_size = compaction_data.reservations_size;
+    associations->max_nflights      = compaction_data.max_nflights;
+    associations->compacted         = 1;
+
+    pool_empty(manager->ll_nodes);
+    return 0;
+}
+
+/**
+ * @brief Copies a ::user_manager_user_and_data_t to a clone, giving it the next ordinal.
  *
- * @param clone_data     Pointer to the clone being generated.
- * @param user_data_data Pointer to the ::user_manager_user_and_data_t being copied.
+ * @param clone     Clone being generated.
+ * @param user_data User and its data to be copied.
  *
  * @retval 0 Success.
  * @retval 1 Allocation failure.
  */
-int __user_manager_clone_foreach_user_data(void *clone_data, const void *user_data_data) {
-    const user_manager_t *const               clone     = clone_data;
-    const user_manager_user_and_data_t *const user_data = user_data_data;
+int __user_manager_clone_user_data(user_manager_t                     *clone,
+                                   const user_manager_user_and_data_t *user_data) {
 
     user_t *const new_user = user_clone(clone->users, clone->strings, user_data->user);
     if (!new_user)
         goto DEFER_1;
 
-    single_pool_id_linked_list_t *const new_flights =
-        single_pool_id_linked_list_clone(clone->ll_nodes, user_data->flights);
-    if (user_data->flights && !new_flights)
-        goto DEFER_2;
-
-    single_pool_id_linked_list_t *const new_reservations =
-        single_pool_id_linked_list_clone(clone->ll_nodes, user_data->reservations);
-    if (user_data->reservations && !new_reservations)
-        goto DEFER_2;
-
-    const user_manager_user_and_data_t new_data = {.user         = new_user,
-                                                   .flights      = new_flights,
-                                                   .reservations = new_reservations};
+    /* Associations were compacted in the original, and its arrays are copied as a whole */
+    const user_manager_user_and_data_t new_data = {
+        .user                = new_user,
+        .new_flights         = NULL,
+        .new_reservations    = NULL,
+        .flights_offset      = user_data->flights_offset,
+        .reservations_offset = user_data->reservations_offset,
+        .nflights            = user_data->nflights,
+        .nreservations       = user_data->nreservations,
+        .nnew_flights        = 0,
+        .nnew_reservations   = 0,
+        .total_spent         = user_data->total_spent,
+        .ordinal             = user_data->ordinal};
 
     user_manager_user_and_data_t *const pool_user_and_data =
         pool_put_item(user_manager_user_and_data_t, clone->user_data, &new_data);
     if (!pool_user_and_data)
         goto DEFER_2;
 
-    g_const_key_hash_table_insert(clone->id_users_rel,
-                                  user_get_const_id(new_user),
-                                  pool_user_and_data);
+    if (string_hash_table_insert(clone->id_users_rel,
+                                 user_get_const_id(new_user),
+                                 pool_user_and_data) == 1)
+        goto DEFER_2;
+
+    g_ptr_array_add(clone->ordinals_rel, pool_user_and_data);
     return 0;
 
 DEFER_2:
@@ -164,36 +773,175 @@ DEFER_1:
 }
 
 user_manager_t *user_manager_clone(const user_manager_t *manager) {
+    pthread_mutex_lock(&manager->associations->lock);
+    const int failure = __user_manager_compact_associations(manager);
+    pthread_mutex_unlock(&manager->associations->lock);
+    if (failure)
+        return NULL;
+
     user_manager_t *const clone = user_manager_create();
     if (!clone)
         return NULL;
 
-    if (pool_iter(manager->user_data, __user_manager_clone_foreach_user_data, clone)) {
-        user_manager_free(clone);
-        return NULL;
-    }
+    if (user_manager_reserve(clone, string_hash_table_get_length(manager->id_users_rel), 0))
+        goto DEFER_1;
+
+    const user_manager_associations_t *const associations       = manager->associations;
+    user_manager_associations_t *const       clone_associations = clone->associations;
+
+    clone_associations->flights      = malloc(associations->flights_size);
+    clone_associations->reservations = malloc(associations->reservations_size);
+    if ((!clone_associations->flights && associations->flights_size) ||
+        (!clone_associations->reservations && associations->reservations_size))
+        goto DEFER_1;
+
+    if (associations->flights_size)
+        memcpy(clone_associations->flights, associations->flights, associations->flights_size);
+    if (associations->reservations_size)
+        memcpy(clone_associations->reservations,
+               associations->reservations,
+               associations->reservations_size);
+    clone_associations->flights_size      = associations->flights_size;
+    clone_associations->reservations_size = associations->reservations_size;
+    clone_associations->max_nflights      = associations->max_nflights;
+
+    /* Users are cloned in ordinal order, so that ordinals stored elsewhere are still valid */
+    for (size_t i = 0; i < manager->ordinals_rel->len; ++i)
+        if (__user_manager_clone_user_data(clone, g_ptr_array_index(manager->ordinals_rel, i)))
+            goto DEFER_1;
     return clone;
+
+DEFER_1:
+    user_manager_free(clone);
+    return NULL;
+}
+
+/**
+ * @brief Discards the replicas of the index of users by name of a user manager.
+ * @param index Index whose replicas (::user_manager_name_index_t::replicas) are discarded.
+ */
+void __user_manager_free_name_replicas(user_manager_name_index_t *index) {
+    for (size_t i = 0; i < index->nreplicas; ++i)
+        free(index->replicas[i]);
+
+    free(index->replicas);
+    index->replicas  = NULL;
+    index->nreplicas = 0;
+}
+
+/**
+ * @brief Discards a user manager's indices of users by name and identifier, so that they're built
+ *        again when needed.
+ * @param manager Manager whose indices are no longer valid.
+ */
+void __user_manager_invalidate_name_index(user_manager_t *manager) {
+    user_manager_name_index_t *const index = manager->name_index;
+    __user_manager_free_name_replicas(index);
+    if (index->ids) {
+        radix_tree_free(index->ids);
+        index->ids = NULL;
+    }
+
+    if (!index->built)
+        return;
+
+    free(index->entries);
+    index->entries = NULL;
+    index->n       = 0;
+    index->built   = 0;
+}
+
+/**
+ * @brief Discards a user manager's bitmaps of users, so that they're built again when needed.
+ * @param index Bitmaps (::user_manager::bitmap_index) that are no longer valid.
+ */
+void __user_manager_invalidate_bitmap_index(user_manager_bitmap_index_t *index) {
+    if (!index->built)
+        return;
+
+    for (size_t i = 0; i < USER_MANAGER_BITMAP_TWO_VALUES; ++i) {
+        compressed_bitmap_free(index->account_status[i]);
+        compressed_bitmap_free(index->sex[i]);
+    }
+    if (index->countries)
+        g_ptr_array_unref(index->countries);
+    if (index->country_ordinals)
+        id_hash_table_free(index->country_ordinals);
+    compressed_bitmap_free(index->empty);
+
+    index->built = 0;
+}
+
+/**
+ * @brief Discards a user manager's index of passengers, so that it's built again when needed.
+ * @param index Index (::user_manager::passenger_index) that is no longer valid.
+ */
+void __user_manager_invalidate_passenger_index(user_manager_passenger_index_t *index) {
+    if (!index->built)
+        return;
+
+    if (index->flights)
+        id_hash_table_free(index->flights);
+    free(index->offsets);
+    free(index->users);
+
+    index->built = 0;
 }
 
 int user_manager_add_user(user_manager_t *manager, const user_t *user) {
     const user_t *const pool_user = user_clone(manager->users, manager->strings, user);
     if (!pool_user)
         return 1;
+    __user_manager_invalidate_name_index(manager);
+    __user_manager_invalidate_bitmap_index(manager->bitmap_index);
+    __user_manager_invalidate_passenger_index(manager->passenger_index);
 
     const user_manager_user_and_data_t user_and_data = {
-        .user         = pool_user,
-        .flights      = single_pool_id_linked_list_create(),
-        .reservations = single_pool_id_linked_list_create(),
-    };
+        .user                = pool_user,
+        .new_flights         = single_pool_id_linked_list_create(),
+        .new_reservations    = single_pool_id_linked_list_create(),
+        .flights_offset      = 0,
+        .reservations_offset = 0,
+        .nflights            = 0,
+        .nreservations       = 0,
+        .nnew_flights        = 0,
+        .nnew_reservations   = 0,
+        .total_spent         = 0,
+        .ordinal             = manager->ordinals_rel->len};
 
     user_manager_user_and_data_t *const pool_user_and_data =
         pool_put_item(user_manager_user_and_data_t, manager->user_data, &user_and_data);
     if (!pool_user_and_data)
         return 1;
 
-    if (!g_const_key_hash_table_insert(manager->id_users_rel,
-                                       user_get_const_id(pool_user),
-                                       pool_user_and_data)) {
+    /* The identifier is hashed once, for both the lookup and the insertion */
+    const char *const id   = user_get_const_id(pool_user);
+    const uint32_t    hash = string_hash_table_hash(id);
+
+    /* A replaced user loses its associations, so that none are lost track of while compacting */
+    user_manager_user_and_data_t *const replaced =
+        string_hash_table_lookup_with_hash(manager->id_users_rel, id, hash);
+    if (replaced) {
+        pool_user_and_data->ordinal = replaced->ordinal;
+
+        replaced->new_flights       = NULL;
+        replaced->new_reservations  = NULL;
+        replaced->nflights          = 0;
+        replaced->nreservations     = 0;
+        replaced->nnew_flights      = 0;
+        replaced->nnew_reservations = 0;
+        replaced->total_spent       = 0;
+    }
+
+    const int inserted =
+        string_hash_table_insert_with_hash(manager->id_users_rel, id, hash, pool_user_and_data);
+    if (inserted == 1)
+        return 1;
+
+    if (inserted == 0) {
+        g_ptr_array_add(manager->ordinals_rel, pool_user_and_data);
+    } else {
+        g_ptr_array_index(manager->ordinals_rel, pool_user_and_data->ordinal) = pool_user_and_data;
 
         /* Do not fatally fail (just print a warning). Show must go on. */
         fprintf(stderr,
@@ -204,96 +952,390 @@ int user_manager_add_user(user_manager_t *manager, const user_t *user) {
     return 0;
 }
 
+int user_manager_reserve(user_manager_t *manager, size_t nusers, size_t nassociations) {
+    const size_t length  = manager->ordinals_rel->len;
+    const size_t missing = nusers > length ? nusers - length : 0;
+
+    /* GPtrArray can't be reserved: grow it and shrink it back, as its memory is kept */
+    g_ptr_array_set_size(manager->ordinals_rel, length + missing);
+    g_ptr_array_set_size(manager->ordinals_rel, length);
+
+    return string_hash_table_reserve(manager->id_users_rel, nusers) ||
+           pool_reserve(manager->users, missing) || pool_reserve(manager->user_data, missing) ||
+           pool_reserve(manager->ll_nodes, nassociations);
+}
+
+int user_manager_shrink_to_fit(user_manager_t *manager) {
+    pool_shrink_to_fit(manager->users);
+    pool_shrink_to_fit(manager->user_data);
+    pool_shrink_to_fit(manager->ll_nodes);
+    string_pool_shrink_to_fit(manager->strings);
+    return string_hash_table_shrink_to_fit(manager->id_users_rel);
+}
+
+/**
+ * @brief  Gets the data of a user in a user manager from its ordinal.
+ * @param  manager User manager where to perform the lookup.
+ * @param  ordinal Ordinal of the user to find.
+ * @return The user's data, or `NULL` if it wasn't found.
+ */
+user_manager_user_and_data_t *__user_manager_get_by_ordinal(const user_manager_t *manager,
+                                                            user_ordinal_t        ordinal) {
+    if (ordinal >= manager->ordinals_rel->len)
+        return NULL;
+    return g_ptr_array_index(manager->ordinals_rel, ordinal);
+}
+
 int user_manager_add_user_flight_association(user_manager_t *manager,
-                                             const char     *user_id,
+                                             user_ordinal_t  user,
                                              flight_id_t     flight_id) {
 
-    user_manager_user_and_data_t *const data =
-        g_const_key_hash_table_lookup(manager->id_users_rel, user_id);
+    user_manager_user_and_data_t *const data = __user_manager_get_by_ordinal(manager, user);
     if (!data)
         return 1;
 
     single_pool_id_linked_list_t *const tmp =
-        single_pool_id_linked_list_append_beginning(manager->ll_nodes, data->flights, flight_id);
+        single_pool_id_linked_list_append_beginning(manager->ll_nodes,
+                                                    data->new_flights,
+                                                    flight_id);
     if (!tmp)
         return 1;
 
-    data->flights = tmp;
+    data->nnew_flights++;
+    data->new_flights                = tmp;
+    manager->associations->compacted = 0;
+    __user_manager_invalidate_passenger_index(manager->passenger_index);
     return 0;
 }
 
 int user_manager_add_user_reservation_association(user_manager_t  *manager,
-                                                  const char      *user_id,
-                                                  reservation_id_t reservation_id) {
+                                                  user_ordinal_t   user,
+                                                  reservation_id_t reservation_id,
+                                                  uint64_t         price) {
 
-    user_manager_user_and_data_t *const data =
-        g_const_key_hash_table_lookup(manager->id_users_rel, user_id);
+    user_manager_user_and_data_t *const data = __user_manager_get_by_ordinal(manager, user);
     if (!data)
         return 1;
 
     single_pool_id_linked_list_t *const tmp =
         single_pool_id_linked_list_append_beginning(manager->ll_nodes,
-                                                    data->reservations,
+                                                    data->new_reservations,
                                                     reservation_id);
     if (!tmp)
         return 1;
 
-    data->reservations = tmp;
+    data->nnew_reservations++;
+    data->new_reservations           = tmp;
+    data->total_spent               += price;
+    manager->associations->compacted = 0;
+    return 0;
+}
+
+/**
+ * @brief   Gets the data of a user while associations are added in bulk.
+ * @details The user ::PREFETCH_BATCH_SIZE positions ahead of @p i is prefetched, and the
+ *          previous user is reused if it's the same (e.g.: sorted input).
+ *
+ * @param manager  Manager where the users are stored.
+ * @param n        Number of users in @p users.
+ * @param users    Ordinals of the users associations are being added to.
+ * @param i        Index of the user to get in @p users.
+ * @param previous Data of `users[i - 1]` (`NULL` for the first user), to be updated.
+ *
+ * @return The data of `users[i]`, or `NULL` if it doesn't exist.
+ */
+user_manager_user_and_data_t *
+    __user_manager_get_by_ordinal_in_bulk(const user_manager_t          *manager,
+                                          size_t                         n,
+                                          const user_ordinal_t           users[n],
+                                          size_t                         i,
+                                          user_manager_user_and_data_t **previous) {
+
+    if (i + PREFETCH_BATCH_SIZE < n) {
+        const user_ordinal_t ahead = users[i + PREFETCH_BATCH_SIZE];
+        if (ahead < manager->ordinals_rel->len)
+            prefetch_read(g_ptr_array_index(manager->ordinals_rel, ahead));
+    }
+
+    if (!*previous || (*previous)->ordinal != users[i])
+        *previous = __user_manager_get_by_ordinal(manager, users[i]);
+    return *previous;
+}
+
+int user_manager_add_user_flight_associations(user_manager_t      *manager,
+                                              flight_id_t          flight_id,
+                                              size_t               n,
+                                              const user_ordinal_t users[n]) {
+
+    __user_manager_invalidate_passenger_index(manager->passenger_index);
+
+    user_manager_user_and_data_t *data = NULL;
+    for (size_t i = 0; i < n; ++i) {
+        if (!__user_manager_get_by_ordinal_in_bulk(manager, n, users, i, &data))
+            return 1;
+
+        single_pool_id_linked_list_t *const tmp =
+            single_pool_id_linked_list_append_beginning(manager->ll_nodes,
+                                                        data->new_flights,
+                                                        flight_id);
+        if (!tmp)
+            return 1;
+
+        data->nnew_flights++;
+        data->new_flights = tmp;
+    }
+
+    if (n)
+        manager->associations->compacted = 0;
+    return 0;
+}
+
+int user_manager_add_user_reservation_associations(user_manager_t        *manager,
+                                                   size_t                 n,
+                                                   const user_ordinal_t   users[n],
+                                                   const reservation_id_t reservation_ids[n],
+                                                   const uint64_t         prices[n]) {
+
+    user_manager_user_and_data_t *data = NULL;
+    for (size_t i = 0; i < n; ++i) {
+        if (!__user_manager_get_by_ordinal_in_bulk(manager, n, users, i, &data))
+            return 1;
+
+        single_pool_id_linked_list_t *const tmp =
+            single_pool_id_linked_list_append_beginning(manager->ll_nodes,
+                                                        data->new_reservations,
+                                                        reservation_ids[i]);
+        if (!tmp)
+            return 1;
+
+        data->nnew_reservations++;
+        data->new_reservations  = tmp;
+        data->total_spent      += prices[i];
+    }
+
+    if (n)
+        manager->associations->compacted = 0;
     return 0;
 }
 
+void user_manager_set_association_dates(user_manager_t                          *manager,
+                                        user_manager_association_date_callback_t flight_date,
+                                        user_manager_association_date_callback_t reservation_date,
+                                        const void                              *date_data) {
+
+    manager->associations->flight_date      = flight_date;
+    manager->associations->reservation_date = reservation_date;
+    manager->associations->date_data        = date_data;
+}
+
+int user_manager_compact(const user_manager_t *manager) {
+    pthread_mutex_lock(&manager->associations->lock);
+    const int failure = __user_manager_compact_associations(manager);
+    pthread_mutex_unlock(&manager->associations->lock);
+    return failure;
+}
+
 const user_t *user_manager_get_by_id(const user_manager_t *manager, const char *id) {
     const user_manager_user_and_data_t *const data =
-        g_const_key_hash_table_lookup(manager->id_users_rel, id);
+        string_hash_table_lookup(manager->id_users_rel, id);
     if (!data)
         return NULL;
     return data->user;
 }
 
-const single_pool_id_linked_list_t *user_manager_get_flights_by_id(const user_manager_t *manager,
-                                                                   const char           *id) {
+size_t user_manager_get_length(const user_manager_t *manager) {
+    return string_hash_table_get_length(manager->id_users_rel);
+}
+
+int user_manager_get_ordinal(const user_manager_t *manager,
+                             const char           *id,
+                             user_ordinal_t       *ordinal) {
 
     const user_manager_user_and_data_t *const data =
-        g_const_key_hash_table_lookup(manager->id_users_rel, id);
+        string_hash_table_lookup(manager->id_users_rel, id);
     if (!data)
-        return NULL;
-    return data->flights;
+        return 1;
+
+    *ordinal = data->ordinal;
+    return 0;
 }
 
-const single_pool_id_linked_list_t *
-    user_manager_get_reservations_by_id(const user_manager_t *manager, const char *id) {
+int user_manager_get_ordinals(const user_manager_t *manager,
+                              size_t                n,
+                              const char *const     ids[n],
+                              user_ordinal_t        ordinals[n],
+                              uint8_t               found[n]) {
+
+    void **const values = malloc(n * sizeof(void *));
+    if (!values)
+        return 1;
+    string_hash_table_lookup_batch(manager->id_users_rel, n, ids, values);
+
+    for (size_t begin = 0; begin < n; begin += PREFETCH_BATCH_SIZE) {
+        const size_t batch = n - begin < PREFETCH_BATCH_SIZE ? n - begin : PREFETCH_BATCH_SIZE;
+
+        for (size_t i = 0; i < batch; ++i)
+            prefetch_read(values[begin + i]);
+
+        for (size_t i = 0; i < batch; ++i) {
+            const user_manager_user_and_data_t *const data = values[begin + i];
+            found[begin + i]                               = data != NULL;
+            if (data)
+                ordinals[begin + i] = data->ordinal;
+        }
+    }
+
+    free(values);
+    return 0;
+}
 
+const user_t *user_manager_get_by_ordinal(const user_manager_t *manager, user_ordinal_t ordinal) {
     const user_manager_user_and_data_t *const data =
-        g_const_key_hash_table_lookup(manager->id_users_rel, id);
+        __user_manager_get_by_ordinal(manager, ordinal);
     if (!data)
         return NULL;
-    return data->reservations;
+    return data->user;
 }
 
-int user_manager_iter(const user_manager_t        *manager,
-                      user_manager_iter_callback_t callback,
-                      void                        *user_data) {
+const user_t *user_manager_get_by_id_with_totals(const user_manager_t *manager,
+                                                 const char           *id,
+                                                 size_t               *nflights,
+                                                 size_t               *nreservations,
+                                                 uint64_t             *total_spent) {
 
-    return pool_iter(manager->users, (pool_iter_callback_t) callback, user_data);
+    const user_manager_user_and_data_t *const data =
+        string_hash_table_lookup(manager->id_users_rel, id);
+    if (!data)
+        return NULL;
+
+    *nflights      = data->nflights + data->nnew_flights;
+    *nreservations = data->nreservations + data->nnew_reservations;
+    *total_spent   = data->total_spent;
+    return data->user;
 }
 
 /**
- * @struct user_manager_iter_with_flights_data_t
- * @brief Auxiliary data for ::__user_manager_iter_with_flights_callback.
+ * @brief Gets the up-to-date associations of a user, compacting them if needed.
  *
- * @var user_manager_iter_with_flights_data_t::user_data
- *     @brief Original user data provided to ::user_manager_iter_with_flights.
- * @var user_manager_iter_with_flights_data_t::original_callback
- *     @brief Original callback provided to ::user_manager_iter_with_flights.
+ * @param manager User manager where to perform the lookup.
+ * @param id      Identifier of the user to find.
+ *
+ * @return The user's data, or `NULL` if it wasn't found or on allocation failure.
  */
-typedef struct {
-    void *const                                     user_data;
-    const user_manager_iter_with_flights_callback_t original_callback;
-} user_manager_iter_with_flights_data_t;
+const user_manager_user_and_data_t *
+    __user_manager_get_compacted_data(const user_manager_t *manager, const char *id) {
 
-/**
- * @brief Intermediate callback for ::user_manager_iter_with_flights.
- *
+    const user_manager_user_and_data_t *const data =
+        string_hash_table_lookup(manager->id_users_rel, id);
+    if (!data)
+        return NULL;
+
+    pthread_mutex_lock(&manager->associations->lock);
+    const int failure = __user_manager_compact_associations(manager);
+    pthread_mutex_unlock(&manager->associations->lock);
+    return failure ? NULL : data;
+}
+
+/**
+ * @brief Decodes the flights or the reservations of a user to the calling thread's scratch arena.
+ *
+ * @param encoded Array of encoded associations of all users.
+ * @param offset  Index of the first byte of the user's associations in @p encoded.
+ * @param n       Number of associations of the user.
+ *
+ * @return The decoded associations, or `NULL` if @p n is `0` or on allocation failure.
+ */
+uint32_t *__user_manager_decode_associations(const uint8_t *encoded, size_t offset, size_t n) {
+    if (!n)
+        return NULL;
+
+    uint32_t *const ids = scratch_arena_allocate(sizeof(uint32_t) * n);
+    if (ids)
+        varint_decode_deltas(encoded + offset, n, ids);
+    return ids;
+}
+
+int user_manager_get_flights_by_id(const user_manager_t *manager,
+                                   const char           *id,
+                                   const flight_id_t   **flights,
+                                   size_t               *nflights) {
+
+    const user_manager_user_and_data_t *const data = __user_manager_get_compacted_data(manager, id);
+    if (!data)
+        return 1;
+
+    *flights  = __user_manager_decode_associations(manager->associations->flights,
+                                                  data->flights_offset,
+                                                  data->nflights);
+    *nflights = data->nflights;
+    return data->nflights && !*flights;
+}
+
+int user_manager_get_reservations_by_id(const user_manager_t    *manager,
+                                        const char              *id,
+                                        const reservation_id_t **reservations,
+                                        size_t                  *nreservations) {
+
+    const user_manager_user_and_data_t *const data = __user_manager_get_compacted_data(manager, id);
+    if (!data)
+        return 1;
+
+    *reservations  = __user_manager_decode_associations(manager->associations->reservations,
+                                                       data->reservations_offset,
+                                                       data->nreservations);
+    *nreservations = data->nreservations;
+    return data->nreservations && !*reservations;
+}
+
+int user_manager_iter(const user_manager_t        *manager,
+                      user_manager_iter_callback_t callback,
+                      void                        *user_data) {
+
+    return pool_iter(manager->users, (pool_iter_callback_t) callback, user_data);
+}
+
+int user_manager_iter_blocks(const user_manager_t                *manager,
+                             user_manager_iter_blocks_callback_t callback,
+                             void                                *user_data) {
+
+    return pool_iter_pointers(manager->users, (pool_iter_pointers_callback_t) callback, user_data);
+}
+
+int user_manager_iter_blocks_parallel(const user_manager_t                *manager,
+                                      size_t                              nthreads,
+                                      user_manager_iter_blocks_callback_t callback,
+                                      void *const                         *user_data) {
+
+    return pool_iter_pointers_parallel(manager->users,
+                                       nthreads,
+                                       (pool_iter_pointers_callback_t) callback,
+                                       user_data);
+}
+
+/**
+ * @struct user_manager_iter_with_flights_data_t
+ * @brief Auxiliary data for ::__user_manager_iter_with_flights_callback.
+ *
+ * @var user_manager_iter_with_flights_data_t::user_data
+ *     @brief Original user data provided to ::user_manager_iter_with_flights.
+ * @var user_manager_iter_with_flights_data_t::original_callback
+ *     @brief Original callback provided to ::user_manager_iter_with_flights.
+ * @var user_manager_iter_with_flights_data_t::flights
+ *     @brief Encoded flights of all users (::user_manager_associations_t::flights).
+ * @var user_manager_iter_with_flights_data_t::decoded
+ *     @brief Where to decode the flights of every user to, with space for
+ *            ::user_manager_associations_t::max_nflights flights.
+ */
+typedef struct {
+    void *const                                     user_data;
+    const user_manager_iter_with_flights_callback_t original_callback;
+    const uint8_t *const                            flights;
+    flight_id_t *const                              decoded;
+} user_manager_iter_with_flights_data_t;
+
+/**
+ * @brief Intermediate callback for ::user_manager_iter_with_flights.
+ *
  * @param iter_data Real callback and original user data (::user_manager_iter_with_flights_data_t).
  * @param user_data A pointer to a ::user_manager_user_and_data_t.
  *
@@ -303,18 +1345,832 @@ int __user_manager_iter_with_flights_callback(void *iter_data, const void *user_
     const user_manager_iter_with_flights_data_t *const iter_data_struct = iter_data;
     const user_manager_user_and_data_t *const          user_data_struct = user_data;
 
+    const flight_id_t *flights = NULL;
+    if (user_data_struct->nflights) {
+        varint_decode_deltas(iter_data_struct->flights + user_data_struct->flights_offset,
+                             user_data_struct->nflights,
+                             iter_data_struct->decoded);
+        flights = iter_data_struct->decoded;
+    }
+
     return iter_data_struct->original_callback(iter_data_struct->user_data,
                                                user_data_struct->user,
-                                               user_data_struct->flights);
+                                               flights,
+                                               user_data_struct->nflights);
 }
 
 int user_manager_iter_with_flights(const user_manager_t                     *manager,
                                    user_manager_iter_with_flights_callback_t callback,
                                    void                                     *user_data) {
 
+    pthread_mutex_lock(&manager->associations->lock);
+    const int failure = __user_manager_compact_associations(manager);
+    pthread_mutex_unlock(&manager->associations->lock);
+    if (failure)
+        return 1;
+
+    const size_t       max_nflights = manager->associations->max_nflights;
+    flight_id_t *const decoded      = malloc(sizeof(flight_id_t) * max_nflights);
+    if (!decoded && max_nflights)
+        return 1;
+
     user_manager_iter_with_flights_data_t iter_data = {.user_data         = user_data,
-                                                       .original_callback = callback};
-    return pool_iter(manager->user_data, __user_manager_iter_with_flights_callback, &iter_data);
+                                                       .original_callback = callback,
+                                                       .flights = manager->associations->flights,
+                                                       .decoded = decoded};
+    const int retval =
+        pool_iter(manager->user_data, __user_manager_iter_with_flights_callback, &iter_data);
+    free(decoded);
+    return retval;
+}
+
+/**
+ * @struct user_manager_collation_keys_t
+ * @brief  A user and the collation keys (see `strxfrm`) of its name and identifier.
+ *
+ * @var user_manager_collation_keys_t::user
+ *     @brief User whose keys are in this structure.
+ * @var user_manager_collation_keys_t::name_key
+ *     @brief Collation key of the name of ::user_manager_collation_keys_t::user.
+ * @var user_manager_collation_keys_t::id_key
+ *     @brief Collation key of the identifier of ::user_manager_collation_keys_t::user.
+ */
+typedef struct {
+    const user_t *user;
+    const char   *name_key, *id_key;
+} user_manager_collation_keys_t;
+
+/**
+ * @struct user_manager_name_index_build_data_t
+ * @brief  Data needed while building a ::user_manager_name_index_t.
+ *
+ * @var user_manager_name_index_build_data_t::keys
+ *     @brief `GArray` of ::user_manager_collation_keys_t, one for each user.
+ * @var user_manager_name_index_build_data_t::keys_pool
+ *     @brief Where the strings in ::user_manager_name_index_build_data_t::keys are allocated.
+ */
+typedef struct {
+    GArray *const        keys;
+    string_pool_t *const keys_pool;
+} user_manager_name_index_build_data_t;
+
+/**
+ * @brief Calculates the collation keys of a user, to be added to a name index being built.
+ *
+ * @param user_data A pointer to a ::user_manager_name_index_build_data_t.
+ * @param user      User whose keys are to be calculated.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_name_index_build_callback(void *user_data, const user_t *user) {
+    const user_manager_name_index_build_data_t *const build_data = user_data;
+
+    const user_manager_collation_keys_t keys = {
+        .user     = user,
+        .name_key = collation_key(build_data->keys_pool, user_get_const_name(user)),
+        .id_key   = collation_key(build_data->keys_pool, user_get_const_id(user))};
+    if (!keys.name_key || !keys.id_key)
+        return 1;
+
+    g_array_append_val(build_data->keys, keys);
+    return 0;
+}
+
+/**
+ * @brief Comparison function for sorting ::user_manager_collation_keys_t by name and identifier.
+ *
+ * @param a A pointer to a ::user_manager_collation_keys_t.
+ * @param b A pointer to a ::user_manager_collation_keys_t.
+ *
+ * @return The comparison result between @p a and @p b.
+ */
+int __user_manager_collation_keys_compare(const void *a, const void *b) {
+    const user_manager_collation_keys_t *const keys_a = a;
+    const user_manager_collation_keys_t *const keys_b = b;
+
+    const int crit1 = strcmp(keys_a->name_key, keys_b->name_key);
+    if (crit1)
+        return crit1;
+
+    return strcmp(keys_a->id_key, keys_b->id_key);
+}
+
+/**
+ * @brief Comparison function for sorting ::user_manager_name_index_entry_t by name (byte order).
+ *
+ * @param a A pointer to a ::user_manager_name_index_entry_t.
+ * @param b A pointer to a ::user_manager_name_index_entry_t.
+ *
+ * @return The comparison result between @p a and @p b.
+ */
+int __user_manager_name_index_entry_compare(const void *a, const void *b) {
+    const user_manager_name_index_entry_t *const entry_a = a;
+    const user_manager_name_index_entry_t *const entry_b = b;
+    return strcmp(user_get_const_name(entry_a->user), user_get_const_name(entry_b->user));
+}
+
+/**
+ * @brief Comparison function for sorting pointers to ::user_manager_name_index_entry_t by rank.
+ *
+ * @param a A pointer to a pointer to a ::user_manager_name_index_entry_t.
+ * @param b A pointer to a pointer to a ::user_manager_name_index_entry_t.
+ *
+ * @return The comparison result between @p a and @p b.
+ */
+int __user_manager_name_index_rank_compare(const void *a, const void *b) {
+    const user_manager_name_index_entry_t *const entry_a =
+        *(const user_manager_name_index_entry_t *const *) a;
+    const user_manager_name_index_entry_t *const entry_b =
+        *(const user_manager_name_index_entry_t *const *) b;
+
+    return (entry_a->rank > entry_b->rank) - (entry_a->rank < entry_b->rank);
+}
+
+/**
+ * @brief   Builds the index of users by name of a user manager.
+ * @details Collation keys are only calculated once per user, instead of calling `strcoll_l` for
+ *          every comparison while sorting.
+ *
+ * @param manager Manager whose ::user_manager::name_index is to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_build_name_index(const user_manager_t *manager) {
+    int retval = 1;
+
+    user_manager_name_index_build_data_t build_data = {
+        .keys      = g_array_new(FALSE, FALSE, sizeof(user_manager_collation_keys_t)),
+        .keys_pool = string_pool_create(USER_MANAGER_NAME_INDEX_KEYS_POOL_BLOCK_CAPACITY)};
+    if (!build_data.keys_pool)
+        goto DEFER_1;
+
+    const cancellation_t *const cancellation = cancellation_suspend();
+    const int                   failure =
+        user_manager_iter(manager, __user_manager_name_index_build_callback, &build_data);
+    cancellation_set_current(cancellation);
+    if (failure)
+        goto DEFER_2;
+
+    const size_t                         n    = build_data.keys->len;
+    user_manager_collation_keys_t *const keys = (user_manager_collation_keys_t *)
+                                                    build_data.keys->data;
+    parallel_sort(keys,
+                  n,
+                  sizeof(user_manager_collation_keys_t),
+                  __user_manager_collation_keys_compare,
+                  0);
+
+    user_manager_name_index_t *const index = manager->name_index;
+    index->entries = malloc(sizeof(user_manager_name_index_entry_t) * n);
+    if (!index->entries && n)
+        goto DEFER_2;
+
+    for (size_t i = 0; i < n; ++i) {
+        index->entries[i].user = keys[i].user;
+        index->entries[i].rank = i;
+    }
+    parallel_sort(index->entries,
+                  n,
+                  sizeof(user_manager_name_index_entry_t),
+                  __user_manager_name_index_entry_compare,
+                  0);
+
+    index->n     = n;
+    index->built = 1;
+    retval       = 0;
+
+DEFER_2:
+    string_pool_free(build_data.keys_pool);
+DEFER_1:
+    g_array_unref(build_data.keys);
+    return retval;
+}
+
+int user_manager_iter_name_prefix(const user_manager_t        *manager,
+                                  const char                  *prefix,
+                                  user_manager_iter_callback_t callback,
+                                  void                        *user_data) {
+
+    user_manager_name_index_t *const index = manager->name_index;
+
+    pthread_mutex_lock(&index->lock);
+    const int failure = !index->built && __user_manager_build_name_index(manager);
+    pthread_mutex_unlock(&index->lock);
+    if (failure)
+        return 1;
+
+    /* Read from the replica in the calling thread's NUMA node, if there's one */
+    const size_t                                 node    = numa_topology_get_thread_node();
+    const user_manager_name_index_entry_t *const entries =
+        node < index->nreplicas ? index->replicas[node] : index->entries;
+
+    /* First user whose name isn't lower than the prefix */
+    size_t begin = 0, end = index->n;
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+        if (user_compare_name(entries[middle].user, prefix) < 0)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+
+    /* First user after begin whose name doesn't start with the prefix */
+    const size_t prefix_length = strlen(prefix);
+    end                        = index->n;
+    for (size_t low = begin; low < end;) {
+        const size_t middle = low + (end - low) / 2;
+        if (user_compare_name_prefix(entries[middle].user, prefix, prefix_length) > 0)
+            end = middle;
+        else
+            low = middle + 1;
+    }
+
+    const size_t n = end - begin;
+    if (n == 0)
+        return 0;
+
+    /* Sort matches by rank (integers), to iterate through them in collation order */
+    const user_manager_name_index_entry_t **const matches =
+        scratch_arena_allocate(sizeof(user_manager_name_index_entry_t *) * n);
+    if (!matches)
+        return 1;
+
+    for (size_t i = 0; i < n; ++i)
+        matches[i] = entries + begin + i;
+    qsort(matches,
+          n,
+          sizeof(user_manager_name_index_entry_t *),
+          __user_manager_name_index_rank_compare);
+
+    int retval = 0;
+    for (size_t i = 0; i < n && !retval; ++i)
+        retval = callback(user_data, matches[i]->user);
+
+    return retval; /* matches is freed when the arena is reset, after the query */
+}
+
+/**
+ * @brief Adds a user to a radix tree of users by identifier being built.
+ *
+ * @param user_data A pointer to a ::radix_tree_t.
+ * @param key       Identifier of the user, kept in the manager's pools.
+ * @param value     A pointer to a ::user_manager_user_and_data_t.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_id_index_build_callback(void *user_data, const char *key, void *value) {
+    return radix_tree_insert(user_data, key, value) == 1;
+}
+
+/**
+ * @brief Builds the index of users by identifier of a user manager.
+ *
+ * @param manager Manager whose ::user_manager_name_index_t::ids is to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_build_id_index(const user_manager_t *manager) {
+    radix_tree_t *const ids = radix_tree_create();
+    if (!ids)
+        return 1;
+
+    /* Identifiers are kept in the manager's pools, so they don't need to be copied */
+    const int failure =
+        string_hash_table_iter(manager->id_users_rel, __user_manager_id_index_build_callback, ids);
+    if (failure) {
+        radix_tree_free(ids);
+        return 1;
+    }
+
+    manager->name_index->ids = ids;
+    return 0;
+}
+
+/**
+ * @brief Gets the index of users by identifier of a user manager, building it if needed.
+ *
+ * @param manager Manager whose ::user_manager_name_index_t::ids is to be returned.
+ *
+ * @return The index, or `NULL` on allocation failure.
+ */
+const radix_tree_t *__user_manager_get_id_index(const user_manager_t *manager) {
+    user_manager_name_index_t *const index = manager->name_index;
+
+    pthread_mutex_lock(&index->lock);
+    const int failure = !index->ids && __user_manager_build_id_index(manager);
+    pthread_mutex_unlock(&index->lock);
+    return failure ? NULL : index->ids;
+}
+
+/**
+ * @struct user_manager_iter_ids_data_t
+ * @brief  Auxiliary data for ::__user_manager_iter_id_prefix_callback and
+ *         ::__user_manager_iter_ids_from_callback.
+ *
+ * @var user_manager_iter_ids_data_t::id_callback
+ *     @brief Callback provided to ::user_manager_iter_id_prefix.
+ * @var user_manager_iter_ids_data_t::user_callback
+ *     @brief Callback provided to ::user_manager_iter_ids_from.
+ * @var user_manager_iter_ids_data_t::user_data
+ *     @brief Original user data provided to the iteration method.
+ */
+typedef struct {
+    prefix_index_iter_callback_t id_callback;
+    user_manager_iter_callback_t user_callback;
+    void                        *user_data;
+} user_manager_iter_ids_data_t;
+
+/**
+ * @brief Calls the callback of ::user_manager_iter_id_prefix for an identifier in a radix tree.
+ *
+ * @param user_data A pointer to a ::user_manager_iter_ids_data_t.
+ * @param key       Identifier of a user.
+ * @param value     A pointer to a ::user_manager_user_and_data_t (unused).
+ *
+ * @return The return value of ::user_manager_iter_ids_data_t::id_callback.
+ */
+int __user_manager_iter_id_prefix_callback(void *user_data, const char *key, void *value) {
+    (void) value;
+    const user_manager_iter_ids_data_t *const data = user_data;
+    return data->id_callback(data->user_data, key);
+}
+
+/**
+ * @brief Calls the callback of ::user_manager_iter_ids_from for a user in a radix tree.
+ *
+ * @param user_data A pointer to a ::user_manager_iter_ids_data_t.
+ * @param key       Identifier of the user (unused).
+ * @param value     A pointer to a ::user_manager_user_and_data_t.
+ *
+ * @return The return value of ::user_manager_iter_ids_data_t::user_callback.
+ */
+int __user_manager_iter_ids_from_callback(void *user_data, const char *key, void *value) {
+    (void) key;
+    const user_manager_iter_ids_data_t *const data          = user_data;
+    const user_manager_user_and_data_t *const user_and_data = value;
+    return data->user_callback(data->user_data, user_and_data->user);
+}
+
+int user_manager_iter_id_prefix(const user_manager_t        *manager,
+                                const char                  *prefix,
+                                prefix_index_iter_callback_t callback,
+                                void                        *user_data) {
+
+    const radix_tree_t *const ids = __user_manager_get_id_index(manager);
+    if (!ids)
+        return 1;
+
+    user_manager_iter_ids_data_t data = {.id_callback   = callback,
+                                         .user_callback = NULL,
+                                         .user_data     = user_data};
+    return radix_tree_iter_prefix(ids, prefix, __user_manager_iter_id_prefix_callback, &data);
+}
+
+int user_manager_iter_ids_from(const user_manager_t        *manager,
+                               const char                  *begin,
+                               user_manager_iter_callback_t callback,
+                               void                        *user_data) {
+
+    const radix_tree_t *const ids = __user_manager_get_id_index(manager);
+    if (!ids)
+        return 1;
+
+    user_manager_iter_ids_data_t data = {.id_callback   = NULL,
+                                         .user_callback = callback,
+                                         .user_data     = user_data};
+    return radix_tree_iter_from(ids, begin, __user_manager_iter_ids_from_callback, &data);
+}
+
+/**
+ * @struct user_manager_replicate_data_t
+ * @brief  Type of `user_data` parameter in ::__user_manager_replicate_indexes_callback.
+ *
+ * @var user_manager_replicate_data_t::index
+ *     @brief Index being replicated.
+ */
+typedef struct {
+    user_manager_name_index_t *index;
+} user_manager_replicate_data_t;
+
+/**
+ * @brief   Builds the replica of the index of users by name of a user manager for a NUMA node.
+ * @details Auxiliary method for ::user_manager_replicate_indexes, called in a thread pinned to
+ *          @p node, so that the replica is allocated in the node's memory.
+ *
+ * @param user_data A pointer to a ::user_manager_replicate_data_t.
+ * @param node      Node to build the replica for.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_replicate_indexes_callback(void *user_data, size_t node) {
+    const user_manager_replicate_data_t *const replicate_data = user_data;
+    user_manager_name_index_t *const           index          = replicate_data->index;
+
+    const size_t size     = sizeof(user_manager_name_index_entry_t) * index->n;
+    index->replicas[node] = malloc(size ? size : 1);
+    if (!index->replicas[node])
+        return 1;
+
+    if (size)
+        memcpy(index->replicas[node], index->entries, size);
+    return 0;
+}
+
+int user_manager_replicate_indexes(const user_manager_t *manager, const numa_topology_t *topology) {
+    user_manager_name_index_t *const index  = manager->name_index;
+    const size_t                     nnodes = numa_topology_get_node_count(topology);
+    int                              retval = 1;
+
+    pthread_mutex_lock(&index->lock);
+    __user_manager_free_name_replicas(index);
+    if (!index->built && __user_manager_build_name_index(manager))
+        goto DEFER_1;
+
+    index->replicas = calloc(nnodes, sizeof(user_manager_name_index_entry_t *));
+    if (!index->replicas)
+        goto DEFER_1;
+    index->nreplicas = nnodes;
+
+    user_manager_replicate_data_t replicate_data = {.index = index};
+    retval = numa_topology_run_on_nodes(topology,
+                                        __user_manager_replicate_indexes_callback,
+                                        &replicate_data);
+    if (retval)
+        __user_manager_free_name_replicas(index);
+
+DEFER_1:
+    pthread_mutex_unlock(&index->lock);
+    return retval;
+}
+
+/**
+ * @brief   Gets the bitmap of users in a country, creating it if needed.
+ * @details Auxiliary method for ::__user_manager_build_bitmap_index.
+ *
+ * @param index   Bitmaps being built.
+ * @param country Country to get the bitmap of.
+ *
+ * @return The bitmap of users in @p country, or `NULL` on allocation failure.
+ */
+compressed_bitmap_t *__user_manager_get_country_bitmap(user_manager_bitmap_index_t *index,
+                                                       country_code_t               country) {
+    const size_t ordinal = (uintptr_t) id_hash_table_lookup(index->country_ordinals, country);
+    if (ordinal)
+        return g_ptr_array_index(index->countries, ordinal - 1);
+
+    compressed_bitmap_t *const bitmap = compressed_bitmap_create();
+    if (!bitmap)
+        return NULL;
+    g_ptr_array_add(index->countries, bitmap); /* Freed with the array, even on failure below */
+
+    if (id_hash_table_insert(index->country_ordinals,
+                             country,
+                             (void *) (uintptr_t) index->countries->len) == 1)
+        return NULL;
+    return bitmap;
+}
+
+/**
+ * @brief Builds the bitmaps of users of a user manager, if they aren't built yet.
+ *
+ * @param manager Manager whose ::user_manager::bitmap_index is to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_build_bitmap_index(const user_manager_t *manager) {
+    user_manager_bitmap_index_t *const index = manager->bitmap_index;
+    if (index->built)
+        return 0;
+
+    /* Set as built right away, so that invalidation frees everything on failure */
+    index->built = 1;
+    for (size_t i = 0; i < USER_MANAGER_BITMAP_TWO_VALUES; ++i) {
+        index->account_status[i] = compressed_bitmap_create();
+        index->sex[i]            = compressed_bitmap_create();
+    }
+    index->countries =
+        g_ptr_array_new_with_free_func((GDestroyNotify) compressed_bitmap_free);
+    index->country_ordinals = id_hash_table_create(0);
+    index->empty            = compressed_bitmap_create();
+
+    for (size_t i = 0; i < USER_MANAGER_BITMAP_TWO_VALUES; ++i)
+        if (!index->account_status[i] || !index->sex[i])
+            goto DEFER_1;
+    if (!index->country_ordinals || !index->empty)
+        goto DEFER_1;
+
+    /* Users are visited by ordinal, as bitmaps must be built in ascending order */
+    for (size_t i = 0; i < manager->ordinals_rel->len; ++i) {
+        const user_manager_user_and_data_t *const data =
+            g_ptr_array_index(manager->ordinals_rel, i);
+        const user_t *const user = data->user;
+
+        compressed_bitmap_t *const country =
+            __user_manager_get_country_bitmap(index, user_get_country_code(user));
+        if (!country || compressed_bitmap_add(country, i) ||
+            compressed_bitmap_add(index->account_status[user_get_account_status(user)], i) ||
+            compressed_bitmap_add(index->sex[user_get_sex(user)], i))
+            goto DEFER_1;
+    }
+    return 0;
+
+DEFER_1:
+    __user_manager_invalidate_bitmap_index(index);
+    return 1;
+}
+
+const compressed_bitmap_t *user_manager_get_bitmap(const user_manager_t       *manager,
+                                                   user_manager_bitmap_field_t field,
+                                                   uint32_t                    value) {
+
+    user_manager_bitmap_index_t *const index = manager->bitmap_index;
+    pthread_mutex_lock(&index->lock);
+    const int failure = __user_manager_build_bitmap_index(manager);
+    pthread_mutex_unlock(&index->lock);
+    if (failure)
+        return NULL;
+
+    switch (field) {
+        case USER_MANAGER_BITMAP_ACCOUNT_STATUS:
+            return value < USER_MANAGER_BITMAP_TWO_VALUES ? index->account_status[value]
+                                                          : index->empty;
+        case USER_MANAGER_BITMAP_SEX:
+            return value < USER_MANAGER_BITMAP_TWO_VALUES ? index->sex[value] : index->empty;
+        case USER_MANAGER_BITMAP_COUNTRY_CODE: {
+            const size_t ordinal = (uintptr_t) id_hash_table_lookup(index->country_ordinals, value);
+            return ordinal ? g_ptr_array_index(index->countries, ordinal - 1) : index->empty;
+        }
+        default:
+            return index->empty;
+    }
+}
+
+/**
+ * @brief   Counts the passengers of every flight, numbering flights in the order they're found.
+ * @details Auxiliary method for ::__user_manager_build_passenger_index (first pass).
+ *
+ * @param manager Manager whose ::user_manager::passenger_index is being built.
+ * @param decoded Where to decode the flights of every user to, with space for
+ *                ::user_manager_associations_t::max_nflights flights.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_count_passengers(const user_manager_t *manager, flight_id_t *decoded) {
+    user_manager_passenger_index_t *const    index        = manager->passenger_index;
+    const user_manager_associations_t *const associations = manager->associations;
+
+    size_t capacity = 0;
+    for (size_t i = 0; i < manager->ordinals_rel->len; ++i) {
+        const user_manager_user_and_data_t *const data =
+            g_ptr_array_index(manager->ordinals_rel, i);
+        if (!data->nflights)
+            continue;
+
+        varint_decode_deltas(associations->flights + data->flights_offset,
+                             data->nflights,
+                             decoded);
+        for (size_t j = 0; j < data->nflights; ++j) {
+            size_t flight = (uintptr_t) id_hash_table_lookup(index->flights, decoded[j]);
+            if (!flight) {
+                /* One more element than flights, for the total number of passengers */
+                if (index->nflights + 1 >= capacity) {
+                    capacity = capacity ? capacity * 2 : 1024;
+
+                    size_t *const new_offsets = realloc(index->offsets, capacity * sizeof(size_t));
+                    if (!new_offsets)
+                        return 1;
+                    index->offsets = new_offsets;
+                }
+
+                index->offsets[index->nflights] = 0;
+                flight                          = ++index->nflights;
+                if (id_hash_table_insert(index->flights,
+                                         decoded[j],
+                                         (void *) (uintptr_t) flight) == 1)
+                    return 1;
+            }
+            index->offsets[flight - 1]++;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief   Builds the index of passengers of a user manager, if it isn't built yet.
+ * @details The flights of every user are decoded twice: once to count the passengers of each
+ *          flight, and once to place users in their flights (see bucket_builder.h), so that all
+ *          passengers are stored in a single array.
+ *
+ * @param manager Manager whose ::user_manager::passenger_index is to be built.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __user_manager_build_passenger_index(const user_manager_t *manager) {
+    user_manager_passenger_index_t *const index = manager->passenger_index;
+    if (index->built)
+        return 0;
+
+    pthread_mutex_lock(&manager->associations->lock);
+    const int failure = __user_manager_compact_associations(manager);
+    pthread_mutex_unlock(&manager->associations->lock);
+    if (failure)
+        return 1;
+
+    const user_manager_associations_t *const associations = manager->associations;
+    flight_id_t *const decoded = malloc(sizeof(flight_id_t) * associations->max_nflights);
+    if (!decoded && associations->max_nflights)
+        return 1;
+
+    /* Set as built right away, so that invalidation frees everything on failure */
+    index->built    = 1;
+    index->flights  = id_hash_table_create(0);
+    index->offsets  = NULL;
+    index->users    = NULL;
+    index->nflights = 0;
+    if (!index->flights || __user_manager_count_passengers(manager, decoded))
+        goto DEFER_1;
+
+    bucket_builder_t *const builder =
+        bucket_builder_create(index->nflights, sizeof(user_ordinal_t));
+    if (!builder)
+        goto DEFER_1;
+
+    for (size_t f = 0; f < index->nflights; ++f)
+        bucket_builder_count(builder, f, index->offsets[f]);
+    if (bucket_builder_allocate(builder))
+        goto DEFER_2;
+
+    /* Users are visited by ordinal, so that the passengers of each flight are sorted */
+    for (size_t i = 0; i < manager->ordinals_rel->len; ++i) {
+        const user_manager_user_and_data_t *const data =
+            g_ptr_array_index(manager->ordinals_rel, i);
+        if (!data->nflights)
+            continue;
+
+        varint_decode_deltas(associations->flights + data->flights_offset,
+                             data->nflights,
+                             decoded);
+        for (size_t j = 0; j < data->nflights; ++j) {
+            const size_t flight = (uintptr_t) id_hash_table_lookup(index->flights, decoded[j]) - 1;
+            *(user_ordinal_t *) bucket_builder_place(builder, flight, 1) = data->ordinal;
+        }
+    }
+
+    /* Turn passenger counts into offsets, with the same prefix sum as the builder's */
+    size_t total = 0;
+    for (size_t f = 0; f < index->nflights; ++f) {
+        const size_t count = index->offsets[f];
+        index->offsets[f]  = total;
+        total             += count;
+    }
+    if (index->offsets)
+        index->offsets[index->nflights] = total;
+
+    index->users = bucket_builder_steal_items(builder);
+    bucket_builder_free(builder);
+    free(decoded);
+    return 0;
+
+DEFER_2:
+    bucket_builder_free(builder);
+DEFER_1:
+    free(decoded);
+    __user_manager_invalidate_passenger_index(index);
+    return 1;
+}
+
+int user_manager_get_passengers_by_flight(const user_manager_t  *manager,
+                                          flight_id_t            flight_id,
+                                          const user_ordinal_t **users,
+                                          size_t                *nusers) {
+
+    user_manager_passenger_index_t *const index = manager->passenger_index;
+    pthread_mutex_lock(&index->lock);
+    const int failure = __user_manager_build_passenger_index(manager);
+    pthread_mutex_unlock(&index->lock);
+    if (failure)
+        return 1;
+
+    const size_t flight = (uintptr_t) id_hash_table_lookup(index->flights, flight_id);
+    if (!flight) {
+        *users  = NULL;
+        *nusers = 0;
+        return 0;
+    }
+
+    *users  = index->users + index->offsets[flight - 1];
+    *nusers = index->offsets[flight] - index->offsets[flight - 1];
+    return 0;
+}
+
+/**
+ * @brief   Gets the number of bytes of memory allocated by the bitmaps of users of a manager.
+ * @details Auxiliary method for ::user_manager_get_memory_usage.
+ *
+ * @param index Bitmaps (::user_manager::bitmap_index) to get the memory usage of.
+ *
+ * @return The number of bytes allocated by @p index.
+ */
+size_t __user_manager_get_bitmap_index_memory_usage(user_manager_bitmap_index_t *index) {
+    size_t total = sizeof(user_manager_bitmap_index_t);
+
+    pthread_mutex_lock(&index->lock);
+    if (index->built) {
+        for (size_t i = 0; i < USER_MANAGER_BITMAP_TWO_VALUES; ++i)
+            total += compressed_bitmap_get_memory_usage(index->account_status[i]) +
+                     compressed_bitmap_get_memory_usage(index->sex[i]);
+
+        for (size_t i = 0; i < index->countries->len; ++i)
+            total += compressed_bitmap_get_memory_usage(g_ptr_array_index(index->countries, i));
+        total += sizeof(GPtrArray) + index->countries->len * sizeof(gpointer) +
+                 id_hash_table_get_memory_usage(index->country_ordinals) +
+                 compressed_bitmap_get_memory_usage(index->empty);
+    }
+    pthread_mutex_unlock(&index->lock);
+
+    return total;
+}
+
+int user_manager_build_index(const user_manager_t *manager, user_manager_index_t index) {
+    user_manager_name_index_t *const      names      = manager->name_index;
+    user_manager_bitmap_index_t *const    bitmaps    = manager->bitmap_index;
+    user_manager_passenger_index_t *const passengers = manager->passenger_index;
+
+    int failure = 0;
+    switch (index) {
+        case USER_MANAGER_INDEX_NAMES:
+            pthread_mutex_lock(&names->lock);
+            failure = !names->built && __user_manager_build_name_index(manager);
+            pthread_mutex_unlock(&names->lock);
+            break;
+        case USER_MANAGER_INDEX_IDS:
+            pthread_mutex_lock(&names->lock);
+            failure = !names->ids && __user_manager_build_id_index(manager);
+            pthread_mutex_unlock(&names->lock);
+            break;
+        case USER_MANAGER_INDEX_BITMAPS:
+            pthread_mutex_lock(&bitmaps->lock);
+            failure = __user_manager_build_bitmap_index(manager);
+            pthread_mutex_unlock(&bitmaps->lock);
+            break;
+        case USER_MANAGER_INDEX_PASSENGERS:
+            pthread_mutex_lock(&passengers->lock);
+            failure = __user_manager_build_passenger_index(manager);
+            pthread_mutex_unlock(&passengers->lock);
+            break;
+        default:
+            break;
+    }
+    return failure;
+}
+
+size_t user_manager_get_memory_usage(const user_manager_t *manager) {
+    size_t total = sizeof(user_manager_t) + pool_get_memory_usage(manager->users) +
+                   pool_get_memory_usage(manager->user_data) +
+                   pool_get_memory_usage(manager->ll_nodes) +
+                   string_pool_get_memory_usage(manager->strings) +
+                   string_hash_table_get_memory_usage(manager->id_users_rel) +
+                   sizeof(GPtrArray) + manager->ordinals_rel->len * sizeof(gpointer);
+
+    user_manager_name_index_t *const name_index = manager->name_index;
+    pthread_mutex_lock(&name_index->lock);
+    total += sizeof(user_manager_name_index_t) +
+             (name_index->nreplicas + 1) * name_index->n * sizeof(*name_index->entries) +
+             name_index->nreplicas * sizeof(*name_index->replicas);
+    if (name_index->ids)
+        total += radix_tree_get_memory_usage(name_index->ids);
+    pthread_mutex_unlock(&name_index->lock);
+
+    total += __user_manager_get_bitmap_index_memory_usage(manager->bitmap_index);
+
+    user_manager_passenger_index_t *const passenger_index = manager->passenger_index;
+    pthread_mutex_lock(&passenger_index->lock);
+    total += sizeof(user_manager_passenger_index_t);
+    if (passenger_index->built && passenger_index->offsets)
+        total += id_hash_table_get_memory_usage(passenger_index->flights) +
+                 (passenger_index->nflights + 1) * sizeof(size_t) +
+                 passenger_index->offsets[passenger_index->nflights] * sizeof(user_ordinal_t);
+    pthread_mutex_unlock(&passenger_index->lock);
+
+    user_manager_associations_t *const associations = manager->associations;
+    pthread_mutex_lock(&associations->lock);
+    total += sizeof(user_manager_associations_t) + associations->flights_size +
+             associations->reservations_size;
+    pthread_mutex_unlock(&associations->lock);
+
+    return total;
+}
+
+size_t user_manager_get_strings_memory_usage(const user_manager_t *manager) {
+    return string_pool_get_memory_usage(manager->strings);
 }
 
 void user_manager_free(user_manager_t *manager) {
@@ -322,6 +2178,27 @@ void user_manager_free(user_manager_t *manager) {
     pool_free(manager->user_data);
     pool_free(manager->ll_nodes);
     string_pool_free(manager->strings);
-    g_const_key_hash_table_unref(manager->id_users_rel);
+    string_hash_table_free(manager->id_users_rel);
+    g_ptr_array_unref(manager->ordinals_rel);
+
+    pthread_mutex_destroy(&manager->name_index->lock);
+    __user_manager_free_name_replicas(manager->name_index);
+    free(manager->name_index->entries);
+    if (manager->name_index->ids)
+        radix_tree_free(manager->name_index->ids);
+    free(manager->name_index);
+
+    pthread_mutex_destroy(&manager->bitmap_index->lock);
+    __user_manager_invalidate_bitmap_index(manager->bitmap_index);
+    free(manager->bitmap_index);
+
+    pthread_mutex_destroy(&manager->passenger_index->lock);
+    __user_manager_invalidate_passenger_index(manager->passenger_index);
+    free(manager->passenger_index);
+
+    pthread_mutex_destroy(&manager->associations->lock);
+    free(manager->associations->flights);
+    free(manager->associations->reservations);
+    free(manager->associations);
     free(manager);
 }
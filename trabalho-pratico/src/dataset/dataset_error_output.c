@@ -24,41 +24,192 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 
 #include "dataset/dataset_error_output.h"
+#include "utils/int_utils.h"
+
+/** @brief Size of the buffer of each error file (1 MiB). */
+#define DATASET_ERROR_OUTPUT_BUFFER_SIZE (1024 * 1024)
+
+/** @brief Number of buffered bytes in an error file after which the writer thread is woken up. */
+#define DATASET_ERROR_OUTPUT_FLUSH_THRESHOLD (DATASET_ERROR_OUTPUT_BUFFER_SIZE / 2)
+
+/** @brief Index of each error file in ::dataset_error_output::files. */
+typedef enum {
+    DATASET_ERROR_OUTPUT_USERS,        /**< `users_errors.csv` */
+    DATASET_ERROR_OUTPUT_FLIGHTS,      /**< `flights_errors.csv` */
+    DATASET_ERROR_OUTPUT_PASSENGERS,   /**< `passengers_errors.csv` */
+    DATASET_ERROR_OUTPUT_RESERVATIONS, /**< `reservations_errors.csv` */
+    DATASET_ERROR_OUTPUT_FILE_COUNT    /**< Number of error files. */
+} dataset_error_output_file_index_t;
 
 /**
- * @struct dataset_error_output
- * @brief  Collection of file handles for all dataset error files.
+ * @struct dataset_error_output_file_t
+ * @brief  A dataset error file and its ring buffer of lines not yet written.
  *
- * @var dataset_error_output::users
- *     @brief File where invalid users will be stored.
- * @var dataset_error_output::flights
- *     @brief File where invalid flights will be stored.
- * @var dataset_error_output::passengers
- *     @brief File where invalid user-flight relations (passengers) will be stored.
- * @var dataset_error_output::reservations
- *     @brief File where invalid hotel reservations will be stored.
+ * @var dataset_error_output_file_t::file
+ *     @brief File where errors are written to. `NULL` for no error output.
+ * @var dataset_error_output_file_t::buffer
+ *     @brief Ring buffer of ::DATASET_ERROR_OUTPUT_BUFFER_SIZE bytes. `NULL` when there's no writer
+ *            thread, and lines are written to ::dataset_error_output_file_t::file right away.
+ * @var dataset_error_output_file_t::head
+ *     @brief Index of the first byte in ::dataset_error_output_file_t::buffer not yet written.
+ * @var dataset_error_output_file_t::length
+ *     @brief Number of bytes in ::dataset_error_output_file_t::buffer not yet written. Only
+ *            decremented after those bytes are written, so that reporting threads don't
+ *            overwrite them.
+ * @var dataset_error_output_file_t::waiting
+ *     @brief Number of threads waiting for room in ::dataset_error_output_file_t::buffer, for
+ *            it to be written even if it's below ::DATASET_ERROR_OUTPUT_FLUSH_THRESHOLD.
+ */
+typedef struct {
+    FILE  *file;
+    char  *buffer;
+    size_t head, length;
+    int    waiting;
+} dataset_error_output_file_t;
+
+/**
+ * @struct  dataset_error_output
+ * @brief   Collection of file handles for all dataset error files.
+ * @details Reported lines are appended to the buffer of each file, and written by a background
+ *          thread, so that parsing doesn't block on IO.
+ *
+ * @var dataset_error_output::files
+ *     @brief Error files, indexed by ::dataset_error_output_file_index_t.
+ * @var dataset_error_output::has_writer
+ *     @brief Whether ::dataset_error_output::writer is running.
+ * @var dataset_error_output::writer
+ *     @brief Thread that writes buffered lines to their files.
+ * @var dataset_error_output::lock
+ *     @brief Lock that guards all buffers in ::dataset_error_output::files, and
+ *            ::dataset_error_output::closing.
+ * @var dataset_error_output::work
+ *     @brief Condition signaled for ::dataset_error_output::writer to write buffered lines.
+ * @var dataset_error_output::space
+ *     @brief Condition broadcast when ::dataset_error_output::writer makes room in a buffer.
+ * @var dataset_error_output::closing
+ *     @brief Whether all buffered lines should be written and ::dataset_error_output::writer should
+ *            stop.
  */
 struct dataset_error_output {
-    FILE *users;
-    FILE *flights;
-    FILE *passengers;
-    FILE *reservations;
+    dataset_error_output_file_t files[DATASET_ERROR_OUTPUT_FILE_COUNT];
+
+    int             has_writer;
+    pthread_t       writer;
+    pthread_mutex_t lock;
+    pthread_cond_t  work, space;
+    int             closing;
 };
 
+/**
+ * @brief  Writes buffered error lines to their files, until the error output is closed.
+ * @param  output_data A pointer to a ::dataset_error_output_t.
+ * @return `NULL`.
+ */
+void *__dataset_error_output_writer_thread(void *output_data) {
+    dataset_error_output_t *const output = output_data;
+
+    pthread_mutex_lock(&output->lock);
+    while (1) {
+        dataset_error_output_file_t *file = NULL;
+        for (size_t i = 0; i < DATASET_ERROR_OUTPUT_FILE_COUNT; ++i) {
+            dataset_error_output_file_t *const candidate = &output->files[i];
+            if (candidate->length &&
+                (candidate->length >= DATASET_ERROR_OUTPUT_FLUSH_THRESHOLD || candidate->waiting ||
+                 output->closing)) {
+                file = candidate;
+                break;
+            }
+        }
+
+        if (!file) {
+            if (output->closing)
+                break;
+            pthread_cond_wait(&output->work, &output->lock);
+            continue;
+        }
+
+        /* Bytes being written aren't touched by reporting threads, so the lock can be released */
+        const size_t span = min(file->length, DATASET_ERROR_OUTPUT_BUFFER_SIZE - file->head);
+        pthread_mutex_unlock(&output->lock);
+        fwrite(file->buffer + file->head, 1, span, file->file);
+        pthread_mutex_lock(&output->lock);
+
+        file->head = (file->head + span) % DATASET_ERROR_OUTPUT_BUFFER_SIZE;
+        file->length -= span;
+        pthread_cond_broadcast(&output->space);
+    }
+    pthread_mutex_unlock(&output->lock);
+    return NULL;
+}
+
+/**
+ * @brief Frees the buffers of all error files in an error output.
+ * @param output Error output whose ::dataset_error_output_file_t::buffer are to be `free`d.
+ */
+void __dataset_error_output_free_buffers(dataset_error_output_t *output) {
+    for (size_t i = 0; i < DATASET_ERROR_OUTPUT_FILE_COUNT; ++i) {
+        free(output->files[i].buffer);
+        output->files[i].buffer = NULL;
+    }
+}
+
+/**
+ * @brief   Starts the thread that writes error lines in the background.
+ * @details On failure, error lines are written as soon as they're reported.
+ * @param   output Error output whose files are already open.
+ */
+void __dataset_error_output_start_writer(dataset_error_output_t *output) {
+    output->has_writer = 0;
+    output->closing    = 0;
+
+    for (size_t i = 0; i < DATASET_ERROR_OUTPUT_FILE_COUNT; ++i) {
+        output->files[i].buffer = malloc(DATASET_ERROR_OUTPUT_BUFFER_SIZE);
+        if (!output->files[i].buffer)
+            goto DEFER_1;
+    }
+
+    if (pthread_mutex_init(&output->lock, NULL))
+        goto DEFER_1;
+    if (pthread_cond_init(&output->work, NULL))
+        goto DEFER_2;
+    if (pthread_cond_init(&output->space, NULL))
+        goto DEFER_3;
+    if (pthread_create(&output->writer, NULL, __dataset_error_output_writer_thread, output))
+        goto DEFER_4;
+
+    output->has_writer = 1;
+    return;
+
+DEFER_4:
+    pthread_cond_destroy(&output->space);
+DEFER_3:
+    pthread_cond_destroy(&output->work);
+DEFER_2:
+    pthread_mutex_destroy(&output->lock);
+DEFER_1:
+    __dataset_error_output_free_buffers(output);
+}
+
+/** @brief Names of the types of error files, indexed by ::dataset_error_output_file_index_t. */
+const char *const dataset_error_output_types[DATASET_ERROR_OUTPUT_FILE_COUNT] = {"users",
+                                                                                 "flights",
+                                                                                 "passengers",
+                                                                                 "reservations"};
+
 dataset_error_output_t *dataset_error_output_create(const char *path) {
-    dataset_error_output_t *const output = malloc(sizeof(dataset_error_output_t));
+    dataset_error_output_t *const output = calloc(1, sizeof(dataset_error_output_t));
     if (!output)
         return NULL;
 
-    if (!path) {
-        output->users = output->flights = output->passengers = output->reservations = NULL;
-        return output;
-    }
+    if (!path)
+        return output; /* All files are NULL */
 
     /* Try to create the directory if it doesn't exist */
     const int mkdir_res = mkdir(path, 0755);
@@ -67,62 +218,192 @@ dataset_error_output_t *dataset_error_output_create(const char *path) {
         return NULL;
     }
 
-    const char *const types[4] = {"users", "flights", "passengers", "reservations"};
-    FILE **const      files[4] = {&output->users,
-                                  &output->flights,
-                                  &output->passengers,
-                                  &output->reservations};
-
-    for (int i = 0; i < 4; ++i) {
+    for (size_t i = 0; i < DATASET_ERROR_OUTPUT_FILE_COUNT; ++i) {
         char file_path[PATH_MAX];
-        snprintf(file_path, PATH_MAX, "%s/%s_errors.csv", path, types[i]);
-        *files[i] = fopen(file_path, "w");
+        snprintf(file_path, PATH_MAX, "%s/%s_errors.csv", path, dataset_error_output_types[i]);
+        output->files[i].file = fopen(file_path, "w");
 
-        if (!*files[i]) {
-            for (int j = 0; j < i; ++i)
-                fclose(*files[i]);
+        if (!output->files[i].file) {
+            for (size_t j = 0; j < i; ++j)
+                fclose(output->files[j].file);
             free(output);
             return NULL;
         }
     }
 
+    __dataset_error_output_start_writer(output);
     return output;
 }
 
+/**
+ * @brief Appends data to the ring buffer of an error file.
+ *
+ * @param file File whose buffer is to be appended to. Must have room for @p n bytes.
+ * @param data Data to be appended.
+ * @param n    Number of bytes in @p data.
+ */
+void __dataset_error_output_buffer_append(dataset_error_output_file_t *file,
+                                          const char                  *data,
+                                          size_t                       n) {
+    const size_t tail  = (file->head + file->length) % DATASET_ERROR_OUTPUT_BUFFER_SIZE;
+    const size_t first = min(n, DATASET_ERROR_OUTPUT_BUFFER_SIZE - tail);
+
+    memcpy(file->buffer + tail, data, first);
+    memcpy(file->buffer, data + first, n - first);
+    file->length += n;
+}
+
+/**
+ * @brief Reports an error line made of multiple concatenated parts.
+ *
+ * @param output     Error output where to write the line to.
+ * @param file_index Error file where to write the line to.
+ * @param nparts     Number of elements in @p parts.
+ * @param parts      Strings that, concatenated, make up the line (without ``'\n'``).
+ */
+void __dataset_error_output_report(dataset_error_output_t           *output,
+                                   dataset_error_output_file_index_t file_index,
+                                   size_t                            nparts,
+                                   const char *const                 parts[nparts]) {
+    dataset_error_output_file_t *const file = &output->files[file_index];
+    if (!file->file)
+        return;
+
+    if (!output->has_writer) {
+        for (size_t i = 0; i < nparts; ++i)
+            fputs(parts[i], file->file);
+        fputc('\n', file->file);
+        return;
+    }
+
+    size_t length = 1; /* '\n' */
+    for (size_t i = 0; i < nparts; ++i)
+        length += strlen(parts[i]);
+
+    pthread_mutex_lock(&output->lock);
+
+    /* Wait for room in the buffer (or for it to be empty, for lines that don't fit in it) */
+    const size_t needed = min(length, DATASET_ERROR_OUTPUT_BUFFER_SIZE);
+    file->waiting++;
+    while (DATASET_ERROR_OUTPUT_BUFFER_SIZE - file->length < needed) {
+        pthread_cond_signal(&output->work);
+        pthread_cond_wait(&output->space, &output->lock);
+    }
+    file->waiting--;
+
+    if (length > DATASET_ERROR_OUTPUT_BUFFER_SIZE) {
+        /* With an empty buffer, the writer thread won't touch this file */
+        for (size_t i = 0; i < nparts; ++i)
+            fputs(parts[i], file->file);
+        fputc('\n', file->file);
+    } else {
+        for (size_t i = 0; i < nparts; ++i)
+            __dataset_error_output_buffer_append(file, parts[i], strlen(parts[i]));
+        __dataset_error_output_buffer_append(file, "\n", 1);
+
+        if (file->length >= DATASET_ERROR_OUTPUT_FLUSH_THRESHOLD)
+            pthread_cond_signal(&output->work);
+    }
+
+    pthread_mutex_unlock(&output->lock);
+}
+
 void dataset_error_output_report_user_error(dataset_error_output_t *output,
                                             const char             *error_line) {
-    if (output->users)
-        fprintf(output->users, "%s\n", error_line);
+    __dataset_error_output_report(output, DATASET_ERROR_OUTPUT_USERS, 1, &error_line);
 }
 
 void dataset_error_output_report_flight_error(dataset_error_output_t *output,
                                               const char             *error_line) {
-    if (output->flights)
-        fprintf(output->flights, "%s\n", error_line);
+    __dataset_error_output_report(output, DATASET_ERROR_OUTPUT_FLIGHTS, 1, &error_line);
 }
 
 void dataset_error_output_report_passenger_error(dataset_error_output_t *output,
                                                  const char             *error_line) {
-    if (output->passengers)
-        fprintf(output->passengers, "%s\n", error_line);
+    __dataset_error_output_report(output, DATASET_ERROR_OUTPUT_PASSENGERS, 1, &error_line);
+}
+
+void dataset_error_output_report_passenger_ids_error(dataset_error_output_t *output,
+                                                     const char             *flight_id,
+                                                     const char             *user_id) {
+    const char *const parts[3] = {flight_id, ";", user_id};
+    __dataset_error_output_report(output, DATASET_ERROR_OUTPUT_PASSENGERS, 3, parts);
 }
 
 void dataset_error_output_report_reservation_error(dataset_error_output_t *output,
                                                    const char             *error_line) {
-    if (output->reservations)
-        fprintf(output->reservations, "%s\n", error_line);
+    __dataset_error_output_report(output, DATASET_ERROR_OUTPUT_RESERVATIONS, 1, &error_line);
 }
 
 void dataset_error_output_free(dataset_error_output_t *output) {
-    if (!output->users) { /* No output files case. All files will be NULL. */
-        free(output);
-        return;
+    if (output->has_writer) {
+        pthread_mutex_lock(&output->lock);
+        output->closing = 1;
+        pthread_cond_signal(&output->work);
+        pthread_mutex_unlock(&output->lock);
+
+        pthread_join(output->writer, NULL);
+        pthread_cond_destroy(&output->space);
+        pthread_cond_destroy(&output->work);
+        pthread_mutex_destroy(&output->lock);
+        __dataset_error_output_free_buffers(output);
     }
 
-    fclose(output->users);
-    fclose(output->flights);
-    fclose(output->passengers);
-    fclose(output->reservations);
+    for (size_t i = 0; i < DATASET_ERROR_OUTPUT_FILE_COUNT; ++i)
+        if (output->files[i].file) /* All files are NULL when there's no error output */
+            fclose(output->files[i].file);
 
     free(output);
 }
+
+/**
+ * @brief Copies the whole contents of a file to another file.
+ *
+ * @param from Path to the file to be copied.
+ * @param to   Path to the file to be overwritten with the contents of @p from.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __dataset_error_output_copy_file(const char *from, const char *to) {
+    int retval = 1;
+
+    FILE *const input = fopen(from, "rb");
+    if (!input)
+        goto DEFER_1;
+
+    FILE *const output = fopen(to, "wb");
+    if (!output)
+        goto DEFER_2;
+
+    char   buffer[65536];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), input)) > 0)
+        if (fwrite(buffer, 1, read, output) != read)
+            goto DEFER_3;
+
+    retval = ferror(input) != 0;
+DEFER_3:
+    if (fclose(output))
+        retval = 1;
+DEFER_2:
+    fclose(input);
+DEFER_1:
+    return retval;
+}
+
+int dataset_error_output_copy(const char *from, const char *to) {
+    if (mkdir(to, 0755) && errno != EEXIST)
+        return 1;
+
+    for (size_t i = 0; i < DATASET_ERROR_OUTPUT_FILE_COUNT; ++i) {
+        char from_path[PATH_MAX], to_path[PATH_MAX];
+        snprintf(from_path, PATH_MAX, "%s/%s_errors.csv", from, dataset_error_output_types[i]);
+        snprintf(to_path, PATH_MAX, "%s/%s_errors.csv", to, dataset_error_output_types[i]);
+
+        if (__dataset_error_output_copy_file(from_path, to_path))
+            return 1;
+    }
+
+    return 0;
+}
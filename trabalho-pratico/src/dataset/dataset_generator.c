@@ -0,0 +1,869 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  dataset_generator.c
+ * @brief Implementation of methods in include/dataset/dataset_generator.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref dataset_generator_examples).
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dataset/dataset_generator.h"
+#include "types/account_status.h"
+#include "types/airport_code.h"
+#include "types/country_code.h"
+#include "types/email.h"
+#include "types/flight.h"
+#include "types/includes_breakfast.h"
+#include "types/reservation.h"
+#include "types/sex.h"
+#include "types/user.h"
+#include "utils/int_utils.h"
+
+/** @brief Number of users generated for a scale factor of `1`. */
+#define DATASET_GENERATOR_BASE_USERS 10000
+
+/** @brief Number of flights generated for a scale factor of `1`. */
+#define DATASET_GENERATOR_BASE_FLIGHTS 1000
+
+/** @brief Number of reservations generated for a scale factor of `1`. */
+#define DATASET_GENERATOR_BASE_RESERVATIONS 60000
+
+/** @brief Number of hotels generated for a scale factor of `1`. */
+#define DATASET_GENERATOR_BASE_HOTELS 50
+
+/** @brief Maximum length of a field in a generated row (including the null terminator). */
+#define DATASET_GENERATOR_FIELD_MAX 128
+
+/** @brief Maximum number of disagreements with the loaders' rules reported to `stderr`. */
+#define DATASET_GENERATOR_MAX_REPORTED_DISAGREEMENTS 10
+
+/** @brief First names of users. */
+const char *const dataset_generator_first_names[] = {
+    "Ana",   "Beatriz", "Carlos", "Diana", "Eduardo", "Filipa", "Gabriel", "Helena",
+    "Ines",  "Joao",    "Luis",   "Maria", "Nuno",    "Olga",   "Pedro",   "Rita",
+    "Sofia", "Tiago",   "Vasco",  "Zita"};
+
+/** @brief Last names of users. */
+const char *const dataset_generator_last_names[] = {
+    "Almeida", "Barbosa", "Costa",   "Dias",    "Esteves", "Ferreira", "Gomes",
+    "Lopes",   "Matos",   "Martins", "Nunes",   "Oliveira", "Pereira", "Ribeiro",
+    "Santos",  "Silva",   "Sousa",   "Teixeira", "Vieira", "Xavier"};
+
+/** @brief Countries of users, the first ones being more common. */
+const char *const dataset_generator_countries[] = {"PT", "ES", "FR", "BR", "GB", "DE", "IT", "US",
+                                                   "NL", "BE", "CH", "IE", "AO", "MZ", "CV"};
+
+/** @brief Airports of flights, the first ones (hubs) being much more common. */
+const char *const dataset_generator_airports[] = {"LIS", "OPO", "MAD", "CDG", "LHR", "FRA", "AMS",
+                                                  "FCO", "BCN", "MUC", "FAO", "DUB", "ZRH", "BRU",
+                                                  "GRU", "JFK", "LAD", "MPM", "RAI", "FNC"};
+
+/** @brief Airlines of flights. */
+const char *const dataset_generator_airlines[] = {"TAP", "Iberia", "Air France", "Ryanair",
+                                                  "Lufthansa", "KLM", "easyJet"};
+
+/** @brief Plane models of flights. */
+const char *const dataset_generator_plane_models[] = {"A320", "A321", "A330", "B737", "B777",
+                                                      "E190", "A350"};
+
+/** @brief Values of the "includes breakfast" field accepted by ::includes_breakfast_from_string. */
+const char *const dataset_generator_breakfasts[] = {"", "f", "false", "0", "t", "true", "1"};
+
+/** @brief Gets the number of elements in a static array. */
+#define DATASET_GENERATOR_LENGTH(array) (sizeof(array) / sizeof(*(array)))
+
+/**
+ * @struct dataset_generator_t
+ * @brief  State of the generation of a dataset.
+ *
+ * @var dataset_generator_t::options
+ *     @brief Configuration of the dataset.
+ * @var dataset_generator_t::rng
+ *     @brief State of the pseudo-random number generator (xorshift64*). Never `0`.
+ * @var dataset_generator_t::nusers
+ *     @brief Number of rows in `users.csv`.
+ * @var dataset_generator_t::nflights
+ *     @brief Number of rows in `flights.csv`.
+ * @var dataset_generator_t::nreservations
+ *     @brief Number of rows in `reservations.csv`.
+ * @var dataset_generator_t::nhotels
+ *     @brief Number of different hotels in `reservations.csv`.
+ * @var dataset_generator_t::valid_users
+ *     @brief Whether each user in `users.csv` is valid, so that only valid users are referenced.
+ * @var dataset_generator_t::valid_flights
+ *     @brief Whether each flight in `flights.csv` is valid.
+ * @var dataset_generator_t::user
+ *     @brief Entity where generated users are validated, like in the users' loader.
+ * @var dataset_generator_t::flight
+ *     @brief Entity where generated flights are validated, like in the flights' loader.
+ * @var dataset_generator_t::reservation
+ *     @brief Entity where generated reservations are validated, like in the reservations' loader.
+ * @var dataset_generator_t::disagreements
+ *     @brief Number of rows whose validity wasn't the intended one.
+ */
+typedef struct {
+    const dataset_generator_options_t *options;
+    uint64_t                           rng;
+
+    size_t   nusers, nflights, nreservations, nhotels;
+    uint8_t *valid_users, *valid_flights;
+
+    user_t        *user;
+    flight_t      *flight;
+    reservation_t *reservation;
+    size_t         disagreements;
+} dataset_generator_t;
+
+/**
+ * @brief  Generates a pseudo-random number.
+ * @param  generator State of the generation, whose pseudo-random number generator is advanced.
+ * @return A pseudo-random 64-bit number.
+ */
+uint64_t __dataset_generator_random(dataset_generator_t *generator) {
+    generator->rng ^= generator->rng >> 12;
+    generator->rng ^= generator->rng << 25;
+    generator->rng ^= generator->rng >> 27;
+    return generator->rng * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief  Generates a pseudo-random number in `[0, 1)`.
+ * @param  generator State of the generation.
+ * @return A uniformly distributed number in `[0, 1)`.
+ */
+double __dataset_generator_unit(dataset_generator_t *generator) {
+    return (__dataset_generator_random(generator) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @brief  Generates a pseudo-random integer in a range.
+ *
+ * @param generator State of the generation.
+ * @param min       Minimum value (inclusive).
+ * @param max       Maximum value (inclusive).
+ *
+ * @return A uniformly distributed integer in `[min, max]`.
+ */
+int __dataset_generator_range(dataset_generator_t *generator, int min, int max) {
+    return min + (int) (__dataset_generator_random(generator) % (uint64_t) (max - min + 1));
+}
+
+/**
+ * @brief   Generates a pseudo-random index, where lower indices are much more likely.
+ * @details The third power of a uniform variable is used, so that the first 10 % of indices get
+ *          about 46 % of the picks.
+ *
+ * @param generator State of the generation.
+ * @param n         Number of possible indices.
+ *
+ * @return An index in `[0, n)`.
+ */
+size_t __dataset_generator_skewed(dataset_generator_t *generator, size_t n) {
+    const double u     = __dataset_generator_unit(generator);
+    const size_t index = n * u * u * u;
+    return index < n ? index : n - 1;
+}
+
+/**
+ * @brief  Decides if a row should be made invalid.
+ * @param  generator State of the generation.
+ * @return Whether the next row should be invalid.
+ */
+int __dataset_generator_make_invalid(dataset_generator_t *generator) {
+    return __dataset_generator_unit(generator) < generator->options->invalid_fraction;
+}
+
+/**
+ * @brief Compares the validity of a generated row with the one intended.
+ *
+ * @param generator State of the generation.
+ * @param file      Name of the file the row belongs to.
+ * @param line      Line of the row in @p file.
+ * @param valid     Whether the row was generated to be valid.
+ * @param rejected  Whether the loaders' rules reject the row.
+ */
+void __dataset_generator_check(dataset_generator_t *generator,
+                               const char          *file,
+                               size_t               line,
+                               int                  valid,
+                               int                  rejected) {
+    if (valid != rejected)
+        return;
+
+    if (generator->disagreements++ < DATASET_GENERATOR_MAX_REPORTED_DISAGREEMENTS)
+        fprintf(stderr,
+                "Line %zu of %s was generated to be %s, but it isn't!\n",
+                line,
+                file,
+                valid ? "valid" : "invalid");
+}
+
+/**
+ * @brief Writes a row of a CSV file.
+ *
+ * @param output  File to write the row to.
+ * @param nfields Number of fields in @p fields.
+ * @param fields  Fields of the row.
+ */
+void __dataset_generator_write_row(FILE  *output,
+                                   size_t nfields,
+                                   char   fields[nfields][DATASET_GENERATOR_FIELD_MAX]) {
+    for (size_t i = 0; i < nfields; ++i) {
+        fputs(fields[i], output);
+        putc(i + 1 < nfields ? ';' : '\n', output);
+    }
+}
+
+/**
+ * @brief Writes a random date (day between 1 and 27, so that a day can always be added to it).
+ *
+ * @param generator State of the generation.
+ * @param output    Where to write the date to.
+ * @param min_year  Minimum year (inclusive).
+ * @param max_year  Maximum year (inclusive).
+ * @param time      Whether to also write a random time of the day.
+ */
+void __dataset_generator_date(dataset_generator_t *generator,
+                              char                 output[DATASET_GENERATOR_FIELD_MAX],
+                              int                  min_year,
+                              int                  max_year,
+                              int                  time) {
+    const int year  = __dataset_generator_range(generator, min_year, max_year);
+    const int month = __dataset_generator_range(generator, 1, 12);
+    const int day   = __dataset_generator_range(generator, 1, 27);
+
+    if (time)
+        snprintf(output,
+                 DATASET_GENERATOR_FIELD_MAX,
+                 "%04d/%02d/%02d %02d:%02d:%02d",
+                 year,
+                 month,
+                 day,
+                 __dataset_generator_range(generator, 0, 23),
+                 __dataset_generator_range(generator, 0, 59),
+                 __dataset_generator_range(generator, 0, 59));
+    else
+        snprintf(output, DATASET_GENERATOR_FIELD_MAX, "%04d/%02d/%02d", year, month, day);
+}
+
+/**
+ * @brief   Writes a date and time some minutes after another one.
+ * @details Dates written by ::__dataset_generator_date have room for at most a day to be added.
+ *
+ * @param output  Where to write the new date and time to.
+ * @param input   Date and time in the format `YYYY/MM/DD hh:mm:ss`.
+ * @param minutes Number of minutes to add to @p input (less than a day).
+ */
+void __dataset_generator_add_minutes(char        output[DATASET_GENERATOR_FIELD_MAX],
+                                     const char *input,
+                                     int         minutes) {
+    int year, month, day, hours, mins, secs;
+    sscanf(input, "%d/%d/%d %d:%d:%d", &year, &month, &day, &hours, &mins, &secs);
+
+    int total = hours * 60 + mins + minutes;
+    if (total >= 24 * 60) {
+        total -= 24 * 60;
+        day++;
+    }
+
+    snprintf(output,
+             DATASET_GENERATOR_FIELD_MAX,
+             "%04d/%02d/%02d %02d:%02d:%02d",
+             year,
+             month,
+             day,
+             total / 60,
+             total % 60,
+             secs);
+}
+
+/**
+ * @brief Writes the identifier of a user.
+ *
+ * @param output Where to write the identifier to.
+ * @param i      Index of the user in `users.csv`.
+ */
+void __dataset_generator_user_id(char output[DATASET_GENERATOR_FIELD_MAX], size_t i) {
+    const size_t nfirst = DATASET_GENERATOR_LENGTH(dataset_generator_first_names);
+    const size_t nlast  = DATASET_GENERATOR_LENGTH(dataset_generator_last_names);
+
+    snprintf(output,
+             DATASET_GENERATOR_FIELD_MAX,
+             "%s%s%zu",
+             dataset_generator_first_names[i % nfirst],
+             dataset_generator_last_names[(i / nfirst) % nlast],
+             i);
+}
+
+/**
+ * @brief  Checks a row of `users.csv` with the same rules as the users' loader.
+ * @param  generator State of the generation.
+ * @param  fields    Fields of the row.
+ * @return Whether the row is rejected.
+ */
+int __dataset_generator_reject_user(dataset_generator_t *generator,
+                                    char                 fields[12][DATASET_GENERATOR_FIELD_MAX]) {
+    date_t           birth_date;
+    date_and_time_t  account_creation;
+    sex_t            sex;
+    country_code_t   country;
+    account_status_t status;
+
+    const int rejected =
+        !*fields[0] || !*fields[1] || email_validate_string_const(fields[2]) || !*fields[3] ||
+        date_from_string_const(&birth_date, fields[4]) ||
+        user_set_birth_date(generator->user, birth_date) || sex_from_string(&sex, fields[5]) ||
+        !*fields[6] || country_code_from_string(&country, fields[7]) || !*fields[8] ||
+        date_and_time_from_string_const(&account_creation, fields[9]) ||
+        user_set_account_creation_date(generator->user, account_creation) || !*fields[10] ||
+        account_status_from_string(&status, fields[11]);
+
+    user_reset_dates(generator->user);
+    return rejected;
+}
+
+/**
+ * @brief Generates `users.csv`.
+ *
+ * @param generator State of the generation.
+ * @param output    File where to write the users to.
+ */
+void __dataset_generator_users(dataset_generator_t *generator, FILE *output) {
+    fputs("id;name;email;phone_number;birth_date;sex;passport;country_code;address;"
+          "account_creation;pay_method;account_status\n",
+          output);
+
+    const size_t nfirst = DATASET_GENERATOR_LENGTH(dataset_generator_first_names);
+    const size_t nlast  = DATASET_GENERATOR_LENGTH(dataset_generator_last_names);
+
+    for (size_t i = 0; i < generator->nusers; ++i) {
+        char fields[12][DATASET_GENERATOR_FIELD_MAX];
+
+        const char *const first = dataset_generator_first_names[i % nfirst];
+        const char *const last  = dataset_generator_last_names[(i / nfirst) % nlast];
+        __dataset_generator_user_id(fields[0], i);
+        snprintf(fields[1], DATASET_GENERATOR_FIELD_MAX, "%s %s", first, last);
+        snprintf(fields[2], DATASET_GENERATOR_FIELD_MAX, "%s.%s%zu@example.com", first, last, i);
+        for (char *c = fields[2]; *c; ++c)
+            *c = tolower(*c);
+
+        snprintf(fields[3],
+                 DATASET_GENERATOR_FIELD_MAX,
+                 "9%08d",
+                 __dataset_generator_range(generator, 0, 99999999));
+        __dataset_generator_date(generator, fields[4], 1940, 2005, 0);
+        strcpy(fields[5], __dataset_generator_range(generator, 0, 1) ? "M" : "F");
+        snprintf(fields[6],
+                 DATASET_GENERATOR_FIELD_MAX,
+                 "PT%06d",
+                 __dataset_generator_range(generator, 0, 999999));
+        strcpy(fields[7],
+               dataset_generator_countries[__dataset_generator_skewed(
+                   generator,
+                   DATASET_GENERATOR_LENGTH(dataset_generator_countries))]);
+        snprintf(fields[8],
+                 DATASET_GENERATOR_FIELD_MAX,
+                 "Rua %s, %d",
+                 last,
+                 __dataset_generator_range(generator, 1, 300));
+        __dataset_generator_date(generator, fields[9], 2010, 2022, 1);
+        strcpy(fields[10], __dataset_generator_range(generator, 0, 1) ? "credit_card" : "cash");
+        strcpy(fields[11], __dataset_generator_range(generator, 0, 9) ? "active" : "inactive");
+
+        const int valid = !__dataset_generator_make_invalid(generator);
+        if (!valid) {
+            switch (__dataset_generator_range(generator, 0, 4)) {
+                case 0:
+                    strcat(fields[2], "@"); /* Two @ */
+                    break;
+                case 1:
+                    memcpy(fields[4] + 5, "13", 2); /* Invalid month */
+                    break;
+                case 2:
+                    strcpy(fields[7], "PRT");
+                    break;
+                case 3:
+                    strcpy(fields[11], "suspended");
+                    break;
+                default:
+                    strcpy(fields[9], "1930/01/01 00:00:00"); /* Account created before birth */
+                    break;
+            }
+        }
+
+        __dataset_generator_check(generator,
+                                  "users.csv",
+                                  i + 2,
+                                  valid,
+                                  __dataset_generator_reject_user(generator, fields));
+        generator->valid_users[i] = valid;
+        __dataset_generator_write_row(output, 12, fields);
+    }
+}
+
+/**
+ * @brief  Checks a row of `flights.csv` with the same rules as the flights' loader.
+ * @param  generator State of the generation.
+ * @param  fields    Fields of the row.
+ * @return Whether the row is rejected.
+ */
+int __dataset_generator_reject_flight(dataset_generator_t *generator,
+                                      char fields[13][DATASET_GENERATOR_FIELD_MAX]) {
+    flight_id_t     id;
+    uint64_t        total_seats;
+    airport_code_t  origin, destination;
+    date_and_time_t departure, arrival, real_departure, real_arrival;
+
+    const int rejected =
+        flight_id_from_string(&id, fields[0]) || !*fields[1] || !*fields[2] ||
+        int_utils_parse_positive(&total_seats, fields[3]) || total_seats > UINT16_MAX ||
+        flight_set_total_seats(generator->flight, total_seats) ||
+        airport_code_from_string(&origin, fields[4]) ||
+        airport_code_from_string(&destination, fields[5]) ||
+        date_and_time_from_string_const(&departure, fields[6]) ||
+        flight_set_schedule_departure_date(generator->flight, departure) ||
+        date_and_time_from_string_const(&arrival, fields[7]) ||
+        flight_set_schedule_arrival_date(generator->flight, arrival) ||
+        date_and_time_from_string_const(&real_departure, fields[8]) ||
+        date_and_time_from_string_const(&real_arrival, fields[9]) ||
+        date_and_time_diff(real_arrival, real_departure) < 0 || !*fields[10] || !*fields[11];
+
+    flight_reset_schedule_dates(generator->flight);
+    return rejected;
+}
+
+/**
+ * @brief Generates `flights.csv` and `passengers.csv`.
+ *
+ * @param generator  State of the generation.
+ * @param flights    File where to write the flights to.
+ * @param passengers File where to write the passengers to.
+ */
+void __dataset_generator_flights(dataset_generator_t *generator, FILE *flights, FILE *passengers) {
+    fputs("id;airline;plane_model;total_seats;origin;destination;schedule_departure_date;"
+          "schedule_arrival_date;real_departure_date;real_arrival_date;pilot;copilot;notes\n",
+          flights);
+    fputs("flight_id;user_id\n", passengers);
+
+    const size_t nairports = DATASET_GENERATOR_LENGTH(dataset_generator_airports);
+    for (size_t i = 0; i < generator->nflights; ++i) {
+        char fields[13][DATASET_GENERATOR_FIELD_MAX];
+
+        snprintf(fields[0], DATASET_GENERATOR_FIELD_MAX, "%010zu", i + 1);
+        strcpy(fields[1],
+               dataset_generator_airlines[__dataset_generator_range(
+                   generator,
+                   0,
+                   DATASET_GENERATOR_LENGTH(dataset_generator_airlines) - 1)]);
+        strcpy(fields[2],
+               dataset_generator_plane_models[__dataset_generator_range(
+                   generator,
+                   0,
+                   DATASET_GENERATOR_LENGTH(dataset_generator_plane_models) - 1)]);
+
+        const int total_seats = __dataset_generator_range(generator, 150, 300);
+        snprintf(fields[3], DATASET_GENERATOR_FIELD_MAX, "%d", total_seats);
+
+        /* Hubs are at the start of the list of airports */
+        const size_t origin = __dataset_generator_skewed(generator, nairports);
+        size_t       destination;
+        do {
+            destination = __dataset_generator_skewed(generator, nairports);
+        } while (destination == origin);
+        strcpy(fields[4], dataset_generator_airports[origin]);
+        strcpy(fields[5], dataset_generator_airports[destination]);
+
+        const int duration = __dataset_generator_range(generator, 60, 12 * 60);
+        const int delay    = __dataset_generator_range(generator, 0, 90);
+        __dataset_generator_date(generator, fields[6], 2021, 2023, 1);
+        __dataset_generator_add_minutes(fields[7], fields[6], duration);
+        __dataset_generator_add_minutes(fields[8], fields[6], delay);
+        __dataset_generator_add_minutes(fields[9], fields[8], duration);
+
+        snprintf(fields[10], DATASET_GENERATOR_FIELD_MAX, "Pilot %zu", i % 97);
+        snprintf(fields[11], DATASET_GENERATOR_FIELD_MAX, "Copilot %zu", i % 89);
+        fields[12][0] = '\0';
+
+        const int valid = !__dataset_generator_make_invalid(generator);
+        if (!valid) {
+            switch (__dataset_generator_range(generator, 0, 3)) {
+                case 0:
+                    strcpy(fields[4], "LISB");
+                    break;
+                case 1:
+                    strcpy(fields[7], fields[6]); /* Arrival before departure */
+                    memcpy(fields[7], "2020", 4);
+                    break;
+                case 2:
+                    strcpy(fields[3], "many");
+                    break;
+                default:
+                    fields[10][0] = '\0'; /* No pilot */
+                    break;
+            }
+        }
+
+        __dataset_generator_check(generator,
+                                  "flights.csv",
+                                  i + 2,
+                                  valid,
+                                  __dataset_generator_reject_flight(generator, fields));
+        generator->valid_flights[i] = valid;
+        __dataset_generator_write_row(flights, 13, fields);
+
+        /* Passengers of this flight (only valid users, except for invalid rows) */
+        const int npassengers = __dataset_generator_range(generator, 0, total_seats / 2);
+        for (int j = 0; j < npassengers; ++j) {
+            char passenger[2][DATASET_GENERATOR_FIELD_MAX];
+            strcpy(passenger[0], fields[0]);
+
+            const size_t user = __dataset_generator_random(generator) % generator->nusers;
+            if (!generator->valid_users[user] || __dataset_generator_make_invalid(generator))
+                strcpy(passenger[1], "NoSuchUser"); /* Invalid passenger */
+            else
+                __dataset_generator_user_id(passenger[1], user);
+
+            __dataset_generator_write_row(passengers, 2, passenger);
+        }
+    }
+}
+
+/**
+ * @brief  Checks a row of `reservations.csv` with the same rules as the reservations' loader.
+ *
+ * @param generator  State of the generation.
+ * @param fields     Fields of the row.
+ * @param valid_user Whether the user that made the reservation is valid.
+ *
+ * @return Whether the row is rejected.
+ */
+int __dataset_generator_reject_reservation(dataset_generator_t *generator,
+                                           char fields[14][DATASET_GENERATOR_FIELD_MAX],
+                                           int  valid_user) {
+    reservation_id_t     id;
+    hotel_id_t           hotel;
+    uint64_t             stars, city_tax, price, rating = RESERVATION_NO_RATING;
+    date_t               begin, end;
+    includes_breakfast_t breakfast;
+
+    const int rejected =
+        reservation_id_from_string(&id, fields[0]) || !valid_user ||
+        hotel_id_from_string(&hotel, fields[2]) || !*fields[3] ||
+        int_utils_parse_positive(&stars, fields[4]) ||
+        reservation_set_hotel_stars(generator->reservation, stars) ||
+        int_utils_parse_positive(&city_tax, fields[5]) || !*fields[6] ||
+        date_from_string_const(&begin, fields[7]) ||
+        reservation_set_begin_date(generator->reservation, begin) ||
+        date_from_string_const(&end, fields[8]) ||
+        reservation_set_end_date(generator->reservation, end) ||
+        int_utils_parse_positive(&price, fields[9]) || price > UINT16_MAX ||
+        reservation_set_price_per_night(generator->reservation, price) ||
+        includes_breakfast_from_string(&breakfast, fields[10]) ||
+        (int_utils_parse_positive(&rating, fields[12]) && *fields[12]) ||
+        reservation_set_rating(generator->reservation, rating);
+
+    reservation_reset_dates(generator->reservation);
+    return rejected;
+}
+
+/**
+ * @brief Generates `reservations.csv`.
+ *
+ * @param generator State of the generation.
+ * @param output    File where to write the reservations to.
+ */
+void __dataset_generator_reservations(dataset_generator_t *generator, FILE *output) {
+    fputs("id;user_id;hotel_id;hotel_name;hotel_stars;city_tax;address;begin_date;end_date;"
+          "price_per_night;includes_breakfast;room_details;rating;comment\n",
+          output);
+
+    for (size_t i = 0; i < generator->nreservations; ++i) {
+        char fields[14][DATASET_GENERATOR_FIELD_MAX];
+
+        /* A few hotels get most of the reservations. Their properties depend only on their ID. */
+        const size_t hotel = __dataset_generator_skewed(generator, generator->nhotels);
+        const size_t user  = __dataset_generator_random(generator) % generator->nusers;
+
+        snprintf(fields[0], DATASET_GENERATOR_FIELD_MAX, "Book%010zu", i + 1);
+        __dataset_generator_user_id(fields[1], user);
+        snprintf(fields[2], DATASET_GENERATOR_FIELD_MAX, "HTL%zu", hotel + 1001);
+        snprintf(fields[3], DATASET_GENERATOR_FIELD_MAX, "Hotel %zu", hotel + 1001);
+        snprintf(fields[4], DATASET_GENERATOR_FIELD_MAX, "%zu", hotel % 5 + 1);
+        snprintf(fields[5], DATASET_GENERATOR_FIELD_MAX, "%zu", hotel % 7 + 1);
+        snprintf(fields[6], DATASET_GENERATOR_FIELD_MAX, "Avenida %zu", hotel + 1);
+
+        /* Up to 13 nights, in the same month (days of generated dates are at most 27) */
+        __dataset_generator_date(generator, fields[7], 2021, 2024, 0);
+        const int begin_day = atoi(fields[7] + 8);
+        const int end_day   = begin_day + __dataset_generator_range(generator, 1, 28 - begin_day);
+        snprintf(fields[8], DATASET_GENERATOR_FIELD_MAX, "%.8s%02d", fields[7], end_day);
+
+        snprintf(fields[9],
+                 DATASET_GENERATOR_FIELD_MAX,
+                 "%d",
+                 __dataset_generator_range(generator, 40, 300));
+        strcpy(fields[10],
+               dataset_generator_breakfasts[__dataset_generator_range(
+                   generator,
+                   0,
+                   DATASET_GENERATOR_LENGTH(dataset_generator_breakfasts) - 1)]);
+        strcpy(fields[11], __dataset_generator_range(generator, 0, 3) ? "Basic" : "Suite");
+
+        const int rating = __dataset_generator_range(generator, 0, 5);
+        if (rating)
+            snprintf(fields[12], DATASET_GENERATOR_FIELD_MAX, "%d", rating);
+        else
+            fields[12][0] = '\0';
+        fields[13][0] = '\0';
+
+        const int valid_user = generator->valid_users[user];
+        const int valid      = valid_user && !__dataset_generator_make_invalid(generator);
+        if (!valid && valid_user) {
+            switch (__dataset_generator_range(generator, 0, 3)) {
+                case 0:
+                    strcpy(fields[4], "6"); /* Too many stars */
+                    break;
+                case 1:
+                    strcpy(fields[8], fields[7]); /* Ends before beginning */
+                    memcpy(fields[8], "2020", 4);
+                    break;
+                case 2:
+                    strcpy(fields[10], "maybe");
+                    break;
+                default:
+                    strcpy(fields[12], "9");
+                    break;
+            }
+        }
+
+        __dataset_generator_check(generator,
+                                  "reservations.csv",
+                                  i + 2,
+                                  valid,
+                                  __dataset_generator_reject_reservation(generator,
+                                                                         fields,
+                                                                         valid_user));
+        __dataset_generator_write_row(output, 14, fields);
+    }
+}
+
+/**
+ * @brief Writes a random query to a query file.
+ *
+ * @param generator State of the generation.
+ * @param output    File where to write the query to.
+ */
+void __dataset_generator_query(dataset_generator_t *generator, FILE *output) {
+    char      id[DATASET_GENERATOR_FIELD_MAX], begin[DATASET_GENERATOR_FIELD_MAX],
+        end[DATASET_GENERATOR_FIELD_MAX];
+    const int type      = __dataset_generator_range(generator, 1, 10);
+    const int formatted = __dataset_generator_range(generator, 0, 4) == 0;
+    fprintf(output, "%d%s ", type, formatted ? "F" : "");
+
+    const size_t hotel = __dataset_generator_skewed(generator, generator->nhotels) + 1001;
+    const char  *airport =
+        dataset_generator_airports[__dataset_generator_skewed(
+            generator,
+            DATASET_GENERATOR_LENGTH(dataset_generator_airports))];
+
+    switch (type) {
+        case 1:
+            switch (__dataset_generator_range(generator, 0, 2)) {
+                case 0:
+                    __dataset_generator_user_id(id,
+                                                __dataset_generator_random(generator) %
+                                                    generator->nusers);
+                    fprintf(output, "%s\n", id);
+                    break;
+                case 1:
+                    fprintf(output,
+                            "%010" PRIu64 "\n",
+                            __dataset_generator_random(generator) % generator->nflights + 1);
+                    break;
+                default:
+                    fprintf(output,
+                            "Book%010" PRIu64 "\n",
+                            __dataset_generator_random(generator) % generator->nreservations + 1);
+                    break;
+            }
+            break;
+        case 2: {
+            const char *const kinds[] = {"", " flights", " reservations"};
+            __dataset_generator_user_id(id,
+                                        __dataset_generator_random(generator) % generator->nusers);
+            fprintf(output, "%s%s\n", id, kinds[__dataset_generator_range(generator, 0, 2)]);
+        } break;
+        case 3:
+        case 4:
+            fprintf(output, "HTL%zu\n", hotel);
+            break;
+        case 5:
+            __dataset_generator_date(generator, begin, 2021, 2021, 1);
+            __dataset_generator_date(generator, end, 2023, 2023, 1);
+            fprintf(output, "%s \"%s\" \"%s\"\n", airport, begin, end);
+            break;
+        case 6:
+            fprintf(output, "%d %d\n", __dataset_generator_range(generator, 2021, 2023),
+                    __dataset_generator_range(generator, 1, 20));
+            break;
+        case 7:
+            fprintf(output, "%d\n", __dataset_generator_range(generator, 1, 20));
+            break;
+        case 8:
+            __dataset_generator_date(generator, begin, 2021, 2022, 0);
+            __dataset_generator_date(generator, end, 2023, 2024, 0);
+            fprintf(output, "HTL%zu %s %s\n", hotel, begin, end);
+            break;
+        case 9: {
+            /* Prefix of a first name, so that there are matches */
+            const char *const name = dataset_generator_first_names[__dataset_generator_range(
+                generator,
+                0,
+                DATASET_GENERATOR_LENGTH(dataset_generator_first_names) - 1)];
+            fprintf(output, "%.*s\n", __dataset_generator_range(generator, 1, 3), name);
+        } break;
+        default:
+            switch (__dataset_generator_range(generator, 0, 2)) {
+                case 0:
+                    fputs("\n", output);
+                    break;
+                case 1:
+                    fprintf(output, "%d\n", __dataset_generator_range(generator, 2010, 2023));
+                    break;
+                default:
+                    fprintf(output,
+                            "%d %d\n",
+                            __dataset_generator_range(generator, 2010, 2023),
+                            __dataset_generator_range(generator, 1, 12));
+                    break;
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Opens a file in the output directory of a dataset, for writing.
+ *
+ * @param options Configuration of the dataset.
+ * @param name    Name of the file in ::dataset_generator_options_t::output_dir.
+ *
+ * @return The open file, or `NULL` on failure (a message is printed to `stderr`).
+ */
+FILE *__dataset_generator_open(const dataset_generator_options_t *options, const char *name) {
+    char path[PATH_MAX];
+    snprintf(path, PATH_MAX, "%s/%s", options->output_dir, name);
+
+    FILE *const file = fopen(path, "w");
+    if (!file)
+        fprintf(stderr, "Failed to open \"%s\" for writing!\n", path);
+    return file;
+}
+
+/**
+ * @brief Generates all files, once the generator's state is allocated.
+ *
+ * @param generator State of the generation.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure. A message will also be printed to `stderr`.
+ */
+int __dataset_generator_write_files(dataset_generator_t *generator) {
+    const char *const names[5] = {"users.csv",
+                                  "flights.csv",
+                                  "passengers.csv",
+                                  "reservations.csv",
+                                  "input.txt"};
+    FILE             *files[5] = {NULL};
+
+    int retval = 0;
+    for (size_t i = 0; i < 5; ++i) {
+        files[i] = __dataset_generator_open(generator->options, names[i]);
+        if (!files[i]) {
+            retval = 1;
+            goto DEFER_1;
+        }
+    }
+
+    __dataset_generator_users(generator, files[0]);
+    __dataset_generator_flights(generator, files[1], files[2]);
+    __dataset_generator_reservations(generator, files[3]);
+    for (size_t i = 0; i < generator->options->nqueries; ++i)
+        __dataset_generator_query(generator, files[4]);
+
+DEFER_1:
+    for (size_t i = 0; i < 5; ++i) {
+        if (files[i] && (ferror(files[i]) | fclose(files[i]))) {
+            fprintf(stderr, "Failed to write to \"%s\"!\n", names[i]);
+            retval = 1;
+        }
+    }
+    return retval;
+}
+
+int dataset_generator_generate(const dataset_generator_options_t *options) {
+    const double scale = options->scale;
+    dataset_generator_t generator = {
+        .options       = options,
+        .rng           = options->seed ? options->seed : 1,
+        .nusers        = DATASET_GENERATOR_BASE_USERS * scale + 1,
+        .nflights      = DATASET_GENERATOR_BASE_FLIGHTS * scale + 1,
+        .nreservations = DATASET_GENERATOR_BASE_RESERVATIONS * scale + 1,
+        .nhotels       = DATASET_GENERATOR_BASE_HOTELS * scale + 1,
+        .disagreements = 0};
+
+    generator.valid_users   = malloc(generator.nusers);
+    generator.valid_flights = malloc(generator.nflights);
+    generator.user          = user_create(NULL);
+    generator.flight        = flight_create(NULL);
+    generator.reservation   = reservation_create(NULL);
+
+    int retval = 1;
+    if (!generator.valid_users || !generator.valid_flights || !generator.user ||
+        !generator.flight || !generator.reservation) {
+        fputs("Failed to allocate dataset generator!\n", stderr);
+    } else {
+        user_reset_dates(generator.user);
+        flight_reset_seats(generator.flight);
+        flight_reset_schedule_dates(generator.flight);
+        reservation_reset_dates(generator.reservation);
+        retval = __dataset_generator_write_files(&generator);
+
+        if (generator.disagreements)
+            fprintf(stderr,
+                    "%zu rows don't have the intended validity!\n",
+                    generator.disagreements);
+    }
+
+    free(generator.valid_users);
+    free(generator.valid_flights);
+    if (generator.user)
+        user_free(generator.user);
+    if (generator.flight)
+        flight_free(generator.flight);
+    if (generator.reservation)
+        reservation_free(generator.reservation);
+    return retval;
+}
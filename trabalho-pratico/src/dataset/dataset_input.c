@@ -22,9 +22,15 @@
  * See [the header file's documentation](@ref dataset_input_examples).
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "dataset/dataset_input.h"
 #include "dataset/flights_loader.h"
@@ -44,76 +50,374 @@
  *     @brief File containing the dataset's user-flight relationships (passengers).
  * @var dataset_input::reservations
  *     @brief File containing the dataset's hotel reservations.
+ * @var dataset_input::row_estimates
+ *     @brief Estimated number of rows in each file (users, flights, passengers and reservations,
+ *            in this order), excluding headers. See ::__dataset_input_estimate_rows.
+ *
+ * All files are mapped to memory (see [mapped_file](@ref mapped_file.h)), so they can be read
+ * without the copies of `FILE` streams, and so that loading steps can read the same file (e.g.:
+ * `flights.csv`) without sharing a file position. Compressed files (see
+ * ::dataset_input_compressions) are decompressed to memory.
  */
 struct dataset_input {
-    FILE *users;
-    FILE *flights;
-    FILE *passengers;
-    FILE *reservations;
+    mapped_file_t *users;
+    mapped_file_t *flights;
+    mapped_file_t *passengers;
+    mapped_file_t *reservations;
+    size_t         row_estimates[4];
 };
 
+/**
+ * @struct dataset_input_compression_t
+ * @brief  A format dataset files may be compressed with.
+ *
+ * @var dataset_input_compression_t::extension
+ *     @brief Extension appended to `.csv` for files in this format.
+ * @var dataset_input_compression_t::decompressor
+ *     @brief Program that decompresses files in this format (see
+ *            ::mapped_file_open_decompressed). `NULL` for uncompressed files.
+ */
+typedef struct {
+    const char *extension;
+    const char *decompressor;
+} dataset_input_compression_t;
+
+/** @brief Formats of dataset files, in the order they're looked for. */
+const dataset_input_compression_t dataset_input_compressions[] = {
+    {"",     NULL  },
+    {".zst", "zstd"},
+    {".gz",  "gzip"},
+};
+
+/** @brief Number of elements in ::dataset_input_compressions. */
+#define DATASET_INPUT_COMPRESSION_COUNT \
+    (sizeof(dataset_input_compressions) / sizeof(*dataset_input_compressions))
+
+/**
+ * @brief Finds a file in a dataset, that may be compressed.
+ *
+ * @param path        Path to the directory containing the dataset.
+ * @param type        Type of the file (e.g.: `"users"`).
+ * @param file_path   Where to write the path of the file to.
+ * @param compression Where to write the format of the file to.
+ * @param file_stat   Where to write information about the file to.
+ *
+ * @retval 0 Success.
+ * @retval 1 File not found in any format (`errno` is set).
+ */
+int __dataset_input_find_file(const char                         *path,
+                              const char                         *type,
+                              char                                file_path[PATH_MAX],
+                              const dataset_input_compression_t **compression,
+                              struct stat                        *file_stat) {
+    for (size_t i = 0; i < DATASET_INPUT_COMPRESSION_COUNT; ++i) {
+        *compression = &dataset_input_compressions[i];
+        snprintf(file_path, PATH_MAX, "%s/%s.csv%s", path, type, (*compression)->extension);
+
+        if (!stat(file_path, file_stat))
+            return 0;
+        if (errno != ENOENT)
+            return 1;
+    }
+
+    return 1;
+}
+
+/** @brief Number of bytes at the beginning of a file whose lines are counted to estimate rows. */
+#define DATASET_INPUT_ROW_ESTIMATE_SAMPLE_SIZE (1 << 20)
+
+/**
+ * @brief   Estimates the number of rows in a dataset file.
+ * @details Lines are only counted in the first ::DATASET_INPUT_ROW_ESTIMATE_SAMPLE_SIZE bytes of
+ *          the file, and that count is extrapolated to the whole file. Smaller files are counted
+ *          exactly.
+ *
+ * @param file File to estimate the number of rows of.
+ *
+ * @return The estimated number of rows in @p file, not counting its header.
+ */
+size_t __dataset_input_estimate_rows(const mapped_file_t *file) {
+    const char *const contents = mapped_file_get_contents(file);
+    const size_t      size     = mapped_file_get_size(file);
+    if (!size)
+        return 0;
+
+    const size_t sample = size < DATASET_INPUT_ROW_ESTIMATE_SAMPLE_SIZE
+                              ? size
+                              : DATASET_INPUT_ROW_ESTIMATE_SAMPLE_SIZE;
+
+    size_t      lines = 0;
+    const char *line  = contents;
+    while (line && line < contents + sample) {
+        line = memchr(line, '\n', contents + sample - line);
+        if (line) {
+            lines++;
+            line++;
+        }
+    }
+
+    if (sample < size && lines)
+        lines = (double) lines * size / sample;
+    return lines ? lines - 1 : 0; /* Header */
+}
+
+/**
+ * @struct dataset_input_open_t
+ * @brief  A dataset file being opened, possibly on another thread.
+ *
+ * @var dataset_input_open_t::path
+ *     @brief Path to the file.
+ * @var dataset_input_open_t::compression
+ *     @brief Format of the file.
+ * @var dataset_input_open_t::file
+ *     @brief The opened file, or `NULL` on failure.
+ * @var dataset_input_open_t::row_estimate
+ *     @brief Estimated number of rows in ::dataset_input_open_t::file.
+ * @var dataset_input_open_t::thread
+ *     @brief Thread opening the file.
+ * @var dataset_input_open_t::is_thread
+ *     @brief Whether ::dataset_input_open_t::thread was started.
+ */
+typedef struct {
+    char                               path[PATH_MAX];
+    const dataset_input_compression_t *compression;
+    mapped_file_t                     *file;
+    size_t                             row_estimate;
+    pthread_t                          thread;
+    int                                is_thread;
+} dataset_input_open_t;
+
+/**
+ * @brief Opens a dataset file and estimates its number of rows.
+ *
+ * @param open_data A pointer to a ::dataset_input_open_t.
+ *
+ * @return Always `NULL`. Failures are reported by a `NULL` ::dataset_input_open_t::file.
+ */
+void *__dataset_input_open_file(void *open_data) {
+    dataset_input_open_t *const open = open_data;
+
+    if (open->compression->decompressor)
+        open->file = mapped_file_open_decompressed(open->path, open->compression->decompressor);
+    else
+        open->file = mapped_file_open(open->path);
+
+    if (open->file)
+        open->row_estimate = __dataset_input_estimate_rows(open->file);
+    return NULL;
+}
+
 dataset_input_t *dataset_input_create(const char *path) {
     dataset_input_t *const input = malloc(sizeof(dataset_input_t));
     if (!input)
         return NULL;
 
-    const char *const types[4] = {"users", "flights", "passengers", "reservations"};
-    FILE **const      files[4] = {&input->users,
-                                  &input->flights,
-                                  &input->passengers,
-                                  &input->reservations};
+    const char *const     types[4] = {"users", "flights", "passengers", "reservations"};
+    mapped_file_t **const files[4] = {&input->users,
+                                      &input->flights,
+                                      &input->passengers,
+                                      &input->reservations};
 
+    dataset_input_open_t opens[4];
+    int                  failed = 0;
     for (int i = 0; i < 4; ++i) {
-        char file_path[PATH_MAX];
-        snprintf(file_path, PATH_MAX, "%s/%s.csv", path, types[i]);
+        opens[i].file         = NULL;
+        opens[i].row_estimate = 0;
+        opens[i].is_thread    = 0;
 
-        *files[i] = fopen(file_path, "r");
-
-        if (!*files[i]) {
-            for (int j = 0; j < i; ++i)
-                fclose(*files[i]);
-            free(input);
-            return NULL;
+        struct stat statbuf;
+        if (__dataset_input_find_file(path,
+                                      types[i],
+                                      opens[i].path,
+                                      &opens[i].compression,
+                                      &statbuf)) {
+            failed               = 1;
+            opens[i].compression = NULL; /* Not opened */
+            continue;
         }
+
+        if (opens[i].compression->decompressor)
+            opens[i].is_thread =
+                !pthread_create(&opens[i].thread, NULL, __dataset_input_open_file, &opens[i]);
+        if (!opens[i].is_thread)
+            __dataset_input_open_file(&opens[i]);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        if (opens[i].is_thread)
+            pthread_join(opens[i].thread, NULL);
+        failed |= opens[i].compression && !opens[i].file;
+
+        *files[i]               = opens[i].file;
+        input->row_estimates[i] = opens[i].row_estimate;
+    }
+
+    if (failed) {
+        dataset_input_free(input);
+        return NULL;
     }
 
     return input;
 }
 
-int dataset_input_load_users(dataset_input_t        *input,
-                             dataset_error_output_t *output,
-                             database_t             *database) {
-    rewind(input->users);
-    return users_loader_load(input->users, database, output);
+int dataset_input_reserve(const dataset_input_t *input, database_t *database) {
+    return database_reserve(database,
+                            input->row_estimates[0],
+                            input->row_estimates[1],
+                            input->row_estimates[3],
+                            input->row_estimates[2]);
+}
+
+void dataset_input_get_sizes(const dataset_input_t *input,
+                             size_t                *users,
+                             size_t                *flights,
+                             size_t                *passengers,
+                             size_t                *reservations) {
+    const mapped_file_t *const files[4] = {input->users,
+                                           input->flights,
+                                           input->passengers,
+                                           input->reservations};
+    size_t *const              sizes[4] = {users, flights, passengers, reservations};
+
+    for (int i = 0; i < 4; ++i)
+        *sizes[i] = mapped_file_get_size(files[i]);
+}
+
+void dataset_input_get_files(const dataset_input_t *input,
+                             const mapped_file_t  **users,
+                             const mapped_file_t  **flights,
+                             const mapped_file_t  **passengers,
+                             const mapped_file_t  **reservations) {
+    *users        = input->users;
+    *flights      = input->flights;
+    *passengers   = input->passengers;
+    *reservations = input->reservations;
+}
+
+int dataset_input_load_users(dataset_input_t                 *input,
+                             dataset_error_output_t          *output,
+                             database_t                      *database,
+                             const dataset_parser_progress_t *progress) {
+    return users_loader_load(input->users, database, output, progress);
 }
 
-int dataset_input_load_flights(dataset_input_t        *input,
-                               dataset_error_output_t *output,
-                               database_t             *database) {
-    rewind(input->flights);
-    return flights_loader_load(input->flights, database, output);
+int dataset_input_load_flights(dataset_input_t                 *input,
+                               dataset_error_output_t          *output,
+                               database_t                      *database,
+                               const dataset_parser_progress_t *progress) {
+    return flights_loader_load(input->flights, database, output, progress);
+}
+
+int dataset_input_load_passengers(dataset_input_t                 *input,
+                                  dataset_error_output_t          *output,
+                                  database_t                      *database,
+                                  const dataset_parser_progress_t *progress) {
+    return passengers_loader_load(input->passengers,
+                                  input->flights,
+                                  database,
+                                  output,
+                                  progress);
+}
+
+int dataset_input_load_reservations(dataset_input_t                 *input,
+                                    dataset_error_output_t          *output,
+                                    database_t                      *database,
+                                    const dataset_parser_progress_t *progress) {
+    return reservations_loader_load(input->reservations, database, output, progress);
+}
+
+/**
+ * @brief Mixes a number into an FNV-1a hash, byte by byte.
+ *
+ * @param hash  Current value of the hash.
+ * @param value Number to be mixed into @p hash.
+ *
+ * @return The new value of the hash.
+ */
+uint64_t __dataset_input_fingerprint_mix(uint64_t hash, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 0x100000001b3;
+    }
+    return hash;
 }
 
-int dataset_input_load_passengers(dataset_input_t        *input,
-                                  dataset_error_output_t *output,
-                                  database_t             *database) {
-    rewind(input->passengers);
-    rewind(input->flights);
-    return passengers_loader_load(input->passengers, input->flights, database, output);
+/**
+ * @brief Number of bytes read from the beginning, the middle and the end of each file, to be mixed
+ *        into a dataset's fingerprint.
+ */
+#define DATASET_INPUT_FINGERPRINT_SAMPLE_SIZE 4096
+
+/**
+ * @brief   Mixes samples of the contents of a file into an FNV-1a hash.
+ * @details Metadata alone misses files replaced by others with the same size and modification time
+ *          (e.g.: extracted from an archive), and reading a few pages per file is still cheap.
+ *
+ * @param hash Current value of the hash, to be updated.
+ * @param path Path to the file.
+ * @param size Size of the file, in bytes.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __dataset_input_fingerprint_sample(uint64_t *hash, const char *path, size_t size) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    const size_t sample     = DATASET_INPUT_FINGERPRINT_SAMPLE_SIZE;
+    const size_t last       = size > sample ? size - sample : 0;
+    const size_t offsets[3] = {0, last / 2, last};
+    for (int i = 0; i < 3; ++i) {
+        char          buffer[DATASET_INPUT_FINGERPRINT_SAMPLE_SIZE];
+        const ssize_t read_bytes = pread(fd, buffer, sample, offsets[i]);
+        if (read_bytes < 0) {
+            close(fd);
+            return 1;
+        }
+
+        for (ssize_t j = 0; j < read_bytes; ++j) {
+            *hash ^= (unsigned char) buffer[j];
+            *hash *= 0x100000001b3;
+        }
+    }
+
+    close(fd);
+    return 0;
 }
 
-int dataset_input_load_reservations(dataset_input_t        *input,
-                                    dataset_error_output_t *output,
-                                    database_t             *database) {
-    rewind(input->reservations);
-    return reservations_loader_load(input->reservations, database, output);
+int dataset_input_get_fingerprint(const char *path, uint64_t *fingerprint) {
+    const char *const types[4] = {"users", "flights", "passengers", "reservations"};
+
+    uint64_t hash = 0xcbf29ce484222325;
+    for (int i = 0; i < 4; ++i) {
+        char                               file_path[PATH_MAX];
+        const dataset_input_compression_t *compression;
+        struct stat                        file_stat;
+        if (__dataset_input_find_file(path, types[i], file_path, &compression, &file_stat))
+            return 1;
+
+        hash = __dataset_input_fingerprint_mix(hash, file_stat.st_dev);
+        hash = __dataset_input_fingerprint_mix(hash, file_stat.st_ino);
+        hash = __dataset_input_fingerprint_mix(hash, file_stat.st_size);
+        hash = __dataset_input_fingerprint_mix(hash, file_stat.st_mtim.tv_sec);
+        hash = __dataset_input_fingerprint_mix(hash, file_stat.st_mtim.tv_nsec);
+        if (__dataset_input_fingerprint_sample(&hash, file_path, file_stat.st_size))
+            return 1;
+    }
+
+    *fingerprint = hash;
+    return 0;
 }
 
 void dataset_input_free(dataset_input_t *input) {
-    fclose(input->users);
-    fclose(input->flights);
-    fclose(input->passengers);
-    fclose(input->reservations);
+    mapped_file_t *const files[4] = {input->users,
+                                     input->flights,
+                                     input->passengers,
+                                     input->reservations};
+    for (int i = 0; i < 4; ++i)
+        if (files[i])
+            mapped_file_close(files[i]);
 
     free(input);
 }
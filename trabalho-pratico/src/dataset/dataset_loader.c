@@ -22,15 +22,295 @@
  * See [the header file's documentation](@ref dataset_loader_examples).
  */
 
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 
+#include "database/database_snapshot.h"
 #include "dataset/dataset_input.h"
 #include "dataset/dataset_loader.h"
+#include "testing/event_trace.h"
+#include "utils/thread_count.h"
 
-int dataset_loader_load(database_t            *database,
-                        const char            *dataset_path,
-                        const char            *errors_path,
-                        performance_metrics_t *metrics) {
+/**
+ * @brief Type of the methods in [dataset_input](@ref dataset_input.h) that load a single file of a
+ *        dataset (e.g.: ::dataset_input_load_users).
+ */
+typedef int (*dataset_loader_step_callback_t)(dataset_input_t                 *input,
+                                              dataset_error_output_t          *output,
+                                              database_t                      *database,
+                                              const dataset_parser_progress_t *progress);
+
+/**
+ * @struct dataset_loader_progress_t
+ * @brief  Where to report the progress of loading a dataset to.
+ *
+ * @var dataset_loader_progress_t::callback
+ *     @brief Method called to report the progress of each file.
+ * @var dataset_loader_progress_t::user_data
+ *     @brief Pointer passed to ::dataset_loader_progress_t::callback.
+ * @var dataset_loader_progress_t::sizes
+ *     @brief Size of each file (indexed by ::performance_metrics_dataset_step_t).
+ */
+typedef struct {
+    dataset_loader_progress_callback_t callback;
+    void                              *user_data;
+    size_t                             sizes[PERFORMANCE_METRICS_DATASET_FILE_COUNT];
+} dataset_loader_progress_t;
+
+/**
+ * @struct dataset_loader_step_t
+ * @brief  A step of loading a dataset (a single file), that may be running on its own thread.
+ *
+ * @var dataset_loader_step_t::load
+ *     @brief Method that loads the file.
+ * @var dataset_loader_step_t::metrics_step
+ *     @brief Identifier of this step, for performance measurement.
+ * @var dataset_loader_step_t::trace_name
+ *     @brief Name of this step in event traces (see [event_trace](@ref event_trace.h)).
+ * @var dataset_loader_step_t::input
+ *     @brief Dataset input files.
+ * @var dataset_loader_step_t::output
+ *     @brief Dataset error files.
+ * @var dataset_loader_step_t::database
+ *     @brief Database where to load the file into.
+ * @var dataset_loader_step_t::progress
+ *     @brief Where to report the progress of this step to. `NULL` when not reporting progress.
+ * @var dataset_loader_step_t::parser_progress
+ *     @brief Progress reporter for the parser, that forwards to ::dataset_loader_step_t::progress.
+ * @var dataset_loader_step_t::phases
+ *     @brief Where the parser measures the time spent in each phase of loading the file. `NULL`
+ *            when not profiling.
+ * @var dataset_loader_step_t::rows
+ *     @brief Number of lines of the file loaded so far.
+ * @var dataset_loader_step_t::thread
+ *     @brief Thread in which this step is running (only if ::dataset_loader_step_t::is_thread).
+ * @var dataset_loader_step_t::is_thread
+ *     @brief   Whether this step is running on another thread.
+ *     @details Steps are run on the calling thread when profiling, or when threads can't be
+ *              created.
+ * @var dataset_loader_step_t::retval
+ *     @brief Value returned by ::dataset_loader_step_t::load.
+ */
+typedef struct {
+    const dataset_loader_step_callback_t     load;
+    const performance_metrics_dataset_step_t metrics_step;
+    const char *const                        trace_name;
+
+    dataset_input_t                 *input;
+    dataset_error_output_t          *output;
+    database_t                      *database;
+    const dataset_loader_progress_t *progress;
+    dataset_parser_progress_t        parser_progress;
+    dataset_parser_phases_t         *phases;
+    size_t                           rows;
+
+    pthread_t thread;
+    int       is_thread;
+    int       retval;
+} dataset_loader_step_t;
+
+/**
+ * @brief   Reports the progress of a dataset loading step.
+ * @details Used as the callback of ::dataset_loader_step_t::parser_progress.
+ *
+ * @param step_data A pointer to a ::dataset_loader_step_t.
+ * @param bytes     Number of bytes of the file already loaded.
+ * @param rows      Number of lines of the file already loaded.
+ *
+ * @return The value returned by the callback in ::dataset_loader_step_t::progress.
+ */
+int __dataset_loader_step_progress(void *step_data, size_t bytes, size_t rows) {
+    dataset_loader_step_t *const           step     = step_data;
+    const dataset_loader_progress_t *const progress = step->progress;
+
+    step->rows = rows;
+    return progress->callback(progress->user_data,
+                              step->metrics_step,
+                              bytes,
+                              progress->sizes[step->metrics_step],
+                              rows);
+}
+
+/**
+ * @brief  Thread entry point for a dataset loading step.
+ * @param  step_data A pointer to a ::dataset_loader_step_t.
+ * @return Always `NULL`. The result is placed in ::dataset_loader_step_t::retval.
+ */
+void *__dataset_loader_step_thread(void *step_data) {
+    dataset_loader_step_t *const step = step_data;
+    event_trace_begin("dataset", step->trace_name, 0);
+    if (!step->progress && !step->phases) {
+        step->retval = step->load(step->input, step->output, step->database, NULL);
+        event_trace_end();
+        return NULL;
+    }
+
+    step->parser_progress = (dataset_parser_progress_t){
+        .callback  = step->progress ? __dataset_loader_step_progress : NULL,
+        .user_data = step,
+        .phases    = step->phases};
+    step->retval = step->load(step->input, step->output, step->database, &step->parser_progress);
+    if (!step->retval && step->progress) {
+        const size_t size = step->progress->sizes[step->metrics_step];
+        step->retval      = __dataset_loader_step_progress(step, size, step->rows) != 0;
+    }
+    event_trace_end();
+    return NULL;
+}
+
+/**
+ * @brief   Starts loading a file of a dataset.
+ * @details When profiling, the step is run on the calling thread, so that resource usage can be
+ *          attributed to each file, and the time spent in each phase of parsing it is measured
+ *          (see ::performance_metrics_set_dataset_phases). Steps also run on the calling thread
+ *          when a new thread can't be created, or when limited to a single thread (see
+ *          ::thread_count_get).
+ *
+ * @param step     Step to be started.
+ * @param input    Dataset input files.
+ * @param output   Dataset error files.
+ * @param database Database where to load the file into.
+ * @param metrics  Where to register program performance data to. Can be `NULL` for no profiling.
+ * @param progress Where to report the progress of the step to. Can be `NULL`.
+ */
+void __dataset_loader_step_start(dataset_loader_step_t           *step,
+                                 dataset_input_t                 *input,
+                                 dataset_error_output_t          *output,
+                                 database_t                      *database,
+                                 performance_metrics_t           *metrics,
+                                 const dataset_loader_progress_t *progress) {
+    step->input     = input;
+    step->output    = output;
+    step->database  = database;
+    step->progress  = progress;
+    step->rows      = 0;
+    step->phases    = NULL;
+    step->is_thread = 0;
+    if (!metrics && thread_count_get() > 1)
+        step->is_thread = !pthread_create(&step->thread, NULL, __dataset_loader_step_thread, step);
+
+    if (!step->is_thread) {
+        dataset_parser_phases_t phases = {0};
+        if (metrics)
+            step->phases = &phases;
+
+        performance_metrics_measure_dataset(metrics, step->metrics_step);
+        __dataset_loader_step_thread(step);
+
+        if (metrics)
+            performance_metrics_set_dataset_phases(metrics, step->metrics_step, &phases);
+        step->phases = NULL;
+    }
+}
+
+/**
+ * @brief Waits for a dataset loading step to finish.
+ * @param step Step started by ::__dataset_loader_step_start.
+ *
+ * @retval 0 Success.
+ * @retval 1 Fatal failure (in the step or while joining its thread).
+ */
+int __dataset_loader_step_wait(dataset_loader_step_t *step) {
+    if (step->is_thread) {
+        step->is_thread = 0;
+        if (pthread_join(step->thread, NULL))
+            return 1;
+    }
+    return step->retval != 0;
+}
+
+/**
+ * @brief Loads all files of a dataset into a database.
+ *
+ * @param database    Database where to store the dataset data in.
+ * @param input_files Dataset input files.
+ * @param error_files Dataset error files.
+ * @param metrics     Where to register program performance data to. Can be `NULL` for no
+ *                    profiling.
+ * @param progress    Where to report loading progress to. Can be `NULL`.
+ *
+ * @retval 0 Success.
+ * @retval 1 Fatal failure (IO or allocation), or loading cancelled through @p progress.
+ */
+int __dataset_loader_run(database_t                      *database,
+                         dataset_input_t                 *input_files,
+                         dataset_error_output_t          *error_files,
+                         performance_metrics_t           *metrics,
+                         const dataset_loader_progress_t *progress) {
+
+    dataset_loader_step_t users = {.load         = dataset_input_load_users,
+                                   .metrics_step = PERFORMANCE_METRICS_DATASET_STEP_USERS,
+                                   .trace_name   = "users"};
+    dataset_loader_step_t flights = {.load         = dataset_input_load_flights,
+                                     .metrics_step = PERFORMANCE_METRICS_DATASET_STEP_FLIGHTS,
+                                     .trace_name   = "flights"};
+    dataset_loader_step_t passengers = {
+        .load         = dataset_input_load_passengers,
+        .metrics_step = PERFORMANCE_METRICS_DATASET_STEP_PASSENGERS,
+        .trace_name   = "passengers"};
+    dataset_loader_step_t reservations = {
+        .load         = dataset_input_load_reservations,
+        .metrics_step = PERFORMANCE_METRICS_DATASET_STEP_RESERVATIONS,
+        .trace_name   = "reservations"};
+
+    /*
+     * Load dataset. Users and flights are independent, and each of passengers and reservations is
+     * started as soon as the files it depends on are loaded (see dataset_input.h). Additions to the
+     * database are serialized by the database itself.
+     */
+    if (progress)
+        for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_FILE_COUNT; ++i)
+            if (progress->callback(progress->user_data, i, 0, progress->sizes[i], 0))
+                return 1;
+
+    __dataset_loader_step_start(&users, input_files, error_files, database, metrics, progress);
+    __dataset_loader_step_start(&flights, input_files, error_files, database, metrics, progress);
+
+    const int users_retval = __dataset_loader_step_wait(&users);
+    if (!users_retval)
+        __dataset_loader_step_start(&reservations,
+                                    input_files,
+                                    error_files,
+                                    database,
+                                    metrics,
+                                    progress);
+
+    const int flights_retval = __dataset_loader_step_wait(&flights);
+    if (!users_retval && !flights_retval)
+        __dataset_loader_step_start(&passengers,
+                                    input_files,
+                                    error_files,
+                                    database,
+                                    metrics,
+                                    progress);
+
+    /* Waiting on a step that wasn't started returns its zero-initialized retval */
+    const int reservations_retval = __dataset_loader_step_wait(&reservations);
+    const int passengers_retval   = __dataset_loader_step_wait(&passengers);
+    return users_retval || flights_retval || reservations_retval || passengers_retval;
+}
+
+/**
+ * @brief Parses a dataset in @p dataset_path and stores the data in @p database.
+ *
+ * @param database     Database where to store the dataset data in.
+ * @param dataset_path Path to the directory containing the dataset.
+ * @param errors_path  Path to the directory where to output error files to.
+ * @param metrics      Where to register program performance data to. Can be `NULL` for no
+ *                     profiling.
+ * @param callback     Method called to report the progress of loading each file. Can be `NULL`.
+ * @param user_data    Pointer passed to @p callback.
+ *
+ * @retval 0 Success.
+ * @retval 1 Fatal failure (IO or allocation), or loading cancelled by @p callback.
+ */
+int __dataset_loader_load(database_t                        *database,
+                          const char                        *dataset_path,
+                          const char                        *errors_path,
+                          performance_metrics_t             *metrics,
+                          dataset_loader_progress_callback_t callback,
+                          void                              *user_data) {
 
     dataset_input_t *const input_files = dataset_input_create(dataset_path);
     if (!input_files)
@@ -42,37 +322,95 @@ int dataset_loader_load(database_t            *database,
         return 1;
     }
 
-    /* Load dataset */
-    int retval = 0;
-
-    performance_metrics_measure_dataset(metrics, PERFORMANCE_METRICS_DATASET_STEP_USERS);
-    if (dataset_input_load_users(input_files, error_files, database)) {
-        retval = 1;
-        goto CLEANUP;
-    }
+    /* Failing to reserve space isn't an error: the database will grow as data is loaded */
+    dataset_input_reserve(input_files, database);
 
-    performance_metrics_measure_dataset(metrics, PERFORMANCE_METRICS_DATASET_STEP_FLIGHTS);
-    if (dataset_input_load_flights(input_files, error_files, database)) {
-        retval = 1;
-        goto CLEANUP;
-    }
+    dataset_loader_progress_t progress = {.callback = callback, .user_data = user_data};
+    dataset_input_get_sizes(input_files,
+                            &progress.sizes[PERFORMANCE_METRICS_DATASET_STEP_USERS],
+                            &progress.sizes[PERFORMANCE_METRICS_DATASET_STEP_FLIGHTS],
+                            &progress.sizes[PERFORMANCE_METRICS_DATASET_STEP_PASSENGERS],
+                            &progress.sizes[PERFORMANCE_METRICS_DATASET_STEP_RESERVATIONS]);
 
-    performance_metrics_measure_dataset(metrics, PERFORMANCE_METRICS_DATASET_STEP_PASSENGERS);
-    if (dataset_input_load_passengers(input_files, error_files, database)) {
-        retval = 1;
-        goto CLEANUP;
-    }
+    const int retval = __dataset_loader_run(database,
+                                            input_files,
+                                            error_files,
+                                            metrics,
+                                            callback ? &progress : NULL);
 
-    performance_metrics_measure_dataset(metrics, PERFORMANCE_METRICS_DATASET_STEP_RESERVATIONS);
-    if (dataset_input_load_reservations(input_files, error_files, database)) {
-        retval = 1;
-        goto CLEANUP;
+    /*
+     * Failing to compact, to cluster or to build indices isn't an error: the database is just
+     * larger or slower than needed, and indices are built when first needed.
+     */
+    performance_metrics_measure_dataset(metrics, PERFORMANCE_METRICS_DATASET_STEP_INDEXES);
+    if (!retval) {
+        event_trace_begin("dataset", "indexes", 0);
+        database_compact(database);
+        if (database_get_layout_policy(database) == DATABASE_LAYOUT_POLICY_CLUSTERED)
+            database_cluster(database);
+        if (database_get_index_policy(database) == DATABASE_INDEX_POLICY_EAGER)
+            database_build_indexes(database, DATABASE_INDEX_SET_ALL);
+        event_trace_end();
     }
-
     performance_metrics_measure_dataset(metrics, PERFORMANCE_METRICS_DATASET_STEP_DONE);
 
-CLEANUP:
     dataset_input_free(input_files);
     dataset_error_output_free(error_files);
     return retval;
 }
+
+int dataset_loader_load(database_t            *database,
+                        const char            *dataset_path,
+                        const char            *errors_path,
+                        performance_metrics_t *metrics) {
+    return __dataset_loader_load(database, dataset_path, errors_path, metrics, NULL, NULL);
+}
+
+database_t *dataset_loader_load_cached(const char            *dataset_path,
+                                       const char            *errors_path,
+                                       const char            *snapshot_path,
+                                       performance_metrics_t *metrics) {
+
+    /* Error files are kept in a directory named after the snapshot */
+    char snapshot_errors_path[PATH_MAX];
+    if (snapshot_path &&
+        (size_t) snprintf(snapshot_errors_path, PATH_MAX, "%s.errors", snapshot_path) >= PATH_MAX)
+        return NULL;
+
+    uint64_t  fingerprint;
+    const int has_fingerprint =
+        snapshot_path && !dataset_input_get_fingerprint(dataset_path, &fingerprint);
+    if (has_fingerprint) {
+        database_t *const database = database_snapshot_load(snapshot_path, fingerprint);
+        if (database) {
+            if (!errors_path || !dataset_error_output_copy(snapshot_errors_path, errors_path))
+                return database;
+            database_free(database); /* Parse the dataset again, to write its error files */
+        }
+    }
+
+    database_t *const database = database_create();
+    if (!database)
+        return NULL;
+
+    /* Snapshots keep the order of entities, and are meant for processes that run many queries */
+    database_set_layout_policy(database, DATABASE_LAYOUT_POLICY_CLUSTERED);
+    if (dataset_loader_load(database, dataset_path, errors_path, metrics)) {
+        database_free(database);
+        return NULL;
+    }
+
+    /* Failing to save a snapshot (e.g.: read-only cache directory) isn't an error */
+    if (has_fingerprint && (!errors_path || !dataset_error_output_copy(errors_path,
+                                                                       snapshot_errors_path)))
+        database_snapshot_save(database, snapshot_path, fingerprint);
+    return database;
+}
+
+int dataset_loader_load_with_progress(database_t                        *database,
+                                      const char                        *dataset_path,
+                                      const char                        *errors_path,
+                                      dataset_loader_progress_callback_t callback,
+                                      void                              *user_data) {
+    return __dataset_loader_load(database, dataset_path, errors_path, NULL, callback, user_data);
+}
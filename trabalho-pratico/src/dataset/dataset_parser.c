@@ -22,11 +22,20 @@
  * See [the header file's documentation](@ref dataset_parser_examples).
  */
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "dataset/dataset_parser.h"
-#include "utils/stream_utils.h"
+#include "utils/int_utils.h"
+#include "utils/thread_count.h"
+
+/** @brief Approximate size of each chunk in ::dataset_parser_parse_parallel (4 MiB). */
+#define DATASET_PARSER_CHUNK_SIZE (1 << 22)
+
+/** @brief Maximum number of threads used by ::dataset_parser_parse_parallel. */
+#define DATASET_PARSER_MAX_THREADS 32
 
 /**
  * @struct dataset_parser_grammar
@@ -57,10 +66,17 @@ struct dataset_parser_grammar {
  * @var dataset_parser_t::user_data
  *     @brief   Data to be passed to callbacks in ::dataset_parser_t::grammar
  *     @details Not owned by this `struct`.
+ * @var dataset_parser_t::ntokens
+ *     @brief Number of first-order tokens parsed so far.
+ * @var dataset_parser_t::phases
+ *     @brief Where the current thread accumulates the time spent in each phase of parsing. `NULL`
+ *            when not measuring.
  */
 typedef struct {
     const dataset_parser_grammar_t *const grammar;
     void *const                           user_data;
+    size_t                                ntokens;
+    dataset_parser_phases_t *const        phases;
 } dataset_parser_t;
 
 dataset_parser_grammar_t *
@@ -106,6 +122,16 @@ void dataset_parser_grammar_free(dataset_parser_grammar_t *grammar) {
     free(grammar);
 }
 
+/**
+ * @brief  Reads a monotonic clock, for measuring the phases of parsing.
+ * @return The current time, in nanoseconds.
+ */
+uint64_t __dataset_parser_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
 /**
  * @brief   Callback for every token parsed.
  * @details Auxiliary function for ::dataset_parser_parse, responsible for calling
@@ -113,26 +139,344 @@ void dataset_parser_grammar_free(dataset_parser_grammar_t *grammar) {
  *
  * @param user_data A pointer to a ::dataset_parser_t.
  * @param token     The token to be parsed.
+ * @param offset    Offset of @p token in the file.
  */
-int __parse_stream_iter(void *user_data, char *token) {
+int __parse_stream_iter(void *user_data, char *token, size_t offset) {
     dataset_parser_t *const parser = user_data;
+    parser->ntokens++;
+
+    dataset_parser_phases_t *const phases = parser->phases;
+    const uint64_t                 begin  = phases ? __dataset_parser_now() : 0;
+
+    int retval = parser->grammar->before_parse_callback(parser->user_data, token, offset);
+    if (!retval) {
+        const int parser_ret = fixed_n_delimiter_parser_parse_string(token,
+                                                                     parser->grammar->token_grammar,
+                                                                     parser->user_data);
+        retval               = parser->grammar->token_callback(parser->user_data, parser_ret);
+        if (phases)
+            phases->rejected_tokens += parser_ret != 0;
+    }
 
-    const int before_parse_ret = parser->grammar->before_parse_callback(parser->user_data, token);
-    if (before_parse_ret)
-        return before_parse_ret;
+    if (phases)
+        phases->validate_time += __dataset_parser_now() - begin;
+    return retval;
+}
 
-    const int parser_ret = fixed_n_delimiter_parser_parse_string(token,
-                                                                 parser->grammar->token_grammar,
-                                                                 parser->user_data);
-    return parser->grammar->token_callback(parser->user_data, parser_ret);
+/**
+ * @brief   Splits a chunk of a file into first-order tokens, and parses them.
+ * @details When measuring (see ::dataset_parser_t::phases), the chunk is read from disk before it's
+ *          parsed, so that IO isn't counted as part of tokenization.
+ *
+ * @param file   File being parsed.
+ * @param parser State of the parser.
+ * @param begin  Offset of the beginning of the chunk.
+ * @param end    Offset of the end of the chunk (exclusive).
+ *
+ * @return The value returned by ::mapped_file_tokenize_range_with_offsets.
+ */
+int __dataset_parser_parse_chunk(const mapped_file_t *file,
+                                 dataset_parser_t    *parser,
+                                 size_t               begin,
+                                 size_t               end) {
+    dataset_parser_phases_t *const phases    = parser->phases;
+    const char                     delimiter = parser->grammar->delimiter;
+    if (!phases)
+        return mapped_file_tokenize_range_with_offsets(file,
+                                                       begin,
+                                                       end,
+                                                       delimiter,
+                                                       __parse_stream_iter,
+                                                       parser);
+
+    const uint64_t io_begin = __dataset_parser_now();
+    mapped_file_touch(file, begin, end);
+    const uint64_t io_end = __dataset_parser_now();
+
+    const uint64_t validate_time = phases->validate_time;
+    const size_t   ntokens       = parser->ntokens;
+    const int      retval        = mapped_file_tokenize_range_with_offsets(file,
+                                                                           begin,
+                                                                           end,
+                                                                           delimiter,
+                                                                           __parse_stream_iter,
+                                                                           parser);
+
+    /* Time not spent in the grammar's callbacks was spent splitting and copying tokens */
+    const uint64_t chunk_time = __dataset_parser_now() - io_end;
+    phases->io_time += io_end - io_begin;
+    phases->tokenize_time += chunk_time - (phases->validate_time - validate_time);
+    phases->bytes += end - begin;
+    phases->tokens += parser->ntokens - ntokens;
+    return retval;
 }
 
-int dataset_parser_parse(FILE *file, const dataset_parser_grammar_t *grammar, void *user_data) {
-    dataset_parser_t parser = {.grammar = grammar, .user_data = user_data};
+/**
+ * @brief Adds the measurements of a thread to the measurements of a whole file.
+ *
+ * @param total  Measurements of the whole file.
+ * @param thread Measurements of a thread.
+ */
+void __dataset_parser_phases_add(dataset_parser_phases_t       *total,
+                                 const dataset_parser_phases_t *thread) {
+    total->io_time += thread->io_time;
+    total->tokenize_time += thread->tokenize_time;
+    total->validate_time += thread->validate_time;
+    total->commit_time += thread->commit_time;
+    total->bytes += thread->bytes;
+    total->tokens += thread->tokens;
+    total->rejected_tokens += thread->rejected_tokens;
+}
+
+/**
+ * @brief Finds where a chunk of a file, to be parsed at once, ends.
+ *
+ * @param contents  Contents of the file.
+ * @param size      Number of bytes in @p contents.
+ * @param begin     Offset in @p contents where the chunk starts.
+ * @param delimiter First-order delimiter, after which the chunk must end.
+ *
+ * @return The offset right after the first @p delimiter at least ::DATASET_PARSER_CHUNK_SIZE bytes
+ *         after @p begin, or @p size if there's no such delimiter.
+ */
+size_t __dataset_parser_chunk_end(const char *contents, size_t size, size_t begin, char delimiter) {
+    if (size - begin <= DATASET_PARSER_CHUNK_SIZE)
+        return size;
+
+    const char *const found = memchr(contents + begin + DATASET_PARSER_CHUNK_SIZE,
+                                     delimiter,
+                                     size - begin - DATASET_PARSER_CHUNK_SIZE);
+    return found ? (size_t) (found - contents + 1) : size;
+}
+
+int dataset_parser_parse(const mapped_file_t             *file,
+                         const dataset_parser_grammar_t  *grammar,
+                         void                            *user_data,
+                         const dataset_parser_progress_t *progress) {
+    dataset_parser_phases_t phases = {0};
+    dataset_parser_t        parser = {.grammar   = grammar,
+                                      .user_data = user_data,
+                                      .ntokens   = 0,
+                                      .phases    = progress && progress->phases ? &phases : NULL};
+
+    /* Parse in chunks, to read the next one from disk and to report progress between them */
+    int          retval   = 0;
+    const char  *contents = mapped_file_get_contents(file);
+    const size_t size     = mapped_file_get_size(file);
+    for (size_t begin = 0; begin < size && !retval;) {
+        const size_t end = __dataset_parser_chunk_end(contents, size, begin, grammar->delimiter);
+        mapped_file_prefetch(file, end, end + DATASET_PARSER_CHUNK_SIZE);
+
+        retval = __dataset_parser_parse_chunk(file, &parser, begin, end);
+        if (retval == MAPPED_FILE_TOKENIZE_RET_ALLOCATION_FAILURE)
+            retval = DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE;
+        else if (!retval && progress && progress->callback)
+            retval = progress->callback(progress->user_data, end, parser.ntokens);
+
+        begin = end;
+    }
+
+    if (parser.phases)
+        __dataset_parser_phases_add(progress->phases, &phases);
+    return retval;
+}
 
-    const int retval = stream_tokenize(file, grammar->delimiter, __parse_stream_iter, &parser);
-    if (retval == STREAM_TOKENIZE_RET_ALLOCATION_FAILURE)
+/**
+ * @struct dataset_parser_parallel_t
+ * @brief  State shared between all threads of ::dataset_parser_parse_parallel.
+ *
+ * @var dataset_parser_parallel_t::file
+ *     @brief File being parsed.
+ * @var dataset_parser_parallel_t::grammar
+ *     @brief Grammar that defines the parser.
+ * @var dataset_parser_parallel_t::create_chunk
+ *     @brief Callback that creates the staging data for a chunk.
+ * @var dataset_parser_parallel_t::finish_chunk
+ *     @brief Callback called after a chunk is parsed, before it's committed. Can be `NULL`.
+ * @var dataset_parser_parallel_t::commit_chunk
+ *     @brief Callback that commits the staging data of a chunk.
+ * @var dataset_parser_parallel_t::free_chunk
+ *     @brief Callback that frees the staging data of a chunk.
+ * @var dataset_parser_parallel_t::user_data
+ *     @brief Data passed to ::dataset_parser_parallel_t::create_chunk,
+ *            ::dataset_parser_parallel_t::finish_chunk and
+ *            ::dataset_parser_parallel_t::commit_chunk.
+ * @var dataset_parser_parallel_t::progress
+ *     @brief Where to report progress to after every commit. Can be `NULL`.
+ * @var dataset_parser_parallel_t::committed_tokens
+ *     @brief   Number of first-order tokens in all committed chunks.
+ *     @details Only accessed by the thread committing a chunk, so it isn't protected by
+ *              ::dataset_parser_parallel_t::lock.
+ * @var dataset_parser_parallel_t::lock
+ *     @brief Lock that protects all the fields below it.
+ * @var dataset_parser_parallel_t::committed
+ *     @brief Condition variable signaled every time a chunk is committed (or skipped).
+ * @var dataset_parser_parallel_t::next_chunk_begin
+ *     @brief Offset in the file where the next chunk to be parsed begins.
+ * @var dataset_parser_parallel_t::next_chunk_index
+ *     @brief Index of the next chunk to be parsed.
+ * @var dataset_parser_parallel_t::next_commit_index
+ *     @brief Index of the next chunk to be committed.
+ * @var dataset_parser_parallel_t::retval
+ *     @brief First non-`0` value returned by a callback (`0` while all succeed).
+ */
+typedef struct {
+    const mapped_file_t *const                 file;
+    const dataset_parser_grammar_t *const      grammar;
+    const dataset_parser_chunk_create_callback create_chunk;
+    const dataset_parser_chunk_finish_callback finish_chunk;
+    const dataset_parser_chunk_commit_callback commit_chunk;
+    const dataset_parser_chunk_free_callback   free_chunk;
+    void *const                                user_data;
+    const dataset_parser_progress_t *const     progress;
+    size_t                                     committed_tokens;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  committed;
+    size_t          next_chunk_begin, next_chunk_index, next_commit_index;
+    int             retval;
+} dataset_parser_parallel_t;
+
+/**
+ * @brief   Parses chunks of a file until there are none left or an error occurs.
+ * @details This is the entry point of every thread in ::dataset_parser_parse_parallel, that also
+ *          gets called on the main thread.
+ *
+ * @param parallel_data A pointer to a ::dataset_parser_parallel_t.
+ *
+ * @return Always `NULL`. Errors are reported in ::dataset_parser_parallel_t::retval.
+ */
+void *__dataset_parser_parallel_worker(void *parallel_data) {
+    dataset_parser_parallel_t *const p = parallel_data;
+
+    const char  *contents = mapped_file_get_contents(p->file);
+    const size_t size     = mapped_file_get_size(p->file);
+
+    /* Accumulated by this thread only, and added to the shared measurements in the end */
+    dataset_parser_phases_t        phases          = {0};
+    dataset_parser_phases_t *const measured_phases = p->progress && p->progress->phases ? &phases
+                                                                                        : NULL;
+
+    while (1) {
+        /* Choose the next chunk, ending it after a delimiter */
+        pthread_mutex_lock(&p->lock);
+        if (p->retval || p->next_chunk_begin >= size) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+
+        const char   delimiter = p->grammar->delimiter;
+        const size_t index     = p->next_chunk_index++;
+        const size_t begin     = p->next_chunk_begin;
+        const size_t end       = __dataset_parser_chunk_end(contents, size, begin, delimiter);
+        p->next_chunk_begin    = end;
+        pthread_mutex_unlock(&p->lock);
+
+        /* Read the chunk after this one from disk while this one is parsed */
+        mapped_file_prefetch(p->file, end, end + DATASET_PARSER_CHUNK_SIZE);
+
+        /* Parse the chunk */
+        int         retval  = DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE;
+        size_t      ntokens = 0;
+        void *const chunk   = p->create_chunk(p->user_data, begin);
+        if (chunk) {
+            dataset_parser_t parser = {.grammar   = p->grammar,
+                                       .user_data = chunk,
+                                       .ntokens   = 0,
+                                       .phases    = measured_phases};
+            retval = __dataset_parser_parse_chunk(p->file, &parser, begin, end);
+            if (retval == MAPPED_FILE_TOKENIZE_RET_ALLOCATION_FAILURE)
+                retval = DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE;
+            ntokens = parser.ntokens;
+
+            if (!retval && p->finish_chunk)
+                retval = p->finish_chunk(p->user_data, chunk);
+        }
+
+        /* Wait for all previous chunks to be committed */
+        pthread_mutex_lock(&p->lock);
+        while (p->next_commit_index != index)
+            pthread_cond_wait(&p->committed, &p->lock);
+        const int failed = p->retval;
+        pthread_mutex_unlock(&p->lock);
+
+        /* Commit outside the lock, so that other threads can keep choosing chunks */
+        if (!failed && !retval) {
+            const uint64_t commit_begin = measured_phases ? __dataset_parser_now() : 0;
+            retval                      = p->commit_chunk(p->user_data, chunk);
+            if (measured_phases)
+                phases.commit_time += __dataset_parser_now() - commit_begin;
+        }
+        if (!failed && !retval && p->progress && p->progress->callback) {
+            p->committed_tokens += ntokens;
+            retval = p->progress->callback(p->progress->user_data, end, p->committed_tokens);
+        }
+        if (chunk)
+            p->free_chunk(chunk);
+
+        pthread_mutex_lock(&p->lock);
+        if (!p->retval)
+            p->retval = retval;
+        p->next_commit_index++;
+        pthread_cond_broadcast(&p->committed);
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    if (measured_phases) {
+        pthread_mutex_lock(&p->lock);
+        __dataset_parser_phases_add(p->progress->phases, &phases);
+        pthread_mutex_unlock(&p->lock);
+    }
+    return NULL;
+}
+
+int dataset_parser_parse_parallel(const mapped_file_t                 *file,
+                                  const dataset_parser_grammar_t      *grammar,
+                                  dataset_parser_chunk_create_callback create_chunk,
+                                  dataset_parser_chunk_finish_callback finish_chunk,
+                                  dataset_parser_chunk_commit_callback commit_chunk,
+                                  dataset_parser_chunk_free_callback   free_chunk,
+                                  void                                *user_data,
+                                  const dataset_parser_progress_t     *progress) {
+
+    dataset_parser_parallel_t p = {.file              = file,
+                                   .grammar           = grammar,
+                                   .create_chunk      = create_chunk,
+                                   .finish_chunk      = finish_chunk,
+                                   .commit_chunk      = commit_chunk,
+                                   .free_chunk        = free_chunk,
+                                   .user_data         = user_data,
+                                   .progress          = progress,
+                                   .committed_tokens  = 0,
+                                   .next_chunk_begin  = 0,
+                                   .next_chunk_index  = 0,
+                                   .next_commit_index = 0,
+                                   .retval            = 0};
+
+    if (pthread_mutex_init(&p.lock, NULL))
         return DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE;
+    if (pthread_cond_init(&p.committed, NULL)) {
+        pthread_mutex_destroy(&p.lock);
+        return DATASET_PARSER_PARSE_RET_ALLOCATION_FAILURE;
+    }
+
+    /* Don't start more threads than there are chunks. The calling thread is also a worker. */
+    const size_t nchunks = mapped_file_get_size(file) / DATASET_PARSER_CHUNK_SIZE + 1;
+
+    size_t nthreads = thread_count_get();
+    nthreads        = min(min(nthreads, nchunks), DATASET_PARSER_MAX_THREADS);
+
+    pthread_t threads[DATASET_PARSER_MAX_THREADS];
+    size_t    nstarted = 0;
+    for (; nstarted < nthreads - 1; ++nstarted)
+        if (pthread_create(threads + nstarted, NULL, __dataset_parser_parallel_worker, &p))
+            break; /* Keep going with the threads that were created */
+
+    __dataset_parser_parallel_worker(&p);
+    for (size_t i = 0; i < nstarted; ++i)
+        pthread_join(threads[i], NULL);
 
-    return 0;
+    pthread_cond_destroy(&p.committed);
+    pthread_mutex_destroy(&p.lock);
+    return p.retval;
 }
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  dataset_partitioner.c
+ * @brief Implementation of methods in include/dataset/dataset_partitioner.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref dataset_partitioner_examples).
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dataset/dataset_input.h"
+#include "dataset/dataset_partitioner.h"
+
+/** @brief Name of the file, in the directory of a partitioned dataset, with its fingerprint. */
+#define DATASET_PARTITIONER_FINGERPRINT_FILE_NAME ".fingerprint"
+
+/**
+ * @brief Column of the user identifier in each dataset file (users, flights, passengers and
+ *        reservations, in this order). `-1` for files copied to every shard.
+ */
+const int dataset_partitioner_user_columns[4] = {0, -1, 1, 1};
+
+/** @brief Names of the dataset files, in the same order as ::dataset_partitioner_user_columns. */
+const char *const dataset_partitioner_types[4] = {"users", "flights", "passengers", "reservations"};
+
+size_t dataset_partitioner_get_shard(const char *user_id, size_t length, size_t nshards) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char) user_id[i];
+        hash *= 0x100000001b3;
+    }
+    return hash % nshards;
+}
+
+/**
+ * @brief Finds the shard a line of a dataset file belongs to.
+ *
+ * @param line    Beginning of the line.
+ * @param length  Number of characters in @p line, not including the line terminator.
+ * @param column  Column of the user identifier (see ::dataset_partitioner_user_columns).
+ * @param nshards Number of shards.
+ *
+ * @return The index of the shard that owns @p line.
+ */
+size_t __dataset_partitioner_get_line_shard(const char *line,
+                                            size_t      length,
+                                            int         column,
+                                            size_t      nshards) {
+    const char *const end   = line + length;
+    const char       *field = line;
+    for (int i = 0; i < column; ++i) {
+        field = memchr(field, ';', end - field);
+        if (!field)
+            return 0; /* Line too short, reported as an error by the first shard */
+        field++;
+    }
+
+    const char *const field_end = memchr(field, ';', end - field);
+    return dataset_partitioner_get_shard(field, (field_end ? field_end : end) - field, nshards);
+}
+
+/**
+ * @brief Splits a dataset file among all shards.
+ *
+ * @param file    Dataset file to be split. Can be `NULL`, for an empty file.
+ * @param column  Column of the user identifier (see ::dataset_partitioner_user_columns).
+ * @param outputs Files of the same type in every shard.
+ * @param nshards Number of shards.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __dataset_partitioner_split_file(const mapped_file_t *file,
+                                     int                  column,
+                                     FILE *const          outputs[],
+                                     size_t               nshards) {
+    if (!file)
+        return 0;
+
+    const char *const contents = mapped_file_get_contents(file);
+    const char *const end      = contents + mapped_file_get_size(file);
+
+    int         header = 1;
+    const char *line   = contents;
+    while (line < end) {
+        const char  *line_end = memchr(line, '\n', end - line);
+        const size_t length   = (line_end ? line_end : end) - line;
+
+        /* The table header (and flights) is written to every shard */
+        size_t first = 0, last = nshards;
+        if (!header && column >= 0) {
+            first = __dataset_partitioner_get_line_shard(line, length, column, nshards);
+            last  = first + 1;
+        }
+
+        for (size_t i = first; i < last; ++i)
+            if (fwrite(line, 1, length, outputs[i]) != length || fputc('\n', outputs[i]) == EOF)
+                return 1;
+
+        header = 0;
+        line   = line_end ? line_end + 1 : end;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Checks if the shards in a directory were created from the current version of a dataset.
+ *
+ * @param fingerprint_path Path to the file with the fingerprint of the partitioned dataset.
+ * @param fingerprint      Fingerprint of the current version of the dataset.
+ * @param nshards          Number of shards.
+ *
+ * @return Whether the shards are up to date.
+ */
+int __dataset_partitioner_is_up_to_date(const char *fingerprint_path,
+                                        uint64_t    fingerprint,
+                                        size_t      nshards) {
+    FILE *const file = fopen(fingerprint_path, "rb");
+    if (!file)
+        return 0;
+
+    uint64_t  stored[2];
+    const int read = fread(stored, sizeof(stored), 1, file) == 1;
+    fclose(file);
+    return read && stored[0] == fingerprint && stored[1] == nshards;
+}
+
+int dataset_partitioner_partition(const char *dataset_path,
+                                  const char *partition_path,
+                                  size_t      nshards) {
+    int retval = 0;
+
+    char fingerprint_path[PATH_MAX];
+    if (snprintf(fingerprint_path,
+                 PATH_MAX,
+                 "%s/" DATASET_PARTITIONER_FINGERPRINT_FILE_NAME,
+                 partition_path) >= PATH_MAX)
+        return 1; /* Path too long */
+
+    uint64_t fingerprint;
+    if (dataset_input_get_fingerprint(dataset_path, &fingerprint))
+        return 1;
+    if (__dataset_partitioner_is_up_to_date(fingerprint_path, fingerprint, nshards))
+        return 0;
+
+    /* Shards being rewritten must not be considered up to date if partitioning fails */
+    if (unlink(fingerprint_path) && errno != ENOENT)
+        return 1;
+    if (mkdir(partition_path, 0755) && errno != EEXIST)
+        return 1;
+
+    dataset_input_t *const input = dataset_input_create(dataset_path);
+    if (!input)
+        return 1;
+
+    const mapped_file_t *files[4];
+    dataset_input_get_files(input, &files[0], &files[1], &files[2], &files[3]);
+
+    FILE **const outputs = calloc(nshards, sizeof(FILE *));
+    if (!outputs) {
+        retval = 1;
+        goto DEFER_1;
+    }
+
+    for (size_t i = 0; i < nshards; ++i) {
+        char shard_path[PATH_MAX];
+        if (snprintf(shard_path,
+                     PATH_MAX,
+                     DATASET_PARTITIONER_SHARD_PATH_FORMAT,
+                     partition_path,
+                     i) >= PATH_MAX) {
+            retval = 1; /* Path too long */
+            goto DEFER_2;
+        }
+
+        if (mkdir(shard_path, 0755) && errno != EEXIST) {
+            retval = 1;
+            goto DEFER_2;
+        }
+    }
+
+    for (size_t i = 0; i < 4 && !retval; ++i) {
+        for (size_t j = 0; j < nshards; ++j) {
+            char file_path[PATH_MAX];
+            if (snprintf(file_path,
+                         PATH_MAX,
+                         DATASET_PARTITIONER_SHARD_PATH_FORMAT "/%s.csv",
+                         partition_path,
+                         j,
+                         dataset_partitioner_types[i]) >= PATH_MAX) {
+                retval = 1; /* Path too long */
+                continue;
+            }
+
+            outputs[j] = fopen(file_path, "w");
+            if (!outputs[j])
+                retval = 1;
+        }
+
+        if (!retval)
+            retval = __dataset_partitioner_split_file(files[i],
+                                                      dataset_partitioner_user_columns[i],
+                                                      outputs,
+                                                      nshards);
+
+        for (size_t j = 0; j < nshards; ++j) {
+            if (outputs[j] && fclose(outputs[j]))
+                retval = 1;
+            outputs[j] = NULL;
+        }
+    }
+
+    if (!retval) {
+        FILE *const    file      = fopen(fingerprint_path, "wb");
+        const uint64_t stored[2] = {fingerprint, nshards};
+        retval                   = !file || fwrite(stored, sizeof(stored), 1, file) != 1;
+        if (file && fclose(file))
+            retval = 1;
+    }
+
+DEFER_2:
+    free(outputs);
+DEFER_1:
+    dataset_input_free(input);
+    return retval;
+}
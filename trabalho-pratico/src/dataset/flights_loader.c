@@ -23,6 +23,7 @@
  *          `loader_data` is a pointer to a ::flights_loader_t.
  */
 
+#include <stdio.h>
 #include <string.h>
 
 #include "dataset/dataset_parser.h"
@@ -45,6 +46,8 @@
  *     @brief Database to add new flights to.
  * @var flights_loader_t::error_line
  *     @brief Current line being processed, in case it needs to be put in the error file.
+ * @var flights_loader_t::strings
+ *     @brief Dictionary of the airlines and plane models of parsed flights.
  * @var flights_loader_t::current_flight
  *     @brief Flight being currently parsed, whose fields are still being filled in.
  * @var flights_loader_t::first_line
@@ -55,9 +58,10 @@ typedef struct {
     dataset_error_output_t *const output;
     database_t *const             database;
 
-    const char     *error_line;
-    flight_t *const current_flight;
-    int             first_line;
+    const char                *error_line;
+    string_dictionary_t *const strings;
+    flight_t *const            current_flight;
+    int                        first_line;
 } flights_loader_t;
 
 /**
@@ -66,10 +70,12 @@ typedef struct {
  *
  * @param loader_data A pointer to a ::flights_loader_t.
  * @param line        Line that is going to be parsed.
+ * @param offset      Offset of @p line in the file. Not used.
  *
  * @retval 0 Always successful.
  */
-int __flights_loader_before_parse_line(void *loader_data, char *line) {
+int __flights_loader_before_parse_line(void *loader_data, char *line, size_t offset) {
+    (void) offset;
     ((flights_loader_t *) loader_data)->error_line = line;
     return 0;
 }
@@ -93,15 +99,13 @@ int __flight_loader_parse_id(void *loader_data, char *token, size_t ntoken) {
 
 /** @brief Parses a flight's airline and plane model (simple strings). */
 int __flight_loader_parse_string(void *loader_data, char *token, size_t ntoken) {
+    flights_loader_t *const loader = loader_data;
+
     switch (ntoken) {
         case 1:
-            return flight_set_airline(NULL,
-                                      ((flights_loader_t *) loader_data)->current_flight,
-                                      token);
+            return flight_set_airline(loader->strings, loader->current_flight, token);
         case 2:
-            return flight_set_plane_model(NULL,
-                                          ((flights_loader_t *) loader_data)->current_flight,
-                                          token);
+            return flight_set_plane_model(loader->strings, loader->current_flight, token);
         default:
             __builtin_unreachable();
     }
@@ -170,9 +174,8 @@ int __flight_loader_parse_real_departure_date(void *loader_data, char *token, si
     if (retval)
         return retval;
 
-    flight_set_real_departure_date(((flights_loader_t *) loader_data)->current_flight,
-                                   date_and_time);
-    return 0;
+    return flight_set_real_departure_date(((flights_loader_t *) loader_data)->current_flight,
+                                          date_and_time);
 }
 
 /** @brief Parses a flight's real arrival date. */
@@ -190,21 +193,6 @@ int __flight_loader_parse_real_arrival_date(void *loader_data, char *token, size
     return date_and_time_diff(date_and_time, departure_date) < 0;
 }
 
-/** @brief Parses a flight's pilot and copilot name. */
-int __flight_loader_parse_pilot_copilot(void *loader_data, char *token, size_t ntoken) {
-    (void) ntoken;
-    (void) loader_data;
-    return (*token == 0); /* Fail on empty pilot / copilot name */
-}
-
-/** @brief Parses a flight's notes. */
-int __flight_loader_parse_notes(void *loader_data, char *token, size_t ntoken) {
-    (void) ntoken;
-    (void) loader_data;
-    (void) token;
-    return 0;
-}
-
 /**
  * @brief Places a parsed flight in the database and handles parsing errors.
  *
@@ -223,20 +211,29 @@ int __flights_loader_after_parse_line(void *loader_data, int retval) {
         dataset_error_output_report_flight_error(loader->output, loader->error_line);
         retval = 0;
     } else {
-        retval = database_add_flight(loader->database, loader->current_flight);
+        retval = database_add_flight(loader->database, loader->strings, loader->current_flight);
     }
 
     flight_reset_schedule_dates(loader->current_flight);
     return retval;
 }
 
-int flights_loader_load(FILE *stream, database_t *database, dataset_error_output_t *output) {
-    flights_loader_t data = {.output         = output,
-                             .database       = database,
-                             .current_flight = flight_create(NULL),
-                             .first_line     = 1};
-    if (!data.current_flight)
-        return 1;
+/** @brief Number of characters in each block of ::flights_loader_t::strings. */
+#define FLIGHTS_LOADER_STRINGS_POOL_BLOCK_CAPACITY 4096
+
+int flights_loader_load(const mapped_file_t             *file,
+                        database_t                      *database,
+                        dataset_error_output_t          *output,
+                        const dataset_parser_progress_t *progress) {
+    int              retval = 1;
+    flights_loader_t data   = {.output         = output,
+                               .database       = database,
+                               .strings        = string_dictionary_create(
+                                   FLIGHTS_LOADER_STRINGS_POOL_BLOCK_CAPACITY),
+                               .current_flight = flight_create(NULL),
+                               .first_line     = 1};
+    if (!data.strings || !data.current_flight)
+        goto DEFER_1;
     flight_set_number_of_passengers(data.current_flight, 0);
 
     const fixed_n_delimiter_parser_iter_callback_t token_callbacks[13] = {
@@ -250,34 +247,33 @@ int flights_loader_load(FILE *stream, database_t *database, dataset_error_output
         __flight_loader_parser_schedule_dates,
         __flight_loader_parse_real_departure_date,
         __flight_loader_parse_real_arrival_date,
-        __flight_loader_parse_pilot_copilot,
-        __flight_loader_parse_pilot_copilot,
-        __flight_loader_parse_notes,
+        fixed_n_delimiter_parser_check_non_empty, /* Pilot */
+        fixed_n_delimiter_parser_check_non_empty, /* Copilot */
+        fixed_n_delimiter_parser_skip,            /* Notes */
     };
 
     fixed_n_delimiter_parser_grammar_t *const line_grammar =
         fixed_n_delimiter_parser_grammar_new(';', 13, token_callbacks);
-    if (!line_grammar) {
-        flight_free(data.current_flight);
-        return 1;
-    }
+    if (!line_grammar)
+        goto DEFER_1;
 
     dataset_parser_grammar_t *const grammar =
         dataset_parser_grammar_new('\n',
                                    line_grammar,
                                    __flights_loader_before_parse_line,
                                    __flights_loader_after_parse_line);
-    if (!grammar) {
-        flight_free(data.current_flight);
-        fixed_n_delimiter_parser_grammar_free(line_grammar);
-        return 1;
-    }
+    if (!grammar)
+        goto DEFER_2;
 
-    const int retval = dataset_parser_parse(stream, grammar, &data);
+    retval = dataset_parser_parse(file, grammar, &data, progress) != 0;
 
     dataset_parser_grammar_free(grammar);
+DEFER_2:
     fixed_n_delimiter_parser_grammar_free(line_grammar);
-    flight_free(data.current_flight);
-
-    return retval != 0;
+DEFER_1:
+    if (data.current_flight)
+        flight_free(data.current_flight);
+    if (data.strings)
+        string_dictionary_free(data.strings);
+    return retval;
 }
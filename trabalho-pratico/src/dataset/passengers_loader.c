@@ -20,15 +20,22 @@
  */
 
 #include <glib.h>
-#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "dataset/dataset_parser.h"
 #include "dataset/passengers_loader.h"
-#include "utils/stream_utils.h"
 #include "utils/string_pool.h"
 
-/** @brief Block capacity of ::passengers_loader_t::commit_buffer_id_pool. */
-#define PASSENGERS_LOADER_ID_POOL_BLOCK_CAPACITY 8192
+/** @brief Block capacity of ::passengers_loader_chunk_t::strings. */
+#define PASSENGERS_LOADER_CHUNK_STRING_POOL_BLOCK_CAPACITY 65536
+
+/**
+ * @brief Minimum number of passengers in ::passengers_loader_t::commit_buffer before they're added
+ *        to the database.
+ */
+#define PASSENGERS_LOADER_BATCH_SIZE 4096
 
 /**
  * @struct passengers_loader_t
@@ -36,67 +43,147 @@
  *
  * @var passengers_loader_t::output
  *     @brief Where to output dataset errors to.
+ * @var passengers_loader_t::contents
+ *     @brief Contents of the `passengers.csv` file, to copy lines of unknown users from.
  * @var passengers_loader_t::database
  *     @brief Database to add user-flight relations (passengers) to.
- * @var passengers_loader_t::users
- *     @brief User manager to check for user existence.
- * @var passengers_loader_t::flights
- *     @brief Flight manager to check for flight existence.
  * @var passengers_loader_t::commit_buffer
- *     @brief All passengers (user ID strings) in the flight being currently parsed.
- * @var passengers_loader_t::commit_buffer_flight
- *     @brief Flight that ::passengers_loader_t::commit_buffer refers to.
- * @var passengers_loader_t::commit_buffer_id_pool
- *     @brief Pool where IDs in ::passengers_loader_t::commit_buffer are stored.
- * @var passengers_loader_t::current_user
- *     @brief User ID in the line currently being parsed.
- * @var passengers_loader_t::current_flight
- *     @brief Flight ID in the line currently being parsed.
+ *     @brief All passengers (::user_ordinal_t) of the flights in
+ *            ::passengers_loader_t::commit_flights.
+ * @var passengers_loader_t::commit_flights
+ *     @brief Flights (::database_flight_passengers_t) whose passengers are yet to be added to the
+ *            database. The last one may still be getting passengers.
  * @var passengers_loader_t::invalid_flight_ids
  *     @brief   List of invalid flight IDs to be printed to the errors file.
  *     @details That is done only after fully loading the `passengers.csv` file.
- * @var passengers_loader_t::error_line
- *     @brief Current line being processed, in case it needs to be put in the error file.
- * @var passengers_loader_t::first_line
- *     @brief   Whether the line being parsed is the first line in the file.
- *     @details Used to print an error on the CSV's table header.
  */
 typedef struct {
     dataset_error_output_t *const output;
+    const char *const             contents;
     database_t *const             database;
-    const user_manager_t *const   users;
-    const flight_manager_t *const flights;
-
-    GPtrArray *const commit_buffer;
-    flight_id_t      commit_buffer_flight;
-    string_pool_t   *commit_buffer_id_pool;
-
-    const char *current_user;
-    flight_id_t current_flight;
 
+    GArray *const commit_buffer;
+    GArray *const commit_flights;
     GArray *const invalid_flight_ids;
-    const char   *error_line;
-    int           first_line;
 } passengers_loader_t;
 
+/**
+ * @struct passengers_loader_staged_t
+ * @brief  A line of `passengers.csv` parsed in a chunk, waiting to be committed.
+ *
+ * @var passengers_loader_staged_t::error_line
+ *     @brief Copy of the line, if it's invalid, to be printed to the errors file. `NULL` for valid
+ *            lines.
+ * @var passengers_loader_staged_t::flight
+ *     @brief Flight in a valid line.
+ * @var passengers_loader_staged_t::user
+ *     @brief Ordinal of the user in a valid line.
+ */
+typedef struct {
+    const char    *error_line;
+    flight_id_t    flight;
+    user_ordinal_t user;
+} passengers_loader_staged_t;
+
+/**
+ * @struct passengers_loader_lookup_t
+ * @brief  A line of `passengers.csv` parsed in a chunk, whose user is yet to be looked up.
+ *
+ * @var passengers_loader_lookup_t::staged
+ *     @brief Index of the line in ::passengers_loader_chunk_t::staged.
+ * @var passengers_loader_lookup_t::offset
+ *     @brief Offset of the line in the file, to copy it from if its user doesn't exist.
+ * @var passengers_loader_lookup_t::length
+ *     @brief Length of the line, not including its delimiter.
+ */
+typedef struct {
+    size_t staged;
+    size_t offset, length;
+} passengers_loader_lookup_t;
+
+/**
+ * @struct  passengers_loader_chunk_t
+ * @brief   Temporary data needed to load a chunk of a file of passengers.
+ * @details Lines are validated (including whether their users and flights exist, as neither
+ *          manager is modified while passengers are loaded) in parallel, and staged here to be
+ *          committed to the database in file order. Users are looked up all at once, after the
+ *          whole chunk is parsed (see ::user_manager_get_ordinals).
+ *
+ * @var passengers_loader_chunk_t::contents
+ *     @brief Contents of the file being parsed.
+ * @var passengers_loader_chunk_t::users
+ *     @brief User manager to check for user existence.
+ * @var passengers_loader_chunk_t::flights
+ *     @brief Flight manager to check for flight existence.
+ * @var passengers_loader_chunk_t::strings
+ *     @brief Pool where error lines are stored.
+ * @var passengers_loader_chunk_t::staged
+ *     @brief Lines (::passengers_loader_staged_t) parsed in this chunk, in file order.
+ * @var passengers_loader_chunk_t::user_ids
+ *     @brief Identifiers of the users to be looked up, stored in
+ *            ::passengers_loader_chunk_t::strings.
+ * @var passengers_loader_chunk_t::lookups
+ *     @brief Lines (::passengers_loader_lookup_t) of each user in
+ *            ::passengers_loader_chunk_t::user_ids.
+ * @var passengers_loader_chunk_t::current_user_id
+ *     @brief Identifier of the user in the line currently being parsed.
+ * @var passengers_loader_chunk_t::current_flight
+ *     @brief Flight ID in the line currently being parsed.
+ * @var passengers_loader_chunk_t::found_flight
+ *     @brief   Last flight that was found in ::passengers_loader_chunk_t::flights.
+ *     @details As passengers are sorted by flight, most lines don't need any flight lookup.
+ * @var passengers_loader_chunk_t::has_found_flight
+ *     @brief Whether ::passengers_loader_chunk_t::found_flight is valid.
+ * @var passengers_loader_chunk_t::error_line
+ *     @brief Current line being processed, in case it needs to be put in the error file.
+ * @var passengers_loader_chunk_t::line_offset
+ *     @brief Offset of ::passengers_loader_chunk_t::error_line in the file.
+ * @var passengers_loader_chunk_t::line_length
+ *     @brief Length of ::passengers_loader_chunk_t::error_line, not including its delimiter.
+ * @var passengers_loader_chunk_t::first_line
+ *     @brief   Whether the line being parsed is the first line in the file.
+ *     @details Used to print an error on the CSV's table header.
+ */
+typedef struct {
+    const char             *contents;
+    const user_manager_t   *users;
+    const flight_manager_t *flights;
+    string_pool_t          *strings;
+    GArray                 *staged;
+    GPtrArray              *user_ids;
+    GArray                 *lookups;
+
+    const char *current_user_id;
+    flight_id_t current_flight, found_flight;
+    int         has_found_flight;
+    const char *error_line;
+    size_t      line_offset, line_length;
+    int         first_line;
+} passengers_loader_chunk_t;
+
 /**
  * @brief Stores the beginning of the current line, in case it needs to be printed to the errors
  *        file.
  *
- * @param loader_data A pointer to a ::flights_loader_t.
+ * @param loader_data A pointer to a ::passengers_loader_chunk_t.
  * @param line        Line that is going to be parsed.
+ * @param offset      Offset of @p line in the file.
  *
  * @retval 0 Always successful.
  */
-int __passengers_loader_before_parse_line(void *loader_data, char *line) {
-    ((passengers_loader_t *) loader_data)->error_line = line;
+int __passengers_loader_before_parse_line(void *loader_data, char *line, size_t offset) {
+    passengers_loader_chunk_t *const chunk = loader_data;
+
+    chunk->error_line  = line;
+    chunk->line_offset = offset;
+    chunk->line_length = strlen(line);
     return 0;
 }
 
 /**
  * @brief Parses a flight's identifier in a user-flight relation (passenger).
  *
- * @param loader_data A pointer to a ::passengers_loader_t.
+ * @param loader_data A pointer to a ::passengers_loader_chunk_t.
  * @param token       Identifier of the flight as a string.
  * @param ntoken      Number of the current token in the line. Not used.
  *
@@ -105,14 +192,21 @@ int __passengers_loader_before_parse_line(void *loader_data, char *line) {
  */
 int __passengers_loader_parse_flight_id(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    passengers_loader_t *const loader = loader_data;
+    passengers_loader_chunk_t *const chunk = loader_data;
 
     flight_id_t id;
     const int   retval = flight_id_from_string(&id, token);
     if (retval == 0) {
-        loader->current_flight = id;
-        return flight_manager_get_by_id(loader->flights, id) == NULL;
-    } else if (retval == 2 && !(loader->first_line && strcmp(token, "flight_id") == 0)) {
+        chunk->current_flight = id;
+        if (chunk->has_found_flight && chunk->found_flight == id)
+            return 0;
+
+        if (!flight_manager_get_by_id(chunk->flights, id))
+            return 1;
+        chunk->found_flight     = id;
+        chunk->has_found_flight = 1;
+        return 0;
+    } else if (retval == 2 && !(chunk->first_line && strcmp(token, "flight_id") == 0)) {
         fprintf(stderr,
                 "Flight ID \"%s\" is not numerical. This isn't supported by our program!\n",
                 token);
@@ -121,83 +215,263 @@ int __passengers_loader_parse_flight_id(void *loader_data, char *token, size_t n
 }
 
 /**
- * @brief Parses a user's identifier in a user-flight relation (passenger).
+ * @brief   Parses a user's identifier in a user-flight relation (passenger).
+ * @details The user is only looked up in ::__passengers_loader_finish_chunk.
  *
- * @param loader_data A pointer to a ::passengers_loader_t.
+ * @param loader_data A pointer to a ::passengers_loader_chunk_t.
  * @param token       Identifier of the user.
  * @param ntoken      Number of the current token in the line. Not used.
  *
- * @retval 0 Parsing success.
- * @retval 1 User doesn't exist.
+ * @retval 0 Always successful.
  */
 int __passengers_loader_parse_user_id(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    passengers_loader_t *const loader = loader_data;
+    ((passengers_loader_chunk_t *) loader_data)->current_user_id = token;
+    return 0;
+}
+
+/**
+ * @brief Stages a parsed passenger or an error line, to be committed later.
+ *
+ * @param loader_data A pointer to a ::passengers_loader_chunk_t.
+ * @param retval      Value returned by the last token callback (`0` for success, another value for
+ *                    a parsing error).
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __passengers_loader_after_parse_line(void *loader_data, int retval) {
+    passengers_loader_chunk_t *const chunk = loader_data;
+    chunk->first_line                      = 0;
+
+    passengers_loader_staged_t staged = {.error_line = NULL,
+                                         .flight     = chunk->current_flight,
+                                         .user       = 0};
+    if (retval) {
+        staged.error_line = string_pool_put(chunk->strings, chunk->error_line);
+        if (!staged.error_line)
+            return 1;
+    } else {
+        char *const user_id = string_pool_put(chunk->strings, chunk->current_user_id);
+        if (!user_id)
+            return 1;
+
+        const passengers_loader_lookup_t lookup = {
+            .staged = chunk->staged->len,
+            .offset = chunk->line_offset,
+            .length = chunk->line_length};
+        g_ptr_array_add(chunk->user_ids, user_id);
+        g_array_append_val(chunk->lookups, lookup);
+    }
+
+    g_array_append_val(chunk->staged, staged);
+    return 0;
+}
 
-    /* Fail if the user isn't found (invalid user won't be found too). */
-    loader->current_user = token;
-    return user_manager_get_by_id(loader->users, token) == NULL;
+/**
+ * @brief   Looks up the users of all lines parsed in a chunk, at once.
+ * @details Lines whose users don't exist (invalid users won't be found too) are turned into error
+ *          lines.
+ *
+ * @param loader_data A pointer to a ::passengers_loader_t.
+ * @param chunk_data  A pointer to a ::passengers_loader_chunk_t.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __passengers_loader_finish_chunk(void *loader_data, void *chunk_data) {
+    (void) loader_data;
+    passengers_loader_chunk_t *const chunk = chunk_data;
+
+    const size_t n = chunk->user_ids->len;
+    if (!n)
+        return 0;
+
+    int                   retval   = 1;
+    user_ordinal_t *const ordinals = malloc(n * sizeof(user_ordinal_t));
+    if (!ordinals)
+        return 1;
+    uint8_t *const found = malloc(n);
+    if (!found)
+        goto DEFER_1;
+
+    if (user_manager_get_ordinals(chunk->users,
+                                  n,
+                                  (const char *const *) chunk->user_ids->pdata,
+                                  ordinals,
+                                  found))
+        goto DEFER_2;
+
+    for (size_t i = 0; i < n; ++i) {
+        const passengers_loader_lookup_t *const lookup =
+            &g_array_index(chunk->lookups, passengers_loader_lookup_t, i);
+        passengers_loader_staged_t *const staged =
+            &g_array_index(chunk->staged, passengers_loader_staged_t, lookup->staged);
+
+        if (found[i]) {
+            staged->user = ordinals[i];
+        } else {
+            char *const line = string_pool_allocate(chunk->strings, lookup->length);
+            if (!line)
+                goto DEFER_2;
+
+            memcpy(line, chunk->contents + lookup->offset, lookup->length);
+            line[lookup->length] = '\0';
+            staged->error_line   = line;
+        }
+    }
+
+    retval = 0;
+DEFER_2:
+    free(found);
+DEFER_1:
+    free(ordinals);
+    return retval;
+}
+
+/**
+ * @brief Frees a chunk created by ::__passengers_loader_create_chunk.
+ * @param chunk_data A pointer to a ::passengers_loader_chunk_t.
+ */
+void __passengers_loader_free_chunk(void *chunk_data) {
+    passengers_loader_chunk_t *const chunk = chunk_data;
+
+    g_array_unref(chunk->lookups);
+    g_ptr_array_unref(chunk->user_ids);
+    g_array_unref(chunk->staged);
+    string_pool_free(chunk->strings);
+    free(chunk);
 }
 
 /**
- * @brief Adds all passengers in the commit buffer to the database.
- * @param loader Current state of the loader of the passengers file.
+ * @brief Creates the data needed to parse a chunk of a file of passengers.
+ *
+ * @param loader_data A pointer to a ::passengers_loader_t.
+ * @param offset      Offset of the chunk in the file.
+ *
+ * @return A pointer to a ::passengers_loader_chunk_t, or `NULL` on allocation failure.
  */
-void __passengers_loader_commit_flight_list(passengers_loader_t *loader) {
-    if (loader->commit_buffer->len == 0)
+void *__passengers_loader_create_chunk(void *loader_data, size_t offset) {
+    const passengers_loader_t *const loader = loader_data;
+
+    passengers_loader_chunk_t *const chunk = malloc(sizeof(passengers_loader_chunk_t));
+    if (!chunk)
+        return NULL;
+
+    chunk->strings = string_pool_create(PASSENGERS_LOADER_CHUNK_STRING_POOL_BLOCK_CAPACITY);
+    if (!chunk->strings) {
+        free(chunk);
+        return NULL;
+    }
+
+    chunk->contents         = loader->contents;
+    chunk->users            = database_get_users(loader->database);
+    chunk->flights          = database_get_flights(loader->database);
+    chunk->staged           = g_array_new(FALSE, FALSE, sizeof(passengers_loader_staged_t));
+    chunk->user_ids         = g_ptr_array_new();
+    chunk->lookups          = g_array_new(FALSE, FALSE, sizeof(passengers_loader_lookup_t));
+    chunk->current_user_id  = NULL;
+    chunk->has_found_flight = 0;
+    chunk->error_line       = NULL;
+    chunk->line_offset      = offset;
+    chunk->line_length      = 0;
+    chunk->first_line       = offset == 0;
+    return chunk;
+}
+
+/**
+ * @brief Adds the passengers of flights in the commit buffer to the database.
+ *
+ * @param loader    Current state of the loader of the passengers file.
+ * @param keep_last Whether to keep the last flight in the commit buffer, because more of its
+ *                  passengers may follow.
+ */
+void __passengers_loader_commit_flight_list(passengers_loader_t *loader, int keep_last) {
+    size_t nflights = loader->commit_flights->len;
+    if (keep_last && nflights)
+        nflights--;
+    if (nflights == 0)
         return;
 
-    if (database_add_passengers(loader->database,
-                                loader->commit_buffer_flight,
-                                loader->commit_buffer->len,
-                                (const char *const *) loader->commit_buffer->pdata)) {
-
-        /* Print passengers as invalid (ignore allocation failures) */
-        char full_print_buffer[LINE_MAX];
-        flight_id_sprintf(full_print_buffer, loader->commit_buffer_flight);
-        /* Flight IDs are 10 characters long */
-        full_print_buffer[10]    = ';';
-        char *const print_buffer = full_print_buffer + 11;
-
-        for (size_t i = 0; i < loader->commit_buffer->len; ++i) {
-            strcpy(print_buffer, g_ptr_array_index(loader->commit_buffer, i));
-            dataset_error_output_report_passenger_error(loader->output, full_print_buffer);
+    database_flight_passengers_t *const flights =
+        (database_flight_passengers_t *) loader->commit_flights->data;
+    const user_ordinal_t *passengers = (const user_ordinal_t *) loader->commit_buffer->data;
+
+    const int failed =
+        database_add_passengers_batch(loader->database, nflights, flights, passengers);
+
+    const user_manager_t *const users = database_get_users(loader->database);
+    for (size_t i = 0; i < nflights; ++i) {
+        if (failed && flights[i].failed) {
+            /* Print passengers as invalid (ignore allocation failures) */
+            char flight_id[FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE];
+            flight_id_sprintf(flight_id, flights[i].flight_id);
+
+            for (size_t j = 0; j < flights[i].npassengers; ++j) {
+                const user_t *const user = user_manager_get_by_ordinal(users, passengers[j]);
+                dataset_error_output_report_passenger_ids_error(loader->output,
+                                                                flight_id,
+                                                                user_get_const_id(user));
+            }
+
+            g_array_append_val(loader->invalid_flight_ids, flights[i].flight_id);
         }
 
-        g_array_append_val(loader->invalid_flight_ids, loader->commit_buffer_flight);
+        passengers += flights[i].npassengers;
     }
 
-    string_pool_empty(loader->commit_buffer_id_pool);
-    g_ptr_array_set_size(loader->commit_buffer, 0);
+    g_array_remove_range(loader->commit_buffer,
+                         0,
+                         passengers - (const user_ordinal_t *) loader->commit_buffer->data);
+    g_array_remove_range(loader->commit_flights, 0, nflights);
 }
 
 /**
- * @brief Places a parsed passenger in the database and handles errors.
+ * @brief   Places the passengers parsed in a chunk in the database and reports errors, in file
+ *          order.
+ * @details Passengers are grouped by flight, regardless of chunk boundaries, and added to the
+ *          database in batches. Flights are reported as invalid when the first passenger of the
+ *          next flight is found, so, to keep the errors file in the same order as if passengers
+ *          were loaded one flight at a time, complete flights are committed before printing any
+ *          error line.
  *
  * @param loader_data A pointer to a ::passengers_loader_t.
- * @param retval      Value returned by the last token callback (`0` for success, another value for
- *                    a parsing error).
+ * @param chunk_data  A pointer to a ::passengers_loader_chunk_t.
  *
- * @retval 0 Always successful. A possible type of allocation error is ignored.
+ * @retval 0 Always successful.
  */
-int __passengers_loader_after_parse_line(void *loader_data, int retval) {
-    passengers_loader_t *const loader = loader_data;
-    loader->first_line                = 0;
+int __passengers_loader_commit_chunk(void *loader_data, void *chunk_data) {
+    passengers_loader_t *const             loader  = loader_data;
+    const passengers_loader_chunk_t *const chunk   = chunk_data;
+    GArray *const                          flights = loader->commit_flights;
+
+    for (size_t i = 0; i < chunk->staged->len; ++i) {
+        const passengers_loader_staged_t *const staged =
+            &g_array_index(chunk->staged, passengers_loader_staged_t, i);
+
+        if (staged->error_line) {
+            __passengers_loader_commit_flight_list(loader, 1);
+            dataset_error_output_report_passenger_error(loader->output, staged->error_line);
+            continue;
+        }
 
-    if (retval) {
-        dataset_error_output_report_passenger_error(loader->output, loader->error_line);
-        return 0;
-    }
+        if (!flights->len ||
+            g_array_index(flights, database_flight_passengers_t, flights->len - 1).flight_id !=
+                staged->flight) {
 
-    /* Flush passengers if this a new flight */
-    if (loader->current_flight != loader->commit_buffer_flight)
-        __passengers_loader_commit_flight_list(loader);
+            /* Flush passengers on flight boundaries, as all of a flight's must be added at once */
+            if (loader->commit_buffer->len >= PASSENGERS_LOADER_BATCH_SIZE)
+                __passengers_loader_commit_flight_list(loader, 0);
 
-    /* Add flight */
-    char *const pool_alloc_id =
-        string_pool_put(loader->commit_buffer_id_pool, loader->current_user);
-    g_ptr_array_add(loader->commit_buffer, pool_alloc_id);
-    loader->commit_buffer_flight = loader->current_flight;
+            const database_flight_passengers_t flight = {.flight_id   = staged->flight,
+                                                         .npassengers = 0,
+                                                         .failed      = 0};
+            g_array_append_val(flights, flight);
+        }
+
+        g_array_index(flights, database_flight_passengers_t, flights->len - 1).npassengers++;
+        g_array_append_val(loader->commit_buffer, staged->user);
+    }
 
     return 0;
 }
@@ -241,10 +515,12 @@ int __passengers_loader_check_line_for_erroneous_flight(void *user_data, char *l
  * @brief Reports errors for all flights with more passengers than seats.
  *
  * @param loader  Data about parsing results.
- * @param flights File stream of `flights.csv`, to print error lines exactly like they were in the
- *                original dataset file.
+ * @param flights File `flights.csv`, to print error lines exactly like they were in the original
+ *                dataset file.
  */
-void __passengers_loader_report_erroneous_flights(passengers_loader_t *loader, FILE *flights) {
+void __passengers_loader_report_erroneous_flights(passengers_loader_t *loader,
+                                                  const mapped_file_t *flights) {
+    size_t offset = 0; /* Both files are sorted, so there's no need to restart each lookup */
     for (size_t i = 0; i < loader->invalid_flight_ids->len; ++i) {
         const flight_id_t id = g_array_index(loader->invalid_flight_ids, flight_id_t, i);
         char              id_str[FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE];
@@ -253,31 +529,28 @@ void __passengers_loader_report_erroneous_flights(passengers_loader_t *loader, F
         passengers_loader_erroneous_flight_callback_data_t user_data = {.output    = loader->output,
                                                                         .flight_id = id_str};
 
-        stream_tokenize(flights,
-                        '\n',
-                        __passengers_loader_check_line_for_erroneous_flight,
-                        &user_data);
+        mapped_file_tokenize(flights,
+                             &offset,
+                             '\n',
+                             __passengers_loader_check_line_for_erroneous_flight,
+                             &user_data);
     }
 }
 
-int passengers_loader_load(FILE                   *passengers_stream,
-                           FILE                   *flights_stream,
-                           database_t             *database,
-                           dataset_error_output_t *output) {
-
-    passengers_loader_t data   = {.output        = output,
-                                  .database      = database,
-                                  .users         = database_get_users(database),
-                                  .flights       = database_get_flights(database),
-                                  .commit_buffer = g_ptr_array_new(),
-                                  .invalid_flight_ids =
-                                      g_array_new(FALSE, FALSE, sizeof(flight_id_t)),
-                                  .first_line = 1};
-    int                 retval = 1;
-
-    data.commit_buffer_id_pool = string_pool_create(PASSENGERS_LOADER_ID_POOL_BLOCK_CAPACITY);
-    if (!data.commit_buffer_id_pool)
-        goto DEFER_1;
+int passengers_loader_load(const mapped_file_t             *passengers_file,
+                           const mapped_file_t             *flights_file,
+                           database_t                      *database,
+                           dataset_error_output_t          *output,
+                           const dataset_parser_progress_t *progress) {
+
+    passengers_loader_t data = {
+        .output             = output,
+        .contents           = mapped_file_get_contents(passengers_file),
+        .database           = database,
+        .commit_buffer      = g_array_new(FALSE, FALSE, sizeof(user_ordinal_t)),
+        .commit_flights     = g_array_new(FALSE, FALSE, sizeof(database_flight_passengers_t)),
+        .invalid_flight_ids = g_array_new(FALSE, FALSE, sizeof(flight_id_t))};
+    int retval = 1;
 
     const fixed_n_delimiter_parser_iter_callback_t token_callbacks[2] = {
         __passengers_loader_parse_flight_id,
@@ -286,7 +559,7 @@ int passengers_loader_load(FILE                   *passengers_stream,
     fixed_n_delimiter_parser_grammar_t *const line_grammar =
         fixed_n_delimiter_parser_grammar_new(';', 2, token_callbacks);
     if (!line_grammar)
-        goto DEFER_2;
+        goto DEFER_1;
 
     dataset_parser_grammar_t *const grammar =
         dataset_parser_grammar_new('\n',
@@ -294,20 +567,26 @@ int passengers_loader_load(FILE                   *passengers_stream,
                                    __passengers_loader_before_parse_line,
                                    __passengers_loader_after_parse_line);
     if (!grammar)
-        goto DEFER_3;
+        goto DEFER_2;
 
-    retval = dataset_parser_parse(passengers_stream, grammar, &data);
-    __passengers_loader_commit_flight_list(&data);
-    __passengers_loader_report_erroneous_flights(&data, flights_stream);
+    retval = dataset_parser_parse_parallel(passengers_file,
+                                           grammar,
+                                           __passengers_loader_create_chunk,
+                                           __passengers_loader_finish_chunk,
+                                           __passengers_loader_commit_chunk,
+                                           __passengers_loader_free_chunk,
+                                           &data,
+                                           progress);
+    __passengers_loader_commit_flight_list(&data, 0);
+    __passengers_loader_report_erroneous_flights(&data, flights_file);
 
     dataset_parser_grammar_free(grammar);
-DEFER_3:
-    fixed_n_delimiter_parser_grammar_free(line_grammar);
 DEFER_2:
-    string_pool_free(data.commit_buffer_id_pool);
+    fixed_n_delimiter_parser_grammar_free(line_grammar);
 DEFER_1:
     g_array_unref(data.invalid_flight_ids);
-    g_ptr_array_unref(data.commit_buffer);
+    g_array_unref(data.commit_flights);
+    g_array_unref(data.commit_buffer);
 
     return retval != 0;
 }
@@ -20,14 +20,28 @@
  *
  * @details Many internal methods in this module are lacking parameter documentation, as they all
  *          follow the same convention: all are ::fixed_n_delimiter_parser_iter_callback_t. The
- *          `loader_data` is a pointer to a ::reservations_loader_t.
+ *          `loader_data` is a pointer to a ::reservations_loader_chunk_t.
  */
 
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "dataset/dataset_parser.h"
 #include "dataset/reservations_loader.h"
 #include "utils/int_utils.h"
+#include "utils/pool.h"
+#include "utils/string_pool.h"
+
+/** @brief Block capacity of ::reservations_loader_chunk_t::reservations. */
+#define RESERVATIONS_LOADER_CHUNK_POOL_BLOCK_CAPACITY 4096
+
+/**
+ * @brief Block capacity of ::reservations_loader_chunk_t::strings and
+ *        ::reservations_loader_chunk_t::hotel_names.
+ */
+#define RESERVATIONS_LOADER_CHUNK_STRING_POOL_BLOCK_CAPACITY 65536
 
 /** @cond FALSE */
 #ifndef __GNUC__
@@ -41,52 +55,124 @@
  *
  * @var reservations_loader_t::output
  *     @brief Where to output dataset errors to.
+ * @var reservations_loader_t::contents
+ *     @brief Contents of the `reservations.csv` file, to copy lines of unknown users from.
  * @var reservations_loader_t::database
  *     @brief Database to add new reservations to.
- * @var reservations_loader_t::users
+ */
+typedef struct {
+    dataset_error_output_t *const output;
+    const char *const             contents;
+    database_t *const             database;
+} reservations_loader_t;
+
+/**
+ * @struct reservations_loader_lookup_t
+ * @brief  A line of `reservations.csv` parsed in a chunk, whose user is yet to be looked up.
+ *
+ * @var reservations_loader_lookup_t::staged
+ *     @brief Index of the line in ::reservations_loader_chunk_t::staged.
+ * @var reservations_loader_lookup_t::offset
+ *     @brief Offset of the line in the file, to copy it from if its user doesn't exist.
+ * @var reservations_loader_lookup_t::length
+ *     @brief Length of the line, not including its delimiter.
+ */
+typedef struct {
+    size_t staged;
+    size_t offset, length;
+} reservations_loader_lookup_t;
+
+/**
+ * @struct  reservations_loader_chunk_t
+ * @brief   Temporary data needed to load a chunk of a file of reservations.
+ * @details Parsing results are staged here, to be committed to the database in file order. Users
+ *          are looked up all at once, after the whole chunk is parsed (see
+ *          ::user_manager_get_ordinals).
+ *
+ * @var reservations_loader_chunk_t::contents
+ *     @brief Contents of the file being parsed.
+ * @var reservations_loader_chunk_t::users
  *     @brief User manager, to check for the existence of users mentioned in reservations.
- * @var reservations_loader_t::error_line
+ * @var reservations_loader_chunk_t::reservations
+ *     @brief Pool where staged reservations are stored.
+ * @var reservations_loader_chunk_t::strings
+ *     @brief Pool where error lines and identifiers of users to be looked up are stored.
+ * @var reservations_loader_chunk_t::hotel_names
+ *     @brief Dictionary of the hotel names in staged reservations.
+ * @var reservations_loader_chunk_t::staged
+ *     @brief   Reservations parsed in this chunk, in file order.
+ *     @details `NULL` elements represent invalid lines, stored in
+ *              ::reservations_loader_chunk_t::errors.
+ * @var reservations_loader_chunk_t::errors
+ *     @brief Invalid lines in this chunk, to be printed to the errors file.
+ * @var reservations_loader_chunk_t::user_ids
+ *     @brief Identifiers of the users to be looked up, stored in
+ *            ::reservations_loader_chunk_t::strings.
+ * @var reservations_loader_chunk_t::lookups
+ *     @brief Lines (::reservations_loader_lookup_t) of each user in
+ *            ::reservations_loader_chunk_t::user_ids.
+ * @var reservations_loader_chunk_t::current_user_id
+ *     @brief Identifier of the user in the line currently being parsed, copied to
+ *            ::reservations_loader_chunk_t::strings (`NULL` on allocation failure).
+ * @var reservations_loader_chunk_t::error_line
  *     @brief Current line being processed, in case it needs to be put in the errors file.
- * @var reservations_loader_t::current_reservation
+ * @var reservations_loader_chunk_t::line_offset
+ *     @brief Offset of ::reservations_loader_chunk_t::error_line in the file.
+ * @var reservations_loader_chunk_t::line_length
+ *     @brief Length of ::reservations_loader_chunk_t::error_line, not including its delimiter.
+ * @var reservations_loader_chunk_t::current_reservation
  *     @brief Reservation being currently parsed, whose fields are still being filled in.
- * @var reservations_loader_t::first_line
+ * @var reservations_loader_chunk_t::first_line
  *     @brief   Whether the line being parsed is the first line in the file.
  *     @details Used to print an error on the CSV's table header.
  */
 typedef struct {
-    dataset_error_output_t *const output;
-    database_t *const             database;
-    const user_manager_t *const   users;
-
-    const char          *error_line;
-    reservation_t *const current_reservation;
-    int                  first_line;
-} reservations_loader_t;
+    const char           *contents;
+    const user_manager_t *users;
+    pool_t               *reservations;
+    string_pool_t        *strings;
+    string_dictionary_t  *hotel_names;
+    GPtrArray            *staged;
+    GPtrArray            *errors;
+    GPtrArray            *user_ids;
+    GArray               *lookups;
+
+    char          *current_user_id;
+    const char    *error_line;
+    size_t         line_offset, line_length;
+    reservation_t *current_reservation;
+    int            first_line;
+} reservations_loader_chunk_t;
 
 /**
  * @brief Stores the beginning of the current line, in case it needs to be printed to the errors
  *        file.
  *
- * @param loader_data A pointer to a ::reservations_loader_t.
+ * @param loader_data A pointer to a ::reservations_loader_chunk_t.
  * @param line        Line that is going to be parsed.
+ * @param offset      Offset of @p line in the file.
  *
  * @retval 0 Always successful.
  */
-int __reservations_loader_before_parse_line(void *loader_data, char *line) {
-    ((reservations_loader_t *) loader_data)->error_line = line;
+int __reservations_loader_before_parse_line(void *loader_data, char *line, size_t offset) {
+    reservations_loader_chunk_t *const chunk = loader_data;
+
+    chunk->error_line  = line;
+    chunk->line_offset = offset;
+    chunk->line_length = strlen(line);
     return 0;
 }
 
 /** @brief Parses a reservation's identifier. */
 int __reservation_loader_parse_id(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    reservations_loader_t *const loader = loader_data;
+    reservations_loader_chunk_t *const chunk = loader_data;
 
     reservation_id_t id;
     const int        retval = reservation_id_from_string(&id, token);
     if (retval == 0) {
-        reservation_set_id(loader->current_reservation, id);
-    } else if (retval == 2 && !(loader->first_line && strcmp(token, "id") == 0)) {
+        reservation_set_id(chunk->current_reservation, id);
+    } else if (retval == 2 && !(chunk->first_line && strcmp(token, "id") == 0)) {
         fprintf(stderr,
                 "Reservation ID \"%s\" not if format BookXXXXXXXXXX. This isn't supported by our "
                 "program!\n",
@@ -95,27 +181,30 @@ int __reservation_loader_parse_id(void *loader_data, char *token, size_t ntoken)
     return retval;
 }
 
-/** @brief Parses the identifier of the user that booked a reservation. */
+/**
+ * @brief   Parses the identifier of the user that booked a reservation.
+ * @details The user is only looked up in ::__reservations_loader_finish_chunk. @p token is only
+ *          null-terminated while this callback runs (other fields follow it in the line), so it's
+ *          copied to ::reservations_loader_chunk_t::strings right away.
+ */
 int __reservation_loader_parse_user_id(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    reservations_loader_t *const loader = loader_data;
+    reservations_loader_chunk_t *const chunk = loader_data;
 
-    if (*token && user_manager_get_by_id(loader->users, token) != NULL)
-        return reservation_set_user_id(NULL, loader->current_reservation, token);
-    else
-        return 1;
+    chunk->current_user_id = string_pool_put(chunk->strings, token); /* NULL on failure */
+    return 0;
 }
 
 /** @brief Parses the identifier of the hotel of a reservation. */
 int __reservation_loader_parse_hotel_id(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    reservations_loader_t *const loader = loader_data;
+    reservations_loader_chunk_t *const chunk = loader_data;
 
     hotel_id_t id;
     const int  retval = hotel_id_from_string(&id, token);
     if (retval == 0) {
-        reservation_set_hotel_id(loader->current_reservation, id);
-    } else if (retval == 2 && !(loader->first_line && strcmp(token, "hotel_id") == 0)) {
+        reservation_set_hotel_id(chunk->current_reservation, id);
+    } else if (retval == 2 && !(chunk->first_line && strcmp(token, "hotel_id") == 0)) {
         fprintf(stderr,
                 "Hotel ID \"%s\" not if format HTLXXXXX. This isn't supported by our program!\n",
                 token);
@@ -126,9 +215,8 @@ int __reservation_loader_parse_hotel_id(void *loader_data, char *token, size_t n
 /** @brief Parses a reservation's hotel name. */
 int __reservation_loader_parse_hotel_name(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    return reservation_set_hotel_name(NULL,
-                                      ((reservations_loader_t *) loader_data)->current_reservation,
-                                      token);
+    reservations_loader_chunk_t *const chunk = loader_data;
+    return reservation_set_hotel_name(chunk->hotel_names, chunk->current_reservation, token);
 }
 
 /**
@@ -137,7 +225,7 @@ int __reservation_loader_parse_hotel_name(void *loader_data, char *token, size_t
  *          empty, they require a different handler function.
  */
 int __reservation_loader_parse_mandatory_numeral(void *loader_data, char *token, size_t ntoken) {
-    reservations_loader_t *const loader = loader_data;
+    reservations_loader_chunk_t *const chunk = loader_data;
 
     uint64_t  numeral;
     const int retval = int_utils_parse_positive(&numeral, token);
@@ -146,27 +234,20 @@ int __reservation_loader_parse_mandatory_numeral(void *loader_data, char *token,
 
     switch (ntoken) {
         case 4:
-            return reservation_set_hotel_stars(loader->current_reservation, numeral);
+            return reservation_set_hotel_stars(chunk->current_reservation, numeral);
         case 5:
-            reservation_set_city_tax(loader->current_reservation, numeral);
+            reservation_set_city_tax(chunk->current_reservation, numeral);
             return 0;
         case 9:
-            return reservation_set_price_per_night(loader->current_reservation, numeral);
+            return reservation_set_price_per_night(chunk->current_reservation, numeral);
         default:
             __builtin_unreachable();
     }
 }
 
-/** @brief Parses a reservation's hotel address. */
-int __reservation_loader_parse_address(void *loader_data, char *token, size_t ntoken) {
-    (void) loader_data;
-    (void) ntoken;
-    return (*token == '\0'); /* Fail on empty addresses */
-}
-
 /** @brief Parses a reservation's beginning and end dates. */
 int __reservation_loader_parse_date(void *loader_data, char *token, size_t ntoken) {
-    reservations_loader_t *const loader = loader_data;
+    reservations_loader_chunk_t *const chunk = loader_data;
 
     date_t    date;
     const int retval = date_from_string(&date, token);
@@ -175,9 +256,9 @@ int __reservation_loader_parse_date(void *loader_data, char *token, size_t ntoke
 
     switch (ntoken) {
         case 7:
-            return reservation_set_begin_date(loader->current_reservation, date);
+            return reservation_set_begin_date(chunk->current_reservation, date);
         case 8:
-            return reservation_set_end_date(loader->current_reservation, date);
+            return reservation_set_end_date(chunk->current_reservation, date);
         default:
             __builtin_unreachable();
     }
@@ -186,45 +267,34 @@ int __reservation_loader_parse_date(void *loader_data, char *token, size_t ntoke
 /** @brief Parses a reservation's "includes breakfast" field. */
 int __reservation_loader_parse_includes_breakfast(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
+    reservations_loader_chunk_t *const chunk = loader_data;
 
     includes_breakfast_t includes_breakfast;
     const int            retval = includes_breakfast_from_string(&includes_breakfast, token);
     if (retval)
         return retval;
 
-    reservation_set_includes_breakfast(((reservations_loader_t *) loader_data)->current_reservation,
-                                       includes_breakfast);
-    return 0;
-}
-
-/**
- * @brief   Parses a reservation's room details and comment fields.
- * @details These are strings that do not require verification.
- */
-int __reservation_loader_parse_dont_verify(void *loader_data, char *token, size_t ntoken) {
-    (void) loader_data;
-    (void) token;
-    (void) ntoken;
+    reservation_set_includes_breakfast(chunk->current_reservation, includes_breakfast);
     return 0;
 }
 
 /** @brief Parses a reservation's rating. */
 int __reservation_loader_parse_rating(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
+    reservations_loader_chunk_t *const chunk = loader_data;
 
     uint64_t  rating = RESERVATION_NO_RATING;
     const int retval = int_utils_parse_positive(&rating, token);
     if (retval && *token)
         return retval; /* Invalid number */
 
-    return reservation_set_rating(((reservations_loader_t *) loader_data)->current_reservation,
-                                  rating);
+    return reservation_set_rating(chunk->current_reservation, rating);
 }
 
 /**
- * @brief Places a parsed reservation in the database and handles errors.
+ * @brief Stages a parsed reservation or an error line, to be committed later.
  *
- * @param loader_data A pointer to a ::reservations_loader_t.
+ * @param loader_data A pointer to a ::reservations_loader_chunk_t.
  * @param retval      Value returned by the last token callback (`0` for success, another value for
  *                    a parsing error).
  *
@@ -232,28 +302,259 @@ int __reservation_loader_parse_rating(void *loader_data, char *token, size_t nto
  * @retval 1 Allocation failure.
  */
 int __reservations_loader_after_parse_line(void *loader_data, int retval) {
-    reservations_loader_t *const loader = loader_data;
-    loader->first_line                  = 0;
+    reservations_loader_chunk_t *const chunk = loader_data;
+    chunk->first_line                        = 0;
 
     if (retval) {
-        dataset_error_output_report_reservation_error(loader->output, loader->error_line);
-        retval = 0;
+        char *const line = string_pool_put(chunk->strings, chunk->error_line);
+        if (!line)
+            return 1;
+
+        g_ptr_array_add(chunk->errors, line);
+        g_ptr_array_add(chunk->staged, NULL);
     } else {
-        retval = database_add_reservation(loader->database, loader->current_reservation);
+        reservation_t *const reservation = reservation_clone(chunk->reservations,
+                                                             chunk->hotel_names,
+                                                             chunk->hotel_names,
+                                                             chunk->current_reservation);
+        if (!reservation)
+            return 1;
+
+        char *const user_id = chunk->current_user_id;
+        if (!user_id)
+            return 1; /* Allocation failure in __reservation_loader_parse_user_id */
+
+        const reservations_loader_lookup_t lookup = {
+            .staged = chunk->staged->len,
+            .offset = chunk->line_offset,
+            .length = chunk->line_length};
+        g_ptr_array_add(chunk->user_ids, user_id);
+        g_array_append_val(chunk->lookups, lookup);
+        g_ptr_array_add(chunk->staged, reservation);
     }
 
-    reservation_reset_dates(loader->current_reservation);
-    return retval;
+    reservation_reset_dates(chunk->current_reservation);
+    return 0;
+}
+
+/**
+ * @brief   Turns reservations whose users weren't found into error lines.
+ * @details ::reservations_loader_chunk_t::errors is rebuilt, so that it stays in file order.
+ *
+ * @param chunk Chunk whose users have been looked up.
+ * @param found Whether the user of each element of ::reservations_loader_chunk_t::lookups was
+ *              found.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __reservations_loader_reject_unknown_users(reservations_loader_chunk_t *chunk,
+                                               const uint8_t               *found) {
+    GPtrArray *const errors = g_ptr_array_new();
+
+    /* Every staged reservation has a lookup, in the same order */
+    size_t old_error = 0, lookup = 0;
+    for (size_t i = 0; i < chunk->staged->len; ++i) {
+        if (!g_ptr_array_index(chunk->staged, i)) {
+            g_ptr_array_add(errors, g_ptr_array_index(chunk->errors, old_error++));
+            continue;
+        }
+
+        const reservations_loader_lookup_t *const l =
+            &g_array_index(chunk->lookups, reservations_loader_lookup_t, lookup);
+        if (found[lookup++])
+            continue;
+
+        char *const line = string_pool_allocate(chunk->strings, l->length);
+        if (!line) {
+            g_ptr_array_unref(errors);
+            return 1;
+        }
+
+        memcpy(line, chunk->contents + l->offset, l->length);
+        line[l->length] = '\0';
+        g_ptr_array_add(errors, line);
+        g_ptr_array_index(chunk->staged, i) = NULL;
+    }
+
+    g_ptr_array_unref(chunk->errors);
+    chunk->errors = errors;
+    return 0;
 }
 
-int reservations_loader_load(FILE *stream, database_t *database, dataset_error_output_t *output) {
-    reservations_loader_t data = {.output              = output,
-                                  .database            = database,
-                                  .users               = database_get_users(database),
-                                  .current_reservation = reservation_create(NULL),
-                                  .first_line          = 1};
-    if (!data.current_reservation)
+/**
+ * @brief   Looks up the users of all reservations parsed in a chunk, at once.
+ * @details Reservations whose users don't exist are turned into error lines.
+ *
+ * @param loader_data A pointer to a ::reservations_loader_t.
+ * @param chunk_data  A pointer to a ::reservations_loader_chunk_t.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __reservations_loader_finish_chunk(void *loader_data, void *chunk_data) {
+    (void) loader_data;
+    reservations_loader_chunk_t *const chunk = chunk_data;
+
+    const size_t n = chunk->user_ids->len;
+    if (!n)
+        return 0;
+
+    int                   retval   = 1;
+    user_ordinal_t *const ordinals = malloc(n * sizeof(user_ordinal_t));
+    if (!ordinals)
         return 1;
+    uint8_t *const found = malloc(n);
+    if (!found)
+        goto DEFER_1;
+
+    if (user_manager_get_ordinals(chunk->users,
+                                  n,
+                                  (const char *const *) chunk->user_ids->pdata,
+                                  ordinals,
+                                  found))
+        goto DEFER_2;
+
+    int all_found = 1;
+    for (size_t i = 0; i < n; ++i) {
+        const reservations_loader_lookup_t *const lookup =
+            &g_array_index(chunk->lookups, reservations_loader_lookup_t, i);
+
+        if (found[i])
+            reservation_set_user(g_ptr_array_index(chunk->staged, lookup->staged), ordinals[i]);
+        else
+            all_found = 0;
+    }
+
+    retval = all_found ? 0 : __reservations_loader_reject_unknown_users(chunk, found);
+DEFER_2:
+    free(found);
+DEFER_1:
+    free(ordinals);
+    return retval;
+}
+
+/**
+ * @brief Frees a chunk created by ::__reservations_loader_create_chunk.
+ * @param chunk_data A pointer to a ::reservations_loader_chunk_t.
+ */
+void __reservations_loader_free_chunk(void *chunk_data) {
+    reservations_loader_chunk_t *const chunk = chunk_data;
+
+    reservation_free(chunk->current_reservation);
+    g_array_unref(chunk->lookups);
+    g_ptr_array_unref(chunk->user_ids);
+    g_ptr_array_unref(chunk->errors);
+    g_ptr_array_unref(chunk->staged);
+    string_dictionary_free(chunk->hotel_names);
+    string_pool_free(chunk->strings);
+    pool_free(chunk->reservations);
+    free(chunk);
+}
+
+/**
+ * @brief Creates the data needed to parse a chunk of a file of reservations.
+ *
+ * @param loader_data A pointer to a ::reservations_loader_t.
+ * @param offset      Offset of the chunk in the file.
+ *
+ * @return A pointer to a ::reservations_loader_chunk_t, or `NULL` on allocation failure.
+ */
+void *__reservations_loader_create_chunk(void *loader_data, size_t offset) {
+    const reservations_loader_t *const loader = loader_data;
+
+    reservations_loader_chunk_t *const chunk = malloc(sizeof(reservations_loader_chunk_t));
+    if (!chunk)
+        return NULL;
+
+    chunk->reservations = pool_create_from_size(reservation_sizeof(),
+                                                RESERVATIONS_LOADER_CHUNK_POOL_BLOCK_CAPACITY);
+    if (!chunk->reservations)
+        goto DEFER_1;
+
+    chunk->strings = string_pool_create(RESERVATIONS_LOADER_CHUNK_STRING_POOL_BLOCK_CAPACITY);
+    if (!chunk->strings)
+        goto DEFER_2;
+
+    chunk->hotel_names =
+        string_dictionary_create(RESERVATIONS_LOADER_CHUNK_STRING_POOL_BLOCK_CAPACITY);
+    if (!chunk->hotel_names)
+        goto DEFER_3;
+
+    chunk->current_reservation = reservation_create(NULL);
+    if (!chunk->current_reservation)
+        goto DEFER_4;
+
+    chunk->contents        = loader->contents;
+    chunk->users           = database_get_users(loader->database);
+    chunk->staged          = g_ptr_array_new();
+    chunk->errors          = g_ptr_array_new();
+    chunk->user_ids        = g_ptr_array_new();
+    chunk->lookups         = g_array_new(FALSE, FALSE, sizeof(reservations_loader_lookup_t));
+    chunk->current_user_id = NULL;
+    chunk->error_line      = NULL;
+    chunk->line_offset     = offset;
+    chunk->line_length     = 0;
+    chunk->first_line      = offset == 0;
+    return chunk;
+
+DEFER_4:
+    string_dictionary_free(chunk->hotel_names);
+DEFER_3:
+    string_pool_free(chunk->strings);
+DEFER_2:
+    pool_free(chunk->reservations);
+DEFER_1:
+    free(chunk);
+    return NULL;
+}
+
+/**
+ * @brief Places the reservations parsed in a chunk in the database and reports errors, in file
+ *        order.
+ *
+ * @param loader_data A pointer to a ::reservations_loader_t.
+ * @param chunk_data  A pointer to a ::reservations_loader_chunk_t.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __reservations_loader_commit_chunk(void *loader_data, void *chunk_data) {
+    const reservations_loader_t *const       loader = loader_data;
+    const reservations_loader_chunk_t *const chunk  = chunk_data;
+
+    const reservation_t *const *const staged =
+        (const reservation_t *const *) chunk->staged->pdata;
+
+    /* Runs of valid reservations between error lines are added to the database at once */
+    size_t error_index = 0, run_begin = 0;
+    for (size_t i = 0; i <= chunk->staged->len; ++i) {
+        if (i < chunk->staged->len && staged[i])
+            continue;
+
+        if (i > run_begin && database_add_reservations_batch(loader->database,
+                                                             chunk->hotel_names,
+                                                             i - run_begin,
+                                                             staged + run_begin))
+            return 1;
+
+        if (i < chunk->staged->len)
+            dataset_error_output_report_reservation_error(
+                loader->output,
+                g_ptr_array_index(chunk->errors, error_index++));
+        run_begin = i + 1;
+    }
+
+    return 0;
+}
+
+int reservations_loader_load(const mapped_file_t             *file,
+                             database_t                      *database,
+                             dataset_error_output_t          *output,
+                             const dataset_parser_progress_t *progress) {
+    reservations_loader_t data = {.output   = output,
+                                  .contents = mapped_file_get_contents(file),
+                                  .database = database};
 
     const fixed_n_delimiter_parser_iter_callback_t token_callbacks[14] = {
         __reservation_loader_parse_id,
@@ -262,21 +563,20 @@ int reservations_loader_load(FILE *stream, database_t *database, dataset_error_o
         __reservation_loader_parse_hotel_name,
         __reservation_loader_parse_mandatory_numeral,
         __reservation_loader_parse_mandatory_numeral,
-        __reservation_loader_parse_address,
+        fixed_n_delimiter_parser_check_non_empty, /* Address */
         __reservation_loader_parse_date,
         __reservation_loader_parse_date,
         __reservation_loader_parse_mandatory_numeral,
         __reservation_loader_parse_includes_breakfast,
-        __reservation_loader_parse_dont_verify,
+        fixed_n_delimiter_parser_skip, /* Room details */
         __reservation_loader_parse_rating,
-        __reservation_loader_parse_dont_verify};
+        fixed_n_delimiter_parser_skip, /* Comment */
+    };
 
     fixed_n_delimiter_parser_grammar_t *const line_grammar =
         fixed_n_delimiter_parser_grammar_new(';', 14, token_callbacks);
-    if (!line_grammar) {
-        reservation_free(data.current_reservation);
+    if (!line_grammar)
         return 1;
-    }
 
     dataset_parser_grammar_t *const grammar =
         dataset_parser_grammar_new('\n',
@@ -285,15 +585,20 @@ int reservations_loader_load(FILE *stream, database_t *database, dataset_error_o
                                    __reservations_loader_after_parse_line);
     if (!grammar) {
         fixed_n_delimiter_parser_grammar_free(line_grammar);
-        reservation_free(data.current_reservation);
         return 1;
     }
 
-    const int retval = dataset_parser_parse(stream, grammar, &data);
+    const int retval = dataset_parser_parse_parallel(file,
+                                                     grammar,
+                                                     __reservations_loader_create_chunk,
+                                                     __reservations_loader_finish_chunk,
+                                                     __reservations_loader_commit_chunk,
+                                                     __reservations_loader_free_chunk,
+                                                     &data,
+                                                     progress);
 
     fixed_n_delimiter_parser_grammar_free(line_grammar);
     dataset_parser_grammar_free(grammar);
-    reservation_free(data.current_reservation);
 
     return retval != 0;
 }
@@ -20,13 +20,25 @@
  *
  * @details Many internal methods in this module are lacking parameter documentation, as they all
  *          follow the same convention: all are ::fixed_n_delimiter_parser_iter_callback_t. The
- *          `loader_data` is a pointer to a ::users_loader_t.
+ *          `loader_data` is a pointer to a ::users_loader_chunk_t.
  */
 
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "dataset/users_loader.h"
 
 #include "dataset/dataset_parser.h"
 #include "types/email.h"
+#include "utils/pool.h"
+#include "utils/string_pool.h"
+
+/** @brief Block capacity of ::users_loader_chunk_t::users. */
+#define USERS_LOADER_CHUNK_POOL_BLOCK_CAPACITY 4096
+
+/** @brief Block capacity of ::users_loader_chunk_t::strings. */
+#define USERS_LOADER_CHUNK_STRING_POOL_BLOCK_CAPACITY 65536
 
 /** @cond FALSE */
 #ifndef __GNUC__
@@ -42,43 +54,74 @@
  *     @brief Where to output dataset errors to.
  * @var users_loader_t::database
  *     @brief Database to add new users to.
- * @var users_loader_t::error_line
- *     @brief Current line being processed, in case it needs to be put in the error file.
- * @var users_loader_t::current_user
- *     @brief User being currently parsed, whose fields are still being filled in.
  */
 typedef struct {
     dataset_error_output_t *const output;
     database_t *const             database;
-
-    const char   *error_line;
-    user_t *const current_user;
 } users_loader_t;
 
+/**
+ * @struct  users_loader_chunk_t
+ * @brief   Temporary data needed to load a chunk of a file of users.
+ * @details Parsing results are staged here, to be committed to the database in file order.
+ *
+ * @var users_loader_chunk_t::users
+ *     @brief Pool where staged users are stored.
+ * @var users_loader_chunk_t::strings
+ *     @brief Pool where the strings in staged users and error lines are stored.
+ * @var users_loader_chunk_t::staged
+ *     @brief   Users parsed in this chunk, in file order.
+ *     @details `NULL` elements represent invalid lines, stored in ::users_loader_chunk_t::errors.
+ * @var users_loader_chunk_t::errors
+ *     @brief Invalid lines in this chunk, to be printed to the error file.
+ * @var users_loader_chunk_t::error_line
+ *     @brief Current line being processed, in case it needs to be put in the error file.
+ * @var users_loader_chunk_t::current_user
+ *     @brief   User being currently parsed, whose fields are still being filled in.
+ *     @details Its strings are validated and put in ::users_loader_chunk_t::strings right from the
+ *              tokenized line, so that no temporary copies are made. Strings of invalid lines are
+ *              only discarded with the chunk.
+ */
+typedef struct {
+    pool_t        *users;
+    string_pool_t *strings;
+    GPtrArray     *staged;
+    GPtrArray     *errors;
+
+    const char *error_line;
+    user_t     *current_user;
+} users_loader_chunk_t;
+
 /**
  * @brief Stores the beginning of the current line, in case it needs to be printed to the errors
  *        file.
  *
- * @param loader_data A pointer to a ::users_loader_t.
+ * @param loader_data A pointer to a ::users_loader_chunk_t.
  * @param line        Line that is going to be parsed.
+ * @param offset      Offset of @p line in the file. Not used.
  *
  * @retval 0 Always successful.
  */
-int __users_loader_before_parse_line(void *loader_data, char *line) {
-    ((users_loader_t *) loader_data)->error_line = line;
+int __users_loader_before_parse_line(void *loader_data, char *line, size_t offset) {
+    (void) offset;
+    ((users_loader_chunk_t *) loader_data)->error_line = line;
     return 0;
 }
 
 /** @brief Parses a user's identifier. */
 int __user_loader_parse_id(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    return user_set_id(NULL, ((users_loader_t *) loader_data)->current_user, token);
+
+    users_loader_chunk_t *const chunk = loader_data;
+    return user_set_id(chunk->strings, chunk->current_user, token);
 }
 
 /** @brief Parses a user's name. */
 int __user_loader_parse_name(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    return user_set_name(NULL, ((users_loader_t *) loader_data)->current_user, token);
+
+    users_loader_chunk_t *const chunk = loader_data;
+    return user_set_name(chunk->strings, chunk->current_user, token);
 }
 
 /** @brief Parses a user's email address. */
@@ -88,16 +131,6 @@ int __user_loader_parse_email(void *loader_data, char *token, size_t ntoken) {
     return email_validate_string(token);
 }
 
-/**
- * @brief   Parses the strings in a user that cannot be empty, but that are not stored.
- * @details These are the phone number, the address and the payment method.
- */
-int __user_loader_parse_non_empty(void *loader_data, char *token, size_t ntoken) {
-    (void) loader_data;
-    (void) ntoken;
-    return (*token == '\0'); /* Fail on empty phone numbers */
-}
-
 /** @brief Parses a user's birth date. */
 int __user_loader_parse_birth_date(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
@@ -107,7 +140,7 @@ int __user_loader_parse_birth_date(void *loader_data, char *token, size_t ntoken
     if (retval)
         return retval;
 
-    return user_set_birth_date(((users_loader_t *) loader_data)->current_user, date);
+    return user_set_birth_date(((users_loader_chunk_t *) loader_data)->current_user, date);
 }
 
 /** @brief Parses a user's sex. */
@@ -119,14 +152,16 @@ int __user_loader_parse_sex(void *loader_data, char *token, size_t ntoken) {
     if (retval)
         return retval;
 
-    user_set_sex(((users_loader_t *) loader_data)->current_user, sex);
+    user_set_sex(((users_loader_chunk_t *) loader_data)->current_user, sex);
     return 0;
 }
 
 /** @brief Parses a user's passport number. */
 int __user_loader_parse_passport(void *loader_data, char *token, size_t ntoken) {
     (void) ntoken;
-    return user_set_passport(NULL, ((users_loader_t *) loader_data)->current_user, token);
+
+    users_loader_chunk_t *const chunk = loader_data;
+    return user_set_passport(chunk->strings, chunk->current_user, token);
 }
 
 /** @brief Parses a user's country code. */
@@ -138,7 +173,7 @@ int __user_loader_parse_country_code(void *loader_data, char *token, size_t ntok
     if (retval)
         return retval;
 
-    user_set_country_code(((users_loader_t *) loader_data)->current_user, country);
+    user_set_country_code(((users_loader_chunk_t *) loader_data)->current_user, country);
     return 0;
 }
 
@@ -151,7 +186,8 @@ int __user_loader_parse_account_creation_date(void *loader_data, char *token, si
     if (retval)
         return retval;
 
-    return user_set_account_creation_date(((users_loader_t *) loader_data)->current_user, date);
+    users_loader_chunk_t *const chunk = loader_data;
+    return user_set_account_creation_date(chunk->current_user, date);
 }
 
 /** @brief Parses a user's account status. */
@@ -163,14 +199,14 @@ int __user_loader_parse_account_status(void *loader_data, char *token, size_t nt
     if (retval)
         return retval;
 
-    user_set_account_status(((users_loader_t *) loader_data)->current_user, status);
+    user_set_account_status(((users_loader_chunk_t *) loader_data)->current_user, status);
     return 0;
 }
 
 /**
- * @brief Places a parsed user in the database and handles errors.
+ * @brief Stages a parsed user or an error line, to be committed later.
  *
- * @param loader_data A pointer to a ::users_loader_t.
+ * @param loader_data A pointer to a ::users_loader_chunk_t.
  * @param retval      Value returned by the last token callback (`0` for success, another value for
  *                    a parsing error).
  *
@@ -178,48 +214,139 @@ int __user_loader_parse_account_status(void *loader_data, char *token, size_t nt
  * @retval 1 Allocation failure.
  */
 int __users_loader_after_parse_line(void *loader_data, int retval) {
-    users_loader_t *const loader = loader_data;
+    users_loader_chunk_t *const chunk = loader_data;
 
     if (retval) {
-        dataset_error_output_report_user_error(loader->output, loader->error_line);
-        retval = 0;
+        char *const line = string_pool_put(chunk->strings, chunk->error_line);
+        if (!line)
+            return 1;
+
+        g_ptr_array_add(chunk->errors, line);
+        g_ptr_array_add(chunk->staged, NULL);
     } else {
-        retval = database_add_user(loader->database, loader->current_user);
+        /* Strings are already in the chunk's pool, so they don't need to be copied again */
+        user_t *const user = user_clone_shallow(chunk->users, chunk->current_user);
+        if (!user)
+            return 1;
+
+        g_ptr_array_add(chunk->staged, user);
     }
 
-    user_reset_dates(loader->current_user);
-    return retval;
+    user_reset_dates(chunk->current_user);
+    return 0;
+}
+
+/**
+ * @brief Frees a chunk created by ::__users_loader_create_chunk.
+ * @param chunk_data A pointer to a ::users_loader_chunk_t.
+ */
+void __users_loader_free_chunk(void *chunk_data) {
+    users_loader_chunk_t *const chunk = chunk_data;
+
+    user_free(chunk->current_user);
+    g_ptr_array_unref(chunk->errors);
+    g_ptr_array_unref(chunk->staged);
+    string_pool_free(chunk->strings);
+    pool_free(chunk->users);
+    free(chunk);
+}
+
+/**
+ * @brief Creates the data needed to parse a chunk of a file of users.
+ *
+ * @param loader_data A pointer to a ::users_loader_t. Not used.
+ * @param offset      Offset of the chunk in the file. Not used.
+ *
+ * @return A pointer to a ::users_loader_chunk_t, or `NULL` on allocation failure.
+ */
+void *__users_loader_create_chunk(void *loader_data, size_t offset) {
+    (void) loader_data;
+    (void) offset;
+
+    users_loader_chunk_t *const chunk = malloc(sizeof(users_loader_chunk_t));
+    if (!chunk)
+        return NULL;
+
+    chunk->users = pool_create_from_size(user_sizeof(), USERS_LOADER_CHUNK_POOL_BLOCK_CAPACITY);
+    if (!chunk->users)
+        goto DEFER_1;
+
+    chunk->strings = string_pool_create(USERS_LOADER_CHUNK_STRING_POOL_BLOCK_CAPACITY);
+    if (!chunk->strings)
+        goto DEFER_2;
+
+    chunk->current_user = user_create(NULL);
+    if (!chunk->current_user)
+        goto DEFER_3;
+
+    chunk->staged     = g_ptr_array_new();
+    chunk->errors     = g_ptr_array_new();
+    chunk->error_line = NULL;
+    return chunk;
+
+DEFER_3:
+    string_pool_free(chunk->strings);
+DEFER_2:
+    pool_free(chunk->users);
+DEFER_1:
+    free(chunk);
+    return NULL;
 }
 
-int users_loader_load(FILE *stream, database_t *database, dataset_error_output_t *output) {
-    users_loader_t data = {.output       = output,
-                           .database     = database,
-                           .current_user = user_create(NULL)};
+/**
+ * @brief Places the users parsed in a chunk in the database and reports errors, in file order.
+ *
+ * @param loader_data A pointer to a ::users_loader_t.
+ * @param chunk_data  A pointer to a ::users_loader_chunk_t.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __users_loader_commit_chunk(void *loader_data, void *chunk_data) {
+    const users_loader_t *const       loader = loader_data;
+    const users_loader_chunk_t *const chunk  = chunk_data;
+
+    size_t error_index = 0;
+    for (size_t i = 0; i < chunk->staged->len; ++i) {
+        const user_t *const user = g_ptr_array_index(chunk->staged, i);
+        if (user) {
+            if (database_add_user(loader->database, user))
+                return 1;
+        } else {
+            dataset_error_output_report_user_error(
+                loader->output,
+                g_ptr_array_index(chunk->errors, error_index++));
+        }
+    }
+
+    return 0;
+}
 
-    if (!data.current_user)
-        return 1; /* Allocation failure */
+int users_loader_load(const mapped_file_t             *file,
+                      database_t                      *database,
+                      dataset_error_output_t          *output,
+                      const dataset_parser_progress_t *progress) {
+    users_loader_t data = {.output = output, .database = database};
 
     const fixed_n_delimiter_parser_iter_callback_t token_callbacks[12] = {
         __user_loader_parse_id,
         __user_loader_parse_name,
         __user_loader_parse_email,
-        __user_loader_parse_non_empty,
+        fixed_n_delimiter_parser_check_non_empty, /* Phone number */
         __user_loader_parse_birth_date,
         __user_loader_parse_sex,
         __user_loader_parse_passport,
         __user_loader_parse_country_code,
-        __user_loader_parse_non_empty,
+        fixed_n_delimiter_parser_check_non_empty, /* Address */
         __user_loader_parse_account_creation_date,
-        __user_loader_parse_non_empty,
+        fixed_n_delimiter_parser_check_non_empty, /* Payment method */
         __user_loader_parse_account_status,
     };
 
     fixed_n_delimiter_parser_grammar_t *const line_grammar =
         fixed_n_delimiter_parser_grammar_new(';', 12, token_callbacks);
-    if (!line_grammar) {
-        user_free(data.current_user);
+    if (!line_grammar)
         return 1;
-    }
 
     dataset_parser_grammar_t *const grammar =
         dataset_parser_grammar_new('\n',
@@ -228,15 +355,20 @@ int users_loader_load(FILE *stream, database_t *database, dataset_error_output_t
                                    __users_loader_after_parse_line);
     if (!grammar) {
         fixed_n_delimiter_parser_grammar_free(line_grammar);
-        user_free(data.current_user);
         return 1;
     }
 
-    const int retval = dataset_parser_parse(stream, grammar, &data);
+    const int retval = dataset_parser_parse_parallel(file,
+                                                     grammar,
+                                                     __users_loader_create_chunk,
+                                                     NULL,
+                                                     __users_loader_commit_chunk,
+                                                     __users_loader_free_chunk,
+                                                     &data,
+                                                     progress);
 
     fixed_n_delimiter_parser_grammar_free(line_grammar);
     dataset_parser_grammar_free(grammar);
-    user_free(data.current_user);
 
     return retval != 0;
 }
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  export_mode.c
+ * @brief Implementation of methods in include/export_mode.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref export_mode_examples).
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "database/database_arrow.h"
+#include "dataset/dataset_loader.h"
+#include "export_mode.h"
+
+/** @brief Name of the file, in the cache directory, where to store a database snapshot. */
+#define EXPORT_MODE_SNAPSHOT_FILE_NAME ".database_snapshot"
+
+int export_mode_run(const char *dataset_dir, const char *cache_dir, const char *output_dir) {
+    if (mkdir(output_dir, 0755) && errno != EEXIST) {
+        fputs("Failed to create output directory!\n", stderr);
+        return 1;
+    }
+
+    char snapshot_path[PATH_MAX];
+    if (cache_dir &&
+        snprintf(snapshot_path, PATH_MAX, "%s/" EXPORT_MODE_SNAPSHOT_FILE_NAME, cache_dir) >=
+            PATH_MAX)
+        cache_dir = NULL; /* Path too long: just don't keep a snapshot */
+
+    database_t *const database = dataset_loader_load_cached(dataset_dir,
+                                                            "Resultados",
+                                                            cache_dir ? snapshot_path : NULL,
+                                                            NULL);
+    if (!database) {
+        fputs("Failed to load dataset files!\n", stderr);
+        return 1;
+    }
+
+    int retval = 0;
+    for (database_arrow_table_t table = 0; table < DATABASE_ARROW_TABLE_COUNT; ++table) {
+        char path[PATH_MAX];
+        snprintf(path,
+                 PATH_MAX,
+                 "%s/%s.arrow",
+                 output_dir,
+                 database_arrow_table_get_name(table));
+
+        if (database_arrow_write_file(database, table, path)) {
+            retval = 1;
+            fprintf(stderr, "Failed to export %s!\n", database_arrow_table_get_name(table));
+            break;
+        }
+    }
+
+    database_free(database);
+    return retval;
+}
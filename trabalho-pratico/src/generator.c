@@ -0,0 +1,95 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  generator.c
+ * @brief Contains the entry point to the dataset generator program.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dataset/dataset_generator.h"
+#include "utils/int_utils.h"
+
+/**
+ * @brief Parses the value of a non-negative real command-line option.
+ *
+ * @param output Where to write the parsed value to, only on success.
+ * @param value  Value of the option. Can be `NULL`, if the option was the last argument.
+ *
+ * @retval 0 Success.
+ * @retval 1 Missing or invalid value.
+ */
+int __generator_parse_real(double *output, const char *value) {
+    if (!value || !*value)
+        return 1;
+
+    char        *end;
+    const double parsed = strtod(value, &end);
+    if (*end || !(parsed >= 0))
+        return 1;
+
+    *output = parsed;
+    return 0;
+}
+
+/**
+ * @brief The entry point to the dataset generator program.
+ * @retval 0 Success
+ * @retval 1 Failure
+ */
+int main(int argc, char **argv) {
+    dataset_generator_options_t options = {.scale            = 1.0,
+                                           .invalid_fraction = 0.01,
+                                           .nqueries         = 1000,
+                                           .seed             = 1};
+
+    int valid = argc >= 2;
+    for (int i = 2; valid && i < argc; ++i) {
+        const char *const value = i + 1 < argc ? argv[i + 1] : NULL;
+        uint64_t          parsed = 0;
+
+        if (strcmp(argv[i], "-s") == 0) {
+            valid = !__generator_parse_real(&options.scale, value);
+        } else if (strcmp(argv[i], "-e") == 0) {
+            valid = !__generator_parse_real(&options.invalid_fraction, value) &&
+                    options.invalid_fraction <= 1;
+        } else if (strcmp(argv[i], "-q") == 0) {
+            valid            = value && !int_utils_parse_positive(&parsed, value);
+            options.nqueries = parsed;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            valid        = value && !int_utils_parse_positive(&parsed, value);
+            options.seed = parsed;
+        } else {
+            valid = 0;
+        }
+        i++;
+    }
+
+    if (!valid) {
+        fputs("Invalid command-line arguments! Usage:\n", stderr);
+        fputs("./programa-gerador [output directory] [-s scale] [-e invalid fraction] "
+              "[-q number of queries] [-r seed]\n",
+              stderr);
+        return 1;
+    }
+
+    options.output_dir = argv[1];
+    return dataset_generator_generate(&options);
+}
@@ -65,37 +65,73 @@ activity_t *activity_create(activity_keypress_callback_t  keypress_callback,
     return activity;
 }
 
-const void *activity_run(activity_t *activity) {
+/**
+ * @brief   Runs the event loop of an activity.
+ * @details The whole terminal is only repainted when the activity starts and when the terminal is
+ *          resized. Otherwise, the screen is erased with `erase` (not `clear`) before each render,
+ *          so that `ncurses` compares the new contents with what's on the terminal, and only sends
+ *          rows (and parts of rows) that changed. This matters on slow terminals (e.g.: over SSH).
+ *
+ * @param activity Activity to be run.
+ * @param interval Maximum time between renders, in milliseconds. `-1` for rendering only after
+ *                 user input.
+ *
+ * @return The `activity_data` value provided to ::activity_create, or `NULL` on input failure.
+ */
+const void *__activity_run(activity_t *activity, int interval) {
     clear();
     int cb_retval = activity->render_callback(activity->data);
     if (cb_retval)
         return activity->data;
     refresh();
 
-    wint_t input;
+    timeout(interval);
+
+    const void *ret = NULL;
+    wint_t      input;
     while (1) {
         const int is_key_code = get_wch(&input);
-        if (is_key_code == ERR)
+        if (is_key_code == ERR && interval < 0)
             break;
 
         /*
          * Ignore Ctrl modifier. Nevertheless, Ctrl+J and Ctrl+3 still need to pass through, as
-         * their codes are the same as a new line and escape.
+         * their codes are the same as a new line and escape. ERR here is a timeout, and only
+         * results in the activity being rendered again.
          */
-        if (input > 31 || input == '\n' || input == '\x1b' || is_key_code) {
+        if (is_key_code != ERR &&
+            (input > 31 || input == '\n' || input == '\x1b' || is_key_code)) {
             cb_retval = activity->keypress_callback(activity->data, input, is_key_code);
-            if (cb_retval)
-                return activity->data;
+            if (cb_retval) {
+                ret = activity->data;
+                break;
+            }
         }
 
-        clear();
+        /* After a resize, nothing on the terminal can be relied on, and it must be repainted */
+        if (is_key_code == KEY_CODE_YES && input == KEY_RESIZE)
+            clear();
+        else
+            erase();
+
         cb_retval = activity->render_callback(activity->data);
-        if (cb_retval)
-            return activity->data;
+        if (cb_retval) {
+            ret = activity->data;
+            break;
+        }
         refresh();
     };
 
-    return NULL;
+    timeout(-1);
+    return ret;
+}
+
+const void *activity_run(activity_t *activity) {
+    return __activity_run(activity, -1);
+}
+
+const void *activity_run_refreshing(activity_t *activity, int interval) {
+    return __activity_run(activity, interval);
 }
 
 void activity_free(activity_t *activity) {
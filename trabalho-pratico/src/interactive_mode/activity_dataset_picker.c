@@ -22,10 +22,19 @@
  * See [the header file's documentation](@ref activity_dataset_picker_examples).
  */
 
+/* d_type in struct dirent isn't part of POSIX */
+#ifndef _DEFAULT_SOURCE /* May already be defined in the compiler's flags */
+#define _DEFAULT_SOURCE
+#endif
+
 #include <dirent.h>
+#include <fcntl.h>
 #include <glib.h>
 #include <limits.h>
 #include <ncurses.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -41,19 +50,312 @@
 typedef enum {
     ACTIVITY_DATASET_PICKER_ACTION_ESCAPE,     /**< Leave the dataset picker. */
     ACTIVITY_DATASET_PICKER_ACTION_VISIT_DIR,  /**< Visit the selected directory. */
+    ACTIVITY_DATASET_PICKER_ACTION_PARENT_DIR, /**< Visit the parent directory. */
     ACTIVITY_DATASET_PICKER_ACTION_CHOOSE_DIR, /**< Choose a directory as a dataset. */
-    ACTIVITY_DATASET_PICKER_ACTION_TYPE_DIR    /**< Type the name of a new directory to visit. */
+    ACTIVITY_DATASET_PICKER_ACTION_TYPE_DIR,   /**< Type the name of a new directory to visit. */
+    ACTIVITY_DATASET_PICKER_ACTION_RELOAD_DIR  /**< List the current directory again. */
 } activity_dataset_picker_action_t;
 
+/**
+ * @struct activity_dataset_picker_entry_t
+ * @brief  A sub-directory in a ::activity_dataset_picker_listing_t.
+ *
+ * @var activity_dataset_picker_entry_t::name
+ *     @brief Name of the directory (UTF-8).
+ * @var activity_dataset_picker_entry_t::display_name
+ *     @brief Name of the directory (UTF-32), for rendering.
+ * @var activity_dataset_picker_entry_t::is_dataset
+ *     @brief Whether the directory contains all files of a dataset.
+ */
+typedef struct {
+    char      *name;
+    unichar_t *display_name;
+    int        is_dataset;
+} activity_dataset_picker_entry_t;
+
+/**
+ * @struct activity_dataset_picker_listing_t
+ * @brief  The sub-directories of a directory, listed in a background thread.
+ *
+ * @var activity_dataset_picker_listing_t::path
+ *     @brief Path of the listed directory.
+ * @var activity_dataset_picker_listing_t::thread
+ *     @brief Thread listing the directory.
+ * @var activity_dataset_picker_listing_t::lock
+ *     @brief Lock that guards all following fields.
+ * @var activity_dataset_picker_listing_t::entries
+ *     @brief Array of ::activity_dataset_picker_entry_t. `..` (when it exists) is always the first
+ *            entry, and all others are sorted by name.
+ * @var activity_dataset_picker_listing_t::version
+ *     @brief Incremented every time ::activity_dataset_picker_listing_t::entries changes.
+ * @var activity_dataset_picker_listing_t::listed
+ *     @brief Whether all sub-directories are in ::activity_dataset_picker_listing_t::entries.
+ * @var activity_dataset_picker_listing_t::complete
+ *     @brief Whether the thread has finished (datasets have also been detected).
+ * @var activity_dataset_picker_listing_t::failed
+ *     @brief Whether the directory couldn't be opened.
+ * @var activity_dataset_picker_listing_t::cancelled
+ *     @brief Set when the listing is no longer needed, for the thread to stop early.
+ */
+typedef struct {
+    char     *path;
+    pthread_t thread;
+
+    pthread_mutex_t lock;
+    GArray         *entries;
+    size_t          version;
+    int             listed, complete, failed, cancelled;
+} activity_dataset_picker_listing_t;
+
+/** @brief Number of directories listed before they're made visible to the user interface. */
+#define ACTIVITY_DATASET_PICKER_LISTING_BATCH_SIZE 256
+
+/** @brief Time between renders while a directory is being listed, in milliseconds. */
+#define ACTIVITY_DATASET_PICKER_REFRESH_INTERVAL 100
+
+/** @brief Files that must be in a directory for it to be considered a dataset. */
+const char *const activity_dataset_picker_dataset_files[4] = {"users.csv",
+                                                              "flights.csv",
+                                                              "passengers.csv",
+                                                              "reservations.csv"};
+
+/**
+ * @brief   Compares two ::activity_dataset_picker_entry_t by name.
+ * @details Byte order of UTF-8 strings is the same as the order of their code points.
+ *
+ * @param a Pointer to a ::activity_dataset_picker_entry_t.
+ * @param b Pointer to a ::activity_dataset_picker_entry_t.
+ *
+ * @return The equivalent of `strcmp(a, b)` for the names of the entries.
+ */
+int __activity_dataset_picker_entry_compare(const void *a, const void *b) {
+    return strcmp(((const activity_dataset_picker_entry_t *) a)->name,
+                  ((const activity_dataset_picker_entry_t *) b)->name);
+}
+
+/**
+ * @brief Checks whether a directory contains a dataset.
+ *
+ * @param parent_fd File descriptor of the parent directory.
+ * @param name      Name of the directory (relative to @p parent_fd).
+ *
+ * @return Whether the directory contains all files in ::activity_dataset_picker_dataset_files.
+ */
+int __activity_dataset_picker_is_dataset(int parent_fd, const char *name) {
+    /* Paths relative to an open directory, so that the whole path isn't resolved for every file */
+    for (size_t i = 0; i < 4; ++i) {
+        char file_path[PATH_MAX];
+        snprintf(file_path, PATH_MAX, "%s/%s", name, activity_dataset_picker_dataset_files[i]);
+        if (faccessat(parent_fd, file_path, F_OK, 0))
+            return 0; /* Most directories fail on the first file */
+    }
+    return 1;
+}
+
+/**
+ * @brief Moves newly listed directories to the entries visible to the user interface.
+ *
+ * @param listing Listing to be modified.
+ * @param batch   Array of ::activity_dataset_picker_entry_t to be moved, and then emptied.
+ * @param first   Index of the first entry to be sorted (after `..`).
+ */
+void __activity_dataset_picker_listing_flush(activity_dataset_picker_listing_t *listing,
+                                             GArray                            *batch,
+                                             size_t                             first) {
+    pthread_mutex_lock(&listing->lock);
+    g_array_append_vals(listing->entries, batch->data, batch->len);
+    qsort(listing->entries->data + first * sizeof(activity_dataset_picker_entry_t),
+          listing->entries->len - first,
+          sizeof(activity_dataset_picker_entry_t),
+          __activity_dataset_picker_entry_compare);
+    listing->version++;
+    pthread_mutex_unlock(&listing->lock);
+
+    g_array_set_size(batch, 0);
+}
+
+/**
+ * @brief Adds a directory to a batch of entries of a listing.
+ *
+ * @param batch Array of ::activity_dataset_picker_entry_t to be appended to.
+ * @param name  Name of the directory.
+ */
+void __activity_dataset_picker_listing_add(GArray *batch, const char *name) {
+    const activity_dataset_picker_entry_t entry = {
+        .name         = g_strdup(name),
+        .display_name = ncurses_utf8_to_unicode(name, NULL),
+        .is_dataset   = 0};
+    g_array_append_val(batch, entry);
+}
+
+/**
+ * @brief   Lists a directory, outside of the user interface's thread.
+ * @details Directories are made visible in batches, so that the first ones can be shown while
+ *          others are listed. Datasets are only detected after all sub-directories are known.
+ *
+ * @param listing_data A pointer to an ::activity_dataset_picker_listing_t.
+ *
+ * @return `NULL`.
+ */
+void *__activity_dataset_picker_listing_thread(void *listing_data) {
+    activity_dataset_picker_listing_t *const listing = listing_data;
+
+    DIR *const dir = opendir(listing->path);
+    if (!dir) {
+        pthread_mutex_lock(&listing->lock);
+        listing->failed   = 1;
+        listing->listed   = 1;
+        listing->complete = 1;
+        pthread_mutex_unlock(&listing->lock);
+        return NULL;
+    }
+    const int dir_fd = dirfd(dir);
+
+    GArray *const batch = g_array_new(FALSE, FALSE, sizeof(activity_dataset_picker_entry_t));
+
+    /* Always hide ".." on the root of the file system */
+    const size_t first = strcmp(listing->path, "/") != 0;
+    if (first)
+        __activity_dataset_picker_listing_add(batch, "..");
+    __activity_dataset_picker_listing_flush(listing, batch, first);
+
+    struct dirent *ent;
+    int            cancelled = 0;
+    while (!cancelled && (ent = readdir(dir)) != NULL) {
+        if (*ent->d_name == '.') /* Hide hidden files (".." was already added) */
+            continue;
+
+        /* Only stat when the file system doesn't tell the file type, or for symbolic links */
+        int is_dir = ent->d_type == DT_DIR;
+        if (ent->d_type == DT_UNKNOWN || ent->d_type == DT_LNK) {
+            struct stat statbuf;
+            is_dir = !fstatat(dir_fd, ent->d_name, &statbuf, 0) && S_ISDIR(statbuf.st_mode);
+        }
+
+        if (is_dir)
+            __activity_dataset_picker_listing_add(batch, ent->d_name);
+
+        if (batch->len >= ACTIVITY_DATASET_PICKER_LISTING_BATCH_SIZE) {
+            __activity_dataset_picker_listing_flush(listing, batch, first);
+
+            pthread_mutex_lock(&listing->lock);
+            cancelled = listing->cancelled;
+            pthread_mutex_unlock(&listing->lock);
+        }
+    }
+    __activity_dataset_picker_listing_flush(listing, batch, first);
+    g_array_unref(batch);
+
+    pthread_mutex_lock(&listing->lock);
+    listing->listed = 1;
+    const size_t n  = listing->entries->len;
+    pthread_mutex_unlock(&listing->lock);
+
+    /* Entries are only modified by this thread, so they can be read without the lock */
+    for (size_t i = first; i < n && !cancelled; ++i) {
+        activity_dataset_picker_entry_t *const entry =
+            &g_array_index(listing->entries, activity_dataset_picker_entry_t, i);
+        const int is_dataset = __activity_dataset_picker_is_dataset(dir_fd, entry->name);
+
+        pthread_mutex_lock(&listing->lock);
+        entry->is_dataset = is_dataset;
+        cancelled         = listing->cancelled;
+        pthread_mutex_unlock(&listing->lock);
+    }
+
+    closedir(dir);
+
+    pthread_mutex_lock(&listing->lock);
+    listing->complete = 1;
+    pthread_mutex_unlock(&listing->lock);
+    return NULL;
+}
+
+/**
+ * @brief   Frees a listing, after stopping the thread listing it.
+ * @details Used as the value destructor of the cache of listings.
+ * @param   listing_data A pointer to an ::activity_dataset_picker_listing_t.
+ */
+void __activity_dataset_picker_listing_free(void *listing_data) {
+    activity_dataset_picker_listing_t *const listing = listing_data;
+
+    pthread_mutex_lock(&listing->lock);
+    listing->cancelled = 1;
+    pthread_mutex_unlock(&listing->lock);
+    pthread_join(listing->thread, NULL);
+
+    for (size_t i = 0; i < listing->entries->len; ++i) {
+        activity_dataset_picker_entry_t *const entry =
+            &g_array_index(listing->entries, activity_dataset_picker_entry_t, i);
+        g_free(entry->name);
+        g_free(entry->display_name);
+    }
+
+    g_array_unref(listing->entries);
+    pthread_mutex_destroy(&listing->lock);
+    g_free(listing->path);
+    free(listing);
+}
+
+/**
+ * @brief   Gets the listing of a directory, starting to list it if it's not in a cache.
+ * @details Listings are kept in @p cache until the dataset picker is left, so that going back to
+ *          a directory is instant.
+ *
+ * @param cache `GHashTable` from paths to ::activity_dataset_picker_listing_t.
+ * @param path  Path of the directory to be listed.
+ *
+ * @return The listing of @p path, or `NULL` on failure.
+ */
+activity_dataset_picker_listing_t *__activity_dataset_picker_get_listing(GHashTable *cache,
+                                                                         const char *path) {
+    activity_dataset_picker_listing_t *listing = g_hash_table_lookup(cache, path);
+    if (listing)
+        return listing;
+
+    listing = malloc(sizeof(activity_dataset_picker_listing_t));
+    if (!listing)
+        return NULL;
+
+    if (pthread_mutex_init(&listing->lock, NULL)) {
+        free(listing);
+        return NULL;
+    }
+
+    listing->path      = g_strdup(path);
+    listing->entries   = g_array_new(FALSE, FALSE, sizeof(activity_dataset_picker_entry_t));
+    listing->version   = 0;
+    listing->listed    = 0;
+    listing->complete  = 0;
+    listing->failed    = 0;
+    listing->cancelled = 0;
+
+    if (pthread_create(&listing->thread, NULL, __activity_dataset_picker_listing_thread, listing)) {
+        g_array_unref(listing->entries);
+        g_free(listing->path);
+        pthread_mutex_destroy(&listing->lock);
+        free(listing);
+        return NULL;
+    }
+
+    g_hash_table_insert(cache, listing->path, listing);
+    return listing;
+}
+
 /**
  * @struct activity_dataset_picker_data_t
  * @brief  Data in a dataset picker TUI activity.
  *
- * @var activity_dataset_picker_data_t::dir_list
- *     @brief An array of `unichar_t *`, containing all sub-directories of
- *            ::activity_dataset_picker_data_t::pwd.
+ * @var activity_dataset_picker_data_t::listing
+ *     @brief Sub-directories of ::activity_dataset_picker_data_t::pwd.
+ * @var activity_dataset_picker_data_t::seen_version
+ *     @brief Value of ::activity_dataset_picker_listing_t::version when
+ *            ::activity_dataset_picker_data_t::chosen_option was last calculated.
  * @var activity_dataset_picker_data_t::chosen_option
  *     @brief The index of the sub-directory the cursor of the directory picker is currently on.
+ * @var activity_dataset_picker_data_t::chosen_name
+ *     @brief Name of the sub-directory the cursor is on, so that the cursor can follow it when more
+ *            directories are listed. `NULL` if there's no sub-directory.
  * @var activity_dataset_picker_data_t::action
  *     @brief Set when leaving the activity, to signal what the user desires to do next.
  * @var activity_dataset_picker_data_t::pwd
@@ -62,13 +364,75 @@ typedef enum {
  *     @brief Length of ::activity_dataset_picker_data_t::pwd.
  */
 typedef struct {
-    GPtrArray                       *dir_list;
-    size_t                           chosen_option;
-    activity_dataset_picker_action_t action;
-    unichar_t                       *pwd;
-    size_t                           pwd_len;
+    activity_dataset_picker_listing_t *listing;
+    size_t                             seen_version;
+    size_t                             chosen_option;
+    char                              *chosen_name;
+    activity_dataset_picker_action_t   action;
+    unichar_t                         *pwd;
+    size_t                             pwd_len;
 } activity_dataset_picker_data_t;
 
+/**
+ * @brief   Keeps the cursor on the same sub-directory after more sub-directories are listed.
+ * @details Must be called with the lock of the picker's listing held.
+ * @param   picker Dataset picker to be updated.
+ */
+void __activity_dataset_picker_follow_chosen(activity_dataset_picker_data_t *picker) {
+    GArray *const entries = picker->listing->entries;
+    if (picker->seen_version != picker->listing->version && picker->chosen_name) {
+        const activity_dataset_picker_entry_t key = {.name = picker->chosen_name};
+
+        /* ".." isn't sorted with the other entries */
+        const size_t first =
+            entries->len && strcmp(g_array_index(entries, activity_dataset_picker_entry_t, 0).name,
+                                   "..") == 0;
+        if (first && strcmp(picker->chosen_name, "..") == 0) {
+            picker->chosen_option = 0;
+        } else {
+            const activity_dataset_picker_entry_t *const found =
+                bsearch(&key,
+                        entries->data + first * sizeof(activity_dataset_picker_entry_t),
+                        entries->len - first,
+                        sizeof(activity_dataset_picker_entry_t),
+                        __activity_dataset_picker_entry_compare);
+            if (found)
+                picker->chosen_option = found - (activity_dataset_picker_entry_t *) entries->data;
+        }
+    }
+    picker->seen_version = picker->listing->version;
+
+    if (picker->chosen_option >= entries->len)
+        picker->chosen_option = entries->len ? entries->len - 1 : 0;
+
+    if (entries->len && !picker->chosen_name) {
+        picker->chosen_name = g_strdup(
+            g_array_index(entries, activity_dataset_picker_entry_t, picker->chosen_option).name);
+    }
+}
+
+/**
+ * @brief Moves the cursor of a dataset picker.
+ *
+ * @param picker Dataset picker to be updated.
+ * @param delta  Number of entries to move the cursor by.
+ */
+void __activity_dataset_picker_move(activity_dataset_picker_data_t *picker, ssize_t delta) {
+    pthread_mutex_lock(&picker->listing->lock);
+    __activity_dataset_picker_follow_chosen(picker);
+
+    GArray *const entries = picker->listing->entries;
+    if (entries->len) {
+        picker->chosen_option = max(0, (ssize_t) picker->chosen_option + delta);
+        picker->chosen_option = min(entries->len - 1, picker->chosen_option);
+
+        g_free(picker->chosen_name);
+        picker->chosen_name = g_strdup(
+            g_array_index(entries, activity_dataset_picker_entry_t, picker->chosen_option).name);
+    }
+    pthread_mutex_unlock(&picker->listing->lock);
+}
+
 /**
  * @brief Responds to user input in a dataset picker activity.
  *
@@ -90,31 +454,37 @@ int __activity_dataset_picker_keypress(void *activity_data, wint_t key, int is_k
                 picker->action = ACTIVITY_DATASET_PICKER_ACTION_ESCAPE;
                 return 1;
             case '\n':
+                if (!picker->chosen_name) /* Nothing has been listed yet */
+                    return 0;
                 picker->action = ACTIVITY_DATASET_PICKER_ACTION_CHOOSE_DIR;
                 return 1;
             case 't':
             case 'T':
                 picker->action = ACTIVITY_DATASET_PICKER_ACTION_TYPE_DIR;
                 return 1;
+            case 'r':
+            case 'R':
+                picker->action = ACTIVITY_DATASET_PICKER_ACTION_RELOAD_DIR;
+                return 1;
             default:
                 return 0;
         }
     } else {
         switch (key) {
             case KEY_UP:
-                picker->chosen_option = max(0, (ssize_t) picker->chosen_option - 1);
+                __activity_dataset_picker_move(picker, -1);
                 break;
             case KEY_DOWN:
-                picker->chosen_option = min(picker->dir_list->len - 1, picker->chosen_option + 1);
+                __activity_dataset_picker_move(picker, 1);
                 break;
             case KEY_RIGHT:
+                if (!picker->chosen_name)
+                    break;
                 picker->action = ACTIVITY_DATASET_PICKER_ACTION_VISIT_DIR;
                 return 1;
             case KEY_LEFT:
                 if (!(picker->pwd[0] == '/' && picker->pwd[1] == '\0')) {
-                    /* Choose .. and leave */
-                    picker->chosen_option = 0;
-                    picker->action        = ACTIVITY_DATASET_PICKER_ACTION_VISIT_DIR;
+                    picker->action = ACTIVITY_DATASET_PICKER_ACTION_PARENT_DIR;
                     return 1;
                 }
                 break;
@@ -127,7 +497,7 @@ int __activity_dataset_picker_keypress(void *activity_data, wint_t key, int is_k
 }
 
 /** @brief Number of help lines rendered by ::__activity_dataset_picker_render_help_text. */
-#define ACTIVITY_DATASET_PICKER_HELP_TEXT_LINE_COUNT 6
+#define ACTIVITY_DATASET_PICKER_HELP_TEXT_LINE_COUNT 7
 
 /**
  * @brief Renders help messages in the bottom of the screen.
@@ -135,14 +505,16 @@ int __activity_dataset_picker_keypress(void *activity_data, wint_t key, int is_k
  * @param window_height Window height set by `getmaxyx`.
  */
 void __activity_dataset_picker_render_help_text(int window_width, int window_height) {
-    const char *const help_strings[] = {"Use \u2191 and \u2193 to cycle through directories",
-                                        "Use \u2192 to visit the selected directory",
-                                        "Use \u2190 to go back",
-                                        "Use T to type the name of a directory",
-                                        "Use ESC to leave the dataset picker",
-                                        "Use Return to load the selected dataset"};
-
-    for (size_t i = 0; i < 6; ++i) {
+    const char *const help_strings[ACTIVITY_DATASET_PICKER_HELP_TEXT_LINE_COUNT] = {
+        "Use \u2191 and \u2193 to cycle through directories",
+        "Use \u2192 to visit the selected directory",
+        "Use \u2190 to go back",
+        "Use T to type the name of a directory",
+        "Use R to list the directory again",
+        "Use ESC to leave the dataset picker",
+        "Use Return to load the selected dataset"};
+
+    for (size_t i = 0; i < ACTIVITY_DATASET_PICKER_HELP_TEXT_LINE_COUNT; ++i) {
         const int width = min((int) ncurses_measure_string(help_strings[i]), window_width - 4);
         move(window_height - ACTIVITY_DATASET_PICKER_HELP_TEXT_LINE_COUNT - 1 + i,
              (window_width - width) / 2);
@@ -151,7 +523,8 @@ void __activity_dataset_picker_render_help_text(int window_width, int window_hei
 }
 
 /**
- * @brief Renders the files in the current directory and the box that contains them.
+ * @brief   Renders the files in the current directory and the box that contains them.
+ * @details Must be called with the lock of the picker's listing held.
  *
  * @param picker        Information about the dataset picker.
  * @param window_width  Window width set by `getmaxyx`.
@@ -176,11 +549,24 @@ void __activity_dataset_picker_render_file_box(const activity_dataset_picker_dat
     move(box_y - 1, box_x + 1);
     ncurses_put_wide_string(picker->pwd + picker->pwd_len - pwd_print_len, (size_t) -1);
 
+    /* Render listing status */
+    const activity_dataset_picker_listing_t *const listing = picker->listing;
+    const char *const status = listing->failed     ? "Error listing directory!"
+                               : !listing->listed   ? "Listing ..."
+                               : !listing->complete ? "Looking for datasets ..."
+                                                    : NULL;
+    if (status) {
+        const int width = min((int) strlen(status), box_width - 2);
+        move(box_y + box_height, box_x + box_width - width - 1);
+        addnstr(status, width);
+    }
+
     /* Render files */
+    const GArray *const entries = listing->entries;
     const ssize_t i0_y  = box_y + (box_height) / 2 - picker->chosen_option; /* Y coord. for i = 0 */
     const size_t  i_min = max(0, (ssize_t) picker->chosen_option - (box_height) / 2);
     const size_t  complement_box_height = box_height % 2 ? (box_height / 2 + 1) : (box_height / 2);
-    const size_t  i_max = min(picker->dir_list->len, picker->chosen_option + complement_box_height);
+    const size_t  i_max = min(entries->len, picker->chosen_option + complement_box_height);
 
     for (size_t i = i_min; i < i_max; ++i) {
         move(i0_y + i, box_x + 1);
@@ -195,10 +581,16 @@ void __activity_dataset_picker_render_file_box(const activity_dataset_picker_dat
             attroff(A_REVERSE);
         }
 
-        const unichar_t *const dirname = g_ptr_array_index(picker->dir_list, i);
-        const size_t           drawable_chars =
-            ncurses_prefix_from_maximum_length(dirname, box_width - 2, NULL);
-        ncurses_put_wide_string(dirname, drawable_chars);
+        /* Datasets are highlighted */
+        const activity_dataset_picker_entry_t *const entry =
+            &g_array_index(entries, activity_dataset_picker_entry_t, i);
+        if (entry->is_dataset)
+            attron(A_BOLD);
+
+        const size_t drawable_chars =
+            ncurses_prefix_from_maximum_length(entry->display_name, box_width - 2, NULL);
+        ncurses_put_wide_string(entry->display_name, drawable_chars);
+        attroff(A_BOLD);
     }
     attroff(A_REVERSE);
 }
@@ -209,95 +601,57 @@ void __activity_dataset_picker_render_file_box(const activity_dataset_picker_dat
  * @retval 0 Always, to continue running this activity.
  */
 int __activity_dataset_picker_render(void *activity_data) {
-    const activity_dataset_picker_data_t *const picker = activity_data;
+    activity_dataset_picker_data_t *const picker = activity_data;
 
     int window_width, window_height;
     getmaxyx(stdscr, window_height, window_width);
 
-    if (window_width < 44 || window_height < 14)
-        return 0;
+    pthread_mutex_lock(&picker->listing->lock);
+    __activity_dataset_picker_follow_chosen(picker);
+    if (window_width >= 44 && window_height >= 15)
+        __activity_dataset_picker_render_file_box(picker, window_width, window_height);
+    pthread_mutex_unlock(&picker->listing->lock);
 
-    __activity_dataset_picker_render_file_box(picker, window_width, window_height);
-    __activity_dataset_picker_render_help_text(window_width, window_height);
+    if (window_width >= 44 && window_height >= 15)
+        __activity_dataset_picker_render_help_text(window_width, window_height);
     return 0;
 }
 
 /**
- * @brief Frees a textbox activity, generated by ::__activity_dataset_picker_create.
- * @param activity_data Pointer to an ::activity_dataset_picker_data_t.
+ * @brief   Frees a dataset picker activity, generated by ::__activity_dataset_picker_create.
+ * @details The listing is kept, as it's owned by the cache of listings.
+ * @param   activity_data Pointer to an ::activity_dataset_picker_data_t.
  */
 void __activity_dataset_picker_free_data(void *activity_data) {
     activity_dataset_picker_data_t *const picker = activity_data;
-    g_ptr_array_unref(picker->dir_list);
+    g_free(picker->chosen_name);
     g_free(picker->pwd);
     free(picker);
 }
 
-/**
- * @brief   `GCompareFunc` for UTF-32 strings.
- * @details Both @p a and @p b are of type `const unichar_t **`. This is an auxiliary function for
- *          ::__activity_dataset_picker_create.
- * @return  The equivalent of `strcmp(a, b)` for UTF-32 strings.
- * */
-gint __activity_dataset_picker_create_sort_strings_compare(gconstpointer a, gconstpointer b) {
-    const unichar_t *const string_a = *(const unichar_t *const *) a;
-    const unichar_t *const string_b = *(const unichar_t *const *) b;
-
-    size_t i;
-    for (i = 0; string_a[i] && string_b[i]; ++i)
-        if (string_a[0] != string_b[0])
-            break;
-    return string_a[i] - string_b[i];
-}
-
 /**
  * @brief   Creates an ::activity_t for a dataset picker.
  * @details Auxiliary method for ::activity_dataset_picker_run.
  *
- * @param path Path of the directory to list.
+ * @param path    Path of the directory to list.
+ * @param listing Listing of @p path (not owned by the activity).
  *
  * @return An ::activity_t for a dataset picker, that must be deleted using ::activity_free.
  *         `NULL` is also a possibility, when an allocation failure occurs.
  */
-activity_t *__activity_dataset_picker_create(const char *path) {
+activity_t *__activity_dataset_picker_create(const char                        *path,
+                                             activity_dataset_picker_listing_t *listing) {
     activity_dataset_picker_data_t *const activity_data =
         malloc(sizeof(activity_dataset_picker_data_t));
     if (!activity_data)
         return NULL;
 
-    glong pwd_len;
-    activity_data->dir_list      = g_ptr_array_new_with_free_func(g_free);
+    activity_data->listing       = listing;
+    activity_data->seen_version  = 0;
     activity_data->chosen_option = 0;
+    activity_data->chosen_name   = NULL;
     activity_data->action        = ACTIVITY_DATASET_PICKER_ACTION_VISIT_DIR;
-    activity_data->pwd           = g_utf8_to_ucs4_fast(path, -1, &pwd_len);
-    activity_data->pwd_len       = pwd_len;
-
-    /* Load list of directories */
-    DIR *const dir = opendir(path);
-    if (!dir) {
-        activity_messagebox_run("Error listing directory!");
-        __activity_dataset_picker_free_data(activity_data);
-        return NULL;
-    }
-
-    struct dirent *ent;
-    while ((ent = readdir(dir)) != NULL) {
-        /* Hide hidden files except "..". Always hide ".." on the root of the file system. */
-        if (*ent->d_name != '.' || (strcmp(ent->d_name, "..") == 0 && strcmp(path, "/") != 0)) {
-            char full_path[PATH_MAX];
-            snprintf(full_path, PATH_MAX, "%s/%s", path, ent->d_name);
-
-            struct stat statbuf; /* Only show directories */
-            if (!stat(full_path, &statbuf) && S_ISDIR(statbuf.st_mode)) {
-                g_ptr_array_add(activity_data->dir_list,
-                                g_utf8_to_ucs4_fast(ent->d_name, -1, NULL));
-            }
-        }
-    }
-    closedir(dir);
-
-    g_ptr_array_sort(activity_data->dir_list,
-                     __activity_dataset_picker_create_sort_strings_compare);
+    activity_data->pwd           = ncurses_utf8_to_unicode(path, &activity_data->pwd_len);
 
     activity_t *const ret = activity_create(__activity_dataset_picker_keypress,
                                             __activity_dataset_picker_render,
@@ -340,29 +694,58 @@ char *activity_dataset_picker_run(void) {
         strcpy(pwd, "/");
     }
 
+    /* Listings are owned by the cache, and keyed by their own paths */
+    GHashTable *const cache = g_hash_table_new_full(g_str_hash,
+                                                    g_str_equal,
+                                                    NULL,
+                                                    __activity_dataset_picker_listing_free);
+    char *ret = NULL;
+
     while (1) {
-        activity_t *const activity = __activity_dataset_picker_create(pwd);
+        activity_dataset_picker_listing_t *const listing =
+            __activity_dataset_picker_get_listing(cache, pwd);
+        if (!listing) {
+            activity_messagebox_run("Error listing directory!");
+            break;
+        }
+
+        activity_t *const activity = __activity_dataset_picker_create(pwd, listing);
         if (!activity)
-            return NULL;
+            break;
 
-        const activity_dataset_picker_data_t *const picker = activity_run(activity);
+        const activity_dataset_picker_data_t *const picker =
+            activity_run_refreshing(activity, ACTIVITY_DATASET_PICKER_REFRESH_INTERVAL);
 
-        const unichar_t *const chosen_utf32 =
-            (const unichar_t *) g_ptr_array_index(picker->dir_list, picker->chosen_option);
-        gchar *const chosen = g_ucs4_to_utf8(chosen_utf32, -1, NULL, NULL, NULL);
-        activity_dataset_picker_action_t action = picker->action;
+        gchar *const                           chosen = g_strdup(picker->chosen_name);
+        const activity_dataset_picker_action_t action = picker->action;
         activity_free(activity);
 
-        if (action == ACTIVITY_DATASET_PICKER_ACTION_TYPE_DIR)
-            __activity_dataset_picker_run_textbox(pwd);
-        else
-            path_concat(pwd, chosen);
-
+        switch (action) {
+            case ACTIVITY_DATASET_PICKER_ACTION_TYPE_DIR:
+                __activity_dataset_picker_run_textbox(pwd);
+                break;
+            case ACTIVITY_DATASET_PICKER_ACTION_RELOAD_DIR:
+                g_hash_table_remove(cache, pwd);
+                break;
+            case ACTIVITY_DATASET_PICKER_ACTION_PARENT_DIR:
+                path_concat(pwd, "..");
+                break;
+            case ACTIVITY_DATASET_PICKER_ACTION_ESCAPE:
+                break;
+            default:
+                path_concat(pwd, chosen);
+                break;
+        }
         g_free(chosen);
 
-        if (action == ACTIVITY_DATASET_PICKER_ACTION_ESCAPE)
-            return NULL;
-        else if (action == ACTIVITY_DATASET_PICKER_ACTION_CHOOSE_DIR)
-            return strdup(pwd);
+        if (action == ACTIVITY_DATASET_PICKER_ACTION_ESCAPE) {
+            break;
+        } else if (action == ACTIVITY_DATASET_PICKER_ACTION_CHOOSE_DIR) {
+            ret = strdup(pwd);
+            break;
+        }
     }
+
+    g_hash_table_unref(cache);
+    return ret;
 }
@@ -27,8 +27,12 @@
 #include "interactive_mode/activity_menu.h"
 
 activity_main_menu_chosen_option_t activity_main_menu_run(void) {
-    const char *const menu_options[] = {"Load dataset", "Run query", "License", "Leave"};
-    const ssize_t     menu_return    = activity_menu_run("MAIN MENU", 4, menu_options);
+    const char *const menu_options[] = {"Load dataset",
+                                        "Run query",
+                                        "Run query file",
+                                        "License",
+                                        "Leave"};
+    const ssize_t     menu_return    = activity_menu_run("MAIN MENU", 5, menu_options);
 
     switch (menu_return) {
         case 0:
@@ -36,8 +40,10 @@ activity_main_menu_chosen_option_t activity_main_menu_run(void) {
         case 1:
             return ACTIVITY_MAIN_MENU_RUN_QUERY;
         case 2:
-            return ACTIVITY_MAIN_MENU_LICENSE;
+            return ACTIVITY_MAIN_MENU_RUN_QUERY_FILE;
         case 3:
+            return ACTIVITY_MAIN_MENU_LICENSE;
+        case 4:
             return ACTIVITY_MAIN_MENU_LEAVE;
         default:
             return ACTIVITY_MAIN_MENU_LEAVE; /* Leave on error */
@@ -171,14 +171,14 @@ activity_t *
 
     size_t max_width = 0;
     for (size_t i = 0; i < n; i++) {
-        activity_data->options[i] = g_utf8_to_ucs4_fast(screen_options[i], -1, NULL);
+        activity_data->options[i] = ncurses_utf8_to_unicode(screen_options[i], NULL);
 
         const size_t string_size = ncurses_measure_unicode_string(activity_data->options[i]);
         if (string_size > max_width)
             max_width = string_size;
     }
 
-    activity_data->title    = g_utf8_to_ucs4_fast(title, -1, NULL);
+    activity_data->title    = ncurses_utf8_to_unicode(title, NULL);
     const size_t title_size = ncurses_measure_unicode_string(activity_data->title);
     if (title_size > max_width)
         max_width = title_size;
@@ -123,7 +123,7 @@ activity_t *__activity_messagebox_create(const char *message) {
     if (!activity_data)
         return NULL;
 
-    activity_data->message    = g_utf8_to_ucs4_fast(message, -1, NULL);
+    activity_data->message    = ncurses_utf8_to_unicode(message, NULL);
     activity_data->text_width = ncurses_measure_unicode_string(activity_data->message);
 
     activity_t *const ret = activity_create(__activity_messagebox_keypress,
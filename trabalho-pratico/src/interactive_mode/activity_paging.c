@@ -31,6 +31,9 @@
 #include "interactive_mode/ncurses_utils.h"
 #include "utils/int_utils.h"
 
+/** @brief Time between renders of a paginator whose lines are still being generated (in ms). */
+#define ACTIVITY_PAGING_REFRESH_INTERVAL 100
+
 /** @brief An action performed in the paginator. */
 typedef enum {
     ACTIVITY_PAGING_ACTION_NEXT_PAGE,     /**< @brief Move to the next page */
@@ -42,10 +45,40 @@ typedef enum {
  * @struct activity_paging_data_t
  * @brief  Data in a paging TUI activity.
  *
- * @var activity_paging_data_t::lines
- *     @brief An array of null-terminated UTF-32 lines.
+ * @var activity_paging_data_t::get_line
+ *     @brief Method called to get each line to be displayed.
+ * @var activity_paging_data_t::source_data
+ *     @brief Pointer passed to ::activity_paging_data_t::get_line.
+ * @var activity_paging_data_t::get_count
+ *     @brief Method called to get the number of lines, while they're still being generated. `NULL`
+ *            when that number is fixed.
  * @var activity_paging_data_t::lines_length
- *     @brief The number of lines in ::activity_paging_data_t::lines.
+ *     @brief The number of lines that can be obtained with ::activity_paging_data_t::get_line.
+ * @var activity_paging_data_t::complete
+ *     @brief Whether all lines have been generated.
+ * @var activity_paging_data_t::blocking
+ *     @brief If text blocks should be considered in page separation.
+ * @var activity_paging_data_t::block_known
+ *     @brief Whether ::activity_paging_data_t::block_length has been determined. While it hasn't,
+ *            pages aren't broken by blocks.
+ * @var activity_paging_data_t::block_scanned
+ *     @brief Number of lines already looked at to determine ::activity_paging_data_t::block_length.
+ * @var activity_paging_data_t::page_lines
+ *     @brief Null-terminated UTF-32 versions of the lines in the current page. Only the lines being
+ *            displayed are converted.
+ * @var activity_paging_data_t::page_start
+ *     @brief Index of the first line in ::activity_paging_data_t::page_lines.
+ * @var activity_paging_data_t::page_length
+ *     @brief Number of lines in ::activity_paging_data_t::page_lines.
+ * @var activity_paging_data_t::page_capacity
+ *     @brief Number of lines ::activity_paging_data_t::page_lines can hold without growing.
+ * @var activity_paging_data_t::page_fit_chars
+ *     @brief Number of characters of each line in ::activity_paging_data_t::page_lines that fit in
+ *            ::activity_paging_data_t::page_fit_width columns, so that lines aren't measured again
+ *            on every render.
+ * @var activity_paging_data_t::page_fit_width
+ *     @brief Width ::activity_paging_data_t::page_fit_chars was calculated for. `-1` if it needs to
+ *            be calculated.
  * @var activity_paging_data_t::block_length
  *     @brief The number of lines in a block.
  * @var activity_paging_data_t::page_reference_index
@@ -56,8 +89,17 @@ typedef enum {
  *     @brief Title of the activity.
  */
 typedef struct {
-    unichar_t **lines;
-    size_t      lines_length, block_length;
+    activity_paging_source_t get_line;
+    activity_paging_count_t  get_count;
+    void                    *source_data;
+    size_t                   lines_length, block_length;
+    int                      complete, blocking, block_known;
+    size_t                   block_scanned;
+
+    unichar_t **page_lines;
+    size_t      page_start, page_length, page_capacity;
+    size_t     *page_fit_chars;
+    int         page_fit_width;
 
     size_t                   page_reference_index;
     activity_paging_action_t change_page;
@@ -103,6 +145,103 @@ int __activity_paging_keypress(void *activity_data, wint_t key, int is_key_code)
     return 0;
 }
 
+/**
+ * @brief Frees the UTF-32 lines of the page being displayed.
+ * @param paging Paging activity whose ::activity_paging_data_t::page_lines are to be `free`d.
+ */
+void __activity_paging_clear_page(activity_paging_data_t *paging) {
+    for (size_t i = 0; i < paging->page_length; i++)
+        g_free(paging->page_lines[i]);
+    paging->page_length = 0;
+}
+
+/**
+ * @brief   Converts the lines of the page to be displayed to UTF-32.
+ * @details Nothing is done if the requested lines are the ones already converted.
+ *
+ * @param paging Paging activity to be modified.
+ * @param start  Index of the first line in the page.
+ * @param end    Index after the last line in the page.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __activity_paging_load_page(activity_paging_data_t *paging, size_t start, size_t end) {
+    if (paging->page_start == start && paging->page_length == end - start)
+        return 0;
+
+    __activity_paging_clear_page(paging);
+    paging->page_fit_width = -1;
+    if (end - start > paging->page_capacity) {
+        unichar_t **const new_lines =
+            realloc(paging->page_lines, (end - start) * sizeof(unichar_t *));
+        if (!new_lines)
+            return 1;
+        paging->page_lines = new_lines;
+
+        size_t *const new_fit_chars =
+            realloc(paging->page_fit_chars, (end - start) * sizeof(size_t));
+        if (!new_fit_chars)
+            return 1;
+        paging->page_fit_chars = new_fit_chars;
+
+        paging->page_capacity = end - start;
+    }
+
+    paging->page_start = start;
+    for (size_t i = start; i < end; i++) {
+        const char *const line = paging->get_line(paging->source_data, i);
+        paging->page_lines[paging->page_length++] = ncurses_utf8_to_unicode(line, NULL);
+    }
+    return 0;
+}
+
+/**
+ * @brief   Measures how much of each line of the page being displayed fits on the screen.
+ * @details Nothing is done if the lines were already measured for the same width.
+ *
+ * @param paging Paging activity to be modified.
+ * @param width  Number of columns available for each line.
+ */
+void __activity_paging_fit_page(activity_paging_data_t *paging, int width) {
+    if (paging->page_fit_width == width)
+        return;
+
+    for (size_t i = 0; i < paging->page_length; i++)
+        paging->page_fit_chars[i] =
+            ncurses_prefix_from_maximum_length(paging->page_lines[i], width, NULL);
+    paging->page_fit_width = width;
+}
+
+/**
+ * @brief   Updates the number of lines in a paging activity and the size of its blocks.
+ * @details The size of a block is determined from the position of the first empty line, which may
+ *          not have been generated yet.
+ *
+ * @param paging Paging activity to be updated.
+ */
+void __activity_paging_update_length(activity_paging_data_t *paging) {
+    if (paging->get_count)
+        paging->lines_length = paging->get_count(paging->source_data, &paging->complete);
+
+    for (; !paging->block_known && paging->block_scanned < paging->lines_length;
+         paging->block_scanned++) {
+
+        if (!paging->blocking) {
+            paging->block_length = 1;
+            paging->block_known  = 1;
+        } else if (!*paging->get_line(paging->source_data, paging->block_scanned)) {
+            paging->block_length = paging->block_scanned + 1;
+            paging->block_known  = 1;
+        }
+    }
+
+    if (!paging->block_known && paging->complete) {
+        paging->block_length = max(paging->lines_length, 1); /* All text is a single block */
+        paging->block_known  = 1;
+    }
+}
+
 /**
  * @brief  Renders a paging activity.
  * @param  activity_data Pointer to an ::activity_paging_data_t.
@@ -110,6 +249,7 @@ int __activity_paging_keypress(void *activity_data, wint_t key, int is_key_code)
  */
 int __activity_paging_render(void *activity_data) {
     activity_paging_data_t *const paging = activity_data;
+    __activity_paging_update_length(paging);
 
     int window_width, window_height;
     getmaxyx(stdscr, window_height, window_width);
@@ -133,6 +273,14 @@ int __activity_paging_render(void *activity_data) {
     move(menu_y - 1, menu_x + (menu_width - title_width) / 2);
     ncurses_put_wide_string(paging->title, title_max_chars);
 
+    if (!paging->complete) {
+        move(menu_y + menu_height - 1, menu_x + 1);
+        printw("Query running. Press ESC to cancel.");
+    }
+
+    if (paging->lines_length == 0)
+        return 0; /* Nothing to show yet */
+
     /*
      * Handle page changes. This is done here because only the renderer known about screen
      * dimensions.
@@ -149,16 +297,22 @@ int __activity_paging_render(void *activity_data) {
         page_number--;
     }
     paging->page_reference_index = page_number * max_on_screen_lines;
+    paging->change_page          = ACTIVITY_PAGING_ACTION_KEEP; /* Don't repeat on refreshes */
 
     /* Prints paging information if there's more than one page. */
     if (max_page_number != 0) {
         move(menu_y + menu_height - 1, menu_x + 1);
-        if (page_number <= max_page_number) {
+        if (page_number <= max_page_number && paging->complete) {
             printw("Use the \u2190 and \u2192 to navigate");
         }
 
         char         ratio[256];
-        const size_t len = snprintf(ratio, 256, "%zu / %zu", page_number + 1, max_page_number + 1);
+        const size_t len = snprintf(ratio,
+                                    256,
+                                    "%zu / %zu%s",
+                                    page_number + 1,
+                                    max_page_number + 1,
+                                    paging->complete ? "" : "+");
         move(menu_y + menu_height - 1, menu_x + menu_width - len - 1);
         printw("%s", ratio);
     }
@@ -166,6 +320,11 @@ int __activity_paging_render(void *activity_data) {
     /* Prints the blocks of lines that fit in the current page */
     const size_t lines_until_end_of_current_page =
         min((page_number + 1) * max_on_screen_lines, paging->lines_length);
+    if (__activity_paging_load_page(paging,
+                                    paging->page_reference_index,
+                                    lines_until_end_of_current_page))
+        return 0; /* Allocation failure: don't render any lines */
+    __activity_paging_fit_page(paging, max(menu_width - 3, 0));
 
     int text_y = menu_y;
     for (size_t i = paging->page_reference_index;
@@ -179,10 +338,9 @@ int __activity_paging_render(void *activity_data) {
             if (i + j >= paging->lines_length)
                 return 0; /* Reached end of text */
 
-            const size_t line_max_chars = ncurses_prefix_from_maximum_length(paging->lines[i + j],
-                                                                             max(menu_width - 3, 0),
-                                                                             NULL);
-            ncurses_put_wide_string(paging->lines[i + j], line_max_chars);
+            const size_t page_index = i + j - paging->page_start;
+            ncurses_put_wide_string(paging->page_lines[page_index],
+                                    paging->page_fit_chars[page_index]);
         }
     }
 
@@ -195,9 +353,9 @@ int __activity_paging_render(void *activity_data) {
  */
 void __activity_paging_free_data(void *activity_data) {
     activity_paging_data_t *const paging = activity_data;
-    for (size_t i = 0; i < paging->lines_length; i++)
-        g_free(paging->lines[i]);
-    free(paging->lines);
+    __activity_paging_clear_page(paging);
+    free(paging->page_lines);
+    free(paging->page_fit_chars);
     g_free(paging->title);
     free(paging);
 }
@@ -205,37 +363,46 @@ void __activity_paging_free_data(void *activity_data) {
 /**
  * @brief Creates an ::activity_t for a paginator.
  *
- * @param n            The number of @p lines.
- * @param lines        The lines of output be shown on the screen.
- * @param block_length The number of lines in an unbreakable block (include empty line).
- * @param title        The title of the activity.
+ * @param n           The number of lines (ignored if @p get_count isn't `NULL`).
+ * @param get_count   Method called to get the number of lines, while they're being generated. Can
+ *                    be `NULL`, for @p n lines.
+ * @param get_line    Method called to get each line to be shown on the screen.
+ * @param source_data Pointer passed to @p get_line and @p get_count.
+ * @param blocking    If text blocks should be considered in page separation.
+ * @param title       The title of the activity.
  *
  * @return  An ::activity_t for a paginator, that must be deleted using ::activity_free. `NULL` is
  *          also a possibility, when an allocation failure occurs.
  */
-activity_t *__activity_paging_create(size_t            n,
-                                     const char *const lines[n],
-                                     size_t            block_length,
-                                     const char       *title) {
+activity_t *__activity_paging_create(size_t                   n,
+                                     activity_paging_count_t  get_count,
+                                     activity_paging_source_t get_line,
+                                     void                    *source_data,
+                                     int                      blocking,
+                                     const char              *title) {
 
     activity_paging_data_t *const activity_data = malloc(sizeof(activity_paging_data_t));
     if (!activity_data)
         return NULL;
 
-    activity_data->lines = malloc(n * sizeof(unichar_t *));
-    if (!activity_data->lines) {
-        free(activity_data);
-        return NULL;
-    }
-
-    for (size_t i = 0; i < n; i++)
-        activity_data->lines[i] = g_utf8_to_ucs4_fast(lines[i], -1, NULL);
-
+    activity_data->get_line             = get_line;
+    activity_data->get_count            = get_count;
+    activity_data->source_data          = source_data;
+    activity_data->complete             = !get_count;
+    activity_data->blocking             = blocking;
+    activity_data->block_known          = 0;
+    activity_data->block_scanned        = 0;
+    activity_data->page_lines           = NULL;
+    activity_data->page_fit_chars       = NULL;
+    activity_data->page_fit_width       = -1;
+    activity_data->page_start           = 0;
+    activity_data->page_length          = 0;
+    activity_data->page_capacity        = 0;
     activity_data->lines_length         = n;
-    activity_data->block_length         = block_length;
+    activity_data->block_length         = 1;
     activity_data->page_reference_index = 0;
     activity_data->change_page          = ACTIVITY_PAGING_ACTION_KEEP;
-    activity_data->title                = g_utf8_to_ucs4_fast(title, -1, NULL);
+    activity_data->title                = ncurses_utf8_to_unicode(title, NULL);
 
     activity_t *const ret = activity_create(__activity_paging_keypress,
                                             __activity_paging_render,
@@ -248,30 +415,59 @@ activity_t *__activity_paging_create(size_t            n,
     return ret;
 }
 
-int activity_paging_run(size_t n, const char *const lines[n], int blocking, const char *title) {
-    const char *const single_empty_line[] = {""};
-    if (n == 0) { /* Simplify edge case */
-        lines = single_empty_line;
-        n     = 1;
-    }
+/**
+ * @struct activity_paging_array_source_t
+ * @brief  Source of lines for ::activity_paging_run.
+ *
+ * @var activity_paging_array_source_t::lines
+ *     @brief Array of lines to be displayed.
+ */
+typedef struct {
+    const char *const *lines;
+} activity_paging_array_source_t;
 
-    /* Automatically determine block size */
-    size_t block_length = 0;
-    if (blocking) {
-        for (size_t i = 0; i < n; ++i) {
-            if (!*lines[i]) {
-                block_length = i + 1;
-                break;
-            }
-        }
+/**
+ * @brief   Gets a line from an array of lines.
+ * @details Used as an ::activity_paging_source_t by ::activity_paging_run.
+ *
+ * @param source_data Pointer to an ::activity_paging_array_source_t.
+ * @param i           Index of the line to get.
+ *
+ * @return The @p i-th line in @p source_data.
+ */
+const char *__activity_paging_array_get_line(void *source_data, size_t i) {
+    const activity_paging_array_source_t *const source = source_data;
+    return source->lines[i];
+}
 
-        if (block_length == 0)
-            block_length = n; /* All text is a single block */
-    } else {
-        block_length = 1;
+/**
+ * @brief   Gets the only line of an empty output.
+ * @details Used as an ::activity_paging_source_t to simplify the edge case of no lines.
+ *
+ * @param source_data Ignored.
+ * @param i           Ignored.
+ *
+ * @return An empty string.
+ */
+const char *__activity_paging_empty_get_line(void *source_data, size_t i) {
+    (void) source_data;
+    (void) i;
+    return "";
+}
+
+int activity_paging_run_source(size_t                   n,
+                               activity_paging_source_t get_line,
+                               void                    *source_data,
+                               int                      blocking,
+                               const char              *title) {
+    if (n == 0) { /* Simplify edge case */
+        get_line = __activity_paging_empty_get_line;
+        n        = 1;
     }
 
-    activity_t *const activity = __activity_paging_create(n, lines, block_length, title);
+    /* Block size is automatically determined, only pulling lines until the end of the first one */
+    activity_t *const activity =
+        __activity_paging_create(n, NULL, get_line, source_data, blocking, title);
     if (!activity)
         return 1;
 
@@ -279,3 +475,27 @@ int activity_paging_run(size_t n, const char *const lines[n], int blocking, cons
     activity_free(activity);
     return 0;
 }
+
+int activity_paging_run_stream(activity_paging_count_t  get_count,
+                               activity_paging_source_t get_line,
+                               void                    *source_data,
+                               int                      blocking,
+                               const char              *title) {
+    activity_t *const activity =
+        __activity_paging_create(0, get_count, get_line, source_data, blocking, title);
+    if (!activity)
+        return 1;
+
+    activity_run_refreshing(activity, ACTIVITY_PAGING_REFRESH_INTERVAL);
+    activity_free(activity);
+    return 0;
+}
+
+int activity_paging_run(size_t n, const char *const lines[n], int blocking, const char *title) {
+    activity_paging_array_source_t source = {.lines = lines};
+    return activity_paging_run_source(n,
+                                      __activity_paging_array_get_line,
+                                      &source,
+                                      blocking,
+                                      title);
+}
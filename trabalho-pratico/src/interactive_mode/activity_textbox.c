@@ -48,6 +48,14 @@
  * @var activity_textbox_data_t::action_cancelled
  *     @brief Whether the user left the textbox by pressing return (`0`) or by pressing escape
  *            (`1`).
+ * @var activity_textbox_data_t::completion
+ *     @brief Method that suggests completions for the input. `NULL` for no suggestions.
+ * @var activity_textbox_data_t::completion_data
+ *     @brief Pointer passed to every call of ::activity_textbox_data_t::completion.
+ * @var activity_textbox_data_t::completions
+ *     @brief Null-terminated UTF-32 strings for the suggestions for the current input.
+ * @var activity_textbox_data_t::completions_count
+ *     @brief Number of elements in ::activity_textbox_data_t::completions.
  */
 typedef struct {
     GArray *input_codepoints;
@@ -57,8 +65,82 @@ typedef struct {
 
     size_t text_field_width;
     int    action_cancelled;
+
+    activity_textbox_completion_callback_t completion;
+    void                                  *completion_data;
+    unichar_t                             *completions[ACTIVITY_TEXTBOX_MAX_COMPLETIONS];
+    size_t                                 completions_count;
 } activity_textbox_data_t;
 
+/**
+ * @brief Discards the suggested completions in a textbox.
+ * @param textbox Textbox whose ::activity_textbox_data_t::completions are to be `free`d.
+ */
+void __activity_textbox_clear_completions(activity_textbox_data_t *textbox) {
+    for (size_t i = 0; i < textbox->completions_count; ++i)
+        g_free(textbox->completions[i]);
+    textbox->completions_count = 0;
+}
+
+/**
+ * @brief   Asks for new completions after the input of a textbox changes.
+ * @details On allocation failures, no completions will be shown.
+ * @param   textbox Textbox whose ::activity_textbox_data_t::completions are to be updated.
+ */
+void __activity_textbox_update_completions(activity_textbox_data_t *textbox) {
+    __activity_textbox_clear_completions(textbox);
+    if (!textbox->completion)
+        return;
+
+    gchar *const utf8 = g_ucs4_to_utf8((gunichar *) textbox->input_codepoints->data,
+                                       textbox->input_codepoints->len,
+                                       NULL,
+                                       NULL,
+                                       NULL);
+    if (!utf8)
+        return;
+
+    char        *completions[ACTIVITY_TEXTBOX_MAX_COMPLETIONS];
+    const size_t count = textbox->completion(textbox->completion_data,
+                                             utf8,
+                                             completions,
+                                             ACTIVITY_TEXTBOX_MAX_COMPLETIONS);
+    g_free(utf8);
+
+    for (size_t i = 0; i < count; ++i) {
+        unichar_t *const utf32 = ncurses_utf8_to_unicode(completions[i], NULL);
+        g_free(completions[i]);
+        if (utf32)
+            textbox->completions[textbox->completions_count++] = utf32;
+    }
+}
+
+/**
+ * @brief Replaces the last word (text after the last space) of a textbox's input with its first
+ *        suggested completion.
+ * @param textbox Textbox whose input is to be completed.
+ */
+void __activity_textbox_complete(activity_textbox_data_t *textbox) {
+    if (!textbox->completions_count)
+        return;
+
+    size_t word_start = textbox->input_codepoints->len;
+    while (word_start > 0 &&
+           g_array_index(textbox->input_codepoints, unichar_t, word_start - 1) != ' ')
+        word_start--;
+
+    for (size_t i = word_start; i < textbox->input_codepoints->len; ++i)
+        textbox->input_codepoints_width -=
+            ncurses_measure_character(g_array_index(textbox->input_codepoints, unichar_t, i));
+    g_array_set_size(textbox->input_codepoints, word_start);
+
+    const unichar_t *const completion = textbox->completions[0];
+    for (size_t i = 0; completion[i]; ++i) {
+        g_array_append_val(textbox->input_codepoints, completion[i]);
+        textbox->input_codepoints_width += ncurses_measure_character(completion[i]);
+    }
+}
+
 /**
  * @brief   Responds to user input in a textbox activity.
  * @details Adds a valid pressed character to the inputted text.
@@ -80,17 +162,24 @@ int __activity_textbox_keypress(void *activity_data, wint_t key, int is_key_code
             return 1;
         }
 
-        unichar_t key_int = key;
-        g_array_append_val(textbox->input_codepoints, key_int);
-        textbox->input_codepoints_width += ncurses_measure_character(key);
+        if (key == '\t' && textbox->completion) {
+            __activity_textbox_complete(textbox);
+        } else {
+            unichar_t key_int = key;
+            g_array_append_val(textbox->input_codepoints, key_int);
+            textbox->input_codepoints_width += ncurses_measure_character(key);
+        }
     } else if (key == KEY_BACKSPACE && textbox->input_codepoints->len > 0) {
         unichar_t last_char =
             g_array_index(textbox->input_codepoints, gunichar, textbox->input_codepoints->len - 1);
         textbox->input_codepoints_width -= ncurses_measure_character(last_char);
 
         g_array_set_size(textbox->input_codepoints, textbox->input_codepoints->len - 1);
+    } else {
+        return 0; /* Input didn't change */
     }
 
+    __activity_textbox_update_completions(textbox);
     return 0;
 }
 
@@ -105,13 +194,17 @@ int __activity_textbox_render(void *activity_data) {
     int window_width, window_height;
     getmaxyx(stdscr, window_height, window_width);
 
-    if (window_width < 8 || window_height < 9) /* Don't attempt rendering on small windows */
+    /* Room for the suggestions and an empty line below them */
+    const int completions_height = textbox->completion ? ACTIVITY_TEXTBOX_MAX_COMPLETIONS + 1 : 0;
+
+    /* Don't attempt rendering on small windows */
+    if (window_width < 8 || window_height < 9 + completions_height)
         return 0;
 
     /* Reference diagram for positions and sizes: see header file */
 
     const int textbox_width  = min((size_t) window_width - 4, textbox->text_field_width + 4);
-    const int textbox_height = 7;
+    const int textbox_height = 7 + completions_height;
     const int textbox_x      = (window_width - textbox_width) / 2;
     const int textbox_y      = (window_height - textbox_height) / 2;
 
@@ -129,15 +222,33 @@ int __activity_textbox_render(void *activity_data) {
     ncurses_render_rectangle(textbox_x + 2, textbox_y + 4, textfield_width, 1);
     move(textbox_y + 4, textbox_x + 2);
 
+    size_t       text_width;
     const size_t max_text_chars =
         ncurses_suffix_from_maximum_length((const unichar_t *) textbox->input_codepoints->data,
                                            textbox->input_codepoints->len,
                                            max(textfield_width - 1, 0),
-                                           NULL);
+                                           &text_width);
     ncurses_put_wide_string((const unichar_t *) textbox->input_codepoints->data +
                                 (textbox->input_codepoints->len - max_text_chars),
                             textbox->input_codepoints->len);
 
+    /* Render suggestions (the first one, inserted by TAB, is highlighted) */
+    for (size_t i = 0; i < textbox->completions_count; ++i) {
+        const size_t max_chars =
+            ncurses_prefix_from_maximum_length(textbox->completions[i],
+                                               max(textfield_width, 0),
+                                               NULL);
+
+        if (i == 0)
+            attron(A_BOLD);
+        move(textbox_y + 7 + i, textbox_x + 2);
+        ncurses_put_wide_string(textbox->completions[i], max_chars);
+        if (i == 0)
+            attroff(A_BOLD);
+    }
+
+    /* Leave the cursor at the end of the input */
+    move(textbox_y + 4, textbox_x + 2 + text_width);
     return 0;
 }
 
@@ -147,6 +258,7 @@ int __activity_textbox_render(void *activity_data) {
  */
 void __activity_textbox_free_data(void *activity_data) {
     activity_textbox_data_t *const textbox = activity_data;
+    __activity_textbox_clear_completions(textbox);
     g_array_unref(textbox->input_codepoints);
     g_free(textbox->title);
     free(textbox);
@@ -154,23 +266,28 @@ void __activity_textbox_free_data(void *activity_data) {
 
 /**
  * @brief   Creates an ::activity_t for a textbox.
- * @details See ::activity_textbox_run for parameter descriptions.
+ * @details See ::activity_textbox_run_with_completion for parameter descriptions.
  * @return  An ::activity_t for a textbox, that must be deleted using ::activity_free. `NULL` is
  *          also a possibility, when an allocation failure occurs.
  */
-activity_t *__activity_textbox_create(const char *title,
-                                      const char *initial_value,
-                                      size_t      text_field_width) {
+activity_t *__activity_textbox_create(const char                            *title,
+                                      const char                            *initial_value,
+                                      size_t                                 text_field_width,
+                                      activity_textbox_completion_callback_t completion,
+                                      void                                  *completion_data) {
 
     activity_textbox_data_t *const activity_data = malloc(sizeof(activity_textbox_data_t));
     if (!activity_data)
         return NULL;
-    activity_data->action_cancelled = 0;
-    activity_data->text_field_width = text_field_width;
+    activity_data->action_cancelled  = 0;
+    activity_data->text_field_width  = text_field_width;
+    activity_data->completion        = completion;
+    activity_data->completion_data   = completion_data;
+    activity_data->completions_count = 0;
 
     /* Initialize input data */
-    long             input_length;
-    unichar_t *const utf32_input = g_utf8_to_ucs4_fast(initial_value, -1, &input_length);
+    size_t           input_length;
+    unichar_t *const utf32_input = ncurses_utf8_to_unicode(initial_value, &input_length);
 
     activity_data->input_codepoints =
         g_array_sized_new(TRUE, FALSE, sizeof(unichar_t), input_length);
@@ -181,7 +298,9 @@ activity_t *__activity_textbox_create(const char *title,
     g_free(utf32_input);
 
     /* Initialize title */
-    activity_data->title = g_utf8_to_ucs4_fast(title, -1, NULL);
+    activity_data->title = ncurses_utf8_to_unicode(title, NULL);
+
+    __activity_textbox_update_completions(activity_data);
 
     activity_t *const ret = activity_create(__activity_textbox_keypress,
                                             __activity_textbox_render,
@@ -195,7 +314,20 @@ activity_t *__activity_textbox_create(const char *title,
 }
 
 char *activity_textbox_run(const char *title, const char *initial_value, size_t text_field_width) {
-    activity_t *const activity = __activity_textbox_create(title, initial_value, text_field_width);
+    return activity_textbox_run_with_completion(title, initial_value, text_field_width, NULL, NULL);
+}
+
+char *activity_textbox_run_with_completion(const char                            *title,
+                                           const char                            *initial_value,
+                                           size_t                                 text_field_width,
+                                           activity_textbox_completion_callback_t completion,
+                                           void                                  *completion_data) {
+
+    activity_t *const activity = __activity_textbox_create(title,
+                                                           initial_value,
+                                                           text_field_width,
+                                                           completion,
+                                                           completion_data);
     if (!activity)
         return NULL;
 
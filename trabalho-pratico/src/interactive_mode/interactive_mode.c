@@ -22,11 +22,23 @@
  * See [the header file's documentation](@ref interactive_mode_examples).
  */
 
+/* SCHED_IDLE isn't part of POSIX */
+#define _GNU_SOURCE
+
 #include <glib.h>
+#include <limits.h>
 #include <locale.h>
 #include <ncurses.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "database/database_handle.h"
+#include "database/database_registry.h"
+#include "database/database_snapshot.h"
+#include "dataset/dataset_input.h"
 #include "dataset/dataset_loader.h"
 #include "interactive_mode/activity_dataset_picker.h"
 #include "interactive_mode/activity_license.h"
@@ -36,8 +48,64 @@
 #include "interactive_mode/activity_textbox.h"
 #include "interactive_mode/interactive_mode.h"
 #include "interactive_mode/screen_loading_dataset.h"
+#include "interactive_mode/screen_running_queries.h"
 #include "queries/query_dispatcher.h"
+#include "queries/query_file_parser.h"
+#include "queries/query_history.h"
 #include "queries/query_parser.h"
+#include "queries/query_type_list.h"
+
+/** @brief Name of the file, in a dataset's directory, where a snapshot of its database is kept. */
+#define INTERACTIVE_MODE_SNAPSHOT_FILE_NAME ".database_snapshot"
+
+/** @brief Maximum number of bytes of query output kept in ::interactive_mode_cache_t::history. */
+#define INTERACTIVE_MODE_HISTORY_MEMORY_BUDGET (64 * 1024 * 1024)
+
+/** @brief Maximum number of bytes used by databases of recently used datasets kept in memory. */
+#define INTERACTIVE_MODE_DATASETS_MEMORY_BUDGET ((size_t) 4 * 1024 * 1024 * 1024)
+
+/**
+ * @struct interactive_mode_cache_t
+ * @brief  Data kept from previous queries. Statistical data is shared with the threads running
+ *         queries.
+ *
+ * @var interactive_mode_cache_t::cache
+ *     @brief Statistical data about the current database. `NULL` on allocation failure, for
+ *            statistical data to be generated for every query.
+ * @var interactive_mode_cache_t::lock
+ *     @brief Lock held while ::interactive_mode_cache_t::cache is being used.
+ * @var interactive_mode_cache_t::history
+ *     @brief Previous queries and their output on the current database. Only used by the user
+ *            interface's thread. `NULL` on allocation failure, for queries to always be run.
+ * @var interactive_mode_cache_t::prewarmed
+ *     @brief Whether indices and statistical data of the current database have already been
+ *            prepared while the user was in the main menu (see ::interactive_mode_prewarm_t).
+ */
+typedef struct {
+    query_statistics_cache_t *cache;
+    pthread_mutex_t           lock;
+    query_history_t          *history;
+    int                       prewarmed;
+} interactive_mode_cache_t;
+
+/**
+ * @brief   Discards all statistical data and query outputs in a cache, after another database is
+ *          loaded.
+ * @details Waits for a query that may still be using the cache.
+ * @param   cache Cache to be cleared.
+ */
+void __interactive_mode_cache_clear(interactive_mode_cache_t *cache) {
+    cache->prewarmed = 0;
+    if (cache->history)
+        query_history_clear_results(cache->history);
+
+    if (!cache->cache)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    query_statistics_cache_clear(cache->cache);
+    pthread_mutex_unlock(&cache->lock);
+}
 
 /**
  * @brief  Initializes `ncurses` for the interactive mode.
@@ -64,48 +132,714 @@ int __interactive_mode_init_ncurses(void) {
 }
 
 /**
- * @brief Method called when the user chooses to load a dataset in the main menu.
- * @param database Databaset to be modifed.
+ * @struct interactive_mode_loading_t
+ * @brief  State shared between the user interface and the thread loading a dataset.
+ *
+ * @var interactive_mode_loading_t::database
+ *     @brief Database where the dataset is loaded into. Swapped into the ::database_handle_t used
+ *            by the user interface once loading succeeds.
+ * @var interactive_mode_loading_t::path
+ *     @brief Path to the directory containing the dataset.
+ * @var interactive_mode_loading_t::snapshot_path
+ *     @brief Where to save a snapshot of ::interactive_mode_loading_t::database to.
+ * @var interactive_mode_loading_t::fingerprint
+ *     @brief Fingerprint of the dataset's files, if
+ *            ::interactive_mode_loading_t::has_fingerprint.
+ * @var interactive_mode_loading_t::has_fingerprint
+ *     @brief Whether a snapshot is to be saved after loading succeeds.
+ * @var interactive_mode_loading_t::saved
+ *     @brief Whether a snapshot was saved, once ::interactive_mode_loading_t::done.
+ * @var interactive_mode_loading_t::thread
+ *     @brief Thread loading the dataset.
+ * @var interactive_mode_loading_t::start
+ *     @brief When loading started.
+ * @var interactive_mode_loading_t::mutex
+ *     @brief Mutex that guards all fields following it.
+ * @var interactive_mode_loading_t::progress
+ *     @brief Progress of loading each file. ::screen_loading_dataset_progress_t::elapsed is
+ *            unused.
+ * @var interactive_mode_loading_t::cancelled
+ *     @brief Whether the user asked for loading to be cancelled.
+ * @var interactive_mode_loading_t::done
+ *     @brief Whether the loading thread has finished.
+ * @var interactive_mode_loading_t::retval
+ *     @brief Value returned by ::dataset_loader_load_with_progress, once
+ *            ::interactive_mode_loading_t::done.
+ */
+typedef struct {
+    database_t     *database;
+    char           *path;
+    char            snapshot_path[PATH_MAX];
+    uint64_t        fingerprint;
+    int             has_fingerprint, saved;
+    pthread_t       thread;
+    struct timespec start;
+
+    pthread_mutex_t                   mutex;
+    screen_loading_dataset_progress_t progress;
+    int                               cancelled, done, retval;
+} interactive_mode_loading_t;
+
+/**
+ * @brief   Reports the progress of loading a dataset file to the user interface.
+ * @details Used as a ::dataset_loader_progress_callback_t.
+ *
+ * @param user_data   A pointer to an ::interactive_mode_loading_t.
+ * @param file        File being loaded.
+ * @param bytes       Number of bytes of @p file already loaded.
+ * @param total_bytes Size of @p file.
+ * @param rows        Number of lines of @p file already loaded.
+ *
+ * @retval 0 Continue loading.
+ * @retval 1 The user cancelled loading.
+ */
+int __interactive_mode_loading_progress(void                              *user_data,
+                                        performance_metrics_dataset_step_t file,
+                                        size_t                             bytes,
+                                        size_t                             total_bytes,
+                                        size_t                             rows) {
+    interactive_mode_loading_t *const loading = user_data;
+
+    pthread_mutex_lock(&loading->mutex);
+    loading->progress.bytes[file]       = bytes;
+    loading->progress.total_bytes[file] = total_bytes;
+    loading->progress.rows[file]        = rows;
+    const int cancelled                 = loading->cancelled;
+    pthread_mutex_unlock(&loading->mutex);
+
+    return cancelled;
+}
+
+/**
+ * @brief Loads a dataset outside of the user interface's thread.
+ * @param loading_data A pointer to an ::interactive_mode_loading_t.
+ * @return `NULL`.
+ */
+void *__interactive_mode_loading_thread(void *loading_data) {
+    interactive_mode_loading_t *const loading = loading_data;
+
+    const int retval = dataset_loader_load_with_progress(loading->database,
+                                                         loading->path,
+                                                         NULL,
+                                                         __interactive_mode_loading_progress,
+                                                         loading);
+
+    /* Failing to save a snapshot (e.g.: read-only dataset directory) isn't an error */
+    if (!retval && loading->has_fingerprint)
+        loading->saved = !database_snapshot_save(loading->database,
+                                                 loading->snapshot_path,
+                                                 loading->fingerprint);
+
+    pthread_mutex_lock(&loading->mutex);
+    loading->retval = retval;
+    loading->done   = 1;
+    pthread_mutex_unlock(&loading->mutex);
+    return NULL;
+}
+
+/**
+ * @brief   Starts loading a dataset in the background.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::__interactive_mode_loading_free.
+ *
+ * @param path            Path to the directory containing the dataset. Ownership is transferred
+ *                        to the returned value on success.
+ * @param snapshot_path   Where to save a snapshot of the database to, if @p has_fingerprint.
+ * @param fingerprint     Fingerprint of the dataset's files.
+ * @param has_fingerprint Whether @p fingerprint is valid.
+ *
+ * @return The state of the loading thread, or `NULL` on failure.
+ */
+interactive_mode_loading_t *__interactive_mode_loading_start(char       *path,
+                                                             const char *snapshot_path,
+                                                             uint64_t    fingerprint,
+                                                             int         has_fingerprint) {
+    interactive_mode_loading_t *const loading = calloc(1, sizeof(interactive_mode_loading_t));
+    if (!loading)
+        goto DEFER_1;
+
+    loading->database = database_create();
+    if (!loading->database)
+        goto DEFER_2;
+    database_set_index_policy(loading->database, DATABASE_INDEX_POLICY_LAZY); /* Few queries run */
+
+    if (pthread_mutex_init(&loading->mutex, NULL))
+        goto DEFER_3;
+
+    loading->path            = path;
+    loading->fingerprint     = fingerprint;
+    loading->has_fingerprint = has_fingerprint;
+    strcpy(loading->snapshot_path, snapshot_path);
+    clock_gettime(CLOCK_MONOTONIC, &loading->start);
+
+    if (pthread_create(&loading->thread, NULL, __interactive_mode_loading_thread, loading))
+        goto DEFER_4;
+
+    return loading;
+
+DEFER_4:
+    pthread_mutex_destroy(&loading->mutex);
+DEFER_3:
+    database_free(loading->database);
+DEFER_2:
+    free(loading);
+DEFER_1:
+    return NULL;
+}
+
+/**
+ * @brief   Frees the state of a loading thread, waiting for it to finish.
+ * @details The database being loaded is also `free`d, unless it's been taken (set to `NULL`).
+ * @param   loading Value returned by ::__interactive_mode_loading_start.
  */
-void __interactive_mode_load_dataset(database_t **database) {
+void __interactive_mode_loading_free(interactive_mode_loading_t *loading) {
+    pthread_join(loading->thread, NULL);
+    pthread_mutex_destroy(&loading->mutex);
+
+    if (loading->database)
+        database_free(loading->database);
+    free(loading->path);
+    free(loading);
+}
+
+/**
+ * @brief   Shows the progress of a dataset being loaded in the background.
+ * @details Returns when loading finishes or when the user hides the progress screen (ENTER).
+ *          Pressing ESC cancels loading.
+ *
+ * @param loading Value returned by ::__interactive_mode_loading_start.
+ */
+void __interactive_mode_loading_show(interactive_mode_loading_t *loading) {
+    timeout(100); /* Re-render the screen at least every 100ms */
+    while (1) {
+        pthread_mutex_lock(&loading->mutex);
+        screen_loading_dataset_progress_t progress = loading->progress;
+        const int                         done     = loading->done;
+        pthread_mutex_unlock(&loading->mutex);
+
+        if (done)
+            break;
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        progress.elapsed = (now.tv_sec - loading->start.tv_sec) +
+                           (now.tv_nsec - loading->start.tv_nsec) / 1e9;
+        screen_loading_dataset_render(&progress);
+
+        const int c = getch();
+        if (c == 27) { /* ESC */
+            pthread_mutex_lock(&loading->mutex);
+            loading->cancelled = 1;
+            pthread_mutex_unlock(&loading->mutex);
+        } else if (c == '\n' || c == KEY_ENTER) {
+            break;
+        }
+    }
+    timeout(-1);
+}
+
+/**
+ * @brief   Swaps in a database loaded in the background, if loading has finished.
+ * @details Until then, nothing happens, and the previous database keeps being used.
+ *
+ * @param loading  Dataset being loaded in the background, freed and set to `NULL` if it's
+ *                 finished. `*loading` can be `NULL`, for no dataset being loaded.
+ * @param handle   Where to swap the newly loaded database into.
+ * @param cache    Statistical data about the previous database, to be discarded.
+ * @param registry Where to keep the newly loaded database, for when its dataset is chosen again.
+ *                 Can be `NULL`.
+ */
+void __interactive_mode_loading_finish(interactive_mode_loading_t **loading,
+                                       database_handle_t           *handle,
+                                       interactive_mode_cache_t    *cache,
+                                       database_registry_t         *registry) {
+    if (!*loading)
+        return;
+
+    pthread_mutex_lock(&(*loading)->mutex);
+    const int done = (*loading)->done;
+    pthread_mutex_unlock(&(*loading)->mutex);
+    if (!done)
+        return;
+
+    /* Failing to keep the database resident isn't an error: it's loaded again when needed */
+    if (!(*loading)->retval && registry && (*loading)->has_fingerprint)
+        database_registry_add(registry,
+                              (*loading)->path,
+                              (*loading)->snapshot_path,
+                              (*loading)->fingerprint,
+                              (*loading)->database,
+                              (*loading)->saved);
+
+    if ((*loading)->retval) {
+        if ((*loading)->cancelled)
+            activity_messagebox_run("Loading cancelled! Old data has been kept.");
+        else
+            activity_messagebox_run("Failed to load dataset! Old data has been kept.");
+    } else if (database_handle_swap(handle, (*loading)->database)) {
+        activity_messagebox_run("Failed to allocate new database! Old data has been kept.");
+    } else {
+        (*loading)->database = NULL; /* Now owned by handle */
+        __interactive_mode_cache_clear(cache);
+        activity_messagebox_run("Dataset loaded successfully!");
+    }
+
+    __interactive_mode_loading_free(*loading);
+    *loading = NULL;
+}
+
+/**
+ * @brief   Method called when the user chooses to load a dataset in the main menu.
+ * @details While a dataset is loaded in the background, the previous database in @p handle can
+ *          still be queried. Choosing this option again shows the progress of that dataset.
+ *
+ * @param handle   Where the current database is, and where to swap the new one into.
+ * @param cache    Statistical data about the current database, to be discarded.
+ * @param registry Databases of recently used datasets. Can be `NULL`.
+ * @param loading  Dataset being loaded in the background. `*loading` can be `NULL`, for no
+ *                 dataset being loaded.
+ */
+void __interactive_mode_load_dataset(database_handle_t           *handle,
+                                     interactive_mode_cache_t    *cache,
+                                     database_registry_t         *registry,
+                                     interactive_mode_loading_t **loading) {
+    if (*loading) {
+        __interactive_mode_loading_show(*loading);
+        __interactive_mode_loading_finish(loading, handle, cache, registry);
+        return;
+    }
+
     /* Ask for dataset path */
     char *const path = activity_dataset_picker_run();
     if (!path)
         return;
 
     /* Show that a new dataset is being loaded */
-    screen_loading_dataset_render();
+    screen_loading_dataset_render(NULL);
 
-    /* Recreate database */
-    if (*database)
-        database_free(*database);
+    /*
+     * Skip parsing if this dataset was loaded before and hasn't changed since (see below). Recently
+     * used datasets are still in memory, and others may have a snapshot.
+     */
+    char snapshot_path[PATH_MAX];
+    snprintf(snapshot_path, PATH_MAX, "%s/" INTERACTIVE_MODE_SNAPSHOT_FILE_NAME, path);
 
-    *database = database_create();
-    if (!*database) {
-        *database = NULL;
-        activity_messagebox_run("Failed to allocate new database!");
+    uint64_t  fingerprint;
+    const int has_fingerprint = !dataset_input_get_fingerprint(path, &fingerprint);
+    if (has_fingerprint) {
+        database_t *const database =
+            registry ? database_registry_acquire(registry, path, snapshot_path, fingerprint)
+                     : database_snapshot_load(snapshot_path, fingerprint);
+        if (database) {
+            if (database_handle_swap(handle, database)) {
+                database_free(database);
+                activity_messagebox_run("Failed to allocate new database! Old data has been kept.");
+            } else {
+                __interactive_mode_cache_clear(cache);
+                activity_messagebox_run("Dataset loaded successfully!");
+            }
+
+            free(path);
+            return;
+        }
+    }
+
+    /* Load new dataset, without discarding the current one */
+    *loading = __interactive_mode_loading_start(path, snapshot_path, fingerprint, has_fingerprint);
+    if (!*loading) {
+        activity_messagebox_run("Failed to start loading dataset! Old data has been kept.");
         free(path);
         return;
     }
 
-    /* Load new dataset */
-    if (dataset_loader_load(*database, path, NULL, NULL)) {
-        activity_messagebox_run("Failed to load dataset! Old data has been discarded.");
-        database_free(*database);
-        *database = NULL;
-    } else {
-        activity_messagebox_run("Dataset loaded successfully!");
+    __interactive_mode_loading_show(*loading);
+    __interactive_mode_loading_finish(loading, handle, cache, registry);
+}
+
+/**
+ * @struct interactive_mode_query_t
+ * @brief  State shared between the user interface and the thread running a query.
+ *
+ * @var interactive_mode_query_t::reference
+ *     @brief Reference to the database being queried, held until the query finishes.
+ * @var interactive_mode_query_t::cache
+ *     @brief Statistical data kept from previous queries. `NULL` when it's not available, because
+ *            another query is still using it.
+ * @var interactive_mode_query_t::query
+ *     @brief Query being run.
+ * @var interactive_mode_query_t::query_str
+ *     @brief Text ::interactive_mode_query_t::query was parsed from.
+ * @var interactive_mode_query_t::writer
+ *     @brief Where the output of ::interactive_mode_query_t::query is written to.
+ * @var interactive_mode_query_t::mutex
+ *     @brief Mutex that guards all fields following it.
+ * @var interactive_mode_query_t::done
+ *     @brief Whether the query has finished running.
+ * @var interactive_mode_query_t::failed
+ *     @brief Whether the query failed to run, once ::interactive_mode_query_t::done.
+ * @var interactive_mode_query_t::abandoned
+ *     @brief Whether the user left before the query finished, in which case the thread running the
+ *            query is responsible for `free`ing this structure.
+ * @var interactive_mode_query_t::cancellation
+ *     @brief Requested when the query is abandoned, so that it stops running as soon as possible.
+ */
+typedef struct {
+    database_reference_t     *reference;
+    interactive_mode_cache_t *cache;
+    query_instance_t         *query;
+    char                     *query_str;
+    query_writer_t           *writer;
+
+    pthread_mutex_t mutex;
+    int             done, failed, abandoned;
+    cancellation_t  cancellation;
+} interactive_mode_query_t;
+
+/**
+ * @brief Frees the state of a query that finished running.
+ * @param query Query to be `free`d.
+ */
+void __interactive_mode_query_free(interactive_mode_query_t *query) {
+    pthread_mutex_destroy(&query->mutex);
+    query_writer_free(query->writer);
+    query_instance_free(query->query);
+    free(query->query_str);
+    database_reference_release(query->reference);
+    free(query);
+}
+
+/**
+ * @brief Runs a query outside of the user interface's thread.
+ * @param query_data A pointer to an ::interactive_mode_query_t.
+ * @return `NULL`.
+ */
+void *__interactive_mode_query_thread(void *query_data) {
+    interactive_mode_query_t *const query = query_data;
+
+    cancellation_set_current(&query->cancellation);
+    const int failed = query_dispatcher_dispatch_single(database_reference_get(query->reference),
+                                                        query->cache ? query->cache->cache : NULL,
+                                                        query->query,
+                                                        query->writer);
+
+    /* Flush the last line of unformatted output */
+    size_t nlines;
+    query_writer_get_lines(query->writer, &nlines);
+
+    if (query->cache)
+        pthread_mutex_unlock(&query->cache->lock);
+
+    pthread_mutex_lock(&query->mutex);
+    query->done         = 1;
+    query->failed       = failed;
+    const int abandoned = query->abandoned;
+    pthread_mutex_unlock(&query->mutex);
+
+    if (abandoned)
+        __interactive_mode_query_free(query);
+    return NULL;
+}
+
+/**
+ * @brief   Gets the number of lines outputted by a query so far.
+ * @details Used as an ::activity_paging_count_t.
+ *
+ * @param query_data A pointer to an ::interactive_mode_query_t.
+ * @param complete   Where to output whether the query has finished running to.
+ *
+ * @return The number of lines outputted by the query so far.
+ */
+size_t __interactive_mode_query_get_count(void *query_data, int *complete) {
+    interactive_mode_query_t *const query = query_data;
+
+    /* Check for completion first, so that no lines are missed once the query is complete */
+    pthread_mutex_lock(&query->mutex);
+    *complete = query->done;
+    pthread_mutex_unlock(&query->mutex);
+
+    return query_writer_get_line_count(query->writer);
+}
+
+/**
+ * @brief   Gets a line outputted by a query.
+ * @details Used as an ::activity_paging_source_t.
+ *
+ * @param query_data A pointer to an ::interactive_mode_query_t.
+ * @param i          Index of the line.
+ *
+ * @return The @p i-th line outputted by the query.
+ */
+const char *__interactive_mode_query_get_line(void *query_data, size_t i) {
+    interactive_mode_query_t *const query = query_data;
+    return query_writer_get_line(query->writer, i);
+}
+
+/**
+ * @brief   Runs a query in a separate thread, showing its output as it's generated.
+ * @details If the user leaves the paginator before the query finishes, the query's output is
+ *          discarded, and the thread running it frees its resources once it finishes.
+ *
+ * @param reference Reference to the database to be queried, whose ownership is transferred to this
+ *                  function.
+ * @param cache     Statistical data kept from previous queries. Only used if no other query is
+ *                  using it.
+ * @param parsed    Query to be run, whose ownership is transferred to this function.
+ * @param query_str Text @p parsed was parsed from, whose ownership is transferred to this function.
+ *                  Used for caching the query's output in ::interactive_mode_cache_t::history.
+ */
+void __interactive_mode_query_stream(database_reference_t     *reference,
+                                     interactive_mode_cache_t *cache,
+                                     query_instance_t         *parsed,
+                                     char                     *query_str) {
+    interactive_mode_query_t *const query = calloc(1, sizeof(interactive_mode_query_t));
+    if (!query) {
+        activity_messagebox_run("Allocation error!");
+        goto DEFER_1;
     }
 
-    free(path);
+    query->writer = query_writer_create(NULL, query_instance_get_formatted(parsed));
+    if (!query->writer) {
+        activity_messagebox_run("Failed to create writer for query output.");
+        goto DEFER_2;
+    }
+
+    if (pthread_mutex_init(&query->mutex, NULL)) {
+        activity_messagebox_run("Allocation error!");
+        goto DEFER_3;
+    }
+
+    /* An abandoned query may still be using the cache */
+    query->reference = reference;
+    query->query     = parsed;
+    query->query_str = query_str;
+    query->cache     = cache->cache && !pthread_mutex_trylock(&cache->lock) ? cache : NULL;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, __interactive_mode_query_thread, query)) {
+        if (query->cache)
+            pthread_mutex_unlock(&cache->lock);
+
+        activity_messagebox_run("Failed to start running query!");
+        pthread_mutex_destroy(&query->mutex);
+        goto DEFER_3;
+    }
+    pthread_detach(thread);
+
+    activity_paging_run_stream(__interactive_mode_query_get_count,
+                               __interactive_mode_query_get_line,
+                               query,
+                               query_instance_get_formatted(parsed),
+                               "QUERY OUTPUT");
+
+    pthread_mutex_lock(&query->mutex);
+    const int done   = query->done;
+    const int failed = query->failed;
+    if (!done) {
+        query->abandoned = 1;
+        query_writer_cancel(query->writer);
+        cancellation_cancel(&query->cancellation);
+    }
+    pthread_mutex_unlock(&query->mutex);
+
+    if (done) {
+        if (failed) {
+            activity_messagebox_run("Failed to run query: out of memory!");
+        } else if (cache->history) {
+            /* On failure, the output simply isn't cached */
+            size_t             nlines;
+            const char *const *lines = query_writer_get_lines(query->writer, &nlines);
+            query_history_add_result(cache->history, parsed, query_str, lines, nlines);
+        }
+        __interactive_mode_query_free(query);
+    }
+    return;
+
+DEFER_3:
+    query_writer_free(query->writer);
+DEFER_2:
+    free(query);
+DEFER_1:
+    query_instance_free(parsed);
+    free(query_str);
+    database_reference_release(reference);
+}
+
+/**
+ * @brief   Shows the cached output of a query, if it's available.
+ * @details Ownership of all parameters is transferred to this function when output is shown.
+ *
+ * @param reference Reference to the database being queried.
+ * @param cache     Where the output of previous queries is kept.
+ * @param parsed    Query whose output is to be shown.
+ * @param query_str Text @p parsed was parsed from.
+ *
+ * @retval 0 Cached output was shown and all parameters were `free`d.
+ * @retval 1 Output not cached (nothing was done).
+ */
+int __interactive_mode_query_show_cached(database_reference_t     *reference,
+                                         interactive_mode_cache_t *cache,
+                                         query_instance_t         *parsed,
+                                         char                     *query_str) {
+    if (!cache->history)
+        return 1;
+
+    size_t             nlines;
+    const char *const *lines =
+        query_history_lookup_result(cache->history, parsed, query_str, &nlines);
+    if (!lines)
+        return 1;
+
+    /* The history is only modified by this thread, so lines stay valid while they're shown */
+    activity_paging_run(nlines, lines, query_instance_get_formatted(parsed), "QUERY OUTPUT");
+
+    query_instance_free(parsed);
+    free(query_str);
+    database_reference_release(reference);
+    return 0;
+}
+
+/**
+ * @struct interactive_mode_completion_t
+ * @brief  Suggestions being collected by ::__interactive_mode_complete_query.
+ *
+ * @var interactive_mode_completion_t::completions
+ *     @brief Where to write suggestions to.
+ * @var interactive_mode_completion_t::count
+ *     @brief Number of suggestions already in ::interactive_mode_completion_t::completions.
+ * @var interactive_mode_completion_t::max
+ *     @brief Maximum number of suggestions in ::interactive_mode_completion_t::completions.
+ */
+typedef struct {
+    char **completions;
+    size_t count, max;
+} interactive_mode_completion_t;
+
+/**
+ * @struct interactive_mode_completion_source_t
+ * @brief  Where ::__interactive_mode_complete_query gets its suggestions from.
+ *
+ * @var interactive_mode_completion_source_t::reference
+ *     @brief Reference to the database being queried.
+ * @var interactive_mode_completion_source_t::history
+ *     @brief Previous queries. May be `NULL`.
+ */
+typedef struct {
+    database_reference_t  *reference;
+    const query_history_t *history;
+} interactive_mode_completion_source_t;
+
+/**
+ * @brief Callback for prefix iterations that collects suggestions for the query textbox.
+ *
+ * @param user_data A pointer to an ::interactive_mode_completion_t.
+ * @param str       Suggestion to be collected.
+ *
+ * @retval 0 More suggestions can be collected.
+ * @retval 1 No more room for suggestions, stop iterating.
+ */
+int __interactive_mode_complete_query_callback(void *user_data, const char *str) {
+    interactive_mode_completion_t *const completion = user_data;
+    completion->completions[completion->count++]    = g_strdup(str);
+    return completion->count >= completion->max;
+}
+
+/**
+ * @brief   Suggests completions for the argument of a query being typed in the query textbox.
+ * @details While the first token is being typed, previous queries starting with it are suggested.
+ *          After that, only the first argument is completed: user identifiers in queries 1 and 2,
+ *          hotel identifiers in queries 3, 4 and 8, and airports in query 5. Lookups are done on
+ *          the managers' prefix indexes, so this is quick enough to run on every keystroke.
+ *
+ * @param completion_data A pointer to an ::interactive_mode_completion_source_t.
+ * @param text            Current query text.
+ * @param completions     Where to write suggestions to.
+ * @param max_completions Maximum number of suggestions to write.
+ *
+ * @return The number of suggestions written to @p completions.
+ */
+size_t __interactive_mode_complete_query(void       *completion_data,
+                                         const char *text,
+                                         char      **completions,
+                                         size_t      max_completions) {
+
+    const interactive_mode_completion_source_t *const source = completion_data;
+
+    const database_t *const database = database_reference_get(source->reference);
+    if (!max_completions)
+        return 0;
+
+    interactive_mode_completion_t completion = {.completions = completions,
+                                                .count       = 0,
+                                                .max         = max_completions};
+    if (!strchr(text, ' ')) {
+        if (source->history)
+            query_history_iter_queries(source->history,
+                                       text,
+                                       __interactive_mode_complete_query_callback,
+                                       &completion);
+        return completion.count;
+    }
+
+    /* Parse query number (with an optional F suffix), followed by exactly one space */
+    const char *cursor = text;
+    while (*cursor == ' ')
+        cursor++;
+
+    int query = 0;
+    while (*cursor >= '0' && *cursor <= '9')
+        query = query * 10 + (*cursor++ - '0');
+    if (*cursor == 'F')
+        cursor++;
+    if (*cursor != ' ')
+        return 0;
+    while (*cursor == ' ')
+        cursor++;
+
+    const char *const argument = cursor;
+    if (strchr(argument, ' ') || !*argument)
+        return 0; /* Only the first argument is completed */
+
+    /* Hotels and airports are always written in uppercase */
+    gchar *const upper = g_ascii_strup(argument, -1);
+    switch (query) {
+        case 1:
+        case 2:
+            user_manager_iter_id_prefix(database_get_users(database),
+                                        argument,
+                                        __interactive_mode_complete_query_callback,
+                                        &completion);
+            break;
+        case 3:
+        case 4:
+        case 8:
+            reservation_manager_iter_hotel_id_prefix(database_get_reservations(database),
+                                                     upper,
+                                                     __interactive_mode_complete_query_callback,
+                                                     &completion);
+            break;
+        case 5:
+            flight_manager_iter_airport_prefix(database_get_flights(database),
+                                               upper,
+                                               __interactive_mode_complete_query_callback,
+                                               &completion);
+            break;
+        default:
+            break;
+    }
+    g_free(upper);
+
+    return completion.count;
 }
 
 /**
  * @brief Method called when the user chooses to run a query in the main menu.
- * @param database Database to be queried.
+ *
+ * @param handle Where the database to be queried is.
+ * @param cache  Statistical data kept from previous queries on the current database.
  */
-void __interactive_mode_run_query(const database_t *database) {
-    if (!database) {
+void __interactive_mode_run_query(database_handle_t *handle, interactive_mode_cache_t *cache) {
+    database_reference_t *const reference = database_handle_acquire(handle);
+    if (!reference) {
         activity_messagebox_run("Please load a dataset first!");
         return;
     }
@@ -114,57 +848,596 @@ void __interactive_mode_run_query(const database_t *database) {
     if (!query_old_str) {
         /* This may also fail from being out of memory */
         activity_messagebox_run("Allocation error!");
+        database_reference_release(reference);
         return;
     }
 
+    interactive_mode_completion_source_t completion_source = {.reference = reference,
+                                                              .history   = cache->history};
+
     while (1) {
-        char *const query_str = activity_textbox_run("Input a query", query_old_str, 40);
+        char *const query_str =
+            activity_textbox_run_with_completion("Input a query",
+                                                 query_old_str,
+                                                 40,
+                                                 __interactive_mode_complete_query,
+                                                 &completion_source);
         if (!query_str) {
             free(query_old_str);
+            database_reference_release(reference);
             return;
         }
 
-        query_instance_t *const query_parsed = query_instance_create();
+        query_instance_t *const query_parsed = query_instance_create(NULL);
         if (!query_parsed) {
             free(query_old_str);
+            free(query_str);
+            database_reference_release(reference);
 
             /* This may also fail from being out of memory */
             activity_messagebox_run("Allocation error!");
             return;
         }
 
-        if (query_parser_parse_string_const(query_parsed, query_str, NULL)) {
+        if (query_parser_parse_string_const(NULL, query_parsed, query_str)) {
             free(query_old_str);
             query_old_str = query_str;
 
             query_instance_free(query_parsed);
             activity_messagebox_run("Failed to parse query.");
         } else {
-            query_writer_t *const writer =
-                query_writer_create(NULL, query_instance_get_formatted(query_parsed));
-            if (!writer) {
-                activity_messagebox_run("Failed to create writer for query output.");
-            } else {
-                if (query_dispatcher_dispatch_single(database, query_parsed, writer)) {
-                    activity_messagebox_run("Failed to run query: out of memory!");
-                } else {
-                    size_t                   nlines;
-                    const char *const *const lines = query_writer_get_lines(writer, &nlines);
-                    activity_paging_run(nlines,
-                                        lines,
-                                        query_instance_get_formatted(query_parsed),
-                                        "QUERY OUTPUT");
-                }
+            free(query_old_str);
+            if (cache->history)
+                query_history_add_query(cache->history, query_str);
 
-                query_writer_free(writer);
-            }
+            if (__interactive_mode_query_show_cached(reference, cache, query_parsed, query_str))
+                __interactive_mode_query_stream(reference, cache, query_parsed, query_str);
+            return;
+        }
+    }
+}
 
-            query_instance_free(query_parsed);
-            free(query_old_str);
-            free(query_str);
+/**
+ * @struct interactive_mode_query_file_command_t
+ * @brief  Information about a query in a query file, needed to show its output.
+ *
+ * @var interactive_mode_query_file_command_t::line
+ *     @brief Line of the query file the query came from.
+ * @var interactive_mode_query_file_command_t::formatted
+ *     @brief Whether the query's output is formatted.
+ */
+typedef struct {
+    size_t line;
+    int    formatted;
+} interactive_mode_query_file_command_t;
+
+/**
+ * @struct interactive_mode_query_file_t
+ * @brief  State shared between the user interface and the thread running a query file.
+ *
+ * @var interactive_mode_query_file_t::reference
+ *     @brief Reference to the database being queried, held until all queries finish.
+ * @var interactive_mode_query_file_t::cache
+ *     @brief Statistical data kept from previous queries. `NULL` when it's not available, because
+ *            another query is still using it.
+ * @var interactive_mode_query_file_t::queries
+ *     @brief Queries being run.
+ * @var interactive_mode_query_file_t::outputs
+ *     @brief Where the output of each query is written to, in the order of
+ *            ::interactive_mode_query_file_t::queries.
+ * @var interactive_mode_query_file_t::commands
+ *     @brief Information about each query in ::interactive_mode_query_file_t::outputs.
+ * @var interactive_mode_query_file_t::n
+ *     @brief Number of elements in ::interactive_mode_query_file_t::outputs and
+ *            ::interactive_mode_query_file_t::commands.
+ * @var interactive_mode_query_file_t::progress
+ *     @brief Progress of the queries being run, accessed atomically.
+ * @var interactive_mode_query_file_t::done
+ *     @brief Whether all queries have finished running, accessed atomically.
+ */
+typedef struct {
+    database_reference_t                  *reference;
+    interactive_mode_cache_t              *cache;
+    query_instance_list_t                 *queries;
+    query_writer_t                       **outputs;
+    interactive_mode_query_file_command_t *commands;
+    size_t                                 n;
+
+    query_dispatcher_progress_t progress;
+    int                         done;
+} interactive_mode_query_file_t;
+
+/**
+ * @brief Called for each query in a query file, to create the writer its output is written to.
+ *
+ * @param user_data A pointer to an ::interactive_mode_query_file_t.
+ * @param instance  Query whose output is to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __interactive_mode_query_file_init_output(void *user_data, const query_instance_t *instance) {
+    interactive_mode_query_file_t *const query_file = user_data;
+
+    query_writer_t *const writer =
+        query_writer_create(NULL, query_instance_get_formatted(instance));
+    if (!writer)
+        return 1;
+
+    query_file->outputs[query_file->n] = writer;
+    query_file->commands[query_file->n].line      = query_instance_get_line_in_file(instance);
+    query_file->commands[query_file->n].formatted = query_instance_get_formatted(instance);
+    query_file->n++;
+    return 0;
+}
+
+/**
+ * @brief   Parses a query file and creates writers for the output of all of its queries.
+ * @details The returned value is owned by the caller, and should be `free`d with
+ *          ::__interactive_mode_query_file_free.
+ *
+ * @param reference Reference to the database to be queried, whose ownership is transferred to the
+ *                  returned value on success.
+ * @param path      Path to the query file.
+ *
+ * @return The queries to be run, or `NULL` on failure (an error message is shown to the user).
+ */
+interactive_mode_query_file_t *__interactive_mode_query_file_create(database_reference_t *reference,
+                                                                    const char           *path) {
+    interactive_mode_query_file_t *const query_file =
+        calloc(1, sizeof(interactive_mode_query_file_t));
+    if (!query_file) {
+        activity_messagebox_run("Allocation error!");
+        goto DEFER_1;
+    }
+
+    FILE *const file = fopen(path, "r");
+    if (!file) {
+        activity_messagebox_run("Failed to open query file!");
+        goto DEFER_2;
+    }
+
+    query_file->queries = query_file_parser_parse(file);
+    fclose(file);
+    if (!query_file->queries) {
+        activity_messagebox_run("Failed to allocate list of queries!");
+        goto DEFER_2;
+    }
+
+    const size_t length = query_instance_list_get_length(query_file->queries);
+    if (!length) {
+        activity_messagebox_run("No valid queries in query file!");
+        goto DEFER_3;
+    }
+
+    query_file->outputs  = malloc(sizeof(query_writer_t *) * length);
+    query_file->commands = malloc(sizeof(interactive_mode_query_file_command_t) * length);
+    if (!query_file->outputs || !query_file->commands) {
+        activity_messagebox_run("Allocation error!");
+        goto DEFER_4;
+    }
+
+    if (query_instance_list_iter(query_file->queries,
+                                 __interactive_mode_query_file_init_output,
+                                 query_file)) {
+        activity_messagebox_run("Failed to create writers for query outputs.");
+        goto DEFER_5;
+    }
+
+    query_file->reference = reference;
+    return query_file;
+
+DEFER_5:
+    for (size_t i = 0; i < query_file->n; ++i)
+        query_writer_free(query_file->outputs[i]);
+DEFER_4:
+    free(query_file->outputs);
+    free(query_file->commands);
+DEFER_3:
+    query_instance_list_free(query_file->queries);
+DEFER_2:
+    free(query_file);
+DEFER_1:
+    return NULL;
+}
+
+/**
+ * @brief Frees the state of a query file that finished running.
+ * @param query_file Value returned by ::__interactive_mode_query_file_create.
+ */
+void __interactive_mode_query_file_free(interactive_mode_query_file_t *query_file) {
+    for (size_t i = 0; i < query_file->n; ++i)
+        query_writer_free(query_file->outputs[i]);
+    free(query_file->outputs);
+    free(query_file->commands);
+    query_instance_list_free(query_file->queries);
+    database_reference_release(query_file->reference);
+    free(query_file);
+}
+
+/**
+ * @brief Runs all queries in a query file outside of the user interface's thread.
+ * @param query_file_data A pointer to an ::interactive_mode_query_file_t.
+ * @return `NULL`.
+ */
+void *__interactive_mode_query_file_thread(void *query_file_data) {
+    interactive_mode_query_file_t *const query_file = query_file_data;
+
+    query_dispatcher_dispatch_list_with_progress(
+        database_reference_get(query_file->reference),
+        query_file->cache ? query_file->cache->cache : NULL,
+        query_file->queries,
+        query_file->outputs,
+        0,
+        NULL,
+        &query_file->progress);
+
+    if (query_file->cache)
+        pthread_mutex_unlock(&query_file->cache->lock);
+
+    g_atomic_int_set(&query_file->done, 1);
+    return NULL;
+}
+
+/**
+ * @brief   Shows the progress of a query file being run in the background.
+ * @details Returns when all queries finish. Pressing ESC cancels queries that haven't run yet.
+ *
+ * @param query_file Query file being run.
+ *
+ * @return The number of seconds queries took to run, including generating statistical data.
+ */
+double __interactive_mode_query_file_show(interactive_mode_query_file_t *query_file) {
+    struct timespec begin, start, now;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    int executing = 0;
+
+    timeout(100); /* Re-render the screen at least every 100ms */
+    while (1) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (g_atomic_int_get(&query_file->done))
+            break;
+
+        query_dispatcher_progress_t progress;
+        for (size_t i = 0; i <= QUERY_TYPE_LIST_COUNT; ++i) {
+            progress.total[i] = g_atomic_int_get(&query_file->progress.total[i]);
+            progress.done[i]  = g_atomic_int_get(&query_file->progress.done[i]);
+        }
+        progress.executing = g_atomic_int_get(&query_file->progress.executing);
+        progress.cancellation.cancelled =
+            g_atomic_int_get(&query_file->progress.cancellation.cancelled);
+
+        /* Throughput only accounts for query execution, not for generating statistical data */
+        if (progress.executing && !executing) {
+            executing = 1;
+            start     = now;
+        }
+
+        const double elapsed =
+            executing ? (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9 : 0.0;
+        screen_running_queries_render(&progress, elapsed);
+
+        if (getch() == 27) /* ESC */
+            cancellation_cancel(&query_file->progress.cancellation);
+    }
+    timeout(-1);
+
+    return (now.tv_sec - begin.tv_sec) + (now.tv_nsec - begin.tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Lets the user see the output of each command in a query file that was run.
+ * @param query_file Query file that finished running.
+ */
+void __interactive_mode_query_file_browse(interactive_mode_query_file_t *query_file) {
+    char *command_str = strdup("");
+    while (command_str) {
+        char *const new_command_str = activity_textbox_run("Command to show (line number)",
+                                                           command_str,
+                                                           20);
+        free(command_str);
+        command_str = new_command_str;
+        if (!command_str)
             return;
+
+        char        *end;
+        const size_t line = strtoul(command_str, &end, 10);
+
+        size_t i = 0;
+        if (*command_str && !*end)
+            while (i < query_file->n && query_file->commands[i].line != line)
+                i++;
+        else
+            i = query_file->n;
+
+        if (i == query_file->n) {
+            activity_messagebox_run("No valid query in that line of the query file.");
+            continue;
+        }
+
+        char title[64];
+        snprintf(title, sizeof(title), "COMMAND %zu OUTPUT", line);
+
+        size_t             nlines;
+        const char *const *lines = query_writer_get_lines(query_file->outputs[i], &nlines);
+        activity_paging_run(nlines, lines, query_file->commands[i].formatted, title);
+    }
+}
+
+/**
+ * @brief   Method called when the user chooses to run a query file in the main menu.
+ * @details All queries are run on the loaded database by ::query_dispatcher_dispatch_list, so
+ *          statistical data is shared between queries of the same type, and queries are executed
+ *          in parallel. Their outputs are kept in memory, for the user to see.
+ *
+ * @param handle Where the database to be queried is.
+ * @param cache  Statistical data kept from previous queries on the current database.
+ */
+void __interactive_mode_run_query_file(database_handle_t        *handle,
+                                       interactive_mode_cache_t *cache) {
+    database_reference_t *const reference = database_handle_acquire(handle);
+    if (!reference) {
+        activity_messagebox_run("Please load a dataset first!");
+        return;
+    }
+
+    char *const path = activity_textbox_run("Choose a query file", "", 60);
+    if (!path) {
+        database_reference_release(reference);
+        return;
+    }
+
+    interactive_mode_query_file_t *const query_file =
+        __interactive_mode_query_file_create(reference, path);
+    free(path);
+    if (!query_file) {
+        database_reference_release(reference);
+        return;
+    }
+
+    /* An abandoned query may still be using the cache */
+    query_file->cache = cache->cache && !pthread_mutex_trylock(&cache->lock) ? cache : NULL;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, __interactive_mode_query_file_thread, query_file)) {
+        if (query_file->cache)
+            pthread_mutex_unlock(&cache->lock);
+
+        activity_messagebox_run("Failed to start running queries!");
+        __interactive_mode_query_file_free(query_file);
+        return;
+    }
+
+    const double elapsed = __interactive_mode_query_file_show(query_file);
+    pthread_join(thread, NULL);
+
+    char message[128];
+    if (g_atomic_int_get(&query_file->progress.cancellation.cancelled))
+        snprintf(message,
+                 sizeof(message),
+                 "Cancelled! Unfinished commands have incomplete output.");
+    else
+        snprintf(message, sizeof(message), "Ran %zu queries in %.2fs.", query_file->n, elapsed);
+    activity_messagebox_run(message);
+
+    __interactive_mode_query_file_browse(query_file);
+    __interactive_mode_query_file_free(query_file);
+}
+
+/**
+ * @struct interactive_mode_prewarm_t
+ * @brief  Work done in the background while the user is in the main menu, so that the first
+ *         queries on a newly loaded database don't have to wait for indices and reusable
+ *         statistical data to be generated.
+ *
+ * @var interactive_mode_prewarm_t::reference
+ *     @brief Reference to the database being prepared, held until the thread finishes.
+ * @var interactive_mode_prewarm_t::cache
+ *     @brief Where reusable statistical data is kept. Only used if no query is using it.
+ * @var interactive_mode_prewarm_t::counts
+ *     @brief Number of queries of each type (index is the query type number minus one) in
+ *            ::interactive_mode_cache_t::history.
+ * @var interactive_mode_prewarm_t::queries
+ *     @brief   Most recent query in ::interactive_mode_cache_t::history of each query type with
+ *              reusable statistical data, run for that data to be cached. `NULL` for other types.
+ *     @details These queries have an empty page, so that no output is kept.
+ * @var interactive_mode_prewarm_t::order
+ *     @brief Indices of ::interactive_mode_prewarm_t::counts, from the most used query type to the
+ *            least used one, which is the order query types are prepared in.
+ * @var interactive_mode_prewarm_t::thread
+ *     @brief Thread doing the work.
+ * @var interactive_mode_prewarm_t::cancellation
+ *     @brief Requested when the user chooses an option in the main menu.
+ * @var interactive_mode_prewarm_t::complete
+ *     @brief Whether all work was done. Only read after ::interactive_mode_prewarm_t::thread is
+ *            joined.
+ */
+typedef struct {
+    database_reference_t     *reference;
+    interactive_mode_cache_t *cache;
+
+    size_t            counts[QUERY_TYPE_LIST_COUNT];
+    query_instance_t *queries[QUERY_TYPE_LIST_COUNT];
+    size_t            order[QUERY_TYPE_LIST_COUNT];
+
+    pthread_t      thread;
+    cancellation_t cancellation;
+    int            complete;
+} interactive_mode_prewarm_t;
+
+/**
+ * @brief Callback for iterations through the history, that counts how many times each query type
+ *        was used.
+ *
+ * @param prewarm_data A pointer to an ::interactive_mode_prewarm_t.
+ * @param query_str    Query in the history.
+ *
+ * @retval 0 Success, continue iterating.
+ * @retval 1 Allocation failure, stop iterating.
+ */
+int __interactive_mode_prewarm_count_query(void *prewarm_data, const char *query_str) {
+    interactive_mode_prewarm_t *const prewarm = prewarm_data;
+
+    query_instance_t *const query = query_instance_create(NULL);
+    if (!query)
+        return 1;
+
+    if (query_parser_parse_string_const(NULL, query, query_str)) {
+        query_instance_free(query);
+        return 0;
+    }
+
+    const query_type_t *const type = query_instance_get_type(query);
+    const size_t              i    = query_type_get_type_number(type) - 1;
+    prewarm->counts[i]++;
+
+    /* Queries are iterated through from the most recent one */
+    if (!prewarm->queries[i] && query_type_has_reusable_statistics(type) &&
+        query_type_needs_statistics(type)) {
+
+        query_instance_set_page(query, 0, 0);
+        prewarm->queries[i] = query;
+    } else {
+        query_instance_free(query);
+    }
+    return 0;
+}
+
+/**
+ * @brief Frees the state of background work that finished.
+ * @param prewarm Background work to be `free`d.
+ */
+void __interactive_mode_prewarm_free(interactive_mode_prewarm_t *prewarm) {
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
+        if (prewarm->queries[i])
+            query_instance_free(prewarm->queries[i]);
+
+    database_reference_release(prewarm->reference);
+    free(prewarm);
+}
+
+/**
+ * @brief   Builds indices and generates reusable statistical data, for every query type.
+ * @details Runs with the lowest scheduling priority available, so that it doesn't compete with the
+ *          user interface (or other programs), and stops between steps when cancelled. An index
+ *          being built can't be cancelled, but the next query would need it very likely.
+ *
+ * @param prewarm_data A pointer to an ::interactive_mode_prewarm_t.
+ * @return `NULL`.
+ */
+void *__interactive_mode_prewarm_thread(void *prewarm_data) {
+    interactive_mode_prewarm_t *const prewarm  = prewarm_data;
+    const database_t *const           database = database_reference_get(prewarm->reference);
+
+#ifdef SCHED_IDLE
+    /* Failing to lower the priority isn't an error: this thread is just more noticeable */
+    const struct sched_param param = {.sched_priority = 0};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+
+    cancellation_set_current(&prewarm->cancellation);
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        const size_t               type_index = prewarm->order[i];
+        const query_type_t *const  type       = query_type_list_get_by_index(type_index + 1);
+        const database_index_set_t indexes    = query_type_get_indexes(type);
+
+        /* On failure, indices are built when first needed */
+        for (size_t index = 0; index < DATABASE_INDEX_COUNT; ++index) {
+            if (cancellation_check())
+                return NULL;
+            if (indexes & DATABASE_INDEX_SET(index))
+                database_build_index(database, (database_index_t) index);
+        }
+
+        /* The cache may be in use by an abandoned query */
+        const query_instance_t *const query = prewarm->queries[type_index];
+        if (query && prewarm->cache->cache && !pthread_mutex_trylock(&prewarm->cache->lock)) {
+            query_writer_t *const writer =
+                query_writer_create(NULL, query_instance_get_formatted(query));
+            if (writer) {
+                query_dispatcher_dispatch_single(database, prewarm->cache->cache, query, writer);
+                query_writer_free(writer);
+            }
+            pthread_mutex_unlock(&prewarm->cache->lock);
         }
     }
+
+    prewarm->complete = !cancellation_check();
+    return NULL;
+}
+
+/**
+ * @brief   Starts preparing the current database in the background, while the user is in the main
+ *          menu.
+ * @details Query types are prepared in order of how often they appear in the history of previous
+ *          queries. Nothing is done if there's no database or if it has already been prepared.
+ *          Failures aren't reported, as this is only an optimization.
+ *
+ * @param handle Where the current database is.
+ * @param cache  Statistical data about the current database, and previous queries.
+ *
+ * @return Background work to be stopped with ::__interactive_mode_prewarm_stop, or `NULL` if
+ *         nothing is being done.
+ */
+interactive_mode_prewarm_t *__interactive_mode_prewarm_start(database_handle_t        *handle,
+                                                             interactive_mode_cache_t *cache) {
+    if (cache->prewarmed)
+        return NULL;
+
+    database_reference_t *const reference = database_handle_acquire(handle);
+    if (!reference)
+        return NULL;
+
+    interactive_mode_prewarm_t *const prewarm = calloc(1, sizeof(interactive_mode_prewarm_t));
+    if (!prewarm) {
+        database_reference_release(reference);
+        return NULL;
+    }
+    prewarm->reference = reference;
+    prewarm->cache     = cache;
+
+    if (cache->history)
+        query_history_iter_queries(cache->history,
+                                   "",
+                                   __interactive_mode_prewarm_count_query,
+                                   prewarm);
+
+    /* Stable insertion sort, for unused query types to be prepared in order */
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        size_t j = i;
+        for (; j > 0 && prewarm->counts[prewarm->order[j - 1]] < prewarm->counts[i]; --j)
+            prewarm->order[j] = prewarm->order[j - 1];
+        prewarm->order[j] = i;
+    }
+
+    if (pthread_create(&prewarm->thread, NULL, __interactive_mode_prewarm_thread, prewarm)) {
+        __interactive_mode_prewarm_free(prewarm);
+        return NULL;
+    }
+    return prewarm;
+}
+
+/**
+ * @brief   Stops preparing a database in the background, once the user leaves the main menu.
+ * @details Waits for the background thread, so that it's not using the database or the cache once
+ *          another database is loaded, or when queries are run.
+ *
+ * @param prewarm Background work to be stopped, freed and set to `NULL`. `*prewarm` can be `NULL`,
+ *                for no background work.
+ * @param cache   Cache marked as prepared, if all work was done.
+ */
+void __interactive_mode_prewarm_stop(interactive_mode_prewarm_t **prewarm,
+                                     interactive_mode_cache_t    *cache) {
+    if (!*prewarm)
+        return;
+
+    cancellation_cancel(&(*prewarm)->cancellation);
+    pthread_join((*prewarm)->thread, NULL);
+    if ((*prewarm)->complete)
+        cache->prewarmed = 1;
+
+    __interactive_mode_prewarm_free(*prewarm);
+    *prewarm = NULL;
 }
 
 int interactive_mode_run(void) {
@@ -173,23 +1446,70 @@ int interactive_mode_run(void) {
         return 1;
     }
 
-    database_t *database = NULL;
+    database_handle_t *const handle = database_handle_create();
+    if (!handle) {
+        endwin();
+        fputs("Failed to allocate database!\n", stderr);
+        return 1;
+    }
+
+    /* Without a registry (allocation failure), datasets are always loaded again */
+    database_registry_t *const registry =
+        database_registry_create(INTERACTIVE_MODE_DATASETS_MEMORY_BUDGET);
+    interactive_mode_loading_t *loading = NULL;
+    interactive_mode_prewarm_t *prewarm = NULL; /* Only while the main menu is shown */
+
+    /* Without a cache (allocation failure), statistical data is generated for every query */
+    interactive_mode_cache_t cache = {
+        .cache   = query_statistics_cache_create(),
+        .history = query_history_create(INTERACTIVE_MODE_HISTORY_MEMORY_BUDGET)};
+    if (cache.cache && pthread_mutex_init(&cache.lock, NULL)) {
+        query_statistics_cache_free(cache.cache);
+        cache.cache = NULL;
+    }
+
     while (1) {
+        /* Use the time the user spends in the main menu to prepare for the next queries */
+        prewarm = __interactive_mode_prewarm_start(handle, &cache);
+
         activity_main_menu_chosen_option_t option = activity_main_menu_run();
+        __interactive_mode_prewarm_stop(&prewarm, &cache);
+
+        /* Swap in a dataset loaded in the background before handling the chosen option */
+        __interactive_mode_loading_finish(&loading, handle, &cache, registry);
 
         switch (option) {
             case ACTIVITY_MAIN_MENU_LOAD_DATASET:
-                __interactive_mode_load_dataset(&database);
+                __interactive_mode_load_dataset(handle, &cache, registry, &loading);
                 break;
             case ACTIVITY_MAIN_MENU_RUN_QUERY:
-                __interactive_mode_run_query(database);
+                __interactive_mode_run_query(handle, &cache);
+                break;
+            case ACTIVITY_MAIN_MENU_RUN_QUERY_FILE:
+                __interactive_mode_run_query_file(handle, &cache);
                 break;
             case ACTIVITY_MAIN_MENU_LICENSE:
                 activity_license_run();
                 break;
             case ACTIVITY_MAIN_MENU_LEAVE:
-                if (database)
-                    database_free(database);
+                if (loading) {
+                    pthread_mutex_lock(&loading->mutex);
+                    loading->cancelled = 1;
+                    pthread_mutex_unlock(&loading->mutex);
+                    __interactive_mode_loading_free(loading);
+                }
+                database_handle_free(handle);
+                if (registry)
+                    database_registry_free(registry);
+                if (cache.cache) {
+                    /* Wait for an abandoned query that may still be using the cache */
+                    pthread_mutex_lock(&cache.lock);
+                    query_statistics_cache_free(cache.cache);
+                    pthread_mutex_unlock(&cache.lock);
+                    pthread_mutex_destroy(&cache.lock);
+                }
+                if (cache.history)
+                    query_history_free(cache.history);
                 return endwin() == ERR;
         }
     }
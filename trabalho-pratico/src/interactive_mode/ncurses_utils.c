@@ -24,9 +24,34 @@
 
 #include <glib.h>
 #include <ncurses.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+/** @cond FALSE */
+#if defined(__SSE2__) && defined(__GNUC__)
+    #include <emmintrin.h>
+#endif
+/** @endcond */
 
 #include "interactive_mode/ncurses_utils.h"
 
+/** @brief Number of bytes of UTF-8 text sent to `ncurses` at once by ::ncurses_put_wide_string. */
+#define NCURSES_UTILS_PUT_BUFFER_SIZE 256
+
+/** @brief Number of characters whose widths are kept in ::__ncurses_utils_widths. */
+#define NCURSES_UTILS_CACHED_CHARACTERS 0x10000
+
+/**
+ * @brief   Widths of all characters in the Basic Multilingual Plane, two bits each.
+ * @details Filled in by ::__ncurses_utils_init_widths, as looking a character up in glib's Unicode
+ *          tables (whether it's printable, wide or zero-width) is slow.
+ */
+uint8_t __ncurses_utils_widths[NCURSES_UTILS_CACHED_CHARACTERS / 4];
+
+/** @brief Makes sure ::__ncurses_utils_init_widths is only called once. */
+pthread_once_t __ncurses_utils_widths_once = PTHREAD_ONCE_INIT;
+
 void ncurses_render_rectangle(int x, int y, int width, int height) {
     /* Horizontal lines */
     move(y - 1, x);
@@ -51,15 +76,158 @@ void ncurses_render_rectangle(int x, int y, int width, int height) {
     mvaddch(y - 1, x + width, '+');
 }
 
+#if defined(__SSE2__) && defined(__GNUC__)
+
+/**
+ * @brief   Converts the ASCII characters at the beginning of a UTF-8 string to UTF-32, 16 at a
+ *          time.
+ * @details Auxiliary method for ::ncurses_utf8_to_unicode. Bytes are zero-extended to 32 bits with
+ *          unpack instructions, for as long as none of them has its most significant bit set.
+ *
+ * @param in  UTF-8 string to be converted.
+ * @param end End of @p in (its null terminator).
+ * @param out Where to write the UTF-32 characters to.
+ *
+ * @return The number of characters converted.
+ */
+size_t __ncurses_utils_widen_ascii(const uint8_t *in, const uint8_t *end, unichar_t *out) {
+    const __m128i zeros = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; end - (in + i) >= 16; i += 16) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i *) (in + i));
+        if (_mm_movemask_epi8(bytes))
+            break; /* Non-ASCII character in the block */
+
+        const __m128i low  = _mm_unpacklo_epi8(bytes, zeros);
+        const __m128i high = _mm_unpackhi_epi8(bytes, zeros);
+        _mm_storeu_si128((__m128i *) (out + i), _mm_unpacklo_epi16(low, zeros));
+        _mm_storeu_si128((__m128i *) (out + i + 4), _mm_unpackhi_epi16(low, zeros));
+        _mm_storeu_si128((__m128i *) (out + i + 8), _mm_unpacklo_epi16(high, zeros));
+        _mm_storeu_si128((__m128i *) (out + i + 12), _mm_unpackhi_epi16(high, zeros));
+    }
+
+    for (; in + i < end && in[i] < 0x80; ++i)
+        out[i] = in[i];
+    return i;
+}
+
+#else
+
+/**
+ * @brief   Converts the ASCII characters at the beginning of a UTF-8 string to UTF-32.
+ * @details Auxiliary method for ::ncurses_utf8_to_unicode.
+ *
+ * @param in  UTF-8 string to be converted.
+ * @param end End of @p in (its null terminator).
+ * @param out Where to write the UTF-32 characters to.
+ *
+ * @return The number of characters converted.
+ */
+size_t __ncurses_utils_widen_ascii(const uint8_t *in, const uint8_t *end, unichar_t *out) {
+    size_t i = 0;
+    for (; in + i < end && in[i] < 0x80; ++i)
+        out[i] = in[i];
+    return i;
+}
+
+#endif
+
+/**
+ * @brief   Decodes a multi-byte UTF-8 sequence.
+ * @details Auxiliary method for ::ncurses_utf8_to_unicode. Sequences with a bad leading byte, or
+ *          without all of their continuation bytes, are decoded as `U+FFFD`, and only their first
+ *          byte is consumed.
+ *
+ * @param in  Beginning of the sequence, whose first byte isn't ASCII.
+ * @param end End of the string containing @p in (its null terminator).
+ * @param out Where to write the decoded character to.
+ *
+ * @return The number of bytes consumed.
+ */
+size_t __ncurses_utils_decode(const uint8_t *in, const uint8_t *end, unichar_t *out) {
+    size_t    n;
+    unichar_t c;
+    if ((in[0] & 0xE0) == 0xC0) {
+        n = 2;
+        c = in[0] & 0x1F;
+    } else if ((in[0] & 0xF0) == 0xE0) {
+        n = 3;
+        c = in[0] & 0x0F;
+    } else if ((in[0] & 0xF8) == 0xF0) {
+        n = 4;
+        c = in[0] & 0x07;
+    } else {
+        *out = 0xFFFD;
+        return 1;
+    }
+
+    if ((size_t) (end - in) < n) {
+        *out = 0xFFFD; /* Truncated sequence */
+        return 1;
+    }
+
+    for (size_t i = 1; i < n; ++i) {
+        if ((in[i] & 0xC0) != 0x80) {
+            *out = 0xFFFD;
+            return 1;
+        }
+        c = c << 6 | (in[i] & 0x3F);
+    }
+
+    *out = c;
+    return n;
+}
+
+unichar_t *ncurses_utf8_to_unicode(const char *str, size_t *length) {
+    /* There can't be more characters than bytes */
+    const size_t     nbytes = strlen(str);
+    unichar_t *const output = g_malloc(sizeof(unichar_t) * (nbytes + 1));
+
+    const uint8_t       *in  = (const uint8_t *) str;
+    const uint8_t *const end = in + nbytes;
+    size_t               n   = 0;
+    while (in < end) {
+        const size_t ascii = __ncurses_utils_widen_ascii(in, end, output + n);
+        in += ascii;
+        n  += ascii;
+
+        if (in < end)
+            in += __ncurses_utils_decode(in, end, output + n++);
+    }
+
+    output[n] = 0;
+    if (length)
+        *length = n;
+    return output;
+}
+
 void ncurses_put_wide_string(const unichar_t *str, size_t n) {
+    /* Text is sent in batches, as every call to ncurses has a high overhead */
+    char   buffer[NCURSES_UTILS_PUT_BUFFER_SIZE];
+    size_t used = 0;
     for (size_t i = 0; str[i] && i < n; ++i) {
-        char      utf8[6];
-        const int count = g_unichar_to_utf8(str[i], utf8);
-        addnstr(utf8, count);
+        if (used + 6 > NCURSES_UTILS_PUT_BUFFER_SIZE) {
+            addnstr(buffer, (int) used);
+            used = 0;
+        }
+
+        if (str[i] < 0x80)
+            buffer[used++] = (char) str[i];
+        else
+            used += g_unichar_to_utf8(str[i], buffer + used);
     }
+
+    if (used)
+        addnstr(buffer, (int) used);
 }
 
-int ncurses_measure_character(unichar_t c) {
+/**
+ * @brief  Measures the width of a Unicode codepoint from glib's Unicode tables.
+ * @param  c Character to be measured.
+ * @return The width of @p c (see ::ncurses_measure_character).
+ */
+int __ncurses_utils_measure_uncached(unichar_t c) {
     if (g_unichar_isprint(c)) {
         if (g_unichar_iswide(c))
             return 2;
@@ -72,28 +240,42 @@ int ncurses_measure_character(unichar_t c) {
     return 0;
 }
 
-size_t ncurses_measure_unicode_string(const unichar_t *str) {
-    size_t width = 0;
+/** @brief Fills in ::__ncurses_utils_widths. Called through `pthread_once`. */
+void __ncurses_utils_init_widths(void) {
+    for (unichar_t c = 0; c < NCURSES_UTILS_CACHED_CHARACTERS; ++c)
+        __ncurses_utils_widths[c / 4] |=
+            (uint8_t) (__ncurses_utils_measure_uncached(c) << (c % 4 * 2));
+}
 
-    const gunichar *iter = str;
-    while (*iter) {
-        width += ncurses_measure_character(*iter);
-        iter++;
-    }
+int ncurses_measure_character(unichar_t c) {
+    if (c < 0x80)
+        return c >= 0x20 && c < 0x7F; /* Only control characters aren't printable */
+    if (c >= NCURSES_UTILS_CACHED_CHARACTERS)
+        return __ncurses_utils_measure_uncached(c);
 
+    pthread_once(&__ncurses_utils_widths_once, __ncurses_utils_init_widths);
+    return (__ncurses_utils_widths[c / 4] >> (c % 4 * 2)) & 3;
+}
+
+size_t ncurses_measure_unicode_string(const unichar_t *str) {
+    size_t width = 0;
+    for (; *str; ++str)
+        width += ncurses_measure_character(*str);
     return width;
 }
 
 size_t ncurses_measure_string(const char *str) {
+    const uint8_t       *in  = (const uint8_t *) str;
+    const uint8_t *const end = in + strlen(str);
+
     size_t width = 0;
-    while (*str) {
-        width += ncurses_measure_character(g_utf8_get_char(str));
-
-        /* Pragmas to fix bad const in glib's macro */
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-        str = g_utf8_next_char(str);
-#pragma GCC diagnostic pop
+    while (in < end) {
+        unichar_t c;
+        if (*in < 0x80)
+            c = *in++;
+        else
+            in += __ncurses_utils_decode(in, end, &c);
+        width += ncurses_measure_character(c);
     }
     return width;
 }
@@ -104,10 +286,8 @@ size_t ncurses_prefix_from_maximum_length(const unichar_t *str, size_t max, size
     const gunichar *iter = str;
     while (*iter) {
         const size_t new_width = acc_width + ncurses_measure_character(*iter);
-        if (new_width > max) {
-            iter++;
+        if (new_width > max)
             break;
-        }
 
         acc_width = new_width;
         iter++;
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+
 /**
  * @file  screen_loading_dataset.c
  * @brief Implementation of methods in include/interactive_mode/screen_loading_dataset.h
@@ -21,39 +22,140 @@
 
 #include <glib.h>
 #include <ncurses.h>
+#include <stdio.h>
 
 #include "interactive_mode/ncurses_utils.h"
+#include "interactive_mode/screen_loading_dataset.h"
 #include "utils/int_utils.h"
 
-void screen_loading_dataset_render(void) {
-    const char *const message_utf8 = "Loading dataset. The application will become unresponsive.";
-    unichar_t *const  message      = g_utf8_to_ucs4_fast(message_utf8, strlen(message_utf8), NULL);
-    const size_t      text_width   = ncurses_measure_unicode_string(message);
+/** @brief Width of the box on the screen (without borders), when the window is large enough. */
+#define SCREEN_LOADING_DATASET_WIDTH 50
+
+/** @brief Height of the box on the screen (without borders), when showing progress. */
+#define SCREEN_LOADING_DATASET_HEIGHT 13
+
+/** @brief Names of the files in a dataset, indexed by ::performance_metrics_dataset_step_t. */
+const char *const screen_loading_dataset_file_names[PERFORMANCE_METRICS_DATASET_FILE_COUNT] = {
+    "users.csv",
+    "flights.csv",
+    "passengers.csv",
+    "reservations.csv"};
+
+/**
+ * @brief Renders a line of text inside the box on the screen, truncating it if needed.
+ *
+ * @param x     Horizontal position of the first character.
+ * @param y     Vertical position of the line.
+ * @param width Maximum width of the line.
+ * @param text  UTF-8 text to be rendered.
+ */
+void __screen_loading_dataset_put_line(int x, int y, int width, const char *text) {
+    unichar_t *const line = ncurses_utf8_to_unicode(text, NULL);
+    if (!line)
+        return;
+
+    const size_t max_chars = ncurses_prefix_from_maximum_length(line, max(width, 0), NULL);
+    move(y, x);
+    ncurses_put_wide_string(line, max_chars);
+    g_free(line);
+}
+
+/**
+ * @brief  Calculates how much of a file has been loaded.
+ *
+ * @param  bytes       Number of bytes already loaded.
+ * @param  total_bytes Total number of bytes.
+ *
+ * @return A value between `0` and `1`. Empty files are always fully loaded.
+ */
+double __screen_loading_dataset_fraction(size_t bytes, size_t total_bytes) {
+    if (!total_bytes)
+        return 1.0;
+    return bytes >= total_bytes ? 1.0 : (double) bytes / total_bytes;
+}
+
+/**
+ * @brief Renders the progress of loading a dataset inside the box on the screen.
+ *
+ * @param progress Progress of loading each file.
+ * @param x        Horizontal position of the first column inside the box.
+ * @param y        Vertical position of the first line inside the box.
+ * @param width    Width of the box without borders.
+ */
+void __screen_loading_dataset_render_progress(const screen_loading_dataset_progress_t *progress,
+                                              int                                      x,
+                                              int                                      y,
+                                              int                                      width) {
+    char   line[256];
+    size_t done = 0, total = 0;
+
+    for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_FILE_COUNT; ++i) {
+        const double fraction =
+            __screen_loading_dataset_fraction(progress->bytes[i], progress->total_bytes[i]);
+
+        snprintf(line,
+                 sizeof(line),
+                 "%-16s %4d%% %11zu rows",
+                 screen_loading_dataset_file_names[i],
+                 (int) (fraction * 100),
+                 progress->rows[i]);
+        __screen_loading_dataset_put_line(x, y + 2 + i, width, line);
+
+        done += min(progress->bytes[i], progress->total_bytes[i]);
+        total += progress->total_bytes[i];
+    }
+
+    /* Overall progress bar */
+    const double fraction  = __screen_loading_dataset_fraction(done, total);
+    const int    bar_width = max(width - 7, 0); /* Brackets and percentage */
+    const int    filled    = (int) (fraction * bar_width);
+
+    move(y + 7, x);
+    addch('[');
+    for (int i = 0; i < bar_width; ++i)
+        addch(i < filled ? '#' : ' ');
+    printw("] %3d%%", (int) (fraction * 100));
+
+    /* Throughput and estimated time remaining */
+    if (progress->elapsed > 0.0 && done) {
+        const double throughput = done / progress->elapsed;
+        const int    remaining  = (int) ((total - done) / throughput);
+
+        snprintf(line,
+                 sizeof(line),
+                 "%.1f MiB/s, %02d:%02d remaining",
+                 throughput / (1024.0 * 1024.0),
+                 remaining / 60,
+                 remaining % 60);
+        __screen_loading_dataset_put_line(x, y + 8, width, line);
+    }
+
+    __screen_loading_dataset_put_line(x, y + 10, width, "ESC to cancel, ENTER to hide");
+}
 
-    clear();
+void screen_loading_dataset_render(const screen_loading_dataset_progress_t *progress) {
+    erase(); /* Only repaint what changed since the last render */
 
     int window_width, window_height;
     getmaxyx(stdscr, window_height, window_width);
 
-    if (window_width < 5 || window_height < 7) { /* Don't attempt rendering on small windows */
-        g_free(message);
+    /* Don't attempt rendering on small windows */
+    const int box_height = progress ? SCREEN_LOADING_DATASET_HEIGHT : 3;
+    if (window_width < (progress ? 24 : 5) || window_height < box_height + 4) {
+        refresh();
         return;
     }
 
     /* Reference diagram for positions and sizes: see header file */
 
-    const int box_width  = min((size_t) window_width - 4, text_width + 2);
-    const int box_height = 3;
+    const int box_width = min(window_width - 4, SCREEN_LOADING_DATASET_WIDTH);
     const int box_x = (window_width - box_width) / 2, box_y = (window_height - box_height) / 2;
 
-    /* Render box and message */
     ncurses_render_rectangle(box_x, box_y, box_width, box_height);
+    __screen_loading_dataset_put_line(box_x + 1, box_y + 1, box_width - 2, "Loading dataset ...");
 
-    const size_t max_chars =
-        ncurses_prefix_from_maximum_length(message, max(box_width - 3, 0), NULL);
-    move(box_y + 1, box_x + 1);
-    ncurses_put_wide_string(message, max_chars);
+    if (progress)
+        __screen_loading_dataset_render_progress(progress, box_x + 1, box_y + 1, box_width - 2);
 
     refresh();
-    g_free(message);
 }
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  screen_running_queries.c
+ * @brief Implementation of methods in include/interactive_mode/screen_running_queries.h
+ */
+
+#include <glib.h>
+#include <ncurses.h>
+#include <stdio.h>
+
+#include "interactive_mode/ncurses_utils.h"
+#include "interactive_mode/screen_running_queries.h"
+#include "utils/int_utils.h"
+
+/** @brief Width of the box on the screen (without borders), when the window is large enough. */
+#define SCREEN_RUNNING_QUERIES_WIDTH 50
+
+/**
+ * @brief Height of the box on the screen (without borders), without counting the lines of each
+ *        query type.
+ */
+#define SCREEN_RUNNING_QUERIES_BASE_HEIGHT 9
+
+/**
+ * @brief Renders a line of text inside the box on the screen, truncating it if needed.
+ *
+ * @param x     Horizontal position of the first character.
+ * @param y     Vertical position of the line.
+ * @param width Maximum width of the line.
+ * @param text  UTF-8 text to be rendered.
+ */
+void __screen_running_queries_put_line(int x, int y, int width, const char *text) {
+    unichar_t *const line = ncurses_utf8_to_unicode(text, NULL);
+    if (!line)
+        return;
+
+    const size_t max_chars = ncurses_prefix_from_maximum_length(line, max(width, 0), NULL);
+    move(y, x);
+    ncurses_put_wide_string(line, max_chars);
+    g_free(line);
+}
+
+/**
+ * @brief Renders the progress of running queries inside the box on the screen.
+ *
+ * @param progress Progress of the queries being run.
+ * @param elapsed  Number of seconds since queries started being executed.
+ * @param x        Horizontal position of the first column inside the box.
+ * @param y        Vertical position of the first line inside the box.
+ * @param width    Width of the box without borders.
+ */
+void __screen_running_queries_render_progress(const query_dispatcher_progress_t *progress,
+                                              double                             elapsed,
+                                              int                                x,
+                                              int                                y,
+                                              int                                width) {
+    char line[256];
+    int  done = 0, total = 0, ntypes = 0;
+
+    for (size_t i = 1; i <= QUERY_TYPE_LIST_COUNT; ++i) {
+        if (!progress->total[i])
+            continue;
+
+        snprintf(line,
+                 sizeof(line),
+                 "Query %-6zu %4d%% %11d / %d",
+                 i,
+                 progress->done[i] * 100 / progress->total[i],
+                 progress->done[i],
+                 progress->total[i]);
+        __screen_running_queries_put_line(x, y + 2 + ntypes, width, line);
+
+        done += progress->done[i];
+        total += progress->total[i];
+        ntypes++;
+    }
+
+    /* Overall progress bar */
+    const double fraction  = total ? (double) done / total : 1.0;
+    const int    bar_width = max(width - 7, 0); /* Brackets and percentage */
+    const int    filled    = (int) (fraction * bar_width);
+
+    move(y + 3 + ntypes, x);
+    addch('[');
+    for (int i = 0; i < bar_width; ++i)
+        addch(i < filled ? '#' : ' ');
+    printw("] %3d%%", (int) (fraction * 100));
+
+    /* Throughput and estimated time remaining */
+    if (elapsed > 0.0 && done) {
+        const double throughput = done / elapsed;
+        const int    remaining  = (int) ((total - done) / throughput);
+
+        snprintf(line,
+                 sizeof(line),
+                 "%.1f queries/s, %02d:%02d remaining",
+                 throughput,
+                 remaining / 60,
+                 remaining % 60);
+        __screen_running_queries_put_line(x, y + 4 + ntypes, width, line);
+    }
+
+    __screen_running_queries_put_line(x, y + 6 + ntypes, width, "ESC to cancel");
+}
+
+void screen_running_queries_render(const query_dispatcher_progress_t *progress, double elapsed) {
+    erase(); /* Only repaint what changed since the last render */
+
+    int ntypes = 0;
+    for (size_t i = 1; i <= QUERY_TYPE_LIST_COUNT; ++i)
+        if (progress->total[i])
+            ntypes++;
+
+    int window_width, window_height;
+    getmaxyx(stdscr, window_height, window_width);
+
+    /* Don't attempt rendering on small windows */
+    const int box_height = SCREEN_RUNNING_QUERIES_BASE_HEIGHT + ntypes;
+    if (window_width < 24 || window_height < box_height + 4) {
+        refresh();
+        return;
+    }
+
+    /* Reference diagram for positions and sizes: see header file */
+
+    const int box_width = min(window_width - 4, SCREEN_RUNNING_QUERIES_WIDTH);
+    const int box_x = (window_width - box_width) / 2, box_y = (window_height - box_height) / 2;
+
+    ncurses_render_rectangle(box_x, box_y, box_width, box_height);
+    __screen_running_queries_put_line(box_x + 1,
+                                      box_y + 1,
+                                      box_width - 2,
+                                      progress->executing ? "Running queries ..."
+                                                          : "Preparing statistical data ...");
+    __screen_running_queries_render_progress(progress,
+                                             elapsed,
+                                             box_x + 1,
+                                             box_y + 1,
+                                             box_width - 2);
+
+    refresh();
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  load.c
+ * @brief Contains the entry point to the load generator program.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "load_mode.h"
+#include "utils/int_utils.h"
+
+/**
+ * @brief Parses the value of a numeric command-line option.
+ *
+ * @param output Where to write the parsed value to, only on success.
+ * @param value  Value of the option. Can be `NULL`, if the option was the last argument.
+ *
+ * @retval 0 Success.
+ * @retval 1 Missing or invalid value.
+ */
+int __load_parse_count(size_t *output, const char *value) {
+    uint64_t parsed;
+    if (!value || int_utils_parse_positive(&parsed, value))
+        return 1;
+
+    *output = parsed;
+    return 0;
+}
+
+/**
+ * @brief Parses the value of a positive real command-line option.
+ *
+ * @param output Where to write the parsed value to, only on success.
+ * @param value  Value of the option. Can be `NULL`, if the option was the last argument.
+ *
+ * @retval 0 Success.
+ * @retval 1 Missing or invalid value.
+ */
+int __load_parse_real(double *output, const char *value) {
+    if (!value || !*value)
+        return 1;
+
+    char        *end;
+    const double parsed = strtod(value, &end);
+    if (*end || !isfinite(parsed) || parsed <= 0)
+        return 1;
+
+    *output = parsed;
+    return 0;
+}
+
+/**
+ * @brief The entry point to the load generator program.
+ * @retval 0 Success
+ * @retval 1 Failure
+ */
+int main(int argc, char **argv) {
+    load_mode_options_t options = {.arrivals    = LOAD_MODE_ARRIVALS_RECORDED,
+                                   .rate        = 0,
+                                   .speed       = 1,
+                                   .repetitions = 1,
+                                   .connections = 16,
+                                   .binary      = 0,
+                                   .compress    = 0};
+
+    int poisson = 0, valid = argc >= 3;
+    for (int i = 3; valid && i < argc; ++i) {
+        const char *const value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-q") == 0) {
+            valid = !__load_parse_real(&options.rate, value);
+            i++;
+        } else if (strcmp(argv[i], "-s") == 0) {
+            valid = !__load_parse_real(&options.speed, value);
+            i++;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            valid = !__load_parse_count(&options.repetitions, value);
+            i++;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            valid = !__load_parse_count(&options.connections, value);
+            i++;
+        } else if (strcmp(argv[i], "-p") == 0) {
+            poisson = 1;
+        } else if (strcmp(argv[i], "-b") == 0) {
+            options.binary = 1;
+        } else if (strcmp(argv[i], "-z") == 0) {
+            options.compress = 1;
+        } else {
+            valid = 0;
+        }
+    }
+
+    /* -p needs a rate, and -z the binary protocol */
+    if (options.rate > 0)
+        options.arrivals = poisson ? LOAD_MODE_ARRIVALS_POISSON : LOAD_MODE_ARRIVALS_UNIFORM;
+    if (!valid || options.repetitions == 0 || options.connections == 0 ||
+        (poisson && options.arrivals == LOAD_MODE_ARRIVALS_RECORDED) ||
+        (options.compress && !options.binary)) {
+        fputs("Invalid command-line arguments! Usage:\n", stderr);
+        fputs("./programa-carga [socket] [workload file] [-q queries per second [-p]] "
+              "[-s speed] [-r repetitions] [-c connections] [-b [-z]]\n",
+              stderr);
+        return 1;
+    }
+
+    options.socket_path   = argv[1];
+    options.workload_path = argv[2];
+    return load_mode_run(&options);
+}
@@ -0,0 +1,966 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  load_mode.c
+ * @brief Implementation of methods in load_mode.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref load_mode_examples).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "load_mode.h"
+#include "queries/query_tokenizer.h"
+#include "queries/query_type_list.h"
+#include "server_mode.h"
+#include "testing/latency_histogram.h"
+#include "testing/workload.h"
+#include "utils/table.h"
+
+/** @brief Number of bytes read from a socket at once. */
+#define LOAD_MODE_READ_BUFFER_SIZE 65536
+
+/** @brief Maximum number of events handled for every call to `epoll_wait`. */
+#define LOAD_MODE_EPOLL_EVENTS 64
+
+/** @brief Size of a reply in the binary protocol, until its payload (see server_mode.h). */
+#define LOAD_MODE_REPLY_HEADER_SIZE 18
+
+/** @brief Seed of the random numbers that generate Poisson arrivals, for reproducible loads. */
+#define LOAD_MODE_POISSON_SEED 0x4c4933
+
+/**
+ * @struct load_mode_request_t
+ * @brief  A query to be sent to the server.
+ *
+ * @var load_mode_request_t::query
+ *     @brief Query, in the workload.
+ * @var load_mode_request_t::type
+ *     @brief Number of the query, or `0` if it isn't a valid query number.
+ * @var load_mode_request_t::due
+ *     @brief When the query must be sent, in nanoseconds since the start of the load.
+ * @var load_mode_request_t::connection
+ *     @brief Index of the connection the query was sent through.
+ * @var load_mode_request_t::done
+ *     @brief Whether the query was answered (or failed).
+ */
+typedef struct {
+    const char *query;
+    size_t      type;
+    uint64_t    due;
+    size_t      connection;
+    int         done;
+} load_mode_request_t;
+
+/**
+ * @struct load_mode_connection_t
+ * @brief  A connection to the server.
+ *
+ * @var load_mode_connection_t::fd
+ *     @brief Socket connected to the server.
+ * @var load_mode_connection_t::events
+ *     @brief Events `epoll` is waiting for on ::load_mode_connection_t::fd.
+ * @var load_mode_connection_t::input
+ *     @brief Data received from the server, that isn't a complete reply yet.
+ * @var load_mode_connection_t::output
+ *     @brief Queries not yet completely sent to the server.
+ * @var load_mode_connection_t::sent
+ *     @brief Number of bytes in ::load_mode_connection_t::output already sent.
+ * @var load_mode_connection_t::pending
+ *     @brief   Indices of the requests sent in text, and not yet answered, in order.
+ *     @details Only the ones from ::load_mode_connection_t::pending_head onwards are pending.
+ * @var load_mode_connection_t::pending_head
+ *     @brief Index of the oldest request in ::load_mode_connection_t::pending.
+ * @var load_mode_connection_t::remaining_lines
+ *     @brief Number of lines left in the text reply being received, or `-1` if its first line
+ *            hasn't been received.
+ * @var load_mode_connection_t::handshaken
+ *     @brief Whether the server echoed ::SERVER_MODE_BINARY_MAGIC, in binary connections.
+ * @var load_mode_connection_t::failed
+ *     @brief Whether the connection was closed, due to an error.
+ */
+typedef struct {
+    int      fd;
+    uint32_t events;
+    GString *input, *output;
+    size_t   sent;
+
+    GArray *pending;
+    size_t  pending_head;
+    long    remaining_lines;
+    int     handshaken, failed;
+} load_mode_connection_t;
+
+/**
+ * @struct load_mode_t
+ * @brief  State of a load test.
+ *
+ * @var load_mode_t::options
+ *     @brief Configuration of the load test.
+ * @var load_mode_t::requests
+ *     @brief Queries to be sent, ordered by when they're due.
+ * @var load_mode_t::nrequests
+ *     @brief Number of elements in ::load_mode_t::requests.
+ * @var load_mode_t::next
+ *     @brief Index of the next request to be sent.
+ * @var load_mode_t::ncompleted
+ *     @brief Number of requests answered (or failed).
+ * @var load_mode_t::connections
+ *     @brief Connections to the server.
+ * @var load_mode_t::nalive
+ *     @brief Number of connections in ::load_mode_t::connections that haven't failed.
+ * @var load_mode_t::next_connection
+ *     @brief Index of the connection the next request should be sent through.
+ * @var load_mode_t::start
+ *     @brief When the load started (`CLOCK_MONOTONIC`).
+ * @var load_mode_t::end
+ *     @brief When the last request was completed, in nanoseconds since the start of the load.
+ * @var load_mode_t::max_delay
+ *     @brief Longest time between a request being due and it being sent, in nanoseconds.
+ * @var load_mode_t::received
+ *     @brief Number of bytes received from the server.
+ * @var load_mode_t::latencies
+ *     @brief Latencies (in microseconds) of successful requests of each query type, with the
+ *            ones of requests that don't start with a valid query number in index `0`.
+ * @var load_mode_t::total_latencies
+ *     @brief Latencies (in microseconds) of all successful requests.
+ * @var load_mode_t::nfailed
+ *     @brief Number of failed requests of each query type (indexed like ::load_mode_t::latencies).
+ * @var load_mode_t::epoll_fd
+ *     @brief `epoll` instance waiting for events on all connections and on ::load_mode_t::timer_fd.
+ * @var load_mode_t::timer_fd
+ *     @brief `timerfd` that expires when the next request is due.
+ */
+typedef struct {
+    const load_mode_options_t *options;
+
+    load_mode_request_t *requests;
+    size_t               nrequests, next, ncompleted;
+
+    load_mode_connection_t *connections;
+    size_t                  nalive, next_connection;
+
+    struct timespec      start;
+    uint64_t             end, max_delay, received;
+    latency_histogram_t *latencies[QUERY_TYPE_LIST_COUNT + 1], *total_latencies;
+    size_t               nfailed[QUERY_TYPE_LIST_COUNT + 1];
+
+    int epoll_fd, timer_fd;
+} load_mode_t;
+
+/**
+ * @brief  Gets the time elapsed since the start of a load test.
+ * @param  load Load test.
+ * @return The elapsed time, in nanoseconds.
+ */
+uint64_t __load_mode_now(const load_mode_t *load) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) ((now.tv_sec - load->start.tv_sec) * 1000000000 +
+                       (now.tv_nsec - load->start.tv_nsec));
+}
+
+/**
+ * @brief  Gets the number of a query, from its first characters.
+ * @param  query Query.
+ * @return The number of @p query, or `0` if it doesn't start with a valid query number.
+ */
+size_t __load_mode_get_type(const char *query) {
+    size_t type = 0;
+    for (; *query >= '0' && *query <= '9'; ++query) {
+        type = type * 10 + (size_t) (*query - '0');
+        if (type > QUERY_TYPE_LIST_COUNT)
+            return 0;
+    }
+    return type;
+}
+
+/**
+ * @brief  Generates a random number, uniformly distributed in `[0, 1)`.
+ * @param  state State of the generator (SplitMix64), updated by this function.
+ * @return The generated number.
+ */
+double __load_mode_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z          = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    z          = z ^ (z >> 31);
+    return (double) (z >> 11) / (double) (UINT64_C(1) << 53);
+}
+
+/**
+ * @brief Creates the requests of a load test, with the times they're due.
+ *
+ * @param load     Load test, whose ::load_mode_t::requests are to be created.
+ * @param workload Queries to be sent.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure, or too many requests.
+ */
+int __load_mode_schedule(load_mode_t *load, const workload_t *workload) {
+    const load_mode_options_t *const options = load->options;
+    const size_t                     length  = workload_get_length(workload);
+
+    if (options->repetitions > UINT32_MAX / (length ? length : 1))
+        return 1; /* Identifiers of binary requests are 32-bit */
+    load->nrequests = length * options->repetitions;
+    load->requests  = malloc(sizeof(load_mode_request_t) * (load->nrequests ? load->nrequests : 1));
+    if (!load->requests)
+        return 1;
+
+    /* Repetitions of a recording are one microsecond apart */
+    const uint64_t span  = length ? workload_get_time(workload, length - 1) + 1 : 0;
+    uint64_t       state = LOAD_MODE_POISSON_SEED;
+    double         time  = 0; /* In seconds */
+
+    for (size_t i = 0; i < load->nrequests; ++i) {
+        const size_t repetition = i / length, j = i % length;
+        if (options->arrivals == LOAD_MODE_ARRIVALS_RECORDED)
+            time = (double) (repetition * span + workload_get_time(workload, j)) / 1e6 /
+                   options->speed;
+        else if (options->arrivals == LOAD_MODE_ARRIVALS_UNIFORM)
+            time = (double) i / options->rate;
+        else if (i > 0)
+            time += -log(1 - __load_mode_random(&state)) / options->rate;
+
+        load->requests[i].query      = workload_get_query(workload, j);
+        load->requests[i].type       = __load_mode_get_type(load->requests[i].query);
+        load->requests[i].due        = (uint64_t) (time * 1e9);
+        load->requests[i].connection = 0;
+        load->requests[i].done       = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Marks a request as completed, recording its latency or failure.
+ *
+ * @param load   Load test.
+ * @param index  Index of the request in ::load_mode_t::requests. Requests already completed are
+ *               ignored.
+ * @param failed Whether the query failed.
+ */
+void __load_mode_complete(load_mode_t *load, size_t index, int failed) {
+    load_mode_request_t *const request = load->requests + index;
+    if (request->done)
+        return;
+
+    request->done = 1;
+    load->ncompleted++;
+    load->end = __load_mode_now(load);
+
+    if (failed) {
+        load->nfailed[request->type]++;
+    } else {
+        const uint64_t latency = (load->end - request->due) / 1000;
+        latency_histogram_record(load->latencies[request->type], latency);
+        latency_histogram_record(load->total_latencies, latency);
+    }
+}
+
+/**
+ * @brief Writes a little-endian integer in the binary protocol.
+ *
+ * @param output Where to append the integer to.
+ * @param value  Integer to be written.
+ * @param nbytes Size of the integer, in bytes.
+ */
+void __load_mode_write_integer(GString *output, uint64_t value, size_t nbytes) {
+    for (size_t i = 0; i < nbytes; ++i)
+        g_string_append_c(output, (char) (value >> (8 * i)));
+}
+
+/**
+ * @brief   Parses a non-negative integer in a query token.
+ * @details Auxiliary method for ::__load_mode_encode_binary.
+ *
+ * @param token  Token to be parsed.
+ * @param output Where to write the parsed integer to.
+ *
+ * @retval 0 Parsing success.
+ * @retval 1 Parsing failure (not only decimal digits, or too large a number).
+ */
+int __load_mode_parse_size(query_tokenizer_span_t token, uint64_t *output) {
+    *output = 0;
+    for (size_t i = 0; i < token.length; ++i) {
+        const unsigned int d = token.begin[i] - '0';
+        if (d >= 10 || *output > (UINT64_MAX - 1 - d) / 10)
+            return 1;
+        *output = *output * 10 + d;
+    }
+    return token.length == 0;
+}
+
+/**
+ * @brief   Encodes a text query as a request of the binary protocol.
+ * @details The query is tokenized like by [the query parser](@ref query_parser.h), including its
+ *          optional `LIMIT` and `OFFSET` clauses.
+ *
+ * @param query    Text query.
+ * @param id       Identifier of the request.
+ * @param compress Whether to ask for a compressed reply.
+ * @param output   Where to append the request to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Invalid query, or one that can't be sent in the binary protocol.
+ */
+int __load_mode_encode_binary(const char *query, uint32_t id, int compress, GString *output) {
+    const char            *iter = query;
+    query_tokenizer_span_t type;
+    if (query_tokenizer_next(&iter, &type))
+        return 1;
+
+    /* Query number, followed by F and / or A (see query_parser.h) */
+    unsigned char flags = compress ? SERVER_MODE_REQUEST_COMPRESS : 0;
+    while (type.length > 0) {
+        const char suffix = type.begin[type.length - 1];
+        if (suffix == 'F' && !(flags & SERVER_MODE_REQUEST_FORMATTED))
+            flags |= SERVER_MODE_REQUEST_FORMATTED;
+        else if (suffix == 'A' && !(flags & SERVER_MODE_REQUEST_APPROXIMATE))
+            flags |= SERVER_MODE_REQUEST_APPROXIMATE;
+        else
+            break;
+        type.length--;
+    }
+
+    uint64_t number;
+    if (__load_mode_parse_size(type, &number) || number > UINT8_MAX)
+        return 1;
+
+    query_tokenizer_span_t tokens[SERVER_MODE_MAX_ARGUMENTS + 4];
+    size_t                 argc = 0;
+    while (!query_tokenizer_next(&iter, tokens + argc))
+        if (++argc == SERVER_MODE_MAX_ARGUMENTS + 4)
+            return 1;
+
+    /* Optional page of results, at the end: [LIMIT n] [OFFSET m] */
+    uint64_t          page[2] = {0, UINT64_MAX};
+    const char *const keywords[2] = {"OFFSET", "LIMIT"};
+    for (size_t i = 0; i < 2; ++i) {
+        if (argc < 2)
+            break;
+
+        const query_tokenizer_span_t key = tokens[argc - 2];
+        if (key.length != strlen(keywords[i]) || memcmp(key.begin, keywords[i], key.length) ||
+            (key.begin > query && key.begin[-1] == '"'))
+            continue;
+        if (__load_mode_parse_size(tokens[argc - 1], page + i))
+            return 1;
+        argc -= 2;
+    }
+
+    if (argc > SERVER_MODE_MAX_ARGUMENTS)
+        return 1;
+    for (size_t i = 0; i < argc; ++i)
+        if (tokens[i].length > UINT16_MAX)
+            return 1;
+
+    const size_t start = output->len;
+    __load_mode_write_integer(output, 0, 4); /* Size, written at the end */
+    __load_mode_write_integer(output, id, 4);
+    __load_mode_write_integer(output, number, 1);
+    __load_mode_write_integer(output, flags, 1);
+    __load_mode_write_integer(output, argc, 1);
+    __load_mode_write_integer(output, page[0], 8);
+    __load_mode_write_integer(output, page[1], 8);
+    for (size_t i = 0; i < argc; ++i) {
+        __load_mode_write_integer(output, tokens[i].length, 2);
+        g_string_append_len(output, tokens[i].begin, (gssize) tokens[i].length);
+        g_string_append_c(output, '\0');
+    }
+
+    const size_t size = output->len - start - 4;
+    for (size_t i = 0; i < 4; ++i)
+        output->str[start + i] = (char) (size >> (8 * i));
+    return 0;
+}
+
+/**
+ * @brief   Closes a connection after an error, failing the requests waiting for a reply on it.
+ * @details Later requests are sent through other connections.
+ *
+ * @param load  Load test.
+ * @param index Index of the connection in ::load_mode_t::connections.
+ */
+void __load_mode_fail_connection(load_mode_t *load, size_t index) {
+    load_mode_connection_t *const connection = load->connections + index;
+    if (connection->failed)
+        return;
+
+    connection->failed = 1;
+    load->nalive--;
+    epoll_ctl(load->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    shutdown(connection->fd, SHUT_RDWR);
+
+    for (size_t i = 0; i < load->next; ++i)
+        if (load->requests[i].connection == index)
+            __load_mode_complete(load, i, 1);
+}
+
+/**
+ * @brief   Sends as much pending output as possible to the server, without blocking.
+ * @details The connection is failed on IO errors.
+ *
+ * @param load  Load test.
+ * @param index Index of the connection in ::load_mode_t::connections.
+ */
+void __load_mode_flush(load_mode_t *load, size_t index) {
+    load_mode_connection_t *const connection = load->connections + index;
+    while (connection->sent < connection->output->len) {
+        const ssize_t ret = send(connection->fd,
+                                 connection->output->str + connection->sent,
+                                 connection->output->len - connection->sent,
+                                 MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                __load_mode_fail_connection(load, index);
+            return;
+        }
+        connection->sent += ret;
+    }
+
+    g_string_truncate(connection->output, 0);
+    connection->sent = 0;
+}
+
+/**
+ * @brief   Writes a request to the output of the next available connection.
+ * @details Requests that can't be sent (no connections left, or queries that can't be encoded in
+ *          the binary protocol) fail immediately.
+ *
+ * @param load  Load test.
+ * @param index Index of the request in ::load_mode_t::requests.
+ */
+void __load_mode_send(load_mode_t *load, size_t index) {
+    load_mode_request_t *const request = load->requests + index;
+
+    const uint64_t delay = __load_mode_now(load) - request->due;
+    if (delay > load->max_delay)
+        load->max_delay = delay;
+
+    if (!load->nalive) {
+        __load_mode_complete(load, index, 1);
+        return;
+    }
+
+    while (load->connections[load->next_connection].failed)
+        load->next_connection = (load->next_connection + 1) % load->options->connections;
+    load_mode_connection_t *const connection = load->connections + load->next_connection;
+    request->connection                      = load->next_connection;
+    load->next_connection = (load->next_connection + 1) % load->options->connections;
+
+    if (load->options->binary) {
+        if (__load_mode_encode_binary(request->query,
+                                      (uint32_t) index,
+                                      load->options->compress,
+                                      connection->output))
+            __load_mode_complete(load, index, 1);
+    } else {
+        g_string_append(connection->output, request->query);
+        g_string_append_c(connection->output, '\n');
+        g_array_append_val(connection->pending, index);
+    }
+}
+
+/**
+ * @brief   Removes the oldest request waiting for a text reply on a connection.
+ * @details Auxiliary method for ::__load_mode_parse_text.
+ *
+ * @param connection Connection with, at least, one pending request.
+ *
+ * @return The index of the removed request in ::load_mode_t::requests.
+ */
+size_t __load_mode_pop_pending(load_mode_connection_t *connection) {
+    const size_t index = g_array_index(connection->pending, size_t, connection->pending_head++);
+    if (connection->pending_head == connection->pending->len) {
+        g_array_set_size(connection->pending, 0);
+        connection->pending_head = 0;
+    }
+    return index;
+}
+
+/**
+ * @brief   Handles the complete lines received from the server, on a text connection.
+ * @details Every reply is a line with the number of lines of output (or `-1`), followed by those
+ *          lines (see server_mode.h). As replies come in order, they're matched to the oldest
+ *          pending requests.
+ *
+ * @param load  Load test.
+ * @param index Index of the connection in ::load_mode_t::connections.
+ */
+void __load_mode_parse_text(load_mode_t *load, size_t index) {
+    load_mode_connection_t *const connection = load->connections + index;
+    GString *const                input      = connection->input;
+    size_t                        position   = 0;
+
+    while (!connection->failed) {
+        const char *const line    = input->str + position;
+        const char *const newline = memchr(line, '\n', input->len - position);
+        if (!newline)
+            break;
+        position += (size_t) (newline - line) + 1;
+
+        if (connection->remaining_lines < 0) {
+            char      *end;
+            const long nlines = strtol(line, &end, 10);
+            if (end != newline || nlines < -1 ||
+                connection->pending_head == connection->pending->len) {
+                __load_mode_fail_connection(load, index); /* Unexpected reply */
+                break;
+            }
+
+            if (nlines <= 0)
+                __load_mode_complete(load, __load_mode_pop_pending(connection), nlines < 0);
+            else
+                connection->remaining_lines = nlines;
+        } else if (--connection->remaining_lines == 0) {
+            __load_mode_complete(load, __load_mode_pop_pending(connection), 0);
+            connection->remaining_lines = -1;
+        }
+    }
+
+    g_string_erase(input, 0, (gssize) position);
+}
+
+/**
+ * @brief   Handles the complete frames received from the server, on a binary connection.
+ * @details Replies are matched to requests by their identifiers. Payloads aren't decompressed.
+ *
+ * @param load  Load test.
+ * @param index Index of the connection in ::load_mode_t::connections.
+ */
+void __load_mode_parse_binary(load_mode_t *load, size_t index) {
+    load_mode_connection_t *const connection   = load->connections + index;
+    GString *const                input        = connection->input;
+    const size_t                  magic_length = strlen(SERVER_MODE_BINARY_MAGIC);
+    size_t                        position     = 0;
+
+    if (!connection->handshaken) {
+        if (input->len < magic_length)
+            return;
+        if (memcmp(input->str, SERVER_MODE_BINARY_MAGIC, magic_length)) {
+            __load_mode_fail_connection(load, index); /* The server doesn't speak binary */
+            return;
+        }
+
+        connection->handshaken = 1;
+        position               = magic_length;
+    }
+
+    while (!connection->failed && input->len - position >= 4) {
+        const unsigned char *const frame = (const unsigned char *) input->str + position;
+        const size_t               size  = (size_t) frame[0] | (size_t) frame[1] << 8 |
+                             (size_t) frame[2] << 16 | (size_t) frame[3] << 24;
+        if (size < LOAD_MODE_REPLY_HEADER_SIZE - 4) {
+            __load_mode_fail_connection(load, index);
+            break;
+        } else if (input->len - position - 4 < size) {
+            break;
+        }
+
+        const size_t id = (size_t) frame[4] | (size_t) frame[5] << 8 | (size_t) frame[6] << 16 |
+                          (size_t) frame[7] << 24;
+        if (id >= load->next || load->requests[id].connection != index) {
+            __load_mode_fail_connection(load, index); /* Unexpected reply */
+            break;
+        }
+
+        __load_mode_complete(load, id, frame[8] != 0);
+        position += 4 + size;
+    }
+
+    g_string_erase(input, 0, (gssize) position);
+}
+
+/**
+ * @brief   Receives as much input as possible from the server, without blocking, and handles the
+ *          complete replies in it.
+ * @details The connection is failed on IO errors, or if the server disconnects.
+ *
+ * @param load  Load test.
+ * @param index Index of the connection in ::load_mode_t::connections.
+ */
+void __load_mode_receive(load_mode_t *load, size_t index) {
+    load_mode_connection_t *const connection = load->connections + index;
+
+    char buffer[LOAD_MODE_READ_BUFFER_SIZE];
+    while (!connection->failed) {
+        const ssize_t ret = recv(connection->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                __load_mode_fail_connection(load, index);
+            break;
+        } else if (ret == 0) {
+            __load_mode_fail_connection(load, index);
+            break;
+        }
+
+        load->received += (uint64_t) ret;
+        g_string_append_len(connection->input, buffer, ret);
+        if (load->options->binary)
+            __load_mode_parse_binary(load, index);
+        else
+            __load_mode_parse_text(load, index);
+    }
+}
+
+/**
+ * @brief Updates the events a connection is waiting for, after its output changes.
+ *
+ * @param load  Load test.
+ * @param index Index of the connection in ::load_mode_t::connections.
+ */
+void __load_mode_update_events(load_mode_t *load, size_t index) {
+    load_mode_connection_t *const connection = load->connections + index;
+    if (connection->failed)
+        return;
+
+    const uint32_t events = EPOLLIN | (connection->output->len ? EPOLLOUT : 0);
+    if (events != connection->events) {
+        struct epoll_event event = {.events = events, .data.ptr = connection};
+        if (epoll_ctl(load->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event))
+            __load_mode_fail_connection(load, index);
+        else
+            connection->events = events;
+    }
+}
+
+/**
+ * @brief Connects to the server, and starts waiting for events on all connections.
+ *
+ * @param load Load test, whose ::load_mode_t::connections were allocated.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure (connections that were created are left in ::load_mode_t::connections, with
+ *           ::load_mode_connection_t::fd set to `-1` for the others).
+ */
+int __load_mode_connect(load_mode_t *load) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(load->options->socket_path) >= sizeof(address.sun_path))
+        return 1;
+    strcpy(address.sun_path, load->options->socket_path);
+
+    for (size_t i = 0; i < load->options->connections; ++i) {
+        load_mode_connection_t *const connection = load->connections + i;
+
+        connection->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connection->fd < 0)
+            return 1;
+
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = connection};
+        if (connect(connection->fd, (struct sockaddr *) &address, sizeof(address)) ||
+            fcntl(connection->fd, F_SETFL, O_NONBLOCK) ||
+            epoll_ctl(load->epoll_fd, EPOLL_CTL_ADD, connection->fd, &event))
+            return 1;
+
+        connection->events = EPOLLIN;
+        load->nalive++;
+        if (load->options->binary)
+            g_string_append(connection->output, SERVER_MODE_BINARY_MAGIC);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Sets ::load_mode_t::timer_fd to expire when the next request is due.
+ * @param load Load test.
+ */
+void __load_mode_arm_timer(load_mode_t *load) {
+    struct itimerspec timer = {0};
+    if (load->next < load->nrequests) {
+        const uint64_t due    = load->requests[load->next].due;
+        timer.it_value.tv_sec = load->start.tv_sec + (time_t) (due / 1000000000);
+        timer.it_value.tv_nsec = load->start.tv_nsec + (long) (due % 1000000000);
+        if (timer.it_value.tv_nsec >= 1000000000) {
+            timer.it_value.tv_sec++;
+            timer.it_value.tv_nsec -= 1000000000;
+        }
+    }
+
+    /* A zeroed expiration time would disarm the timer */
+    if (load->next < load->nrequests && !timer.it_value.tv_sec && !timer.it_value.tv_nsec)
+        timer.it_value.tv_nsec = 1;
+    timerfd_settime(load->timer_fd, TFD_TIMER_ABSTIME, &timer, NULL);
+}
+
+/**
+ * @brief Sends requests when they're due and handles replies, until all requests are completed.
+ *
+ * @param load Load test, already connected to the server.
+ *
+ * @retval 0 Success.
+ * @retval 1 `epoll_wait` failure, or all connections were closed.
+ */
+int __load_mode_run_loop(load_mode_t *load) {
+    struct epoll_event events[LOAD_MODE_EPOLL_EVENTS];
+
+    while (load->ncompleted < load->nrequests) {
+        const uint64_t now = __load_mode_now(load);
+        while (load->next < load->nrequests && load->requests[load->next].due <= now)
+            __load_mode_send(load, load->next++);
+
+        for (size_t i = 0; i < load->options->connections; ++i) {
+            if (!load->connections[i].failed && load->connections[i].output->len)
+                __load_mode_flush(load, i);
+            __load_mode_update_events(load, i);
+        }
+
+        if (!load->nalive) {
+            fputs("All connections to the server were closed!\n", stderr);
+            return 1;
+        }
+        if (load->ncompleted == load->nrequests)
+            break;
+
+        __load_mode_arm_timer(load);
+        const int n = epoll_wait(load->epoll_fd, events, LOAD_MODE_EPOLL_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fputs("Failed to wait for events!\n", stderr);
+            return 1;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.ptr == &load->timer_fd) {
+                uint64_t expirations;
+                while (read(load->timer_fd, &expirations, sizeof(expirations)) < 0 &&
+                       errno == EINTR)
+                    ;
+                continue;
+            }
+
+            load_mode_connection_t *const connection = events[i].data.ptr;
+            const size_t                  index      = (size_t) (connection - load->connections);
+            if (connection->failed)
+                continue; /* Failed while handling previous events */
+
+            if (events[i].events & EPOLLOUT)
+                __load_mode_flush(load, index);
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                __load_mode_receive(load, index);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Prints the results of a load test to `stdout`.
+ * @param load Load test, whose requests were all completed.
+ */
+void __load_mode_print(const load_mode_t *load) {
+    const double seconds = (double) load->end / 1e9;
+    const double offered =
+        load->nrequests ? (double) load->requests[load->nrequests - 1].due / 1e9 : 0;
+
+    size_t nfailed = 0;
+    for (size_t i = 0; i <= QUERY_TYPE_LIST_COUNT; ++i)
+        nfailed += load->nfailed[i];
+
+    printf("Sent %zu queries in %.3lf s", load->nrequests, offered);
+    if (offered > 0)
+        printf(" (%.1lf queries/s offered)", (double) load->nrequests / offered);
+    printf("\nAnswered %zu queries in %.3lf s", load->nrequests - nfailed, seconds);
+    if (seconds > 0)
+        printf(" (%.1lf queries/s)", (double) (load->nrequests - nfailed) / seconds);
+    printf(", %zu failed\n", nfailed);
+    printf("Received %.2lf MiB, sent queries at most %.3lf ms after they were due\n\n",
+           (double) load->received / (1024 * 1024),
+           (double) load->max_delay / 1e6);
+
+    size_t nrows = 1;
+    for (size_t i = 0; i <= QUERY_TYPE_LIST_COUNT; ++i)
+        nrows += latency_histogram_get_count(load->latencies[i]) || load->nfailed[i];
+
+    table_t *const table = table_create(10, nrows + 1);
+    if (!table) {
+        fputs("Failed to allocate table!\n", stderr);
+        return;
+    }
+
+    const char *const titles[9] = {"Count",
+                                   "Failed",
+                                   "Throughput (queries/s)",
+                                   "Mean (ms)",
+                                   "p50 (ms)",
+                                   "p90 (ms)",
+                                   "p99 (ms)",
+                                   "p99.9 (ms)",
+                                   "Max (ms)"};
+    for (size_t i = 0; i < 9; ++i)
+        table_insert_format(table, i + 1, 0, "%s", titles[i]);
+
+    /* Unknown queries come after all query types, and all queries after those */
+    size_t row = 1;
+    for (size_t i = 1; i <= QUERY_TYPE_LIST_COUNT + 2; ++i) {
+        const int                        total     = i == QUERY_TYPE_LIST_COUNT + 2;
+        const size_t                     type      = total ? 0 : i % (QUERY_TYPE_LIST_COUNT + 1);
+        const size_t                     failed    = total ? nfailed : load->nfailed[type];
+        const latency_histogram_t *const histogram =
+            total ? load->total_latencies : load->latencies[type];
+
+        const uint64_t count = latency_histogram_get_count(histogram);
+        if (!total && !count && !failed)
+            continue;
+
+        if (total)
+            table_insert_format(table, 0, row, "All queries");
+        else if (type)
+            table_insert_format(table, 0, row, "Query %zu", type);
+        else
+            table_insert_format(table, 0, row, "Unknown");
+
+        table_insert_format(table, 1, row, "%" PRIu64, count + failed);
+        table_insert_format(table, 2, row, "%zu", failed);
+        if (seconds > 0)
+            table_insert_format(table, 3, row, "%.1lf", (double) count / seconds);
+        if (count) {
+            const double percentiles[4] = {50.0, 90.0, 99.0, 99.9};
+            table_insert_format(table,
+                                4,
+                                row,
+                                "%.3lf",
+                                (double) latency_histogram_get_total(histogram) / count / 1000);
+            for (size_t j = 0; j < 4; ++j)
+                table_insert_format(
+                    table,
+                    j + 5,
+                    row,
+                    "%.3lf",
+                    (double) latency_histogram_get_percentile(histogram, percentiles[j]) / 1000);
+            table_insert_format(table,
+                                9,
+                                row,
+                                "%.3lf",
+                                (double) latency_histogram_get_max(histogram) / 1000);
+        }
+        row++;
+    }
+
+    table_draw(stdout, table);
+    table_free(table);
+}
+
+int load_mode_run(const load_mode_options_t *options) {
+    int         ret  = 1;
+    load_mode_t load = {.options = options, .epoll_fd = -1, .timer_fd = -1};
+
+    workload_t *const workload = workload_load(options->workload_path);
+    if (!workload) {
+        fputs("Failed to load workload!\n", stderr);
+        return 1;
+    }
+    if (options->arrivals == LOAD_MODE_ARRIVALS_RECORDED && !workload_has_times(workload)) {
+        fputs("Workload has no recorded times! Choose a query rate.\n", stderr);
+        goto DEFER_1;
+    }
+
+    if (__load_mode_schedule(&load, workload)) {
+        fputs("Failed to schedule queries!\n", stderr);
+        goto DEFER_1;
+    }
+
+    for (size_t i = 0; i <= QUERY_TYPE_LIST_COUNT; ++i)
+        if (!(load.latencies[i] = latency_histogram_create()))
+            goto DEFER_2;
+    if (!(load.total_latencies = latency_histogram_create()))
+        goto DEFER_2;
+
+    load.connections = malloc(sizeof(load_mode_connection_t) * options->connections);
+    if (!load.connections)
+        goto DEFER_2;
+    for (size_t i = 0; i < options->connections; ++i)
+        load.connections[i] = (load_mode_connection_t){.fd              = -1,
+                                                       .input           = g_string_new(""),
+                                                       .output          = g_string_new(""),
+                                                       .pending         = g_array_new(FALSE,
+                                                                              FALSE,
+                                                                              sizeof(size_t)),
+                                                       .remaining_lines = -1};
+
+    load.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    load.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (load.epoll_fd < 0 || load.timer_fd < 0) {
+        fputs("Failed to create event loop!\n", stderr);
+        goto DEFER_3;
+    }
+
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = &load.timer_fd};
+    if (epoll_ctl(load.epoll_fd, EPOLL_CTL_ADD, load.timer_fd, &event)) {
+        fputs("Failed to create event loop!\n", stderr);
+        goto DEFER_3;
+    }
+
+    if (__load_mode_connect(&load)) {
+        fprintf(stderr, "Failed to connect to %s!\n", options->socket_path);
+        goto DEFER_3;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &load.start);
+    if (__load_mode_run_loop(&load))
+        goto DEFER_3;
+
+    __load_mode_print(&load);
+    ret = 0;
+
+DEFER_3:
+    for (size_t i = 0; i < options->connections; ++i) {
+        if (load.connections[i].fd >= 0)
+            close(load.connections[i].fd);
+        g_string_free(load.connections[i].input, TRUE);
+        g_string_free(load.connections[i].output, TRUE);
+        g_array_free(load.connections[i].pending, TRUE);
+    }
+    free(load.connections);
+    if (load.epoll_fd >= 0)
+        close(load.epoll_fd);
+    if (load.timer_fd >= 0)
+        close(load.timer_fd);
+DEFER_2:
+    for (size_t i = 0; i <= QUERY_TYPE_LIST_COUNT; ++i)
+        if (load.latencies[i])
+            latency_histogram_free(load.latencies[i]);
+    if (load.total_latencies)
+        latency_histogram_free(load.total_latencies);
+    free(load.requests);
+DEFER_1:
+    workload_free(workload);
+    return ret;
+}
@@ -18,28 +18,235 @@
  * @file  main.c
  * @brief Contains the entry point to main the program.
  */
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 
 #include "batch_mode.h"
+#include "export_mode.h"
 #include "interactive_mode/interactive_mode.h"
+#include "partitioned_mode.h"
+#include "queries/query_dispatcher.h"
+#include "queries/query_file_compiler.h"
+#include "server_mode.h"
+#include "testing/event_trace.h"
+#include "utils/block_allocator.h"
 
 /**
- * @brief  The entry point to the main program.
+ * @brief Parses the batch window of server mode (see ::server_mode_run).
+ *
+ * @param str    Command-line argument, a number of microseconds.
+ * @param output Where to write the parsed value to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure.
+ */
+int __main_parse_batch_window(const char *str, unsigned long *output) {
+    char *end;
+    *output = strtoul(str, &end, 10);
+    return !*str || *str == '-' || *end;
+}
+
+/**
+ * @brief Parses the port of the metrics endpoint of server mode (see ::server_mode_run).
+ *
+ * @param str    Command-line argument, a TCP port number, or `0` to disable the endpoint.
+ * @param output Where to write the parsed value to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure.
+ */
+int __main_parse_metrics_port(const char *str, unsigned short *output) {
+    char *end;
+    const unsigned long port = strtoul(str, &end, 10);
+    *output                  = (unsigned short) port;
+    return !*str || *str == '-' || *end || port > 65535;
+}
+
+/**
+ * @brief Parses the number of shards of partitioned mode (see ::partitioned_mode_run).
+ *
+ * @param str    Command-line argument, a positive number.
+ * @param output Where to write the parsed value to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure.
+ */
+int __main_parse_shards(const char *str, size_t *output) {
+    char *end;
+    *output = strtoul(str, &end, 10);
+    return !*str || *str == '-' || *end || *output == 0;
+}
+
+/**
+ * @brief Parses the memory budget for statistical data (see
+ *        ::query_dispatcher_set_statistics_budget).
+ *
+ * @param str    Command-line argument, a positive number of mebibytes.
+ * @param output Where to write the parsed value to, in bytes.
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure.
+ */
+int __main_parse_statistics_budget(const char *str, size_t *output) {
+    char               *end;
+    const unsigned long mebibytes = strtoul(str, &end, 10);
+    *output                       = (size_t) mebibytes * 1024 * 1024;
+    return !*str || *str == '-' || *end || mebibytes == 0 || mebibytes > SIZE_MAX / 1024 / 1024;
+}
+
+/**
+ * @brief  Runs the mode of the program chosen by the command-line arguments.
+ * @param  argc      Number of command-line arguments in @p argv.
+ * @param  argv      Command-line arguments, not including the ones of event tracing, memory limits
+ *                   and caching.
+ * @param  cache_dir Directory where to keep data across runs, or `NULL` not to keep any.
  * @retval 0 Success.
  * @retval 1 Insuccess.
  */
-int main(int argc, char **argv) {
+int __main_run_mode(int argc, char **argv, const char *cache_dir) {
+    unsigned long  window;
+    unsigned short port;
+    size_t         shards;
     if (argc == 1) {
         return interactive_mode_run();
     } else if (argc == 3) {
-        return batch_mode_run(argv[1], argv[2], NULL);
+        return batch_mode_run_streaming(argv[1], cache_dir, argv[2], NULL, 0);
+    } else if (argc == 4 && strcmp(argv[1], "-c") == 0) {
+        return batch_mode_run_streaming(argv[2], cache_dir, argv[3], BATCH_MODE_CONTAINER_PATH, 0);
+    } else if (argc == 4 && strcmp(argv[1], "-b") == 0) {
+        return batch_mode_run_streaming(argv[2], cache_dir, argv[3], NULL, 1);
+    } else if (argc == 4 && strcmp(argv[1], "-s") == 0) {
+        return server_mode_run(argv[2],
+                               cache_dir,
+                               argv[3],
+                               SERVER_MODE_DEFAULT_BATCH_WINDOW,
+                               0,
+                               NULL);
+    } else if (argc == 5 && strcmp(argv[1], "-s") == 0 &&
+               !__main_parse_batch_window(argv[4], &window)) {
+        return server_mode_run(argv[2], cache_dir, argv[3], window, 0, NULL);
+    } else if ((argc == 6 || argc == 7) && strcmp(argv[1], "-s") == 0 &&
+               !__main_parse_batch_window(argv[4], &window) &&
+               !__main_parse_metrics_port(argv[5], &port)) {
+        return server_mode_run(argv[2],
+                               cache_dir,
+                               argv[3],
+                               window,
+                               port,
+                               argc == 7 ? argv[6] : NULL);
+    } else if (argc >= 4 && strcmp(argv[1], "-j") == 0) {
+        return batch_mode_run_jobs(argv[2], cache_dir, argc - 3, argv + 3);
+    } else if (argc == 5 && strcmp(argv[1], "-p") == 0 && !__main_parse_shards(argv[4], &shards)) {
+        return partitioned_mode_run(argv[2], argv[3], shards);
+    } else if (argc == 4 && strcmp(argv[1], "-e") == 0) {
+        return export_mode_run(argv[2], cache_dir, argv[3]);
+    } else if (argc == 4 && strcmp(argv[1], "-q") == 0) {
+        if (query_file_compiler_compile(argv[2], argv[3])) {
+            fputs("Failed to compile query file!\n", stderr);
+            return 1;
+        }
     } else {
         fputs("Invalid command-line arguments! Usage:\n\n", stderr);
         fputs("./programa-principal - Interactive mode\n", stderr);
         fputs("./programa-principal [dataset] [query file] - Batch mode\n", stderr);
+        fputs("./programa-principal -c [dataset] [query file] - Batch mode (outputs in "
+              BATCH_MODE_CONTAINER_PATH ")\n",
+              stderr);
+        fputs("./programa-principal -b [dataset] [query file] - Batch mode (binary outputs)\n",
+              stderr);
+        fputs("./programa-principal -s [dataset] [socket path] (batch window in us) "
+              "(metrics port, or 0) (workload file to record) - Server mode\n",
+              stderr);
+        fputs("./programa-principal -j [dataset] [query files...] - Batch mode (one process per "
+              "query file, sharing the database)\n",
+              stderr);
+        fputs("./programa-principal -p [dataset] [query file] [shards] - Partitioned mode (dataset "
+              "split among many processes)\n",
+              stderr);
+        fputs("./programa-principal -e [dataset] [output directory] - Export mode (tables as "
+              "Arrow IPC files)\n",
+              stderr);
+        fputs("./programa-principal -q [query file] [compiled query file] - Compile a query file "
+              "(accepted by the batch modes instead of it)\n",
+              stderr);
+        fputs("\nAny mode can be preceded by -t [trace file], to write a timeline of what every "
+              "thread did (Chrome's trace event format)\n",
+              stderr);
+        fputs("Any of the above can be preceded by -o [spill directory], to keep the dataset in "
+              "files there, for datasets larger than memory,\n",
+              stderr);
+        fputs("and by -m [MiB], to limit the memory taken by the statistical data of each query "
+              "type\n",
+              stderr);
+        fputs("Batch, server and export modes only keep data across runs (snapshots of the "
+              "dataset, statistical data and\n",
+              stderr);
+        fputs("query outputs) when preceded by -k [cache directory], which is created if it "
+              "doesn't exist\n",
+              stderr);
         return 1;
     }
 
     return 0;
 }
+
+/**
+ * @brief  The entry point to the main program.
+ * @retval 0 Success.
+ * @retval 1 Insuccess.
+ */
+int main(int argc, char **argv) {
+    /* The program's name is replaced by other arguments, but it isn't used by any mode */
+    const char *cache_dir = NULL;
+    while (argc >= 3 && (strcmp(argv[1], "-o") == 0 || strcmp(argv[1], "-m") == 0 ||
+                         strcmp(argv[1], "-k") == 0)) {
+        size_t budget;
+        if (strcmp(argv[1], "-k") == 0) {
+            if (mkdir(argv[2], 0755) && errno != EEXIST) {
+                fputs("Failed to create cache directory!\n", stderr);
+                return 1;
+            }
+            cache_dir = argv[2];
+        } else if (strcmp(argv[1], "-o") == 0) {
+            if (block_allocator_set_spill_directory(argv[2])) {
+                fputs("Spill directory path is too long!\n", stderr);
+                return 1;
+            }
+        } else if (__main_parse_statistics_budget(argv[2], &budget)) {
+            fputs("Invalid memory budget for statistical data!\n", stderr);
+            return 1;
+        } else {
+            query_dispatcher_set_statistics_budget(budget);
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc < 3 || strcmp(argv[1], "-t") != 0)
+        return __main_run_mode(argc, argv, cache_dir);
+
+    const char *const    trace_path = argv[2];
+    event_trace_t *const trace      = event_trace_start(0);
+    if (!trace)
+        fputs("Failed to start the event trace! Continuing without it.\n", stderr);
+
+    const int retval = __main_run_mode(argc - 2, argv + 2, cache_dir);
+    if (trace) {
+        event_trace_stop(trace);
+
+        size_t dropped;
+        event_trace_get_event_count(trace, &dropped);
+        if (dropped)
+            fprintf(stderr, "%zu trace events were dropped (buffer full)!\n", dropped);
+
+        if (event_trace_write_file(trace, trace_path))
+            fputs("Failed to write the event trace!\n", stderr);
+        event_trace_free(trace);
+    }
+    return retval;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  microbenchmark.c
+ * @brief Contains the entry point to the microbenchmark program.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "testing/microbenchmarks.h"
+#include "utils/int_utils.h"
+
+/**
+ * @brief The entry point to the microbenchmark program.
+ * @retval 0 Success
+ * @retval 1 Failure
+ */
+int main(int argc, char **argv) {
+    microbenchmarks_options_t options = {.filter = NULL, .repetitions = 5, .max_size = 1000000};
+
+    int valid = 1;
+    for (int i = 1; valid && i < argc; i += 2) {
+        const char *const value  = i + 1 < argc ? argv[i + 1] : NULL;
+        uint64_t          parsed = 0;
+
+        if (!value) {
+            valid = 0;
+        } else if (strcmp(argv[i], "-f") == 0) {
+            options.filter = value;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            valid               = !int_utils_parse_positive(&parsed, value);
+            options.repetitions = parsed;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            valid            = !int_utils_parse_positive(&parsed, value);
+            options.max_size = parsed;
+        } else {
+            valid = 0;
+        }
+    }
+
+    if (!valid || options.repetitions == 0 || options.max_size == 0) {
+        fputs("Invalid command-line arguments! Usage:\n", stderr);
+        fputs("./programa-microbenchmark [-f name filter] [-r repetitions] [-n maximum size]\n",
+              stderr);
+        return 1;
+    }
+
+    return microbenchmarks_run(&options);
+}
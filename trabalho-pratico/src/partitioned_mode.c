@@ -0,0 +1,1013 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  partitioned_mode.c
+ * @brief Implementation of methods in include/partitioned_mode.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref partitioned_mode_examples).
+ */
+
+#include <errno.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "dataset/dataset_loader.h"
+#include "dataset/dataset_partitioner.h"
+#include "partitioned_mode.h"
+#include "queries/query_dispatcher.h"
+#include "queries/query_parser.h"
+#include "queries/query_tokenizer.h"
+#include "types/flight_id.h"
+#include "types/reservation_id.h"
+#include "utils/int_utils.h"
+
+/**
+ * @brief Format of the path of the directory where a dataset's shards are kept, given the path of
+ *        the dataset (a string) and the number of shards (a `size_t`).
+ */
+#define PARTITIONED_MODE_PARTITION_PATH_FORMAT "%s/.shards_%zu"
+
+/** @brief Name of the file, in a shard's directory, where a snapshot of its database is kept. */
+#define PARTITIONED_MODE_SNAPSHOT_FILE_NAME ".database_snapshot"
+
+/**
+ * @brief   Prefix of requests for the ratings of a hotel (followed by the hotel's identifier).
+ * @details Shards reply with a line containing the sum of the ratings and their count, so that
+ *          the average rating (query 3) can be calculated across shards.
+ */
+#define PARTITIONED_MODE_RATINGS_REQUEST "R "
+
+/**
+ * @brief Number of airports asked to each shard, for queries of type 6, so that all airports are
+ *        listed, and the top airports can be chosen after counts are merged.
+ */
+#define PARTITIONED_MODE_ALL_AIRPORTS "1000000000"
+
+/** @brief Maximum number of arguments of the queries routed by the coordinator. */
+#define PARTITIONED_MODE_MAX_ARGUMENTS 3
+
+/**
+ * @struct partitioned_mode_shard_t
+ * @brief  A worker process, as seen by the coordinator.
+ *
+ * @var partitioned_mode_shard_t::pid
+ *     @brief Identifier of the process.
+ * @var partitioned_mode_shard_t::requests
+ *     @brief Where to write requests (queries) to. `NULL` if it couldn't be opened.
+ * @var partitioned_mode_shard_t::replies
+ *     @brief Where to read replies from. `NULL` if it couldn't be opened.
+ */
+typedef struct {
+    pid_t pid;
+    FILE *requests;
+    FILE *replies;
+} partitioned_mode_shard_t;
+
+/**
+ * @brief Reads a line from a stream.
+ *
+ * @param file Stream to read from.
+ *
+ * @return The line, without its terminator, that must be `free`d, or `NULL` on end of file or
+ *         allocation failure.
+ */
+char *__partitioned_mode_read_line(FILE *file) {
+    char         *line = NULL;
+    size_t        size = 0;
+    const ssize_t read = getline(&line, &size, file);
+    if (read <= 0) {
+        free(line);
+        return NULL;
+    }
+
+    if (line[read - 1] == '\n')
+        line[read - 1] = '\0';
+    return line;
+}
+
+/**
+ * @brief Opens a stream on a socket.
+ *
+ * @param fd   Socket to open a stream on, closed on failure. Can be negative (failure).
+ * @param mode Mode of the stream (see `fdopen`).
+ *
+ * @return The stream, or `NULL` on failure.
+ */
+FILE *__partitioned_mode_open_stream(int fd, const char *mode) {
+    FILE *const file = fd >= 0 ? fdopen(fd, mode) : NULL;
+    if (!file && fd >= 0)
+        close(fd);
+    return file;
+}
+
+/**
+ * @brief Answers a request for the ratings of a hotel (::PARTITIONED_MODE_RATINGS_REQUEST).
+ *
+ * @param database Database of the shard.
+ * @param hotel    Identifier of the hotel.
+ * @param output   Where to write the reply to.
+ */
+void __partitioned_mode_answer_ratings(const database_t *database,
+                                       const char       *hotel,
+                                       FILE             *output) {
+    hotel_id_t id;
+    if (hotel_id_from_string(&id, hotel)) {
+        fputs("-1\n", output);
+        return;
+    }
+
+    uint64_t sum;
+    size_t   count;
+    reservation_manager_get_hotel_ratings(database_get_reservations(database), id, &sum, &count);
+    fprintf(output, "1\n%" PRIu64 ";%zu\n", sum, count);
+}
+
+/**
+ * @brief   Answers a query sent to a shard.
+ * @details Output is always formatted, so that the coordinator knows the name of every field.
+ *
+ * @param database Database of the shard.
+ * @param cache    Statistical data kept from previous queries. Can be `NULL`.
+ * @param query    Query to be answered.
+ * @param output   Where to write the reply to.
+ */
+void __partitioned_mode_answer_query(const database_t         *database,
+                                     query_statistics_cache_t *cache,
+                                     const char               *query,
+                                     FILE                     *output) {
+    query_instance_t *const instance = query_instance_create(NULL);
+    query_writer_t *const   writer   = query_writer_create(NULL, 1);
+
+    if (!instance || !writer || query_parser_parse_string_const(NULL, instance, query) ||
+        query_dispatcher_dispatch_single(database, cache, instance, writer)) {
+        fputs("-1\n", output);
+    } else {
+        size_t                   nlines;
+        const char *const *const lines = query_writer_get_lines(writer, &nlines);
+
+        fprintf(output, "%zu\n", nlines);
+        for (size_t i = 0; i < nlines; ++i) {
+            fputs(lines[i], output);
+            fputc('\n', output);
+        }
+    }
+
+    if (writer)
+        query_writer_free(writer);
+    if (instance)
+        query_instance_free(instance);
+}
+
+/**
+ * @brief   Runs a worker process, that answers requests from the coordinator about a shard.
+ * @details Requests are answered in order, until the coordinator closes the socket.
+ *
+ * @param shard_path Path to the directory containing the shard.
+ * @param socket     Socket connected to the coordinator.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message will also be printed to `stderr`.
+ */
+int __partitioned_mode_run_shard(const char *shard_path, int socket) {
+    int retval = 0;
+
+    char snapshot_path[PATH_MAX];
+    snprintf(snapshot_path, PATH_MAX, "%s/" PARTITIONED_MODE_SNAPSHOT_FILE_NAME, shard_path);
+    database_t *const database = dataset_loader_load_cached(shard_path, NULL, snapshot_path, NULL);
+    if (!database) {
+        close(socket);
+        fputs("Failed to load dataset shard!\n", stderr);
+        return 1;
+    }
+
+    FILE *const input  = __partitioned_mode_open_stream(dup(socket), "r");
+    FILE *const output = __partitioned_mode_open_stream(socket, "w");
+    if (!input || !output) {
+        retval = 1;
+        fputs("Failed to communicate with coordinator!\n", stderr);
+        goto DEFER_1;
+    }
+
+    /* Without a cache (allocation failure), statistical data is generated for every query */
+    query_statistics_cache_t *const cache = query_statistics_cache_create();
+
+    char *request;
+    while ((request = __partitioned_mode_read_line(input))) {
+        if (strncmp(request,
+                    PARTITIONED_MODE_RATINGS_REQUEST,
+                    strlen(PARTITIONED_MODE_RATINGS_REQUEST)) == 0)
+            __partitioned_mode_answer_ratings(database,
+                                              request + strlen(PARTITIONED_MODE_RATINGS_REQUEST),
+                                              output);
+        else
+            __partitioned_mode_answer_query(database, cache, request, output);
+
+        free(request);
+        if (fflush(output)) {
+            retval = 1;
+            fputs("Failed to communicate with coordinator!\n", stderr);
+            break;
+        }
+    }
+
+    if (cache)
+        query_statistics_cache_free(cache);
+
+DEFER_1:
+    if (input)
+        fclose(input);
+    if (output)
+        fclose(output);
+    database_free(database);
+    return retval;
+}
+
+/**
+ * @brief Frees the replies of many shards.
+ *
+ * @param replies Replies to be `free`d (some may be `NULL`).
+ * @param n       Number of elements in @p replies.
+ */
+void __partitioned_mode_free_replies(GPtrArray *replies[], size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        if (replies[i])
+            g_ptr_array_unref(replies[i]);
+}
+
+/**
+ * @brief   Sends the same request to many shards, and waits for all their replies.
+ * @details The request is sent to all shards before any reply is read, so that shards can work on
+ *          it at the same time.
+ *
+ * @param shards  Shards to send @p request to.
+ * @param nshards Number of elements in @p shards.
+ * @param request Request to be sent.
+ * @param replies Where to write the lines of the reply of each shard to. A reply is `NULL` when
+ *                the request failed in that shard. Must be `free`d with
+ *                ::__partitioned_mode_free_replies, even on failure.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure (e.g.: a worker process died).
+ */
+int __partitioned_mode_scatter(partitioned_mode_shard_t *shards,
+                               size_t                    nshards,
+                               const char               *request,
+                               GPtrArray                *replies[nshards]) {
+    for (size_t i = 0; i < nshards; ++i)
+        replies[i] = NULL;
+
+    for (size_t i = 0; i < nshards; ++i)
+        if (fputs(request, shards[i].requests) == EOF || fputc('\n', shards[i].requests) == EOF ||
+            fflush(shards[i].requests))
+            return 1;
+
+    for (size_t i = 0; i < nshards; ++i) {
+        char *const header = __partitioned_mode_read_line(shards[i].replies);
+        if (!header)
+            return 1;
+
+        const long nlines = strtol(header, NULL, 10);
+        free(header);
+        if (nlines < 0)
+            continue; /* Failed request */
+
+        replies[i] = g_ptr_array_new_with_free_func(free);
+        for (long j = 0; j < nlines; ++j) {
+            char *const line = __partitioned_mode_read_line(shards[i].replies);
+            if (!line)
+                return 1;
+            g_ptr_array_add(replies[i], line);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Splits the formatted output of a query into objects.
+ * @details Lines in @p reply are modified, so that keys and values become different strings.
+ *
+ * @param reply Lines of formatted output. Can be `NULL`, for no objects.
+ *
+ * @return An array of objects, each an array of keys and values (alternated), pointing to the
+ *         lines in @p reply. Must be `free`d with `g_ptr_array_unref`.
+ */
+GPtrArray *__partitioned_mode_get_objects(GPtrArray *reply) {
+    GPtrArray *const objects = g_ptr_array_new_with_free_func((GDestroyNotify) g_ptr_array_unref);
+    if (!reply)
+        return objects;
+
+    GPtrArray *object = NULL;
+    for (size_t i = 0; i < reply->len; ++i) {
+        char *const line = g_ptr_array_index(reply, i);
+        if (strncmp(line, "--- ", 4) == 0) {
+            object = g_ptr_array_new();
+            g_ptr_array_add(objects, object);
+            continue;
+        }
+
+        char *const separator = strstr(line, ": ");
+        if (!object || !separator)
+            continue; /* Empty line between objects */
+
+        *separator = '\0';
+        g_ptr_array_add(object, line);
+        g_ptr_array_add(object, separator + 2);
+    }
+
+    return objects;
+}
+
+/**
+ * @brief Gets the value of a field of an object in the output of a query.
+ *
+ * @param object Object from ::__partitioned_mode_get_objects.
+ * @param key    Name of the field.
+ *
+ * @return The field's value, or `NULL` if @p object doesn't have that field.
+ */
+const char *__partitioned_mode_get_field(const GPtrArray *object, const char *key) {
+    for (size_t i = 0; i + 1 < object->len; i += 2)
+        if (strcmp(g_ptr_array_index(object, i), key) == 0)
+            return g_ptr_array_index(object, i + 1);
+    return NULL;
+}
+
+/**
+ * @brief Gets the value of a numeric field of an object in the output of a query.
+ *
+ * @param object Object from ::__partitioned_mode_get_objects.
+ * @param key    Name of the field.
+ *
+ * @return The field's value, or `0` if @p object doesn't have that field.
+ */
+uint64_t __partitioned_mode_get_unsigned(const GPtrArray *object, const char *key) {
+    const char *const value = __partitioned_mode_get_field(object, key);
+    return value ? strtoull(value, NULL, 10) : 0;
+}
+
+/**
+ * @brief Writes an object (from another query's output) to a query writer.
+ *
+ * @param writer       Where to write @p object to.
+ * @param object       Object from ::__partitioned_mode_get_objects.
+ * @param replaced_key Field whose value is replaced by @p replaced. Can be `NULL`.
+ * @param replaced     New value of the field @p replaced_key.
+ */
+void __partitioned_mode_write_object(query_writer_t  *writer,
+                                     const GPtrArray *object,
+                                     const char      *replaced_key,
+                                     uint64_t         replaced) {
+    query_writer_write_new_object(writer);
+    for (size_t i = 0; i + 1 < object->len; i += 2) {
+        const char *const key   = g_ptr_array_index(object, i);
+        const char *const value = g_ptr_array_index(object, i + 1);
+
+        if (replaced_key && strcmp(key, replaced_key) == 0)
+            query_writer_write_new_field_unsigned(writer, key, replaced);
+        else
+            query_writer_write_new_field_string(writer, key, value);
+    }
+}
+
+/**
+ * @brief Sends a query to a single shard, and writes its output unmodified.
+ *
+ * @param shard  Shard to send @p query to.
+ * @param query  Query to be answered.
+ * @param writer Where to write the output of @p query to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int __partitioned_mode_forward(partitioned_mode_shard_t *shard,
+                               const char               *query,
+                               query_writer_t           *writer) {
+    GPtrArray *reply;
+    const int  retval = __partitioned_mode_scatter(shard, 1, query, &reply);
+
+    GPtrArray *const objects = __partitioned_mode_get_objects(retval ? NULL : reply);
+    for (size_t i = 0; i < objects->len; ++i)
+        __partitioned_mode_write_object(writer, g_ptr_array_index(objects, i), NULL, 0);
+
+    g_ptr_array_unref(objects);
+    __partitioned_mode_free_replies(&reply, 1);
+    return retval;
+}
+
+/**
+ * @brief   Answers a query of type 1 about a flight or a reservation, by asking all shards.
+ * @details A reservation is only found in the shard of its user. A flight is found in all
+ *          shards, but each one only knows some of its passengers, that are summed.
+ *
+ * @param shards    All shards.
+ * @param nshards   Number of elements in @p shards.
+ * @param query     Query to be answered.
+ * @param is_flight Whether @p query is about a flight.
+ * @param writer    Where to write the output of @p query to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int __partitioned_mode_merge_q01(partitioned_mode_shard_t *shards,
+                                 size_t                    nshards,
+                                 const char               *query,
+                                 int                       is_flight,
+                                 query_writer_t           *writer) {
+    GPtrArray *replies[nshards];
+    int        retval = __partitioned_mode_scatter(shards, nshards, query, replies);
+    if (retval)
+        goto DEFER_1;
+
+    GPtrArray *found      = NULL;
+    uint64_t   passengers = 0;
+    for (size_t i = 0; i < nshards; ++i) {
+        GPtrArray *const objects = __partitioned_mode_get_objects(replies[i]);
+        if (objects->len) {
+            passengers += __partitioned_mode_get_unsigned(g_ptr_array_index(objects, 0),
+                                                          "passengers");
+            if (!found)
+                found = g_ptr_array_ref(objects);
+        }
+        g_ptr_array_unref(objects);
+    }
+
+    if (found) {
+        __partitioned_mode_write_object(writer,
+                                        g_ptr_array_index(found, 0),
+                                        is_flight ? "passengers" : NULL,
+                                        passengers);
+        g_ptr_array_unref(found);
+    }
+
+DEFER_1:
+    __partitioned_mode_free_replies(replies, nshards);
+    return retval;
+}
+
+/**
+ * @brief Answers a query of type 3, by summing the ratings of the hotel in all shards.
+ *
+ * @param shards  All shards.
+ * @param nshards Number of elements in @p shards.
+ * @param hotel   Identifier of the hotel.
+ * @param writer  Where to write the output of the query to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int __partitioned_mode_merge_q03(partitioned_mode_shard_t *shards,
+                                 size_t                    nshards,
+                                 const char               *hotel,
+                                 query_writer_t           *writer) {
+    char request[LINE_MAX];
+    snprintf(request, LINE_MAX, PARTITIONED_MODE_RATINGS_REQUEST "%s", hotel);
+
+    GPtrArray *replies[nshards];
+    const int  retval = __partitioned_mode_scatter(shards, nshards, request, replies);
+
+    int      found = 0;
+    uint64_t sum   = 0;
+    size_t   count = 0;
+    for (size_t i = 0; i < nshards && !retval; ++i) {
+        uint64_t shard_sum;
+        size_t   shard_count;
+        if (replies[i] && replies[i]->len == 1 &&
+            sscanf(g_ptr_array_index(replies[i], 0),
+                   "%" SCNu64 ";%zu",
+                   &shard_sum,
+                   &shard_count) == 2) {
+            found = 1;
+            sum += shard_sum;
+            count += shard_count;
+        }
+    }
+
+    if (found) {
+        query_writer_write_new_object(writer);
+        query_writer_write_new_field_decimal(writer, "rating", (double) sum / (double) count);
+    }
+
+    __partitioned_mode_free_replies(replies, nshards);
+    return retval;
+}
+
+/**
+ * @struct partitioned_mode_q06_item_t
+ * @brief  Number of passengers of an airport, summed across all shards.
+ *
+ * @var partitioned_mode_q06_item_t::name
+ *     @brief Airport code (a string in a shard's reply).
+ * @var partitioned_mode_q06_item_t::passengers
+ *     @brief Number of passengers in the airport.
+ */
+typedef struct {
+    const char *name;
+    uint64_t    passengers;
+} partitioned_mode_q06_item_t;
+
+/**
+ * @brief Comparison function for ::partitioned_mode_q06_item_t, in the same order as in query 6.
+ */
+int __partitioned_mode_q06_compare(gconstpointer a, gconstpointer b) {
+    const partitioned_mode_q06_item_t *const item_a = a;
+    const partitioned_mode_q06_item_t *const item_b = b;
+
+    if (item_a->passengers != item_b->passengers)
+        return item_a->passengers > item_b->passengers ? -1 : 1;
+    return strcmp(item_a->name, item_b->name);
+}
+
+/**
+ * @brief   Answers a query of type 6, by summing the passengers of every airport in all shards.
+ * @details Each shard lists all its airports, as the top airports of a shard may not be the top
+ *          airports of the whole dataset.
+ *
+ * @param shards  All shards.
+ * @param nshards Number of elements in @p shards.
+ * @param year    Year in the query.
+ * @param n       Number of airports to be outputted.
+ * @param writer  Where to write the output of the query to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int __partitioned_mode_merge_q06(partitioned_mode_shard_t *shards,
+                                 size_t                    nshards,
+                                 const char               *year,
+                                 uint64_t                  n,
+                                 query_writer_t           *writer) {
+    char request[LINE_MAX];
+    snprintf(request, LINE_MAX, "6 %s " PARTITIONED_MODE_ALL_AIRPORTS, year);
+
+    GPtrArray *replies[nshards];
+    const int  retval = __partitioned_mode_scatter(shards, nshards, request, replies);
+    if (retval) {
+        __partitioned_mode_free_replies(replies, nshards);
+        return 1;
+    }
+
+    GArray *const     items   = g_array_new(FALSE, FALSE, sizeof(partitioned_mode_q06_item_t));
+    GHashTable *const indices = g_hash_table_new(g_str_hash, g_str_equal);
+    for (size_t i = 0; i < nshards; ++i) {
+        GPtrArray *const objects = __partitioned_mode_get_objects(replies[i]);
+        for (size_t j = 0; j < objects->len; ++j) {
+            const GPtrArray *const object = g_ptr_array_index(objects, j);
+            const char *const      name   = __partitioned_mode_get_field(object, "name");
+            if (!name)
+                continue;
+
+            /* Indices are offset by one, as NULL means a missing key */
+            const size_t index = GPOINTER_TO_SIZE(g_hash_table_lookup(indices, name));
+            if (!index) {
+                const partitioned_mode_q06_item_t item = {.name = name, .passengers = 0};
+                g_array_append_val(items, item);
+                g_hash_table_insert(indices,
+                                    (gpointer) (uintptr_t) name,
+                                    GSIZE_TO_POINTER(items->len));
+            }
+
+            partitioned_mode_q06_item_t *const item =
+                &g_array_index(items,
+                               partitioned_mode_q06_item_t,
+                               index ? index - 1 : items->len - 1);
+            item->passengers += __partitioned_mode_get_unsigned(object, "passengers");
+        }
+        g_ptr_array_unref(objects);
+    }
+
+    g_array_sort(items, __partitioned_mode_q06_compare);
+    for (size_t i = 0; i < items->len && i < n; ++i) {
+        const partitioned_mode_q06_item_t *const item =
+            &g_array_index(items, partitioned_mode_q06_item_t, i);
+
+        query_writer_write_new_object(writer);
+        query_writer_write_new_field_string(writer, "name", item->name);
+        query_writer_write_new_field_unsigned(writer, "passengers", item->passengers);
+    }
+
+    g_hash_table_destroy(indices);
+    g_array_free(items, TRUE);
+    __partitioned_mode_free_replies(replies, nshards);
+    return 0;
+}
+
+/**
+ * @brief Answers a query of type 8, by summing the revenue of the hotel in all shards.
+ *
+ * @param shards  All shards.
+ * @param nshards Number of elements in @p shards.
+ * @param query   Query to be answered.
+ * @param writer  Where to write the output of the query to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int __partitioned_mode_merge_q08(partitioned_mode_shard_t *shards,
+                                 size_t                    nshards,
+                                 const char               *query,
+                                 query_writer_t           *writer) {
+    GPtrArray *replies[nshards];
+    const int  retval = __partitioned_mode_scatter(shards, nshards, query, replies);
+
+    int      found   = 0;
+    uint64_t revenue = 0;
+    for (size_t i = 0; i < nshards && !retval; ++i) {
+        GPtrArray *const objects = __partitioned_mode_get_objects(replies[i]);
+        if (objects->len) {
+            found = 1;
+            revenue += __partitioned_mode_get_unsigned(g_ptr_array_index(objects, 0), "revenue");
+        }
+        g_ptr_array_unref(objects);
+    }
+
+    if (found) {
+        query_writer_write_new_object(writer);
+        query_writer_write_new_field_unsigned(writer, "revenue", revenue);
+    }
+
+    __partitioned_mode_free_replies(replies, nshards);
+    return retval;
+}
+
+/** @brief Number of event counts in each line of the output of a query of type 10. */
+#define PARTITIONED_MODE_Q10_COUNTS 5
+
+/** @brief Names of the event counts in the output of a query of type 10. */
+const char *const partitioned_mode_q10_counts[PARTITIONED_MODE_Q10_COUNTS] = {"users",
+                                                                              "flights",
+                                                                              "passengers",
+                                                                              "unique_passengers",
+                                                                              "reservations"};
+
+/**
+ * @struct partitioned_mode_q10_row_t
+ * @brief  Event counts in a year, month or day, summed across all shards.
+ *
+ * @var partitioned_mode_q10_row_t::instant
+ *     @brief Year, month or day.
+ * @var partitioned_mode_q10_row_t::counts
+ *     @brief Event counts, in the order of ::partitioned_mode_q10_counts.
+ */
+typedef struct {
+    int64_t  instant;
+    uint64_t counts[PARTITIONED_MODE_Q10_COUNTS];
+} partitioned_mode_q10_row_t;
+
+/** @brief Comparison function for ::partitioned_mode_q10_row_t, by instant. */
+int __partitioned_mode_q10_compare(gconstpointer a, gconstpointer b) {
+    const partitioned_mode_q10_row_t *const row_a = a;
+    const partitioned_mode_q10_row_t *const row_b = b;
+    return (row_a->instant > row_b->instant) - (row_a->instant < row_b->instant);
+}
+
+/**
+ * @brief   Answers a query of type 10, by summing the event counts of all shards.
+ * @details Users (and so unique passengers) don't repeat across shards, so all counts are summed,
+ *          except for flights, that are the same in every shard.
+ *
+ * @param shards  All shards.
+ * @param nshards Number of elements in @p shards.
+ * @param query   Query to be answered.
+ * @param writer  Where to write the output of the query to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int __partitioned_mode_merge_q10(partitioned_mode_shard_t *shards,
+                                 size_t                    nshards,
+                                 const char               *query,
+                                 query_writer_t           *writer) {
+    GPtrArray *replies[nshards];
+    const int  retval = __partitioned_mode_scatter(shards, nshards, query, replies);
+    if (retval) {
+        __partitioned_mode_free_replies(replies, nshards);
+        return 1;
+    }
+
+    /* The first field (year, month or day) is the same in every line */
+    const char   *instant_key = NULL;
+    GArray *const rows        = g_array_new(FALSE, FALSE, sizeof(partitioned_mode_q10_row_t));
+    for (size_t i = 0; i < nshards; ++i) {
+        GPtrArray *const objects = __partitioned_mode_get_objects(replies[i]);
+        for (size_t j = 0; j < objects->len; ++j) {
+            const GPtrArray *const object = g_ptr_array_index(objects, j);
+            if (object->len < 2)
+                continue;
+
+            instant_key           = g_ptr_array_index(object, 0);
+            const int64_t instant = strtoll(g_ptr_array_index(object, 1), NULL, 10);
+
+            /* There are very few rows (at most 31), so they're searched linearly */
+            size_t k = 0;
+            while (k < rows->len &&
+                   g_array_index(rows, partitioned_mode_q10_row_t, k).instant != instant)
+                k++;
+            if (k == rows->len) {
+                const partitioned_mode_q10_row_t row = {.instant = instant, .counts = {0}};
+                g_array_append_val(rows, row);
+            }
+
+            partitioned_mode_q10_row_t *const row =
+                &g_array_index(rows, partitioned_mode_q10_row_t, k);
+            for (size_t l = 0; l < PARTITIONED_MODE_Q10_COUNTS; ++l) {
+                const uint64_t count =
+                    __partitioned_mode_get_unsigned(object, partitioned_mode_q10_counts[l]);
+
+                if (l == 1)
+                    row->counts[l] = count > row->counts[l] ? count : row->counts[l]; /* Flights */
+                else
+                    row->counts[l] += count;
+            }
+        }
+        g_ptr_array_unref(objects);
+    }
+
+    g_array_sort(rows, __partitioned_mode_q10_compare);
+    for (size_t i = 0; i < rows->len; ++i) {
+        const partitioned_mode_q10_row_t *const row =
+            &g_array_index(rows, partitioned_mode_q10_row_t, i);
+
+        query_writer_write_new_object(writer);
+        query_writer_write_new_field_signed(writer, instant_key, row->instant);
+        for (size_t j = 0; j < PARTITIONED_MODE_Q10_COUNTS; ++j)
+            query_writer_write_new_field_unsigned(writer,
+                                                  partitioned_mode_q10_counts[j],
+                                                  row->counts[j]);
+    }
+
+    g_array_free(rows, TRUE);
+    __partitioned_mode_free_replies(replies, nshards);
+    return 0;
+}
+
+/**
+ * @brief   Answers a query, by routing it to the shards that can answer it.
+ * @details See [the header file's documentation](@ref partitioned_mode.h) for how each query type
+ *          is routed.
+ *
+ * @param shards   All shards.
+ * @param nshards  Number of elements in @p shards.
+ * @param query    Query to be answered.
+ * @param instance @p query, already parsed (and valid).
+ * @param writer   Where to write the output of @p query to.
+ *
+ * @retval 0 Success (unsupported queries are reported to `stderr`, and have no output).
+ * @retval 1 IO or allocation failure.
+ */
+int __partitioned_mode_execute(partitioned_mode_shard_t *shards,
+                               size_t                    nshards,
+                               const char               *query,
+                               const query_instance_t   *instance,
+                               query_writer_t           *writer) {
+    /* Arguments are tokenized again, as their parsed form is private to each query type */
+    char                  *argv[PARTITIONED_MODE_MAX_ARGUMENTS] = {NULL};
+    size_t                 argc                                 = 0;
+    const char            *iter                                 = query;
+    query_tokenizer_span_t token;
+    query_tokenizer_next(&iter, &token); /* Query type */
+    while (argc < PARTITIONED_MODE_MAX_ARGUMENTS && !query_tokenizer_next(&iter, &token))
+        argv[argc++] = g_strndup(token.begin, token.length);
+
+    int          retval = 0;
+    const size_t type   = query_type_get_type_number(query_instance_get_type(instance));
+    if (query_instance_get_approximate(instance))
+        goto UNSUPPORTED;
+
+    switch (type) {
+        case 1: {
+            flight_id_t      flight;
+            reservation_id_t reservation;
+            if (!flight_id_from_string(&flight, argv[0]))
+                retval = __partitioned_mode_merge_q01(shards, nshards, query, 1, writer);
+            else if (!reservation_id_from_string(&reservation, argv[0]))
+                retval = __partitioned_mode_merge_q01(shards, nshards, query, 0, writer);
+            else
+                retval = __partitioned_mode_forward(
+                    shards + dataset_partitioner_get_shard(argv[0], strlen(argv[0]), nshards),
+                    query,
+                    writer);
+        } break;
+        case 2:
+            retval = __partitioned_mode_forward(
+                shards + dataset_partitioner_get_shard(argv[0], strlen(argv[0]), nshards),
+                query,
+                writer);
+            break;
+        case 3:
+            retval = __partitioned_mode_merge_q03(shards, nshards, argv[0], writer);
+            break;
+        case 5:
+        case 7:
+            retval = __partitioned_mode_forward(shards, query, writer); /* Flights only */
+            break;
+        case 6: {
+            uint64_t n;
+            if (!int_utils_parse_positive(&n, argv[1]))
+                retval = __partitioned_mode_merge_q06(shards, nshards, argv[0], n, writer);
+        } break;
+        case 8:
+            retval = __partitioned_mode_merge_q08(shards, nshards, query, writer);
+            break;
+        case 10:
+            retval = __partitioned_mode_merge_q10(shards, nshards, query, writer);
+            break;
+        default:
+            goto UNSUPPORTED;
+    }
+
+    goto DEFER_1;
+UNSUPPORTED:
+    fprintf(stderr, "Query \"%s\" isn't supported in partitioned mode!\n", query);
+DEFER_1:
+    for (size_t i = 0; i < argc; ++i)
+        g_free(argv[i]);
+    return retval;
+}
+
+/**
+ * @brief Answers all queries in a query file, writing their outputs to files, like in batch mode.
+ *
+ * @param shards     All shards.
+ * @param nshards    Number of elements in @p shards.
+ * @param query_file File containing the queries.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure. A message will also be printed to `stderr`.
+ */
+int __partitioned_mode_run_queries(partitioned_mode_shard_t *shards,
+                                   size_t                    nshards,
+                                   FILE                     *query_file) {
+    char *line;
+    for (size_t line_number = 1; (line = __partitioned_mode_read_line(query_file)); ++line_number) {
+        query_instance_t *const instance = query_instance_create(NULL);
+        if (!instance) {
+            free(line);
+            fputs("Failed to allocate query!\n", stderr);
+            return 1;
+        }
+
+        if (query_parser_parse_string_const(NULL, instance, line)) {
+            query_instance_free(instance); /* Invalid queries are ignored, like in batch mode */
+            free(line);
+            continue;
+        }
+
+        char path[PATH_MAX];
+        snprintf(path, PATH_MAX, "Resultados/command%zu_output.txt", line_number);
+        query_writer_t *const writer =
+            query_writer_create(path, query_instance_get_formatted(instance));
+
+        const int failed =
+            !writer || __partitioned_mode_execute(shards, nshards, line, instance, writer);
+        if (writer)
+            query_writer_free(writer);
+        query_instance_free(instance);
+        free(line);
+
+        if (failed) {
+            fputs("Failed to answer query with the dataset's shards!\n", stderr);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int partitioned_mode_run(const char *dataset_dir, const char *query_file_path, size_t nshards) {
+    int retval = 0;
+
+    char partition_path[PATH_MAX];
+    if (snprintf(partition_path,
+                 PATH_MAX,
+                 PARTITIONED_MODE_PARTITION_PATH_FORMAT,
+                 dataset_dir,
+                 nshards) >= PATH_MAX) {
+        fputs("Dataset path is too long!\n", stderr);
+        return 1;
+    }
+    if (dataset_partitioner_partition(dataset_dir, partition_path, nshards)) {
+        fputs("Failed to partition dataset!\n", stderr);
+        return 1;
+    }
+
+    FILE *const query_file = fopen(query_file_path, "r");
+    if (!query_file) {
+        fputs("Failed to read query file!\n", stderr);
+        return 1;
+    }
+
+    /* Error files aren't written by shards, so the output directory may not exist */
+    if (mkdir("Resultados", 0755) && errno != EEXIST) {
+        retval = 1;
+        fputs("Failed to create output directory!\n", stderr);
+        goto DEFER_1;
+    }
+
+    partitioned_mode_shard_t *const shards = malloc(sizeof(partitioned_mode_shard_t) * nshards);
+    if (!shards) {
+        retval = 1;
+        fputs("Failed to allocate shards!\n", stderr);
+        goto DEFER_1;
+    }
+
+    /* Pending output would be written once by every process */
+    fflush(stdout);
+    fflush(stderr);
+
+    size_t nstarted = 0;
+    for (; nstarted < nshards; ++nstarted) {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets)) {
+            retval = 1;
+            break;
+        }
+
+        const pid_t pid = fork();
+        if (pid < 0) {
+            close(sockets[0]);
+            close(sockets[1]);
+            retval = 1;
+            break; /* Still wait for the shards that were started */
+        } else if (pid == 0) {
+            close(sockets[0]);
+            for (size_t i = 0; i < nstarted; ++i) {
+                fclose(shards[i].requests);
+                fclose(shards[i].replies);
+            }
+
+            char shard_path[PATH_MAX];
+            if (snprintf(shard_path,
+                         PATH_MAX,
+                         DATASET_PARTITIONER_SHARD_PATH_FORMAT,
+                         partition_path,
+                         nstarted) >= PATH_MAX) {
+                fputs("Shard path is too long!\n", stderr);
+                _exit(1);
+            }
+            _exit(__partitioned_mode_run_shard(shard_path, sockets[1]));
+        }
+
+        close(sockets[1]);
+        shards[nstarted].pid      = pid;
+        shards[nstarted].requests = __partitioned_mode_open_stream(dup(sockets[0]), "w");
+        shards[nstarted].replies  = __partitioned_mode_open_stream(sockets[0], "r");
+        if (!shards[nstarted].requests || !shards[nstarted].replies) {
+            if (shards[nstarted].requests)
+                fclose(shards[nstarted].requests);
+            if (shards[nstarted].replies)
+                fclose(shards[nstarted].replies);
+
+            waitpid(pid, NULL, 0); /* The shard stops once its socket is closed */
+            retval = 1;
+            break;
+        }
+    }
+
+    if (retval)
+        fputs("Failed to start dataset shards!\n", stderr);
+    else
+        retval = __partitioned_mode_run_queries(shards, nshards, query_file);
+
+    /* Closing sockets stops shards */
+    for (size_t i = 0; i < nstarted; ++i) {
+        fclose(shards[i].requests);
+        fclose(shards[i].replies);
+    }
+
+    for (size_t i = 0; i < nstarted; ++i) {
+        int status;
+        if (waitpid(shards[i].pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+            retval = 1;
+    }
+
+    free(shards);
+DEFER_1:
+    fclose(query_file);
+    return retval;
+}
@@ -20,9 +20,12 @@
  */
 
 #include <glib.h>
+#include <string.h>
 
 #include "queries/q02.h"
 #include "queries/query_instance.h"
+#include "utils/int_utils.h"
+#include "utils/prefetch.h"
 
 /** @brief What entities related to a user must be outputted (flights, reservations, or both). */
 typedef enum {
@@ -50,65 +53,100 @@ typedef struct {
  * @details The first argument, a user identifier, is mandatory. A optional second argument, taking
  *          the value of either `"flights"` or `"reservations"`, is allowed.
  *
- * @param argc Number of arguments.
- * @param argv Values of the arguments.
+ * @param allocator Where to allocate the identifier of the user. `NULL` for `strdup`.
+ * @param output    Where to write the ::q02_argument_data_t to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
  *
- * @return `NULL` on failure (parsing or allocation), a pointer to a `q02_argument_data_t`
- *         otherwise.
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments or allocation failure.
  */
-void *__q02_parse_arguments(size_t argc, char *const argv[argc]) {
+int __q02_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    q02_argument_data_t *const ret = output;
+
     if (argc == 1) {
-        q02_argument_data_t *const ret = malloc(sizeof(q02_argument_data_t));
-        ret->user_id                   = strdup(argv[0]);
-        ret->filter                    = Q02_ARGUMENTS_NO_ARGUMENT;
-        return ret;
+        ret->filter = Q02_ARGUMENTS_NO_ARGUMENT;
     } else if (argc == 2) {
-        q02_arguments_output_filter_t filter;
-
         if (strcmp(argv[1], "flights") == 0)
-            filter = Q02_ARGUMENTS_FLIGHTS;
+            ret->filter = Q02_ARGUMENTS_FLIGHTS;
         else if (strcmp(argv[1], "reservations") == 0)
-            filter = Q02_ARGUMENTS_RESERVATIONS;
+            ret->filter = Q02_ARGUMENTS_RESERVATIONS;
         else
-            return NULL;
-
-        q02_argument_data_t *const ret = malloc(sizeof(q02_argument_data_t));
-        ret->user_id                   = strdup(argv[0]);
-        ret->filter                    = filter;
-        return ret;
+            return 1;
+    } else {
+        return 1;
     }
 
-    return NULL;
+    ret->user_id = allocator ? string_pool_put(allocator, argv[0]) : strdup(argv[0]);
+    return ret->user_id == NULL;
 }
 
 /**
- * @brief  Creates a deep clone of the value returned by ::__q02_parse_arguments.
- * @param  args_data Non-`NULL` value returned by ::__q02_parse_arguments (a pointer to a
- *                   ::q02_argument_data_t).
- * @return A deep copy of @p args_data.
+ * @brief Creates a deep clone of arguments written by ::__q02_parse_arguments.
+ *
+ * @param allocator Where to allocate the identifier of the user. `NULL` for `strdup`.
+ * @param output    Shallow copy of @p args_data, to be turned into a deep copy.
+ * @param args_data Arguments written by ::__q02_parse_arguments (a ::q02_argument_data_t).
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
  */
-void *__q02_clone_arguments(const void *args_data) {
+int __q02_clone_arguments(string_pool_t *allocator, void *output, const void *args_data) {
     const q02_argument_data_t *const args  = args_data;
-    q02_argument_data_t *const       clone = malloc(sizeof(q02_argument_data_t));
-    if (!clone)
-        return NULL;
-
-    clone->user_id = strdup(args->user_id);
-    if (!clone->user_id) {
-        free(clone);
-        return NULL;
-    }
-    clone->filter = args->filter;
-    return clone;
+    q02_argument_data_t *const       clone = output;
+
+    clone->user_id =
+        allocator ? string_pool_put(allocator, args->user_id) : strdup(args->user_id);
+    return clone->user_id == NULL;
 }
 
 /**
- * @brief Frees data generated by ::__q02_parse_arguments.
- * @param args_data Data generated by ::__q02_parse_arguments.
+ * @brief Frees data referred to by arguments written by ::__q02_parse_arguments.
+ * @param args_data Arguments written by ::__q02_parse_arguments.
  */
 void __q02_free_arguments(void *args_data) {
     free(((q02_argument_data_t *) args_data)->user_id);
-    free(args_data);
+}
+
+/**
+ * @brief Writes the identifier of the user in arguments written by ::__q02_parse_arguments.
+ *
+ * @param args_data Arguments written by ::__q02_parse_arguments.
+ * @param file      File where to write the identifier to (including its null terminator).
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __q02_save_arguments(const void *args_data, FILE *file) {
+    const q02_argument_data_t *const args = args_data;
+    const size_t                     size = strlen(args->user_id) + 1;
+    return fwrite(args->user_id, 1, size, file) != size;
+}
+
+/**
+ * @brief Reads the identifier of the user written by ::__q02_save_arguments.
+ *
+ * @param allocator Where to allocate the identifier of the user. `NULL` for `strdup`.
+ * @param output    Saved ::q02_argument_data_t, whose identifier is to be read.
+ * @param contents  Data written by ::__q02_save_arguments.
+ * @param size      Number of bytes in @p contents.
+ *
+ * @retval 0 Success.
+ * @retval 1 Corrupt @p contents or allocation failure.
+ */
+int __q02_load_arguments(string_pool_t *allocator,
+                         void          *output,
+                         const char    *contents,
+                         size_t         size) {
+    if (!size || memchr(contents, '\0', size) != contents + size - 1)
+        return 1;
+
+    q02_argument_data_t *const args = output;
+    args->user_id = allocator ? string_pool_put(allocator, contents) : strdup(contents);
+    return args->user_id == NULL;
 }
 
 /**
@@ -133,8 +171,8 @@ typedef struct {
 } q02_output_item_t;
 
 /**
- * @brief   Comparison function for sorting the output of query 2.
- * @details Auxiliary function for ::__q02_execute.
+ * @brief   Comparison function for ordering the output of query 2.
+ * @details Auxiliary function for ::q02_execute.
  */
 gint __q02_execute_sort_compare(gconstpointer a_data, gconstpointer b_data) {
     const q02_output_item_t *const a = a_data;
@@ -149,61 +187,148 @@ gint __q02_execute_sort_compare(gconstpointer a_data, gconstpointer b_data) {
 }
 
 /**
- * @brief Prints the output of a query of type 2 to an @p output writer.
+ * @struct q02_reservation_window_t
+ * @brief  Reservations of a user, looked up in batches (see ::reservation_manager_get_by_ids).
+ *
+ * @var q02_reservation_window_t::reservations
+ *     @brief Looked up reservations, from index ::q02_reservation_window_t::begin (inclusive) to
+ *            ::q02_reservation_window_t::end (exclusive) of the user's reservations.
+ * @var q02_reservation_window_t::begin
+ *     @brief Index, in the user's reservations, of the first reservation in the window.
+ * @var q02_reservation_window_t::end
+ *     @brief Index, in the user's reservations, after the last reservation in the window.
+ */
+typedef struct {
+    const reservation_t *reservations[PREFETCH_BATCH_SIZE];
+    size_t               begin, end;
+} q02_reservation_window_t;
+
+/**
+ * @struct q02_flight_window_t
+ * @brief  Flights of a user, looked up in batches (see ::flight_manager_get_by_ids).
+ *
+ * @var q02_flight_window_t::flights
+ *     @brief Looked up flights, from index ::q02_flight_window_t::begin (inclusive) to
+ *            ::q02_flight_window_t::end (exclusive) of the user's flights.
+ * @var q02_flight_window_t::begin
+ *     @brief Index, in the user's flights, of the first flight in the window.
+ * @var q02_flight_window_t::end
+ *     @brief Index, in the user's flights, after the last flight in the window.
+ */
+typedef struct {
+    const flight_t *flights[PREFETCH_BATCH_SIZE];
+    size_t          begin, end;
+} q02_flight_window_t;
+
+/**
+ * @brief   Creates an output item for a reservation.
+ * @details If the reservation isn't in @p window, the next ::PREFETCH_BATCH_SIZE reservations are
+ *          looked up. Indices must not decrease between calls with the same @p window.
  *
- * @param output    Where to output the query's results to.
- * @param items     Array of ::q02_output_item_t, to be written as text.
- * @param filter    Whether the query requested flights, reservations or both.
+ * @param reservations Manager where the reservation is stored.
+ * @param window       Reservations already looked up.
+ * @param ids          Identifiers of all the user's reservations.
+ * @param n            Number of reservations in @p ids.
+ * @param i            Index of the reservation in @p ids.
+ *
+ * @return The output item for the reservation identified by `ids[i]`.
  */
-void __q02_print_output(query_writer_t               *output,
-                        GArray                       *items,
-                        q02_arguments_output_filter_t filter) {
-
-    for (size_t i = 0; i < items->len; ++i) {
-        const q02_output_item_t *const item = &g_array_index(items, q02_output_item_t, i);
-
-        char date_string[DATE_SPRINTF_MIN_BUFFER_SIZE];
-        date_sprintf(date_string, date_and_time_get_date(item->date));
-
-        char flight_id_str[FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE];
-        char reservation_id_str[RESERVATION_ID_SPRINTF_MIN_BUFFER_SIZE];
-
-        query_writer_write_new_object(output);
-        switch (item->type) {
-            case Q02_OUTPUT_ITEM_FLIGHT:
-                flight_id_sprintf(flight_id_str, item->id);
-                query_writer_write_new_field(output, "id", "%s", flight_id_str);
-                break;
-            case Q02_OUTPUT_ITEM_RESERVATION:
-                reservation_id_sprintf(reservation_id_str, item->id);
-                query_writer_write_new_field(output, "id", "%s", reservation_id_str);
-                break;
-        }
-        query_writer_write_new_field(output, "date", "%s", date_string);
-
-        if (filter == Q02_ARGUMENTS_NO_ARGUMENT) {
-            query_writer_write_new_field(output,
-                                         "type",
-                                         item->type == Q02_OUTPUT_ITEM_FLIGHT ? "flight"
-                                                                              : "reservation");
-        }
+q02_output_item_t __q02_reservation_item(const reservation_manager_t *reservations,
+                                         q02_reservation_window_t    *window,
+                                         const reservation_id_t      *ids,
+                                         size_t                       n,
+                                         size_t                       i) {
+    if (i >= window->end) {
+        window->begin = i;
+        window->end   = min(i + PREFETCH_BATCH_SIZE, n);
+        reservation_manager_get_by_ids(reservations,
+                                       window->end - window->begin,
+                                       ids + i,
+                                       window->reservations);
     }
+
+    const reservation_id_t id = ids[i];
+    date_and_time_t        output_time;
+    date_and_time_from_values(&output_time,
+                              reservation_get_begin_date(window->reservations[i - window->begin]),
+                              0 /* 00:00:00 */);
+
+    const q02_output_item_t output_item = {.id   = id,
+                                           .date = output_time,
+                                           .type = Q02_OUTPUT_ITEM_RESERVATION};
+    return output_item;
 }
 
 /**
- * @brief Executes a query of type 2.
+ * @brief   Creates an output item for a flight.
+ * @details If the flight isn't in @p window, the next ::PREFETCH_BATCH_SIZE flights are looked up.
+ *          Indices must not decrease between calls with the same @p window.
  *
- * @param database   Database to get information from.
- * @param statistics Always `NULL`, as this query does not use statistic data.
- * @param instance   Query instance to be executed.
- * @param output     Where to output query results to.
+ * @param flights Manager where the flight is stored.
+ * @param window  Flights already looked up.
+ * @param ids     Identifiers of all the user's flights.
+ * @param n       Number of flights in @p ids.
+ * @param i       Index of the flight in @p ids.
  *
- * @retval 0 Always successful.
+ * @return The output item for the flight identified by `ids[i]`.
  */
-int __q02_execute(const database_t       *database,
-                  const void             *statistics,
-                  const query_instance_t *instance,
-                  query_writer_t         *output) {
+q02_output_item_t __q02_flight_item(const flight_manager_t *flights,
+                                    q02_flight_window_t    *window,
+                                    const flight_id_t      *ids,
+                                    size_t                  n,
+                                    size_t                  i) {
+    if (i >= window->end) {
+        window->begin = i;
+        window->end   = min(i + PREFETCH_BATCH_SIZE, n);
+        flight_manager_get_by_ids(flights, window->end - window->begin, ids + i, window->flights);
+    }
+
+    const q02_output_item_t output_item = {
+        .id   = ids[i],
+        .date = flight_get_schedule_departure_date(window->flights[i - window->begin]),
+        .type = Q02_OUTPUT_ITEM_FLIGHT};
+    return output_item;
+}
+
+/**
+ * @brief Prints an item of the output of a query of type 2 to an @p output writer.
+ *
+ * @param output Where to output the query's results to.
+ * @param item   Item to be written as text.
+ * @param filter Whether the query requested flights, reservations or both.
+ */
+void __q02_print_output_item(query_writer_t               *output,
+                             const q02_output_item_t      *item,
+                             q02_arguments_output_filter_t filter) {
+
+    char flight_id_str[FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE];
+    char reservation_id_str[RESERVATION_ID_SPRINTF_MIN_BUFFER_SIZE];
+
+    query_writer_write_new_object(output);
+    switch (item->type) {
+        case Q02_OUTPUT_ITEM_FLIGHT:
+            flight_id_sprintf(flight_id_str, item->id);
+            query_writer_write_new_field_string(output, "id", flight_id_str);
+            break;
+        case Q02_OUTPUT_ITEM_RESERVATION:
+            reservation_id_sprintf(reservation_id_str, item->id);
+            query_writer_write_new_field_string(output, "id", reservation_id_str);
+            break;
+    }
+    query_writer_write_new_field_date(output, "date", date_and_time_get_date(item->date));
+
+    if (filter == Q02_ARGUMENTS_NO_ARGUMENT) {
+        query_writer_write_new_field_string(output,
+                                            "type",
+                                            item->type == Q02_OUTPUT_ITEM_FLIGHT ? "flight"
+                                                                                 : "reservation");
+    }
+}
+
+int q02_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
     (void) statistics;
     const q02_argument_data_t *const args = query_instance_get_argument_data(instance);
 
@@ -215,52 +340,121 @@ int __q02_execute(const database_t       *database,
     if (!user || user_get_account_status(user) == ACCOUNT_STATUS_INACTIVE)
         return 0;
 
-    GArray *const output_items = g_array_new(FALSE, FALSE, sizeof(q02_output_item_t));
-
-    if (args->filter != Q02_ARGUMENTS_FLIGHTS) { /* Add reservations */
-        const single_pool_id_linked_list_t *user_reservations =
-            user_manager_get_reservations_by_id(users, args->user_id);
-
-        while (user_reservations) {
-            const reservation_id_t id = single_pool_id_linked_list_get_value(user_reservations);
+    const reservation_id_t *user_reservations = NULL;
+    size_t                  nreservations     = 0;
+    if (args->filter != Q02_ARGUMENTS_FLIGHTS &&
+        user_manager_get_reservations_by_id(users,
+                                            args->user_id,
+                                            &user_reservations,
+                                            &nreservations))
+        return 1;
+
+    const flight_id_t *user_flights = NULL;
+    size_t             nflights     = 0;
+    if (args->filter != Q02_ARGUMENTS_RESERVATIONS &&
+        user_manager_get_flights_by_id(users, args->user_id, &user_flights, &nflights))
+        return 1;
+
+    q02_reservation_window_t reservation_window = {.begin = 0, .end = 0};
+    q02_flight_window_t      flight_window      = {.begin = 0, .end = 0};
+
+    /* Items before the requested page are merged but not printed, and the ones after it aren't */
+    const size_t offset = query_instance_get_offset(instance);
+    size_t       r = 0, f = 0;
+    while (r < nreservations && f < nflights && !query_writer_is_page_full(output)) {
+        const q02_output_item_t reservation =
+            __q02_reservation_item(reservations,
+                                   &reservation_window,
+                                   user_reservations,
+                                   nreservations,
+                                   r);
+        const q02_output_item_t flight = __q02_flight_item(flights,
+                                                          &flight_window,
+                                                          user_flights,
+                                                          nflights,
+                                                          f);
+
+        const int is_reservation = __q02_execute_sort_compare(&reservation, &flight) <= 0;
+        if (r + f < offset)
+            query_writer_skip_objects(output, 1);
+        else
+            __q02_print_output_item(output, is_reservation ? &reservation : &flight, args->filter);
 
-            date_and_time_t output_time;
-            date_and_time_from_values(
-                &output_time,
-                reservation_get_begin_date(reservation_manager_get_by_id(reservations, id)),
-                0 /* 00:00:00 */);
+        r += is_reservation;
+        f += !is_reservation;
+    }
 
-            const q02_output_item_t output_item = {.id   = id,
-                                                   .date = output_time,
-                                                   .type = Q02_OUTPUT_ITEM_RESERVATION};
+    /* Only one of the lists is left, so the items before the page can be skipped directly */
+    if (r + f < offset) {
+        const size_t skipped_reservations = min(offset - r - f, nreservations - r);
+        r += skipped_reservations;
+        const size_t skipped_flights = min(offset - r - f, nflights - f);
+        f += skipped_flights;
 
-            g_array_append_val(output_items, output_item);
-            user_reservations = single_pool_id_linked_list_get_next(user_reservations);
-        }
+        query_writer_skip_objects(output, skipped_reservations + skipped_flights);
     }
 
-    if (args->filter != Q02_ARGUMENTS_RESERVATIONS) { /* Add flights */
-        const single_pool_id_linked_list_t *user_flights =
-            user_manager_get_flights_by_id(users, args->user_id);
+    for (; r < nreservations && !query_writer_is_page_full(output); ++r) {
+        const q02_output_item_t reservation =
+            __q02_reservation_item(reservations,
+                                   &reservation_window,
+                                   user_reservations,
+                                   nreservations,
+                                   r);
+        __q02_print_output_item(output, &reservation, args->filter);
+    }
 
-        while (user_flights) {
-            const flight_id_t id = single_pool_id_linked_list_get_value(user_flights);
+    for (; f < nflights && !query_writer_is_page_full(output); ++f) {
+        const q02_output_item_t flight = __q02_flight_item(flights,
+                                                          &flight_window,
+                                                          user_flights,
+                                                          nflights,
+                                                          f);
+        __q02_print_output_item(output, &flight, args->filter);
+    }
 
-            const q02_output_item_t output_item = {
-                .id   = id,
-                .date = flight_get_schedule_departure_date(flight_manager_get_by_id(flights, id)),
-                .type = Q02_OUTPUT_ITEM_FLIGHT};
+    return 0;
+}
 
-            g_array_append_val(output_items, output_item);
-            user_flights = single_pool_id_linked_list_get_next(user_flights);
-        }
-    }
+/**
+ * @brief   Estimates the number of objects in the output of a query of type 2.
+ * @details The user's flights and reservations are looked up, but not the entities themselves, so
+ *          this is a constant time operation. The estimate is exact.
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance whose results are to be estimated.
+ *
+ * @return The number of flights and / or reservations of the user in @p instance.
+ */
+size_t __q02_estimate_results(const database_t       *database,
+                              const void             *statistics,
+                              const query_instance_t *instance) {
+    (void) statistics;
+    const q02_argument_data_t *const args  = query_instance_get_argument_data(instance);
+    const user_manager_t *const      users = database_get_users(database);
 
-    g_array_sort(output_items, __q02_execute_sort_compare);
-    __q02_print_output(output, output_items, args->filter);
+    const user_t *const user = user_manager_get_by_id(users, args->user_id);
+    if (!user || user_get_account_status(user) == ACCOUNT_STATUS_INACTIVE)
+        return 0;
 
-    g_array_unref(output_items);
-    return 0;
+    const reservation_id_t *user_reservations;
+    size_t                  nreservations = 0;
+    if (args->filter != Q02_ARGUMENTS_FLIGHTS)
+        user_manager_get_reservations_by_id(users,
+                                            args->user_id,
+                                            &user_reservations,
+                                            &nreservations); /* Ignore errors */
+
+    const flight_id_t *user_flights;
+    size_t             nflights = 0;
+    if (args->filter != Q02_ARGUMENTS_RESERVATIONS)
+        user_manager_get_flights_by_id(users,
+                                       args->user_id,
+                                       &user_flights,
+                                       &nflights); /* Ignore errors */
+
+    return nreservations + nflights;
 }
 
 query_type_t *q02_create(void) {
@@ -268,7 +462,15 @@ query_type_t *q02_create(void) {
                              __q02_parse_arguments,
                              __q02_clone_arguments,
                              __q02_free_arguments,
+                             __q02_save_arguments,
+                             __q02_load_arguments,
+                             NULL,
+                             NULL,
+                             NULL,
+                             0,
                              NULL,
+                             q02_execute,
                              NULL,
-                             __q02_execute);
+                             __q02_estimate_results,
+                             0);
 }
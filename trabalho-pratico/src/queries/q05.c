@@ -19,12 +19,11 @@
  * @brief Implementation of methods in include/queries/q05.h
  */
 
-#include <stdio.h>
+#include <string.h>
 
 #include "queries/q05.h"
 #include "queries/query_instance.h"
-#include "utils/glib/GConstKeyHashTable.h"
-#include "utils/glib/GConstPtrArray.h"
+#include "utils/int_utils.h"
 
 /**
  * @struct q05_parsed_arguments_t
@@ -47,242 +46,155 @@ typedef struct {
  * @brief   Parses the arguments of a query of type 5.
  * @details Asserts that there's three arguments, an airport code, and two dates with times.
  *
- * @param argc Number of arguments.
- * @param argv Values of the arguments.
+ * @param allocator Not used (no strings are stored).
+ * @param output    Where to write the ::q05_parsed_arguments_t to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
  *
- * @return `NULL` on parsing or allocation failure, a pointer to a ::q05_parsed_arguments_t
- *         otherwise.
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments.
  */
-void *__q05_parse_arguments(size_t argc, char *const argv[argc]) {
+int __q05_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    (void) allocator;
     if (argc != 3)
-        return NULL;
+        return 1;
 
-    q05_parsed_arguments_t *const parsed_arguments = malloc(sizeof(q05_parsed_arguments_t));
-    if (!parsed_arguments)
-        return NULL;
+    q05_parsed_arguments_t *const parsed_arguments = output;
 
     const int airport_retval = airport_code_from_string(&parsed_arguments->airport_code, argv[0]);
     const int begin_date_retval = date_and_time_from_string(&parsed_arguments->begin_date, argv[1]);
     const int end_date_retval   = date_and_time_from_string(&parsed_arguments->end_date, argv[2]);
 
-    if (airport_retval || begin_date_retval || end_date_retval) {
-        free(parsed_arguments);
-        return NULL;
-    }
-
-    return parsed_arguments;
+    return airport_retval || begin_date_retval || end_date_retval;
 }
 
 /**
- * @brief  Creates a deep clone of the value returned by ::__q05_parse_arguments.
- * @param  args_data Non-`NULL` value returned by ::__q05_parse_arguments (a pointer to a
- *                   ::q05_parsed_arguments_t).
- * @return A deep copy of @p args_data.
- */
-void *__q05_clone_arguments(const void *args_data) {
-    const q05_parsed_arguments_t *const args  = args_data;
-    q05_parsed_arguments_t *const       clone = malloc(sizeof(q05_parsed_arguments_t));
-    if (!clone)
-        return NULL;
-
-    memcpy(clone, args, sizeof(q05_parsed_arguments_t));
-    return clone;
-}
-
-/**
- * @struct q05_foreach_airport_data_t
- * @brief  Data needed while iterating over flights.
+ * @struct q05_execute_iter_callback_data_t
+ * @brief  Type of `user_data` parameter in ::__q05_execute_iter_callback.
  *
- * @var q05_foreach_airport_data_t::nfilters
- *     @brief Number of elements in ::q05_foreach_airport_data_t::filters.
- * @var q05_foreach_airport_data_t::filters
- *     @brief Array of pointers to ::q05_parsed_arguments_t. Information about which flights and
- *            date ranges to keep.
- * @var q05_foreach_airport_data_t::origin_flights
- *     @brief Associations between ::q05_parsed_arguments_t and arrays (::GConstPtrArray) of
- *            pointers to flights (::flight_t).
+ * @var q05_execute_iter_callback_data_t::strings
+ *     @brief Dictionary of airlines and plane models in the flight manager.
+ * @var q05_execute_iter_callback_data_t::output
+ *     @brief Where to output flights to.
  */
 typedef struct {
-    size_t                                     nfilters;
-    const q05_parsed_arguments_t *const *const filters;
-    GConstKeyHashTable *const                  origin_flights;
-} q05_foreach_airport_data_t;
+    const string_dictionary_t *const strings;
+    query_writer_t *const            output;
+} q05_execute_iter_callback_data_t;
 
 /**
- * @brief   A method called for each flight, to consider it in the list of flights with an origin
- *          on a given airport, depending on range of times.
- * @details An auxiliary method for ::__q05_generate_statistics.
+ * @brief   Callback called for every flight that matches a query of type 5, to output it.
+ * @details Auxiliary method for ::q05_execute.
  *
- * @param user_data A pointer to a ::q05_foreach_airport_data_t.
- * @param flight    Flight being processed.
+ * @param user_data A pointer to a ::q05_execute_iter_callback_data_t.
+ * @param flight    Flight that departs from the query's airport during the query's range of time.
  *
  * @retval 0 Always successful.
  */
-int __q05_generate_statistics_foreach_flight(void *user_data, const flight_t *flight) {
-    q05_foreach_airport_data_t *const foreach_data = user_data;
-
-    airport_code_t  airport                 = flight_get_origin(flight);
-    date_and_time_t schedule_departure_date = flight_get_schedule_departure_date(flight);
-
-    /* Add flight to all query answers whose filter matches */
-    for (size_t i = 0; i < foreach_data->nfilters; i++) {
-        const q05_parsed_arguments_t *const args = foreach_data->filters[i];
-
-        /* Check if the flight meets the filters in the arguments */
-        if (airport == args->airport_code &&
-            date_and_time_diff(args->begin_date, schedule_departure_date) <= 0 &&
-            date_and_time_diff(args->end_date, schedule_departure_date) >= 0) {
-
-            /* Add flight to answer */
-            GConstPtrArray *const flights =
-                g_const_key_hash_table_lookup(foreach_data->origin_flights, args);
-            g_const_ptr_array_add(flights, flight);
-        }
-    }
-
+int __q05_execute_iter_callback(void *user_data, const flight_t *flight) {
+    const q05_execute_iter_callback_data_t *const data    = user_data;
+    const string_dictionary_t *const              strings = data->strings;
+    query_writer_t *const                         output  = data->output;
+
+    char flight_id_str[FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE];
+    flight_id_sprintf(flight_id_str, flight_get_id(flight));
+
+    query_writer_write_new_object(output);
+    query_writer_write_new_field_string(output, "id", flight_id_str);
+    query_writer_write_new_field_date_and_time(output,
+                                               "schedule_departure_date",
+                                               flight_get_schedule_departure_date(flight));
+    query_writer_write_new_field_airport_code(output,
+                                              "destination",
+                                              flight_get_destination(flight));
+    query_writer_write_new_field_string(output,
+                                        "airline",
+                                        flight_get_const_airline(strings, flight));
+    query_writer_write_new_field_string(output,
+                                        "plane_model",
+                                        flight_get_const_plane_model(strings, flight));
     return 0;
 }
 
-/**
- * @brief   A comparison function for sorting a ::GConstPtrArray of flights.
- * @details Auxiliary method for ::__q05_generate_statistics_sort_each_array, itself an
- *          auxiliary method for ::__q05_generate_statistics.
- */
-gint __q05_flights_date_compare_func(const void *const *a, const void *const *b) {
-    const flight_t *const flight_a = *((const flight_t *const *) a);
-    const flight_t *const flight_b = *((const flight_t *const *) b);
-
-    const int64_t crit1 = date_and_time_diff(flight_get_schedule_departure_date(flight_b),
-                                             flight_get_schedule_departure_date(flight_a));
-    if (crit1)
-        return crit1;
-
-    const int32_t crit2 = flight_get_id(flight_a) - flight_get_id(flight_b);
-    return crit2;
-}
-
-/**
- * @brief Sorts each array of flights in the statistical's data hash table.
- *
- * @param query Pointer to a ::q05_foreach_airport_data_t.
- * @param list  Array of reservations to be sorted (::GConstPtrArray).
- * @param data  External data (not used).
- */
-void __q05_generate_statistics_sort_each_array(gconstpointer query, gpointer list, gpointer data) {
-    (void) query;
-    (void) data;
-    g_const_ptr_array_sort(list, __q05_flights_date_compare_func);
-}
-
-/**
- * @brief Generates statistical data for queries of type 5.
- *
- * @param database  Database, to iterate through flights.
- * @param n         Number of query instances that need to be executed.
- * @param instances Query instances that need to be executed.
- *
- * @return A ::GConstKeyHashTable associating a ::q05_foreach_airport_data_t for each query to a
- *         ::GConstPtrArray of pointers to flights (::flight_t). `NULL` may be returned on
- *         allocation failure.
- */
-void *__q05_generate_statistics(const database_t             *database,
-                                size_t                        n,
-                                const query_instance_t *const instances[n]) {
-    const q05_parsed_arguments_t **const filters = malloc(n * sizeof(q05_parsed_arguments_t *));
-    if (!filters)
-        return NULL;
-
-    GConstKeyHashTable *const origin_flights =
-        g_const_key_hash_table_new_full(g_direct_hash,
-                                        g_direct_equal,
-                                        (GDestroyNotify) g_ptr_array_unref);
-
-    for (size_t i = 0; i < n; ++i) {
-        const q05_parsed_arguments_t *const argument_data =
-            query_instance_get_argument_data(instances[i]);
-
-        g_const_key_hash_table_insert(origin_flights, argument_data, g_const_ptr_array_new());
-        filters[i] = argument_data;
-    }
-
-    q05_foreach_airport_data_t callback_data = {.nfilters       = n,
-                                                .filters        = filters,
-                                                .origin_flights = origin_flights};
-    flight_manager_iter(database_get_flights(database),
-                        __q05_generate_statistics_foreach_flight,
-                        &callback_data);
-
-    g_const_key_hash_table_foreach(origin_flights, __q05_generate_statistics_sort_each_array, NULL);
-    free(filters);
-    return origin_flights;
+int q05_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
+    (void) statistics;
+
+    const q05_parsed_arguments_t *const arguments = query_instance_get_argument_data(instance);
+    const flight_manager_t *const       flights   = database_get_flights(database);
+
+    q05_execute_iter_callback_data_t data = {.strings = flight_manager_get_strings(flights),
+                                             .output  = output};
+
+    /* Only look at the flights in the requested page */
+    const size_t offset = query_instance_get_offset(instance);
+    query_writer_skip_objects(output, offset);
+    return flight_manager_iter_origin_departures_range(flights,
+                                                       arguments->airport_code,
+                                                       arguments->begin_date,
+                                                       arguments->end_date,
+                                                       offset,
+                                                       query_instance_get_limit(instance),
+                                                       __q05_execute_iter_callback,
+                                                       &data);
 }
 
 /**
- * @brief Method called to execute a query of type 5.
+ * @brief   Estimates the number of flights in the output of a query of type 5.
+ * @details Departures are assumed to be half of the flights of an airport (see
+ *          ::database_statistics_get_airport_frequency), spread evenly across the dates of all
+ *          flights in the database.
  *
- * @param database   Database to get data from (not used, as all data is collected in
- *                   ::__q05_generate_statistics).
- * @param statistics Statistical data generated by ::__q05_generate_statistics (a
- *                   ::GConstKeyHashTable that associates query arguments (::q05_parsed_arguments_t)
- *                   to arrays (::GConstPtrArray) of flights (::flight_id_t)).
- * @param instance   Query instance to be executed.
- * @param output     Where to write the query's result to.
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance whose results are to be estimated.
  *
- * @retval 0 Success.
- * @retval 1 Fatal failure (should, in principle, be unreachable).
+ * @return The estimated number of flights departing from the airport in @p instance during its
+ *         range of time.
  */
-int __q05_execute(const database_t       *database,
-                  const void             *statistics,
-                  const query_instance_t *instance,
-                  query_writer_t         *output) {
-    (void) database;
-
-    const GConstKeyHashTable *const     origin_flights = statistics;
-    const q05_parsed_arguments_t *const arguments      = query_instance_get_argument_data(instance);
-
-    const GConstPtrArray *const flights =
-        g_const_key_hash_table_const_lookup(origin_flights, arguments);
-    if (!flights) {
-        fprintf(stderr, "Bad statistical data in query 5! This should not happen!\n");
-        return 1; /* Only happens on bad statistics, which itself shouldn't happen. */
-    }
-
-    const size_t flights_len = g_const_ptr_array_get_length(flights);
-    for (size_t i = 0; i < flights_len; i++) {
-        const flight_t *const flight = g_const_ptr_array_index(flights, i);
-
-        char scheduled_departure_str[DATE_AND_TIME_SPRINTF_MIN_BUFFER_SIZE];
-        date_and_time_sprintf(scheduled_departure_str, flight_get_schedule_departure_date(flight));
-
-        char destination_airport[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
-        airport_code_sprintf(destination_airport, flight_get_destination(flight));
-
-        char flight_id_str[FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE];
-        flight_id_sprintf(flight_id_str, flight_get_id(flight));
-
-        query_writer_write_new_object(output);
-        query_writer_write_new_field(output, "id", "%s", flight_id_str);
-        query_writer_write_new_field(output,
-                                     "schedule_departure_date",
-                                     "%s",
-                                     scheduled_departure_str);
-        query_writer_write_new_field(output, "destination", "%s", destination_airport);
-        query_writer_write_new_field(output, "airline", "%s", flight_get_const_airline(flight));
-        query_writer_write_new_field(output,
-                                     "plane_model",
-                                     "%s",
-                                     flight_get_const_plane_model(flight));
-    }
-
-    return 0;
+size_t __q05_estimate_results(const database_t       *database,
+                              const void             *statistics,
+                              const query_instance_t *instance) {
+    (void) statistics;
+    const q05_parsed_arguments_t *const arguments     = query_instance_get_argument_data(instance);
+    const database_statistics_t *const  db_statistics = database_get_statistics(database);
+
+    const size_t departures =
+        database_statistics_get_airport_frequency(db_statistics, arguments->airport_code) / 2;
+
+    date_and_time_t first, last;
+    if (!departures || database_statistics_get_flight_dates(db_statistics, &first, &last))
+        return 0;
+
+    const date_and_time_t begin = max(arguments->begin_date, first);
+    const date_and_time_t end   = min(arguments->end_date, last);
+    if (begin > end)
+        return 0;
+    else if (first == last)
+        return departures;
+
+    return (size_t) ((double) departures * (double) (end - begin) / (double) (last - first));
 }
 
 query_type_t *q05_create(void) {
     return query_type_create(5,
                              __q05_parse_arguments,
-                             __q05_clone_arguments,
-                             free,
-                             __q05_generate_statistics,
-                             (query_type_free_statistics_callback_t) g_hash_table_unref,
-                             __q05_execute);
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             0,
+                             NULL,
+                             q05_execute,
+                             NULL,
+                             __q05_estimate_results,
+                             DATABASE_INDEX_SET(DATABASE_INDEX_FLIGHT_ORIGIN_DEPARTURES));
 }
@@ -19,12 +19,16 @@
  * @brief Implementation of methods in include/queries/q06.h
  */
 
-#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "queries/q06.h"
 #include "queries/query_instance.h"
-#include "utils/glib/GConstKeyHashTable.h"
+#include "utils/group_by.h"
 #include "utils/int_utils.h"
+#include "utils/top_k.h"
 
 /**
  * @struct q06_parsed_arguments_t
@@ -45,18 +49,23 @@ typedef struct {
  * @details Asserts that there are exactly two arguments, a year and a number of airports to
  *          display.
  *
- * @param argc Number of query arguments.
- * @param argv List of query arguments.
+ * @param allocator Not used (no strings are stored).
+ * @param output    Where to write the ::q06_parsed_arguments_t to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
  *
- * @return A pointer to a ::q06_parsed_arguments_t, or `NULL` on parsing or allocation failure.
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments.
  */
-void *__q06_parse_arguments(size_t argc, char *const argv[argc]) {
+int __q06_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    (void) allocator;
     if (argc != 2)
-        return NULL;
+        return 1;
 
-    q06_parsed_arguments_t *const args = malloc(sizeof(q06_parsed_arguments_t));
-    if (!args)
-        return NULL;
+    q06_parsed_arguments_t *const args = output;
 
     /* Parse year */
     const size_t length = strlen(argv[0]);
@@ -64,92 +73,32 @@ void *__q06_parse_arguments(size_t argc, char *const argv[argc]) {
         uint64_t  year;
         const int retval = int_utils_parse_positive(&year, argv[0]);
 
-        if (retval) {
-            free(args);
-            return NULL; /* Invalid year format */
-        }
+        if (retval)
+            return 1; /* Invalid year format */
 
         args->year = year;
     } else {
-        free(args);
-        return NULL; /* Invalid year format */
+        return 1; /* Invalid year format */
     }
 
     /* Parse the number of flights */
     uint64_t  n;
     const int retval = int_utils_parse_positive(&n, argv[1]);
-    if (retval) {
-        free(args);
-        return NULL; /* Invalid N format */
-    }
+    if (retval)
+        return 1; /* Invalid N format */
     args->n = (size_t) n;
 
-    return args;
+    return 0;
 }
 
-/**
- * @brief  Creates a deep clone of the value returned by ::__q06_parse_arguments.
- * @param  args_data Non-`NULL` value returned by ::__q06_parse_arguments (a pointer to a
- *                   ::q06_parsed_arguments_t).
- * @return A deep copy of @p args_data.
- */
-void *__q06_clone_arguments(const void *args_data) {
-    const q06_parsed_arguments_t *const args  = args_data;
-    q06_parsed_arguments_t *const       clone = malloc(sizeof(q06_parsed_arguments_t));
-    if (!clone)
-        return NULL;
-
-    memcpy(clone, args, sizeof(q06_parsed_arguments_t));
-    return clone;
-}
+/** @brief Number of years that a query of type 6 can refer to (years are written with 4 digits). */
+#define Q06_NUMBER_OF_YEARS 10000
 
 /**
- * @brief   Adds a number of passengers to an airport in a `airport code -> passengers` hash table.
- * @details Auxiliary function for ::__q06_generate_statistics_foreach_flight, itself an auxiliary
- *          method for ::__q06_generate_statistics.
- *
- * @param airport_count  `GHashTable` that associates airports (::airport_code_t) with numbers of
- *                       passengers.
- * @param airport        Airport to add passengers to.
- * @param num_passengers Number of passengers to be added to @p airport in @p airport_count.
+ * @brief   One in how many flights is counted, when all queries are approximate.
+ * @details Counts are then scaled up by this factor.
  */
-void __q06_generate_statistics_add_passengers(GHashTable    *airport_count,
-                                              airport_code_t airport,
-                                              uint16_t       num_passengers) {
-    const uint64_t origin_count =
-        GPOINTER_TO_UINT(g_hash_table_lookup(airport_count, GUINT_TO_POINTER(airport)));
-    g_hash_table_insert(airport_count,
-                        GUINT_TO_POINTER(airport),
-                        GUINT_TO_POINTER(num_passengers + origin_count));
-}
-
-/**
- * @brief   Method called for each flight, to generate statistical data.
- * @details An auxiliary method for ::__q06_generate_statistics.
- *
- * @param user_data A `GHashTable` that associates a year with another `GHashTable`, that itself
- *                  associates airport codes with numbers of passengers (integers).
- * @param flight    The flight to consider.
- *
- * @retval 0 Always successful.
- */
-int __q06_generate_statistics_foreach_flight(void *user_data, const flight_t *flight) {
-    const uint16_t year =
-        date_get_year(date_and_time_get_date(flight_get_schedule_departure_date(flight)));
-
-    /* Get the airport code -> passenger count mapping */
-    GHashTable *const airport_count = g_hash_table_lookup(user_data, GUINT_TO_POINTER(year));
-    if (!airport_count)
-        return 0; /* Year not asked for in queries */
-
-    const airport_code_t origin         = flight_get_origin(flight);
-    const airport_code_t destination    = flight_get_destination(flight);
-    const uint16_t       num_passengers = flight_get_number_of_passengers(flight);
-
-    __q06_generate_statistics_add_passengers(airport_count, origin, num_passengers);
-    __q06_generate_statistics_add_passengers(airport_count, destination, num_passengers);
-    return 0;
-}
+#define Q06_APPROXIMATE_SAMPLING_RATE 16
 
 /**
  * @struct q06_array_item_t
@@ -159,36 +108,127 @@ int __q06_generate_statistics_foreach_flight(void *user_data, const flight_t *fl
  *     @brief An airport.
  * @var q06_array_item_t::count
  *     @brief The number of passangers of q06_array_item_t::airport.
+ * @var q06_array_item_t::error
+ *     @brief   Half-width of a 95% confidence interval of ::q06_array_item_t::count.
+ *     @details `0` when all flights were counted.
  */
 typedef struct {
     airport_code_t airport;
-    uint32_t       count;
+    uint32_t       count, error;
 } q06_array_item_t;
 
 /**
- * @brief   Method called for each airport-passenger count pair in a `GHashTable`, which is added to
- *          a `GArray`.
- * @details An auxiliary method for ::__q06_generate_statistics_foreach_year.
+ * @struct  q06_top_airports_t
+ * @brief   Airports by number of passengers, for each year when first needed.
+ * @details Kept apart from ::q06_statistical_data_t, as it's modified while executing queries.
+ *          Only as many airports as asked for by queries are sorted.
  *
- * @param key       The key in the `GHashTable`, an ::airport_code_t.
- * @param value     The value in the `GHashTable`, an integer (as a pointer).
- * @param user_data The `GArray` of airport + passanger count tuples (::q06_array_item_t).
+ * @var q06_top_airports_t::lock
+ *     @brief Lock that protects ::q06_top_airports_t::years from being modified by multiple
+ *            threads at the same time.
+ * @var q06_top_airports_t::years
+ *     @brief ::top_k_array_t of ::q06_array_item_t for each year, or `NULL` for years that
+ *            haven't been needed yet.
  */
-void __q06_foreach_airport_count(gpointer key, gpointer value, gpointer user_data) {
-    const q06_array_item_t item = {.airport = GPOINTER_TO_UINT(key),
-                                   .count   = GPOINTER_TO_UINT(value)};
-    g_array_append_val(user_data, item);
+typedef struct {
+    pthread_mutex_t lock;
+    top_k_array_t  *years[Q06_NUMBER_OF_YEARS];
+} q06_top_airports_t;
+
+/**
+ * @struct q06_statistical_data_t
+ * @brief  Statistical data for queries of type 6: passengers by year and airport.
+ *
+ * @var q06_statistical_data_t::passengers
+ *     @brief ::group_by_t of numbers of passengers grouped by ::airport_code_t, for each year
+ *            (`NULL` for years without flights).
+ * @var q06_statistical_data_t::top
+ *     @brief Airports sorted by number of passengers, for each year.
+ * @var q06_statistical_data_t::sampling_rate
+ *     @brief One in how many flights was counted (`1` unless generated for approximate queries
+ *            only).
+ */
+typedef struct {
+    group_by_t         *passengers[Q06_NUMBER_OF_YEARS];
+    q06_top_airports_t *top;
+    uint32_t            sampling_rate;
+} q06_statistical_data_t;
+
+/**
+ * @brief   Gets the passenger count of a year, creating it if needed.
+ * @details Auxiliary function for ::__q06_generate_statistics_foreach_flights, itself an auxiliary
+ *          method for ::__q06_generate_statistics, and for ::__q06_load_statistics.
+ *
+ * @param stats   Statistical data being generated.
+ * @param year    Year to get the passenger count of.
+ * @param columns Flights whose airport dictionary (::flight_manager_columns_t::airports) is used
+ *                for the keys of new passenger counts, or `NULL` for counts keyed by
+ *                ::airport_code_t.
+ *
+ * @return The passenger count of @p year, or `NULL` on allocation failure.
+ */
+group_by_t *__q06_generate_statistics_get_year(q06_statistical_data_t         *stats,
+                                               uint16_t                        year,
+                                               const flight_manager_columns_t *columns) {
+    if (!stats->passengers[year]) {
+        if (columns)
+            stats->passengers[year] = group_by_create_with_keys(GROUP_BY_AGGREGATE_SUM,
+                                                                columns->nairports,
+                                                                columns->airports);
+        else
+            stats->passengers[year] = group_by_create(GROUP_BY_AGGREGATE_SUM, 0);
+    }
+    return stats->passengers[year];
+}
+
+/**
+ * @brief   Method called for each block of flights, to generate statistical data.
+ * @details An auxiliary method for ::__q06_generate_statistics.
+ *
+ * @param user_data A pointer to a ::q06_statistical_data_t.
+ * @param columns   The flights to consider.
+ * @param n         Number of flights in @p columns.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __q06_generate_statistics_foreach_flights(void                           *user_data,
+                                              const flight_manager_columns_t *columns,
+                                              size_t                          n) {
+    q06_statistical_data_t *const stats = user_data;
+
+    for (size_t i = 0; i < n; ++i) {
+        /* Deterministic (hash-based) sampling, for threads to agree on which flights are counted */
+        if (stats->sampling_rate > 1 &&
+            ((uint32_t) (columns->id[i] * 0x9E3779B1u) >> 16) % stats->sampling_rate)
+            continue;
+
+        const uint16_t year =
+            date_get_year(date_and_time_get_date(columns->schedule_departure_date[i]));
+
+        /* Get the year's passenger count (for every year, to be reusable) */
+        group_by_t *const year_count = __q06_generate_statistics_get_year(stats, year, columns);
+        if (!year_count)
+            return 1;
+
+        /* Airports are numbered densely, so that passengers are counted in arrays */
+        const uint16_t num_passengers = columns->number_of_passengers[i];
+        if (group_by_add(year_count, columns->origin_ordinal[i], num_passengers) ||
+            group_by_add(year_count, columns->destination_ordinal[i], num_passengers))
+            return 1;
+    }
+    return 0;
 }
 
 /**
  * @brief   Comparison function for ::q06_array_item_t.
- * @details Used for array sorting in ::__q06_generate_statistics_foreach_year.
+ * @details Used for selecting the top airports in ::__q06_get_top_airports.
  */
-gint __q06_sort_airports_by_count(gconstpointer a, gconstpointer b) {
+int __q06_sort_airports_by_count(const void *a, const void *b) {
     const q06_array_item_t *const item_a = a;
     const q06_array_item_t *const item_b = b;
 
-    const int64_t crit1 = item_b->count - item_a->count;
+    const int64_t crit1 = (int64_t) item_b->count - (int64_t) item_a->count;
     if (crit1)
         return crit1;
 
@@ -201,127 +241,343 @@ gint __q06_sort_airports_by_count(gconstpointer a, gconstpointer b) {
 }
 
 /**
- * @brief   Converts a `GHashTable` (::airport_code_t -> passenger count) to an ordered `GArray` of
- *          key-value tuples (::q06_array_item_t).
- * @details The `GArray` will be inserted into a ::GConstKeyHashTable whose keys are years. This is
- *          an auxiliary method for ::__q06_generate_statistics.
- *
- * @param key_year            Year being processed (as a pointer).
- * @param value_airport_count `GHashTable` (::airport_code_t -> passenger count) associated to
- *                            @p key_year.
- * @param user_data           ::GConstKeyHashTable (year -> tuple array) to write the output array
- *                            to.
+ * @brief Frees statistical data for queries of type 6.
+ * @param statistical_data A pointer to a ::q06_statistical_data_t.
  */
-void __q06_generate_statistics_foreach_year(gpointer key_year,
-                                            gpointer value_airport_count,
-                                            gpointer user_data) {
+void __q06_free_statistics(void *statistical_data) {
+    q06_statistical_data_t *const stats = statistical_data;
+
+    for (size_t i = 0; i < Q06_NUMBER_OF_YEARS; ++i) {
+        if (stats->passengers[i])
+            group_by_free(stats->passengers[i]);
+        if (stats->top->years[i])
+            top_k_array_free(stats->top->years[i]);
+    }
 
-    GHashTable *const airport_count = value_airport_count;
-    GArray *const     airport_count_array =
-        g_array_sized_new(FALSE, FALSE, sizeof(q06_array_item_t), g_hash_table_size(airport_count));
+    pthread_mutex_destroy(&stats->top->lock);
+    free(stats->top);
+    free(stats);
+}
 
-    g_hash_table_foreach(airport_count, __q06_foreach_airport_count, airport_count_array);
-    g_array_sort(airport_count_array, __q06_sort_airports_by_count);
+/**
+ * @brief Merges partial statistical data for queries of type 6.
+ *
+ * @param scan_data    Value returned by ::__q06_generate_statistics.
+ * @param partial_data Another value returned by ::__q06_generate_statistics, filled in by
+ *                     ::__q06_generate_statistics_foreach_flights. It'll be freed.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __q06_generate_statistics_merge(void *scan_data, void *partial_data) {
+    q06_statistical_data_t *const stats   = scan_data;
+    q06_statistical_data_t *const partial = partial_data;
+
+    int retval = 0;
+    for (size_t year = 0; year < Q06_NUMBER_OF_YEARS && !retval; ++year) {
+        group_by_t *const partial_count = partial->passengers[year];
+        if (!partial_count)
+            continue;
+
+        if (stats->passengers[year]) {
+            retval = group_by_merge(stats->passengers[year], partial_count);
+        } else {
+            /* Years only in partial data are moved instead of copied */
+            stats->passengers[year]   = partial_count;
+            partial->passengers[year] = NULL;
+        }
+    }
 
-    g_const_key_hash_table_insert(user_data, key_year, airport_count_array);
+    __q06_free_statistics(partial);
+    return retval;
 }
 
 /**
- * @brief Generates statistical data for queries of type 6.
+ * @brief   Starts generating statistical data for queries of type 6.
+ * @details Passengers are counted by ::__q06_generate_statistics_foreach_flights, and the final
+ *          statistical data is returned by ::__q06_generate_statistics_end. Data is generated for
+ *          all years, not only for the ones in @p instances, so that it can be reused by other
+ *          queries. When all queries are approximate, only a sample of the flights is counted
+ *          (see ::Q06_APPROXIMATE_SAMPLING_RATE).
  *
- * @param database   Database, to iterate through flights.
+ * @param database   Database (not used, as flights are iterated through later).
  * @param n          Number of query instances to be executed.
  * @param instances  Array of query instances to be executed.
  *
- * @return A ::GConstKeyHashTable that associates years with sorted `GArray`s of ::q06_array_item_t
- *         (airport + passenger count tuples).
+ * @return A pointer to a ::q06_statistical_data_t, or `NULL` on allocation failure.
  */
 void *__q06_generate_statistics(const database_t             *database,
                                 size_t                        n,
                                 const query_instance_t *const instances[n]) {
+    (void) database;
 
-    GHashTable *const years_airport_count =
-        g_hash_table_new_full(g_direct_hash,
-                              g_direct_equal,
-                              NULL,
-                              (GDestroyNotify) g_hash_table_unref);
-    for (size_t i = 0; i < n; ++i) {
-        const int16_t year =
-            ((const q06_parsed_arguments_t *) query_instance_get_argument_data(instances[i]))->year;
+    q06_statistical_data_t *const stats = malloc(sizeof(q06_statistical_data_t));
+    if (!stats)
+        return NULL;
 
-        GHashTable *const airport_count = g_hash_table_new(g_direct_hash, g_direct_equal);
-        g_hash_table_insert(years_airport_count, GUINT_TO_POINTER(year), airport_count);
+    stats->sampling_rate =
+        query_instance_are_all_approximate(n, instances) ? Q06_APPROXIMATE_SAMPLING_RATE : 1;
+
+    stats->top = malloc(sizeof(q06_top_airports_t));
+    if (!stats->top) {
+        free(stats);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&stats->top->lock, NULL)) {
+        free(stats->top);
+        free(stats);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < Q06_NUMBER_OF_YEARS; ++i) {
+        stats->passengers[i] = NULL;
+        stats->top->years[i] = NULL;
     }
 
-    flight_manager_iter(database_get_flights(database),
-                        __q06_generate_statistics_foreach_flight,
-                        years_airport_count);
-
-    /* Create a sorted array for each year (instead of a hash table) */
-    GConstKeyHashTable *const years_airport_count_array =
-        g_const_key_hash_table_new_full(g_direct_hash,
-                                        g_direct_equal,
-                                        (GDestroyNotify) g_array_unref);
-    g_hash_table_foreach(years_airport_count,
-                         __q06_generate_statistics_foreach_year,
-                         years_airport_count_array);
-
-    g_hash_table_unref(years_airport_count);
-    return years_airport_count_array;
+    return stats;
 }
 
 /**
- * @brief   Executes a query of type 6.
- * @details Prints the top N airports with the most passangers in a given year.
+ * @brief Finishes generating statistical data for queries of type 6.
  *
- * @param database   Database to get data from (not used, as all data is collected in
- *                   ::__q06_generate_statistics).
- * @param statistics Statistics generated by ::__q06_generate_statistics.
- * @param instance   Query instance to be executed.
- * @param output     Where to write the query's result to.
+ * @param database  Database (not used).
+ * @param scan_data The ::q06_statistical_data_t returned by ::__q06_generate_statistics, after all
+ *                  flights have been counted.
  *
- * @retval 0 Success.
- * @retval 1 Fatal failure (should, in principle, be unreachable).
+ * @return @p scan_data, after discarding data only needed while counting passengers.
  */
-int __q06_execute(const database_t       *database,
-                  const void             *statistics,
-                  const query_instance_t *instance,
-                  query_writer_t         *output) {
+void *__q06_generate_statistics_end(const database_t *database, void *scan_data) {
     (void) database;
+    q06_statistical_data_t *const stats = scan_data;
+
+    for (size_t i = 0; i < Q06_NUMBER_OF_YEARS; ++i)
+        if (stats->passengers[i])
+            group_by_freeze(stats->passengers[i]);
+    return stats;
+}
+
+/**
+ * @brief   Gets the airports of a year with the most passengers, sorting them if needed.
+ * @details Auxiliary method for ::q06_execute. Sorted airports are kept for future queries.
+ *
+ * @param stats Statistical data for queries of type 6.
+ * @param year  Year to get the top airports of.
+ * @param n     Number of airports needed.
+ * @param out_n Where to write the number of airports returned to (at most @p n).
+ *
+ * @return An array of ::q06_array_item_t, or `NULL` if there are no flights in @p year or on
+ *         allocation failure.
+ */
+const q06_array_item_t *__q06_get_top_airports(const q06_statistical_data_t *stats,
+                                               uint16_t                      year,
+                                               size_t                        n,
+                                               size_t                       *out_n) {
+    const group_by_t *const year_count = stats->passengers[year];
+    if (!year_count)
+        return NULL;
+
+    pthread_mutex_lock(&stats->top->lock);
+    top_k_array_t *top = stats->top->years[year];
+    if (!top) {
+        const size_t            nitems = group_by_get_length(year_count);
+        q06_array_item_t *const items  = malloc(sizeof(q06_array_item_t) * nitems);
+        if (!items) {
+            pthread_mutex_unlock(&stats->top->lock);
+            return NULL;
+        }
 
-    const q06_parsed_arguments_t *const args = query_instance_get_argument_data(instance);
+        /* Horvitz-Thompson estimate of the total, and its variance, for Bernoulli sampling */
+        const uint32_t rate = stats->sampling_rate;
+        for (size_t i = 0; i < nitems; ++i) {
+            const double variance =
+                (double) rate * (rate - 1) * group_by_get_sum_of_squares(year_count, i);
 
-    const GConstKeyHashTable *const years_airport_count_array = statistics;
-    const GArray *const             airport_count =
-        g_const_key_hash_table_const_lookup(years_airport_count_array,
-                                            GUINT_TO_POINTER(args->year));
+            items[i].airport = group_by_get_key(year_count, i);
+            items[i].count   = group_by_get_sum(year_count, i) * rate;
+            items[i].error   = ceil(1.96 * sqrt(variance));
+        }
 
-    if (!airport_count) {
-        fprintf(stderr, "Bad statistical data in query 6! This should not happen!\n");
-        return 1; /* Only if statistics are bad, which shouldn't happen */
+        top = top_k_array_create(items,
+                                 nitems,
+                                 sizeof(q06_array_item_t),
+                                 __q06_sort_airports_by_count);
+        stats->top->years[year] = top;
     }
+    pthread_mutex_unlock(&stats->top->lock);
 
-    const size_t i_max = min(args->n, airport_count->len);
-    for (size_t i = 0; i < i_max; ++i) {
-        const q06_array_item_t *const item = &g_array_index(airport_count, q06_array_item_t, i);
+    if (!top)
+        return NULL;
+    return top_k_array_get(top, n, out_n);
+}
 
-        char airport_code_str[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
-        airport_code_sprintf(airport_code_str, item->airport);
+int q06_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
+    (void) database;
+
+    const q06_parsed_arguments_t *const args  = query_instance_get_argument_data(instance);
+    const q06_statistical_data_t *const stats = statistics;
+    if (!stats->passengers[args->year])
+        return 0; /* No flights in that year */
+
+    size_t                        i_max;
+    const q06_array_item_t *const top = __q06_get_top_airports(stats, args->year, args->n, &i_max);
+    if (!top)
+        return 1;
+
+    for (size_t i = 0; i < i_max; ++i) {
+        const q06_array_item_t *const item = &top[i];
 
         query_writer_write_new_object(output);
-        query_writer_write_new_field(output, "name", "%s", airport_code_str);
-        query_writer_write_new_field(output, "passengers", "%" PRIu32, item->count);
+        query_writer_write_new_field_airport_code(output, "name", item->airport);
+        query_writer_write_new_field_unsigned(output, "passengers", item->count);
+        if (query_instance_get_approximate(instance))
+            query_writer_write_new_field_unsigned(output, "passengers_error", item->error);
     }
 
     return 0;
 }
 
+/**
+ * @brief   Writes statistical data for queries of type 6 to a file.
+ * @details For every year with flights, its number and number of airports are written (as two
+ *          `uint32_t`s), followed by a ::q06_array_item_t for each airport.
+ *
+ * @param statistics A pointer to a ::q06_statistical_data_t. Mustn't have been generated from a
+ *                   sample of the flights.
+ * @param file       File where to write @p statistics to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __q06_save_statistics(const void *statistics, FILE *file) {
+    const q06_statistical_data_t *const stats = statistics;
+    if (stats->sampling_rate != 1)
+        return 1;
+
+    for (uint32_t year = 0; year < Q06_NUMBER_OF_YEARS; ++year) {
+        const group_by_t *const year_count = stats->passengers[year];
+        if (!year_count)
+            continue;
+
+        const uint32_t header[2] = {year, group_by_get_length(year_count)};
+        if (fwrite(header, sizeof(uint32_t), 2, file) != 2)
+            return 1;
+
+        for (size_t i = 0; i < header[1]; ++i) {
+            const q06_array_item_t item = {.airport = group_by_get_key(year_count, i),
+                                           .count   = group_by_get_sum(year_count, i),
+                                           .error   = 0};
+            if (fwrite(&item, sizeof(q06_array_item_t), 1, file) != 1)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief   Reads statistical data for queries of type 6, written by ::__q06_save_statistics.
+ * @details Passenger counts are added back to a ::group_by_t for each year, which is quick, as
+ *          there are few airports.
+ *
+ * @param contents Contents of the file written by ::__q06_save_statistics.
+ * @param size     Number of bytes in @p contents.
+ *
+ * @return A pointer to a ::q06_statistical_data_t, or `NULL` if @p contents are corrupt or on
+ *         allocation failure.
+ */
+void *__q06_load_statistics(const char *contents, size_t size) {
+    q06_statistical_data_t *const stats = __q06_generate_statistics(NULL, 0, NULL);
+    if (!stats)
+        return NULL;
+
+    size_t offset = 0;
+    while (offset < size) {
+        uint32_t header[2];
+        if (size - offset < sizeof(header))
+            goto DEFER_1;
+        memcpy(header, contents + offset, sizeof(header));
+        offset += sizeof(header);
+
+        if (header[0] >= Q06_NUMBER_OF_YEARS || stats->passengers[header[0]] ||
+            (size - offset) / sizeof(q06_array_item_t) < header[1])
+            goto DEFER_1;
+
+        group_by_t *const year_count = __q06_generate_statistics_get_year(stats, header[0], NULL);
+        if (!year_count)
+            goto DEFER_1;
+
+        for (size_t i = 0; i < header[1]; ++i) {
+            q06_array_item_t item;
+            memcpy(&item, contents + offset, sizeof(q06_array_item_t));
+            offset += sizeof(q06_array_item_t);
+
+            if (group_by_add(year_count, item.airport, item.count))
+                goto DEFER_1;
+        }
+    }
+
+    return __q06_generate_statistics_end(NULL, stats);
+
+DEFER_1:
+    __q06_free_statistics(stats);
+    return NULL;
+}
+
+/**
+ * @brief   Finds the range of dates the statistical data of some queries of type 6 depends on.
+ * @details Only the years asked for by the queries are needed.
+ *
+ * @param n         Number of query instances in @p instances.
+ * @param instances Instances of the query 6.
+ * @param begin     Where to write the first day of the earliest year to.
+ * @param end       Where to write the last day of the latest year to.
+ *
+ * @retval 0 @p begin and @p end were written.
+ * @retval 1 A year can't be represented as a date.
+ */
+int __q06_date_range(size_t                        n,
+                     const query_instance_t *const instances[n],
+                     date_t                       *begin,
+                     date_t                       *end) {
+
+    uint16_t first_year = UINT16_MAX, last_year = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const q06_parsed_arguments_t *const args = query_instance_get_argument_data(instances[i]);
+        first_year                               = min(first_year, args->year);
+        last_year                                = max(last_year, args->year);
+    }
+
+    return date_from_values(begin, first_year, 1, 1) ||
+           date_from_values(end, last_year, 12, DATE_DAYS_PER_MONTH);
+}
+
 query_type_t *q06_create(void) {
+    const query_type_scan_t scan = {.begin           = __q06_generate_statistics,
+                                    .foreach_flights = __q06_generate_statistics_foreach_flights,
+                                    .end             = __q06_generate_statistics_end,
+                                    .partial_begin   = __q06_generate_statistics,
+                                    .merge           = __q06_generate_statistics_merge,
+                                    .date_range      = __q06_date_range};
+    const query_type_persistence_t persistence = {.save        = __q06_save_statistics,
+                                                  .load        = __q06_load_statistics,
+                                                  .free_loaded = __q06_free_statistics};
+
     return query_type_create(6,
                              __q06_parse_arguments,
-                             __q06_clone_arguments,
-                             free,
-                             __q06_generate_statistics,
-                             (query_type_free_statistics_callback_t) g_hash_table_unref,
-                             __q06_execute);
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             &scan,
+                             __q06_free_statistics,
+                             1,
+                             &persistence,
+                             q06_execute,
+                             NULL,
+                             NULL,
+                             0);
 }
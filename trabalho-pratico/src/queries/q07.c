@@ -19,86 +19,150 @@
  * @brief Implementation of methods in include/queries/q07.h
  */
 
-#include <glib.h>
 #include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "queries/q07.h"
 #include "queries/query_instance.h"
+#include "utils/group_by.h"
 #include "utils/int_utils.h"
+#include "utils/top_k.h"
 
 /**
  * @brief   Parses the arguments of a query of type 7.
- * @details Asserts there's only one integer argument..
+ * @details Asserts there's only one positive integer argument.
  *
- * @param argc Number of arguments.
- * @param argv Values of the arguments.
+ * @param allocator Not used (no strings are stored).
+ * @param output    Where to write the number of airports (a `uint64_t`) to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
  *
- * @return `NULL` for invalid arguments, an integer encoded as a pointer otherwise.
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments.
  */
-void *__q07_parse_arguments(size_t argc, char *const argv[argc]) {
+int __q07_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    (void) allocator;
     if (argc != 1)
-        return NULL;
+        return 1;
 
     /* Parse number of flights */
-    uint64_t  n;
-    const int retval = int_utils_parse_positive(&n, argv[0]);
-    if (retval)
-        return NULL; /* Invalid N format */
-
-    return GUINT_TO_POINTER(n);
+    uint64_t *const n = output;
+    return int_utils_parse_positive(n, argv[0]) || *n == 0; /* Invalid N format */
 }
 
 /**
- * @brief  Creates a deep clone of the value returned by ::__q07_parse_arguments.
- * @param  args_data Non-`NULL` value returned by ::__q07_parse_arguments (an integer encoded as a
- *                   pointer).
- * @return A deep copy of @p args_data.
+ * @struct q07_delays_t
+ * @brief  Delays of flights being collected, while generating statistical data for queries of type
+ *         7.
+ *
+ * @var q07_delays_t::aggregate
+ *     @brief What to keep for each airport in ::q07_delays_t::delays.
+ * @var q07_delays_t::delays
+ *     @brief   ::group_by_t of delays (in seconds), grouped by ::airport_code_t.
+ *     @details Only created for the first block of flights, with its airport dictionary
+ *              (::flight_manager_columns_t::airports). `NULL` until then.
+ * @var q07_delays_t::partials
+ *     @brief   Delays collected by other threads, in ::q07_delays_t::delays of their partial data.
+ *     @details Only merged into ::q07_delays_t::delays when the scan ends, all at once, so that
+ *              the delays of each airport are copied only once (see ::group_by_merge_all).
+ * @var q07_delays_t::npartials
+ *     @brief Number of elements in ::q07_delays_t::partials.
  */
-void *__q07_clone_arguments(const void *args_data) {
-    return (void *) (size_t) args_data; /* Const cast acceptable - it's an just an integer */
-}
+typedef struct {
+    group_by_aggregate_t aggregate;
+    group_by_t          *delays;
+    group_by_t         **partials;
+    size_t               npartials;
+} q07_delays_t;
 
 /**
- * @brief   Frees data generated by ::__q07_parse_arguments.
- * @details Does nothing, as @p args_data is just an integer encoded as a pointer.
- * @param   args_data Data generated by ::__q07_parse_arguments.
+ * @brief Frees delays being collected for queries of type 7.
+ * @param delays Delays to be `free`d.
  */
-void __q07_free_arguments(void *args_data) {
-    (void) args_data;
+void __q07_delays_free(q07_delays_t *delays) {
+    for (size_t i = 0; i < delays->npartials; ++i)
+        group_by_free(delays->partials[i]);
+    free(delays->partials);
+    if (delays->delays)
+        group_by_free(delays->delays);
+    free(delays);
 }
 
 /**
- * @brief   A comparison function for sorting an `GArray` of `int64_t`s.
- * @details Auxiliary method for ::__q07_generate_statistics.
+ * @brief Function called for every block of flights, that adds each flight's delay to the group of
+ *        its origin airport.
+ *
+ * @param user_data A pointer to a ::q07_delays_t.
+ * @param columns   Flights to be processed.
+ * @param n         Number of flights in @p columns.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
  */
-gint __q07_generate_statistics_int64_compare_func(gconstpointer a, gconstpointer b) {
-    return *(const int64_t *) a - *(const int64_t *) b;
+int __q07_generate_statistics_foreach_flights(void                           *user_data,
+                                              const flight_manager_columns_t *columns,
+                                              size_t                          n) {
+    q07_delays_t *const delays = user_data;
+
+    /* Airports are numbered densely, so that delays are grouped in an array */
+    if (!delays->delays) {
+        delays->delays =
+            group_by_create_with_keys(delays->aggregate, columns->nairports, columns->airports);
+        if (!delays->delays)
+            return 1;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t delay = date_and_time_diff(columns->real_departure_date[i],
+                                                 columns->schedule_departure_date[i]);
+        if (group_by_add(delays->delays, columns->origin_ordinal[i], delay))
+            return 1;
+    }
+    return 0;
 }
 
 /**
- * @brief Function called for every flight, that adds it to an array of flights associated with an
- *        airport.
+ * @brief Merges partial statistical data for queries of type 7.
+ *
+ * @details Partial delays are only kept, to be merged in ::__q07_generate_statistics_end.
  *
- * @param user_data A `GHashTable` that associates ::airport_code_t's to `GArray`s of delays
- *                  (`int64_t`),
- * @param flight    Flight to be processed.
+ * @param scan_data    Value returned by ::__q07_generate_statistics.
+ * @param partial_data Another value returned by ::__q07_generate_statistics, filled in by
+ *                     ::__q07_generate_statistics_foreach_flights. It'll be freed.
  *
- * @retval 0 Always. Don't stop iteration.
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
  */
-int __q07_generate_statistics_foreach_flight(void *user_data, const flight_t *flight) {
-    GHashTable *const airport_delays = user_data;
-
-    const airport_code_t airport_code = flight_get_origin(flight);
-    const int64_t        delay        = date_and_time_diff(flight_get_real_departure_date(flight),
-                                             flight_get_schedule_departure_date(flight));
+int __q07_generate_statistics_merge(void *scan_data, void *partial_data) {
+    q07_delays_t *const delays  = scan_data;
+    q07_delays_t *const partial = partial_data;
+
+    if (!partial->delays || !delays->delays) {
+        /* Nothing to merge, or delays to be merged into */
+        if (!delays->delays) {
+            delays->delays  = partial->delays;
+            partial->delays = NULL;
+        }
+
+        __q07_delays_free(partial);
+        return 0;
+    }
 
-    GArray *delays = g_hash_table_lookup(airport_delays, GUINT_TO_POINTER(airport_code));
-    if (!delays) {
-        delays = g_array_new(FALSE, FALSE, sizeof(int64_t));
-        g_hash_table_insert(airport_delays, GUINT_TO_POINTER(airport_code), delays);
+    group_by_t **const partials =
+        realloc(delays->partials, (delays->npartials + 1) * sizeof(group_by_t *));
+    if (!partials) {
+        __q07_delays_free(partial);
+        return 1;
     }
 
-    g_array_append_val(delays, delay);
+    partials[delays->npartials++] = partial->delays;
+    delays->partials              = partials;
+    free(partial);
     return 0;
 }
 
@@ -110,50 +174,27 @@ int __q07_generate_statistics_foreach_flight(void *user_data, const flight_t *fl
  *     @brief Airport to whom ::q07_airport_median::median applies.
  * @var q07_airport_median::median
  *     @brief Departure delay median of q07_airport_median::airport_code.
+ * @var q07_airport_median::error
+ *     @brief Upper bound of the absolute error of ::q07_airport_median::median (`0` unless
+ *            generated for approximate queries only).
  */
 typedef struct {
     airport_code_t airport_code;
     int64_t        median;
+    uint64_t       error;
 } q07_airport_median;
 
-/**
- * @brief Function called for every airport, to generate an array of ::q07_airport_median.
- *
- * @param key       An `airport_code_t` as a pointer.
- * @param value     A pointer to a `GArray` of `int64_t`, the delays of all flights in seconds.
- * @param user_data A `GArray` of ::q07_airport_median to which a new value will be added.
- */
-void __q07_generate_statistics_foreach_airport(gpointer key, gpointer value, gpointer user_data) {
-    const airport_code_t airport = GPOINTER_TO_UINT(key);
-    GArray *const        delays  = value;
-    GArray *const        to_add  = user_data;
-
-    g_array_sort(delays, __q07_generate_statistics_int64_compare_func);
-
-    double median;
-    if (delays->len % 2 == 0) {
-        const size_t middle = delays->len / 2;
-        median              = (g_array_index(delays, uint64_t, middle) +
-                  g_array_index(delays, uint64_t, middle - 1)) *
-                 0.5;
-    } else {
-        median = g_array_index(delays, uint64_t, delays->len / 2);
-    }
-
-    const q07_airport_median airport_median = {.airport_code = airport, .median = round(median)};
-    g_array_append_val(to_add, airport_median);
-}
-
 /**
  * @brief   Comparsion criteria for sorting arrays of ::q07_airport_median.
- * @details Auxiliary method for ::__q07_generate_statistics.
+ * @details Auxiliary method for ::__q07_generate_statistics_end, that's used to select the top
+ *          airports.
  *
  * @param a Pointer to a `const` ::q07_airport_median.
  * @param b Pointer to a `const` ::q07_airport_median.
  *
  * @return Comparison value between @p a and @p b.
  */
-gint __q07_generate_statistics_airport_median_compare_func(gconstpointer a, gconstpointer b) {
+int __q07_generate_statistics_airport_median_compare_func(const void *a, const void *b) {
     const q07_airport_median *const airport_median_a = a;
     const q07_airport_median *const airport_median_b = b;
 
@@ -170,80 +211,236 @@ gint __q07_generate_statistics_airport_median_compare_func(gconstpointer a, gcon
 }
 
 /**
- * @brief Generates statistical data for queries of type 7.
+ * @struct  q07_statistical_data_t
+ * @brief   Statistical data for queries of type 7: airports by median delay.
+ * @details Airports are only sorted as needed by queries (see ::top_k_array_t), so that N airports
+ *          don't need the whole array to be sorted.
+ *
+ * @var q07_statistical_data_t::airport_medians
+ *     @brief ::top_k_array_t of ::q07_airport_median.
+ */
+typedef struct {
+    top_k_array_t *airport_medians;
+} q07_statistical_data_t;
+
+/**
+ * @brief Frees statistical data for queries of type 7.
+ * @param statistical_data A pointer to a ::q07_statistical_data_t.
+ */
+void __q07_free_statistics(void *statistical_data) {
+    q07_statistical_data_t *const stats = statistical_data;
+    top_k_array_free(stats->airport_medians);
+    free(stats);
+}
+
+/**
+ * @brief   Starts generating statistical data for queries of type 7.
+ * @details Delays are added to the returned data by ::__q07_generate_statistics_foreach_flights,
+ *          and the final statistical data is returned by ::__q07_generate_statistics_end.
  *
- * @param database  Database, to iterate through flights.
+ * @param database  Database (not used, as flights are iterated through later).
  * @param n         Number of query instances that will need to be executed.
- * @param instances Query instances that will need to be executed.
+ * @param instances Query instances that will need to be executed. When all of them are
+ *                  approximate, delays are summarized in a ::t_digest_t instead of being kept.
  *
- * @return A sorted `GArray` of ::q07_airport_median.
+ * @return A pointer to a ::q07_delays_t, or `NULL` on allocation failure.
  */
 void *__q07_generate_statistics(const database_t             *database,
                                 size_t                        n,
                                 const query_instance_t *const instances[n]) {
-    (void) instances;
-    (void) n;
-
-    /* Associate each airport with list of delays */
-    GHashTable *const airport_delays =
-        g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_array_unref);
-    flight_manager_iter(database_get_flights(database),
-                        __q07_generate_statistics_foreach_flight,
-                        airport_delays);
-
-    /* Calulate sorted array of airports with delays */
-    GArray *const airport_medians = g_array_new(FALSE, FALSE, sizeof(q07_airport_median));
-    g_hash_table_foreach(airport_delays,
-                         __q07_generate_statistics_foreach_airport,
-                         airport_medians);
-    g_array_sort(airport_medians, __q07_generate_statistics_airport_median_compare_func);
-
-    g_hash_table_unref(airport_delays);
-    return airport_medians;
+    (void) database;
+
+    q07_delays_t *const delays = malloc(sizeof(q07_delays_t));
+    if (!delays)
+        return NULL;
+
+    /* Consecutive flights often share their origin, which ::group_by_add takes advantage of */
+    delays->aggregate = query_instance_are_all_approximate(n, instances)
+                            ? GROUP_BY_AGGREGATE_DIGEST
+                            : GROUP_BY_AGGREGATE_VALUES;
+    delays->delays    = NULL;
+    delays->partials  = NULL;
+    delays->npartials = 0;
+    return delays;
 }
 
 /**
- * @brief Executes a query of type 7.
+ * @brief Finishes generating statistical data for queries of type 7, by calculating the median
+ *        delay of every airport.
  *
- * @param database   Database to get data from (not used, as all data is collected in
- *                   ::__q07_generate_statistics).
- * @param statistics Value returned by ::__q07_generate_statistics (a sorted `GArray` of
- *                   ::q07_airport_median.)
- * @param instance   Query instance to be executed.
- * @param output     Where to write the query's output to.
+ * @param database  Database (not used).
+ * @param scan_data The ::q07_delays_t returned by ::__q07_generate_statistics, after all flights
+ *                  have been added to it. It will be freed.
  *
- * @retval 0 Always successful.
+ * @return A pointer to a ::q07_statistical_data_t, or `NULL` on allocation failure.
  */
-int __q07_execute(const database_t       *database,
-                  const void             *statistics,
-                  const query_instance_t *instance,
-                  query_writer_t         *output) {
+void *__q07_generate_statistics_end(const database_t *database, void *scan_data) {
     (void) database;
+    q07_delays_t *const delays = scan_data;
 
-    const uint64_t      n = GPOINTER_TO_UINT(query_instance_get_argument_data(instance));
-    const GArray *const airport_medians = statistics;
+    /* No flights were scanned */
+    if (!delays->delays) {
+        delays->delays = group_by_create(delays->aggregate, 0);
+        if (!delays->delays)
+            goto DEFER_1;
+    }
 
-    const size_t i_max = min(n, airport_medians->len);
-    for (size_t i = 0; i < i_max; i++) {
-        const q07_airport_median *const airport_median =
-            &g_array_index(airport_medians, q07_airport_median, i);
+    group_by_t *const airport_delays = delays->delays;
+    if (group_by_merge_all(airport_delays, delays->partials, delays->npartials))
+        goto DEFER_1;
 
-        char airport_code_str[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
-        airport_code_sprintf(airport_code_str, airport_median->airport_code);
+    q07_statistical_data_t *const stats = malloc(sizeof(q07_statistical_data_t));
+    if (!stats)
+        goto DEFER_1;
+
+    /* Calulate array of airports with delays, to be sorted when executing queries */
+    const size_t              nairports = group_by_get_length(airport_delays);
+    q07_airport_median *const medians   = malloc(sizeof(q07_airport_median) * nairports);
+    if (!medians) {
+        free(stats);
+        goto DEFER_1;
+    }
+
+    for (size_t i = 0; i < nairports; ++i) {
+        /* Selection instead of sorting, as only the middle values are needed */
+        double       error;
+        const double median = group_by_calculate_median(airport_delays, i, &error);
+        medians[i] = (q07_airport_median) {.airport_code = group_by_get_key(airport_delays, i),
+                                           .median       = round(median),
+                                           .error        = ceil(error)};
+    }
+
+    stats->airport_medians =
+        top_k_array_create(medians,
+                           nairports,
+                           sizeof(q07_airport_median),
+                           __q07_generate_statistics_airport_median_compare_func);
+    if (!stats->airport_medians) {
+        free(stats);
+        goto DEFER_1;
+    }
+
+    __q07_delays_free(delays);
+    return stats;
+
+DEFER_1:
+    __q07_delays_free(delays);
+    return NULL;
+}
+
+int q07_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
+    (void) database;
+
+    const uint64_t n = *(const uint64_t *) query_instance_get_argument_data(instance);
+    const q07_statistical_data_t *const stats = statistics;
+
+    size_t                          i_max;
+    const q07_airport_median *const top = top_k_array_get(stats->airport_medians, n, &i_max);
+    for (size_t i = 0; i < i_max; i++) {
+        const q07_airport_median *const airport_median = &top[i];
 
         query_writer_write_new_object(output);
-        query_writer_write_new_field(output, "name", "%s", airport_code_str);
-        query_writer_write_new_field(output, "median", "%" PRIu64, airport_median->median);
+        query_writer_write_new_field_airport_code(output, "name", airport_median->airport_code);
+        query_writer_write_new_field_unsigned(output, "median", airport_median->median);
+        if (query_instance_get_approximate(instance))
+            query_writer_write_new_field_unsigned(output, "median_error", airport_median->error);
     }
     return 0;
 }
 
+/**
+ * @brief   Writes statistical data for queries of type 7 to a file.
+ * @details The number of airports is written, followed by all of them (sorting them all, which is
+ *          cheap, as there are few airports).
+ *
+ * @param statistics A pointer to a ::q07_statistical_data_t.
+ * @param file       File where to write @p statistics to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure (or allocation failure).
+ */
+int __q07_save_statistics(const void *statistics, FILE *file) {
+    const q07_statistical_data_t *const stats = statistics;
+
+    size_t                          nairports;
+    const q07_airport_median *const medians =
+        top_k_array_get(stats->airport_medians, SIZE_MAX, &nairports);
+    if (!medians && nairports)
+        return 1;
+
+    const uint64_t n = nairports;
+    return fwrite(&n, sizeof(uint64_t), 1, file) != 1 ||
+           fwrite(medians, sizeof(q07_airport_median), nairports, file) != nairports;
+}
+
+/**
+ * @brief   Reads statistical data for queries of type 7, written by ::__q07_save_statistics.
+ * @details Airports are copied out of the mapped file, as a ::top_k_array_t sorts them in place.
+ *
+ * @param contents Contents of the file written by ::__q07_save_statistics.
+ * @param size     Number of bytes in @p contents.
+ *
+ * @return A pointer to a ::q07_statistical_data_t, or `NULL` if @p contents are corrupt or on
+ *         allocation failure.
+ */
+void *__q07_load_statistics(const char *contents, size_t size) {
+    uint64_t n;
+    if (size < sizeof(uint64_t))
+        return NULL;
+    memcpy(&n, contents, sizeof(uint64_t));
+    if (n != (size - sizeof(uint64_t)) / sizeof(q07_airport_median) ||
+        (size - sizeof(uint64_t)) % sizeof(q07_airport_median))
+        return NULL;
+
+    q07_statistical_data_t *const stats = malloc(sizeof(q07_statistical_data_t));
+    if (!stats)
+        return NULL;
+
+    q07_airport_median *const medians = malloc(sizeof(q07_airport_median) * n);
+    if (!medians) {
+        free(stats);
+        return NULL;
+    }
+    memcpy(medians, contents + sizeof(uint64_t), sizeof(q07_airport_median) * n);
+
+    stats->airport_medians =
+        top_k_array_create(medians,
+                           n,
+                           sizeof(q07_airport_median),
+                           __q07_generate_statistics_airport_median_compare_func);
+    if (!stats->airport_medians) {
+        free(stats);
+        return NULL;
+    }
+    return stats;
+}
+
 query_type_t *q07_create(void) {
+    const query_type_scan_t scan = {.begin           = __q07_generate_statistics,
+                                    .foreach_flights = __q07_generate_statistics_foreach_flights,
+                                    .end             = __q07_generate_statistics_end,
+                                    .partial_begin   = __q07_generate_statistics,
+                                    .merge           = __q07_generate_statistics_merge};
+    const query_type_persistence_t persistence = {.save        = __q07_save_statistics,
+                                                  .load        = __q07_load_statistics,
+                                                  .free_loaded = __q07_free_statistics};
+
     return query_type_create(7,
                              __q07_parse_arguments,
-                             __q07_clone_arguments,
-                             __q07_free_arguments,
-                             __q07_generate_statistics,
-                             (query_type_free_statistics_callback_t) g_array_unref,
-                             __q07_execute);
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             &scan,
+                             __q07_free_statistics,
+                             1,
+                             &persistence,
+                             q07_execute,
+                             NULL,
+                             NULL,
+                             0);
 }
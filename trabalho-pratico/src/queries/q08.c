@@ -19,11 +19,15 @@
  * @brief Implementation of methods in include/queries/q08.h
  */
 
-#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "queries/q08.h"
 #include "queries/query_instance.h"
+#include "utils/cache_line.h"
+#include "utils/date_overlap.h"
+#include "utils/glib/GConstKeyHashTable.h"
+#include "utils/int_utils.h"
 
 /**
  * @struct q08_parsed_arguments_t
@@ -46,205 +50,490 @@ typedef struct {
  * @brief   Parses arguments for query 8.
  * @details Asserts that there's three arguments, an hotel identifier and two dates.
  *
- * @param argc Number of arguments.
- * @param argv Values of the arguments.
+ * @param allocator Not used (no strings are stored).
+ * @param output    Where to write the ::q08_parsed_arguments_t to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
  *
- * @return `NULL` on parsing or allocation failure, a pointer to a ::q08_parsed_arguments_t
- *         otherwise.
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments.
  */
-void *__q08_parse_arguments(size_t argc, char *const argv[argc]) {
+int __q08_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    (void) allocator;
     if (argc != 3)
-        return NULL;
+        return 1;
 
-    q08_parsed_arguments_t *const parsed_arguments = malloc(sizeof(q08_parsed_arguments_t));
-    if (!parsed_arguments)
-        return NULL;
+    q08_parsed_arguments_t *const parsed_arguments = output;
 
     const int hotel_retval      = hotel_id_from_string(&parsed_arguments->hotel_id, argv[0]);
     const int begin_date_retval = date_from_string(&parsed_arguments->begin_date, argv[1]);
     const int end_date_retval   = date_from_string(&parsed_arguments->end_date, argv[2]);
 
-    if (hotel_retval || begin_date_retval || end_date_retval) {
-        free(parsed_arguments);
-        return NULL;
-    }
-    return parsed_arguments;
+    return hotel_retval || begin_date_retval || end_date_retval;
 }
 
 /**
- * @brief  Creates a deep clone of the value returned by ::__q08_parse_arguments.
- * @param  args_data Non-`NULL` value returned by ::__q08_parse_arguments (a pointer to a
- *                   ::q08_parsed_arguments_t).
- * @return A deep copy of @p args_data.
+ * @struct  q08_hotel_revenue_t
+ * @brief   Daily revenue of a hotel, for range lookups.
+ * @details While reservations are being iterated through, only
+ *          ::q08_hotel_revenue_t::daily_changes is filled. Its prefix sums are then turned into
+ *          ::q08_hotel_revenue_t::cumulative, in ::__q08_generate_statistics_end.
+ *
+ * @var q08_hotel_revenue_t::first_day
+ *     @brief First day with any revenue (first day of the earliest reservation of the hotel).
+ * @var q08_hotel_revenue_t::daily_changes
+ *     @brief `GArray` of `int64_t`, where each element is the difference between the revenue on a
+ *            day (counted from ::q08_hotel_revenue_t::first_day) and the revenue on the day
+ *            before.
+ * @var q08_hotel_revenue_t::cumulative
+ *     @brief Array of ::q08_hotel_revenue_t::ndays `+ 1` elements, where the `i`-th element is the
+ *            total revenue during the first `i` days since ::q08_hotel_revenue_t::first_day.
+ * @var q08_hotel_revenue_t::ndays
+ *     @brief Number of days with revenue information.
  */
-void *__q08_clone_arguments(const void *args_data) {
-    const q08_parsed_arguments_t *const args  = args_data;
-    q08_parsed_arguments_t *const       clone = malloc(sizeof(q08_parsed_arguments_t));
-    if (!clone)
-        return NULL;
+typedef struct {
+    date_t    first_day;
+    GArray   *daily_changes;
+    uint64_t *cumulative;
+    size_t    ndays;
+} q08_hotel_revenue_t;
 
-    memcpy(clone, args, sizeof(q08_parsed_arguments_t));
-    return clone;
+/**
+ * @brief Frees a ::q08_hotel_revenue_t, in a hash table of statistical data for query 8.
+ * @param data A pointer to a ::q08_hotel_revenue_t.
+ */
+void __q08_hotel_revenue_free(gpointer data) {
+    q08_hotel_revenue_t *const revenue = data;
+    if (revenue->daily_changes)
+        g_array_unref(revenue->daily_changes);
+    free(revenue->cumulative);
+    free(revenue);
 }
 
 /**
- * @struct q08_statistical_data_t
- * @brief  Association between query instances and hotel revenue prices.
+ * @brief   Generates statistical data for queries of type 8.
+ * @details The returned hash table is only filled after all reservations are iterated through
+ *          with ::__q08_generate_statistics_foreach_reservations. Revenue is calculated for every
+ *          hotel, so that the same statistical data can answer queries in future dispatches.
+ *
+ * @param database   Database (not used, as reservations are iterated through later).
+ * @param n          Number of query instances (not used).
+ * @param instances  Instances of the query 8 (not used).
  *
- * @var q08_statistical_data_t::n
- *     @brief Number of query instances (same as ::q08_statistical_data_t::filters and
- *            ::q08_statistical_data_t::revenues).
- * @var q08_statistical_data_t::filters
- *     @brief Query instances that need to be answered.
- * @var q08_statistical_data_t::revenues
- *     @brief Revenues of hotels (associated to ::q08_statistical_data_t::filters).
+ * @return A ::GConstKeyHashTable associating hotel identifiers (integers) with
+ *         ::q08_hotel_revenue_t.
  */
-typedef struct {
-    size_t                  n;
-    q08_parsed_arguments_t *filters;
-    uint64_t               *revenues;
-} q08_statistical_data_t;
+void *__q08_generate_statistics(const database_t             *database,
+                                size_t                        n,
+                                const query_instance_t *const instances[n]) {
+    (void) database;
+    (void) instances;
+
+    return g_const_key_hash_table_new_full(g_direct_hash, g_direct_equal, __q08_hotel_revenue_free);
+}
 
 /**
- * @brief   A method called for each reservation, to calculate the revenue of a hotel.
- * @details An auxiliary method for ::__q08_generate_statistics.
+ * @brief Moves the first day of a hotel's revenue back, to an earlier day.
  *
- * @param user_data   A pointer to a ::q08_statistical_data_t.
- * @param reservation Reservation being processed.
+ * @param hotel     Revenue of the hotel being modified.
+ * @param first_day New first day of @p hotel. Mustn't be after ::q08_hotel_revenue_t::first_day.
+ */
+void __q08_hotel_revenue_move_first_day(q08_hotel_revenue_t *hotel, date_t first_day) {
+    const int64_t shift = date_diff(hotel->first_day, first_day);
+    if (shift <= 0)
+        return;
+
+    const size_t old_length = hotel->daily_changes->len;
+    g_array_set_size(hotel->daily_changes, old_length + shift);
+
+    int64_t *const changes = (int64_t *) hotel->daily_changes->data;
+    memmove(changes + shift, changes, old_length * sizeof(int64_t));
+    memset(changes, 0, shift * sizeof(int64_t));
+    hotel->first_day = first_day;
+}
+
+/**
+ * @brief   A method called for each block of reservations, to add their revenue to their hotels.
+ * @details An auxiliary method for ::__q08_generate_statistics. Consecutive reservations are
+ *          usually from the same hotel, so the last hotel looked up is kept.
  *
- * @retval 0 Always successful.
+ * @param user_data A ::GConstKeyHashTable associating hotel identifiers with
+ *                  ::q08_hotel_revenue_t.
+ * @param columns   Reservations being processed.
+ * @param n         Number of reservations in @p columns.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
  */
-int __q08_generate_statistics_foreach_reservation(void                *user_data,
-                                                  const reservation_t *reservation) {
-    q08_statistical_data_t *const stats    = user_data;
-    const hotel_id_t              hotel_id = reservation_get_hotel_id(reservation);
+int __q08_generate_statistics_foreach_reservations(void                                *user_data,
+                                                   const reservation_manager_columns_t *columns,
+                                                   size_t                               n) {
+    q08_hotel_revenue_t *hotel      = NULL;
+    hotel_id_t           last_hotel = 0;
+
+    for (size_t r = 0; r < n; ++r) {
+        const hotel_id_t hotel_id          = columns->hotel_id[r];
+        const date_t     reservation_begin = columns->begin_date[r];
+        date_t           reservation_end   = columns->end_date[r];
+
+        /* Reservations don't make money on their last day */
+        date_set_day(&reservation_end, date_get_day(reservation_end) - 1);
+
+        if (!hotel || hotel_id != last_hotel) {
+            hotel = g_const_key_hash_table_lookup(user_data, GUINT_TO_POINTER(hotel_id));
+            if (!hotel) {
+                /* Other threads may be filling in their own partial data for the same hotel */
+                hotel = cache_line_calloc(sizeof(q08_hotel_revenue_t));
+                if (!hotel)
+                    return 1;
+
+                hotel->first_day     = reservation_begin;
+                hotel->daily_changes = g_array_new(FALSE, TRUE, sizeof(int64_t));
+                hotel->cumulative    = NULL;
+                hotel->ndays         = 0;
+                g_const_key_hash_table_insert(user_data, GUINT_TO_POINTER(hotel_id), hotel);
+            }
+            last_hotel = hotel_id;
+        }
 
-    for (size_t i = 0; i < stats->n; i++) {
-        const q08_parsed_arguments_t *const args = &stats->filters[i];
+        /* Move the beginning of the array back for reservations earlier than all others */
+        __q08_hotel_revenue_move_first_day(hotel, reservation_begin);
 
-        if (hotel_id == args->hotel_id) {
-            const uint16_t price_per_night   = reservation_get_price_per_night(reservation);
-            const date_t   reservation_begin = reservation_get_begin_date(reservation);
-            date_t         reservation_end   = reservation_get_end_date(reservation);
+        const int64_t begin_index = date_diff(reservation_begin, hotel->first_day);
+        const int64_t end_index   = date_diff(reservation_end, hotel->first_day) + 1;
+        if (end_index <= begin_index)
+            continue;
 
-            /* Reservations don't make money on their last day */
-            date_set_day(&reservation_end, date_get_day(reservation_end) - 1);
-            if (date_diff(args->begin_date, reservation_end) > 0 ||
-                date_diff(reservation_begin, args->end_date) > 0)
-                continue;
+        if (hotel->daily_changes->len < (size_t) end_index + 1)
+            g_array_set_size(hotel->daily_changes, end_index + 1);
 
-            const date_t range_begin = date_diff(reservation_begin, args->begin_date) < 0
-                                           ? args->begin_date
-                                           : reservation_begin;
-            const date_t range_end =
-                date_diff(reservation_end, args->end_date) < 0 ? reservation_end : args->end_date;
+        const int64_t price_per_night = columns->price_per_night[r];
+        g_array_index(hotel->daily_changes, int64_t, begin_index) += price_per_night;
+        g_array_index(hotel->daily_changes, int64_t, end_index) -= price_per_night;
+    }
+    return 0;
+}
+
+/**
+ * @struct q08_merge_data_t
+ * @brief  Data needed while merging partial statistical data, in ::__q08_generate_statistics_merge.
+ *
+ * @var q08_merge_data_t::hotels
+ *     @brief ::GConstKeyHashTable to merge partial data into.
+ * @var q08_merge_data_t::failure
+ *     @brief Set to `1` on allocation failure.
+ */
+typedef struct {
+    GConstKeyHashTable *hotels;
+    int                 failure;
+} q08_merge_data_t;
 
-            stats->revenues[i] += price_per_night * (date_diff(range_end, range_begin) + 1);
+/**
+ * @brief   Adds the revenue of a hotel in partial statistical data to the complete data.
+ * @details Auxiliary method for ::__q08_generate_statistics_merge.
+ *
+ * @param hotel_id  Hotel identifier encoded as a pointer.
+ * @param hotel     A pointer to a ::q08_hotel_revenue_t, in partial data.
+ * @param user_data A pointer to a ::q08_merge_data_t.
+ */
+void __q08_generate_statistics_merge_hotel(gconstpointer hotel_id,
+                                           gpointer      hotel,
+                                           gpointer      user_data) {
+    const q08_hotel_revenue_t *const partial = hotel;
+    q08_merge_data_t *const          data    = user_data;
+
+    q08_hotel_revenue_t *const merged = g_const_key_hash_table_lookup(data->hotels, hotel_id);
+    if (!merged) {
+        q08_hotel_revenue_t *const copy = malloc(sizeof(q08_hotel_revenue_t));
+        if (!copy) {
+            data->failure = 1;
+            return;
         }
+
+        copy->first_day     = partial->first_day;
+        copy->daily_changes = g_array_ref(partial->daily_changes); /* Partial data is freed later */
+        copy->cumulative    = NULL;
+        copy->ndays         = 0;
+        g_const_key_hash_table_insert(data->hotels, hotel_id, copy);
+        return;
     }
 
-    return 0;
+    __q08_hotel_revenue_move_first_day(merged, partial->first_day);
+
+    const size_t offset = date_diff(partial->first_day, merged->first_day);
+    const size_t length = partial->daily_changes->len;
+    if (merged->daily_changes->len < offset + length)
+        g_array_set_size(merged->daily_changes, offset + length);
+
+    int64_t *const       changes         = (int64_t *) merged->daily_changes->data + offset;
+    const int64_t *const partial_changes = (const int64_t *) partial->daily_changes->data;
+    for (size_t i = 0; i < length; ++i)
+        changes[i] += partial_changes[i];
 }
 
 /**
- * @brief Generates statistical data for queries of type 8.
+ * @brief Merges partial statistical data for queries of type 8.
  *
- * @param database   Database, to iterate through reservations.
- * @param n          Number of query instances.
- * @param instances  Instances of the query 8.
+ * @param scan_data    Value returned by ::__q08_generate_statistics.
+ * @param partial_data Another value returned by ::__q08_generate_statistics, filled in by
+ *                     ::__q08_generate_statistics_foreach_reservations. It'll be freed.
  *
- * @return A pointer to a ::q08_statistical_data_t on success, or `NULL` on allocation failure.
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
  */
-void *__q08_generate_statistics(const database_t             *database,
-                                size_t                        n,
-                                const query_instance_t *const instances[n]) {
-
-    q08_statistical_data_t *const stats = malloc(sizeof(q08_statistical_data_t));
-    if (!stats)
-        return NULL;
-    stats->n = n;
+int __q08_generate_statistics_merge(void *scan_data, void *partial_data) {
+    q08_merge_data_t data = {.hotels = scan_data, .failure = 0};
+    g_const_key_hash_table_foreach(partial_data, __q08_generate_statistics_merge_hotel, &data);
+    g_const_key_hash_table_unref(partial_data);
+    return data.failure;
+}
 
-    stats->filters = malloc(n * sizeof(q08_parsed_arguments_t));
-    if (!stats->filters) {
-        free(stats);
-        return NULL;
+/**
+ * @brief   Turns the daily revenue changes of a hotel into cumulative revenue.
+ * @details Auxiliary method for ::__q08_generate_statistics_end.
+ *
+ * @param hotel_id  Hotel identifier encoded as a pointer (not used).
+ * @param hotel     A pointer to a ::q08_hotel_revenue_t.
+ * @param user_data A pointer to an `int`, set to `1` on allocation failure.
+ */
+void __q08_generate_statistics_accumulate(gconstpointer hotel_id,
+                                          gpointer      hotel,
+                                          gpointer      user_data) {
+    (void) hotel_id;
+    q08_hotel_revenue_t *const revenue = hotel;
+
+    const size_t         ndays   = revenue->daily_changes->len;
+    const int64_t *const changes = (const int64_t *) revenue->daily_changes->data;
+
+    revenue->cumulative = malloc((ndays + 1) * sizeof(uint64_t));
+    if (!revenue->cumulative) {
+        *(int *) user_data = 1;
+        return;
     }
 
-    stats->revenues = malloc(n * sizeof(uint64_t));
-    if (!stats->revenues) {
-        free(stats->filters);
-        free(stats);
-        return NULL;
+    int64_t daily_revenue  = 0;
+    revenue->cumulative[0] = 0;
+    for (size_t i = 0; i < ndays; ++i) {
+        daily_revenue += changes[i];
+        revenue->cumulative[i + 1] = revenue->cumulative[i] + daily_revenue;
     }
 
-    for (size_t i = 0; i < n; ++i) {
-        const q08_parsed_arguments_t *const argument_data =
-            query_instance_get_argument_data(instances[i]);
+    revenue->ndays = ndays;
+    g_array_unref(revenue->daily_changes);
+    revenue->daily_changes = NULL;
+}
 
-        stats->filters[i]  = *argument_data;
-        stats->revenues[i] = 0;
-    }
+/**
+ * @brief   Finishes generating statistical data for queries of type 8.
+ * @details Calculates cumulative revenue for each hotel, after all reservations are iterated
+ *          through with ::__q08_generate_statistics_foreach_reservations.
+ *
+ * @param database  Database (not used).
+ * @param scan_data Value returned by ::__q08_generate_statistics.
+ *
+ * @return @p scan_data on success, `NULL` on allocation failure.
+ */
+void *__q08_generate_statistics_end(const database_t *database, void *scan_data) {
+    (void) database;
 
-    reservation_manager_iter(database_get_reservations(database),
-                             __q08_generate_statistics_foreach_reservation,
-                             stats);
-    return stats;
+    int failure = 0;
+    g_const_key_hash_table_foreach(scan_data, __q08_generate_statistics_accumulate, &failure);
+    if (failure) {
+        g_const_key_hash_table_unref(scan_data);
+        return NULL;
+    }
+    return scan_data;
 }
 
 /**
  * @brief Frees statistical data generated by ::__q08_generate_statistics.
- * @param statistical_data Non-`NULL` value returned by ::__q08_generate_statistics.
+ * @param statistical_data Non-`NULL` value returned by ::__q08_generate_statistics_end.
  */
 void __q08_free_statistics(void *statistical_data) {
-    q08_statistical_data_t *const stats = statistical_data;
-    free(stats->revenues);
-    free(stats->filters);
-    free(stats);
+    g_const_key_hash_table_unref(statistical_data);
+}
+
+/**
+ * @brief   Estimates the cost of answering queries of type 8 without statistical data.
+ * @details Each query iterates through all reservations of its hotel, whose number is known
+ *          beforehand, from the database's statistics.
+ *
+ * @param database  Database the queries will be answered from.
+ * @param n         Number of query instances in @p instances.
+ * @param instances Instances of the query 8.
+ *
+ * @return The total number of reservations in the hotels of all queries.
+ */
+size_t __q08_index_cost(const database_t             *database,
+                        size_t                        n,
+                        const query_instance_t *const instances[n]) {
+    const database_statistics_t *const statistics = database_get_statistics(database);
+
+    size_t cost = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const q08_parsed_arguments_t *const arguments =
+            query_instance_get_argument_data(instances[i]);
+        cost += database_statistics_get_hotel_frequency(statistics, arguments->hotel_id);
+    }
+    return cost;
 }
 
 /**
- * @brief Method called to execute a query of type 8.
+ * @brief   Calculates the revenue of a hotel during a range of dates, when no statistical data is
+ *          available.
+ * @details Auxiliary method for ::q08_execute. Reservations that begin after the range are skipped
+ *          with a binary search, as they're sorted from the latest beginning date, and the others
+ *          are filtered by ::date_overlap_weighted_sum, many at a time.
  *
- * @param database   Database to get data from (not used, as all data is collected in
- *                   ::__q08_generate_statistics).
- * @param statistics Statistical data generated by ::__q08_generate_statistics (a pointer to a
- *                   ::q08_statistical_data_t).
- * @param instance   Query instance to be executed.
- * @param output     Where to write the query's result to.
+ * @param reservations Reservations in the database.
+ * @param arguments    Arguments of the query being executed.
+ * @param revenue      Where to write the revenue of the hotel to.
  *
  * @retval 0 Success.
- * @retval 1 Fatal failure (should, in principle, be unreachable).
+ * @retval 1 Allocation failure.
  */
-int __q08_execute(const database_t       *database,
-                  const void             *statistics,
-                  const query_instance_t *instance,
-                  query_writer_t         *output) {
-    (void) database;
+int __q08_execute_from_index(const reservation_manager_t  *reservations,
+                             const q08_parsed_arguments_t *arguments,
+                             uint64_t                     *revenue) {
+    reservation_manager_hotel_columns_t columns;
+    size_t                              n;
+    if (reservation_manager_get_hotel_columns(reservations, arguments->hotel_id, &columns, &n))
+        return 1;
+
+    size_t skip = 0, count = n;
+    while (count) {
+        const size_t half = count / 2;
+        if (columns.begin_date[skip + half] > arguments->end_date) {
+            skip += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+
+    /* Reservations don't make money on their last day, which is excluded from their intervals */
+    *revenue = date_overlap_weighted_sum(n - skip,
+                                         columns.begin_date + skip,
+                                         columns.end_date + skip,
+                                         columns.price_per_night + skip,
+                                         arguments->begin_date,
+                                         arguments->end_date);
+    return 0;
+}
+
+int q08_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
 
-    const q08_statistical_data_t *const stats     = statistics;
     const q08_parsed_arguments_t *const arguments = query_instance_get_argument_data(instance);
 
-    for (size_t i = 0; i < stats->n; ++i) {
-        if (stats->filters[i].hotel_id == arguments->hotel_id &&
-            stats->filters[i].begin_date == arguments->begin_date &&
-            stats->filters[i].end_date == arguments->end_date) {
+    uint64_t revenue = 0;
+    if (statistics) {
+        const q08_hotel_revenue_t *const hotel =
+            g_const_key_hash_table_const_lookup(statistics, GUINT_TO_POINTER(arguments->hotel_id));
 
-            query_writer_write_new_object(output);
-            query_writer_write_new_field(output, "revenue", "%" PRIu64, stats->revenues[i]);
-            return 0;
+        if (hotel && hotel->ndays) {
+            int64_t begin = date_diff(arguments->begin_date, hotel->first_day);
+            int64_t end   = date_diff(arguments->end_date, hotel->first_day);
+            begin         = begin < 0 ? 0 : begin;
+            end           = end >= (int64_t) hotel->ndays ? (int64_t) hotel->ndays - 1 : end;
+
+            if (begin <= end)
+                revenue = hotel->cumulative[end + 1] - hotel->cumulative[begin];
         }
+    } else if (__q08_execute_from_index(database_get_reservations(database),
+                                        arguments,
+                                        &revenue)) {
+        return 1;
+    }
+
+    query_writer_write_new_object(output);
+    query_writer_write_new_field_unsigned(output, "revenue", revenue);
+    return 0;
+}
+
+/**
+ * @brief   Finds the range of dates the statistical data of some queries of type 8 depends on.
+ * @details Only reservations ongoing between the earliest beginning date and the latest end date
+ *          of all queries can contribute to their revenues.
+ *
+ * @param n         Number of query instances in @p instances.
+ * @param instances Instances of the query 8.
+ * @param begin     Where to write the earliest beginning date of a query to.
+ * @param end       Where to write the latest end date of a query to.
+ *
+ * @retval 0 Always successful.
+ */
+int __q08_date_range(size_t                        n,
+                     const query_instance_t *const instances[n],
+                     date_t                       *begin,
+                     date_t                       *end) {
+
+    *begin = UINT32_MAX;
+    *end   = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const q08_parsed_arguments_t *const arguments =
+            query_instance_get_argument_data(instances[i]);
+
+        *begin = min(*begin, arguments->begin_date);
+        *end   = max(*end, arguments->end_date);
     }
+    return 0;
+}
 
-    fprintf(stderr, "Bad statistical data in query 8! This should not happen!\n");
-    return 1;
+/**
+ * @brief   Estimates how much memory the statistical data for some queries of type 8 will take.
+ * @details Every hotel with reservations gets the revenue of every day in the range of dates of
+ *          the queries (see ::__q08_date_range), both in ::q08_hotel_revenue_t::daily_changes and
+ *          in ::q08_hotel_revenue_t::cumulative.
+ *
+ * @param database  Database the statistical data will be generated from.
+ * @param n         Number of query instances in @p instances.
+ * @param instances Instances of the query 8.
+ *
+ * @return The estimated size of the statistical data, in bytes.
+ */
+size_t __q08_estimate_size(const database_t             *database,
+                           size_t                        n,
+                           const query_instance_t *const instances[n]) {
+    const size_t nhotels = database_statistics_get_hotel_count(database_get_statistics(database));
+
+    date_t begin, end;
+    __q08_date_range(n, instances, &begin, &end);
+    const int64_t ndays = begin <= end ? date_diff(end, begin) + 1 : 0;
+
+    return nhotels * (sizeof(q08_hotel_revenue_t) +
+                      (size_t) ndays * (sizeof(int64_t) + sizeof(uint64_t)));
 }
 
 query_type_t *q08_create(void) {
+    const query_type_scan_t scan = {
+        .begin                = __q08_generate_statistics,
+        .foreach_reservations = __q08_generate_statistics_foreach_reservations,
+        .end                  = __q08_generate_statistics_end,
+        .partial_begin        = __q08_generate_statistics,
+        .merge                = __q08_generate_statistics_merge,
+        .index_cost           = __q08_index_cost,
+        .date_range           = __q08_date_range,
+        .estimate_size        = __q08_estimate_size};
+
     return query_type_create(8,
                              __q08_parse_arguments,
-                             __q08_clone_arguments,
-                             free,
-                             __q08_generate_statistics,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             &scan,
                              __q08_free_statistics,
-                             __q08_execute);
+                             1,
+                             NULL,
+                             q08_execute,
+                             NULL,
+                             NULL,
+                             DATABASE_INDEX_SET(DATABASE_INDEX_RESERVATION_HOTELS));
 }
@@ -19,241 +19,192 @@
  * @brief Implementation of methods in include/queries/q09.h
  */
 
-#include <locale.h>
-#include <stdio.h>
+#include <string.h>
 
 #include "queries/q09.h"
 #include "queries/query_instance.h"
-#include "utils/glib/GConstPtrArray.h"
 
 /**
  * @brief   Parses arguments of a query of type 9.
  * @details Asserts there's only one string argument.
  *
- * @param argc Number of arguments.
- * @param argv Values of the arguments.
+ * @param allocator Where to allocate the copy of the prefix. `NULL` for `strdup`.
+ * @param output    Where to write the copy of the prefix (a `char *`) to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
  *
- * @return `NULL` for invalid arguments, a copy of the only @p argv on success.
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments or allocation failure.
  */
-void *__q09_parse_arguments(size_t argc, char *const argv[argc]) {
+int __q09_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
     if (argc != 1)
-        return NULL;
-    else
-        return strdup(argv[0]);
-}
+        return 1;
 
-/**
- * @struct q09_statistical_data_t
- * @brief  Query 9's statistical data.
- *
- * @var q09_statistical_data_t::prefixes
- *     @brief Sorted array of prefixes to compare user names against.
- * @var q09_statistical_data_t::lengths
- *     @brief Length of each prefix in ::q09_statistical_data_t::prefixes.
- * @var q09_statistical_data_t::matches
- *     @brief Arrays of pointers to users that match with each prefix in
- *            q09_statistical_data_t::prefixes.
- * @var q09_statistical_data_t::n
- *     @brief Number of elements in every array of this struct.
- */
-typedef struct {
-    const char     **prefixes;
-    size_t          *lengths;
-    GConstPtrArray **matches;
-    size_t           n;
-} q09_statistical_data_t;
+    char **const prefix = output;
+    *prefix             = allocator ? string_pool_put(allocator, argv[0]) : strdup(argv[0]);
+    return *prefix == NULL;
+}
 
 /**
- * @brief   Callback called for every user, to match user ID prefixes.
- * @details Auxiliary method for ::__q09_generate_statistics.
+ * @brief Creates a deep clone of arguments written by ::__q09_parse_arguments.
  *
- * @param user_data A pointer to a ::q09_statistical_data_t.
- * @param user      User to be inspected.
+ * @param allocator Where to allocate the copy of the prefix. `NULL` for `strdup`.
+ * @param output    Shallow copy of @p args_data, to be turned into a deep copy.
+ * @param args_data Arguments written by ::__q09_parse_arguments (a `char *`).
  *
- * @retval 0 Always successful.
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
  */
-int __q09_generate_statistics_iter_callback(void *user_data, const user_t *user) {
-    q09_statistical_data_t *const stats = user_data;
-
-    /* Local copies for slight performance increase */
-    const size_t             n        = stats->n;
-    const char *const *const prefixes = stats->prefixes;
-    const size_t *const      lengths  = stats->lengths;
-
-    for (size_t i = 0; i < n; ++i) {
-        const int cmp = strncmp(prefixes[i], user_get_const_name(user), lengths[i]);
+int __q09_clone_arguments(string_pool_t *allocator, void *output, const void *args_data) {
+    const char *const *const prefix = args_data;
+    char **const             clone  = output;
 
-        if (cmp == 0 && user_get_account_status(user) == ACCOUNT_STATUS_ACTIVE)
-            g_const_ptr_array_add(stats->matches[i], user);
-        else if (cmp > 0)
-            break;
-    }
-    return 0;
+    *clone = allocator ? string_pool_put(allocator, *prefix) : strdup(*prefix);
+    return *clone == NULL;
 }
 
 /**
- * @brief   User comparison function for user ordering for final output.
- * @details Auxiliary method for ::__q09_generate_statistics.
+ * @brief Frees the prefix in arguments written by ::__q09_parse_arguments.
+ * @param args_data Arguments written by ::__q09_parse_arguments.
  */
-gint __q09_sort_compare_callback(const void *const *a, const void *const *b) {
-    const user_t *const user_a = *(const user_t *const *) a;
-    const user_t *const user_b = *(const user_t *const *) b;
-
-    const int crit1 = strcoll(user_get_const_name(user_a), user_get_const_name(user_b));
-    if (crit1)
-        return crit1;
-
-    const int crit2 = strcoll(user_get_const_id(user_a), user_get_const_id(user_b));
-    return crit2;
+void __q09_free_arguments(void *args_data) {
+    free(*(char **) args_data);
 }
 
 /**
- * @brief   Comparison function for sorting arrays of strings.
- * @details Auxiliary method for ::__q09_generate_statistics.
+ * @brief Writes the prefix in arguments written by ::__q09_parse_arguments.
+ *
+ * @param args_data Arguments written by ::__q09_parse_arguments.
+ * @param file      File where to write the prefix to (including its null terminator).
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
  */
-int __q09_sort_prefixes_callback(const void *a, const void *b) {
-    return strcmp(*(const char *const *) a, *(const char *const *) b);
+int __q09_save_arguments(const void *args_data, FILE *file) {
+    const char *const prefix = *(const char *const *) args_data;
+    const size_t      size   = strlen(prefix) + 1;
+    return fwrite(prefix, 1, size, file) != size;
 }
 
 /**
- * @brief Generates statistical data for queries of type 9.
+ * @brief Reads the prefix written by ::__q09_save_arguments.
  *
- * @param database  Database, to iterate through users.
- * @param n         Number of query instances to be executed.
- * @param instances Query instances to be executed.
+ * @param allocator Where to allocate the copy of the prefix. `NULL` for `strdup`.
+ * @param output    Where to write the copy of the prefix (a `char *`) to.
+ * @param contents  Data written by ::__q09_save_arguments.
+ * @param size      Number of bytes in @p contents.
  *
- * @return A pointer to a ::q09_statistical_data_t, or `NULL` on allocation failure.
+ * @retval 0 Success.
+ * @retval 1 Corrupt @p contents or allocation failure.
  */
-void *__q09_generate_statistics(const database_t             *database,
-                                size_t                        n,
-                                const query_instance_t *const instances[n]) {
-
-    /* Set locale for sorting and restore older locale later */
-    char *const old_locale = strdup(setlocale(LC_COLLATE, NULL));
-    setlocale(LC_COLLATE, "en_US.UTF-8");
-
-    /* Allocate and initialize statistics */
-    q09_statistical_data_t *const stats = malloc(sizeof(q09_statistical_data_t));
-    if (!stats)
-        return NULL;
-
-    stats->prefixes = malloc(sizeof(const char *) * n);
-    stats->lengths  = malloc(sizeof(size_t) * n);
-    stats->matches  = malloc(sizeof(GConstPtrArray **) * n);
-    stats->n        = n;
-
-    if (!stats->prefixes || !stats->lengths || !stats->matches) {
-        if (stats->prefixes)
-            free(stats->prefixes);
-        if (stats->lengths)
-            free(stats->lengths);
-        if (stats->matches)
-            free(stats->matches);
-
-        free(stats);
-        return NULL;
-    }
-
-    size_t count = 0;
-    for (size_t i = 0; i < n; ++i) {
-        const char *const prefix = query_instance_get_argument_data(instances[i]);
-
-        int found = 0;
-        for (size_t j = 0; j < count; ++j) {
-            if (strcmp(prefix, stats->prefixes[j]) == 0) {
-                found = 1;
-                break;
-            }
-        }
+int __q09_load_arguments(string_pool_t *allocator,
+                         void          *output,
+                         const char    *contents,
+                         size_t         size) {
+    if (!size || memchr(contents, '\0', size) != contents + size - 1)
+        return 1;
+
+    char **const prefix = output;
+    *prefix             = allocator ? string_pool_put(allocator, contents) : strdup(contents);
+    return *prefix == NULL;
+}
 
-        if (!found) {
-            stats->prefixes[count] = prefix;
-            count++;
-        }
-    }
-    stats->n = count;
-    qsort(stats->prefixes, count, sizeof(const char *), __q09_sort_prefixes_callback);
+/**
+ * @brief Value returned by ::__q09_execute_iter_callback to stop iterating, when no more users
+ *        will be outputted.
+ */
+#define Q09_EXECUTE_ITER_PAGE_FULL 2
 
-    for (size_t i = 0; i < stats->n; ++i) {
-        stats->lengths[i] = strlen(stats->prefixes[i]);
-        stats->matches[i] = g_const_ptr_array_new();
+/**
+ * @brief   Callback called for every user whose name starts with the query's prefix.
+ * @details Auxiliary method for ::q09_execute. Inactive users aren't outputted, so users can't be
+ *          skipped before being looked at, but iteration stops once the query's page is full.
+ *
+ * @param user_data A pointer to the ::query_writer_t where to output matching users.
+ * @param user      User whose name matches the query's prefix.
+ *
+ * @retval 0                          Success.
+ * @retval Q09_EXECUTE_ITER_PAGE_FULL No more users are to be outputted.
+ */
+int __q09_execute_iter_callback(void *user_data, const user_t *user) {
+    query_writer_t *const output = user_data;
+    if (query_writer_is_page_full(output))
+        return Q09_EXECUTE_ITER_PAGE_FULL;
+
+    if (user_get_account_status(user) == ACCOUNT_STATUS_ACTIVE) {
+        query_writer_write_new_object(output);
+        query_writer_write_new_field_string(output, "id", user_get_const_id(user));
+        query_writer_write_new_field_string(output, "name", user_get_const_name(user));
     }
+    return 0;
+}
 
-    /* Fill matches in statistical data */
-    user_manager_iter(database_get_users(database), __q09_generate_statistics_iter_callback, stats);
-
-    for (size_t i = 0; i < stats->n; ++i)
-        g_const_ptr_array_sort(stats->matches[i], __q09_sort_compare_callback);
-
-    if (old_locale) {
-        setlocale(LC_COLLATE, old_locale);
-        free(old_locale);
-    }
-    return stats;
+int q09_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
+    (void) statistics;
+
+    const char *const prefix = *(const char *const *) query_instance_get_argument_data(instance);
+    const int         retval = user_manager_iter_name_prefix(database_get_users(database),
+                                                     prefix,
+                                                     __q09_execute_iter_callback,
+                                                     output);
+    return retval == Q09_EXECUTE_ITER_PAGE_FULL ? 0 : retval;
 }
 
 /**
- * @brief Frees statistical data generated by ::__q09_generate_statistics.
- * @param statistical_data Non-`NULL` value returned by ::__q09_generate_statistics.
+ * @brief Factor by which the first character of a prefix is expected to reduce the number of users
+ *        whose names start with it (see ::__q09_estimate_results).
  */
-void __q09_free_statistics(void *statistical_data) {
-    q09_statistical_data_t *const stats = statistical_data;
-    free(stats->prefixes);
-    free(stats->lengths);
-
-    for (size_t i = 0; i < stats->n; ++i)
-        g_const_ptr_array_unref(stats->matches[i]);
-    free(stats->matches);
+#define Q09_FIRST_CHARACTER_SELECTIVITY 16
 
-    free(stats);
-}
+/**
+ * @brief Factor by which every character after the first one of a prefix is expected to reduce the
+ *        number of users whose names start with it (see ::__q09_estimate_results).
+ */
+#define Q09_CHARACTER_SELECTIVITY 8
 
 /**
- * @brief Executes a query of type 9.
+ * @brief   Estimates the number of users in the output of a query of type 9.
+ * @details The names of users aren't counted by prefix, so every character in the prefix is
+ *          assumed to select a fixed fraction of the users selected by the previous ones.
  *
- * @param database   Database to get data from (not used, as all data is collected in
- *                   ::__q09_generate_statistics).
- * @param statistics A pointer to a ::q09_statistical_data_t.
- * @param instance   Query instance to be executed.
- * @param output     Where to write the query's output to.
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance whose results are to be estimated.
  *
- * @retval 0 Success.
- * @retval 1 Fatal failure (should, in principle, be unreachable).
+ * @return The estimated number of users whose names start with the prefix in @p instance.
  */
-int __q09_execute(const database_t       *database,
-                  const void             *statistics,
-                  const query_instance_t *instance,
-                  query_writer_t         *output) {
-    (void) database;
-
-    const char *const                   prefix = query_instance_get_argument_data(instance);
-    const q09_statistical_data_t *const stats  = statistics;
-
-    for (size_t i = 0; i < stats->n; ++i) {
-        if (strcmp(stats->prefixes[i], prefix) == 0) {
-
-            const GConstPtrArray *const matches     = stats->matches[i];
-            const size_t                matches_len = g_const_ptr_array_get_length(matches);
-            for (size_t j = 0; j < matches_len; ++j) {
-                const user_t *const user = g_const_ptr_array_index(matches, j);
-                query_writer_write_new_object(output);
-                query_writer_write_new_field(output, "id", "%s", user_get_const_id(user));
-                query_writer_write_new_field(output, "name", "%s", user_get_const_name(user));
-            }
-            return 0;
-        }
-    }
-
-    fprintf(stderr, "Bad statistical data in query 9! This should not happen!\n");
-    return 1;
+size_t __q09_estimate_results(const database_t       *database,
+                              const void             *statistics,
+                              const query_instance_t *instance) {
+    (void) statistics;
+    const char *const prefix = *(const char *const *) query_instance_get_argument_data(instance);
+
+    size_t estimate = database_statistics_get_user_count(database_get_statistics(database));
+    for (size_t i = 0; prefix[i] && estimate; ++i)
+        estimate /= i ? Q09_CHARACTER_SELECTIVITY : Q09_FIRST_CHARACTER_SELECTIVITY;
+    return estimate;
 }
 
 query_type_t *q09_create(void) {
     return query_type_create(9,
                              __q09_parse_arguments,
-                             (query_type_clone_arguments_callback_t) strdup,
-                             free,
-                             __q09_generate_statistics,
-                             __q09_free_statistics,
-                             __q09_execute);
+                             __q09_clone_arguments,
+                             __q09_free_arguments,
+                             __q09_save_arguments,
+                             __q09_load_arguments,
+                             NULL,
+                             NULL,
+                             NULL,
+                             0,
+                             NULL,
+                             q09_execute,
+                             NULL,
+                             __q09_estimate_results,
+                             DATABASE_INDEX_SET(DATABASE_INDEX_USER_NAMES));
 }
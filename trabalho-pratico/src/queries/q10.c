@@ -19,15 +19,15 @@
  * @brief Implementation of methods in include/queries/q10.h
  */
 
-/* TODO - remove headers */
-
 #include <inttypes.h>
-#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "queries/q10.h"
 #include "queries/query_instance.h"
+#include "utils/cache_line.h"
 #include "utils/int_utils.h"
+#include "utils/prefetch.h"
 
 /**
  * @struct q10_parsed_arguments_t
@@ -47,66 +47,47 @@ typedef struct {
  * @brief   Parses the arguments for a query of type 10.
  * @details There can be zero to two arguments, a year and a month.
  *
- * @param argc Number of query arguments.
- * @param argv List of query arguments.
+ * @param allocator Not used (no strings are stored).
+ * @param output    Where to write the ::q10_parsed_arguments_t to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
  *
- * @return A pointer to a ::q10_parsed_arguments_t, or `NULL` on parsing or allocation failure.
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments.
  */
-void *__q10_parse_arguments(size_t argc, char *const argv[argc]) {
-    q10_parsed_arguments_t *const ret = malloc(sizeof(q10_parsed_arguments_t));
-    if (!ret)
-        return NULL;
+int __q10_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    (void) allocator;
+    q10_parsed_arguments_t *const ret = output;
 
     if (argc == 0) {
         ret->year  = -1;
         ret->month = -1;
     } else if (argc == 1) {
         uint64_t parsed;
-        if (int_utils_parse_positive(&parsed, argv[0])) {
-            free(ret);
-            return NULL;
-        }
+        if (int_utils_parse_positive(&parsed, argv[0]))
+            return 1;
 
         ret->year  = parsed;
         ret->month = -1;
     } else if (argc == 2) {
         uint64_t parsed_year, parsed_month;
         if (int_utils_parse_positive(&parsed_year, argv[0]) ||
-            int_utils_parse_positive(&parsed_month, argv[1])) {
+            int_utils_parse_positive(&parsed_month, argv[1]))
+            return 1;
 
-            free(ret);
-            return NULL;
-        }
-
-        if (0 == parsed_month || parsed_month > 12) {
-            free(ret);
-            return NULL;
-        }
+        if (0 == parsed_month || parsed_month > 12)
+            return 1;
 
         ret->year  = parsed_year;
         ret->month = parsed_month;
     } else {
-        free(ret);
-        return NULL;
+        return 1;
     }
 
-    return ret;
-}
-
-/**
- * @brief  Creates a deep clone of the value returned by ::__q10_parse_arguments.
- * @param  args_data Non-`NULL` value returned by ::__q10_parse_arguments (a pointer to a
- *                   ::q10_parsed_arguments_t).
- * @return A deep copy of @p args_data.
- */
-void *__q10_clone_arguments(const void *args_data) {
-    const q10_parsed_arguments_t *const args  = args_data;
-    q10_parsed_arguments_t *const       clone = malloc(sizeof(q10_parsed_arguments_t));
-    if (!clone)
-        return NULL;
-
-    memcpy(clone, args, sizeof(q10_parsed_arguments_t));
-    return clone;
+    return 0;
 }
 
 /**
@@ -128,209 +109,213 @@ typedef struct {
     uint32_t users, flights, passengers, unique_passengers, reservations;
 } q10_instant_statistics_t;
 
+/** @brief Start of the range of event years supported by this query. */
+#define Q10_SUPPORTED_YEAR_RANGE_START 2000
+/** @brief End of the range of event years supported by this query. */
+#define Q10_SUPPORTED_YEAR_RANGE_END   2064
+/** @brief The number event of years supported by this query. */
+#define Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE                                                         \
+    (Q10_SUPPORTED_YEAR_RANGE_END - Q10_SUPPORTED_YEAR_RANGE_START)
+
 /**
- * @brief   A type of match between an event and query arguments.
- * @details Return type of ::__q10_instant_matches.
+ * @struct  q10_statistical_data_t
+ * @brief   Answers to all queries of type 10.
+ * @details Events are counted for every year, month and day in the supported range of years, so
+ *          that any query of type 10 is only a read of one of these arrays. Months and days are
+ *          indexed starting at `1`.
+ *
+ * @var q10_statistical_data_t::years
+ *     @brief Statistics for each year.
+ * @var q10_statistical_data_t::months
+ *     @brief Statistics for each month of each year.
+ * @var q10_statistical_data_t::days
+ *     @brief Statistics for each day of each month of each year.
  */
-typedef enum {
-    Q10_INSTANT_MATCHES_NO_MATCH,    /**< Event isn't fit for the arguments. */
-    Q10_INSTANT_MATCHES_ALL_YEARS,   /**< Event matches and must be added to an array of years. */
-    Q10_INSTANT_MATCHES_YEAR_MONTHS, /**< Event matches and must be added to an array of months. */
-    Q10_INSTANT_MATCHES_MONTH_DAYS,  /**< Event matches and must be added to an array of days. */
-} q10_instant_matches_ret_t;
+typedef struct {
+    q10_instant_statistics_t years[Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE];
+    q10_instant_statistics_t months[Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE][13];
+    q10_instant_statistics_t days[Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE][13][32];
+} q10_statistical_data_t;
 
 /**
- * @brief Determines if an event matches the arguments of a query, and should be counted towards its
- *        results.
+ * @brief Gets the statistics of the year, month and day of a date.
  *
- * @param year   Year of the event.
- * @param month  Month of the event.
- * @param filter Arguments to match event against.
+ * @param stats    Statistical data to get statistics from.
+ * @param date     Date of an event.
+ * @param instants Where to write pointers to the statistics of the year, month and day (in this
+ *                 order) of @p date.
  *
- * @return The type of match (see ::q10_instant_matches_ret_t).
+ * @retval 0 Success.
+ * @retval 1 @p date is outside the range of supported years.
  */
-__attribute__((always_inline)) inline q10_instant_matches_ret_t
-    __q10_instant_matches(int16_t year, int8_t month, const q10_parsed_arguments_t *filter) {
-    if (year == filter->year) {
-        const q10_instant_matches_ret_t alternative =
-            (filter->month == -1) ? Q10_INSTANT_MATCHES_YEAR_MONTHS : Q10_INSTANT_MATCHES_NO_MATCH;
-        return (month == filter->month) ? Q10_INSTANT_MATCHES_MONTH_DAYS : alternative;
-    }
-
-    return (filter->year == -1) ? Q10_INSTANT_MATCHES_ALL_YEARS : Q10_INSTANT_MATCHES_NO_MATCH;
+int __q10_get_instants(q10_statistical_data_t   *stats,
+                       date_t                    date,
+                       q10_instant_statistics_t *instants[3]) {
+
+    const uint16_t year = date_get_year(date);
+    if (year < Q10_SUPPORTED_YEAR_RANGE_START || year >= Q10_SUPPORTED_YEAR_RANGE_END)
+        return 1;
+
+    const size_t  year_index = year - Q10_SUPPORTED_YEAR_RANGE_START;
+    const uint8_t month      = date_get_month(date);
+    instants[0]              = &stats->years[year_index];
+    instants[1]              = &stats->months[year_index][month];
+    instants[2]              = &stats->days[year_index][month][date_get_day(date)];
+    return 0;
 }
 
+#if Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE > 64
+    #error "Years must fit in the bits of a uint64_t (see q10_foreach_user_data_t)"
+#endif
+
 /**
- * @struct q10_foreach_user_data_t
- * @brief  Data used while iterating through users (this includes passengers relations).
- *
- * @var q10_foreach_user_data_t::stats_data
- *     @brief   Statistics (array of arrays) for the moments related to query arguments.
- *     @details The length of each array depends on the arguments in each element of
- *              ::q10_foreach_user_data_t::filters.
- * @var q10_foreach_user_data_t::filters
- *     @brief Array of query arguments to match events against.
- * @var q10_foreach_user_data_t::flags
- *     @brief Array of auxiliary bit arrays (integers), used to calculate
- *            ::q10_instant_statistics_t::unique_passengers
- * @var q10_foreach_user_data_t::stats_length
- *     @brief Length of ::q10_foreach_user_data_t::stats_data, ::q10_foreach_user_data_t::filters
- *            and q10_foreach_user_data_t::flags.
+ * @struct  q10_foreach_user_data_t
+ * @brief   Data used while iterating through users (this includes passengers relations).
+ * @details To count unique passengers, the years, months and days each user flew in are marked in
+ *          bitsets, which are transposed: bit `y` of a bitset refers to year `y` (relative to
+ *          ::Q10_SUPPORTED_YEAR_RANGE_START), and there's a bitset for every month and day. After
+ *          all flights of a user are marked, every set bit is a unique passenger in that instant.
+ *          Bitsets are cleared while they're counted, so they're empty before every user.
+ *
+ * @var q10_foreach_user_data_t::stats
+ *     @brief Statistical data being generated.
  * @var q10_foreach_user_data_t::flights
  *     @brief Flight manager for performant access to flights.
+ * @var q10_foreach_user_data_t::years
+ *     @brief Years the current user flew in.
+ * @var q10_foreach_user_data_t::months
+ *     @brief Years in which the current user flew in each month.
+ * @var q10_foreach_user_data_t::days
+ *     @brief Years in which the current user flew in each day of each month.
+ * @var q10_foreach_user_data_t::marked_days
+ *     @brief Bit `d` of each month is set when ::q10_foreach_user_data_t::days for that month
+ *            and day `d` isn't empty, so that empty days aren't visited.
  */
 typedef struct {
-    q10_instant_statistics_t *const *const stats_data;
-    const q10_parsed_arguments_t *const    filters;
-    uint64_t *const                        flags;
-    const size_t                           stats_length;
+    q10_statistical_data_t *stats;
+    const flight_manager_t *flights;
 
-    const flight_manager_t *const flights;
+    uint64_t years;
+    uint64_t months[13];
+    uint64_t days[13][32];
+    uint32_t marked_days[13];
 } q10_foreach_user_data_t;
 
-/** @brief Start of the range of event years supported by this query. */
-#define Q10_SUPPORTED_YEAR_RANGE_START 2000
-/** @brief End of the range of event years supported by this query. */
-#define Q10_SUPPORTED_YEAR_RANGE_END   2064
-/** @brief The number event of years supported by this query. */
-#define Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE                                                         \
-    (Q10_SUPPORTED_YEAR_RANGE_END - Q10_SUPPORTED_YEAR_RANGE_START)
+/**
+ * @brief Counts a unique passenger in every year of a bitset.
+ *
+ * @param instants Statistics of the first supported year (for a given month and day, if any).
+ * @param stride   Distance between the statistics of consecutive years, in @p instants.
+ * @param years    Bitset of the years to count a passenger in. See ::q10_foreach_user_data_t.
+ */
+void __q10_count_unique_passengers(q10_instant_statistics_t *instants,
+                                   size_t                    stride,
+                                   uint64_t                  years) {
+    for (; years; years &= years - 1)
+        instants[(size_t) __builtin_ctzll(years) * stride].unique_passengers++;
+}
 
 /**
  * @brief   Method called for every user in the database.
- * @details Calculates the number of users, passengers, and unique passengers for every query.
+ * @details Calculates the number of users, passengers, and unique passengers.
  *
- * @param user_data  A pointer to a ::q10_foreach_user_data_t.
- * @param user       User being processed.
- * @param passengers Identifiers of the flights @p user has been in.
+ * @param user_data   A pointer to a ::q10_foreach_user_data_t.
+ * @param user        User being processed.
+ * @param passengers  Identifiers of the flights @p user has been in.
+ * @param npassengers Number of elements in @p passengers.
  *
  * @retval 0 Always, not to stop iteration.
  */
-int __q10_generate_statistics_foreach_user(void                               *user_data,
-                                           const user_t                       *user,
-                                           const single_pool_id_linked_list_t *passengers) {
+int __q10_generate_statistics_foreach_user(void              *user_data,
+                                           const user_t      *user,
+                                           const flight_id_t *passengers,
+                                           size_t             npassengers) {
     q10_foreach_user_data_t *const iter_data = user_data;
+    q10_statistical_data_t *const  stats     = iter_data->stats;
+
+    q10_instant_statistics_t *instants[3];
+    if (!__q10_get_instants(stats,
+                            date_and_time_get_date(user_get_account_creation_date(user)),
+                            instants)) {
+        for (int i = 0; i < 3; ++i)
+            instants[i]->users++;
+    }
 
-    date_t  date  = date_and_time_get_date(user_get_account_creation_date(user));
-    int16_t year  = date_get_year(date);
-    uint8_t month = date_get_month(date);
-    uint8_t day   = date_get_day(date);
-
-    for (size_t i = 0; i < iter_data->stats_length; ++i) {
-        switch (__q10_instant_matches(year, month, iter_data->filters + i)) {
-            case Q10_INSTANT_MATCHES_NO_MATCH:
-                break;
-            case Q10_INSTANT_MATCHES_ALL_YEARS:
-                iter_data->stats_data[i][year - Q10_SUPPORTED_YEAR_RANGE_START].users++;
-                break;
-            case Q10_INSTANT_MATCHES_YEAR_MONTHS:
-                iter_data->stats_data[i][month].users++;
-                break;
-            case Q10_INSTANT_MATCHES_MONTH_DAYS:
-                iter_data->stats_data[i][day].users++;
-                break;
+    const flight_t *flights[PREFETCH_BATCH_SIZE];
+    for (size_t p = 0; p < npassengers; ++p) {
+        const size_t batch_index = p % PREFETCH_BATCH_SIZE;
+        if (batch_index == 0) {
+            const size_t left = npassengers - p;
+            flight_manager_get_by_ids(iter_data->flights,
+                                      left < PREFETCH_BATCH_SIZE ? left : PREFETCH_BATCH_SIZE,
+                                      passengers + p,
+                                      flights);
         }
+        const flight_t *const flight = flights[batch_index];
+
+        const date_t date = date_and_time_get_date(flight_get_schedule_departure_date(flight));
+        if (__q10_get_instants(stats, date, instants))
+            continue;
 
-        /* Reset flags for unique passengers calculation. */
-        iter_data->flags[i] = 0;
+        for (int i = 0; i < 3; ++i)
+            instants[i]->passengers++;
+
+        const size_t   year_index = date_get_year(date) - Q10_SUPPORTED_YEAR_RANGE_START;
+        const uint64_t year       = (uint64_t) 1 << year_index;
+        const uint8_t  month      = date_get_month(date);
+        const uint8_t  day        = date_get_day(date);
+        iter_data->years |= year;
+        iter_data->months[month] |= year;
+        iter_data->days[month][day] |= year;
+        iter_data->marked_days[month] |= (uint32_t) 1 << day;
     }
 
-    while (passengers) {
-        const flight_t *const flight =
-            flight_manager_get_by_id(iter_data->flights,
-                                     single_pool_id_linked_list_get_value(passengers));
-        passengers = single_pool_id_linked_list_get_next(passengers);
-        __builtin_prefetch(passengers); /* <- This does miracles for performance */
-
-        date  = date_and_time_get_date(flight_get_schedule_departure_date(flight));
-        year  = date_get_year(date);
-        month = date_get_month(date);
-        day   = date_get_day(date);
-
-        for (size_t i = 0; i < iter_data->stats_length; ++i) {
-            q10_instant_statistics_t *target;
-            int                       shift, can_add_unique;
-            switch (__q10_instant_matches(year, month, iter_data->filters + i)) {
-                case Q10_INSTANT_MATCHES_NO_MATCH:
-                    continue;
-                case Q10_INSTANT_MATCHES_ALL_YEARS:
-                    target = &iter_data->stats_data[i][year - Q10_SUPPORTED_YEAR_RANGE_START];
-
-                    shift          = 1 << (year - Q10_SUPPORTED_YEAR_RANGE_START);
-                    can_add_unique = !(iter_data->flags[i] & shift);
-                    iter_data->flags[i] |= shift;
-                    break;
-                case Q10_INSTANT_MATCHES_YEAR_MONTHS:
-                    target = &iter_data->stats_data[i][month];
-
-                    shift          = 1 << month;
-                    can_add_unique = !(iter_data->flags[i] & shift);
-                    iter_data->flags[i] |= shift;
-                    break;
-                case Q10_INSTANT_MATCHES_MONTH_DAYS:
-                    target = &iter_data->stats_data[i][day];
-
-                    shift          = 1 << day;
-                    can_add_unique = !(iter_data->flags[i] & shift);
-                    iter_data->flags[i] |= shift;
-                    break;
-            }
-
-            target->passengers++;
-            target->unique_passengers += can_add_unique;
+    if (!iter_data->years)
+        return 0;
+
+    __q10_count_unique_passengers(stats->years, 1, iter_data->years);
+    iter_data->years = 0;
+
+    for (size_t month = 1; month < 13; ++month) {
+        if (!iter_data->months[month])
+            continue;
+
+        __q10_count_unique_passengers(&stats->months[0][month], 13, iter_data->months[month]);
+        iter_data->months[month] = 0;
+
+        uint32_t marked_days = iter_data->marked_days[month];
+        for (; marked_days; marked_days &= marked_days - 1) {
+            const size_t day = (size_t) __builtin_ctz(marked_days);
+            __q10_count_unique_passengers(&stats->days[0][month][day],
+                                          13 * 32,
+                                          iter_data->days[month][day]);
+            iter_data->days[month][day] = 0;
         }
+        iter_data->marked_days[month] = 0;
     }
+
     return 0;
 }
 
 /**
- * @struct q10_statistical_data_t
- * @brief  Answers to all queries of type 10.
- *
- * @var q10_statistical_data_t::stats_data
- *     @brief   Statistics (array of arrays) for the moments related to query arguments.
- *     @details The length of each array depends on the arguments in each element of
- *              ::q10_statistical_data_t::filters.
- * @var q10_statistical_data_t::filters
- *     @brief Array of query arguments to match events against.
- * @var q10_statistical_data_t::stats_length
- *     @brief Length of ::q10_statistical_data_t::stats_data and ::q10_statistical_data_t::filters.
- */
-typedef struct {
-    q10_instant_statistics_t **stats_data;
-    q10_parsed_arguments_t    *filters;
-    size_t                     stats_length;
-} q10_statistical_data_t;
-
-/**
- * @brief Method called for every flight in the database.
+ * @brief Method called for every block of flights in the database.
  *
- * @param user_data  A pointer to a ::q10_statistical_data_t.
- * @param flight     Flight being processed.
+ * @param user_data A pointer to a ::q10_statistical_data_t.
+ * @param columns   Flights being processed.
+ * @param n         Number of flights in @p columns.
  *
  * @retval 0 Always, not to stop iteration.
  */
-int __q10_generate_statistics_foreach_flight(void *user_data, const flight_t *flight) {
-    q10_statistical_data_t *const stats = user_data;
-
-    const date_t   date  = date_and_time_get_date(flight_get_schedule_departure_date(flight));
-    const uint16_t year  = date_get_year(date);
-    const uint8_t  month = date_get_month(date);
-    const uint8_t  day   = date_get_day(date);
-
-    for (size_t i = 0; i < stats->stats_length; ++i) {
-        switch (__q10_instant_matches(year, month, stats->filters + i)) {
-            case Q10_INSTANT_MATCHES_NO_MATCH:
-                break;
-            case Q10_INSTANT_MATCHES_ALL_YEARS:
-                stats->stats_data[i][year - Q10_SUPPORTED_YEAR_RANGE_START].flights++;
-                break;
-            case Q10_INSTANT_MATCHES_YEAR_MONTHS:
-                stats->stats_data[i][month].flights++;
-                break;
-            case Q10_INSTANT_MATCHES_MONTH_DAYS:
-                stats->stats_data[i][day].flights++;
-                break;
+int __q10_generate_statistics_foreach_flights(void                           *user_data,
+                                              const flight_manager_columns_t *columns,
+                                              size_t                          n) {
+    for (size_t f = 0; f < n; ++f) {
+        q10_instant_statistics_t *instants[3];
+        if (!__q10_get_instants(user_data,
+                                date_and_time_get_date(columns->schedule_departure_date[f]),
+                                instants)) {
+            for (int i = 0; i < 3; ++i)
+                instants[i]->flights++;
         }
     }
 
@@ -338,35 +323,22 @@ int __q10_generate_statistics_foreach_flight(void *user_data, const flight_t *fl
 }
 
 /**
- * @brief Method called for every reservation in the database.
+ * @brief Method called for every block of reservations in the database.
  *
- * @param user_data   A pointer to a ::q10_statistical_data_t.
- * @param reservation Reservation being processed.
+ * @param user_data A pointer to a ::q10_statistical_data_t.
+ * @param columns   Reservations being processed.
+ * @param n         Number of reservations in @p columns.
  *
  * @retval 0 Always, not to stop iteration.
  */
-int __q10_generate_statistics_foreach_reservation(void                *user_data,
-                                                  const reservation_t *reservation) {
-    q10_statistical_data_t *const stats = user_data;
-
-    const date_t   date  = reservation_get_begin_date(reservation);
-    const uint16_t year  = date_get_year(date);
-    const uint8_t  month = date_get_month(date);
-    const uint8_t  day   = date_get_day(date);
-
-    for (size_t i = 0; i < stats->stats_length; ++i) {
-        switch (__q10_instant_matches(year, month, stats->filters + i)) {
-            case Q10_INSTANT_MATCHES_NO_MATCH:
-                break;
-            case Q10_INSTANT_MATCHES_ALL_YEARS:
-                stats->stats_data[i][year - Q10_SUPPORTED_YEAR_RANGE_START].reservations++;
-                break;
-            case Q10_INSTANT_MATCHES_YEAR_MONTHS:
-                stats->stats_data[i][month].reservations++;
-                break;
-            case Q10_INSTANT_MATCHES_MONTH_DAYS:
-                stats->stats_data[i][day].reservations++;
-                break;
+int __q10_generate_statistics_foreach_reservations(void                                *user_data,
+                                                   const reservation_manager_columns_t *columns,
+                                                   size_t                               n) {
+    for (size_t r = 0; r < n; ++r) {
+        q10_instant_statistics_t *instants[3];
+        if (!__q10_get_instants(user_data, columns->begin_date[r], instants)) {
+            for (int i = 0; i < 3; ++i)
+                instants[i]->reservations++;
         }
     }
 
@@ -374,88 +346,114 @@ int __q10_generate_statistics_foreach_reservation(void                *user_data
 }
 
 /**
- * @brief Generates statistical data for queries of type 10.
+ * @brief   Generates statistical data for queries of type 10.
+ * @details Users (and passengers) are considered here, while flights and reservations are only
+ *          counted later, when iterated through with ::__q10_generate_statistics_foreach_flights
+ *          and ::__q10_generate_statistics_foreach_reservations. Data is generated for every year,
+ *          month and day, independently of @p instances, so that it can be reused by other
+ *          queries.
  *
  * @param database   Database to iterate through.
- * @param n          Number of query instances.
- * @param instances  Instances of the query 10.
+ * @param n          Number of query instances (not used).
+ * @param instances  Instances of the query 10 (not used).
  *
  * @return A pointer to a ::q10_statistical_data_t on success, or `NULL` on allocation failure.
  */
 void *__q10_generate_statistics(const database_t             *database,
                                 size_t                        n,
                                 const query_instance_t *const instances[n]) {
+    (void) n;
+    (void) instances;
 
-    q10_instant_statistics_t **const stats_data = calloc(n, sizeof(q10_instant_statistics_t *));
-    if (!stats_data)
-        goto DEFER_1;
-
-    q10_parsed_arguments_t *const filters = malloc(n * sizeof(q10_parsed_arguments_t));
-    if (!filters)
-        goto DEFER_2;
-
-    uint64_t *const flags = malloc(n * sizeof(uint64_t));
-    if (!flags)
-        goto DEFER_3;
+    q10_statistical_data_t *const stats = calloc(1, sizeof(q10_statistical_data_t));
+    if (!stats)
+        return NULL;
 
-    for (size_t i = 0; i < n; ++i) {
-        const q10_parsed_arguments_t *const args = query_instance_get_argument_data(instances[i]);
-        filters[i]                               = *args;
-
-        if (args->year != -1 && args->month != -1) {
-            stats_data[i] = calloc(32, sizeof(q10_instant_statistics_t));
-            if (!stats_data[i])
-                goto DEFER_4;
-        } else if (args->year != -1) {
-            stats_data[i] = calloc(13, sizeof(q10_instant_statistics_t));
-            if (!stats_data[i])
-                goto DEFER_4;
-        } else {
-            stats_data[i] =
-                calloc(Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE, sizeof(q10_instant_statistics_t));
-            if (!stats_data[i])
-                goto DEFER_4;
-        }
+    q10_foreach_user_data_t *const user_iter_data = calloc(1, sizeof(q10_foreach_user_data_t));
+    if (!user_iter_data) {
+        free(stats);
+        return NULL;
     }
 
-    q10_foreach_user_data_t user_iter_data = {.stats_data   = stats_data,
-                                              .filters      = filters,
-                                              .flags        = flags,
-                                              .stats_length = n,
-                                              .flights      = database_get_flights(database)};
-    user_manager_iter_with_flights(database_get_users(database),
-                                   __q10_generate_statistics_foreach_user,
-                                   &user_iter_data);
+    user_iter_data->stats   = stats;
+    user_iter_data->flights = database_get_flights(database);
+    if (user_manager_iter_with_flights(database_get_users(database),
+                                       __q10_generate_statistics_foreach_user,
+                                       user_iter_data)) {
+        free(user_iter_data);
+        free(stats);
+        return NULL;
+    }
 
-    q10_statistical_data_t *const stats = malloc(sizeof(q10_statistical_data_t));
-    if (!stats)
-        goto DEFER_4;
-    stats->stats_data   = stats_data;
-    stats->filters      = filters;
-    stats->stats_length = n;
+    free(user_iter_data);
+    return stats;
+}
 
-    flight_manager_iter(database_get_flights(database),
-                        __q10_generate_statistics_foreach_flight,
-                        stats);
+/**
+ * @brief   Starts generating partial statistical data for queries of type 10.
+ * @details Partial data only counts flights and reservations, in part of the database, and is later
+ *          merged with ::__q10_generate_statistics_merge. Users are only considered in
+ *          ::__q10_generate_statistics.
+ *
+ * @param database   Database (not used).
+ * @param n          Number of query instances (not used).
+ * @param instances  Instances of the query 10 (not used).
+ *
+ * @return A pointer to a ::q10_statistical_data_t on success, or `NULL` on allocation failure.
+ *         It's allocated with ::cache_line_calloc.
+ */
+void *__q10_generate_statistics_partial(const database_t             *database,
+                                        size_t                        n,
+                                        const query_instance_t *const instances[n]) {
+    (void) database;
+    (void) n;
+    (void) instances;
 
-    reservation_manager_iter(database_get_reservations(database),
-                             __q10_generate_statistics_foreach_reservation,
-                             stats);
+    /* Counters are incremented constantly, and mustn't share cache lines with other threads' */
+    return cache_line_calloc(sizeof(q10_statistical_data_t));
+}
 
-    free(flags);
-    return stats;
+/**
+ * @brief Adds the statistics of an array of instants to the ones of another array.
+ *
+ * @param to   Where to add statistics to.
+ * @param from Statistics to be added to @p to.
+ * @param n    Number of instants in @p to and @p from.
+ */
+void __q10_instant_statistics_add(q10_instant_statistics_t       *to,
+                                  const q10_instant_statistics_t *from,
+                                  size_t                          n) {
+    for (size_t i = 0; i < n; ++i) {
+        to[i].users += from[i].users;
+        to[i].flights += from[i].flights;
+        to[i].passengers += from[i].passengers;
+        to[i].unique_passengers += from[i].unique_passengers;
+        to[i].reservations += from[i].reservations;
+    }
+}
 
-DEFER_4:
-    for (size_t i = 0; i < n; ++i)
-        if (stats_data[i])
-            free(stats_data[i]);
-    free(flags);
-DEFER_3:
-    free(filters);
-DEFER_2:
-    free(stats_data);
-DEFER_1:
-    return NULL;
+/**
+ * @brief Merges partial statistical data for queries of type 10.
+ *
+ * @param scan_data    Value returned by ::__q10_generate_statistics.
+ * @param partial_data Value returned by ::__q10_generate_statistics_partial. It'll be freed.
+ *
+ * @retval 0 Always successful.
+ */
+int __q10_generate_statistics_merge(void *scan_data, void *partial_data) {
+    q10_statistical_data_t *const       stats   = scan_data;
+    const q10_statistical_data_t *const partial = partial_data;
+
+    __q10_instant_statistics_add(stats->years, partial->years, Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE);
+    __q10_instant_statistics_add(&stats->months[0][0],
+                                 &partial->months[0][0],
+                                 Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE * 13);
+    __q10_instant_statistics_add(&stats->days[0][0][0],
+                                 &partial->days[0][0][0],
+                                 Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE * 13 * 32);
+
+    free(partial_data);
+    return 0;
 }
 
 /**
@@ -472,15 +470,12 @@ void __q10_instant_statistics_write(const q10_instant_statistics_t *istats,
                                     int                             value) {
 
     query_writer_write_new_object(output);
-    query_writer_write_new_field(output, ymd, "%d", value);
-    query_writer_write_new_field(output, "users", "%" PRIu32, istats->users);
-    query_writer_write_new_field(output, "flights", "%" PRIu32, istats->flights);
-    query_writer_write_new_field(output, "passengers", "%" PRIu32, istats->passengers);
-    query_writer_write_new_field(output,
-                                 "unique_passengers",
-                                 "%" PRIu32,
-                                 istats->unique_passengers);
-    query_writer_write_new_field(output, "reservations", "%" PRIu32, istats->reservations);
+    query_writer_write_new_field_signed(output, ymd, value);
+    query_writer_write_new_field_unsigned(output, "users", istats->users);
+    query_writer_write_new_field_unsigned(output, "flights", istats->flights);
+    query_writer_write_new_field_unsigned(output, "passengers", istats->passengers);
+    query_writer_write_new_field_unsigned(output, "unique_passengers", istats->unique_passengers);
+    query_writer_write_new_field_unsigned(output, "reservations", istats->reservations);
 }
 
 /**
@@ -496,78 +491,136 @@ int __q10_instant_statistics_has_events(const q10_instant_statistics_t *istats)
            istats->reservations;
 }
 
-/**
- * @brief Method called to execute a query of type 10.
- *
- * @param database   Database to get data from (not used, as all data is collected in
- *                   ::__q10_generate_statistics).
- * @param statistics Statistical data generated by ::__q10_generate_statistics (a pointer to a
- *                   ::q10_statistical_data_t).
- * @param instance   Query instance to be executed.
- * @param output     Where to write the query's result to.
- *
- * @retval 0 Success.
- * @retval 1 Fatal failure (should, in principle, be unreachable).
- */
-int __q10_execute(const database_t       *database,
-                  const void             *statistics,
-                  const query_instance_t *instance,
-                  query_writer_t         *output) {
+int q10_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
     (void) database;
 
     const q10_parsed_arguments_t *const args  = query_instance_get_argument_data(instance);
     const q10_statistical_data_t *const stats = statistics;
 
-    for (size_t i = 0; i < stats->stats_length; ++i) {
-        const q10_parsed_arguments_t *const filter = stats->filters + i;
-        if (!(filter->year == args->year && filter->month == args->month))
-            continue;
-
-        const q10_instant_statistics_t *const istats = stats->stats_data[i];
-
-        if (filter->year != -1 && filter->month != -1) {
-            for (int j = 1; j <= 31; ++j)
-                if (__q10_instant_statistics_has_events(istats + j))
-                    __q10_instant_statistics_write(istats + j, output, "day", j);
-        } else if (filter->year != -1) {
-            for (int j = 1; j <= 12; ++j)
-                if (__q10_instant_statistics_has_events(istats + j))
-                    __q10_instant_statistics_write(istats + j, output, "month", j);
-        } else {
-            for (int j = 0; j < Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE; ++j)
-                if (__q10_instant_statistics_has_events(istats + j))
-                    __q10_instant_statistics_write(istats + j,
-                                                   output,
-                                                   "year",
-                                                   j + Q10_SUPPORTED_YEAR_RANGE_START);
-        }
+    if (args->year == -1) {
+        for (int j = 0; j < Q10_SUPPORTED_YEAR_RANGE_AMPLITUDE; ++j)
+            if (__q10_instant_statistics_has_events(&stats->years[j]))
+                __q10_instant_statistics_write(&stats->years[j],
+                                               output,
+                                               "year",
+                                               j + Q10_SUPPORTED_YEAR_RANGE_START);
         return 0;
     }
 
-    fprintf(stderr, "Bad statistical data in query 10! This should not happen!\n");
-    return 1;
+    if (args->year < Q10_SUPPORTED_YEAR_RANGE_START || args->year >= Q10_SUPPORTED_YEAR_RANGE_END)
+        return 0; /* No events outside of the supported range */
+    const size_t year_index = args->year - Q10_SUPPORTED_YEAR_RANGE_START;
+
+    if (args->month == -1) {
+        const q10_instant_statistics_t *const istats = stats->months[year_index];
+        for (int j = 1; j <= 12; ++j)
+            if (__q10_instant_statistics_has_events(istats + j))
+                __q10_instant_statistics_write(istats + j, output, "month", j);
+    } else {
+        const q10_instant_statistics_t *const istats = stats->days[year_index][args->month];
+        for (int j = 1; j <= 31; ++j)
+            if (__q10_instant_statistics_has_events(istats + j))
+                __q10_instant_statistics_write(istats + j, output, "day", j);
+    }
+    return 0;
 }
 
 /**
- * @brief Frees statistical data generated by ::__q10_generate_statistics.
- * @param statistics Non-`NULL` value returned by ::__q10_generate_statistics.
+ * @brief Writes statistical data for queries of type 10 to a file.
+ *
+ * @param statistics A pointer to a ::q10_statistical_data_t.
+ * @param file       File where to write @p statistics to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
  */
-void __q10_free_statistics(void *statistics) {
-    q10_statistical_data_t *const stats = statistics;
-
-    for (size_t i = 0; i < stats->stats_length; ++i)
-        free((stats->stats_data)[i]);
-    free(stats->stats_data);
-    free(stats->filters);
-    free(stats);
+int __q10_save_statistics(const void *statistics, FILE *file) {
+    return fwrite(statistics, sizeof(q10_statistical_data_t), 1, file) != 1;
+}
+
+/**
+ * @brief   Reads statistical data for queries of type 10, written by ::__q10_save_statistics.
+ * @details ::q10_statistical_data_t doesn't point to other data, so it's used directly from the
+ *          mapped file, without being copied.
+ *
+ * @param contents Contents of the file written by ::__q10_save_statistics.
+ * @param size     Number of bytes in @p contents.
+ *
+ * @return A pointer to a ::q10_statistical_data_t in @p contents, or `NULL` if @p size is wrong.
+ */
+void *__q10_load_statistics(const char *contents, size_t size) {
+    if (size != sizeof(q10_statistical_data_t))
+        return NULL;
+    return (void *) (uintptr_t) contents; /* Statistics are never modified */
+}
+
+/**
+ * @brief   Finds the range of dates the statistical data of some queries of type 10 depends on.
+ * @details Queries for a year only need that year, and queries for a month only need that month.
+ *          Queries without arguments need every year.
+ *
+ * @param n         Number of query instances in @p instances.
+ * @param instances Instances of the query 10.
+ * @param begin     Where to write the first day needed by a query to.
+ * @param end       Where to write the last day needed by a query to.
+ *
+ * @retval 0 @p begin and @p end were written.
+ * @retval 1 Some query needs every date.
+ */
+int __q10_date_range(size_t                        n,
+                     const query_instance_t *const instances[n],
+                     date_t                       *begin,
+                     date_t                       *end) {
+
+    *begin = UINT32_MAX;
+    *end   = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const q10_parsed_arguments_t *const args = query_instance_get_argument_data(instances[i]);
+        if (args->year < 0)
+            return 1;
+
+        date_t first, last;
+        if (date_from_values(&first, args->year, args->month < 0 ? 1 : args->month, 1) ||
+            date_from_values(&last,
+                             args->year,
+                             args->month < 0 ? 12 : args->month,
+                             DATE_DAYS_PER_MONTH))
+            return 1;
+
+        *begin = min(*begin, first);
+        *end   = max(*end, last);
+    }
+    return 0;
 }
 
 query_type_t *q10_create(void) {
+    const query_type_scan_t scan = {
+        .begin                = __q10_generate_statistics,
+        .foreach_flights      = __q10_generate_statistics_foreach_flights,
+        .foreach_reservations = __q10_generate_statistics_foreach_reservations,
+        .partial_begin        = __q10_generate_statistics_partial,
+        .merge                = __q10_generate_statistics_merge,
+        .date_range           = __q10_date_range};
+    const query_type_persistence_t persistence = {.save        = __q10_save_statistics,
+                                                  .load        = __q10_load_statistics,
+                                                  .free_loaded = NULL};
+
     return query_type_create(10,
                              __q10_parse_arguments,
-                             __q10_clone_arguments,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             &scan,
                              free,
-                             __q10_generate_statistics,
-                             __q10_free_statistics,
-                             __q10_execute);
+                             1,
+                             &persistence,
+                             q10_execute,
+                             NULL,
+                             NULL,
+                             0);
 }
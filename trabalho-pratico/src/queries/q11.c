@@ -0,0 +1,251 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  q11.c
+ * @brief Implementation of methods in include/queries/q11.h
+ */
+
+#include <stdint.h>
+
+#include "queries/q11.h"
+#include "queries/query_instance.h"
+
+/**
+ * @struct q11_parsed_arguments_t
+ * @brief  Parsed arguments of a query of type 11.
+ *
+ * @var q11_parsed_arguments_t::origin
+ *     @brief Code of the origin airport.
+ * @var q11_parsed_arguments_t::destination
+ *     @brief Code of the destination airport.
+ * @var q11_parsed_arguments_t::begin_date
+ *     @brief Beginning date for date range filter.
+ * @var q11_parsed_arguments_t::end_date
+ *     @brief End date for date range filter.
+ * @var q11_parsed_arguments_t::statistics
+ *     @brief Whether no time frame was provided, and the statistics of the route are to be
+ *            outputted, instead of its flights.
+ */
+typedef struct {
+    airport_code_t  origin;
+    airport_code_t  destination;
+    date_and_time_t begin_date;
+    date_and_time_t end_date;
+    int             statistics;
+} q11_parsed_arguments_t;
+
+/**
+ * @brief   Parses the arguments of a query of type 11.
+ * @details Asserts that there's two airport codes, optionally followed by two dates with times.
+ *
+ * @param allocator Not used (no strings are stored).
+ * @param output    Where to write the ::q11_parsed_arguments_t to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
+ *
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments.
+ */
+int __q11_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    (void) allocator;
+    if (argc != 2 && argc != 4)
+        return 1;
+
+    q11_parsed_arguments_t *const parsed_arguments = output;
+    if (airport_code_from_string(&parsed_arguments->origin, argv[0]) ||
+        airport_code_from_string(&parsed_arguments->destination, argv[1]))
+        return 1;
+
+    parsed_arguments->statistics = argc == 2;
+    if (argc == 2) {
+        parsed_arguments->begin_date = 0;
+        parsed_arguments->end_date   = INT64_MAX;
+        return 0;
+    }
+
+    const int begin_date_retval = date_and_time_from_string(&parsed_arguments->begin_date, argv[2]);
+    const int end_date_retval   = date_and_time_from_string(&parsed_arguments->end_date, argv[3]);
+    return begin_date_retval || end_date_retval;
+}
+
+/**
+ * @brief  Calculates the delay of a flight.
+ * @param  flight Flight to get the delay of.
+ * @return The number of seconds between the scheduled and the real departure dates of @p flight.
+ */
+int64_t __q11_flight_delay(const flight_t *flight) {
+    return date_and_time_diff(flight_get_real_departure_date(flight),
+                              flight_get_schedule_departure_date(flight));
+}
+
+/**
+ * @struct q11_execute_iter_callback_data_t
+ * @brief  Type of `user_data` parameter in ::__q11_execute_iter_callback.
+ *
+ * @var q11_execute_iter_callback_data_t::strings
+ *     @brief Dictionary of airlines and plane models in the flight manager.
+ * @var q11_execute_iter_callback_data_t::output
+ *     @brief Where to output flights to.
+ */
+typedef struct {
+    const string_dictionary_t *const strings;
+    query_writer_t *const            output;
+} q11_execute_iter_callback_data_t;
+
+/**
+ * @brief   Callback called for every flight that matches a query of type 11, to output it.
+ * @details Auxiliary method for ::q11_execute.
+ *
+ * @param user_data A pointer to a ::q11_execute_iter_callback_data_t.
+ * @param flight    Flight of the query's route that departs during the query's range of time.
+ *
+ * @retval 0 Always successful.
+ */
+int __q11_execute_iter_callback(void *user_data, const flight_t *flight) {
+    const q11_execute_iter_callback_data_t *const data    = user_data;
+    const string_dictionary_t *const              strings = data->strings;
+    query_writer_t *const                         output  = data->output;
+
+    char flight_id_str[FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE];
+    flight_id_sprintf(flight_id_str, flight_get_id(flight));
+
+    query_writer_write_new_object(output);
+    query_writer_write_new_field_string(output, "id", flight_id_str);
+    query_writer_write_new_field_date_and_time(output,
+                                               "schedule_departure_date",
+                                               flight_get_schedule_departure_date(flight));
+    query_writer_write_new_field_signed(output, "delay", __q11_flight_delay(flight));
+    query_writer_write_new_field_unsigned(output,
+                                          "passengers",
+                                          flight_get_number_of_passengers(flight));
+    query_writer_write_new_field_string(output,
+                                        "airline",
+                                        flight_get_const_airline(strings, flight));
+    query_writer_write_new_field_string(output,
+                                        "plane_model",
+                                        flight_get_const_plane_model(strings, flight));
+    return 0;
+}
+
+/**
+ * @struct q11_route_statistics_t
+ * @brief  Statistics of all flights of a route.
+ *
+ * @var q11_route_statistics_t::flights
+ *     @brief Number of flights.
+ * @var q11_route_statistics_t::passengers
+ *     @brief Total number of passengers.
+ * @var q11_route_statistics_t::total_delay
+ *     @brief Sum of the delays of all flights.
+ * @var q11_route_statistics_t::maximum_delay
+ *     @brief Largest delay of any flight.
+ */
+typedef struct {
+    uint64_t flights, passengers;
+    int64_t  total_delay, maximum_delay;
+} q11_route_statistics_t;
+
+/**
+ * @brief   Callback called for every flight of the route of a query of type 11, to add it to the
+ *          route's statistics.
+ * @details Auxiliary method for ::q11_execute.
+ *
+ * @param user_data A pointer to a ::q11_route_statistics_t.
+ * @param flight    Flight of the query's route.
+ *
+ * @retval 0 Always successful.
+ */
+int __q11_execute_statistics_iter_callback(void *user_data, const flight_t *flight) {
+    q11_route_statistics_t *const stats = user_data;
+    const int64_t                 delay = __q11_flight_delay(flight);
+
+    if (!stats->flights || delay > stats->maximum_delay)
+        stats->maximum_delay = delay;
+    stats->flights++;
+    stats->passengers += flight_get_number_of_passengers(flight);
+    stats->total_delay += delay;
+    return 0;
+}
+
+int q11_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
+    (void) statistics;
+
+    const q11_parsed_arguments_t *const arguments = query_instance_get_argument_data(instance);
+    const flight_manager_t *const       flights   = database_get_flights(database);
+
+    if (arguments->statistics) {
+        q11_route_statistics_t stats = {0};
+        flight_manager_iter_route_departures(flights,
+                                             arguments->origin,
+                                             arguments->destination,
+                                             arguments->begin_date,
+                                             arguments->end_date,
+                                             __q11_execute_statistics_iter_callback,
+                                             &stats);
+        if (!stats.flights)
+            return 0;
+
+        query_writer_write_new_object(output);
+        query_writer_write_new_field_unsigned(output, "flights", stats.flights);
+        query_writer_write_new_field_unsigned(output, "passengers", stats.passengers);
+        query_writer_write_new_field_decimal(output,
+                                             "average_delay",
+                                             (double) stats.total_delay / (double) stats.flights);
+        query_writer_write_new_field_signed(output, "maximum_delay", stats.maximum_delay);
+        return 0;
+    }
+
+    q11_execute_iter_callback_data_t data = {.strings = flight_manager_get_strings(flights),
+                                             .output  = output};
+
+    /* Only look at the flights in the requested page */
+    const size_t offset = query_instance_get_offset(instance);
+    query_writer_skip_objects(output, offset);
+    return flight_manager_iter_route_departures_range(flights,
+                                                      arguments->origin,
+                                                      arguments->destination,
+                                                      arguments->begin_date,
+                                                      arguments->end_date,
+                                                      offset,
+                                                      query_instance_get_limit(instance),
+                                                      __q11_execute_iter_callback,
+                                                      &data);
+}
+
+query_type_t *q11_create(void) {
+    return query_type_create(11,
+                             __q11_parse_arguments,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             0,
+                             NULL,
+                             q11_execute,
+                             NULL,
+                             NULL,
+                             DATABASE_INDEX_SET(DATABASE_INDEX_FLIGHT_ROUTE_DEPARTURES));
+}
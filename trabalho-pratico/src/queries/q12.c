@@ -0,0 +1,894 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  q12.c
+ * @brief Implementation of methods in include/queries/q12.h
+ */
+
+#include <glib.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queries/q12.h"
+#include "queries/query_instance.h"
+#include "utils/int_utils.h"
+#include "utils/radix_sort.h"
+
+/** @brief Maximum number of filters in a query of type 12. */
+#define Q12_MAX_FILTERS 16
+
+/** @brief Type of the entity filtered by a query 12. */
+typedef enum {
+    Q12_ENTITY_FLIGHTS,      /**< @brief The query filters flights. */
+    Q12_ENTITY_RESERVATIONS, /**< @brief The query filters reservations. */
+    Q12_ENTITY_USERS         /**< @brief The query filters users. */
+} q12_entity_t;
+
+/** @brief Column a filter of a query 12 is applied to. */
+typedef enum {
+    Q12_COLUMN_ORIGIN,      /**< @brief Origin airport of a flight. */
+    Q12_COLUMN_DESTINATION, /**< @brief Destination airport of a flight. */
+    Q12_COLUMN_DEPARTURE,   /**< @brief Scheduled departure date of a flight. */
+    Q12_COLUMN_DELAY,       /**< @brief Delay of a flight, in seconds. */
+    Q12_COLUMN_PASSENGERS,  /**< @brief Number of passengers of a flight. */
+    Q12_COLUMN_HOTEL,       /**< @brief Hotel of a reservation. */
+    Q12_COLUMN_STARS,       /**< @brief Number of stars of the hotel of a reservation. */
+    Q12_COLUMN_RATING,      /**< @brief Rating of a reservation. */
+    Q12_COLUMN_BEGIN,       /**< @brief Beginning date of a reservation. */
+    Q12_COLUMN_END,         /**< @brief End date of a reservation. */
+    Q12_COLUMN_PRICE,       /**< @brief Price per night of a reservation. */
+    Q12_COLUMN_BREAKFAST,   /**< @brief Whether a reservation includes breakfast. */
+    Q12_COLUMN_STATUS,      /**< @brief Account status of a user. */
+    Q12_COLUMN_SEX,         /**< @brief Sex of a user. */
+    Q12_COLUMN_COUNTRY      /**< @brief Country code of a user. */
+} q12_column_t;
+
+/**
+ * @struct  q12_filter_t
+ * @brief   A filter of a query 12, compiled to a range of values.
+ * @details A row matches the filter when the value of its column is in
+ *          [::q12_filter_t::min, ::q12_filter_t::max], unless ::q12_filter_t::negate is set (e.g.:
+ *          for `!=`). Filters that never match are an inverted range of all values.
+ *
+ * @var q12_filter_t::column
+ *     @brief Column the filter is applied to (a ::q12_column_t).
+ * @var q12_filter_t::negate
+ *     @brief `1` if rows must be outside the range to match, `0` otherwise.
+ * @var q12_filter_t::min
+ *     @brief Lowest value in the range (inclusive).
+ * @var q12_filter_t::max
+ *     @brief Highest value in the range (inclusive).
+ */
+typedef struct {
+    uint8_t column;
+    uint8_t negate;
+    int64_t min, max;
+} q12_filter_t;
+
+/**
+ * @struct  q12_parsed_arguments_t
+ * @brief   Parsed arguments of a query of type 12.
+ * @details Filters are stored as bytes, as they may be in a ::string_pool_t, without any alignment
+ *          guarantees. They're copied to an array of ::q12_filter_t before being evaluated.
+ *
+ * @var q12_parsed_arguments_t::entity
+ *     @brief Entity being filtered (a ::q12_entity_t).
+ * @var q12_parsed_arguments_t::ids
+ *     @brief `1` to output the identifiers of matches, `0` to output their count.
+ * @var q12_parsed_arguments_t::nfilters
+ *     @brief Number of filters in ::q12_parsed_arguments_t::filters.
+ * @var q12_parsed_arguments_t::filters
+ *     @brief ::q12_parsed_arguments_t::nfilters ::q12_filter_t's. `NULL` when there are none.
+ */
+typedef struct {
+    uint8_t entity;
+    uint8_t ids;
+    uint8_t nfilters;
+    char   *filters;
+} q12_parsed_arguments_t;
+
+/**
+ * @brief Parses the name of a column of a query 12.
+ *
+ * @param column Where to write the parsed column to.
+ * @param entity Entity being filtered, that must have the column.
+ * @param input  Name of the column.
+ *
+ * @retval 0 Success.
+ * @retval 1 Unknown column, or column of another entity.
+ */
+int __q12_parse_column(q12_column_t *column, q12_entity_t entity, const char *input) {
+    const char *const names[] = {"origin",
+                                 "destination",
+                                 "departure",
+                                 "delay",
+                                 "passengers",
+                                 "hotel",
+                                 "stars",
+                                 "rating",
+                                 "begin",
+                                 "end",
+                                 "price",
+                                 "breakfast",
+                                 "status",
+                                 "sex",
+                                 "country"};
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(*names); ++i) {
+        if (strcmp(names[i], input) == 0) {
+            const q12_entity_t column_entity = i < Q12_COLUMN_HOTEL    ? Q12_ENTITY_FLIGHTS
+                                               : i < Q12_COLUMN_STATUS ? Q12_ENTITY_RESERVATIONS
+                                                                       : Q12_ENTITY_USERS;
+            if (column_entity != entity)
+                return 1;
+
+            *column = (q12_column_t) i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Parses a signed decimal integer.
+ *
+ * @param output Where to write the parsed integer to.
+ * @param input  String to be parsed, optionally starting with a `'-'`.
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure, or integer out of range.
+ */
+int __q12_parse_integer(int64_t *output, const char *input) {
+    const int negative = *input == '-';
+
+    uint64_t magnitude;
+    if (int_utils_parse_positive(&magnitude, input + negative) || magnitude > INT64_MAX)
+        return 1;
+
+    *output = negative ? -(int64_t) magnitude : (int64_t) magnitude;
+    return 0;
+}
+
+/**
+ * @brief Parses the value of a filter of a query 12, for a given column.
+ *
+ * @param output Where to write the parsed value to.
+ * @param column Column the value is compared with.
+ * @param input  String to be parsed. May be modified.
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure.
+ */
+int __q12_parse_value(int64_t *output, q12_column_t column, char *input) {
+    switch (column) {
+        case Q12_COLUMN_ORIGIN:
+        case Q12_COLUMN_DESTINATION: {
+            airport_code_t code;
+            if (airport_code_from_string(&code, input))
+                return 1;
+            *output = code;
+            return 0;
+        }
+        case Q12_COLUMN_DEPARTURE: {
+            date_and_time_t date;
+            if (date_and_time_from_string(&date, input))
+                return 1;
+            *output = (int64_t) date;
+            return 0;
+        }
+        case Q12_COLUMN_HOTEL: {
+            hotel_id_t hotel;
+            if (hotel_id_from_string(&hotel, input))
+                return 1;
+            *output = hotel;
+            return 0;
+        }
+        case Q12_COLUMN_BEGIN:
+        case Q12_COLUMN_END: {
+            date_t date;
+            if (date_from_string(&date, input))
+                return 1;
+            *output = date;
+            return 0;
+        }
+        case Q12_COLUMN_BREAKFAST: {
+            includes_breakfast_t breakfast;
+            if (includes_breakfast_from_string(&breakfast, input))
+                return 1;
+            *output = breakfast;
+            return 0;
+        }
+        case Q12_COLUMN_STATUS: {
+            account_status_t status;
+            if (account_status_from_string(&status, input))
+                return 1;
+            *output = status;
+            return 0;
+        }
+        case Q12_COLUMN_SEX: {
+            sex_t sex;
+            if (sex_from_string(&sex, input))
+                return 1;
+            *output = sex;
+            return 0;
+        }
+        case Q12_COLUMN_COUNTRY: {
+            country_code_t country;
+            if (country_code_from_string(&country, input))
+                return 1;
+            *output = country;
+            return 0;
+        }
+        default:
+            return __q12_parse_integer(output, input);
+    }
+}
+
+/**
+ * @brief Parses a filter of a query 12, and compiles it to a range of values.
+ *
+ * @param output   Where to write the compiled filter to.
+ * @param entity   Entity being filtered.
+ * @param column   Name of the column.
+ * @param operator Comparison operator.
+ * @param value    Value to compare the column with. May be modified.
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure, or comparison other than `=` for users.
+ */
+int __q12_parse_filter(q12_filter_t *output,
+                       q12_entity_t  entity,
+                       const char   *column,
+                       const char   *operator,
+                       char         *value) {
+    q12_column_t parsed_column;
+    int64_t      parsed_value;
+    if (__q12_parse_column(&parsed_column, entity, column) ||
+        __q12_parse_value(&parsed_value, parsed_column, value))
+        return 1;
+
+    output->column = parsed_column;
+    output->negate = 0;
+    output->min    = INT64_MIN;
+    output->max    = INT64_MAX;
+
+    if (strcmp(operator, "=") == 0 || strcmp(operator, "!=") == 0) {
+        output->negate = operator[0] == '!';
+        output->min    = parsed_value;
+        output->max    = parsed_value;
+    } else if (strcmp(operator, "<=") == 0) {
+        output->max = parsed_value;
+    } else if (strcmp(operator, ">=") == 0) {
+        output->min = parsed_value;
+    } else if (strcmp(operator, "<") == 0) {
+        if (parsed_value == INT64_MIN)
+            output->negate = 1; /* Never matches */
+        else
+            output->max = parsed_value - 1;
+    } else if (strcmp(operator, ">") == 0) {
+        if (parsed_value == INT64_MAX)
+            output->negate = 1; /* Never matches */
+        else
+            output->min = parsed_value + 1;
+    } else {
+        return 1;
+    }
+
+    /* Users are only filtered with bitmaps, which can't answer other comparisons */
+    if (entity == Q12_ENTITY_USERS && (output->negate || output->min != output->max))
+        return 1;
+    return 0;
+}
+
+/**
+ * @brief   Parses the arguments of a query of type 12.
+ * @details Asserts that there's an entity, an output mode, and groups of three arguments for each
+ *          filter (see q12.h).
+ *
+ * @param allocator Where to allocate the compiled filters. `NULL` for `malloc`.
+ * @param output    Where to write the ::q12_parsed_arguments_t to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
+ *
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments or allocation failure.
+ */
+int __q12_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    if (argc < 2 || (argc - 2) % 3 != 0 || (argc - 2) / 3 > Q12_MAX_FILTERS)
+        return 1;
+
+    q12_parsed_arguments_t *const parsed_arguments = output;
+    if (strcmp(argv[0], "flights") == 0)
+        parsed_arguments->entity = Q12_ENTITY_FLIGHTS;
+    else if (strcmp(argv[0], "reservations") == 0)
+        parsed_arguments->entity = Q12_ENTITY_RESERVATIONS;
+    else if (strcmp(argv[0], "users") == 0)
+        parsed_arguments->entity = Q12_ENTITY_USERS;
+    else
+        return 1;
+
+    if (strcmp(argv[1], "count") == 0)
+        parsed_arguments->ids = 0;
+    else if (strcmp(argv[1], "ids") == 0)
+        parsed_arguments->ids = 1;
+    else
+        return 1;
+
+    const size_t nfilters = (argc - 2) / 3;
+    q12_filter_t filters[Q12_MAX_FILTERS];
+    for (size_t i = 0; i < nfilters; ++i) {
+        char *const *const filter = argv + 2 + 3 * i;
+        if (__q12_parse_filter(&filters[i],
+                               (q12_entity_t) parsed_arguments->entity,
+                               filter[0],
+                               filter[1],
+                               filter[2]))
+            return 1;
+    }
+
+    parsed_arguments->nfilters = (uint8_t) nfilters;
+    parsed_arguments->filters  = NULL;
+    if (nfilters == 0)
+        return 0;
+
+    const size_t size = sizeof(q12_filter_t) * nfilters;
+    parsed_arguments->filters = allocator ? string_pool_allocate(allocator, size) : malloc(size);
+    if (!parsed_arguments->filters)
+        return 1;
+
+    memcpy(parsed_arguments->filters, filters, size);
+    return 0;
+}
+
+/**
+ * @brief Creates a deep clone of arguments written by ::__q12_parse_arguments.
+ *
+ * @param allocator Where to allocate the copy of the filters. `NULL` for `malloc`.
+ * @param output    Shallow copy of @p args_data, to be turned into a deep copy.
+ * @param args_data Arguments written by ::__q12_parse_arguments (a ::q12_parsed_arguments_t).
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __q12_clone_arguments(string_pool_t *allocator, void *output, const void *args_data) {
+    const q12_parsed_arguments_t *const arguments = args_data;
+    q12_parsed_arguments_t *const       clone     = output;
+    if (!arguments->filters)
+        return 0;
+
+    const size_t size = sizeof(q12_filter_t) * arguments->nfilters;
+    clone->filters    = allocator ? string_pool_allocate(allocator, size) : malloc(size);
+    if (!clone->filters)
+        return 1;
+
+    memcpy(clone->filters, arguments->filters, size);
+    return 0;
+}
+
+/**
+ * @brief Frees the filters in arguments written by ::__q12_parse_arguments.
+ * @param args_data Arguments written by ::__q12_parse_arguments.
+ */
+void __q12_free_arguments(void *args_data) {
+    free(((q12_parsed_arguments_t *) args_data)->filters);
+}
+
+/**
+ * @brief Writes the filters in arguments written by ::__q12_parse_arguments.
+ *
+ * @param args_data Arguments written by ::__q12_parse_arguments.
+ * @param file      File where to write the compiled filters to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __q12_save_arguments(const void *args_data, FILE *file) {
+    const q12_parsed_arguments_t *const arguments = args_data;
+    return arguments->filters &&
+           fwrite(arguments->filters, sizeof(q12_filter_t), arguments->nfilters, file) !=
+               arguments->nfilters;
+}
+
+/**
+ * @brief Reads the filters written by ::__q12_save_arguments.
+ *
+ * @param allocator Where to allocate the filters. `NULL` for `malloc`.
+ * @param output    Saved ::q12_parsed_arguments_t, whose filters are to be read.
+ * @param contents  Data written by ::__q12_save_arguments.
+ * @param size      Number of bytes in @p contents.
+ *
+ * @retval 0 Success.
+ * @retval 1 Corrupt @p contents or allocation failure.
+ */
+int __q12_load_arguments(string_pool_t *allocator,
+                         void          *output,
+                         const char    *contents,
+                         size_t         size) {
+    q12_parsed_arguments_t *const arguments = output;
+    if (arguments->nfilters > Q12_MAX_FILTERS || size != sizeof(q12_filter_t) * arguments->nfilters)
+        return 1;
+
+    arguments->filters = NULL;
+    if (size == 0)
+        return 0;
+
+    arguments->filters = allocator ? string_pool_allocate(allocator, size) : malloc(size);
+    if (!arguments->filters)
+        return 1;
+
+    memcpy(arguments->filters, contents, size);
+    return 0;
+}
+
+/**
+ * @brief   Applies a filter to a block of rows, without any branches.
+ * @details Values are compared with a single unsigned subtraction, which turns the range check
+ *          into `value - min <= max - min`.
+ *
+ * @param matches Array of @p n `uint8_t`s, cleared for rows that don't match @p filter.
+ * @param n       Number of rows in the block.
+ * @param filter  Pointer to the ::q12_filter_t to be applied.
+ * @param value   Expression for the value of the column in row `i`.
+ */
+#define Q12_FILTER(matches, n, filter, value)                                                      \
+    do {                                                                                           \
+        const uint64_t min    = (uint64_t) (filter)->min;                                          \
+        const uint64_t range  = (uint64_t) (filter)->max - min;                                    \
+        const uint8_t  negate = (filter)->negate;                                                  \
+        for (size_t i = 0; i < (n); ++i)                                                           \
+            (matches)[i] &= ((uint64_t) (int64_t) (value) - min <= range) ^ negate;                \
+    } while (0)
+
+/**
+ * @brief Value returned by ::__q12_execute_users_callback to stop iterating, when no more
+ *        identifiers will be outputted.
+ */
+#define Q12_EXECUTE_ITER_PAGE_FULL 2
+
+/**
+ * @struct  q12_execute_data_t
+ * @brief   Type of `user_data` parameter in callbacks of ::q12_execute.
+ * @details Flight and reservation identifiers are only outputted once all matches are found, so
+ *          that they can be sorted. Otherwise, their order would depend on how rows are laid out
+ *          in memory (see ::database_set_layout_policy).
+ *
+ * @var q12_execute_data_t::filters
+ *     @brief Filters all matching rows match.
+ * @var q12_execute_data_t::nfilters
+ *     @brief Number of elements in ::q12_execute_data_t::filters.
+ * @var q12_execute_data_t::output
+ *     @brief Where to output identifiers to, or `NULL` if only matches are to be counted.
+ * @var q12_execute_data_t::ids
+ *     @brief Matching flights or reservations found so far, as ::radix_sort_item_t's keyed by
+ *            identifier. `NULL` if only matches are to be counted.
+ * @var q12_execute_data_t::count
+ *     @brief Number of matches found so far.
+ */
+typedef struct {
+    const q12_filter_t *filters;
+    size_t              nfilters;
+    query_writer_t     *output;
+    GArray             *ids;
+    uint64_t            count;
+} q12_execute_data_t;
+
+/**
+ * @brief Method that prints an identifier (::flight_id_sprintf or ::reservation_id_sprintf).
+ *
+ * @param output Where to print the identifier to. Must be at least
+ *               ::Q12_ID_SPRINTF_MIN_BUFFER_SIZE characters long.
+ * @param id     Identifier to be printed.
+ */
+typedef void (*q12_id_sprintf_t)(char *output, uint32_t id);
+
+/** @brief Minimum size of the buffer passed to a ::q12_id_sprintf_t. */
+#define Q12_ID_SPRINTF_MIN_BUFFER_SIZE                                                             \
+    max(FLIGHT_ID_SPRINTF_MIN_BUFFER_SIZE, RESERVATION_ID_SPRINTF_MIN_BUFFER_SIZE)
+
+/**
+ * @brief   Collects or counts the matching rows of a block.
+ * @details Auxiliary method for ::__q12_execute_flights_callback and
+ *          ::__q12_execute_reservations_callback.
+ *
+ * @param data    Query data, where to count or collect matches to.
+ * @param matches Whether each row matches all filters.
+ * @param ids     Identifiers of the rows (::flight_id_t's or ::reservation_id_t's).
+ * @param n       Number of rows in the block.
+ */
+void __q12_collect_matches(q12_execute_data_t *data,
+                           const uint8_t      *matches,
+                           const uint32_t     *ids,
+                           size_t              n) {
+    if (!data->ids) {
+        uint64_t block_count = 0;
+        for (size_t i = 0; i < n; ++i)
+            block_count += matches[i];
+        data->count += block_count;
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (matches[i]) {
+            const radix_sort_item_t item = {.key = ids[i], .value = NULL};
+            g_array_append_val(data->ids, item);
+        }
+    }
+}
+
+/**
+ * @brief   Outputs the matches collected by ::__q12_collect_matches, sorted by identifier.
+ * @details Auxiliary method for ::q12_execute.
+ *
+ * @param data       Query data, with the collected matches and where to output them to.
+ * @param id_sprintf Method to print the identifiers of the matches.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __q12_output_matches(q12_execute_data_t *data, q12_id_sprintf_t id_sprintf) {
+    radix_sort_item_t *const items = (radix_sort_item_t *) data->ids->data;
+    const size_t             n     = data->ids->len;
+
+    radix_sort_item_t *const tmp = malloc(sizeof(radix_sort_item_t) * n);
+    if (!tmp && n)
+        return 1;
+    radix_sort(items, tmp, n);
+    free(tmp);
+
+    for (size_t i = 0; i < n && !query_writer_is_page_full(data->output); ++i) {
+        char id_str[Q12_ID_SPRINTF_MIN_BUFFER_SIZE];
+        id_sprintf(id_str, (uint32_t) items[i].key);
+        query_writer_write_new_object(data->output);
+        query_writer_write_new_field_string(data->output, "id", id_str);
+    }
+    return 0;
+}
+
+/**
+ * @brief   Callback for every block of flights, when a query of type 12 filters flights.
+ * @details Auxiliary method for ::q12_execute.
+ *
+ * @param user_data A pointer to a ::q12_execute_data_t.
+ * @param columns   Flights in the block.
+ * @param n         Number of flights in the block.
+ *
+ * @return Always `0`, to keep iterating.
+ */
+int __q12_execute_flights_callback(void                           *user_data,
+                                   const flight_manager_columns_t *columns,
+                                   size_t                          n) {
+    q12_execute_data_t *const data = user_data;
+
+    uint8_t matches[n];
+    memset(matches, 1, n);
+
+    for (size_t f = 0; f < data->nfilters; ++f) {
+        const q12_filter_t *const filter = &data->filters[f];
+        switch (filter->column) {
+            case Q12_COLUMN_ORIGIN:
+                Q12_FILTER(matches, n, filter, columns->origin[i]);
+                break;
+            case Q12_COLUMN_DESTINATION:
+                Q12_FILTER(matches, n, filter, columns->destination[i]);
+                break;
+            case Q12_COLUMN_DEPARTURE:
+                Q12_FILTER(matches, n, filter, columns->schedule_departure_date[i]);
+                break;
+            case Q12_COLUMN_DELAY:
+                Q12_FILTER(matches,
+                           n,
+                           filter,
+                           date_and_time_diff(columns->real_departure_date[i],
+                                              columns->schedule_departure_date[i]));
+                break;
+            default:
+                Q12_FILTER(matches, n, filter, columns->number_of_passengers[i]);
+                break;
+        }
+    }
+
+    __q12_collect_matches(data, matches, columns->id, n);
+    return 0;
+}
+
+/**
+ * @brief   Callback for every block of reservations, when a query of type 12 filters reservations.
+ * @details Auxiliary method for ::q12_execute.
+ *
+ * @param user_data A pointer to a ::q12_execute_data_t.
+ * @param columns   Reservations in the block.
+ * @param n         Number of reservations in the block.
+ *
+ * @return Always `0`, to keep iterating.
+ */
+int __q12_execute_reservations_callback(void                                *user_data,
+                                        const reservation_manager_columns_t *columns,
+                                        size_t                               n) {
+    q12_execute_data_t *const data = user_data;
+
+    uint8_t matches[n];
+    memset(matches, 1, n);
+
+    for (size_t f = 0; f < data->nfilters; ++f) {
+        const q12_filter_t *const filter = &data->filters[f];
+        switch (filter->column) {
+            case Q12_COLUMN_HOTEL:
+                Q12_FILTER(matches, n, filter, columns->hotel_id[i]);
+                break;
+            case Q12_COLUMN_STARS:
+                Q12_FILTER(matches, n, filter, columns->hotel_stars[i]);
+                break;
+            case Q12_COLUMN_RATING:
+                Q12_FILTER(matches, n, filter, columns->rating[i]);
+                break;
+            case Q12_COLUMN_BEGIN:
+                Q12_FILTER(matches, n, filter, columns->begin_date[i]);
+                break;
+            case Q12_COLUMN_END:
+                Q12_FILTER(matches, n, filter, columns->end_date[i]);
+                break;
+            case Q12_COLUMN_BREAKFAST:
+                Q12_FILTER(matches, n, filter, columns->includes_breakfast[i]);
+                break;
+            default:
+                Q12_FILTER(matches, n, filter, columns->price_per_night[i]);
+                break;
+        }
+    }
+
+    __q12_collect_matches(data, matches, columns->id, n);
+    return 0;
+}
+
+/**
+ * @brief   Checks if a filter can be answered by a bitmap index.
+ * @details See ::user_manager_get_bitmap and ::reservation_manager_get_bitmap.
+ *
+ * @param filter Filter to be checked.
+ *
+ * @return `1` if @p filter is an equality test on a column with a bitmap index, `0` otherwise.
+ */
+int __q12_is_bitmap_filter(const q12_filter_t *filter) {
+    const int bitmap_column =
+        filter->column == Q12_COLUMN_STARS || filter->column == Q12_COLUMN_BREAKFAST ||
+        filter->column == Q12_COLUMN_STATUS || filter->column == Q12_COLUMN_SEX ||
+        filter->column == Q12_COLUMN_COUNTRY;
+    return bitmap_column && !filter->negate && filter->min == filter->max;
+}
+
+/**
+ * @brief Gets the bitmap of the rows (or user ordinals) that match a filter.
+ *
+ * @param database Database to get the bitmap from.
+ * @param filter   Filter for which ::__q12_is_bitmap_filter is true.
+ *
+ * @return The bitmap of matches of @p filter, or `NULL` on allocation failure.
+ */
+const compressed_bitmap_t *__q12_get_filter_bitmap(const database_t   *database,
+                                                   const q12_filter_t *filter) {
+    const user_manager_t *const        users        = database_get_users(database);
+    const reservation_manager_t *const reservations = database_get_reservations(database);
+
+    switch (filter->column) {
+        case Q12_COLUMN_STARS:
+            return reservation_manager_get_bitmap(reservations,
+                                                  RESERVATION_MANAGER_BITMAP_STARS,
+                                                  filter->min);
+        case Q12_COLUMN_BREAKFAST:
+            return reservation_manager_get_bitmap(reservations,
+                                                  RESERVATION_MANAGER_BITMAP_BREAKFAST,
+                                                  filter->min);
+        case Q12_COLUMN_STATUS:
+            return user_manager_get_bitmap(users, USER_MANAGER_BITMAP_ACCOUNT_STATUS, filter->min);
+        case Q12_COLUMN_SEX:
+            return user_manager_get_bitmap(users, USER_MANAGER_BITMAP_SEX, filter->min);
+        default:
+            return user_manager_get_bitmap(users, USER_MANAGER_BITMAP_COUNTRY_CODE, filter->min);
+    }
+}
+
+/**
+ * @struct q12_execute_users_data_t
+ * @brief  Type of `user_data` parameter in ::__q12_execute_users_callback.
+ *
+ * @var q12_execute_users_data_t::users
+ *     @brief Users being outputted.
+ * @var q12_execute_users_data_t::output
+ *     @brief Where to output users to.
+ */
+typedef struct {
+    const user_manager_t *users;
+    query_writer_t       *output;
+} q12_execute_users_data_t;
+
+/**
+ * @brief   Callback for every user that matches a query of type 12, when identifiers are outputted.
+ * @details Auxiliary method for ::__q12_execute_bitmaps.
+ *
+ * @param user_data A pointer to a ::q12_execute_users_data_t.
+ * @param ordinal   Ordinal of the matching user.
+ *
+ * @retval 0                          Success.
+ * @retval Q12_EXECUTE_ITER_PAGE_FULL No more identifiers are to be outputted.
+ */
+int __q12_execute_users_callback(void *user_data, uint32_t ordinal) {
+    const q12_execute_users_data_t *const data = user_data;
+    if (query_writer_is_page_full(data->output))
+        return Q12_EXECUTE_ITER_PAGE_FULL;
+
+    const user_t *const user = user_manager_get_by_ordinal(data->users, ordinal);
+    query_writer_write_new_object(data->output);
+    query_writer_write_new_field_string(data->output, "id", user_get_const_id(user));
+    return 0;
+}
+
+/**
+ * @brief   Executes a query of type 12 by intersecting the bitmaps of its filters.
+ * @details Auxiliary method for ::q12_execute. Used for users, and to count reservations when
+ *          all filters satisfy ::__q12_is_bitmap_filter. Reservation identifiers can't be outputted
+ *          this way, as bitmaps of reservations only know their rows.
+ *
+ * @param database Database to get data from.
+ * @param data     Filters of the query, and where to output or count its matches to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __q12_execute_bitmaps(const database_t *database, q12_execute_data_t *data) {
+    const user_manager_t *const users     = database_get_users(database);
+    q12_execute_users_data_t    user_data = {.users = users, .output = data->output};
+    const size_t                nfilters  = data->nfilters;
+    const compressed_bitmap_t  *bitmaps[Q12_MAX_FILTERS];
+
+    if (nfilters == 0) {
+        /* Only possible for users: all of them match */
+        const size_t nusers = user_manager_get_length(users);
+        if (!data->output) {
+            data->count = nusers;
+            return 0;
+        }
+
+        for (size_t i = 0; i < nusers; ++i)
+            if (__q12_execute_users_callback(&user_data, i))
+                break;
+        return 0;
+    }
+
+    for (size_t i = 0; i < nfilters; ++i) {
+        bitmaps[i] = __q12_get_filter_bitmap(database, &data->filters[i]);
+        if (!bitmaps[i])
+            return 1;
+    }
+
+    /* When counting, the last intersection is only counted, not stored */
+    const compressed_bitmap_t *matches      = bitmaps[0];
+    compressed_bitmap_t       *intersection = NULL;
+    const size_t               nstored      = data->output ? nfilters : nfilters - 1;
+    for (size_t i = 1; i < nstored; ++i) {
+        compressed_bitmap_t *const next = compressed_bitmap_and(matches, bitmaps[i]);
+        compressed_bitmap_free(intersection);
+        if (!next)
+            return 1;
+
+        matches = intersection = next;
+    }
+
+    if (data->output)
+        compressed_bitmap_iter(matches, __q12_execute_users_callback, &user_data);
+    else if (nfilters > 1)
+        data->count = compressed_bitmap_and_count(matches, bitmaps[nfilters - 1]);
+    else
+        data->count = compressed_bitmap_count(matches);
+
+    compressed_bitmap_free(intersection);
+    return 0;
+}
+
+/**
+ * @brief   Checks if a query of type 12 can be executed by ::__q12_execute_bitmaps.
+ * @param   arguments Arguments of the query.
+ * @param   filters   Filters of the query, already copied from @p arguments.
+ * @return  `1` if the query is to be executed with bitmaps, `0` if columns are to be scanned.
+ */
+int __q12_uses_bitmaps(const q12_parsed_arguments_t *arguments, const q12_filter_t *filters) {
+    if (arguments->entity == Q12_ENTITY_USERS)
+        return 1;
+    if (arguments->entity != Q12_ENTITY_RESERVATIONS || arguments->ids || !arguments->nfilters)
+        return 0;
+
+    for (size_t i = 0; i < arguments->nfilters; ++i)
+        if (!__q12_is_bitmap_filter(&filters[i]))
+            return 0;
+    return 1;
+}
+
+int q12_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
+    (void) statistics;
+
+    const q12_parsed_arguments_t *const arguments = query_instance_get_argument_data(instance);
+
+    q12_filter_t filters[Q12_MAX_FILTERS];
+    if (arguments->nfilters)
+        memcpy(filters, arguments->filters, sizeof(q12_filter_t) * arguments->nfilters);
+
+    q12_execute_data_t data = {.filters  = filters,
+                               .nfilters = arguments->nfilters,
+                               .output   = arguments->ids ? output : NULL,
+                               .ids      = NULL,
+                               .count    = 0};
+
+    if (__q12_uses_bitmaps(arguments, filters)) {
+        if (__q12_execute_bitmaps(database, &data))
+            return 1;
+    } else {
+        if (arguments->ids)
+            data.ids = g_array_new(FALSE, FALSE, sizeof(radix_sort_item_t));
+
+        int retval;
+        if (arguments->entity == Q12_ENTITY_FLIGHTS)
+            retval = flight_manager_iter_columns(database_get_flights(database),
+                                                 __q12_execute_flights_callback,
+                                                 &data);
+        else
+            retval = reservation_manager_iter_columns(database_get_reservations(database),
+                                                      __q12_execute_reservations_callback,
+                                                      &data);
+
+        if (!retval && data.ids)
+            retval = __q12_output_matches(&data,
+                                          arguments->entity == Q12_ENTITY_FLIGHTS
+                                              ? flight_id_sprintf
+                                              : reservation_id_sprintf);
+        if (data.ids)
+            g_array_unref(data.ids);
+        if (retval)
+            return 1;
+    }
+
+    if (!arguments->ids) {
+        query_writer_write_new_object(output);
+        query_writer_write_new_field_unsigned(output, "count", data.count);
+    }
+    return 0;
+}
+
+query_type_t *q12_create(void) {
+    return query_type_create(12,
+                             __q12_parse_arguments,
+                             __q12_clone_arguments,
+                             __q12_free_arguments,
+                             __q12_save_arguments,
+                             __q12_load_arguments,
+                             NULL,
+                             NULL,
+                             NULL,
+                             0,
+                             NULL,
+                             q12_execute,
+                             NULL,
+                             NULL,
+                             DATABASE_INDEX_SET(DATABASE_INDEX_USER_BITMAPS) |
+                                 DATABASE_INDEX_SET(DATABASE_INDEX_FLIGHT_COLUMNS) |
+                                 DATABASE_INDEX_SET(DATABASE_INDEX_RESERVATION_COLUMNS));
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  q13.c
+ * @brief Implementation of methods in include/queries/q13.h
+ */
+
+#include "queries/q13.h"
+#include "queries/query_instance.h"
+
+/**
+ * @brief   Parses the arguments of a query of type 13.
+ * @details Asserts that there's only one argument, a flight identifier.
+ *
+ * @param allocator Not used (no strings are stored).
+ * @param output    Where to write the parsed ::flight_id_t to.
+ * @param argc      Number of arguments.
+ * @param argv      Values of the arguments.
+ *
+ * @retval 0 Success.
+ * @retval 1 Invalid arguments.
+ */
+int __q13_parse_arguments(string_pool_t *allocator,
+                          void          *output,
+                          size_t         argc,
+                          char *const    argv[argc]) {
+    (void) allocator;
+    if (argc != 1)
+        return 1;
+
+    return flight_id_from_string(output, argv[0]);
+}
+
+int q13_execute(const database_t       *database,
+                const void             *statistics,
+                const query_instance_t *instance,
+                query_writer_t         *output) {
+    (void) statistics;
+
+    const flight_id_t flight_id = *(const flight_id_t *) query_instance_get_argument_data(instance);
+
+    const user_manager_t *const users = database_get_users(database);
+
+    const user_ordinal_t *passengers;
+    size_t                npassengers;
+    if (user_manager_get_passengers_by_flight(users, flight_id, &passengers, &npassengers))
+        return 1;
+
+    /* Only look at the passengers in the requested page */
+    const size_t offset = query_instance_get_offset(instance);
+    query_writer_skip_objects(output, offset < npassengers ? offset : npassengers);
+    for (size_t i = offset; i < npassengers && !query_writer_is_page_full(output); ++i) {
+        const user_t *const user = user_manager_get_by_ordinal(users, passengers[i]);
+
+        query_writer_write_new_object(output);
+        query_writer_write_new_field_string(output, "id", user_get_const_id(user));
+        query_writer_write_new_field_string(output, "name", user_get_const_name(user));
+    }
+    return 0;
+}
+
+/**
+ * @brief   Counts the passengers in the output of a query of type 13.
+ * @details The passengers of each flight are contiguous in the index of passengers, so this is a
+ *          constant time operation (once the index is built).
+ *
+ * @param database   Database to get data from.
+ * @param statistics Not used (no statistical data is generated for this query).
+ * @param instance   Query instance whose passengers are to be counted.
+ *
+ * @return The number of passengers of the flight of @p instance (`0` on allocation failure).
+ */
+size_t __q13_count_results(const database_t       *database,
+                           const void             *statistics,
+                           const query_instance_t *instance) {
+    (void) statistics;
+
+    const flight_id_t flight_id = *(const flight_id_t *) query_instance_get_argument_data(instance);
+
+    const user_ordinal_t *passengers;
+    size_t                npassengers;
+    if (user_manager_get_passengers_by_flight(database_get_users(database),
+                                              flight_id,
+                                              &passengers,
+                                              &npassengers))
+        return 0;
+    return npassengers;
+}
+
+query_type_t *q13_create(void) {
+    return query_type_create(13,
+                             __q13_parse_arguments,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL,
+                             0,
+                             NULL,
+                             q13_execute,
+                             __q13_count_results,
+                             NULL,
+                             DATABASE_INDEX_SET(DATABASE_INDEX_USER_PASSENGERS));
+}
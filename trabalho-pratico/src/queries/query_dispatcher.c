@@ -22,13 +22,23 @@
  * See [the header file's documentation](@ref query_dispatcher_examples).
  */
 
+#include <glib.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "queries/query_dispatcher.h"
+#include "testing/event_trace.h"
+#include "utils/glib/GConstKeyHashTable.h"
+#include "utils/int_utils.h"
+#include "utils/scratch_arena.h"
+#include "utils/task_scheduler.h"
+#include "utils/thread_count.h"
 
-int query_dispatcher_dispatch_single(const database_t       *database,
-                                     const query_instance_t *query_instance,
-                                     query_writer_t         *output) {
+int query_dispatcher_dispatch_single(const database_t         *database,
+                                     query_statistics_cache_t *cache,
+                                     const query_instance_t   *query_instance,
+                                     query_writer_t           *output) {
 
     query_instance_list_t *const list = query_instance_list_create();
     if (!list)
@@ -39,11 +49,88 @@ int query_dispatcher_dispatch_single(const database_t       *database,
         return 1;
     }
 
-    query_dispatcher_dispatch_list(database, list, &output, NULL);
+    query_dispatcher_dispatch_list(database, cache, list, &output, 1, NULL);
     query_instance_list_free(list);
     return 0;
 }
 
+/** @brief A manager in the database that can be iterated through in a ::query_type_scan_t. */
+typedef enum {
+    QUERY_DISPATCHER_MANAGER_USERS,        /**< ::query_type_scan_t::foreach_user */
+    QUERY_DISPATCHER_MANAGER_FLIGHTS,      /**< ::query_type_scan_t::foreach_flights */
+    QUERY_DISPATCHER_MANAGER_RESERVATIONS, /**< ::query_type_scan_t::foreach_reservations */
+    QUERY_DISPATCHER_NUMBER_OF_MANAGERS    /**< Not a manager, just the number of managers. */
+} query_dispatcher_manager_t;
+
+/**
+ * @struct query_dispatcher_date_range_t
+ * @brief  Dates that iterations through flights and reservations are restricted to.
+ *
+ * @var query_dispatcher_date_range_t::bounded
+ *     @brief Whether iterations are restricted at all (if not, the other fields aren't used).
+ * @var query_dispatcher_date_range_t::begin
+ *     @brief First date (inclusive) of the range.
+ * @var query_dispatcher_date_range_t::end
+ *     @brief Last date (inclusive) of the range.
+ */
+typedef struct {
+    int    bounded;
+    date_t begin, end;
+} query_dispatcher_date_range_t;
+
+/**
+ * @struct query_dispatcher_group_t
+ * @brief  A set of queries of the same type, that share the same statistical data.
+ *
+ * @var query_dispatcher_group_t::instances
+ *     @brief Queries in the group.
+ * @var query_dispatcher_group_t::n
+ *     @brief Number of queries in ::query_dispatcher_group_t::instances.
+ * @var query_dispatcher_group_t::first_output
+ *     @brief Index of the output of the first query in the group.
+ * @var query_dispatcher_group_t::scan
+ *     @brief How to generate statistical data by iterating through the database (`NULL` if the
+ *            query type doesn't support it).
+ * @var query_dispatcher_group_t::statistics
+ *     @brief   Statistical data generated for the queries in the group.
+ *     @details While scanning the database, this is the `scan_data` of ::query_type_scan_t.
+ * @var query_dispatcher_group_t::partials
+ *     @brief   Partial statistical data (see ::query_type_scan_t::partial_begin) of each thread,
+ *              for every manager iterated through in parallel.
+ *     @details Kept until the end of the scan, when it's merged into
+ *              ::query_dispatcher_group_t::statistics. Each manager has its own array, so that
+ *              concurrent iterations through different managers don't modify the same data.
+ * @var query_dispatcher_group_t::npartials
+ *     @brief Number of elements in each array of ::query_dispatcher_group_t::partials.
+ * @var query_dispatcher_group_t::failed
+ *     @brief Whether generating statistical data failed, and the queries must not be executed.
+ * @var query_dispatcher_group_t::cached
+ *     @brief Whether ::query_dispatcher_group_t::statistics is owned by a
+ *            ::query_statistics_cache_t, and must not be generated nor freed.
+ * @var query_dispatcher_group_t::indexed
+ *     @brief Whether the queries are answered from indexes, without statistical data (see
+ *            ::query_type_scan_t::index_cost).
+ * @var query_dispatcher_group_t::dates
+ *     @brief Dates the scan of the group can be restricted to (see
+ *            ::query_type_scan_t::date_range).
+ * @var query_dispatcher_group_t::deferred
+ *     @brief   Whether the group's statistical data would go over the memory budget (see
+ *              ::query_dispatcher_set_statistics_budget).
+ *     @details These queries are only run after all others, in smaller groups (see
+ *              ::__query_dispatcher_run_deferred).
+ */
+typedef struct {
+    const query_instance_t *const *instances;
+    size_t                         n, first_output;
+    const query_type_scan_t       *scan;
+    void                          *statistics;
+    void                         **partials[QUERY_DISPATCHER_NUMBER_OF_MANAGERS];
+    size_t                         npartials[QUERY_DISPATCHER_NUMBER_OF_MANAGERS];
+    int                            failed, cached, indexed;
+    query_dispatcher_date_range_t  dates;
+    int                            deferred;
+} query_dispatcher_group_t;
+
 /**
  * @struct query_dispatcher_data_t
  * @brief  Data needed while dispatching a list of queries.
@@ -52,82 +139,1740 @@ int query_dispatcher_dispatch_single(const database_t       *database,
  *     @brief Database, so that queries can access data.
  * @var query_dispatcher_data_t::outputs
  *     @brief Where to output query results to.
- * @var query_dispatcher_data_t::i
- *     @brief Number of queries processed until now.
  * @var query_dispatcher_data_t::metrics
  *     @brief Performance metrics where to write profiling information to.
+ * @var query_dispatcher_data_t::progress
+ *     @brief Where to report progress to. Can be `NULL`.
+ * @var query_dispatcher_data_t::costs
+ *     @brief Measured costs of query types. Can be `NULL`.
+ * @var query_dispatcher_data_t::topology
+ *     @brief NUMA nodes to pin worker threads to. Can be `NULL`.
+ * @var query_dispatcher_data_t::groups
+ *     @brief   Sets of queries of the same type (::query_dispatcher_group_t).
+ *     @details There's, at most, one group per query type, so there are always few groups.
+ * @var query_dispatcher_data_t::ninstances
+ *     @brief Total number of queries in all groups.
+ * @var query_dispatcher_data_t::originals
+ *     @brief   Index of the output of the first occurrence of each query (the query's own index
+ *              for queries that aren't repeated).
+ *     @details Repeated queries are only executed once, and the other outputs are linked to the
+ *              original one. `NULL` if repeated queries weren't looked for.
+ * @var query_dispatcher_data_t::fuse_scans
+ *     @brief   Whether iterations through the database of different query types are shared.
+ *     @details When profiling, this isn't done, so that the time taken to generate statistics can
+ *              be attributed to each query type.
+ * @var query_dispatcher_data_t::scan_nthreads
+ *     @brief Number of threads each iteration through a manager can be split across.
+ * @var query_dispatcher_data_t::split_queries
+ *     @brief   Whether the execution of queries with large outputs can be split across multiple
+ *              tasks (see ::query_type_count_results_callback_t).
+ *     @details When profiling, this isn't done, so that executions can be measured one at a time.
+ * @var query_dispatcher_data_t::group_order
+ *     @brief   Indices of groups in ::query_dispatcher_data_t::groups, from the one with the most
+ *              expensive statistical data to generate to the cheapest.
+ *     @details `NULL` on allocation failure, for groups to be processed in their original order.
+ * @var query_dispatcher_data_t::query_order
+ *     @brief   Indices of the outputs of all queries, from the group of queries that takes the
+ *              longest to execute to the quickest.
+ *     @details `NULL` on allocation failure, for queries to be executed in their original order.
+ * @var query_dispatcher_data_t::chunk
+ *     @brief Part of a deferred group (see ::query_dispatcher_group_t::deferred) whose queries
+ *            are being executed.
  */
 typedef struct {
-    const database_t *const      database;
-    query_writer_t *const *const outputs;
-    size_t                       i;
-    performance_metrics_t *const metrics;
+    const database_t *const               database;
+    query_writer_t *const *const          outputs;
+    performance_metrics_t *const          metrics;
+    query_dispatcher_progress_t *const    progress;
+    const query_dispatcher_costs_t *const costs;
+    const numa_topology_t *const          topology;
+
+    GArray *const groups;
+    size_t        ninstances;
+    size_t       *originals;
+    int           fuse_scans;
+    size_t        scan_nthreads;
+    int           split_queries;
+    size_t       *group_order, *query_order;
+
+    const query_dispatcher_group_t *chunk;
 } query_dispatcher_data_t;
 
 /**
- * @brief Gets called for each set of queries of the same type, to execute them.
+ * @brief Gets called for each set of queries of the same type, to store them as a group.
  *
  * @param user_data A pointer to a ::query_dispatcher_data_t.
- * @param n         Number of queries to be processed.
- * @param instances Queries of the same type to be processed.
+ * @param n         Number of queries in the set.
+ * @param instances Queries of the same type.
  *
- * @return Always `0`, even on failure. No query execution failures shall halt the program.
+ * @retval 0 Always successful.
  */
 int __query_dispatcher_query_set_callback(void                         *user_data,
                                           size_t                        n,
                                           const query_instance_t *const instances[n]) {
     query_dispatcher_data_t *const dispatcher_data = user_data;
 
-    const query_type_t *const type     = query_instance_get_type(instances[0]);
+    const query_dispatcher_group_t group = {
+        .instances    = instances,
+        .n            = n,
+        .first_output = dispatcher_data->ninstances,
+        .scan         = query_type_get_scan(query_instance_get_type(instances[0])),
+        .statistics   = NULL,
+        .partials     = {NULL},
+        .npartials    = {0},
+        .failed       = 0,
+        .cached       = 0,
+        .indexed      = 0,
+        .dates        = {.bounded = 0, .begin = 0, .end = 0},
+        .deferred     = 0};
+    g_array_append_val(dispatcher_data->groups, group);
+    dispatcher_data->ninstances += n;
+    return 0;
+}
+
+/**
+ * @struct query_dispatcher_scan_t
+ * @brief  Query types whose iteration callbacks are called in a single pass over a manager.
+ *
+ * @var query_dispatcher_scan_t::groups
+ *     @brief Groups of queries whose iteration callbacks haven't stopped iteration yet.
+ * @var query_dispatcher_scan_t::data
+ *     @brief `user_data` for the iteration callbacks of each group in
+ *            ::query_dispatcher_scan_t::groups (`scan_data` or partial data).
+ * @var query_dispatcher_scan_t::n
+ *     @brief Number of elements in ::query_dispatcher_scan_t::groups and
+ *            ::query_dispatcher_scan_t::data.
+ */
+typedef struct {
+    query_dispatcher_group_t **groups;
+    void                     **data;
+    size_t                     n;
+} query_dispatcher_scan_t;
+
+/**
+ * @brief Removes a group of queries from a scan, after it orders iteration to stop.
+ *
+ * @param scan Scan to be modified.
+ * @param i    Index of the group in ::query_dispatcher_scan_t::groups.
+ */
+void __query_dispatcher_scan_remove(query_dispatcher_scan_t *scan, size_t i) {
+    --scan->n;
+    scan->groups[i] = scan->groups[scan->n];
+    scan->data[i]   = scan->data[scan->n];
+}
+
+/**
+ * @brief Calls ::query_type_scan_t::foreach_user for every group of queries in a scan.
+ *
+ * @param user_data A pointer to a ::query_dispatcher_scan_t.
+ * @param user      User being processed.
+ *
+ * @retval 0 Continue iteration.
+ * @retval 1 All query types stopped iteration.
+ */
+int __query_dispatcher_scan_user(void *user_data, const user_t *user) {
+    query_dispatcher_scan_t *const scan = user_data;
+
+    for (size_t i = 0; i < scan->n;) {
+        query_dispatcher_group_t *const group = scan->groups[i];
+        if (group->scan->foreach_user(scan->data[i], user))
+            __query_dispatcher_scan_remove(scan, i); /* Stop iteration for this query type */
+        else
+            ++i;
+    }
+    return scan->n == 0;
+}
+
+/**
+ * @brief Calls ::query_type_scan_t::foreach_user for every user in a group of users.
+ *
+ * @param user_data A pointer to a ::query_dispatcher_scan_t.
+ * @param users     Users being processed.
+ * @param n         Number of users in @p users.
+ *
+ * @retval 0 Continue iteration.
+ * @retval 1 All query types stopped iteration.
+ */
+int __query_dispatcher_scan_users(void *user_data, const user_t *const *users, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        if (__query_dispatcher_scan_user(user_data, users[i]))
+            return 1;
+    return 0;
+}
+
+/**
+ * @brief Calls ::query_type_scan_t::foreach_flights for every group of queries in a scan.
+ *
+ * @param user_data A pointer to a ::query_dispatcher_scan_t.
+ * @param columns   Block of flights being processed.
+ * @param n         Number of flights in @p columns.
+ *
+ * @retval 0 Continue iteration.
+ * @retval 1 All query types stopped iteration.
+ */
+int __query_dispatcher_scan_flights(void                           *user_data,
+                                    const flight_manager_columns_t *columns,
+                                    size_t                          n) {
+    query_dispatcher_scan_t *const scan = user_data;
+
+    for (size_t i = 0; i < scan->n;) {
+        query_dispatcher_group_t *const group = scan->groups[i];
+        if (group->scan->foreach_flights(scan->data[i], columns, n))
+            __query_dispatcher_scan_remove(scan, i); /* Stop iteration for this query type */
+        else
+            ++i;
+    }
+    return scan->n == 0;
+}
+
+/**
+ * @brief Calls ::query_type_scan_t::foreach_reservations for every group of queries in a scan.
+ *
+ * @param user_data A pointer to a ::query_dispatcher_scan_t.
+ * @param columns   Block of reservations being processed.
+ * @param n         Number of reservations in @p columns.
+ *
+ * @retval 0 Continue iteration.
+ * @retval 1 All query types stopped iteration.
+ */
+int __query_dispatcher_scan_reservations(void                                *user_data,
+                                         const reservation_manager_columns_t *columns,
+                                         size_t                               n) {
+    query_dispatcher_scan_t *const scan = user_data;
+
+    for (size_t i = 0; i < scan->n;) {
+        query_dispatcher_group_t *const group = scan->groups[i];
+        if (group->scan->foreach_reservations(scan->data[i], columns, n))
+            __query_dispatcher_scan_remove(scan, i); /* Stop iteration for this query type */
+        else
+            ++i;
+    }
+    return scan->n == 0;
+}
+
+/**
+ * @brief Checks if a ::query_type_scan_t has an iteration callback for a manager.
+ *
+ * @param type_scan Scan of a query type. Can be `NULL`.
+ * @param manager   Manager that may be iterated through.
+ *
+ * @retval 0 @p type_scan doesn't iterate through @p manager.
+ * @retval 1 @p type_scan iterates through @p manager.
+ */
+int __query_dispatcher_scan_iterates_manager(const query_type_scan_t   *type_scan,
+                                             query_dispatcher_manager_t manager) {
+    if (!type_scan)
+        return 0;
+
+    return (manager == QUERY_DISPATCHER_MANAGER_USERS && type_scan->foreach_user) ||
+           (manager == QUERY_DISPATCHER_MANAGER_FLIGHTS && type_scan->foreach_flights) ||
+           (manager == QUERY_DISPATCHER_MANAGER_RESERVATIONS && type_scan->foreach_reservations);
+}
+
+/**
+ * @brief Widens a range of dates, so that it also covers the dates needed by a group of queries.
+ *
+ * @param range Range to be widened. Must start with `begin > end` if it's still empty.
+ * @param group Group of queries, whose ::query_dispatcher_group_t::dates are added to @p range.
+ */
+void __query_dispatcher_date_range_add(query_dispatcher_date_range_t  *range,
+                                       const query_dispatcher_group_t *group) {
+    if (!group->dates.bounded) {
+        range->bounded = 0;
+    } else {
+        range->begin = min(range->begin, group->dates.begin);
+        range->end   = max(range->end, group->dates.end);
+    }
+}
+
+/**
+ * @brief Iterates through a manager in the calling thread.
+ *
+ * @param database Database containing the manager to be iterated through.
+ * @param manager  Manager to be iterated through.
+ * @param dates    Dates flights and reservations can be restricted to.
+ * @param scan     Groups of queries to call iteration callbacks for.
+ */
+void __query_dispatcher_iterate(const database_t                    *database,
+                                query_dispatcher_manager_t           manager,
+                                const query_dispatcher_date_range_t *dates,
+                                query_dispatcher_scan_t             *scan) {
+
+    const flight_manager_t *const      flights      = database_get_flights(database);
+    const reservation_manager_t *const reservations = database_get_reservations(database);
+
+    switch (manager) {
+        case QUERY_DISPATCHER_MANAGER_USERS:
+            user_manager_iter(database_get_users(database), __query_dispatcher_scan_user, scan);
+            break;
+        case QUERY_DISPATCHER_MANAGER_FLIGHTS:
+            if (dates->bounded)
+                flight_manager_iter_columns_between(flights,
+                                                    dates->begin,
+                                                    dates->end,
+                                                    __query_dispatcher_scan_flights,
+                                                    scan);
+            else
+                flight_manager_iter_columns(flights, __query_dispatcher_scan_flights, scan);
+            break;
+        case QUERY_DISPATCHER_MANAGER_RESERVATIONS:
+            if (dates->bounded)
+                reservation_manager_iter_columns_between(reservations,
+                                                         dates->begin,
+                                                         dates->end,
+                                                         __query_dispatcher_scan_reservations,
+                                                         scan);
+            else
+                reservation_manager_iter_columns(reservations,
+                                                 __query_dispatcher_scan_reservations,
+                                                 scan);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Iterates through a manager, splitting it across multiple threads.
+ *
+ * @param database Database containing the manager to be iterated through.
+ * @param manager  Manager to be iterated through.
+ * @param dates    Dates flights and reservations can be restricted to.
+ * @param nthreads Number of threads to split the iteration across.
+ * @param scans    Pointers to the ::query_dispatcher_scan_t of each thread.
+ */
+void __query_dispatcher_iterate_parallel(const database_t                    *database,
+                                         query_dispatcher_manager_t           manager,
+                                         const query_dispatcher_date_range_t *dates,
+                                         size_t                               nthreads,
+                                         void *const                         *scans) {
+
+    const flight_manager_t *const      flights      = database_get_flights(database);
+    const reservation_manager_t *const reservations = database_get_reservations(database);
+
+    switch (manager) {
+        case QUERY_DISPATCHER_MANAGER_USERS:
+            user_manager_iter_blocks_parallel(database_get_users(database),
+                                              nthreads,
+                                              __query_dispatcher_scan_users,
+                                              scans);
+            break;
+        case QUERY_DISPATCHER_MANAGER_FLIGHTS:
+            if (dates->bounded)
+                flight_manager_iter_columns_between_parallel(flights,
+                                                             dates->begin,
+                                                             dates->end,
+                                                             nthreads,
+                                                             __query_dispatcher_scan_flights,
+                                                             scans);
+            else
+                flight_manager_iter_columns_parallel(flights,
+                                                     nthreads,
+                                                     __query_dispatcher_scan_flights,
+                                                     scans);
+            break;
+        case QUERY_DISPATCHER_MANAGER_RESERVATIONS:
+            if (dates->bounded)
+                reservation_manager_iter_columns_between_parallel(
+                    reservations,
+                    dates->begin,
+                    dates->end,
+                    nthreads,
+                    __query_dispatcher_scan_reservations,
+                    scans);
+            else
+                reservation_manager_iter_columns_parallel(reservations,
+                                                          nthreads,
+                                                          __query_dispatcher_scan_reservations,
+                                                          scans);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief   Creates the partial statistical data of every thread, for a group of queries that will
+ *          iterate through a manager in parallel.
+ * @details Partial data is stored in ::query_dispatcher_group_t::partials, even on failure, so that
+ *          it's freed when merged.
+ *
+ * @param database Database, so that partial statistical data can be generated.
+ * @param manager  Manager that will be iterated through.
+ * @param group    Group of queries with ::query_type_scan_t::partial_begin.
+ * @param nthreads Number of threads the iteration will be split across.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure (@p group must iterate through @p manager in a single thread).
+ */
+int __query_dispatcher_begin_partials(const database_t          *database,
+                                      query_dispatcher_manager_t manager,
+                                      query_dispatcher_group_t  *group,
+                                      size_t                     nthreads) {
+
+    void **const partials = malloc(sizeof(void *) * nthreads);
+    if (!partials)
+        return 1;
+
+    group->partials[manager]  = partials;
+    group->npartials[manager] = 0;
+    for (size_t i = 0; i < nthreads; ++i) {
+        partials[i] = group->scan->partial_begin(database, group->n, group->instances);
+        if (!partials[i])
+            return 1;
+        group->npartials[manager]++;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Iterates through a manager once, for all groups of queries that need to do so.
+ * @details Groups whose ::query_type_scan_t supports partial statistical data iterate through
+ *          @p manager in a separate pass, split across @p nthreads threads. Their partial data is
+ *          only merged in ::__query_dispatcher_end_scan.
+ *
+ * @param database Database containing the manager to be iterated through.
+ * @param manager  Manager to be iterated through.
+ * @param n        Number of groups in @p groups.
+ * @param groups   Groups of queries. Those without a ::query_type_scan_t, without an iteration
+ *                 callback for @p manager, or whose ::query_type_scan_t::begin failed are ignored.
+ * @param nthreads Number of threads the iteration can be split across.
+ */
+void __query_dispatcher_scan_manager(const database_t          *database,
+                                     query_dispatcher_manager_t manager,
+                                     size_t                     n,
+                                     query_dispatcher_group_t   groups[n],
+                                     size_t                     nthreads) {
+    if (n == 0)
+        return;
+
+    query_dispatcher_group_t *scan_groups[n];
+    void                     *scan_data[n];
+    query_dispatcher_scan_t   scan = {.groups = scan_groups, .data = scan_data, .n = 0};
+
+    query_dispatcher_group_t *parallel_groups[n];
+    size_t                    nparallel = 0;
+
+    /* Start with empty ranges, widened by every group */
+    query_dispatcher_date_range_t dates          = {.bounded = 1, .begin = UINT32_MAX, .end = 0};
+    query_dispatcher_date_range_t parallel_dates = dates;
+
+    for (size_t i = 0; i < n; ++i) {
+        query_dispatcher_group_t *const group = groups + i;
+        if (!group->statistics || !__query_dispatcher_scan_iterates_manager(group->scan, manager))
+            continue;
+
+        if (nthreads > 1 && group->scan->partial_begin && group->scan->merge &&
+            !__query_dispatcher_begin_partials(database, manager, group, nthreads)) {
+
+            parallel_groups[nparallel++] = group;
+            __query_dispatcher_date_range_add(&parallel_dates, group);
+        } else {
+            scan.groups[scan.n] = group;
+            scan.data[scan.n++] = group->statistics;
+            __query_dispatcher_date_range_add(&dates, group);
+        }
+    }
+
+    if (scan.n)
+        __query_dispatcher_iterate(database, manager, &dates, &scan);
+
+    if (nparallel) {
+        query_dispatcher_group_t *thread_groups[nthreads][nparallel];
+        void                     *thread_data[nthreads][nparallel];
+        query_dispatcher_scan_t   thread_scans[nthreads];
+        void                     *thread_scan_pointers[nthreads];
+
+        for (size_t t = 0; t < nthreads; ++t) {
+            for (size_t i = 0; i < nparallel; ++i) {
+                thread_groups[t][i] = parallel_groups[i];
+                thread_data[t][i]   = parallel_groups[i]->partials[manager][t];
+            }
+
+            thread_scans[t] = (query_dispatcher_scan_t){.groups = thread_groups[t],
+                                                        .data   = thread_data[t],
+                                                        .n      = nparallel};
+            thread_scan_pointers[t] = &thread_scans[t];
+        }
+
+        __query_dispatcher_iterate_parallel(database,
+                                            manager,
+                                            &parallel_dates,
+                                            nthreads,
+                                            thread_scan_pointers);
+    }
+}
+
+/**
+ * @brief Calls ::query_type_scan_t::end for a group of queries, after all database iterations.
+ *
+ * @param database Database, so that statistical data can be generated.
+ * @param group    Group of queries with a ::query_type_scan_t.
+ */
+void __query_dispatcher_end_scan(const database_t *database, query_dispatcher_group_t *group) {
+    for (size_t i = 0; i < QUERY_DISPATCHER_NUMBER_OF_MANAGERS; ++i) {
+        for (size_t j = 0; j < group->npartials[i]; ++j)
+            if (group->scan->merge(group->statistics, group->partials[i][j]))
+                group->failed = 1;
+
+        free(group->partials[i]);
+        group->partials[i]  = NULL;
+        group->npartials[i] = 0;
+    }
+
+    if (group->statistics && group->scan->end)
+        group->statistics = group->scan->end(database, group->statistics);
+
+    group->failed = group->failed || !group->statistics; /* Query statistical failure */
+}
+
+/**
+ * @brief Gets the position of a task in the order work is meant to be done in.
+ *
+ * @param order Order of tasks (see ::query_dispatcher_data_t::group_order). Can be `NULL`.
+ * @param i     Index of the task, as run by the ::task_scheduler_t.
+ *
+ * @return `order[i]`, or @p i if @p order is `NULL`.
+ */
+size_t __query_dispatcher_get_ordered(const size_t *order, size_t i) {
+    return order ? order[i] : i;
+}
+
+/**
+ * @brief   Generates the statistical data for a group of queries.
+ * @details When scans are fused (see ::query_dispatcher_data_t::fuse_scans), only
+ *          ::query_type_scan_t::begin is called for groups of queries with a ::query_type_scan_t.
+ *
+ * @param scheduler Scheduler running the task (not used).
+ * @param worker    Worker running the task (not used).
+ * @param user_data A pointer to a ::query_dispatcher_data_t.
+ * @param i         Position of the group in ::query_dispatcher_data_t::group_order.
+ */
+void __query_dispatcher_generate_statistics(task_scheduler_t *scheduler,
+                                            size_t            worker,
+                                            void             *user_data,
+                                            size_t            i) {
+    (void) scheduler;
+    (void) worker;
+    query_dispatcher_data_t *const  dispatcher_data = user_data;
+    query_dispatcher_group_t *const group =
+        &g_array_index(dispatcher_data->groups,
+                       query_dispatcher_group_t,
+                       __query_dispatcher_get_ordered(dispatcher_data->group_order, i));
+    if (group->cached || group->indexed || group->deferred)
+        return;
+
+    const query_type_t *const type     = query_instance_get_type(group->instances[0]);
     const size_t              type_num = query_type_get_type_number(type);
 
     const query_type_generate_statistics_callback_t generate_stats =
         query_type_get_generate_statistics_callback(type);
-    const query_type_free_statistics_callback_t free_stats =
-        query_type_get_free_statistics_callback(type);
-    const query_type_execute_callback_t execute = query_type_get_execute_callback(type);
-
-    void *statistics = NULL;
-    if (generate_stats) {
-        performance_metrics_start_measuring_query_statistics(dispatcher_data->metrics, type_num);
-        statistics = generate_stats(dispatcher_data->database, n, instances);
-        performance_metrics_stop_measuring_query_statistics(dispatcher_data->metrics, type_num);
-
-        if (!statistics)
-            return 0; /* Query statistical failure */
-    }
-
-    for (size_t j = 0; j < n; ++j) {
-        const size_t line = query_instance_get_line_in_file(instances[j]);
-
-        performance_metrics_start_measuring_query_execution(dispatcher_data->metrics,
-                                                            type_num,
-                                                            line);
-        execute(dispatcher_data->database,
-                statistics,
-                instances[j],
-                dispatcher_data->outputs[dispatcher_data->i + j]); /* Ignore returned result */
-        performance_metrics_stop_measuring_query_execution(dispatcher_data->metrics,
-                                                           type_num,
-                                                           line);
-    }
-    dispatcher_data->i += n;
-
-    if (free_stats)
-        free_stats(statistics);
+    if (!group->scan && !generate_stats)
+        return;
+
+    event_trace_begin("statistics", "query", type_num);
+    performance_metrics_start_measuring_query_statistics(dispatcher_data->metrics, type_num);
+    if (group->scan) {
+        group->statistics =
+            group->scan->begin(dispatcher_data->database, group->n, group->instances);
+
+        if (!dispatcher_data->fuse_scans) {
+            for (size_t j = 0; j < QUERY_DISPATCHER_NUMBER_OF_MANAGERS; ++j)
+                __query_dispatcher_scan_manager(dispatcher_data->database,
+                                                j,
+                                                1,
+                                                group,
+                                                dispatcher_data->scan_nthreads);
+            __query_dispatcher_end_scan(dispatcher_data->database, group);
+        }
+    } else {
+        group->statistics = generate_stats(dispatcher_data->database, group->n, group->instances);
+        group->failed     = !group->statistics; /* Query statistical failure */
+    }
+    performance_metrics_stop_measuring_query_statistics(dispatcher_data->metrics, type_num);
+    event_trace_end();
+}
+
+/**
+ * @brief Iterates through a manager once, for all groups of queries that need to do so.
+ *
+ * @param scheduler Scheduler running the task (not used).
+ * @param worker    Worker running the task (not used).
+ * @param user_data A pointer to a ::query_dispatcher_data_t.
+ * @param i         Manager to iterate through (::query_dispatcher_manager_t).
+ */
+void __query_dispatcher_fused_scan(task_scheduler_t *scheduler,
+                                   size_t            worker,
+                                   void             *user_data,
+                                   size_t            i) {
+    (void) scheduler;
+    (void) worker;
+    query_dispatcher_data_t *const dispatcher_data = user_data;
+
+    event_trace_begin("statistics", "fused scan", i + 1);
+    __query_dispatcher_scan_manager(dispatcher_data->database,
+                                    i,
+                                    dispatcher_data->groups->len,
+                                    (query_dispatcher_group_t *) dispatcher_data->groups->data,
+                                    dispatcher_data->scan_nthreads);
+    event_trace_end();
+}
+
+/**
+ * @brief Finishes generating the statistical data for a group of queries, after fused scans.
+ *
+ * @param scheduler Scheduler running the task (not used).
+ * @param worker    Worker running the task (not used).
+ * @param user_data A pointer to a ::query_dispatcher_data_t.
+ * @param i         Position of the group in ::query_dispatcher_data_t::group_order.
+ */
+void __query_dispatcher_end_fused_scan(task_scheduler_t *scheduler,
+                                       size_t            worker,
+                                       void             *user_data,
+                                       size_t            i) {
+    (void) scheduler;
+    (void) worker;
+    query_dispatcher_data_t *const  dispatcher_data = user_data;
+    query_dispatcher_group_t *const group =
+        &g_array_index(dispatcher_data->groups,
+                       query_dispatcher_group_t,
+                       __query_dispatcher_get_ordered(dispatcher_data->group_order, i));
+
+    if (group->scan && !group->deferred)
+        __query_dispatcher_end_scan(dispatcher_data->database, group);
+}
+
+/**
+ * @brief Gets the group of queries a query belongs to.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param i               Index of the query's output in ::query_dispatcher_data_t::outputs.
+ *
+ * @return The group containing the query.
+ */
+const query_dispatcher_group_t *
+    __query_dispatcher_get_group(const query_dispatcher_data_t *dispatcher_data, size_t i) {
+    const query_dispatcher_group_t *group = NULL;
+    for (size_t j = 0; j < dispatcher_data->groups->len; ++j) {
+        group = &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, j);
+        if (i < group->first_output + group->n)
+            break;
+    }
+    return group;
+}
+
+/**
+ * @brief Minimum number of objects in each chunk of the output of a query, when its execution is
+ *        split across multiple tasks.
+ */
+#define QUERY_DISPATCHER_CHUNK_OBJECTS 4096
+
+/**
+ * @struct  query_dispatcher_split_t
+ * @brief   A query whose execution is split across multiple tasks, each outputting a chunk of its
+ *          results.
+ * @details Tasks can't wait for each other, so the last chunk to be executed is the one that
+ *          appends all chunks to the query's output.
+ *
+ * @var query_dispatcher_split_t::dispatcher_data
+ *     @brief Data about the queries being dispatched.
+ * @var query_dispatcher_split_t::group
+ *     @brief Group the query belongs to.
+ * @var query_dispatcher_split_t::output
+ *     @brief Index of the query's output in ::query_dispatcher_data_t::outputs.
+ * @var query_dispatcher_split_t::nchunks
+ *     @brief Number of chunks the query's output was split into.
+ * @var query_dispatcher_split_t::instances
+ *     @brief Clone of the query for each chunk, whose page is the chunk's range of objects.
+ * @var query_dispatcher_split_t::chunks
+ *     @brief Where each chunk is outputted to.
+ * @var query_dispatcher_split_t::remaining
+ *     @brief Number of chunks that haven't been executed yet.
+ */
+typedef struct {
+    query_dispatcher_data_t        *dispatcher_data;
+    const query_dispatcher_group_t *group;
+    size_t                          output, nchunks;
+    query_instance_t              **instances;
+    query_writer_t                **chunks;
+    gint                            remaining;
+} query_dispatcher_split_t;
+
+/**
+ * @brief Frees the chunks and cloned queries of a query split across multiple tasks.
+ * @param split Query whose execution was split. Chunks and clones that are `NULL` are ignored.
+ */
+void __query_dispatcher_split_free(query_dispatcher_split_t *split) {
+    for (size_t k = 0; k < split->nchunks; ++k) {
+        if (split->chunks[k])
+            query_writer_free(split->chunks[k]);
+        if (split->instances[k])
+            query_instance_free(split->instances[k]);
+    }
+
+    free(split->chunks);
+    free(split->instances);
+    free(split);
+}
+
+/**
+ * @brief   Executes a chunk of a query split across multiple tasks.
+ * @details The task that executes the last chunk appends all chunks to the query's output, in
+ *          order, and closes it.
+ *
+ * @param scheduler Scheduler running the task (not used).
+ * @param worker    Worker running the task (not used).
+ * @param user_data A pointer to a ::query_dispatcher_split_t.
+ * @param k         Index of the chunk to be executed.
+ */
+void __query_dispatcher_execute_chunk(task_scheduler_t *scheduler,
+                                      size_t            worker,
+                                      void             *user_data,
+                                      size_t            k) {
+    (void) scheduler;
+    (void) worker;
+    query_dispatcher_split_t *const split           = user_data;
+    query_dispatcher_data_t *const  dispatcher_data = split->dispatcher_data;
+
+    const query_type_t *const type = query_instance_get_type(split->instances[k]);
+    event_trace_begin("execution", "query chunk", query_type_get_type_number(type));
+    query_type_list_execute(dispatcher_data->database,
+                            split->group->statistics,
+                            split->instances[k],
+                            split->chunks[k]); /* Ignore returned result */
+    scratch_arena_reset();
+    event_trace_end();
+
+    if (!g_atomic_int_dec_and_test(&split->remaining))
+        return;
+
+    query_writer_t *const output = dispatcher_data->outputs[split->output];
+    for (size_t j = 0; j < split->nchunks; ++j)
+        query_writer_append_chunk(output, split->chunks[j]);
+    query_writer_close(output); /* Write output file now, ignoring errors */
+
+    if (dispatcher_data->progress)
+        g_atomic_int_inc(&dispatcher_data->progress->done[query_type_get_type_number(type)]);
+    __query_dispatcher_split_free(split);
+}
+
+/**
+ * @brief   Splits the execution of a query with a large output across multiple tasks.
+ * @details Only queries whose type has a ::query_type_count_results_callback_t can be split. Each
+ *          chunk of the query's output is a page of results executed by a clone of the query, in a
+ *          new task. The query's output is closed once all chunks are executed.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param scheduler       Scheduler running the query's task.
+ * @param worker          Worker running the query's task.
+ * @param group           Group the query belongs to.
+ * @param i               Index of the query's output in ::query_dispatcher_data_t::outputs.
+ *
+ * @retval 0 Success (the query is being executed).
+ * @retval 1 The query can't (or is too small to) be split, or allocation failure. The query must
+ *           be executed normally.
+ */
+int __query_dispatcher_split_query(query_dispatcher_data_t        *dispatcher_data,
+                                   task_scheduler_t               *scheduler,
+                                   size_t                          worker,
+                                   const query_dispatcher_group_t *group,
+                                   size_t                          i) {
+
+    const query_instance_t *const instance = group->instances[i - group->first_output];
+    const query_type_count_results_callback_t count_results =
+        query_type_get_count_results_callback(query_instance_get_type(instance));
+    if (!count_results)
+        return 1;
+
+    /* Only objects in the query's page are split into chunks */
+    const size_t offset  = query_instance_get_offset(instance);
+    const size_t total   = count_results(dispatcher_data->database, group->statistics, instance);
+    const size_t objects = min(total - min(offset, total), query_instance_get_limit(instance));
+    const size_t nchunks = objects / QUERY_DISPATCHER_CHUNK_OBJECTS;
+    if (nchunks < 2)
+        return 1;
+
+    query_dispatcher_split_t *const split = malloc(sizeof(query_dispatcher_split_t));
+    if (!split)
+        return 1;
+
+    split->dispatcher_data = dispatcher_data;
+    split->group           = group;
+    split->output          = i;
+    split->nchunks         = nchunks;
+    split->instances       = calloc(nchunks, sizeof(query_instance_t *));
+    split->chunks          = calloc(nchunks, sizeof(query_writer_t *));
+    if (!split->instances || !split->chunks) {
+        __query_dispatcher_split_free(split);
+        return 1;
+    }
+
+    for (size_t k = 0; k < nchunks; ++k) {
+        const size_t begin = offset + objects * k / nchunks;
+        const size_t end   = offset + objects * (k + 1) / nchunks;
+
+        split->chunks[k]    = query_writer_create_chunk(dispatcher_data->outputs[i]);
+        split->instances[k] = query_instance_clone(NULL, NULL, instance);
+        if (!split->chunks[k] || !split->instances[k]) {
+            __query_dispatcher_split_free(split);
+            return 1;
+        }
+
+        query_instance_set_page(split->instances[k], begin, end - begin);
+        query_writer_set_page(split->chunks[k], begin, end - begin);
+        query_writer_reserve_objects(split->chunks[k], end - begin);
+    }
+
+    /* Run the first chunk in this task, while others can be stolen by idle workers */
+    g_atomic_int_set(&split->remaining, (gint) nchunks);
+    for (size_t k = 1; k < nchunks; ++k)
+        if (task_scheduler_spawn(scheduler, worker, __query_dispatcher_execute_chunk, split, k))
+            __query_dispatcher_execute_chunk(scheduler, worker, split, k);
+    __query_dispatcher_execute_chunk(scheduler, worker, split, 0);
     return 0;
 }
 
-void query_dispatcher_dispatch_list(const database_t      *database,
-                                    query_instance_list_t *query_instance_list,
-                                    query_writer_t *const *outputs,
-                                    performance_metrics_t *metrics) {
+/**
+ * @brief   Executes a query and writes its output.
+ * @details Auxiliary method for ::__query_dispatcher_run_query, kept apart so that the common case,
+ *          without performance metrics, doesn't have to consider them for every query.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param group           Group the query belongs to.
+ * @param instance        Query to be executed.
+ * @param i               Index of the query's output in ::query_dispatcher_data_t::outputs.
+ */
+void __query_dispatcher_execute_instance(const query_dispatcher_data_t  *dispatcher_data,
+                                         const query_dispatcher_group_t *group,
+                                         const query_instance_t         *instance,
+                                         size_t                          i) {
+    query_type_list_execute(dispatcher_data->database,
+                            group->statistics,
+                            instance,
+                            dispatcher_data->outputs[i]); /* Ignore returned result */
+    scratch_arena_reset();
+    query_writer_close(dispatcher_data->outputs[i]); /* Write output file now, ignoring errors */
+}
+
+/**
+ * @brief   Executes a single query, after checking that it can be executed.
+ * @details Queries with large outputs may have their execution split across multiple tasks (see
+ *          ::__query_dispatcher_split_query).
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param scheduler       Scheduler running the query's task. Can be `NULL`, for the query not to be
+ *                        split.
+ * @param worker          Worker running the query's task.
+ * @param group           Group the query belongs to.
+ * @param i               Index of the query's output in ::query_dispatcher_data_t::outputs.
+ */
+void __query_dispatcher_run_query(query_dispatcher_data_t        *dispatcher_data,
+                                  task_scheduler_t               *scheduler,
+                                  size_t                          worker,
+                                  const query_dispatcher_group_t *group,
+                                  size_t                          i) {
+    if (group->failed || group->deferred)
+        return;
+
+    query_dispatcher_progress_t *const progress = dispatcher_data->progress;
+    if (cancellation_check())
+        return;
+
+    if (scheduler && dispatcher_data->split_queries &&
+        !__query_dispatcher_split_query(dispatcher_data, scheduler, worker, group, i))
+        return;
+
+    const query_instance_t *const instance = group->instances[i - group->first_output];
+    const size_t type_num = query_type_get_type_number(query_instance_get_type(instance));
+
+    query_writer_set_page(dispatcher_data->outputs[i],
+                          query_instance_get_offset(instance),
+                          query_instance_get_limit(instance));
+    query_type_list_reserve_output(dispatcher_data->database,
+                                   group->statistics,
+                                   instance,
+                                   dispatcher_data->outputs[i]);
+
+    event_trace_begin("execution", "query", type_num);
+    performance_metrics_t *const metrics = dispatcher_data->metrics;
+    if (metrics) {
+        const size_t line = query_instance_get_line_in_file(instance);
+        performance_metrics_start_measuring_query_execution(metrics, type_num, line);
+        __query_dispatcher_execute_instance(dispatcher_data, group, instance, i);
+        performance_metrics_stop_measuring_query_execution(metrics, type_num, line);
+    } else {
+        __query_dispatcher_execute_instance(dispatcher_data, group, instance, i);
+    }
+    event_trace_end();
+
+    if (progress)
+        g_atomic_int_inc(&progress->done[type_num]);
+}
+
+/**
+ * @brief   Executes a single query.
+ * @details Repetitions of previous queries are skipped, and only handled by
+ *          ::__query_dispatcher_execute_repeated.
+ *
+ * @param scheduler Scheduler running the task.
+ * @param worker    Worker running the task.
+ * @param user_data A pointer to a ::query_dispatcher_data_t.
+ * @param i         Position of the query in ::query_dispatcher_data_t::query_order.
+ */
+void __query_dispatcher_execute(task_scheduler_t *scheduler,
+                                size_t            worker,
+                                void             *user_data,
+                                size_t            i) {
+    query_dispatcher_data_t *const dispatcher_data = user_data;
+
+    const size_t output = __query_dispatcher_get_ordered(dispatcher_data->query_order, i);
+    if (dispatcher_data->originals && dispatcher_data->originals[output] != output)
+        return;
+
+    __query_dispatcher_run_query(dispatcher_data,
+                                 scheduler,
+                                 worker,
+                                 __query_dispatcher_get_group(dispatcher_data, output),
+                                 output);
+}
+
+/**
+ * @brief   Outputs the result of a repetition of a previous query, after all other queries were
+ *          executed.
+ * @details The output file is linked to the one of the original query. If that's not possible,
+ *          the query is executed again.
+ *
+ * @param scheduler Scheduler running the task.
+ * @param worker    Worker running the task.
+ * @param user_data A pointer to a ::query_dispatcher_data_t.
+ * @param i         Index of the query's output in ::query_dispatcher_data_t::outputs.
+ */
+void __query_dispatcher_execute_repeated(task_scheduler_t *scheduler,
+                                         size_t            worker,
+                                         void             *user_data,
+                                         size_t            i) {
+    query_dispatcher_data_t *const dispatcher_data = user_data;
+
+    const size_t original = dispatcher_data->originals[i];
+    if (original == i)
+        return;
+
+    const query_dispatcher_group_t *const group = __query_dispatcher_get_group(dispatcher_data, i);
+    if (group->failed || group->deferred) /* Deferred groups execute their own repetitions */
+        return;
+
+    if (query_writer_close_as_link(dispatcher_data->outputs[i],
+                                   dispatcher_data->outputs[original])) {
+        __query_dispatcher_run_query(dispatcher_data, scheduler, worker, group, i);
+    } else if (dispatcher_data->progress) {
+        const query_type_t *const type = query_instance_get_type(group->instances[0]);
+        g_atomic_int_inc(&dispatcher_data->progress->done[query_type_get_type_number(type)]);
+    }
+}
+
+/** @brief Hashes a query instance, for repeated queries to be found. */
+guint __query_dispatcher_instance_hash(gconstpointer instance) {
+    return (guint) query_instance_get_arguments_hash(instance);
+}
+
+/** @brief Checks if two query instances are repetitions of the same query. */
+gboolean __query_dispatcher_instance_equal(gconstpointer a, gconstpointer b) {
+    return query_instance_is_same_query(a, b);
+}
+
+/**
+ * @brief   Finds repetitions of the same query in all groups of queries.
+ * @details See ::query_dispatcher_data_t::originals.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ *
+ * @return The value for ::query_dispatcher_data_t::originals, or `NULL` on allocation failure (or
+ *         if there are no queries).
+ */
+size_t *__query_dispatcher_find_repeated(const query_dispatcher_data_t *dispatcher_data) {
+    if (dispatcher_data->ninstances == 0)
+        return NULL;
+
+    size_t *const originals = malloc(sizeof(size_t) * dispatcher_data->ninstances);
+    if (!originals)
+        return NULL;
+
+    GConstKeyHashTable *const seen =
+        g_const_key_hash_table_new(__query_dispatcher_instance_hash,
+                                   __query_dispatcher_instance_equal);
+
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        const query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+
+        for (size_t j = 0; j < group->n; ++j) {
+            const size_t output = group->first_output + j;
+
+            /* Values are offset by one, so that NULL means the query hasn't been seen */
+            const gpointer first = g_const_key_hash_table_lookup(seen, group->instances[j]);
+            if (first) {
+                originals[output] = GPOINTER_TO_SIZE(first) - 1;
+            } else {
+                originals[output] = output;
+                g_const_key_hash_table_insert(seen,
+                                              group->instances[j],
+                                              GSIZE_TO_POINTER(output + 1));
+            }
+        }
+    }
+
+    g_const_key_hash_table_unref(seen);
+    return originals;
+}
+
+/**
+ * @brief   Runs a set of independent tasks on multiple threads.
+ * @details Tasks are run by a [work-stealing scheduler](@ref task_scheduler.h), as query execution
+ *          costs are very uneven, with threads pinned to the nodes in
+ *          ::query_dispatcher_data_t::topology. If the scheduler can't be created, all tasks are
+ *          run in the calling thread.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param ntasks          Number of tasks to run.
+ * @param task            Method called for every task (with indices from `0` to @p ntasks - `1`).
+ * @param nthreads        Maximum number of threads to use, including the calling one.
+ */
+void __query_dispatcher_run_tasks(query_dispatcher_data_t  *dispatcher_data,
+                                  size_t                    ntasks,
+                                  task_scheduler_callback_t task,
+                                  size_t                    nthreads) {
+
+    if (task_scheduler_run_pinned(dispatcher_data->topology,
+                                  nthreads,
+                                  ntasks,
+                                  task,
+                                  dispatcher_data))
+        for (size_t i = 0; i < ntasks; ++i)
+            task(NULL, 0, dispatcher_data, i);
+}
+
+/**
+ * @brief   Calculates how many threads each iteration through a manager can be split across.
+ * @details Iterations through different managers already run concurrently, so the available
+ *          threads are divided among the managers that need to be iterated through.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param nthreads        Maximum number of threads to use.
+ *
+ * @return The number of threads for each iteration through a manager (at least `1`).
+ */
+size_t __query_dispatcher_get_scan_nthreads(const query_dispatcher_data_t *dispatcher_data,
+                                            size_t                         nthreads) {
+    size_t nmanagers = 0;
+    for (size_t i = 0; i < QUERY_DISPATCHER_NUMBER_OF_MANAGERS; ++i) {
+        for (size_t j = 0; j < dispatcher_data->groups->len; ++j) {
+            const query_dispatcher_group_t *const group =
+                &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, j);
+
+            if (__query_dispatcher_scan_iterates_manager(group->scan, i)) {
+                nmanagers++;
+                break;
+            }
+        }
+    }
+
+    return max(1, nthreads / max(1, nmanagers));
+}
+
+/**
+ * @brief Gets statistical data from a cache, for all groups of queries whose data is there.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param cache           Cache to get statistical data from.
+ */
+void __query_dispatcher_get_cached_statistics(query_dispatcher_data_t  *dispatcher_data,
+                                              query_statistics_cache_t *cache) {
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+
+        group->statistics =
+            query_statistics_cache_get(cache,
+                                       query_instance_get_type(group->instances[0]),
+                                       query_instance_are_all_approximate(group->n,
+                                                                          group->instances));
+        if (group->statistics) {
+            group->cached = 1;
+            group->scan   = NULL; /* Don't take part in scans */
+        }
+    }
+}
+
+/**
+ * @brief   Relative cost of looking up an entity through an index, compared to visiting it during
+ *          a scan.
+ * @details Scans go through contiguous columns of data, while index lookups jump around memory.
+ */
+#define QUERY_DISPATCHER_INDEX_LOOKUP_COST 4
+
+/**
+ * @brief   Estimates the cost of a scan, as the number of entities in the managers it iterates
+ *          through.
+ * @details Taken from the database's statistics. Users are iterated through with their
+ *          associations (e.g.: query 10 goes through every user's flights), so those are counted
+ *          too.
+ *
+ * @param database  Database to be scanned.
+ * @param type_scan Scan to estimate the cost of.
+ *
+ * @return The number of entities visited by @p type_scan.
+ */
+size_t __query_dispatcher_get_scan_cost(const database_t        *database,
+                                        const query_type_scan_t *type_scan) {
+    const database_statistics_t *const statistics = database_get_statistics(database);
+
+    size_t cost = 0;
+    if (type_scan->foreach_user)
+        cost += database_statistics_get_user_count(statistics) +
+                database_statistics_get_passenger_count(statistics) +
+                database_statistics_get_reservation_count(statistics);
+    if (type_scan->foreach_flights)
+        cost += database_statistics_get_flight_count(statistics);
+    if (type_scan->foreach_reservations)
+        cost += database_statistics_get_reservation_count(statistics);
+    return cost;
+}
+
+/**
+ * @brief   Chooses, for every group of queries, between a scan and answering each query from
+ *          indexes.
+ * @details Groups whose ::query_type_scan_t::index_cost estimates fewer lookups than the ones in
+ *          a scan (weighted by ::QUERY_DISPATCHER_INDEX_LOOKUP_COST) stop taking part in scans.
+ *          Cached statistical data is always used when available.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ */
+void __query_dispatcher_choose_strategies(query_dispatcher_data_t *dispatcher_data) {
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        if (!group->scan || !group->scan->index_cost)
+            continue;
+
+        const size_t scan_cost =
+            __query_dispatcher_get_scan_cost(dispatcher_data->database, group->scan);
+        const size_t index_cost =
+            group->scan->index_cost(dispatcher_data->database, group->n, group->instances);
+
+        if (index_cost < scan_cost / QUERY_DISPATCHER_INDEX_LOOKUP_COST) {
+            group->indexed = 1;
+            group->scan    = NULL; /* Don't take part in scans */
+        }
+    }
+}
+
+/**
+ * @brief   Restricts the scans of groups of queries to the dates they depend on.
+ * @details Only done for groups whose statistical data won't be cached, as cached data must be
+ *          able to answer any other query of the same type.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param cache           Cache statistical data will be added to. Can be `NULL`.
+ */
+void __query_dispatcher_choose_date_ranges(query_dispatcher_data_t  *dispatcher_data,
+                                           query_statistics_cache_t *cache) {
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        const query_type_t *const type = query_instance_get_type(group->instances[0]);
+
+        if (!group->scan || !group->scan->date_range ||
+            (cache && query_type_has_reusable_statistics(type)))
+            continue;
+
+        group->dates.bounded = !group->scan->date_range(group->n,
+                                                        group->instances,
+                                                        &group->dates.begin,
+                                                        &group->dates.end);
+    }
+}
+
+/**
+ * @brief   Memory budget for the statistical data of each query type, in bytes (`0` for none).
+ * @details Global, as it's a limit on the whole process rather than on a single dispatch. It's
+ *          only set before any query is dispatched.
+ */
+size_t __query_dispatcher_statistics_budget = 0;
+
+void query_dispatcher_set_statistics_budget(size_t bytes) {
+    __query_dispatcher_statistics_budget = bytes;
+}
+
+/**
+ * @brief   Defers groups of queries whose statistical data would go over the memory budget.
+ * @details See ::query_dispatcher_set_statistics_budget.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ */
+void __query_dispatcher_choose_deferred(query_dispatcher_data_t *dispatcher_data) {
+    const size_t budget = __query_dispatcher_statistics_budget;
+    if (!budget)
+        return;
+
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        if (group->cached || group->indexed || !group->scan || !group->scan->estimate_size)
+            continue;
+
+        group->deferred =
+            group->scan->estimate_size(dispatcher_data->database, group->n, group->instances) >
+            budget;
+    }
+}
+
+/**
+ * @brief Checks if the costs of the query types of all groups of queries were measured.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ *
+ * @retval 0 There are no measured costs, or some query type wasn't measured.
+ * @retval 1 All query types were measured.
+ */
+int __query_dispatcher_has_measured_costs(const query_dispatcher_data_t *dispatcher_data) {
+    if (!dispatcher_data->costs)
+        return 0;
+
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        const query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        const size_t type_num =
+            query_type_get_type_number(query_instance_get_type(group->instances[0]));
+
+        if (!dispatcher_data->costs->measured[type_num])
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief   Estimates the cost of generating the statistical data for a group of queries.
+ * @details Measured costs are in microseconds, while estimated ones are in entities visited in the
+ *          database. To compare groups, either all costs must be measured or none can be.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param group           Group of queries to estimate the cost of.
+ * @param measured        Whether to use measured costs (see
+ *                        ::__query_dispatcher_has_measured_costs).
+ *
+ * @return The cost of generating the statistical data for @p group.
+ */
+uint64_t __query_dispatcher_get_statistics_cost(const query_dispatcher_data_t  *dispatcher_data,
+                                                const query_dispatcher_group_t *group,
+                                                int                             measured) {
+    if (group->cached || group->indexed)
+        return 0;
+
+    const query_type_t *const type = query_instance_get_type(group->instances[0]);
+    if (measured)
+        return dispatcher_data->costs->statistics[query_type_get_type_number(type)];
+    else if (group->scan)
+        return __query_dispatcher_get_scan_cost(dispatcher_data->database, group->scan);
+    else
+        return query_type_get_generate_statistics_callback(type) ? group->n : 0;
+}
+
+/**
+ * @brief Estimates the cost of executing all queries in a group.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param group           Group of queries to estimate the cost of.
+ * @param measured        Whether to use measured costs (see
+ *                        ::__query_dispatcher_has_measured_costs). If not, all queries are
+ *                        assumed to take the same time.
+ *
+ * @return The cost of executing the queries in @p group.
+ */
+uint64_t __query_dispatcher_get_execution_cost(const query_dispatcher_data_t  *dispatcher_data,
+                                               const query_dispatcher_group_t *group,
+                                               int                             measured) {
+    if (!measured)
+        return group->n;
+
+    const query_type_t *const type = query_instance_get_type(group->instances[0]);
+    return group->n * dispatcher_data->costs->execution[query_type_get_type_number(type)];
+}
+
+/**
+ * @struct query_dispatcher_cost_t
+ * @brief  The cost of a group of queries, for groups to be sorted by cost.
+ *
+ * @var query_dispatcher_cost_t::cost
+ *     @brief Estimated cost of the group.
+ * @var query_dispatcher_cost_t::index
+ *     @brief Index of the group in ::query_dispatcher_data_t::groups.
+ */
+typedef struct {
+    uint64_t cost;
+    size_t   index;
+} query_dispatcher_cost_t;
+
+/**
+ * @brief Comparison function for `qsort`ing groups of queries, from the most expensive to the
+ *        cheapest (ties keep the original order).
+ */
+int __query_dispatcher_cost_compare(const void *a, const void *b) {
+    const query_dispatcher_cost_t *const cost_a = a;
+    const query_dispatcher_cost_t *const cost_b = b;
+
+    if (cost_a->cost != cost_b->cost)
+        return cost_a->cost < cost_b->cost ? 1 : -1;
+    return (cost_a->index > cost_b->index) - (cost_a->index < cost_b->index);
+}
+
+/**
+ * @brief   Chooses the order groups of queries are processed in, and queries are executed in.
+ * @details Tasks are dealt to workers in a round-robin fashion (see ::task_scheduler_run), so
+ *          sorting them from the most to the least expensive approximates longest processing time
+ *          first scheduling: expensive work starts early, and cheap work fills in the gaps, instead
+ *          of a long task being started last and running alone.
+ *
+ * @param dispatcher_data Data about the queries being dispatched, where
+ *                        ::query_dispatcher_data_t::group_order and
+ *                        ::query_dispatcher_data_t::query_order are written to (`NULL` on
+ *                        allocation failure).
+ */
+void __query_dispatcher_order_work(query_dispatcher_data_t *dispatcher_data) {
+    const size_t ngroups = dispatcher_data->groups->len;
+    if (ngroups == 0)
+        return;
+
+    const int               measured = __query_dispatcher_has_measured_costs(dispatcher_data);
+    query_dispatcher_cost_t statistics_costs[ngroups];
+    query_dispatcher_cost_t execution_costs[ngroups];
+
+    for (size_t i = 0; i < ngroups; ++i) {
+        const query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+
+        statistics_costs[i] = (query_dispatcher_cost_t){
+            .cost  = __query_dispatcher_get_statistics_cost(dispatcher_data, group, measured),
+            .index = i};
+        execution_costs[i] = (query_dispatcher_cost_t){
+            .cost  = __query_dispatcher_get_execution_cost(dispatcher_data, group, measured),
+            .index = i};
+    }
+
+    qsort(statistics_costs,
+          ngroups,
+          sizeof(query_dispatcher_cost_t),
+          __query_dispatcher_cost_compare);
+    qsort(execution_costs,
+          ngroups,
+          sizeof(query_dispatcher_cost_t),
+          __query_dispatcher_cost_compare);
+
+    dispatcher_data->group_order = malloc(sizeof(size_t) * ngroups);
+    if (dispatcher_data->group_order)
+        for (size_t i = 0; i < ngroups; ++i)
+            dispatcher_data->group_order[i] = statistics_costs[i].index;
+
+    if (dispatcher_data->ninstances == 0)
+        return;
+    dispatcher_data->query_order = malloc(sizeof(size_t) * dispatcher_data->ninstances);
+    if (!dispatcher_data->query_order)
+        return;
+
+    size_t next = 0;
+    for (size_t i = 0; i < ngroups; ++i) {
+        const query_dispatcher_group_t *const group = &g_array_index(dispatcher_data->groups,
+                                                                     query_dispatcher_group_t,
+                                                                     execution_costs[i].index);
+
+        for (size_t j = 0; j < group->n; ++j)
+            dispatcher_data->query_order[next++] = group->first_output + j;
+    }
+}
+
+/**
+ * @brief   Marks all groups of queries whose statistical data was just generated as failed.
+ * @details Called when dispatching is cancelled, as iterations may have stopped early, leaving
+ *          that data incomplete. It mustn't be used, especially not cached.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ */
+void __query_dispatcher_fail_cancelled(query_dispatcher_data_t *dispatcher_data) {
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        if (!group->cached)
+            group->failed = 1;
+    }
+}
+
+/**
+ * @brief Adds newly generated statistical data to a cache, when it can be reused.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param cache           Cache to add statistical data to.
+ */
+void __query_dispatcher_cache_statistics(query_dispatcher_data_t  *dispatcher_data,
+                                         query_statistics_cache_t *cache) {
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        const query_type_t *const type = query_instance_get_type(group->instances[0]);
+
+        if (!group->cached && !group->failed && group->statistics &&
+            query_type_has_reusable_statistics(type))
+            group->cached = !query_statistics_cache_put(
+                cache,
+                type,
+                group->statistics,
+                query_instance_are_all_approximate(group->n, group->instances));
+    }
+}
+
+void query_dispatcher_dispatch_list(const database_t         *database,
+                                    query_statistics_cache_t *cache,
+                                    query_instance_list_t    *query_instance_list,
+                                    query_writer_t *const    *outputs,
+                                    size_t                    nthreads,
+                                    performance_metrics_t    *metrics) {
+
+    query_dispatcher_dispatch_list_with_progress(database,
+                                                 cache,
+                                                 query_instance_list,
+                                                 outputs,
+                                                 nthreads,
+                                                 metrics,
+                                                 NULL);
+}
+
+void query_dispatcher_costs_from_metrics(query_dispatcher_costs_t    *costs,
+                                         const performance_metrics_t *metrics) {
+    memset(costs, 0, sizeof(query_dispatcher_costs_t));
+
+    for (size_t i = 1; i <= QUERY_TYPE_LIST_COUNT; ++i) {
+        const latency_histogram_t *const latencies =
+            performance_metrics_get_query_latencies(metrics, i);
+        const uint64_t count = latency_histogram_get_count(latencies);
+        if (!count)
+            continue;
+
+        const performance_event_t *const statistics =
+            performance_metrics_get_query_statistics_measurement(metrics, i);
+
+        costs->statistics[i] = statistics ? performance_event_get_elapsed_time(statistics) : 0;
+        costs->execution[i]  = latency_histogram_get_total(latencies) / count;
+        costs->measured[i]   = 1;
+    }
+}
+
+/**
+ * @brief   Builds the database indices read by all queries being dispatched, concurrently.
+ * @details Indices already built are skipped, and failing to build an index isn't an error, as
+ *          queries build them again when needed.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ */
+void __query_dispatcher_build_indexes(const query_dispatcher_data_t *dispatcher_data) {
+    database_index_set_t indexes = 0;
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        const query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        indexes |= query_type_get_indexes(query_instance_get_type(group->instances[0]));
+    }
+
+    database_build_indexes(dispatcher_data->database, indexes);
+}
+
+/**
+ * @brief Writes the number of queries of each type to the progress of a dispatch.
+ * @param dispatcher_data Data about the queries being dispatched.
+ */
+void __query_dispatcher_report_totals(query_dispatcher_data_t *dispatcher_data) {
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        const query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        const size_t type_num =
+            query_type_get_type_number(query_instance_get_type(group->instances[0]));
+
+        g_atomic_int_set(&dispatcher_data->progress->total[type_num], (int) group->n);
+    }
+}
+
+/**
+ * @brief   Finds how many queries of a deferred group can share statistical data without going over
+ *          the memory budget.
+ * @details The length is doubled while the estimate fits the budget, and then binary searched, so
+ *          that only a few estimates are needed.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param group           Deferred group of queries (see ::query_dispatcher_group_t::deferred).
+ * @param begin           Index of the first query of the chunk in @p group.
+ *
+ * @return The number of queries, starting at @p begin, in the chunk (at least `1`, even if a
+ *         single query goes over the budget).
+ */
+size_t __query_dispatcher_get_chunk_length(const query_dispatcher_data_t  *dispatcher_data,
+                                           const query_dispatcher_group_t *group,
+                                           size_t                          begin) {
+    const query_type_scan_size_callback_t estimate  = group->scan->estimate_size;
+    const size_t                          budget    = __query_dispatcher_statistics_budget;
+    const size_t                          remaining = group->n - begin;
+
+    size_t fits = 1, goes_over = 2; /* Lengths known to fit and to go over the budget */
+    while (goes_over <= remaining &&
+           estimate(dispatcher_data->database, goes_over, group->instances + begin) <= budget) {
+        fits = goes_over;
+        goes_over *= 2;
+    }
+    goes_over = min(goes_over, remaining + 1);
+
+    while (goes_over - fits > 1) {
+        const size_t middle = fits + (goes_over - fits) / 2;
+        if (estimate(dispatcher_data->database, middle, group->instances + begin) <= budget)
+            fits = middle;
+        else
+            goes_over = middle;
+    }
+    return fits;
+}
+
+/**
+ * @brief Executes a query of the chunk of a deferred group being run.
+ *
+ * @param scheduler Scheduler running the task.
+ * @param worker    Worker running the task.
+ * @param user_data A pointer to a ::query_dispatcher_data_t.
+ * @param i         Index of the query in ::query_dispatcher_data_t::chunk.
+ */
+void __query_dispatcher_execute_deferred(task_scheduler_t *scheduler,
+                                         size_t            worker,
+                                         void             *user_data,
+                                         size_t            i) {
+    query_dispatcher_data_t *const        dispatcher_data = user_data;
+    const query_dispatcher_group_t *const chunk           = dispatcher_data->chunk;
+    __query_dispatcher_run_query(dispatcher_data,
+                                 scheduler,
+                                 worker,
+                                 chunk,
+                                 chunk->first_output + i);
+}
+
+/**
+ * @brief   Runs the queries of deferred groups, in chunks whose statistical data fits the memory
+ *          budget.
+ * @details Each chunk has its statistical data generated (restricted to the chunk's dates),
+ *          its queries executed (repetitions included), and its statistical data freed, before
+ *          moving on to the next chunk. See ::query_dispatcher_set_statistics_budget.
+ *
+ * @param dispatcher_data Data about the queries being dispatched.
+ * @param nthreads        Maximum number of threads to use.
+ */
+void __query_dispatcher_run_deferred(query_dispatcher_data_t *dispatcher_data, size_t nthreads) {
+    const database_t *const database = dispatcher_data->database;
+
+    for (size_t i = 0; i < dispatcher_data->groups->len; ++i) {
+        const query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data->groups, query_dispatcher_group_t, i);
+        if (!group->deferred || group->failed)
+            continue;
+
+        const query_type_t *const type     = query_instance_get_type(group->instances[0]);
+        const size_t              type_num = query_type_get_type_number(type);
+        const query_type_free_statistics_callback_t free_stats =
+            query_type_get_free_statistics_callback(type);
+
+        size_t length;
+        for (size_t begin = 0; begin < group->n && !cancellation_check(); begin += length) {
+            length = __query_dispatcher_get_chunk_length(dispatcher_data, group, begin);
+
+            query_dispatcher_group_t chunk = *group;
+            chunk.instances                = group->instances + begin;
+            chunk.n                        = length;
+            chunk.first_output             = group->first_output + begin;
+            chunk.deferred                 = 0;
+            if (chunk.scan->date_range)
+                chunk.dates.bounded = !chunk.scan->date_range(chunk.n,
+                                                              chunk.instances,
+                                                              &chunk.dates.begin,
+                                                              &chunk.dates.end);
+
+            event_trace_begin("statistics", "query chunk", type_num);
+            chunk.statistics = chunk.scan->begin(database, chunk.n, chunk.instances);
+            for (size_t j = 0; j < QUERY_DISPATCHER_NUMBER_OF_MANAGERS; ++j)
+                __query_dispatcher_scan_manager(database,
+                                                j,
+                                                1,
+                                                &chunk,
+                                                dispatcher_data->scan_nthreads);
+            __query_dispatcher_end_scan(database, &chunk);
+            event_trace_end();
+
+            chunk.failed = chunk.failed || cancellation_check(); /* Possibly incomplete data */
+            dispatcher_data->chunk = &chunk;
+            __query_dispatcher_run_tasks(dispatcher_data,
+                                         chunk.n,
+                                         __query_dispatcher_execute_deferred,
+                                         nthreads);
+            dispatcher_data->chunk = NULL;
+
+            if (free_stats && chunk.statistics)
+                free_stats(chunk.statistics);
+        }
+    }
+}
+
+/**
+ * @brief Runs a list of queries.
+ *
+ * @param database            Database, so that the queries can get information.
+ * @param cache               See ::query_dispatcher_dispatch_list.
+ * @param query_instance_list See ::query_dispatcher_dispatch_list.
+ * @param outputs             See ::query_dispatcher_dispatch_list.
+ * @param nthreads            See ::query_dispatcher_dispatch_list.
+ * @param metrics             See ::query_dispatcher_dispatch_list.
+ * @param progress            See ::query_dispatcher_dispatch_list_with_progress.
+ * @param costs               See ::query_dispatcher_dispatch_list_with_hints.
+ * @param topology            See ::query_dispatcher_dispatch_list_with_hints.
+ */
+void __query_dispatcher_dispatch(const database_t               *database,
+                                 query_statistics_cache_t       *cache,
+                                 query_instance_list_t          *query_instance_list,
+                                 query_writer_t *const          *outputs,
+                                 size_t                          nthreads,
+                                 performance_metrics_t          *metrics,
+                                 query_dispatcher_progress_t    *progress,
+                                 const query_dispatcher_costs_t *costs,
+                                 const numa_topology_t          *topology) {
+
+    /* Worker threads inherit the current cancellation (see task_scheduler_run) */
+    const cancellation_t *const previous_cancellation = cancellation_get_current();
+    if (progress)
+        cancellation_set_current(&progress->cancellation);
+
+    query_dispatcher_data_t dispatcher_data = {
+        .database    = database,
+        .outputs     = outputs,
+        .metrics     = metrics,
+        .progress    = progress,
+        .costs       = costs,
+        .topology    = topology,
+        .groups      = g_array_new(FALSE, FALSE, sizeof(query_dispatcher_group_t)),
+        .ninstances  = 0,
+        .originals   = NULL,
+        .group_order = NULL,
+        .query_order = NULL,
+        .chunk       = NULL};
 
-    query_dispatcher_data_t dispatcher_data = {.database = database,
-                                               .outputs  = outputs,
-                                               .i        = 0,
-                                               .metrics  = metrics};
     query_instance_list_iter_types(query_instance_list,
                                    __query_dispatcher_query_set_callback,
                                    &dispatcher_data);
+    if (cache)
+        __query_dispatcher_get_cached_statistics(&dispatcher_data, cache);
+    __query_dispatcher_choose_strategies(&dispatcher_data);
+    __query_dispatcher_choose_date_ranges(&dispatcher_data, cache);
+    __query_dispatcher_choose_deferred(&dispatcher_data);
+    if (progress)
+        __query_dispatcher_report_totals(&dispatcher_data);
+    dispatcher_data.originals = __query_dispatcher_find_repeated(&dispatcher_data);
+    __query_dispatcher_order_work(&dispatcher_data);
+
+    /* Measurements of different queries can't overlap */
+    if (metrics) {
+        nthreads = 1;
+    } else if (nthreads == 0) {
+        nthreads = thread_count_get();
+    }
+
+    /* When measuring, building indices is attributed to the first query that needs them */
+    if (!metrics)
+        __query_dispatcher_build_indexes(&dispatcher_data);
+
+    dispatcher_data.fuse_scans    = !metrics;
+    dispatcher_data.split_queries = !metrics && nthreads > 1;
+    dispatcher_data.scan_nthreads = __query_dispatcher_get_scan_nthreads(&dispatcher_data,
+                                                                         nthreads);
+    __query_dispatcher_run_tasks(&dispatcher_data,
+                                 dispatcher_data.groups->len,
+                                 __query_dispatcher_generate_statistics,
+                                 nthreads);
+    if (dispatcher_data.fuse_scans) {
+        __query_dispatcher_run_tasks(&dispatcher_data,
+                                     QUERY_DISPATCHER_NUMBER_OF_MANAGERS,
+                                     __query_dispatcher_fused_scan,
+                                     nthreads);
+        __query_dispatcher_run_tasks(&dispatcher_data,
+                                     dispatcher_data.groups->len,
+                                     __query_dispatcher_end_fused_scan,
+                                     nthreads);
+    }
+    if (cancellation_check())
+        __query_dispatcher_fail_cancelled(&dispatcher_data);
+    if (cache)
+        __query_dispatcher_cache_statistics(&dispatcher_data, cache);
+    if (progress)
+        g_atomic_int_set(&progress->executing, 1);
+    __query_dispatcher_run_tasks(&dispatcher_data,
+                                 dispatcher_data.ninstances,
+                                 __query_dispatcher_execute,
+                                 nthreads);
+    if (dispatcher_data.originals) {
+        __query_dispatcher_run_tasks(&dispatcher_data,
+                                     dispatcher_data.ninstances,
+                                     __query_dispatcher_execute_repeated,
+                                     nthreads);
+        free(dispatcher_data.originals);
+    }
+    __query_dispatcher_run_deferred(&dispatcher_data, nthreads);
+
+    for (size_t i = 0; i < dispatcher_data.groups->len; ++i) {
+        const query_dispatcher_group_t *const group =
+            &g_array_index(dispatcher_data.groups, query_dispatcher_group_t, i);
+
+        const query_type_free_statistics_callback_t free_stats =
+            query_type_get_free_statistics_callback(query_instance_get_type(group->instances[0]));
+        if (free_stats && group->statistics && !group->cached)
+            free_stats(group->statistics);
+    }
+
+    free(dispatcher_data.group_order);
+    free(dispatcher_data.query_order);
+    g_array_unref(dispatcher_data.groups);
+    cancellation_set_current(previous_cancellation);
+}
+
+void query_dispatcher_dispatch_list_with_progress(const database_t            *database,
+                                                  query_statistics_cache_t    *cache,
+                                                  query_instance_list_t       *query_instance_list,
+                                                  query_writer_t *const       *outputs,
+                                                  size_t                       nthreads,
+                                                  performance_metrics_t       *metrics,
+                                                  query_dispatcher_progress_t *progress) {
+
+    __query_dispatcher_dispatch(database,
+                                cache,
+                                query_instance_list,
+                                outputs,
+                                nthreads,
+                                metrics,
+                                progress,
+                                NULL,
+                                NULL);
+}
+
+void query_dispatcher_dispatch_list_with_hints(const database_t               *database,
+                                               query_statistics_cache_t       *cache,
+                                               query_instance_list_t          *query_instance_list,
+                                               query_writer_t *const          *outputs,
+                                               size_t                          nthreads,
+                                               const query_dispatcher_costs_t *costs,
+                                               const numa_topology_t          *topology) {
+
+    __query_dispatcher_dispatch(database,
+                                cache,
+                                query_instance_list,
+                                outputs,
+                                nthreads,
+                                NULL,
+                                NULL,
+                                costs,
+                                topology);
 }
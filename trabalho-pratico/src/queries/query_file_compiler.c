@@ -0,0 +1,431 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  query_file_compiler.c
+ * @brief Implementation of methods in include/queries/query_file_compiler.h
+ *
+ * @details A compiled query file starts with a ::query_file_compiler_header_t, followed by a
+ *          ::query_file_compiler_record_t for every query. Each record is followed by the query's
+ *          unparsed arguments (::query_file_compiler_record_t::arguments_size bytes), and then by
+ *          ::query_file_compiler_record_t::data_size bytes, written by the query type's
+ *          ::query_type_save_arguments_callback_t. Numbers are stored in the native byte order.
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref query_file_compiler_examples).
+ */
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "queries/query_file_compiler.h"
+#include "queries/query_type_list.h"
+#include "utils/mapped_file.h"
+
+/** @brief Value of ::query_file_compiler_header_t::magic. */
+#define QUERY_FILE_COMPILER_MAGIC "LI3QBIN"
+
+/** @brief Version of the compiled format. Must be incremented on every change to the format. */
+#define QUERY_FILE_COMPILER_VERSION 2
+
+/**
+ * @struct query_file_compiler_header_t
+ * @brief  Beginning of a compiled query file.
+ *
+ * @var query_file_compiler_header_t::magic
+ *     @brief Always ::QUERY_FILE_COMPILER_MAGIC, to identify compiled query files.
+ * @var query_file_compiler_header_t::version
+ *     @brief Version of the format of the file (::QUERY_FILE_COMPILER_VERSION).
+ * @var query_file_compiler_header_t::header_size
+ *     @brief   Size of this `struct`.
+ *     @details Detects files compiled by builds of this program with a different ABI.
+ * @var query_file_compiler_header_t::record_size
+ *     @brief Size of a ::query_file_compiler_record_t.
+ * @var query_file_compiler_header_t::pointer_size
+ *     @brief   Size of a pointer.
+ *     @details Arguments are stored as they are in memory, so their layout depends on it.
+ * @var query_file_compiler_header_t::nqueries
+ *     @brief Number of queries in the file.
+ */
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t pointer_size;
+    uint64_t nqueries;
+} query_file_compiler_header_t;
+
+/**
+ * @struct query_file_compiler_record_t
+ * @brief  A query in a compiled query file.
+ *
+ * @var query_file_compiler_record_t::line_in_file
+ *     @brief See ::query_instance_get_line_in_file.
+ * @var query_file_compiler_record_t::offset
+ *     @brief See ::query_instance_get_offset.
+ * @var query_file_compiler_record_t::limit
+ *     @brief See ::query_instance_get_limit.
+ * @var query_file_compiler_record_t::arguments_size
+ *     @brief Number of bytes of unparsed arguments after this record (see
+ *            ::query_instance_get_arguments).
+ * @var query_file_compiler_record_t::type_number
+ *     @brief Number of the type of the query (see ::query_type_get_type_number).
+ * @var query_file_compiler_record_t::data_size
+ *     @brief Number of bytes written by ::query_type_save_arguments_callback_t after the unparsed
+ *            arguments.
+ * @var query_file_compiler_record_t::formatted
+ *     @brief See ::query_instance_get_formatted.
+ * @var query_file_compiler_record_t::approximate
+ *     @brief See ::query_instance_get_approximate.
+ * @var query_file_compiler_record_t::arguments
+ *     @brief Arguments of the query, as they are in memory (see
+ *            ::query_instance_get_argument_data).
+ */
+typedef struct {
+    uint64_t line_in_file;
+    uint64_t offset, limit;
+    uint64_t arguments_size;
+    uint32_t type_number;
+    uint32_t data_size;
+    uint8_t  formatted, approximate;
+    char     arguments[QUERY_TYPE_ARGUMENTS_MAX_SIZE];
+} query_file_compiler_record_t;
+
+/**
+ * @brief Checks if the header of a compiled query file is valid.
+ * @param header Header read from a compiled query file.
+ * @return Whether @p header belongs to a compiled query file of this format and ABI.
+ */
+int __query_file_compiler_header_is_valid(const query_file_compiler_header_t *header) {
+    return !memcmp(header->magic, QUERY_FILE_COMPILER_MAGIC, sizeof(QUERY_FILE_COMPILER_MAGIC)) &&
+           header->version == QUERY_FILE_COMPILER_VERSION &&
+           header->header_size == sizeof(query_file_compiler_header_t) &&
+           header->record_size == sizeof(query_file_compiler_record_t) &&
+           header->pointer_size == sizeof(void *);
+}
+
+/**
+ * @struct query_file_compiler_writer_t
+ * @brief  Data needed while writing a compiled query file.
+ *
+ * @var query_file_compiler_writer_t::file
+ *     @brief File being written.
+ * @var query_file_compiler_writer_t::count
+ *     @brief Number of queries written.
+ */
+typedef struct {
+    FILE    *file;
+    uint64_t count;
+} query_file_compiler_writer_t;
+
+/**
+ * @brief   Writes a query to a compiled query file.
+ * @details Auxiliary method for ::query_file_compiler_save.
+ *
+ * @param user_data A pointer to a ::query_file_compiler_writer_t.
+ * @param instance  Query to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __query_file_compiler_write_query(void *user_data, const query_instance_t *instance) {
+    query_file_compiler_writer_t *const writer = user_data;
+    const query_type_t *const           type   = query_instance_get_type(instance);
+
+    size_t            arguments_size;
+    const char *const arguments = query_instance_get_arguments(instance, &arguments_size);
+
+    /* Zero padding, so that the same queries always compile to the same file */
+    query_file_compiler_record_t record;
+    memset(&record, 0, sizeof(query_file_compiler_record_t));
+    record.line_in_file   = query_instance_get_line_in_file(instance);
+    record.offset         = query_instance_get_offset(instance);
+    record.limit          = query_instance_get_limit(instance);
+    record.arguments_size = arguments_size;
+    record.type_number    = (uint32_t) query_type_get_type_number(type);
+    record.formatted      = (uint8_t) query_instance_get_formatted(instance);
+    record.approximate    = (uint8_t) query_instance_get_approximate(instance);
+    memcpy(record.arguments, query_instance_get_argument_data(instance), sizeof(record.arguments));
+
+    const long record_offset = ftell(writer->file);
+    if (record_offset < 0 ||
+        fwrite(&record, sizeof(query_file_compiler_record_t), 1, writer->file) != 1 ||
+        (arguments_size && fwrite(arguments, arguments_size, 1, writer->file) != 1))
+        return 1;
+
+    const query_type_save_arguments_callback_t save_cb =
+        query_type_get_save_arguments_callback(type);
+    if (save_cb) {
+        if (save_cb(query_instance_get_argument_data(instance), writer->file))
+            return 1;
+
+        /* The size of the data is only known once it's written */
+        const long end = ftell(writer->file);
+        if (end < 0)
+            return 1;
+
+        const long data_size = end - record_offset - (long) sizeof(query_file_compiler_record_t) -
+                               (long) arguments_size;
+        if (data_size > UINT32_MAX)
+            return 1;
+
+        if (data_size) {
+            record.data_size = (uint32_t) data_size;
+            if (fseek(writer->file,
+                      record_offset + (long) offsetof(query_file_compiler_record_t, data_size),
+                      SEEK_SET) ||
+                fwrite(&record.data_size, sizeof(uint32_t), 1, writer->file) != 1 ||
+                fseek(writer->file, end, SEEK_SET))
+                return 1;
+        }
+    }
+
+    writer->count++;
+    return 0;
+}
+
+int query_file_compiler_save(query_instance_list_t *list, const char *path) {
+    /* Write to a temporary file first, so that a failure never leaves a corrupt file behind */
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, PATH_MAX, "%s.tmp", path) >= PATH_MAX)
+        return 1;
+
+    query_file_compiler_writer_t writer = {.file = fopen(tmp_path, "wb"), .count = 0};
+    if (!writer.file)
+        return 1;
+
+    query_file_compiler_header_t header = {.magic        = QUERY_FILE_COMPILER_MAGIC,
+                                           .version      = QUERY_FILE_COMPILER_VERSION,
+                                           .header_size  = sizeof(query_file_compiler_header_t),
+                                           .record_size  = sizeof(query_file_compiler_record_t),
+                                           .pointer_size = sizeof(void *),
+                                           .nqueries     = 0};
+
+    /* Header is written again when the number of queries is known */
+    if (fwrite(&header, sizeof(query_file_compiler_header_t), 1, writer.file) != 1)
+        goto DEFER_1;
+
+    if (query_instance_list_iter(list, __query_file_compiler_write_query, &writer))
+        goto DEFER_1;
+
+    header.nqueries = writer.count;
+    if (fseek(writer.file, 0, SEEK_SET) ||
+        fwrite(&header, sizeof(query_file_compiler_header_t), 1, writer.file) != 1)
+        goto DEFER_1;
+
+    if (fclose(writer.file)) {
+        remove(tmp_path);
+        return 1;
+    }
+
+    if (rename(tmp_path, path)) {
+        remove(tmp_path);
+        return 1;
+    }
+    return 0;
+
+DEFER_1:
+    fclose(writer.file);
+    remove(tmp_path);
+    return 1;
+}
+
+int query_file_compiler_compile(const char *query_file_path, const char *path) {
+    query_instance_list_t *const list = query_file_parser_parse_path(query_file_path);
+    if (!list)
+        return 1;
+
+    const int retval = query_file_compiler_save(list, path);
+    query_instance_list_free(list);
+    return retval;
+}
+
+int query_file_compiler_is_compiled(const char *path) {
+    FILE *const file = fopen(path, "rb");
+    if (!file)
+        return 0;
+
+    char         magic[sizeof(QUERY_FILE_COMPILER_MAGIC)];
+    const size_t read = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+    return read == sizeof(magic) && !memcmp(magic, QUERY_FILE_COMPILER_MAGIC, sizeof(magic));
+}
+
+/**
+ * @struct query_file_compiler_reader_t
+ * @brief  Data needed while reading a compiled query file.
+ *
+ * @var query_file_compiler_reader_t::file
+ *     @brief File being read.
+ * @var query_file_compiler_reader_t::contents
+ *     @brief Contents of ::query_file_compiler_reader_t::file.
+ * @var query_file_compiler_reader_t::size
+ *     @brief Number of bytes in ::query_file_compiler_reader_t::contents.
+ * @var query_file_compiler_reader_t::offset
+ *     @brief Offset in ::query_file_compiler_reader_t::contents of the next record to be read.
+ * @var query_file_compiler_reader_t::nqueries
+ *     @brief Number of queries in the file (::query_file_compiler_header_t::nqueries).
+ */
+typedef struct {
+    mapped_file_t *file;
+    const char    *contents;
+    size_t         size, offset;
+    uint64_t       nqueries;
+} query_file_compiler_reader_t;
+
+/**
+ * @brief Maps a compiled query file and checks its header.
+ *
+ * @param reader Where to write the state of the reader to. When successful, its
+ *               ::query_file_compiler_reader_t::file must be closed with ::mapped_file_close.
+ * @param path   Path to the compiled query file.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure, or invalid header.
+ */
+int __query_file_compiler_open(query_file_compiler_reader_t *reader, const char *path) {
+    reader->file = mapped_file_open(path);
+    if (!reader->file)
+        return 1;
+
+    reader->contents = mapped_file_get_contents(reader->file);
+    reader->size     = mapped_file_get_size(reader->file);
+
+    query_file_compiler_header_t header;
+    if (reader->size < sizeof(query_file_compiler_header_t))
+        goto DEFER_1;
+    memcpy(&header, reader->contents, sizeof(query_file_compiler_header_t));
+    if (!__query_file_compiler_header_is_valid(&header))
+        goto DEFER_1;
+
+    /* Every query takes at least a record, so the number of queries is bounded by the file size */
+    reader->offset   = sizeof(query_file_compiler_header_t);
+    reader->nqueries = header.nqueries;
+    if (reader->nqueries > (reader->size - reader->offset) / sizeof(query_file_compiler_record_t))
+        goto DEFER_1;
+    return 0;
+
+DEFER_1:
+    mapped_file_close(reader->file);
+    return 1;
+}
+
+/**
+ * @brief Reads the next query of a compiled query file into a query instance.
+ *
+ * @param reader    Compiled query file being read.
+ * @param allocator Where to allocate strings in the arguments of the query. `NULL` for `strdup`.
+ * @param instance  Query instance to be filled in.
+ *
+ * @retval 0 Success.
+ * @retval 1 Corrupt file or allocation failure.
+ */
+int __query_file_compiler_read_query(query_file_compiler_reader_t *reader,
+                                     string_pool_t                *allocator,
+                                     query_instance_t             *instance) {
+    query_file_compiler_record_t record;
+    if (sizeof(query_file_compiler_record_t) > reader->size - reader->offset)
+        return 1;
+    memcpy(&record, reader->contents + reader->offset, sizeof(query_file_compiler_record_t));
+    reader->offset += sizeof(query_file_compiler_record_t);
+
+    const query_type_t *const type = query_type_list_get_by_index(record.type_number);
+    if (!type || record.arguments_size > reader->size - reader->offset)
+        return 1;
+
+    const char *const arguments = reader->contents + reader->offset;
+    reader->offset += record.arguments_size;
+    if (record.data_size > reader->size - reader->offset)
+        return 1;
+
+    query_instance_set_type(instance, type);
+    query_instance_set_formatted(instance, record.formatted);
+    query_instance_set_approximate(instance, record.approximate);
+    query_instance_set_line_in_file(instance, record.line_in_file);
+    query_instance_set_page(instance, record.offset, record.limit);
+
+    const char *const data = reader->contents + reader->offset;
+    reader->offset += record.data_size;
+    return query_instance_load_arguments(allocator,
+                                         instance,
+                                         record.arguments,
+                                         arguments,
+                                         record.arguments_size,
+                                         data,
+                                         record.data_size);
+}
+
+query_instance_list_t *query_file_compiler_load(const char *path) {
+    query_file_compiler_reader_t reader;
+    if (__query_file_compiler_open(&reader, path))
+        return NULL;
+
+    query_instance_list_t *list = query_instance_list_create();
+    if (!list)
+        goto DEFER_1;
+
+    for (uint64_t i = 0; i < reader.nqueries; ++i) {
+        /* Read directly into the list, to avoid copying the query */
+        string_pool_t          *string_allocator;
+        query_instance_t *const query = query_instance_list_add_empty(list, &string_allocator);
+        if (!query || __query_file_compiler_read_query(&reader, string_allocator, query)) {
+            if (query)
+                query_instance_list_remove_last(list);
+            query_instance_list_free(list);
+            list = NULL;
+            break;
+        }
+    }
+
+DEFER_1:
+    mapped_file_close(reader.file);
+    return list;
+}
+
+int query_file_compiler_iter(const char                      *path,
+                             query_file_parser_iter_callback_t callback,
+                             void                             *user_data) {
+    query_file_compiler_reader_t reader;
+    if (__query_file_compiler_open(&reader, path))
+        return 1;
+
+    int retval = 0;
+    for (uint64_t i = 0; i < reader.nqueries && !retval; ++i) {
+        query_instance_t *const query = query_instance_create(NULL);
+        if (!query) {
+            retval = 1;
+            break;
+        }
+
+        retval = __query_file_compiler_read_query(&reader, NULL, query);
+        if (!retval)
+            retval = callback(user_data, query);
+        query_instance_free(query);
+    }
+
+    mapped_file_close(reader.file);
+    return retval;
+}
+
+query_instance_list_t *query_file_compiler_load_or_parse(const char *path) {
+    if (query_file_compiler_is_compiled(path))
+        return query_file_compiler_load(path);
+    return query_file_parser_parse_path(path);
+}
@@ -22,26 +22,32 @@
  * See [the header file's documentation](@ref query_file_parser_examples).
  */
 
-#include <glib.h>
+#include <string.h>
 
 #include "queries/query_file_parser.h"
 #include "queries/query_parser.h"
+#include "utils/int_utils.h"
+#include "utils/mapped_file.h"
+#include "utils/parallel_for.h"
 #include "utils/stream_utils.h"
+#include "utils/thread_count.h"
+
+/** @brief Minimum size of each chunk in ::query_file_parser_parse_path (1 MiB). */
+#define QUERY_FILE_PARSER_MIN_CHUNK_SIZE (1 << 20)
+
+/** @brief Maximum number of chunks (and threads) in ::query_file_parser_parse_path. */
+#define QUERY_FILE_PARSER_MAX_CHUNKS 32
 
 /**
  * @struct query_file_parser_data_t
  * @brief  State of a parser of a file of queries.
  *
- * @var query_file_parser_data_t::aux_buffer
- *     @brief Auxiliary array passed to ::query_parser_parse_string, to reduce the number of
- *            allocations.
  * @var query_file_parser_data_t::line_number
  *     @brief Number of the current line of the file.
  * @var query_file_parser_data_t::query_instance_list
  *     @brief List to add parsed queries to.
  */
 typedef struct {
-    GPtrArray *const             aux_buffer;
     size_t                       line_number;
     query_instance_list_t *const query_instance_list;
 } query_file_parser_data_t;
@@ -59,23 +65,17 @@ typedef struct {
 int __query_file_parser_parse_query_callback(void *user_data, char *line) {
     query_file_parser_data_t *const parser_data = user_data;
 
-    query_instance_t *const aux_query = query_instance_create();
-    if (!aux_query)
-        return 1;
-
-    const int retval = query_parser_parse_string(aux_query, line, parser_data->aux_buffer);
-    if (retval) {
-        query_instance_free(aux_query);
-        parser_data->line_number++;
-        return 0; /* Ignore parsing failures */
-    }
-
-    query_instance_set_line_in_file(aux_query, parser_data->line_number);
-    if (query_instance_list_add(parser_data->query_instance_list, aux_query)) {
-        query_instance_free(aux_query);
+    /* Parse directly into the list, to avoid copying the query */
+    string_pool_t          *string_allocator;
+    query_instance_t *const query =
+        query_instance_list_add_empty(parser_data->query_instance_list, &string_allocator);
+    if (!query)
         return 1; /* Allocation failure */
-    }
-    query_instance_free(aux_query);
+
+    if (query_parser_parse_string(string_allocator, query, line))
+        query_instance_list_remove_last(parser_data->query_instance_list); /* Ignore failures */
+    else
+        query_instance_set_line_in_file(query, parser_data->line_number);
 
     parser_data->line_number++;
     return 0;
@@ -86,16 +86,192 @@ query_instance_list_t *query_file_parser_parse(FILE *input) {
     if (!list)
         return NULL;
 
-    query_file_parser_data_t parser_data = {.aux_buffer          = g_ptr_array_new(),
-                                            .line_number         = 1,
+    query_file_parser_data_t parser_data = {.line_number         = 1,
                                             .query_instance_list = list};
 
     if (stream_tokenize(input, '\n', __query_file_parser_parse_query_callback, &parser_data)) {
-        g_ptr_array_unref(parser_data.aux_buffer);
         query_instance_list_free(list);
         return NULL;
     }
 
-    g_ptr_array_unref(parser_data.aux_buffer);
     return list;
 }
+
+/**
+ * @struct query_file_parser_chunk_t
+ * @brief  Part of a query file, parsed by a thread in ::query_file_parser_parse_path.
+ *
+ * @var query_file_parser_chunk_t::file
+ *     @brief File being parsed.
+ * @var query_file_parser_chunk_t::begin
+ *     @brief Offset of the beginning of the chunk (always the beginning of a line).
+ * @var query_file_parser_chunk_t::end
+ *     @brief Offset right after the end of the chunk (after a newline, or the end of the file).
+ * @var query_file_parser_chunk_t::list
+ *     @brief List to add the queries in the chunk to, with line numbers relative to the chunk.
+ * @var query_file_parser_chunk_t::nlines
+ *     @brief Number of lines in the chunk, written after it's parsed.
+ */
+typedef struct {
+    const mapped_file_t   *file;
+    size_t                 begin, end;
+    query_instance_list_t *list;
+    size_t                 nlines;
+} query_file_parser_chunk_t;
+
+/**
+ * @brief   Parses a chunk of a query file.
+ * @details Auxiliary method for ::query_file_parser_parse_path, called by ::parallel_for.
+ *
+ * @param user_data A pointer to a ::query_file_parser_chunk_t.
+ * @param begin     Index of the chunk (not used, as there's a chunk per thread).
+ * @param end       Index after the chunk (not used).
+ *
+ * @retval 0 Success (parsing failures may occur).
+ * @retval 1 Allocation failure.
+ */
+int __query_file_parser_parse_chunk(void *user_data, size_t begin, size_t end) {
+    (void) begin;
+    (void) end;
+
+    query_file_parser_chunk_t *const chunk       = user_data;
+    query_file_parser_data_t         parser_data = {.line_number         = 1,
+                                                    .query_instance_list = chunk->list};
+
+    const int retval = mapped_file_tokenize_range(chunk->file,
+                                                  chunk->begin,
+                                                  chunk->end,
+                                                  '\n',
+                                                  __query_file_parser_parse_query_callback,
+                                                  &parser_data);
+
+    chunk->nlines = parser_data.line_number - 1;
+    return retval != 0;
+}
+
+query_instance_list_t *query_file_parser_parse_path(const char *path) {
+    mapped_file_t *const file = mapped_file_open(path);
+    if (!file)
+        return NULL;
+
+    const char  *contents = mapped_file_get_contents(file);
+    const size_t size     = mapped_file_get_size(file);
+    const size_t nchunks  = max(1, min(size / QUERY_FILE_PARSER_MIN_CHUNK_SIZE,
+                                       min(thread_count_get(), QUERY_FILE_PARSER_MAX_CHUNKS)));
+
+    /* Split the file in chunks of about the same size, each ending after a newline */
+    query_file_parser_chunk_t chunks[QUERY_FILE_PARSER_MAX_CHUNKS];
+    void                     *chunk_pointers[QUERY_FILE_PARSER_MAX_CHUNKS];
+    size_t                    ncreated = 0;
+    size_t                    begin    = 0;
+    for (size_t i = 0; i < nchunks; ++i) {
+        size_t end = size;
+        if (i + 1 < nchunks) {
+            const size_t      target = max(begin, size / nchunks * (i + 1));
+            const char *const found  = memchr(contents + target, '\n', size - target);
+            end                      = found ? (size_t) (found - contents + 1) : size;
+        }
+
+        chunks[i] = (query_file_parser_chunk_t){.file   = file,
+                                                .begin  = begin,
+                                                .end    = end,
+                                                .list   = query_instance_list_create(),
+                                                .nlines = 0};
+        if (!chunks[i].list)
+            goto DEFER_1;
+
+        chunk_pointers[i] = &chunks[i];
+        ncreated++;
+        begin = end;
+    }
+
+    if (parallel_for(nchunks, nchunks, __query_file_parser_parse_chunk, chunk_pointers))
+        goto DEFER_1;
+
+    /* Merge chunks in file order, so that line numbers are relative to the whole file */
+    query_instance_list_t *const list        = chunks[0].list;
+    size_t                       line_offset = chunks[0].nlines;
+    for (size_t i = 1; i < nchunks; ++i) {
+        const int failed = query_instance_list_merge(list, chunks[i].list, line_offset);
+        chunks[i].list   = NULL; /* Owned by list, or freed on failure */
+        line_offset += chunks[i].nlines;
+        if (failed)
+            goto DEFER_1;
+    }
+
+    mapped_file_close(file);
+    return list;
+
+DEFER_1:
+    for (size_t i = 0; i < ncreated; ++i)
+        if (chunks[i].list)
+            query_instance_list_free(chunks[i].list);
+    mapped_file_close(file);
+    return NULL;
+}
+
+/**
+ * @struct query_file_parser_iter_data_t
+ * @brief  State of a parser of a file of queries, in ::query_file_parser_iter.
+ *
+ * @var query_file_parser_iter_data_t::line_number
+ *     @brief Number of the current line of the file.
+ * @var query_file_parser_iter_data_t::callback
+ *     @brief Method called for every query parsed successfully.
+ * @var query_file_parser_iter_data_t::user_data
+ *     @brief `user_data` parameter for ::query_file_parser_iter_data_t::callback.
+ * @var query_file_parser_iter_data_t::retval
+ *     @brief Value returned by ::query_file_parser_iter_data_t::callback when it stopped parsing,
+ *            or `1` on allocation failure.
+ */
+typedef struct {
+    size_t                                  line_number;
+    const query_file_parser_iter_callback_t callback;
+    void *const                             user_data;
+    int                                     retval;
+} query_file_parser_iter_data_t;
+
+/**
+ * @brief   Parses a line (containing a query) in a query file, and calls the user's callback.
+ * @details Auxiliary method for ::query_file_parser_iter.
+ *
+ * @param user_data A pointer to a ::query_file_parser_iter_data_t.
+ * @param line      Query to be parsed.
+ *
+ * @retval 0 Success (parsing failures may occur).
+ * @retval 1 Allocation failure or the user's callback ordered parsing to stop.
+ */
+int __query_file_parser_iter_query_callback(void *user_data, char *line) {
+    query_file_parser_iter_data_t *const parser_data = user_data;
+
+    query_instance_t *const query = query_instance_create(NULL);
+    if (!query) {
+        parser_data->retval = 1; /* Allocation failure */
+        return 1;
+    }
+
+    if (!query_parser_parse_string(NULL, query, line)) {
+        query_instance_set_line_in_file(query, parser_data->line_number);
+        parser_data->retval = parser_data->callback(parser_data->user_data, query);
+    }
+
+    query_instance_free(query);
+    parser_data->line_number++;
+    return parser_data->retval != 0;
+}
+
+int query_file_parser_iter(FILE                             *input,
+                           query_file_parser_iter_callback_t callback,
+                           void                             *user_data) {
+    query_file_parser_iter_data_t parser_data = {.line_number = 1,
+                                                 .callback    = callback,
+                                                 .user_data   = user_data,
+                                                 .retval      = 0};
+
+    const int tokenize_retval =
+        stream_tokenize(input, '\n', __query_file_parser_iter_query_callback, &parser_data);
+
+    if (tokenize_retval == STREAM_TOKENIZE_RET_ALLOCATION_FAILURE)
+        return 1;
+    return parser_data.retval;
+}
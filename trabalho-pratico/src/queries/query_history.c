@@ -0,0 +1,292 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  query_history.c
+ * @brief Implementation of methods in include/queries/query_history.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref query_history_examples).
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queries/query_history.h"
+#include "queries/query_tokenizer.h"
+
+/**
+ * @struct query_history_result_t
+ * @brief  The cached output of a query.
+ *
+ * @var query_history_result_t::key
+ *     @brief Normalized query (see ::__query_history_normalize), key in ::query_history::results.
+ * @var query_history_result_t::lines
+ *     @brief Lines outputted by the query. All of them are stored in the same allocation as this
+ *            array.
+ * @var query_history_result_t::n
+ *     @brief Number of elements in ::query_history_result_t::lines.
+ * @var query_history_result_t::memory
+ *     @brief Number of bytes allocated for this result.
+ * @var query_history_result_t::link
+ *     @brief Node of this result in ::query_history::lru.
+ */
+typedef struct {
+    char  *key;
+    char **lines;
+    size_t n, memory;
+    GList  link;
+} query_history_result_t;
+
+/**
+ * @struct query_history
+ * @brief  Queries issued in interactive mode, and their cached results.
+ *
+ * @var query_history::queries
+ *     @brief Text of the most recent queries (`char *`), from the oldest to the most recent.
+ * @var query_history::results
+ *     @brief Map from normalized queries to ::query_history_result_t.
+ * @var query_history::lru
+ *     @brief Cached results, from the most recently used to the least recently used.
+ * @var query_history::memory
+ *     @brief Number of bytes used by all cached results.
+ * @var query_history::memory_budget
+ *     @brief Maximum value of ::query_history::memory.
+ */
+struct query_history {
+    GPtrArray  *queries;
+    GHashTable *results;
+    GQueue      lru;
+    size_t      memory, memory_budget;
+};
+
+query_history_t *query_history_create(size_t memory_budget) {
+    query_history_t *const history = malloc(sizeof(query_history_t));
+    if (!history)
+        return NULL;
+
+    history->queries       = g_ptr_array_new_with_free_func(g_free);
+    history->results       = g_hash_table_new(g_str_hash, g_str_equal);
+    history->memory        = 0;
+    history->memory_budget = memory_budget;
+    g_queue_init(&history->lru);
+    return history;
+}
+
+int query_history_add_query(query_history_t *history, const char *query_str) {
+    for (size_t i = 0; i < history->queries->len; ++i) {
+        if (strcmp(g_ptr_array_index(history->queries, i), query_str) == 0) {
+            g_ptr_array_remove_index(history->queries, i);
+            break;
+        }
+    }
+
+    if (history->queries->len >= QUERY_HISTORY_MAX_QUERIES)
+        g_ptr_array_remove_index(history->queries, 0);
+
+    char *const copy = g_strdup(query_str);
+    if (!copy)
+        return 1;
+    g_ptr_array_add(history->queries, copy);
+    return 0;
+}
+
+int query_history_iter_queries(const query_history_t        *history,
+                               const char                   *prefix,
+                               query_history_iter_callback_t callback,
+                               void                         *user_data) {
+
+    for (size_t i = history->queries->len; i > 0; --i) {
+        const char *const query_str = g_ptr_array_index(history->queries, i - 1);
+        if (g_str_has_prefix(query_str, prefix)) {
+            const int retval = callback(user_data, query_str);
+            if (retval)
+                return retval;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Callback for ::query_tokenizer_tokenize_const that adds query arguments to a key.
+ * @details The first token (query type and formatting) is skipped, as it's already in the key.
+ *
+ * @param user_data A `GString *` with the normalized query being built.
+ * @param token     Current query token.
+ *
+ * @retval 0 Always, to continue tokenizing.
+ */
+int __query_history_normalize_callback(void *user_data, char *token) {
+    GString *const key = user_data;
+    if (key->len == 0) {
+        g_string_append_c(key, ' '); /* Mark the first token as seen */
+        return 0;
+    }
+
+    /* Separator that can't be part of a token */
+    g_string_append_c(key, '\n');
+    g_string_append(key, token);
+    return 0;
+}
+
+/**
+ * @brief   Generates the key of a query in ::query_history::results.
+ * @details Queries with the same key generate the same output: the key is formed by the query's
+ *          type, formatting and approximation (as parsed, so that `01` and `1` match), followed by
+ *          its arguments, no matter how many spaces were between them, or how they were quoted.
+ *
+ * @param query     Parsed query.
+ * @param query_str Text @p query was parsed from.
+ *
+ * @return A key to be `g_free`d, or `NULL` on allocation or tokenization failure.
+ */
+char *__query_history_normalize(const query_instance_t *query, const char *query_str) {
+    GString *const arguments = g_string_new("");
+    if (query_tokenizer_tokenize_const(query_str, __query_history_normalize_callback, arguments)) {
+        g_string_free(arguments, TRUE);
+        return NULL;
+    }
+
+    char *const key = g_strdup_printf("%zu%s%s%s",
+                                      query_type_get_type_number(query_instance_get_type(query)),
+                                      query_instance_get_formatted(query) ? "F" : "",
+                                      query_instance_get_approximate(query) ? "A" : "",
+                                      arguments->str + (arguments->len ? 1 : 0));
+    g_string_free(arguments, TRUE);
+    return key;
+}
+
+/**
+ * @brief Removes a cached result from a history.
+ *
+ * @param history History to be modified.
+ * @param result  Result in @p history to be removed and `free`d.
+ */
+void __query_history_remove_result(query_history_t *history, query_history_result_t *result) {
+    g_hash_table_remove(history->results, result->key);
+    g_queue_unlink(&history->lru, &result->link);
+    history->memory -= result->memory;
+
+    g_free(result->key);
+    free(result->lines);
+    free(result);
+}
+
+int query_history_add_result(query_history_t        *history,
+                             const query_instance_t *query,
+                             const char             *query_str,
+                             const char *const      *lines,
+                             size_t                  n) {
+
+    char *const key = __query_history_normalize(query, query_str);
+    if (!key)
+        return 1;
+
+    /* Calculate needed memory, and avoid caching results that don't fit in the budget */
+    size_t lines_size = n * sizeof(char *);
+    for (size_t i = 0; i < n; ++i)
+        lines_size += strlen(lines[i]) + 1;
+
+    const size_t memory = sizeof(query_history_result_t) + strlen(key) + 1 + lines_size;
+    if (memory > history->memory_budget) {
+        g_free(key);
+        return 0;
+    }
+
+    query_history_result_t *const existing = g_hash_table_lookup(history->results, key);
+    if (existing)
+        __query_history_remove_result(history, existing);
+
+    while (history->memory + memory > history->memory_budget)
+        __query_history_remove_result(history, g_queue_peek_tail(&history->lru));
+
+    query_history_result_t *const result = malloc(sizeof(query_history_result_t));
+    if (!result)
+        goto DEFER_1;
+
+    /* Copy all lines to a single allocation */
+    result->lines = malloc(lines_size);
+    if (!result->lines)
+        goto DEFER_2;
+
+    char *copy = (char *) (result->lines + n);
+    for (size_t i = 0; i < n; ++i) {
+        const size_t length = strlen(lines[i]) + 1;
+        memcpy(copy, lines[i], length);
+        result->lines[i] = copy;
+        copy += length;
+    }
+
+    result->key       = key;
+    result->n         = n;
+    result->memory    = memory;
+    result->link.data = result;
+    g_queue_push_head_link(&history->lru, &result->link);
+    g_hash_table_insert(history->results, key, result);
+    history->memory += memory;
+    return 0;
+
+DEFER_2:
+    free(result);
+DEFER_1:
+    g_free(key);
+    return 1;
+}
+
+const char *const *query_history_lookup_result(query_history_t        *history,
+                                               const query_instance_t *query,
+                                               const char             *query_str,
+                                               size_t                 *n) {
+
+    char *const key = __query_history_normalize(query, query_str);
+    if (!key)
+        return NULL;
+
+    query_history_result_t *const result = g_hash_table_lookup(history->results, key);
+    g_free(key);
+    if (!result)
+        return NULL;
+
+    /* Mark as most recently used */
+    g_queue_unlink(&history->lru, &result->link);
+    g_queue_push_head_link(&history->lru, &result->link);
+
+    *n = result->n;
+    return (const char *const *) result->lines;
+}
+
+void query_history_clear_results(query_history_t *history) {
+    while (!g_queue_is_empty(&history->lru))
+        __query_history_remove_result(history, g_queue_peek_head(&history->lru));
+}
+
+size_t query_history_get_memory_usage(const query_history_t *history) {
+    size_t total = sizeof(query_history_t) + history->memory +
+                   history->queries->len * sizeof(gpointer);
+    for (size_t i = 0; i < history->queries->len; ++i)
+        total += strlen(g_ptr_array_index(history->queries, i)) + 1;
+    return total;
+}
+
+void query_history_free(query_history_t *history) {
+    query_history_clear_results(history);
+    g_hash_table_unref(history->results);
+    g_ptr_array_unref(history->queries);
+    free(history);
+}
@@ -22,10 +22,29 @@
  * See [the header file's documentation](@ref query_instance_examples).
  */
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "queries/query_instance.h"
 
+/**
+ * @union query_instance_argument_data_t
+ * @brief Storage for the arguments of a query, aligned for any of the types they may contain.
+ *
+ * @var query_instance_argument_data_t::pointer
+ *     @brief Alignment for pointers.
+ * @var query_instance_argument_data_t::integer
+ *     @brief Alignment for integers.
+ * @var query_instance_argument_data_t::real
+ *     @brief Alignment for floating-point numbers.
+ */
+typedef union {
+    void    *pointer;
+    uint64_t integer;
+    double   real;
+} query_instance_argument_data_t;
+
 /**
  * @struct query_instance
  * @brief  Instance of a query (in a file, or inputted by the user).
@@ -35,45 +54,132 @@
  *            line.
  * @var query_instance::formatted
  *     @brief If the query's output should be formatted (pretty printed).
+ * @var query_instance::approximate
+ *     @brief If the query's output can be approximate (see ::query_instance_set_approximate).
  * @var query_instance::line_in_file
  *     @brief The number of the line this query is in the input file (`1` for interactive mode).
+ * @var query_instance::offset
+ *     @brief Number of objects at the beginning of the query's output to be left out.
+ * @var query_instance::limit
+ *     @brief Maximum number of objects to be outputted (::QUERY_INSTANCE_NO_LIMIT for all).
  * @var query_instance::argument_data
  *     @brief The arguments of this query, after being parsed by the specific query type.
+ * @var query_instance::arguments_hash
+ *     @brief FNV-1a hash of the arguments ::query_instance::argument_data was parsed from.
+ * @var query_instance::arguments
+ *     @brief The arguments ::query_instance::argument_data was parsed from, each followed by its
+ *            null terminator (`NULL` when there are none).
+ * @var query_instance::arguments_size
+ *     @brief Number of bytes in ::query_instance::arguments.
+ * @var query_instance::has_argument_data
+ *     @brief Whether ::query_instance::argument_data has been successfully parsed.
+ * @var query_instance::owns_argument_data
+ *     @brief Whether data referred to by ::query_instance::argument_data must be `free`d.
+ * @var query_instance::owns_arguments
+ *     @brief Whether ::query_instance::arguments must be `free`d.
+ * @var query_instance::owns_itself
+ *     @brief Whether this instance was allocated with `malloc`, and not in a pool.
  */
 struct query_instance {
-    const query_type_t *type;
-    int                 formatted;
-    size_t              line_in_file;
-    void               *argument_data;
+    const query_type_t            *type;
+    int                            formatted;
+    int                            approximate;
+    size_t                         line_in_file;
+    size_t                         offset, limit;
+    query_instance_argument_data_t argument_data[QUERY_TYPE_ARGUMENTS_MAX_SIZE /
+                                                 sizeof(query_instance_argument_data_t)];
+    uint64_t                       arguments_hash;
+    char                          *arguments;
+    size_t                         arguments_size;
+
+    int has_argument_data, owns_argument_data, owns_arguments, owns_itself;
 };
 
-query_instance_t *query_instance_create(void) {
-    query_instance_t *const ret = malloc(sizeof(query_instance_t));
+query_instance_t *query_instance_create(pool_t *allocator) {
+    query_instance_t *const ret =
+        allocator ? pool_alloc_item(query_instance_t, allocator) : malloc(sizeof(query_instance_t));
     if (!ret)
         return NULL;
 
     /* Invalid data so that deallocations and clones don't deal with uninitialized data. */
-    ret->type          = NULL;
-    ret->argument_data = NULL;
+    ret->type               = NULL;
+    ret->approximate        = 0;
+    ret->offset             = 0;
+    ret->limit              = QUERY_INSTANCE_NO_LIMIT;
+    ret->arguments_hash     = 0;
+    ret->arguments          = NULL;
+    ret->arguments_size     = 0;
+    ret->has_argument_data  = 0;
+    ret->owns_argument_data = 0;
+    ret->owns_arguments     = 0;
+    ret->owns_itself        = allocator == NULL;
     return ret;
 }
 
-query_instance_t *query_instance_clone(const query_instance_t *query) {
-    query_instance_t *const clone = malloc(sizeof(query_instance_t));
+/**
+ * @brief   Allocates space for the unparsed arguments of a query.
+ * @details ::query_instance::arguments is left uninitialized, and ::query_instance::arguments_hash
+ *          isn't updated.
+ *
+ * @param allocator Pool where to allocate the arguments. Can be `NULL`, so that `malloc` is used.
+ * @param query     Query instance to have its arguments allocated.
+ * @param size      Number of bytes to allocate.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __query_instance_allocate_arguments(string_pool_t    *allocator,
+                                        query_instance_t *query,
+                                        size_t            size) {
+    query->arguments      = NULL;
+    query->arguments_size = size;
+    query->owns_arguments = 0;
+    if (!size)
+        return 0;
+
+    query->arguments = allocator ? string_pool_allocate(allocator, size) : malloc(size);
+    if (!query->arguments)
+        return 1;
+    query->owns_arguments = allocator == NULL;
+    return 0;
+}
+
+query_instance_t *query_instance_clone(pool_t                 *allocator,
+                                       string_pool_t          *string_allocator,
+                                       const query_instance_t *query) {
+    query_instance_t *const clone = query_instance_create(allocator);
     if (!clone)
         return NULL;
+
     memcpy(clone, query, sizeof(query_instance_t));
+    clone->owns_argument_data = 0;
+    clone->owns_arguments     = 0;
+    clone->owns_itself        = allocator == NULL;
+
+    if (query->has_argument_data) {
+        if (__query_instance_allocate_arguments(string_allocator, clone, query->arguments_size))
+            goto DEFER_1;
+        if (query->arguments_size)
+            memcpy(clone->arguments, query->arguments, query->arguments_size);
 
-    if (query->type && query->argument_data) {
         const query_type_clone_arguments_callback_t clone_cb =
             query_type_get_clone_arguments_callback(query->type);
-        clone->argument_data = clone_cb(query->argument_data);
-        if (!clone->argument_data) {
-            free(clone);
-            return NULL;
+
+        if (clone_cb) {
+            if (clone_cb(string_allocator, clone->argument_data, query->argument_data))
+                goto DEFER_2;
+            clone->owns_argument_data = string_allocator == NULL;
         }
     }
     return clone;
+
+DEFER_2:
+    if (clone->owns_arguments)
+        free(clone->arguments);
+DEFER_1:
+    if (clone->owns_itself)
+        free(clone);
+    return NULL;
 }
 
 void query_instance_set_type(query_instance_t *query, const query_type_t *type) {
@@ -84,25 +190,118 @@ void query_instance_set_formatted(query_instance_t *query, int formatted) {
     query->formatted = formatted;
 }
 
+void query_instance_set_approximate(query_instance_t *query, int approximate) {
+    query->approximate = approximate;
+}
+
 void query_instance_set_line_in_file(query_instance_t *query, size_t line_in_file) {
     query->line_in_file = line_in_file;
 }
 
-int query_instance_set_argument_data(query_instance_t *query, const void *argument_data) {
-    if (!query->type)
-        return 1;
+void query_instance_set_page(query_instance_t *query, size_t offset, size_t limit) {
+    query->offset = offset;
+    query->limit  = limit;
+}
 
-    if (query->argument_data) {
+/**
+ * @brief Frees the data referred to by the arguments of a query, if it's owned by the query.
+ * @param query Query instance to have its arguments freed.
+ */
+void __query_instance_free_argument_data(query_instance_t *query) {
+    if (query->owns_argument_data) {
         const query_type_free_arguments_callback_t free_cb =
             query_type_get_free_arguments_callback(query->type);
-        free_cb(query->argument_data);
+        if (free_cb)
+            free_cb(query->argument_data);
+    }
+    if (query->owns_arguments)
+        free(query->arguments);
+
+    query->has_argument_data  = 0;
+    query->owns_argument_data = 0;
+    query->owns_arguments     = 0;
+    query->arguments_hash     = 0;
+    query->arguments          = NULL;
+    query->arguments_size     = 0;
+}
+
+/**
+ * @brief Hashes the arguments of a query, before they're parsed.
+ *
+ * @param arguments Arguments of the query, each followed by its null terminator.
+ * @param size      Number of bytes in @p arguments.
+ *
+ * @return The FNV-1a hash of all arguments, including their null terminators.
+ */
+uint64_t __query_instance_hash_arguments(const char *arguments, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char) arguments[i];
+        hash *= 0x100000001b3;
     }
+    return hash;
+}
 
-    query_type_clone_arguments_callback_t clone_cb =
-        query_type_get_clone_arguments_callback(query->type);
-    query->argument_data = clone_cb(argument_data);
-    if (!query->argument_data)
+int query_instance_parse_arguments(string_pool_t    *allocator,
+                                   query_instance_t *query,
+                                   size_t            argc,
+                                   char *const       argv[argc]) {
+    if (!query->type)
         return 1;
+
+    __query_instance_free_argument_data(query);
+
+    /* Copy before parsing, as arguments may be modified by the parser */
+    size_t size = 0;
+    for (size_t i = 0; i < argc; ++i)
+        size += strlen(argv[i]) + 1;
+    if (__query_instance_allocate_arguments(allocator, query, size))
+        return 1;
+
+    char *end = query->arguments;
+    for (size_t i = 0; i < argc; ++i)
+        end = stpcpy(end, argv[i]) + 1;
+
+    const query_type_parse_arguments_callback_t parse_cb =
+        query_type_get_parse_arguments_callback(query->type);
+    if (parse_cb(allocator, query->argument_data, argc, argv)) {
+        __query_instance_free_argument_data(query);
+        return 1;
+    }
+
+    query->arguments_hash     = __query_instance_hash_arguments(query->arguments, size);
+    query->has_argument_data  = 1;
+    query->owns_argument_data = allocator == NULL;
+    return 0;
+}
+
+int query_instance_load_arguments(string_pool_t    *allocator,
+                                  query_instance_t *query,
+                                  const void       *args_data,
+                                  const char       *arguments,
+                                  size_t            arguments_size,
+                                  const char       *contents,
+                                  size_t            size) {
+    if (!query->type)
+        return 1;
+
+    __query_instance_free_argument_data(query);
+    if (__query_instance_allocate_arguments(allocator, query, arguments_size))
+        return 1;
+    if (arguments_size)
+        memcpy(query->arguments, arguments, arguments_size);
+    memcpy(query->argument_data, args_data, QUERY_TYPE_ARGUMENTS_MAX_SIZE);
+
+    const query_type_load_arguments_callback_t load_cb =
+        query_type_get_load_arguments_callback(query->type);
+    if (load_cb ? load_cb(allocator, query->argument_data, contents, size) : size != 0) {
+        __query_instance_free_argument_data(query);
+        return 1;
+    }
+
+    query->arguments_hash     = __query_instance_hash_arguments(arguments, arguments_size);
+    query->has_argument_data  = 1;
+    query->owns_argument_data = allocator == NULL;
     return 0;
 }
 
@@ -114,19 +313,57 @@ int query_instance_get_formatted(const query_instance_t *query) {
     return query->formatted;
 }
 
+int query_instance_get_approximate(const query_instance_t *query) {
+    return query->approximate;
+}
+
+int query_instance_are_all_approximate(size_t n, const query_instance_t *const instances[n]) {
+    for (size_t i = 0; i < n; ++i)
+        if (!instances[i]->approximate)
+            return 0;
+    return n > 0;
+}
+
 size_t query_instance_get_line_in_file(const query_instance_t *query) {
     return query->line_in_file;
 }
 
+size_t query_instance_get_offset(const query_instance_t *query) {
+    return query->offset;
+}
+
+size_t query_instance_get_limit(const query_instance_t *query) {
+    return query->limit;
+}
+
 const void *query_instance_get_argument_data(const query_instance_t *query) {
     return query->argument_data;
 }
 
+uint64_t query_instance_get_arguments_hash(const query_instance_t *query) {
+    return query->arguments_hash;
+}
+
+const char *query_instance_get_arguments(const query_instance_t *query, size_t *size) {
+    *size = query->arguments_size;
+    return query->arguments;
+}
+
+int query_instance_is_same_query(const query_instance_t *a, const query_instance_t *b) {
+    /* The hash only rules out most different queries: the arguments must be compared too */
+    return a->has_argument_data && b->has_argument_data && a->type == b->type &&
+           a->formatted == b->formatted && a->approximate == b->approximate &&
+           a->offset == b->offset && a->limit == b->limit &&
+           a->arguments_hash == b->arguments_hash && a->arguments_size == b->arguments_size &&
+           (!a->arguments_size || !memcmp(a->arguments, b->arguments, a->arguments_size));
+}
+
+size_t query_instance_sizeof(void) {
+    return sizeof(query_instance_t);
+}
+
 void query_instance_free(query_instance_t *query) {
-    if (query->type && query->argument_data) {
-        const query_type_free_arguments_callback_t free_cb =
-            query_type_get_free_arguments_callback(query->type);
-        free_cb(query->argument_data);
-    }
-    free(query);
+    __query_instance_free_argument_data(query);
+    if (query->owns_itself)
+        free(query);
 }
@@ -26,116 +26,336 @@
 #include <stdint.h>
 
 #include "queries/query_instance_list.h"
+#include "queries/query_type_list.h"
 
 /**
  * @struct query_instance_list
- * @brief  A container for a sorted list of ::query_instance_t.
+ * @brief  A container for a list of ::query_instance_t, grouped by query type.
  *
- * @var query_instance_list::list
- *     @brief Actual sorted list of ::query_instance_t.
+ * @var query_instance_list::types
+ *     @brief   Array of ::query_instance_t for each query type (index is the type number minus
+ *              one). `NULL` for types without queries.
+ *     @details Queries are placed in their type's array as soon as they're added, so that no
+ *              sorting is needed to group them.
+ * @var query_instance_list::pools
+ *     @brief   Pools where the query instances of each type are allocated (index is the type
+ *              number minus one). `NULL` for types without queries.
+ *     @details Instances of the same type (and the arguments inside them) are contiguous in
+ *              memory, so that iterating through all queries of a type is cache-friendly.
  * @var query_instance_list::sorted
- *     @brief If the list is sorted. When performing an iteration, the array will be sorted so that
- *            this becomes `1`.
+ *     @brief Whether each array in ::query_instance_list::types is ordered by line in the file.
+ *            This only isn't the case when queries are added out of order.
+ * @var query_instance_list::pending
+ *     @brief   Last instance created by ::query_instance_list_add_empty (or `NULL`).
+ *     @details Its type isn't known until it's filled in, so it's allocated in
+ *              ::query_instance_list::staging, and only copied to its type's pool and placed in
+ *              ::query_instance_list::types when the list is next used.
+ * @var query_instance_list::last_type
+ *     @brief Index in ::query_instance_list::types of the array the last instance was added to.
+ * @var query_instance_list::length
+ *     @brief Number of instances in all arrays of ::query_instance_list::types.
+ * @var query_instance_list::staging
+ *     @brief Pool where ::query_instance_list::pending is allocated. It's emptied every time the
+ *            pending instance is placed.
+ * @var query_instance_list::strings
+ *     @brief Pool where strings in the arguments of the query instances are allocated.
+ * @var query_instance_list::merged
+ *     @brief   Lists merged into this one with ::query_instance_list_merge (or `NULL`, if none).
+ *     @details Their instances are placed in ::query_instance_list::types, but they're still
+ *              allocated in the pools of these lists, freed alongside this one.
  */
 struct query_instance_list {
-    GPtrArray *list;
-    int        sorted;
+    GPtrArray        *types[QUERY_TYPE_LIST_COUNT];
+    pool_t           *pools[QUERY_TYPE_LIST_COUNT];
+    int               sorted[QUERY_TYPE_LIST_COUNT];
+    query_instance_t *pending;
+    size_t            last_type, length;
+
+    pool_t        *staging;
+    string_pool_t *strings;
+    GPtrArray     *merged;
 };
 
+/** @brief Number of query instances in each block of the pools in ::query_instance_list::pools. */
+#define QUERY_INSTANCE_LIST_INSTANCES_POOL_BLOCK_CAPACITY 1024
+
+/** @brief Number of characters in each block of ::query_instance_list::strings. */
+#define QUERY_INSTANCE_LIST_STRINGS_POOL_BLOCK_CAPACITY 16384
+
 query_instance_list_t *query_instance_list_create(void) {
     query_instance_list_t *const list = malloc(sizeof(query_instance_list_t));
     if (!list)
         return NULL;
 
-    list->list   = g_ptr_array_new_with_free_func((GDestroyNotify) query_instance_free);
-    list->sorted = 1;
+    list->staging = pool_create_from_size(query_instance_sizeof(), 1);
+    if (!list->staging)
+        goto DEFER_1;
+
+    list->strings = string_pool_create(QUERY_INSTANCE_LIST_STRINGS_POOL_BLOCK_CAPACITY);
+    if (!list->strings)
+        goto DEFER_2;
+
+    /* Instances don't own any memory, as it's all in the pools */
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        list->types[i]  = NULL;
+        list->pools[i]  = NULL;
+        list->sorted[i] = 1;
+    }
+    list->pending   = NULL;
+    list->last_type = 0;
+    list->length    = 0;
+    list->merged    = NULL;
     return list;
+
+DEFER_2:
+    pool_free(list->staging);
+DEFER_1:
+    free(list);
+    return NULL;
+}
+
+/**
+ * @brief Gets the array of instances of a query type, creating it (and its pool) if needed.
+ *
+ * @param list List of query instances.
+ * @param i    Index of the query type in ::query_instance_list::types.
+ *
+ * @return The array of instances of the query type, or `NULL` on allocation failure.
+ */
+GPtrArray *__query_instance_list_get_bucket(query_instance_list_t *list, size_t i) {
+    if (!list->types[i]) {
+        list->pools[i] = pool_create_from_size(query_instance_sizeof(),
+                                               QUERY_INSTANCE_LIST_INSTANCES_POOL_BLOCK_CAPACITY);
+        if (!list->pools[i])
+            return NULL;
+        list->types[i] = g_ptr_array_new();
+    }
+    return list->types[i];
+}
+
+/**
+ * @brief   Copies a query instance to the pool of its type, and places it at the end of its type's
+ *          array.
+ * @details The copy is shallow, so @p instance mustn't own its arguments.
+ *
+ * @param list     List of query instances to be modified.
+ * @param instance Instance to be placed in @p list.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure or @p instance without a valid type (@p list is left unchanged).
+ */
+int __query_instance_list_place(query_instance_list_t *list, const query_instance_t *instance) {
+    const query_type_t *const type = query_instance_get_type(instance);
+    if (!type)
+        return 1;
+
+    const size_t i = query_type_get_type_number(type) - 1;
+    if (i >= QUERY_TYPE_LIST_COUNT)
+        return 1;
+
+    GPtrArray *const bucket = __query_instance_list_get_bucket(list, i);
+    if (!bucket)
+        return 1;
+
+    query_instance_t *const placed = pool_put_item(query_instance_t, list->pools[i], instance);
+    if (!placed)
+        return 1;
+
+    if (bucket->len && query_instance_get_line_in_file(placed) <
+                           query_instance_get_line_in_file(g_ptr_array_index(bucket,
+                                                                             bucket->len - 1)))
+        list->sorted[i] = 0;
+
+    g_ptr_array_add(bucket, placed);
+    list->last_type = i;
+    list->length++;
+    return 0;
 }
 
-/** @brief `GCopyFunc` to copy a ::query_instance_t. */
-gpointer __query_instance_list_copy_query_instance(gconstpointer instance, gpointer user_data) {
-    (void) user_data;
-    return query_instance_clone(instance);
+/**
+ * @brief   Places the instance created by the last call to ::query_instance_list_add_empty (if
+ *          any) in the array of its type.
+ * @details Instances that were never filled in (without a valid type) are discarded.
+ *
+ * @param list List of query instances to be modified.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (the pending instance is lost).
+ */
+int __query_instance_list_place_pending(query_instance_list_t *list) {
+    if (!list->pending)
+        return 0;
+
+    const int retval = query_instance_get_type(list->pending) &&
+                       __query_instance_list_place(list, list->pending);
+    list->pending    = NULL;
+    pool_empty(list->staging);
+    return retval;
 }
 
 query_instance_list_t *query_instance_list_clone(const query_instance_list_t *list) {
-    query_instance_list_t *const clone = malloc(sizeof(query_instance_list_t));
+    query_instance_list_t *const clone = query_instance_list_create();
     if (!clone)
         return NULL;
 
-    clone->sorted = list->sorted;
-    clone->list   = g_ptr_array_copy(list->list, __query_instance_list_copy_query_instance, NULL);
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        if (!list->types[i])
+            continue;
+
+        for (size_t j = 0; j < list->types[i]->len; ++j) {
+            if (query_instance_list_add(clone, g_ptr_array_index(list->types[i], j))) {
+                query_instance_list_free(clone);
+                return NULL;
+            }
+        }
+    }
+
+    if (list->pending && query_instance_get_type(list->pending) &&
+        query_instance_list_add(clone, list->pending)) {
+        query_instance_list_free(clone);
+        return NULL;
+    }
+
     return clone;
 }
 
 int query_instance_list_add(query_instance_list_t *list, const query_instance_t *query) {
-    query_instance_t *const clone = query_instance_clone(query);
+    if (__query_instance_list_place_pending(list))
+        return 1;
+
+    /* Clone to the staging pool, so that the clone can then be placed in its type's pool */
+    query_instance_t *const clone = query_instance_clone(list->staging, list->strings, query);
     if (!clone)
         return 1;
 
-    g_ptr_array_add(list->list, clone);
-    list->sorted = 0;
-    return 0;
+    const int retval = __query_instance_list_place(list, clone);
+    pool_empty(list->staging);
+    return retval;
 }
 
-/** @brief Compares two query instances to order them by type. */
-gint __query_instance_list_compare(gconstpointer a, gconstpointer b) {
-    const ssize_t crit1 = (ssize_t) query_instance_get_type(*(const query_instance_t *const *) a) -
-                          (ssize_t) query_instance_get_type(*(const query_instance_t *const *) b);
-    if (crit1)
-        return crit1;
-
-    const ssize_t crit2 =
-        (ssize_t) query_instance_get_line_in_file(*(const query_instance_t *const *) a) -
-        (ssize_t) query_instance_get_line_in_file(*(const query_instance_t *const *) b);
-    return crit2;
+query_instance_t *query_instance_list_add_empty(query_instance_list_t *list,
+                                                string_pool_t        **string_allocator) {
+    if (__query_instance_list_place_pending(list))
+        return NULL;
+
+    query_instance_t *const instance = query_instance_create(list->staging);
+    if (!instance)
+        return NULL;
+
+    list->pending     = instance;
+    *string_allocator = list->strings;
+    return instance;
 }
 
-int query_instance_list_iter_types(query_instance_list_t                  *list,
-                                   query_instance_list_iter_types_callback callback,
-                                   void                                   *user_data) {
-    if (!list->sorted) {
-        g_ptr_array_sort(list->list, __query_instance_list_compare);
-        list->sorted = 1;
+void query_instance_list_remove_last(query_instance_list_t *list) {
+    if (list->pending) {
+        list->pending = NULL;
+        pool_empty(list->staging);
+    } else {
+        GPtrArray *const bucket = list->types[list->last_type];
+        g_ptr_array_set_size(bucket, bucket->len - 1);
+        list->length--;
     }
+}
 
-    if (list->list->len == 0) /* Don't fail on edge case */
-        return 0;
+int query_instance_list_merge(query_instance_list_t *list,
+                              query_instance_list_t *other,
+                              size_t                 line_offset) {
+    if (__query_instance_list_place_pending(list) || __query_instance_list_place_pending(other))
+        goto DEFER_1;
 
-    query_instance_t *instance = g_ptr_array_index(list->list, 0);
+    if (!list->merged)
+        list->merged = g_ptr_array_new();
 
-    size_t              current_set_start = 0;
-    const query_type_t *current_set_type  = query_instance_get_type(instance); /* First instance */
-    size_t              current_set_count = 1;
+    /* Check for allocation failures before any instance is moved */
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
+        if (other->types[i] && other->types[i]->len && !__query_instance_list_get_bucket(list, i))
+            goto DEFER_1;
 
-    for (size_t i = 1; i < list->list->len; ++i) {
-        instance                 = g_ptr_array_index(list->list, i);
-        const query_type_t *type = query_instance_get_type(instance);
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        GPtrArray *const from = other->types[i];
+        if (!from || from->len == 0)
+            continue;
 
-        if (type == current_set_type) {
-            current_set_count++;
-        } else {
-            if (current_set_count > 0) {
-                const query_instance_t *const *current_set =
-                    (const query_instance_t *const *) &g_ptr_array_index(list->list,
-                                                                         current_set_start);
+        GPtrArray *const to = list->types[i];
+        for (size_t j = 0; j < from->len; ++j) {
+            query_instance_t *const instance = g_ptr_array_index(from, j);
+            const size_t            line     = query_instance_get_line_in_file(instance);
+            query_instance_set_line_in_file(instance, line + line_offset);
+        }
 
-                const int cb_ret = callback(user_data, current_set_count, current_set);
-                if (cb_ret)
-                    return cb_ret;
-            }
+        const query_instance_t *const first = g_ptr_array_index(from, 0);
+        if (!other->sorted[i] ||
+            (to->len && query_instance_get_line_in_file(first) <
+                            query_instance_get_line_in_file(g_ptr_array_index(to, to->len - 1))))
+            list->sorted[i] = 0;
 
-            current_set_count = 1;
-            current_set_start = i;
-            current_set_type  = type;
-        }
+        for (size_t j = 0; j < from->len; ++j)
+            g_ptr_array_add(to, g_ptr_array_index(from, j));
     }
 
-    const query_instance_t *const *current_set =
-        (const query_instance_t *const *) &g_ptr_array_index(list->list, current_set_start);
-    const int cb_ret = callback(user_data, current_set_count, current_set);
-    if (cb_ret)
-        return cb_ret;
+    if (other->length) {
+        list->last_type = other->last_type;
+        list->length += other->length;
+    }
+
+    g_ptr_array_add(list->merged, other);
+    return 0;
+
+DEFER_1:
+    query_instance_list_free(other);
+    return 1;
+}
+
+/** @brief Compares two query instances to order them by line in the file. */
+gint __query_instance_list_compare(gconstpointer a, gconstpointer b) {
+    const size_t line_a = query_instance_get_line_in_file(*(const query_instance_t *const *) a);
+    const size_t line_b = query_instance_get_line_in_file(*(const query_instance_t *const *) b);
+    return (line_a > line_b) - (line_a < line_b);
+}
+
+/**
+ * @brief   Gets the array of instances of a query type, ordered by line in the file.
+ * @details Arrays are only sorted if instances were added out of order.
+ *
+ * @param list List of query instances.
+ * @param i    Index of the query type in ::query_instance_list::types.
+ * @param n    Where to output the number of instances in the array to.
+ *
+ * @return The instances of the query type, or `NULL` if there are none.
+ */
+const query_instance_t *const *
+    __query_instance_list_get_type(query_instance_list_t *list, size_t i, size_t *n) {
+    GPtrArray *const bucket = list->types[i];
+    if (!bucket || bucket->len == 0)
+        return NULL;
+
+    if (!list->sorted[i]) {
+        g_ptr_array_sort(bucket, __query_instance_list_compare);
+        list->sorted[i] = 1;
+    }
+
+    *n = bucket->len;
+    return (const query_instance_t *const *) bucket->pdata;
+}
+
+int query_instance_list_iter_types(query_instance_list_t                  *list,
+                                   query_instance_list_iter_types_callback callback,
+                                   void                                   *user_data) {
+    if (__query_instance_list_place_pending(list))
+        return 1;
+
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        size_t                               n;
+        const query_instance_t *const *const instances =
+            __query_instance_list_get_type(list, i, &n);
+        if (!instances)
+            continue;
+
+        const int cb_ret = callback(user_data, n, instances);
+        if (cb_ret)
+            return cb_ret;
+    }
 
     return 0;
 }
@@ -143,24 +363,43 @@ int query_instance_list_iter_types(query_instance_list_t                  *list,
 int query_instance_list_iter(query_instance_list_t            *list,
                              query_instance_list_iter_callback callback,
                              void                             *user_data) {
-    if (!list->sorted) {
-        g_ptr_array_sort(list->list, __query_instance_list_compare);
-        list->sorted = 1;
-    }
+    if (__query_instance_list_place_pending(list))
+        return 1;
+
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        size_t                               n;
+        const query_instance_t *const *const instances =
+            __query_instance_list_get_type(list, i, &n);
+        if (!instances)
+            continue;
 
-    for (size_t i = 0; i < list->list->len; ++i) {
-        const int retval = callback(user_data, g_ptr_array_index(list->list, i));
-        if (retval)
-            return retval;
+        for (size_t j = 0; j < n; ++j) {
+            const int retval = callback(user_data, instances[j]);
+            if (retval)
+                return retval;
+        }
     }
     return 0;
 }
 
 size_t query_instance_list_get_length(const query_instance_list_t *list) {
-    return list->list->len;
+    return list->length + (list->pending && query_instance_get_type(list->pending));
 }
 
 void query_instance_list_free(query_instance_list_t *list) {
-    g_ptr_array_unref(list->list);
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        if (list->types[i]) {
+            g_ptr_array_unref(list->types[i]);
+            pool_free(list->pools[i]);
+        }
+    }
+    if (list->merged) {
+        for (size_t i = 0; i < list->merged->len; ++i)
+            query_instance_list_free(g_ptr_array_index(list->merged, i));
+        g_ptr_array_unref(list->merged);
+    }
+
+    pool_free(list->staging);
+    string_pool_free(list->strings);
     free(list);
 }
@@ -0,0 +1,549 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  query_output_cache.c
+ * @brief Implementation of methods in include/queries/query_output_cache.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref query_output_cache_examples).
+ */
+
+#include <glib.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queries/query_output_cache.h"
+
+/** @brief Number of shards in a ::query_output_cache_t. Must be a power of two. */
+#define QUERY_OUTPUT_CACHE_SHARDS 16
+
+/** @brief Number of rows (hash functions) of the frequency sketch of every shard. */
+#define QUERY_OUTPUT_CACHE_SKETCH_ROWS 4
+
+/** @brief Maximum value of a counter in the frequency sketch. */
+#define QUERY_OUTPUT_CACHE_SKETCH_MAX 15
+
+/** @brief Expected average memory usage of an output, to size the frequency sketch. */
+#define QUERY_OUTPUT_CACHE_EXPECTED_ENTRY_SIZE 256
+
+/**
+ * @brief Number of lookups, per sketch column, after which all frequencies are halved, so that
+ *        they only reflect recent popularity.
+ */
+#define QUERY_OUTPUT_CACHE_SAMPLE_FACTOR 10
+
+/**
+ * @brief   Fraction of a shard's capacity a single output may take.
+ * @details Larger outputs would flush too many others out of the cache.
+ */
+#define QUERY_OUTPUT_CACHE_MAX_ENTRY_FRACTION 8
+
+/**
+ * @struct query_output_cache_entry_t
+ * @brief  A cached output, and what identifies its query.
+ *
+ * @var query_output_cache_entry_t::database
+ *     @brief Database the query was executed on.
+ * @var query_output_cache_entry_t::type
+ *     @brief Type of the query.
+ * @var query_output_cache_entry_t::arguments_hash
+ *     @brief Hash of the query's arguments (see ::query_instance_get_arguments_hash).
+ * @var query_output_cache_entry_t::arguments
+ *     @brief   The query's arguments (see ::query_instance_get_arguments).
+ *     @details In entries in the cache, they're stored right after the entry.
+ * @var query_output_cache_entry_t::arguments_size
+ *     @brief Number of bytes in ::query_output_cache_entry_t::arguments.
+ * @var query_output_cache_entry_t::offset
+ *     @brief Number of results the query skips (see ::query_instance_set_page).
+ * @var query_output_cache_entry_t::limit
+ *     @brief Maximum number of results of the query (see ::query_instance_set_page).
+ * @var query_output_cache_entry_t::formatted
+ *     @brief Whether the query's output is formatted.
+ * @var query_output_cache_entry_t::approximate
+ *     @brief Whether the query's output may be approximate.
+ * @var query_output_cache_entry_t::hash
+ *     @brief Hash of all fields above.
+ * @var query_output_cache_entry_t::output
+ *     @brief Output of the query, with every line ending in `'\n'`. Not null-terminated.
+ * @var query_output_cache_entry_t::length
+ *     @brief Number of bytes in ::query_output_cache_entry_t::output.
+ * @var query_output_cache_entry_t::nlines
+ *     @brief Number of lines in ::query_output_cache_entry_t::output.
+ * @var query_output_cache_entry_t::previous
+ *     @brief More recently used entry in the same shard, or `NULL`.
+ * @var query_output_cache_entry_t::next
+ *     @brief Less recently used entry in the same shard, or `NULL`.
+ */
+typedef struct query_output_cache_entry {
+    const database_t   *database;
+    const query_type_t *type;
+    uint64_t            arguments_hash;
+    const char         *arguments;
+    size_t              arguments_size;
+    size_t              offset, limit;
+    int                 formatted, approximate;
+    uint64_t            hash;
+
+    char  *output;
+    size_t length, nlines;
+
+    struct query_output_cache_entry *previous, *next;
+} query_output_cache_entry_t;
+
+/**
+ * @struct query_output_cache_shard_t
+ * @brief  Part of a ::query_output_cache_t, with its own lock.
+ *
+ * @var query_output_cache_shard_t::lock
+ *     @brief Lock that protects all other fields.
+ * @var query_output_cache_shard_t::entries
+ *     @brief Set of ::query_output_cache_entry_t, owned by the shard.
+ * @var query_output_cache_shard_t::head
+ *     @brief Most recently used entry, or `NULL` if the shard is empty.
+ * @var query_output_cache_shard_t::tail
+ *     @brief Least recently used entry (the next to be evicted), or `NULL` if the shard is empty.
+ * @var query_output_cache_shard_t::size
+ *     @brief Memory used by all entries, in bytes.
+ * @var query_output_cache_shard_t::capacity
+ *     @brief Maximum value of ::query_output_cache_shard_t::size.
+ * @var query_output_cache_shard_t::sketch
+ *     @brief   Count-min sketch of the lookup frequencies of queries.
+ *     @details ::QUERY_OUTPUT_CACHE_SKETCH_ROWS rows of ::query_output_cache_shard_t::width
+ *              counters, one after the other.
+ * @var query_output_cache_shard_t::width
+ *     @brief Number of counters in each row of ::query_output_cache_shard_t::sketch (a power of
+ *            two).
+ * @var query_output_cache_shard_t::samples
+ *     @brief Number of lookups counted in the sketch since it was last halved.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+
+    GHashTable                 *entries;
+    query_output_cache_entry_t *head, *tail;
+    size_t                      size, capacity;
+
+    uint8_t *sketch;
+    size_t   width, samples;
+} query_output_cache_shard_t;
+
+/**
+ * @struct query_output_cache
+ * @brief  Outputs of popular queries, kept in memory.
+ *
+ * @var query_output_cache::generation
+ *     @brief Incremented (atomically) every time the cache is invalidated.
+ * @var query_output_cache::shards
+ *     @brief Shards of the cache, chosen by the hash of each query.
+ */
+struct query_output_cache {
+    gint                       generation;
+    query_output_cache_shard_t shards[QUERY_OUTPUT_CACHE_SHARDS];
+};
+
+/**
+ * @brief Hashes a cache entry, for a `GHashTable`.
+ * @param entry A pointer to a ::query_output_cache_entry_t.
+ * @return The hash of @p entry.
+ */
+guint __query_output_cache_entry_hash(gconstpointer entry) {
+    return (guint) ((const query_output_cache_entry_t *) entry)->hash;
+}
+
+/**
+ * @brief Checks if two cache entries are outputs of the same query, for a `GHashTable`.
+ *
+ * @param a A pointer to a ::query_output_cache_entry_t.
+ * @param b A pointer to another ::query_output_cache_entry_t.
+ *
+ * @return Whether @p a and @p b identify the same query (their outputs aren't compared).
+ */
+gboolean __query_output_cache_entry_equal(gconstpointer a, gconstpointer b) {
+    const query_output_cache_entry_t *const x = a;
+    const query_output_cache_entry_t *const y = b;
+    return x->hash == y->hash && x->database == y->database && x->type == y->type &&
+           x->arguments_hash == y->arguments_hash && x->offset == y->offset &&
+           x->limit == y->limit && x->formatted == y->formatted &&
+           x->approximate == y->approximate && x->arguments_size == y->arguments_size &&
+           (!x->arguments_size || !memcmp(x->arguments, y->arguments, x->arguments_size));
+}
+
+/**
+ * @brief Frees a cache entry, for a `GHashTable`.
+ * @param entry A pointer to a ::query_output_cache_entry_t.
+ */
+void __query_output_cache_entry_free(gpointer entry) {
+    free(((query_output_cache_entry_t *) entry)->output);
+    free(entry);
+}
+
+/**
+ * @brief  Gets the memory used by a cache entry, counted towards its shard's capacity.
+ * @param  length Number of bytes in the entry's output and arguments.
+ * @return The memory used by the entry, including an estimate of the hash table's overhead.
+ */
+size_t __query_output_cache_entry_size(size_t length) {
+    return sizeof(query_output_cache_entry_t) + length + 4 * sizeof(void *);
+}
+
+/**
+ * @brief  Mixes the bits of a 64-bit integer (SplitMix64's finalizer).
+ * @param  x Integer to be mixed.
+ * @return A value whose every bit depends on all bits of @p x.
+ */
+uint64_t __query_output_cache_mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief   Fills the fields of a cache entry that identify a query.
+ * @details The output of the entry isn't initialized.
+ *
+ * @param entry    Entry to be initialized.
+ * @param database Database @p query is executed on.
+ * @param query    Query identified by @p entry.
+ */
+void __query_output_cache_entry_init(query_output_cache_entry_t *entry,
+                                     const database_t           *database,
+                                     const query_instance_t     *query) {
+    entry->database       = database;
+    entry->type           = query_instance_get_type(query);
+    entry->arguments_hash = query_instance_get_arguments_hash(query);
+    entry->arguments      = query_instance_get_arguments(query, &entry->arguments_size);
+    entry->offset         = query_instance_get_offset(query);
+    entry->limit          = query_instance_get_limit(query);
+    entry->formatted      = query_instance_get_formatted(query);
+    entry->approximate    = query_instance_get_approximate(query);
+
+    uint64_t hash = entry->arguments_hash;
+    hash = __query_output_cache_mix(hash ^ (uint64_t) (uintptr_t) entry->database);
+    hash = __query_output_cache_mix(hash ^ (uint64_t) (uintptr_t) entry->type);
+    hash = __query_output_cache_mix(hash ^ entry->offset);
+    hash = __query_output_cache_mix(hash ^ entry->limit);
+    hash = __query_output_cache_mix(hash ^ (uint64_t) (entry->formatted << 1 | entry->approximate));
+    entry->hash = hash;
+}
+
+/**
+ * @brief   Gets the shard a query belongs to.
+ * @details The top bits of the hash are used, as the bottom ones index the sketch and the hash
+ *          table.
+ *
+ * @param cache Cache containing the shard.
+ * @param hash  ::query_output_cache_entry_t::hash of the query.
+ *
+ * @return The shard where @p hash belongs.
+ */
+query_output_cache_shard_t *__query_output_cache_get_shard(query_output_cache_t *cache,
+                                                            uint64_t              hash) {
+    return &cache->shards[(hash >> 58) & (QUERY_OUTPUT_CACHE_SHARDS - 1)];
+}
+
+/**
+ * @brief Gets the index of a query's counter in a row of a shard's frequency sketch.
+ *
+ * @param shard Shard containing the sketch.
+ * @param hash  ::query_output_cache_entry_t::hash of the query.
+ * @param row   Row of the sketch.
+ *
+ * @return The index of the counter in ::query_output_cache_shard_t::sketch.
+ */
+size_t __query_output_cache_sketch_index(const query_output_cache_shard_t *shard,
+                                         uint64_t                          hash,
+                                         size_t                            row) {
+    /* Double hashing, with an odd step so that rows don't collide in the same way */
+    const uint64_t step = (hash >> 32) | 1;
+    return row * shard->width + (size_t) ((hash + row * step) & (shard->width - 1));
+}
+
+/**
+ * @brief   Estimates how many times a query was looked up, recently.
+ * @details ::query_output_cache_shard_t::lock must be held.
+ *
+ * @param shard Shard the query belongs to.
+ * @param hash  ::query_output_cache_entry_t::hash of the query.
+ *
+ * @return The estimated frequency (never less than the real one, up to
+ *         ::QUERY_OUTPUT_CACHE_SKETCH_MAX).
+ */
+uint8_t __query_output_cache_frequency(const query_output_cache_shard_t *shard, uint64_t hash) {
+    uint8_t frequency = QUERY_OUTPUT_CACHE_SKETCH_MAX;
+    for (size_t row = 0; row < QUERY_OUTPUT_CACHE_SKETCH_ROWS; ++row) {
+        const uint8_t counter = shard->sketch[__query_output_cache_sketch_index(shard, hash, row)];
+        if (counter < frequency)
+            frequency = counter;
+    }
+    return frequency;
+}
+
+/**
+ * @brief   Counts a lookup of a query in a shard's frequency sketch.
+ * @details Only the smallest counters are incremented (conservative update), which reduces the
+ *          overestimation of frequencies. ::query_output_cache_shard_t::lock must be held.
+ *
+ * @param shard Shard the query belongs to.
+ * @param hash  ::query_output_cache_entry_t::hash of the query.
+ */
+void __query_output_cache_count(query_output_cache_shard_t *shard, uint64_t hash) {
+    const uint8_t frequency = __query_output_cache_frequency(shard, hash);
+    if (frequency < QUERY_OUTPUT_CACHE_SKETCH_MAX) {
+        for (size_t row = 0; row < QUERY_OUTPUT_CACHE_SKETCH_ROWS; ++row) {
+            uint8_t *const counter =
+                &shard->sketch[__query_output_cache_sketch_index(shard, hash, row)];
+            if (*counter == frequency)
+                (*counter)++;
+        }
+    }
+
+    /* Age all frequencies, so that popularity from long ago is forgotten */
+    if (++shard->samples >= shard->width * QUERY_OUTPUT_CACHE_SAMPLE_FACTOR) {
+        for (size_t i = 0; i < shard->width * QUERY_OUTPUT_CACHE_SKETCH_ROWS; ++i)
+            shard->sketch[i] >>= 1;
+        shard->samples /= 2;
+    }
+}
+
+/**
+ * @brief   Removes an entry from the least-recently-used list of its shard.
+ * @details ::query_output_cache_shard_t::lock must be held.
+ *
+ * @param shard Shard containing @p entry.
+ * @param entry Entry to be unlinked (not `free`d).
+ */
+void __query_output_cache_unlink(query_output_cache_shard_t *shard,
+                                 query_output_cache_entry_t *entry) {
+    if (entry->previous)
+        entry->previous->next = entry->next;
+    else
+        shard->head = entry->next;
+
+    if (entry->next)
+        entry->next->previous = entry->previous;
+    else
+        shard->tail = entry->previous;
+}
+
+/**
+ * @brief   Adds an entry to the start (most recently used) of its shard's list.
+ * @details ::query_output_cache_shard_t::lock must be held.
+ *
+ * @param shard Shard where to add @p entry.
+ * @param entry Entry not in the list.
+ */
+void __query_output_cache_link(query_output_cache_shard_t *shard,
+                               query_output_cache_entry_t *entry) {
+    entry->previous = NULL;
+    entry->next     = shard->head;
+    if (shard->head)
+        shard->head->previous = entry;
+    else
+        shard->tail = entry;
+    shard->head = entry;
+}
+
+/**
+ * @brief   Evicts the least recently used entry of a shard.
+ * @details ::query_output_cache_shard_t::lock must be held, and the shard mustn't be empty.
+ *
+ * @param shard Shard to be modified.
+ */
+void __query_output_cache_evict(query_output_cache_shard_t *shard) {
+    query_output_cache_entry_t *const victim = shard->tail;
+    __query_output_cache_unlink(shard, victim);
+    shard->size -= __query_output_cache_entry_size(victim->length + victim->arguments_size);
+    g_hash_table_remove(shard->entries, victim); /* Frees victim */
+}
+
+query_output_cache_t *query_output_cache_create(size_t capacity) {
+    query_output_cache_t *const cache = malloc(sizeof(query_output_cache_t));
+    if (!cache)
+        return NULL;
+    cache->generation = 0;
+
+    /* Enough columns for every output that fits in a shard, if they had the expected size */
+    const size_t shard_capacity = capacity / QUERY_OUTPUT_CACHE_SHARDS;
+    size_t       width          = 64;
+    while (width < shard_capacity / QUERY_OUTPUT_CACHE_EXPECTED_ENTRY_SIZE)
+        width *= 2;
+
+    size_t i = 0;
+    for (; i < QUERY_OUTPUT_CACHE_SHARDS; ++i) {
+        query_output_cache_shard_t *const shard = &cache->shards[i];
+
+        shard->sketch = calloc(width * QUERY_OUTPUT_CACHE_SKETCH_ROWS, sizeof(uint8_t));
+        if (!shard->sketch)
+            goto DEFER_1;
+        if (pthread_mutex_init(&shard->lock, NULL)) {
+            free(shard->sketch);
+            goto DEFER_1;
+        }
+
+        shard->entries  = g_hash_table_new_full(__query_output_cache_entry_hash,
+                                               __query_output_cache_entry_equal,
+                                               __query_output_cache_entry_free,
+                                               NULL);
+        shard->head     = NULL;
+        shard->tail     = NULL;
+        shard->size     = 0;
+        shard->capacity = shard_capacity;
+        shard->width    = width;
+        shard->samples  = 0;
+    }
+
+    return cache;
+
+DEFER_1:
+    while (i--) {
+        g_hash_table_unref(cache->shards[i].entries);
+        pthread_mutex_destroy(&cache->shards[i].lock);
+        free(cache->shards[i].sketch);
+    }
+    free(cache);
+    return NULL;
+}
+
+unsigned int query_output_cache_get_generation(query_output_cache_t *cache) {
+    return (unsigned int) g_atomic_int_get(&cache->generation);
+}
+
+int query_output_cache_get(query_output_cache_t   *cache,
+                           const database_t       *database,
+                           const query_instance_t *query,
+                           GString                *output,
+                           size_t                 *nlines) {
+    query_output_cache_entry_t key;
+    __query_output_cache_entry_init(&key, database, query);
+    query_output_cache_shard_t *const shard = __query_output_cache_get_shard(cache, key.hash);
+
+    pthread_mutex_lock(&shard->lock);
+    __query_output_cache_count(shard, key.hash);
+
+    query_output_cache_entry_t *const entry = g_hash_table_lookup(shard->entries, &key);
+    if (entry) {
+        __query_output_cache_unlink(shard, entry);
+        __query_output_cache_link(shard, entry);
+        g_string_append_len(output, entry->output, (gssize) entry->length);
+        *nlines = entry->nlines;
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+    return entry == NULL;
+}
+
+void query_output_cache_put(query_output_cache_t   *cache,
+                            unsigned int            generation,
+                            const database_t       *database,
+                            const query_instance_t *query,
+                            const char             *output,
+                            size_t                  length,
+                            size_t                  nlines) {
+    if (!query_instance_get_arguments_hash(query))
+        return;
+
+    size_t arguments_size;
+    query_instance_get_arguments(query, &arguments_size);
+
+    query_output_cache_entry_t *const entry =
+        malloc(sizeof(query_output_cache_entry_t) + arguments_size);
+    if (!entry)
+        return;
+    __query_output_cache_entry_init(entry, database, query);
+    if (arguments_size)
+        entry->arguments = memcpy(entry + 1, entry->arguments, arguments_size);
+
+    query_output_cache_shard_t *const shard = __query_output_cache_get_shard(cache, entry->hash);
+
+    const size_t size = __query_output_cache_entry_size(length + arguments_size);
+    if (size > shard->capacity / QUERY_OUTPUT_CACHE_MAX_ENTRY_FRACTION) {
+        free(entry);
+        return;
+    }
+
+    /* Copied outside the lock, even if the output isn't admitted */
+    entry->output = malloc(length ? length : 1);
+    if (!entry->output) {
+        free(entry);
+        return;
+    }
+    memcpy(entry->output, output, length);
+    entry->length = length;
+    entry->nlines = nlines;
+
+    pthread_mutex_lock(&shard->lock);
+
+    /* Checked inside the lock, as invalidation clears every shard after changing the generation */
+    if ((unsigned int) g_atomic_int_get(&cache->generation) != generation ||
+        g_hash_table_contains(shard->entries, entry))
+        goto DEFER_1;
+
+    /* TinyLFU admission: only evict outputs less popular than the new one */
+    const uint8_t frequency = __query_output_cache_frequency(shard, entry->hash);
+    while (shard->size + size > shard->capacity) {
+        if (__query_output_cache_frequency(shard, shard->tail->hash) >= frequency)
+            goto DEFER_1;
+        __query_output_cache_evict(shard);
+    }
+
+    g_hash_table_add(shard->entries, entry);
+    __query_output_cache_link(shard, entry);
+    shard->size += size;
+    pthread_mutex_unlock(&shard->lock);
+    return;
+
+DEFER_1:
+    pthread_mutex_unlock(&shard->lock);
+    __query_output_cache_entry_free(entry);
+}
+
+void query_output_cache_invalidate(query_output_cache_t *cache) {
+    g_atomic_int_inc(&cache->generation);
+
+    for (size_t i = 0; i < QUERY_OUTPUT_CACHE_SHARDS; ++i) {
+        query_output_cache_shard_t *const shard = &cache->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        g_hash_table_remove_all(shard->entries);
+        shard->head = NULL;
+        shard->tail = NULL;
+        shard->size = 0;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+size_t query_output_cache_get_memory_usage(query_output_cache_t *cache) {
+    size_t size = 0;
+    for (size_t i = 0; i < QUERY_OUTPUT_CACHE_SHARDS; ++i) {
+        pthread_mutex_lock(&cache->shards[i].lock);
+        size += cache->shards[i].size;
+        pthread_mutex_unlock(&cache->shards[i].lock);
+    }
+    return size;
+}
+
+void query_output_cache_free(query_output_cache_t *cache) {
+    for (size_t i = 0; i < QUERY_OUTPUT_CACHE_SHARDS; ++i) {
+        g_hash_table_unref(cache->shards[i].entries);
+        pthread_mutex_destroy(&cache->shards[i].lock);
+        free(cache->shards[i].sketch);
+    }
+    free(cache);
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  query_output_container.c
+ * @brief Implementation of methods in include/queries/query_output_container.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref query_output_container_examples).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "queries/query_output_container.h"
+#include "utils/mapped_file.h"
+
+/**
+ * @struct query_output_container_entry_t
+ * @brief  An entry in the table of a container, exactly as stored in the file.
+ *
+ * @var query_output_container_entry_t::id
+ *     @brief Identifier of the query (its line in the query file).
+ * @var query_output_container_entry_t::offset
+ *     @brief Position of the query's output in the file.
+ * @var query_output_container_entry_t::length
+ *     @brief Number of characters in the query's output.
+ */
+typedef struct {
+    uint64_t id, offset, length;
+} query_output_container_entry_t;
+
+/**
+ * @struct query_output_container_header_t
+ * @brief  Header of a container, exactly as stored in the file.
+ *
+ * @var query_output_container_header_t::magic
+ *     @brief ::QUERY_OUTPUT_CONTAINER_MAGIC, without a null terminator.
+ * @var query_output_container_header_t::count
+ *     @brief Number of entries in the table.
+ * @var query_output_container_header_t::table_offset
+ *     @brief Position of the table in the file.
+ */
+typedef struct {
+    char     magic[8];
+    uint64_t count, table_offset;
+} query_output_container_header_t;
+
+/**
+ * @struct query_output_container
+ * @brief  A container file being written to.
+ *
+ * @var query_output_container::fd
+ *     @brief File descriptor of the container file.
+ * @var query_output_container::lock
+ *     @brief Lock guarding all other fields, so that many threads can add entries at once.
+ * @var query_output_container::end
+ *     @brief Position in the file where the next payload will be written to.
+ * @var query_output_container::entries
+ *     @brief `GArray` of ::query_output_container_entry_t, in the order they were added.
+ * @var query_output_container::failed
+ *     @brief Whether adding any entry failed.
+ * @var query_output_container::closed
+ *     @brief Whether ::query_output_container_close has been called.
+ */
+struct query_output_container {
+    int             fd;
+    pthread_mutex_t lock;
+    uint64_t        end;
+    GArray         *entries;
+    int             failed, closed;
+};
+
+query_output_container_t *query_output_container_create(const char *path) {
+    query_output_container_t *const ret = malloc(sizeof(query_output_container_t));
+    if (!ret)
+        return NULL;
+
+    ret->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (ret->fd < 0) {
+        free(ret);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&ret->lock, NULL)) {
+        close(ret->fd);
+        free(ret);
+        return NULL;
+    }
+
+    ret->end     = sizeof(query_output_container_header_t); /* Written when closing */
+    ret->entries = g_array_new(FALSE, FALSE, sizeof(query_output_container_entry_t));
+    ret->failed  = 0;
+    ret->closed  = 0;
+    return ret;
+}
+
+/**
+ * @brief Writes data to a position in a file, retrying on partial writes.
+ *
+ * @param fd     File to be written to.
+ * @param data   Data to be written.
+ * @param length Number of bytes in @p data.
+ * @param offset Position in the file where to write @p data to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO error.
+ */
+int __query_output_container_pwrite(int fd, const void *data, size_t length, uint64_t offset) {
+    const char *const bytes   = data;
+    size_t            written = 0;
+    while (written < length) {
+        const ssize_t ret = pwrite(fd, bytes + written, length - written, offset + written);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+        written += ret;
+    }
+    return 0;
+}
+
+int query_output_container_add(query_output_container_t *container,
+                               uint64_t                  id,
+                               const char               *payload,
+                               size_t                    length,
+                               uint64_t                 *out_offset) {
+    /* Only reserve space while locked, so that many payloads can be written at once */
+    pthread_mutex_lock(&container->lock);
+    const uint64_t offset = container->end;
+    container->end += length;
+    pthread_mutex_unlock(&container->lock);
+
+    if (__query_output_container_pwrite(container->fd, payload, length, offset)) {
+        pthread_mutex_lock(&container->lock);
+        container->failed = 1;
+        pthread_mutex_unlock(&container->lock);
+        return 1;
+    }
+
+    if (out_offset)
+        *out_offset = offset;
+    return query_output_container_add_link(container, id, offset, length);
+}
+
+int query_output_container_add_link(query_output_container_t *container,
+                                    uint64_t                  id,
+                                    uint64_t                  offset,
+                                    size_t                    length) {
+    const query_output_container_entry_t entry = {.id = id, .offset = offset, .length = length};
+
+    pthread_mutex_lock(&container->lock);
+    g_array_append_val(container->entries, entry);
+    pthread_mutex_unlock(&container->lock);
+    return 0;
+}
+
+/** @brief Compares two ::query_output_container_entry_t by identifier, for sorting. */
+gint __query_output_container_entry_compare(gconstpointer a, gconstpointer b) {
+    const query_output_container_entry_t *const entry_a = a;
+    const query_output_container_entry_t *const entry_b = b;
+    return (entry_a->id > entry_b->id) - (entry_a->id < entry_b->id);
+}
+
+int query_output_container_close(query_output_container_t *container) {
+    if (container->closed)
+        return 0;
+    container->closed = 1;
+
+    g_array_sort(container->entries, __query_output_container_entry_compare);
+
+    query_output_container_header_t header = {.count        = container->entries->len,
+                                              .table_offset = container->end};
+    memcpy(header.magic, QUERY_OUTPUT_CONTAINER_MAGIC, sizeof(header.magic));
+
+    int retval = container->failed;
+    retval |= __query_output_container_pwrite(container->fd,
+                                              container->entries->data,
+                                              sizeof(query_output_container_entry_t) *
+                                                  container->entries->len,
+                                              container->end);
+    retval |= __query_output_container_pwrite(container->fd, &header, sizeof(header), 0);
+    retval |= close(container->fd) != 0;
+    return retval;
+}
+
+void query_output_container_free(query_output_container_t *container) {
+    query_output_container_close(container); /* Ignore IO errors */
+    g_array_unref(container->entries);
+    pthread_mutex_destroy(&container->lock);
+    free(container);
+}
+
+/**
+ * @struct query_output_container_reader
+ * @brief  A container file being read from.
+ *
+ * @var query_output_container_reader::file
+ *     @brief Memory-mapped container file.
+ * @var query_output_container_reader::count
+ *     @brief Number of entries in the table.
+ * @var query_output_container_reader::table
+ *     @brief Pointer to the table in the mapped file. May not be aligned, so entries must be copied
+ *            before being read.
+ */
+struct query_output_container_reader {
+    mapped_file_t *file;
+    size_t         count;
+    const char    *table;
+};
+
+query_output_container_reader_t *query_output_container_reader_open(const char *path) {
+    mapped_file_t *const file = mapped_file_open(path);
+    if (!file)
+        return NULL;
+
+    const char  *contents = mapped_file_get_contents(file);
+    const size_t size     = mapped_file_get_size(file);
+
+    query_output_container_header_t header;
+    if (size < sizeof(header))
+        goto DEFER_1;
+    memcpy(&header, contents, sizeof(header));
+
+    /* Validate the whole file, so that entries can be read without any further checks */
+    if (memcmp(header.magic, QUERY_OUTPUT_CONTAINER_MAGIC, sizeof(header.magic)) ||
+        header.table_offset < sizeof(header) || header.table_offset > size ||
+        (size - header.table_offset) % sizeof(query_output_container_entry_t) ||
+        header.count != (size - header.table_offset) / sizeof(query_output_container_entry_t))
+        goto DEFER_1;
+
+    const char *const table = contents + header.table_offset;
+    for (size_t i = 0; i < header.count; ++i) {
+        query_output_container_entry_t entry;
+        memcpy(&entry, table + i * sizeof(entry), sizeof(entry));
+        if (entry.offset > header.table_offset || entry.length > header.table_offset - entry.offset)
+            goto DEFER_1;
+    }
+
+    query_output_container_reader_t *const ret = malloc(sizeof(query_output_container_reader_t));
+    if (!ret)
+        goto DEFER_1;
+
+    ret->file  = file;
+    ret->count = header.count;
+    ret->table = table;
+    return ret;
+
+DEFER_1:
+    mapped_file_close(file);
+    return NULL;
+}
+
+size_t query_output_container_reader_get_count(const query_output_container_reader_t *reader) {
+    return reader->count;
+}
+
+void query_output_container_reader_get_entry(const query_output_container_reader_t *reader,
+                                             size_t                                 i,
+                                             uint64_t                              *out_id,
+                                             const char                           **out_payload,
+                                             size_t                                *out_length) {
+    query_output_container_entry_t entry;
+    memcpy(&entry, reader->table + i * sizeof(entry), sizeof(entry));
+
+    *out_id      = entry.id;
+    *out_payload = mapped_file_get_contents(reader->file) + entry.offset;
+    *out_length  = entry.length;
+}
+
+void query_output_container_reader_close(query_output_container_reader_t *reader) {
+    mapped_file_close(reader->file);
+    free(reader);
+}
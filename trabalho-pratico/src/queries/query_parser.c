@@ -22,145 +22,179 @@
  * See [the header file's documentation](@ref query_parser_examples).
  */
 
-#include <glib.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "queries/query_parser.h"
 #include "queries/query_tokenizer.h"
 #include "queries/query_type_list.h"
-#include "utils/int_utils.h"
 
 /**
- * @struct query_parser_data_t
- * @brief  State of a query parser.
- *
- * @var query_parser_data_t::output
- *     @brief Query being currently parsed.
- * @var query_parser_data_t::args
- *     @brief Array to store pointers to query arguments (`char *`) to.
- * @var query_parser_data_t::first_token_parsed
- *     @brief Whether the first token (containg the query type) has already been parsed.
- * @var query_parser_data_t::last_terminator
- *     @brief Where a null terminator (``'\0'``) should be placed, so that the previous token ends;
- *            `NULL` if no token has yet been parsed.
+ * @brief Maximum number of arguments in a query (a query with more arguments fails to be parsed).
  */
-typedef struct {
-    query_instance_t *const output;
-    GPtrArray              *args;
-    int                     first_token_parsed;
-    char                   *last_terminator;
-} query_parser_data_t;
+#define QUERY_PARSER_MAX_ARGUMENTS 32
 
 /**
- * @brief   Callback for every token in the query.
- * @details Parses the first token and adds the remaining ones to an array.
+ * @brief   Parses the first token of a query, containing its number and whether it's formatted.
+ * @details Auxiliary method for ::query_parser_parse_string. The number may be followed by `F`
+ *          (formatted output) and / or `A` (approximate output), in any order.
  *
- * @param user_data A pointer to a ::query_parser_data_t.
- * @param token     Current query token being parsed.
+ * @param output Query whose type and format will be set.
+ * @param token  First token of the query.
  *
  * @retval 0 Parsing success.
  * @retval 1 Parsing failure.
  */
-int __query_parser_tokenize_callback(void *user_data, char *token) {
-    query_parser_data_t *const parser = user_data;
+int __query_parser_parse_type(query_instance_t *output, query_tokenizer_span_t token) {
+    size_t length = token.length;
+    if (length == 0)
+        return 1;
 
-    if (!parser->first_token_parsed) { /* First argument: query number */
+    int formatted = 0, approximate = 0;
+    while (length > 0) {
+        const char suffix = token.begin[length - 1];
+        if (suffix == 'F' && !formatted)
+            formatted = 1;
+        else if (suffix == 'A' && !approximate)
+            approximate = 1;
+        else
+            break;
+        length--;
+    }
+    if (length == 0)
+        return 1;
 
-        /* Check if query is formatted */
-        const size_t token_len = strlen(token);
-        if (token_len == 0)
+    uint64_t index = 0;
+    for (size_t i = 0; i < length; ++i) {
+        const unsigned int d = token.begin[i] - '0';
+        if (d >= 10)
             return 1;
+        index = index * 10 + d;
+    }
+
+    const query_type_t *const type = query_type_list_get_by_index((size_t) index);
+    if (!type)
+        return 1;
+
+    query_instance_set_formatted(output, formatted);
+    query_instance_set_approximate(output, approximate);
+    query_instance_set_type(output, type);
+    return 0;
+}
+
+/**
+ * @brief   Parses a non-negative integer in a query token.
+ * @details Auxiliary method for ::__query_parser_parse_page_clause.
+ *
+ * @param token  Token to be parsed.
+ * @param output Where to write the parsed integer to. Nothing is written on failure.
+ *
+ * @retval 0 Parsing success.
+ * @retval 1 Parsing failure (not only decimal digits, or too large a number).
+ */
+int __query_parser_parse_size(query_tokenizer_span_t token, size_t *output) {
+    if (token.length == 0)
+        return 1;
 
-        if (token[token_len - 1] == 'F') {
-            query_instance_set_formatted(parser->output, 1);
-            token[token_len - 1] = '\0';
-        } else {
-            query_instance_set_formatted(parser->output, 0);
-        }
-
-        /* Parse number of query */
-        uint64_t                  query_type;
-        const int                 retval = int_utils_parse_positive(&query_type, token);
-        const query_type_t *const type =
-            retval ? NULL : query_type_list_get_by_index((size_t) query_type);
-        if (retval || !type) {
-            if (token[token_len - 1] == '\0') /* Restore previous string form */
-                token[token_len - 1] = 'F';
+    size_t value = 0;
+    for (size_t i = 0; i < token.length; ++i) {
+        const unsigned int d = token.begin[i] - '0';
+        if (d >= 10 || value > (SIZE_MAX - d) / 10)
             return 1;
-        }
-        query_instance_set_type(parser->output, type);
-
-        if (token[token_len - 1] == '\0') /* Restore previous string form */
-            token[token_len - 1] = 'F';
-        parser->first_token_parsed = 1;
-    } else {
-        if (parser->last_terminator)
-            *parser->last_terminator = '\0';
-        parser->last_terminator = token + strlen(token);
-        g_ptr_array_add(parser->args, token);
+        value = value * 10 + d;
     }
+
+    *output = value;
     return 0;
 }
 
-int query_parser_parse_string(query_instance_t *output, char *input, GPtrArray *aux) {
-    query_parser_data_t parser_data = {.output             = output,
-                                       .first_token_parsed = 0,
-                                       .last_terminator    = NULL};
-    if (aux) {
-        g_ptr_array_set_size(aux, 0);
-        parser_data.args = aux;
-    } else {
-        parser_data.args = g_ptr_array_new();
-    }
+/**
+ * @brief   Parses a `keyword <number>` clause at the end of a query's arguments, removing it from
+ *          them.
+ * @details Auxiliary method for ::query_parser_parse_string. Keywords must not be quoted, so that
+ *          an argument can still be the same as a keyword.
+ *
+ * @param input   Query being parsed.
+ * @param tokens  Arguments of the query.
+ * @param argc    Number of arguments in @p tokens. Decremented if the clause is found.
+ * @param keyword Clause's keyword.
+ * @param output  Where to write the clause's number to. Not modified if the clause isn't found.
+ *
+ * @retval 0 Success (including when the clause isn't present).
+ * @retval 1 Invalid number after @p keyword.
+ */
+int __query_parser_parse_page_clause(const char                   *input,
+                                     const query_tokenizer_span_t *tokens,
+                                     size_t                       *argc,
+                                     const char                   *keyword,
+                                     size_t                       *output) {
+    if (*argc < 2)
+        return 0;
+
+    const query_tokenizer_span_t key = tokens[*argc - 2];
+    if (key.length != strlen(keyword) || memcmp(key.begin, keyword, key.length) ||
+        (key.begin > input && key.begin[-1] == '"'))
+        return 0;
+
+    if (__query_parser_parse_size(tokens[*argc - 1], output))
+        return 1;
+    *argc -= 2;
+    return 0;
+}
 
-    /* Query type parsing */
-    const int retval =
-        query_tokenizer_tokenize(input, __query_parser_tokenize_callback, &parser_data);
-    if (retval || !parser_data.first_token_parsed) {
-        if (!aux)
-            g_ptr_array_free(parser_data.args, TRUE);
+int query_parser_parse_string(string_pool_t *allocator, query_instance_t *output, char *input) {
+    const char            *iter = input;
+    query_tokenizer_span_t token;
+
+    if (query_tokenizer_next(&iter, &token) || __query_parser_parse_type(output, token))
         return 1;
-    }
 
-    if (parser_data.last_terminator)
-        *parser_data.last_terminator = '\0';
+    /*
+     * All tokens must be found before any is null-terminated, as a terminator may be placed where
+     * the tokenizer still needs to look at (a space).
+     */
+    query_tokenizer_span_t tokens[QUERY_PARSER_MAX_ARGUMENTS];
+    size_t                 argc = 0;
+    while (!query_tokenizer_next(&iter, &token)) {
+        if (argc == QUERY_PARSER_MAX_ARGUMENTS)
+            return 1;
+        tokens[argc++] = token;
+    }
 
-    /* Argument parsing */
-    const query_type_t *const                   query_type = query_instance_get_type(output);
-    const query_type_parse_arguments_callback_t parse_cb =
-        query_type_get_parse_arguments_callback(query_type);
-    void *const argument_data =
-        parse_cb(parser_data.args->len, (char *const *) parser_data.args->pdata);
+    /* Optional page of results, at the end: [LIMIT n] [OFFSET m] */
+    size_t offset = 0, limit = QUERY_INSTANCE_NO_LIMIT;
+    if (__query_parser_parse_page_clause(input, tokens, &argc, "OFFSET", &offset) ||
+        __query_parser_parse_page_clause(input, tokens, &argc, "LIMIT", &limit))
+        return 1;
+    query_instance_set_page(output, offset, limit);
 
-    if (argument_data) {
-        query_instance_set_argument_data(output, argument_data);
+    char *argv[QUERY_PARSER_MAX_ARGUMENTS];
+    char  end_chars[QUERY_PARSER_MAX_ARGUMENTS];
+    for (size_t i = 0; i < argc; ++i) {
+        argv[i]      = input + (tokens[i].begin - input); /* Don't cast the const away */
+        end_chars[i] = argv[i][tokens[i].length];
 
-        const query_type_free_arguments_callback_t free_cb =
-            query_type_get_free_arguments_callback(query_type);
-        free_cb(argument_data);
+        argv[i][tokens[i].length] = '\0';
     }
 
-    /* Restore string */
-    for (ssize_t i = 0; i < parser_data.args->len; ++i) {
-        char *const str = g_ptr_array_index(parser_data.args, i);
-        char *const end = str + strlen(str);
+    /* Argument parsing (directly into the query instance) */
+    const int retval = query_instance_parse_arguments(allocator, output, argc, argv);
 
-        if (*(str - 1) == '"')
-            *end = '"';
-        else if (i != parser_data.args->len - 1)
-            *end = ' ';
-    }
+    for (size_t i = 0; i < argc; ++i) /* Restore string */
+        argv[i][tokens[i].length] = end_chars[i];
 
-    if (!aux)
-        g_ptr_array_unref(parser_data.args);
-    return (argument_data == NULL);
+    return retval;
 }
 
-int query_parser_parse_string_const(query_instance_t *output, const char *input, GPtrArray *aux) {
+int query_parser_parse_string_const(string_pool_t    *allocator,
+                                    query_instance_t *output,
+                                    const char       *input) {
     char *const buffer = strdup(input);
     if (!buffer)
         return QUERY_PARSER_PARSE_CONST_RET_FAILED_MALLOC;
 
-    const int retval = query_parser_parse_string(output, buffer, aux);
+    const int retval = query_parser_parse_string(allocator, output, buffer);
     free(buffer);
     return retval != 0;
 }
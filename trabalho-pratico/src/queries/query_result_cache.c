@@ -0,0 +1,327 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  query_result_cache.c
+ * @brief Implementation of methods in include/queries/query_result_cache.h
+ *
+ * @details Every output is kept, exactly as written by ::query_writer_t, in a directory whose name
+ *          contains the cache key, with only a hash of the query's arguments (see
+ *          ::__query_result_cache_get_path). The arguments themselves are kept in a file next to
+ *          the output, and compared on every lookup, so that queries whose hashes collide never
+ *          get each other's outputs.
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref query_result_cache_examples).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+    #include <linux/fs.h>
+    #include <sys/ioctl.h>
+#endif
+
+#include "queries/query_result_cache.h"
+
+/**
+ * @brief   Version of the outputs in the cache.
+ * @details Must be incremented on every change to the output of any query type.
+ */
+#define QUERY_RESULT_CACHE_VERSION 2
+
+/** @brief Name of the file, in the directory of a cached output, with the query's arguments. */
+#define QUERY_RESULT_CACHE_ARGUMENTS_FILE_NAME "arguments"
+
+/** @brief Name of the file, in the directory of a cached output, with the output itself. */
+#define QUERY_RESULT_CACHE_OUTPUT_FILE_NAME "output"
+
+/** @brief Size of the buffer used to copy files, when they can't be reflinked. */
+#define QUERY_RESULT_CACHE_COPY_BUFFER_SIZE 65536
+
+/**
+ * @struct query_result_cache
+ * @brief  Query outputs kept in a directory.
+ *
+ * @var query_result_cache::directory
+ *     @brief Path to the directory where outputs are kept.
+ * @var query_result_cache::fingerprint
+ *     @brief Identifier of the dataset queries are executed on.
+ */
+struct query_result_cache {
+    char    *directory;
+    uint64_t fingerprint;
+};
+
+query_result_cache_t *query_result_cache_create(const char *directory, uint64_t fingerprint) {
+    if (mkdir(directory, 0777) && errno != EEXIST)
+        return NULL;
+
+    query_result_cache_t *const cache = malloc(sizeof(query_result_cache_t));
+    if (!cache)
+        return NULL;
+
+    cache->directory = strdup(directory);
+    if (!cache->directory) {
+        free(cache);
+        return NULL;
+    }
+
+    cache->fingerprint = fingerprint;
+    return cache;
+}
+
+/**
+ * @brief   Gets the path of the directory where the output of a query is kept.
+ * @details The name of the directory is made of the version of the cache, the dataset's
+ *          fingerprint, and every property of the query compared by ::query_instance_is_same_query
+ *          (only a hash of the arguments, which is shared by other queries on collisions).
+ *
+ * @param cache  Cache the directory is in.
+ * @param query  Query whose output is kept in the directory.
+ * @param binary Whether the output is in [binary](@ref query_writer_binary_format).
+ * @param path   Where to write the path to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Path too long, or @p query's arguments weren't parsed.
+ */
+int __query_result_cache_get_path(const query_result_cache_t *cache,
+                                  const query_instance_t     *query,
+                                  int                         binary,
+                                  char                        path[PATH_MAX]) {
+    const uint64_t arguments_hash = query_instance_get_arguments_hash(query);
+    if (!arguments_hash)
+        return 1;
+
+    const int written =
+        snprintf(path,
+                 PATH_MAX,
+                 "%s/v%d_%016" PRIx64 "_q%zu_%016" PRIx64 "_%c%c_%zu_%zu.%s",
+                 cache->directory,
+                 QUERY_RESULT_CACHE_VERSION,
+                 cache->fingerprint,
+                 query_type_get_type_number(query_instance_get_type(query)),
+                 arguments_hash,
+                 query_instance_get_formatted(query) ? 'F' : 'U',
+                 query_instance_get_approximate(query) ? 'A' : 'E',
+                 query_instance_get_offset(query),
+                 query_instance_get_limit(query),
+                 binary ? "bin" : "txt");
+    return written < 0 || written >= PATH_MAX;
+}
+
+/**
+ * @brief Gets the paths of the files in the directory of a cached output.
+ *
+ * @param directory      Path to the directory of the cached output.
+ * @param arguments_path Where to write the path of the file with the query's arguments to.
+ * @param output_path    Where to write the path of the file with the output to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Path too long.
+ */
+int __query_result_cache_get_file_paths(const char *directory,
+                                        char        arguments_path[PATH_MAX],
+                                        char        output_path[PATH_MAX]) {
+    return snprintf(arguments_path,
+                    PATH_MAX,
+                    "%s/" QUERY_RESULT_CACHE_ARGUMENTS_FILE_NAME,
+                    directory) >= PATH_MAX ||
+           snprintf(output_path, PATH_MAX, "%s/" QUERY_RESULT_CACHE_OUTPUT_FILE_NAME, directory) >=
+               PATH_MAX;
+}
+
+/**
+ * @brief Checks if the arguments kept with a cached output are the arguments of a query.
+ *
+ * @param path  Path to the file with the arguments of the cached output.
+ * @param query Query whose output is wanted.
+ *
+ * @return Whether the file could be read and contains exactly the arguments of @p query.
+ */
+int __query_result_cache_has_arguments(const char *path, const query_instance_t *query) {
+    size_t            size;
+    const char *const arguments = query_instance_get_arguments(query, &size);
+
+    FILE *const file = fopen(path, "rb");
+    if (!file)
+        return 0;
+
+    /* Try to read an extra byte, to find out if the file is longer than the arguments */
+    char *const buffer = malloc(size + 1);
+    const int   same   = buffer && fread(buffer, 1, size + 1, file) == size &&
+                     (!size || !memcmp(buffer, arguments, size));
+
+    free(buffer);
+    fclose(file);
+    return same;
+}
+
+/**
+ * @brief Writes all bytes of a buffer to a file.
+ *
+ * @param fd   Open file descriptor of the file to be written.
+ * @param data Data to be written.
+ * @param size Number of bytes in @p data.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __query_result_cache_write(int fd, const char *data, size_t size) {
+    for (size_t written = 0; written < size;) {
+        const ssize_t n = write(fd, data + written, size - written);
+        if (n < 0 && errno != EINTR)
+            return 1;
+        written += n < 0 ? 0 : (size_t) n;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Copies the contents of a file to another.
+ * @details The file is reflinked (its blocks are shared until modified) if the file system
+ *          supports it, and copied through a buffer otherwise.
+ *
+ * @param from_fd Open file descriptor of the file to be read.
+ * @param to_fd   Open file descriptor of the (empty) file to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __query_result_cache_copy(int from_fd, int to_fd) {
+#ifdef FICLONE
+    if (!ioctl(to_fd, FICLONE, from_fd))
+        return 0;
+#endif
+
+    char buffer[QUERY_RESULT_CACHE_COPY_BUFFER_SIZE];
+    for (;;) {
+        const ssize_t nread = read(from_fd, buffer, sizeof(buffer));
+        if (nread < 0 && errno == EINTR)
+            continue;
+        if (nread < 0)
+            return 1;
+        if (nread == 0)
+            return 0;
+
+        if (__query_result_cache_write(to_fd, buffer, (size_t) nread))
+            return 1;
+    }
+}
+
+int query_result_cache_get(const query_result_cache_t *cache,
+                           const query_instance_t     *query,
+                           int                         binary,
+                           const char                 *output_path) {
+    char path[PATH_MAX], arguments_path[PATH_MAX], cached_path[PATH_MAX];
+    if (__query_result_cache_get_path(cache, query, binary, path) ||
+        __query_result_cache_get_file_paths(path, arguments_path, cached_path))
+        return 1;
+
+    /* Other queries' outputs may be kept here, if their hashes collide with this query's */
+    if (!__query_result_cache_has_arguments(arguments_path, query))
+        return 1;
+
+    const int from_fd = open(cached_path, O_RDONLY);
+    if (from_fd < 0)
+        return 1;
+
+    /* Outputs may be hard links (see query_writer_close_as_link): replace them, don't modify */
+    int retval = 1;
+    if (unlink(output_path) && errno != ENOENT)
+        goto DEFER_1;
+
+    const int to_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (to_fd < 0)
+        goto DEFER_1;
+
+    retval = __query_result_cache_copy(from_fd, to_fd);
+    if (close(to_fd))
+        retval = 1;
+
+DEFER_1:
+    close(from_fd);
+    return retval;
+}
+
+int query_result_cache_put(const query_result_cache_t *cache,
+                           const query_instance_t     *query,
+                           int                         binary,
+                           const char                 *output_path) {
+    char path[PATH_MAX], tmp_path[PATH_MAX], arguments_path[PATH_MAX], cached_path[PATH_MAX];
+    if (__query_result_cache_get_path(cache, query, binary, path) ||
+        (size_t) snprintf(tmp_path, PATH_MAX, "%s.XXXXXX", path) >= PATH_MAX ||
+        !mkdtemp(tmp_path))
+        return 1;
+
+    int retval = 1;
+    if (__query_result_cache_get_file_paths(tmp_path, arguments_path, cached_path))
+        goto DEFER_1;
+
+    size_t            size;
+    const char *const arguments    = query_instance_get_arguments(query, &size);
+    const int         arguments_fd = open(arguments_path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (arguments_fd < 0)
+        goto DEFER_1;
+
+    retval = __query_result_cache_write(arguments_fd, arguments, size);
+    if (close(arguments_fd) || retval) {
+        retval = 1;
+        goto DEFER_2;
+    }
+
+    retval            = 1;
+    const int from_fd = open(output_path, O_RDONLY);
+    if (from_fd < 0)
+        goto DEFER_2;
+
+    const int to_fd = open(cached_path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (to_fd < 0)
+        goto DEFER_3;
+
+    retval = __query_result_cache_copy(from_fd, to_fd);
+    if (close(to_fd))
+        retval = 1;
+
+    /* A directory isn't renamed over another one with files, so entries are never replaced */
+    if (retval || rename(tmp_path, path)) {
+        remove(cached_path);
+        retval = 1;
+    }
+
+DEFER_3:
+    close(from_fd);
+DEFER_2:
+    if (retval)
+        remove(arguments_path);
+DEFER_1:
+    if (retval)
+        rmdir(tmp_path);
+    return retval;
+}
+
+void query_result_cache_free(query_result_cache_t *cache) {
+    free(cache->directory);
+    free(cache);
+}
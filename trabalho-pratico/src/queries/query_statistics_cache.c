@@ -0,0 +1,222 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  query_statistics_cache.c
+ * @brief Implementation of methods in include/queries/query_statistics_cache.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref query_statistics_cache_examples).
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+
+#include "queries/query_statistics_cache.h"
+
+/**
+ * @struct query_statistics_cache
+ * @brief  Statistical data for multiple query types, kept between query dispatches.
+ *
+ * @var query_statistics_cache::entries
+ *     @brief Associations between query type numbers and ::query_statistics_cache_entry_t.
+ * @var query_statistics_cache::store
+ *     @brief Where to look up missing statistical data, and to save new data to. Can be `NULL`.
+ * @var query_statistics_cache::hits
+ *     @brief Number of calls to ::query_statistics_cache_get that found statistical data.
+ * @var query_statistics_cache::misses
+ *     @brief Number of calls to ::query_statistics_cache_get that didn't find statistical data.
+ */
+struct query_statistics_cache {
+    GHashTable               *entries;
+    query_statistics_store_t *store;
+    size_t                    hits, misses;
+};
+
+/**
+ * @struct query_statistics_cache_entry_t
+ * @brief  Statistical data for a query type, in a ::query_statistics_cache_t.
+ *
+ * @var query_statistics_cache_entry_t::statistics
+ *     @brief Statistical data generated by a query type.
+ * @var query_statistics_cache_entry_t::free_statistics
+ *     @brief Method to free ::query_statistics_cache_entry_t::statistics (can be `NULL`).
+ * @var query_statistics_cache_entry_t::approximate
+ *     @brief Whether ::query_statistics_cache_entry_t::statistics can only be used to answer
+ *            approximate queries.
+ * @var query_statistics_cache_entry_t::file
+ *     @brief File ::query_statistics_cache_entry_t::statistics was loaded from (`NULL` for
+ *            generated data), closed after the data is freed.
+ */
+typedef struct {
+    void                                 *statistics;
+    query_type_free_statistics_callback_t free_statistics;
+    int                                   approximate;
+    mapped_file_t                        *file;
+} query_statistics_cache_entry_t;
+
+/**
+ * @brief Frees a ::query_statistics_cache_entry_t, and the statistical data in it.
+ * @param entry Entry to be freed.
+ */
+void __query_statistics_cache_entry_free(void *entry) {
+    query_statistics_cache_entry_t *const cache_entry = entry;
+    if (cache_entry->free_statistics)
+        cache_entry->free_statistics(cache_entry->statistics);
+    if (cache_entry->file)
+        mapped_file_close(cache_entry->file);
+    free(cache_entry);
+}
+
+query_statistics_cache_t *query_statistics_cache_create(void) {
+    query_statistics_cache_t *const cache = malloc(sizeof(query_statistics_cache_t));
+    if (!cache)
+        return NULL;
+
+    cache->entries = g_hash_table_new_full(g_direct_hash,
+                                           g_direct_equal,
+                                           NULL,
+                                           __query_statistics_cache_entry_free);
+    cache->store   = NULL;
+    cache->hits    = 0;
+    cache->misses  = 0;
+    return cache;
+}
+
+void query_statistics_cache_set_store(query_statistics_cache_t *cache,
+                                      query_statistics_store_t *store) {
+    cache->store = store;
+}
+
+/**
+ * @brief Creates a cache entry for statistical data.
+ *
+ * @param statistics      Statistical data to be cached.
+ * @param free_statistics Method to free @p statistics (can be `NULL`).
+ * @param approximate     Whether @p statistics can only answer approximate queries.
+ * @param file            File @p statistics was loaded from, or `NULL`.
+ *
+ * @return A new ::query_statistics_cache_entry_t, or `NULL` on allocation failure.
+ */
+query_statistics_cache_entry_t *
+    __query_statistics_cache_entry_create(void                                 *statistics,
+                                          query_type_free_statistics_callback_t free_statistics,
+                                          int                                   approximate,
+                                          mapped_file_t                        *file) {
+
+    query_statistics_cache_entry_t *const entry = malloc(sizeof(query_statistics_cache_entry_t));
+    if (!entry)
+        return NULL;
+
+    entry->statistics      = statistics;
+    entry->free_statistics = free_statistics;
+    entry->approximate     = approximate;
+    entry->file            = file;
+    return entry;
+}
+
+/**
+ * @brief Loads the statistical data of a query type from the store of a cache, and caches it.
+ *
+ * @param cache Cache whose store to load data from.
+ * @param type  Query type whose statistical data is wanted.
+ *
+ * @return The loaded statistical data, or `NULL` if it isn't in the store (or on allocation
+ *         failure).
+ */
+void *__query_statistics_cache_load(query_statistics_cache_t *cache, const query_type_t *type) {
+    if (!cache->store || !query_type_has_reusable_statistics(type))
+        return NULL;
+
+    mapped_file_t *file;
+    void *const    statistics = query_statistics_store_load(cache->store, type, &file);
+    if (!statistics)
+        return NULL;
+
+    const query_type_free_statistics_callback_t free_loaded =
+        query_type_get_persistence(type)->free_loaded;
+    query_statistics_cache_entry_t *const entry =
+        __query_statistics_cache_entry_create(statistics, free_loaded, 0, file);
+    if (!entry) {
+        if (free_loaded)
+            free_loaded(statistics);
+        mapped_file_close(file);
+        return NULL;
+    }
+
+    g_hash_table_insert(cache->entries,
+                        GUINT_TO_POINTER(query_type_get_type_number(type)),
+                        entry);
+    return statistics;
+}
+
+void *query_statistics_cache_get(query_statistics_cache_t *cache,
+                                 const query_type_t       *type,
+                                 int                       approximate) {
+    const query_statistics_cache_entry_t *const entry =
+        g_hash_table_lookup(cache->entries, GUINT_TO_POINTER(query_type_get_type_number(type)));
+
+    void *const statistics = !entry || (entry->approximate && !approximate)
+                                 ? __query_statistics_cache_load(cache, type)
+                                 : entry->statistics;
+    if (statistics)
+        cache->hits++;
+    else
+        cache->misses++;
+    return statistics;
+}
+
+int query_statistics_cache_put(query_statistics_cache_t *cache,
+                               const query_type_t       *type,
+                               void                     *statistics,
+                               int                       approximate) {
+
+    query_statistics_cache_entry_t *const entry =
+        __query_statistics_cache_entry_create(statistics,
+                                              query_type_get_free_statistics_callback(type),
+                                              approximate,
+                                              NULL);
+    if (!entry)
+        return 1;
+
+    /* Failing to save statistics (e.g.: read-only cache directory) isn't an error */
+    if (cache->store && !approximate && query_type_get_persistence(type))
+        query_statistics_store_save(cache->store, type, statistics);
+
+    /* Replaces (and frees) approximate statistics, which couldn't answer the exact queries */
+    g_hash_table_insert(cache->entries,
+                        GUINT_TO_POINTER(query_type_get_type_number(type)),
+                        entry);
+    return 0;
+}
+
+void query_statistics_cache_clear(query_statistics_cache_t *cache) {
+    cache->store = NULL;
+    g_hash_table_remove_all(cache->entries);
+}
+
+void query_statistics_cache_get_lookup_counts(const query_statistics_cache_t *cache,
+                                              size_t                         *hits,
+                                              size_t                         *misses) {
+    *hits   = cache->hits;
+    *misses = cache->misses;
+}
+
+void query_statistics_cache_free(query_statistics_cache_t *cache) {
+    g_hash_table_unref(cache->entries);
+    free(cache);
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  query_statistics_store.c
+ * @brief Implementation of methods in include/queries/query_statistics_store.h
+ *
+ * @details Every file starts with a ::query_statistics_store_header_t, followed by whatever
+ *          ::query_type_persistence_t::save writes. The header has a size multiple of 8 bytes, so
+ *          that data right after it can be read in place from the mapped file.
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref query_statistics_store_examples).
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "queries/query_statistics_store.h"
+
+/** @brief Value of ::query_statistics_store_header_t::magic. */
+#define QUERY_STATISTICS_STORE_MAGIC "LI3STAT"
+
+/**
+ * @brief   Version of the format of stored files.
+ * @details Must be incremented on every change to the statistical data of any query type.
+ */
+#define QUERY_STATISTICS_STORE_VERSION 1
+
+/**
+ * @struct query_statistics_store
+ * @brief  Statistical data for multiple query types, kept in files.
+ *
+ * @var query_statistics_store::path_prefix
+ *     @brief Beginning of the path of every file in the store.
+ * @var query_statistics_store::fingerprint
+ *     @brief Identifier of the dataset the stored data is generated from.
+ */
+struct query_statistics_store {
+    char    *path_prefix;
+    uint64_t fingerprint;
+};
+
+/**
+ * @struct query_statistics_store_header_t
+ * @brief  Beginning of a file in a ::query_statistics_store_t.
+ *
+ * @var query_statistics_store_header_t::magic
+ *     @brief Always ::QUERY_STATISTICS_STORE_MAGIC, to identify stored files.
+ * @var query_statistics_store_header_t::version
+ *     @brief Version of the format of the file (::QUERY_STATISTICS_STORE_VERSION).
+ * @var query_statistics_store_header_t::header_size
+ *     @brief   Size of this `struct`.
+ *     @details Detects files created by builds of this program with a different ABI.
+ * @var query_statistics_store_header_t::fingerprint
+ *     @brief Identifier of the dataset the data was generated from.
+ * @var query_statistics_store_header_t::type_number
+ *     @brief Number of the query type that generated the data.
+ * @var query_statistics_store_header_t::size
+ *     @brief Number of bytes after the header.
+ */
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t fingerprint;
+    uint64_t type_number;
+    uint64_t size;
+} query_statistics_store_header_t;
+
+query_statistics_store_t *query_statistics_store_create(const char *path_prefix,
+                                                        uint64_t    fingerprint) {
+    query_statistics_store_t *const store = malloc(sizeof(query_statistics_store_t));
+    if (!store)
+        return NULL;
+
+    store->path_prefix = strdup(path_prefix);
+    if (!store->path_prefix) {
+        free(store);
+        return NULL;
+    }
+
+    store->fingerprint = fingerprint;
+    return store;
+}
+
+/**
+ * @brief Gets the path of the file of a query type in a store.
+ *
+ * @param store Store the file is in.
+ * @param type  Query type the file is for.
+ * @param path  Where to write the path to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Path too long.
+ */
+int __query_statistics_store_get_path(const query_statistics_store_t *store,
+                                      const query_type_t             *type,
+                                      char                            path[PATH_MAX]) {
+    return (size_t) snprintf(path,
+                             PATH_MAX,
+                             "%s%zu",
+                             store->path_prefix,
+                             query_type_get_type_number(type)) >= PATH_MAX;
+}
+
+int query_statistics_store_save(const query_statistics_store_t *store,
+                                const query_type_t             *type,
+                                const void                     *statistics) {
+
+    const query_type_persistence_t *const persistence = query_type_get_persistence(type);
+    if (!persistence)
+        return 1;
+
+    char path[PATH_MAX], tmp_path[PATH_MAX];
+    if (__query_statistics_store_get_path(store, type, path) ||
+        (size_t) snprintf(tmp_path, PATH_MAX, "%s.%ld.tmp", path, (long) getpid()) >= PATH_MAX)
+        return 1;
+
+    FILE *const file = fopen(tmp_path, "wb");
+    if (!file)
+        return 1;
+
+    query_statistics_store_header_t header = {
+        .magic       = QUERY_STATISTICS_STORE_MAGIC,
+        .version     = QUERY_STATISTICS_STORE_VERSION,
+        .header_size = sizeof(query_statistics_store_header_t),
+        .fingerprint = store->fingerprint,
+        .type_number = query_type_get_type_number(type),
+        .size        = 0};
+
+    /* Header is written again when the size of the data is known */
+    if (fwrite(&header, sizeof(query_statistics_store_header_t), 1, file) != 1 ||
+        persistence->save(statistics, file))
+        goto DEFER_1;
+
+    const long end = ftell(file);
+    if (end < 0)
+        goto DEFER_1;
+    header.size = end - sizeof(query_statistics_store_header_t);
+
+    if (fseek(file, 0, SEEK_SET) ||
+        fwrite(&header, sizeof(query_statistics_store_header_t), 1, file) != 1)
+        goto DEFER_1;
+
+    if (fclose(file)) {
+        remove(tmp_path);
+        return 1;
+    }
+
+    if (rename(tmp_path, path)) {
+        remove(tmp_path);
+        return 1;
+    }
+    return 0;
+
+DEFER_1:
+    fclose(file);
+    remove(tmp_path);
+    return 1;
+}
+
+void *query_statistics_store_load(const query_statistics_store_t *store,
+                                  const query_type_t             *type,
+                                  mapped_file_t                 **file) {
+
+    const query_type_persistence_t *const persistence = query_type_get_persistence(type);
+    if (!persistence)
+        return NULL;
+
+    char path[PATH_MAX];
+    if (__query_statistics_store_get_path(store, type, path))
+        return NULL;
+
+    mapped_file_t *const mapped = mapped_file_open(path);
+    if (!mapped)
+        return NULL;
+
+    const char *const contents = mapped_file_get_contents(mapped);
+    const size_t      size     = mapped_file_get_size(mapped);
+
+    query_statistics_store_header_t header;
+    if (size < sizeof(query_statistics_store_header_t))
+        goto DEFER_1;
+    memcpy(&header, contents, sizeof(query_statistics_store_header_t));
+
+    if (memcmp(header.magic, QUERY_STATISTICS_STORE_MAGIC, sizeof(header.magic)) ||
+        header.version != QUERY_STATISTICS_STORE_VERSION ||
+        header.header_size != sizeof(query_statistics_store_header_t) ||
+        header.fingerprint != store->fingerprint ||
+        header.type_number != query_type_get_type_number(type) ||
+        header.size != size - sizeof(query_statistics_store_header_t))
+        goto DEFER_1;
+
+    void *const statistics =
+        persistence->load(contents + sizeof(query_statistics_store_header_t), header.size);
+    if (!statistics)
+        goto DEFER_1;
+
+    *file = mapped;
+    return statistics;
+
+DEFER_1:
+    mapped_file_close(mapped);
+    return NULL;
+}
+
+void query_statistics_store_free(query_statistics_store_t *store) {
+    free(store->path_prefix);
+    free(store);
+}
@@ -26,58 +26,56 @@
 #include <string.h>
 
 #include "queries/query_tokenizer.h"
-#include "utils/string_utils.h"
 
-/**
- * @struct query_tokenizer_data_t
- * @brief  Contains the tokenizer's state.
- *
- * @var query_tokenizer_data_t::user_data
- *     @brief `user_data` parameter in ::query_tokenizer_tokenize.
- * @var query_tokenizer_data_t::callback
- *     @brief `callback` parameter in ::query_tokenizer_tokenize.
- * @var query_tokenizer_data_t::quote_token
- *     @brief The pointer to the beginning of the current token if is starts with ``'\"'``, `NULL`
- *            otherwise.
- */
-typedef struct {
-    void                    *user_data;
-    tokenize_iter_callback_t callback;
+int query_tokenizer_next(const char **iter, query_tokenizer_span_t *token) {
+    const char *i           = *iter;
+    const char *quote_begin = NULL; /* Beginning of the current quoted token, if any */
 
-    char *quote_token;
-} query_tokenizer_data_t;
+    while (1) {
+        while (*i == ' ') /* Skip empty tokens */
+            i++;
 
-/**
- * @brief   Handles space-separated tokens from a string.
- * @details Auxiliary method for ::query_tokenizer_tokenize.
- *
- * @param tokenizer_data A pointer to a ::query_tokenizer_data_t.
- * @param token          Space-separated token to process (take quotes into account).
- */
-int __query_tokenizer_handle_space_split(void *tokenizer_data, char *token) {
-    query_tokenizer_data_t *const tokenizer = tokenizer_data;
-
-    if (*token == '\0') /* Skip empty tokens */
-        return 0;
+        if (*i == '\0') { /* Unclosed quotes are discarded */
+            *iter = i;
+            return 1;
+        }
 
-    if (*token == '"')
-        tokenizer->quote_token = token + 1;
+        const char *const begin = i;
+        while (*i != ' ' && *i != '\0')
+            i++;
+
+        if (*begin == '"')
+            quote_begin = begin + 1;
+
+        if (!quote_begin) {
+            token->begin  = begin;
+            token->length = i - begin;
+            *iter         = i;
+            return 0;
+        } else if (*(i - 1) == '"') {
+            /* A single quote (`"`) is an empty token that starts and ends in itself */
+            token->begin  = quote_begin;
+            token->length = i - 1 > quote_begin ? (size_t) (i - 1 - quote_begin) : 0;
+            *iter         = i;
+            return 0;
+        }
+    }
+}
 
-    if (tokenizer->quote_token) {
-        const size_t token_length = strlen(token);
-        if (token[token_length - 1] == '"') {
+int query_tokenizer_tokenize(char *input, tokenize_iter_callback_t callback, void *user_data) {
+    const char            *iter = input;
+    query_tokenizer_span_t token;
 
-            token[token_length - 1] = '\0';
-            const int cb_result = tokenizer->callback(tokenizer->user_data, tokenizer->quote_token);
+    while (!query_tokenizer_next(&iter, &token)) {
+        /* Get a modifiable pointer without casting the const away */
+        char *const begin = input + (token.begin - input);
+        char *const end   = begin + token.length;
 
-            token[token_length - 1] = '"'; /* Restore string */
-            tokenizer->quote_token  = NULL;
+        const char end_char = *end;
+        *end                = '\0';
+        const int cb_result = callback(user_data, begin);
+        *end                = end_char; /* Restore string */
 
-            if (cb_result)
-                return cb_result;
-        }
-    } else {
-        const int cb_result = tokenizer->callback(tokenizer->user_data, token);
         if (cb_result)
             return cb_result;
     }
@@ -85,18 +83,6 @@ int __query_tokenizer_handle_space_split(void *tokenizer_data, char *token) {
     return 0;
 }
 
-int query_tokenizer_tokenize(char *input, tokenize_iter_callback_t callback, void *user_data) {
-    query_tokenizer_data_t tokenizer_data = {.user_data   = user_data,
-                                             .callback    = callback,
-                                             .quote_token = NULL};
-    const int              retval =
-        string_tokenize(input, ' ', __query_tokenizer_handle_space_split, &tokenizer_data);
-    if (retval)
-        return retval;
-
-    return 0;
-}
-
 int query_tokenizer_tokenize_const(const char              *input,
                                    tokenize_iter_callback_t callback,
                                    void                    *user_data) {
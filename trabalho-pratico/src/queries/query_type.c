@@ -34,17 +34,35 @@
  * @var query_type::type_number
  *     @brief A number that identifies this query type.
  * @var query_type::parse_arguments
- *     @brief Method that parses query arguments and generates ::query_instance::argument_data.
+ *     @brief Method that parses query arguments into ::query_instance::argument_data.
  * @var query_type::clone_arguments
  *     @brief Method that clones query arguments, generated by ::query_type::parse_arguments.
  * @var query_type::free_arguments
- *     @brief Method that frees data returned by ::query_type::parse_arguments.
+ *     @brief Method that frees data referred to by arguments from ::query_type::parse_arguments.
+ * @var query_type::save_arguments
+ *     @brief Method that writes data referred to by arguments to a compiled query file.
+ * @var query_type::load_arguments
+ *     @brief Method that reads data written by ::query_type::save_arguments.
  * @var query_type::generate_statistics
  *     @brief Method that generates statistical data for all queries of the same type.
+ * @var query_type::scan
+ *     @brief   Alternative to ::query_type::generate_statistics, based on database iterations.
+ *     @details ::query_type_scan_t::begin is `NULL` if the query type doesn't have one.
  * @var query_type::free_statistics
  *     @brief Method that frees data generated by ::query_type::generate_statistics.
+ * @var query_type::reusable_statistics
+ *     @brief Whether statistical data doesn't depend on the queries it's generated for.
+ * @var query_type::persistence
+ *     @brief   How to keep statistical data in files.
+ *     @details ::query_type_persistence_t::save is `NULL` if the query type doesn't have one.
  * @var query_type::execute
  *     @brief Method that executes a single query.
+ * @var query_type::count_results
+ *     @brief Method that counts the objects in the output of a query, without executing it.
+ * @var query_type::estimate_results
+ *     @brief Method that estimates the number of objects in the output of a query.
+ * @var query_type::indexes
+ *     @brief Database indices read by this query type.
  */
 struct query_type {
     size_t type_number;
@@ -52,20 +70,36 @@ struct query_type {
     query_type_parse_arguments_callback_t parse_arguments;
     query_type_clone_arguments_callback_t clone_arguments;
     query_type_free_arguments_callback_t  free_arguments;
+    query_type_save_arguments_callback_t  save_arguments;
+    query_type_load_arguments_callback_t  load_arguments;
 
     query_type_generate_statistics_callback_t generate_statistics;
+    query_type_scan_t                         scan;
     query_type_free_statistics_callback_t     free_statistics;
+    int                                       reusable_statistics;
+    query_type_persistence_t                  persistence;
 
-    query_type_execute_callback_t execute;
+    query_type_execute_callback_t          execute;
+    query_type_count_results_callback_t    count_results;
+    query_type_estimate_results_callback_t estimate_results;
+    database_index_set_t                   indexes;
 };
 
 query_type_t *query_type_create(size_t                                    type_number,
                                 query_type_parse_arguments_callback_t     parse_arguments,
                                 query_type_clone_arguments_callback_t     clone_arguments,
                                 query_type_free_arguments_callback_t      free_arguments,
+                                query_type_save_arguments_callback_t      save_arguments,
+                                query_type_load_arguments_callback_t      load_arguments,
                                 query_type_generate_statistics_callback_t generate_statistics,
+                                const query_type_scan_t                  *scan,
                                 query_type_free_statistics_callback_t     free_statistics,
-                                query_type_execute_callback_t             execute) {
+                                int                                       reusable_statistics,
+                                const query_type_persistence_t           *persistence,
+                                query_type_execute_callback_t             execute,
+                                query_type_count_results_callback_t       count_results,
+                                query_type_estimate_results_callback_t    estimate_results,
+                                database_index_set_t                      indexes) {
 
     query_type_t *const query = malloc(sizeof(query_type_t));
     if (!query)
@@ -75,9 +109,32 @@ query_type_t *query_type_create(size_t                                    type_n
     query->parse_arguments     = parse_arguments;
     query->clone_arguments     = clone_arguments;
     query->free_arguments      = free_arguments;
+    query->save_arguments      = save_arguments;
+    query->load_arguments      = load_arguments;
     query->generate_statistics = generate_statistics;
     query->free_statistics     = free_statistics;
+    query->reusable_statistics = reusable_statistics;
     query->execute             = execute;
+    query->count_results       = count_results;
+    query->estimate_results    = estimate_results;
+    query->indexes             = indexes;
+
+    if (scan) {
+        query->scan = *scan;
+
+        /* Iterations through flights and reservations are done by columns */
+        if (scan->foreach_flights)
+            query->indexes |= DATABASE_INDEX_SET(DATABASE_INDEX_FLIGHT_COLUMNS);
+        if (scan->foreach_reservations)
+            query->indexes |= DATABASE_INDEX_SET(DATABASE_INDEX_RESERVATION_COLUMNS);
+    } else {
+        memset(&query->scan, 0, sizeof(query_type_scan_t));
+    }
+
+    if (persistence && reusable_statistics)
+        query->persistence = *persistence;
+    else
+        memset(&query->persistence, 0, sizeof(query_type_persistence_t));
 
     return query;
 }
@@ -113,22 +170,64 @@ query_type_free_arguments_callback_t
     return type->free_arguments;
 }
 
+query_type_save_arguments_callback_t
+    query_type_get_save_arguments_callback(const query_type_t *type) {
+
+    return type->save_arguments;
+}
+
+query_type_load_arguments_callback_t
+    query_type_get_load_arguments_callback(const query_type_t *type) {
+
+    return type->load_arguments;
+}
+
 query_type_generate_statistics_callback_t
     query_type_get_generate_statistics_callback(const query_type_t *type) {
 
     return type->generate_statistics;
 }
 
+const query_type_scan_t *query_type_get_scan(const query_type_t *type) {
+    return type->scan.begin ? &type->scan : NULL;
+}
+
 query_type_free_statistics_callback_t
     query_type_get_free_statistics_callback(const query_type_t *type) {
 
     return type->free_statistics;
 }
 
+int query_type_has_reusable_statistics(const query_type_t *type) {
+    return type->reusable_statistics;
+}
+
+const query_type_persistence_t *query_type_get_persistence(const query_type_t *type) {
+    return type->persistence.save ? &type->persistence : NULL;
+}
+
+int query_type_needs_statistics(const query_type_t *type) {
+    return type->generate_statistics || type->scan.begin;
+}
+
 query_type_execute_callback_t query_type_get_execute_callback(const query_type_t *type) {
     return type->execute;
 }
 
+query_type_count_results_callback_t
+    query_type_get_count_results_callback(const query_type_t *type) {
+    return type->count_results;
+}
+
+query_type_estimate_results_callback_t
+    query_type_get_estimate_results_callback(const query_type_t *type) {
+    return type->estimate_results;
+}
+
+database_index_set_t query_type_get_indexes(const query_type_t *type) {
+    return type->indexes;
+}
+
 void query_type_free(query_type_t *query) {
     free(query);
 }
@@ -23,6 +23,7 @@
  */
 
 #include "queries/query_type_list.h"
+#include "queries/query_instance.h"
 
 #include "queries/q01.h"
 #include "queries/q02.h"
@@ -34,6 +35,10 @@
 #include "queries/q08.h"
 #include "queries/q09.h"
 #include "queries/q10.h"
+#include "queries/q11.h"
+#include "queries/q12.h"
+#include "queries/q13.h"
+#include "utils/int_utils.h"
 
 /**
  * @brief   List of all known queries.
@@ -51,16 +56,11 @@ query_type_t *__query_type_list[QUERY_TYPE_LIST_COUNT];
 
 /** @brief Automatically initializes ::__query_type_list when the program starts. */
 void __attribute__((constructor)) __query_type_list_create(void) {
-    query_type_t *(*const constructors[QUERY_TYPE_LIST_COUNT])(void) = {q01_create,
-                                                                        q02_create,
-                                                                        q03_create,
-                                                                        q04_create,
-                                                                        q05_create,
-                                                                        q06_create,
-                                                                        q07_create,
-                                                                        q08_create,
-                                                                        q09_create,
-                                                                        q10_create};
+#define QUERY_TYPE_LIST_CONSTRUCTOR(number, prefix) prefix##_create,
+    query_type_t *(*const constructors[QUERY_TYPE_LIST_COUNT])(void) = {
+        QUERY_TYPE_LIST_FOREACH(QUERY_TYPE_LIST_CONSTRUCTOR)};
+#undef QUERY_TYPE_LIST_CONSTRUCTOR
+
     for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
         __query_type_list[i] = constructors[i]();
 }
@@ -76,3 +76,37 @@ const query_type_t *query_type_list_get_by_index(size_t index) {
         return __query_type_list[index - 1];
     return NULL;
 }
+
+int query_type_list_execute(const database_t       *database,
+                            const void             *statistics,
+                            const query_instance_t *instance,
+                            query_writer_t         *output) {
+
+    switch (query_type_get_type_number(query_instance_get_type(instance))) {
+#define QUERY_TYPE_LIST_EXECUTE(number, prefix)                                                    \
+    case number:                                                                                   \
+        return prefix##_execute(database, statistics, instance, output);
+
+        QUERY_TYPE_LIST_FOREACH(QUERY_TYPE_LIST_EXECUTE)
+#undef QUERY_TYPE_LIST_EXECUTE
+
+        default:
+            return 1;
+    }
+}
+
+void query_type_list_reserve_output(const database_t       *database,
+                                    const void             *statistics,
+                                    const query_instance_t *instance,
+                                    query_writer_t         *output) {
+
+    const query_type_estimate_results_callback_t estimate_results =
+        query_type_get_estimate_results_callback(query_instance_get_type(instance));
+    if (!estimate_results)
+        return;
+
+    const size_t estimate = estimate_results(database, statistics, instance);
+    const size_t offset   = min(query_instance_get_offset(instance), estimate);
+    const size_t limit    = query_instance_get_limit(instance);
+    query_writer_reserve_objects(output, min(estimate - offset, limit));
+}
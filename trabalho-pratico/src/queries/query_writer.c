@@ -22,47 +22,112 @@
  * See [the header file's documentation](@ref query_writer_examples).
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <glib.h>
 #include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "queries/query_writer.h"
+#include "testing/event_trace.h"
+#include "utils/int_utils.h"
 #include "utils/string_pool.h"
 
 /**
  * @struct query_writer
  * @brief  Information about where to output query results to.
  *
- * @var query_writer::stream
- *     @brief Where to write query outputs to. May be `NULL` (see ::query_writer::lines in that
- *            case).
+ * @var query_writer::path
+ *     @brief Path of the file where to write query outputs to. May be `NULL` (see
+ *            ::query_writer::container and ::query_writer::lines in that case).
+ * @var query_writer::container
+ *     @brief Container where to write query outputs to, if ::query_writer::path is `NULL`. May
+ *            also be `NULL` (see ::query_writer::lines in that case, or
+ *            ::query_writer_create_chunk if that's also `NULL`).
+ * @var query_writer::container_id
+ *     @brief Identifier of the query's entry in ::query_writer::container.
+ * @var query_writer::container_offset
+ *     @brief Position of the query's output in ::query_writer::container, after it's closed.
+ * @var query_writer::container_length
+ *     @brief Number of characters in the query's output in ::query_writer::container, after it's
+ *            closed.
+ * @var query_writer::buffer
+ *     @brief   Output of the query waiting to be written to ::query_writer::path (or to
+ *              ::query_writer::container).
+ *     @details The file is only opened when the writer is closed, so that it's written with a
+ *              single system call and that few files are open at any given time.
+ * @var query_writer::buffer_length
+ *     @brief Number of characters in ::query_writer::buffer.
+ * @var query_writer::buffer_capacity
+ *     @brief Number of characters ::query_writer::buffer can hold before needing to grow.
+ * @var query_writer::failed
+ *     @brief Whether ::query_writer::buffer failed to grow, and output has been lost.
+ * @var query_writer::closed
+ *     @brief Whether ::query_writer_close has been called.
+ * @var query_writer::cancelled
+ *     @brief Whether ::query_writer_cancel has been called, and further output is to be ignored.
  * @var query_writer::formatted
  *     @brief Whether the output of the query should be formatted (pretty printed).
+ * @var query_writer::binary
+ *     @brief Whether the output of the query is in binary (see ::query_writer_set_binary), in
+ *            which case ::query_writer::formatted is ignored.
+ * @var query_writer::record_begin
+ *     @brief Position, in ::query_writer::buffer, of the length of the record of the object
+ *            currently being written, in binary output.
  * @var query_writer::is_first_field
  *     @brief Whether the next field to be printed is the first field of the current object.
  * @var query_writer::current_object
  *    @brief Number of the object currently being written (starts counting up from `1`).
+ * @var query_writer::page_begin
+ *     @brief Number of objects at the beginning of the output to be left out.
+ * @var query_writer::page_end
+ *     @brief Number of the last object to be outputted (`SIZE_MAX` for no limit).
+ * @var query_writer::skipping
+ *     @brief Whether the current object is outside of the page, and its fields are to be ignored.
+ * @var query_writer::wrote_object
+ *     @brief Whether any object in the page has already been outputted.
  * @var query_writer::strings
- *     @brief In case ::query_writer::stream is `NULL`, this is where strings in
+ *     @brief In case ::query_writer::path is `NULL`, this is where strings in
  *            ::query_writer::lines are allocated.
  * @var query_writer::lines
- *     @brief Lines of output of a query, only initialized if ::query_writer::stream is `NULL`.
+ *     @brief Lines of output of a query, only initialized if both ::query_writer::path and
+ *            ::query_writer::container are `NULL`.
+ * @var query_writer::lines_lock
+ *     @brief   Lock that guards ::query_writer::lines (only initialized alongside it).
+ *     @details Allows for lines to be read (::query_writer_get_line) while a query is still
+ *              writing them.
  * @var query_writer::current_line
  *    @brief Current line being printed. Used for outputting non-formatted query results to strings.
  * @var query_writer::current_line_cursor
  *    @brief Position (in characters) where to start writing to ::query_writer::current_line.
  */
 struct query_writer {
-    FILE *stream;
+    char                     *path;
+    query_output_container_t *container;
+    uint64_t                  container_id, container_offset, container_length;
 
-    int formatted;
+    char  *buffer;
+    size_t buffer_length, buffer_capacity;
+    int    failed, closed;
+    gint   cancelled;
+
+    int    formatted, binary;
+    size_t record_begin;
 
     int    is_first_field;
     size_t current_object;
+    size_t page_begin, page_end;
+    int    skipping, wrote_object;
 
-    string_pool_t *strings;
-    GPtrArray     *lines;
+    string_pool_t  *strings;
+    GPtrArray      *lines;
+    pthread_mutex_t lines_lock;
 
     size_t current_line_cursor;
     char   current_line[LINE_MAX];
@@ -71,19 +136,64 @@ struct query_writer {
 /** @brief Size of each pool block in ::query_writer::strings. */
 #define QUERY_WRITER_STRING_POOL_BLOCK_SIZE (1 << 17)
 
-query_writer_t *query_writer_create(const char *out_file_path, int formatted) {
+/** @brief Initial capacity of ::query_writer::buffer. */
+#define QUERY_WRITER_BUFFER_INITIAL_CAPACITY 4096
+
+/** @brief Estimated number of bytes of each object, used by ::query_writer_reserve_objects. */
+#define QUERY_WRITER_OBJECT_SIZE_ESTIMATE 96
+
+/**
+ * @brief Estimated number of bytes of each formatted object (see ::query_writer::formatted), used
+ *        by ::query_writer_reserve_objects.
+ */
+#define QUERY_WRITER_FORMATTED_OBJECT_SIZE_ESTIMATE 192
+
+/** @brief Maximum number of bytes reserved by a single call to ::query_writer_reserve_objects. */
+#define QUERY_WRITER_MAX_RESERVATION (64 << 20)
+
+/**
+ * @brief  Allocates a query writer and initializes the fields common to all kinds of outputs.
+ * @param  formatted Whether the output of the query should be formatted (pretty printed).
+ * @return A writer whose output fields must still be initialized, or `NULL` on allocation failure.
+ */
+query_writer_t *__query_writer_alloc(int formatted) {
     query_writer_t *const ret = malloc(sizeof(query_writer_t));
     if (!ret)
         return NULL;
 
+    ret->container        = NULL;
+    ret->container_id     = 0;
+    ret->container_offset = 0;
+    ret->container_length = 0;
+
+    ret->buffer          = NULL;
+    ret->buffer_length   = 0;
+    ret->buffer_capacity = 0;
+    ret->failed          = 0;
+    ret->closed          = 0;
+    ret->cancelled       = 0;
+
     ret->formatted           = formatted;
+    ret->binary              = 0;
+    ret->record_begin        = 0;
     ret->is_first_field      = 1;
     ret->current_object      = 1;
+    ret->page_begin          = 0;
+    ret->page_end            = SIZE_MAX;
+    ret->skipping            = 0;
+    ret->wrote_object        = 0;
     ret->current_line_cursor = 0;
+    return ret;
+}
+
+query_writer_t *query_writer_create(const char *out_file_path, int formatted) {
+    query_writer_t *const ret = __query_writer_alloc(formatted);
+    if (!ret)
+        return NULL;
 
     if (out_file_path) {
-        ret->stream = fopen(out_file_path, "w");
-        if (!ret->stream) {
+        ret->path = strdup(out_file_path);
+        if (!ret->path) {
             free(ret);
             return NULL;
         }
@@ -91,36 +201,342 @@ query_writer_t *query_writer_create(const char *out_file_path, int formatted) {
         ret->strings = NULL;
         ret->lines   = NULL;
     } else {
-        ret->stream  = NULL;
+        ret->path    = NULL;
         ret->strings = string_pool_create(QUERY_WRITER_STRING_POOL_BLOCK_SIZE);
         if (!ret->strings) {
             free(ret);
             return NULL;
         }
+        if (pthread_mutex_init(&ret->lines_lock, NULL)) {
+            string_pool_free(ret->strings);
+            free(ret);
+            return NULL;
+        }
         ret->lines = g_ptr_array_new();
     }
 
     return ret;
 }
 
+query_writer_t *query_writer_create_in_container(query_output_container_t *container,
+                                                 uint64_t                  id,
+                                                 int                       formatted) {
+    query_writer_t *const ret = __query_writer_alloc(formatted);
+    if (!ret)
+        return NULL;
+
+    ret->path         = NULL;
+    ret->container    = container;
+    ret->container_id = id;
+    ret->strings      = NULL;
+    ret->lines        = NULL;
+    return ret;
+}
+
+query_writer_t *query_writer_create_chunk(const query_writer_t *writer) {
+    if (writer->lines)
+        return NULL;
+
+    query_writer_t *const ret = __query_writer_alloc(writer->formatted);
+    if (!ret)
+        return NULL;
+
+    ret->path    = NULL;
+    ret->strings = NULL;
+    ret->lines   = NULL;
+    ret->binary  = writer->binary;
+    return ret;
+}
+
+/**
+ * @brief Makes sure there's space in ::query_writer::buffer for more characters.
+ *
+ * @param writer Writer whose buffer may need to grow.
+ * @param length Number of characters (including a null terminator) that need to fit after
+ *               ::query_writer::buffer_length.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (::query_writer::failed is set).
+ */
+int __query_writer_reserve(query_writer_t *writer, size_t length) {
+    if (writer->buffer_length + length <= writer->buffer_capacity)
+        return 0;
+
+    size_t new_capacity = writer->buffer_capacity ? writer->buffer_capacity
+                                                  : QUERY_WRITER_BUFFER_INITIAL_CAPACITY;
+    while (new_capacity < writer->buffer_length + length)
+        new_capacity *= 2;
+
+    char *const new_buffer = realloc(writer->buffer, new_capacity);
+    if (!new_buffer) {
+        writer->failed = 1;
+        return 1;
+    }
+
+    writer->buffer          = new_buffer;
+    writer->buffer_capacity = new_capacity;
+    return 0;
+}
+
+/**
+ * @brief Appends a character to ::query_writer::buffer.
+ *
+ * @param writer    Writer to output @p character to.
+ * @param character Character to be outputted.
+ */
+void __query_writer_putc(query_writer_t *writer, char character) {
+    if (__query_writer_reserve(writer, 1))
+        return;
+    writer->buffer[writer->buffer_length++] = character;
+}
+
+/**
+ * @brief Appends formatted text to ::query_writer::buffer.
+ *
+ * @param writer Writer to output text to.
+ * @param format How to format the output (`printf` format string).
+ * @param args   Objects to be formatted accoring to @p format.
+ */
+void __query_writer_vprintf(query_writer_t *writer, const char *format, va_list args) {
+    va_list args_copy;
+    va_copy(args_copy, args);
+
+    if (__query_writer_reserve(writer, 1))
+        goto DEFER_1;
+
+    /* Try to format to the free space in the buffer, and only grow it if that's not enough */
+    const size_t available = writer->buffer_capacity - writer->buffer_length;
+    const int    length =
+        vsnprintf(writer->buffer + writer->buffer_length, available, format, args);
+    if (length < 0)
+        goto DEFER_1;
+
+    if ((size_t) length >= available) {
+        if (__query_writer_reserve(writer, length + 1))
+            goto DEFER_1;
+        vsnprintf(writer->buffer + writer->buffer_length, length + 1, format, args_copy);
+    }
+    writer->buffer_length += length;
+
+DEFER_1:
+    va_end(args_copy);
+}
+
+/**
+ * @brief Appends formatted text to ::query_writer::buffer.
+ *
+ * @param writer Writer to output text to.
+ * @param format How to format the output (`printf` format string).
+ * @param ...    Objects to be formatted accoring to @p format.
+ */
+__attribute__((format(printf, 2, 3))) void
+    __query_writer_printf(query_writer_t *writer, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    __query_writer_vprintf(writer, format, args);
+    va_end(args);
+}
+
+/**
+ * @brief Appends a line to ::query_writer::lines.
+ *
+ * @param writer Writer to output @p line to.
+ * @param line   Line to be copied to ::query_writer::strings.
+ */
+void __query_writer_add_line(query_writer_t *writer, const char *line) {
+    char *const copy = string_pool_put(writer->strings, line);
+
+    pthread_mutex_lock(&writer->lines_lock);
+    g_ptr_array_add(writer->lines, copy);
+    pthread_mutex_unlock(&writer->lines_lock);
+}
+
+/**
+ * @brief Writes an integer to ::query_writer::buffer, in little-endian, with no space checks.
+ *
+ * @param writer Writer to output @p value to. Must have space for @p size more bytes.
+ * @param value  Value to be outputted.
+ * @param size   Number of bytes of @p value to output.
+ */
+void __query_writer_put_integer(query_writer_t *writer, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+        writer->buffer[writer->buffer_length++] = (char) (uint8_t) (value >> (8 * i));
+}
+
+/**
+ * @brief   Updates the length of the record of the object currently being written, in binary
+ *          output.
+ * @details Called after every field, so that records are always complete.
+ *
+ * @param writer Writer with binary output.
+ */
+void __query_writer_update_record_length(query_writer_t *writer) {
+    const size_t length = writer->buffer_length - writer->record_begin - 4;
+    const size_t end    = writer->buffer_length;
+
+    writer->buffer_length = writer->record_begin;
+    __query_writer_put_integer(writer, length, 4);
+    writer->buffer_length = end;
+}
+
+/**
+ * @brief   Starts writing a field of an object in binary output.
+ * @details Writes the field's type and key, and makes sure there's space for its value.
+ *
+ * @param writer       Writer with binary output.
+ * @param key          Name of the field being outputted.
+ * @param type         Type of the field.
+ * @param value_length Number of bytes in the field's value.
+ *
+ * @retval 0 Success.
+ * @retval 1 The field isn't to be written (output cancelled, outside of the page, or allocation
+ *           failure).
+ */
+int __query_writer_start_binary_field(query_writer_t            *writer,
+                                      const char                *key,
+                                      query_writer_binary_type_t type,
+                                      size_t                     value_length) {
+    if (g_atomic_int_get(&writer->cancelled) || writer->skipping)
+        return 1;
+
+    const size_t key_length = min(strlen(key), UINT8_MAX);
+    if (__query_writer_reserve(writer, 2 + key_length + value_length))
+        return 1;
+
+    __query_writer_put_integer(writer, type, 1);
+    __query_writer_put_integer(writer, key_length, 1);
+    memcpy(writer->buffer + writer->buffer_length, key, key_length);
+    writer->buffer_length += key_length;
+    return 0;
+}
+
+/**
+ * @brief Writes an integer field of an object in binary output.
+ *
+ * @param writer Writer with binary output.
+ * @param key    Name of the field being outputted.
+ * @param type   Type of the field (whose value is a 64-bit integer).
+ * @param value  Value of the field.
+ */
+void __query_writer_write_binary_integer(query_writer_t            *writer,
+                                         const char                *key,
+                                         query_writer_binary_type_t type,
+                                         uint64_t                   value) {
+    if (__query_writer_start_binary_field(writer, key, type, sizeof(uint64_t)))
+        return;
+
+    __query_writer_put_integer(writer, value, sizeof(uint64_t));
+    __query_writer_update_record_length(writer);
+}
+
+/**
+ * @brief Writes a string field of an object in binary output.
+ *
+ * @param writer Writer with binary output.
+ * @param key    Name of the field being outputted.
+ * @param value  Value of the field (doesn't need to be null-terminated).
+ * @param length Number of characters in @p value.
+ */
+void __query_writer_write_binary_string(query_writer_t *writer,
+                                        const char     *key,
+                                        const char     *value,
+                                        size_t          length) {
+    if (__query_writer_start_binary_field(writer,
+                                          key,
+                                          QUERY_WRITER_BINARY_TYPE_STRING,
+                                          sizeof(uint32_t) + length))
+        return;
+
+    __query_writer_put_integer(writer, length, sizeof(uint32_t));
+    memcpy(writer->buffer + writer->buffer_length, value, length);
+    writer->buffer_length += length;
+    __query_writer_update_record_length(writer);
+}
+
+/**
+ * @brief Writes the date part of a date field in binary output, with no space checks.
+ *
+ * @param writer Writer with binary output, with space for 4 more bytes.
+ * @param date   Date to be outputted.
+ */
+void __query_writer_put_date(query_writer_t *writer, date_t date) {
+    __query_writer_put_integer(writer, date_get_year(date), 2);
+    __query_writer_put_integer(writer, date_get_month(date), 1);
+    __query_writer_put_integer(writer, date_get_day(date), 1);
+}
+
+void query_writer_reserve_objects(query_writer_t *writer, size_t nobjects) {
+    if (writer->closed || !nobjects)
+        return;
+
+    if (writer->lines) {
+        /* Lines are pointers copied on every growth: only an empty array can be replaced */
+        const size_t nlines = min(nobjects * (writer->formatted ? 8 : 1),
+                                  QUERY_WRITER_MAX_RESERVATION / sizeof(char *));
+
+        pthread_mutex_lock(&writer->lines_lock);
+        if (writer->lines->len == 0) {
+            g_ptr_array_unref(writer->lines);
+            writer->lines = g_ptr_array_sized_new((guint) nlines);
+        }
+        pthread_mutex_unlock(&writer->lines_lock);
+        return;
+    }
+
+    const size_t object_size = writer->formatted && !writer->binary
+                                   ? QUERY_WRITER_FORMATTED_OBJECT_SIZE_ESTIMATE
+                                   : QUERY_WRITER_OBJECT_SIZE_ESTIMATE;
+    const size_t reserved = min(nobjects, QUERY_WRITER_MAX_RESERVATION / object_size) * object_size;
+    const size_t capacity = writer->buffer_length + reserved;
+    if (capacity <= writer->buffer_capacity)
+        return;
+
+    /* Unlike ::__query_writer_reserve, failing to allocate a hint isn't an error */
+    char *const new_buffer = realloc(writer->buffer, capacity);
+    if (new_buffer) {
+        writer->buffer          = new_buffer;
+        writer->buffer_capacity = capacity;
+    }
+}
+
+void query_writer_set_binary(query_writer_t *writer) {
+    if (!writer->lines)
+        writer->binary = 1;
+}
+
 void query_writer_write_new_object(query_writer_t *writer) {
-    if (writer->stream) {
+    if (g_atomic_int_get(&writer->cancelled))
+        return;
+
+    /* Objects outside of the page are still counted, so that formatted output is numbered */
+    writer->skipping =
+        writer->current_object <= writer->page_begin || writer->current_object > writer->page_end;
+    if (writer->skipping) {
+        writer->current_object++;
+        return;
+    }
+
+    if (writer->binary) {
+        /* Record length, updated as fields are written */
+        writer->record_begin = writer->buffer_length;
+        if (!__query_writer_reserve(writer, 4))
+            __query_writer_put_integer(writer, 0, 4);
+    } else if (!writer->lines) {
         /* Spacing after last item (don't add spacing to the beginning of the file) */
-        if (writer->current_object != 1)
-            fputc('\n', writer->stream);
+        if (writer->wrote_object)
+            __query_writer_putc(writer, '\n');
 
         /* Print object number for formatted output */
         if (writer->formatted)
-            fprintf(writer->stream, "--- %zu ---\n", writer->current_object);
+            __query_writer_printf(writer, "--- %zu ---\n", writer->current_object);
     } else {
-        if (writer->current_object != 1) {
+        if (writer->wrote_object) {
             if (writer->formatted) {
                 /* Spacing after last item (don't add spacing to the beginning of the file) */
-                g_ptr_array_add(writer->lines, string_pool_put(writer->strings, ""));
+                __query_writer_add_line(writer, "");
             } else {
                 /* Flush last time (it's invalid for the first object) */
-                g_ptr_array_add(writer->lines,
-                                string_pool_put(writer->strings, writer->current_line));
+                __query_writer_add_line(writer, writer->current_line);
                 writer->current_line_cursor = 0;
             }
         }
@@ -129,34 +545,68 @@ void query_writer_write_new_object(query_writer_t *writer) {
         if (writer->formatted) {
             char line[LINE_MAX];
             snprintf(line, LINE_MAX, "--- %zu ---", writer->current_object);
-            g_ptr_array_add(writer->lines, string_pool_put(writer->strings, line));
+            __query_writer_add_line(writer, line);
         }
     }
 
     writer->current_object++;
     writer->is_first_field = 1;
+    writer->wrote_object   = 1;
+}
+
+void query_writer_set_page(query_writer_t *writer, size_t offset, size_t limit) {
+    writer->page_begin = offset;
+    writer->page_end   = limit > SIZE_MAX - offset ? SIZE_MAX : offset + limit;
+}
+
+void query_writer_skip_objects(query_writer_t *writer, size_t n) {
+    writer->current_object += n;
+}
+
+int query_writer_is_page_full(const query_writer_t *writer) {
+    return writer->current_object > writer->page_end;
 }
 
 void query_writer_write_new_field(query_writer_t *writer,
                                   const char     *key,
                                   const char     *format,
                                   ...) {
+    if (g_atomic_int_get(&writer->cancelled) || writer->skipping)
+        return;
+
     va_list printf_args;
     va_start(printf_args, format);
 
-    if (writer->stream) {
+    if (writer->binary) {
+        /* The string's length is only known after formatting it */
+        if (__query_writer_start_binary_field(writer,
+                                              key,
+                                              QUERY_WRITER_BINARY_TYPE_STRING,
+                                              sizeof(uint32_t)))
+            goto DEFER_1;
+
+        const size_t length_position = writer->buffer_length;
+        writer->buffer_length       += sizeof(uint32_t);
+        __query_writer_vprintf(writer, format, printf_args);
+
+        const size_t end      = writer->buffer_length;
+        writer->buffer_length = length_position;
+        __query_writer_put_integer(writer, end - length_position - sizeof(uint32_t), 4);
+        writer->buffer_length = end;
+        __query_writer_update_record_length(writer);
+    } else if (!writer->lines) {
 
         if (writer->formatted) {
             /* Print line "key: value" */
-            fprintf(writer->stream, "%s: ", key);
-            vfprintf(writer->stream, format, printf_args);
-            fputc('\n', writer->stream);
+            __query_writer_printf(writer, "%s: ", key);
+            __query_writer_vprintf(writer, format, printf_args);
+            __query_writer_putc(writer, '\n');
         } else {
             /* Print only values, adding semicolons between them */
             if (!writer->is_first_field) {
-                fputc(';', writer->stream);
+                __query_writer_putc(writer, ';');
             }
-            vfprintf(writer->stream, format, printf_args);
+            __query_writer_vprintf(writer, format, printf_args);
             writer->is_first_field = 0;
         }
     } else {
@@ -165,7 +615,7 @@ void query_writer_write_new_field(query_writer_t *writer,
             char         line[LINE_MAX];
             const size_t len = snprintf(line, LINE_MAX, "%s: ", key);
             vsnprintf(line + len, LINE_MAX - len, format, printf_args);
-            g_ptr_array_add(writer->lines, string_pool_put(writer->strings, line));
+            __query_writer_add_line(writer, line);
         } else {
             /*
              * Print only values, adding semicolons between them. This is done to
@@ -184,34 +634,386 @@ void query_writer_write_new_field(query_writer_t *writer,
         }
     }
 
+DEFER_1:
     va_end(printf_args);
 }
 
+/**
+ * @brief   Writes a field of an object to a query writer, whose value has already been formatted.
+ * @details Auxiliary method for all typed field writers (e.g.:
+ *          ::query_writer_write_new_field_date). In binary output, the value is written as a
+ *          string.
+ *
+ * @param writer Where to write the query's output to.
+ * @param key    Name of the field being outputted.
+ * @param value  Formatted value of the field (doesn't need to be null-terminated).
+ * @param length Number of characters in @p value.
+ */
+void __query_writer_write_field(query_writer_t *writer,
+                                const char     *key,
+                                const char     *value,
+                                size_t          length) {
+    if (writer->binary) {
+        __query_writer_write_binary_string(writer, key, value, length);
+        return;
+    }
+
+    if (g_atomic_int_get(&writer->cancelled) || writer->skipping)
+        return;
+
+    if (!writer->lines) {
+        if (writer->formatted) {
+            /* Print line "key: value" */
+            const size_t key_length = strlen(key);
+            if (__query_writer_reserve(writer, key_length + length + 3))
+                return;
+
+            char *const end = writer->buffer + writer->buffer_length;
+            memcpy(end, key, key_length);
+            end[key_length]     = ':';
+            end[key_length + 1] = ' ';
+            memcpy(end + key_length + 2, value, length);
+            end[key_length + length + 2] = '\n';
+            writer->buffer_length += key_length + length + 3;
+        } else {
+            /* Print only values, adding semicolons between them */
+            if (__query_writer_reserve(writer, length + 1))
+                return;
+
+            if (!writer->is_first_field)
+                writer->buffer[writer->buffer_length++] = ';';
+            memcpy(writer->buffer + writer->buffer_length, value, length);
+            writer->buffer_length += length;
+            writer->is_first_field = 0;
+        }
+    } else {
+        if (writer->formatted) {
+            /* Print line "key: value" */
+            char line[LINE_MAX];
+            snprintf(line, LINE_MAX, "%s: %.*s", key, (int) length, value);
+            __query_writer_add_line(writer, line);
+        } else {
+            /* Print only values, adding semicolons between them, to writer->current_line */
+            size_t cursor = writer->current_line_cursor;
+            if (!writer->is_first_field && cursor < LINE_MAX - 1)
+                writer->current_line[cursor++] = ';';
+
+            const size_t copied = min(length, LINE_MAX - 1 - cursor);
+            memcpy(writer->current_line + cursor, value, copied);
+            writer->current_line[cursor + copied] = '\0';
+
+            writer->current_line_cursor = cursor + copied;
+            writer->is_first_field      = 0;
+        }
+    }
+}
+
+void query_writer_write_new_field_string(query_writer_t *writer,
+                                         const char     *key,
+                                         const char     *value) {
+    __query_writer_write_field(writer, key, value, strlen(value));
+}
+
+void query_writer_write_new_field_unsigned(query_writer_t *writer,
+                                           const char     *key,
+                                           uint64_t        value) {
+    if (writer->binary) {
+        __query_writer_write_binary_integer(writer, key, QUERY_WRITER_BINARY_TYPE_UNSIGNED, value);
+        return;
+    }
+
+    char         str[INT_UTILS_SPRINT_MIN_BUFFER_SIZE];
+    const size_t length = int_utils_sprint_unsigned(str, value);
+    __query_writer_write_field(writer, key, str, length);
+}
+
+void query_writer_write_new_field_signed(query_writer_t *writer, const char *key, int64_t value) {
+    if (writer->binary) {
+        __query_writer_write_binary_integer(writer,
+                                            key,
+                                            QUERY_WRITER_BINARY_TYPE_SIGNED,
+                                            (uint64_t) value);
+        return;
+    }
+
+    char str[INT_UTILS_SPRINT_MIN_BUFFER_SIZE + 1];
+    str[0] = '-';
+
+    /* Negate as unsigned, so that INT64_MIN doesn't overflow */
+    const int    negative = value < 0;
+    const size_t length =
+        int_utils_sprint_unsigned(str + negative, negative ? -(uint64_t) value : (uint64_t) value);
+    __query_writer_write_field(writer, key, str, length + negative);
+}
+
+/** @brief Minimum size of the buffer passed to ::__query_writer_sprint_decimal. */
+#define QUERY_WRITER_DECIMAL_MIN_BUFFER_SIZE (INT_UTILS_SPRINT_MIN_BUFFER_SIZE + 5)
+
+/**
+ * @brief   Prints a number with three decimal places, like `printf("%.3f", value)`.
+ * @details The number is scaled to thousandths and rounded with integer arithmetic. Values too
+ *          close to halfway between two thousandths (where the rounding error of scaling could
+ *          change the result), and values too large for that, aren't printed.
+ *
+ * @param output Where to print the number to. Must be at least
+ *               ::QUERY_WRITER_DECIMAL_MIN_BUFFER_SIZE characters long.
+ * @param length Where to output the number of characters written to @p output to, not including
+ *               the null terminator.
+ * @param value  Number to be printed.
+ *
+ * @retval 0 Success.
+ * @retval 1 @p value must be printed with `printf`.
+ */
+int __query_writer_sprint_decimal(char *output, size_t *length, double value) {
+    const int    negative  = signbit(value) != 0;
+    const double magnitude = negative ? -value : value;
+    const double scaled    = magnitude * 1000.0;
+
+    if (!(scaled < 0x1p52)) /* Also true for NaN */
+        return 1;
+
+    uint64_t     thousandths = (uint64_t) scaled;
+    const double fraction    = scaled - (double) thousandths; /* Exact */
+    const double error       = scaled * 0x1p-50;
+    if (fraction > 0.5 - error && fraction < 0.5 + error)
+        return 1;
+    thousandths += fraction > 0.5;
+
+    size_t i = 0;
+    if (negative)
+        output[i++] = '-';
+    i += int_utils_sprint_unsigned(output + i, thousandths / 1000);
+    output[i++] = '.';
+    int_utils_write_fixed(output + i, thousandths % 1000, 3);
+    i += 3;
+    output[i] = '\0';
+
+    *length = i;
+    return 0;
+}
+
+void query_writer_write_new_field_decimal(query_writer_t *writer, const char *key, double value) {
+    if (writer->binary) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(uint64_t));
+        __query_writer_write_binary_integer(writer, key, QUERY_WRITER_BINARY_TYPE_DECIMAL, bits);
+        return;
+    }
+
+    char   str[QUERY_WRITER_DECIMAL_MIN_BUFFER_SIZE];
+    size_t length;
+    if (__query_writer_sprint_decimal(str, &length, value))
+        query_writer_write_new_field(writer, key, "%.3f", value);
+    else
+        __query_writer_write_field(writer, key, str, length);
+}
+
+void query_writer_write_new_field_cents(query_writer_t *writer, const char *key, uint64_t cents) {
+    if (writer->binary) {
+        __query_writer_write_binary_integer(writer, key, QUERY_WRITER_BINARY_TYPE_CENTS, cents);
+        return;
+    }
+
+    char         str[QUERY_WRITER_DECIMAL_MIN_BUFFER_SIZE];
+    const size_t units = int_utils_sprint_unsigned(str, cents / 100);
+
+    str[units] = '.';
+    int_utils_write_fixed(str + units + 1, cents % 100, 2);
+    str[units + 3] = '0';
+    str[units + 4] = '\0';
+    __query_writer_write_field(writer, key, str, units + 4);
+}
+
+void query_writer_write_new_field_date(query_writer_t *writer, const char *key, date_t value) {
+    if (writer->binary) {
+        if (!__query_writer_start_binary_field(writer, key, QUERY_WRITER_BINARY_TYPE_DATE, 4)) {
+            __query_writer_put_date(writer, value);
+            __query_writer_update_record_length(writer);
+        }
+        return;
+    }
+
+    char str[DATE_SPRINTF_MIN_BUFFER_SIZE];
+    date_sprintf(str, value);
+    __query_writer_write_field(writer, key, str, DATE_SPRINTF_MIN_BUFFER_SIZE - 1);
+}
+
+void query_writer_write_new_field_date_and_time(query_writer_t *writer,
+                                                const char     *key,
+                                                date_and_time_t value) {
+    if (writer->binary) {
+        if (!__query_writer_start_binary_field(writer,
+                                               key,
+                                               QUERY_WRITER_BINARY_TYPE_DATE_AND_TIME,
+                                               7)) {
+            const daytime_t time = date_and_time_get_time(value);
+            __query_writer_put_date(writer, date_and_time_get_date(value));
+            __query_writer_put_integer(writer, daytime_get_hours(time), 1);
+            __query_writer_put_integer(writer, daytime_get_minutes(time), 1);
+            __query_writer_put_integer(writer, daytime_get_seconds(time), 1);
+            __query_writer_update_record_length(writer);
+        }
+        return;
+    }
+
+    char str[DATE_AND_TIME_SPRINTF_MIN_BUFFER_SIZE];
+    date_and_time_sprintf(str, value);
+    __query_writer_write_field(writer, key, str, DATE_AND_TIME_SPRINTF_MIN_BUFFER_SIZE - 1);
+}
+
+void query_writer_write_new_field_airport_code(query_writer_t *writer,
+                                               const char     *key,
+                                               airport_code_t  value) {
+    char str[AIRPORT_CODE_SPRINTF_MIN_BUFFER_SIZE];
+    airport_code_sprintf(str, value);
+    __query_writer_write_field(writer, key, str, strlen(str));
+}
+
+void query_writer_append_chunk(query_writer_t *writer, const query_writer_t *chunk) {
+    writer->failed         = writer->failed || chunk->failed;
+    writer->current_object = max(writer->current_object, chunk->current_object);
+    if (!chunk->wrote_object)
+        return;
+
+    /* Spacing between the last object of the writer and the first one of the chunk */
+    if (writer->wrote_object && !writer->binary)
+        __query_writer_putc(writer, '\n');
+
+    writer->record_begin = writer->buffer_length + chunk->record_begin;
+    if (!__query_writer_reserve(writer, chunk->buffer_length)) {
+        memcpy(writer->buffer + writer->buffer_length, chunk->buffer, chunk->buffer_length);
+        writer->buffer_length += chunk->buffer_length;
+    }
+
+    writer->is_first_field = chunk->is_first_field;
+    writer->wrote_object   = 1;
+}
+
+int query_writer_close(query_writer_t *writer) {
+    /* Chunks are never closed, only appended to other writers */
+    if (writer->lines || writer->closed || (!writer->path && !writer->container))
+        return 0;
+    writer->closed = 1;
+
+    /* Flush missing last line before writing file */
+    if (!writer->formatted && !writer->binary && !(writer->is_first_field && !writer->wrote_object))
+        __query_writer_putc(writer, '\n');
+
+    int retval = writer->failed;
+    event_trace_begin("output", "flush", 0);
+
+    if (writer->container) {
+        writer->container_length = writer->buffer_length;
+        if (query_output_container_add(writer->container,
+                                       writer->container_id,
+                                       writer->buffer,
+                                       writer->buffer_length,
+                                       &writer->container_offset))
+            writer->failed = retval = 1;
+        goto DEFER_1;
+    }
+
+    const int fd = open(writer->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        retval = 1;
+        goto DEFER_1;
+    }
+
+    size_t written = 0;
+    while (written < writer->buffer_length) {
+        const ssize_t ret = write(fd, writer->buffer + written, writer->buffer_length - written);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            retval = 1;
+            break;
+        }
+        written += ret;
+    }
+
+    if (close(fd))
+        retval = 1;
+
+DEFER_1:
+    event_trace_end();
+    free(writer->buffer);
+    writer->buffer          = NULL;
+    writer->buffer_length   = 0;
+    writer->buffer_capacity = 0;
+    return retval;
+}
+
+int query_writer_close_as_link(query_writer_t *writer, const query_writer_t *original) {
+    if (writer->container && writer->container == original->container) {
+        if (writer->closed || !original->closed || original->failed ||
+            query_output_container_add_link(writer->container,
+                                            writer->container_id,
+                                            original->container_offset,
+                                            original->container_length))
+            return 1;
+
+        writer->closed = 1;
+        return 0;
+    }
+
+    if (!writer->path || !original->path || writer->closed || !original->closed ||
+        original->failed)
+        return 1;
+
+    if (unlink(writer->path) && errno != ENOENT)
+        return 1;
+    if (link(original->path, writer->path))
+        return 1;
+
+    writer->closed = 1;
+    return 0;
+}
+
 const char *const *query_writer_get_lines(query_writer_t *writer, size_t *out_n) {
-    if (writer->stream)
+    if (!writer->lines)
         return NULL;
 
     /* Flush last line when printing to a set of strings */
     if (writer->current_line_cursor != 0) {
         writer->current_line_cursor = 0;
-        g_ptr_array_add(writer->lines, string_pool_put(writer->strings, writer->current_line));
+        __query_writer_add_line(writer, writer->current_line);
     }
 
     *out_n = writer->lines->len;
     return (const char *const *) writer->lines->pdata;
 }
 
-void query_writer_free(query_writer_t *writer) {
-    /* Flush missing last line before closing file */
-    if (!writer->formatted && writer->stream &&
-        !(writer->is_first_field && writer->current_object == 1))
-        fputc('\n', writer->stream);
+size_t query_writer_get_line_count(query_writer_t *writer) {
+    if (!writer->lines)
+        return 0;
 
-    if (writer->stream) {
-        fclose(writer->stream);
+    pthread_mutex_lock(&writer->lines_lock);
+    const size_t count = writer->lines->len;
+    pthread_mutex_unlock(&writer->lines_lock);
+    return count;
+}
+
+const char *query_writer_get_line(query_writer_t *writer, size_t i) {
+    pthread_mutex_lock(&writer->lines_lock);
+    const char *const line = g_ptr_array_index(writer->lines, i);
+    pthread_mutex_unlock(&writer->lines_lock);
+    return line;
+}
+
+void query_writer_cancel(query_writer_t *writer) {
+    g_atomic_int_set(&writer->cancelled, 1);
+}
+
+void query_writer_free(query_writer_t *writer) {
+    if (!writer->lines) {
+        query_writer_close(writer); /* Ignore IO errors */
+        free(writer->path);
+        free(writer->buffer); /* Not freed by query_writer_close for chunks */
     } else {
         string_pool_free(writer->strings);
         g_ptr_array_unref(writer->lines);
+        pthread_mutex_destroy(&writer->lines_lock);
     }
     free(writer);
 }
@@ -0,0 +1,2132 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  server_mode.c
+ * @brief Implementation of methods in server_mode.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref server_mode_examples).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dataset/dataset_loader.h"
+#include "queries/query_dispatcher.h"
+#include "queries/query_output_cache.h"
+#include "queries/query_parser.h"
+#include "server_mode.h"
+#include "testing/event_trace.h"
+#include "testing/live_metrics.h"
+#include "testing/workload.h"
+#include "utils/cancellation.h"
+#include "utils/class_queue.h"
+#include "utils/epoch.h"
+#include "utils/lz4_block.h"
+#include "utils/thread_count.h"
+
+/** @brief Name of the file, in the cache directory, where a snapshot of the database is kept. */
+#define SERVER_MODE_SNAPSHOT_FILE_NAME ".database_snapshot"
+
+/** @brief Maximum number of connections waiting to be accepted. */
+#define SERVER_MODE_BACKLOG 64
+
+/** @brief Maximum number of queries in a batch (see ::server_mode_data_t::batch). */
+#define SERVER_MODE_MAX_BATCH_SIZE 4096
+
+/** @brief Maximum number of clients connected at the same time. */
+#define SERVER_MODE_MAX_CONNECTIONS 65536
+
+/** @brief Maximum number of bytes received from a client, and not yet handed to a worker. */
+#define SERVER_MODE_MAX_INPUT (1 << 20)
+
+/** @brief Number of bytes read from a socket at once. */
+#define SERVER_MODE_READ_BUFFER_SIZE 4096
+
+/** @brief Maximum number of events handled for every call to `epoll_wait`. */
+#define SERVER_MODE_EPOLL_EVENTS 256
+
+/** @brief Maximum size of an HTTP request to the metrics endpoint. */
+#define SERVER_MODE_MAX_HTTP_REQUEST 8192
+
+/** @brief Maximum time (in microseconds) a query can run for, before a `-1` reply is sent. */
+#define SERVER_MODE_QUERY_TIMEOUT 10000000
+
+/**
+ * @brief Maximum number of bytes of replies not yet sent to a binary client, above which no more of
+ *        its requests are executed.
+ */
+#define SERVER_MODE_MAX_OUTPUT (1 << 20)
+
+/** @brief Size of every frame in the binary protocol, before its variable-length data. */
+#define SERVER_MODE_FRAME_SIZE_SIZE 4
+
+/** @brief Size of a binary request, after its size, until its arguments. */
+#define SERVER_MODE_REQUEST_HEADER_SIZE 23
+
+/** @brief Size of a binary reply, until its payload. */
+#define SERVER_MODE_REPLY_HEADER_SIZE 18
+
+/** @brief Minimum size of the payload of a binary reply for it to be compressed. */
+#define SERVER_MODE_MIN_COMPRESSED_SIZE 512
+
+/** @brief Average execution time (in microseconds) above which a query type is heavy. */
+#define SERVER_MODE_HEAVY_COST 1000
+
+/** @brief One in this many worker threads is reserved for light queries. */
+#define SERVER_MODE_LIGHT_WORKERS_RATIO 4
+
+/** @brief Maximum number of bytes used by the outputs of popular queries, kept in memory. */
+#define SERVER_MODE_OUTPUT_CACHE_SIZE (64 << 20)
+
+/** @brief How a client talks to the server. */
+typedef enum {
+    SERVER_MODE_PROTOCOL_UNKNOWN, /**< Not enough data was received to know the protocol. */
+    SERVER_MODE_PROTOCOL_TEXT,    /**< One query per line, answered one at a time. */
+    SERVER_MODE_PROTOCOL_BINARY,  /**< Pipelined frames (see server_mode.h). */
+    SERVER_MODE_PROTOCOL_HTTP     /**< HTTP requests to the metrics endpoint. */
+} server_mode_protocol_t;
+
+/**
+ * @brief   Priority class of a query, in ::server_mode_data_t::jobs.
+ * @details Light queries are taken first by all workers, some reserved for them, and preempt heavy
+ *          queries at block boundaries (see ::__server_mode_yield).
+ */
+typedef enum {
+    SERVER_MODE_CLASS_LIGHT, /**< Lookups, expected to be answered quickly. */
+    SERVER_MODE_CLASS_HEAVY  /**< Scans, or queries that need statistical data. */
+} server_mode_class_t;
+
+/**
+ * @struct server_mode_request_t
+ * @brief  A query waiting to be executed in a batch, by the thread that collects it.
+ *
+ * @var server_mode_request_t::instance
+ *     @brief Query to be executed.
+ * @var server_mode_request_t::writer
+ *     @brief Where to write the query's output to.
+ * @var server_mode_request_t::done
+ *     @brief Whether the batch containing this query has been executed.
+ * @var server_mode_request_t::failed
+ *     @brief Whether the batch containing this query couldn't be executed.
+ */
+typedef struct {
+    query_instance_t *instance;
+    query_writer_t   *writer;
+    int               done, failed;
+} server_mode_request_t;
+
+/**
+ * @struct server_mode_connection_t
+ * @brief  State of a connected client, only accessed by the event loop.
+ *
+ * @var server_mode_connection_t::fd
+ *     @brief Socket connected to the client.
+ * @var server_mode_connection_t::events
+ *     @brief Events `epoll` is waiting for on ::server_mode_connection_t::fd.
+ * @var server_mode_connection_t::input
+ *     @brief Data received from the client, not yet handed to a worker.
+ * @var server_mode_connection_t::output
+ *     @brief Replies not yet completely sent to the client.
+ * @var server_mode_connection_t::sent
+ *     @brief Number of bytes in ::server_mode_connection_t::output already sent.
+ * @var server_mode_connection_t::recorded
+ *     @brief Number of bytes in ::server_mode_connection_t::input whose queries were already
+ *            recorded (see ::server_mode_loop_t::recorder).
+ * @var server_mode_connection_t::eof
+ *     @brief Whether the client won't send more queries.
+ * @var server_mode_connection_t::failed
+ *     @brief Whether the connection must be closed, due to an error.
+ * @var server_mode_connection_t::jobs
+ *     @brief   Jobs (::server_mode_job_t) from this client being executed by workers.
+ *     @details At most one for text clients, and up to ::SERVER_MODE_MAX_PIPELINE for binary ones.
+ * @var server_mode_connection_t::protocol
+ *     @brief How the client talks to the server. HTTP connections to the metrics endpoint are
+ *            known as such when accepted, and other clients once they send their first bytes.
+ */
+typedef struct {
+    int      fd;
+    uint32_t events;
+    GString *input, *output;
+    size_t   sent, recorded;
+    int      eof, failed;
+
+    GPtrArray             *jobs;
+    server_mode_protocol_t protocol;
+} server_mode_connection_t;
+
+/**
+ * @struct server_mode_job_t
+ * @brief  A query handed by the event loop to a worker thread.
+ *
+ * @var server_mode_job_t::connection
+ *     @brief   Connection where the query was received from.
+ *     @details Must not be accessed by workers.
+ * @var server_mode_job_t::query
+ *     @brief   Query to be executed.
+ *     @details A null-terminated line for text clients, or the part of a binary request after its
+ *              identifier.
+ * @var server_mode_job_t::length
+ *     @brief Number of bytes in ::server_mode_job_t::query.
+ * @var server_mode_job_t::id
+ *     @brief Identifier of a binary request, to be repeated in its reply.
+ * @var server_mode_job_t::protocol
+ *     @brief Protocol of ::server_mode_job_t::query and ::server_mode_job_t::reply.
+ * @var server_mode_job_t::priority
+ *     @brief Priority class of the query, chosen by the event loop.
+ * @var server_mode_job_t::reply
+ *     @brief Where the worker writes the reply to be sent to the client.
+ * @var server_mode_job_t::cancellation
+ *     @brief   Requested when the query times out, or when its client disconnects.
+ *     @details Queries executed in batches (see ::server_mode_data_t::batch) aren't cancelled.
+ */
+typedef struct {
+    server_mode_connection_t *connection;
+    char                     *query;
+    size_t                    length;
+    uint32_t                  id;
+    server_mode_protocol_t    protocol;
+    server_mode_class_t       priority;
+    GString                  *reply;
+    cancellation_t            cancellation;
+} server_mode_job_t;
+
+/**
+ * @struct server_mode_data_t
+ * @brief  Data shared by all threads that answer queries in ::server_mode_run.
+ *
+ * @var server_mode_data_t::dataset_dir
+ *     @brief Path to the directory containing the dataset, to be reloaded on `SIGHUP`.
+ * @var server_mode_data_t::cache_dir
+ *     @brief Path to the directory where a snapshot of the database is kept, or `NULL`.
+ * @var server_mode_data_t::database
+ *     @brief   Database to be queried, accessed atomically.
+ *     @details Replaced when the dataset is reloaded. Must only be read inside an epoch section
+ *              (see ::server_mode_data_t::epoch), and only until the end of that section.
+ * @var server_mode_data_t::epoch
+ *     @brief Domain of the threads that read ::server_mode_data_t::database, so that a replaced
+ *            database is only `free`d once no thread can be reading it.
+ * @var server_mode_data_t::reloaded
+ *     @brief Set (atomically) when the thread reloading the dataset finishes.
+ * @var server_mode_data_t::cache
+ *     @brief Statistical data kept between queries. Can be `NULL`.
+ * @var server_mode_data_t::cache_lock
+ *     @brief   Lock that protects ::server_mode_data_t::cache and
+ *              ::server_mode_data_t::cache_database.
+ *     @details Only queries that need statistical data need to hold it, so that lookups (e.g.:
+ *              query 1) are answered concurrently.
+ * @var server_mode_data_t::cache_database
+ *     @brief Database the statistical data in ::server_mode_data_t::cache was generated for.
+ * @var server_mode_data_t::outputs
+ *     @brief   Outputs of popular queries, to answer repeated queries without executing them.
+ *     @details `NULL` when it couldn't be allocated. Invalidated when the dataset is reloaded.
+ * @var server_mode_data_t::batch_window
+ *     @brief Time (in microseconds) to wait for other queries to join a batch. `0` disables
+ *            batching.
+ * @var server_mode_data_t::batch_lock
+ *     @brief Lock that protects ::server_mode_data_t::batch and ::server_mode_data_t::collecting.
+ * @var server_mode_data_t::batch_cond
+ *     @brief Condition signaled when a batch becomes full, or when a batch is executed.
+ * @var server_mode_data_t::batch
+ *     @brief   Queries (::server_mode_request_t) that need statistical data, waiting to be
+ *              executed together.
+ *     @details Queries in a batch are grouped by type by the dispatcher, so that statistical data
+ *              is generated for all queries of the same type at once.
+ * @var server_mode_data_t::collecting
+ *     @brief Whether a thread is waiting for ::server_mode_data_t::batch to be filled, before
+ *            executing it.
+ * @var server_mode_data_t::jobs
+ *     @brief Queue of jobs (::server_mode_job_t) to be executed by worker threads, in one class per
+ *            ::server_mode_class_t.
+ * @var server_mode_data_t::light_jobs
+ *     @brief   Number of light jobs in ::server_mode_data_t::jobs, accessed atomically.
+ *     @details Lets heavy queries check cheaply whether they need to yield.
+ * @var server_mode_data_t::costs
+ *     @brief   Average execution time (in microseconds) of each query type, accessed atomically.
+ *     @details Exponential moving average, used to classify queries (see ::__server_mode_classify).
+ * @var server_mode_data_t::completed_lock
+ *     @brief Lock that protects ::server_mode_data_t::completed.
+ * @var server_mode_data_t::completed
+ *     @brief Jobs (::server_mode_job_t) executed by workers, whose replies haven't been sent yet.
+ * @var server_mode_data_t::completed_fd
+ *     @brief `eventfd` written to by workers, to wake up the event loop after finishing a job (or
+ *            by the thread reloading the dataset, once it's done).
+ * @var server_mode_data_t::metrics
+ *     @brief Counters exposed by the metrics endpoint. `NULL` when it's disabled.
+ */
+typedef struct {
+    const char     *dataset_dir;
+    const char     *cache_dir;
+    database_t     *database;
+    epoch_domain_t *epoch;
+    gint            reloaded;
+
+    query_statistics_cache_t *cache;
+    pthread_mutex_t           cache_lock;
+    const database_t         *cache_database;
+    query_output_cache_t     *outputs;
+
+    unsigned long   batch_window;
+    pthread_mutex_t batch_lock;
+    pthread_cond_t  batch_cond;
+    GPtrArray      *batch;
+    int             collecting;
+
+    class_queue_t  *jobs;
+    gint            light_jobs;
+    gint            costs[QUERY_TYPE_LIST_COUNT + 1];
+    pthread_mutex_t completed_lock;
+    GPtrArray      *completed;
+    int             completed_fd;
+
+    live_metrics_t *metrics;
+} server_mode_data_t;
+
+/**
+ * @struct server_mode_loop_t
+ * @brief  State of the event loop, that handles all connections in a single thread.
+ *
+ * @var server_mode_loop_t::data
+ *     @brief Data shared with worker threads.
+ * @var server_mode_loop_t::socket
+ *     @brief Listening socket, from which connections are accepted.
+ * @var server_mode_loop_t::metrics_socket
+ *     @brief Listening TCP socket of the metrics endpoint, or `-1` if it's disabled.
+ * @var server_mode_loop_t::epoll_fd
+ *     @brief `epoll` instance waiting for events on all file descriptors.
+ * @var server_mode_loop_t::signal_fd
+ *     @brief `signalfd` that receives termination signals.
+ * @var server_mode_loop_t::connections
+ *     @brief Set of connected clients (::server_mode_connection_t), `free`d when removed.
+ * @var server_mode_loop_t::participant
+ *     @brief Epoch participant of the event loop's thread, that reads the database for metrics.
+ * @var server_mode_loop_t::recorder
+ *     @brief Where queries are recorded as they arrive. `NULL` when recording is disabled.
+ * @var server_mode_loop_t::reload_thread
+ *     @brief Thread reloading the dataset, if ::server_mode_loop_t::reloading.
+ * @var server_mode_loop_t::reloading
+ *     @brief Whether ::server_mode_loop_t::reload_thread is running (or hasn't been joined yet).
+ */
+typedef struct {
+    server_mode_data_t *data;
+    int                 socket;
+    int                 metrics_socket;
+    int                 epoll_fd;
+    int                 signal_fd;
+    GHashTable         *connections;
+
+    epoch_participant_t *participant;
+    workload_recorder_t *recorder;
+    pthread_t            reload_thread;
+    int                  reloading;
+} server_mode_loop_t;
+
+/**
+ * @brief Loads a database, from a snapshot if possible.
+ *
+ * @param dataset_dir Path to the directory containing the dataset.
+ * @param cache_dir   Path to the directory where the snapshot is kept, or `NULL` for no snapshot.
+ *
+ * @return The loaded database, or `NULL` on failure.
+ */
+database_t *__server_mode_load_database(const char *dataset_dir, const char *cache_dir) {
+    char snapshot_path[PATH_MAX];
+    if (cache_dir &&
+        snprintf(snapshot_path, PATH_MAX, "%s/" SERVER_MODE_SNAPSHOT_FILE_NAME, cache_dir) >=
+            PATH_MAX)
+        cache_dir = NULL; /* Path too long: just don't keep a snapshot */
+
+    return dataset_loader_load_cached(dataset_dir,
+                                      "Resultados",
+                                      cache_dir ? snapshot_path : NULL,
+                                      NULL);
+}
+
+/**
+ * @brief   Locks the statistics cache, to run queries that need statistical data on a database.
+ * @details Statistical data generated for another database (before or after the dataset was
+ *          reloaded) is discarded.
+ *
+ * @param data     Data shared by all threads that answer queries.
+ * @param database Database the queries will run on.
+ */
+void __server_mode_lock_cache(server_mode_data_t *data, const database_t *database) {
+    pthread_mutex_lock(&data->cache_lock);
+    if (data->cache && data->cache_database != database) {
+        query_statistics_cache_clear(data->cache);
+        data->cache_database = database;
+    }
+}
+
+/**
+ * @struct server_mode_order_data_t
+ * @brief  Data needed to order the outputs of a batch, in ::__server_mode_order_callback.
+ *
+ * @var server_mode_order_data_t::batch
+ *     @brief Queries (::server_mode_request_t) in the batch.
+ * @var server_mode_order_data_t::outputs
+ *     @brief Query writers, in the order of the list of queries in the batch.
+ * @var server_mode_order_data_t::i
+ *     @brief Number of writers in ::server_mode_order_data_t::outputs.
+ */
+typedef struct {
+    GPtrArray       *batch;
+    query_writer_t **outputs;
+    size_t           i;
+} server_mode_order_data_t;
+
+/**
+ * @brief Called for every query in a batch, to place its writer where the dispatcher expects it.
+ *
+ * @param user_data A pointer to a ::server_mode_order_data_t.
+ * @param instance  Query in the batch. Its line number is its position in the batch, plus one.
+ *
+ * @retval 0 Always successful.
+ */
+int __server_mode_order_callback(void *user_data, const query_instance_t *instance) {
+    server_mode_order_data_t *const order_data = user_data;
+    const size_t                    position   = query_instance_get_line_in_file(instance) - 1;
+    const server_mode_request_t    *request    = g_ptr_array_index(order_data->batch, position);
+
+    order_data->outputs[order_data->i++] = request->writer;
+    return 0;
+}
+
+/**
+ * @brief Updates the lookup counts of the statistics cache in the metrics endpoint.
+ * @param data Data shared by all threads that answer queries. Its
+ *             ::server_mode_data_t::cache_lock must be held.
+ */
+void __server_mode_publish_cache_counts(server_mode_data_t *data) {
+    if (!data->metrics || !data->cache)
+        return;
+
+    size_t hits, misses;
+    query_statistics_cache_get_lookup_counts(data->cache, &hits, &misses);
+    live_metrics_set_value(data->metrics, LIVE_METRICS_VALUE_CACHE_HITS, hits);
+    live_metrics_set_value(data->metrics, LIVE_METRICS_VALUE_CACHE_MISSES, misses);
+}
+
+/**
+ * @brief Updates the metrics about the dataset, after it's loaded.
+ *
+ * @param metrics  Metrics to be updated. Can be `NULL`, for nothing to be done.
+ * @param database Loaded database.
+ * @param start    When loading started (`CLOCK_MONOTONIC`).
+ */
+void __server_mode_publish_dataset_metrics(live_metrics_t         *metrics,
+                                           const database_t       *database,
+                                           const struct timespec *start) {
+    if (!metrics)
+        return;
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const long load_time =
+        (end.tv_sec - start->tv_sec) * 1000000 + (end.tv_nsec - start->tv_nsec) / 1000;
+
+    live_metrics_set_value(metrics, LIVE_METRICS_VALUE_LOAD_TIME, (uint64_t) load_time);
+    live_metrics_set_value(metrics,
+                           LIVE_METRICS_VALUE_USERS,
+                           user_manager_get_length(database_get_users(database)));
+    live_metrics_set_value(metrics,
+                           LIVE_METRICS_VALUE_FLIGHTS,
+                           flight_manager_get_length(database_get_flights(database)));
+    live_metrics_set_value(metrics,
+                           LIVE_METRICS_VALUE_RESERVATIONS,
+                           reservation_manager_get_length(database_get_reservations(database)));
+}
+
+/**
+ * @brief   Executes all queries in a batch.
+ * @details Queries are grouped by type by the dispatcher, so that statistical data is generated
+ *          for all queries of the same type at once.
+ *
+ * @param data  Data shared by all threads that answer queries.
+ * @param batch Queries (::server_mode_request_t) to be executed.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __server_mode_execute_batch(server_mode_data_t *data, GPtrArray *batch) {
+    int retval = 0;
+
+    query_instance_list_t *const list = query_instance_list_create();
+    if (!list) {
+        retval = 1;
+        goto DEFER_1;
+    }
+
+    query_writer_t **const outputs = malloc(sizeof(query_writer_t *) * batch->len);
+    if (!outputs) {
+        retval = 1;
+        goto DEFER_2;
+    }
+
+    /* Line numbers identify requests once the list is grouped by query type */
+    for (size_t i = 0; i < batch->len; ++i) {
+        server_mode_request_t *const request = g_ptr_array_index(batch, i);
+        query_instance_set_line_in_file(request->instance, i + 1);
+        if (query_instance_list_add(list, request->instance)) {
+            retval = 1;
+            goto DEFER_3;
+        }
+    }
+
+    server_mode_order_data_t order_data = {.batch = batch, .outputs = outputs, .i = 0};
+    query_instance_list_iter(list, __server_mode_order_callback, &order_data);
+
+    /* The batch is shared with other clients, so the leader's cancellation can't stop it */
+    const cancellation_t *const previous = cancellation_suspend();
+    const database_t *const database = g_atomic_pointer_get(&data->database);
+    __server_mode_lock_cache(data, database);
+    event_trace_begin("execution", "batch", batch->len);
+    query_dispatcher_dispatch_list(database, data->cache, list, outputs, 0, NULL);
+    event_trace_end();
+    __server_mode_publish_cache_counts(data);
+    pthread_mutex_unlock(&data->cache_lock);
+    cancellation_set_current(previous);
+
+DEFER_3:
+    free(outputs);
+DEFER_2:
+    query_instance_list_free(list);
+DEFER_1:
+    return retval;
+}
+
+/**
+ * @brief   Executes a query that needs statistical data, in a batch with other clients' queries.
+ * @details The first thread to add a query to an empty batch waits for
+ *          ::server_mode_data_t::batch_window (or for the batch to fill up), and then executes the
+ *          whole batch. Other threads wait for that to happen.
+ *
+ * @param data     Data shared by all threads that answer queries.
+ * @param instance Query to be executed.
+ * @param writer   Where to write the query's output to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __server_mode_execute_batched(server_mode_data_t *data,
+                                  query_instance_t   *instance,
+                                  query_writer_t     *writer) {
+    server_mode_request_t request = {.instance = instance,
+                                     .writer   = writer,
+                                     .done     = 0,
+                                     .failed   = 0};
+
+    pthread_mutex_lock(&data->batch_lock);
+    g_ptr_array_add(data->batch, &request);
+    if (data->batch->len >= SERVER_MODE_MAX_BATCH_SIZE)
+        pthread_cond_broadcast(&data->batch_cond);
+
+    if (data->collecting) {
+        while (!request.done)
+            pthread_cond_wait(&data->batch_cond, &data->batch_lock);
+        pthread_mutex_unlock(&data->batch_lock);
+        return request.failed;
+    }
+
+    /* This thread collects the batch, until its window closes */
+    data->collecting = 1;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += data->batch_window / 1000000;
+    deadline.tv_nsec += (long) (data->batch_window % 1000000) * 1000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while (data->batch->len < SERVER_MODE_MAX_BATCH_SIZE &&
+           pthread_cond_timedwait(&data->batch_cond, &data->batch_lock, &deadline) != ETIMEDOUT)
+        ;
+
+    GPtrArray *const batch = data->batch;
+    data->batch            = g_ptr_array_new();
+    data->collecting       = 0;
+    pthread_mutex_unlock(&data->batch_lock);
+
+    const int failed = __server_mode_execute_batch(data, batch);
+
+    pthread_mutex_lock(&data->batch_lock);
+    for (size_t i = 0; i < batch->len; ++i) {
+        server_mode_request_t *const batched = g_ptr_array_index(batch, i);
+        batched->failed                      = failed;
+        batched->done                        = 1;
+    }
+    pthread_cond_broadcast(&data->batch_cond);
+    pthread_mutex_unlock(&data->batch_lock);
+
+    g_ptr_array_free(batch, TRUE);
+    return failed;
+}
+
+/**
+ * @brief Executes a parsed query.
+ *
+ * @param data     Data shared by all threads that answer queries.
+ * @param shard    Where to record the query's execution to. Can be `NULL`.
+ * @param database Value of ::server_mode_data_t::database, read in the current epoch section.
+ * @param instance Query to be executed.
+ * @param writer   Where to write the query's output to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure.
+ */
+int __server_mode_execute(server_mode_data_t   *data,
+                          live_metrics_shard_t *shard,
+                          const database_t     *database,
+                          query_instance_t     *instance,
+                          query_writer_t       *writer) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* Queries that don't need statistical data don't touch the cache, and run concurrently */
+    int       failed;
+    const int needs_statistics = query_type_needs_statistics(query_instance_get_type(instance));
+    if (needs_statistics && data->batch_window) {
+        failed = __server_mode_execute_batched(data, instance, writer);
+    } else if (needs_statistics && data->cache) {
+        __server_mode_lock_cache(data, database);
+        failed = query_dispatcher_dispatch_single(database, data->cache, instance, writer);
+        __server_mode_publish_cache_counts(data);
+        pthread_mutex_unlock(&data->cache_lock);
+    } else {
+        failed = query_dispatcher_dispatch_single(database, NULL, instance, writer);
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const long latency =
+        (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+
+    /* Racing updates may lose a sample, which doesn't matter for an estimate */
+    const size_t type_number = query_type_get_type_number(query_instance_get_type(instance));
+    const gint   cost        = g_atomic_int_get(&data->costs[type_number]);
+    const long   sample      = latency < INT_MAX / 8 ? latency : INT_MAX / 8;
+    g_atomic_int_set(&data->costs[type_number], (gint) ((cost * 7 + sample) / 8));
+
+    /* Not cancellation_check, as that would yield to other queries */
+    if (shard) {
+        const int cancelled = cancellation_is_requested(cancellation_get_current());
+        live_metrics_shard_record_query(shard,
+                                        type_number,
+                                        (uint64_t) latency,
+                                        failed || cancelled);
+    }
+
+    return failed;
+}
+
+/**
+ * @brief Reads a little-endian integer from the binary protocol.
+ *
+ * @param in     Where to read the integer from.
+ * @param nbytes Size of the integer, in bytes.
+ *
+ * @return The read integer.
+ */
+uint64_t __server_mode_read_integer(const char *in, size_t nbytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < nbytes; ++i)
+        value |= (uint64_t) (unsigned char) in[i] << (8 * i);
+    return value;
+}
+
+/**
+ * @brief Writes a little-endian integer in the binary protocol.
+ *
+ * @param out    Where to write the integer to.
+ * @param value  Integer to be written.
+ * @param nbytes Size of the integer, in bytes.
+ */
+void __server_mode_write_integer(char *out, uint64_t value, size_t nbytes) {
+    for (size_t i = 0; i < nbytes; ++i)
+        out[i] = (char) (value >> (8 * i));
+}
+
+/**
+ * @brief Finds the arguments in a request received through the binary protocol.
+ *
+ * @param request   Request, after its identifier.
+ * @param length    Number of bytes in @p request. Must be at least
+ *                  ::SERVER_MODE_REQUEST_HEADER_SIZE minus the size of the identifier.
+ * @param positions Where to write the position of each null-terminated argument in @p request to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Malformed arguments, or too many of them.
+ */
+int __server_mode_find_arguments(const char *request,
+                                 size_t      length,
+                                 size_t      positions[SERVER_MODE_MAX_ARGUMENTS]) {
+    const size_t argc = (unsigned char) request[2];
+    if (argc > SERVER_MODE_MAX_ARGUMENTS)
+        return 1;
+
+    size_t position = SERVER_MODE_REQUEST_HEADER_SIZE - 4;
+    for (size_t i = 0; i < argc; ++i) {
+        if (length - position < 2)
+            return 1;
+        const size_t argument_length  = __server_mode_read_integer(request + position, 2);
+        position                     += 2;
+        if (length - position <= argument_length || request[position + argument_length] != '\0')
+            return 1;
+
+        positions[i]  = position;
+        position     += argument_length + 1;
+    }
+
+    return position != length;
+}
+
+/**
+ * @brief   Parses a request received through the binary protocol.
+ * @details Arguments are null-terminated in the request itself, so they're handed to the query's
+ *          ::query_type_parse_arguments_callback_t without being copied or tokenized.
+ *
+ * @param job      Job containing the request. ::server_mode_job_t::length must be at least
+ *                 ::SERVER_MODE_REQUEST_HEADER_SIZE minus the size of the identifier.
+ * @param instance Where the parsed query is placed. This **will be modified on failure** too.
+ *
+ * @retval 0 Parsing success.
+ * @retval 1 Parsing failure.
+ */
+int __server_mode_parse_request(const server_mode_job_t *job, query_instance_t *instance) {
+    const char *const         request = job->query;
+    const query_type_t *const type    = query_type_list_get_by_index((unsigned char) request[0]);
+    const unsigned char       flags   = (unsigned char) request[1];
+    const size_t              argc    = (unsigned char) request[2];
+    const uint64_t            offset  = __server_mode_read_integer(request + 3, 8);
+    const uint64_t            limit   = __server_mode_read_integer(request + 11, 8);
+
+    size_t positions[SERVER_MODE_MAX_ARGUMENTS];
+    if (!type || __server_mode_find_arguments(request, job->length, positions) ||
+        offset > SIZE_MAX || (limit > SIZE_MAX && limit != UINT64_MAX))
+        return 1;
+
+    query_instance_set_type(instance, type);
+    query_instance_set_formatted(instance, (flags & SERVER_MODE_REQUEST_FORMATTED) != 0);
+    query_instance_set_approximate(instance, (flags & SERVER_MODE_REQUEST_APPROXIMATE) != 0);
+    query_instance_set_page(instance,
+                            (size_t) offset,
+                            limit == UINT64_MAX ? QUERY_INSTANCE_NO_LIMIT : (size_t) limit);
+
+    char *argv[SERVER_MODE_MAX_ARGUMENTS];
+    for (size_t i = 0; i < argc; ++i)
+        argv[i] = job->query + positions[i];
+    return query_instance_parse_arguments(NULL, instance, argc, argv);
+}
+
+/**
+ * @brief Writes the reply to a query received through the binary protocol.
+ *
+ * @param job    Job whose ::server_mode_job_t::reply is to be written.
+ * @param output Output of the query (every line ending in `'\n'`), or `NULL` if it failed.
+ * @param nlines Number of lines in @p output.
+ */
+void __server_mode_write_binary_reply(server_mode_job_t *job,
+                                      const GString     *output,
+                                      size_t             nlines) {
+    GString *const reply = job->reply;
+    g_string_truncate(reply, 0);
+    for (size_t i = 0; i < SERVER_MODE_REPLY_HEADER_SIZE; ++i)
+        g_string_append_c(reply, '\0');
+
+    if (output)
+        g_string_append_len(reply, output->str, (gssize) output->len);
+    else
+        nlines = 0;
+
+    size_t length = reply->len - SERVER_MODE_REPLY_HEADER_SIZE;
+    if (length > UINT32_MAX - SERVER_MODE_REPLY_HEADER_SIZE || nlines > UINT32_MAX) {
+        output = NULL; /* Too large for the protocol */
+        nlines = 0;
+        length = 0;
+        g_string_truncate(reply, SERVER_MODE_REPLY_HEADER_SIZE);
+    }
+
+    /* Only keep compressed payloads when they're smaller */
+    server_mode_reply_encoding_t encoding = SERVER_MODE_REPLY_ENCODING_RAW;
+    if (((unsigned char) job->query[1] & SERVER_MODE_REQUEST_COMPRESS) &&
+        length >= SERVER_MODE_MIN_COMPRESSED_SIZE) {
+        uint8_t *const compressed = malloc(length - 1);
+        if (compressed) {
+            const size_t compressed_length =
+                lz4_block_compress((const uint8_t *) reply->str + SERVER_MODE_REPLY_HEADER_SIZE,
+                                   length,
+                                   compressed,
+                                   length - 1);
+            if (compressed_length) {
+                g_string_truncate(reply, SERVER_MODE_REPLY_HEADER_SIZE);
+                g_string_append_len(reply, (const char *) compressed, compressed_length);
+                encoding = SERVER_MODE_REPLY_ENCODING_LZ4;
+            }
+            free(compressed);
+        }
+    }
+
+    __server_mode_write_integer(reply->str, reply->len - SERVER_MODE_FRAME_SIZE_SIZE, 4);
+    __server_mode_write_integer(reply->str + 4, job->id, 4);
+    reply->str[8] = output ? 0 : 1;
+    reply->str[9] = (char) encoding;
+    __server_mode_write_integer(reply->str + 10, nlines, 4);
+    __server_mode_write_integer(reply->str + 14, length, 4);
+}
+
+/**
+ * @brief Writes the reply to a query received from a text client.
+ *
+ * @param job    Job whose ::server_mode_job_t::reply is to be written.
+ * @param output Output of the query (every line ending in `'\n'`), or `NULL` if it failed.
+ * @param nlines Number of lines in @p output.
+ */
+void __server_mode_write_text_reply(server_mode_job_t *job, const GString *output, size_t nlines) {
+    g_string_truncate(job->reply, 0);
+    if (!output) {
+        g_string_append(job->reply, "-1\n");
+        return;
+    }
+
+    g_string_append_printf(job->reply, "%zu\n", nlines);
+    g_string_append_len(job->reply, output->str, (gssize) output->len);
+}
+
+/**
+ * @brief   Looks up the output of a query in ::server_mode_data_t::outputs.
+ * @details Queries answered from the cache are recorded as executed, with the time taken by the
+ *          lookup.
+ *
+ * @param data     Data shared by all threads that answer queries.
+ * @param shard    Where to record the lookup to. Can be `NULL`.
+ * @param database Database @p instance is to be executed on.
+ * @param instance Query whose output is wanted.
+ * @param output   Where to append the output to, on a hit.
+ * @param nlines   Where to write the number of lines in @p output to, on a hit.
+ *
+ * @retval 0 Success (cache hit).
+ * @retval 1 The query must be executed.
+ */
+int __server_mode_lookup_output(server_mode_data_t     *data,
+                                live_metrics_shard_t   *shard,
+                                const database_t       *database,
+                                const query_instance_t *instance,
+                                GString                *output,
+                                size_t                 *nlines) {
+    if (!data->outputs)
+        return 1;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const int missed = query_output_cache_get(data->outputs, database, instance, output, nlines);
+
+    if (shard) {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        const long latency =
+            (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+
+        const size_t type_number = query_type_get_type_number(query_instance_get_type(instance));
+        live_metrics_shard_record_output_cache(shard, type_number, !missed);
+        if (!missed)
+            live_metrics_shard_record_query(shard, type_number, (uint64_t) latency, 0);
+    }
+    return missed;
+}
+
+/**
+ * @brief   Parses and executes a query, generating the reply to be sent to a client.
+ * @details Replies to cancelled queries are failures, so that incomplete output isn't sent.
+ *
+ * @param data  Data shared by all threads that answer queries.
+ * @param shard Where to record the query's execution to. Can be `NULL`.
+ * @param job   Job whose query is to be run, and whose ::server_mode_job_t::reply is to be written.
+ */
+void __server_mode_answer(server_mode_data_t   *data,
+                          live_metrics_shard_t *shard,
+                          server_mode_job_t    *job) {
+    GString                *output   = NULL;
+    size_t                  nlines   = 0;
+    query_instance_t *const instance = query_instance_create(NULL);
+    if (!instance)
+        goto DEFER_1;
+
+    const int parse_failed = job->protocol == SERVER_MODE_PROTOCOL_BINARY
+                                 ? __server_mode_parse_request(job, instance)
+                                 : query_parser_parse_string(NULL, instance, job->query);
+    if (parse_failed) {
+        if (shard)
+            live_metrics_shard_record_query(shard, 0, 0, 1);
+        goto DEFER_2;
+    }
+
+    /* Read before the database, so that outputs generated from a replaced one aren't cached */
+    const unsigned int generation =
+        data->outputs ? query_output_cache_get_generation(data->outputs) : 0;
+    const database_t *const database = g_atomic_pointer_get(&data->database);
+
+    output = g_string_new("");
+    if (!__server_mode_lookup_output(data, shard, database, instance, output, &nlines))
+        goto DEFER_2;
+
+    query_writer_t *const writer =
+        query_writer_create(NULL, query_instance_get_formatted(instance));
+    if (!writer)
+        goto DEFER_3;
+
+    if (__server_mode_execute(data, shard, database, instance, writer) ||
+        cancellation_is_requested(&job->cancellation)) {
+        query_writer_free(writer);
+        goto DEFER_3;
+    }
+
+    const char *const *const lines = query_writer_get_lines(writer, &nlines);
+    for (size_t i = 0; i < nlines; ++i) {
+        g_string_append(output, lines[i]);
+        g_string_append_c(output, '\n');
+    }
+    query_writer_free(writer);
+
+    if (data->outputs)
+        query_output_cache_put(data->outputs,
+                               generation,
+                               database,
+                               instance,
+                               output->str,
+                               output->len,
+                               nlines);
+    goto DEFER_2;
+
+DEFER_3:
+    g_string_free(output, TRUE);
+    output = NULL;
+DEFER_2:
+    query_instance_free(instance);
+DEFER_1:
+    if (job->protocol == SERVER_MODE_PROTOCOL_BINARY)
+        __server_mode_write_binary_reply(job, output, nlines);
+    else
+        __server_mode_write_text_reply(job, output, nlines);
+
+    if (output)
+        g_string_free(output, TRUE);
+}
+
+/**
+ * @struct server_mode_worker_t
+ * @brief  Arguments of a thread that answers queries (see ::__server_mode_worker).
+ *
+ * @var server_mode_worker_t::data
+ *     @brief Data shared by all threads that answer queries.
+ * @var server_mode_worker_t::participant
+ *     @brief Epoch participant of the thread, in whose sections queries are answered.
+ * @var server_mode_worker_t::max_class
+ *     @brief Least urgent class of queries the thread takes from ::server_mode_data_t::jobs.
+ * @var server_mode_worker_t::thread
+ *     @brief The thread itself, set when it starts.
+ * @var server_mode_worker_t::shard
+ *     @brief Where the thread records executed queries to. Can be `NULL`.
+ */
+typedef struct {
+    server_mode_data_t  *data;
+    epoch_participant_t *participant;
+    server_mode_class_t  max_class;
+
+    pthread_t             thread;
+    live_metrics_shard_t *shard;
+} server_mode_worker_t;
+
+/**
+ * @brief   Executes a job and hands it back to the event loop through
+ *          ::server_mode_data_t::completed.
+ * @details Must be called inside an epoch section. The calling thread's current cancellation is
+ *          restored afterwards.
+ *
+ * @param worker Worker thread executing the job.
+ * @param job    Job popped from ::server_mode_data_t::jobs.
+ */
+void __server_mode_run_job(server_mode_worker_t *worker, server_mode_job_t *job) {
+    server_mode_data_t *const data = worker->data;
+    if (job->priority == SERVER_MODE_CLASS_LIGHT)
+        g_atomic_int_add(&data->light_jobs, -1);
+
+    const cancellation_t *const previous = cancellation_get_current();
+    cancellation_set_timeout(&job->cancellation, SERVER_MODE_QUERY_TIMEOUT);
+    cancellation_set_current(&job->cancellation);
+    __server_mode_answer(data, worker->shard, job);
+    cancellation_set_current(previous);
+
+    pthread_mutex_lock(&data->completed_lock);
+    g_ptr_array_add(data->completed, job);
+    pthread_mutex_unlock(&data->completed_lock);
+
+    const uint64_t one = 1;
+    while (write(data->completed_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+        ;
+}
+
+/**
+ * @brief   Executes light queries waiting in ::server_mode_data_t::jobs, from inside a heavy query.
+ * @details Called at block boundaries of heavy queries (see ::cancellation_yield_callback_t), so
+ *          that light queries don't wait for them when all workers are busy. Only the worker's own
+ *          thread yields, not the threads helping it with a parallel query. Light queries don't
+ *          yield themselves, so preemption isn't nested.
+ *
+ * @param worker_data A pointer to the ::server_mode_worker_t executing the heavy query.
+ */
+void __server_mode_yield(void *worker_data) {
+    server_mode_worker_t *const worker = worker_data;
+    if (!g_atomic_int_get(&worker->data->light_jobs) ||
+        !pthread_equal(pthread_self(), worker->thread))
+        return;
+
+    server_mode_job_t *job;
+    while ((job = class_queue_try_pop(worker->data->jobs, SERVER_MODE_CLASS_LIGHT)))
+        __server_mode_run_job(worker, job);
+}
+
+/**
+ * @brief   Entry point of every thread that answers queries in ::server_mode_run.
+ * @details Executes jobs (::server_mode_job_t) until ::server_mode_data_t::jobs is closed, taking
+ *          light queries first. Finished jobs are handed back to the event loop through
+ *          ::server_mode_data_t::completed. The time between jobs is a quiescent point, where the
+ *          database can be replaced.
+ *
+ * @param  worker_data A pointer to a ::server_mode_worker_t.
+ * @return Always `NULL`.
+ */
+void *__server_mode_worker(void *worker_data) {
+    server_mode_worker_t *const worker = worker_data;
+    server_mode_data_t *const   data   = worker->data;
+
+    /* Without a shard (allocation failure), this thread's queries aren't counted */
+    worker->thread = pthread_self();
+    worker->shard  = data->metrics ? live_metrics_add_shard(data->metrics) : NULL;
+
+    server_mode_job_t *job;
+    while ((job = class_queue_pop(data->jobs, worker->max_class))) {
+        if (job->priority == SERVER_MODE_CLASS_HEAVY) {
+            job->cancellation.yield      = __server_mode_yield;
+            job->cancellation.yield_data = worker;
+        }
+
+        epoch_enter(worker->participant);
+        __server_mode_run_job(worker, job);
+        epoch_exit(worker->participant);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   Entry point of the thread that reloads the dataset, after `SIGHUP` is received.
+ * @details The new database is published atomically, while queries keep running. The old database
+ *          is only `free`d after every thread that may be reading it passes a quiescent point (see
+ *          ::epoch_synchronize). Loading failures keep the old database.
+ *
+ * @param  server_data A pointer to a ::server_mode_data_t.
+ * @return Always `NULL`.
+ */
+void *__server_mode_reload_thread(void *server_data) {
+    server_mode_data_t *const data = server_data;
+
+    fputs("Reloading dataset...\n", stderr);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    database_t *const database = __server_mode_load_database(data->dataset_dir, data->cache_dir);
+    if (database) {
+        __server_mode_publish_dataset_metrics(data->metrics, database, &start);
+
+        database_t *const old = g_atomic_pointer_get(&data->database);
+        g_atomic_pointer_set(&data->database, database);
+
+        /* After publishing, so that queries started after this only see the new database */
+        if (data->outputs)
+            query_output_cache_invalidate(data->outputs);
+        epoch_synchronize(data->epoch);
+
+        /* A new database could be allocated at the same address, and reuse outdated statistics */
+        pthread_mutex_lock(&data->cache_lock);
+        if (data->cache && data->cache_database == old) {
+            query_statistics_cache_clear(data->cache);
+            data->cache_database = NULL;
+        }
+        pthread_mutex_unlock(&data->cache_lock);
+
+        database_free(old);
+        fputs("Dataset reloaded successfully!\n", stderr);
+    } else {
+        fputs("Failed to reload dataset! Old data has been kept.\n", stderr);
+    }
+
+    /* Wake up the event loop, to join this thread */
+    g_atomic_int_set(&data->reloaded, 1);
+    const uint64_t one = 1;
+    while (write(data->completed_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+        ;
+    return NULL;
+}
+
+/**
+ * @brief Frees a job created by ::__server_mode_dispatch.
+ * @param job Job to be `free`d.
+ */
+void __server_mode_job_free(server_mode_job_t *job) {
+    g_string_free(job->reply, TRUE);
+    g_free(job->query);
+    free(job);
+}
+
+/**
+ * @brief Frees a connection, after closing its socket.
+ * @param connection Connection to be `free`d.
+ */
+void __server_mode_connection_free(server_mode_connection_t *connection) {
+    close(connection->fd);
+    g_string_free(connection->input, TRUE);
+    g_string_free(connection->output, TRUE);
+    g_ptr_array_free(connection->jobs, TRUE);
+    free(connection);
+}
+
+/**
+ * @brief Closes a connection if there's nothing left to do on it.
+ *
+ * @param loop       Event loop the connection belongs to.
+ * @param connection Connection to be checked.
+ *
+ * @retval 0 The connection is still open.
+ * @retval 1 The connection was closed and `free`d.
+ */
+int __server_mode_close_if_done(server_mode_loop_t *loop, server_mode_connection_t *connection) {
+    if (connection->failed) {
+        /* Stop receiving events, even if a worker will still reply to this connection */
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+        if (connection->jobs->len) {
+            for (size_t i = 0; i < connection->jobs->len; ++i) {
+                server_mode_job_t *const job = g_ptr_array_index(connection->jobs, i);
+                cancellation_cancel(&job->cancellation); /* Nobody will read the reply */
+            }
+            return 0;
+        }
+    } else if (connection->jobs->len || !connection->eof || connection->input->len ||
+               connection->output->len) {
+        return 0;
+    } else {
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    }
+
+    g_hash_table_remove(loop->connections, connection); /* Also frees the connection */
+    return 1;
+}
+
+/**
+ * @brief   Sends as much pending output as possible to a client, without blocking.
+ * @details ::server_mode_connection_t::failed is set on IO errors.
+ * @param   connection Connection to the client.
+ */
+void __server_mode_flush(server_mode_connection_t *connection) {
+    while (connection->sent < connection->output->len) {
+        const ssize_t ret = send(connection->fd,
+                                 connection->output->str + connection->sent,
+                                 connection->output->len - connection->sent,
+                                 MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                connection->failed = 1;
+            return;
+        }
+        connection->sent += ret;
+    }
+
+    g_string_truncate(connection->output, 0);
+    connection->sent = 0;
+}
+
+/**
+ * @brief   Receives as much input as possible from a client, without blocking.
+ * @details ::server_mode_connection_t::eof and ::server_mode_connection_t::failed are set when the
+ *          client disconnects, or on IO errors, respectively.
+ * @param   connection Connection to the client.
+ */
+void __server_mode_receive(server_mode_connection_t *connection) {
+    char buffer[SERVER_MODE_READ_BUFFER_SIZE];
+    while (connection->input->len < SERVER_MODE_MAX_INPUT) {
+        const ssize_t ret = recv(connection->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                connection->failed = 1;
+            return;
+        } else if (ret == 0) {
+            connection->eof = 1;
+            return;
+        }
+        g_string_append_len(connection->input, buffer, ret);
+    }
+}
+
+/**
+ * @brief Updates the values in the metrics endpoint that aren't counted by worker threads.
+ * @param loop Event loop whose ::server_mode_data_t::metrics are to be updated.
+ */
+void __server_mode_update_metrics(server_mode_loop_t *loop) {
+    live_metrics_t *const metrics = loop->data->metrics;
+
+    epoch_enter(loop->participant);
+    const database_t *const database = g_atomic_pointer_get(&loop->data->database);
+
+    live_metrics_set_value(metrics,
+                           LIVE_METRICS_VALUE_CONNECTIONS,
+                           g_hash_table_size(loop->connections));
+    live_metrics_set_value(metrics,
+                           LIVE_METRICS_VALUE_USERS_MEMORY,
+                           user_manager_get_memory_usage(database_get_users(database)));
+    live_metrics_set_value(metrics,
+                           LIVE_METRICS_VALUE_FLIGHTS_MEMORY,
+                           flight_manager_get_memory_usage(database_get_flights(database)));
+    live_metrics_set_value(
+        metrics,
+        LIVE_METRICS_VALUE_RESERVATIONS_MEMORY,
+        reservation_manager_get_memory_usage(database_get_reservations(database)));
+    epoch_exit(loop->participant);
+
+    if (loop->data->outputs)
+        live_metrics_set_value(metrics,
+                               LIVE_METRICS_VALUE_OUTPUT_CACHE_MEMORY,
+                               query_output_cache_get_memory_usage(loop->data->outputs));
+}
+
+/**
+ * @brief   Replies to an HTTP request to the metrics endpoint, once it's been fully received.
+ * @details Every connection gets a single response (to `GET /metrics`, or `404 Not Found` for
+ *          anything else), after which it's closed.
+ *
+ * @param loop       Event loop the connection belongs to.
+ * @param connection HTTP connection.
+ */
+void __server_mode_respond_http(server_mode_loop_t *loop, server_mode_connection_t *connection) {
+    const char *const request = connection->input->str;
+    if (!connection->input->len)
+        return;
+    if (!connection->eof && connection->input->len < SERVER_MODE_MAX_HTTP_REQUEST &&
+        !strstr(request, "\r\n\r\n") && !strstr(request, "\n\n"))
+        return; /* Wait for the rest of the request */
+
+    const int found =
+        g_str_has_prefix(request, "GET /metrics ") || g_str_has_prefix(request, "GET /metrics?");
+
+    GString *const body = g_string_new(NULL);
+    if (found) {
+        __server_mode_update_metrics(loop);
+        live_metrics_write_prometheus(loop->data->metrics, body);
+    } else {
+        g_string_append(body, "Not found\n");
+    }
+
+    g_string_append_printf(connection->output,
+                           "HTTP/1.1 %s\r\n"
+                           "Content-Type: %s\r\n"
+                           "Content-Length: %zu\r\n"
+                           "Connection: close\r\n\r\n",
+                           found ? "200 OK" : "404 Not Found",
+                           found ? "text/plain; version=0.0.4" : "text/plain",
+                           body->len);
+    g_string_append_len(connection->output, body->str, body->len);
+    g_string_free(body, TRUE);
+
+    g_string_truncate(connection->input, 0);
+    connection->eof = 1; /* Close the connection once the response is sent */
+    __server_mode_flush(connection);
+}
+
+/**
+ * @brief   Chooses the priority class of a query, before it's parsed.
+ * @details Queries that need statistical data are always heavy, as they hold
+ *          ::server_mode_data_t::cache_lock, which light queries executed inside them (see
+ *          ::__server_mode_yield) must never need. Other queries are heavy if their type took, on
+ *          average, longer than ::SERVER_MODE_HEAVY_COST to execute recently. Invalid queries are
+ *          light, as they fail quickly.
+ *
+ * @param data Data shared by all threads that answer queries.
+ * @param job  Job whose ::server_mode_job_t::query and ::server_mode_job_t::protocol are set.
+ *
+ * @return The priority class of @p job.
+ */
+server_mode_class_t __server_mode_classify(server_mode_data_t *data, const server_mode_job_t *job) {
+    size_t number = 0;
+    if (job->protocol == SERVER_MODE_PROTOCOL_BINARY) {
+        number = (unsigned char) job->query[0];
+    } else {
+        for (const char *digit = job->query; *digit >= '0' && *digit <= '9'; ++digit)
+            if ((number = number * 10 + (size_t) (*digit - '0')) > QUERY_TYPE_LIST_COUNT)
+                return SERVER_MODE_CLASS_LIGHT;
+    }
+
+    const query_type_t *const type = query_type_list_get_by_index(number);
+    if (!type)
+        return SERVER_MODE_CLASS_LIGHT;
+    else if (query_type_needs_statistics(type) ||
+             g_atomic_int_get(&data->costs[number]) >= SERVER_MODE_HEAVY_COST)
+        return SERVER_MODE_CLASS_HEAVY;
+    else
+        return SERVER_MODE_CLASS_LIGHT;
+}
+
+/**
+ * @brief Hands a query received from a client to the worker threads.
+ *
+ * @param loop       Event loop the connection belongs to.
+ * @param connection Connection to the client. ::server_mode_connection_t::failed is set on failure.
+ * @param query      Query to be executed (see ::server_mode_job_t::query), allocated with
+ *                   `g_malloc`. Ownership is taken, even on failure.
+ * @param length     Number of bytes in @p query.
+ * @param id         Identifier of a binary request (see ::server_mode_job_t::id).
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure, or the queue of jobs is closed.
+ */
+int __server_mode_submit(server_mode_loop_t       *loop,
+                         server_mode_connection_t *connection,
+                         char                     *query,
+                         size_t                    length,
+                         uint32_t                  id) {
+    server_mode_job_t *const job = malloc(sizeof(server_mode_job_t));
+    if (!job) {
+        g_free(query);
+        connection->failed = 1;
+        return 1;
+    }
+
+    job->connection = connection;
+    job->query      = query;
+    job->length     = length;
+    job->id         = id;
+    job->protocol   = connection->protocol;
+    job->priority   = __server_mode_classify(loop->data, job);
+    job->reply      = g_string_new(NULL);
+    memset(&job->cancellation, 0, sizeof(cancellation_t));
+
+    if (job->priority == SERVER_MODE_CLASS_LIGHT)
+        g_atomic_int_inc(&loop->data->light_jobs);
+
+    g_ptr_array_add(connection->jobs, job);
+    if (class_queue_push(loop->data->jobs, job, job->priority)) {
+        if (job->priority == SERVER_MODE_CLASS_LIGHT)
+            g_atomic_int_add(&loop->data->light_jobs, -1);
+        g_ptr_array_remove_fast(connection->jobs, job);
+        connection->failed = 1;
+        __server_mode_job_free(job);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Removes data handed to workers from the input of a connection.
+ * @details ::server_mode_connection_t::recorded is updated accordingly.
+ *
+ * @param connection Connection to the client.
+ * @param length     Number of bytes to remove from the start of ::server_mode_connection_t::input.
+ */
+void __server_mode_consume_input(server_mode_connection_t *connection, size_t length) {
+    g_string_erase(connection->input, 0, length);
+    connection->recorded = connection->recorded > length ? connection->recorded - length : 0;
+}
+
+/**
+ * @brief   Records a request received through the binary protocol, as a text query.
+ * @details Malformed requests aren't recorded.
+ *
+ * @param recorder Where to record the query to.
+ * @param request  Request, after its identifier.
+ * @param length   Number of bytes in @p request. Must be at least
+ *                 ::SERVER_MODE_REQUEST_HEADER_SIZE minus the size of the identifier.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO failure.
+ */
+int __server_mode_record_request(workload_recorder_t *recorder,
+                                 const char          *request,
+                                 size_t               length) {
+    size_t positions[SERVER_MODE_MAX_ARGUMENTS];
+    if (__server_mode_find_arguments(request, length, positions))
+        return 0;
+
+    const unsigned char flags = (unsigned char) request[1];
+    GString *const      query = g_string_new(NULL);
+    g_string_append_printf(query,
+                           "%u%s%s",
+                           (unsigned char) request[0],
+                           flags & SERVER_MODE_REQUEST_FORMATTED ? "F" : "",
+                           flags & SERVER_MODE_REQUEST_APPROXIMATE ? "A" : "");
+
+    /* Arguments are quoted, as they may contain spaces */
+    for (size_t i = 0; i < (unsigned char) request[2]; ++i)
+        g_string_append_printf(query, " \"%s\"", request + positions[i]);
+
+    const uint64_t offset = __server_mode_read_integer(request + 3, 8);
+    const uint64_t limit  = __server_mode_read_integer(request + 11, 8);
+    if (limit != UINT64_MAX)
+        g_string_append_printf(query, " LIMIT %" PRIu64, limit);
+    if (offset)
+        g_string_append_printf(query, " OFFSET %" PRIu64, offset);
+
+    const int retval = workload_recorder_record(recorder, query->str, query->len);
+    g_string_free(query, TRUE);
+    return retval;
+}
+
+/**
+ * @brief   Records the queries received from a client that haven't been recorded yet.
+ * @details Queries are recorded as soon as they're received, before waiting for previous queries
+ *          in the same connection to be answered. Recording stops on IO errors.
+ *
+ * @param loop       Event loop the connection belongs to.
+ * @param connection Connection to the client, whose protocol is already known.
+ */
+void __server_mode_record(server_mode_loop_t *loop, server_mode_connection_t *connection) {
+    const GString *const input    = connection->input;
+    size_t               position = connection->recorded;
+    int                  failed   = 0;
+
+    if (connection->protocol == SERVER_MODE_PROTOCOL_TEXT) {
+        while (!failed && position < input->len) {
+            const char *const line    = input->str + position;
+            const char *const newline = memchr(line, '\n', input->len - position);
+            if (!newline && !connection->eof)
+                break;
+
+            const size_t length  = newline ? (size_t) (newline - line) : input->len - position;
+            failed               = workload_recorder_record(loop->recorder, line, length);
+            position            += newline ? length + 1 : length;
+        }
+    } else if (connection->protocol == SERVER_MODE_PROTOCOL_BINARY) {
+        while (!failed && input->len - position >= SERVER_MODE_FRAME_SIZE_SIZE) {
+            const char *const frame = input->str + position;
+            const uint64_t size = __server_mode_read_integer(frame, SERVER_MODE_FRAME_SIZE_SIZE);
+            if (size < SERVER_MODE_REQUEST_HEADER_SIZE ||
+                input->len - position - SERVER_MODE_FRAME_SIZE_SIZE < size)
+                break; /* Incomplete, or malformed (and the connection will be closed) */
+
+            failed    = __server_mode_record_request(loop->recorder,
+                                                  frame + SERVER_MODE_FRAME_SIZE_SIZE + 4,
+                                                  size - 4);
+            position += SERVER_MODE_FRAME_SIZE_SIZE + size;
+        }
+    }
+
+    connection->recorded = position;
+    if (failed) {
+        fputs("Failed to record workload! Recording has stopped.\n", stderr);
+        workload_recorder_free(loop->recorder);
+        loop->recorder = NULL;
+    }
+}
+
+/**
+ * @brief   Finds out how a client talks to the server, from the first bytes it sends.
+ * @details Binary clients start with ::SERVER_MODE_BINARY_MAGIC, which is removed from the input
+ *          and sent back. Text queries can't start like that, as they start with a number.
+ *
+ * @param connection Connection to the client, whose ::server_mode_connection_t::protocol is
+ *                   still ::SERVER_MODE_PROTOCOL_UNKNOWN.
+ *
+ * @retval 0 ::server_mode_connection_t::protocol was set.
+ * @retval 1 More data is needed.
+ */
+int __server_mode_detect_protocol(server_mode_connection_t *connection) {
+    const size_t magic_length = strlen(SERVER_MODE_BINARY_MAGIC);
+    const size_t length =
+        connection->input->len < magic_length ? connection->input->len : magic_length;
+    if (memcmp(connection->input->str, SERVER_MODE_BINARY_MAGIC, length)) {
+        connection->protocol = SERVER_MODE_PROTOCOL_TEXT;
+        return 0;
+    } else if (length < magic_length) {
+        if (!connection->eof)
+            return 1;
+
+        connection->protocol = SERVER_MODE_PROTOCOL_TEXT; /* Let the text parser reject it */
+        return 0;
+    }
+
+    __server_mode_consume_input(connection, magic_length);
+    g_string_append(connection->output, SERVER_MODE_BINARY_MAGIC);
+    __server_mode_flush(connection);
+    connection->protocol = SERVER_MODE_PROTOCOL_BINARY;
+    return 0;
+}
+
+/**
+ * @brief   Hands the next line received from a text client to the worker threads.
+ * @details Only one query per connection is executed at a time, and only after the reply to the
+ *          previous one was sent, so that replies are sent in order and slow clients don't
+ *          accumulate output.
+ *
+ * @param loop       Event loop the connection belongs to.
+ * @param connection Connection to the client.
+ */
+void __server_mode_dispatch_line(server_mode_loop_t *loop, server_mode_connection_t *connection) {
+    if (connection->jobs->len || connection->output->len)
+        return;
+
+    const char *const newline = memchr(connection->input->str, '\n', connection->input->len);
+    size_t            length;
+    if (newline)
+        length = newline - connection->input->str;
+    else if (connection->eof && connection->input->len)
+        length = connection->input->len; /* Last line without a line terminator */
+    else
+        return;
+
+    char *const query = g_strndup(connection->input->str, length);
+    __server_mode_consume_input(connection, newline ? length + 1 : length);
+    __server_mode_submit(loop, connection, query, length, 0);
+}
+
+/**
+ * @brief   Hands the requests received from a binary client to the worker threads.
+ * @details Requests are taken while fewer than ::SERVER_MODE_MAX_PIPELINE are being executed, and
+ *          while less than ::SERVER_MODE_MAX_OUTPUT bytes of replies are waiting to be sent, so
+ *          that slow clients don't accumulate output. ::server_mode_connection_t::failed is set on
+ *          malformed frames.
+ *
+ * @param loop       Event loop the connection belongs to.
+ * @param connection Connection to the client.
+ */
+void __server_mode_dispatch_frames(server_mode_loop_t       *loop,
+                                   server_mode_connection_t *connection) {
+    const GString *const input    = connection->input;
+    size_t               consumed = 0;
+
+    while (connection->jobs->len < SERVER_MODE_MAX_PIPELINE &&
+           connection->output->len < SERVER_MODE_MAX_OUTPUT) {
+        const size_t available = input->len - consumed;
+        if (available < SERVER_MODE_FRAME_SIZE_SIZE) {
+            if (connection->eof && available)
+                connection->failed = 1; /* Truncated frame */
+            break;
+        }
+
+        const char *const frame = input->str + consumed;
+        const uint64_t    size  = __server_mode_read_integer(frame, SERVER_MODE_FRAME_SIZE_SIZE);
+        if (size < SERVER_MODE_REQUEST_HEADER_SIZE ||
+            size > SERVER_MODE_MAX_INPUT - SERVER_MODE_FRAME_SIZE_SIZE) {
+            connection->failed = 1;
+            break;
+        } else if (available - SERVER_MODE_FRAME_SIZE_SIZE < size) {
+            if (connection->eof)
+                connection->failed = 1;
+            break;
+        }
+
+        /* The job gets the request after its identifier */
+        const char *const request = frame + SERVER_MODE_FRAME_SIZE_SIZE;
+        const size_t      length  = size - 4;
+        char *const       query   = g_malloc(length);
+        memcpy(query, request + 4, length);
+
+        consumed += SERVER_MODE_FRAME_SIZE_SIZE + size;
+        if (__server_mode_submit(loop,
+                                 connection,
+                                 query,
+                                 length,
+                                 (uint32_t) __server_mode_read_integer(request, 4)))
+            break;
+    }
+
+    __server_mode_consume_input(connection, consumed);
+}
+
+/**
+ * @brief Hands the queries received from a client to the worker threads, or replies to an HTTP
+ *        request.
+ *
+ * @param loop       Event loop the connection belongs to.
+ * @param connection Connection to the client.
+ */
+void __server_mode_dispatch(server_mode_loop_t *loop, server_mode_connection_t *connection) {
+    if (connection->failed)
+        return;
+    if (connection->protocol == SERVER_MODE_PROTOCOL_UNKNOWN &&
+        __server_mode_detect_protocol(connection))
+        return;
+    if (loop->recorder)
+        __server_mode_record(loop, connection);
+
+    switch (connection->protocol) {
+        case SERVER_MODE_PROTOCOL_HTTP:
+            if (!connection->output->len)
+                __server_mode_respond_http(loop, connection);
+            break;
+        case SERVER_MODE_PROTOCOL_BINARY:
+            __server_mode_dispatch_frames(loop, connection);
+            break;
+        default:
+            __server_mode_dispatch_line(loop, connection);
+            break;
+    }
+}
+
+/**
+ * @brief Updates the events a connection is waiting for, after its state changes.
+ *
+ * @param loop       Event loop the connection belongs to.
+ * @param connection Connection to be updated.
+ */
+void __server_mode_update_connection(server_mode_loop_t       *loop,
+                                     server_mode_connection_t *connection) {
+    __server_mode_dispatch(loop, connection);
+    if (__server_mode_close_if_done(loop, connection) || connection->failed)
+        return;
+
+    uint32_t events = 0;
+    if (!connection->eof && connection->input->len < SERVER_MODE_MAX_INPUT)
+        events |= EPOLLIN;
+    if (connection->output->len)
+        events |= EPOLLOUT;
+
+    if (events != connection->events) {
+        struct epoll_event event = {.events = events, .data.ptr = connection};
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event)) {
+            connection->failed = 1;
+            __server_mode_close_if_done(loop, connection);
+            return;
+        }
+        connection->events = events;
+    }
+}
+
+/**
+ * @brief Accepts all pending connections on a listening socket.
+ *
+ * @param loop   Event loop to add connections to.
+ * @param socket Listening socket (::server_mode_loop_t::socket or
+ *               ::server_mode_loop_t::metrics_socket).
+ * @param http   Whether connections are to the metrics endpoint.
+ */
+void __server_mode_accept(server_mode_loop_t *loop, int socket, int http) {
+    while (1) {
+        const int fd = accept(socket, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return; /* No more pending connections (or an error that can't be handled) */
+        }
+
+        /* The number of connections is bounded by the capacity of the queue of jobs */
+        if (g_hash_table_size(loop->connections) >= SERVER_MODE_MAX_CONNECTIONS ||
+            fcntl(fd, F_SETFL, O_NONBLOCK)) {
+            close(fd);
+            continue;
+        }
+
+        server_mode_connection_t *const connection = malloc(sizeof(server_mode_connection_t));
+        if (!connection) {
+            close(fd);
+            continue;
+        }
+
+        connection->fd       = fd;
+        connection->events   = EPOLLIN;
+        connection->input    = g_string_new(NULL);
+        connection->output   = g_string_new(NULL);
+        connection->sent     = 0;
+        connection->recorded = 0;
+        connection->eof      = 0;
+        connection->failed   = 0;
+        connection->jobs     = g_ptr_array_new();
+        connection->protocol = http ? SERVER_MODE_PROTOCOL_HTTP : SERVER_MODE_PROTOCOL_UNKNOWN;
+
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = connection};
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event)) {
+            __server_mode_connection_free(connection);
+            continue;
+        }
+        g_hash_table_add(loop->connections, connection);
+    }
+}
+
+/**
+ * @brief   Appends the replies of finished jobs to the output of their connections.
+ * @details The thread reloading the dataset is also joined, if it has finished.
+ * @param   loop Event loop whose jobs finished.
+ */
+void __server_mode_handle_completed(server_mode_loop_t *loop) {
+    server_mode_data_t *const data = loop->data;
+
+    uint64_t count;
+    while (read(data->completed_fd, &count, sizeof(count)) < 0 && errno == EINTR)
+        ;
+
+    pthread_mutex_lock(&data->completed_lock);
+    GPtrArray *const completed = data->completed;
+    data->completed            = g_ptr_array_new();
+    pthread_mutex_unlock(&data->completed_lock);
+
+    if (loop->reloading && g_atomic_int_get(&data->reloaded)) {
+        pthread_join(loop->reload_thread, NULL);
+        loop->reloading = 0;
+    }
+
+    for (size_t i = 0; i < completed->len; ++i) {
+        server_mode_job_t *const        job        = g_ptr_array_index(completed, i);
+        server_mode_connection_t *const connection = job->connection;
+
+        g_ptr_array_remove_fast(connection->jobs, job);
+        if (!connection->failed) {
+            g_string_append_len(connection->output, job->reply->str, job->reply->len);
+            __server_mode_flush(connection);
+        }
+        __server_mode_job_free(job);
+        __server_mode_update_connection(loop, connection);
+    }
+    g_ptr_array_free(completed, TRUE);
+}
+
+/**
+ * @brief   Starts reloading the dataset in the background, if that isn't already happening.
+ * @details The thread is joined in ::__server_mode_handle_completed.
+ * @param   loop Event loop that received `SIGHUP`.
+ */
+void __server_mode_start_reload(server_mode_loop_t *loop) {
+    if (loop->reloading) {
+        fputs("The dataset is already being reloaded!\n", stderr);
+        return;
+    }
+
+    g_atomic_int_set(&loop->data->reloaded, 0);
+    if (pthread_create(&loop->reload_thread, NULL, __server_mode_reload_thread, loop->data)) {
+        fputs("Failed to start reloading dataset!\n", stderr);
+        return;
+    }
+    loop->reloading = 1;
+}
+
+/**
+ * @brief   Handles events on every file descriptor, until the server is asked to terminate.
+ * @details After `SIGINT` or `SIGTERM` is received, no more connections are accepted, and this
+ *          function returns once all connected clients have disconnected.
+ *
+ * @param loop Event loop to be run.
+ *
+ * @retval 0 Success.
+ * @retval 1 `epoll_wait` failure.
+ */
+int __server_mode_run_loop(server_mode_loop_t *loop) {
+    int                accepting = 1;
+    struct epoll_event events[SERVER_MODE_EPOLL_EVENTS];
+
+    while (accepting || g_hash_table_size(loop->connections)) {
+        const int n = epoll_wait(loop->epoll_fd, events, SERVER_MODE_EPOLL_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            void *const ptr = events[i].data.ptr;
+            if (ptr == &loop->socket) {
+                __server_mode_accept(loop, loop->socket, 0);
+            } else if (ptr == &loop->metrics_socket) {
+                __server_mode_accept(loop, loop->metrics_socket, 1);
+            } else if (ptr == &loop->data->completed_fd) {
+                __server_mode_handle_completed(loop);
+            } else if (ptr == &loop->signal_fd) {
+                struct signalfd_siginfo info;
+                while (read(loop->signal_fd, &info, sizeof(info)) < 0 && errno == EINTR)
+                    ;
+
+                if (info.ssi_signo == SIGHUP) {
+                    __server_mode_start_reload(loop);
+                    continue;
+                }
+
+                epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, loop->socket, NULL);
+                if (loop->metrics_socket >= 0)
+                    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, loop->metrics_socket, NULL);
+                accepting = 0;
+            } else if (g_hash_table_contains(loop->connections, ptr)) {
+                /* Connections may be closed while handling previous events */
+                server_mode_connection_t *const connection = ptr;
+                if (events[i].events & EPOLLOUT)
+                    __server_mode_flush(connection);
+                if (events[i].events & EPOLLIN)
+                    __server_mode_receive(connection);
+                if (events[i].events & (EPOLLHUP | EPOLLERR))
+                    connection->failed = 1; /* Replies can't be sent anymore */
+                __server_mode_update_connection(loop, connection);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Creates a Unix domain socket listening for connections, without blocking.
+ *
+ * @param path Path where to create the socket.
+ *
+ * @return The listening socket, or `-1` on failure.
+ */
+int __server_mode_listen(const char *path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(address.sun_path))
+        return -1;
+    strcpy(address.sun_path, path);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) || bind(fd, (struct sockaddr *) &address, sizeof(address))) {
+        close(fd);
+        return -1;
+    }
+
+    if (listen(fd, SERVER_MODE_BACKLOG)) {
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief   Creates a TCP socket listening for connections to the metrics endpoint, without
+ *          blocking.
+ * @details Only connections from the same machine are accepted.
+ *
+ * @param port Port to listen on.
+ *
+ * @return The listening socket, or `-1` on failure.
+ */
+int __server_mode_listen_tcp(unsigned short port) {
+    struct sockaddr_in address = {.sin_family      = AF_INET,
+                                  .sin_port        = htons(port),
+                                  .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    const int reuse = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) ||
+        fcntl(fd, F_SETFL, O_NONBLOCK) ||
+        bind(fd, (struct sockaddr *) &address, sizeof(address)) ||
+        listen(fd, SERVER_MODE_BACKLOG)) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Creates the file descriptors of an event loop, and starts waiting for events on them.
+ *
+ * @param loop    Event loop to be initialized. ::server_mode_loop_t::data,
+ *                ::server_mode_loop_t::socket and ::server_mode_loop_t::metrics_socket must
+ *                already be set.
+ * @param signals Signals that terminate the server.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure.
+ */
+int __server_mode_loop_init(server_mode_loop_t *loop, const sigset_t *signals) {
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epoll_fd < 0)
+        goto DEFER_1;
+
+    loop->signal_fd = signalfd(-1, signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (loop->signal_fd < 0)
+        goto DEFER_2;
+
+    /* These file descriptors are told apart from connections by the address of their fields */
+    int *const sources[4] = {&loop->socket,
+                             &loop->data->completed_fd,
+                             &loop->signal_fd,
+                             &loop->metrics_socket};
+    for (size_t i = 0; i < (loop->metrics_socket >= 0 ? 4 : 3); ++i) {
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = sources[i]};
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, *sources[i], &event))
+            goto DEFER_3;
+    }
+
+    loop->connections = g_hash_table_new_full(g_direct_hash,
+                                              g_direct_equal,
+                                              (GDestroyNotify) __server_mode_connection_free,
+                                              NULL);
+    return 0;
+
+DEFER_3:
+    close(loop->signal_fd);
+DEFER_2:
+    close(loop->epoll_fd);
+DEFER_1:
+    return 1;
+}
+
+/**
+ * @brief   Frees the resources of an event loop initialized by ::__server_mode_loop_init.
+ * @details Clients still connected are disconnected.
+ * @param   loop Event loop to be destroyed.
+ */
+void __server_mode_loop_destroy(server_mode_loop_t *loop) {
+    g_hash_table_destroy(loop->connections);
+    close(loop->signal_fd);
+    close(loop->epoll_fd);
+}
+
+int server_mode_run(const char    *dataset_dir,
+                    const char    *cache_dir,
+                    const char    *socket_path,
+                    unsigned long  batch_window,
+                    unsigned short metrics_port,
+                    const char    *workload_path) {
+    int retval = 0;
+
+    struct timespec load_start;
+    clock_gettime(CLOCK_MONOTONIC, &load_start);
+    database_t *const database = __server_mode_load_database(dataset_dir, cache_dir);
+    if (!database) {
+        retval = 1;
+        fputs("Failed to load dataset!\n", stderr);
+        goto DEFER_1;
+    }
+
+    /* Block termination and reload signals in all threads, so that only the event loop gets them */
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    if (pthread_sigmask(SIG_BLOCK, &signals, NULL)) {
+        retval = 1;
+        fputs("Failed to block signals!\n", stderr);
+        goto DEFER_2;
+    }
+
+    /* Without caches (allocation failure), queries are always executed from scratch */
+    server_mode_data_t data = {.dataset_dir  = dataset_dir,
+                               .cache_dir    = cache_dir,
+                               .database     = database,
+                               .epoch        = epoch_domain_create(),
+                               .reloaded     = 0,
+                               .cache        = query_statistics_cache_create(),
+                               .batch_window = batch_window,
+                               .batch        = g_ptr_array_new(),
+                               .collecting   = 0,
+                               .jobs         = class_queue_create(2, SERVER_MODE_MAX_CONNECTIONS),
+                               .light_jobs   = 0,
+                               .completed    = g_ptr_array_new(),
+                               .completed_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC),
+                               .metrics      = metrics_port ? live_metrics_create() : NULL};
+    data.outputs = query_output_cache_create(SERVER_MODE_OUTPUT_CACHE_SIZE);
+    server_mode_loop_t loop = {.data           = &data,
+                               .socket         = __server_mode_listen(socket_path),
+                               .metrics_socket = -1,
+                               .recorder       = NULL,
+                               .reloading      = 0};
+    if (loop.socket < 0) {
+        retval = 1;
+        fputs("Failed to create socket!\n", stderr);
+        goto DEFER_3;
+    }
+
+    if (!data.jobs || data.completed_fd < 0) {
+        retval = 1;
+        fputs("Failed to create queue of queries!\n", stderr);
+        goto DEFER_4;
+    }
+
+    if (!data.epoch || !(loop.participant = epoch_domain_register(data.epoch))) {
+        retval = 1;
+        fputs("Failed to create epoch domain!\n", stderr);
+        goto DEFER_4;
+    }
+
+    if (metrics_port) {
+        loop.metrics_socket = data.metrics ? __server_mode_listen_tcp(metrics_port) : -1;
+        if (loop.metrics_socket < 0) {
+            retval = 1;
+            fputs("Failed to create metrics endpoint!\n", stderr);
+            goto DEFER_4;
+        }
+
+        __server_mode_publish_dataset_metrics(data.metrics, database, &load_start);
+    }
+
+    if (workload_path && !(loop.recorder = workload_recorder_create(workload_path))) {
+        retval = 1;
+        fputs("Failed to create workload file!\n", stderr);
+        goto DEFER_4;
+    }
+
+    if (pthread_mutex_init(&data.cache_lock, NULL)) {
+        retval = 1;
+        fputs("Failed to create lock!\n", stderr);
+        goto DEFER_4;
+    }
+
+    if (pthread_mutex_init(&data.batch_lock, NULL)) {
+        retval = 1;
+        fputs("Failed to create lock!\n", stderr);
+        goto DEFER_5;
+    }
+
+    if (pthread_cond_init(&data.batch_cond, NULL)) {
+        retval = 1;
+        fputs("Failed to create condition variable!\n", stderr);
+        goto DEFER_6;
+    }
+
+    if (pthread_mutex_init(&data.completed_lock, NULL)) {
+        retval = 1;
+        fputs("Failed to create lock!\n", stderr);
+        goto DEFER_7;
+    }
+
+    if (__server_mode_loop_init(&loop, &signals)) {
+        retval = 1;
+        fputs("Failed to create event loop!\n", stderr);
+        goto DEFER_8;
+    }
+
+    /*
+     * Threads reserved for light queries are the last ones, so that threads that fail to start
+     * never leave heavy queries without workers. With few threads, light queries only preempt heavy
+     * ones.
+     */
+    const size_t nthreads  = thread_count_get();
+    const size_t nreserved = nthreads / SERVER_MODE_LIGHT_WORKERS_RATIO;
+
+    /* Participants are registered before any thread starts, so that none is missed by a reload */
+    pthread_t *const            threads  = malloc(sizeof(pthread_t) * nthreads);
+    server_mode_worker_t *const workers  = malloc(sizeof(server_mode_worker_t) * nthreads);
+    size_t                      nstarted = 0;
+    if (threads && workers) {
+        size_t nregistered = 0;
+        for (; nregistered < nthreads; ++nregistered) {
+            workers[nregistered].data        = &data;
+            workers[nregistered].participant = epoch_domain_register(data.epoch);
+            workers[nregistered].max_class   = nregistered + nreserved >= nthreads
+                                                   ? SERVER_MODE_CLASS_LIGHT
+                                                   : SERVER_MODE_CLASS_HEAVY;
+            if (!workers[nregistered].participant)
+                break;
+        }
+
+        for (; nstarted < nregistered; ++nstarted)
+            if (pthread_create(threads + nstarted, NULL, __server_mode_worker, workers + nstarted))
+                break; /* Keep going with the threads that were created */
+    }
+
+    if (nstarted == 0) {
+        retval = 1;
+        fputs("Failed to start worker threads!\n", stderr);
+        goto DEFER_9;
+    }
+
+    fprintf(stderr, "Listening on %s\n", socket_path);
+    if (metrics_port)
+        fprintf(stderr, "Serving metrics on http://127.0.0.1:%hu/metrics\n", metrics_port);
+    if (workload_path)
+        fprintf(stderr, "Recording workload to %s\n", workload_path);
+    if (__server_mode_run_loop(&loop)) {
+        retval = 1;
+        fputs("Failed to wait for events!\n", stderr);
+    }
+
+    /* Let workers finish pending jobs, and then stop them */
+    class_queue_close(data.jobs);
+    for (size_t i = 0; i < nstarted; ++i)
+        pthread_join(threads[i], NULL);
+
+    if (loop.reloading)
+        pthread_join(loop.reload_thread, NULL);
+
+DEFER_9:
+    free(workers);
+    free(threads);
+    for (size_t i = 0; i < data.completed->len; ++i)
+        __server_mode_job_free(g_ptr_array_index(data.completed, i));
+    __server_mode_loop_destroy(&loop);
+DEFER_8:
+    pthread_mutex_destroy(&data.completed_lock);
+DEFER_7:
+    pthread_cond_destroy(&data.batch_cond);
+DEFER_6:
+    pthread_mutex_destroy(&data.batch_lock);
+DEFER_5:
+    pthread_mutex_destroy(&data.cache_lock);
+DEFER_4:
+    if (loop.recorder && workload_recorder_free(loop.recorder))
+        fputs("Failed to write workload file!\n", stderr);
+    if (loop.metrics_socket >= 0)
+        close(loop.metrics_socket);
+    close(loop.socket);
+    unlink(socket_path);
+DEFER_3:
+    if (data.completed_fd >= 0)
+        close(data.completed_fd);
+    g_ptr_array_free(data.completed, TRUE);
+    if (data.jobs)
+        class_queue_free(data.jobs);
+    g_ptr_array_free(data.batch, TRUE);
+    if (data.cache)
+        query_statistics_cache_free(data.cache);
+    if (data.outputs)
+        query_output_cache_free(data.outputs);
+    if (data.metrics)
+        live_metrics_free(data.metrics);
+    if (data.epoch)
+        epoch_domain_free(data.epoch);
+
+    /* The database may have been replaced by a reload */
+    database_free(g_atomic_pointer_get(&data.database));
+    goto DEFER_1;
+DEFER_2:
+    database_free(database);
+DEFER_1:
+    return retval;
+}
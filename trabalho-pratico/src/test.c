@@ -20,10 +20,116 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "batch_mode.h"
+#include "testing/event_trace.h"
+#include "testing/metrics_export.h"
 #include "testing/performance_metrics_output.h"
+#include "testing/sampling_profiler.h"
 #include "testing/test_diff_output.h"
+#include "testing/test_matrix.h"
+
+/**
+ * @brief Writes the samples of a sampling profiler to a file, as collapsed stacks.
+ *
+ * @param path     Path to the file to be written.
+ * @param profiler Stopped profiler.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure or IO error.
+ */
+int __test_write_profile(const char *path, const sampling_profiler_t *profiler) {
+    FILE *const output = fopen(path, "w");
+    if (!output)
+        return 1;
+
+    size_t dropped;
+    sampling_profiler_get_sample_count(profiler, &dropped);
+    if (dropped)
+        fprintf(stderr, "%zu profiler samples were dropped (buffer full)!\n", dropped);
+
+    const int retval = sampling_profiler_write_collapsed(profiler, output);
+    return fclose(output) | retval;
+}
+
+/**
+ * @brief Stops an event trace and writes it to a file.
+ *
+ * @param path  Path to the file to be written.
+ * @param trace Running trace.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO error.
+ */
+int __test_write_trace(const char *path, event_trace_t *trace) {
+    event_trace_stop(trace);
+
+    size_t dropped;
+    event_trace_get_event_count(trace, &dropped);
+    if (dropped)
+        fprintf(stderr, "%zu trace events were dropped (buffer full)!\n", dropped);
+
+    return event_trace_write_file(trace, path);
+}
+
+/**
+ * @brief Parses the number of test cases run at once in matrix mode (see ::test_matrix_run).
+ *
+ * @param str    Command-line argument, a positive number.
+ * @param output Where to write the parsed value to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Parsing failure.
+ */
+int __test_parse_jobs(const char *str, size_t *output) {
+    char *end;
+    *output = strtoul(str, &end, 10);
+    return !*str || *str == '-' || *end || *output == 0;
+}
+
+/**
+ * @brief   Runs the test cases in a manifest file (see test_matrix.h).
+ * @details Flags after the path of the manifest are `--jobs n`, for the maximum number of test
+ *          cases run at once, and `--lightweight`.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, where `argv[2]` is the path of the manifest.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure.
+ */
+int __test_run_matrix(int argc, char **argv) {
+    int    lightweight = 0;
+    size_t njobs       = 0;
+    for (int i = 3; i < argc; ++i) {
+        if (strcmp(argv[i], "--lightweight") == 0) {
+            lightweight = 1;
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc &&
+                   !__test_parse_jobs(argv[i + 1], &njobs)) {
+            ++i;
+        } else {
+            fputs("Invalid command-line arguments! Usage:\n", stderr);
+            fputs("./programa-testes --matrix [manifest] [--jobs n] [--lightweight]\n", stderr);
+            return 1;
+        }
+    }
+
+    test_matrix_t *const matrix = test_matrix_load(argv[2]);
+    if (!matrix) {
+        fputs("Failed to read test matrix manifest!\n", stderr);
+        return 1;
+    }
+
+    const int retval = test_matrix_run(matrix,
+                                       njobs,
+                                       lightweight ? PERFORMANCE_EVENT_MODE_LIGHTWEIGHT
+                                                   : PERFORMANCE_EVENT_MODE_RUSAGE,
+                                       stdout);
+    test_matrix_free(matrix);
+    return retval;
+}
 
 /**
  * @brief The entry point to the test program.
@@ -31,14 +137,92 @@
  * @retval 1 Failure
  */
 int main(int argc, char **argv) {
-    if (argc == 4) {
-        performance_metrics_t *const metrics = performance_metrics_create();
+    if (argc >= 3 && strcmp(argv[1], "--matrix") == 0)
+        return __test_run_matrix(argc, argv);
+
+    /* Optional flags after the positional arguments */
+    int         lightweight = 0, keep_query_events = 1, hardware_counters = 0, container = 0;
+    int         allocations = 0;
+    const char *json_path = NULL, *csv_path = NULL, *profile_path = NULL, *trace_path = NULL;
+    for (int i = 4; i < argc; ++i) {
+        if (strcmp(argv[i], "--lightweight") == 0) {
+            lightweight = 1;
+        } else if (strcmp(argv[i], "--no-line-events") == 0) {
+            keep_query_events = 0;
+        } else if (strcmp(argv[i], "--hardware-counters") == 0) {
+            hardware_counters = 1;
+        } else if (strcmp(argv[i], "--container") == 0) {
+            container = 1;
+        } else if (strcmp(argv[i], "--allocations") == 0) {
+            allocations = 1;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else {
+            argc = 0; /* Invalid flag */
+            break;
+        }
+    }
+
+    if (argc >= 4) {
+        /* Lightweight mode is less precise, but has less overhead when measuring fast queries */
+        performance_metrics_t *const metrics = performance_metrics_create_with_mode(
+            lightweight ? PERFORMANCE_EVENT_MODE_LIGHTWEIGHT : PERFORMANCE_EVENT_MODE_RUSAGE);
         if (!metrics) {
             fputs("Failed to allocate performance metrics!\n", stderr);
             return 1;
         }
+        performance_metrics_set_keep_query_events(metrics, keep_query_events);
+        if (hardware_counters && performance_metrics_enable_hardware_counters(metrics))
+            fputs("Hardware counters not available! Continuing without them.\n", stderr);
+
+        sampling_profiler_t *profiler = NULL;
+        if (profile_path) {
+            profiler = sampling_profiler_start(0, 0);
+            if (!profiler)
+                fputs("Failed to start the sampling profiler! Continuing without it.\n", stderr);
+            performance_metrics_set_profiler(metrics, profiler);
+        }
+
+        allocation_profiler_t *allocation_profiler = NULL;
+        if (allocations) {
+            allocation_profiler = allocation_profiler_start(PERFORMANCE_METRICS_ALLOCATION_PHASES);
+            if (!allocation_profiler)
+                fputs("Failed to start the allocation profiler! Continuing without it.\n", stderr);
+            performance_metrics_set_allocation_profiler(metrics, allocation_profiler);
+        }
+
+        event_trace_t *trace = NULL;
+        if (trace_path) {
+            trace = event_trace_start(0);
+            if (!trace)
+                fputs("Failed to start the event trace! Continuing without it.\n", stderr);
+        }
+
+        const char *const container_path = container ? BATCH_MODE_CONTAINER_PATH : NULL;
+        const int         retval = batch_mode_run(argv[1], argv[2], container_path, metrics);
+        if (allocation_profiler) {
+            allocation_profiler_stop(allocation_profiler);
+            performance_metrics_set_allocation_profiler(metrics, NULL); /* Copies counts */
+            allocation_profiler_free(allocation_profiler);
+        }
+        if (trace) {
+            if (__test_write_trace(trace_path, trace))
+                fputs("Failed to write the event trace!\n", stderr);
+            event_trace_free(trace);
+        }
+        if (profiler) {
+            performance_metrics_set_profiler(metrics, NULL);
+            if (sampling_profiler_stop(profiler) | __test_write_profile(profile_path, profiler))
+                fputs("Failed to write the sampling profiler's output!\n", stderr);
+            sampling_profiler_free(profiler);
+        }
 
-        const int retval = batch_mode_run(argv[1], argv[2], metrics);
         if (retval) {
             performance_metrics_free(metrics);
             return retval;
@@ -47,7 +231,10 @@ int main(int argc, char **argv) {
         performance_metrics_measure_whole_program(metrics);
         performance_metrics_output_print(stdout, metrics);
 
-        test_diff_t *const diff = test_diff_create("Resultados", argv[3]);
+        test_diff_t *const diff =
+            container
+                ? test_diff_create_with_container("Resultados", BATCH_MODE_CONTAINER_PATH, argv[3])
+                : test_diff_create("Resultados", argv[3]);
         if (!diff) {
             fputs("Failed to compare generated and expected results!\n", stderr);
             performance_metrics_free(metrics);
@@ -55,12 +242,26 @@ int main(int argc, char **argv) {
         }
         test_diff_output_print(stdout, diff);
 
+        int export_failed = 0;
+        if (json_path)
+            export_failed |=
+                metrics_export_write_file(json_path, METRICS_EXPORT_FORMAT_JSON, metrics, diff);
+        if (csv_path)
+            export_failed |=
+                metrics_export_write_file(csv_path, METRICS_EXPORT_FORMAT_CSV, metrics, diff);
+        if (export_failed)
+            fputs("Failed to export performance metrics!\n", stderr);
+
         performance_metrics_free(metrics);
         test_diff_free(diff);
-        return 0;
+        return export_failed;
     } else {
         fputs("Invalid command-line arguments! Usage:\n", stderr);
-        fputs("./programa-testes [dataset] [query file] [expected output directory]\n", stderr);
+        fputs("./programa-testes [dataset] [query file] [expected output directory] "
+              "[--lightweight] [--no-line-events] [--hardware-counters] [--allocations] "
+              "[--container] [--json file] [--csv file] [--profile file] [--trace file]\n"
+              "./programa-testes --matrix [manifest] [--jobs n] [--lightweight]\n",
+              stderr);
         return 1;
     }
 }
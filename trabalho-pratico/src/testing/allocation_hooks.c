@@ -0,0 +1,106 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    allocation_hooks.c
+ * @brief   Replacements of the C library's allocation functions, that count allocations.
+ * @details Only linked into programs that profile allocations (see
+ *          [allocation_profiler](@ref allocation_profiler.h)), as every allocation pays for a
+ *          call to `malloc_usable_size` and for checking whether a profiler is running. Memory is
+ *          still managed by glibc's allocator, through its `__libc_` entry points, so blocks can
+ *          be freed by either the replacements or the C library itself.
+ */
+
+#include <errno.h>
+#include <malloc.h>
+#include <stddef.h>
+
+#include "testing/allocation_profiler.h"
+
+/* glibc's allocator, not declared in any header */
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void  __libc_free(void *ptr);
+
+/** @brief Tells the allocation profiler that allocation functions have been replaced. */
+void __attribute__((constructor)) __allocation_hooks_enable(void) {
+    allocation_profiler_enable_hooks();
+}
+
+/**
+ * @brief  Counts a successful allocation.
+ * @param  ptr Allocated block, or `NULL` on allocation failure.
+ * @return @p ptr.
+ */
+void *__allocation_hooks_count(void *ptr) {
+    if (ptr)
+        allocation_profiler_count_allocation(malloc_usable_size(ptr));
+    return ptr;
+}
+
+/** @brief Replacement of `malloc` that counts allocations. */
+void *malloc(size_t size) {
+    return __allocation_hooks_count(__libc_malloc(size));
+}
+
+/** @brief Replacement of `calloc` that counts allocations. */
+void *calloc(size_t nmemb, size_t size) {
+    return __allocation_hooks_count(__libc_calloc(nmemb, size));
+}
+
+/** @brief Replacement of `realloc` that counts a resize as a `free` and an allocation. */
+void *realloc(void *ptr, size_t size) {
+    const size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+    void *const  ret      = __libc_realloc(ptr, size);
+
+    /* Failed reallocations keep the old block (unless it was freed, with a size of 0) */
+    if (ptr && (ret || size == 0))
+        allocation_profiler_count_free(old_size);
+    return __allocation_hooks_count(ret);
+}
+
+/** @brief Replacement of `memalign` that counts allocations. */
+void *memalign(size_t alignment, size_t size) {
+    return __allocation_hooks_count(__libc_memalign(alignment, size));
+}
+
+/** @brief Replacement of `aligned_alloc` that counts allocations. */
+void *aligned_alloc(size_t alignment, size_t size) {
+    return __allocation_hooks_count(__libc_memalign(alignment, size));
+}
+
+/** @brief Replacement of `posix_memalign` that counts allocations. */
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    /* Alignment must be a power of two multiple of sizeof(void *) */
+    if (alignment % sizeof(void *) || (alignment & (alignment - 1)))
+        return EINVAL;
+
+    void *const ptr = __allocation_hooks_count(__libc_memalign(alignment, size));
+    if (!ptr && size)
+        return ENOMEM;
+
+    *memptr = ptr;
+    return 0;
+}
+
+/** @brief Replacement of `free` that counts freed blocks. */
+void free(void *ptr) {
+    if (ptr)
+        allocation_profiler_count_free(malloc_usable_size(ptr));
+    __libc_free(ptr);
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  allocation_profiler.c
+ * @brief Implementation of methods in include/testing/allocation_profiler.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref allocation_profiler_examples).
+ */
+
+#include <stdlib.h>
+
+#include "testing/allocation_profiler.h"
+
+/**
+ * @struct  allocation_profiler_phase_t
+ * @brief   Counters of a phase of the program.
+ * @details All fields are updated atomically.
+ *
+ * @var allocation_profiler_phase_t::allocations
+ *     @brief Number of allocations.
+ * @var allocation_profiler_phase_t::frees
+ *     @brief Number of blocks freed.
+ * @var allocation_profiler_phase_t::bytes
+ *     @brief Total number of bytes allocated.
+ * @var allocation_profiler_phase_t::peak_live_bytes
+ *     @brief Maximum value of ::allocation_profiler::live_bytes minus
+ *            ::allocation_profiler::phase_start_live_bytes.
+ */
+typedef struct {
+    uint64_t allocations, frees, bytes;
+    int64_t  peak_live_bytes;
+} allocation_profiler_phase_t;
+
+/**
+ * @struct allocation_profiler
+ * @brief  Counts heap allocations made in each phase of the program.
+ *
+ * @var allocation_profiler::phases
+ *     @brief Counters of every phase.
+ * @var allocation_profiler::nphases
+ *     @brief Number of elements in ::allocation_profiler::phases.
+ * @var allocation_profiler::current_phase
+ *     @brief Phase allocations are currently attributed to.
+ * @var allocation_profiler::live_bytes
+ *     @brief   Bytes allocated and not yet freed in the whole process, since the profiler started.
+ *     @details Negative when blocks allocated before the profiler started are freed.
+ * @var allocation_profiler::phase_start_live_bytes
+ *     @brief Value of ::allocation_profiler::live_bytes when the current phase was entered.
+ */
+struct allocation_profiler {
+    allocation_profiler_phase_t *phases;
+    size_t                       nphases;
+    size_t                       current_phase;
+    int64_t                      live_bytes, phase_start_live_bytes;
+};
+
+/**
+ * @brief   The profiler currently running, or `NULL`.
+ * @details This global variable is justified for the following reasons:
+ *
+ *          -# It's only modified when profiling starts and stops, and read atomically;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# Allocation functions can't receive any extra parameters.
+ */
+allocation_profiler_t *__allocation_profiler_running = NULL;
+
+/**
+ * @brief   Whether allocation functions were replaced by src/testing/allocation_hooks.c.
+ * @details This global variable is justified for the following reasons:
+ *
+ *          -# It's only modified before `main` is called;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# It describes how the whole program was linked.
+ */
+int __allocation_profiler_hooked = 0;
+
+allocation_profiler_t *allocation_profiler_start(size_t nphases) {
+    if (!__allocation_profiler_hooked || nphases == 0 ||
+        __atomic_load_n(&__allocation_profiler_running, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    allocation_profiler_t *const profiler = malloc(sizeof(allocation_profiler_t));
+    if (!profiler)
+        return NULL;
+
+    profiler->phases = calloc(nphases, sizeof(allocation_profiler_phase_t));
+    if (!profiler->phases) {
+        free(profiler);
+        return NULL;
+    }
+
+    profiler->nphases                = nphases;
+    profiler->current_phase          = 0;
+    profiler->live_bytes             = 0;
+    profiler->phase_start_live_bytes = 0;
+
+    allocation_profiler_t *expected = NULL;
+    if (!__atomic_compare_exchange_n(&__allocation_profiler_running,
+                                     &expected,
+                                     profiler,
+                                     0,
+                                     __ATOMIC_RELEASE,
+                                     __ATOMIC_RELAXED)) {
+        allocation_profiler_free(profiler);
+        return NULL;
+    }
+    return profiler;
+}
+
+void allocation_profiler_set_phase(allocation_profiler_t *profiler, size_t phase) {
+    if (!profiler)
+        return;
+
+    __atomic_store_n(&profiler->phase_start_live_bytes,
+                     __atomic_load_n(&profiler->live_bytes, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&profiler->current_phase, phase, __ATOMIC_RELAXED);
+}
+
+void allocation_profiler_stop(allocation_profiler_t *profiler) {
+    allocation_profiler_t *expected = profiler;
+    __atomic_compare_exchange_n(&__allocation_profiler_running,
+                                &expected,
+                                NULL,
+                                0,
+                                __ATOMIC_RELEASE,
+                                __ATOMIC_RELAXED);
+}
+
+void allocation_profiler_get_counts(const allocation_profiler_t  *profiler,
+                                    size_t                        phase,
+                                    allocation_profiler_counts_t *out) {
+    const allocation_profiler_phase_t *const counters = &profiler->phases[phase];
+
+    out->allocations = __atomic_load_n(&counters->allocations, __ATOMIC_RELAXED);
+    out->frees       = __atomic_load_n(&counters->frees, __ATOMIC_RELAXED);
+    out->bytes       = __atomic_load_n(&counters->bytes, __ATOMIC_RELAXED);
+
+    const int64_t peak   = __atomic_load_n(&counters->peak_live_bytes, __ATOMIC_RELAXED);
+    out->peak_live_bytes = peak > 0 ? (uint64_t) peak : 0;
+}
+
+void allocation_profiler_free(allocation_profiler_t *profiler) {
+    free(profiler->phases);
+    free(profiler);
+}
+
+void allocation_profiler_enable_hooks(void) {
+    __allocation_profiler_hooked = 1;
+}
+
+void allocation_profiler_count_allocation(size_t bytes) {
+    allocation_profiler_t *const profiler =
+        __atomic_load_n(&__allocation_profiler_running, __ATOMIC_ACQUIRE);
+    if (!profiler)
+        return;
+
+    allocation_profiler_phase_t *const counters =
+        &profiler->phases[__atomic_load_n(&profiler->current_phase, __ATOMIC_RELAXED)];
+    __atomic_fetch_add(&counters->allocations, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counters->bytes, bytes, __ATOMIC_RELAXED);
+
+    const int64_t live =
+        __atomic_add_fetch(&profiler->live_bytes, (int64_t) bytes, __ATOMIC_RELAXED);
+    const int64_t growth =
+        live - __atomic_load_n(&profiler->phase_start_live_bytes, __ATOMIC_RELAXED);
+
+    int64_t peak = __atomic_load_n(&counters->peak_live_bytes, __ATOMIC_RELAXED);
+    while (growth > peak && !__atomic_compare_exchange_n(&counters->peak_live_bytes,
+                                                         &peak,
+                                                         growth,
+                                                         1,
+                                                         __ATOMIC_RELAXED,
+                                                         __ATOMIC_RELAXED))
+        ;
+}
+
+void allocation_profiler_count_free(size_t bytes) {
+    allocation_profiler_t *const profiler =
+        __atomic_load_n(&__allocation_profiler_running, __ATOMIC_ACQUIRE);
+    if (!profiler)
+        return;
+
+    allocation_profiler_phase_t *const counters =
+        &profiler->phases[__atomic_load_n(&profiler->current_phase, __ATOMIC_RELAXED)];
+    __atomic_fetch_add(&counters->frees, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&profiler->live_bytes, (int64_t) bytes, __ATOMIC_RELAXED);
+}
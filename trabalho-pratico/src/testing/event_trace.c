@@ -0,0 +1,330 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  event_trace.c
+ * @brief Implementation of methods in include/testing/event_trace.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref event_trace_examples).
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "testing/event_trace.h"
+
+/**
+ * @struct event_trace_event_t
+ * @brief  The beginning or the end of a span of work.
+ *
+ * @var event_trace_event_t::time
+ *     @brief Time (in nanoseconds) since the trace started.
+ * @var event_trace_event_t::category
+ *     @brief Category of the span, or `NULL` for the end of a span.
+ * @var event_trace_event_t::name
+ *     @brief Name of the span, or `NULL` for the end of a span.
+ * @var event_trace_event_t::number
+ *     @brief Number appended to ::event_trace_event_t::name, or `0` for none.
+ */
+typedef struct {
+    uint64_t    time;
+    const char *category, *name;
+    size_t      number;
+} event_trace_event_t;
+
+/**
+ * @struct  event_trace_buffer_t
+ * @brief   Events recorded by a single thread.
+ * @details Only written to by its thread, so no synchronization is needed besides adding the
+ *          buffer to ::event_trace::buffers.
+ *
+ * @var event_trace_buffer_t::next
+ *     @brief Next buffer in ::event_trace::buffers.
+ * @var event_trace_buffer_t::thread
+ *     @brief Number that identifies the thread that recorded these events.
+ * @var event_trace_buffer_t::count
+ *     @brief Number of elements in ::event_trace_buffer_t::events.
+ * @var event_trace_buffer_t::open
+ *     @brief   Number of recorded spans that haven't ended yet.
+ *     @details Space is always kept for their ends, so that all spans in the output are closed.
+ * @var event_trace_buffer_t::skipped
+ *     @brief Number of dropped spans that haven't ended yet, whose ends must also be dropped.
+ * @var event_trace_buffer_t::dropped
+ *     @brief Number of events that didn't fit in ::event_trace_buffer_t::events.
+ * @var event_trace_buffer_t::events
+ *     @brief Preallocated array of ::event_trace::max_events events.
+ */
+typedef struct event_trace_buffer {
+    struct event_trace_buffer *next;
+    size_t                     thread, count, open, skipped, dropped;
+    event_trace_event_t        events[];
+} event_trace_buffer_t;
+
+/**
+ * @struct event_trace
+ * @brief  Timeline of what every thread was doing.
+ *
+ * @var event_trace::max_events
+ *     @brief Number of events that fit in every ::event_trace_buffer_t.
+ * @var event_trace::start
+ *     @brief Time (in nanoseconds, `CLOCK_MONOTONIC`) when the trace was started.
+ * @var event_trace::buffers
+ *     @brief Linked list of the buffers of all threads that recorded events. New buffers are
+ *            added atomically, at the head of the list.
+ * @var event_trace::nthreads
+ *     @brief Number of buffers in ::event_trace::buffers.
+ * @var event_trace::key
+ *     @brief Thread-local storage for the buffer of each thread.
+ */
+struct event_trace {
+    size_t                max_events;
+    uint64_t              start;
+    event_trace_buffer_t *buffers;
+    size_t                nthreads;
+    pthread_key_t         key;
+};
+
+/**
+ * @brief   The trace currently running, or `NULL`.
+ * @details This global variable is justified for the following reasons:
+ *
+ *          -# It's only modified when tracing starts and stops, and read atomically;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# Events are recorded deep inside many modules (e.g.: the dataset loader), that would
+ *             otherwise all need a new parameter passed down from the program's entry point.
+ */
+event_trace_t *__event_trace_running = NULL;
+
+/**
+ * @brief  Gets the current time.
+ * @return The current time (in nanoseconds) of `CLOCK_MONOTONIC`.
+ */
+uint64_t __event_trace_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * @brief  Gets the buffer of the calling thread, allocating it if it doesn't exist.
+ * @param  trace Running trace.
+ * @return The buffer of the calling thread, or `NULL` on allocation failure.
+ */
+event_trace_buffer_t *__event_trace_get_buffer(event_trace_t *trace) {
+    event_trace_buffer_t *buffer = pthread_getspecific(trace->key);
+    if (buffer)
+        return buffer;
+
+    buffer = malloc(sizeof(event_trace_buffer_t) + trace->max_events * sizeof(event_trace_event_t));
+    if (!buffer)
+        return NULL;
+    if (pthread_setspecific(trace->key, buffer)) {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer->thread  = __atomic_fetch_add(&trace->nthreads, 1, __ATOMIC_RELAXED);
+    buffer->count   = 0;
+    buffer->open    = 0;
+    buffer->skipped = 0;
+    buffer->dropped = 0;
+
+    buffer->next = __atomic_load_n(&trace->buffers, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace->buffers,
+                                        &buffer->next,
+                                        buffer,
+                                        1,
+                                        __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED))
+        ;
+    return buffer;
+}
+
+event_trace_t *event_trace_start(size_t max_events) {
+    if (__atomic_load_n(&__event_trace_running, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    event_trace_t *const trace = malloc(sizeof(event_trace_t));
+    if (!trace)
+        return NULL;
+
+    trace->max_events = max_events ? max_events : EVENT_TRACE_DEFAULT_MAX_EVENTS;
+    trace->start      = __event_trace_now();
+    trace->buffers    = NULL;
+    trace->nthreads   = 0;
+    if (pthread_key_create(&trace->key, NULL)) {
+        free(trace);
+        return NULL;
+    }
+
+    event_trace_t *expected = NULL;
+    if (!__atomic_compare_exchange_n(&__event_trace_running,
+                                     &expected,
+                                     trace,
+                                     0,
+                                     __ATOMIC_RELEASE,
+                                     __ATOMIC_RELAXED)) {
+        pthread_key_delete(trace->key);
+        free(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+void event_trace_begin(const char *category, const char *name, size_t number) {
+    event_trace_t *const trace = __atomic_load_n(&__event_trace_running, __ATOMIC_ACQUIRE);
+    if (!trace)
+        return;
+
+    event_trace_buffer_t *const buffer = __event_trace_get_buffer(trace);
+    if (!buffer)
+        return;
+
+    /* Keep space for the end of this span and of all open ones */
+    if (buffer->skipped || buffer->count + buffer->open + 2 > trace->max_events) {
+        buffer->skipped++;
+        buffer->dropped++;
+        return;
+    }
+
+    buffer->events[buffer->count++] = (event_trace_event_t) {.time     = __event_trace_now(),
+                                                             .category = category,
+                                                             .name     = name,
+                                                             .number   = number};
+    buffer->open++;
+}
+
+void event_trace_end(void) {
+    event_trace_t *const trace = __atomic_load_n(&__event_trace_running, __ATOMIC_ACQUIRE);
+    if (!trace)
+        return;
+
+    event_trace_buffer_t *const buffer = pthread_getspecific(trace->key);
+    if (!buffer)
+        return;
+
+    if (buffer->skipped) {
+        buffer->skipped--;
+        buffer->dropped++;
+    } else if (buffer->open) {
+        buffer->events[buffer->count++] = (event_trace_event_t) {.time     = __event_trace_now(),
+                                                                 .category = NULL,
+                                                                 .name     = NULL,
+                                                                 .number   = 0};
+        buffer->open--;
+    }
+}
+
+void event_trace_stop(event_trace_t *trace) {
+    event_trace_t *expected = trace;
+    __atomic_compare_exchange_n(&__event_trace_running,
+                                &expected,
+                                NULL,
+                                0,
+                                __ATOMIC_RELEASE,
+                                __ATOMIC_RELAXED);
+}
+
+size_t event_trace_get_event_count(const event_trace_t *trace, size_t *dropped) {
+    size_t count = 0, total_dropped = 0;
+    for (const event_trace_buffer_t *buffer = trace->buffers; buffer; buffer = buffer->next) {
+        count += buffer->count;
+        total_dropped += buffer->dropped;
+    }
+
+    if (dropped)
+        *dropped = total_dropped;
+    return count;
+}
+
+int event_trace_write_json(const event_trace_t *trace, FILE *output) {
+    fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", output);
+
+    int first = 1;
+    for (const event_trace_buffer_t *buffer = trace->buffers; buffer; buffer = buffer->next) {
+        fprintf(output,
+                "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %zu, "
+                "\"args\": {\"name\": \"Thread %zu\"}}",
+                first ? "" : ",\n",
+                buffer->thread,
+                buffer->thread);
+        first = 0;
+
+        for (size_t i = 0; i < buffer->count; ++i) {
+            const event_trace_event_t *const event = &buffer->events[i];
+            const double time = (double) (event->time - trace->start) / 1000; /* Microseconds */
+
+            if (!event->name) {
+                fprintf(output,
+                        ",\n{\"ph\": \"E\", \"ts\": %.3lf, \"pid\": 1, \"tid\": %zu}",
+                        time,
+                        buffer->thread);
+            } else if (event->number) {
+                fprintf(output,
+                        ",\n{\"name\": \"%s %zu\", \"cat\": \"%s\", \"ph\": \"B\", \"ts\": %.3lf, "
+                        "\"pid\": 1, \"tid\": %zu}",
+                        event->name,
+                        event->number,
+                        event->category,
+                        time,
+                        buffer->thread);
+            } else {
+                fprintf(output,
+                        ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"B\", \"ts\": %.3lf, "
+                        "\"pid\": 1, \"tid\": %zu}",
+                        event->name,
+                        event->category,
+                        time,
+                        buffer->thread);
+            }
+        }
+
+        /* Spans still open when the trace was stopped */
+        for (size_t i = 0; i < buffer->open; ++i)
+            fprintf(output,
+                    ",\n{\"ph\": \"E\", \"ts\": %.3lf, \"pid\": 1, \"tid\": %zu}",
+                    (double) (__event_trace_now() - trace->start) / 1000,
+                    buffer->thread);
+    }
+
+    fputs("\n]}\n", output);
+    return ferror(output) != 0;
+}
+
+int event_trace_write_file(const event_trace_t *trace, const char *path) {
+    FILE *const output = fopen(path, "w");
+    if (!output)
+        return 1;
+
+    const int retval = event_trace_write_json(trace, output);
+    return fclose(output) | retval;
+}
+
+void event_trace_free(event_trace_t *trace) {
+    event_trace_buffer_t *buffer = trace->buffers;
+    while (buffer) {
+        event_trace_buffer_t *const next = buffer->next;
+        free(buffer);
+        buffer = next;
+    }
+
+    pthread_key_delete(trace->key);
+    free(trace);
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  hardware_counters.c
+ * @brief Implementation of methods in include/testing/hardware_counters.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref hardware_counters_examples).
+ */
+
+/* syscall isn't part of POSIX */
+#ifndef _DEFAULT_SOURCE /* May already be defined in the compiler's flags */
+#define _DEFAULT_SOURCE
+#endif
+
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "testing/hardware_counters.h"
+
+/**
+ * @struct hardware_counters
+ * @brief  A set of open hardware counters.
+ *
+ * @var hardware_counters::fds
+ *     @brief File descriptors of each counter. The first one is the group leader.
+ */
+struct hardware_counters {
+    int fds[HARDWARE_COUNTER_COUNT];
+};
+
+/**
+ * @struct hardware_counters_read_format_t
+ * @brief  What's read from a counter's file descriptor (`PERF_FORMAT_TOTAL_TIME_ENABLED |
+ *         PERF_FORMAT_TOTAL_TIME_RUNNING`).
+ *
+ * @var hardware_counters_read_format_t::value
+ *     @brief Value of the counter.
+ * @var hardware_counters_read_format_t::time_enabled
+ *     @brief Time the counter has been enabled for.
+ * @var hardware_counters_read_format_t::time_running
+ *     @brief Time the counter has actually been counting for (less than
+ *            ::hardware_counters_read_format_t::time_enabled when multiplexed).
+ */
+typedef struct {
+    uint64_t value, time_enabled, time_running;
+} hardware_counters_read_format_t;
+
+/**
+ * @brief Opens a single counter.
+ *
+ * @param type     Type of the event (`PERF_TYPE_*`).
+ * @param config   Event to be counted, whose meaning depends on @p type.
+ * @param group_fd File descriptor of the group leader, or `-1` to create a new group.
+ *
+ * @return The file descriptor of the counter, or `-1` on failure.
+ */
+int __hardware_counters_open_one(uint32_t type, uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(struct perf_event_attr));
+
+    attr.size           = sizeof(struct perf_event_attr);
+    attr.type           = type;
+    attr.config         = config;
+    attr.disabled       = group_fd < 0; /* Only the leader, so that the group starts at once */
+    attr.inherit        = 1;            /* PERF_FORMAT_GROUP can't be used with this */
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+hardware_counters_t *hardware_counters_open(void) {
+    hardware_counters_t *const counters = malloc(sizeof(hardware_counters_t));
+    if (!counters)
+        return NULL;
+
+    const uint64_t llc_loads = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+
+    const uint32_t types[HARDWARE_COUNTER_COUNT]   = {PERF_TYPE_HARDWARE,
+                                                      PERF_TYPE_HARDWARE,
+                                                      PERF_TYPE_HARDWARE,
+                                                      PERF_TYPE_HARDWARE,
+                                                      PERF_TYPE_HW_CACHE};
+    const uint64_t configs[HARDWARE_COUNTER_COUNT] = {PERF_COUNT_HW_CPU_CYCLES,
+                                                      PERF_COUNT_HW_INSTRUCTIONS,
+                                                      PERF_COUNT_HW_CACHE_MISSES,
+                                                      PERF_COUNT_HW_BRANCH_MISSES,
+                                                      llc_loads};
+
+    for (size_t i = 0; i < HARDWARE_COUNTER_COUNT; ++i) {
+        const int group_fd = i ? counters->fds[0] : -1;
+        counters->fds[i]   = __hardware_counters_open_one(types[i], configs[i], group_fd);
+        if (counters->fds[i] < 0) {
+            for (size_t j = 0; j < i; ++j)
+                close(counters->fds[j]);
+            free(counters);
+            return NULL;
+        }
+    }
+
+    if (ioctl(counters->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP)) {
+        hardware_counters_close(counters);
+        return NULL;
+    }
+    return counters;
+}
+
+int hardware_counters_read(const hardware_counters_t *counters,
+                           hardware_counters_values_t *output) {
+    for (size_t i = 0; i < HARDWARE_COUNTER_COUNT; ++i) {
+        hardware_counters_read_format_t read_format;
+        if (read(counters->fds[i], &read_format, sizeof(read_format)) != sizeof(read_format))
+            return 1;
+
+        /* Scale multiplexed counters as if they had been running all the time */
+        if (read_format.time_running && read_format.time_running < read_format.time_enabled)
+            output->values[i] = (double) read_format.value * read_format.time_enabled /
+                                read_format.time_running;
+        else
+            output->values[i] = read_format.value;
+    }
+    return 0;
+}
+
+void hardware_counters_values_subtract(hardware_counters_values_t       *values,
+                                       const hardware_counters_values_t *earlier) {
+    for (size_t i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+        values->values[i] =
+            values->values[i] > earlier->values[i] ? values->values[i] - earlier->values[i] : 0;
+}
+
+void hardware_counters_values_add(hardware_counters_values_t       *values,
+                                  const hardware_counters_values_t *other) {
+    for (size_t i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+        values->values[i] += other->values[i];
+}
+
+void hardware_counters_close(hardware_counters_t *counters) {
+    for (size_t i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+        close(counters->fds[i]);
+    free(counters);
+}
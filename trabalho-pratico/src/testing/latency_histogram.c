@@ -0,0 +1,148 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  latency_histogram.c
+ * @brief Implementation of methods in include/testing/latency_histogram.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref latency_histogram_examples).
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testing/latency_histogram.h"
+
+/** @brief Number of bits in ::LATENCY_HISTOGRAM_SUB_BUCKETS. */
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 7
+
+/** @brief Number of buckets between consecutive powers of two, after the exact range. */
+#define LATENCY_HISTOGRAM_HALF_SUB_BUCKETS (LATENCY_HISTOGRAM_SUB_BUCKETS / 2)
+
+/** @brief Total number of buckets, enough to hold any `uint64_t`. */
+#define LATENCY_HISTOGRAM_BUCKETS                                                                  \
+    (LATENCY_HISTOGRAM_HALF_SUB_BUCKETS * (64 - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) +           \
+     LATENCY_HISTOGRAM_HALF_SUB_BUCKETS)
+
+/**
+ * @struct latency_histogram
+ * @brief  A fixed-size histogram of latencies.
+ *
+ * @var latency_histogram::counts
+ *     @brief Number of values recorded in each bucket.
+ * @var latency_histogram::count
+ *     @brief Total number of values recorded.
+ * @var latency_histogram::total
+ *     @brief Sum of all values recorded.
+ * @var latency_histogram::max
+ *     @brief Highest value recorded.
+ */
+struct latency_histogram {
+    uint64_t counts[LATENCY_HISTOGRAM_BUCKETS];
+    uint64_t count, total, max;
+};
+
+latency_histogram_t *latency_histogram_create(void) {
+    return calloc(1, sizeof(latency_histogram_t));
+}
+
+latency_histogram_t *latency_histogram_clone(const latency_histogram_t *histogram) {
+    latency_histogram_t *const ret = malloc(sizeof(latency_histogram_t));
+    if (!ret)
+        return NULL;
+
+    memcpy(ret, histogram, sizeof(latency_histogram_t));
+    return ret;
+}
+
+/**
+ * @brief  Calculates the index of the bucket a value belongs to.
+ * @param  value Value to be recorded.
+ * @return The index of @p value's bucket in ::latency_histogram::counts.
+ */
+size_t __latency_histogram_get_index(uint64_t value) {
+    if (value < LATENCY_HISTOGRAM_SUB_BUCKETS)
+        return value;
+
+    /* Keep the LATENCY_HISTOGRAM_SUB_BUCKET_BITS - 1 bits after the most significant one */
+    const int msb   = 63 - __builtin_clzll(value);
+    const int shift = msb - (LATENCY_HISTOGRAM_SUB_BUCKET_BITS - 1);
+    return (size_t) shift * LATENCY_HISTOGRAM_HALF_SUB_BUCKETS + (value >> shift);
+}
+
+/**
+ * @brief  Calculates the highest value that belongs to a bucket.
+ * @param  index Index of the bucket in ::latency_histogram::counts.
+ * @return The highest value whose bucket is @p index.
+ */
+uint64_t __latency_histogram_get_upper_bound(size_t index) {
+    if (index < LATENCY_HISTOGRAM_SUB_BUCKETS)
+        return index;
+
+    const int      shift       = index / LATENCY_HISTOGRAM_HALF_SUB_BUCKETS - 1;
+    const uint64_t sub_bucket  = index % LATENCY_HISTOGRAM_HALF_SUB_BUCKETS +
+                                LATENCY_HISTOGRAM_HALF_SUB_BUCKETS;
+    const uint64_t lower_bound = sub_bucket << shift;
+    return lower_bound + (((uint64_t) 1 << shift) - 1);
+}
+
+void latency_histogram_record(latency_histogram_t *histogram, uint64_t value) {
+    histogram->counts[__latency_histogram_get_index(value)]++;
+    histogram->count++;
+    histogram->total += value;
+    if (value > histogram->max)
+        histogram->max = value;
+}
+
+uint64_t latency_histogram_get_count(const latency_histogram_t *histogram) {
+    return histogram->count;
+}
+
+uint64_t latency_histogram_get_total(const latency_histogram_t *histogram) {
+    return histogram->total;
+}
+
+uint64_t latency_histogram_get_max(const latency_histogram_t *histogram) {
+    return histogram->max;
+}
+
+uint64_t latency_histogram_get_percentile(const latency_histogram_t *histogram, double percentile) {
+    if (!histogram->count)
+        return 0;
+
+    /* Rank of the value to be found (1-indexed) */
+    uint64_t rank = ceil(percentile / 100.0 * histogram->count);
+    if (rank < 1)
+        rank = 1;
+
+    const size_t last = __latency_histogram_get_index(histogram->max);
+    uint64_t     seen = 0;
+    for (size_t i = 0; i < last; ++i) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            const uint64_t bound = __latency_histogram_get_upper_bound(i);
+            return bound < histogram->max ? bound : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+void latency_histogram_free(latency_histogram_t *histogram) {
+    free(histogram);
+}
@@ -0,0 +1,373 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  live_metrics.c
+ * @brief Implementation of methods in include/testing/live_metrics.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref live_metrics_examples).
+ */
+
+#include <glib.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queries/query_type_list.h"
+#include "testing/live_metrics.h"
+
+/**
+ * @struct live_metrics_query_counters_t
+ * @brief  Counters of the executions of a query type.
+ *
+ * @var live_metrics_query_counters_t::count
+ *     @brief Number of executed queries.
+ * @var live_metrics_query_counters_t::failed
+ *     @brief Number of queries that failed to execute.
+ * @var live_metrics_query_counters_t::total
+ *     @brief Sum of the latencies of all queries, in microseconds.
+ * @var live_metrics_query_counters_t::output_hits
+ *     @brief Number of queries whose output was found in a cache of outputs.
+ * @var live_metrics_query_counters_t::output_misses
+ *     @brief Number of queries whose output was looked up, but not found, in a cache of outputs.
+ * @var live_metrics_query_counters_t::buckets
+ *     @brief   Number of queries in each bucket of the latency histogram.
+ *     @details Not cumulative: each query is only counted in the first bucket it fits in, or in
+ *              none of them, if it took longer than the upper bound of the last bucket.
+ */
+typedef struct {
+    uint64_t count, failed, total;
+    uint64_t output_hits, output_misses;
+    uint64_t buckets[LIVE_METRICS_LATENCY_BUCKETS];
+} live_metrics_query_counters_t;
+
+/**
+ * @struct live_metrics_shard
+ * @brief  Counters updated by a single thread.
+ *
+ * @var live_metrics_shard::queries
+ *     @brief Counters for every query type (index `0` for invalid queries).
+ */
+struct live_metrics_shard {
+    live_metrics_query_counters_t queries[QUERY_TYPE_LIST_COUNT + 1];
+};
+
+/**
+ * @struct live_metrics
+ * @brief  Counters of a long-running program.
+ *
+ * @var live_metrics::lock
+ *     @brief Lock that protects ::live_metrics::shards.
+ * @var live_metrics::shards
+ *     @brief Counters of every thread (::live_metrics_shard_t).
+ * @var live_metrics::values
+ *     @brief Values set with ::live_metrics_set_value.
+ */
+struct live_metrics {
+    pthread_mutex_t lock;
+    GPtrArray      *shards;
+    uint64_t        values[LIVE_METRICS_VALUE_COUNT];
+};
+
+/**
+ * @struct live_metrics_value_info_t
+ * @brief  How to write a ::live_metrics_value_t.
+ *
+ * @var live_metrics_value_info_t::name
+ *     @brief Name of the metric. Consecutive values with the same name share a `HELP` line.
+ * @var live_metrics_value_info_t::labels
+ *     @brief Labels of this value, or `NULL`.
+ * @var live_metrics_value_info_t::type
+ *     @brief Prometheus type of the metric (`counter` or `gauge`).
+ * @var live_metrics_value_info_t::help
+ *     @brief Description of the metric.
+ * @var live_metrics_value_info_t::microseconds
+ *     @brief Whether the value is stored in microseconds, to be written in seconds.
+ */
+typedef struct {
+    const char *name, *labels, *type, *help;
+    int         microseconds;
+} live_metrics_value_info_t;
+
+/** @brief How to write every ::live_metrics_value_t, in the same order. */
+const live_metrics_value_info_t __live_metrics_value_info[LIVE_METRICS_VALUE_COUNT] = {
+    {"li3_connections", NULL, "gauge", "Number of connected clients.", 0},
+    {"li3_statistics_cache_hits_total",
+     NULL,
+     "counter",
+     "Lookups of statistical data found in the cache.",
+     0},
+    {"li3_statistics_cache_misses_total",
+     NULL,
+     "counter",
+     "Lookups of statistical data not found in the cache.",
+     0},
+    {"li3_entities", "kind=\"users\"", "gauge", "Number of entities loaded.", 0},
+    {"li3_entities", "kind=\"flights\"", "gauge", "Number of entities loaded.", 0},
+    {"li3_entities", "kind=\"reservations\"", "gauge", "Number of entities loaded.", 0},
+    {"li3_manager_memory_bytes", "manager=\"users\"", "gauge", "Memory used by managers.", 0},
+    {"li3_manager_memory_bytes", "manager=\"flights\"", "gauge", "Memory used by managers.", 0},
+    {"li3_manager_memory_bytes",
+     "manager=\"reservations\"",
+     "gauge",
+     "Memory used by managers.",
+     0},
+    {"li3_dataset_load_seconds", NULL, "gauge", "Time taken to load the dataset.", 1},
+    {"li3_output_cache_memory_bytes", NULL, "gauge", "Memory used by cached query outputs.", 0},
+};
+
+/**
+ * @brief Atomically reads a counter, without tearing.
+ * @param counter Counter to be read.
+ * @return The value of @p counter.
+ */
+uint64_t __live_metrics_load(const uint64_t *counter) {
+#ifdef __GNUC__
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+#else
+    return *counter;
+#endif
+}
+
+/**
+ * @brief   Atomically writes a counter, without tearing.
+ * @details Counters in shards only have one writer, so no read-modify-write operation is needed.
+ *
+ * @param counter Counter to be written.
+ * @param value   New value of @p counter.
+ */
+void __live_metrics_store(uint64_t *counter, uint64_t value) {
+#ifdef __GNUC__
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+#else
+    *counter = value;
+#endif
+}
+
+live_metrics_t *live_metrics_create(void) {
+    live_metrics_t *const metrics = calloc(1, sizeof(live_metrics_t));
+    if (!metrics)
+        return NULL;
+
+    if (pthread_mutex_init(&metrics->lock, NULL)) {
+        free(metrics);
+        return NULL;
+    }
+
+    metrics->shards = g_ptr_array_new_with_free_func(free);
+    return metrics;
+}
+
+live_metrics_shard_t *live_metrics_add_shard(live_metrics_t *metrics) {
+    live_metrics_shard_t *const shard = calloc(1, sizeof(live_metrics_shard_t));
+    if (!shard)
+        return NULL;
+
+    pthread_mutex_lock(&metrics->lock);
+    g_ptr_array_add(metrics->shards, shard);
+    pthread_mutex_unlock(&metrics->lock);
+    return shard;
+}
+
+void live_metrics_shard_record_query(live_metrics_shard_t *shard,
+                                     size_t                type_number,
+                                     uint64_t              latency,
+                                     int                   failed) {
+
+    if (type_number > QUERY_TYPE_LIST_COUNT)
+        type_number = 0;
+    live_metrics_query_counters_t *const counters = &shard->queries[type_number];
+
+    __live_metrics_store(&counters->count, counters->count + 1);
+    __live_metrics_store(&counters->total, counters->total + latency);
+    if (failed)
+        __live_metrics_store(&counters->failed, counters->failed + 1);
+
+    /* First bucket whose upper bound (2^i) isn't less than the latency */
+    size_t bucket = 0;
+    while (bucket < LIVE_METRICS_LATENCY_BUCKETS && ((uint64_t) 1 << bucket) < latency)
+        bucket++;
+    if (bucket < LIVE_METRICS_LATENCY_BUCKETS)
+        __live_metrics_store(&counters->buckets[bucket], counters->buckets[bucket] + 1);
+}
+
+void live_metrics_shard_record_output_cache(live_metrics_shard_t *shard,
+                                            size_t                type_number,
+                                            int                   hit) {
+
+    if (type_number > QUERY_TYPE_LIST_COUNT)
+        type_number = 0;
+    live_metrics_query_counters_t *const counters = &shard->queries[type_number];
+
+    if (hit)
+        __live_metrics_store(&counters->output_hits, counters->output_hits + 1);
+    else
+        __live_metrics_store(&counters->output_misses, counters->output_misses + 1);
+}
+
+void live_metrics_set_value(live_metrics_t *metrics, live_metrics_value_t value, uint64_t number) {
+    __live_metrics_store(&metrics->values[value], number);
+}
+
+/**
+ * @brief Writes the `HELP` and `TYPE` lines of a metric.
+ *
+ * @param output Where to append the text to.
+ * @param name   Name of the metric.
+ * @param type   Prometheus type of the metric.
+ * @param help   Description of the metric.
+ */
+void __live_metrics_write_header(GString    *output,
+                                 const char *name,
+                                 const char *type,
+                                 const char *help) {
+
+    g_string_append_printf(output, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * @brief Adds up the counters of every query type in all shards.
+ *
+ * @param metrics Metrics whose shards are to be added up.
+ * @param sum     Where to write the counters to (one element per query type, and `0` for invalid
+ *                queries).
+ */
+void __live_metrics_sum_shards(live_metrics_t                *metrics,
+                               live_metrics_query_counters_t *sum) {
+
+    pthread_mutex_lock(&metrics->lock);
+    for (size_t i = 0; i < metrics->shards->len; ++i) {
+        const live_metrics_shard_t *const shard = g_ptr_array_index(metrics->shards, i);
+        for (size_t t = 0; t <= QUERY_TYPE_LIST_COUNT; ++t) {
+            const live_metrics_query_counters_t *const counters = &shard->queries[t];
+
+            sum[t].count  += __live_metrics_load(&counters->count);
+            sum[t].failed += __live_metrics_load(&counters->failed);
+            sum[t].total  += __live_metrics_load(&counters->total);
+
+            sum[t].output_hits   += __live_metrics_load(&counters->output_hits);
+            sum[t].output_misses += __live_metrics_load(&counters->output_misses);
+            for (size_t b = 0; b < LIVE_METRICS_LATENCY_BUCKETS; ++b)
+                sum[t].buckets[b] += __live_metrics_load(&counters->buckets[b]);
+        }
+    }
+    pthread_mutex_unlock(&metrics->lock);
+}
+
+void live_metrics_write_prometheus(live_metrics_t *metrics, GString *output) {
+    live_metrics_query_counters_t sum[QUERY_TYPE_LIST_COUNT + 1] = {0};
+    __live_metrics_sum_shards(metrics, sum);
+
+    __live_metrics_write_header(output,
+                                "li3_invalid_queries_total",
+                                "counter",
+                                "Number of queries that couldn't be parsed.");
+    g_string_append_printf(output, "li3_invalid_queries_total %" PRIu64 "\n", sum[0].count);
+
+    __live_metrics_write_header(output,
+                                "li3_queries_total",
+                                "counter",
+                                "Number of queries executed.");
+    for (size_t t = 1; t <= QUERY_TYPE_LIST_COUNT; ++t)
+        g_string_append_printf(output,
+                               "li3_queries_total{type=\"%zu\"} %" PRIu64 "\n",
+                               t,
+                               sum[t].count);
+
+    __live_metrics_write_header(output,
+                                "li3_query_failures_total",
+                                "counter",
+                                "Number of queries that failed to execute.");
+    for (size_t t = 1; t <= QUERY_TYPE_LIST_COUNT; ++t)
+        g_string_append_printf(output,
+                               "li3_query_failures_total{type=\"%zu\"} %" PRIu64 "\n",
+                               t,
+                               sum[t].failed);
+
+    __live_metrics_write_header(output,
+                                "li3_output_cache_hits_total",
+                                "counter",
+                                "Queries whose output was found in the cache.");
+    for (size_t t = 1; t <= QUERY_TYPE_LIST_COUNT; ++t)
+        g_string_append_printf(output,
+                               "li3_output_cache_hits_total{type=\"%zu\"} %" PRIu64 "\n",
+                               t,
+                               sum[t].output_hits);
+
+    __live_metrics_write_header(output,
+                                "li3_output_cache_misses_total",
+                                "counter",
+                                "Queries whose output was not found in the cache.");
+    for (size_t t = 1; t <= QUERY_TYPE_LIST_COUNT; ++t)
+        g_string_append_printf(output,
+                               "li3_output_cache_misses_total{type=\"%zu\"} %" PRIu64 "\n",
+                               t,
+                               sum[t].output_misses);
+
+    __live_metrics_write_header(output,
+                                "li3_query_latency_seconds",
+                                "histogram",
+                                "Time taken to execute queries.");
+    for (size_t t = 1; t <= QUERY_TYPE_LIST_COUNT; ++t) {
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < LIVE_METRICS_LATENCY_BUCKETS; ++b) {
+            cumulative += sum[t].buckets[b];
+            g_string_append_printf(output,
+                                   "li3_query_latency_seconds_bucket{type=\"%zu\",le=\"%g\"} "
+                                   "%" PRIu64 "\n",
+                                   t,
+                                   (double) ((uint64_t) 1 << b) * 1e-6,
+                                   cumulative);
+        }
+
+        g_string_append_printf(output,
+                               "li3_query_latency_seconds_bucket{type=\"%zu\",le=\"+Inf\"} "
+                               "%" PRIu64 "\n"
+                               "li3_query_latency_seconds_sum{type=\"%zu\"} %g\n"
+                               "li3_query_latency_seconds_count{type=\"%zu\"} %" PRIu64 "\n",
+                               t,
+                               sum[t].count,
+                               t,
+                               (double) sum[t].total * 1e-6,
+                               t,
+                               sum[t].count);
+    }
+
+    for (size_t i = 0; i < LIVE_METRICS_VALUE_COUNT; ++i) {
+        const live_metrics_value_info_t *const info = &__live_metrics_value_info[i];
+        if (i == 0 || strcmp(info->name, __live_metrics_value_info[i - 1].name))
+            __live_metrics_write_header(output, info->name, info->type, info->help);
+
+        g_string_append(output, info->name);
+        if (info->labels)
+            g_string_append_printf(output, "{%s}", info->labels);
+
+        const uint64_t value = __live_metrics_load(&metrics->values[i]);
+        if (info->microseconds)
+            g_string_append_printf(output, " %.6f\n", (double) value * 1e-6);
+        else
+            g_string_append_printf(output, " %" PRIu64 "\n", value);
+    }
+}
+
+void live_metrics_free(live_metrics_t *metrics) {
+    g_ptr_array_unref(metrics->shards);
+    pthread_mutex_destroy(&metrics->lock);
+    free(metrics);
+}
@@ -0,0 +1,395 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  metrics_comparison.c
+ * @brief Implementation of methods in include/testing/metrics_comparison.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref metrics_comparison_examples).
+ */
+
+#include <glib.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testing/metrics_comparison.h"
+#include "testing/sample_statistics.h"
+#include "utils/table.h"
+
+/**
+ * @struct metrics_comparison
+ * @brief  Exported metrics of two builds, to be compared.
+ *
+ * @var metrics_comparison::metrics
+ *     @brief   Samples of every metric, in every build.
+ *     @details Keys are strings in the format `section:name:metric` (e.g.: `latency:1:p99_us`),
+ *              and values are arrays of ::METRICS_COMPARISON_SIDE_COUNT `GArray`s of `double`.
+ * @var metrics_comparison::nruns
+ *     @brief Number of runs of each build added to the comparison.
+ */
+struct metrics_comparison {
+    GHashTable *metrics;
+    size_t      nruns[METRICS_COMPARISON_SIDE_COUNT];
+};
+
+/**
+ * @brief Frees the samples of a metric in a ::metrics_comparison_t.
+ * @param data Array of ::METRICS_COMPARISON_SIDE_COUNT `GArray`s of `double`.
+ */
+void __metrics_comparison_free_samples(gpointer data) {
+    GArray **const samples = data;
+    for (size_t i = 0; i < METRICS_COMPARISON_SIDE_COUNT; ++i)
+        if (samples[i])
+            g_array_unref(samples[i]);
+    free(samples);
+}
+
+metrics_comparison_t *metrics_comparison_create(void) {
+    metrics_comparison_t *const comparison = malloc(sizeof(metrics_comparison_t));
+    if (!comparison)
+        return NULL;
+
+    comparison->metrics =
+        g_hash_table_new_full(g_str_hash, g_str_equal, g_free, __metrics_comparison_free_samples);
+    memset(comparison->nruns, 0, sizeof(comparison->nruns));
+    return comparison;
+}
+
+/**
+ * @brief   Splits the next field out of a CSV row.
+ * @details Quoted fields are unquoted in place.
+ *
+ * @param row Pointer to the beginning of the field. Updated to point to the beginning of the next
+ *            field, or to `NULL` if this was the last one.
+ *
+ * @return The contents of the field, or `NULL` if there are no more fields.
+ */
+char *__metrics_comparison_next_field(char **row) {
+    char *const field = *row;
+    if (!field)
+        return NULL;
+
+    if (*field != '"') {
+        char *const comma = strchr(field, ',');
+        if (comma)
+            *comma = '\0';
+        *row = comma ? comma + 1 : NULL;
+        return field;
+    }
+
+    /* Quotes are escaped by doubling them */
+    char *read = field + 1, *write = field;
+    while (*read && !(*read == '"' && read[1] != '"')) {
+        if (*read == '"')
+            read++;
+        *write++ = *read++;
+    }
+    *write = '\0';
+
+    if (*read == '"')
+        read++;
+    *row = *read == ',' ? read + 1 : NULL;
+    return field;
+}
+
+/**
+ * @brief   Adds a single CSV row to a comparison.
+ * @details Rows of sections that aren't compared (per-query execution times and test results) and
+ *          query counts are ignored.
+ *
+ * @param comparison Comparison to be modified.
+ * @param side       Build the row comes from.
+ * @param row        Row, with no trailing newline. Modified while parsing.
+ *
+ * @retval 0 Success (or ignored row).
+ * @retval 1 Invalid row.
+ */
+int __metrics_comparison_add_row(metrics_comparison_t     *comparison,
+                                 metrics_comparison_side_t side,
+                                 char                     *row) {
+    const char *const section = __metrics_comparison_next_field(&row);
+    const char *const name    = __metrics_comparison_next_field(&row);
+    const char *const line    = __metrics_comparison_next_field(&row);
+    const char *const metric  = __metrics_comparison_next_field(&row);
+    const char *const value   = __metrics_comparison_next_field(&row);
+    if (!value || row)
+        return 1;
+
+    const char *const compared_sections[] = {"dataset", "statistics", "latency", "program"};
+    int               compared            = 0;
+    for (size_t i = 0; i < sizeof(compared_sections) / sizeof(*compared_sections); ++i)
+        compared |= strcmp(section, compared_sections[i]) == 0;
+
+    /* Sizes of the input, not of its processing */
+    const char *const ignored_metrics[] = {"count", "bytes", "rows", "rejected_rows"};
+    for (size_t i = 0; i < sizeof(ignored_metrics) / sizeof(*ignored_metrics); ++i)
+        compared &= strcmp(metric, ignored_metrics[i]) != 0;
+    if (!compared || *line)
+        return 0;
+
+    char        *end;
+    const double parsed = strtod(value, &end);
+    if (end == value || *end)
+        return 1;
+
+    char *const key     = g_strdup_printf("%s:%s:%s", section, name, metric);
+    GArray    **samples = g_hash_table_lookup(comparison->metrics, key);
+    if (samples) {
+        g_free(key);
+    } else {
+        samples = malloc(sizeof(GArray *) * METRICS_COMPARISON_SIDE_COUNT);
+        if (!samples) {
+            g_free(key);
+            return 1;
+        }
+
+        for (size_t i = 0; i < METRICS_COMPARISON_SIDE_COUNT; ++i)
+            samples[i] = g_array_new(FALSE, FALSE, sizeof(double));
+        g_hash_table_insert(comparison->metrics, key, samples);
+    }
+
+    g_array_append_val(samples[side], parsed);
+    return 0;
+}
+
+int metrics_comparison_add_file(metrics_comparison_t     *comparison,
+                                metrics_comparison_side_t side,
+                                const char               *path) {
+    FILE *const file = fopen(path, "r");
+    if (!file)
+        return 1;
+
+    int    retval = 0;
+    char  *line   = NULL;
+    size_t size   = 0;
+    for (size_t i = 0; !retval; ++i) {
+        ssize_t length = getline(&line, &size, file);
+        if (length < 0)
+            break;
+
+        if (length > 0 && line[length - 1] == '\n')
+            line[--length] = '\0';
+
+        if (i == 0)
+            retval = strcmp(line, "section,name,line,metric,value") != 0;
+        else if (length > 0)
+            retval = __metrics_comparison_add_row(comparison, side, line);
+    }
+
+    retval |= ferror(file) != 0;
+    free(line);
+    fclose(file);
+
+    if (!retval)
+        comparison->nruns[side]++;
+    return retval;
+}
+
+/**
+ * @struct metrics_comparison_change_t
+ * @brief  How a metric changed from the baseline build to the candidate build.
+ *
+ * @var metrics_comparison_change_t::name
+ *     @brief Name of the metric (key of ::metrics_comparison::metrics).
+ * @var metrics_comparison_change_t::means
+ *     @brief Mean value of the metric in each build.
+ * @var metrics_comparison_change_t::relative
+ *     @brief Relative change of the mean (e.g.: `0.1` for a 10 % increase).
+ * @var metrics_comparison_change_t::t
+ *     @brief   Welch's t statistic of the change.
+ *     @details `NAN` when there weren't enough samples for the change to be tested, and infinite
+ *              when the samples of both builds have no variance.
+ * @var metrics_comparison_change_t::significant
+ *     @brief Whether the change is statistically significant (or untested).
+ */
+typedef struct {
+    const char *name;
+    double      means[METRICS_COMPARISON_SIDE_COUNT], relative, t;
+    int         significant;
+} metrics_comparison_change_t;
+
+/**
+ * @brief Compares the samples of a metric in both builds.
+ *
+ * @param name    Name of the metric.
+ * @param samples Samples of the metric in each build. None of them can be empty.
+ *
+ * @return How the metric changed.
+ */
+metrics_comparison_change_t __metrics_comparison_compare(const char *name, GArray *const *samples) {
+    metrics_comparison_change_t change = {.name = name};
+
+    double variances[METRICS_COMPARISON_SIDE_COUNT], squared_errors[METRICS_COMPARISON_SIDE_COUNT];
+    int    testable = 1;
+    for (size_t i = 0; i < METRICS_COMPARISON_SIDE_COUNT; ++i) {
+        const size_t        n      = samples[i]->len;
+        const double *const values = (const double *) samples[i]->data;
+
+        change.means[i]   = sample_statistics_mean(n, values);
+        variances[i]      = sample_statistics_variance(n, values);
+        squared_errors[i] = n ? variances[i] / n : 0;
+        testable &= n >= 2;
+    }
+
+    const double baseline   = change.means[METRICS_COMPARISON_SIDE_BASELINE];
+    const double difference = change.means[METRICS_COMPARISON_SIDE_CANDIDATE] - baseline;
+    if (fabs(baseline) > 0)
+        change.relative = difference / fabs(baseline);
+    else
+        change.relative = fabs(difference) > 0 ? 1 : 0;
+
+    if (!testable) {
+        change.t           = NAN;
+        change.significant = 1;
+        return change;
+    }
+
+    const double squared_error = squared_errors[0] + squared_errors[1];
+    if (squared_error <= 0) {
+        change.t           = difference > 0 ? INFINITY : difference < 0 ? -INFINITY : 0;
+        change.significant = fabs(difference) > 0;
+        return change;
+    }
+
+    /* Welch–Satterthwaite equation for the degrees of freedom */
+    double denominator = 0;
+    for (size_t i = 0; i < METRICS_COMPARISON_SIDE_COUNT; ++i)
+        denominator += squared_errors[i] * squared_errors[i] / (samples[i]->len - 1);
+    const double degrees_of_freedom = squared_error * squared_error / denominator;
+
+    change.t           = difference / sqrt(squared_error);
+    change.significant = fabs(change.t) > sample_statistics_t_critical_value(degrees_of_freedom);
+    return change;
+}
+
+/**
+ * @brief  Orders changes by decreasing magnitude of their relative change, for `qsort`.
+ *
+ * @param a Pointer to a ::metrics_comparison_change_t.
+ * @param b Pointer to a ::metrics_comparison_change_t.
+ *
+ * @return A negative value if @p a has the largest change, a positive value if @p b does, or `0`.
+ */
+int __metrics_comparison_change_compare(const void *a, const void *b) {
+    const double change_a = fabs(((const metrics_comparison_change_t *) a)->relative);
+    const double change_b = fabs(((const metrics_comparison_change_t *) b)->relative);
+    return (change_a < change_b) - (change_a > change_b);
+}
+
+/**
+ * @brief Prints a table of changes.
+ *
+ * @param output  Stream where to print the table to.
+ * @param title   Header of the table's first column.
+ * @param n       Number of changes in @p changes.
+ * @param changes Changes to be printed, already ordered.
+ */
+void __metrics_comparison_print_table(FILE                              *output,
+                                      const char                        *title,
+                                      size_t                             n,
+                                      const metrics_comparison_change_t *changes) {
+
+    table_t *const table = table_create(5, n + 1);
+    if (!table)
+        return;
+
+    table_insert_format(table, 0, 0, "%s", title);
+    table_insert_format(table, 1, 0, "Baseline");
+    table_insert_format(table, 2, 0, "Candidate");
+    table_insert_format(table, 3, 0, "Change");
+    table_insert_format(table, 4, 0, "t");
+
+    for (size_t i = 0; i < n; ++i) {
+        table_insert_format(table, 0, i + 1, "%s", changes[i].name);
+        table_insert_format(table, 1, i + 1, "%.1lf", changes[i].means[0]);
+        table_insert_format(table, 2, i + 1, "%.1lf", changes[i].means[1]);
+        table_insert_format(table, 3, i + 1, "%+.2lf %%", changes[i].relative * 100);
+        if (isnan(changes[i].t))
+            table_insert_format(table, 4, i + 1, "untested");
+        else
+            table_insert_format(table, 4, i + 1, "%.2lf", changes[i].t);
+    }
+
+    table_draw(output, table);
+    table_free(table);
+}
+
+size_t metrics_comparison_print(FILE                       *output,
+                                const metrics_comparison_t *comparison,
+                                double                      threshold) {
+    const size_t                       nmetrics = g_hash_table_size(comparison->metrics);
+    metrics_comparison_change_t *const changes  = malloc(sizeof(*changes) * (nmetrics + 1));
+    if (!changes) {
+        fputs("Failed to allocate metric comparison!\n", stderr);
+        return 0;
+    }
+
+    /* Regressions are put at the beginning of the array, and improvements at its end */
+    size_t nregressions = 0, nimprovements = 0, nunchanged = 0;
+
+    GHashTableIter iter;
+    gpointer       key, value;
+    g_hash_table_iter_init(&iter, comparison->metrics);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        GArray *const *const samples = value;
+        if (!samples[METRICS_COMPARISON_SIDE_BASELINE]->len ||
+            !samples[METRICS_COMPARISON_SIDE_CANDIDATE]->len)
+            continue;
+
+        const metrics_comparison_change_t change = __metrics_comparison_compare(key, samples);
+        if (!change.significant || fabs(change.relative) < threshold)
+            nunchanged++;
+        else if (change.relative > 0)
+            changes[nregressions++] = change;
+        else
+            changes[nmetrics - nimprovements++] = change;
+    }
+
+    metrics_comparison_change_t *const improvements = changes + nmetrics + 1 - nimprovements;
+    qsort(changes, nregressions, sizeof(*changes), __metrics_comparison_change_compare);
+    qsort(improvements, nimprovements, sizeof(*changes), __metrics_comparison_change_compare);
+
+    fprintf(output,
+            "Compared %zu baseline run(s) with %zu candidate run(s).\n\n",
+            comparison->nruns[METRICS_COMPARISON_SIDE_BASELINE],
+            comparison->nruns[METRICS_COMPARISON_SIDE_CANDIDATE]);
+
+    if (nregressions) {
+        __metrics_comparison_print_table(output, "Regressions", nregressions, changes);
+        putc('\n', output);
+    }
+    if (nimprovements) {
+        __metrics_comparison_print_table(output, "Improvements", nimprovements, improvements);
+        putc('\n', output);
+    }
+
+    fprintf(output,
+            "%zu regression(s), %zu improvement(s), %zu metric(s) without significant changes.\n",
+            nregressions,
+            nimprovements,
+            nunchanged);
+
+    free(changes);
+    return nregressions;
+}
+
+void metrics_comparison_free(metrics_comparison_t *comparison) {
+    g_hash_table_unref(comparison->metrics);
+    free(comparison);
+}
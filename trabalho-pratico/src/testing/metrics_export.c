@@ -0,0 +1,608 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  metrics_export.c
+ * @brief Implementation of methods in include/testing/metrics_export.h
+ *
+ * ### Example
+ * See [the header file's documentation](@ref metrics_export_example).
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queries/query_type_list.h"
+#include "testing/metrics_export.h"
+
+/** @brief Names of dataset loading steps, indexed by ::performance_metrics_dataset_step_t. */
+const char *const metrics_export_dataset_step_names[PERFORMANCE_METRICS_DATASET_STEP_DONE] = {
+    "users",
+    "flights",
+    "passengers",
+    "reservations",
+    "indexes"};
+
+/** @brief Names of hardware counters, indexed by ::hardware_counter_t. */
+const char *const metrics_export_counter_names[HARDWARE_COUNTER_COUNT] = {"cycles",
+                                                                          "instructions",
+                                                                          "cache_misses",
+                                                                          "branch_misses",
+                                                                          "llc_loads"};
+
+/** @brief Percentiles of query execution times to be exported. */
+const double metrics_export_percentiles[] = {50.0, 90.0, 99.0, 99.9};
+
+/** @brief Names of ::metrics_export_percentiles. */
+const char *const metrics_export_percentile_names[] = {"p50_us", "p90_us", "p99_us", "p99_9_us"};
+
+/** @brief Number of elements in ::metrics_export_percentiles. */
+#define METRICS_EXPORT_PERCENTILES_COUNT 4
+
+/**
+ * @brief Writes a JSON string, escaping characters where needed.
+ *
+ * @param output Stream where to write the string to.
+ * @param str    String to be written (without quotes).
+ */
+void __metrics_export_json_string(FILE *output, const char *str) {
+    putc('"', output);
+    for (const char *c = str; *c; ++c) {
+        if (*c == '"' || *c == '\\')
+            fprintf(output, "\\%c", *c);
+        else if ((unsigned char) *c < 0x20)
+            fprintf(output, "\\u%04x", (unsigned char) *c);
+        else
+            putc(*c, output);
+    }
+    putc('"', output);
+}
+
+/**
+ * @brief Writes the values of hardware counters as a JSON object member.
+ *
+ * @param output   Stream where to write the member to.
+ * @param counters Values of the counters. Can be `NULL`, for nothing to be written.
+ */
+void __metrics_export_json_counters(FILE *output, const hardware_counters_values_t *counters) {
+    if (!counters)
+        return;
+
+    fputs(", \"counters\": {", output);
+    for (size_t i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+        fprintf(output,
+                "%s\"%s\": %" PRIu64,
+                i ? ", " : "",
+                metrics_export_counter_names[i],
+                counters->values[i]);
+    putc('}', output);
+}
+
+/**
+ * @brief Writes the time and memory of a performance event as a JSON object.
+ *
+ * @param output   Stream where to write the object to.
+ * @param event    Event to be written. If `NULL`, `null` is written.
+ * @param counters Hardware counter values measured alongside @p event. Can be `NULL`.
+ */
+void __metrics_export_json_event(FILE                             *output,
+                                 const performance_event_t        *event,
+                                 const hardware_counters_values_t *counters) {
+    if (!event) {
+        fputs("null", output);
+        return;
+    }
+
+    fprintf(output,
+            "{\"time_us\": %" PRIu64 ", \"memory_kib\": %zu",
+            performance_event_get_elapsed_time(event),
+            performance_event_get_used_memory(event));
+    __metrics_export_json_counters(output, counters);
+    putc('}', output);
+}
+
+/**
+ * @brief Writes all information about queries of a given type as a JSON object.
+ *
+ * @param output     Stream where to write the object to.
+ * @param metrics    Performance metrics to get the information from.
+ * @param query_type Type of the queries.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __metrics_export_json_query(FILE                        *output,
+                                const performance_metrics_t *metrics,
+                                size_t                       query_type) {
+    fprintf(output, "    {\n      \"type\": %zu,\n      \"statistics\": ", query_type);
+    __metrics_export_json_event(
+        output,
+        performance_metrics_get_query_statistics_measurement(metrics, query_type),
+        performance_metrics_get_query_statistics_counters(metrics, query_type));
+
+    const latency_histogram_t *const histogram =
+        performance_metrics_get_query_latencies(metrics, query_type);
+    fprintf(output,
+            ",\n      \"latency\": {\"count\": %" PRIu64 ", \"total_us\": %" PRIu64,
+            latency_histogram_get_count(histogram),
+            latency_histogram_get_total(histogram));
+    for (size_t i = 0; i < METRICS_EXPORT_PERCENTILES_COUNT; ++i)
+        fprintf(output,
+                ", \"%s\": %" PRIu64,
+                metrics_export_percentile_names[i],
+                latency_histogram_get_percentile(histogram, metrics_export_percentiles[i]));
+    fprintf(output, ", \"max_us\": %" PRIu64, latency_histogram_get_max(histogram));
+    __metrics_export_json_counters(
+        output,
+        performance_metrics_get_query_execution_counters(metrics, query_type));
+    fputs("},\n      \"executions\": [", output);
+
+    size_t      *lines;
+    uint64_t    *times;
+    const size_t n =
+        performance_metrics_get_query_execution_measurements(metrics, query_type, &lines, &times);
+    if (n && (!lines || !times)) {
+        free(lines);
+        free(times);
+        return 1;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        fprintf(output,
+                "%s{\"line\": %zu, \"time_us\": %" PRIu64 "}",
+                i ? ", " : "",
+                lines[i],
+                times[i]);
+    fputs("]\n    }", output);
+
+    free(lines);
+    free(times);
+    return 0;
+}
+
+/**
+ * @brief Writes a list of file names as a JSON array.
+ *
+ * @param output Stream where to write the array to.
+ * @param n      Number of elements in @p files.
+ * @param files  File names to be written.
+ */
+void __metrics_export_json_files(FILE *output, size_t n, const char *const files[n]) {
+    putc('[', output);
+    for (size_t i = 0; i < n; ++i) {
+        if (i)
+            fputs(", ", output);
+        __metrics_export_json_string(output, files[i]);
+    }
+    putc(']', output);
+}
+
+/**
+ * @brief Writes test results as a JSON object.
+ *
+ * @param output Stream where to write the object to.
+ * @param diff   Test results to be written.
+ */
+void __metrics_export_json_diff(FILE *output, const test_diff_t *diff) {
+    size_t n;
+
+    fputs("{\"extra_files\": ", output);
+    const char *const *const extra = test_diff_get_extra_files(diff, &n);
+    __metrics_export_json_files(output, n, extra);
+
+    fputs(", \"missing_files\": ", output);
+    const char *const *const missing = test_diff_get_missing_files(diff, &n);
+    __metrics_export_json_files(output, n, missing);
+
+    const char *const *common;
+    const ssize_t     *errors;
+    n = test_diff_get_common_file_errors(diff, &common, &errors);
+
+    fputs(", \"errors\": [", output);
+    int first = 1;
+    for (size_t i = 0; i < n; ++i) {
+        if (errors[i] == 0)
+            continue;
+
+        fputs(first ? "{\"file\": " : ", {\"file\": ", output);
+        __metrics_export_json_string(output, common[i]);
+        if (errors[i] == -1)
+            fputs(", \"line\": null}", output); /* IO error */
+        else
+            fprintf(output, ", \"line\": %zd}", errors[i]);
+        first = 0;
+    }
+    fputs("]}", output);
+}
+
+/**
+ * @brief Writes the time spent in each phase of parsing a file of the dataset as a JSON object.
+ *
+ * @param output Stream where to write the object to.
+ * @param phases Parsing phases to be written. Can be `NULL`, for `null` to be written.
+ */
+void __metrics_export_json_phases(FILE *output, const dataset_parser_phases_t *phases) {
+    if (!phases) {
+        fputs("null", output);
+        return;
+    }
+
+    fprintf(output,
+            "{\"io_us\": %" PRIu64 ", \"tokenize_us\": %" PRIu64 ", \"validate_us\": %" PRIu64
+            ", \"commit_us\": %" PRIu64 ", \"bytes\": %zu, \"rows\": %zu, \"rejected_rows\": %zu}",
+            phases->io_time / 1000,
+            phases->tokenize_time / 1000,
+            phases->validate_time / 1000,
+            phases->commit_time / 1000,
+            phases->bytes,
+            phases->tokens,
+            phases->rejected_tokens);
+}
+
+/**
+ * @brief Writes performance metrics and test results as a JSON object.
+ *
+ * @param output  Stream where to write the object to.
+ * @param metrics Performance metrics to be written.
+ * @param diff    Test results to be written. Can be `NULL`.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __metrics_export_json(FILE                        *output,
+                          const performance_metrics_t *metrics,
+                          const test_diff_t           *diff) {
+    fputs("{\n  \"dataset\": [\n", output);
+    for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_STEP_DONE; ++i) {
+        fprintf(output, "    {\"step\": \"%s\", \"event\": ", metrics_export_dataset_step_names[i]);
+        __metrics_export_json_event(output,
+                                    performance_metrics_get_dataset_measurement(metrics, i),
+                                    performance_metrics_get_dataset_counters(metrics, i));
+        fputs(", \"phases\": ", output);
+        __metrics_export_json_phases(output, performance_metrics_get_dataset_phases(metrics, i));
+        fputs(i + 1 < PERFORMANCE_METRICS_DATASET_STEP_DONE ? "},\n" : "}\n", output);
+    }
+
+    fputs("  ],\n  \"queries\": [\n", output);
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        if (__metrics_export_json_query(output, metrics, i + 1))
+            return 1;
+        fputs(i + 1 < QUERY_TYPE_LIST_COUNT ? ",\n" : "\n", output);
+    }
+
+    fprintf(output,
+            "  ],\n  \"program\": {\"time_us\": %" PRIu64 ", \"peak_memory_kib\": %zu}",
+            performance_metrics_get_program_total_time(metrics),
+            performance_metrics_get_program_total_mem(metrics));
+
+    if (diff) {
+        fputs(",\n  \"diff\": ", output);
+        __metrics_export_json_diff(output, diff);
+    }
+    fputs("\n}\n", output);
+    return 0;
+}
+
+/**
+ * @brief Writes a CSV field, quoting it if needed.
+ *
+ * @param output Stream where to write the field to.
+ * @param str    Contents of the field.
+ */
+void __metrics_export_csv_field(FILE *output, const char *str) {
+    if (!strpbrk(str, ",\"\n")) {
+        fputs(str, output);
+        return;
+    }
+
+    putc('"', output);
+    for (const char *c = str; *c; ++c) {
+        if (*c == '"')
+            putc('"', output);
+        putc(*c, output);
+    }
+    putc('"', output);
+}
+
+/**
+ * @brief Writes a single measurement as a CSV row.
+ *
+ * @param output  Stream where to write the row to.
+ * @param section Section of the measurement (e.g.: `"dataset"`).
+ * @param name    Name of what was measured (e.g.: `"users"`).
+ * @param line    Line of the query in the batch mode's input file, or `0` to leave it empty.
+ * @param metric  Name of the measured quantity (e.g.: `"time_us"`).
+ * @param value   Measured value.
+ */
+void __metrics_export_csv_row(FILE       *output,
+                              const char *section,
+                              const char *name,
+                              size_t      line,
+                              const char *metric,
+                              uint64_t    value) {
+    fprintf(output, "%s,", section);
+    __metrics_export_csv_field(output, name);
+    if (line)
+        fprintf(output, ",%zu,%s,%" PRIu64 "\n", line, metric, value);
+    else
+        fprintf(output, ",,%s,%" PRIu64 "\n", metric, value);
+}
+
+/**
+ * @brief Writes a performance event (and its hardware counters) as CSV rows.
+ *
+ * @param output   Stream where to write the rows to.
+ * @param section  Section of the measurement (e.g.: `"dataset"`).
+ * @param name     Name of what was measured (e.g.: `"users"`).
+ * @param event    Event to be written. Can be `NULL`, for it to be skipped.
+ * @param counters Hardware counter values measured alongside @p event. Can be `NULL`.
+ */
+void __metrics_export_csv_event(FILE                             *output,
+                                const char                       *section,
+                                const char                       *name,
+                                const performance_event_t        *event,
+                                const hardware_counters_values_t *counters) {
+    if (!event)
+        return;
+
+    __metrics_export_csv_row(output,
+                             section,
+                             name,
+                             0,
+                             "time_us",
+                             performance_event_get_elapsed_time(event));
+    __metrics_export_csv_row(output,
+                             section,
+                             name,
+                             0,
+                             "memory_kib",
+                             performance_event_get_used_memory(event));
+
+    if (counters)
+        for (size_t i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+            __metrics_export_csv_row(output,
+                                     section,
+                                     name,
+                                     0,
+                                     metrics_export_counter_names[i],
+                                     counters->values[i]);
+}
+
+/**
+ * @brief Writes all information about queries of a given type as CSV rows.
+ *
+ * @param output     Stream where to write the rows to.
+ * @param metrics    Performance metrics to get the information from.
+ * @param query_type Type of the queries.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __metrics_export_csv_query(FILE                        *output,
+                               const performance_metrics_t *metrics,
+                               size_t                       query_type) {
+    char name[32];
+    snprintf(name, 32, "%zu", query_type);
+
+    __metrics_export_csv_event(
+        output,
+        "statistics",
+        name,
+        performance_metrics_get_query_statistics_measurement(metrics, query_type),
+        performance_metrics_get_query_statistics_counters(metrics, query_type));
+
+    const latency_histogram_t *const histogram =
+        performance_metrics_get_query_latencies(metrics, query_type);
+    if (latency_histogram_get_count(histogram)) {
+        __metrics_export_csv_row(output,
+                                 "latency",
+                                 name,
+                                 0,
+                                 "count",
+                                 latency_histogram_get_count(histogram));
+        __metrics_export_csv_row(output,
+                                 "latency",
+                                 name,
+                                 0,
+                                 "total_us",
+                                 latency_histogram_get_total(histogram));
+        for (size_t i = 0; i < METRICS_EXPORT_PERCENTILES_COUNT; ++i)
+            __metrics_export_csv_row(
+                output,
+                "latency",
+                name,
+                0,
+                metrics_export_percentile_names[i],
+                latency_histogram_get_percentile(histogram, metrics_export_percentiles[i]));
+        __metrics_export_csv_row(output,
+                                 "latency",
+                                 name,
+                                 0,
+                                 "max_us",
+                                 latency_histogram_get_max(histogram));
+
+        const hardware_counters_values_t *const counters =
+            performance_metrics_get_query_execution_counters(metrics, query_type);
+        if (counters)
+            for (size_t i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+                __metrics_export_csv_row(output,
+                                         "latency",
+                                         name,
+                                         0,
+                                         metrics_export_counter_names[i],
+                                         counters->values[i]);
+    }
+
+    size_t      *lines;
+    uint64_t    *times;
+    const size_t n =
+        performance_metrics_get_query_execution_measurements(metrics, query_type, &lines, &times);
+    if (n && (!lines || !times)) {
+        free(lines);
+        free(times);
+        return 1;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        __metrics_export_csv_row(output, "query", name, lines[i], "time_us", times[i]);
+
+    free(lines);
+    free(times);
+    return 0;
+}
+
+/**
+ * @brief Writes test results as CSV rows.
+ *
+ * @param output Stream where to write the rows to.
+ * @param diff   Test results to be written.
+ */
+void __metrics_export_csv_diff(FILE *output, const test_diff_t *diff) {
+    size_t n;
+
+    const char *const *const extra = test_diff_get_extra_files(diff, &n);
+    __metrics_export_csv_row(output, "diff", "extra_files", 0, "count", n);
+    for (size_t i = 0; i < n; ++i)
+        __metrics_export_csv_row(output, "diff_extra", extra[i], 0, "count", 1);
+
+    const char *const *const missing = test_diff_get_missing_files(diff, &n);
+    __metrics_export_csv_row(output, "diff", "missing_files", 0, "count", n);
+    for (size_t i = 0; i < n; ++i)
+        __metrics_export_csv_row(output, "diff_missing", missing[i], 0, "count", 1);
+
+    const char *const *common;
+    const ssize_t     *errors;
+    n = test_diff_get_common_file_errors(diff, &common, &errors);
+
+    size_t nerrors = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (errors[i] == -1) {
+            __metrics_export_csv_row(output, "diff_error", common[i], 0, "io_error", 1);
+            nerrors++;
+        } else if (errors[i] > 0) {
+            __metrics_export_csv_row(output, "diff_error", common[i], errors[i], "line", errors[i]);
+            nerrors++;
+        }
+    }
+    __metrics_export_csv_row(output, "diff", "errors", 0, "count", nerrors);
+}
+
+/**
+ * @brief Writes the time spent in each phase of parsing a file of the dataset as CSV rows.
+ *
+ * @param output Stream where to write the rows to.
+ * @param name   Name of the dataset loading step (e.g.: `"users"`).
+ * @param phases Parsing phases to be written. Can be `NULL`, for them to be skipped.
+ */
+void __metrics_export_csv_phases(FILE                          *output,
+                                 const char                    *name,
+                                 const dataset_parser_phases_t *phases) {
+    if (!phases)
+        return;
+
+    __metrics_export_csv_row(output, "dataset", name, 0, "io_us", phases->io_time / 1000);
+    __metrics_export_csv_row(output,
+                             "dataset",
+                             name,
+                             0,
+                             "tokenize_us",
+                             phases->tokenize_time / 1000);
+    __metrics_export_csv_row(output,
+                             "dataset",
+                             name,
+                             0,
+                             "validate_us",
+                             phases->validate_time / 1000);
+    __metrics_export_csv_row(output, "dataset", name, 0, "commit_us", phases->commit_time / 1000);
+    __metrics_export_csv_row(output, "dataset", name, 0, "bytes", phases->bytes);
+    __metrics_export_csv_row(output, "dataset", name, 0, "rows", phases->tokens);
+    __metrics_export_csv_row(output, "dataset", name, 0, "rejected_rows", phases->rejected_tokens);
+}
+
+/**
+ * @brief Writes performance metrics and test results as CSV.
+ *
+ * @param output  Stream where to write the rows to.
+ * @param metrics Performance metrics to be written.
+ * @param diff    Test results to be written. Can be `NULL`.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __metrics_export_csv(FILE                        *output,
+                         const performance_metrics_t *metrics,
+                         const test_diff_t           *diff) {
+    fputs("section,name,line,metric,value\n", output);
+
+    for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_STEP_DONE; ++i) {
+        __metrics_export_csv_event(output,
+                                   "dataset",
+                                   metrics_export_dataset_step_names[i],
+                                   performance_metrics_get_dataset_measurement(metrics, i),
+                                   performance_metrics_get_dataset_counters(metrics, i));
+        __metrics_export_csv_phases(output,
+                                    metrics_export_dataset_step_names[i],
+                                    performance_metrics_get_dataset_phases(metrics, i));
+    }
+
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
+        if (__metrics_export_csv_query(output, metrics, i + 1))
+            return 1;
+
+    __metrics_export_csv_row(output,
+                             "program",
+                             "total",
+                             0,
+                             "time_us",
+                             performance_metrics_get_program_total_time(metrics));
+    __metrics_export_csv_row(output,
+                             "program",
+                             "total",
+                             0,
+                             "peak_memory_kib",
+                             performance_metrics_get_program_total_mem(metrics));
+
+    if (diff)
+        __metrics_export_csv_diff(output, diff);
+    return 0;
+}
+
+int metrics_export_write(FILE                        *output,
+                         metrics_export_format_t      format,
+                         const performance_metrics_t *metrics,
+                         const test_diff_t           *diff) {
+    int retval;
+    if (format == METRICS_EXPORT_FORMAT_JSON)
+        retval = __metrics_export_json(output, metrics, diff);
+    else
+        retval = __metrics_export_csv(output, metrics, diff);
+
+    return retval || ferror(output);
+}
+
+int metrics_export_write_file(const char                  *path,
+                              metrics_export_format_t      format,
+                              const performance_metrics_t *metrics,
+                              const test_diff_t           *diff) {
+    FILE *const output = fopen(path, "w");
+    if (!output)
+        return 1;
+
+    const int retval = metrics_export_write(output, format, metrics, diff);
+    return fclose(output) || retval;
+}
@@ -0,0 +1,1246 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  microbenchmarks.c
+ * @brief Implementation of methods in include/testing/microbenchmarks.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref microbenchmarks_examples).
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "testing/microbenchmarks.h"
+#include "testing/performance_event.h"
+#include "types/account_status.h"
+#include "types/email.h"
+#include "types/sex.h"
+#include "utils/cache_line.h"
+#include "utils/date.h"
+#include "utils/cpu_features.h"
+#include "utils/date_overlap.h"
+#include "utils/fixed_n_delimiter_parser.h"
+#include "utils/glib/GConstKeyHashTable.h"
+#include "utils/id_hash_table.h"
+#include "utils/parallel_for.h"
+#include "utils/pool.h"
+#include "utils/string_hash_table.h"
+#include "utils/string_pool.h"
+#include "utils/string_pool_no_duplicates.h"
+#include "utils/table.h"
+
+/** @brief Minimum number of operations in each repetition of a benchmark. */
+#define MICROBENCHMARKS_MIN_OPERATIONS 1000000
+
+/** @brief Smallest number of operations per benchmark. */
+#define MICROBENCHMARKS_MIN_SIZE 1000
+
+/** @brief Maximum number of different inputs of benchmarks whose inputs can be repeated. */
+#define MICROBENCHMARKS_MAX_INPUTS 4096
+
+/** @brief Number of characters reserved for each input string (including the null terminator). */
+#define MICROBENCHMARKS_STRING_STRIDE 32
+
+/** @brief Number of characters reserved for each CSV line (including the null terminator). */
+#define MICROBENCHMARKS_LINE_STRIDE 192
+
+/** @brief Number of fields in the benchmarked CSV lines (like in `users.csv`). */
+#define MICROBENCHMARKS_LINE_FIELDS 12
+
+/** @brief Block capacity of the pools used in benchmarks (like in the loaders). */
+#define MICROBENCHMARKS_POOL_BLOCK_CAPACITY 4096
+
+/**
+ * @struct microbenchmarks_timer_t
+ * @brief  Measurements of a repetition of a benchmark.
+ *
+ * @var microbenchmarks_timer_t::memory_source
+ *     @brief File from where memory usage is read (see ::performance_event_open_memory_source).
+ * @var microbenchmarks_timer_t::event
+ *     @brief Event being currently measured, between ::__microbenchmarks_start and
+ *            ::__microbenchmarks_stop.
+ * @var microbenchmarks_timer_t::elapsed
+ *     @brief Sum of the elapsed times (in microseconds) of all measured sections.
+ * @var microbenchmarks_timer_t::memory
+ *     @brief Memory (in KiB) allocated in the last measured section where memory was measured.
+ * @var microbenchmarks_timer_t::measure_memory
+ *     @brief Whether to measure memory in the next measured section.
+ * @var microbenchmarks_timer_t::sink
+ *     @brief Where benchmarks accumulate results, so that their operations aren't optimized away.
+ */
+typedef struct {
+    int                  memory_source;
+    performance_event_t *event;
+    uint64_t             elapsed;
+    size_t               memory;
+    int                  measure_memory;
+    uint64_t             sink;
+} microbenchmarks_timer_t;
+
+/**
+ * @brief Starts measuring the section of a benchmark with the operations being benchmarked.
+ *
+ * @param timer Measurements of the current repetition.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or measurement failure.
+ */
+int __microbenchmarks_start(microbenchmarks_timer_t *timer) {
+    timer->event = performance_event_start_measuring_lightweight(
+        timer->measure_memory ? timer->memory_source : -1);
+    return !timer->event;
+}
+
+/**
+ * @brief Stops measuring the section of a benchmark started with ::__microbenchmarks_start.
+ *
+ * @param timer Measurements of the current repetition.
+ *
+ * @retval 0 Success.
+ * @retval 1 Measurement failure.
+ */
+int __microbenchmarks_stop(microbenchmarks_timer_t *timer) {
+    const int retval = performance_event_stop_measuring(timer->event);
+    if (!retval) {
+        timer->elapsed += performance_event_get_elapsed_time(timer->event);
+        if (timer->measure_memory)
+            timer->memory = performance_event_get_used_memory(timer->event);
+    }
+
+    performance_event_free(timer->event);
+    timer->event = NULL;
+    return retval;
+}
+
+/**
+ * @brief  Hashes an integer (SplitMix64's finalizer), to get varied but reproducible inputs.
+ * @param  i Integer to be hashed.
+ * @return The hash of @p i.
+ */
+uint64_t __microbenchmarks_mix(uint64_t i) {
+    i += 0x9E3779B97F4A7C15ULL;
+    i = (i ^ (i >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    i = (i ^ (i >> 27)) * 0x94D049BB133111EBULL;
+    return i ^ (i >> 31);
+}
+
+/**
+ * @brief Method that writes the input string of a benchmark with a given index.
+ *
+ * @param output Where to write the string to.
+ * @param stride Number of characters available in @p output.
+ * @param i      Index of the input.
+ */
+typedef void (*microbenchmarks_input_generator_t)(char *output, size_t stride, size_t i);
+
+/** @brief Generates a key, like a user identifier. */
+void __microbenchmarks_key(char *output, size_t stride, size_t i) {
+    snprintf(output, stride, "User%zuName", (size_t) (__microbenchmarks_mix(i) % 100000000));
+}
+
+/** @brief Generates a valid date. */
+void __microbenchmarks_date(char *output, size_t stride, size_t i) {
+    const uint64_t mix = __microbenchmarks_mix(i);
+    snprintf(output,
+             stride,
+             "%04d/%02d/%02d",
+             (int) (1950 + mix % 75),
+             (int) ((mix >> 8) % 12 + 1),
+             (int) ((mix >> 16) % 28 + 1));
+}
+
+/** @brief Generates an email, that is invalid one in every eight times. */
+void __microbenchmarks_email(char *output, size_t stride, size_t i) {
+    const uint64_t mix = __microbenchmarks_mix(i);
+    snprintf(output,
+             stride,
+             "user.%zu@%s.%s",
+             (size_t) (mix % 1000000),
+             (mix >> 24) % 8 ? "example" : "",
+             (mix >> 32) % 2 ? "com" : "pt");
+}
+
+/** @brief Generates a line of a CSV file, like the ones in `users.csv`. */
+void __microbenchmarks_line(char *output, size_t stride, size_t i) {
+    const uint64_t mix = __microbenchmarks_mix(i);
+    snprintf(output,
+             stride,
+             "User%zuName;Some Name;user%zu@example.com;9%08zu;19%02zu/%02zu/%02zu;%s;PT%06zu;PT;"
+             "Rua Qualquer, %zu;2015/03/06 20:18:30;credit_card;active",
+             (size_t) (mix % 100000000),
+             (size_t) (mix % 100000000),
+             (size_t) (mix % 100000000),
+             (size_t) ((mix >> 8) % 100),
+             (size_t) ((mix >> 16) % 12 + 1),
+             (size_t) ((mix >> 24) % 28 + 1),
+             (mix >> 32) % 2 ? "M" : "F",
+             (size_t) (mix % 1000000),
+             (size_t) ((mix >> 40) % 300));
+}
+
+/**
+ * @brief Generates the inputs of a benchmark.
+ *
+ * @param n         Number of inputs.
+ * @param stride    Number of characters reserved for each input.
+ * @param generator Method that generates each input.
+ *
+ * @return A buffer of @p n strings, input `i` starting at `i * stride`, or `NULL` on allocation
+ *         failure. It must be `free`d.
+ */
+char *__microbenchmarks_inputs_create(size_t                            n,
+                                      size_t                            stride,
+                                      microbenchmarks_input_generator_t generator) {
+    char *const inputs = malloc(n * stride);
+    if (!inputs)
+        return NULL;
+
+    for (size_t i = 0; i < n; ++i)
+        generator(inputs + i * stride, stride, i);
+    return inputs;
+}
+
+/**
+ * @brief Type of the method that runs a benchmark once.
+ *
+ * @param timer Where to measure the benchmark's operations, with ::__microbenchmarks_start and
+ *              ::__microbenchmarks_stop.
+ * @param n     Number of operations to run.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or measurement failure.
+ */
+typedef int (*microbenchmarks_benchmark_t)(microbenchmarks_timer_t *timer, size_t n);
+
+/** @brief Benchmarks ::pool_alloc_item, including the creation of the pool. */
+int __microbenchmarks_pool_alloc_item(microbenchmarks_timer_t *timer, size_t n) {
+    if (__microbenchmarks_start(timer))
+        return 1;
+
+    pool_t *const pool = pool_create(uint64_t, MICROBENCHMARKS_POOL_BLOCK_CAPACITY);
+    if (!pool) {
+        __microbenchmarks_stop(timer);
+        return 1;
+    }
+
+    int retval = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t *const item = pool_alloc_item(uint64_t, pool);
+        if (!item) {
+            retval = 1;
+            break;
+        }
+        *item = i;
+    }
+
+    retval |= __microbenchmarks_stop(timer);
+    pool_free(pool);
+    return retval;
+}
+
+/** @brief Benchmarks ::string_pool_put with different strings. */
+int __microbenchmarks_string_pool_put(microbenchmarks_timer_t *timer, size_t n) {
+    char *const keys =
+        __microbenchmarks_inputs_create(n, MICROBENCHMARKS_STRING_STRIDE, __microbenchmarks_key);
+    if (!keys)
+        return 1;
+
+    int retval = 1;
+    if (__microbenchmarks_start(timer))
+        goto DEFER_1;
+
+    string_pool_t *const pool = string_pool_create(MICROBENCHMARKS_POOL_BLOCK_CAPACITY * 16);
+    if (!pool) {
+        __microbenchmarks_stop(timer);
+        goto DEFER_1;
+    }
+
+    retval = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!string_pool_put(pool, keys + i * MICROBENCHMARKS_STRING_STRIDE)) {
+            retval = 1;
+            break;
+        }
+    }
+
+    retval |= __microbenchmarks_stop(timer);
+    string_pool_free(pool);
+DEFER_1:
+    free(keys);
+    return retval;
+}
+
+/** @brief Benchmarks ::string_pool_no_duplicates_put, where each string is put eight times. */
+int __microbenchmarks_string_pool_no_duplicates_put(microbenchmarks_timer_t *timer, size_t n) {
+    const size_t ndistinct = n / 8 + 1;
+    char *const  keys      = __microbenchmarks_inputs_create(ndistinct,
+                                                       MICROBENCHMARKS_STRING_STRIDE,
+                                                       __microbenchmarks_key);
+    if (!keys)
+        return 1;
+
+    int retval = 1;
+    if (__microbenchmarks_start(timer))
+        goto DEFER_1;
+
+    string_pool_no_duplicates_t *const pool =
+        string_pool_no_duplicates_create(MICROBENCHMARKS_POOL_BLOCK_CAPACITY * 16);
+    if (!pool) {
+        __microbenchmarks_stop(timer);
+        goto DEFER_1;
+    }
+
+    retval = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const char *const key = keys + (i % ndistinct) * MICROBENCHMARKS_STRING_STRIDE;
+        if (!string_pool_no_duplicates_put(pool, key)) {
+            retval = 1;
+            break;
+        }
+    }
+
+    retval |= __microbenchmarks_stop(timer);
+    string_pool_no_duplicates_free(pool);
+DEFER_1:
+    free(keys);
+    return retval;
+}
+
+/**
+ * @brief Benchmarks insertions or lookups in a ::GConstKeyHashTable with string keys.
+ *
+ * @param timer  Where to measure the benchmark's operations.
+ * @param n      Number of keys.
+ * @param lookup Whether to benchmark lookups (the table is filled before measuring) instead of
+ *               insertions.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or measurement failure.
+ */
+int __microbenchmarks_g_const_key_hash_table(microbenchmarks_timer_t *timer,
+                                             size_t                   n,
+                                             int                      lookup) {
+    char *const keys =
+        __microbenchmarks_inputs_create(n, MICROBENCHMARKS_STRING_STRIDE, __microbenchmarks_key);
+    if (!keys)
+        return 1;
+
+    int retval = 1;
+    if (!lookup && __microbenchmarks_start(timer))
+        goto DEFER_1;
+
+    GConstKeyHashTable *const table = g_const_key_hash_table_new(g_str_hash, g_str_equal);
+    for (size_t i = 0; i < n; ++i)
+        g_const_key_hash_table_insert(table, keys + i * MICROBENCHMARKS_STRING_STRIDE, keys);
+
+    if (lookup) {
+        if (__microbenchmarks_start(timer))
+            goto DEFER_2;
+
+        for (size_t i = 0; i < n; ++i) {
+            const size_t key = __microbenchmarks_mix(i) % n;
+            timer->sink += !!g_const_key_hash_table_lookup(
+                table,
+                keys + key * MICROBENCHMARKS_STRING_STRIDE);
+        }
+    }
+
+    retval = __microbenchmarks_stop(timer);
+DEFER_2:
+    g_const_key_hash_table_unref(table);
+DEFER_1:
+    free(keys);
+    return retval;
+}
+
+/** @brief Benchmarks ::g_const_key_hash_table_insert. */
+int __microbenchmarks_g_const_key_hash_table_insert(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_g_const_key_hash_table(timer, n, 0);
+}
+
+/** @brief Benchmarks ::g_const_key_hash_table_lookup. */
+int __microbenchmarks_g_const_key_hash_table_lookup(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_g_const_key_hash_table(timer, n, 1);
+}
+
+/**
+ * @brief Benchmarks insertions or lookups in a ::string_hash_table_t.
+ *
+ * @param timer  Where to measure the benchmark's operations.
+ * @param n      Number of keys.
+ * @param lookup Whether to benchmark lookups (the table is filled before measuring) instead of
+ *               insertions.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or measurement failure.
+ */
+int __microbenchmarks_string_hash_table(microbenchmarks_timer_t *timer, size_t n, int lookup) {
+    char *const keys =
+        __microbenchmarks_inputs_create(n, MICROBENCHMARKS_STRING_STRIDE, __microbenchmarks_key);
+    if (!keys)
+        return 1;
+
+    int retval = 1;
+    if (!lookup && __microbenchmarks_start(timer))
+        goto DEFER_1;
+
+    string_hash_table_t *const table = string_hash_table_create(0);
+    if (!table) {
+        if (!lookup)
+            __microbenchmarks_stop(timer);
+        goto DEFER_1;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (string_hash_table_insert(table, keys + i * MICROBENCHMARKS_STRING_STRIDE, keys) == 1) {
+            if (!lookup)
+                __microbenchmarks_stop(timer);
+            goto DEFER_2;
+        }
+    }
+
+    if (lookup) {
+        if (__microbenchmarks_start(timer))
+            goto DEFER_2;
+
+        for (size_t i = 0; i < n; ++i) {
+            const size_t key = __microbenchmarks_mix(i) % n;
+            timer->sink +=
+                !!string_hash_table_lookup(table, keys + key * MICROBENCHMARKS_STRING_STRIDE);
+        }
+    }
+
+    retval = __microbenchmarks_stop(timer);
+DEFER_2:
+    string_hash_table_free(table);
+DEFER_1:
+    free(keys);
+    return retval;
+}
+
+/** @brief Benchmarks ::string_hash_table_insert. */
+int __microbenchmarks_string_hash_table_insert(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_string_hash_table(timer, n, 0);
+}
+
+/** @brief Benchmarks ::string_hash_table_lookup. */
+int __microbenchmarks_string_hash_table_lookup(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_string_hash_table(timer, n, 1);
+}
+
+/**
+ * @brief Benchmarks insertions or lookups in an ::id_hash_table_t, with scattered keys.
+ *
+ * @param timer  Where to measure the benchmark's operations.
+ * @param n      Number of keys.
+ * @param lookup Whether to benchmark lookups (the table is filled before measuring) instead of
+ *               insertions.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or measurement failure.
+ */
+int __microbenchmarks_id_hash_table(microbenchmarks_timer_t *timer, size_t n, int lookup) {
+    if (!lookup && __microbenchmarks_start(timer))
+        return 1;
+
+    id_hash_table_t *const table = id_hash_table_create(0);
+    if (!table) {
+        if (!lookup)
+            __microbenchmarks_stop(timer);
+        return 1;
+    }
+
+    int retval = 1;
+    for (size_t i = 0; i < n; ++i) {
+        if (id_hash_table_insert(table, (uint32_t) __microbenchmarks_mix(i), table) == 1) {
+            if (!lookup)
+                __microbenchmarks_stop(timer);
+            goto DEFER_1;
+        }
+    }
+
+    if (lookup) {
+        if (__microbenchmarks_start(timer))
+            goto DEFER_1;
+
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t key = __microbenchmarks_mix(__microbenchmarks_mix(i) % n);
+            timer->sink += !!id_hash_table_lookup(table, key);
+        }
+    }
+
+    retval = __microbenchmarks_stop(timer);
+DEFER_1:
+    id_hash_table_free(table);
+    return retval;
+}
+
+/** @brief Benchmarks ::id_hash_table_insert. */
+int __microbenchmarks_id_hash_table_insert(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_id_hash_table(timer, n, 0);
+}
+
+/** @brief Benchmarks ::id_hash_table_lookup. */
+int __microbenchmarks_id_hash_table_lookup(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_id_hash_table(timer, n, 1);
+}
+
+/** @brief Callback for every field in ::__microbenchmarks_fixed_n_delimiter_parser. */
+int __microbenchmarks_fixed_n_delimiter_parser_callback(void  *user_data,
+                                                         char  *token,
+                                                         size_t ntoken) {
+    *(uint64_t *) user_data += (unsigned char) *token + ntoken;
+    return 0;
+}
+
+/** @brief Benchmarks ::fixed_n_delimiter_parser_parse_string with lines of `users.csv`. */
+int __microbenchmarks_fixed_n_delimiter_parser(microbenchmarks_timer_t *timer, size_t n) {
+    const size_t ninputs = n < MICROBENCHMARKS_MAX_INPUTS ? n : MICROBENCHMARKS_MAX_INPUTS;
+    char *const  lines   = __microbenchmarks_inputs_create(ninputs,
+                                                        MICROBENCHMARKS_LINE_STRIDE,
+                                                        __microbenchmarks_line);
+    if (!lines)
+        return 1;
+
+    fixed_n_delimiter_parser_iter_callback_t callbacks[MICROBENCHMARKS_LINE_FIELDS];
+    for (size_t i = 0; i < MICROBENCHMARKS_LINE_FIELDS; ++i)
+        callbacks[i] = __microbenchmarks_fixed_n_delimiter_parser_callback;
+
+    int                                       retval = 1;
+    fixed_n_delimiter_parser_grammar_t *const grammar =
+        fixed_n_delimiter_parser_grammar_new(';', MICROBENCHMARKS_LINE_FIELDS, callbacks);
+    if (!grammar)
+        goto DEFER_1;
+
+    if (__microbenchmarks_start(timer))
+        goto DEFER_2;
+
+    for (size_t i = 0; i < n; ++i) {
+        char *const line = lines + (i % ninputs) * MICROBENCHMARKS_LINE_STRIDE;
+        timer->sink += fixed_n_delimiter_parser_parse_string(line, grammar, &timer->sink);
+    }
+
+    retval = __microbenchmarks_stop(timer);
+DEFER_2:
+    fixed_n_delimiter_parser_grammar_free(grammar);
+DEFER_1:
+    free(lines);
+    return retval;
+}
+
+/** @brief Benchmarks ::date_from_string with valid dates. */
+int __microbenchmarks_date_from_string(microbenchmarks_timer_t *timer, size_t n) {
+    const size_t ninputs = n < MICROBENCHMARKS_MAX_INPUTS ? n : MICROBENCHMARKS_MAX_INPUTS;
+    char *const  dates   = __microbenchmarks_inputs_create(ninputs,
+                                                        MICROBENCHMARKS_STRING_STRIDE,
+                                                        __microbenchmarks_date);
+    if (!dates)
+        return 1;
+
+    int retval = 1;
+    if (!__microbenchmarks_start(timer)) {
+        for (size_t i = 0; i < n; ++i) {
+            date_t date = 0;
+            timer->sink +=
+                date_from_string(&date, dates + (i % ninputs) * MICROBENCHMARKS_STRING_STRIDE);
+            timer->sink += date;
+        }
+        retval = __microbenchmarks_stop(timer);
+    }
+
+    free(dates);
+    return retval;
+}
+
+/** @brief Benchmarks ::email_validate_string with mostly valid emails. */
+int __microbenchmarks_email_validate_string(microbenchmarks_timer_t *timer, size_t n) {
+    const size_t ninputs = n < MICROBENCHMARKS_MAX_INPUTS ? n : MICROBENCHMARKS_MAX_INPUTS;
+    char *const  emails  = __microbenchmarks_inputs_create(ninputs,
+                                                         MICROBENCHMARKS_STRING_STRIDE,
+                                                         __microbenchmarks_email);
+    if (!emails)
+        return 1;
+
+    int retval = 1;
+    if (!__microbenchmarks_start(timer)) {
+        for (size_t i = 0; i < n; ++i)
+            timer->sink +=
+                email_validate_string(emails + (i % ninputs) * MICROBENCHMARKS_STRING_STRIDE);
+        retval = __microbenchmarks_stop(timer);
+    }
+
+    free(emails);
+    return retval;
+}
+
+/**
+ * @brief Generates intervals of dates like the stays of reservations, up to three weeks long.
+ *
+ * @param n     Number of intervals.
+ * @param begin Where to write the first day of every interval to.
+ * @param end   Where to write the day after the last day of every interval to.
+ * @param price Where to write the weight of every interval to.
+ */
+void __microbenchmarks_intervals(size_t n, date_t *begin, date_t *end, uint16_t *price) {
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t hash = __microbenchmarks_mix(i);
+        begin[i]            = DATE_CURRENT - hash % DATE_DAYS_PER_YEAR;
+        end[i]              = begin[i] + (hash >> 16) % 22;
+        price[i]            = (hash >> 32) % 1000;
+    }
+}
+
+/** @brief Benchmarks ::date_overlap_weighted_sum, with windows of a month. */
+int __microbenchmarks_date_overlap_weighted_sum(microbenchmarks_timer_t *timer, size_t n) {
+    date_t *const   begin = malloc(sizeof(date_t) * n);
+    date_t *const   end   = malloc(sizeof(date_t) * n);
+    uint16_t *const price = malloc(sizeof(uint16_t) * n);
+
+    int retval = 1;
+    if (!begin || !end || !price)
+        goto DEFER_1;
+
+    __microbenchmarks_intervals(n, begin, end, price);
+    if (!__microbenchmarks_start(timer)) {
+        const date_t first = DATE_CURRENT - DATE_DAYS_PER_YEAR / 2;
+        timer->sink +=
+            date_overlap_weighted_sum(n, begin, end, price, first, first + DATE_DAYS_PER_MONTH);
+        retval = __microbenchmarks_stop(timer);
+    }
+
+DEFER_1:
+    free(begin);
+    free(end);
+    free(price);
+    return retval;
+}
+
+/** @brief Number of counters in each thread's accumulator (like the months of a year in Q10). */
+#define MICROBENCHMARKS_ACCUMULATOR_COUNTERS 13
+
+/**
+ * @struct microbenchmarks_accumulator_thread_t
+ * @brief  Data of a thread in ::__microbenchmarks_accumulators.
+ *
+ * @var microbenchmarks_accumulator_thread_t::keys
+ *     @brief Counter to increment for each index (shared by all threads).
+ * @var microbenchmarks_accumulator_thread_t::counters
+ *     @brief Partial counters of this thread.
+ */
+typedef struct {
+    const uint8_t *keys;
+    uint64_t      *counters;
+} microbenchmarks_accumulator_thread_t;
+
+/** @brief Callback for ::parallel_for that counts the keys in a sub-range of indices. */
+int __microbenchmarks_accumulators_range(void *user_data, size_t begin, size_t end) {
+    const microbenchmarks_accumulator_thread_t *const thread = user_data;
+    for (size_t i = begin; i < end; ++i)
+        thread->counters[thread->keys[i]]++;
+    return 0;
+}
+
+/**
+ * @brief   Benchmarks accumulating into per-thread partial counters, that are merged afterwards.
+ * @details Like the partial data of a parallel scan (see ::query_type_scan_t::partial_begin), each
+ *          of the @p nthreads counts the keys in its own sub-range. With @p padded, the counters
+ *          of each thread start on their own cache line. Otherwise, they're packed next to each
+ *          other, and neighbouring threads write to the same cache lines (false sharing).
+ *
+ * @param timer    Measurements of the current repetition.
+ * @param n        Number of keys to count.
+ * @param nthreads Number of threads to split counting across.
+ * @param padded   Whether to keep the counters of each thread in separate cache lines.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or measurement failure, or wrong merged counts.
+ */
+int __microbenchmarks_accumulators(microbenchmarks_timer_t *timer,
+                                   size_t                   n,
+                                   size_t                   nthreads,
+                                   int                      padded) {
+    const size_t size   = MICROBENCHMARKS_ACCUMULATOR_COUNTERS * sizeof(uint64_t);
+    const size_t stride = padded ? CACHE_LINE_ROUND_UP(size) : size;
+
+    microbenchmarks_accumulator_thread_t threads[nthreads];
+    void                                *thread_pointers[nthreads];
+    int                                  retval = 1;
+
+    uint8_t *const keys = malloc(n);
+    if (!keys)
+        return 1;
+
+    char *const counters = cache_line_calloc(stride * nthreads);
+    if (!counters)
+        goto DEFER_1;
+
+    for (size_t i = 0; i < n; ++i)
+        keys[i] = __microbenchmarks_mix(i) % MICROBENCHMARKS_ACCUMULATOR_COUNTERS;
+
+    for (size_t t = 0; t < nthreads; ++t) {
+        threads[t] = (microbenchmarks_accumulator_thread_t){
+            .keys     = keys,
+            .counters = (uint64_t *) (void *) (counters + t * stride)};
+        thread_pointers[t] = &threads[t];
+    }
+
+    if (__microbenchmarks_start(timer))
+        goto DEFER_2;
+
+    parallel_for(n, nthreads, __microbenchmarks_accumulators_range, thread_pointers);
+
+    /* Deterministic merge, in the order of the threads' sub-ranges */
+    uint64_t merged[MICROBENCHMARKS_ACCUMULATOR_COUNTERS] = {0};
+    for (size_t t = 0; t < nthreads; ++t)
+        for (size_t c = 0; c < MICROBENCHMARKS_ACCUMULATOR_COUNTERS; ++c)
+            merged[c] += threads[t].counters[c];
+
+    if (__microbenchmarks_stop(timer))
+        goto DEFER_2;
+
+    uint64_t total = 0;
+    for (size_t c = 0; c < MICROBENCHMARKS_ACCUMULATOR_COUNTERS; ++c)
+        total += merged[c];
+
+    timer->sink += merged[0];
+    retval = total != n;
+
+DEFER_2:
+    free(counters);
+DEFER_1:
+    free(keys);
+    return retval;
+}
+
+/** @brief Benchmarks counting in a single thread, the baseline of the other accumulators. */
+int __microbenchmarks_accumulators_1_thread(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_accumulators(timer, n, 1, 1);
+}
+
+/** @brief Benchmarks counting in 2 threads, with counters in the same cache lines. */
+int __microbenchmarks_accumulators_packed_2_threads(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_accumulators(timer, n, 2, 0);
+}
+
+/** @brief Benchmarks counting in 4 threads, with counters in the same cache lines. */
+int __microbenchmarks_accumulators_packed_4_threads(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_accumulators(timer, n, 4, 0);
+}
+
+/** @brief Benchmarks counting in 2 threads, with counters in different cache lines. */
+int __microbenchmarks_accumulators_padded_2_threads(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_accumulators(timer, n, 2, 1);
+}
+
+/** @brief Benchmarks counting in 4 threads, with counters in different cache lines. */
+int __microbenchmarks_accumulators_padded_4_threads(microbenchmarks_timer_t *timer, size_t n) {
+    return __microbenchmarks_accumulators(timer, n, 4, 1);
+}
+
+/**
+ * @brief Callback for the username and the domain name in ::__microbenchmarks_email_reference.
+ *        Fails on empty strings.
+ */
+int __microbenchmarks_email_reference_non_empty(void *user_data, char *token, size_t ntoken) {
+    (void) user_data;
+    (void) ntoken;
+    return *token == '\0';
+}
+
+/** @brief Callback for the TLD in ::__microbenchmarks_email_reference. */
+int __microbenchmarks_email_reference_tld(void *user_data, char *token, size_t ntoken) {
+    (void) user_data;
+    (void) ntoken;
+    return strlen(token) < 2;
+}
+
+/**
+ * @brief Callback for the domain in ::__microbenchmarks_email_reference.
+ * @param user_data Grammar for email domains.
+ */
+int __microbenchmarks_email_reference_domain(void *user_data, char *token, size_t ntoken) {
+    (void) ntoken;
+    return fixed_n_delimiter_parser_parse_string(token, user_data, NULL) != 0;
+}
+
+/**
+ * @brief   Reference implementation of ::email_validate_string, made of grammars.
+ * @details ::email_validate_string used to be implemented like this, and vectorizing it mustn't
+ *          change which emails it accepts.
+ *
+ * @param input  Email to be validated. Will be modified.
+ * @param email  Grammar that splits @p input in a username and a domain.
+ * @param domain Grammar that splits a domain in a name and a TLD.
+ *
+ * @retval 0 Valid email.
+ * @retval 1 Validation failure.
+ */
+int __microbenchmarks_email_reference(char                                     *input,
+                                      const fixed_n_delimiter_parser_grammar_t *email,
+                                      fixed_n_delimiter_parser_grammar_t       *domain) {
+    return fixed_n_delimiter_parser_parse_string(input, email, domain) != 0;
+}
+
+/**
+ * @brief   Compares ::email_validate_string with ::__microbenchmarks_email_reference.
+ * @details All strings made of `'a'`, `'@'` and `'.'`, up to a given length, are tested, starting
+ *          at every position inside a 16-byte block, and preceded by usernames of different
+ *          lengths, so that separators land on both sides of block boundaries.
+ *
+ * @retval 0 Both implementations agree.
+ * @retval 1 Mismatch (reported to `stderr`) or allocation failure.
+ */
+int __microbenchmarks_check_email(void) {
+    const fixed_n_delimiter_parser_iter_callback_t domain_callbacks[2] = {
+        __microbenchmarks_email_reference_non_empty,
+        __microbenchmarks_email_reference_tld};
+    const fixed_n_delimiter_parser_iter_callback_t email_callbacks[2] = {
+        __microbenchmarks_email_reference_non_empty,
+        __microbenchmarks_email_reference_domain};
+
+    int                                       retval = 1;
+    fixed_n_delimiter_parser_grammar_t *const domain =
+        fixed_n_delimiter_parser_grammar_new('.', 2, domain_callbacks);
+    if (!domain)
+        return 1;
+    fixed_n_delimiter_parser_grammar_t *const email =
+        fixed_n_delimiter_parser_grammar_new('@', 2, email_callbacks);
+    if (!email)
+        goto DEFER_1;
+
+    const char alphabet[3] = {'a', '@', '.'};
+    for (size_t length = 0; length <= 7; ++length) {
+        size_t combinations = 1;
+        for (size_t i = 0; i < length; ++i)
+            combinations *= sizeof(alphabet);
+
+        for (size_t combination = 0; combination < combinations; ++combination) {
+            for (size_t prefix = 0; prefix <= 18; prefix += 9) {
+                for (size_t offset = 0; offset < 16; ++offset) {
+                    char        tested[64], reference[64];
+                    char *const input = tested + offset;
+
+                    memset(input, 'u', prefix);
+                    size_t digits = combination;
+                    for (size_t i = 0; i < length; ++i) {
+                        input[prefix + i] = alphabet[digits % sizeof(alphabet)];
+                        digits /= sizeof(alphabet);
+                    }
+                    input[prefix + length] = '\0';
+                    strcpy(reference, input);
+
+                    const int expected =
+                        __microbenchmarks_email_reference(reference, email, domain);
+                    if (email_validate_string_const(input) != expected) {
+                        fprintf(stderr,
+                                "email_validate_string(\"%s\") should return %d!\n",
+                                input,
+                                expected);
+                        goto DEFER_2;
+                    }
+                }
+            }
+        }
+    }
+
+    retval = 0;
+DEFER_2:
+    fixed_n_delimiter_parser_grammar_free(email);
+DEFER_1:
+    fixed_n_delimiter_parser_grammar_free(domain);
+    return retval;
+}
+
+/**
+ * @brief   Compares ::date_overlap_weighted_sum with counting the days of every interval in the
+ *          window, one by one.
+ * @details Every number of intervals up to a few SSE2 registers is tested, so that the intervals
+ *          left over after the vectorized loop are tested too, with windows at every offset from
+ *          the intervals (including empty windows).
+ *
+ * @retval 0 Both implementations agree.
+ * @retval 1 Mismatch (reported to `stderr`).
+ */
+int __microbenchmarks_check_date_overlap(void) {
+    date_t   begin[16], end[16];
+    uint16_t price[16];
+    __microbenchmarks_intervals(16, begin, end, price);
+    end[3] = begin[3] - 1; /* Empty interval */
+
+    for (size_t n = 0; n <= 16; ++n) {
+        for (date_t first = DATE_CURRENT - DATE_DAYS_PER_YEAR; first <= DATE_CURRENT; first += 7) {
+            for (date_t length = 0; length < 40; length += 3) {
+                const date_t last = first + length - 1; /* Empty when length is 0 */
+
+                uint64_t expected = 0, days = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    for (date_t day = begin[i]; day < end[i]; ++day) {
+                        if (day >= first && day <= last) {
+                            expected += price[i];
+                            days++;
+                        }
+                    }
+                }
+
+                if (date_overlap_weighted_sum(n, begin, end, price, first, last) != expected ||
+                    date_overlap_weighted_sum(n, begin, end, NULL, first, last) != days) {
+                    fprintf(stderr,
+                            "date_overlap_weighted_sum mismatch for %zu intervals!\n",
+                            n);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @struct microbenchmarks_tokens_t
+ * @brief  Tokens read by ::__microbenchmarks_record_token.
+ *
+ * @var microbenchmarks_tokens_t::buffer
+ *     @brief Concatenation of all tokens, each followed by a `'|'`.
+ * @var microbenchmarks_tokens_t::length
+ *     @brief Number of characters in ::microbenchmarks_tokens_t::buffer.
+ */
+typedef struct {
+    char   buffer[256];
+    size_t length;
+} microbenchmarks_tokens_t;
+
+/**
+ * @brief Callback for ::__microbenchmarks_check_fixed_n_delimiter_parser that stores every token.
+ * @param user_data A ::microbenchmarks_tokens_t.
+ */
+int __microbenchmarks_record_token(void *user_data, char *token, size_t ntoken) {
+    (void) ntoken;
+    microbenchmarks_tokens_t *const tokens = user_data;
+    const size_t                    length = strlen(token);
+
+    memcpy(tokens->buffer + tokens->length, token, length);
+    tokens->length += length;
+    tokens->buffer[tokens->length++] = '|';
+    return 0;
+}
+
+/**
+ * @brief   Compares every tokenizer of ::fixed_n_delimiter_parser_parse_string the current CPU
+ *          supports with the scalar one.
+ * @details Pseudo-random strings of commas and letters, up to a few AVX2 registers long, are split
+ *          starting at every position inside a 32-byte block, by grammars with different numbers
+ *          of tokens, so that strings end before, at, and after the last expected token.
+ *
+ * @retval 0 All tokenizers agree.
+ * @retval 1 Mismatch (reported to `stderr`) or allocation failure.
+ */
+int __microbenchmarks_check_fixed_n_delimiter_parser(void) {
+    const cpu_features_t kernels[2] = {CPU_FEATURE_SSE2, CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2};
+    const size_t         ntokens[4] = {1, 2, 5, 8};
+
+    const fixed_n_delimiter_parser_iter_callback_t callbacks[8] = {
+        __microbenchmarks_record_token,
+        __microbenchmarks_record_token,
+        __microbenchmarks_record_token,
+        __microbenchmarks_record_token,
+        __microbenchmarks_record_token,
+        __microbenchmarks_record_token,
+        __microbenchmarks_record_token,
+        __microbenchmarks_record_token};
+
+    int                                 retval = 1;
+    fixed_n_delimiter_parser_grammar_t *grammars[4];
+    size_t                              ngrammars = 0;
+    for (; ngrammars < 4; ++ngrammars) {
+        grammars[ngrammars] =
+            fixed_n_delimiter_parser_grammar_new(',', ntokens[ngrammars], callbacks);
+        if (!grammars[ngrammars])
+            goto DEFER_1;
+    }
+
+    uint32_t seed = 1;
+    for (size_t length = 0; length < 100; ++length) {
+        for (size_t pattern = 0; pattern < 16; ++pattern) {
+            for (size_t offset = 0; offset < 32; ++offset) {
+                char        buffer[160] __attribute__((aligned(32)));
+                char *const input = buffer + offset;
+
+                /* Patterns go from many to few delimiters */
+                for (size_t i = 0; i < length; ++i) {
+                    seed     = seed * 1103515245 + 12345;
+                    input[i] = (seed >> 16) % (pattern % 4 + 2) ? 'a' : ',';
+                }
+                input[length] = '\0';
+
+                for (size_t g = 0; g < ngrammars; ++g) {
+                    microbenchmarks_tokens_t expected = {.length = 0};
+                    fixed_n_delimiter_parser_select_kernel(0);
+                    const int expected_retval =
+                        fixed_n_delimiter_parser_parse_string(input, grammars[g], &expected);
+
+                    for (size_t k = 0; k < 2; ++k) {
+                        if (fixed_n_delimiter_parser_select_kernel(kernels[k]) != kernels[k])
+                            continue; /* Not supported by this CPU */
+
+                        microbenchmarks_tokens_t tested = {.length = 0};
+                        if (fixed_n_delimiter_parser_parse_string(input, grammars[g], &tested) !=
+                                expected_retval ||
+                            tested.length != expected.length ||
+                            memcmp(tested.buffer, expected.buffer, expected.length)) {
+                            fprintf(stderr,
+                                    "Tokenizer with features 0x%x disagrees on \"%s\"!\n",
+                                    kernels[k],
+                                    input);
+                            goto DEFER_2;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    retval = 0;
+DEFER_2:
+    fixed_n_delimiter_parser_select_kernel(cpu_features_get());
+DEFER_1:
+    for (size_t g = 0; g < ngrammars; ++g)
+        fixed_n_delimiter_parser_grammar_free(grammars[g]);
+    return retval;
+}
+
+/**
+ * @brief   Compares ::sex_from_string and ::account_status_from_string with `strcmp` and
+ *          `strcasecmp`, which they used to be implemented with.
+ * @details Every valid value is tested with each character replaced by every other one, and with
+ *          all combinations of upper and lower case letters.
+ *
+ * @retval 0 All implementations agree.
+ * @retval 1 Mismatch (reported to `stderr`).
+ */
+int __microbenchmarks_check_enums(void) {
+    const char *const values[4] = {"M", "F", "active", "inactive"};
+    for (size_t value = 0; value < 4; ++value) {
+        const size_t length = strlen(values[value]);
+
+        for (size_t i = 0; i <= length; ++i) {
+            for (int c = 0; c < 256; ++c) {
+                char input[16];
+                strcpy(input, values[value]);
+                input[i] = (char) c;
+                if (i == length)
+                    input[i + 1] = '\0';
+
+                sex_t            sex;
+                account_status_t status;
+                const int sex_expected    = strcmp(input, "M") && strcmp(input, "F");
+                const int status_expected = strcasecmp(input, "active") &&
+                                            strcasecmp(input, "inactive");
+
+                if ((sex_from_string(&sex, input) != 0) != sex_expected ||
+                    (account_status_from_string(&status, input) != 0) != status_expected) {
+                    fprintf(stderr, "Mismatch when parsing \"%s\"!\n", input);
+                    return 1;
+                }
+            }
+        }
+
+        for (unsigned int mask = 0; mask < (1u << length); ++mask) {
+            char input[16];
+            for (size_t i = 0; i < length; ++i)
+                input[i] = mask & (1u << i) ? values[value][i] ^ 0x20 : values[value][i];
+            input[length] = '\0';
+
+            account_status_t status;
+            const int        expected =
+                strcasecmp(input, "active") && strcasecmp(input, "inactive");
+            if ((account_status_from_string(&status, input) != 0) != expected) {
+                fprintf(stderr, "Mismatch when parsing \"%s\"!\n", input);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @struct microbenchmarks_entry_t
+ * @brief  A benchmark and its name.
+ *
+ * @var microbenchmarks_entry_t::name
+ *     @brief Name of the benchmark, printed in the results and matched against
+ *            ::microbenchmarks_options_t::filter.
+ * @var microbenchmarks_entry_t::run
+ *     @brief Method that runs the benchmark once.
+ */
+typedef struct {
+    const char                 *name;
+    microbenchmarks_benchmark_t run;
+} microbenchmarks_entry_t;
+
+/** @brief All benchmarks, in the order they're run. */
+const microbenchmarks_entry_t microbenchmarks_entries[] = {
+    {"pool_alloc_item",                 __microbenchmarks_pool_alloc_item                },
+    {"string_pool_put",                 __microbenchmarks_string_pool_put                },
+    {"string_pool_no_duplicates_put",   __microbenchmarks_string_pool_no_duplicates_put  },
+    {"g_const_key_hash_table_insert",   __microbenchmarks_g_const_key_hash_table_insert  },
+    {"g_const_key_hash_table_lookup",   __microbenchmarks_g_const_key_hash_table_lookup  },
+    {"string_hash_table_insert",        __microbenchmarks_string_hash_table_insert       },
+    {"string_hash_table_lookup",        __microbenchmarks_string_hash_table_lookup       },
+    {"id_hash_table_insert",            __microbenchmarks_id_hash_table_insert           },
+    {"id_hash_table_lookup",            __microbenchmarks_id_hash_table_lookup           },
+    {"fixed_n_delimiter_parser",        __microbenchmarks_fixed_n_delimiter_parser       },
+    {"date_from_string",                __microbenchmarks_date_from_string               },
+    {"email_validate_string",           __microbenchmarks_email_validate_string          },
+    {"date_overlap_weighted_sum",       __microbenchmarks_date_overlap_weighted_sum      },
+    {"accumulators_1_thread",           __microbenchmarks_accumulators_1_thread          },
+    {"accumulators_packed_2_threads",   __microbenchmarks_accumulators_packed_2_threads  },
+    {"accumulators_packed_4_threads",   __microbenchmarks_accumulators_packed_4_threads  },
+    {"accumulators_padded_2_threads",   __microbenchmarks_accumulators_padded_2_threads  },
+    {"accumulators_padded_4_threads",   __microbenchmarks_accumulators_padded_4_threads  },
+};
+
+/** @brief Number of elements in ::microbenchmarks_entries. */
+#define MICROBENCHMARKS_COUNT (sizeof(microbenchmarks_entries) / sizeof(*microbenchmarks_entries))
+
+/**
+ * @brief Runs a benchmark at a given size, as many times as requested.
+ *
+ * @param options       Configuration of the run.
+ * @param entry         Benchmark to be run.
+ * @param n             Number of operations in each run of the benchmark.
+ * @param memory_source File from where memory usage is read.
+ * @param ns_per_op     Where to output the best time per operation (in nanoseconds) to.
+ * @param bytes_per_op  Where to output the memory per operation (in bytes) to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation or measurement failure.
+ */
+int __microbenchmarks_measure(const microbenchmarks_options_t *options,
+                              const microbenchmarks_entry_t   *entry,
+                              size_t                           n,
+                              int                              memory_source,
+                              double                          *ns_per_op,
+                              double                          *bytes_per_op) {
+    const size_t batches = n < MICROBENCHMARKS_MIN_OPERATIONS ? MICROBENCHMARKS_MIN_OPERATIONS / n
+                                                              : 1;
+
+    microbenchmarks_timer_t timer = {.memory_source = memory_source, .memory = 0, .sink = 0};
+    uint64_t                best  = UINT64_MAX;
+    for (size_t r = 0; r < options->repetitions; ++r) {
+        timer.elapsed = 0;
+        for (size_t b = 0; b < batches; ++b) {
+            timer.measure_memory = r == 0 && b == 0;
+            if (entry->run(&timer, n))
+                return 1;
+        }
+
+        if (timer.elapsed < best)
+            best = timer.elapsed;
+    }
+
+    *ns_per_op    = best * 1000.0 / ((double) batches * n);
+    *bytes_per_op = timer.memory * 1024.0 / n;
+    return 0;
+}
+
+int microbenchmarks_run(const microbenchmarks_options_t *options) {
+    size_t sizes[20], nsizes = 0;
+    for (size_t size = MICROBENCHMARKS_MIN_SIZE; size <= options->max_size && nsizes < 20;
+         size *= 10)
+        sizes[nsizes++] = size;
+    if (!nsizes)
+        sizes[nsizes++] = options->max_size;
+
+    /* Don't measure optimized validators that disagree with their reference implementations */
+    if (__microbenchmarks_check_email() || __microbenchmarks_check_enums() ||
+        __microbenchmarks_check_date_overlap() ||
+        __microbenchmarks_check_fixed_n_delimiter_parser()) {
+        fputs("Validators don't match their reference implementations!\n", stderr);
+        return 1;
+    }
+
+    size_t nrows = 0;
+    for (size_t i = 0; i < MICROBENCHMARKS_COUNT; ++i)
+        if (!options->filter || strstr(microbenchmarks_entries[i].name, options->filter))
+            nrows += nsizes;
+
+    if (!nrows) {
+        fprintf(stderr, "No benchmarks match \"%s\"!\n", options->filter);
+        return 1;
+    }
+
+    const int memory_source = performance_event_open_memory_source();
+    if (memory_source < 0) {
+        fputs("Failed to open memory usage source!\n", stderr);
+        return 1;
+    }
+
+    int            retval = 1;
+    table_t *const table  = table_create(4, nrows + 1);
+    if (!table) {
+        fputs("Failed to allocate results table!\n", stderr);
+        goto DEFER_1;
+    }
+
+    table_insert_format(table, 0, 0, "Benchmark");
+    table_insert_format(table, 1, 0, "Size");
+    table_insert_format(table, 2, 0, "Time (ns/op)");
+    table_insert_format(table, 3, 0, "Memory (bytes/op)");
+
+    size_t row = 1;
+    for (size_t i = 0; i < MICROBENCHMARKS_COUNT; ++i) {
+        const microbenchmarks_entry_t *const entry = &microbenchmarks_entries[i];
+        if (options->filter && !strstr(entry->name, options->filter))
+            continue;
+
+        for (size_t j = 0; j < nsizes; ++j) {
+            double ns_per_op, bytes_per_op;
+            if (__microbenchmarks_measure(options,
+                                          entry,
+                                          sizes[j],
+                                          memory_source,
+                                          &ns_per_op,
+                                          &bytes_per_op)) {
+                fprintf(stderr, "Failed to run benchmark \"%s\"!\n", entry->name);
+                goto DEFER_2;
+            }
+
+            table_insert_format(table, 0, row, "%s", entry->name);
+            table_insert_format(table, 1, row, "%zu", sizes[j]);
+            table_insert_format(table, 2, row, "%.2lf", ns_per_op);
+            table_insert_format(table, 3, row, "%.2lf", bytes_per_op);
+            row++;
+        }
+    }
+
+    table_draw(stdout, table);
+    retval = 0;
+
+DEFER_2:
+    table_free(table);
+DEFER_1:
+    close(memory_source);
+    return retval;
+}
@@ -23,10 +23,13 @@
  */
 
 #include <ctype.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "testing/performance_event.h"
 #include "utils/int_utils.h"
@@ -46,10 +49,16 @@
  *     @details If ::performance_event_stop_measuring has been called, this is the difference
  *              between memory in the beginning and in the end of the task, clamped to zero.
  *              Otherwise, it's the memory used before starting to run the task.
+ * @var performance_event::mode
+ *     @brief How this event is measured.
+ * @var performance_event::memory_source
+ *     @brief File where memory usage is read from, in ::PERFORMANCE_EVENT_MODE_LIGHTWEIGHT.
  */
 struct performance_event {
-    uint64_t elapsed_time;
-    size_t   used_memory;
+    uint64_t                 elapsed_time;
+    size_t                   used_memory;
+    performance_event_mode_t mode;
+    int                      memory_source;
 };
 
 /**
@@ -119,6 +128,61 @@ int __performance_event_get_memory_usage(size_t *output) {
     return retval;
 }
 
+int performance_event_open_memory_source(void) {
+    return open("/proc/self/statm", O_RDONLY);
+}
+
+/**
+ * @brief   Reads the current memory usage from `/proc/self/statm`.
+ * @details The first field of the file is the virtual memory size, in pages.
+ *
+ * @param memory_source File descriptor returned by ::performance_event_open_memory_source, or
+ *                      `-1`, for `0` to be always output.
+ * @param output        Where to output the memory usage (in KiB), only on success.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure.
+ */
+int __performance_event_get_memory_usage_lightweight(int memory_source, size_t *output) {
+    if (memory_source < 0) {
+        *output = 0;
+        return 0;
+    }
+
+    char          buffer[64];
+    const ssize_t nread = pread(memory_source, buffer, sizeof(buffer) - 1, 0);
+    if (nread <= 0)
+        return 1;
+    buffer[nread] = '\0';
+
+    char *const end = strchr(buffer, ' ');
+    if (end)
+        *end = '\0';
+
+    uint64_t pages;
+    if (int_utils_parse_positive(&pages, buffer))
+        return 1;
+
+    *output = pages * (sysconf(_SC_PAGESIZE) / 1024);
+    return 0;
+}
+
+/**
+ * @brief  Gets the time elapsed since an arbitrary point, in microseconds.
+ * @param  output Where to output the time to, only on success.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure.
+ */
+int __performance_event_get_monotonic_time(uint64_t *output) {
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now))
+        return 1;
+
+    *output = (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    return 0;
+}
+
 performance_event_t *performance_event_start_measuring(void) {
     performance_event_t *const perf = malloc(sizeof(performance_event_t));
     if (!perf)
@@ -137,6 +201,25 @@ performance_event_t *performance_event_start_measuring(void) {
     }
     perf->elapsed_time = __performance_event_add_user_system_time(usage.ru_utime, usage.ru_stime);
 
+    perf->mode          = PERFORMANCE_EVENT_MODE_RUSAGE;
+    perf->memory_source = -1;
+    return perf;
+}
+
+performance_event_t *performance_event_start_measuring_lightweight(int memory_source) {
+    performance_event_t *const perf = malloc(sizeof(performance_event_t));
+    if (!perf)
+        return NULL;
+
+    if (__performance_event_get_memory_usage_lightweight(memory_source, &perf->used_memory) ||
+        __performance_event_get_monotonic_time(&perf->elapsed_time)) {
+
+        free(perf);
+        return NULL;
+    }
+
+    perf->mode          = PERFORMANCE_EVENT_MODE_LIGHTWEIGHT;
+    perf->memory_source = memory_source;
     return perf;
 }
 
@@ -150,25 +233,30 @@ performance_event_t *performance_event_clone(const performance_event_t *perf) {
 }
 
 int performance_event_stop_measuring(performance_event_t *perf) {
-    struct rusage usage;
-    const int     insuccess = getrusage(RUSAGE_SELF, &usage);
-    if (insuccess) {
-        perf->elapsed_time = 0;
-        perf->used_memory  = 0;
-        return 1;
-    }
+    uint64_t elapsed;
+    size_t   new_memory;
 
-    const uint64_t elapsed =
-        __performance_event_add_user_system_time(usage.ru_utime, usage.ru_stime);
-    perf->elapsed_time = elapsed - perf->elapsed_time;
+    if (perf->mode == PERFORMANCE_EVENT_MODE_LIGHTWEIGHT) {
+        if (__performance_event_get_monotonic_time(&elapsed) ||
+            __performance_event_get_memory_usage_lightweight(perf->memory_source, &new_memory)) {
 
-    size_t new_memory;
-    if (__performance_event_get_memory_usage(&new_memory)) {
-        perf->elapsed_time = 0;
-        perf->used_memory  = 0;
-        return 1;
+            perf->elapsed_time = 0;
+            perf->used_memory  = 0;
+            return 1;
+        }
+    } else {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) || __performance_event_get_memory_usage(&new_memory)) {
+            perf->elapsed_time = 0;
+            perf->used_memory  = 0;
+            return 1;
+        }
+
+        elapsed = __performance_event_add_user_system_time(usage.ru_utime, usage.ru_stime);
     }
 
+    perf->elapsed_time = elapsed - perf->elapsed_time;
+
     if (perf->used_memory > new_memory)
         perf->used_memory = 0;
     else
@@ -177,6 +265,10 @@ int performance_event_stop_measuring(performance_event_t *perf) {
     return 0;
 }
 
+performance_event_mode_t performance_event_get_mode(const performance_event_t *perf) {
+    return perf->mode;
+}
+
 uint64_t performance_event_get_elapsed_time(const performance_event_t *perf) {
     return perf->elapsed_time;
 }
@@ -23,12 +23,20 @@
  */
 
 #include <glib.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/resource.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 #include "queries/query_type_list.h"
+#include "testing/hardware_counters.h"
+#include "testing/latency_histogram.h"
 #include "testing/performance_metrics.h"
+#include "testing/sampling_profiler.h"
 
 /**
  * @struct performance_metrics
@@ -43,37 +51,151 @@
  * @var performance_metrics::query_events
  *     @brief   Performance information about individual query execution.
  *     @details Hash tables that associate a query's line number in a file (integer) to a
- *              ::performance_event_t.
+ *              ::performance_event_t. These are left empty when
+ *              ::performance_metrics::keep_query_events is `0`.
+ * @var performance_metrics::query_latencies
+ *     @brief Histograms of the execution times of all queries, for each query type.
+ * @var performance_metrics::keep_query_events
+ *     @brief Whether to store the event of every query in ::performance_metrics::query_events.
+ * @var performance_metrics::current_query_event
+ *     @brief   Event of the query being executed, when ::performance_metrics::keep_query_events is
+ *              `0`.
+ *     @details Only one is needed, as measurements of different queries can't overlap.
  * @var performance_metrics::program_total_time
  *     @brief Time (in microseconds) that the whole program took to be executed.
  * @var performance_metrics::program_total_mem
  *     @brief Peak memory usage (in KiB) of the program.
+ * @var performance_metrics::counters
+ *     @brief   Open hardware counters, or `NULL` if these aren't being measured.
+ *     @details Always `NULL` in clones, that can't be used to measure new events.
+ * @var performance_metrics::counters_enabled
+ *     @brief Whether hardware counter values are available.
+ * @var performance_metrics::counters_start
+ *     @brief   Values of the hardware counters at the start of the current measurement.
+ *     @details Only one is needed, as measurements of different tasks can't overlap.
+ * @var performance_metrics::dataset_counters
+ *     @brief Hardware counter values for each step of dataset loading.
+ * @var performance_metrics::dataset_phases
+ *     @brief   Time spent in each phase of parsing every file of the dataset.
+ *     @details Only valid where ::performance_metrics::dataset_phases_measured is `1`.
+ * @var performance_metrics::dataset_phases_measured
+ *     @brief Whether ::performance_metrics_set_dataset_phases has been called for each file.
+ * @var performance_metrics::statistical_counters
+ *     @brief Hardware counter values for query statistical data generation.
+ * @var performance_metrics::query_counters
+ *     @brief Hardware counter values for the execution of all queries of each type (summed).
+ * @var performance_metrics::structure_memory
+ *     @brief   Bytes used by each part of the database.
+ *     @details Only valid if ::performance_metrics::structures_measured is `1`.
+ * @var performance_metrics::structure_strings_memory
+ *     @brief Bytes used by strings in each part of the database (included in
+ *            ::performance_metrics::structure_memory).
+ * @var performance_metrics::structures_measured
+ *     @brief Whether ::performance_metrics_measure_database_memory has been called.
+ * @var performance_metrics::statistical_memory
+ *     @brief Heap growth (in bytes) while generating the statistical data of each query type.
+ *            `SIZE_MAX` when not measured.
+ * @var performance_metrics::heap_start
+ *     @brief   Heap usage at the start of the current statistical data measurement, or `SIZE_MAX`
+ *              if it couldn't be measured.
+ *     @details Only one is needed, as measurements of different tasks can't overlap.
+ * @var performance_metrics::profiler
+ *     @brief   Sampling profiler whose samples are tagged with the query being processed, or
+ *              `NULL`. Not owned by the metrics.
+ *     @details Always `NULL` in clones.
+ * @var performance_metrics::allocation_profiler
+ *     @brief   Allocation profiler whose phase is set to the task being measured, or `NULL`. Not
+ *              owned by the metrics.
+ *     @details Always `NULL` in clones.
+ * @var performance_metrics::allocations
+ *     @brief   Heap allocations made in each phase (see ::performance_metrics_allocation_phase_t).
+ *     @details Only valid if ::performance_metrics::allocations_measured is `1`.
+ * @var performance_metrics::allocations_measured
+ *     @brief Whether an allocation profiler was attached and detached.
+ * @var performance_metrics::mode
+ *     @brief How all events are measured.
+ * @var performance_metrics::memory_source
+ *     @brief   File used to measure memory usage, in ::PERFORMANCE_EVENT_MODE_LIGHTWEIGHT.
+ *     @details Opened once, so that it isn't reopened for every measured query. `-1` in
+ *              ::PERFORMANCE_EVENT_MODE_RUSAGE.
  */
 struct performance_metrics {
     performance_metrics_dataset_step_t current_dataset_step;
     performance_event_t               *dataset_events[PERFORMANCE_METRICS_DATASET_STEP_DONE];
     performance_event_t               *statistical_events[QUERY_TYPE_LIST_COUNT];
     GHashTable                        *query_events[QUERY_TYPE_LIST_COUNT];
+    latency_histogram_t               *query_latencies[QUERY_TYPE_LIST_COUNT];
+    int                                keep_query_events;
+    performance_event_t               *current_query_event;
 
     uint64_t program_total_time;
     size_t   program_total_mem;
+
+    hardware_counters_t       *counters;
+    int                        counters_enabled;
+    hardware_counters_values_t counters_start;
+    hardware_counters_values_t dataset_counters[PERFORMANCE_METRICS_DATASET_STEP_DONE];
+    hardware_counters_values_t statistical_counters[QUERY_TYPE_LIST_COUNT];
+    hardware_counters_values_t query_counters[QUERY_TYPE_LIST_COUNT];
+
+    dataset_parser_phases_t dataset_phases[PERFORMANCE_METRICS_DATASET_FILE_COUNT];
+    int                     dataset_phases_measured[PERFORMANCE_METRICS_DATASET_FILE_COUNT];
+
+    size_t structure_memory[PERFORMANCE_METRICS_STRUCTURE_COUNT];
+    size_t structure_strings_memory[PERFORMANCE_METRICS_STRUCTURE_COUNT];
+    int    structures_measured;
+    size_t statistical_memory[QUERY_TYPE_LIST_COUNT];
+    size_t heap_start;
+
+    sampling_profiler_t *profiler;
+
+    allocation_profiler_t       *allocation_profiler;
+    allocation_profiler_counts_t allocations[PERFORMANCE_METRICS_ALLOCATION_PHASES];
+    int                          allocations_measured;
+
+    performance_event_mode_t mode;
+    int                      memory_source;
 };
 
 performance_metrics_t *performance_metrics_create(void) {
+    return performance_metrics_create_with_mode(PERFORMANCE_EVENT_MODE_RUSAGE);
+}
+
+performance_metrics_t *performance_metrics_create_with_mode(performance_event_mode_t mode) {
     performance_metrics_t *const ret = malloc(sizeof(performance_metrics_t));
     if (!ret)
         return NULL;
+    memset(ret, 0, sizeof(performance_metrics_t)); /* To ease cleanup on allocation failure */
+
+    ret->mode          = mode;
+    ret->memory_source = -1;
+    if (mode == PERFORMANCE_EVENT_MODE_LIGHTWEIGHT) {
+        ret->memory_source = performance_event_open_memory_source();
+        if (ret->memory_source < 0) {
+            free(ret);
+            return NULL;
+        }
+    }
 
     ret->current_dataset_step = PERFORMANCE_METRICS_DATASET_STEP_NOT_STARTED;
     for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_STEP_DONE; ++i)
         ret->dataset_events[i] = NULL;
 
+    ret->keep_query_events   = 1;
+    ret->current_query_event = NULL;
+    ret->heap_start          = SIZE_MAX;
     for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
         ret->statistical_events[i] = NULL;
+        ret->statistical_memory[i] = SIZE_MAX;
         ret->query_events[i]       = g_hash_table_new_full(g_direct_hash,
                                                      g_direct_equal,
                                                      NULL,
                                                      (GDestroyNotify) performance_event_free);
+        ret->query_latencies[i]    = latency_histogram_create();
+        if (!ret->query_latencies[i]) {
+            performance_metrics_free(ret);
+            return NULL;
+        }
     }
 
     ret->program_total_time = 0;
@@ -88,6 +210,16 @@ performance_metrics_t *performance_metrics_clone(const performance_metrics_t *me
         return NULL;
     memset(ret, 0, sizeof(performance_metrics_t)); /* To ease cleanup on allocation failure */
 
+    ret->mode          = metrics->mode;
+    ret->memory_source = -1;
+    if (metrics->memory_source >= 0) {
+        ret->memory_source = dup(metrics->memory_source);
+        if (ret->memory_source < 0) {
+            performance_metrics_free(ret);
+            return NULL;
+        }
+    }
+
     ret->current_dataset_step = metrics->current_dataset_step;
     for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_STEP_DONE; ++i) {
         if (metrics->dataset_events[i]) {
@@ -127,14 +259,139 @@ performance_metrics_t *performance_metrics_clone(const performance_metrics_t *me
 
             g_hash_table_insert(ret->query_events[i], key, event_clone);
         }
+
+        ret->query_latencies[i] = latency_histogram_clone(metrics->query_latencies[i]);
+        if (!ret->query_latencies[i]) {
+            performance_metrics_free(ret);
+            return NULL;
+        }
+    }
+
+    ret->keep_query_events = metrics->keep_query_events;
+    if (metrics->current_query_event) {
+        ret->current_query_event = performance_event_clone(metrics->current_query_event);
+        if (!ret->current_query_event) {
+            performance_metrics_free(ret);
+            return NULL;
+        }
     }
 
     ret->program_total_time = metrics->program_total_time;
     ret->program_total_mem  = metrics->program_total_mem;
 
+    /* Counters themselves aren't cloned, only their values */
+    ret->counters_enabled = metrics->counters_enabled;
+    memcpy(ret->dataset_counters, metrics->dataset_counters, sizeof(metrics->dataset_counters));
+    memcpy(ret->dataset_phases, metrics->dataset_phases, sizeof(metrics->dataset_phases));
+    memcpy(ret->allocations, metrics->allocations, sizeof(metrics->allocations));
+    ret->allocations_measured = metrics->allocations_measured;
+    memcpy(ret->dataset_phases_measured,
+           metrics->dataset_phases_measured,
+           sizeof(metrics->dataset_phases_measured));
+    memcpy(ret->statistical_counters,
+           metrics->statistical_counters,
+           sizeof(metrics->statistical_counters));
+    memcpy(ret->query_counters, metrics->query_counters, sizeof(metrics->query_counters));
+
+    memcpy(ret->structure_memory, metrics->structure_memory, sizeof(metrics->structure_memory));
+    memcpy(ret->structure_strings_memory,
+           metrics->structure_strings_memory,
+           sizeof(metrics->structure_strings_memory));
+    ret->structures_measured = metrics->structures_measured;
+    memcpy(ret->statistical_memory,
+           metrics->statistical_memory,
+           sizeof(metrics->statistical_memory));
+    ret->heap_start = metrics->heap_start;
+
     return ret;
 }
 
+int performance_metrics_enable_hardware_counters(performance_metrics_t *metrics) {
+    if (metrics->counters)
+        return 0;
+
+    metrics->counters = hardware_counters_open();
+    if (!metrics->counters)
+        return 1;
+
+    metrics->counters_enabled = 1;
+    return 0;
+}
+
+/**
+ * @brief Reads hardware counters at the start of a measurement, if they're being measured.
+ * @param metrics Metrics where the counters are.
+ */
+void __performance_metrics_start_counters(performance_metrics_t *metrics) {
+    if (metrics->counters && hardware_counters_read(metrics->counters, &metrics->counters_start))
+        fputs("Failed to read hardware counters!\n", stderr);
+}
+
+/**
+ * @brief Reads hardware counters at the end of a measurement, if they're being measured.
+ *
+ * @param metrics Metrics where the counters are.
+ * @param output  Where to add the difference in counter values since
+ *                ::__performance_metrics_start_counters to.
+ */
+void __performance_metrics_stop_counters(performance_metrics_t      *metrics,
+                                         hardware_counters_values_t *output) {
+    if (!metrics->counters)
+        return;
+
+    hardware_counters_values_t now;
+    if (hardware_counters_read(metrics->counters, &now)) {
+        fputs("Failed to read hardware counters!\n", stderr);
+        return;
+    }
+
+    hardware_counters_values_subtract(&now, &metrics->counters_start);
+    hardware_counters_values_add(output, &now);
+}
+
+/**
+ * @brief   Gets the number of bytes currently allocated in the heap.
+ * @details Only available with the GNU C library. Includes blocks that `malloc` placed in their own
+ *          memory mappings.
+ *
+ * @return The number of bytes in use in the heap, or `SIZE_MAX` if that can't be measured.
+ */
+size_t __performance_metrics_get_heap_usage(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return SIZE_MAX;
+#endif
+}
+
+/**
+ * @brief  Starts measuring a performance event, in the mode chosen for a set of metrics.
+ * @param  metrics Metrics the event will belong to.
+ * @return A new performance event, or `NULL` on failure.
+ */
+performance_event_t *__performance_metrics_start_event(const performance_metrics_t *metrics) {
+    if (metrics->mode == PERFORMANCE_EVENT_MODE_LIGHTWEIGHT)
+        return performance_event_start_measuring_lightweight(metrics->memory_source);
+    return performance_event_start_measuring();
+}
+
+/**
+ * @brief Identifiers of the phases of an allocation profiler attached to performance metrics.
+ */
+typedef enum {
+    PERFORMANCE_METRICS_ALLOCATION_PHASE_OTHER   = 0, /**< @brief Outside of other phases. */
+    PERFORMANCE_METRICS_ALLOCATION_PHASE_DATASET = 1, /**< @brief First dataset loading step. */
+
+    /** @brief Statistical data generation of the first query type. */
+    PERFORMANCE_METRICS_ALLOCATION_PHASE_STATISTICS =
+        PERFORMANCE_METRICS_ALLOCATION_PHASE_DATASET + PERFORMANCE_METRICS_DATASET_STEP_DONE,
+
+    /** @brief Execution of queries of the first query type. */
+    PERFORMANCE_METRICS_ALLOCATION_PHASE_EXECUTION =
+        PERFORMANCE_METRICS_ALLOCATION_PHASE_STATISTICS + QUERY_TYPE_LIST_COUNT,
+} performance_metrics_allocation_phase_t;
+
 /**
  * @brief Prints a dataset performance measurement error to `stderr`.
  * @param step Step of dataset loading the error happened in.
@@ -156,6 +413,9 @@ void __performance_metrics_print_dataset_measurement_error(
         case PERFORMANCE_METRICS_DATASET_STEP_RESERVATIONS:
             where = "reservations.csv";
             break;
+        case PERFORMANCE_METRICS_DATASET_STEP_INDEXES:
+            where = "indices";
+            break;
         default:
             where = "?.csv";
             break;
@@ -176,17 +436,37 @@ void performance_metrics_measure_dataset(performance_metrics_t             *metr
                 metrics->dataset_events[metrics->current_dataset_step]))
             __performance_metrics_print_dataset_measurement_error(metrics->current_dataset_step);
     }
+    if (metrics->current_dataset_step != PERFORMANCE_METRICS_DATASET_STEP_NOT_STARTED)
+        __performance_metrics_stop_counters(
+            metrics,
+            &metrics->dataset_counters[metrics->current_dataset_step]);
 
     /* Start current measurement */
-    if (step == PERFORMANCE_METRICS_DATASET_STEP_DONE)
+    if (step == PERFORMANCE_METRICS_DATASET_STEP_DONE) {
+        allocation_profiler_set_phase(metrics->allocation_profiler,
+                                      PERFORMANCE_METRICS_ALLOCATION_PHASE_OTHER);
         return;
+    }
 
-    performance_event_t *const perf = performance_event_start_measuring();
+    performance_event_t *const perf = __performance_metrics_start_event(metrics);
     if (!perf)
         __performance_metrics_print_dataset_measurement_error(step);
 
     metrics->current_dataset_step = step;
     metrics->dataset_events[step] = perf;
+    __performance_metrics_start_counters(metrics);
+    allocation_profiler_set_phase(metrics->allocation_profiler,
+                                  PERFORMANCE_METRICS_ALLOCATION_PHASE_DATASET + step);
+}
+
+void performance_metrics_set_dataset_phases(performance_metrics_t             *metrics,
+                                            performance_metrics_dataset_step_t step,
+                                            const dataset_parser_phases_t     *phases) {
+    if (!metrics || step >= PERFORMANCE_METRICS_DATASET_FILE_COUNT)
+        return;
+
+    metrics->dataset_phases[step]          = *phases;
+    metrics->dataset_phases_measured[step] = 1;
 }
 
 void performance_metrics_start_measuring_query_statistics(performance_metrics_t *metrics,
@@ -197,13 +477,19 @@ void performance_metrics_start_measuring_query_statistics(performance_metrics_t
     if (metrics->statistical_events[query_type - 1])
         performance_event_free(metrics->statistical_events[query_type - 1]);
 
-    performance_event_t *const perf = performance_event_start_measuring();
+    performance_event_t *const perf = __performance_metrics_start_event(metrics);
     if (!perf)
         fprintf(stderr,
                 "Failed to measure resource usage in query %zu's statistical data generation!\n",
                 query_type);
 
     metrics->statistical_events[query_type - 1] = perf;
+    metrics->statistical_memory[query_type - 1] = SIZE_MAX;
+    metrics->heap_start                         = __performance_metrics_get_heap_usage();
+    __performance_metrics_start_counters(metrics);
+    sampling_profiler_set_tag(metrics->profiler, query_type, 0);
+    allocation_profiler_set_phase(metrics->allocation_profiler,
+                                  PERFORMANCE_METRICS_ALLOCATION_PHASE_STATISTICS + query_type - 1);
 }
 
 void performance_metrics_stop_measuring_query_statistics(performance_metrics_t *metrics,
@@ -211,6 +497,15 @@ void performance_metrics_stop_measuring_query_statistics(performance_metrics_t *
     if (!metrics)
         return;
 
+    allocation_profiler_set_phase(metrics->allocation_profiler,
+                                  PERFORMANCE_METRICS_ALLOCATION_PHASE_OTHER);
+    sampling_profiler_set_tag(metrics->profiler, 0, 0);
+    __performance_metrics_stop_counters(metrics, &metrics->statistical_counters[query_type - 1]);
+
+    const size_t heap_end = __performance_metrics_get_heap_usage();
+    if (metrics->heap_start != SIZE_MAX && heap_end != SIZE_MAX)
+        metrics->statistical_memory[query_type - 1] =
+            heap_end > metrics->heap_start ? heap_end - metrics->heap_start : 0;
     if (!metrics->statistical_events[query_type - 1] ||
         performance_event_stop_measuring(metrics->statistical_events[query_type - 1])) {
 
@@ -220,22 +515,53 @@ void performance_metrics_stop_measuring_query_statistics(performance_metrics_t *
     }
 }
 
+void performance_metrics_set_keep_query_events(performance_metrics_t *metrics, int keep) {
+    metrics->keep_query_events = keep;
+}
+
+void performance_metrics_set_profiler(performance_metrics_t *metrics,
+                                      sampling_profiler_t   *profiler) {
+    metrics->profiler = profiler;
+}
+
+void performance_metrics_set_allocation_profiler(performance_metrics_t *metrics,
+                                                 allocation_profiler_t *profiler) {
+    if (metrics->allocation_profiler) {
+        for (size_t i = 0; i < PERFORMANCE_METRICS_ALLOCATION_PHASES; ++i)
+            allocation_profiler_get_counts(metrics->allocation_profiler,
+                                           i,
+                                           &metrics->allocations[i]);
+        metrics->allocations_measured = 1;
+    }
+    metrics->allocation_profiler = profiler;
+}
+
 void performance_metrics_start_measuring_query_execution(performance_metrics_t *metrics,
                                                          size_t                 query_type,
                                                          size_t                 line_in_file) {
     if (!metrics)
         return;
 
-    performance_event_t *const perf = performance_event_start_measuring();
+    performance_event_t *const perf = __performance_metrics_start_event(metrics);
     if (!perf)
         fprintf(stderr,
                 "Failed to measure resource usage in query %zu's (line %zu) execution!\n",
                 query_type,
                 line_in_file);
 
-    g_hash_table_insert(metrics->query_events[query_type - 1],
-                        GUINT_TO_POINTER(line_in_file),
-                        perf);
+    if (metrics->keep_query_events) {
+        g_hash_table_insert(metrics->query_events[query_type - 1],
+                            GUINT_TO_POINTER(line_in_file),
+                            perf);
+    } else {
+        if (metrics->current_query_event)
+            performance_event_free(metrics->current_query_event);
+        metrics->current_query_event = perf;
+    }
+    __performance_metrics_start_counters(metrics);
+    sampling_profiler_set_tag(metrics->profiler, query_type, line_in_file);
+    allocation_profiler_set_phase(metrics->allocation_profiler,
+                                  PERFORMANCE_METRICS_ALLOCATION_PHASE_EXECUTION + query_type - 1);
 }
 
 void performance_metrics_stop_measuring_query_execution(performance_metrics_t *metrics,
@@ -244,14 +570,57 @@ void performance_metrics_stop_measuring_query_execution(performance_metrics_t *m
     if (!metrics)
         return;
 
+    allocation_profiler_set_phase(metrics->allocation_profiler,
+                                  PERFORMANCE_METRICS_ALLOCATION_PHASE_OTHER);
+    sampling_profiler_set_tag(metrics->profiler, 0, 0);
+    __performance_metrics_stop_counters(metrics, &metrics->query_counters[query_type - 1]);
     performance_event_t *const perf =
-        g_hash_table_lookup(metrics->query_events[query_type - 1], GUINT_TO_POINTER(line_in_file));
+        metrics->keep_query_events
+            ? g_hash_table_lookup(metrics->query_events[query_type - 1],
+                                  GUINT_TO_POINTER(line_in_file))
+            : metrics->current_query_event;
 
-    if (!perf || performance_event_stop_measuring(perf))
+    if (!perf || performance_event_stop_measuring(perf)) {
         fprintf(stderr,
                 "Failed to measure resource usage in query %zu's (line %zu) execution!\n",
                 query_type,
                 line_in_file);
+    } else {
+        latency_histogram_record(metrics->query_latencies[query_type - 1],
+                                 performance_event_get_elapsed_time(perf));
+    }
+
+    if (!metrics->keep_query_events) {
+        if (perf)
+            performance_event_free(perf);
+        metrics->current_query_event = NULL;
+    }
+}
+
+void performance_metrics_measure_database_memory(performance_metrics_t *metrics,
+                                                 const database_t      *database) {
+    if (!metrics)
+        return;
+
+    const user_manager_t *const users = database_get_users(database);
+    metrics->structure_memory[PERFORMANCE_METRICS_STRUCTURE_USERS] =
+        user_manager_get_memory_usage(users);
+    metrics->structure_strings_memory[PERFORMANCE_METRICS_STRUCTURE_USERS] =
+        user_manager_get_strings_memory_usage(users);
+
+    const flight_manager_t *const flights = database_get_flights(database);
+    metrics->structure_memory[PERFORMANCE_METRICS_STRUCTURE_FLIGHTS] =
+        flight_manager_get_memory_usage(flights);
+    metrics->structure_strings_memory[PERFORMANCE_METRICS_STRUCTURE_FLIGHTS] =
+        flight_manager_get_strings_memory_usage(flights);
+
+    const reservation_manager_t *const reservations = database_get_reservations(database);
+    metrics->structure_memory[PERFORMANCE_METRICS_STRUCTURE_RESERVATIONS] =
+        reservation_manager_get_memory_usage(reservations);
+    metrics->structure_strings_memory[PERFORMANCE_METRICS_STRUCTURE_RESERVATIONS] =
+        reservation_manager_get_strings_memory_usage(reservations);
+
+    metrics->structures_measured = 1;
 }
 
 void performance_metrics_measure_whole_program(performance_metrics_t *metrics) {
@@ -283,6 +652,102 @@ const performance_event_t *
     return metrics->statistical_events[query_type - 1];
 }
 
+const dataset_parser_phases_t *
+    performance_metrics_get_dataset_phases(const performance_metrics_t       *metrics,
+                                           performance_metrics_dataset_step_t step) {
+    if (step >= PERFORMANCE_METRICS_DATASET_FILE_COUNT || !metrics->dataset_phases_measured[step])
+        return NULL;
+    return &metrics->dataset_phases[step];
+}
+
+/**
+ * @brief  Gets the heap allocations made in a phase of an allocation profiler.
+ * @param  metrics Performance metrics to get allocation counts from.
+ * @param  phase   Phase to get allocation counts for.
+ * @return The allocations made in @p phase, or `NULL` if they weren't measured.
+ */
+const allocation_profiler_counts_t *
+    __performance_metrics_get_allocations(const performance_metrics_t          *metrics,
+                                          performance_metrics_allocation_phase_t phase) {
+    return metrics->allocations_measured ? &metrics->allocations[phase] : NULL;
+}
+
+const allocation_profiler_counts_t *
+    performance_metrics_get_dataset_allocations(const performance_metrics_t       *metrics,
+                                                performance_metrics_dataset_step_t step) {
+    return __performance_metrics_get_allocations(metrics,
+                                                 PERFORMANCE_METRICS_ALLOCATION_PHASE_DATASET +
+                                                     step);
+}
+
+const allocation_profiler_counts_t *
+    performance_metrics_get_query_statistics_allocations(const performance_metrics_t *metrics,
+                                                         size_t                       query_type) {
+    return __performance_metrics_get_allocations(metrics,
+                                                 PERFORMANCE_METRICS_ALLOCATION_PHASE_STATISTICS +
+                                                     query_type - 1);
+}
+
+const allocation_profiler_counts_t *
+    performance_metrics_get_query_execution_allocations(const performance_metrics_t *metrics,
+                                                        size_t                       query_type) {
+    return __performance_metrics_get_allocations(metrics,
+                                                 PERFORMANCE_METRICS_ALLOCATION_PHASE_EXECUTION +
+                                                     query_type - 1);
+}
+
+const allocation_profiler_counts_t *
+    performance_metrics_get_other_allocations(const performance_metrics_t *metrics) {
+    return __performance_metrics_get_allocations(metrics,
+                                                 PERFORMANCE_METRICS_ALLOCATION_PHASE_OTHER);
+}
+
+const hardware_counters_values_t *
+    performance_metrics_get_dataset_counters(const performance_metrics_t       *metrics,
+                                             performance_metrics_dataset_step_t step) {
+    return metrics->counters_enabled ? &metrics->dataset_counters[step] : NULL;
+}
+
+const hardware_counters_values_t *
+    performance_metrics_get_query_statistics_counters(const performance_metrics_t *metrics,
+                                                      size_t                       query_type) {
+    return metrics->counters_enabled ? &metrics->statistical_counters[query_type - 1] : NULL;
+}
+
+const hardware_counters_values_t *
+    performance_metrics_get_query_execution_counters(const performance_metrics_t *metrics,
+                                                     size_t                       query_type) {
+    return metrics->counters_enabled ? &metrics->query_counters[query_type - 1] : NULL;
+}
+
+const latency_histogram_t *
+    performance_metrics_get_query_latencies(const performance_metrics_t *metrics,
+                                            size_t                       query_type) {
+    return metrics->query_latencies[query_type - 1];
+}
+
+int performance_metrics_get_structure_memory(const performance_metrics_t    *metrics,
+                                             performance_metrics_structure_t structure,
+                                             size_t                         *out_total,
+                                             size_t                         *out_strings) {
+    if (!metrics->structures_measured)
+        return 1;
+
+    *out_total   = metrics->structure_memory[structure];
+    *out_strings = metrics->structure_strings_memory[structure];
+    return 0;
+}
+
+int performance_metrics_get_query_statistics_memory(const performance_metrics_t *metrics,
+                                                    size_t                       query_type,
+                                                    size_t                      *out_bytes) {
+    if (metrics->statistical_memory[query_type - 1] == SIZE_MAX)
+        return 1;
+
+    *out_bytes = metrics->statistical_memory[query_type - 1];
+    return 0;
+}
+
 uint64_t performance_metrics_get_program_total_time(const performance_metrics_t *metrics) {
     return metrics->program_total_time;
 }
@@ -341,5 +806,15 @@ void performance_metrics_free(performance_metrics_t *metrics) {
         if (metrics->query_events[i]) /* If statement to ease cleanup after allocation failure */
             g_hash_table_unref(metrics->query_events[i]);
 
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i)
+        if (metrics->query_latencies[i])
+            latency_histogram_free(metrics->query_latencies[i]);
+    if (metrics->current_query_event)
+        performance_event_free(metrics->current_query_event);
+
+    if (metrics->counters)
+        hardware_counters_close(metrics->counters);
+    if (metrics->memory_source >= 0)
+        close(metrics->memory_source);
     free(metrics);
 }
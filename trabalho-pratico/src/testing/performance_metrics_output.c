@@ -22,6 +22,7 @@
  * See [the header file's documentation](@ref performance_metrics_output_example).
  */
 
+#include <inttypes.h>
 #include <math.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -29,6 +30,7 @@
 #include "queries/query_type_list.h"
 #include "testing/performance_metrics_output.h"
 #include "utils/table.h"
+#include "utils/table_stream.h"
 
 /**
  * @brief Calulates which unit should be used to display a set of data points.
@@ -188,11 +190,75 @@ uint64_t __performance_metrics_output_print_dataset(FILE
             ret += performance_event_get_elapsed_time(dataset_events[i]);
     }
 
-    const char *const event_names[] = {"Users", "Flights", "Passengers", "Reservations"};
-    __performance_metrics_output_print_table(output, 4, dataset_events, event_names);
+    const char *const event_names[PERFORMANCE_METRICS_DATASET_STEP_DONE] = {"Users",
+                                                                            "Flights",
+                                                                            "Passengers",
+                                                                            "Reservations",
+                                                                            "Indices"};
+    __performance_metrics_output_print_table(output,
+                                             PERFORMANCE_METRICS_DATASET_STEP_DONE,
+                                             dataset_events,
+                                             event_names);
     return ret;
 }
 
+/**
+ * @brief   Prints how long each phase of parsing every file of the dataset took.
+ * @details Files whose phases weren't measured are skipped. Throughputs are relative to the whole
+ *          time it took to load each file.
+ *
+ * @param output  Stream where to output formatted performance data to.
+ * @param metrics Performance metrics to extract parsing phases from.
+ */
+void __performance_metrics_output_print_dataset_phases(FILE                        *output,
+                                                       const performance_metrics_t *metrics) {
+    const char *const file_names[PERFORMANCE_METRICS_DATASET_FILE_COUNT] = {"Users",
+                                                                            "Flights",
+                                                                            "Passengers",
+                                                                            "Reservations"};
+
+    table_t *const table = table_create(8, PERFORMANCE_METRICS_DATASET_FILE_COUNT + 1);
+    if (!table)
+        return;
+
+    table_insert_format(table, 1, 0, "I/O (ms)");
+    table_insert_format(table, 2, 0, "Tokenize (ms)");
+    table_insert_format(table, 3, 0, "Validate (ms)");
+    table_insert_format(table, 4, 0, "Commit (ms)");
+    table_insert_format(table, 5, 0, "MB/s");
+    table_insert_format(table, 6, 0, "Rows/s");
+    table_insert_format(table, 7, 0, "Rejected");
+
+    size_t row = 1;
+    for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_FILE_COUNT; ++i) {
+        const dataset_parser_phases_t *const phases =
+            performance_metrics_get_dataset_phases(metrics, i);
+        if (!phases)
+            continue;
+
+        table_insert_format(table, 0, row, "%s", file_names[i]);
+        table_insert_format(table, 1, row, "%.2lf", phases->io_time / 1e6);
+        table_insert_format(table, 2, row, "%.2lf", phases->tokenize_time / 1e6);
+        table_insert_format(table, 3, row, "%.2lf", phases->validate_time / 1e6);
+        table_insert_format(table, 4, row, "%.2lf", phases->commit_time / 1e6);
+
+        const performance_event_t *const event =
+            performance_metrics_get_dataset_measurement(metrics, i);
+        const uint64_t elapsed = event ? performance_event_get_elapsed_time(event) : 0;
+        if (elapsed) {
+            table_insert_format(table, 5, row, "%.2lf", (double) phases->bytes / elapsed);
+            table_insert_format(table, 6, row, "%.0lf", phases->tokens * 1e6 / elapsed);
+        }
+
+        table_insert_format(table, 7, row, "%zu", phases->rejected_tokens);
+        row++;
+    }
+
+    if (row > 1)
+        table_draw(output, table);
+    table_free(table);
+}
+
 /**
  * @brief Prints the performance information about query statistical data generation in @p metrics.
  *
@@ -257,14 +323,15 @@ uint64_t __performance_metrics_output_print_query(FILE          *output,
         return 0;
     fprintf(output, "\nQuery %zu\n\n", query_type);
 
-    /* Calulate amortized times */
-    uint64_t *const amortized = malloc(n * sizeof(uint64_t));
-    if (!amortized)
-        return 0;
+    /* Amortized times are calculated as they're printed, so only the largest values are kept */
+    size_t   max_line = 0;
+    uint64_t max_time = 0;
     for (size_t i = 0; i < n; ++i) {
         ret += times[i];
-        amortized[i] = times[i] + statistics_time / n;
+        max_line = line_numbers[i] > max_line ? line_numbers[i] : max_line;
+        max_time = times[i] > max_time ? times[i] : max_time;
     }
+    const uint64_t amortized_avg[1] = {ret / n + statistics_time / n};
 
     /* Choose best units to fit data */
     const char *const units[3] = {"us", "ms", "s"};
@@ -272,33 +339,42 @@ uint64_t __performance_metrics_output_print_query(FILE          *output,
     const char       *time_unit_name, *amortized_unit_name;
     time_unit_multiplier = __performance_metrics_choose_unit(n, times, units, &time_unit_name);
     amortized_unit_multiplier =
-        __performance_metrics_choose_unit(n, amortized, units, &amortized_unit_name);
+        __performance_metrics_choose_unit(1, amortized_avg, units, &amortized_unit_name);
 
-    /* Print table */
-    table_t *const table = table_create(3, n + 1);
-    if (!table) {
-        free(amortized);
+    /* Print table, with column widths fit to the widest values */
+    table_stream_t *const table = table_stream_create(output, 3);
+    if (!table)
         return ret;
-    }
-    table_insert_format(table, 1, 0, "Time (%s)", time_unit_name);
-    table_insert_format(table, 2, 0, "Amortized (%s)", amortized_unit_name);
+
+    table_stream_fit_column(table, 0, "Line %5zu", max_line);
+    table_stream_fit_column(table, 1, "Time (%s)", time_unit_name);
+    table_stream_fit_column(table, 1, "%.2lf", (double) max_time / time_unit_multiplier);
+    table_stream_fit_column(table, 2, "Amortized (%s)", amortized_unit_name);
+    if (statistics_time)
+        table_stream_fit_column(table,
+                                2,
+                                "%.2lf",
+                                (double) (max_time + statistics_time / n) /
+                                    amortized_unit_multiplier);
+
+    table_stream_set_cell(table, 1, "Time (%s)", time_unit_name);
+    table_stream_set_cell(table, 2, "Amortized (%s)", amortized_unit_name);
+    table_stream_end_row(table);
 
     for (size_t i = 0; i < n; i++) {
-        table_insert_format(table, 0, i + 1, "Line %5zu", line_numbers[i]);
-        table_insert_format(table, 1, i + 1, "%.2lf", (double) times[i] / time_unit_multiplier);
+        table_stream_set_cell(table, 0, "Line %5zu", line_numbers[i]);
+        table_stream_set_cell(table, 1, "%.2lf", (double) times[i] / time_unit_multiplier);
 
         if (statistics_time)
-            table_insert_format(table,
-                                2,
-                                i + 1,
-                                "%.2lf",
-                                (double) amortized[i] / amortized_unit_multiplier);
+            table_stream_set_cell(table,
+                                  2,
+                                  "%.2lf",
+                                  (double) (times[i] + statistics_time / n) /
+                                      amortized_unit_multiplier);
+        table_stream_end_row(table);
     }
 
-    table_draw(output, table);
-    table_free(table);
-    free(amortized);
-
+    table_stream_free(table);
     return ret;
 }
 
@@ -307,13 +383,9 @@ uint64_t __performance_metrics_output_print_query(FILE          *output,
  *
  * @param output  Stream where to output formatted performance data to.
  * @param metrics Performance metrics to extract query execution information from.
- *
- * @return The time (in microseconds) it took to execute all queries (doesn't include statistical
- *         data generation).
  */
-uint64_t __performance_metrics_output_print_all_queries(FILE                        *output,
-                                                        const performance_metrics_t *metrics) {
-    uint64_t ret = 0;
+void __performance_metrics_output_print_all_queries(FILE                        *output,
+                                                    const performance_metrics_t *metrics) {
     for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
         size_t   *line_numbers;
         uint64_t *times;
@@ -327,18 +399,316 @@ uint64_t __performance_metrics_output_print_all_queries(FILE
                                                                                 i + 1,
                                                                                 &line_numbers,
                                                                                 &times);
-        ret += __performance_metrics_output_print_query(output,
-                                                        i + 1,
-                                                        len,
-                                                        line_numbers,
-                                                        times,
-                                                        statistics_time);
+        __performance_metrics_output_print_query(output,
+                                                 i + 1,
+                                                 len,
+                                                 line_numbers,
+                                                 times,
+                                                 statistics_time);
         free(line_numbers);
         free(times);
     }
+}
+
+/**
+ * @brief Prints execution time percentiles of each query type.
+ *
+ * @param output  Stream where to output formatted performance data to.
+ * @param metrics Performance metrics to extract query latency histograms from.
+ *
+ * @return The time (in microseconds) it took to execute all queries (doesn't include statistical
+ *         data generation).
+ */
+uint64_t __performance_metrics_output_print_latencies(FILE                        *output,
+                                                      const performance_metrics_t *metrics) {
+    const double      percentiles[]      = {50.0, 90.0, 99.0, 99.9};
+    const char *const percentile_names[] = {"p50", "p90", "p99", "p99.9"};
+    const size_t      npercentiles       = sizeof(percentiles) / sizeof(*percentiles);
+
+    uint64_t ret = 0, maxs[QUERY_TYPE_LIST_COUNT];
+    size_t   nrows = 0;
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        const latency_histogram_t *const histogram =
+            performance_metrics_get_query_latencies(metrics, i + 1);
+
+        ret += latency_histogram_get_total(histogram);
+        if (latency_histogram_get_count(histogram))
+            maxs[nrows++] = latency_histogram_get_max(histogram);
+    }
+
+    /* Same unit for all columns, chosen from the maximums, as those are the widest values */
+    const char *const units[3] = {"us", "ms", "s"};
+    const char       *unit_name;
+    const int unit_multiplier = __performance_metrics_choose_unit(nrows, maxs, units, &unit_name);
+
+    table_t *const table = table_create(npercentiles + 3, nrows + 1);
+    if (!table)
+        return ret;
+    table_insert_format(table, 1, 0, "Count");
+    for (size_t j = 0; j < npercentiles; ++j)
+        table_insert_format(table, j + 2, 0, "%s (%s)", percentile_names[j], unit_name);
+    table_insert_format(table, npercentiles + 2, 0, "Max (%s)", unit_name);
+
+    size_t row = 1;
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        const latency_histogram_t *const histogram =
+            performance_metrics_get_query_latencies(metrics, i + 1);
+        if (!latency_histogram_get_count(histogram))
+            continue;
+
+        table_insert_format(table, 0, row, "Query %zu", i + 1);
+        table_insert_format(table, 1, row, "%" PRIu64, latency_histogram_get_count(histogram));
+        for (size_t j = 0; j < npercentiles; ++j)
+            table_insert_format(
+                table,
+                j + 2,
+                row,
+                "%.2lf",
+                (double) latency_histogram_get_percentile(histogram, percentiles[j]) /
+                    unit_multiplier);
+
+        table_insert_format(table,
+                            npercentiles + 2,
+                            row,
+                            "%.2lf",
+                            (double) latency_histogram_get_max(histogram) / unit_multiplier);
+        row++;
+    }
+
+    table_draw(output, table);
+    table_free(table);
     return ret;
 }
 
+/**
+ * @brief Adds a row of hardware counter values to a table.
+ *
+ * @param table  Table to be modified.
+ * @param row    Index of the row in @p table.
+ * @param name   Name of the measured task.
+ * @param values Hardware counter values measured for the task.
+ */
+void __performance_metrics_output_insert_counters(table_t                          *table,
+                                                  size_t                            row,
+                                                  const char                       *name,
+                                                  const hardware_counters_values_t *values) {
+    const uint64_t cycles       = values->values[HARDWARE_COUNTER_CYCLES];
+    const uint64_t instructions = values->values[HARDWARE_COUNTER_INSTRUCTIONS];
+
+    table_insert_format(table, 0, row, "%s", name);
+    table_insert_format(table, 1, row, "%.2lf", cycles / 1e6);
+    table_insert_format(table, 2, row, "%.2lf", instructions / 1e6);
+    if (cycles)
+        table_insert_format(table, 3, row, "%.2lf", (double) instructions / cycles);
+    table_insert_format(table,
+                        4,
+                        row,
+                        "%.2lf",
+                        values->values[HARDWARE_COUNTER_CACHE_MISSES] / 1e6);
+    table_insert_format(table,
+                        5,
+                        row,
+                        "%.2lf",
+                        values->values[HARDWARE_COUNTER_BRANCH_MISSES] / 1e6);
+    table_insert_format(table, 6, row, "%.2lf", values->values[HARDWARE_COUNTER_LLC_LOADS] / 1e6);
+}
+
+/**
+ * @brief Prints a table with the hardware counter values measured for every task.
+ *
+ * @param output  Stream where to output formatted performance data to.
+ * @param metrics Performance metrics to extract hardware counter values from. Hardware counters
+ *                must have been enabled.
+ */
+void __performance_metrics_output_print_counters(FILE                        *output,
+                                                 const performance_metrics_t *metrics) {
+    /* Dataset steps, and statistics and execution of each query type */
+    const size_t                      max_rows = PERFORMANCE_METRICS_DATASET_STEP_DONE +
+                                                 2 * QUERY_TYPE_LIST_COUNT;
+    const hardware_counters_values_t *rows[max_rows];
+    char                              names[max_rows][32];
+    size_t                            nrows = 0;
+
+    const char *const dataset_names[PERFORMANCE_METRICS_DATASET_STEP_DONE] = {"Users",
+                                                                              "Flights",
+                                                                              "Passengers",
+                                                                              "Reservations",
+                                                                              "Indices"};
+    for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_STEP_DONE; ++i) {
+        rows[nrows] = performance_metrics_get_dataset_counters(metrics, i);
+        snprintf(names[nrows++], 32, "%s", dataset_names[i]);
+    }
+
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        const hardware_counters_values_t *const statistics =
+            performance_metrics_get_query_statistics_counters(metrics, i + 1);
+        const hardware_counters_values_t *const execution =
+            performance_metrics_get_query_execution_counters(metrics, i + 1);
+
+        /* Skip query types that weren't run */
+        if (statistics->values[HARDWARE_COUNTER_CYCLES]) {
+            rows[nrows] = statistics;
+            snprintf(names[nrows++], 32, "Query %zu (statistics)", i + 1);
+        }
+        if (execution->values[HARDWARE_COUNTER_CYCLES]) {
+            rows[nrows] = execution;
+            snprintf(names[nrows++], 32, "Query %zu (execution)", i + 1);
+        }
+    }
+
+    table_t *const table = table_create(7, nrows + 1);
+    if (!table)
+        return;
+
+    table_insert_format(table, 1, 0, "Cycles (M)");
+    table_insert_format(table, 2, 0, "Instructions (M)");
+    table_insert_format(table, 3, 0, "IPC");
+    table_insert_format(table, 4, 0, "Cache misses (M)");
+    table_insert_format(table, 5, 0, "Branch misses (M)");
+    table_insert_format(table, 6, 0, "LLC loads (M)");
+    for (size_t i = 0; i < nrows; ++i)
+        __performance_metrics_output_insert_counters(table, i + 1, names[i], rows[i]);
+
+    table_draw(output, table);
+    table_free(table);
+}
+
+/**
+ * @brief   Prints a table with the memory used by each part of the database and by the statistical
+ *          data of each query type.
+ * @details Query types whose statistical data's memory usage wasn't measured are skipped.
+ *
+ * @param output  Stream where to output formatted performance data to.
+ * @param metrics Performance metrics to extract memory usage information from. The memory usage of
+ *                the database must have been measured.
+ */
+void __performance_metrics_output_print_memory(FILE                        *output,
+                                               const performance_metrics_t *metrics) {
+    const size_t max_rows = PERFORMANCE_METRICS_STRUCTURE_COUNT + QUERY_TYPE_LIST_COUNT;
+    uint64_t     totals[max_rows], strings[max_rows];
+    char         names[max_rows][32];
+    size_t       nrows = 0;
+
+    const char *const structure_names[] = {"user_manager", "flight_manager", "reservation_manager"};
+    for (size_t i = 0; i < PERFORMANCE_METRICS_STRUCTURE_COUNT; ++i) {
+        size_t total, strings_total;
+        performance_metrics_get_structure_memory(metrics, i, &total, &strings_total);
+
+        totals[nrows]  = total / 1024;
+        strings[nrows] = strings_total / 1024;
+        snprintf(names[nrows++], 32, "%s", structure_names[i]);
+    }
+
+    uint64_t database_total = 0;
+    for (size_t i = 0; i < nrows; ++i)
+        database_total += totals[i];
+
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        size_t total;
+        if (!performance_metrics_get_query_statistics_memory(metrics, i + 1, &total)) {
+            totals[nrows]  = total / 1024;
+            strings[nrows] = 0;
+            snprintf(names[nrows++], 32, "Query %zu (statistics)", i + 1);
+        }
+    }
+
+    const char *const mem_unit_names[] = {"KiB", "MiB", "GiB"};
+    const char       *unit_name;
+    const int         multiplier =
+        __performance_metrics_choose_unit(nrows, totals, mem_unit_names, &unit_name);
+
+    table_t *const table = table_create(4, nrows + 1);
+    if (!table)
+        return;
+
+    table_insert_format(table, 1, 0, "Total (%s)", unit_name);
+    table_insert_format(table, 2, 0, "Strings (%s)", unit_name);
+    table_insert_format(table, 3, 0, "Share of database");
+    for (size_t i = 0; i < nrows; ++i) {
+        table_insert_format(table, 0, i + 1, "%s", names[i]);
+        table_insert_format(table, 1, i + 1, "%.2lf", (double) totals[i] / multiplier);
+
+        if (i < PERFORMANCE_METRICS_STRUCTURE_COUNT) {
+            table_insert_format(table, 2, i + 1, "%.2lf", (double) strings[i] / multiplier);
+            if (database_total)
+                table_insert_format(table,
+                                    3,
+                                    i + 1,
+                                    "%.1lf %%",
+                                    totals[i] * 100.0 / database_total);
+        }
+    }
+
+    table_draw(output, table);
+    table_free(table);
+}
+
+/**
+ * @brief   Prints a table with the heap allocations made by every task.
+ * @details Tasks without any allocations (e.g.: query types that weren't run) are skipped.
+ *
+ * @param output  Stream where to output formatted performance data to.
+ * @param metrics Performance metrics to extract allocation counts from. Allocations must have
+ *                been measured.
+ */
+void __performance_metrics_output_print_allocations(FILE                        *output,
+                                                    const performance_metrics_t *metrics) {
+    /* Dataset steps, statistics and execution of each query type, and everything else */
+    const size_t                        max_rows = PERFORMANCE_METRICS_ALLOCATION_PHASES;
+    const allocation_profiler_counts_t *rows[max_rows];
+    char                                names[max_rows][32];
+    size_t                              nrows = 0;
+
+    const char *const dataset_names[PERFORMANCE_METRICS_DATASET_STEP_DONE] = {"Users",
+                                                                              "Flights",
+                                                                              "Passengers",
+                                                                              "Reservations",
+                                                                              "Indices"};
+    for (size_t i = 0; i < PERFORMANCE_METRICS_DATASET_STEP_DONE; ++i) {
+        rows[nrows] = performance_metrics_get_dataset_allocations(metrics, i);
+        snprintf(names[nrows++], 32, "%s", dataset_names[i]);
+    }
+
+    for (size_t i = 0; i < QUERY_TYPE_LIST_COUNT; ++i) {
+        rows[nrows] = performance_metrics_get_query_statistics_allocations(metrics, i + 1);
+        snprintf(names[nrows++], 32, "Query %zu (statistics)", i + 1);
+        rows[nrows] = performance_metrics_get_query_execution_allocations(metrics, i + 1);
+        snprintf(names[nrows++], 32, "Query %zu (execution)", i + 1);
+    }
+
+    rows[nrows] = performance_metrics_get_other_allocations(metrics);
+    snprintf(names[nrows++], 32, "Other");
+
+    size_t nfilled = 0;
+    for (size_t i = 0; i < nrows; ++i)
+        nfilled += rows[i]->allocations != 0;
+
+    table_t *const table = table_create(5, nfilled + 1);
+    if (!table)
+        return;
+
+    table_insert_format(table, 1, 0, "Allocations");
+    table_insert_format(table, 2, 0, "Frees");
+    table_insert_format(table, 3, 0, "Allocated (MiB)");
+    table_insert_format(table, 4, 0, "Peak live (MiB)");
+
+    size_t row = 1;
+    for (size_t i = 0; i < nrows; ++i) {
+        if (!rows[i]->allocations)
+            continue;
+
+        table_insert_format(table, 0, row, "%s", names[i]);
+        table_insert_format(table, 1, row, "%" PRIu64, rows[i]->allocations);
+        table_insert_format(table, 2, row, "%" PRIu64, rows[i]->frees);
+        table_insert_format(table, 3, row, "%.2lf", rows[i]->bytes / 1048576.0);
+        table_insert_format(table, 4, row, "%.2lf", rows[i]->peak_live_bytes / 1048576.0);
+        row++;
+    }
+
+    table_draw(output, table);
+    table_free(table);
+}
+
 /**
  * @brief Prints a summary of the performance data collected.
  *
@@ -391,6 +761,14 @@ void performance_metrics_output_print(FILE *output, const performance_metrics_t
         fprintf(output, "\nDATASET LOADING\n\n");
     const uint64_t dataset_time = __performance_metrics_output_print_dataset(output, metrics);
 
+    if (performance_metrics_get_dataset_phases(metrics, PERFORMANCE_METRICS_DATASET_STEP_USERS)) {
+        if (tty)
+            fprintf(output, "\n\x1b[1;4mDATASET LOADING PHASES\x1b[22;24m\n\n");
+        else
+            fprintf(output, "\nDATASET LOADING PHASES\n\n");
+        __performance_metrics_output_print_dataset_phases(output, metrics);
+    }
+
     if (tty)
         fprintf(output, "\n\x1b[1;4mQUERY STATISTICAL DATA GENERATION\x1b[22;24m\n\n");
     else
@@ -401,7 +779,41 @@ void performance_metrics_output_print(FILE *output, const performance_metrics_t
         fprintf(output, "\n\x1b[1;4mQUERY EXECUTION\x1b[22;24m\n\n");
     else
         fprintf(output, "\nQUERY EXECUTION\n\n");
-    query_time += __performance_metrics_output_print_all_queries(output, metrics);
+    __performance_metrics_output_print_all_queries(output, metrics);
+
+    if (tty)
+        fprintf(output, "\n\x1b[1;4mQUERY EXECUTION PERCENTILES\x1b[22;24m\n\n");
+    else
+        fprintf(output, "\nQUERY EXECUTION PERCENTILES\n\n");
+    query_time += __performance_metrics_output_print_latencies(output, metrics);
+
+    if (performance_metrics_get_dataset_counters(metrics, PERFORMANCE_METRICS_DATASET_STEP_USERS)) {
+        if (tty)
+            fprintf(output, "\n\x1b[1;4mHARDWARE COUNTERS\x1b[22;24m\n\n");
+        else
+            fprintf(output, "\nHARDWARE COUNTERS\n\n");
+        __performance_metrics_output_print_counters(output, metrics);
+    }
+
+    size_t total, strings;
+    if (!performance_metrics_get_structure_memory(metrics,
+                                                  PERFORMANCE_METRICS_STRUCTURE_USERS,
+                                                  &total,
+                                                  &strings)) {
+        if (tty)
+            fprintf(output, "\n\x1b[1;4mMEMORY BREAKDOWN\x1b[22;24m\n\n");
+        else
+            fprintf(output, "\nMEMORY BREAKDOWN\n\n");
+        __performance_metrics_output_print_memory(output, metrics);
+    }
+
+    if (performance_metrics_get_other_allocations(metrics)) {
+        if (tty)
+            fprintf(output, "\n\x1b[1;4mHEAP ALLOCATIONS\x1b[22;24m\n\n");
+        else
+            fprintf(output, "\nHEAP ALLOCATIONS\n\n");
+        __performance_metrics_output_print_allocations(output, metrics);
+    }
 
     if (tty)
         fprintf(output, "\n\x1b[1;4mPERFORMANCE SUMMARY\x1b[22;24m\n\n");
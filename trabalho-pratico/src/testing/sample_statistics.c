@@ -0,0 +1,60 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  sample_statistics.c
+ * @brief Implementation of methods in include/testing/sample_statistics.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref sample_statistics_examples).
+ */
+
+#include "testing/sample_statistics.h"
+
+double sample_statistics_mean(size_t n, const double samples[n]) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i)
+        sum += samples[i];
+    return n ? sum / n : 0;
+}
+
+double sample_statistics_variance(size_t n, const double samples[n]) {
+    if (n < 2)
+        return 0;
+
+    const double mean     = sample_statistics_mean(n, samples);
+    double       variance = 0;
+    for (size_t i = 0; i < n; ++i)
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    return variance / (n - 1);
+}
+
+double sample_statistics_t_critical_value(double degrees_of_freedom) {
+    /* Indexed by the degrees of freedom minus one */
+    const double t_values[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                               2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                               2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                               2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+    const size_t nt_values  = sizeof(t_values) / sizeof(*t_values);
+
+    if (degrees_of_freedom < 1)
+        return t_values[0];
+    else if (degrees_of_freedom > nt_values)
+        return 1.960;
+    else
+        return t_values[(size_t) degrees_of_freedom - 1];
+}
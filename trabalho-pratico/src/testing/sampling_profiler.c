@@ -0,0 +1,331 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  sampling_profiler.c
+ * @brief Implementation of methods in include/testing/sampling_profiler.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref sampling_profiler_examples).
+ */
+
+/* setitimer and backtrace aren't part of POSIX */
+#ifndef _DEFAULT_SOURCE /* May already be defined in the compiler's flags */
+#define _DEFAULT_SOURCE
+#endif
+
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "testing/sampling_profiler.h"
+
+/** @brief Maximum number of frames recorded in each sample. */
+#define SAMPLING_PROFILER_MAX_DEPTH 48
+
+/** @brief Number of innermost frames in every sample that belong to the signal handler. */
+#define SAMPLING_PROFILER_HANDLER_FRAMES 2
+
+/** @brief Maximum length of a line of collapsed stacks (longer stacks are cut short). */
+#define SAMPLING_PROFILER_LINE_MAX 8192
+
+/**
+ * @struct sampling_profiler_sample_t
+ * @brief  A sample of the call stack.
+ *
+ * @var sampling_profiler_sample_t::query_type
+ *     @brief Value of ::sampling_profiler::query_type when the sample was taken.
+ * @var sampling_profiler_sample_t::line
+ *     @brief Value of ::sampling_profiler::line when the sample was taken.
+ * @var sampling_profiler_sample_t::depth
+ *     @brief Number of elements in ::sampling_profiler_sample_t::frames. `0` for samples that
+ *            weren't fully written.
+ * @var sampling_profiler_sample_t::frames
+ *     @brief Return addresses in the call stack, from the innermost to the outermost.
+ */
+typedef struct {
+    size_t query_type, line;
+    int    depth;
+    void  *frames[SAMPLING_PROFILER_MAX_DEPTH];
+} sampling_profiler_sample_t;
+
+/**
+ * @struct sampling_profiler
+ * @brief  Statistical profiler that samples the call stack of the process on `SIGPROF`.
+ *
+ * @var sampling_profiler::samples
+ *     @brief Preallocated array of ::sampling_profiler::capacity samples.
+ * @var sampling_profiler::capacity
+ *     @brief Number of elements in ::sampling_profiler::samples.
+ * @var sampling_profiler::nsamples
+ *     @brief Number of samples taken, including dropped ones. Incremented atomically, as signals
+ *            may be handled by different threads at once.
+ * @var sampling_profiler::query_type
+ *     @brief Current tag: query type being processed, or `0`.
+ * @var sampling_profiler::line
+ *     @brief Current tag: line of the query being executed, or `0` for statistical data
+ *            generation.
+ * @var sampling_profiler::old_action
+ *     @brief `SIGPROF` handler before the profiler was started, restored when it's stopped.
+ */
+struct sampling_profiler {
+    sampling_profiler_sample_t *samples;
+    size_t                      capacity, nsamples;
+    volatile size_t             query_type, line;
+    struct sigaction            old_action;
+};
+
+/** @brief The profiler currently running, used by the signal handler. */
+sampling_profiler_t *volatile sampling_profiler_running = NULL;
+
+/**
+ * @brief   Handler of `SIGPROF`, that records a sample of the call stack.
+ * @details Only `backtrace` is called, which is safe after it's been called once outside of a
+ *          signal handler (so that `libgcc` is already loaded).
+ *
+ * @param signum Number of the handled signal (`SIGPROF`).
+ */
+void __sampling_profiler_handler(int signum) {
+    (void) signum;
+    const int saved_errno = errno;
+
+    sampling_profiler_t *const profiler = sampling_profiler_running;
+    if (profiler) {
+        const size_t i = __sync_fetch_and_add(&profiler->nsamples, 1);
+        if (i < profiler->capacity) {
+            sampling_profiler_sample_t *const sample = &profiler->samples[i];
+            sample->query_type                       = profiler->query_type;
+            sample->line                             = profiler->line;
+            sample->depth = backtrace(sample->frames, SAMPLING_PROFILER_MAX_DEPTH);
+        }
+    }
+
+    errno = saved_errno;
+}
+
+sampling_profiler_t *sampling_profiler_start(unsigned int frequency, size_t max_samples) {
+    if (sampling_profiler_running)
+        return NULL;
+
+    sampling_profiler_t *const profiler = malloc(sizeof(sampling_profiler_t));
+    if (!profiler)
+        return NULL;
+
+    profiler->capacity   = max_samples ? max_samples : SAMPLING_PROFILER_DEFAULT_MAX_SAMPLES;
+    profiler->nsamples   = 0;
+    profiler->query_type = 0;
+    profiler->line       = 0;
+    profiler->samples    = calloc(profiler->capacity, sizeof(sampling_profiler_sample_t));
+    if (!profiler->samples)
+        goto DEFER_1;
+
+    /* Load libgcc's unwinder now, as that can't be done inside the signal handler */
+    void *warmup[1];
+    backtrace(warmup, 1);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_handler = __sampling_profiler_handler;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &profiler->old_action))
+        goto DEFER_2;
+
+    sampling_profiler_running = profiler;
+
+    const unsigned int     hz       = frequency ? frequency : SAMPLING_PROFILER_DEFAULT_FREQUENCY;
+    const struct itimerval interval = {
+        .it_interval = {.tv_sec = 0, .tv_usec = hz > 1 ? 1000000 / hz : 999999},
+        .it_value    = {.tv_sec = 0, .tv_usec = hz > 1 ? 1000000 / hz : 999999}
+    };
+    if (setitimer(ITIMER_PROF, &interval, NULL))
+        goto DEFER_3;
+
+    return profiler;
+
+DEFER_3:
+    sampling_profiler_running = NULL;
+    sigaction(SIGPROF, &profiler->old_action, NULL);
+DEFER_2:
+    free(profiler->samples);
+DEFER_1:
+    free(profiler);
+    return NULL;
+}
+
+void sampling_profiler_set_tag(sampling_profiler_t *profiler, size_t query_type, size_t line) {
+    if (!profiler)
+        return;
+
+    profiler->query_type = query_type;
+    profiler->line       = line;
+}
+
+int sampling_profiler_stop(sampling_profiler_t *profiler) {
+    const struct itimerval stopped = {0};
+    int                    retval  = setitimer(ITIMER_PROF, &stopped, NULL) != 0;
+
+    sampling_profiler_running = NULL;
+    retval |= sigaction(SIGPROF, &profiler->old_action, NULL) != 0;
+    return retval;
+}
+
+size_t sampling_profiler_get_sample_count(const sampling_profiler_t *profiler, size_t *dropped) {
+    const size_t taken = profiler->nsamples;
+    if (dropped)
+        *dropped = taken > profiler->capacity ? taken - profiler->capacity : 0;
+    return taken < profiler->capacity ? taken : profiler->capacity;
+}
+
+/**
+ * @brief   Writes the name of a frame, as returned by `backtrace_symbols`, to a buffer.
+ * @details A symbol like `./program(function+0x1a) [0x5555]` becomes `function`. When the function
+ *          isn't known (e.g.: a non-exported symbol), the module and the offset in it are written
+ *          instead (`program+0x1234`), so that they can be resolved with `addr2line`.
+ *
+ * @param output    Where to write the name to.
+ * @param available Number of characters available in @p output.
+ * @param symbol    Symbol returned by `backtrace_symbols`.
+ *
+ * @return The number of characters written (excluding the null terminator).
+ */
+size_t __sampling_profiler_frame_name(char *output, size_t available, const char *symbol) {
+    const char *const open  = strchr(symbol, '(');
+    const char *const close = open ? strchr(open, ')') : NULL;
+    if (!open || !close)
+        return snprintf(output, available, "%s", symbol);
+
+    const char *const plus = memchr(open, '+', close - open);
+    const char *const end  = plus ? plus : close;
+    if (end > open + 1)
+        return snprintf(output, available, "%.*s", (int) (end - open - 1), open + 1);
+
+    const char *module = symbol;
+    for (const char *c = symbol; c < open; ++c)
+        if (*c == '/')
+            module = c + 1;
+    return snprintf(output,
+                    available,
+                    "%.*s%.*s",
+                    (int) (open - module),
+                    module,
+                    (int) (close - end),
+                    end);
+}
+
+/**
+ * @brief Creates the collapsed stack line of a sample (without its count).
+ *
+ * @param sample Sample to be formatted. Must be deeper than ::SAMPLING_PROFILER_HANDLER_FRAMES.
+ *
+ * @return The line, that must be `free`d, or `NULL` on allocation failure.
+ */
+char *__sampling_profiler_collapse(const sampling_profiler_sample_t *sample) {
+    char **const frame_names = backtrace_symbols(sample->frames, sample->depth);
+    if (!frame_names)
+        return NULL;
+
+    char   line[SAMPLING_PROFILER_LINE_MAX];
+    size_t length;
+    if (sample->query_type == 0)
+        length = snprintf(line, SAMPLING_PROFILER_LINE_MAX, "other");
+    else if (sample->line == 0)
+        length = snprintf(line,
+                          SAMPLING_PROFILER_LINE_MAX,
+                          "query%zu;statistics",
+                          sample->query_type);
+    else
+        length = snprintf(line,
+                          SAMPLING_PROFILER_LINE_MAX,
+                          "query%zu;line%zu",
+                          sample->query_type,
+                          sample->line);
+
+    /* Outermost frames first */
+    for (int i = sample->depth - 1; i >= SAMPLING_PROFILER_HANDLER_FRAMES; --i) {
+        if (length + 2 >= SAMPLING_PROFILER_LINE_MAX)
+            break;
+
+        line[length++] = ';';
+        length += __sampling_profiler_frame_name(line + length,
+                                                 SAMPLING_PROFILER_LINE_MAX - length,
+                                                 frame_names[i]);
+        if (length >= SAMPLING_PROFILER_LINE_MAX)
+            length = SAMPLING_PROFILER_LINE_MAX - 1;
+    }
+
+    free(frame_names); /* A single allocation, with all the strings */
+
+    /* Spaces separate stacks from counts */
+    for (size_t i = 0; i < length; ++i)
+        if (line[i] == ' ')
+            line[i] = '_';
+    line[length] = '\0';
+    return strdup(line);
+}
+
+/** @brief Comparison function for `qsort`ing collapsed stack lines. */
+int __sampling_profiler_line_compare(const void *a, const void *b) {
+    return strcmp(*(const char *const *) a, *(const char *const *) b);
+}
+
+int sampling_profiler_write_collapsed(const sampling_profiler_t *profiler, FILE *output) {
+    const size_t nsamples = sampling_profiler_get_sample_count(profiler, NULL);
+    char **const lines    = malloc(sizeof(char *) * (nsamples ? nsamples : 1));
+    if (!lines)
+        return 1;
+
+    int    retval = 0;
+    size_t nlines = 0;
+    for (size_t i = 0; i < nsamples; ++i) {
+        const sampling_profiler_sample_t *const sample = &profiler->samples[i];
+        if (sample->depth <= SAMPLING_PROFILER_HANDLER_FRAMES)
+            continue;
+
+        if (!(lines[nlines] = __sampling_profiler_collapse(sample))) {
+            retval = 1;
+            goto DEFER_1;
+        }
+        nlines++;
+    }
+
+    /* Identical stacks become adjacent, so they can be counted in a single pass */
+    qsort(lines, nlines, sizeof(char *), __sampling_profiler_line_compare);
+    for (size_t i = 0; i < nlines;) {
+        size_t j = i + 1;
+        while (j < nlines && strcmp(lines[i], lines[j]) == 0)
+            j++;
+
+        fprintf(output, "%s %zu\n", lines[i], j - i);
+        i = j;
+    }
+    retval = ferror(output) != 0;
+
+DEFER_1:
+    for (size_t i = 0; i < nlines; ++i)
+        free(lines[i]);
+    free(lines);
+    return retval;
+}
+
+void sampling_profiler_free(sampling_profiler_t *profiler) {
+    free(profiler->samples);
+    free(profiler);
+}
@@ -24,14 +24,19 @@
 
 #include <dirent.h>
 #include <glib.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include "queries/query_output_container.h"
 #include "testing/test_diff.h"
 #include "utils/int_utils.h"
+#include "utils/mapped_file.h"
+#include "utils/parallel_for.h"
 
 /**
  * @struct test_diff
@@ -94,32 +99,29 @@ GPtrArray *__test_diff_read_dir(const char *path) {
 }
 
 /**
- * @brief   Fills three arrays with information about files common between two directories.
+ * @brief   Fills three arrays with information about files common between the program's results
+ *          and a directory of expected results.
  * @details The filled arrays are guaranteed to be lexicographically sorted.
  *
- * @param results  Directory where the program's output was placed into.
- * @param expected Directory containing expected program results.
- * @param common   Files present in both @p results and @p expected.
- * @param extra    Files in @p results but not it @p expected.
- * @param missing  Files in @p expected but not in @p results.
+ * @param results_files Lexicographically sorted array of the names of the files the program
+ *                      outputted (`char *`).
+ * @param expected      Directory containing expected program results.
+ * @param common        Files present in both @p results_files and @p expected.
+ * @param extra         Files in @p results_files but not it @p expected.
+ * @param missing       Files in @p expected but not in @p results_files.
  *
  * @retval 0 Success.
  * @retval 1 IO error.
  */
-int __test_diff_common_files(const char *results,
+int __test_diff_common_files(GPtrArray  *results_files,
                              const char *expected,
                              GPtrArray  *common,
                              GPtrArray  *extra,
                              GPtrArray  *missing) {
 
-    GPtrArray *const results_files = __test_diff_read_dir(results);
-    if (!results_files)
-        return 1;
     GPtrArray *const expected_files = __test_diff_read_dir(expected);
-    if (!expected_files) {
-        g_ptr_array_unref(results_files);
+    if (!expected_files)
         return 1;
-    }
 
     /* Algorithm similar to a merge, but for set partitioning */
     guint ri = 0, ei = 0;
@@ -151,51 +153,48 @@ int __test_diff_common_files(const char *results,
         }
     }
 
-    g_ptr_array_unref(results_files);
     g_ptr_array_unref(expected_files);
     return 0;
 }
 
 /**
- * @brief Loads the contents of a file to memory.
+ * @brief Compares the contents of a file generated by the program with a file it was expected to
+ *        output, to determine if they differ in any line.
  *
- * @param path Path to the file.
- * @param n    Where to write the number of bytes read to.
+ * @param result_contents Contents of the file generated by the program.
+ * @param result_len      Number of characters in @p result_contents.
+ * @param expected        Path to a file that the program is expected to output.
  *
- * @return On success, the array of read bytes, which must be deleted with `free`. On failure,
- *         `NULL` will be returned.
+ * @return `0` if the files are the same, `-1` if an IO error occurs while reading @p expected, the
+ *         line where the files differ otherwise.
  */
-char *__test_diff_read_file(const char *path, size_t *n) {
-    FILE *const f = fopen(path, "r");
-    if (!f)
-        return NULL;
+ssize_t __test_diff_compare_contents(const char *result_contents,
+                                     size_t      result_len,
+                                     const char *expected) {
+    mapped_file_t *const expected_file = mapped_file_open(expected);
+    if (!expected_file)
+        return -1;
 
-    long  len;
-    char *ret = NULL;
-
-    /* Determine lenght of file */
-    if (fseek(f, 0, SEEK_END))
-        goto END;
-    if ((len = ftell(f)) == -1)
-        goto END;
-    if (fseek(f, 0, 0))
-        goto END;
-
-    /* Read file contents */
-    ret = malloc(sizeof(char) * len);
-    if (!ret)
-        goto END;
-
-    const size_t read = fread(ret, 1, len, f);
-    if (read != (size_t) len || ferror(f)) {
-        ret = NULL;
-        free(ret);
-        goto END;
+    const char  *expected_contents = mapped_file_get_contents(expected_file);
+    const size_t expected_len      = mapped_file_get_size(expected_file);
+
+    /* Most files are equal, so a single memcmp avoids scanning them for lines */
+    ssize_t ret = 0;
+    if (result_len != expected_len ||
+        (result_len && memcmp(result_contents, expected_contents, result_len))) {
+
+        const size_t min_len = min(result_len, expected_len);
+        size_t       i       = 0;
+        while (i < min_len && result_contents[i] == expected_contents[i])
+            i++;
+
+        /* The line where the files differ is one after the number of (common) preceding lines */
+        ret = 1;
+        for (size_t j = 0; j < i; ++j)
+            ret += result_contents[j] == '\n';
     }
 
-    *n = (size_t) len;
-END:
-    fclose(f);
+    mapped_file_close(expected_file);
     return ret;
 }
 
@@ -209,37 +208,106 @@ END:
  *         line where the files differ otherwise.
  */
 ssize_t __test_diff_compare_files(const char *result, const char *expected) {
-    size_t      result_len, expected_len;
-    char *const result_contents = __test_diff_read_file(result, &result_len);
-    if (!result_contents)
-        return -1;
-    char *const expected_contents = __test_diff_read_file(expected, &expected_len);
-    if (!expected_contents) {
-        free(result_contents);
+    mapped_file_t *const result_file = mapped_file_open(result);
+    if (!result_file)
         return -1;
-    }
 
-    const size_t min_len = min(result_len, expected_len);
-    size_t       line = 1, ret = 0;
-    for (size_t i = 0; i < min_len; ++i) {
-        if (result_contents[i] == '\n' && expected_contents[i] == '\n')
-            line++;
+    const ssize_t ret = __test_diff_compare_contents(mapped_file_get_contents(result_file),
+                                                     mapped_file_get_size(result_file),
+                                                     expected);
+    mapped_file_close(result_file);
+    return ret;
+}
 
-        if (result_contents[i] != expected_contents[i]) {
-            ret = line;
-            break;
+/**
+ * @struct test_diff_compare_data_t
+ * @brief  Data shared by all threads in ::__test_diff_compare_range.
+ *
+ * @var test_diff_compare_data_t::diff
+ *     @brief Where to write the result of every comparison to.
+ * @var test_diff_compare_data_t::results
+ *     @brief Directory where the program's output was placed into.
+ * @var test_diff_compare_data_t::expected
+ *     @brief Directory containing expected program results.
+ * @var test_diff_compare_data_t::container
+ *     @brief Container with the outputs of queries, or `NULL` if all results are in
+ *            ::test_diff_compare_data_t::results.
+ * @var test_diff_compare_data_t::container_files
+ *     @brief Maps the name of each file in ::test_diff_compare_data_t::container to its index in
+ *            the container plus one (`NULL` if there's no container).
+ */
+typedef struct {
+    test_diff_t                           *diff;
+    const char                            *results, *expected;
+    const query_output_container_reader_t *container;
+    GHashTable                            *container_files;
+} test_diff_compare_data_t;
+
+/**
+ * @brief   Compares a range of the files common to both directories, in a ::parallel_for thread.
+ * @details Each thread writes to a disjoint range of ::test_diff::common_file_errors.
+ *
+ * @param user_data A pointer to a ::test_diff_compare_data_t.
+ * @param begin     Index of the first file in ::test_diff::common_files to compare.
+ * @param end       Index after the last file in ::test_diff::common_files to compare.
+ *
+ * @return Always `0`, as IO errors are reported per file.
+ */
+int __test_diff_compare_range(void *user_data, size_t begin, size_t end) {
+    const test_diff_compare_data_t *const data = user_data;
+
+    for (size_t i = begin; i < end; ++i) {
+        const char *const file_name = g_ptr_array_index(data->diff->common_files, i);
+
+        char expected_path[PATH_MAX];
+        snprintf(expected_path, PATH_MAX, "%s/%s", data->expected, file_name);
+
+        const size_t container_index =
+            data->container_files
+                ? GPOINTER_TO_SIZE(g_hash_table_lookup(data->container_files, file_name))
+                : 0;
+
+        if (container_index) {
+            uint64_t    id;
+            const char *payload;
+            size_t      length;
+            query_output_container_reader_get_entry(data->container,
+                                                    container_index - 1,
+                                                    &id,
+                                                    &payload,
+                                                    &length);
+
+            data->diff->common_file_errors[i] =
+                __test_diff_compare_contents(payload, length, expected_path);
+        } else {
+            char result_path[PATH_MAX];
+            snprintf(result_path, PATH_MAX, "%s/%s", data->results, file_name);
+            data->diff->common_file_errors[i] =
+                __test_diff_compare_files(result_path, expected_path);
         }
     }
-
-    if (ret == 0 && result_len != expected_len)
-        ret = line;
-
-    free(result_contents);
-    free(expected_contents);
-    return ret;
+    return 0;
 }
 
-test_diff_t *test_diff_create(const char *results, const char *expected) {
+/**
+ * @brief Generates the difference between the program's results and a directory of expected
+ *        results.
+ *
+ * @param results         Directory where the program's output was placed into.
+ * @param results_files   Lexicographically sorted array of the names of the files the program
+ *                        outputted (`char *`).
+ * @param container       Container with some of the program's outputs. Can be `NULL`.
+ * @param container_files See ::test_diff_compare_data_t::container_files.
+ * @param expected        Directory containing expected program results.
+ *
+ * @return A valid pointer to a ::test_diff_t, that must be `free`d with ::test_diff_free, or
+ *         `NULL` in case of either an allocation or IO error.
+ */
+test_diff_t *__test_diff_create(const char                            *results,
+                                GPtrArray                             *results_files,
+                                const query_output_container_reader_t *container,
+                                GHashTable                            *container_files,
+                                const char                            *expected) {
     test_diff_t *const diff = malloc(sizeof(test_diff_t));
     if (!diff)
         return NULL;
@@ -249,7 +317,7 @@ test_diff_t *test_diff_create(const char *results, const char *expected) {
     diff->common_files       = g_ptr_array_new_with_free_func((GDestroyNotify) free);
     diff->common_file_errors = NULL;
 
-    if (__test_diff_common_files(results,
+    if (__test_diff_common_files(results_files,
                                  expected,
                                  diff->common_files,
                                  diff->extra_files,
@@ -264,15 +332,83 @@ test_diff_t *test_diff_create(const char *results, const char *expected) {
         return NULL;
     }
 
-    for (guint i = 0; i < diff->common_files->len; ++i) {
-        const char *const file_name = g_ptr_array_index(diff->common_files, i);
+    const long   ncpus    = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t nthreads = ncpus > 0 ? (size_t) ncpus : 1;
+
+    test_diff_compare_data_t data = {.diff            = diff,
+                                     .results         = results,
+                                     .expected        = expected,
+                                     .container       = container,
+                                     .container_files = container_files};
+    void                    *thread_data[nthreads];
+    for (size_t i = 0; i < nthreads; ++i)
+        thread_data[i] = &data;
+
+    parallel_for(diff->common_files->len, nthreads, __test_diff_compare_range, thread_data);
+    return diff;
+}
+
+test_diff_t *test_diff_create(const char *results, const char *expected) {
+    GPtrArray *const results_files = __test_diff_read_dir(results);
+    if (!results_files)
+        return NULL;
+
+    test_diff_t *const diff = __test_diff_create(results, results_files, NULL, NULL, expected);
+    g_ptr_array_unref(results_files);
+    return diff;
+}
 
-        char result_path[PATH_MAX], expected_path[PATH_MAX];
-        snprintf(result_path, PATH_MAX, "%s/%s", results, file_name);
-        snprintf(expected_path, PATH_MAX, "%s/%s", expected, file_name);
+test_diff_t *test_diff_create_with_container(const char *results,
+                                             const char *container_path,
+                                             const char *expected) {
+    test_diff_t *diff = NULL;
+
+    query_output_container_reader_t *const container =
+        query_output_container_reader_open(container_path);
+    if (!container)
+        goto DEFER_1;
+
+    GPtrArray *const results_files = __test_diff_read_dir(results);
+    if (!results_files)
+        goto DEFER_2;
+
+    /* The container itself isn't an output of the program */
+    for (guint i = 0; i < results_files->len; ++i) {
+        char path[PATH_MAX];
+        snprintf(path, PATH_MAX, "%s/%s", results, (char *) g_ptr_array_index(results_files, i));
+        if (strcmp(path, container_path) == 0) {
+            g_ptr_array_remove_index(results_files, i);
+            break;
+        }
+    }
 
-        diff->common_file_errors[i] = __test_diff_compare_files(result_path, expected_path);
+    /* Name entries after the files that batch mode would have created without a container */
+    GHashTable *const container_files = g_hash_table_new(g_str_hash, g_str_equal);
+    const size_t      count           = query_output_container_reader_get_count(container);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t    id;
+        const char *payload;
+        size_t      length;
+        query_output_container_reader_get_entry(container, i, &id, &payload, &length);
+
+        char name[PATH_MAX];
+        snprintf(name, PATH_MAX, "command%" PRIu64 "_output.txt", id);
+        if (g_hash_table_contains(container_files, name))
+            continue; /* Repeated identifiers (invalid container) */
+
+        char *const name_copy = strdup(name);
+        g_ptr_array_add(results_files, name_copy);
+        g_hash_table_insert(container_files, name_copy, GSIZE_TO_POINTER(i + 1));
     }
+    g_ptr_array_sort(results_files, __test_diff_read_dir_sort_compare);
+
+    diff = __test_diff_create(results, results_files, container, container_files, expected);
+
+    g_hash_table_unref(container_files); /* Keys are owned by results_files */
+    g_ptr_array_unref(results_files);
+DEFER_2:
+    query_output_container_reader_close(container);
+DEFER_1:
     return diff;
 }
 
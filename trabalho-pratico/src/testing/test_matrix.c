@@ -0,0 +1,713 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  test_matrix.c
+ * @brief Implementation of methods in include/testing/test_matrix.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref test_matrix_examples).
+ */
+
+#include <errno.h>
+#include <glib.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "batch_mode.h"
+#include "dataset/dataset_loader.h"
+#include "queries/query_dispatcher.h"
+#include "queries/query_file_compiler.h"
+#include "testing/performance_metrics_output.h"
+#include "testing/test_diff_output.h"
+#include "testing/test_matrix.h"
+#include "utils/int_utils.h"
+#include "utils/thread_count.h"
+
+/**
+ * @struct test_matrix_case_t
+ * @brief  A test case in a ::test_matrix_t.
+ *
+ * @var test_matrix_case_t::dataset
+ *     @brief Path to the directory containing the dataset.
+ * @var test_matrix_case_t::queries
+ *     @brief Path to the query file.
+ * @var test_matrix_case_t::expected
+ *     @brief Path to the directory containing the expected results.
+ */
+typedef struct {
+    char *dataset, *queries, *expected;
+} test_matrix_case_t;
+
+/**
+ * @struct test_matrix
+ * @brief  Test cases read from a manifest file.
+ *
+ * @var test_matrix::cases
+ *     @brief Array of ::test_matrix_case_t, in the order they appear in the manifest.
+ */
+struct test_matrix {
+    GArray *cases;
+};
+
+/**
+ * @struct test_matrix_result_t
+ * @brief  Summary of the results of a test case, sent by the process that ran it to its parent.
+ *
+ * @var test_matrix_result_t::failed
+ *     @brief Whether the test case failed to run (its other fields are then meaningless).
+ * @var test_matrix_result_t::correct
+ *     @brief Number of files equal to the expected ones.
+ * @var test_matrix_result_t::incorrect
+ *     @brief Number of files different from the expected ones (or that failed to be read).
+ * @var test_matrix_result_t::missing
+ *     @brief Number of expected files that weren't generated.
+ * @var test_matrix_result_t::extra
+ *     @brief Number of generated files that weren't expected.
+ * @var test_matrix_result_t::time
+ *     @brief CPU time of the process that ran the test case, in microseconds.
+ * @var test_matrix_result_t::memory
+ *     @brief Peak memory usage of the process that ran the test case, in KiB.
+ */
+typedef struct {
+    int      failed;
+    size_t   correct, incorrect, missing, extra;
+    uint64_t time;
+    size_t   memory;
+} test_matrix_result_t;
+
+/**
+ * @struct test_matrix_job_t
+ * @brief  Process running a test case.
+ *
+ * @var test_matrix_job_t::started
+ *     @brief Whether the test case has already been started (or skipped, on failure).
+ * @var test_matrix_job_t::pid
+ *     @brief Identifier of the process running the test case (`0` if it isn't running).
+ * @var test_matrix_job_t::pipe
+ *     @brief Reading end of the pipe where the process writes its ::test_matrix_job_t::result to.
+ * @var test_matrix_job_t::result
+ *     @brief Results of the test case, once its process exits.
+ */
+typedef struct {
+    int                  started;
+    pid_t                pid;
+    int                  pipe;
+    test_matrix_result_t result;
+} test_matrix_job_t;
+
+/**
+ * @brief   Parses a line of a manifest file and adds its test case to a test matrix.
+ * @details Auxiliary method for ::test_matrix_load.
+ *
+ * @param matrix Test matrix to add the test case to.
+ * @param line   Line of the manifest file, without its line break. Modified while being parsed.
+ *
+ * @retval 0 Success (or empty line / comment).
+ * @retval 1 The line doesn't have exactly three fields.
+ */
+int __test_matrix_add_line(test_matrix_t *matrix, char *line) {
+    char *fields[3], *save_ptr = NULL, *token = strtok_r(line, " \t", &save_ptr);
+    if (!token || *token == '#')
+        return 0;
+
+    size_t n = 0;
+    for (; token; token = strtok_r(NULL, " \t", &save_ptr)) {
+        if (n == 3)
+            return 1;
+        fields[n++] = token;
+    }
+    if (n != 3)
+        return 1;
+
+    const test_matrix_case_t test_case = {.dataset  = g_strdup(fields[0]),
+                                          .queries  = g_strdup(fields[1]),
+                                          .expected = g_strdup(fields[2])};
+    g_array_append_val(matrix->cases, test_case);
+    return 0;
+}
+
+test_matrix_t *test_matrix_load(const char *path) {
+    FILE *const file = fopen(path, "r");
+    if (!file)
+        return NULL;
+
+    test_matrix_t *const matrix = malloc(sizeof(test_matrix_t));
+    if (!matrix) {
+        fclose(file);
+        return NULL;
+    }
+    matrix->cases = g_array_new(FALSE, FALSE, sizeof(test_matrix_case_t));
+
+    int    retval = 0;
+    char  *line   = NULL;
+    size_t size   = 0;
+    while (!retval) {
+        ssize_t length = getline(&line, &size, file);
+        if (length < 0)
+            break;
+
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
+        retval = __test_matrix_add_line(matrix, line);
+    }
+
+    retval |= ferror(file) != 0;
+    free(line);
+    fclose(file);
+
+    if (retval) {
+        test_matrix_free(matrix);
+        return NULL;
+    }
+    return matrix;
+}
+
+size_t test_matrix_get_length(const test_matrix_t *matrix) {
+    return matrix->cases->len;
+}
+
+/**
+ * @struct test_matrix_writers_data_t
+ * @brief  Data used to create the writers of a test case's queries, in
+ *         ::__test_matrix_create_writer_callback.
+ *
+ * @var test_matrix_writers_data_t::container
+ *     @brief Container where query outputs are written to.
+ * @var test_matrix_writers_data_t::outputs
+ *     @brief Where to write created query writers to.
+ * @var test_matrix_writers_data_t::i
+ *     @brief Number of writers already created.
+ */
+typedef struct {
+    query_output_container_t *const container;
+    query_writer_t **const          outputs;
+    size_t                          i;
+} test_matrix_writers_data_t;
+
+/**
+ * @brief Called for each query of a test case, to create the writer its output is written to.
+ *
+ * @param user_data A pointer to a ::test_matrix_writers_data_t.
+ * @param instance  Query whose output will be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __test_matrix_create_writer_callback(void *user_data, const query_instance_t *instance) {
+    test_matrix_writers_data_t *const data = user_data;
+
+    query_writer_t *const writer =
+        query_writer_create_in_container(data->container,
+                                         query_instance_get_line_in_file(instance),
+                                         query_instance_get_formatted(instance));
+    if (!writer)
+        return 1;
+
+    data->outputs[data->i++] = writer;
+    return 0;
+}
+
+/**
+ * @brief   Executes the queries of a test case, writing their outputs to a container.
+ * @details Auxiliary method for ::__test_matrix_run_case.
+ *
+ * @param database       Database to execute the queries on.
+ * @param query_file     Path to the query file.
+ * @param container_path Path to the container where to write the outputs of the queries to.
+ * @param metrics        Where to register query performance data to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message will also be printed to `stderr`.
+ */
+int __test_matrix_execute(const database_t      *database,
+                          const char            *query_file,
+                          const char            *container_path,
+                          performance_metrics_t *metrics) {
+    int retval = 0;
+
+    query_instance_list_t *const query_instance_list =
+        query_file_compiler_load_or_parse(query_file);
+    if (!query_instance_list) {
+        fprintf(stderr, "Failed to read query file \"%s\"!\n", query_file);
+        return 1;
+    }
+
+    query_output_container_t *const container = query_output_container_create(container_path);
+    if (!container) {
+        retval = 1;
+        fputs("Failed to create query output container!\n", stderr);
+        goto DEFER_1;
+    }
+
+    const size_t           length  = query_instance_list_get_length(query_instance_list);
+    query_writer_t **const outputs = malloc(sizeof(query_writer_t *) * length);
+    if (!outputs) {
+        retval = 1;
+        fputs("Failed to allocate list of query outputs!\n", stderr);
+        goto DEFER_2;
+    }
+
+    test_matrix_writers_data_t data = {.container = container, .outputs = outputs, .i = 0};
+    if (query_instance_list_iter(query_instance_list,
+                                 __test_matrix_create_writer_callback,
+                                 &data)) {
+        retval = 1;
+        fputs("Failed to open one of the query outputs!\n", stderr);
+    } else {
+        query_dispatcher_dispatch_list(database, NULL, query_instance_list, outputs, 1, metrics);
+        performance_metrics_measure_database_memory(metrics, database);
+    }
+
+    for (size_t i = 0; i < data.i; ++i)
+        query_writer_free(outputs[i]);
+    free(outputs);
+
+    if (!retval && query_output_container_close(container)) {
+        retval = 1;
+        fputs("Failed to write query output container!\n", stderr);
+    }
+
+DEFER_2:
+    query_output_container_free(container);
+DEFER_1:
+    query_instance_list_free(query_instance_list);
+    return retval;
+}
+
+/**
+ * @brief   Counts the files in each category of a ::test_diff_t.
+ * @details Auxiliary method for ::__test_matrix_run_case.
+ *
+ * @param diff   Differences between the generated and the expected results of a test case.
+ * @param result Where to write the number of files in each category to.
+ */
+void __test_matrix_summarize_diff(const test_diff_t *diff, test_matrix_result_t *result) {
+    test_diff_get_extra_files(diff, &result->extra);
+    test_diff_get_missing_files(diff, &result->missing);
+
+    const char *const *common;
+    const ssize_t     *errors;
+    const size_t       ncommon = test_diff_get_common_file_errors(diff, &common, &errors);
+
+    result->correct = result->incorrect = 0;
+    for (size_t i = 0; i < ncommon; ++i) {
+        if (errors[i])
+            result->incorrect++;
+        else
+            result->correct++;
+    }
+}
+
+/**
+ * @brief   Runs a test case, in the process forked for it.
+ * @details Writes the test case's report to ::TEST_MATRIX_CASE_REPORT_PATH_FORMAT.
+ *
+ * @param database     Database loaded from the test case's dataset.
+ * @param load_metrics Metrics of loading @p database, to which query metrics are added.
+ * @param test_case    Test case to be run.
+ * @param i            Index of @p test_case in its ::test_matrix_t.
+ * @param results_dir  Directory where the dataset's error files were written to.
+ * @param result       Where to write the summary of the results of @p test_case to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure. A message will also be printed to `stderr`.
+ */
+int __test_matrix_run_case(const database_t            *database,
+                           const performance_metrics_t *load_metrics,
+                           const test_matrix_case_t    *test_case,
+                           size_t                       i,
+                           const char                  *results_dir,
+                           test_matrix_result_t        *result) {
+    int retval = 1;
+
+    performance_metrics_t *const metrics = performance_metrics_clone(load_metrics);
+    if (!metrics) {
+        fputs("Failed to allocate performance metrics!\n", stderr);
+        return 1;
+    }
+
+    char container_path[PATH_MAX], report_path[PATH_MAX];
+    snprintf(container_path, PATH_MAX, TEST_MATRIX_CASE_CONTAINER_PATH_FORMAT, i);
+    snprintf(report_path, PATH_MAX, TEST_MATRIX_CASE_REPORT_PATH_FORMAT, i);
+
+    if (__test_matrix_execute(database, test_case->queries, container_path, metrics))
+        goto DEFER_1;
+    performance_metrics_measure_whole_program(metrics);
+
+    test_diff_t *const diff =
+        test_diff_create_with_container(results_dir, container_path, test_case->expected);
+    if (!diff) {
+        fputs("Failed to compare generated and expected results!\n", stderr);
+        goto DEFER_1;
+    }
+
+    FILE *const report = fopen(report_path, "w");
+    if (!report) {
+        fprintf(stderr, "Failed to write test case report to \"%s\"!\n", report_path);
+        goto DEFER_2;
+    }
+
+    performance_metrics_output_print(report, metrics);
+    test_diff_output_print(report, diff);
+    if (!fclose(report)) {
+        __test_matrix_summarize_diff(diff, result);
+        result->time   = performance_metrics_get_program_total_time(metrics);
+        result->memory = performance_metrics_get_program_total_mem(metrics);
+        retval         = 0;
+    }
+
+DEFER_2:
+    test_diff_free(diff);
+DEFER_1:
+    performance_metrics_free(metrics);
+    return retval;
+}
+
+/**
+ * @brief Forks a process to run a test case.
+ *
+ * @param database     Database loaded from the test case's dataset.
+ * @param load_metrics Metrics of loading @p database.
+ * @param test_case    Test case to be run.
+ * @param i            Index of @p test_case in its ::test_matrix_t.
+ * @param results_dir  Directory where the dataset's error files were written to.
+ * @param job          Where to register the started process to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure to start the process. A message will also be printed to `stderr`.
+ */
+int __test_matrix_start_case(const database_t            *database,
+                             const performance_metrics_t *load_metrics,
+                             const test_matrix_case_t    *test_case,
+                             size_t                       i,
+                             const char                  *results_dir,
+                             test_matrix_job_t           *job) {
+    int fds[2];
+    if (pipe(fds)) {
+        fputs("Failed to start test case!\n", stderr);
+        return 1;
+    }
+
+    /* Pending output would be written once by every process */
+    fflush(stdout);
+    fflush(stderr);
+
+    job->pid = fork();
+    if (job->pid < 0) {
+        job->pid = 0;
+        close(fds[0]);
+        close(fds[1]);
+        fputs("Failed to start test case!\n", stderr);
+        return 1;
+    } else if (job->pid == 0) {
+        close(fds[0]);
+
+        test_matrix_result_t result = {.failed = 0};
+        result.failed =
+            __test_matrix_run_case(database, load_metrics, test_case, i, results_dir, &result);
+
+        /* A single write smaller than PIPE_BUF is atomic */
+        const int failed = write(fds[1], &result, sizeof(test_matrix_result_t)) !=
+                           (ssize_t) sizeof(test_matrix_result_t);
+        _exit(failed || result.failed); /* Don't free the database shared with the parent */
+    }
+
+    close(fds[1]);
+    job->pipe = fds[0];
+    return 0;
+}
+
+/**
+ * @brief   Waits for any running test case to finish, and reads its results.
+ * @details Test cases whose process didn't report results are marked as failed.
+ *
+ * @param n    Number of test cases in @p jobs.
+ * @param jobs Processes of all test cases.
+ *
+ * @retval 0 A test case finished.
+ * @retval 1 No test cases are running.
+ */
+int __test_matrix_wait(size_t n, test_matrix_job_t jobs[n]) {
+    int   status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, 0)) < 0)
+        if (errno != EINTR)
+            return 1;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (jobs[i].pid != pid)
+            continue;
+
+        const ssize_t length = read(jobs[i].pipe, &jobs[i].result, sizeof(test_matrix_result_t));
+        if (length != (ssize_t) sizeof(test_matrix_result_t) || !WIFEXITED(status) ||
+            WEXITSTATUS(status))
+            jobs[i].result.failed = 1;
+
+        close(jobs[i].pipe);
+        jobs[i].pid = 0;
+        break;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Creates ::TEST_MATRIX_DIRECTORY (and its parent directory).
+ * @details Auxiliary method for ::test_matrix_run.
+ *
+ * @retval 0 Success (or the directory already exists).
+ * @retval 1 Failure. A message will also be printed to `stderr`.
+ */
+int __test_matrix_create_directory(void) {
+    if ((mkdir("Resultados", 0755) && errno != EEXIST) ||
+        (mkdir(TEST_MATRIX_DIRECTORY, 0755) && errno != EEXIST)) {
+        fputs("Failed to create directory \"" TEST_MATRIX_DIRECTORY "\"!\n", stderr);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Loads a dataset and starts running all of its test cases.
+ * @details Auxiliary method for ::test_matrix_run. Test cases after @p first that use the same
+ *          dataset are started too, waiting for others to finish when @p njobs are running.
+ *
+ * @param matrix  Test cases being run.
+ * @param jobs    Processes of all test cases in @p matrix.
+ * @param first   Index of the first test case of the dataset.
+ * @param njobs   Maximum number of test cases running at once.
+ * @param mode    How to measure the performance of each case.
+ * @param running Number of test cases running. Updated as cases start and finish.
+ *
+ * @retval 0 Success.
+ * @retval 1 Failure to load the dataset or to start some test case. A message will also be printed
+ *           to `stderr`.
+ */
+int __test_matrix_run_dataset(const test_matrix_t     *matrix,
+                              test_matrix_job_t       *jobs,
+                              size_t                   first,
+                              size_t                   njobs,
+                              performance_event_mode_t mode,
+                              size_t                  *running) {
+    const size_t      n       = matrix->cases->len;
+    const char *const dataset = g_array_index(matrix->cases, test_matrix_case_t, first).dataset;
+
+    char results_dir[PATH_MAX], snapshot_path[PATH_MAX];
+    snprintf(results_dir, PATH_MAX, TEST_MATRIX_DIRECTORY "/dataset%zu", first);
+    snprintf(snapshot_path, PATH_MAX, "%s/" BATCH_MODE_SNAPSHOT_FILE_NAME, dataset);
+
+    int                          retval   = 0;
+    database_t                  *database = NULL;
+    performance_metrics_t *const metrics  = performance_metrics_create_with_mode(mode);
+    if (metrics)
+        database = dataset_loader_load_cached(dataset, results_dir, snapshot_path, metrics);
+    if (!database) {
+        retval = 1;
+        fprintf(stderr, "Failed to load dataset \"%s\"!\n", dataset);
+    }
+
+    for (size_t i = first; i < n; ++i) {
+        const test_matrix_case_t *const test_case =
+            &g_array_index(matrix->cases, test_matrix_case_t, i);
+        if (jobs[i].started || strcmp(test_case->dataset, dataset))
+            continue;
+
+        jobs[i].started       = 1;
+        jobs[i].result.failed = 1;
+        if (!database)
+            continue;
+
+        while (*running >= njobs)
+            *running = __test_matrix_wait(n, jobs) ? 0 : *running - 1;
+
+        if (__test_matrix_start_case(database, metrics, test_case, i, results_dir, &jobs[i]))
+            retval = 1;
+        else
+            (*running)++;
+    }
+
+    /* Processes of test cases have their own copies of the database */
+    if (database)
+        database_free(database);
+    if (metrics)
+        performance_metrics_free(metrics);
+    return retval;
+}
+
+/**
+ * @brief Copies the contents of a file to a stream.
+ *
+ * @param path   Path to the file to be copied.
+ * @param output Where to write the contents of the file to.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO error.
+ */
+int __test_matrix_copy_file(const char *path, FILE *output) {
+    FILE *const input = fopen(path, "r");
+    if (!input)
+        return 1;
+
+    char   buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), input)))
+        fwrite(buffer, 1, length, output);
+
+    const int retval = ferror(input) != 0;
+    fclose(input);
+    return retval;
+}
+
+/**
+ * @brief   Writes the reports of all test cases, followed by a table summarizing them.
+ * @details Auxiliary method for ::test_matrix_run.
+ *
+ * @param matrix Test cases that were run.
+ * @param jobs   Results of all test cases in @p matrix.
+ * @param report Where to write the reports to.
+ */
+void __test_matrix_write_report(const test_matrix_t     *matrix,
+                                const test_matrix_job_t *jobs,
+                                FILE                    *report) {
+    const int    tty = isatty(fileno(report));
+    const size_t n   = matrix->cases->len;
+
+    for (size_t i = 0; i < n; ++i) {
+        const test_matrix_case_t *const test_case =
+            &g_array_index(matrix->cases, test_matrix_case_t, i);
+        fprintf(report, tty ? "\x1b[1;4mTEST CASE %zu\x1b[22;24m\n\n" : "TEST CASE %zu\n\n", i);
+        fprintf(report,
+                "Dataset: %s\nQueries: %s\nExpected: %s\n\n",
+                test_case->dataset,
+                test_case->queries,
+                test_case->expected);
+
+        char report_path[PATH_MAX];
+        snprintf(report_path, PATH_MAX, TEST_MATRIX_CASE_REPORT_PATH_FORMAT, i);
+        if (jobs[i].result.failed || __test_matrix_copy_file(report_path, report))
+            fputs("Failed to run test case!\n\n", report);
+    }
+
+    fputs(tty ? "\x1b[1;4mSUMMARY\x1b[22;24m\n\n" : "SUMMARY\n\n", report);
+    fprintf(report,
+            "%6s  %-6s  %9s  %9s  %9s  %9s  %13s  %12s\n",
+            "Case",
+            "Result",
+            "Correct",
+            "Incorrect",
+            "Missing",
+            "Extra",
+            "CPU time (ms)",
+            "Memory (KiB)");
+
+    test_matrix_result_t total   = {.failed = 0};
+    size_t               npassed = 0, nfailed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const test_matrix_result_t *const result = &jobs[i].result;
+        if (result->failed) {
+            fprintf(report, "%6zu  %-6s\n", i, "ERROR");
+            nfailed++;
+            continue;
+        }
+
+        const int passed = !result->incorrect && !result->missing;
+        fprintf(report,
+                "%6zu  %-6s  %9zu  %9zu  %9zu  %9zu  %13.3f  %12zu\n",
+                i,
+                passed ? "PASS" : "FAIL",
+                result->correct,
+                result->incorrect,
+                result->missing,
+                result->extra,
+                (double) result->time / 1000.0,
+                result->memory);
+
+        npassed += passed;
+        total.correct += result->correct;
+        total.incorrect += result->incorrect;
+        total.missing += result->missing;
+        total.extra += result->extra;
+        total.time += result->time;
+        total.memory = max(total.memory, result->memory);
+    }
+
+    fprintf(report,
+            "%6s  %-6s  %9zu  %9zu  %9zu  %9zu  %13.3f  %12zu\n\n",
+            "Total",
+            "",
+            total.correct,
+            total.incorrect,
+            total.missing,
+            total.extra,
+            (double) total.time / 1000.0,
+            total.memory);
+    fprintf(report,
+            "%zu of %zu test cases passed (%zu failed to run).\n",
+            npassed,
+            n,
+            nfailed);
+}
+
+int test_matrix_run(const test_matrix_t     *matrix,
+                    size_t                   njobs,
+                    performance_event_mode_t mode,
+                    FILE                    *report) {
+    if (__test_matrix_create_directory())
+        return 1;
+
+    const size_t             n    = matrix->cases->len;
+    test_matrix_job_t *const jobs = calloc(n ? n : 1, sizeof(test_matrix_job_t));
+    if (!jobs) {
+        fputs("Failed to allocate test case processes!\n", stderr);
+        return 1;
+    }
+
+    /* Test cases of the same dataset are started together, so that it's only loaded once */
+    int    retval  = 0;
+    size_t running = 0;
+    njobs          = njobs ? njobs : thread_count_get();
+    for (size_t i = 0; i < n; ++i)
+        if (!jobs[i].started)
+            retval |= __test_matrix_run_dataset(matrix, jobs, i, njobs, mode, &running);
+
+    for (; running; --running)
+        if (__test_matrix_wait(n, jobs))
+            break;
+
+    for (size_t i = 0; i < n; ++i)
+        retval |= jobs[i].result.failed;
+
+    __test_matrix_write_report(matrix, jobs, report);
+    free(jobs);
+    return retval;
+}
+
+void test_matrix_free(test_matrix_t *matrix) {
+    for (size_t i = 0; i < matrix->cases->len; ++i) {
+        test_matrix_case_t *const test_case = &g_array_index(matrix->cases, test_matrix_case_t, i);
+        g_free(test_case->dataset);
+        g_free(test_case->queries);
+        g_free(test_case->expected);
+    }
+    g_array_free(matrix->cases, TRUE);
+    free(matrix);
+}
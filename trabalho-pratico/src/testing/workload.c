@@ -0,0 +1,218 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  workload.c
+ * @brief Implementation of methods in include/testing/workload.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref workload_examples).
+ */
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "testing/workload.h"
+#include "utils/int_utils.h"
+
+/**
+ * @struct workload_recorder
+ * @brief  Writes queries to a workload file, as they arrive.
+ *
+ * @var workload_recorder::file
+ *     @brief Workload file being written.
+ * @var workload_recorder::start
+ *     @brief When recording started (`CLOCK_MONOTONIC`).
+ */
+struct workload_recorder {
+    FILE           *file;
+    struct timespec start;
+};
+
+/**
+ * @struct workload_entry_t
+ * @brief  A query in a ::workload_t.
+ *
+ * @var workload_entry_t::time
+ *     @brief Time the query arrived, in microseconds since the start of the recording.
+ * @var workload_entry_t::query
+ *     @brief Null-terminated query.
+ */
+typedef struct {
+    uint64_t time;
+    char    *query;
+} workload_entry_t;
+
+/**
+ * @struct workload
+ * @brief  Queries read from a workload file (or from a query file).
+ *
+ * @var workload::entries
+ *     @brief Queries (::workload_entry_t), in the order they were read.
+ * @var workload::has_times
+ *     @brief Whether the queries were read with their arrival times.
+ */
+struct workload {
+    GArray *entries;
+    int     has_times;
+};
+
+workload_recorder_t *workload_recorder_create(const char *path) {
+    workload_recorder_t *const recorder = malloc(sizeof(workload_recorder_t));
+    if (!recorder)
+        return NULL;
+
+    recorder->file = fopen(path, "w");
+    if (!recorder->file) {
+        free(recorder);
+        return NULL;
+    }
+
+    if (fputs(WORKLOAD_FILE_HEADER "\n", recorder->file) == EOF) {
+        fclose(recorder->file);
+        free(recorder);
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &recorder->start);
+    return recorder;
+}
+
+int workload_recorder_record(workload_recorder_t *recorder, const char *query, size_t length) {
+    if (memchr(query, '\n', length) || memchr(query, '\r', length))
+        return 0;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t time = (now.tv_sec - recorder->start.tv_sec) * 1000000 +
+                         (now.tv_nsec - recorder->start.tv_nsec) / 1000;
+
+    return fprintf(recorder->file, "%" PRId64 " ", time) < 0 ||
+           fwrite(query, 1, length, recorder->file) != length ||
+           fputc('\n', recorder->file) == EOF;
+}
+
+int workload_recorder_flush(workload_recorder_t *recorder) {
+    return fflush(recorder->file) != 0;
+}
+
+int workload_recorder_free(workload_recorder_t *recorder) {
+    const int retval = fclose(recorder->file) != 0;
+    free(recorder);
+    return retval;
+}
+
+/**
+ * @brief   Adds a line of a workload file (or of a query file) to a workload.
+ * @details Auxiliary method for ::workload_load.
+ *
+ * @param workload Workload to add the line's query to.
+ * @param line     Line without a line terminator, modified by this function.
+ *
+ * @retval 0 Success.
+ * @retval 1 Line without an arrival time, or with a time before the previous query's.
+ */
+int __workload_add_line(workload_t *workload, char *line) {
+    workload_entry_t entry = {.time = 0, .query = line};
+    if (workload->has_times) {
+        char *const space = strchr(line, ' ');
+        if (!space)
+            return 1;
+
+        *space = '\0';
+        if (int_utils_parse_positive(&entry.time, line))
+            return 1;
+        entry.query = space + 1;
+
+        if (workload->entries->len &&
+            g_array_index(workload->entries, workload_entry_t, workload->entries->len - 1).time >
+                entry.time)
+            return 1;
+    }
+
+    entry.query = g_strdup(entry.query);
+    g_array_append_val(workload->entries, entry);
+    return 0;
+}
+
+workload_t *workload_load(const char *path) {
+    FILE *const file = fopen(path, "r");
+    if (!file)
+        return NULL;
+
+    workload_t *const workload = malloc(sizeof(workload_t));
+    if (!workload) {
+        fclose(file);
+        return NULL;
+    }
+    workload->entries   = g_array_new(FALSE, FALSE, sizeof(workload_entry_t));
+    workload->has_times = 0;
+
+    int    retval = 0;
+    char  *line   = NULL;
+    size_t size   = 0;
+    for (size_t i = 0; !retval; ++i) {
+        ssize_t length = getline(&line, &size, file);
+        if (length < 0)
+            break;
+
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
+
+        if (i == 0 && strcmp(line, WORKLOAD_FILE_HEADER) == 0)
+            workload->has_times = 1;
+        else if (length > 0)
+            retval = __workload_add_line(workload, line);
+    }
+
+    retval |= ferror(file) != 0;
+    free(line);
+    fclose(file);
+
+    if (retval) {
+        workload_free(workload);
+        return NULL;
+    }
+    return workload;
+}
+
+size_t workload_get_length(const workload_t *workload) {
+    return workload->entries->len;
+}
+
+int workload_has_times(const workload_t *workload) {
+    return workload->has_times;
+}
+
+const char *workload_get_query(const workload_t *workload, size_t i) {
+    return g_array_index(workload->entries, workload_entry_t, i).query;
+}
+
+uint64_t workload_get_time(const workload_t *workload, size_t i) {
+    return g_array_index(workload->entries, workload_entry_t, i).time;
+}
+
+void workload_free(workload_t *workload) {
+    for (size_t i = 0; i < workload->entries->len; ++i)
+        g_free(g_array_index(workload->entries, workload_entry_t, i).query);
+    g_array_free(workload->entries, TRUE);
+    free(workload);
+}
@@ -19,22 +19,27 @@
  * @brief Implementation of methods in include/types/account_status.h
  */
 
-/** @cond FALSE */
-#ifndef _BSD_SOURCE
-    /* Expose strcasecmp */
-    #define _BSD_SOURCE
-#endif
-/** @endcond */
-
 #include <string.h>
 
 #include "types/account_status.h"
 
 int account_status_from_string(account_status_t *output, const char *input) {
-    if (strcasecmp(input, "inactive") == 0) {
+    /*
+     * Case-insensitive comparison in a single pass. Setting 0x20 lowercases letters, and, as both
+     * valid values are made of letters only, no other character can be mistaken for one of them.
+     */
+    char   lowercase[8];
+    size_t length = 0;
+    for (; input[length]; ++length) {
+        if (length == sizeof(lowercase))
+            return 1; /* Longer than "inactive" */
+        lowercase[length] = input[length] | 0x20;
+    }
+
+    if (length == 8 && memcmp(lowercase, "inactive", 8) == 0) {
         *output = ACCOUNT_STATUS_INACTIVE;
         return 0;
-    } else if (strcasecmp(input, "active") == 0) {
+    } else if (length == 6 && memcmp(lowercase, "active", 6) == 0) {
         *output = ACCOUNT_STATUS_ACTIVE;
         return 0;
     } else {
@@ -26,6 +26,23 @@
 
 #include "types/flight.h"
 
+#ifdef PACKED_RECORDS
+/** @brief Type of the dates in a ::flight_t: seconds since ::FLIGHT_PACKED_DATE_EPOCH. */
+typedef uint32_t flight_date_t;
+
+/** @brief Latest date that can be stored in a ::flight_t, used when resetting dates. */
+#define FLIGHT_DATE_LATEST UINT32_MAX
+#else
+/** @brief Type of the dates in a ::flight_t. */
+typedef date_and_time_t flight_date_t;
+
+/**
+ * @brief Latest date that can be stored in a ::flight_t, used when resetting dates.
+ * @details date_and_time_diff is a signed subtraction, so it must fit in an `int64_t`.
+ */
+#define FLIGHT_DATE_LATEST 0x7FFFFFFFFFFFFFFF
+#endif
+
 /**
  * @struct  flight
  * @brief   A flight.
@@ -33,9 +50,9 @@
  *          and notes) aren't put here, as they aren't required by any of the queries.
  *
  * @var flight::airline
- *     @brief Airline of a given flight.
+ *     @brief Code of the airline of a given flight, in a ::string_dictionary_t.
  * @var flight::plane_model
- *     @brief Plane model of a given flight.
+ *     @brief Code of the plane model of a given flight, in a ::string_dictionary_t.
  * @var flight::origin
  *     @brief Origin airport of a given flight.
  * @var flight::destination
@@ -43,7 +60,9 @@
  * @var flight::id
  *     @brief Identifier of a given flight.
  * @var flight::schedule_departure_date
- *     @brief Scheduled departure date of a given flight.
+ *     @brief   Scheduled departure date of a given flight.
+ *     @details Dates are stored as ::flight_date_t, and must be converted with
+ *              ::__flight_date_encode and ::__flight_date_decode.
  * @var flight::real_departure_date
  *     @brief Real departure date of a given flight.
  * @var flight::schedule_arrival_date
@@ -55,36 +74,64 @@
  * @var flight::owns_itself
  *     @brief   Whether, when `free`ing this flight, the flight pointer should be `free`'d.
  *     @details A false value means that the flight is allocated in a pool.
- * @var flight::owns_airline
- *     @brief   Whether ::flight::airline should be `free`d.
- *     @details A false value means that this string is allocated in a pool.
- * @var flight::owns_plane_model
- *     @brief   Whether ::flight::plane_model should be `free`d.
- *     @details A false value means that this string is allocated in a pool.
  */
 struct flight {
-    const char     *airline;
-    const char     *plane_model;
-    date_and_time_t schedule_departure_date;
-    date_and_time_t real_departure_date;
-    date_and_time_t schedule_arrival_date;
-    airport_code_t  origin;
-    airport_code_t  destination;
-    flight_id_t     id;
-    uint16_t        number_of_passengers;
-    uint16_t        total_seats;
-
-    int owns_itself : 1, owns_airline : 1, owns_plane_model : 1;
+    flight_date_t  schedule_departure_date;
+    flight_date_t  real_departure_date;
+    flight_date_t  schedule_arrival_date;
+    airport_code_t origin;
+    airport_code_t destination;
+    flight_id_t    id;
+    uint16_t       number_of_passengers;
+    uint16_t       total_seats;
+    string_code_t  airline;
+    string_code_t  plane_model;
+
+    unsigned int owns_itself : 1;
 };
 
+/**
+ * @brief   Encodes a date to be stored in a ::flight_t.
+ * @details With `PACKED_RECORDS`, dates are stored relative to ::FLIGHT_PACKED_DATE_EPOCH.
+ *
+ * @param date   Date to be encoded.
+ * @param output Where to write the encoded date to.
+ *
+ * @retval 0 Success.
+ * @retval 1 @p date can't be represented.
+ */
+int __flight_date_encode(date_and_time_t date, flight_date_t *output) {
+#ifdef PACKED_RECORDS
+    if (date < FLIGHT_PACKED_DATE_EPOCH || date - FLIGHT_PACKED_DATE_EPOCH > UINT32_MAX)
+        return 1;
+
+    *output = (flight_date_t) (date - FLIGHT_PACKED_DATE_EPOCH);
+#else
+    *output = date;
+#endif
+    return 0;
+}
+
+/**
+ * @brief  Decodes a date stored in a ::flight_t.
+ * @param  date Date encoded by ::__flight_date_encode.
+ * @return The decoded date.
+ */
+date_and_time_t __flight_date_decode(flight_date_t date) {
+#ifdef PACKED_RECORDS
+    return FLIGHT_PACKED_DATE_EPOCH + date;
+#else
+    return date;
+#endif
+}
+
 flight_t *flight_create(pool_t *allocator) {
     flight_t *const ret =
         allocator ? pool_alloc_item(flight_t, allocator) : malloc(sizeof(flight_t));
     if (!ret)
         return NULL;
 
-    ret->owns_itself  = allocator == NULL;
-    ret->owns_airline = ret->owns_plane_model = 0; /* Don't free in first setter call */
+    ret->owns_itself = allocator == NULL;
 
     /* For first comparisons to work */
     flight_reset_schedule_dates(ret);
@@ -92,20 +139,25 @@ flight_t *flight_create(pool_t *allocator) {
     return ret;
 }
 
-flight_t *flight_clone(pool_t                      *allocator,
-                       string_pool_no_duplicates_t *string_allocator,
-                       const flight_t              *flight) {
+flight_t *flight_clone(pool_t                    *allocator,
+                       string_dictionary_t       *strings,
+                       const string_dictionary_t *flight_strings,
+                       const flight_t            *flight) {
 
     flight_t *const ret = flight_create(allocator);
     if (!ret)
         return NULL;
 
     memcpy(ret, flight, sizeof(flight_t));
-    ret->owns_itself  = allocator == NULL;
-    ret->owns_airline = ret->owns_plane_model = 0; /* Don't free in first setter call */
+    ret->owns_itself = allocator == NULL;
+
+    if (strings == flight_strings)
+        return ret;
 
-    if (flight_set_airline(string_allocator, ret, flight->airline) ||
-        flight_set_plane_model(string_allocator, ret, flight->plane_model)) {
+    const char *const airline     = string_dictionary_decode(flight_strings, flight->airline);
+    const char *const plane_model = string_dictionary_decode(flight_strings, flight->plane_model);
+    if (flight_set_airline(strings, ret, airline) ||
+        flight_set_plane_model(strings, ret, plane_model)) {
 
         if (ret->owns_itself)
             free(ret);
@@ -115,44 +167,18 @@ flight_t *flight_clone(pool_t                      *allocator,
     return ret;
 }
 
-int flight_set_airline(string_pool_no_duplicates_t *allocator,
-                       flight_t                    *flight,
-                       const char                  *airline) {
+int flight_set_airline(string_dictionary_t *strings, flight_t *flight, const char *airline) {
     if (!*airline)
         return 1;
-
-    const char *const new_airline =
-        allocator ? string_pool_no_duplicates_put(allocator, airline) : strdup(airline);
-    if (!new_airline)
-        return 1;
-
-    if (flight->owns_airline)
-        /* Purposely remove const. We know it was allocated by this module */
-        free((char *) (size_t) flight->airline);
-    flight->owns_airline = allocator == NULL;
-
-    flight->airline = new_airline;
-    return 0;
+    return string_dictionary_encode(strings, airline, &flight->airline);
 }
 
-int flight_set_plane_model(string_pool_no_duplicates_t *allocator,
-                           flight_t                    *flight,
-                           const char                  *plane_model) {
+int flight_set_plane_model(string_dictionary_t *strings,
+                           flight_t            *flight,
+                           const char          *plane_model) {
     if (!*plane_model)
         return 1;
-
-    const char *const new_plane_model =
-        allocator ? string_pool_no_duplicates_put(allocator, plane_model) : strdup(plane_model);
-    if (!new_plane_model)
-        return 1;
-
-    if (flight->owns_plane_model)
-        /* Purposely remove const. We know it was allocated by this module */
-        free((char *) (size_t) flight->plane_model);
-    flight->owns_plane_model = allocator == NULL;
-
-    flight->plane_model = new_plane_model;
-    return 0;
+    return string_dictionary_encode(strings, plane_model, &flight->plane_model);
 }
 
 void flight_set_origin(flight_t *flight, airport_code_t origin) {
@@ -168,24 +194,24 @@ void flight_set_id(flight_t *flight, flight_id_t id) {
 }
 
 int flight_set_schedule_departure_date(flight_t *flight, date_and_time_t scheduled_departure_date) {
-    if (date_and_time_diff(scheduled_departure_date, flight->schedule_arrival_date) > 0)
+    const date_and_time_t arrival = __flight_date_decode(flight->schedule_arrival_date);
+    if (date_and_time_diff(scheduled_departure_date, arrival) > 0)
         return 1;
 
-    flight->schedule_departure_date = scheduled_departure_date;
-    return 0;
+    return __flight_date_encode(scheduled_departure_date, &flight->schedule_departure_date);
 }
 
 int flight_set_schedule_arrival_date(flight_t *flight, date_and_time_t schedule_arrival_date) {
-    if (date_and_time_diff(flight->schedule_departure_date, schedule_arrival_date) > 0)
+    const date_and_time_t departure = __flight_date_decode(flight->schedule_departure_date);
+    if (date_and_time_diff(departure, schedule_arrival_date) > 0)
         return 1;
 
-    flight->schedule_arrival_date = schedule_arrival_date;
-    return 0;
+    return __flight_date_encode(schedule_arrival_date, &flight->schedule_arrival_date);
 }
 
 void flight_reset_schedule_dates(flight_t *flight) {
     flight->schedule_departure_date = 0;
-    flight->schedule_arrival_date   = 0xFFFFFFFFFFFFFFFF;
+    flight->schedule_arrival_date   = FLIGHT_DATE_LATEST;
 }
 
 int flight_set_number_of_passengers(flight_t *flight, uint16_t number_of_passengers) {
@@ -196,8 +222,8 @@ int flight_set_number_of_passengers(flight_t *flight, uint16_t number_of_passeng
     return 0;
 }
 
-void flight_set_real_departure_date(flight_t *flight, date_and_time_t real_departure_date) {
-    flight->real_departure_date = real_departure_date;
+int flight_set_real_departure_date(flight_t *flight, date_and_time_t real_departure_date) {
+    return __flight_date_encode(real_departure_date, &flight->real_departure_date);
 }
 
 int flight_set_total_seats(flight_t *flight, uint16_t total_seats) {
@@ -213,14 +239,23 @@ void flight_reset_seats(flight_t *flight) {
     flight->total_seats          = 0xFFFF;
 }
 
-const char *flight_get_const_airline(const flight_t *flight) {
+string_code_t flight_get_airline_code(const flight_t *flight) {
     return flight->airline;
 }
 
-const char *flight_get_const_plane_model(const flight_t *flight) {
+const char *flight_get_const_airline(const string_dictionary_t *strings, const flight_t *flight) {
+    return string_dictionary_decode(strings, flight->airline);
+}
+
+string_code_t flight_get_plane_model_code(const flight_t *flight) {
     return flight->plane_model;
 }
 
+const char *flight_get_const_plane_model(const string_dictionary_t *strings,
+                                         const flight_t            *flight) {
+    return string_dictionary_decode(strings, flight->plane_model);
+}
+
 airport_code_t flight_get_origin(const flight_t *flight) {
     return flight->origin;
 }
@@ -234,11 +269,11 @@ flight_id_t flight_get_id(const flight_t *flight) {
 }
 
 date_and_time_t flight_get_schedule_departure_date(const flight_t *flight) {
-    return flight->schedule_departure_date;
+    return __flight_date_decode(flight->schedule_departure_date);
 }
 
 date_and_time_t flight_get_schedule_arrival_date(const flight_t *flight) {
-    return flight->schedule_arrival_date;
+    return __flight_date_decode(flight->schedule_arrival_date);
 }
 
 uint16_t flight_get_number_of_passengers(const flight_t *flight) {
@@ -246,7 +281,7 @@ uint16_t flight_get_number_of_passengers(const flight_t *flight) {
 }
 
 date_and_time_t flight_get_real_departure_date(const flight_t *flight) {
-    return flight->real_departure_date;
+    return __flight_date_decode(flight->real_departure_date);
 }
 
 uint16_t flight_get_total_seats(const flight_t *flight) {
@@ -266,14 +301,6 @@ void flight_invalidate(flight_t *flight) {
 }
 
 void flight_free(flight_t *flight) {
-    if (flight->owns_airline)
-        /* Purposely remove const. We know it was allocated by this module */
-        free((char *) (size_t) flight->airline);
-
-    if (flight->owns_plane_model)
-        /* Purposely remove const. We know it was allocated by this module */
-        free((char *) (size_t) flight->plane_model);
-
     if (flight->owns_itself)
         free(flight);
 }
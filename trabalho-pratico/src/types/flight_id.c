@@ -35,5 +35,6 @@ int flight_id_from_string(flight_id_t *output, const char *input) {
 }
 
 void flight_id_sprintf(char *output, flight_id_t id) {
-    sprintf(output, "%010" PRIu32, id);
+    int_utils_write_fixed(output, id, 10);
+    output[10] = '\0';
 }
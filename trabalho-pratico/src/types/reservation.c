@@ -32,10 +32,8 @@
  * @details Some fields in the project's requirements (such as address, room details and comments)
  *          aren't put here, as they aren't required by any of the queries.
  *
- * @var reservation::user_id
- *     @brief Identifier of the user that booked a given reservation.
  * @var reservation::hotel_name
- *     @brief Name of the hotel of a given reservation.
+ *     @brief Code of the name of the hotel of a given reservation, in a ::string_dictionary_t.
  * @var reservation::includes_breakfast
  *     @brief Whether or not this booling includes breakfast.
  * @var reservation::begin_date
@@ -47,6 +45,8 @@
  * @var reservation::rating
  *     @brief Rating of a given reservation. It's a value between 1 and 5 (inclusive), or
  *            ::RESERVATION_NO_RATING, meaning
+ * @var reservation::user
+ *     @brief Ordinal of the user that booked a given reservation.
  * @var reservation::hotel_id
  *     @brief Identifier of the hotel of a given reservation.
  * @var reservation::hotel_stars
@@ -59,27 +59,21 @@
  *     @brief   Whether, when `free`ing this reservation, the reservation pointer should be
  *              `free`'d.
  *     @details A false value means that the reservation is allocated in a pool.
- * @var reservation::owns_user_id
- *     @brief   Whether ::reservation::user_id should be `free`d.
- *     @details A false value means that this string is allocated in a pool.
- * @var reservation::owns_hotel_name
- *     @brief   Whether ::reservation::hotel_name should be `free`d.
- *     @details A false value means that this string is allocated in a pool.
  */
 struct reservation {
-    char                *user_id;
-    const char          *hotel_name;
     date_t               begin_date;
     date_t               end_date;
     reservation_id_t     id;
+    user_ordinal_t       user;
     hotel_id_t           hotel_id;
     uint16_t             price_per_night;
+    string_code_t        hotel_name;
     uint8_t              city_tax;
     uint8_t              rating;
     uint8_t              hotel_stars;
     includes_breakfast_t includes_breakfast : 1;
 
-    int owns_itself : 1, owns_user_id : 1, owns_hotel_name : 1;
+    unsigned int owns_itself : 1;
 };
 
 reservation_t *reservation_create(pool_t *allocator) {
@@ -88,29 +82,30 @@ reservation_t *reservation_create(pool_t *allocator) {
     if (!ret)
         return NULL;
 
-    ret->owns_itself  = allocator == NULL;
-    ret->owns_user_id = ret->owns_hotel_name = 0; /* Don't free in first setter call */
-    reservation_reset_dates(ret);                 /* For first comparisons to work */
+    ret->owns_itself = allocator == NULL;
+    reservation_reset_dates(ret); /* For first comparisons to work */
 
     return ret;
 }
 
-reservation_t *reservation_clone(pool_t                      *allocator,
-                                 string_pool_t               *user_id_allocator,
-                                 string_pool_no_duplicates_t *hotel_name_allocator,
-                                 const reservation_t         *reservation) {
+reservation_t *reservation_clone(pool_t                    *allocator,
+                                 string_dictionary_t       *hotel_names,
+                                 const string_dictionary_t *reservation_hotel_names,
+                                 const reservation_t       *reservation) {
 
     reservation_t *const ret = reservation_create(allocator);
     if (!ret)
         return NULL;
 
     memcpy(ret, reservation, sizeof(reservation_t));
-    ret->owns_itself  = allocator == NULL;
-    ret->owns_user_id = ret->owns_hotel_name = 0; /* Don't free in first setter call */
+    ret->owns_itself = allocator == NULL;
 
-    if (reservation_set_user_id(user_id_allocator, ret, reservation->user_id) ||
-        reservation_set_hotel_name(hotel_name_allocator, ret, reservation->hotel_name)) {
+    if (hotel_names == reservation_hotel_names)
+        return ret;
 
+    const char *const hotel_name =
+        string_dictionary_decode(reservation_hotel_names, reservation->hotel_name);
+    if (reservation_set_hotel_name(hotel_names, ret, hotel_name)) {
         if (ret->owns_itself)
             free(ret);
         return NULL;
@@ -119,42 +114,16 @@ reservation_t *reservation_clone(pool_t                      *allocator,
     return ret;
 }
 
-int reservation_set_user_id(string_pool_t *allocator,
-                            reservation_t *reservation,
-                            const char    *user_id) {
-    if (!*user_id)
-        return 1;
-
-    char *const new_user_id = allocator ? string_pool_put(allocator, user_id) : strdup(user_id);
-    if (!new_user_id)
-        return 1;
-
-    if (reservation->owns_user_id)
-        free(reservation->user_id);
-    reservation->owns_user_id = allocator == NULL;
-
-    reservation->user_id = new_user_id;
-    return 0;
+void reservation_set_user(reservation_t *reservation, user_ordinal_t user) {
+    reservation->user = user;
 }
 
-int reservation_set_hotel_name(string_pool_no_duplicates_t *allocator,
-                               reservation_t               *reservation,
-                               const char                  *hotel_name) {
+int reservation_set_hotel_name(string_dictionary_t *hotel_names,
+                               reservation_t       *reservation,
+                               const char          *hotel_name) {
     if (!*hotel_name)
         return 1;
-
-    const char *const new_hotel_name =
-        allocator ? string_pool_no_duplicates_put(allocator, hotel_name) : strdup(hotel_name);
-    if (!new_hotel_name)
-        return 1;
-
-    if (reservation->owns_hotel_name)
-        /* Purposely remove const. We know it was allocated by this module */
-        free((char *) (size_t) reservation->hotel_name);
-    reservation->owns_hotel_name = allocator == NULL;
-
-    reservation->hotel_name = new_hotel_name;
-    return 0;
+    return string_dictionary_encode(hotel_names, hotel_name, &reservation->hotel_name);
 }
 
 void reservation_set_includes_breakfast(reservation_t       *reservation,
@@ -219,14 +188,19 @@ int reservation_set_price_per_night(reservation_t *reservation, uint16_t price_p
     return 0;
 }
 
-const char *reservation_get_const_user_id(const reservation_t *reservation) {
-    return reservation->user_id;
+user_ordinal_t reservation_get_user(const reservation_t *reservation) {
+    return reservation->user;
 }
 
-const char *reservation_get_const_hotel_name(const reservation_t *reservation) {
+string_code_t reservation_get_hotel_name_code(const reservation_t *reservation) {
     return reservation->hotel_name;
 }
 
+const char *reservation_get_const_hotel_name(const string_dictionary_t *hotel_names,
+                                             const reservation_t       *reservation) {
+    return string_dictionary_decode(hotel_names, reservation->hotel_name);
+}
+
 includes_breakfast_t reservation_get_includes_breakfast(const reservation_t *reservation) {
     return reservation->includes_breakfast;
 }
@@ -279,18 +253,12 @@ double reservation_calculate_hotel_profit(const reservation_t *reservation) {
     return reservation->price_per_night * date_diff(reservation->end_date, reservation->begin_date);
 }
 
-double reservation_calculate_price(const reservation_t *reservation) {
-    return reservation_calculate_hotel_profit(reservation) * (1 + 0.01 * reservation->city_tax);
+uint64_t reservation_calculate_price_cents(const reservation_t *reservation) {
+    const uint64_t nights = (uint64_t) date_diff(reservation->end_date, reservation->begin_date);
+    return (uint64_t) reservation->price_per_night * nights * (100 + reservation->city_tax);
 }
 
 void reservation_free(reservation_t *reservation) {
-    if (reservation->owns_user_id)
-        free(reservation->user_id);
-
-    if (reservation->owns_hotel_name)
-        /* Purposely remove const. We know it was allocated by this module */
-        free((char *) (size_t) reservation->hotel_name);
-
     if (reservation->owns_itself)
         free(reservation);
 }
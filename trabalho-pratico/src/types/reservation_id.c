@@ -42,5 +42,7 @@ int reservation_id_from_string(reservation_id_t *output, const char *input) {
 }
 
 void reservation_id_sprintf(char *output, reservation_id_t id) {
-    sprintf(output, "Book%010" PRIu32, id);
+    memcpy(output, "Book", 4);
+    int_utils_write_fixed(output + 4, id, 10);
+    output[14] = '\0';
 }
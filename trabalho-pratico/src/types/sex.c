@@ -20,19 +20,22 @@
  */
 
 #include <inttypes.h>
-#include <string.h>
 
 #include "types/sex.h"
 
 int sex_from_string(sex_t *output, const char *input) {
-    if (strcmp(input, "M") == 0) {
-        *output = SEX_M;
-        return 0;
-    } else if (strcmp(input, "F") == 0) {
-        *output = SEX_F;
-        return 0;
-    } else {
+    if (!input[0] || input[1]) /* inline strlen(input) != 1 */
         return 1;
+
+    switch (input[0]) {
+        case 'M':
+            *output = SEX_M;
+            return 0;
+        case 'F':
+            *output = SEX_F;
+            return 0;
+        default:
+            return 1;
     }
 }
 
@@ -34,9 +34,14 @@
  *          and payment methods) aren't put here, as they aren't required by any of the queries.
  *
  * @var user::id
- *     @brief Identifier of a given user.
+ *     @brief   Identifier of a given user.
+ *     @details Stored in ::user::id::inline_id if ::user::inline_id is true, and in
+ *              ::user::id::pointer otherwise, which is `NULL` for invalid users.
  * @var user::name
  *     @brief Full name of a given user.
+ * @var user::name_prefix
+ *     @brief   First ::USER_NAME_PREFIX_SIZE bytes of ::user::name.
+ *     @details Padded with null characters, but not null-terminated when the name is long.
  * @var user::birth_date
  *     @brief Date of birth of a given user.
  * @var user::sex
@@ -49,6 +54,8 @@
  *     @brief Date of creation of a given user's account.
  * @var user::account_status
  *     @brief Whether a user's account is active or inactive.
+ * @var user::inline_id
+ *     @brief Whether ::user::id is stored in ::user::id::inline_id.
  * @var user::owns_itself
  *     @brief   Whether, when `free`ing this user, the user pointer should be `free`'d.
  *     @details A false value means that the user is allocated in a pool.
@@ -63,16 +70,21 @@
  *     @details A false value means that this string is allocated in a pool.
  */
 struct user {
-    char            *id;
+    union {
+        char *pointer;
+        char  inline_id[USER_INLINE_ID_SIZE];
+    } id;
+
     char            *name;
     char            *passport;
     date_and_time_t  account_creation_date;
+    char             name_prefix[USER_NAME_PREFIX_SIZE];
     date_t           birth_date;
     country_code_t   country_code;
     sex_t            sex            : 1;
     account_status_t account_status : 1;
 
-    int owns_itself : 1, owns_id : 1, owns_name : 1, owns_passport : 1;
+    unsigned int inline_id : 1, owns_itself : 1, owns_id : 1, owns_name : 1, owns_passport : 1;
 };
 
 user_t *user_create(pool_t *allocator) {
@@ -82,7 +94,8 @@ user_t *user_create(pool_t *allocator) {
 
     ret->owns_itself = allocator == NULL;
     ret->owns_id = ret->owns_name = ret->owns_passport = 0; /* Don't free in first setter call */
-    user_reset_dates(ret);                                  /* For first comparisons to work */
+    ret->inline_id                                     = 0;
+    user_reset_dates(ret); /* For first comparisons to work */
     return ret;
 }
 
@@ -95,7 +108,7 @@ user_t *user_clone(pool_t *allocator, string_pool_t *string_allocator, const use
     ret->owns_itself = allocator == NULL;
     ret->owns_id = ret->owns_name = ret->owns_passport = 0; /* Don't free in first setter call */
 
-    if (user_set_id(string_allocator, ret, user->id) ||
+    if (user_set_id(string_allocator, ret, user_get_const_id(user)) ||
         user_set_name(string_allocator, ret, user->name) ||
         user_set_passport(string_allocator, ret, user->passport)) {
 
@@ -107,19 +120,42 @@ user_t *user_clone(pool_t *allocator, string_pool_t *string_allocator, const use
     return ret;
 }
 
+user_t *user_clone_shallow(pool_t *allocator, const user_t *user) {
+    user_t *const ret = user_create(allocator);
+    if (!ret)
+        return NULL;
+
+    memcpy(ret, user, sizeof(user_t));
+    ret->owns_itself = allocator == NULL;
+    ret->owns_id = ret->owns_name = ret->owns_passport = 0; /* Strings belong to user's pool */
+    return ret;
+}
+
 int user_set_id(string_pool_t *allocator, user_t *user, const char *id) {
     if (!*id)
         return 1;
 
+    const size_t length = strlen(id);
+    if (length < USER_INLINE_ID_SIZE) {
+        if (user->owns_id)
+            free(user->id.pointer);
+        user->owns_id   = 0;
+        user->inline_id = 1;
+
+        memcpy(user->id.inline_id, id, length + 1);
+        return 0;
+    }
+
     char *const new_id = allocator ? string_pool_put(allocator, id) : strdup(id);
     if (!new_id)
         return 1;
 
     if (user->owns_id)
-        free(user->id);
-    user->owns_id = allocator == NULL;
+        free(user->id.pointer);
+    user->owns_id   = allocator == NULL;
+    user->inline_id = 0;
 
-    user->id = new_id;
+    user->id.pointer = new_id;
     return 0;
 }
 
@@ -136,6 +172,10 @@ int user_set_name(string_pool_t *allocator, user_t *user, const char *name) {
     user->owns_name = allocator == NULL;
 
     user->name = new_name;
+    const size_t length        = strlen(new_name);
+    const size_t prefix_length = length < USER_NAME_PREFIX_SIZE ? length : USER_NAME_PREFIX_SIZE;
+    memset(user->name_prefix, 0, USER_NAME_PREFIX_SIZE);
+    memcpy(user->name_prefix, new_name, prefix_length);
     return 0;
 }
 
@@ -189,13 +229,55 @@ void user_reset_dates(user_t *user) {
 }
 
 const char *user_get_const_id(const user_t *user) {
-    return user->id;
+    return user->inline_id ? user->id.inline_id : user->id.pointer;
 }
 
 const char *user_get_const_name(const user_t *user) {
     return user->name;
 }
 
+/**
+ * @brief Compares a string with the name of a user, using only ::user::name_prefix.
+ *
+ * @param user   User whose name is to be compared.
+ * @param str    String to compare the name of @p user with.
+ * @param length Number of characters to compare (at most ::USER_NAME_PREFIX_SIZE).
+ * @param result Where to write the comparison result to, when it's found.
+ *
+ * @retval 0 The first @p length characters are equal, and neither string ends before them.
+ * @retval 1 The comparison is decided, and written to @p result.
+ */
+int __user_compare_name_prefix(const user_t *user, const char *str, size_t length, int *result) {
+    for (size_t i = 0; i < length; ++i) {
+        const unsigned char a = user->name_prefix[i], b = str[i];
+        if (a != b || !a) { /* Different characters or both strings end here */
+            *result = a - b;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int user_compare_name(const user_t *user, const char *str) {
+    int result;
+    if (__user_compare_name_prefix(user, str, USER_NAME_PREFIX_SIZE, &result))
+        return result;
+
+    return strcmp(user->name + USER_NAME_PREFIX_SIZE, str + USER_NAME_PREFIX_SIZE);
+}
+
+int user_compare_name_prefix(const user_t *user, const char *prefix, size_t length) {
+    int result;
+    if (length <= USER_NAME_PREFIX_SIZE)
+        return __user_compare_name_prefix(user, prefix, length, &result) ? result : 0;
+    if (__user_compare_name_prefix(user, prefix, USER_NAME_PREFIX_SIZE, &result))
+        return result;
+
+    return strncmp(user->name + USER_NAME_PREFIX_SIZE,
+                   prefix + USER_NAME_PREFIX_SIZE,
+                   length - USER_NAME_PREFIX_SIZE);
+}
+
 date_t user_get_birth_date(const user_t *user) {
     return user->birth_date;
 }
@@ -225,22 +307,24 @@ size_t user_sizeof(void) {
 }
 
 int user_is_valid(const user_t *user) {
-    return user->id == NULL;
+    return !user->inline_id && user->id.pointer == NULL;
 }
 
 void user_invalidate(user_t *user) {
     if (user->owns_id)
-        free(user->id);
-    user->id = NULL;
+        free(user->id.pointer);
+    user->owns_id    = 0;
+    user->inline_id  = 0;
+    user->id.pointer = NULL;
 }
 
 int32_t user_calculate_age(const user_t *user) {
-    return date_diff(DATE_CURRENT, user->birth_date) / 372;
+    return date_diff(DATE_CURRENT, user->birth_date) / DATE_DAYS_PER_YEAR;
 }
 
 void user_free(user_t *user) {
     if (user->owns_id)
-        free(user->id);
+        free(user->id.pointer);
     if (user->owns_name)
         free(user->name);
     if (user->owns_passport)
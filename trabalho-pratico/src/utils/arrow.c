@@ -0,0 +1,821 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  arrow.c
+ * @brief Implementation of methods in include/utils/arrow.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref arrow_examples).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/arrow.h"
+#include "utils/int_utils.h"
+
+/** @brief Maximum number of fields of a table in a ::arrow_flatbuffer_t. */
+#define ARROW_FLATBUFFER_MAX_FIELDS 8
+
+/** @brief Initial number of bytes allocated for a ::arrow_flatbuffer_t. */
+#define ARROW_FLATBUFFER_INITIAL_CAPACITY 1024
+
+/** @brief Alignment of every message and buffer in an Arrow IPC file. */
+#define ARROW_IPC_ALIGNMENT 8
+
+/** @brief Magic string at the beginning (padded) and at the end of an Arrow IPC file. */
+#define ARROW_IPC_MAGIC "ARROW1"
+
+/** @brief Value of `MetadataVersion` (in `Schema.fbs`) written to every message (`V5`). */
+#define ARROW_IPC_METADATA_VERSION 4
+
+/**
+ * @struct  arrow_flatbuffer_t
+ * @brief   A builder of [FlatBuffers](https://flatbuffers.dev/), the format of Arrow IPC metadata.
+ * @details Like in the reference implementation, objects are written from the end of the buffer
+ *          towards its beginning, so that they refer to objects written before them with positive
+ *          offsets. Positions of objects are measured from the end of the buffer (see
+ *          ::arrow_flatbuffer_t::used), as its beginning moves when it grows.
+ *
+ * @var arrow_flatbuffer_t::data
+ *     @brief Memory of the buffer, whose last ::arrow_flatbuffer_t::used bytes are in use.
+ * @var arrow_flatbuffer_t::capacity
+ *     @brief Number of bytes in ::arrow_flatbuffer_t::data.
+ * @var arrow_flatbuffer_t::used
+ *     @brief Number of bytes already written.
+ * @var arrow_flatbuffer_t::alignment
+ *     @brief Largest alignment of an object written so far.
+ * @var arrow_flatbuffer_t::table_start
+ *     @brief Value of ::arrow_flatbuffer_t::used when the table being built was started.
+ * @var arrow_flatbuffer_t::fields
+ *     @brief Positions of the fields of the table being built (`0` for fields not written).
+ * @var arrow_flatbuffer_t::nfields
+ *     @brief Number of elements of ::arrow_flatbuffer_t::fields in use.
+ * @var arrow_flatbuffer_t::failed
+ *     @brief Whether an allocation failed. Once set, nothing else is written.
+ */
+typedef struct {
+    uint8_t *data;
+    size_t   capacity, used, alignment;
+    size_t   table_start;
+    size_t   fields[ARROW_FLATBUFFER_MAX_FIELDS];
+    size_t   nfields;
+    int      failed;
+} arrow_flatbuffer_t;
+
+/** @brief Values of the `Type` union (in Arrow's `Schema.fbs`) of the supported types. */
+typedef enum {
+    ARROW_FLATBUFFER_TYPE_INT       = 2,  /**< @brief `Int` table. */
+    ARROW_FLATBUFFER_TYPE_UTF8      = 5,  /**< @brief `Utf8` table. */
+    ARROW_FLATBUFFER_TYPE_BOOL      = 6,  /**< @brief `Bool` table. */
+    ARROW_FLATBUFFER_TYPE_DATE      = 8,  /**< @brief `Date` table. */
+    ARROW_FLATBUFFER_TYPE_TIMESTAMP = 10, /**< @brief `Timestamp` table. */
+} arrow_flatbuffer_type_t;
+
+/** @brief Values of the `MessageHeader` union (in Arrow's `Message.fbs`) used by this writer. */
+typedef enum {
+    ARROW_FLATBUFFER_HEADER_SCHEMA       = 1, /**< @brief `Schema` table. */
+    ARROW_FLATBUFFER_HEADER_RECORD_BATCH = 3  /**< @brief `RecordBatch` table. */
+} arrow_flatbuffer_header_t;
+
+/** @brief Types of columns supported by ::arrow_write_ipc_file. */
+typedef enum {
+    ARROW_TYPE_UINT8,     /**< @brief Format `C`. */
+    ARROW_TYPE_UINT16,    /**< @brief Format `S`. */
+    ARROW_TYPE_UINT32,    /**< @brief Format `I`. */
+    ARROW_TYPE_DATE,      /**< @brief Format `tdD`. */
+    ARROW_TYPE_TIMESTAMP, /**< @brief Format `tss:`. */
+    ARROW_TYPE_BOOL,      /**< @brief Format `b`. */
+    ARROW_TYPE_UTF8,      /**< @brief Format `u`. */
+    ARROW_TYPE_COUNT      /**< @brief Number of supported types. */
+} arrow_type_t;
+
+/** @brief Format strings of every ::arrow_type_t. */
+const char *const arrow_type_formats[ARROW_TYPE_COUNT] = {"C", "S", "I", "tdD", "tss:", "b", "u"};
+
+/** @brief Size of the values of every ::arrow_type_t, or `0` for types not of fixed width. */
+const size_t arrow_type_widths[ARROW_TYPE_COUNT] = {1, 2, 4, 4, 8, 0, 0};
+
+/**
+ * @struct arrow_field_node_t
+ * @brief  `FieldNode` struct (in Arrow's `Message.fbs`), describing a column of a record batch.
+ *
+ * @var arrow_field_node_t::length
+ *     @brief Number of values in the column.
+ * @var arrow_field_node_t::null_count
+ *     @brief Number of null values in the column.
+ */
+typedef struct {
+    int64_t length, null_count;
+} arrow_field_node_t;
+
+/**
+ * @struct arrow_buffer_t
+ * @brief  `Buffer` struct (in Arrow's `Schema.fbs`), the location of a buffer in a message body.
+ *
+ * @var arrow_buffer_t::offset
+ *     @brief Index of the first byte of the buffer in the message body.
+ * @var arrow_buffer_t::length
+ *     @brief Number of bytes in the buffer (not counting padding).
+ */
+typedef struct {
+    int64_t offset, length;
+} arrow_buffer_t;
+
+/**
+ * @struct arrow_block_t
+ * @brief  `Block` struct (in Arrow's `File.fbs`), the location of a message in a file.
+ *
+ * @var arrow_block_t::offset
+ *     @brief Index of the first byte of the message in the file.
+ * @var arrow_block_t::metadata_length
+ *     @brief Number of bytes of the message before its body (prefix, metadata and padding).
+ * @var arrow_block_t::padding
+ *     @brief Padding, always `0`, so that ::arrow_block_t::body_length is aligned.
+ * @var arrow_block_t::body_length
+ *     @brief Number of bytes in the body of the message.
+ */
+typedef struct {
+    int64_t offset;
+    int32_t metadata_length, padding;
+    int64_t body_length;
+} arrow_block_t;
+
+/**
+ * @struct arrow_writer_t
+ * @brief  An Arrow IPC file being written.
+ *
+ * @var arrow_writer_t::file
+ *     @brief File being written.
+ * @var arrow_writer_t::position
+ *     @brief Number of bytes already written to ::arrow_writer_t::file.
+ * @var arrow_writer_t::failed
+ *     @brief Whether a write failed. Once set, nothing else is written.
+ */
+typedef struct {
+    FILE   *file;
+    int64_t position;
+    int     failed;
+} arrow_writer_t;
+
+/**
+ * @brief Makes sure a ::arrow_flatbuffer_t has space for more bytes, growing it if needed.
+ *
+ * @param fb Buffer to grow.
+ * @param n  Number of bytes to be written.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (::arrow_flatbuffer_t::failed is set).
+ */
+int __arrow_flatbuffer_reserve(arrow_flatbuffer_t *fb, size_t n) {
+    if (fb->failed)
+        return 1;
+    if (fb->used + n <= fb->capacity)
+        return 0;
+
+    size_t new_capacity = fb->capacity ? fb->capacity : ARROW_FLATBUFFER_INITIAL_CAPACITY;
+    while (new_capacity < fb->used + n)
+        new_capacity *= 2;
+
+    uint8_t *const data = malloc(new_capacity);
+    if (!data) {
+        fb->failed = 1;
+        return 1;
+    }
+
+    /* Bytes in use are kept at the end of the buffer */
+    if (fb->used)
+        memcpy(data + new_capacity - fb->used, fb->data + fb->capacity - fb->used, fb->used);
+    free(fb->data);
+    fb->data     = data;
+    fb->capacity = new_capacity;
+    return 0;
+}
+
+/**
+ * @brief Writes bytes before all others in a ::arrow_flatbuffer_t.
+ *
+ * @param fb    Buffer to write to.
+ * @param bytes Bytes to be written. Can be `NULL`, for @p n zeroes.
+ * @param n     Number of bytes in @p bytes.
+ */
+void __arrow_flatbuffer_push(arrow_flatbuffer_t *fb, const void *bytes, size_t n) {
+    if (__arrow_flatbuffer_reserve(fb, n))
+        return;
+
+    fb->used += n;
+    if (bytes)
+        memcpy(fb->data + fb->capacity - fb->used, bytes, n);
+    else
+        memset(fb->data + fb->capacity - fb->used, 0, n);
+}
+
+/**
+ * @brief Pads a ::arrow_flatbuffer_t, so that an object is aligned after @p extra more bytes are
+ *        written.
+ *
+ * @param fb        Buffer to be padded.
+ * @param alignment Alignment of the object to be written (a power of 2).
+ * @param extra     Number of bytes to be written before the object is aligned.
+ */
+void __arrow_flatbuffer_align(arrow_flatbuffer_t *fb, size_t alignment, size_t extra) {
+    fb->alignment = max(fb->alignment, alignment);
+    __arrow_flatbuffer_push(fb, NULL, (alignment - (fb->used + extra) % alignment) % alignment);
+}
+
+/**
+ * @brief Starts building a table in a ::arrow_flatbuffer_t. Only one table can be built at once.
+ * @param fb Buffer where to build the table.
+ */
+void __arrow_flatbuffer_start_table(arrow_flatbuffer_t *fb) {
+    memset(fb->fields, 0, sizeof(fb->fields));
+    fb->nfields     = 0;
+    fb->table_start = fb->used;
+}
+
+/**
+ * @brief Adds a scalar field to the table being built in a ::arrow_flatbuffer_t.
+ *
+ * @param fb    Buffer where the table is being built.
+ * @param field Index of the field in the table (lower than ::ARROW_FLATBUFFER_MAX_FIELDS).
+ * @param value Value of the field.
+ * @param size  Number of bytes in @p value (also its alignment).
+ */
+void __arrow_flatbuffer_add_field(arrow_flatbuffer_t *fb,
+                                  size_t              field,
+                                  const void         *value,
+                                  size_t              size) {
+    __arrow_flatbuffer_align(fb, size, 0);
+    __arrow_flatbuffer_push(fb, value, size);
+    fb->fields[field] = fb->used;
+    fb->nfields       = max(fb->nfields, field + 1);
+}
+
+/**
+ * @brief Writes a reference to an object (`uoffset_t`) in a ::arrow_flatbuffer_t.
+ *
+ * @param fb     Buffer to write to.
+ * @param object Position of the object to refer to, written before.
+ */
+void __arrow_flatbuffer_push_reference(arrow_flatbuffer_t *fb, size_t object) {
+    const uint32_t offset = (uint32_t) (fb->used + sizeof(uint32_t) - object);
+    __arrow_flatbuffer_push(fb, &offset, sizeof(uint32_t));
+}
+
+/**
+ * @brief Adds a field that refers to an object to the table being built in a
+ *        ::arrow_flatbuffer_t.
+ *
+ * @param fb     Buffer where the table is being built.
+ * @param field  Index of the field in the table (lower than ::ARROW_FLATBUFFER_MAX_FIELDS).
+ * @param object Position of the object to refer to, written before the table was started.
+ */
+void __arrow_flatbuffer_add_reference(arrow_flatbuffer_t *fb, size_t field, size_t object) {
+    __arrow_flatbuffer_align(fb, sizeof(uint32_t), 0);
+    __arrow_flatbuffer_push_reference(fb, object);
+    fb->fields[field] = fb->used;
+    fb->nfields       = max(fb->nfields, field + 1);
+}
+
+/**
+ * @brief   Finishes building a table in a ::arrow_flatbuffer_t.
+ * @details The table's vtable (offsets of its fields) is written right before it.
+ *
+ * @param fb Buffer where the table is being built.
+ *
+ * @return The position of the table.
+ */
+size_t __arrow_flatbuffer_end_table(arrow_flatbuffer_t *fb) {
+    __arrow_flatbuffer_align(fb, sizeof(uint32_t), 0);
+    __arrow_flatbuffer_push(fb, NULL, sizeof(int32_t)); /* Offset to the vtable, written below */
+    const size_t table = fb->used;
+
+    for (size_t i = fb->nfields; i > 0; --i) {
+        const uint16_t offset = fb->fields[i - 1] ? (uint16_t) (table - fb->fields[i - 1]) : 0;
+        __arrow_flatbuffer_push(fb, &offset, sizeof(uint16_t));
+    }
+
+    const uint16_t sizes[2] = {(uint16_t) (sizeof(uint16_t) * (2 + fb->nfields)),
+                               (uint16_t) (table - fb->table_start)};
+    __arrow_flatbuffer_push(fb, sizes, sizeof(sizes));
+
+    if (!fb->failed) {
+        const int32_t vtable_offset = (int32_t) (fb->used - table);
+        memcpy(fb->data + fb->capacity - table, &vtable_offset, sizeof(int32_t));
+    }
+    return table;
+}
+
+/**
+ * @brief Writes a string to a ::arrow_flatbuffer_t.
+ *
+ * @param fb  Buffer to write to.
+ * @param str String to be written.
+ *
+ * @return The position of the string.
+ */
+size_t __arrow_flatbuffer_add_string(arrow_flatbuffer_t *fb, const char *str) {
+    const uint32_t length = (uint32_t) strlen(str);
+    __arrow_flatbuffer_align(fb, sizeof(uint32_t), length + 1);
+    __arrow_flatbuffer_push(fb, NULL, 1); /* Null terminator */
+    __arrow_flatbuffer_push(fb, str, length);
+    __arrow_flatbuffer_push(fb, &length, sizeof(uint32_t));
+    return fb->used;
+}
+
+/**
+ * @brief Writes a vector of structs to a ::arrow_flatbuffer_t.
+ *
+ * @param fb        Buffer to write to.
+ * @param elements  Structs to be written. Can be `NULL` if @p n is `0`.
+ * @param size      Size of each struct in @p elements.
+ * @param n         Number of elements in @p elements.
+ * @param alignment Alignment of the structs in @p elements.
+ *
+ * @return The position of the vector.
+ */
+size_t __arrow_flatbuffer_add_struct_vector(arrow_flatbuffer_t *fb,
+                                            const void         *elements,
+                                            size_t              size,
+                                            size_t              n,
+                                            size_t              alignment) {
+    const uint32_t length = (uint32_t) n;
+    __arrow_flatbuffer_align(fb, sizeof(uint32_t), size * n);
+    __arrow_flatbuffer_align(fb, alignment, size * n);
+    __arrow_flatbuffer_push(fb, elements, size * n);
+    __arrow_flatbuffer_push(fb, &length, sizeof(uint32_t));
+    return fb->used;
+}
+
+/**
+ * @brief Writes a vector of references to objects (e.g.: tables) to a ::arrow_flatbuffer_t.
+ *
+ * @param fb      Buffer to write to.
+ * @param objects Positions of the objects to refer to. Can be `NULL` if @p n is `0`.
+ * @param n       Number of elements in @p objects.
+ *
+ * @return The position of the vector.
+ */
+size_t __arrow_flatbuffer_add_reference_vector(arrow_flatbuffer_t *fb,
+                                               const size_t       *objects,
+                                               size_t              n) {
+    const uint32_t length = (uint32_t) n;
+    __arrow_flatbuffer_align(fb, sizeof(uint32_t), sizeof(uint32_t) * n);
+    for (size_t i = n; i > 0; --i)
+        __arrow_flatbuffer_push_reference(fb, objects[i - 1]);
+    __arrow_flatbuffer_push(fb, &length, sizeof(uint32_t));
+    return fb->used;
+}
+
+/**
+ * @brief Finishes a ::arrow_flatbuffer_t by writing a reference to its root table.
+ *
+ * @param fb   Buffer to finish.
+ * @param root Position of the root table.
+ *
+ * @return The finished buffer (::arrow_flatbuffer_t::used bytes), or `NULL` on allocation failure.
+ */
+const uint8_t *__arrow_flatbuffer_finish(arrow_flatbuffer_t *fb, size_t root) {
+    __arrow_flatbuffer_align(fb, fb->alignment, sizeof(uint32_t));
+    __arrow_flatbuffer_push_reference(fb, root);
+    return fb->failed ? NULL : fb->data + fb->capacity - fb->used;
+}
+
+/**
+ * @brief Writes the type of a column (a table of the `Type` union) to a ::arrow_flatbuffer_t.
+ *
+ * @param fb        Buffer to write to.
+ * @param type      Type of the column.
+ * @param type_type Where to output the ::arrow_flatbuffer_type_t of the written table to.
+ *
+ * @return The position of the written table.
+ */
+size_t __arrow_flatbuffer_add_type(arrow_flatbuffer_t *fb, arrow_type_t type, uint8_t *type_type) {
+    __arrow_flatbuffer_start_table(fb);
+    switch (type) {
+        case ARROW_TYPE_UINT8:
+        case ARROW_TYPE_UINT16:
+        case ARROW_TYPE_UINT32: {
+            /* is_signed (field 1) defaults to false */
+            const int32_t bit_width = (int32_t) (8 * arrow_type_widths[type]);
+            __arrow_flatbuffer_add_field(fb, 0, &bit_width, sizeof(int32_t));
+            *type_type = ARROW_FLATBUFFER_TYPE_INT;
+        } break;
+        case ARROW_TYPE_DATE: {
+            const int16_t unit = 0; /* DateUnit.DAY (not the default) */
+            __arrow_flatbuffer_add_field(fb, 0, &unit, sizeof(int16_t));
+            *type_type = ARROW_FLATBUFFER_TYPE_DATE;
+        } break;
+        case ARROW_TYPE_TIMESTAMP: {
+            const int16_t unit = 0; /* TimeUnit.SECOND, without a timezone */
+            __arrow_flatbuffer_add_field(fb, 0, &unit, sizeof(int16_t));
+            *type_type = ARROW_FLATBUFFER_TYPE_TIMESTAMP;
+        } break;
+        case ARROW_TYPE_BOOL:
+            *type_type = ARROW_FLATBUFFER_TYPE_BOOL;
+            break;
+        default:
+            *type_type = ARROW_FLATBUFFER_TYPE_UTF8;
+            break;
+    }
+    return __arrow_flatbuffer_end_table(fb);
+}
+
+/**
+ * @brief Writes a `Schema` table to a ::arrow_flatbuffer_t.
+ *
+ * @param fb     Buffer to write to.
+ * @param schema Type of a record batch.
+ * @param types  Types of the children of @p schema.
+ *
+ * @return The position of the schema. On allocation failure, ::arrow_flatbuffer_t::failed is set.
+ */
+size_t __arrow_flatbuffer_add_schema(arrow_flatbuffer_t       *fb,
+                                     const struct ArrowSchema *schema,
+                                     const arrow_type_t       *types) {
+    const size_t  ncolumns = (size_t) schema->n_children;
+    size_t *const fields   = malloc(sizeof(size_t) * max(ncolumns, 1));
+    if (!fields) {
+        fb->failed = 1;
+        return 0;
+    }
+
+    for (size_t i = 0; i < ncolumns; ++i) {
+        const struct ArrowSchema *const child = schema->children[i];
+
+        uint8_t       type_type;
+        const uint8_t nullable = (child->flags & ARROW_FLAG_NULLABLE) != 0;
+        const size_t  name     = __arrow_flatbuffer_add_string(fb, child->name ? child->name : "");
+        const size_t  type     = __arrow_flatbuffer_add_type(fb, types[i], &type_type);
+        const size_t  children = __arrow_flatbuffer_add_reference_vector(fb, NULL, 0);
+
+        __arrow_flatbuffer_start_table(fb);
+        __arrow_flatbuffer_add_reference(fb, 0, name);
+        __arrow_flatbuffer_add_reference(fb, 3, type);
+        __arrow_flatbuffer_add_reference(fb, 5, children);
+        __arrow_flatbuffer_add_field(fb, 1, &nullable, sizeof(uint8_t));
+        __arrow_flatbuffer_add_field(fb, 2, &type_type, sizeof(uint8_t));
+        fields[i] = __arrow_flatbuffer_end_table(fb);
+    }
+
+    const size_t fields_vector = __arrow_flatbuffer_add_reference_vector(fb, fields, ncolumns);
+    free(fields);
+
+    const int16_t endianness = 0; /* Endianness.Little */
+    __arrow_flatbuffer_start_table(fb);
+    __arrow_flatbuffer_add_reference(fb, 1, fields_vector);
+    __arrow_flatbuffer_add_field(fb, 0, &endianness, sizeof(int16_t));
+    return __arrow_flatbuffer_end_table(fb);
+}
+
+/**
+ * @brief Writes a `Message` table, the root of a message's metadata, to a ::arrow_flatbuffer_t.
+ *
+ * @param fb          Buffer to write to.
+ * @param header_type Type of @p header.
+ * @param header      Position of the table with the contents of the message.
+ * @param body_length Number of bytes in the body of the message.
+ *
+ * @return The position of the message.
+ */
+size_t __arrow_flatbuffer_add_message(arrow_flatbuffer_t       *fb,
+                                      arrow_flatbuffer_header_t header_type,
+                                      size_t                    header,
+                                      int64_t                   body_length) {
+    const int16_t version = ARROW_IPC_METADATA_VERSION;
+    const uint8_t type    = (uint8_t) header_type;
+
+    __arrow_flatbuffer_start_table(fb);
+    __arrow_flatbuffer_add_field(fb, 3, &body_length, sizeof(int64_t));
+    __arrow_flatbuffer_add_reference(fb, 2, header);
+    __arrow_flatbuffer_add_field(fb, 0, &version, sizeof(int16_t));
+    __arrow_flatbuffer_add_field(fb, 1, &type, sizeof(uint8_t));
+    return __arrow_flatbuffer_end_table(fb);
+}
+
+/**
+ * @brief Writes bytes to an Arrow IPC file.
+ *
+ * @param writer File to write to.
+ * @param bytes  Bytes to be written. Can be `NULL`, for @p n zeroes (@p n must be lower than
+ *               ::ARROW_IPC_ALIGNMENT).
+ * @param n      Number of bytes in @p bytes.
+ */
+void __arrow_writer_write(arrow_writer_t *writer, const void *bytes, size_t n) {
+    const uint8_t zeroes[ARROW_IPC_ALIGNMENT] = {0};
+    if (writer->failed || !n)
+        return;
+
+    if (fwrite(bytes ? bytes : zeroes, 1, n, writer->file) != n)
+        writer->failed = 1;
+    writer->position += (int64_t) n;
+}
+
+/**
+ * @brief Gets the number of bytes of padding needed after a buffer in an Arrow IPC file.
+ * @param length Number of bytes in the buffer.
+ * @return The number of bytes needed to align @p length to ::ARROW_IPC_ALIGNMENT.
+ */
+size_t __arrow_get_padding(size_t length) {
+    return (ARROW_IPC_ALIGNMENT - length % ARROW_IPC_ALIGNMENT) % ARROW_IPC_ALIGNMENT;
+}
+
+/**
+ * @brief   Writes the metadata of a message to an Arrow IPC file.
+ * @details The metadata is prefixed by a continuation marker and by its length, and padded so that
+ *          the body of the message is aligned.
+ *
+ * @param writer   File to write to.
+ * @param metadata Finished buffer with the ::__arrow_flatbuffer_add_message table.
+ * @param length   Number of bytes in @p metadata.
+ *
+ * @return The number of bytes written (`metaDataLength` of a `Block`).
+ */
+int32_t __arrow_writer_write_message(arrow_writer_t *writer,
+                                     const uint8_t  *metadata,
+                                     size_t          length) {
+    const uint32_t continuation  = UINT32_MAX;
+    const size_t   padding       = __arrow_get_padding(length);
+    const int32_t  padded_length = (int32_t) (length + padding);
+
+    __arrow_writer_write(writer, &continuation, sizeof(uint32_t));
+    __arrow_writer_write(writer, &padded_length, sizeof(int32_t));
+    __arrow_writer_write(writer, metadata, length);
+    __arrow_writer_write(writer, NULL, padding);
+    return (int32_t) (2 * sizeof(uint32_t)) + padded_length;
+}
+
+/**
+ * @brief Gets the type of a column of a record batch from its format string.
+ *
+ * @param format Format string of the column.
+ * @param output Where to write the type to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Unsupported format.
+ */
+int __arrow_parse_format(const char *format, arrow_type_t *output) {
+    for (size_t i = 0; i < ARROW_TYPE_COUNT; ++i) {
+        if (strcmp(format, arrow_type_formats[i]) == 0) {
+            *output = (arrow_type_t) i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Counts the null values of a column, from its validity bitmap.
+ *
+ * @param validity Validity bitmap of the column. Can be `NULL`, when there are no null values.
+ * @param n        Number of values in the column.
+ *
+ * @return The number of null values.
+ */
+int64_t __arrow_count_nulls(const uint8_t *validity, int64_t n) {
+    if (!validity)
+        return 0;
+
+    int64_t nulls = 0;
+    for (int64_t i = 0; i < n; ++i)
+        nulls += !(validity[i / 8] & (1 << (i % 8)));
+    return nulls;
+}
+
+/**
+ * @struct arrow_body_t
+ * @brief  Buffers of the body of a record batch message.
+ *
+ * @var arrow_body_t::nodes
+ *     @brief Description of every column.
+ * @var arrow_body_t::buffers
+ *     @brief Location of every buffer in the body.
+ * @var arrow_body_t::data
+ *     @brief Contents of every buffer in ::arrow_body_t::buffers.
+ * @var arrow_body_t::nbuffers
+ *     @brief Number of elements in ::arrow_body_t::buffers and ::arrow_body_t::data.
+ * @var arrow_body_t::length
+ *     @brief Number of bytes in the body, including padding.
+ */
+typedef struct {
+    arrow_field_node_t *nodes;
+    arrow_buffer_t     *buffers;
+    const void        **data;
+    size_t              nbuffers;
+    int64_t             length;
+} arrow_body_t;
+
+/**
+ * @brief Adds a buffer to a ::arrow_body_t.
+ *
+ * @param body   Body to add the buffer to.
+ * @param data   Contents of the buffer. Can be `NULL` if @p length is `0`.
+ * @param length Number of bytes in @p data.
+ */
+void __arrow_body_add(arrow_body_t *body, const void *data, int64_t length) {
+    body->buffers[body->nbuffers] = (arrow_buffer_t) {.offset = body->length, .length = length};
+    body->data[body->nbuffers]    = data;
+    body->nbuffers++;
+    body->length += length + (int64_t) __arrow_get_padding((size_t) length);
+}
+
+/**
+ * @brief Describes the buffers of a record batch in a ::arrow_body_t.
+ *
+ * @param body  Where to write the description to. Its arrays must have space for every column and
+ *              for three buffers per column.
+ * @param array Record batch to be written.
+ * @param types Types of the columns of @p array.
+ */
+void __arrow_body_describe(arrow_body_t            *body,
+                           const struct ArrowArray *array,
+                           const arrow_type_t      *types) {
+    body->nbuffers = 0;
+    body->length   = 0;
+
+    for (int64_t i = 0; i < array->n_children; ++i) {
+        const struct ArrowArray *const child    = array->children[i];
+        const int64_t                  n        = child->length;
+        const uint8_t *const           validity = child->buffers[0];
+
+        const int64_t nulls =
+            child->null_count >= 0 ? child->null_count : __arrow_count_nulls(validity, n);
+        body->nodes[i] = (arrow_field_node_t) {.length = n, .null_count = nulls};
+        __arrow_body_add(body, validity, nulls ? (n + 7) / 8 : 0);
+
+        const arrow_type_t type = types[i];
+        if (type == ARROW_TYPE_BOOL) {
+            __arrow_body_add(body, child->buffers[1], (n + 7) / 8);
+        } else if (type == ARROW_TYPE_UTF8) {
+            const int32_t *const offsets = child->buffers[1];
+            __arrow_body_add(body, offsets, (int64_t) sizeof(int32_t) * (n + 1));
+            __arrow_body_add(body, child->buffers[2], offsets[n]);
+        } else {
+            __arrow_body_add(body, child->buffers[1], (int64_t) arrow_type_widths[type] * n);
+        }
+    }
+}
+
+/**
+ * @brief Checks if a record batch can be written by ::arrow_write_ipc_file, and gets the types of
+ *        its columns.
+ *
+ * @param schema Type of the record batch.
+ * @param array  Record batch to be written.
+ * @param types  Where to write the type of every column to.
+ *
+ * @retval 0 Supported record batch.
+ * @retval 1 Unsupported record batch.
+ */
+int __arrow_check_record_batch(const struct ArrowSchema *schema,
+                               const struct ArrowArray  *array,
+                               arrow_type_t             *types) {
+    if (strcmp(schema->format, "+s") || schema->n_children != array->n_children || array->offset)
+        return 1;
+
+    for (int64_t i = 0; i < array->n_children; ++i) {
+        const struct ArrowArray *const child = array->children[i];
+        if (__arrow_parse_format(schema->children[i]->format, &types[i]) || child->offset ||
+            child->length != array->length || child->n_buffers != 2 + (types[i] == ARROW_TYPE_UTF8))
+            return 1;
+    }
+    return 0;
+}
+
+int arrow_write_ipc_file(const char               *path,
+                         const struct ArrowSchema *schema,
+                         const struct ArrowArray  *array) {
+
+    const size_t        ncolumns = (size_t) array->n_children;
+    arrow_type_t *const types    = malloc(sizeof(arrow_type_t) * max(ncolumns, 1));
+    if (!types)
+        return 1;
+    if (__arrow_check_record_batch(schema, array, types))
+        goto DEFER_1;
+
+    arrow_body_t body = {.nodes   = malloc(sizeof(arrow_field_node_t) * max(ncolumns, 1)),
+                         .buffers = malloc(sizeof(arrow_buffer_t) * 3 * max(ncolumns, 1)),
+                         .data    = malloc(sizeof(const void *) * 3 * max(ncolumns, 1))};
+    if (!body.nodes || !body.buffers || !body.data)
+        goto DEFER_2;
+    __arrow_body_describe(&body, array, types);
+
+    arrow_writer_t writer = {.file = fopen(path, "wb"), .position = 0, .failed = 0};
+    if (!writer.file)
+        goto DEFER_2;
+
+    const char magic[8] = ARROW_IPC_MAGIC; /* Padded with zeroes */
+    __arrow_writer_write(&writer, magic, sizeof(magic));
+
+    /* Schema message */
+    arrow_flatbuffer_t fb     = {.alignment = 1};
+    const size_t       header = __arrow_flatbuffer_add_schema(&fb, schema, types);
+    size_t root = __arrow_flatbuffer_add_message(&fb, ARROW_FLATBUFFER_HEADER_SCHEMA, header, 0);
+    const uint8_t *metadata = __arrow_flatbuffer_finish(&fb, root);
+    if (!metadata)
+        goto DEFER_4;
+    __arrow_writer_write_message(&writer, metadata, fb.used);
+    free(fb.data);
+
+    /* Record batch message */
+    arrow_block_t block = {.offset = writer.position, .padding = 0, .body_length = body.length};
+    fb                  = (arrow_flatbuffer_t) {.alignment = 1};
+
+    const int64_t length  = array->length;
+    const size_t  nodes   = __arrow_flatbuffer_add_struct_vector(&fb,
+                                                              body.nodes,
+                                                              sizeof(arrow_field_node_t),
+                                                              ncolumns,
+                                                              sizeof(int64_t));
+    const size_t  buffers = __arrow_flatbuffer_add_struct_vector(&fb,
+                                                                body.buffers,
+                                                                sizeof(arrow_buffer_t),
+                                                                body.nbuffers,
+                                                                sizeof(int64_t));
+    __arrow_flatbuffer_start_table(&fb);
+    __arrow_flatbuffer_add_field(&fb, 0, &length, sizeof(int64_t));
+    __arrow_flatbuffer_add_reference(&fb, 1, nodes);
+    __arrow_flatbuffer_add_reference(&fb, 2, buffers);
+    root = __arrow_flatbuffer_add_message(&fb,
+                                          ARROW_FLATBUFFER_HEADER_RECORD_BATCH,
+                                          __arrow_flatbuffer_end_table(&fb),
+                                          body.length);
+    metadata = __arrow_flatbuffer_finish(&fb, root);
+    if (!metadata)
+        goto DEFER_4;
+    block.metadata_length = __arrow_writer_write_message(&writer, metadata, fb.used);
+    free(fb.data);
+
+    for (size_t i = 0; i < body.nbuffers; ++i) {
+        const size_t buffer_length = (size_t) body.buffers[i].length;
+        __arrow_writer_write(&writer, body.data[i], buffer_length);
+        __arrow_writer_write(&writer, NULL, __arrow_get_padding(buffer_length));
+    }
+
+    /* End-of-stream marker and footer */
+    const uint32_t eos[2] = {UINT32_MAX, 0};
+    __arrow_writer_write(&writer, eos, sizeof(eos));
+
+    fb                          = (arrow_flatbuffer_t) {.alignment = 1};
+    const int16_t version       = ARROW_IPC_METADATA_VERSION;
+    const size_t  footer_schema = __arrow_flatbuffer_add_schema(&fb, schema, types);
+    const size_t  dictionaries =
+        __arrow_flatbuffer_add_struct_vector(&fb, NULL, sizeof(arrow_block_t), 0, sizeof(int64_t));
+    const size_t record_batches = __arrow_flatbuffer_add_struct_vector(&fb,
+                                                                       &block,
+                                                                       sizeof(arrow_block_t),
+                                                                       1,
+                                                                       sizeof(int64_t));
+    __arrow_flatbuffer_start_table(&fb);
+    __arrow_flatbuffer_add_reference(&fb, 1, footer_schema);
+    __arrow_flatbuffer_add_reference(&fb, 2, dictionaries);
+    __arrow_flatbuffer_add_reference(&fb, 3, record_batches);
+    __arrow_flatbuffer_add_field(&fb, 0, &version, sizeof(int16_t));
+    metadata = __arrow_flatbuffer_finish(&fb, __arrow_flatbuffer_end_table(&fb));
+    if (!metadata)
+        goto DEFER_4;
+
+    const int32_t footer_length = (int32_t) fb.used;
+    __arrow_writer_write(&writer, metadata, fb.used);
+    __arrow_writer_write(&writer, &footer_length, sizeof(int32_t));
+    __arrow_writer_write(&writer, ARROW_IPC_MAGIC, strlen(ARROW_IPC_MAGIC));
+    free(fb.data);
+
+    if (fclose(writer.file) || writer.failed)
+        goto DEFER_3;
+
+    free(body.nodes);
+    free(body.buffers);
+    free(body.data);
+    free(types);
+    return 0;
+
+DEFER_4:
+    free(fb.data);
+    fclose(writer.file);
+DEFER_3:
+    remove(path);
+DEFER_2:
+    free(body.nodes);
+    free(body.buffers);
+    free(body.data);
+DEFER_1:
+    free(types);
+    return 1;
+}
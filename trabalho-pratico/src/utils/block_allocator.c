@@ -0,0 +1,260 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  block_allocator.c
+ * @brief Implementation of methods in include/utils/block_allocator.h
+ */
+
+/* MAP_ANONYMOUS, MAP_HUGETLB and madvise aren't part of POSIX */
+#ifndef _DEFAULT_SOURCE /* May already be defined in the compiler's flags */
+#define _DEFAULT_SOURCE
+#endif
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "utils/block_allocator.h"
+
+/**
+ * @brief   Directory where large blocks are mapped from files, or an empty string to keep them in
+ *          anonymous memory.
+ * @details Global, as every pool and manager in the process shares it. It's only set before any
+ *          block is allocated.
+ */
+char __block_allocator_spill_directory[PATH_MAX] = "";
+
+int block_allocator_set_spill_directory(const char *path) {
+    if (!path) {
+        *__block_allocator_spill_directory = '\0';
+        return 0;
+    }
+
+    const int written = snprintf(__block_allocator_spill_directory,
+                                 sizeof(__block_allocator_spill_directory),
+                                 "%s",
+                                 path);
+    if (written < 0 || (size_t) written >= sizeof(__block_allocator_spill_directory)) {
+        *__block_allocator_spill_directory = '\0';
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Checks if a block will be mapped to memory, to be backed by huge pages.
+ * @details Blocks smaller than half a huge page are always allocated with `malloc`, as rounding
+ *          them up would waste too much memory.
+ *
+ * @param policy How a block is allocated.
+ * @param size   Size of the block, in bytes.
+ *
+ * @retval 0 The block is allocated with `malloc`.
+ * @retval 1 The block is mapped to memory.
+ */
+int __block_allocator_uses_huge_pages(block_allocator_policy_t policy, size_t size) {
+#if defined(MAP_ANONYMOUS) && (defined(MAP_HUGETLB) || defined(MADV_HUGEPAGE))
+    return policy == BLOCK_ALLOCATOR_POLICY_HUGE_PAGES &&
+           size >= BLOCK_ALLOCATOR_HUGE_PAGE_SIZE / 2;
+#else
+    (void) policy;
+    (void) size;
+    return 0;
+#endif
+}
+
+/**
+ * @brief  Rounds a size up to a multiple of ::BLOCK_ALLOCATOR_HUGE_PAGE_SIZE.
+ * @param  size Size to be rounded.
+ * @return @p size, rounded up.
+ */
+size_t __block_allocator_round_to_huge_pages(size_t size) {
+    const size_t page = BLOCK_ALLOCATOR_HUGE_PAGE_SIZE;
+    return (size + page - 1) / page * page;
+}
+
+size_t block_allocator_get_size(block_allocator_policy_t policy, size_t size) {
+    if (__block_allocator_uses_huge_pages(policy, size))
+        return __block_allocator_round_to_huge_pages(size);
+    return size;
+}
+
+/**
+ * @brief   Maps memory aligned to a huge page, and asks for it to be backed by transparent huge
+ *          pages.
+ * @details Auxiliary method for ::block_allocator_alloc. More memory than needed is mapped, and
+ *          the unaligned ends are unmapped.
+ *
+ * @param size Size of the block, in bytes. Must be a multiple of ::BLOCK_ALLOCATOR_HUGE_PAGE_SIZE.
+ *
+ * @return The mapped block, or `NULL` on failure.
+ */
+void *__block_allocator_map_transparent(size_t size) {
+#ifdef MAP_ANONYMOUS
+    const size_t   page        = BLOCK_ALLOCATOR_HUGE_PAGE_SIZE;
+    const size_t   mapped_size = size + page;
+    uint8_t *const mapped =
+        mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ((void *) mapped == MAP_FAILED)
+        return NULL;
+
+    const size_t head = (page - (uintptr_t) mapped % page) % page;
+    if (head)
+        munmap(mapped, head);
+    if (mapped_size - head - size)
+        munmap(mapped + head + size, mapped_size - head - size);
+
+#ifdef MADV_HUGEPAGE
+    madvise(mapped + head, size, MADV_HUGEPAGE); /* Only a hint: failure isn't an error */
+#endif
+    return mapped + head;
+#else
+    (void) size;
+    return NULL;
+#endif
+}
+
+/**
+ * @brief   Checks if large blocks are being mapped from files in a spill directory.
+ * @details See ::block_allocator_set_spill_directory.
+ *
+ * @param policy How a block is allocated.
+ * @param size   Size of the block, in bytes.
+ *
+ * @retval 0 The block isn't mapped from a file.
+ * @retval 1 The block is mapped from a file in the spill directory.
+ */
+int __block_allocator_spills(block_allocator_policy_t policy, size_t size) {
+    return *__block_allocator_spill_directory && __block_allocator_uses_huge_pages(policy, size);
+}
+
+/**
+ * @brief   Maps memory from a new temporary file in the spill directory.
+ * @details Auxiliary method for ::block_allocator_alloc. The file is deleted right after being
+ *          created, so that it disappears as soon as the block is unmapped, or the program exits.
+ *
+ * @param size Size of the block, in bytes. Must be a multiple of ::BLOCK_ALLOCATOR_HUGE_PAGE_SIZE.
+ *
+ * @return The mapped block, or `NULL` on failure.
+ */
+void *__block_allocator_map_file(size_t size) {
+    char      path[PATH_MAX];
+    const int written =
+        snprintf(path, PATH_MAX, "%s/li3-block-XXXXXX", __block_allocator_spill_directory);
+    if (written < 0 || written >= PATH_MAX)
+        return NULL;
+
+    const int fd = mkstemp(path);
+    if (fd < 0)
+        return NULL;
+    unlink(path);
+
+    void *block = NULL;
+    if (ftruncate(fd, (off_t) size))
+        goto DEFER_1;
+
+    block = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (block == MAP_FAILED)
+        block = NULL;
+
+DEFER_1:
+    close(fd); /* The mapping keeps the file alive */
+    return block;
+}
+
+void *block_allocator_alloc(block_allocator_policy_t policy, size_t size) {
+    if (!__block_allocator_uses_huge_pages(policy, size))
+        return malloc(size);
+
+    const size_t mapped_size = __block_allocator_round_to_huge_pages(size);
+    if (__block_allocator_spills(policy, size))
+        return __block_allocator_map_file(mapped_size);
+
+#ifdef MAP_HUGETLB
+    /* Only succeeds if the administrator has reserved huge pages */
+    void *const block = mmap(NULL,
+                             mapped_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                             -1,
+                             0);
+    if (block != MAP_FAILED)
+        return block;
+#endif
+
+    return __block_allocator_map_transparent(mapped_size);
+}
+
+void block_allocator_free(block_allocator_policy_t policy, void *block, size_t size) {
+    if (!block)
+        return;
+
+    if (__block_allocator_uses_huge_pages(policy, size))
+        munmap(block, __block_allocator_round_to_huge_pages(size));
+    else
+        free(block);
+}
+
+void block_allocator_evict(block_allocator_policy_t policy, const void *block, size_t size) {
+    if (!block || !__block_allocator_spills(policy, size))
+        return;
+
+    /* Only hints: failure is harmless */
+    void *const  mapped      = (void *) (uintptr_t) block;
+    const size_t mapped_size = __block_allocator_round_to_huge_pages(size);
+#if defined(MADV_PAGEOUT)
+    madvise(mapped, mapped_size, MADV_PAGEOUT);
+#elif defined(MADV_COLD)
+    madvise(mapped, mapped_size, MADV_COLD);
+#else
+    msync(mapped, mapped_size, MS_ASYNC);
+#endif
+}
+
+void block_allocator_release_unused(block_allocator_policy_t policy,
+                                    void                    *block,
+                                    size_t                   size,
+                                    size_t                   used) {
+#ifdef MADV_DONTNEED
+    if (!__block_allocator_uses_huge_pages(policy, size))
+        return;
+
+    /* Mapped blocks are huge page aligned, so the rounded offset is also page aligned */
+    const size_t begin = __block_allocator_round_to_huge_pages(used);
+    const size_t end   = __block_allocator_round_to_huge_pages(size);
+    if (begin >= end)
+        return;
+
+#ifdef MADV_REMOVE
+    /* Also free the space on disk, as dropping pages of a file doesn't */
+    if (__block_allocator_spills(policy, size)) {
+        madvise((uint8_t *) block + begin, end - begin, MADV_REMOVE); /* Failure is harmless */
+        return;
+    }
+#endif
+    madvise((uint8_t *) block + begin, end - begin, MADV_DONTNEED); /* Failure is harmless */
+#else
+    (void) policy;
+    (void) block;
+    (void) size;
+    (void) used;
+#endif
+}
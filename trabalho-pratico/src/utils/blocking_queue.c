@@ -0,0 +1,146 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  blocking_queue.c
+ * @brief Implementation of methods in include/utils/blocking_queue.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref blocking_queue_examples).
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "utils/blocking_queue.h"
+
+/**
+ * @struct blocking_queue
+ * @brief  A bounded queue of pointers, shared between threads.
+ *
+ * @var blocking_queue::items
+ *     @brief Circular buffer of ::blocking_queue::capacity items.
+ * @var blocking_queue::capacity
+ *     @brief Number of elements in ::blocking_queue::items.
+ * @var blocking_queue::start
+ *     @brief Index of the first item in ::blocking_queue::items.
+ * @var blocking_queue::length
+ *     @brief Number of items in the queue.
+ * @var blocking_queue::closed
+ *     @brief Whether ::blocking_queue_close has been called.
+ * @var blocking_queue::lock
+ *     @brief Lock that protects all other fields.
+ * @var blocking_queue::not_empty
+ *     @brief Signaled when an item is pushed or when the queue is closed.
+ * @var blocking_queue::not_full
+ *     @brief Signaled when an item is popped or when the queue is closed.
+ */
+struct blocking_queue {
+    void **items;
+    size_t capacity, start, length;
+    int    closed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty, not_full;
+};
+
+blocking_queue_t *blocking_queue_create(size_t capacity) {
+    if (capacity == 0)
+        capacity = 1;
+
+    blocking_queue_t *const queue = malloc(sizeof(blocking_queue_t));
+    if (!queue)
+        goto DEFER_1;
+
+    queue->items = malloc(sizeof(void *) * capacity);
+    if (!queue->items)
+        goto DEFER_2;
+
+    if (pthread_mutex_init(&queue->lock, NULL))
+        goto DEFER_3;
+    if (pthread_cond_init(&queue->not_empty, NULL))
+        goto DEFER_4;
+    if (pthread_cond_init(&queue->not_full, NULL))
+        goto DEFER_5;
+
+    queue->capacity = capacity;
+    queue->start    = 0;
+    queue->length   = 0;
+    queue->closed   = 0;
+    return queue;
+
+DEFER_5:
+    pthread_cond_destroy(&queue->not_empty);
+DEFER_4:
+    pthread_mutex_destroy(&queue->lock);
+DEFER_3:
+    free(queue->items);
+DEFER_2:
+    free(queue);
+DEFER_1:
+    return NULL;
+}
+
+int blocking_queue_push(blocking_queue_t *queue, void *item) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->length == queue->capacity && !queue->closed)
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+
+    if (queue->closed) {
+        pthread_mutex_unlock(&queue->lock);
+        return 1;
+    }
+
+    queue->items[(queue->start + queue->length) % queue->capacity] = item;
+    queue->length++;
+
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return 0;
+}
+
+void *blocking_queue_pop(blocking_queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->length == 0 && !queue->closed)
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+
+    void *item = NULL;
+    if (queue->length) {
+        item         = queue->items[queue->start];
+        queue->start = (queue->start + 1) % queue->capacity;
+        queue->length--;
+        pthread_cond_signal(&queue->not_full);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return item;
+}
+
+void blocking_queue_close(blocking_queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = 1;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+void blocking_queue_free(blocking_queue_t *queue) {
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+    free(queue);
+}
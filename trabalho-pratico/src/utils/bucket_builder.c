@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  bucket_builder.c
+ * @brief Implementation of methods in include/utils/bucket_builder.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref bucket_builder_examples).
+ */
+
+#include <stdlib.h>
+
+#include "utils/bucket_builder.h"
+
+/**
+ * @struct bucket_builder
+ * @brief  Per-key arrays being built in a single buffer, in two passes.
+ *
+ * @var bucket_builder::nbuckets
+ *     @brief Number of buckets.
+ * @var bucket_builder::item_size
+ *     @brief Size, in bytes, of each item.
+ * @var bucket_builder::offsets
+ *     @brief   Before ::bucket_builder_allocate, number of items counted for each bucket. After
+ *              that, index in ::bucket_builder::items of the first item of each bucket.
+ *     @details ::bucket_builder::nbuckets `+ 1` elements, so that the last one is the number of
+ *              items in all buckets.
+ * @var bucket_builder::placed
+ *     @brief   Number of items already placed in each bucket.
+ *     @details `NULL` before ::bucket_builder_allocate.
+ * @var bucket_builder::items
+ *     @brief Buffer with the items of all buckets, one bucket after the other.
+ * @var bucket_builder::owns_items
+ *     @brief Whether ::bucket_builder::items is to be `free`d with the builder.
+ */
+struct bucket_builder {
+    size_t  nbuckets, item_size;
+    size_t *offsets, *placed;
+    char   *items;
+    int     owns_items;
+};
+
+bucket_builder_t *bucket_builder_create(size_t nbuckets, size_t item_size) {
+    bucket_builder_t *const builder = malloc(sizeof(bucket_builder_t));
+    if (!builder)
+        return NULL;
+
+    builder->offsets = calloc(nbuckets + 1, sizeof(size_t));
+    if (!builder->offsets) {
+        free(builder);
+        return NULL;
+    }
+
+    builder->nbuckets   = nbuckets;
+    builder->item_size  = item_size;
+    builder->placed     = NULL;
+    builder->items      = NULL;
+    builder->owns_items = 1;
+    return builder;
+}
+
+void bucket_builder_count(bucket_builder_t *builder, size_t bucket, size_t n) {
+    builder->offsets[bucket + 1] += n;
+}
+
+int bucket_builder_allocate(bucket_builder_t *builder) {
+    for (size_t i = 1; i <= builder->nbuckets; ++i)
+        builder->offsets[i] += builder->offsets[i - 1];
+
+    builder->placed = calloc(builder->nbuckets ? builder->nbuckets : 1, sizeof(size_t));
+    if (!builder->placed)
+        return 1;
+
+    const size_t total = builder->offsets[builder->nbuckets];
+    if (total) {
+        builder->items = malloc(total * builder->item_size);
+        if (!builder->items) {
+            free(builder->placed);
+            builder->placed = NULL;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void *bucket_builder_place(bucket_builder_t *builder, size_t bucket, size_t n) {
+    const size_t position = builder->offsets[bucket] + builder->placed[bucket];
+    builder->placed[bucket] += n;
+    return builder->items + position * builder->item_size;
+}
+
+void *bucket_builder_get_bucket(const bucket_builder_t *builder, size_t bucket, size_t *n) {
+    *n = builder->offsets[bucket + 1] - builder->offsets[bucket];
+    return builder->items ? builder->items + builder->offsets[bucket] * builder->item_size : NULL;
+}
+
+void *bucket_builder_steal_items(bucket_builder_t *builder) {
+    builder->owns_items = 0;
+    return builder->items;
+}
+
+void bucket_builder_free(bucket_builder_t *builder) {
+    if (builder->owns_items)
+        free(builder->items);
+    free(builder->offsets);
+    free(builder->placed);
+    free(builder);
+}
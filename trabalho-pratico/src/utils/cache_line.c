@@ -0,0 +1,42 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  cache_line.c
+ * @brief Implementation of methods in include/utils/cache_line.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref cache_line_examples).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/cache_line.h"
+
+void *cache_line_calloc(size_t size) {
+    const size_t rounded = CACHE_LINE_ROUND_UP(size ? size : 1);
+    if (rounded < size)
+        return NULL; /* Overflow */
+
+    void *ret;
+    if (posix_memalign(&ret, CACHE_LINE_SIZE, rounded))
+        return NULL;
+
+    memset(ret, 0, rounded);
+    return ret;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  cancellation.c
+ * @brief Implementation of methods in include/utils/cancellation.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref cancellation_examples).
+ */
+
+#include <glib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "utils/cancellation.h"
+
+/**
+ * @brief   Key of the current ::cancellation_t of every thread (`NULL` when not set).
+ * @details Shall not be modified apart from its creation. This global variable is justified for
+ *          the following reasons:
+ *
+ *          -# It's not modified (no mutable global state). Each thread has its own value;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# Cancellation is checked very deep inside queries, whose callbacks don't know which
+ *             work they're part of.
+ */
+pthread_key_t __cancellation_current;
+
+/** @brief Whether ::__cancellation_current was successfully created. */
+int __cancellation_has_current = 0;
+
+/** @brief Automatically creates ::__cancellation_current when the program starts. */
+void __attribute__((constructor)) __cancellation_current_create(void) {
+    __cancellation_has_current = !pthread_key_create(&__cancellation_current, NULL);
+}
+
+/** @brief Automatically deletes ::__cancellation_current when the program terminates. */
+void __attribute__((destructor)) __cancellation_current_delete(void) {
+    if (__cancellation_has_current)
+        pthread_key_delete(__cancellation_current);
+}
+
+/**
+ * @brief  Gets the current time, for deadlines.
+ * @return The value of `CLOCK_MONOTONIC`, in nanoseconds.
+ */
+uint64_t __cancellation_get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+void cancellation_set_timeout(cancellation_t *cancellation, uint64_t timeout) {
+    cancellation->deadline = __cancellation_get_time() + timeout * 1000;
+}
+
+void cancellation_cancel(cancellation_t *cancellation) {
+    g_atomic_int_set(&cancellation->cancelled, 1);
+}
+
+int cancellation_is_requested(const cancellation_t *cancellation) {
+    if (!cancellation)
+        return 0;
+
+    if (g_atomic_int_get(&cancellation->cancelled))
+        return 1;
+    return cancellation->deadline && __cancellation_get_time() >= cancellation->deadline;
+}
+
+void cancellation_set_current(const cancellation_t *cancellation) {
+    if (__cancellation_has_current)
+        pthread_setspecific(__cancellation_current, cancellation);
+}
+
+const cancellation_t *cancellation_get_current(void) {
+    if (!__cancellation_has_current)
+        return NULL;
+    return pthread_getspecific(__cancellation_current);
+}
+
+const cancellation_t *cancellation_suspend(void) {
+    const cancellation_t *const previous = cancellation_get_current();
+    if (previous)
+        cancellation_set_current(NULL);
+    return previous;
+}
+
+int cancellation_check(void) {
+    const cancellation_t *const current = cancellation_get_current();
+    if (current && current->yield)
+        current->yield(current->yield_data);
+    return cancellation_is_requested(current);
+}
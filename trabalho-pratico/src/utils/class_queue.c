@@ -0,0 +1,193 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  class_queue.c
+ * @brief Implementation of methods in include/utils/class_queue.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref class_queue_examples).
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "utils/class_queue.h"
+
+/**
+ * @struct class_queue
+ * @brief  A bounded queue of pointers, shared between threads, split into priority classes.
+ *
+ * @var class_queue::items
+ *     @brief   Circular buffers of ::class_queue::capacity items, one after the other, one per
+ *              class.
+ *     @details Class `i` starts at `items + i * capacity`.
+ * @var class_queue::starts
+ *     @brief Index of the first item of each class, in its circular buffer.
+ * @var class_queue::lengths
+ *     @brief Number of items in each class.
+ * @var class_queue::nclasses
+ *     @brief Number of priority classes.
+ * @var class_queue::capacity
+ *     @brief Maximum number of items in each class.
+ * @var class_queue::closed
+ *     @brief Whether ::class_queue_close has been called.
+ * @var class_queue::lock
+ *     @brief Lock that protects all other fields.
+ * @var class_queue::not_empty
+ *     @brief Signaled when an item is pushed or when the queue is closed.
+ * @var class_queue::not_full
+ *     @brief Signaled when an item is popped or when the queue is closed.
+ */
+struct class_queue {
+    void  **items;
+    size_t *starts, *lengths;
+    size_t  nclasses, capacity;
+    int     closed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty, not_full;
+};
+
+class_queue_t *class_queue_create(size_t nclasses, size_t capacity) {
+    if (nclasses == 0)
+        nclasses = 1;
+    if (capacity == 0)
+        capacity = 1;
+
+    class_queue_t *const queue = malloc(sizeof(class_queue_t));
+    if (!queue)
+        goto DEFER_1;
+
+    queue->items = malloc(sizeof(void *) * nclasses * capacity);
+    if (!queue->items)
+        goto DEFER_2;
+
+    queue->starts = calloc(nclasses * 2, sizeof(size_t));
+    if (!queue->starts)
+        goto DEFER_3;
+    queue->lengths = queue->starts + nclasses;
+
+    if (pthread_mutex_init(&queue->lock, NULL))
+        goto DEFER_4;
+    if (pthread_cond_init(&queue->not_empty, NULL))
+        goto DEFER_5;
+    if (pthread_cond_init(&queue->not_full, NULL))
+        goto DEFER_6;
+
+    queue->nclasses = nclasses;
+    queue->capacity = capacity;
+    queue->closed   = 0;
+    return queue;
+
+DEFER_6:
+    pthread_cond_destroy(&queue->not_empty);
+DEFER_5:
+    pthread_mutex_destroy(&queue->lock);
+DEFER_4:
+    free(queue->starts);
+DEFER_3:
+    free(queue->items);
+DEFER_2:
+    free(queue);
+DEFER_1:
+    return NULL;
+}
+
+int class_queue_push(class_queue_t *queue, void *item, size_t item_class) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->lengths[item_class] == queue->capacity && !queue->closed)
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+
+    if (queue->closed) {
+        pthread_mutex_unlock(&queue->lock);
+        return 1;
+    }
+
+    const size_t i = (queue->starts[item_class] + queue->lengths[item_class]) % queue->capacity;
+    queue->items[item_class * queue->capacity + i] = item;
+    queue->lengths[item_class]++;
+
+    /* Any consumer can take the most urgent class, but only some can take the others */
+    if (item_class == 0)
+        pthread_cond_signal(&queue->not_empty);
+    else
+        pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return 0;
+}
+
+/**
+ * @brief   Removes the oldest item of the most urgent non-empty class, among classes `0` to
+ *          @p max_class.
+ * @details Auxiliary method for ::class_queue_pop and ::class_queue_try_pop. ::class_queue::lock
+ *          must be held.
+ *
+ * @param queue     Queue to be modified.
+ * @param max_class Least urgent class that can be taken.
+ *
+ * @return The removed item, or `NULL` if there are no items in classes `0` to @p max_class.
+ */
+void *__class_queue_pop_locked(class_queue_t *queue, size_t max_class) {
+    for (size_t c = 0; c < queue->nclasses && c <= max_class; ++c) {
+        if (queue->lengths[c]) {
+            void *const item = queue->items[c * queue->capacity + queue->starts[c]];
+            queue->starts[c] = (queue->starts[c] + 1) % queue->capacity;
+            queue->lengths[c]--;
+
+            /* Producers may be waiting on different classes */
+            pthread_cond_broadcast(&queue->not_full);
+            return item;
+        }
+    }
+    return NULL;
+}
+
+void *class_queue_pop(class_queue_t *queue, size_t max_class) {
+    pthread_mutex_lock(&queue->lock);
+
+    void *item;
+    while (!(item = __class_queue_pop_locked(queue, max_class)) && !queue->closed)
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+
+    pthread_mutex_unlock(&queue->lock);
+    return item;
+}
+
+void *class_queue_try_pop(class_queue_t *queue, size_t max_class) {
+    pthread_mutex_lock(&queue->lock);
+    void *const item = __class_queue_pop_locked(queue, max_class);
+    pthread_mutex_unlock(&queue->lock);
+    return item;
+}
+
+void class_queue_close(class_queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = 1;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+void class_queue_free(class_queue_t *queue) {
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->starts);
+    free(queue->items);
+    free(queue);
+}
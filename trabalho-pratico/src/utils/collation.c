@@ -0,0 +1,119 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  collation.c
+ * @brief Implementation of methods in include/utils/collation.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref collation_examples).
+ */
+
+#include <locale.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "utils/collation.h"
+
+/** @brief Locale used for collation, created by ::__collation_init. */
+locale_t __collation_locale = (locale_t) 0;
+
+/** @brief Whether ::__collation_locale orders ASCII strings by their bytes. */
+int __collation_ascii_is_bytewise = 0;
+
+/** @brief Makes sure ::__collation_init is only called once. */
+pthread_once_t __collation_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Checks if all characters in a string are ASCII.
+ * @param str String to be checked.
+ * @retval 1 All characters are ASCII.
+ * @retval 0 There's at least one non-ASCII character.
+ */
+int __collation_is_ascii(const char *str) {
+    for (; *str; ++str)
+        if ((unsigned char) *str >= 0x80)
+            return 0;
+    return 1;
+}
+
+/**
+ * @brief   Checks if ::__collation_locale orders ASCII strings by their bytes.
+ * @details For that to happen, collation keys of ASCII strings must be the strings themselves,
+ *          so that they can be mixed with keys generated with `strxfrm_l`.
+ *
+ * @retval 1 ASCII strings are ordered by their bytes.
+ * @retval 0 ASCII strings are ordered in another way.
+ */
+int __collation_check_ascii_is_bytewise(void) {
+    char ascii[0x7F - 0x20 + 1], key[sizeof(ascii) * 4];
+    for (size_t i = 0; i < sizeof(ascii) - 1; ++i)
+        ascii[i] = (char) (0x20 + i);
+    ascii[sizeof(ascii) - 1] = '\0';
+
+    if (strxfrm_l(key, ascii, sizeof(key), __collation_locale) >= sizeof(key) ||
+        strcmp(key, ascii) != 0)
+        return 0;
+
+    for (size_t i = 1; i < sizeof(ascii) - 1; ++i) {
+        const char previous[2] = {ascii[i - 1], '\0'}, current[2] = {ascii[i], '\0'};
+        if (strcoll_l(previous, current, __collation_locale) >= 0)
+            return 0;
+    }
+    return 1;
+}
+
+/** @brief Creates ::__collation_locale. Called through `pthread_once`. */
+void __collation_init(void) {
+    /* Fallback to the current locale if this locale isn't available */
+    __collation_locale = newlocale(LC_COLLATE_MASK, COLLATION_LOCALE, (locale_t) 0);
+    if (!__collation_locale)
+        __collation_locale = duplocale(LC_GLOBAL_LOCALE);
+
+    if (__collation_locale)
+        __collation_ascii_is_bytewise = __collation_check_ascii_is_bytewise();
+}
+
+locale_t collation_get_locale(void) {
+    pthread_once(&__collation_once, __collation_init);
+    return __collation_locale;
+}
+
+int collation_compare(const char *a, const char *b) {
+    const locale_t locale = collation_get_locale();
+    if (!locale || (__collation_ascii_is_bytewise && __collation_is_ascii(a) &&
+                    __collation_is_ascii(b)))
+        return strcmp(a, b);
+
+    return strcoll_l(a, b, locale);
+}
+
+const char *collation_key(string_pool_t *pool, const char *str) {
+    const locale_t locale = collation_get_locale();
+    if (!locale)
+        return NULL;
+    if (__collation_ascii_is_bytewise && __collation_is_ascii(str))
+        return string_pool_put(pool, str);
+
+    const size_t length = strxfrm_l(NULL, str, 0, locale);
+    char *const  key    = string_pool_allocate(pool, length);
+    if (!key)
+        return NULL;
+
+    strxfrm_l(key, str, length + 1, locale);
+    return key;
+}
@@ -0,0 +1,439 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  compressed_bitmap.c
+ * @brief Implementation of methods in include/utils/compressed_bitmap.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref compressed_bitmap_examples).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/compressed_bitmap.h"
+
+/** @brief Number of 64-bit words in a chunk stored as a bitset (65536 bits). */
+#define COMPRESSED_BITMAP_BITSET_WORDS 1024
+
+/**
+ * @brief   Maximum number of indices in a chunk stored as an array.
+ * @details Past this, an array would take more memory than a bitset.
+ */
+#define COMPRESSED_BITMAP_ARRAY_MAX_CARDINALITY 4096
+
+/** @brief Initial number of chunks (or array elements) allocated when the first one is added. */
+#define COMPRESSED_BITMAP_INITIAL_CAPACITY 16
+
+/**
+ * @struct compressed_bitmap_chunk_t
+ * @brief  Indices in a ::compressed_bitmap_t with the same 16 most significant bits.
+ *
+ * @var compressed_bitmap_chunk_t::array
+ *     @brief Sorted 16 least significant bits of every index. `NULL` for bitset chunks.
+ * @var compressed_bitmap_chunk_t::bits
+ *     @brief ::COMPRESSED_BITMAP_BITSET_WORDS words with a bit for every possible index. `NULL` for
+ *            array chunks.
+ * @var compressed_bitmap_chunk_t::cardinality
+ *     @brief Number of indices in the chunk.
+ * @var compressed_bitmap_chunk_t::capacity
+ *     @brief Number of elements that fit in ::compressed_bitmap_chunk_t::array.
+ * @var compressed_bitmap_chunk_t::high
+ *     @brief 16 most significant bits of every index in the chunk.
+ */
+typedef struct {
+    uint16_t *array;
+    uint64_t *bits;
+    uint32_t  cardinality, capacity;
+    uint16_t  high;
+} compressed_bitmap_chunk_t;
+
+/**
+ * @struct compressed_bitmap
+ * @brief  A compressed set of integer indices.
+ *
+ * @var compressed_bitmap::chunks
+ *     @brief Non-empty chunks, sorted by ::compressed_bitmap_chunk_t::high.
+ * @var compressed_bitmap::length
+ *     @brief Number of elements in ::compressed_bitmap::chunks.
+ * @var compressed_bitmap::capacity
+ *     @brief Number of elements that fit in ::compressed_bitmap::chunks.
+ */
+struct compressed_bitmap {
+    compressed_bitmap_chunk_t *chunks;
+    size_t                     length, capacity;
+};
+
+compressed_bitmap_t *compressed_bitmap_create(void) {
+    compressed_bitmap_t *const bitmap = malloc(sizeof(compressed_bitmap_t));
+    if (!bitmap)
+        return NULL;
+
+    bitmap->chunks   = NULL;
+    bitmap->length   = 0;
+    bitmap->capacity = 0;
+    return bitmap;
+}
+
+/**
+ * @brief Adds a new empty array chunk to the end of a bitmap.
+ *
+ * @param bitmap Bitmap to be modified.
+ * @param high   16 most significant bits of the indices in the new chunk.
+ *
+ * @return The new chunk, or `NULL` on allocation failure.
+ */
+compressed_bitmap_chunk_t *__compressed_bitmap_append_chunk(compressed_bitmap_t *bitmap,
+                                                            uint16_t             high) {
+    if (bitmap->length == bitmap->capacity) {
+        const size_t new_capacity =
+            bitmap->capacity ? bitmap->capacity * 2 : COMPRESSED_BITMAP_INITIAL_CAPACITY;
+        compressed_bitmap_chunk_t *const new_chunks =
+            realloc(bitmap->chunks, new_capacity * sizeof(compressed_bitmap_chunk_t));
+        if (!new_chunks)
+            return NULL;
+
+        bitmap->chunks   = new_chunks;
+        bitmap->capacity = new_capacity;
+    }
+
+    compressed_bitmap_chunk_t *const chunk = &bitmap->chunks[bitmap->length++];
+    *chunk = (compressed_bitmap_chunk_t) {.array       = NULL,
+                                          .bits        = NULL,
+                                          .cardinality = 0,
+                                          .capacity    = 0,
+                                          .high        = high};
+    return chunk;
+}
+
+/**
+ * @brief Adds a value to the end of an array chunk, converting it to a bitset if it gets too large.
+ *
+ * @param chunk Array chunk to be modified.
+ * @param low   16 least significant bits of the index to add. Must be greater than all others in
+ *              @p chunk.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p chunk is left unchanged).
+ */
+int __compressed_bitmap_array_chunk_add(compressed_bitmap_chunk_t *chunk, uint16_t low) {
+    if (chunk->cardinality == COMPRESSED_BITMAP_ARRAY_MAX_CARDINALITY) {
+        uint64_t *const bits = calloc(COMPRESSED_BITMAP_BITSET_WORDS, sizeof(uint64_t));
+        if (!bits)
+            return 1;
+
+        for (uint32_t i = 0; i < chunk->cardinality; ++i)
+            bits[chunk->array[i] >> 6] |= (uint64_t) 1 << (chunk->array[i] & 63);
+        bits[low >> 6] |= (uint64_t) 1 << (low & 63);
+
+        free(chunk->array);
+        chunk->array    = NULL;
+        chunk->bits     = bits;
+        chunk->capacity = 0;
+        chunk->cardinality++;
+        return 0;
+    }
+
+    if (chunk->cardinality == chunk->capacity) {
+        const uint32_t new_capacity =
+            chunk->capacity ? chunk->capacity * 2 : COMPRESSED_BITMAP_INITIAL_CAPACITY;
+        uint16_t *const new_array = realloc(chunk->array, new_capacity * sizeof(uint16_t));
+        if (!new_array)
+            return 1;
+
+        chunk->array    = new_array;
+        chunk->capacity = new_capacity;
+    }
+
+    chunk->array[chunk->cardinality++] = low;
+    return 0;
+}
+
+int compressed_bitmap_add(compressed_bitmap_t *bitmap, uint32_t index) {
+    const uint16_t high = index >> 16;
+    const uint16_t low  = index & 0xFFFF;
+
+    compressed_bitmap_chunk_t *chunk = NULL;
+    if (bitmap->length && bitmap->chunks[bitmap->length - 1].high == high) {
+        chunk = &bitmap->chunks[bitmap->length - 1];
+    } else {
+        chunk = __compressed_bitmap_append_chunk(bitmap, high);
+        if (!chunk)
+            return 1;
+    }
+
+    if (chunk->bits) {
+        chunk->bits[low >> 6] |= (uint64_t) 1 << (low & 63);
+        chunk->cardinality++;
+        return 0;
+    }
+
+    if (__compressed_bitmap_array_chunk_add(chunk, low)) {
+        if (chunk->cardinality == 0)
+            bitmap->length--; /* Don't leave an empty chunk behind */
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks if a chunk contains a value.
+ *
+ * @param chunk Chunk to search in.
+ * @param low   16 least significant bits of the index to look for.
+ *
+ * @return `1` if @p low is in @p chunk, `0` otherwise.
+ */
+int __compressed_bitmap_chunk_contains(const compressed_bitmap_chunk_t *chunk, uint16_t low) {
+    if (chunk->bits)
+        return (chunk->bits[low >> 6] >> (low & 63)) & 1;
+
+    size_t begin = 0, end = chunk->cardinality;
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+        if (chunk->array[middle] < low)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin < chunk->cardinality && chunk->array[begin] == low;
+}
+
+int compressed_bitmap_contains(const compressed_bitmap_t *bitmap, uint32_t index) {
+    const uint16_t high = index >> 16;
+
+    size_t begin = 0, end = bitmap->length;
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+        if (bitmap->chunks[middle].high < high)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+
+    return begin < bitmap->length && bitmap->chunks[begin].high == high &&
+           __compressed_bitmap_chunk_contains(&bitmap->chunks[begin], index & 0xFFFF);
+}
+
+size_t compressed_bitmap_count(const compressed_bitmap_t *bitmap) {
+    size_t count = 0;
+    for (size_t i = 0; i < bitmap->length; ++i)
+        count += bitmap->chunks[i].cardinality;
+    return count;
+}
+
+/**
+ * @brief   Intersects two chunks with the same ::compressed_bitmap_chunk_t::high.
+ * @details Auxiliary method for ::compressed_bitmap_and and ::compressed_bitmap_and_count.
+ *
+ * @param a      First chunk.
+ * @param b      Second chunk.
+ * @param output Empty array chunk where to write the intersection to, or `NULL` to only count it.
+ *
+ * @return The number of indices in both @p a and @p b, or `SIZE_MAX` on allocation failure.
+ */
+size_t __compressed_bitmap_chunk_and(const compressed_bitmap_chunk_t *a,
+                                     const compressed_bitmap_chunk_t *b,
+                                     compressed_bitmap_chunk_t       *output) {
+    if (a->bits && b->bits) {
+        size_t count = 0;
+        if (!output) {
+            for (size_t i = 0; i < COMPRESSED_BITMAP_BITSET_WORDS; ++i)
+                count += __builtin_popcountll(a->bits[i] & b->bits[i]);
+            return count;
+        }
+
+        uint64_t *const bits = malloc(COMPRESSED_BITMAP_BITSET_WORDS * sizeof(uint64_t));
+        if (!bits)
+            return SIZE_MAX;
+
+        for (size_t i = 0; i < COMPRESSED_BITMAP_BITSET_WORDS; ++i) {
+            bits[i]  = a->bits[i] & b->bits[i];
+            count   += __builtin_popcountll(bits[i]);
+        }
+
+        output->bits        = bits;
+        output->cardinality = count;
+        if (count > COMPRESSED_BITMAP_ARRAY_MAX_CARDINALITY)
+            return count;
+
+        /* Few indices in common: convert back to an array */
+        /* Always allocate at least one byte, so that NULL only means failure */
+        uint16_t *const array = malloc(count * sizeof(uint16_t) + 1);
+        if (!array) {
+            free(bits);
+            output->bits = NULL;
+            return SIZE_MAX;
+        }
+
+        size_t n = 0;
+        for (size_t i = 0; i < COMPRESSED_BITMAP_BITSET_WORDS; ++i)
+            for (uint64_t word = bits[i]; word; word &= word - 1)
+                array[n++] = (i << 6) | __builtin_ctzll(word);
+
+        free(bits);
+        output->bits     = NULL;
+        output->array    = array;
+        output->capacity = count;
+        return count;
+    }
+
+    /* At least one of the chunks is an array: test each of its values in the other chunk */
+    const compressed_bitmap_chunk_t *const array_chunk = a->bits ? b : a;
+    const compressed_bitmap_chunk_t *const other_chunk = a->bits ? a : b;
+
+    if (output) {
+        /* Always allocate at least one byte, so that NULL only means failure */
+        output->array = malloc(array_chunk->cardinality * sizeof(uint16_t) + 1);
+        if (!output->array)
+            return SIZE_MAX;
+        output->capacity = array_chunk->cardinality;
+    }
+
+    size_t count = 0;
+    for (uint32_t i = 0; i < array_chunk->cardinality; ++i) {
+        const uint16_t low = array_chunk->array[i];
+        if (__compressed_bitmap_chunk_contains(other_chunk, low)) {
+            if (output)
+                output->array[count] = low;
+            count++;
+        }
+    }
+
+    if (output)
+        output->cardinality = count;
+    return count;
+}
+
+/**
+ * @brief   Intersects two bitmaps, writing the intersection to a third one or only counting it.
+ * @details Auxiliary method for ::compressed_bitmap_and and ::compressed_bitmap_and_count.
+ *
+ * @param a      First bitmap.
+ * @param b      Second bitmap.
+ * @param output Empty bitmap where to write the intersection to, or `NULL` to only count it.
+ *
+ * @return The number of indices in both @p a and @p b, or `SIZE_MAX` on allocation failure.
+ */
+size_t __compressed_bitmap_and(const compressed_bitmap_t *a,
+                               const compressed_bitmap_t *b,
+                               compressed_bitmap_t       *output) {
+    size_t count = 0;
+    size_t i = 0, j = 0;
+    while (i < a->length && j < b->length) {
+        const compressed_bitmap_chunk_t *const chunk_a = &a->chunks[i];
+        const compressed_bitmap_chunk_t *const chunk_b = &b->chunks[j];
+
+        if (chunk_a->high < chunk_b->high) {
+            i++;
+        } else if (chunk_a->high > chunk_b->high) {
+            j++;
+        } else {
+            compressed_bitmap_chunk_t *chunk = NULL;
+            if (output) {
+                chunk = __compressed_bitmap_append_chunk(output, chunk_a->high);
+                if (!chunk)
+                    return SIZE_MAX;
+            }
+
+            const size_t chunk_count = __compressed_bitmap_chunk_and(chunk_a, chunk_b, chunk);
+            if (chunk_count == SIZE_MAX) {
+                output->length--;
+                return SIZE_MAX;
+            }
+
+            if (output && chunk_count == 0) {
+                free(chunk->array);
+                output->length--;
+            }
+
+            count += chunk_count;
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+compressed_bitmap_t *compressed_bitmap_and(const compressed_bitmap_t *a,
+                                           const compressed_bitmap_t *b) {
+    compressed_bitmap_t *const output = compressed_bitmap_create();
+    if (!output)
+        return NULL;
+
+    if (__compressed_bitmap_and(a, b, output) == SIZE_MAX) {
+        compressed_bitmap_free(output);
+        return NULL;
+    }
+    return output;
+}
+
+size_t compressed_bitmap_and_count(const compressed_bitmap_t *a, const compressed_bitmap_t *b) {
+    return __compressed_bitmap_and(a, b, NULL);
+}
+
+int compressed_bitmap_iter(const compressed_bitmap_t        *bitmap,
+                           compressed_bitmap_iter_callback_t callback,
+                           void                             *user_data) {
+
+    for (size_t i = 0; i < bitmap->length; ++i) {
+        const compressed_bitmap_chunk_t *const chunk = &bitmap->chunks[i];
+        const uint32_t                         high  = (uint32_t) chunk->high << 16;
+
+        if (chunk->bits) {
+            for (uint32_t w = 0; w < COMPRESSED_BITMAP_BITSET_WORDS; ++w) {
+                for (uint64_t word = chunk->bits[w]; word; word &= word - 1) {
+                    const int retval = callback(user_data, high | (w << 6) | __builtin_ctzll(word));
+                    if (retval)
+                        return retval;
+                }
+            }
+        } else {
+            for (uint32_t j = 0; j < chunk->cardinality; ++j) {
+                const int retval = callback(user_data, high | chunk->array[j]);
+                if (retval)
+                    return retval;
+            }
+        }
+    }
+    return 0;
+}
+
+size_t compressed_bitmap_get_memory_usage(const compressed_bitmap_t *bitmap) {
+    size_t usage =
+        sizeof(compressed_bitmap_t) + bitmap->capacity * sizeof(compressed_bitmap_chunk_t);
+
+    for (size_t i = 0; i < bitmap->length; ++i) {
+        const compressed_bitmap_chunk_t *const chunk = &bitmap->chunks[i];
+        usage += chunk->bits ? COMPRESSED_BITMAP_BITSET_WORDS * sizeof(uint64_t)
+                             : chunk->capacity * sizeof(uint16_t);
+    }
+    return usage;
+}
+
+void compressed_bitmap_free(compressed_bitmap_t *bitmap) {
+    if (!bitmap)
+        return;
+
+    for (size_t i = 0; i < bitmap->length; ++i) {
+        free(bitmap->chunks[i].array);
+        free(bitmap->chunks[i].bits);
+    }
+    free(bitmap->chunks);
+    free(bitmap);
+}
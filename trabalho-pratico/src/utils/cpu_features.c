@@ -0,0 +1,86 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  cpu_features.c
+ * @brief Implementation of methods in include/utils/cpu_features.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref cpu_features_examples).
+ */
+
+#include <pthread.h>
+
+/** @cond FALSE */
+#if defined(__arm__) && defined(__linux__)
+    #include <sys/auxv.h>
+
+    #ifndef HWCAP_NEON
+        #define HWCAP_NEON (1 << 12)
+    #endif
+#endif
+/** @endcond */
+
+#include "utils/cpu_features.h"
+
+/** @brief Features of the current CPU, detected by ::__cpu_features_init. */
+cpu_features_t __cpu_features = 0;
+
+/** @brief Makes sure ::__cpu_features_init is only called once. */
+pthread_once_t __cpu_features_once = PTHREAD_ONCE_INIT;
+
+/** @brief Detects ::__cpu_features. Called through `pthread_once`. */
+void __cpu_features_init(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init(); /* Needed when called from constructors */
+    if (__builtin_cpu_supports("sse2"))
+        __cpu_features |= CPU_FEATURE_SSE2;
+    if (__builtin_cpu_supports("sse4.2"))
+        __cpu_features |= CPU_FEATURE_SSE4_2;
+    if (__builtin_cpu_supports("avx2"))
+        __cpu_features |= CPU_FEATURE_AVX2;
+    if (__builtin_cpu_supports("avx512bw"))
+        __cpu_features |= CPU_FEATURE_AVX512BW;
+#elif defined(__aarch64__)
+    __cpu_features |= CPU_FEATURE_NEON;
+#elif defined(__arm__) && defined(__linux__)
+    if (getauxval(AT_HWCAP) & HWCAP_NEON)
+        __cpu_features |= CPU_FEATURE_NEON;
+#endif
+}
+
+cpu_features_t cpu_features_get(void) {
+    pthread_once(&__cpu_features_once, __cpu_features_init);
+    return __cpu_features;
+}
+
+const char *cpu_feature_get_name(cpu_feature_t feature) {
+    switch (feature) {
+        case CPU_FEATURE_SSE2:
+            return "SSE2";
+        case CPU_FEATURE_SSE4_2:
+            return "SSE4.2";
+        case CPU_FEATURE_AVX2:
+            return "AVX2";
+        case CPU_FEATURE_AVX512BW:
+            return "AVX512BW";
+        case CPU_FEATURE_NEON:
+            return "NEON";
+        default:
+            return "?";
+    }
+}
@@ -31,31 +31,20 @@
 #include "utils/int_utils.h"
 
 /**
- * @union date_union_helper_t
- * @brief Date with `union`, to easily extract fields from a date integer.
+ * @struct date_fields_t
+ * @brief  Calendar fields of a date, only used for parsing, printing, getters and setters.
  *
- * @var date_union_helper_t::date
- *     @brief Compact date format, exposed to the outside of this module.
- * @var date_union_helper_t::fields
- *     @brief Individual fields within ::date_union_helper_t::date.
- * @var date_union_helper_t::year
- *     @brief Year in @p ::date_union_helper_t::date. Must be between ::DATE_YEAR_MIN and
- *            ::DATE_YEAR_MAX.
- * @var date_union_helper_t::month
- *     @brief Month in @p ::date_union_helper_t::date. Must be between ::DATE_MONTH_MIN and
- *            ::DATE_MONTH_MAX.
- * @var date_union_helper_t::day
- *     @brief Day in @p ::date_union_helper_t::date. Must be between ::DATE_DAY_MIN and
- *            ::DATE_DAY_MAX.
+ * @var date_fields_t::year
+ *     @brief Year in the date. Must be between ::DATE_YEAR_MIN and ::DATE_YEAR_MAX.
+ * @var date_fields_t::month
+ *     @brief Month in the date. Must be between ::DATE_MONTH_MIN and ::DATE_MONTH_MAX.
+ * @var date_fields_t::day
+ *     @brief Day in the date. Must be between ::DATE_DAY_MIN and ::DATE_DAY_MAX.
  */
-typedef union {
-    const date_t date;
-
-    struct {
-        uint16_t year;
-        uint8_t  month, day;
-    } fields;
-} date_union_helper_t;
+typedef struct {
+    uint16_t year;
+    uint8_t  month, day;
+} date_fields_t;
 
 /** @brief The minimum value (inclusive) that a year in a date may take. */
 #define DATE_YEAR_MIN  1
@@ -70,28 +59,47 @@ typedef union {
 /** @brief The maximum value (inclusive) that a day in a date may take. */
 #define DATE_DAY_MAX   31
 
-int date_from_values(date_t *output, uint16_t year, uint8_t month, uint8_t day) {
-    date_union_helper_t date_union;
+/**
+ * @brief   Converts calendar fields into a day number (see ::date_t).
+ * @param   fields Valid calendar fields of a date.
+ * @return  The day number of the date in @p fields.
+ */
+date_t __date_from_fields(date_fields_t fields) {
+    return (date_t) fields.year * DATE_DAYS_PER_YEAR +
+           (date_t) (fields.month - DATE_MONTH_MIN) * DATE_DAYS_PER_MONTH +
+           (date_t) (fields.day - DATE_DAY_MIN);
+}
+
+/**
+ * @brief  Converts a day number (see ::date_t) back into calendar fields.
+ * @param  date Date to be converted.
+ * @return The calendar fields of @p date.
+ */
+date_fields_t __date_to_fields(date_t date) {
+    const date_fields_t fields = {
+        .year  = date / DATE_DAYS_PER_YEAR,
+        .month = date % DATE_DAYS_PER_YEAR / DATE_DAYS_PER_MONTH + DATE_MONTH_MIN,
+        .day   = date % DATE_DAYS_PER_MONTH + DATE_DAY_MIN};
+    return fields;
+}
 
+int date_from_values(date_t *output, uint16_t year, uint8_t month, uint8_t day) {
     if (year < DATE_YEAR_MIN || year > DATE_YEAR_MAX || month < DATE_MONTH_MIN ||
         month > DATE_MONTH_MAX || day < DATE_DAY_MIN || day > DATE_DAY_MAX) {
 
         return 1;
     }
 
-    date_union.fields.year  = year;
-    date_union.fields.month = month;
-    date_union.fields.day   = day;
-
-    *output = date_union.date;
+    const date_fields_t fields = {.year = year, .month = month, .day = day};
+    *output                    = __date_from_fields(fields);
     return 0;
 }
 
 /**
  * @brief Auxiliary method for ::date_from_string. Parses any of the integers in a date.
  *
- * @param date_data A pointer to a ::date_union_helper_t, whose fields are filled in as the date
- *                  is parsed.
+ * @param date_data A pointer to a ::date_fields_t, whose fields are filled in as the date is
+ *                  parsed.
  * @param token     Number between slashes to be parsed.
  * @param ntoken    Tokens already parsed (number of the current token, `0`-indexed).
  *
@@ -99,7 +107,7 @@ int date_from_values(date_t *output, uint16_t year, uint8_t month, uint8_t day)
  * @retval 1 Integer parsing failure.
  */
 int __date_from_string_parse_field(void *date_data, char *token, size_t ntoken) {
-    date_union_helper_t *const date = date_data;
+    date_fields_t *const date = date_data;
 
     const uint64_t mins[3]    = {DATE_YEAR_MIN, DATE_MONTH_MIN, DATE_DAY_MIN};
     const uint64_t maxs[3]    = {DATE_YEAR_MAX, DATE_MONTH_MAX, DATE_DAY_MAX};
@@ -120,13 +128,13 @@ int __date_from_string_parse_field(void *date_data, char *token, size_t ntoken)
 
     switch (ntoken) {
         case 0:
-            date->fields.year = parsed;
+            date->year = parsed;
             break;
         case 1:
-            date->fields.month = parsed;
+            date->month = parsed;
             break;
         case 2:
-            date->fields.day = parsed;
+            date->day = parsed;
             break;
         default: /* unreachable */
             break;
@@ -159,18 +167,51 @@ void __attribute__((destructor)) __date_grammar_free(void) {
     fixed_n_delimiter_parser_grammar_free(__date_grammar);
 }
 
+int date_from_fixed_width(date_t *output, const char input[10]) {
+    /* Gather the digits of "YYYY/MM/DD" into "YYYYMMDD" */
+    const uint64_t head   = int_utils_load_chars(input);
+    const uint64_t tail   = int_utils_load_chars(input + 2);
+    const uint64_t digits = (head & 0xFFFFFFFF) | ((head >> 8) & 0xFFFF00000000) |
+                            (tail & 0xFFFF000000000000);
+
+    uint8_t   pairs[4];
+    const int invalid = int_utils_parse_digit_pairs(pairs, digits);
+
+    const unsigned int year  = pairs[0] * 100 + pairs[1];
+    const unsigned int month = pairs[2], day = pairs[3];
+
+    /* Bitwise instead of logical operators, to avoid branching */
+    const int valid = !invalid & ((head >> 32 & 0xFF) == '/') & ((head >> 56) == '/') &
+                      (year - DATE_YEAR_MIN <= DATE_YEAR_MAX - DATE_YEAR_MIN) &
+                      (month - DATE_MONTH_MIN <= DATE_MONTH_MAX - DATE_MONTH_MIN) &
+                      (day - DATE_DAY_MIN <= DATE_DAY_MAX - DATE_DAY_MIN);
+    if (!valid)
+        return 1;
+
+    const date_fields_t fields = {.year = year, .month = month, .day = day};
+    *output                    = __date_from_fields(fields);
+    return 0;
+}
+
 int date_from_string(date_t *output, char *input) {
-    date_union_helper_t tmp_date;
-    const int retval = fixed_n_delimiter_parser_parse_string(input, __date_grammar, &tmp_date);
+    /* Only fall back to the grammar for malformed dates, to get the same error codes */
+    if (strnlen(input, 11) == 10 && !date_from_fixed_width(output, input))
+        return 0;
+
+    date_fields_t tmp_date;
+    const int     retval = fixed_n_delimiter_parser_parse_string(input, __date_grammar, &tmp_date);
     if (retval) {
         return retval;
     } else {
-        *output = tmp_date.date;
+        *output = __date_from_fields(tmp_date);
         return 0;
     }
 }
 
 int date_from_string_const(date_t *output, const char *input) {
+    if (strnlen(input, 11) == 10 && !date_from_fixed_width(output, input))
+        return 0;
+
     char *const buffer = strdup(input);
     if (!buffer)
         return 1;
@@ -182,40 +223,31 @@ int date_from_string_const(date_t *output, const char *input) {
 }
 
 void date_sprintf(char *output, date_t date) {
-    const date_union_helper_t date_union = {.date = date};
-
-    sprintf(output,
-            "%04d/%02d/%02d",
-            date_union.fields.year,
-            date_union.fields.month,
-            date_union.fields.day);
+    const date_fields_t fields = __date_to_fields(date);
+    int_utils_write_fixed(output, fields.year, 4);
+    output[4] = '/';
+    int_utils_write_fixed(output + 5, fields.month, 2);
+    output[7] = '/';
+    int_utils_write_fixed(output + 8, fields.day, 2);
+    output[10] = '\0';
 }
 
 int64_t date_diff(date_t a, date_t b) {
-    const date_union_helper_t a_union = {.date = a};
-    const date_union_helper_t b_union = {.date = b};
-
-    const int64_t a_days = (int64_t) a_union.fields.year * 12 * 31 +
-                           (int64_t) a_union.fields.month * 31 + (int64_t) a_union.fields.day;
-    const int64_t b_days = (int64_t) b_union.fields.year * 12 * 31 +
-                           (int64_t) b_union.fields.month * 31 + (int64_t) b_union.fields.day;
-
-    return a_days - b_days;
+    return (int64_t) a - (int64_t) b;
 }
 
 /**
  * @brief Helper macro for defining getters.
- * @param property Property to get in ::date_union_helper_t::fields.
+ * @param property Property to get in ::date_fields_t.
  */
 #define DATE_GETTER_FUNCTION_BODY(property)                                                        \
-    const date_union_helper_t date_union = {.date = date};                                         \
-    return date_union.fields.property;
+    return __date_to_fields(date).property;
 
 /**
  * @brief Helper macro for defining setters.
  *
- * @param property    Property to set in ::date_union_helper_t::fields. Name must match the name of
- *                    the argument in the setter method.
+ * @param property    Property to set in ::date_fields_t. Name must match the name of the argument
+ *                    in the setter method.
  * @param lower_bound Minimum value (inclusive) that @p property can take.
  * @param upper_bound Maximum value (inclusive) that @p property can take.
  */
@@ -224,9 +256,9 @@ int64_t date_diff(date_t a, date_t b) {
         return 1;                                                                                  \
     }                                                                                              \
                                                                                                    \
-    date_union_helper_t date_union = {.date = *date};                                              \
-    date_union.fields.property     = property;                                                     \
-    *date                          = date_union.date;                                              \
+    date_fields_t fields = __date_to_fields(*date);                                                \
+    fields.property      = property;                                                               \
+    *date                = __date_from_fields(fields);                                             \
     return 0;
 
 uint16_t date_get_year(date_t date) {
@@ -254,14 +286,9 @@ int date_set_day(date_t *date, uint8_t day) {
 }
 
 uint32_t date_generate_dayless(date_t date) {
-    date_union_helper_t date_union = {.date = date};
-    date_union.fields.day          = 0;
-    return date_union.date;
+    return date / DATE_DAYS_PER_MONTH;
 }
 
 uint32_t date_generate_monthless(date_t date) {
-    date_union_helper_t date_union = {.date = date};
-    date_union.fields.day          = 0;
-    date_union.fields.month        = 0;
-    return date_union.date;
+    return date / DATE_DAYS_PER_YEAR;
 }
@@ -32,39 +32,31 @@
 #include "utils/fixed_n_delimiter_parser.h"
 
 /**
- * @union date_and_time_union_helper_t
- * @brief Timed date with `union`, to easily extract fields from a timed date integer.
+ * @struct date_and_time_fields_t
+ * @brief  Date and time of a timed date, filled in while it's parsed.
  *
- * @var date_and_time_union_helper_t::date_and_time
- *     @brief Compact timed date format, exposed to the outside of this module.
- * @var date_and_time_union_helper_t::fields
- *     @brief Individual fields within ::date_and_time_union_helper_t::date_and_time.
- * @var date_and_time_union_helper_t::date
- *     @brief Date in ::date_and_time_union_helper_t::date_and_time.
- * @var date_and_time_union_helper_t::time
- *     @brief Time of the day in ::date_and_time_union_helper_t::date_and_time.
+ * @var date_and_time_fields_t::date
+ *     @brief Date in the timed date.
+ * @var date_and_time_fields_t::time
+ *     @brief Time of the day in the timed date.
  */
-typedef union {
-    const date_and_time_t date_and_time;
+typedef struct {
+    date_t    date;
+    daytime_t time;
+} date_and_time_fields_t;
 
-    struct {
-        date_t    date;
-        daytime_t time;
-    } fields;
-} date_and_time_union_helper_t;
+/** @brief Number of seconds in a day. */
+#define DATE_AND_TIME_SECONDS_PER_DAY (24 * 60 * 60)
 
 void date_and_time_from_values(date_and_time_t *output, date_t date, daytime_t time) {
-    date_and_time_union_helper_t date_and_time_union;
-    date_and_time_union.fields.date = date;
-    date_and_time_union.fields.time = time;
-    *output                         = date_and_time_union.date_and_time;
+    *output = (date_and_time_t) date * DATE_AND_TIME_SECONDS_PER_DAY + time;
 }
 
 /**
  * @brief Auxiliary method for ::date_and_time_from_string. Parses dates.
  *
- * @param date_and_time_data A pointer to a ::date_and_time_union_helper_t, whose fields are filled
- *                           in as the timed date is parsed.
+ * @param date_and_time_data A pointer to a ::date_and_time_fields_t, whose fields are filled in
+ *                           as the timed date is parsed.
  * @param token              Date being parsed.
  * @param ntoken             Tokens already parsed (number of the current token, `0`-indexed).
  *
@@ -73,15 +65,15 @@ void date_and_time_from_values(date_and_time_t *output, date_t date, daytime_t t
  */
 int __date_and_time_from_string_parse_date(void *date_and_time_data, char *token, size_t ntoken) {
     (void) ntoken;
-    date_and_time_union_helper_t *const date_and_time = date_and_time_data;
-    return date_from_string(&date_and_time->fields.date, token);
+    date_and_time_fields_t *const date_and_time = date_and_time_data;
+    return date_from_string(&date_and_time->date, token);
 }
 
 /**
  * @brief Auxiliary method for ::date_and_time_from_string. Parses times in the day.
  *
- * @param date_and_time_data A pointer to a ::date_and_time_union_helper_t, whose fields are filled
- *                           in as the timed date is parsed.
+ * @param date_and_time_data A pointer to a ::date_and_time_fields_t, whose fields are filled in
+ *                           as the timed date is parsed.
  * @param token              Time being parsed.
  * @param ntoken             Tokens already parsed (number of the current token, `0`-indexed).
  *
@@ -92,8 +84,8 @@ int __date_and_time_from_string_parse_daytime(void  *date_and_time_data,
                                               char  *token,
                                               size_t ntoken) {
     (void) ntoken;
-    date_and_time_union_helper_t *const date_and_time = date_and_time_data;
-    return daytime_from_string(&date_and_time->fields.time, token);
+    date_and_time_fields_t *const date_and_time = date_and_time_data;
+    return daytime_from_string(&date_and_time->time, token);
 }
 
 /**
@@ -122,19 +114,49 @@ void __attribute__((destructor)) __date_and_time_grammar_free(void) {
     fixed_n_delimiter_parser_grammar_free(__date_and_time_grammar);
 }
 
+/**
+ * @brief   Parses the fixed-width representation of a timed date.
+ * @details Fast path of ::date_and_time_from_string and ::date_and_time_from_string_const.
+ *
+ * @param output Where the parsed timed date is placed. Won't be modified on failure.
+ * @param input  String to parse, in the format `"YYYY/MM/DD HH:MM:SS"`.
+ *
+ * @retval 0 Parsing success.
+ * @retval 1 Parsing failure (@p input isn't a valid timed date in the fixed-width format).
+ */
+int __date_and_time_from_fixed_width(date_and_time_t *output, const char *input) {
+    if (strnlen(input, 20) != 19 || input[10] != ' ')
+        return 1;
+
+    date_and_time_fields_t fields;
+    if (date_from_fixed_width(&fields.date, input) ||
+        daytime_from_fixed_width(&fields.time, input + 11))
+        return 1;
+
+    date_and_time_from_values(output, fields.date, fields.time);
+    return 0;
+}
+
 int date_and_time_from_string(date_and_time_t *output, char *input) {
-    date_and_time_union_helper_t tmp_date;
-    const int                    retval =
+    /* Only fall back to the grammar for malformed input, to get the same error codes */
+    if (!__date_and_time_from_fixed_width(output, input))
+        return 0;
+
+    date_and_time_fields_t tmp_date;
+    const int              retval =
         fixed_n_delimiter_parser_parse_string(input, __date_and_time_grammar, &tmp_date);
     if (retval) {
         return retval;
     } else {
-        *output = tmp_date.date_and_time;
+        date_and_time_from_values(output, tmp_date.date, tmp_date.time);
         return 0;
     }
 }
 
 int date_and_time_from_string_const(date_and_time_t *output, const char *input) {
+    if (!__date_and_time_from_fixed_width(output, input))
+        return 0;
+
     char *const buffer = strdup(input);
     if (!buffer)
         return 1;
@@ -146,43 +168,27 @@ int date_and_time_from_string_const(date_and_time_t *output, const char *input)
 }
 
 void date_and_time_sprintf(char *output, date_and_time_t date_and_time) {
-    const date_and_time_union_helper_t date_and_time_union = {.date_and_time = date_and_time};
-
-    char date_str[DATE_SPRINTF_MIN_BUFFER_SIZE];
-    date_sprintf(date_str, date_and_time_union.fields.date);
-
-    char time_str[DAYTIME_SPRINTF_MIN_BUFFER_SIZE];
-    daytime_sprintf(time_str, date_and_time_union.fields.time);
-
-    sprintf(output, "%s %s", date_str, time_str);
+    date_sprintf(output, date_and_time_get_date(date_and_time));
+    output[DATE_SPRINTF_MIN_BUFFER_SIZE - 1] = ' ';
+    daytime_sprintf(output + DATE_SPRINTF_MIN_BUFFER_SIZE, date_and_time_get_time(date_and_time));
 }
 
 int64_t date_and_time_diff(date_and_time_t a, date_and_time_t b) {
-    const date_and_time_union_helper_t a_union = {.date_and_time = a};
-    const date_and_time_union_helper_t b_union = {.date_and_time = b};
-
-    return date_diff(a_union.fields.date, b_union.fields.date) * (24 * 60 * 60) +
-           daytime_diff(a_union.fields.time, b_union.fields.time);
+    return (int64_t) a - (int64_t) b;
 }
 
 date_t date_and_time_get_date(date_and_time_t date_and_time) {
-    const date_and_time_union_helper_t date_and_time_union = {.date_and_time = date_and_time};
-    return date_and_time_union.fields.date;
+    return date_and_time / DATE_AND_TIME_SECONDS_PER_DAY;
 }
 
 void date_and_time_set_date(date_and_time_t *date_and_time, date_t date) {
-    date_and_time_union_helper_t date_and_time_union = {.date_and_time = *date_and_time};
-    date_and_time_union.fields.date                  = date;
-    *date_and_time                                   = date_and_time_union.date_and_time;
+    date_and_time_from_values(date_and_time, date, date_and_time_get_time(*date_and_time));
 }
 
 daytime_t date_and_time_get_time(date_and_time_t date_and_time) {
-    const date_and_time_union_helper_t date_and_time_union = {.date_and_time = date_and_time};
-    return date_and_time_union.fields.time;
+    return date_and_time % DATE_AND_TIME_SECONDS_PER_DAY;
 }
 
 void date_and_time_set_time(date_and_time_t *date_and_time, daytime_t time) {
-    date_and_time_union_helper_t date_and_time_union = {.date_and_time = *date_and_time};
-    date_and_time_union.fields.time                  = time;
-    *date_and_time                                   = date_and_time_union.date_and_time;
+    date_and_time_from_values(date_and_time, date_and_time_get_date(*date_and_time), time);
 }
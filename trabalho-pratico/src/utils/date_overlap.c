@@ -0,0 +1,144 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  date_overlap.c
+ * @brief Implementation of methods in include/utils/date_overlap.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref date_overlap_examples).
+ */
+
+/** @cond FALSE */
+#if defined(__SSE2__) && defined(__GNUC__)
+    #include <emmintrin.h>
+#endif
+/** @endcond */
+
+#include "utils/date_overlap.h"
+#include "utils/int_utils.h"
+
+/**
+ * @brief Sums the weighted lengths of the overlaps of intervals with a window, one at a time.
+ *
+ * @param n            Number of intervals.
+ * @param begin        First day of each interval (inclusive).
+ * @param end          Day after the last day of each interval (exclusive).
+ * @param weights      Weight of each interval. Can be `NULL`, for every weight to be `1`.
+ * @param window_first First day of the window (inclusive).
+ * @param window_after Day after the last day of the window (exclusive).
+ *
+ * @return The sum, for every interval, of its number of days inside the window times its weight.
+ */
+uint64_t __date_overlap_weighted_sum_scalar(size_t          n,
+                                            const date_t   *begin,
+                                            const date_t   *end,
+                                            const uint16_t *weights,
+                                            date_t          window_first,
+                                            date_t          window_after) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const date_t   first  = max(begin[i], window_first);
+        const date_t   after  = min(end[i], window_after);
+        const uint64_t length = after > first ? after - first : 0;
+        sum += weights ? length * weights[i] : length;
+    }
+    return sum;
+}
+
+#if defined(__SSE2__) && defined(__GNUC__)
+
+/** @brief Number of intervals in each SSE2 register. */
+#define DATE_OVERLAP_LANES 4
+
+/**
+ * @brief Chooses between the lanes of two registers, as SSE2 has no blend instruction.
+ *
+ * @param mask Lanes with all bits set choose @p a, and lanes with no bits set choose @p b.
+ * @param a    Lanes chosen where @p mask is set.
+ * @param b    Lanes chosen where @p mask isn't set.
+ *
+ * @return The chosen lanes.
+ */
+__m128i __date_overlap_select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+uint64_t date_overlap_weighted_sum(size_t          n,
+                                   const date_t   *begin,
+                                   const date_t   *end,
+                                   const uint16_t *weights,
+                                   date_t          window_first,
+                                   date_t          window_last) {
+
+    /*
+     * SSE2 only has signed 32-bit comparisons. That's fine, as dates are day numbers well below
+     * 2^31 (see date_t).
+     */
+    const __m128i first = _mm_set1_epi32((int32_t) window_first);
+    const __m128i after = _mm_set1_epi32((int32_t) window_last + 1);
+    const __m128i ones  = _mm_set1_epi32(1);
+    const __m128i zeros = _mm_setzero_si128();
+
+    __m128i sums = _mm_setzero_si128(); /* Two 64-bit sums, of even and odd lanes */
+    size_t  i    = 0;
+    for (; i + DATE_OVERLAP_LANES <= n; i += DATE_OVERLAP_LANES) {
+        const __m128i b = _mm_loadu_si128((const __m128i *) (begin + i));
+        const __m128i e = _mm_loadu_si128((const __m128i *) (end + i));
+
+        /* max(b, first) and min(e, after), with masks instead of branches */
+        const __m128i lo     = __date_overlap_select(_mm_cmpgt_epi32(b, first), b, first);
+        const __m128i hi     = __date_overlap_select(_mm_cmpgt_epi32(after, e), e, after);
+        const __m128i length = _mm_and_si128(_mm_sub_epi32(hi, lo), _mm_cmpgt_epi32(hi, lo));
+
+        const __m128i w =
+            weights ? _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (weights + i)), zeros)
+                    : ones;
+
+        /* Lengths times weights may not fit in 32 bits, so products are 64-bit */
+        const __m128i even = _mm_mul_epu32(length, w);
+        const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(length, 32), _mm_srli_epi64(w, 32));
+        sums               = _mm_add_epi64(sums, _mm_add_epi64(even, odd));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, sums);
+    return lanes[0] + lanes[1] + __date_overlap_weighted_sum_scalar(n - i,
+                                                                    begin + i,
+                                                                    end + i,
+                                                                    weights ? weights + i : NULL,
+                                                                    window_first,
+                                                                    window_last + 1);
+}
+
+#else
+
+uint64_t date_overlap_weighted_sum(size_t          n,
+                                   const date_t   *begin,
+                                   const date_t   *end,
+                                   const uint16_t *weights,
+                                   date_t          window_first,
+                                   date_t          window_last) {
+    return __date_overlap_weighted_sum_scalar(n,
+                                              begin,
+                                              end,
+                                              weights,
+                                              window_first,
+                                              window_last + 1);
+}
+
+#endif
@@ -31,30 +31,19 @@
 #include "utils/int_utils.h"
 
 /**
- * @union daytime_union_helper_t
- * @brief Time with `union`, to easily extract fields from a time integer.
+ * @struct daytime_fields_t
+ * @brief  Fields of a time, only used for parsing, printing, getters and setters.
  *
- * @var daytime_union_helper_t::daytime
- *     @brief Compact time format, exposed to the outside of this module.
- * @var daytime_union_helper_t::fields
- *     @brief Individual fields within ::daytime_union_helper_t::daytime.
- * @var daytime_union_helper_t::hours
- *     @brief Hour in @p ::daytime_union_helper_t::daytime. Must be between `0` and
- *            ::DAYTIME_HOURS_MAX.
- * @var daytime_union_helper_t::minutes
- *     @brief Minute in @p ::daytime_union_helper_t::daytime. Must be between `0` and
- *            ::DAYTIME_MINUTES_MAX.
- * @var daytime_union_helper_t::seconds
- *     @brief Second in @p ::daytime_union_helper_t::daytime. Must be between `0` and
- *            ::DAYTIME_SECONDS_MAX.
+ * @var daytime_fields_t::hours
+ *     @brief Hour in the time. Must be between `0` and ::DAYTIME_HOURS_MAX.
+ * @var daytime_fields_t::minutes
+ *     @brief Minute in the time. Must be between `0` and ::DAYTIME_MINUTES_MAX.
+ * @var daytime_fields_t::seconds
+ *     @brief Second in the time. Must be between `0` and ::DAYTIME_SECONDS_MAX.
  */
-typedef union {
-    const daytime_t daytime;
-
-    struct {
-        uint8_t hours, minutes, seconds;
-    } fields;
-} daytime_union_helper_t;
+typedef struct {
+    uint8_t hours, minutes, seconds;
+} daytime_fields_t;
 
 /** @brief The maximum value (inclusive) that hours in a time may take. */
 #define DAYTIME_HOURS_MAX   23
@@ -63,27 +52,44 @@ typedef union {
 /** @brief The maximum value (inclusive) that seconds in a time may take. */
 #define DAYTIME_SECONDS_MAX 59
 
-int daytime_from_values(daytime_t *output, uint8_t hours, uint8_t minutes, uint8_t seconds) {
-    daytime_union_helper_t daytime_union;
+/**
+ * @brief  Converts the fields of a time into a number of seconds (see ::daytime_t).
+ * @param  fields Valid fields of a time.
+ * @return The number of seconds since midnight in @p fields.
+ */
+daytime_t __daytime_from_fields(daytime_fields_t fields) {
+    return (daytime_t) fields.hours * 3600 + (daytime_t) fields.minutes * 60 +
+           (daytime_t) fields.seconds;
+}
 
+/**
+ * @brief  Converts a number of seconds (see ::daytime_t) back into the fields of a time.
+ * @param  time Time to be converted.
+ * @return The fields of @p time.
+ */
+daytime_fields_t __daytime_to_fields(daytime_t time) {
+    const daytime_fields_t fields = {.hours   = time / 3600,
+                                     .minutes = time % 3600 / 60,
+                                     .seconds = time % 60};
+    return fields;
+}
+
+int daytime_from_values(daytime_t *output, uint8_t hours, uint8_t minutes, uint8_t seconds) {
     if (hours > DAYTIME_HOURS_MAX || minutes > DAYTIME_MINUTES_MAX ||
         seconds > DAYTIME_SECONDS_MAX) {
         return 1;
     }
 
-    daytime_union.fields.hours   = hours;
-    daytime_union.fields.minutes = minutes;
-    daytime_union.fields.seconds = seconds;
-
-    *output = daytime_union.daytime;
+    const daytime_fields_t fields = {.hours = hours, .minutes = minutes, .seconds = seconds};
+    *output                       = __daytime_from_fields(fields);
     return 0;
 }
 
 /**
  * @brief Auxiliary method for ::daytime_from_string. Parses any of the integers in a time.
  *
- * @param daytime_data A pointer to a ::daytime_union_helper_t, whose fields are filled in as the
- *                     time is parsed.
+ * @param daytime_data A pointer to a ::daytime_fields_t, whose fields are filled in as the time
+ *                     is parsed.
  * @param token        Number between colons to be parsed.
  * @param ntoken       Tokens already parsed (number of the current token, `0`-indexed).
  *
@@ -91,12 +97,10 @@ int daytime_from_values(daytime_t *output, uint8_t hours, uint8_t minutes, uint8
  * @retval 1 Integer parsing failure.
  */
 int __daytime_from_string_parse_field(void *daytime_data, char *token, size_t ntoken) {
-    daytime_union_helper_t *const daytime = daytime_data;
+    daytime_fields_t *const daytime = daytime_data;
 
     const uint64_t maxs[3]    = {DAYTIME_HOURS_MAX, DAYTIME_MINUTES_MAX, DAYTIME_SECONDS_MAX};
-    uint8_t       *outputs[3] = {&daytime->fields.hours,
-                                 &daytime->fields.minutes,
-                                 &daytime->fields.seconds};
+    uint8_t       *outputs[3] = {&daytime->hours, &daytime->minutes, &daytime->seconds};
 
     const size_t token_length = strlen(token);
     if (token_length != 2)
@@ -139,19 +143,47 @@ void __attribute__((destructor)) __daytime_grammar_free(void) {
     fixed_n_delimiter_parser_grammar_free(__daytime_grammar);
 }
 
+int daytime_from_fixed_width(daytime_t *output, const char input[8]) {
+    /* Gather the digits of "HH:MM:SS" into "HHMMSS00" */
+    const uint64_t chars  = int_utils_load_chars(input);
+    const uint64_t digits = (chars & 0xFFFF) | ((chars >> 8) & 0xFFFF0000) |
+                            ((chars >> 16) & 0xFFFF00000000) | 0x3030000000000000;
+
+    uint8_t   pairs[4];
+    const int invalid = int_utils_parse_digit_pairs(pairs, digits);
+
+    /* Bitwise instead of logical operators, to avoid branching */
+    const int valid = !invalid & ((chars >> 16 & 0xFF) == ':') & ((chars >> 40 & 0xFF) == ':') &
+                      (pairs[0] <= DAYTIME_HOURS_MAX) & (pairs[1] <= DAYTIME_MINUTES_MAX) &
+                      (pairs[2] <= DAYTIME_SECONDS_MAX);
+    if (!valid)
+        return 1;
+
+    const daytime_fields_t fields = {.hours = pairs[0], .minutes = pairs[1], .seconds = pairs[2]};
+    *output                       = __daytime_from_fields(fields);
+    return 0;
+}
+
 int daytime_from_string(daytime_t *output, char *input) {
-    daytime_union_helper_t tmp_daytime;
-    const int              retval =
+    /* Only fall back to the grammar for malformed times, to get the same error codes */
+    if (strnlen(input, 9) == 8 && !daytime_from_fixed_width(output, input))
+        return 0;
+
+    daytime_fields_t tmp_daytime;
+    const int        retval =
         fixed_n_delimiter_parser_parse_string(input, __daytime_grammar, &tmp_daytime);
     if (retval) {
         return retval;
     } else {
-        *output = tmp_daytime.daytime;
+        *output = __daytime_from_fields(tmp_daytime);
         return 0;
     }
 }
 
 int daytime_from_string_const(daytime_t *output, const char *input) {
+    if (strnlen(input, 9) == 8 && !daytime_from_fixed_width(output, input))
+        return 0;
+
     char *const buffer = strdup(input);
     if (!buffer)
         return 1;
@@ -163,41 +195,30 @@ int daytime_from_string_const(daytime_t *output, const char *input) {
 }
 
 void daytime_sprintf(char *output, daytime_t daytime) {
-    const daytime_union_helper_t daytime_union = {.daytime = daytime};
-
-    sprintf(output,
-            "%02d:%02d:%02d",
-            daytime_union.fields.hours,
-            daytime_union.fields.minutes,
-            daytime_union.fields.seconds);
+    const daytime_fields_t fields = __daytime_to_fields(daytime);
+    int_utils_write_fixed(output, fields.hours, 2);
+    output[2] = ':';
+    int_utils_write_fixed(output + 3, fields.minutes, 2);
+    output[5] = ':';
+    int_utils_write_fixed(output + 6, fields.seconds, 2);
+    output[8] = '\0';
 }
 
 int32_t daytime_diff(daytime_t a, daytime_t b) {
-    const daytime_union_helper_t a_union = {.daytime = a};
-    const daytime_union_helper_t b_union = {.daytime = b};
-
-    const uint32_t a_seconds = (uint32_t) a_union.fields.hours * 3600 +
-                               (uint32_t) a_union.fields.minutes * 60 +
-                               (uint32_t) a_union.fields.seconds;
-    const uint32_t b_seconds = (uint32_t) b_union.fields.hours * 3600 +
-                               (uint32_t) b_union.fields.minutes * 60 +
-                               (uint32_t) b_union.fields.seconds;
-
-    return a_seconds - b_seconds;
+    return (int32_t) a - (int32_t) b;
 }
 
 /**
  * @brief Helper macro for defining getters.
- * @param property Property to get in ::daytime_union_helper_t::fields.
+ * @param property Property to get in ::daytime_fields_t.
  */
 #define DAYTIME_GETTER_FUNCTION_BODY(property)                                                     \
-    const daytime_union_helper_t daytime_union = {.daytime = time};                                \
-    return daytime_union.fields.property;
+    return __daytime_to_fields(time).property;
 
 /**
  * @brief Helper macro for defining setters.
- * @param property    Property to set in ::daytime_union_helper_t::fields. Name must match the name
- *                    of the argument in the setter method.
+ * @param property    Property to set in ::daytime_fields_t. Name must match the name of the
+ *                    argument in the setter method.
  * @param upper_bound Maximum value (inclusive) that @p property can take.
  */
 #define DAYTIME_SETTER_FUNCTION_BODY(property, upper_bound)                                        \
@@ -205,9 +226,9 @@ int32_t daytime_diff(daytime_t a, daytime_t b) {
         return 1;                                                                                  \
     }                                                                                              \
                                                                                                    \
-    daytime_union_helper_t daytime_union = {.daytime = *time};                                     \
-    daytime_union.fields.property        = property;                                               \
-    *time                                = daytime_union.daytime;                                  \
+    daytime_fields_t fields = __daytime_to_fields(*time);                                          \
+    fields.property         = property;                                                            \
+    *time                   = __daytime_from_fields(fields);                                       \
     return 0;
 
 uint8_t daytime_get_hours(daytime_t time) {
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  epoch.c
+ * @brief Implementation of methods in include/utils/epoch.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref epoch_examples).
+ */
+
+#include <glib.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "utils/epoch.h"
+
+/** @brief Time (in nanoseconds) ::epoch_synchronize sleeps for, between checks of a reader. */
+#define EPOCH_SYNCHRONIZE_SLEEP 100000
+
+/**
+ * @struct epoch_domain
+ * @brief  A set of readers and writers of some shared data.
+ *
+ * @var epoch_domain::epoch
+ *     @brief   Global epoch, incremented by every ::epoch_synchronize.
+ *     @details Only compared for equality, so it may wrap around.
+ * @var epoch_domain::lock
+ *     @brief Lock that protects ::epoch_domain::participants, and serializes writers.
+ * @var epoch_domain::participants
+ *     @brief All registered ::epoch_participant_t.
+ */
+struct epoch_domain {
+    gint            epoch;
+    pthread_mutex_t lock;
+    GPtrArray      *participants;
+};
+
+/**
+ * @struct epoch_participant
+ * @brief  A thread that reads shared data.
+ *
+ * @var epoch_participant::domain
+ *     @brief Domain this participant is registered in.
+ * @var epoch_participant::epoch
+ *     @brief Value of ::epoch_domain::epoch when the participant's current section started.
+ * @var epoch_participant::active
+ *     @brief Whether the participant is inside a section.
+ */
+struct epoch_participant {
+    epoch_domain_t *domain;
+    gint            epoch, active;
+};
+
+epoch_domain_t *epoch_domain_create(void) {
+    epoch_domain_t *const domain = malloc(sizeof(epoch_domain_t));
+    if (!domain)
+        return NULL;
+
+    if (pthread_mutex_init(&domain->lock, NULL)) {
+        free(domain);
+        return NULL;
+    }
+
+    domain->epoch        = 0;
+    domain->participants = g_ptr_array_new_with_free_func(free);
+    return domain;
+}
+
+epoch_participant_t *epoch_domain_register(epoch_domain_t *domain) {
+    epoch_participant_t *const participant = malloc(sizeof(epoch_participant_t));
+    if (!participant)
+        return NULL;
+
+    participant->domain = domain;
+    participant->epoch  = 0;
+    participant->active = 0;
+
+    pthread_mutex_lock(&domain->lock);
+    g_ptr_array_add(domain->participants, participant);
+    pthread_mutex_unlock(&domain->lock);
+    return participant;
+}
+
+void epoch_enter(epoch_participant_t *participant) {
+    /*
+     * Atomic operations on gint are full barriers. Setting the epoch before the active flag means
+     * a writer never sees this participant as active with the epoch of a previous section, and
+     * shared data is only read after both stores are visible to writers.
+     */
+    g_atomic_int_set(&participant->epoch, g_atomic_int_get(&participant->domain->epoch));
+    g_atomic_int_set(&participant->active, 1);
+}
+
+void epoch_exit(epoch_participant_t *participant) {
+    g_atomic_int_set(&participant->active, 0);
+}
+
+void epoch_synchronize(epoch_domain_t *domain) {
+    pthread_mutex_lock(&domain->lock);
+
+    /* Readers that enter a section after this only see data published before the call */
+    const gint epoch = (gint) ((guint) g_atomic_int_get(&domain->epoch) + 1);
+    g_atomic_int_set(&domain->epoch, epoch);
+
+    for (size_t i = 0; i < domain->participants->len; ++i) {
+        const epoch_participant_t *const participant =
+            g_ptr_array_index(domain->participants, i);
+
+        /* Wait for a quiescent point: leaving the section, or starting a new one */
+        while (g_atomic_int_get(&participant->active) &&
+               g_atomic_int_get(&participant->epoch) != epoch) {
+            const struct timespec duration = {.tv_sec = 0, .tv_nsec = EPOCH_SYNCHRONIZE_SLEEP};
+            nanosleep(&duration, NULL);
+        }
+    }
+
+    pthread_mutex_unlock(&domain->lock);
+}
+
+void epoch_domain_free(epoch_domain_t *domain) {
+    g_ptr_array_unref(domain->participants);
+    pthread_mutex_destroy(&domain->lock);
+    free(domain);
+}
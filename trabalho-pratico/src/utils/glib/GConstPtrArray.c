@@ -20,6 +20,7 @@
  */
 
 #include "utils/glib/GConstPtrArray.h"
+#include "utils/parallel_sort.h"
 
 GConstPtrArray *g_const_ptr_array_new(void) {
     return (GConstPtrArray *) g_ptr_array_new();
@@ -38,7 +39,15 @@ guint g_const_ptr_array_get_length(const GConstPtrArray *array) {
 }
 
 void g_const_ptr_array_sort(GConstPtrArray *array, GConstCompareFunc compare_func) {
-    g_ptr_array_sort((GPtrArray *) array, (GCompareFunc) compare_func);
+    GPtrArray *const ptr_array = (GPtrArray *) array;
+
+    /* Stable, like g_ptr_array_sort, which is what's done in a single thread on failure */
+    if (parallel_sort(ptr_array->pdata,
+                      ptr_array->len,
+                      sizeof(gpointer),
+                      (parallel_sort_compare_t) compare_func,
+                      1))
+        g_ptr_array_sort(ptr_array, (GCompareFunc) compare_func);
 }
 
 void g_const_ptr_array_unref(GConstPtrArray *array) {
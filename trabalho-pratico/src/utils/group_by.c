@@ -0,0 +1,449 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  group_by.c
+ * @brief Implementation of methods in include/utils/group_by.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref group_by_examples).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/bucket_builder.h"
+#include "utils/group_by.h"
+#include "utils/id_hash_table.h"
+#include "utils/int_utils.h"
+#include "utils/t_digest.h"
+
+/**
+ * @struct group_by_group_t
+ * @brief  Aggregated data of a single group in a ::group_by_t.
+ *
+ * @var group_by_group_t::sum
+ *     @brief Sum of all values in the group.
+ * @var group_by_group_t::sum_of_squares
+ *     @brief Sum of the squares of all values in the group.
+ * @var group_by_group_t::count
+ *     @brief Number of values in the group.
+ * @var group_by_group_t::values
+ *     @brief   Values in the group.
+ *     @details Only used for aggregations created with ::GROUP_BY_AGGREGATE_VALUES. Points into
+ *              ::group_by::values_buffer after ::group_by_merge_all.
+ * @var group_by_group_t::values_capacity
+ *     @brief Number of values that fit in ::group_by_group_t::values.
+ * @var group_by_group_t::digest
+ *     @brief   Summary of the values in the group.
+ *     @details Only used for aggregations created with ::GROUP_BY_AGGREGATE_DIGEST.
+ * @var group_by_group_t::key
+ *     @brief Key of the group, or its ordinal in ::group_by::key_dictionary.
+ */
+typedef struct {
+    int64_t     sum;
+    double      sum_of_squares;
+    uint64_t    count;
+    int64_t    *values;
+    size_t      values_capacity;
+    t_digest_t *digest;
+    uint32_t    key;
+} group_by_group_t;
+
+/**
+ * @struct group_by
+ * @brief  Aggregation of integer values grouped by integer keys.
+ *
+ * @var group_by::aggregate
+ *     @brief What is kept for each group.
+ * @var group_by::dense_keys
+ *     @brief Upper bound of keys, or `0` for keys in a hash table.
+ * @var group_by::dense_ordinals
+ *     @brief   Ordinal (plus one) of the group of each key, or `0` for keys without a group.
+ *     @details Only used when ::group_by::dense_keys isn't `0`.
+ * @var group_by::hash_ordinals
+ *     @brief   ::id_hash_table_t that associates keys with the ordinal (plus one) of their group.
+ *     @details Only used when ::group_by::dense_keys is `0`.
+ * @var group_by::groups
+ *     @brief Aggregated data of every group, by ordinal.
+ * @var group_by::length
+ *     @brief Number of groups in ::group_by::groups.
+ * @var group_by::capacity
+ *     @brief Number of groups that fit in ::group_by::groups.
+ * @var group_by::last_ordinal
+ *     @brief Ordinal of the last group values were added to, or `SIZE_MAX` if there's none.
+ * @var group_by::values_buffer
+ *     @brief   Values of all groups, one group after the other, built by ::group_by_merge_all.
+ *     @details `NULL` when every group's values are a separate allocation.
+ * @var group_by::key_dictionary
+ *     @brief   Keys of groups, indexed by the key ordinals in ::group_by_group_t::key.
+ *     @details `NULL` for aggregations not created by ::group_by_create_with_keys.
+ */
+struct group_by {
+    group_by_aggregate_t aggregate;
+    size_t               dense_keys;
+    uint32_t            *dense_ordinals;
+    id_hash_table_t     *hash_ordinals;
+
+    group_by_group_t *groups;
+    size_t            length, capacity;
+    size_t            last_ordinal;
+    int64_t          *values_buffer;
+    uint32_t         *key_dictionary;
+};
+
+/** @brief Initial number of groups (or values in a group) allocated when the first one is added. */
+#define GROUP_BY_INITIAL_CAPACITY 16
+
+group_by_t *group_by_create(group_by_aggregate_t aggregate, size_t dense_keys) {
+    group_by_t *const group = malloc(sizeof(group_by_t));
+    if (!group)
+        return NULL;
+
+    group->aggregate      = aggregate;
+    group->dense_keys     = dense_keys;
+    group->dense_ordinals = NULL;
+    group->hash_ordinals  = NULL;
+
+    if (dense_keys) {
+        group->dense_ordinals = calloc(dense_keys, sizeof(uint32_t));
+        if (!group->dense_ordinals) {
+            free(group);
+            return NULL;
+        }
+    } else {
+        group->hash_ordinals = id_hash_table_create(0);
+        if (!group->hash_ordinals) {
+            free(group);
+            return NULL;
+        }
+    }
+
+    group->groups         = NULL;
+    group->length         = 0;
+    group->capacity       = 0;
+    group->last_ordinal   = SIZE_MAX;
+    group->values_buffer  = NULL;
+    group->key_dictionary = NULL;
+    return group;
+}
+
+group_by_t *
+    group_by_create_with_keys(group_by_aggregate_t aggregate, size_t nkeys, const uint32_t *keys) {
+
+    group_by_t *const group = group_by_create(aggregate, nkeys ? nkeys : 1);
+    if (!group)
+        return NULL;
+
+    group->key_dictionary = malloc((nkeys ? nkeys : 1) * sizeof(uint32_t));
+    if (!group->key_dictionary) {
+        group_by_free(group);
+        return NULL;
+    }
+
+    memcpy(group->key_dictionary, keys, nkeys * sizeof(uint32_t));
+    return group;
+}
+
+/**
+ * @brief Creates a new empty group, without associating it with its key.
+ *
+ * @param group Aggregation to add the new group to.
+ * @param key   Key of the new group.
+ *
+ * @return The ordinal of the new group, or `SIZE_MAX` on allocation failure.
+ */
+size_t __group_by_create_group(group_by_t *group, uint32_t key) {
+    if (group->length == group->capacity) {
+        const size_t new_capacity =
+            group->capacity ? group->capacity * 2 : GROUP_BY_INITIAL_CAPACITY;
+        group_by_group_t *const new_groups =
+            realloc(group->groups, new_capacity * sizeof(group_by_group_t));
+        if (!new_groups)
+            return SIZE_MAX;
+
+        group->groups   = new_groups;
+        group->capacity = new_capacity;
+    }
+
+    t_digest_t *digest = NULL;
+    if (group->aggregate == GROUP_BY_AGGREGATE_DIGEST) {
+        digest = t_digest_create();
+        if (!digest)
+            return SIZE_MAX;
+    }
+
+    group->groups[group->length] = (group_by_group_t) {.sum             = 0,
+                                                       .sum_of_squares  = 0,
+                                                       .count           = 0,
+                                                       .values          = NULL,
+                                                       .values_capacity = 0,
+                                                       .digest          = digest,
+                                                       .key             = key};
+    return group->length++;
+}
+
+/**
+ * @brief Gets the ordinal of the group of a key, creating the group if needed.
+ *
+ * @param group Aggregation to get the group from.
+ * @param key   Key of the group.
+ *
+ * @return The ordinal of the group of @p key, or `SIZE_MAX` on allocation failure.
+ */
+size_t __group_by_get_ordinal(group_by_t *group, uint32_t key) {
+    if (group->last_ordinal != SIZE_MAX && group->groups[group->last_ordinal].key == key)
+        return group->last_ordinal;
+
+    size_t ordinal;
+    if (group->dense_keys) {
+        ordinal = group->dense_ordinals[key];
+        if (ordinal) {
+            ordinal--;
+        } else {
+            ordinal = __group_by_create_group(group, key);
+            if (ordinal == SIZE_MAX)
+                return SIZE_MAX;
+            group->dense_ordinals[key] = ordinal + 1;
+        }
+    } else {
+        ordinal = (size_t) (uintptr_t) id_hash_table_lookup(group->hash_ordinals, key);
+        if (ordinal) {
+            ordinal--;
+        } else {
+            ordinal = __group_by_create_group(group, key);
+            if (ordinal == SIZE_MAX)
+                return SIZE_MAX;
+
+            if (id_hash_table_insert(group->hash_ordinals,
+                                     key,
+                                     (void *) (uintptr_t) (ordinal + 1)) == 1) {
+                t_digest_free(group->groups[ordinal].digest);
+                group->length--;
+                return SIZE_MAX;
+            }
+        }
+    }
+
+    group->last_ordinal = ordinal;
+    return ordinal;
+}
+
+/**
+ * @brief Appends values to a group in an aggregation created with ::GROUP_BY_AGGREGATE_VALUES.
+ *
+ * @param group_data Group to add @p values to.
+ * @param values     Values to be added.
+ * @param n          Number of values in @p values.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p group_data is left unchanged).
+ */
+int __group_by_append_values(group_by_group_t *group_data, const int64_t *values, size_t n) {
+    const size_t needed = group_data->count + n;
+    if (needed > group_data->values_capacity) {
+        size_t new_capacity =
+            group_data->values_capacity ? group_data->values_capacity : GROUP_BY_INITIAL_CAPACITY;
+        while (new_capacity < needed)
+            new_capacity *= 2;
+
+        int64_t *const new_values = realloc(group_data->values, new_capacity * sizeof(int64_t));
+        if (!new_values)
+            return 1;
+
+        group_data->values          = new_values;
+        group_data->values_capacity = new_capacity;
+    }
+
+    memcpy(group_data->values + group_data->count, values, n * sizeof(int64_t));
+    return 0;
+}
+
+int group_by_add(group_by_t *group, uint32_t key, int64_t value) {
+    const size_t ordinal = __group_by_get_ordinal(group, key);
+    if (ordinal == SIZE_MAX)
+        return 1;
+
+    group_by_group_t *const group_data = &group->groups[ordinal];
+    if (group->aggregate == GROUP_BY_AGGREGATE_VALUES &&
+        __group_by_append_values(group_data, &value, 1))
+        return 1;
+    if (group->aggregate == GROUP_BY_AGGREGATE_DIGEST &&
+        t_digest_add(group_data->digest, (double) value))
+        return 1;
+
+    group_data->sum += value;
+    group_data->sum_of_squares += (double) value * value;
+    group_data->count++;
+    return 0;
+}
+
+int group_by_merge(group_by_t *group, const group_by_t *partial) {
+    for (size_t i = 0; i < partial->length; ++i) {
+        const group_by_group_t *const partial_data = &partial->groups[i];
+
+        const size_t ordinal = __group_by_get_ordinal(group, partial_data->key);
+        if (ordinal == SIZE_MAX)
+            return 1;
+
+        group_by_group_t *const group_data = &group->groups[ordinal];
+        if (group->aggregate == GROUP_BY_AGGREGATE_VALUES &&
+            __group_by_append_values(group_data, partial_data->values, partial_data->count))
+            return 1;
+        if (group->aggregate == GROUP_BY_AGGREGATE_DIGEST &&
+            t_digest_merge(group_data->digest, partial_data->digest))
+            return 1;
+
+        group_data->sum += partial_data->sum;
+        group_data->sum_of_squares += partial_data->sum_of_squares;
+        group_data->count += partial_data->count;
+    }
+    return 0;
+}
+
+int group_by_merge_all(group_by_t *group, group_by_t *const *partials, size_t n) {
+    if (group->aggregate != GROUP_BY_AGGREGATE_VALUES) {
+        for (size_t i = 0; i < n; ++i)
+            if (group_by_merge(group, partials[i]))
+                return 1;
+
+        group_by_freeze(group);
+        return 0;
+    }
+
+    /* Create all groups first, so that the number of buckets is known */
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < partials[i]->length; ++j)
+            if (__group_by_get_ordinal(group, partials[i]->groups[j].key) == SIZE_MAX)
+                return 1;
+
+    bucket_builder_t *const builder = bucket_builder_create(group->length, sizeof(int64_t));
+    if (!builder)
+        return 1;
+
+    for (size_t o = 0; o < group->length; ++o)
+        bucket_builder_count(builder, o, group->groups[o].count);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < partials[i]->length; ++j)
+            bucket_builder_count(builder,
+                                 __group_by_get_ordinal(group, partials[i]->groups[j].key),
+                                 partials[i]->groups[j].count);
+
+    if (bucket_builder_allocate(builder)) {
+        bucket_builder_free(builder);
+        return 1;
+    }
+
+    /* Values already in group come first, like with group_by_merge */
+    for (size_t o = 0; o < group->length; ++o) {
+        group_by_group_t *const group_data = &group->groups[o];
+        if (group_data->count)
+            memcpy(bucket_builder_place(builder, o, group_data->count),
+                   group_data->values,
+                   group_data->count * sizeof(int64_t));
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < partials[i]->length; ++j) {
+            const group_by_group_t *const partial_data = &partials[i]->groups[j];
+
+            const size_t            ordinal    = __group_by_get_ordinal(group, partial_data->key);
+            group_by_group_t *const group_data = &group->groups[ordinal];
+
+            if (partial_data->count)
+                memcpy(bucket_builder_place(builder, ordinal, partial_data->count),
+                       partial_data->values,
+                       partial_data->count * sizeof(int64_t));
+
+            group_data->sum += partial_data->sum;
+            group_data->sum_of_squares += partial_data->sum_of_squares;
+            group_data->count += partial_data->count;
+        }
+    }
+
+    for (size_t o = 0; o < group->length; ++o) {
+        group_by_group_t *const group_data = &group->groups[o];
+        size_t                  count;
+
+        free(group_data->values);
+        group_data->values          = bucket_builder_get_bucket(builder, o, &count);
+        group_data->values_capacity = count;
+    }
+    group->values_buffer = bucket_builder_steal_items(builder);
+    bucket_builder_free(builder);
+
+    group_by_freeze(group);
+    return 0;
+}
+
+void group_by_freeze(group_by_t *group) {
+    free(group->dense_ordinals);
+    if (group->hash_ordinals)
+        id_hash_table_free(group->hash_ordinals);
+
+    group->dense_ordinals = NULL;
+    group->hash_ordinals  = NULL;
+}
+
+size_t group_by_get_length(const group_by_t *group) {
+    return group->length;
+}
+
+uint32_t group_by_get_key(const group_by_t *group, size_t ordinal) {
+    const uint32_t key = group->groups[ordinal].key;
+    return group->key_dictionary ? group->key_dictionary[key] : key;
+}
+
+uint64_t group_by_get_count(const group_by_t *group, size_t ordinal) {
+    return group->groups[ordinal].count;
+}
+
+int64_t group_by_get_sum(const group_by_t *group, size_t ordinal) {
+    return group->groups[ordinal].sum;
+}
+
+double group_by_get_sum_of_squares(const group_by_t *group, size_t ordinal) {
+    return group->groups[ordinal].sum_of_squares;
+}
+
+double group_by_get_average(const group_by_t *group, size_t ordinal) {
+    const group_by_group_t *const group_data = &group->groups[ordinal];
+    return (double) group_data->sum / group_data->count;
+}
+
+double group_by_calculate_median(group_by_t *group, size_t ordinal, double *error) {
+    group_by_group_t *const group_data = &group->groups[ordinal];
+    if (group->aggregate == GROUP_BY_AGGREGATE_DIGEST)
+        return t_digest_quantile(group_data->digest, 0.5, error);
+
+    if (error)
+        *error = 0;
+    return int_utils_median_int64(group_data->values, group_data->count);
+}
+
+void group_by_free(group_by_t *group) {
+    group_by_freeze(group);
+    for (size_t i = 0; i < group->length; ++i) {
+        if (!group->values_buffer)
+            free(group->groups[i].values);
+        t_digest_free(group->groups[i].digest);
+    }
+    free(group->values_buffer);
+    free(group->key_dictionary);
+    free(group->groups);
+    free(group);
+}
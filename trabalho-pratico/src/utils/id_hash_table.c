@@ -0,0 +1,315 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  id_hash_table.c
+ * @brief Implementation of methods in include/utils/id_hash_table.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref id_hash_table_examples).
+ */
+
+#include <stdlib.h>
+
+#include "utils/id_hash_table.h"
+#include "utils/prefetch.h"
+
+/**
+ * @struct id_hash_table_entry_t
+ * @brief  An entry (bucket) in an ::id_hash_table_t.
+ *
+ * @var id_hash_table_entry_t::value
+ *     @brief Value associated with ::id_hash_table_entry_t::key.
+ * @var id_hash_table_entry_t::key
+ *     @brief Key of this entry.
+ * @var id_hash_table_entry_t::hash
+ *     @brief Cached hash of ::id_hash_table_entry_t::key. `0` for empty entries.
+ */
+typedef struct {
+    void    *value;
+    uint32_t key;
+    uint32_t hash;
+} id_hash_table_entry_t;
+
+/**
+ * @struct id_hash_table
+ * @brief  A hash table whose keys are integer identifiers.
+ *
+ * @var id_hash_table::entries
+ *     @brief Array of ::id_hash_table::capacity entries, some of which are empty.
+ * @var id_hash_table::capacity
+ *     @brief Number of elements in ::id_hash_table::entries. Always a power of two.
+ * @var id_hash_table::length
+ *     @brief Number of non-empty elements in ::id_hash_table::entries.
+ */
+struct id_hash_table {
+    id_hash_table_entry_t *entries;
+    size_t                 capacity, length;
+};
+
+/** @brief Minimum number of entries in a ::id_hash_table_t. */
+#define ID_HASH_TABLE_MIN_CAPACITY 16
+
+/**
+ * @brief Maximum number of entries in a ::id_hash_table_t with a given capacity (maximum load
+ *        factor of `7 / 8`).
+ */
+#define ID_HASH_TABLE_MAX_LENGTH(capacity) ((capacity) - (capacity) / 8)
+
+/**
+ * @brief   Hashes a key.
+ * @details Uses the finalizer of MurmurHash3, so that sequential identifiers are spread through the
+ *          table. `0` is reserved for empty entries.
+ *
+ * @param key Key to be hashed.
+ *
+ * @return The hash of @p key.
+ */
+uint32_t __id_hash_table_hash(uint32_t key) {
+    key ^= key >> 16;
+    key *= 0x85ebca6b;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35;
+    key ^= key >> 16;
+    return key ? key : 1;
+}
+
+/**
+ * @brief  Calculates how far an entry is from the position its hash maps to.
+ *
+ * @param table    Hash table @p entry belongs to.
+ * @param hash     Hash in the entry.
+ * @param position Index of the entry in ::id_hash_table::entries.
+ *
+ * @return The probe sequence length of the entry.
+ */
+size_t __id_hash_table_distance(const id_hash_table_t *table, uint32_t hash, size_t position) {
+    return (position - (hash & (table->capacity - 1))) & (table->capacity - 1);
+}
+
+/**
+ * @brief   Places an entry whose key isn't in a table, without checking its load factor.
+ * @details Richer entries (closer to their home position) are displaced by poorer ones (Robin
+ *          Hood hashing).
+ *
+ * @param table Hash table to be modified.
+ * @param entry Entry to be placed.
+ */
+void __id_hash_table_place(id_hash_table_t *table, id_hash_table_entry_t entry) {
+    size_t position = entry.hash & (table->capacity - 1), distance = 0;
+    while (table->entries[position].hash) {
+        const size_t existing_distance =
+            __id_hash_table_distance(table, table->entries[position].hash, position);
+
+        if (existing_distance < distance) {
+            const id_hash_table_entry_t tmp = table->entries[position];
+            table->entries[position]        = entry;
+            entry                           = tmp;
+            distance                        = existing_distance;
+        }
+
+        position = (position + 1) & (table->capacity - 1);
+        distance++;
+    }
+
+    table->entries[position] = entry;
+    table->length++;
+}
+
+/**
+ * @brief  Calculates the capacity needed for a number of entries.
+ * @param  n Number of entries.
+ * @return The minimum power of two that's a valid capacity for @p n entries.
+ */
+size_t __id_hash_table_capacity_for(size_t n) {
+    size_t capacity = ID_HASH_TABLE_MIN_CAPACITY;
+    while (ID_HASH_TABLE_MAX_LENGTH(capacity) < n)
+        capacity *= 2;
+    return capacity;
+}
+
+/**
+ * @brief Changes the number of entries in a hash table, rehashing all of its entries.
+ *
+ * @param table    Hash table to be modified.
+ * @param capacity New capacity of @p table. Must be a power of two that can hold all of its
+ *                 entries.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ */
+int __id_hash_table_resize(id_hash_table_t *table, size_t capacity) {
+    id_hash_table_entry_t *const new_entries = calloc(capacity, sizeof(id_hash_table_entry_t));
+    if (!new_entries)
+        return 1;
+
+    id_hash_table_entry_t *const old_entries  = table->entries;
+    const size_t                 old_capacity = table->capacity;
+
+    table->entries  = new_entries;
+    table->capacity = capacity;
+    table->length   = 0;
+    for (size_t i = 0; i < old_capacity; ++i)
+        if (old_entries[i].hash)
+            __id_hash_table_place(table, old_entries[i]);
+
+    free(old_entries);
+    return 0;
+}
+
+id_hash_table_t *id_hash_table_create(size_t capacity) {
+    id_hash_table_t *const table = malloc(sizeof(id_hash_table_t));
+    if (!table)
+        return NULL;
+
+    table->capacity = __id_hash_table_capacity_for(capacity);
+    table->length   = 0;
+    table->entries  = calloc(table->capacity, sizeof(id_hash_table_entry_t));
+    if (!table->entries) {
+        free(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+int id_hash_table_reserve(id_hash_table_t *table, size_t n) {
+    const size_t capacity = __id_hash_table_capacity_for(n);
+    if (capacity <= table->capacity)
+        return 0;
+    return __id_hash_table_resize(table, capacity);
+}
+
+int id_hash_table_shrink_to_fit(id_hash_table_t *table) {
+    const size_t capacity = __id_hash_table_capacity_for(table->length);
+    if (capacity >= table->capacity)
+        return 0;
+    return __id_hash_table_resize(table, capacity);
+}
+
+/**
+ * @brief Finds the position of a key in a hash table.
+ *
+ * @param table    Hash table where to perform the lookup.
+ * @param key      Key to look for.
+ * @param hash     Hash of @p key (see ::__id_hash_table_hash).
+ * @param position Where to output the index of the entry with @p key to.
+ *
+ * @retval 0 @p key found.
+ * @retval 1 @p key not in @p table.
+ */
+int __id_hash_table_find(const id_hash_table_t *table,
+                         uint32_t               key,
+                         uint32_t               hash,
+                         size_t                *position) {
+    size_t i = hash & (table->capacity - 1);
+
+    for (size_t distance = 0;; ++distance) {
+        const id_hash_table_entry_t *const entry = &table->entries[i];
+
+        /* Robin Hood invariant: the key would have displaced any richer entry */
+        if (!entry->hash || __id_hash_table_distance(table, entry->hash, i) < distance)
+            return 1;
+
+        if (entry->hash == hash && entry->key == key) {
+            *position = i;
+            return 0;
+        }
+
+        i = (i + 1) & (table->capacity - 1);
+    }
+}
+
+int id_hash_table_insert(id_hash_table_t *table, uint32_t key, void *value) {
+    size_t position;
+    if (!__id_hash_table_find(table, key, __id_hash_table_hash(key), &position)) {
+        table->entries[position].value = value;
+        return 2;
+    }
+
+    if (table->length + 1 > ID_HASH_TABLE_MAX_LENGTH(table->capacity) &&
+        __id_hash_table_resize(table, table->capacity * 2))
+        return 1;
+
+    const id_hash_table_entry_t entry = {.value = value,
+                                         .key   = key,
+                                         .hash  = __id_hash_table_hash(key)};
+    __id_hash_table_place(table, entry);
+    return 0;
+}
+
+void *id_hash_table_lookup(const id_hash_table_t *table, uint32_t key) {
+    size_t position;
+    if (__id_hash_table_find(table, key, __id_hash_table_hash(key), &position))
+        return NULL;
+    return table->entries[position].value;
+}
+
+void id_hash_table_lookup_batch(const id_hash_table_t *table,
+                                size_t                 n,
+                                const uint32_t         keys[n],
+                                void                  *values[n]) {
+    for (size_t begin = 0; begin < n; begin += PREFETCH_BATCH_SIZE) {
+        const size_t batch = n - begin < PREFETCH_BATCH_SIZE ? n - begin : PREFETCH_BATCH_SIZE;
+
+        uint32_t hashes[PREFETCH_BATCH_SIZE];
+        for (size_t i = 0; i < batch; ++i) {
+            hashes[i] = __id_hash_table_hash(keys[begin + i]);
+            prefetch_read(&table->entries[hashes[i] & (table->capacity - 1)]);
+        }
+
+        for (size_t i = 0; i < batch; ++i) {
+            size_t position;
+            values[begin + i] =
+                __id_hash_table_find(table, keys[begin + i], hashes[i], &position)
+                    ? NULL
+                    : table->entries[position].value;
+        }
+    }
+}
+
+int id_hash_table_remove(id_hash_table_t *table, uint32_t key) {
+    size_t position;
+    if (__id_hash_table_find(table, key, __id_hash_table_hash(key), &position))
+        return 1;
+
+    /* Backward shift deletion: move following displaced entries one position back */
+    size_t next = (position + 1) & (table->capacity - 1);
+    while (table->entries[next].hash &&
+           __id_hash_table_distance(table, table->entries[next].hash, next) > 0) {
+
+        table->entries[position] = table->entries[next];
+        position                 = next;
+        next                     = (next + 1) & (table->capacity - 1);
+    }
+
+    table->entries[position].hash = 0;
+    table->length--;
+    return 0;
+}
+
+size_t id_hash_table_get_length(const id_hash_table_t *table) {
+    return table->length;
+}
+
+size_t id_hash_table_get_memory_usage(const id_hash_table_t *table) {
+    return sizeof(id_hash_table_t) + table->capacity * sizeof(id_hash_table_entry_t);
+}
+
+void id_hash_table_free(id_hash_table_t *table) {
+    free(table->entries);
+    free(table);
+}
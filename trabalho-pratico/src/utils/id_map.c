@@ -0,0 +1,268 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  id_map.c
+ * @brief Implementation of methods in include/utils/id_map.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/id_hash_table.h"
+#include "utils/id_map.h"
+
+/**
+ * @struct id_map
+ * @brief  A map from integer identifiers to pointers.
+ *
+ * @var id_map::values
+ *     @brief Dense storage: array of ::id_map::capacity values, the first one associated with key
+ *            ::id_map::base. Missing keys have `NULL` values. `NULL` in sparse mode.
+ * @var id_map::capacity
+ *     @brief Number of elements in ::id_map::values.
+ * @var id_map::base
+ *     @brief Key associated with the first element of ::id_map::values.
+ * @var id_map::min_key
+ *     @brief Lowest key ever stored in ::id_map::values (since it was last reallocated).
+ * @var id_map::max_key
+ *     @brief Highest key ever stored in ::id_map::values (since it was last reallocated).
+ * @var id_map::length
+ *     @brief Number of entries in the map (dense mode).
+ * @var id_map::reserved
+ *     @brief Number of entries requested with ::id_map_reserve, used when switching to sparse
+ *            mode.
+ * @var id_map::sparse
+ *     @brief Sparse storage. `NULL` in dense mode.
+ */
+struct id_map {
+    void    **values;
+    size_t    capacity;
+    uint32_t  base, min_key, max_key;
+    size_t    length, reserved;
+
+    id_hash_table_t *sparse;
+};
+
+/** @brief Minimum number of elements in ::id_map::values. */
+#define ID_MAP_MIN_CAPACITY 1024
+
+/**
+ * @brief Maximum distance between the lowest and the highest key for a map with @p length entries
+ *        to be kept in dense mode.
+ */
+#define ID_MAP_MAX_DENSE_SPAN(length) (2 * (size_t) (length) + 4096)
+
+id_map_t *id_map_create(void) {
+    id_map_t *const map = malloc(sizeof(id_map_t));
+    if (!map)
+        return NULL;
+
+    map->values   = NULL;
+    map->capacity = 0;
+    map->base     = 0;
+    map->min_key  = 0;
+    map->max_key  = 0;
+    map->length   = 0;
+    map->reserved = 0;
+    map->sparse   = NULL;
+    return map;
+}
+
+int id_map_reserve(id_map_t *map, size_t n) {
+    if (map->sparse)
+        return id_hash_table_reserve(map->sparse, n);
+
+    /* The range of keys isn't known yet, so space is only allocated when needed */
+    map->reserved = n > map->reserved ? n : map->reserved;
+    return 0;
+}
+
+/**
+ * @brief Moves all entries of a map in dense mode to a hash table.
+ *
+ * @param map Map to be modified.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p map is left unchanged).
+ */
+int __id_map_make_sparse(id_map_t *map) {
+    const size_t           capacity = map->reserved > map->length ? map->reserved : map->length;
+    id_hash_table_t *const sparse   = id_hash_table_create(capacity + 1);
+    if (!sparse)
+        return 1;
+
+    for (size_t i = 0; i < map->capacity; ++i) {
+        /* Can't fail, as enough space was reserved */
+        if (map->values[i])
+            id_hash_table_insert(sparse, map->base + i, map->values[i]);
+    }
+
+    free(map->values);
+    map->values   = NULL;
+    map->capacity = 0;
+    map->sparse   = sparse;
+    return 0;
+}
+
+/**
+ * @brief Reallocates ::id_map::values, so that a key outside of its range can be stored.
+ *
+ * @param map     Map to be modified.
+ * @param min_key Lowest key that must fit in the new array.
+ * @param max_key Highest key that must fit in the new array.
+ * @param down    Whether the array is growing towards lower keys (room is left before
+ *                @p min_key instead of after @p max_key).
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p map is left unchanged).
+ */
+int __id_map_grow(id_map_t *map, uint32_t min_key, uint32_t max_key, int down) {
+    const size_t span         = (size_t) max_key - min_key + 1;
+    size_t       new_capacity = span * 2;
+    if (new_capacity < ID_MAP_MIN_CAPACITY)
+        new_capacity = ID_MAP_MIN_CAPACITY;
+    if (new_capacity < map->reserved)
+        new_capacity = map->reserved;
+
+    void **const new_values = calloc(new_capacity, sizeof(void *));
+    if (!new_values)
+        return 1;
+
+    uint32_t new_base = min_key;
+    if (down)
+        new_base = (size_t) max_key + 1 >= new_capacity ? max_key + 1 - new_capacity : 0;
+
+    if (map->length)
+        memcpy(new_values + (map->min_key - new_base),
+               map->values + (map->min_key - map->base),
+               sizeof(void *) * ((size_t) map->max_key - map->min_key + 1));
+
+    free(map->values);
+    map->values   = new_values;
+    map->capacity = new_capacity;
+    map->base     = new_base;
+    map->min_key  = min_key;
+    map->max_key  = max_key;
+    return 0;
+}
+
+int id_map_shrink_to_fit(id_map_t *map) {
+    map->reserved = 0;
+    if (map->sparse)
+        return id_hash_table_shrink_to_fit(map->sparse);
+
+    const size_t span = map->length ? (size_t) map->max_key - map->min_key + 1 : 0;
+    if (span >= map->capacity)
+        return 0;
+
+    void **const new_values = malloc(sizeof(void *) * span);
+    if (!new_values && span)
+        return 1;
+
+    if (span)
+        memcpy(new_values, map->values + (map->min_key - map->base), sizeof(void *) * span);
+
+    free(map->values);
+    map->values   = new_values;
+    map->capacity = span;
+    map->base     = map->min_key;
+    return 0;
+}
+
+int id_map_insert(id_map_t *map, uint32_t key, void *value) {
+    if (map->sparse)
+        return id_hash_table_insert(map->sparse, key, value);
+
+    if (key < map->base || (size_t) key - map->base >= map->capacity) {
+        const uint32_t min_key = map->length && map->min_key < key ? map->min_key : key;
+        const uint32_t max_key = map->length && map->max_key > key ? map->max_key : key;
+
+        if ((size_t) max_key - min_key + 1 > ID_MAP_MAX_DENSE_SPAN(map->length + 1)) {
+            if (__id_map_make_sparse(map))
+                return 1;
+            return id_hash_table_insert(map->sparse, key, value);
+        }
+
+        if (__id_map_grow(map, min_key, max_key, map->length && key < map->min_key))
+            return 1;
+    }
+
+    void **const slot = &map->values[key - map->base];
+    if (*slot) {
+        *slot = value;
+        return 2;
+    }
+
+    *slot = value;
+    if (!map->length || key < map->min_key)
+        map->min_key = key;
+    if (!map->length || key > map->max_key)
+        map->max_key = key;
+    map->length++;
+    return 0;
+}
+
+void *id_map_lookup(const id_map_t *map, uint32_t key) {
+    if (map->sparse)
+        return id_hash_table_lookup(map->sparse, key);
+
+    if (key < map->base || (size_t) key - map->base >= map->capacity)
+        return NULL;
+    return map->values[key - map->base];
+}
+
+void id_map_lookup_batch(const id_map_t *map, size_t n, const uint32_t keys[n], void *values[n]) {
+    if (map->sparse) {
+        id_hash_table_lookup_batch(map->sparse, n, keys, values);
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        values[i] = id_map_lookup(map, keys[i]);
+}
+
+int id_map_remove(id_map_t *map, uint32_t key) {
+    if (map->sparse)
+        return id_hash_table_remove(map->sparse, key);
+
+    if (key < map->base || (size_t) key - map->base >= map->capacity ||
+        !map->values[key - map->base])
+        return 1;
+
+    map->values[key - map->base] = NULL;
+    map->length--;
+    return 0;
+}
+
+size_t id_map_get_length(const id_map_t *map) {
+    if (map->sparse)
+        return id_hash_table_get_length(map->sparse);
+    return map->length;
+}
+
+size_t id_map_get_memory_usage(const id_map_t *map) {
+    if (map->sparse)
+        return sizeof(id_map_t) + id_hash_table_get_memory_usage(map->sparse);
+    return sizeof(id_map_t) + map->capacity * sizeof(void *);
+}
+
+void id_map_free(id_map_t *map) {
+    if (map->sparse)
+        id_hash_table_free(map->sparse);
+    free(map->values);
+    free(map);
+}
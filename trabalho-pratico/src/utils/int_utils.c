@@ -22,6 +22,9 @@
  * See [the header file's documentation](@ref int_utils_examples).
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "utils/int_utils.h"
 
 int int_utils_parse_positive(uint64_t *output, const char *input) {
@@ -47,3 +50,168 @@ int int_utils_parse_positive(uint64_t *output, const char *input) {
     *output = acc;
     return 0;
 }
+
+uint64_t int_utils_load_chars(const char input[8]) {
+    uint64_t chars = 0;
+    for (int i = 0; i < 8; ++i)
+        chars |= (uint64_t) (uint8_t) input[i] << (i * 8);
+    return chars;
+}
+
+int int_utils_parse_digit_pairs(uint8_t output[4], uint64_t chars) {
+    /*
+     * Digits become 0-9 in each byte. Any other character becomes a byte (the lowest one among
+     * them, in case of borrowing) larger than 9, that either has its top bit set or gains it when
+     * 0x76 is added.
+     */
+    const uint64_t digits  = chars - 0x3030303030303030;
+    const uint64_t invalid = (digits | (digits + 0x7676767676767676)) & 0x8080808080808080;
+
+    /* Each pair of bytes (first digit in the lower one) becomes a 16-bit number */
+    const uint64_t pairs = (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FF;
+    for (int i = 0; i < 4; ++i)
+        output[i] = pairs >> (i * 16);
+
+    return invalid != 0;
+}
+
+/**
+ * @brief Swaps two integers.
+ *
+ * @param a First integer.
+ * @param b Second integer.
+ */
+void __int_utils_swap_int64(int64_t *a, int64_t *b) {
+    const int64_t tmp = *a;
+    *a                = *b;
+    *b                = tmp;
+}
+
+/**
+ * @brief   Partitions an array of integers around the median of its first, middle and last values.
+ * @details Auxiliary method for ::__int_utils_select_int64.
+ *
+ * @param values Values to be partitioned.
+ * @param n      Number of elements in @p values. Must be at least `2`.
+ *
+ * @return The final position of the pivot. Values before it aren't greater than it, and values
+ *         after it aren't lower than it.
+ */
+size_t __int_utils_partition_int64(int64_t *values, size_t n) {
+    const size_t middle = n / 2, last = n - 1;
+
+    /* Median of three, placed in the last position */
+    if (values[middle] < values[0])
+        __int_utils_swap_int64(&values[middle], &values[0]);
+    if (values[last] < values[0])
+        __int_utils_swap_int64(&values[last], &values[0]);
+    if (values[last] < values[middle])
+        __int_utils_swap_int64(&values[last], &values[middle]);
+    __int_utils_swap_int64(&values[middle], &values[last]);
+
+    const int64_t pivot = values[last];
+    size_t        store = 0;
+    for (size_t i = 0; i < last; ++i)
+        if (values[i] < pivot)
+            __int_utils_swap_int64(&values[i], &values[store++]);
+
+    __int_utils_swap_int64(&values[store], &values[last]);
+    return store;
+}
+
+/**
+ * @brief   Comparison function for sorting `int64_t`s with `qsort`.
+ * @details Auxiliary method for ::__int_utils_select_int64.
+ */
+int __int_utils_int64_compare(const void *a, const void *b) {
+    const int64_t int_a = *(const int64_t *) a;
+    const int64_t int_b = *(const int64_t *) b;
+    return (int_a > int_b) - (int_a < int_b);
+}
+
+/**
+ * @brief   Finds the `k`-th lowest value in an array of integers.
+ * @details Quickselect, that falls back to sorting when too many partitions are needed (bad
+ *          pivots). After this method, values before position @p k aren't greater than the
+ *          returned value.
+ *
+ * @param values Values to search. Will be reordered.
+ * @param n      Number of elements in @p values.
+ * @param k      Position of the value to find in @p values, were it sorted. Must be lower than
+ *               @p n.
+ *
+ * @return The `k`-th lowest value in @p values.
+ */
+int64_t __int_utils_select_int64(int64_t *values, size_t n, size_t k) {
+    size_t depth = 0;
+    for (size_t i = n; i; i >>= 1)
+        depth += 2;
+
+    while (n > 1) {
+        if (depth-- == 0) {
+            qsort(values, n, sizeof(int64_t), __int_utils_int64_compare);
+            return values[k];
+        }
+
+        const size_t pivot = __int_utils_partition_int64(values, n);
+        if (k == pivot) {
+            return values[k];
+        } else if (k < pivot) {
+            n = pivot;
+        } else {
+            values += pivot + 1;
+            n -= pivot + 1;
+            k -= pivot + 1;
+        }
+    }
+
+    return values[0];
+}
+
+double int_utils_median_int64(int64_t *values, size_t n) {
+    const size_t  middle = n / 2;
+    const int64_t upper  = __int_utils_select_int64(values, n, middle);
+    if (n % 2)
+        return upper;
+
+    /* The other middle value is the greatest among the ones before middle */
+    int64_t lower = values[0];
+    for (size_t i = 1; i < middle; ++i)
+        lower = max(lower, values[i]);
+
+    return ((double) lower + (double) upper) * 0.5;
+}
+
+/** @brief Pairs of decimal digits, from `"00"` to `"99"`. */
+const char int_utils_digit_pairs[201] = "00010203040506070809"
+                                        "10111213141516171819"
+                                        "20212223242526272829"
+                                        "30313233343536373839"
+                                        "40414243444546474849"
+                                        "50515253545556575859"
+                                        "60616263646566676869"
+                                        "70717273747576777879"
+                                        "80818283848586878889"
+                                        "90919293949596979899";
+
+void int_utils_write_fixed(char *output, uint64_t value, size_t width) {
+    while (width >= 2) {
+        width -= 2;
+        memcpy(output + width, int_utils_digit_pairs + (value % 100) * 2, 2);
+        value /= 100;
+    }
+
+    if (width)
+        output[0] = '0' + value % 10;
+}
+
+size_t int_utils_sprint_unsigned(char *output, uint64_t value) {
+    size_t length = 1;
+    for (uint64_t power = 10; length < INT_UTILS_SPRINT_MIN_BUFFER_SIZE - 1 && value >= power;
+         power *= 10)
+        length++;
+
+    int_utils_write_fixed(output, value, length);
+    output[length] = '\0';
+    return length;
+}
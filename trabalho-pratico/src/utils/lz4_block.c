@@ -0,0 +1,252 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  lz4_block.c
+ * @brief Implementation of methods in include/utils/lz4_block.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref lz4_block_examples).
+ */
+
+#include <string.h>
+
+#include "utils/lz4_block.h"
+
+/** @brief Number of bits in the hash of a 4-byte sequence (see ::__lz4_block_hash). */
+#define LZ4_BLOCK_HASH_BITS 12
+
+/** @brief Minimum length of a back-reference, subtracted from the length stored in blocks. */
+#define LZ4_BLOCK_MIN_MATCH 4
+
+/** @brief Number of bytes at the end of a block that must always be literals. */
+#define LZ4_BLOCK_LAST_LITERALS 5
+
+/** @brief Minimum distance from the start of the last back-reference to the end of a block. */
+#define LZ4_BLOCK_MATCH_LIMIT 12
+
+/** @brief Maximum distance of a back-reference (offsets are stored in 16 bits). */
+#define LZ4_BLOCK_MAX_OFFSET 65535
+
+/**
+ * @brief   Number of consecutive failed searches for a back-reference after which bytes start being
+ *          skipped.
+ * @details Data that doesn't compress is gone through faster, as every further
+ *          ::LZ4_BLOCK_SKIP_TRIGGER failures increase the step by one byte.
+ */
+#define LZ4_BLOCK_SKIP_TRIGGER 64
+
+/**
+ * @brief Reads 4 bytes from a possibly unaligned position.
+ * @param ptr Where to read from.
+ * @return The 4 bytes at @p ptr, in native byte order.
+ */
+uint32_t __lz4_block_read_32(const uint8_t *ptr) {
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(uint32_t));
+    return value;
+}
+
+/**
+ * @brief Hashes a 4-byte sequence, to index the table of previous occurrences.
+ * @param sequence Sequence to be hashed.
+ * @return A value lower than `1 << LZ4_BLOCK_HASH_BITS`.
+ */
+uint32_t __lz4_block_hash(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - LZ4_BLOCK_HASH_BITS);
+}
+
+/**
+ * @brief Writes the part of a length that doesn't fit in a sequence's token.
+ *
+ * @param out    Where to write the length to.
+ * @param length Length minus `15`.
+ *
+ * @return A pointer to the first byte after the written length.
+ */
+uint8_t *__lz4_block_write_length(uint8_t *out, size_t length) {
+    while (length >= 255) {
+        *out++  = 255;
+        length -= 255;
+    }
+    *out++ = (uint8_t) length;
+    return out;
+}
+
+/**
+ * @brief Writes a sequence (a run of literals, followed by a back-reference) to a block.
+ *
+ * @param out          Where to write the sequence to. Moved to the first byte after it.
+ * @param end          End of the output buffer.
+ * @param literals     Bytes to be copied to the block as-is.
+ * @param nliterals    Number of bytes in @p literals.
+ * @param offset       Distance from the start of the back-reference to the data it refers to.
+ * @param match_length Length of the back-reference. `0` for the last sequence in the block, which
+ *                     only contains literals.
+ *
+ * @retval 0 Success.
+ * @retval 1 Not enough space between @p out and @p end.
+ */
+int __lz4_block_write_sequence(uint8_t      **out,
+                               const uint8_t *end,
+                               const uint8_t *literals,
+                               size_t         nliterals,
+                               size_t         offset,
+                               size_t         match_length) {
+    const size_t extra_match = match_length ? match_length - LZ4_BLOCK_MIN_MATCH : 0;
+    const size_t needed      = 1 + (nliterals / 255 + 1) + nliterals + 2 + (extra_match / 255 + 1);
+    if ((size_t) (end - *out) < needed)
+        return 1;
+
+    uint8_t *const token = *out;
+    uint8_t       *o     = token + 1;
+
+    *token = (uint8_t) ((nliterals >= 15 ? 15 : nliterals) << 4);
+    if (nliterals >= 15)
+        o = __lz4_block_write_length(o, nliterals - 15);
+    memcpy(o, literals, nliterals);
+    o += nliterals;
+
+    if (match_length) {
+        o[0]    = (uint8_t) (offset & 0xff);
+        o[1]    = (uint8_t) (offset >> 8);
+        o      += 2;
+        *token |= (uint8_t) (extra_match >= 15 ? 15 : extra_match);
+        if (extra_match >= 15)
+            o = __lz4_block_write_length(o, extra_match - 15);
+    }
+
+    *out = o;
+    return 0;
+}
+
+size_t lz4_block_compress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity) {
+    uint8_t             *out     = output;
+    const uint8_t *const out_end = output + capacity;
+    size_t               anchor  = 0; /* Start of the literals not yet written */
+
+    if (length >= LZ4_BLOCK_MATCH_LIMIT) {
+        uint32_t table[1 << LZ4_BLOCK_HASH_BITS];
+        memset(table, 0xff, sizeof(table)); /* UINT32_MAX for no previous occurrence */
+
+        const size_t search_end = length - LZ4_BLOCK_MATCH_LIMIT;
+        const size_t match_end  = length - LZ4_BLOCK_LAST_LITERALS;
+        size_t       i = 0, misses = 0;
+        while (i <= search_end) {
+            const uint32_t sequence  = __lz4_block_read_32(input + i);
+            const uint32_t hash      = __lz4_block_hash(sequence);
+            size_t         candidate = table[hash];
+            table[hash]              = (uint32_t) i;
+
+            if (candidate == UINT32_MAX || i - candidate > LZ4_BLOCK_MAX_OFFSET ||
+                __lz4_block_read_32(input + candidate) != sequence) {
+                i += 1 + misses++ / LZ4_BLOCK_SKIP_TRIGGER;
+                continue;
+            }
+
+            /* Extend the match backwards, into literals, and then forwards */
+            while (i > anchor && candidate > 0 && input[i - 1] == input[candidate - 1]) {
+                i--;
+                candidate--;
+            }
+
+            size_t match_length = LZ4_BLOCK_MIN_MATCH;
+            while (i + match_length < match_end &&
+                   input[i + match_length] == input[candidate + match_length])
+                match_length++;
+
+            if (__lz4_block_write_sequence(&out,
+                                           out_end,
+                                           input + anchor,
+                                           i - anchor,
+                                           i - candidate,
+                                           match_length))
+                return 0;
+
+            i      += match_length;
+            anchor  = i;
+            misses  = 0;
+        }
+    }
+
+    if (__lz4_block_write_sequence(&out, out_end, input + anchor, length - anchor, 0, 0))
+        return 0;
+    return (size_t) (out - output);
+}
+
+/**
+ * @brief Reads the part of a length that doesn't fit in a sequence's token.
+ *
+ * @param in     Where to read the length from. Moved to the first byte after it.
+ * @param end    End of the block.
+ * @param length Length to be incremented.
+ *
+ * @retval 0 Success.
+ * @retval 1 The block ends before the length, or the length overflows.
+ */
+int __lz4_block_read_length(const uint8_t **in, const uint8_t *end, size_t *length) {
+    uint8_t byte;
+    do {
+        if (*in == end || *length > SIZE_MAX - 255)
+            return 1;
+        byte     = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+size_t lz4_block_decompress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity) {
+    const uint8_t       *in     = input;
+    const uint8_t *const in_end = input + length;
+    size_t               o      = 0;
+
+    while (in < in_end) {
+        const uint8_t token = *in++;
+
+        size_t nliterals = token >> 4;
+        if (nliterals == 15 && __lz4_block_read_length(&in, in_end, &nliterals))
+            return LZ4_BLOCK_DECOMPRESS_FAILED;
+        if (nliterals > (size_t) (in_end - in) || nliterals > capacity - o)
+            return LZ4_BLOCK_DECOMPRESS_FAILED;
+
+        memcpy(output + o, in, nliterals);
+        in += nliterals;
+        o  += nliterals;
+        if (in == in_end)
+            break; /* Last sequence, without a back-reference */
+
+        if (in_end - in < 2)
+            return LZ4_BLOCK_DECOMPRESS_FAILED;
+        const size_t offset  = (size_t) in[0] | ((size_t) in[1] << 8);
+        in                  += 2;
+        if (offset == 0 || offset > o)
+            return LZ4_BLOCK_DECOMPRESS_FAILED;
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && __lz4_block_read_length(&in, in_end, &match_length))
+            return LZ4_BLOCK_DECOMPRESS_FAILED;
+        match_length += LZ4_BLOCK_MIN_MATCH;
+        if (match_length > capacity - o)
+            return LZ4_BLOCK_DECOMPRESS_FAILED;
+
+        /* Byte by byte, as the reference may overlap the bytes being written */
+        for (size_t i = 0; i < match_length; ++i, ++o)
+            output[o] = output[o - offset];
+    }
+
+    return o;
+}
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  mapped_file.c
+ * @brief Implementation of methods in include/utils/mapped_file.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref mapped_file_examples).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "utils/int_utils.h"
+#include "utils/mapped_file.h"
+
+/** @brief Environment of the current process, passed to decompressors. */
+extern char **environ;
+
+/** @brief Initial size of the buffer used to read files that can't be mapped to memory. */
+#define MAPPED_FILE_READ_BUFFER_INITIAL_SIZE 65536
+
+/**
+ * @struct mapped_file
+ * @brief  A read-only file, whose contents are mapped to memory.
+ *
+ * @var mapped_file::contents
+ *     @brief Contents of the file (not null-terminated). `NULL` for empty files.
+ * @var mapped_file::size
+ *     @brief Number of bytes in ::mapped_file::contents.
+ * @var mapped_file::is_mapped
+ *     @brief   Whether ::mapped_file::contents was mapped with `mmap`.
+ *     @details A false value means that ::mapped_file::contents is a heap buffer.
+ */
+struct mapped_file {
+    char  *contents;
+    size_t size;
+    int    is_mapped;
+};
+
+/**
+ * @brief   Reads the whole contents of a file descriptor to a heap buffer.
+ * @details Auxiliary method for ::mapped_file_open, for files that can't be mapped to memory.
+ *
+ * @param file Where to write the read contents to.
+ * @param fd   File descriptor to be read.
+ *
+ * @retval 0 Success.
+ * @retval 1 IO or allocation failure.
+ */
+int __mapped_file_read_whole(mapped_file_t *file, int fd) {
+    size_t capacity = MAPPED_FILE_READ_BUFFER_INITIAL_SIZE;
+    file->contents  = malloc(capacity);
+    file->size      = 0;
+    file->is_mapped = 0;
+    if (!file->contents)
+        return 1;
+
+    ssize_t read_bytes;
+    while ((read_bytes = read(fd, file->contents + file->size, capacity - file->size)) != 0) {
+        if (read_bytes < 0) {
+            free(file->contents);
+            return 1;
+        }
+
+        file->size += read_bytes;
+        if (file->size == capacity) {
+            capacity *= 2;
+            char *const new_contents = realloc(file->contents, capacity);
+            if (!new_contents) {
+                free(file->contents);
+                return 1;
+            }
+            file->contents = new_contents;
+        }
+    }
+
+    return 0;
+}
+
+mapped_file_t *mapped_file_open(const char *path) {
+    mapped_file_t *const file = malloc(sizeof(mapped_file_t));
+    if (!file)
+        goto DEFER_1;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        goto DEFER_2;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat))
+        goto DEFER_3;
+
+    if (S_ISREG(file_stat.st_mode)) {
+        file->size      = file_stat.st_size;
+        file->is_mapped = 0;
+        file->contents  = NULL;
+        if (file->size == 0) { /* Empty files can't be mapped */
+            close(fd);
+            return file;
+        }
+
+        void *const contents = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (contents != MAP_FAILED) {
+            posix_madvise(contents, file->size, POSIX_MADV_SEQUENTIAL);
+
+            file->contents  = contents;
+            file->is_mapped = 1;
+            close(fd); /* The mapping remains valid */
+            return file;
+        }
+    }
+
+    if (__mapped_file_read_whole(file, fd))
+        goto DEFER_3;
+
+    close(fd);
+    return file;
+
+DEFER_3:
+    close(fd);
+DEFER_2:
+    free(file);
+DEFER_1:
+    return NULL;
+}
+
+mapped_file_t *mapped_file_open_decompressed(const char *path, const char *decompressor) {
+    /* posix_spawnp's arguments aren't const, so they're copied to modifiable buffers */
+    char program[NAME_MAX + 1], flags[] = "-dc", separator[] = "--", path_copy[PATH_MAX];
+    if ((size_t) snprintf(program, sizeof(program), "%s", decompressor) >= sizeof(program) ||
+        (size_t) snprintf(path_copy, sizeof(path_copy), "%s", path) >= sizeof(path_copy))
+        return NULL;
+    char *const argv[] = {program, flags, separator, path_copy, NULL};
+
+    mapped_file_t *const file = malloc(sizeof(mapped_file_t));
+    if (!file)
+        goto DEFER_1;
+
+    int fds[2];
+    if (pipe(fds))
+        goto DEFER_2;
+
+    posix_spawn_file_actions_t actions;
+    if (posix_spawn_file_actions_init(&actions))
+        goto DEFER_3;
+
+    pid_t pid;
+    if (posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO) ||
+        posix_spawn_file_actions_addclose(&actions, fds[0]) ||
+        posix_spawn_file_actions_addclose(&actions, fds[1]) ||
+        posix_spawnp(&pid, program, &actions, NULL, argv, environ)) {
+
+        posix_spawn_file_actions_destroy(&actions);
+        goto DEFER_3;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+
+    /*
+     * The decompressor runs concurrently in its own process, and the pipe between both processes
+     * is a bounded buffer: its output is consumed as it's produced, never reaching the disk.
+     */
+    close(fds[1]);
+    const int read_failed = __mapped_file_read_whole(file, fds[0]);
+    close(fds[0]); /* A decompressor still writing will stop on SIGPIPE */
+
+    int status, wait_failed;
+    while ((wait_failed = waitpid(pid, &status, 0) < 0) && errno == EINTR)
+        ;
+
+    if (read_failed)
+        goto DEFER_2;
+    if (wait_failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        free(file->contents); /* Truncated or corrupt input */
+        goto DEFER_2;
+    }
+
+    return file;
+
+DEFER_3:
+    close(fds[0]);
+    close(fds[1]);
+DEFER_2:
+    free(file);
+DEFER_1:
+    return NULL;
+}
+
+const char *mapped_file_get_contents(const mapped_file_t *file) {
+    return file->contents;
+}
+
+size_t mapped_file_get_size(const mapped_file_t *file) {
+    return file->size;
+}
+
+void mapped_file_prefetch(const mapped_file_t *file, size_t begin, size_t end) {
+    end = min(end, file->size);
+    if (!file->is_mapped || begin >= end)
+        return;
+
+    /* The address passed to posix_madvise must be page aligned */
+    const long   page_size = sysconf(_SC_PAGESIZE);
+    const size_t aligned   = page_size > 0 ? begin - begin % page_size : begin;
+    posix_madvise(file->contents + aligned, end - aligned, POSIX_MADV_WILLNEED);
+}
+
+void mapped_file_touch(const mapped_file_t *file, size_t begin, size_t end) {
+    end = min(end, file->size);
+    if (!file->is_mapped || begin >= end)
+        return;
+
+    const long   page_size = sysconf(_SC_PAGESIZE);
+    const size_t stride    = page_size > 0 ? (size_t) page_size : 4096;
+
+    /* volatile, so that reads aren't optimized away */
+    const volatile char *const contents = file->contents;
+    for (size_t i = begin; i < end; i += stride)
+        (void) contents[i];
+    (void) contents[end - 1];
+}
+
+/**
+ * @brief   Splits part of a mapped file into tokens, separated by @p delimiter.
+ * @details Auxiliary method for ::mapped_file_tokenize and ::mapped_file_tokenize_range.
+ *
+ * @param file      File to tokenize.
+ * @param begin     Offset of the beginning of the region to tokenize.
+ * @param end       Offset of the end of the region to tokenize (exclusive).
+ * @param stop      Where to write the offset right after the last processed token to. Can be
+ *                  `NULL`.
+ * @param delimiter       Character to separate tokens. It won't be part of those tokens.
+ * @param callback        Function called for every token read. Can be `NULL` if
+ *                        @p offset_callback isn't.
+ * @param offset_callback Function called for every token read, with its offset in the file. Only
+ *                        called if @p callback is `NULL`.
+ * @param user_data       Pointer passed to every call of @p callback or @p offset_callback.
+ *
+ * @return `0` on success, otherwise, the return value from the callback in case it ordered the
+ *         tokenization to stop. ::MAPPED_FILE_TOKENIZE_RET_ALLOCATION_FAILURE may also be returned
+ *         on allocation failures.
+ */
+int __mapped_file_tokenize(const mapped_file_t                  *file,
+                           size_t                                begin,
+                           size_t                                end,
+                           size_t                               *stop,
+                           char                                  delimiter,
+                           tokenize_iter_callback_t              callback,
+                           mapped_file_tokenize_offset_callback_t offset_callback,
+                           void                                 *user_data) {
+
+    if (!file->contents) { /* Empty file */
+        if (stop)
+            *stop = 0;
+        return 0;
+    }
+
+    const char *const region_end = file->contents + min(end, file->size);
+    const char       *current    = file->contents + min(begin, file->size);
+
+    char  *token    = NULL;
+    size_t capacity = 0;
+    int    retval   = 0;
+
+    while (current < region_end) {
+        const char *token_end = memchr(current, delimiter, region_end - current);
+        if (!token_end)
+            token_end = region_end;
+
+        /* Copy the token, so that it can be null-terminated and modified by the callback */
+        const size_t length = token_end - current;
+        if (length + 1 > capacity) {
+            capacity               = max(length + 1, capacity * 2);
+            char *const new_buffer = realloc(token, capacity);
+            if (!new_buffer) {
+                retval = MAPPED_FILE_TOKENIZE_RET_ALLOCATION_FAILURE;
+                break;
+            }
+            token = new_buffer;
+        }
+
+        memcpy(token, current, length);
+        token[length] = '\0';
+
+        const size_t offset = current - file->contents;
+        current             = token_end == region_end ? region_end : token_end + 1;
+
+        retval = callback ? callback(user_data, token) : offset_callback(user_data, token, offset);
+        if (retval)
+            break;
+    }
+
+    if (stop)
+        *stop = current - file->contents;
+    free(token);
+    return retval;
+}
+
+int mapped_file_tokenize(const mapped_file_t     *file,
+                         size_t                  *offset,
+                         char                     delimiter,
+                         tokenize_iter_callback_t callback,
+                         void                    *user_data) {
+    return __mapped_file_tokenize(file,
+                                  offset ? *offset : 0,
+                                  file->size,
+                                  offset,
+                                  delimiter,
+                                  callback,
+                                  NULL,
+                                  user_data);
+}
+
+int mapped_file_tokenize_range(const mapped_file_t     *file,
+                               size_t                   begin,
+                               size_t                   end,
+                               char                     delimiter,
+                               tokenize_iter_callback_t callback,
+                               void                    *user_data) {
+    return __mapped_file_tokenize(file, begin, end, NULL, delimiter, callback, NULL, user_data);
+}
+
+int mapped_file_tokenize_range_with_offsets(const mapped_file_t                  *file,
+                                            size_t                                begin,
+                                            size_t                                end,
+                                            char                                  delimiter,
+                                            mapped_file_tokenize_offset_callback_t callback,
+                                            void                                 *user_data) {
+    return __mapped_file_tokenize(file, begin, end, NULL, delimiter, NULL, callback, user_data);
+}
+
+void mapped_file_close(mapped_file_t *file) {
+    if (file->is_mapped)
+        munmap(file->contents, file->size);
+    else
+        free(file->contents);
+    free(file);
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  numa_topology.c
+ * @brief Implementation of methods in include/utils/numa_topology.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref numa_topology_examples).
+ */
+
+/* cpu_set_t and pthread_setaffinity_np aren't part of POSIX */
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "utils/numa_topology.h"
+
+/**
+ * @struct numa_topology
+ * @brief  The NUMA nodes of the machine.
+ *
+ * @var numa_topology::cpus
+ *     @brief Processors in each node. Empty if the topology couldn't be read.
+ * @var numa_topology::nnodes
+ *     @brief Number of elements in ::numa_topology::cpus.
+ */
+struct numa_topology {
+    cpu_set_t *cpus;
+    size_t     nnodes;
+};
+
+/**
+ * @brief   Key of the thread-specific node of every thread, offset by one (so that `NULL` means
+ *          the thread was never pinned).
+ * @details Shall not be modified apart from its creation. This global variable is justified for
+ *          the following reasons:
+ *
+ *          -# It's not modified (no mutable global state). Each thread has its own value;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# Code reading replicated data doesn't need to know which thread is running it.
+ */
+pthread_key_t __numa_topology_thread_node;
+
+/** @brief Whether ::__numa_topology_thread_node was successfully created. */
+int __numa_topology_has_thread_node = 0;
+
+/** @brief Automatically creates ::__numa_topology_thread_node when the program starts. */
+void __attribute__((constructor)) __numa_topology_thread_node_create(void) {
+    __numa_topology_has_thread_node = !pthread_key_create(&__numa_topology_thread_node, NULL);
+}
+
+/** @brief Automatically deletes ::__numa_topology_thread_node when the program terminates. */
+void __attribute__((destructor)) __numa_topology_thread_node_delete(void) {
+    if (__numa_topology_has_thread_node)
+        pthread_key_delete(__numa_topology_thread_node);
+}
+
+/**
+ * @brief Reads the processors of a NUMA node from `/sys/devices/system/node`.
+ *
+ * @param node   Node to read the processors of.
+ * @param output Where to write the processors to. Only modified on success.
+ *
+ * @retval 0 Success.
+ * @retval 1 The node doesn't exist, or its list of processors couldn't be read.
+ */
+int __numa_topology_read_node(size_t node, cpu_set_t *output) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu/cpulist", node);
+
+    FILE *const file = fopen(path, "r");
+    if (!file)
+        return 1;
+
+    /* List of ranges of processors (e.g.: 0-3,8-11) */
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (size_t first, last; fscanf(file, "%zu", &first) == 1;) {
+        int separator = fgetc(file);
+        last          = first;
+        if (separator == '-') {
+            if (fscanf(file, "%zu", &last) != 1)
+                break;
+            separator = fgetc(file);
+        }
+
+        for (size_t cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+            CPU_SET(cpu, &cpus);
+
+        if (separator != ',')
+            break;
+    }
+    fclose(file);
+
+    *output = cpus;
+    return 0;
+}
+
+numa_topology_t *numa_topology_create(void) {
+    numa_topology_t *const topology = malloc(sizeof(numa_topology_t));
+    if (!topology)
+        return NULL;
+
+    topology->cpus   = NULL;
+    topology->nnodes = 0;
+
+    /* Nodes are numbered contiguously. Nodes without processors (only memory) are skipped. */
+    cpu_set_t cpus;
+    for (size_t node = 0; !__numa_topology_read_node(node, &cpus); ++node) {
+        if (CPU_COUNT(&cpus) == 0)
+            continue;
+
+        cpu_set_t *const new_cpus =
+            realloc(topology->cpus, sizeof(cpu_set_t) * (topology->nnodes + 1));
+        if (!new_cpus) {
+            numa_topology_free(topology);
+            return NULL;
+        }
+
+        topology->cpus                     = new_cpus;
+        topology->cpus[topology->nnodes++] = cpus;
+    }
+
+    return topology;
+}
+
+size_t numa_topology_get_node_count(const numa_topology_t *topology) {
+    return topology->nnodes ? topology->nnodes : 1;
+}
+
+int numa_topology_pin_thread(const numa_topology_t *topology, size_t node) {
+    if (__numa_topology_has_thread_node)
+        pthread_setspecific(__numa_topology_thread_node, (void *) (uintptr_t) (node + 1));
+
+    if (node >= topology->nnodes)
+        return topology->nnodes != 0; /* Nothing to pin to if the topology is unknown */
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &topology->cpus[node]) != 0;
+}
+
+int numa_topology_pin_thread_to_processor(const numa_topology_t *topology,
+                                          size_t                 node,
+                                          size_t                 processor) {
+    if (__numa_topology_has_thread_node)
+        pthread_setspecific(__numa_topology_thread_node, (void *) (uintptr_t) (node + 1));
+
+    if (node >= topology->nnodes)
+        return 1; /* Processors are only known for known nodes */
+
+    /* Find the processor-th processor of the node (in a non-empty set) */
+    const cpu_set_t *const cpus = &topology->cpus[node];
+    size_t                 k    = processor % (size_t) CPU_COUNT(cpus);
+    size_t                 cpu  = 0;
+    for (;; ++cpu)
+        if (CPU_ISSET(cpu, cpus) && k-- == 0)
+            break;
+
+    cpu_set_t single;
+    CPU_ZERO(&single);
+    CPU_SET(cpu, &single);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &single) != 0;
+}
+
+size_t numa_topology_get_thread_node(void) {
+    if (!__numa_topology_has_thread_node)
+        return 0;
+
+    const uintptr_t node = (uintptr_t) pthread_getspecific(__numa_topology_thread_node);
+    return node ? node - 1 : 0;
+}
+
+/**
+ * @struct numa_topology_run_data_t
+ * @brief  Data for each thread in ::numa_topology_run_on_nodes.
+ *
+ * @var numa_topology_run_data_t::topology
+ *     @brief Topology of the machine.
+ * @var numa_topology_run_data_t::callback
+ *     @brief Method to be called in the thread.
+ * @var numa_topology_run_data_t::user_data
+ *     @brief `user_data` parameter for ::numa_topology_run_data_t::callback.
+ * @var numa_topology_run_data_t::node
+ *     @brief Node to run ::numa_topology_run_data_t::callback in.
+ * @var numa_topology_run_data_t::retval
+ *     @brief Value returned by ::numa_topology_run_data_t::callback.
+ */
+typedef struct {
+    const numa_topology_t        *topology;
+    numa_topology_node_callback_t callback;
+    void                         *user_data;
+    size_t                        node;
+    int                           retval;
+} numa_topology_run_data_t;
+
+/**
+ * @brief  Calls the callback in ::numa_topology_run_on_nodes, after pinning the thread to a node.
+ * @param  arg A pointer to a ::numa_topology_run_data_t.
+ * @return `NULL`.
+ */
+void *__numa_topology_run_thread(void *arg) {
+    numa_topology_run_data_t *const data = arg;
+
+    numa_topology_pin_thread(data->topology, data->node); /* Run anyway if pinning fails */
+    data->retval = data->callback(data->user_data, data->node);
+    return NULL;
+}
+
+int numa_topology_run_on_nodes(const numa_topology_t        *topology,
+                               numa_topology_node_callback_t callback,
+                               void                         *user_data) {
+
+    const size_t             nnodes = numa_topology_get_node_count(topology);
+    numa_topology_run_data_t data[nnodes];
+    pthread_t                threads[nnodes];
+    int                      started[nnodes];
+
+    for (size_t i = 0; i < nnodes; ++i) {
+        data[i]    = (numa_topology_run_data_t){.topology  = topology,
+                                                .callback  = callback,
+                                                .user_data = user_data,
+                                                .node      = i,
+                                                .retval    = 1};
+        started[i] = !pthread_create(&threads[i], NULL, __numa_topology_run_thread, &data[i]);
+    }
+
+    int retval = 0;
+    for (size_t i = 0; i < nnodes; ++i) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        retval |= data[i].retval != 0;
+    }
+    return retval;
+}
+
+void numa_topology_free(numa_topology_t *topology) {
+    free(topology->cpus);
+    free(topology);
+}
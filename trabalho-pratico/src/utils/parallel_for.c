@@ -0,0 +1,131 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  parallel_for.c
+ * @brief Implementation of methods in include/utils/parallel_for.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref parallel_for_examples).
+ */
+
+#include <pthread.h>
+
+#include "utils/cancellation.h"
+#include "utils/parallel_for.h"
+#include "utils/thread_count.h"
+#include "utils/thread_pool.h"
+
+/**
+ * @struct parallel_for_thread_t
+ * @brief  A sub-range of indices processed by a thread in ::parallel_for.
+ *
+ * @var parallel_for_thread_t::callback
+ *     @brief Method called for the sub-range.
+ * @var parallel_for_thread_t::user_data
+ *     @brief `user_data` parameter for ::parallel_for_thread_t::callback.
+ * @var parallel_for_thread_t::begin
+ *     @brief First index in the sub-range.
+ * @var parallel_for_thread_t::end
+ *     @brief Index after the last one in the sub-range.
+ * @var parallel_for_thread_t::retval
+ *     @brief Value returned by ::parallel_for_thread_t::callback.
+ * @var parallel_for_thread_t::cancellation
+ *     @brief Current cancellation of the calling thread of ::parallel_for, inherited by other
+ *            threads (see ::cancellation_set_current).
+ * @var parallel_for_thread_t::thread
+ *     @brief Thread processing the sub-range (only if ::parallel_for_thread_t::is_thread).
+ * @var parallel_for_thread_t::is_thread
+ *     @brief Whether this sub-range is being processed in another thread.
+ */
+typedef struct {
+    parallel_for_callback_t callback;
+    void                   *user_data;
+    size_t                  begin, end;
+    int                     retval;
+    const cancellation_t   *cancellation;
+
+    pthread_t thread;
+    int       is_thread;
+} parallel_for_thread_t;
+
+/**
+ * @brief  Entry point of a thread in ::parallel_for.
+ * @param  thread_data A pointer to a ::parallel_for_thread_t.
+ * @return `NULL`.
+ */
+void *__parallel_for_thread(void *thread_data) {
+    parallel_for_thread_t *const range = thread_data;
+    if (range->begin < range->end)
+        range->retval = range->callback(range->user_data, range->begin, range->end);
+    return NULL;
+}
+
+/**
+ * @brief  Entry point of a thread in ::parallel_for, other than the calling thread.
+ * @param  thread_data A pointer to a ::parallel_for_thread_t.
+ * @return `NULL`.
+ */
+void *__parallel_for_other_thread(void *thread_data) {
+    const parallel_for_thread_t *const range = thread_data;
+    cancellation_set_current(range->cancellation);
+    return __parallel_for_thread(thread_data);
+}
+
+int parallel_for(size_t                  n,
+                 size_t                  nthreads,
+                 parallel_for_callback_t callback,
+                 void *const            *user_data) {
+    if (nthreads == 0)
+        nthreads = 1;
+
+    thread_pool_t *const pool = nthreads > 1 ? thread_pool_get_shared() : NULL;
+    if (pool)
+        return thread_pool_parallel_for(pool, n, nthreads, callback, user_data);
+
+    const cancellation_t *const cancellation = cancellation_get_current();
+
+    parallel_for_thread_t threads[nthreads];
+    for (size_t i = 0; i < nthreads; ++i)
+        threads[i] = (parallel_for_thread_t){.callback     = callback,
+                                             .user_data    = user_data[i],
+                                             .begin        = n * i / nthreads,
+                                             .end          = n * (i + 1) / nthreads,
+                                             .retval       = 0,
+                                             .cancellation = cancellation,
+                                             .is_thread    = 0};
+
+    /* The first sub-range is always processed in the calling thread */
+    const int single_threaded = thread_count_get() == 1;
+    for (size_t i = 1; i < nthreads && !single_threaded; ++i)
+        if (threads[i].begin < threads[i].end)
+            threads[i].is_thread =
+                !pthread_create(&threads[i].thread, NULL, __parallel_for_other_thread, &threads[i]);
+
+    for (size_t i = 0; i < nthreads; ++i)
+        if (!threads[i].is_thread)
+            __parallel_for_thread(&threads[i]);
+
+    int retval = 0;
+    for (size_t i = 0; i < nthreads; ++i) {
+        if (threads[i].is_thread)
+            pthread_join(threads[i].thread, NULL);
+        if (!retval)
+            retval = threads[i].retval;
+    }
+    return retval;
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  parallel_sort.c
+ * @brief Implementation of methods in include/utils/parallel_sort.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref parallel_sort_examples).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/parallel_sort.h"
+#include "utils/thread_pool.h"
+
+/** @brief Length of the runs sorted with insertion sort, before merging starts. */
+#define PARALLEL_SORT_INSERTION_RUN 16
+
+/** @brief Maximum number of runs an array is split into, to be sorted by different threads. */
+#define PARALLEL_SORT_MAX_RUNS 64
+
+/**
+ * @struct parallel_sort_t
+ * @brief  State shared by all threads sorting the same array.
+ *
+ * @var parallel_sort_t::source
+ *     @brief Array whose runs are being sorted, or merged into ::parallel_sort_t::destination.
+ * @var parallel_sort_t::destination
+ *     @brief Temporary buffer, as large as ::parallel_sort_t::source.
+ * @var parallel_sort_t::bounds
+ *     @brief Index of the first element of each run, followed by the number of elements.
+ * @var parallel_sort_t::nruns
+ *     @brief Number of runs in ::parallel_sort_t::bounds.
+ * @var parallel_sort_t::size
+ *     @brief Size of each element, in bytes.
+ * @var parallel_sort_t::compare
+ *     @brief Function that establishes the order of elements.
+ * @var parallel_sort_t::stable
+ *     @brief Whether equal elements must keep their relative order.
+ */
+typedef struct {
+    char                   *source, *destination;
+    const size_t           *bounds;
+    size_t                  nruns, size;
+    parallel_sort_compare_t compare;
+    int                     stable;
+} parallel_sort_t;
+
+/**
+ * @brief Merges two sorted arrays into another, keeping the order of equal elements.
+ *
+ * @param a       First array, whose elements come first when equal to the ones in @p b.
+ * @param na      Number of elements in @p a.
+ * @param b       Second array.
+ * @param nb      Number of elements in @p b.
+ * @param out     Where to write the `na + nb` merged elements to.
+ * @param size    Size of each element, in bytes.
+ * @param compare Function that establishes the order of elements.
+ */
+void __parallel_sort_merge(const char             *a,
+                           size_t                  na,
+                           const char             *b,
+                           size_t                  nb,
+                           char                   *out,
+                           size_t                  size,
+                           parallel_sort_compare_t compare) {
+
+    const char *const a_end = a + na * size, *const b_end = b + nb * size;
+    while (a < a_end && b < b_end) {
+        if (compare(b, a) < 0) {
+            memcpy(out, b, size);
+            b += size;
+        } else {
+            memcpy(out, a, size);
+            a += size;
+        }
+        out += size;
+    }
+
+    memcpy(out, a, (size_t) (a_end - a));
+    memcpy(out + (a_end - a), b, (size_t) (b_end - b));
+}
+
+/**
+ * @brief Sorts an array with a stable merge sort, in the calling thread.
+ *
+ * @param base    Array to be sorted.
+ * @param tmp     Temporary buffer, with space for @p n elements.
+ * @param n       Number of elements in @p base.
+ * @param size    Size of each element, in bytes.
+ * @param compare Function that establishes the order of elements.
+ */
+void __parallel_sort_merge_sort(char                   *base,
+                                char                   *tmp,
+                                size_t                  n,
+                                size_t                  size,
+                                parallel_sort_compare_t compare) {
+
+    /* Short runs are sorted with insertion sort, which is stable and fast for few elements */
+    char element[size];
+    for (size_t begin = 0; begin < n; begin += PARALLEL_SORT_INSERTION_RUN) {
+        const size_t end = begin + PARALLEL_SORT_INSERTION_RUN < n
+                               ? begin + PARALLEL_SORT_INSERTION_RUN
+                               : n;
+
+        for (size_t i = begin + 1; i < end; ++i) {
+            size_t j = i;
+            while (j > begin && compare(base + (j - 1) * size, base + i * size) > 0)
+                j--;
+
+            if (j < i) {
+                memcpy(element, base + i * size, size);
+                memmove(base + (j + 1) * size, base + j * size, (i - j) * size);
+                memcpy(base + j * size, element, size);
+            }
+        }
+    }
+
+    char *from = base, *to = tmp;
+    for (size_t width = PARALLEL_SORT_INSERTION_RUN; width < n; width *= 2) {
+        for (size_t begin = 0; begin < n; begin += 2 * width) {
+            const size_t middle = begin + width < n ? begin + width : n;
+            const size_t end    = middle + width < n ? middle + width : n;
+            __parallel_sort_merge(from + begin * size,
+                                  middle - begin,
+                                  from + middle * size,
+                                  end - middle,
+                                  to + begin * size,
+                                  size,
+                                  compare);
+        }
+
+        char *const swap = from;
+        from             = to;
+        to               = swap;
+    }
+
+    if (from != base)
+        memcpy(base, from, n * size);
+}
+
+/**
+ * @brief   Sorts runs of an array, in a thread.
+ * @details Callback for ::thread_pool_parallel_for, where every index is a run.
+ *
+ * @param sort_data A pointer to a ::parallel_sort_t.
+ * @param begin     First run to be sorted.
+ * @param end       Run after the last one to be sorted.
+ *
+ * @retval 0 Always successful.
+ */
+int __parallel_sort_sort_runs(void *sort_data, size_t begin, size_t end) {
+    const parallel_sort_t *const sort = sort_data;
+
+    for (size_t i = begin; i < end; ++i) {
+        char *const  run = sort->source + sort->bounds[i] * sort->size;
+        const size_t n   = sort->bounds[i + 1] - sort->bounds[i];
+
+        if (sort->stable)
+            __parallel_sort_merge_sort(run,
+                                       sort->destination + sort->bounds[i] * sort->size,
+                                       n,
+                                       sort->size,
+                                       sort->compare);
+        else
+            qsort(run, n, sort->size, sort->compare);
+    }
+    return 0;
+}
+
+/**
+ * @brief   Merges pairs of sorted runs of an array, in a thread.
+ * @details Callback for ::thread_pool_parallel_for, where every index is a pair of runs. A run
+ *          without a pair (the last one, when there's an odd number of them) is just copied.
+ *
+ * @param sort_data A pointer to a ::parallel_sort_t.
+ * @param begin     First pair to be merged.
+ * @param end       Pair after the last one to be merged.
+ *
+ * @retval 0 Always successful.
+ */
+int __parallel_sort_merge_runs(void *sort_data, size_t begin, size_t end) {
+    const parallel_sort_t *const sort = sort_data;
+
+    for (size_t i = begin; i < end; ++i) {
+        const size_t first  = sort->bounds[2 * i];
+        const size_t middle = sort->bounds[2 * i + 1];
+        const size_t last   = 2 * i + 2 <= sort->nruns ? sort->bounds[2 * i + 2] : middle;
+
+        __parallel_sort_merge(sort->source + first * sort->size,
+                              middle - first,
+                              sort->source + middle * sort->size,
+                              last - middle,
+                              sort->destination + first * sort->size,
+                              sort->size,
+                              sort->compare);
+    }
+    return 0;
+}
+
+int parallel_sort(void *base, size_t n, size_t size, parallel_sort_compare_t compare, int stable) {
+    if (n < 2)
+        return 0;
+
+    thread_pool_t *const pool  = n >= PARALLEL_SORT_THRESHOLD ? thread_pool_get_shared() : NULL;
+    size_t               nruns = pool ? thread_pool_get_thread_count(pool) + 1 : 1;
+    if (nruns > PARALLEL_SORT_MAX_RUNS)
+        nruns = PARALLEL_SORT_MAX_RUNS;
+
+    if (nruns == 1 && !stable) {
+        qsort(base, n, size, compare);
+        return 0;
+    }
+
+    /* Unstable sorting can still be done without a buffer, only without multiple threads */
+    char *const tmp = malloc(n * size);
+    if (!tmp) {
+        if (stable)
+            return 1;
+
+        qsort(base, n, size, compare);
+        return 0;
+    }
+
+    if (nruns == 1) {
+        __parallel_sort_merge_sort(base, tmp, n, size, compare);
+        free(tmp);
+        return 0;
+    }
+
+    size_t bounds[PARALLEL_SORT_MAX_RUNS + 1];
+    for (size_t i = 0; i <= nruns; ++i)
+        bounds[i] = n * i / nruns;
+
+    parallel_sort_t sort = {.source      = base,
+                            .destination = tmp,
+                            .bounds      = bounds,
+                            .nruns       = nruns,
+                            .size        = size,
+                            .compare     = compare,
+                            .stable      = stable};
+
+    void *user_data[PARALLEL_SORT_MAX_RUNS];
+    for (size_t i = 0; i < nruns; ++i)
+        user_data[i] = &sort;
+
+    thread_pool_parallel_for(pool, nruns, nruns, __parallel_sort_sort_runs, user_data);
+    while (sort.nruns > 1) {
+        const size_t npairs = (sort.nruns + 1) / 2;
+        thread_pool_parallel_for(pool, npairs, npairs, __parallel_sort_merge_runs, user_data);
+
+        for (size_t i = 0; i < npairs; ++i)
+            bounds[i] = bounds[2 * i];
+        bounds[npairs] = n;
+        sort.nruns     = npairs;
+
+        char *const swap = sort.source;
+        sort.source      = sort.destination;
+        sort.destination = swap;
+    }
+
+    if (sort.source != base)
+        memcpy(base, sort.source, n * size);
+    free(tmp);
+    return 0;
+}
@@ -18,6 +18,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "utils/block_allocator.h"
+#include "utils/parallel_for.h"
 #include "utils/pool.h"
 
 /**
@@ -33,76 +35,168 @@
  * @brief  Pool allocator for objects of the same size.
  *
  * @var pool::blocks
- *     @brief Array of blocks (`uint8_t *`'s) in the pool.
+ *     @brief Array of blocks (`uint8_t *`'s) in the pool, allocated with ::pool::policy.
+ * @var pool::spare_blocks
+ *     @brief Array of blocks (`uint8_t *`'s) allocated in advance by ::pool_reserve, not yet in
+ *            ::pool::blocks.
+ * @var pool::single_use_blocks
+ *     @brief Array of blocks (`uint8_t *`'s) allocated with `malloc` for arrays larger than
+ *            ::pool::block_capacity.
+ * @var pool::single_use_counts
+ *     @brief Number of items (`size_t`'s) in each block of ::pool::single_use_blocks.
+ * @var pool::single_use_bytes
+ *     @brief Sum of the sizes (in bytes) of all blocks in ::pool::single_use_blocks.
+ * @var pool::block_used
+ *     @brief   Number of items (`size_t`'s) in each block of ::pool::blocks, except the top one
+ *              (see ::pool::top_block_used).
+ *     @details Blocks other than the top one may not be full, when an array didn't fit at their
+ *              end. Knowing where each block ends is what allows for iteration.
  * @var pool::item_size
  *     @brief Size (in bytes) of an item in the pool.
  * @var pool::block_capacity
  *     @brief Capacity of each pool block (in items).
  * @var pool::top_block_used
  *     @brief Number of items already in the top block of the pool.
- * @var pool::can_iterate
- *     @brief If a pool can be iterated over (::pool_put_items hasn't been called).
+ * @var pool::policy
+ *     @brief How blocks in ::pool::blocks are allocated.
  */
 struct pool {
-    GPtrArray *blocks;
+    GPtrArray *blocks, *spare_blocks, *single_use_blocks;
+    GArray    *single_use_counts;
+    size_t     single_use_bytes;
+    GArray    *block_used;
 
-    size_t item_size;
-    size_t block_capacity;
-    size_t top_block_used;
-
-    int can_iterate;
+    size_t                   item_size;
+    size_t                   block_capacity;
+    size_t                   top_block_used;
+    block_allocator_policy_t policy;
 };
 
 /**
- * @brief Adds a new block to the top of the pool.
+ * @brief   Adds a new block to the top of the pool.
+ * @details Blocks allocated in advance by ::pool_reserve are used first. The number of items in the
+ *          previous top block is recorded in ::pool::block_used.
  * @param pool Pool to add block to.
  *
  * @retval 0 Success
  * @retval 1 Allocation failure
  */
 int __pool_allocate_block(pool_t *pool) {
-    uint8_t *const block = malloc(pool->item_size * pool->block_capacity);
-    if (!block)
-        return 1;
+    uint8_t *block;
+    if (pool->spare_blocks->len) {
+        block = g_ptr_array_steal_index(pool->spare_blocks, pool->spare_blocks->len - 1);
+    } else {
+        block = block_allocator_alloc(pool->policy, pool->item_size * pool->block_capacity);
+        if (!block)
+            return 1;
+    }
 
+    if (pool->blocks->len)
+        g_array_append_val(pool->block_used, pool->top_block_used);
     g_ptr_array_add(pool->blocks, block);
     pool->top_block_used = 0;
     return 0;
 }
 
 /**
- * @brief   Adds a new block to the middle of a pool, that will only be used for storing a single
- *          array of items.
+ * @brief   Adds a new block to a pool, that will only be used for storing a single array of items.
  * @details Auxiliary method for ::__pool_alloc_items. Used when `n > pool->block_capacity`.
  *
  * @param pool Pool to add block to.
  * @param n    Number of elements to allocate.
  *
- * @retval 0 Success
- * @retval 1 Allocation failure
+ * @return The new block, or `NULL` on allocation failure.
  */
-int __pool_allocate_single_use_block(pool_t *pool, size_t n) {
+uint8_t *__pool_allocate_single_use_block(pool_t *pool, size_t n) {
     uint8_t *const block = malloc(pool->item_size * n);
     if (!block)
-        return 1;
+        return NULL;
 
-    g_ptr_array_insert(pool->blocks, pool->blocks->len - 1, block);
-    return 0;
+    g_ptr_array_add(pool->single_use_blocks, block);
+    g_array_append_val(pool->single_use_counts, n);
+    pool->single_use_bytes += pool->item_size * n;
+    return block;
 }
 
-pool_t *pool_create_from_size(size_t item_size, size_t block_capacity) {
+/**
+ * @brief Frees blocks of a pool allocated with its ::pool::policy, starting at an index.
+ *
+ * @param pool   Pool whose blocks are freed.
+ * @param blocks Array of blocks to be freed (::pool::blocks or ::pool::spare_blocks).
+ * @param begin  Index of the first block in @p blocks to be freed.
+ */
+void __pool_free_blocks(pool_t *pool, GPtrArray *blocks, size_t begin) {
+    for (size_t i = begin; i < blocks->len; ++i)
+        block_allocator_free(pool->policy,
+                             g_ptr_array_index(blocks, i),
+                             pool->item_size * pool->block_capacity);
+    g_ptr_array_set_size(blocks, begin);
+}
+
+/**
+ * @brief   Gets the items in a block of a pool.
+ * @details Blocks are numbered in ::pool::blocks, followed by the blocks in
+ *          ::pool::single_use_blocks.
+ *
+ * @param pool  Pool to get the block from.
+ * @param i     Index of the block. Must be less than the sum of the lengths of ::pool::blocks and
+ *              ::pool::single_use_blocks.
+ * @param items Where to write a pointer to the first item in the block to.
+ *
+ * @return The number of items in the block (may be `0`).
+ */
+size_t __pool_get_block_items(const pool_t *pool, size_t i, const uint8_t **items) {
+    if (i >= pool->blocks->len) {
+        i -= pool->blocks->len;
+        *items = g_ptr_array_index(pool->single_use_blocks, i);
+        return g_array_index(pool->single_use_counts, size_t, i);
+    }
+
+    *items = g_ptr_array_index(pool->blocks, i);
+    return i == pool->blocks->len - 1 ? pool->top_block_used
+                                      : g_array_index(pool->block_used, size_t, i);
+}
+
+/**
+ * @brief Tells the operating system that a block of a pool won't be accessed for a while.
+ *
+ * @param pool Pool the block belongs to.
+ * @param i    Index of the block (see ::__pool_get_block_items).
+ */
+void __pool_evict_block(const pool_t *pool, size_t i) {
+    if (i < pool->blocks->len) /* Single-use blocks always come from malloc */
+        block_allocator_evict(pool->policy,
+                              g_ptr_array_index(pool->blocks, i),
+                              pool->item_size * pool->block_capacity);
+}
+
+pool_t *pool_create_from_size_with_policy(size_t                   item_size,
+                                          size_t                   block_capacity,
+                                          block_allocator_policy_t policy) {
     pool_t *const pool = malloc(sizeof(pool_t));
     if (!pool)
         return NULL;
 
-    pool->blocks         = g_ptr_array_new_with_free_func(free);
-    pool->item_size      = item_size;
-    pool->block_capacity = block_capacity;
-    pool->top_block_used = 0;
-    pool->can_iterate    = 1;
+    /* Use all the space that will be allocated anyway (e.g.: the rest of a huge page) */
+    const size_t block_size = block_allocator_get_size(policy, item_size * block_capacity);
+
+    pool->blocks            = g_ptr_array_new();
+    pool->spare_blocks      = g_ptr_array_new();
+    pool->single_use_blocks = g_ptr_array_new_with_free_func(free);
+    pool->single_use_counts = g_array_new(FALSE, FALSE, sizeof(size_t));
+    pool->single_use_bytes  = 0;
+    pool->block_used        = g_array_new(FALSE, FALSE, sizeof(size_t));
+    pool->item_size         = item_size;
+    pool->block_capacity    = block_size / item_size;
+    pool->top_block_used    = 0;
+    pool->policy            = policy;
 
     if (__pool_allocate_block(pool)) {
         g_ptr_array_unref(pool->blocks);
+        g_ptr_array_unref(pool->spare_blocks);
+        g_ptr_array_unref(pool->single_use_blocks);
+        g_array_unref(pool->single_use_counts);
+        g_array_unref(pool->block_used);
         free(pool);
         return NULL;
     }
@@ -110,6 +204,29 @@ pool_t *pool_create_from_size(size_t item_size, size_t block_capacity) {
     return pool;
 }
 
+pool_t *pool_create_from_size(size_t item_size, size_t block_capacity) {
+    return pool_create_from_size_with_policy(item_size,
+                                             block_capacity,
+                                             BLOCK_ALLOCATOR_POLICY_MALLOC);
+}
+
+int pool_reserve(pool_t *pool, size_t n) {
+    size_t available = pool->block_capacity - pool->top_block_used +
+                       pool->block_capacity * pool->spare_blocks->len;
+
+    while (available < n) {
+        uint8_t *const block =
+            block_allocator_alloc(pool->policy, pool->item_size * pool->block_capacity);
+        if (!block)
+            return 1;
+
+        g_ptr_array_add(pool->spare_blocks, block);
+        available += pool->block_capacity;
+    }
+
+    return 0;
+}
+
 void *__pool_alloc_item(pool_t *pool) {
     if (pool->top_block_used == pool->block_capacity) {
         if (__pool_allocate_block(pool))
@@ -123,13 +240,8 @@ void *__pool_alloc_item(pool_t *pool) {
 }
 
 void *__pool_alloc_items(pool_t *pool, size_t n) {
-    pool->can_iterate = 0;
-
     if (n > pool->block_capacity) { /* Very large array */
-        if (__pool_allocate_single_use_block(pool, n))
-            return NULL;
-
-        return g_ptr_array_index(pool->blocks, pool->blocks->len - 2);
+        return __pool_allocate_single_use_block(pool, n);
     } else {
         const size_t block_left = pool->block_capacity - pool->top_block_used;
         if (n > block_left)
@@ -162,13 +274,13 @@ void *__pool_put_items(pool_t *pool, const void *items_location, size_t n) {
 }
 
 int pool_iter(const pool_t *pool, pool_iter_callback_t callback, void *user_data) {
-    if (!pool->can_iterate)
-        return POOL_ITER_RET_ADDED_ARRAY;
+    const size_t nblocks = pool->blocks->len + pool->single_use_blocks->len;
+    for (size_t i = 0; i < nblocks; ++i) {
+        if (cancellation_check())
+            return CANCELLATION_ITER_RET;
 
-    for (size_t i = 0; i < pool->blocks->len; ++i) {
-        const uint8_t *const block = g_ptr_array_index(pool->blocks, i);
-        const size_t         item_count =
-            i == pool->blocks->len - 1 ? pool->top_block_used : pool->block_capacity;
+        const uint8_t *block;
+        const size_t   item_count = __pool_get_block_items(pool, i, &block);
 
         for (size_t j = 0; j < item_count; ++j) {
             const void *const item   = block + pool->item_size * j;
@@ -177,18 +289,218 @@ int pool_iter(const pool_t *pool, pool_iter_callback_t callback, void *user_data
             if (retval)
                 return retval;
         }
+
+        /* Scans don't revisit blocks, that shouldn't push other data out of memory */
+        __pool_evict_block(pool, i);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Calls a callback for every block in a range of blocks of a pool.
+ *
+ * @param pool      Pool to iterate through.
+ * @param begin     Index of the first block to iterate through (see ::__pool_get_block_items).
+ * @param end       Index of the block after the last one to iterate through.
+ * @param callback  Method called for every non-empty block.
+ * @param user_data Pointer passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback.
+ */
+int __pool_iter_block_range(const pool_t               *pool,
+                            size_t                      begin,
+                            size_t                      end,
+                            pool_iter_blocks_callback_t callback,
+                            void                       *user_data) {
+
+    for (size_t i = begin; i < end; ++i) {
+        const uint8_t *block;
+        const size_t   item_count = __pool_get_block_items(pool, i, &block);
+        if (!item_count)
+            continue;
+        if (cancellation_check())
+            return CANCELLATION_ITER_RET;
+
+        const int retval = callback(user_data, block, item_count);
+        if (retval)
+            return retval;
+
+        /* Scans don't revisit blocks, that shouldn't push other data out of memory */
+        __pool_evict_block(pool, i);
+    }
+
+    return 0;
+}
+
+int pool_iter_blocks(const pool_t *pool, pool_iter_blocks_callback_t callback, void *user_data) {
+    const size_t nblocks = pool->blocks->len + pool->single_use_blocks->len;
+    return __pool_iter_block_range(pool, 0, nblocks, callback, user_data);
+}
+
+/**
+ * @struct pool_iter_pointers_data_t
+ * @brief  Data passed to ::__pool_iter_pointers_callback by ::pool_iter_pointers.
+ *
+ * @var pool_iter_pointers_data_t::callback
+ *     @brief Callback to be called for every group of pointers.
+ * @var pool_iter_pointers_data_t::user_data
+ *     @brief `user_data` parameter for every ::pool_iter_pointers_data_t::callback.
+ * @var pool_iter_pointers_data_t::item_size
+ *     @brief Size (in bytes) of an item in the pool (::pool::item_size).
+ */
+typedef struct {
+    pool_iter_pointers_callback_t callback;
+    void                         *user_data;
+    size_t                        item_size;
+} pool_iter_pointers_data_t;
+
+/**
+ * @brief   Calls a ::pool_iter_pointers_callback_t for groups of pointers to items in a block.
+ * @details Auxiliary method for ::pool_iter_pointers and ::pool_iter_pointers_parallel.
+ *
+ * @param user_data A pointer to a ::pool_iter_pointers_data_t.
+ * @param items     Items in a pool block.
+ * @param n         Number of items in @p items.
+ *
+ * @return The return value of the last-called target callback.
+ */
+int __pool_iter_pointers_callback(void *user_data, const void *items, size_t n) {
+    const pool_iter_pointers_data_t *const data  = user_data;
+    const uint8_t *const                   bytes = items;
+
+    const void *pointers[POOL_ITER_POINTERS_CAPACITY];
+    for (size_t i = 0; i < n; i += POOL_ITER_POINTERS_CAPACITY) {
+        const size_t count =
+            n - i < POOL_ITER_POINTERS_CAPACITY ? n - i : POOL_ITER_POINTERS_CAPACITY;
+
+        for (size_t j = 0; j < count; ++j)
+            pointers[j] = bytes + data->item_size * (i + j);
+
+        const int retval = data->callback(data->user_data, pointers, count);
+        if (retval)
+            return retval;
     }
 
     return 0;
 }
 
+int pool_iter_pointers(const pool_t                 *pool,
+                       pool_iter_pointers_callback_t callback,
+                       void                         *user_data) {
+    pool_iter_pointers_data_t data = {.callback  = callback,
+                                      .user_data = user_data,
+                                      .item_size = pool->item_size};
+    return pool_iter_blocks(pool, __pool_iter_pointers_callback, &data);
+}
+
+/**
+ * @struct pool_iter_range_data_t
+ * @brief  Data for each thread in ::pool_iter_blocks_parallel.
+ *
+ * @var pool_iter_range_data_t::pool
+ *     @brief Pool being iterated through.
+ * @var pool_iter_range_data_t::callback
+ *     @brief Method called for every block in the thread's range of blocks.
+ * @var pool_iter_range_data_t::user_data
+ *     @brief `user_data` parameter for every ::pool_iter_range_data_t::callback.
+ */
+typedef struct {
+    const pool_t               *pool;
+    pool_iter_blocks_callback_t callback;
+    void                       *user_data;
+} pool_iter_range_data_t;
+
+/**
+ * @brief   Iterates through a range of blocks of a pool.
+ * @details Auxiliary method for ::pool_iter_blocks_parallel, called in each thread.
+ *
+ * @param user_data A pointer to a ::pool_iter_range_data_t.
+ * @param begin     Index of the first block to iterate through.
+ * @param end       Index of the block after the last one to iterate through.
+ *
+ * @return The return value of the last-called callback.
+ */
+int __pool_iter_range_callback(void *user_data, size_t begin, size_t end) {
+    const pool_iter_range_data_t *const data = user_data;
+    return __pool_iter_block_range(data->pool, begin, end, data->callback, data->user_data);
+}
+
+int pool_iter_blocks_parallel(const pool_t               *pool,
+                              size_t                      nthreads,
+                              pool_iter_blocks_callback_t callback,
+                              void *const                *user_data) {
+    if (nthreads == 0)
+        nthreads = 1;
+
+    pool_iter_range_data_t data[nthreads];
+    void                  *data_pointers[nthreads];
+    for (size_t i = 0; i < nthreads; ++i) {
+        data[i] = (pool_iter_range_data_t){.pool      = pool,
+                                           .callback  = callback,
+                                           .user_data = user_data[i]};
+        data_pointers[i] = &data[i];
+    }
+
+    const size_t nblocks = pool->blocks->len + pool->single_use_blocks->len;
+    return parallel_for(nblocks, nthreads, __pool_iter_range_callback, data_pointers);
+}
+
+int pool_iter_pointers_parallel(const pool_t                 *pool,
+                                size_t                        nthreads,
+                                pool_iter_pointers_callback_t callback,
+                                void *const                  *user_data) {
+    if (nthreads == 0)
+        nthreads = 1;
+
+    pool_iter_pointers_data_t data[nthreads];
+    void                     *data_pointers[nthreads];
+    for (size_t i = 0; i < nthreads; ++i) {
+        data[i] = (pool_iter_pointers_data_t){.callback  = callback,
+                                              .user_data = user_data[i],
+                                              .item_size = pool->item_size};
+        data_pointers[i] = &data[i];
+    }
+
+    return pool_iter_blocks_parallel(pool, nthreads, __pool_iter_pointers_callback, data_pointers);
+}
+
 void pool_empty(pool_t *pool) {
-    g_ptr_array_set_size(pool->blocks, 1);
-    pool->top_block_used = 0;
-    pool->can_iterate    = 1;
+    __pool_free_blocks(pool, pool->blocks, 1);
+    g_ptr_array_set_size(pool->single_use_blocks, 0);
+    g_array_set_size(pool->single_use_counts, 0);
+    g_array_set_size(pool->block_used, 0);
+    pool->single_use_bytes = 0;
+    pool->top_block_used   = 0;
+}
+
+void pool_shrink_to_fit(pool_t *pool) {
+    __pool_free_blocks(pool, pool->spare_blocks, 0);
+
+    block_allocator_release_unused(pool->policy,
+                                   g_ptr_array_index(pool->blocks, pool->blocks->len - 1),
+                                   pool->item_size * pool->block_capacity,
+                                   pool->item_size * pool->top_block_used);
+}
+
+size_t pool_get_memory_usage(const pool_t *pool) {
+    const size_t nblocks = pool->blocks->len + pool->spare_blocks->len;
+    const size_t nptrs   = nblocks + pool->single_use_blocks->len;
+    const size_t ncounts = pool->block_used->len + pool->single_use_counts->len;
+
+    return sizeof(pool_t) + nptrs * sizeof(gpointer) + ncounts * sizeof(size_t) +
+           nblocks * block_allocator_get_size(pool->policy,
+                                              pool->item_size * pool->block_capacity) +
+           pool->single_use_bytes;
 }
 
 void pool_free(pool_t *pool) {
+    __pool_free_blocks(pool, pool->blocks, 0);
+    __pool_free_blocks(pool, pool->spare_blocks, 0);
     g_ptr_array_unref(pool->blocks);
+    g_ptr_array_unref(pool->spare_blocks);
+    g_ptr_array_unref(pool->single_use_blocks);
+    g_array_unref(pool->single_use_counts);
+    g_array_unref(pool->block_used);
     free(pool);
 }
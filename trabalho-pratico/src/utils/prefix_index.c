@@ -0,0 +1,170 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  prefix_index.c
+ * @brief Implementation of methods in include/utils/prefix_index.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref prefix_index_examples).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/prefix_index.h"
+#include "utils/string_pool.h"
+
+/**
+ * @struct prefix_index
+ * @brief  A sorted set of strings, that can be searched by prefix.
+ *
+ * @var prefix_index::strings
+ *     @brief Array of ::prefix_index::length strings, sorted after ::prefix_index_build.
+ * @var prefix_index::length
+ *     @brief Number of elements in ::prefix_index::strings.
+ * @var prefix_index::capacity
+ *     @brief Number of elements ::prefix_index::strings can hold before needing to grow.
+ * @var prefix_index::copies
+ *     @brief Where strings copied by ::prefix_index_add_copy are allocated. `NULL` until needed.
+ */
+struct prefix_index {
+    const char   **strings;
+    size_t         length, capacity;
+    string_pool_t *copies;
+};
+
+/** @brief Initial capacity of ::prefix_index::strings. */
+#define PREFIX_INDEX_INITIAL_CAPACITY 64
+
+/** @brief Number of characters in each block of ::prefix_index::copies. */
+#define PREFIX_INDEX_COPIES_BLOCK_CAPACITY 4096
+
+prefix_index_t *prefix_index_create(void) {
+    prefix_index_t *const index = malloc(sizeof(prefix_index_t));
+    if (!index)
+        return NULL;
+
+    index->strings  = NULL;
+    index->length   = 0;
+    index->capacity = 0;
+    index->copies   = NULL;
+    return index;
+}
+
+int prefix_index_add(prefix_index_t *index, const char *str) {
+    if (index->length == index->capacity) {
+        const size_t new_capacity =
+            index->capacity ? index->capacity * 2 : PREFIX_INDEX_INITIAL_CAPACITY;
+        const char **const new_strings = realloc(index->strings, new_capacity * sizeof(char *));
+        if (!new_strings)
+            return 1;
+
+        index->strings  = new_strings;
+        index->capacity = new_capacity;
+    }
+
+    index->strings[index->length++] = str;
+    return 0;
+}
+
+int prefix_index_add_copy(prefix_index_t *index, const char *str) {
+    if (!index->copies) {
+        index->copies = string_pool_create(PREFIX_INDEX_COPIES_BLOCK_CAPACITY);
+        if (!index->copies)
+            return 1;
+    }
+
+    /* On failure, the copy is left unused in the pool */
+    const char *const copy = string_pool_put(index->copies, str);
+    return !copy || prefix_index_add(index, copy);
+}
+
+/**
+ * @brief Comparison function for sorting strings in ::prefix_index::strings.
+ *
+ * @param a A pointer to a string.
+ * @param b A pointer to a string.
+ *
+ * @return The comparison result between @p a and @p b.
+ */
+int __prefix_index_compare(const void *a, const void *b) {
+    return strcmp(*(const char *const *) a, *(const char *const *) b);
+}
+
+void prefix_index_build(prefix_index_t *index) {
+    if (!index->length)
+        return;
+
+    qsort(index->strings, index->length, sizeof(char *), __prefix_index_compare);
+
+    size_t unique = 1;
+    for (size_t i = 1; i < index->length; ++i)
+        if (strcmp(index->strings[i], index->strings[unique - 1]))
+            index->strings[unique++] = index->strings[i];
+    index->length = unique;
+}
+
+int prefix_index_iter_prefix(const prefix_index_t        *index,
+                             const char                  *prefix,
+                             prefix_index_iter_callback_t callback,
+                             void                        *user_data) {
+
+    /* First string that isn't lower than the prefix */
+    size_t begin = 0, end = index->length;
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+        if (strcmp(index->strings[middle], prefix) < 0)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+
+    /* First string after begin that doesn't start with the prefix */
+    const size_t prefix_length = strlen(prefix);
+    end                        = index->length;
+    for (size_t low = begin; low < end;) {
+        const size_t middle = low + (end - low) / 2;
+        if (strncmp(index->strings[middle], prefix, prefix_length) > 0)
+            end = middle;
+        else
+            low = middle + 1;
+    }
+
+    int retval = 0;
+    for (size_t i = begin; i < end && !retval; ++i)
+        retval = callback(user_data, index->strings[i]);
+    return retval;
+}
+
+size_t prefix_index_get_length(const prefix_index_t *index) {
+    return index->length;
+}
+
+size_t prefix_index_get_memory_usage(const prefix_index_t *index) {
+    size_t total = sizeof(prefix_index_t) + index->capacity * sizeof(char *);
+    if (index->copies)
+        total += string_pool_get_memory_usage(index->copies);
+    return total;
+}
+
+void prefix_index_free(prefix_index_t *index) {
+    if (index->copies)
+        string_pool_free(index->copies);
+    free(index->strings);
+    free(index);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  radix_sort.c
+ * @brief Implementation of methods in include/utils/radix_sort.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref radix_sort_examples).
+ */
+
+#include <string.h>
+
+#include "utils/radix_sort.h"
+
+/** @brief Number of bits in each digit of a ::radix_sort_item_t::key. */
+#define RADIX_SORT_DIGIT_BITS 8
+
+/** @brief Number of possible values of each digit of a ::radix_sort_item_t::key. */
+#define RADIX_SORT_BUCKETS (1 << RADIX_SORT_DIGIT_BITS)
+
+/** @brief Number of digits in a ::radix_sort_item_t::key. */
+#define RADIX_SORT_DIGITS (64 / RADIX_SORT_DIGIT_BITS)
+
+void radix_sort(radix_sort_item_t *items, radix_sort_item_t *tmp, size_t n) {
+    /* The histograms of all digits are built in a single pass through the items */
+    size_t counts[RADIX_SORT_DIGITS][RADIX_SORT_BUCKETS] = {0};
+    for (size_t i = 0; i < n; ++i)
+        for (size_t d = 0; d < RADIX_SORT_DIGITS; ++d)
+            counts[d][(items[i].key >> (d * RADIX_SORT_DIGIT_BITS)) & (RADIX_SORT_BUCKETS - 1)]++;
+
+    radix_sort_item_t *from = items, *to = tmp;
+    for (size_t d = 0; d < RADIX_SORT_DIGITS; ++d) {
+        const size_t shift = d * RADIX_SORT_DIGIT_BITS;
+
+        /* A digit that's the same in all keys wouldn't move any item */
+        if (n == 0 || counts[d][(from[0].key >> shift) & (RADIX_SORT_BUCKETS - 1)] == n)
+            continue;
+
+        size_t offset = 0;
+        for (size_t b = 0; b < RADIX_SORT_BUCKETS; ++b) {
+            const size_t count = counts[d][b];
+            counts[d][b]       = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            to[counts[d][(from[i].key >> shift) & (RADIX_SORT_BUCKETS - 1)]++] = from[i];
+
+        radix_sort_item_t *const swap = from;
+        from                          = to;
+        to                            = swap;
+    }
+
+    if (from != items)
+        memcpy(items, from, sizeof(radix_sort_item_t) * n);
+}
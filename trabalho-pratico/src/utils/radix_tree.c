@@ -0,0 +1,943 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  radix_tree.c
+ * @brief Implementation of methods in include/utils/radix_tree.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref radix_tree_examples).
+ */
+
+/** @cond FALSE */
+#if defined(__SSE2__) && defined(__GNUC__)
+    #include <emmintrin.h>
+#endif
+/** @endcond */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/int_utils.h"
+#include "utils/pool.h"
+#include "utils/radix_tree.h"
+
+/** @brief Kind of inner node of a ::radix_tree_t, by how many children it can hold. */
+typedef enum {
+    RADIX_TREE_NODE_4,  /**< @brief A ::radix_tree_node_4_t. */
+    RADIX_TREE_NODE_16, /**< @brief A ::radix_tree_node_16_t. */
+    RADIX_TREE_NODE_48, /**< @brief A ::radix_tree_node_48_t. */
+    RADIX_TREE_NODE_256 /**< @brief A ::radix_tree_node_256_t. */
+} radix_tree_node_type_t;
+
+/** @brief Maximum number of bytes of a compressed path stored in a ::radix_tree_node_t. */
+#define RADIX_TREE_MAX_PREFIX_LENGTH 10
+
+/**
+ * @struct  radix_tree_node_t
+ * @brief   Header common to all inner nodes of a ::radix_tree_t.
+ * @details Children are either inner nodes or leaves (::radix_tree_leaf_t), told apart by the
+ *          lowest bit of their pointers (set for leaves).
+ *
+ * @var radix_tree_node_t::type
+ *     @brief Kind of node (a ::radix_tree_node_type_t).
+ * @var radix_tree_node_t::nchildren
+ *     @brief Number of children of the node.
+ * @var radix_tree_node_t::prefix_length
+ *     @brief Number of bytes shared by all keys below this node, after the byte that led to it.
+ * @var radix_tree_node_t::prefix
+ *     @brief   First bytes of the prefix of ::radix_tree_node_t::prefix_length bytes.
+ *     @details When the prefix is longer than ::RADIX_TREE_MAX_PREFIX_LENGTH, the remaining bytes
+ *              are read from any leaf below this node.
+ */
+typedef struct {
+    uint8_t  type;
+    uint16_t nchildren;
+    uint32_t prefix_length;
+    uint8_t  prefix[RADIX_TREE_MAX_PREFIX_LENGTH];
+} radix_tree_node_t;
+
+/**
+ * @struct radix_tree_node_4_t
+ * @brief  An inner node with up to 4 children, sorted by key byte.
+ *
+ * @var radix_tree_node_4_t::header
+ *     @brief Header common to all nodes.
+ * @var radix_tree_node_4_t::keys
+ *     @brief Byte that leads to each child, in ascending order.
+ * @var radix_tree_node_4_t::children
+ *     @brief Children of the node, in the same order as ::radix_tree_node_4_t::keys.
+ */
+typedef struct {
+    radix_tree_node_t header;
+    uint8_t           keys[4];
+    void             *children[4];
+} radix_tree_node_4_t;
+
+/**
+ * @struct radix_tree_node_16_t
+ * @brief  An inner node with up to 16 children, sorted by key byte.
+ *
+ * @var radix_tree_node_16_t::header
+ *     @brief Header common to all nodes.
+ * @var radix_tree_node_16_t::keys
+ *     @brief Byte that leads to each child, in ascending order (compared all at once with SSE2).
+ * @var radix_tree_node_16_t::children
+ *     @brief Children of the node, in the same order as ::radix_tree_node_16_t::keys.
+ */
+typedef struct {
+    radix_tree_node_t header;
+    uint8_t           keys[16];
+    void             *children[16];
+} radix_tree_node_16_t;
+
+/**
+ * @struct radix_tree_node_48_t
+ * @brief  An inner node with up to 48 children, indexed by key byte.
+ *
+ * @var radix_tree_node_48_t::header
+ *     @brief Header common to all nodes.
+ * @var radix_tree_node_48_t::indices
+ *     @brief Index (plus one) in ::radix_tree_node_48_t::children of the child of every byte, or
+ *            `0` for bytes without a child.
+ * @var radix_tree_node_48_t::children
+ *     @brief Children of the node, in insertion order.
+ */
+typedef struct {
+    radix_tree_node_t header;
+    uint8_t           indices[256];
+    void             *children[48];
+} radix_tree_node_48_t;
+
+/**
+ * @struct radix_tree_node_256_t
+ * @brief  An inner node with a child (or `NULL`) for every byte.
+ *
+ * @var radix_tree_node_256_t::header
+ *     @brief Header common to all nodes.
+ * @var radix_tree_node_256_t::children
+ *     @brief Child of every byte, or `NULL`.
+ */
+typedef struct {
+    radix_tree_node_t header;
+    void             *children[256];
+} radix_tree_node_256_t;
+
+/**
+ * @struct radix_tree_leaf_t
+ * @brief  A key in a ::radix_tree_t, and its value.
+ *
+ * @var radix_tree_leaf_t::key
+ *     @brief Key, not owned by the tree.
+ * @var radix_tree_leaf_t::value
+ *     @brief Value associated with ::radix_tree_leaf_t::key.
+ */
+typedef struct {
+    const char *key;
+    void       *value;
+} radix_tree_leaf_t;
+
+/**
+ * @struct radix_tree
+ * @brief  An adaptive radix tree that maps strings to values.
+ *
+ * @var radix_tree::root
+ *     @brief Root of the tree (an inner node or a leaf), or `NULL` if the tree is empty.
+ * @var radix_tree::leaves
+ *     @brief Allocator for leaves (::radix_tree_leaf_t).
+ * @var radix_tree::length
+ *     @brief Number of keys in the tree.
+ * @var radix_tree::nodes_size
+ *     @brief Number of bytes allocated for inner nodes.
+ */
+struct radix_tree {
+    void   *root;
+    pool_t *leaves;
+    size_t  length;
+    size_t  nodes_size;
+};
+
+/** @brief Number of leaves in each block of ::radix_tree::leaves. */
+#define RADIX_TREE_LEAVES_POOL_BLOCK_CAPACITY 4096
+
+radix_tree_t *radix_tree_create(void) {
+    radix_tree_t *const tree = malloc(sizeof(radix_tree_t));
+    if (!tree)
+        return NULL;
+
+    tree->leaves = pool_create(radix_tree_leaf_t, RADIX_TREE_LEAVES_POOL_BLOCK_CAPACITY);
+    if (!tree->leaves) {
+        free(tree);
+        return NULL;
+    }
+
+    tree->root       = NULL;
+    tree->length     = 0;
+    tree->nodes_size = 0;
+    return tree;
+}
+
+/**
+ * @brief  Checks if a child of a node is a leaf.
+ * @param  child Child of a node (or the root of a tree).
+ * @return Whether @p child is a tagged pointer to a ::radix_tree_leaf_t.
+ */
+int __radix_tree_is_leaf(const void *child) {
+    return (uintptr_t) child & 1;
+}
+
+/**
+ * @brief  Gets the leaf a tagged child pointer refers to.
+ * @param  child Child of a node for which ::__radix_tree_is_leaf is true.
+ * @return The leaf @p child points to.
+ */
+radix_tree_leaf_t *__radix_tree_get_leaf(const void *child) {
+    return (radix_tree_leaf_t *) ((uintptr_t) child & ~(uintptr_t) 1);
+}
+
+/**
+ * @brief  Gets the size of a kind of node.
+ * @param  type Kind of node.
+ * @return The number of bytes of a node of type @p type.
+ */
+size_t __radix_tree_node_size(radix_tree_node_type_t type) {
+    switch (type) {
+        case RADIX_TREE_NODE_4:
+            return sizeof(radix_tree_node_4_t);
+        case RADIX_TREE_NODE_16:
+            return sizeof(radix_tree_node_16_t);
+        case RADIX_TREE_NODE_48:
+            return sizeof(radix_tree_node_48_t);
+        case RADIX_TREE_NODE_256:
+        default:
+            return sizeof(radix_tree_node_256_t);
+    }
+}
+
+/**
+ * @brief Allocates a new inner node without children.
+ *
+ * @param tree Tree the node will belong to.
+ * @param type Kind of node to allocate.
+ *
+ * @return The new node, or `NULL` on allocation failure.
+ */
+radix_tree_node_t *__radix_tree_create_node(radix_tree_t *tree, radix_tree_node_type_t type) {
+    const size_t             size = __radix_tree_node_size(type);
+    radix_tree_node_t *const node = calloc(1, size);
+    if (!node)
+        return NULL;
+
+    node->type        = type;
+    tree->nodes_size += size;
+    return node;
+}
+
+/**
+ * @brief Frees an inner node, but not its children.
+ *
+ * @param tree Tree the node belongs to.
+ * @param node Node to be `free`d.
+ */
+void __radix_tree_free_node(radix_tree_t *tree, radix_tree_node_t *node) {
+    tree->nodes_size -= __radix_tree_node_size(node->type);
+    free(node);
+}
+
+/**
+ * @brief Allocates a new leaf.
+ *
+ * @param tree  Tree the leaf will belong to.
+ * @param key   Key of the leaf.
+ * @param value Value of the leaf.
+ *
+ * @return A tagged pointer to the new leaf (to be stored as a child), or `NULL` on allocation
+ *         failure.
+ */
+void *__radix_tree_create_leaf(radix_tree_t *tree, const char *key, void *value) {
+    radix_tree_leaf_t *const leaf = pool_alloc_item(radix_tree_leaf_t, tree->leaves);
+    if (!leaf)
+        return NULL;
+
+    leaf->key   = key;
+    leaf->value = value;
+    return (void *) ((uintptr_t) leaf | 1);
+}
+
+/**
+ * @brief   Finds the position of a byte among the sorted keys of a ::radix_tree_node_16_t.
+ * @details Auxiliary method for ::__radix_tree_find_child.
+ *
+ * @param node Node to search in.
+ * @param byte Byte to look for.
+ *
+ * @return The index of @p byte in ::radix_tree_node_16_t::keys, or `SIZE_MAX` if it's not there.
+ */
+size_t __radix_tree_node_16_find(const radix_tree_node_16_t *node, uint8_t byte) {
+#if defined(__SSE2__) && defined(__GNUC__)
+    const __m128i keys    = _mm_loadu_si128((const __m128i *) node->keys);
+    const __m128i matches = _mm_cmpeq_epi8(keys, _mm_set1_epi8((char) byte));
+    const uint32_t mask =
+        (uint32_t) _mm_movemask_epi8(matches) & ((1u << node->header.nchildren) - 1);
+    return mask ? (size_t) __builtin_ctz(mask) : SIZE_MAX;
+#else
+    for (size_t i = 0; i < node->header.nchildren; ++i)
+        if (node->keys[i] == byte)
+            return i;
+    return SIZE_MAX;
+#endif
+}
+
+/**
+ * @brief Finds where the child of a node for a given byte is stored.
+ *
+ * @param node Inner node to search in.
+ * @param byte Byte that leads to the child.
+ *
+ * @return A pointer to the child pointer, or `NULL` if @p node has no child for @p byte.
+ */
+void **__radix_tree_find_child(radix_tree_node_t *node, uint8_t byte) {
+    switch (node->type) {
+        case RADIX_TREE_NODE_4: {
+            radix_tree_node_4_t *const node_4 = (radix_tree_node_4_t *) node;
+            for (size_t i = 0; i < node->nchildren; ++i)
+                if (node_4->keys[i] == byte)
+                    return &node_4->children[i];
+            return NULL;
+        }
+        case RADIX_TREE_NODE_16: {
+            radix_tree_node_16_t *const node_16 = (radix_tree_node_16_t *) node;
+            const size_t                i       = __radix_tree_node_16_find(node_16, byte);
+            return i == SIZE_MAX ? NULL : &node_16->children[i];
+        }
+        case RADIX_TREE_NODE_48: {
+            radix_tree_node_48_t *const node_48 = (radix_tree_node_48_t *) node;
+            const uint8_t               i       = node_48->indices[byte];
+            return i ? &node_48->children[i - 1] : NULL;
+        }
+        case RADIX_TREE_NODE_256: {
+            radix_tree_node_256_t *const node_256 = (radix_tree_node_256_t *) node;
+            return node_256->children[byte] ? &node_256->children[byte] : NULL;
+        }
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * @brief   Gets the leaf with the lowest key below a node.
+ * @details Used to read the parts of compressed paths not stored in nodes.
+ *
+ * @param child Inner node or tagged leaf.
+ *
+ * @return The leaf with the lowest key below @p child.
+ */
+const radix_tree_leaf_t *__radix_tree_minimum(const void *child) {
+    while (!__radix_tree_is_leaf(child)) {
+        const radix_tree_node_t *const node = child;
+        switch (node->type) {
+            case RADIX_TREE_NODE_4:
+                child = ((const radix_tree_node_4_t *) node)->children[0];
+                break;
+            case RADIX_TREE_NODE_16:
+                child = ((const radix_tree_node_16_t *) node)->children[0];
+                break;
+            case RADIX_TREE_NODE_48: {
+                const radix_tree_node_48_t *const node_48 = (const radix_tree_node_48_t *) node;
+
+                size_t byte = 0;
+                while (!node_48->indices[byte])
+                    byte++;
+                child = node_48->children[node_48->indices[byte] - 1];
+                break;
+            }
+            case RADIX_TREE_NODE_256:
+            default: {
+                const radix_tree_node_256_t *const node_256 = (const radix_tree_node_256_t *) node;
+
+                size_t byte = 0;
+                while (!node_256->children[byte])
+                    byte++;
+                child = node_256->children[byte];
+                break;
+            }
+        }
+    }
+    return __radix_tree_get_leaf(child);
+}
+
+/**
+ * @brief Counts how many bytes of the compressed path of a node a key matches.
+ *
+ * @param node   Inner node whose prefix is compared.
+ * @param key    Key to compare.
+ * @param length Number of bytes in @p key that can be compared (including the terminator).
+ * @param depth  Index of the first byte of @p key to be compared with the prefix of @p node.
+ *
+ * @return The number of matching bytes, up to ::radix_tree_node_t::prefix_length.
+ */
+size_t __radix_tree_prefix_mismatch(const radix_tree_node_t *node,
+                                    const char              *key,
+                                    size_t                   length,
+                                    size_t                   depth) {
+
+    const size_t stored = min(node->prefix_length, RADIX_TREE_MAX_PREFIX_LENGTH);
+
+    size_t i = 0;
+    for (; i < stored && depth + i < length; ++i)
+        if (node->prefix[i] != (uint8_t) key[depth + i])
+            return i;
+
+    if (i == stored && node->prefix_length > stored) {
+        const char *const leaf_key = __radix_tree_minimum(node)->key;
+        for (; i < node->prefix_length && depth + i < length; ++i)
+            if (leaf_key[depth + i] != key[depth + i])
+                return i;
+    }
+    return i;
+}
+
+/**
+ * @brief Copies an inner node to a larger kind of node, and frees the original.
+ *
+ * @param tree Tree the node belongs to.
+ * @param node Full node to be grown (not a ::radix_tree_node_256_t).
+ *
+ * @return The new node, or `NULL` on allocation failure (@p node is left unchanged).
+ */
+radix_tree_node_t *__radix_tree_grow_node(radix_tree_t *tree, radix_tree_node_t *node) {
+    radix_tree_node_t *const grown = __radix_tree_create_node(tree, node->type + 1);
+    if (!grown)
+        return NULL;
+
+    grown->nchildren     = node->nchildren;
+    grown->prefix_length = node->prefix_length;
+    memcpy(grown->prefix, node->prefix, sizeof(node->prefix));
+
+    switch (node->type) {
+        case RADIX_TREE_NODE_4: {
+            const radix_tree_node_4_t *const old = (const radix_tree_node_4_t *) node;
+            radix_tree_node_16_t *const      new = (radix_tree_node_16_t *) grown;
+            memcpy(new->keys, old->keys, sizeof(old->keys));
+            memcpy(new->children, old->children, sizeof(old->children));
+            break;
+        }
+        case RADIX_TREE_NODE_16: {
+            const radix_tree_node_16_t *const old = (const radix_tree_node_16_t *) node;
+            radix_tree_node_48_t *const       new = (radix_tree_node_48_t *) grown;
+            for (size_t i = 0; i < node->nchildren; ++i) {
+                new->indices[old->keys[i]] = i + 1;
+                new->children[i]           = old->children[i];
+            }
+            break;
+        }
+        case RADIX_TREE_NODE_48:
+        default: {
+            const radix_tree_node_48_t *const old = (const radix_tree_node_48_t *) node;
+            radix_tree_node_256_t *const      new = (radix_tree_node_256_t *) grown;
+            for (size_t byte = 0; byte < 256; ++byte)
+                if (old->indices[byte])
+                    new->children[byte] = old->children[old->indices[byte] - 1];
+            break;
+        }
+    }
+
+    __radix_tree_free_node(tree, node);
+    return grown;
+}
+
+/**
+ * @brief   Adds a child to an inner node, growing the node if it's full.
+ * @details @p byte mustn't already lead to a child of @p node.
+ *
+ * @param tree  Tree the node belongs to.
+ * @param ref   Where the pointer to @p node is stored, updated if the node grows.
+ * @param byte  Byte that will lead to @p child.
+ * @param child Child (inner node or tagged leaf) to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (the node is left unchanged).
+ */
+int __radix_tree_add_child(radix_tree_t *tree, void **ref, uint8_t byte, void *child) {
+    radix_tree_node_t *node = *ref;
+
+    const size_t capacities[4] = {4, 16, 48, 256};
+    if (node->nchildren == capacities[node->type]) {
+        node = __radix_tree_grow_node(tree, node);
+        if (!node)
+            return 1;
+        *ref = node;
+    }
+
+    switch (node->type) {
+        case RADIX_TREE_NODE_4:
+        case RADIX_TREE_NODE_16: {
+            uint8_t *keys;
+            void   **children;
+            if (node->type == RADIX_TREE_NODE_4) {
+                keys     = ((radix_tree_node_4_t *) node)->keys;
+                children = ((radix_tree_node_4_t *) node)->children;
+            } else {
+                keys     = ((radix_tree_node_16_t *) node)->keys;
+                children = ((radix_tree_node_16_t *) node)->children;
+            }
+
+            /* Keep children sorted, for iterations in order */
+            size_t position = 0;
+            while (position < node->nchildren && keys[position] < byte)
+                position++;
+
+            const size_t after = node->nchildren - position;
+            memmove(keys + position + 1, keys + position, after);
+            memmove(children + position + 1, children + position, after * sizeof(void *));
+            keys[position]     = byte;
+            children[position] = child;
+            break;
+        }
+        case RADIX_TREE_NODE_48: {
+            radix_tree_node_48_t *const node_48 = (radix_tree_node_48_t *) node;
+            node_48->children[node->nchildren] = child;
+            node_48->indices[byte]             = node->nchildren + 1;
+            break;
+        }
+        case RADIX_TREE_NODE_256:
+        default:
+            ((radix_tree_node_256_t *) node)->children[byte] = child;
+            break;
+    }
+
+    node->nchildren++;
+    return 0;
+}
+
+/**
+ * @brief   Creates a node with two children, to replace an existing child that shares only part
+ *          of its path with a new key.
+ * @details Auxiliary method for ::__radix_tree_insert.
+ *
+ * @param tree           Tree the nodes belong to.
+ * @param key            Key being inserted.
+ * @param depth          Index of the first byte of @p key in the new node's prefix.
+ * @param prefix_length  Number of bytes shared by @p key and the keys below @p existing, from
+ *                       @p depth.
+ * @param existing       Child being replaced.
+ * @param existing_byte  Byte that will lead to @p existing in the new node.
+ * @param leaf           Tagged leaf of @p key.
+ *
+ * @return The new node, or `NULL` on allocation failure.
+ */
+radix_tree_node_t *__radix_tree_split(radix_tree_t *tree,
+                                      const char   *key,
+                                      size_t        depth,
+                                      size_t        prefix_length,
+                                      void         *existing,
+                                      uint8_t       existing_byte,
+                                      void         *leaf) {
+
+    radix_tree_node_4_t *const node =
+        (radix_tree_node_4_t *) __radix_tree_create_node(tree, RADIX_TREE_NODE_4);
+    if (!node)
+        return NULL;
+
+    node->header.prefix_length = prefix_length;
+    memcpy(node->header.prefix, key + depth, min(prefix_length, RADIX_TREE_MAX_PREFIX_LENGTH));
+
+    /* Two different bytes, so no sorting is needed */
+    const uint8_t key_byte = (uint8_t) key[depth + prefix_length];
+    const int     after    = key_byte > existing_byte;
+    node->keys[!after]     = existing_byte;
+    node->children[!after] = existing;
+    node->keys[after]      = key_byte;
+    node->children[after]  = leaf;
+    node->header.nchildren = 2;
+    return &node->header;
+}
+
+/**
+ * @brief Inserts a key below a child of a tree.
+ *
+ * @param tree   Tree to be modified.
+ * @param ref    Where the child to insert the key under is stored.
+ * @param key    Key to be inserted.
+ * @param length Number of bytes in @p key, including the terminator.
+ * @param depth  Number of bytes of @p key already consumed to reach @p ref.
+ * @param value  Value to associate with @p key.
+ *
+ * @retval 0 Success (@p key wasn't in @p tree).
+ * @retval 1 Allocation failure.
+ * @retval 2 Success (@p key was in @p tree, and its value was replaced).
+ */
+int __radix_tree_insert(radix_tree_t *tree,
+                        void        **ref,
+                        const char   *key,
+                        size_t        length,
+                        size_t        depth,
+                        void         *value) {
+
+    while (*ref && !__radix_tree_is_leaf(*ref)) {
+        radix_tree_node_t *const node = *ref;
+
+        if (node->prefix_length) {
+            const size_t matched = __radix_tree_prefix_mismatch(node, key, length, depth);
+            if (matched < node->prefix_length) {
+                /* The key diverges from this node's path: split the path at the divergence */
+                uint8_t existing_byte;
+                if (node->prefix_length <= RADIX_TREE_MAX_PREFIX_LENGTH) {
+                    existing_byte = node->prefix[matched];
+                } else {
+                    existing_byte = (uint8_t) __radix_tree_minimum(node)->key[depth + matched];
+                }
+
+                void *const leaf = __radix_tree_create_leaf(tree, key, value);
+                if (!leaf)
+                    return 1;
+                radix_tree_node_t *const split =
+                    __radix_tree_split(tree, key, depth, matched, node, existing_byte, leaf);
+                if (!split)
+                    return 1;
+
+                /* Remove the split part from the path of the existing node */
+                const size_t remaining = node->prefix_length - matched - 1;
+                if (node->prefix_length <= RADIX_TREE_MAX_PREFIX_LENGTH) {
+                    memmove(node->prefix, node->prefix + matched + 1, remaining);
+                } else {
+                    const char *const leaf_key = __radix_tree_minimum(node)->key;
+                    memcpy(node->prefix,
+                           leaf_key + depth + matched + 1,
+                           min(remaining, RADIX_TREE_MAX_PREFIX_LENGTH));
+                }
+                node->prefix_length = remaining;
+
+                *ref = split;
+                tree->length++;
+                return 0;
+            }
+            depth += node->prefix_length;
+        }
+
+        void **const child = __radix_tree_find_child(node, (uint8_t) key[depth]);
+        if (!child) {
+            void *const leaf = __radix_tree_create_leaf(tree, key, value);
+            if (!leaf || __radix_tree_add_child(tree, ref, (uint8_t) key[depth], leaf))
+                return 1;
+
+            tree->length++;
+            return 0;
+        }
+
+        ref = child;
+        depth++;
+    }
+
+    if (!*ref) {
+        void *const leaf = __radix_tree_create_leaf(tree, key, value);
+        if (!leaf)
+            return 1;
+
+        *ref = leaf;
+        tree->length++;
+        return 0;
+    }
+
+    radix_tree_leaf_t *const existing = __radix_tree_get_leaf(*ref);
+    if (!strcmp(existing->key, key)) {
+        existing->key   = key; /* The old key may not outlive its value */
+        existing->value = value;
+        return 2;
+    }
+
+    /* Two different keys: they differ at or before the terminator of the shortest */
+    size_t common = 0;
+    while (key[depth + common] == existing->key[depth + common])
+        common++;
+
+    void *const leaf = __radix_tree_create_leaf(tree, key, value);
+    if (!leaf)
+        return 1;
+    radix_tree_node_t *const split =
+        __radix_tree_split(tree,
+                           key,
+                           depth,
+                           common,
+                           *ref,
+                           (uint8_t) existing->key[depth + common],
+                           leaf);
+    if (!split)
+        return 1;
+
+    *ref = split;
+    tree->length++;
+    return 0;
+}
+
+int radix_tree_insert(radix_tree_t *tree, const char *key, void *value) {
+    /* The terminator is part of the key, so that no key is a prefix of another */
+    return __radix_tree_insert(tree, &tree->root, key, strlen(key) + 1, 0, value);
+}
+
+void *radix_tree_lookup(const radix_tree_t *tree, const char *key) {
+    const size_t length = strlen(key) + 1;
+    void        *child  = tree->root;
+    size_t       depth  = 0;
+
+    while (child && !__radix_tree_is_leaf(child)) {
+        radix_tree_node_t *const node = child;
+
+        /* Only stored prefix bytes are checked: the leaf is compared with the whole key */
+        const size_t stored = min(node->prefix_length, RADIX_TREE_MAX_PREFIX_LENGTH);
+        for (size_t i = 0; i < stored; ++i)
+            if (depth + i >= length || node->prefix[i] != (uint8_t) key[depth + i])
+                return NULL;
+
+        depth += node->prefix_length;
+        if (depth >= length)
+            return NULL;
+
+        void *const *const next = __radix_tree_find_child(node, (uint8_t) key[depth]);
+        child                   = next ? *next : NULL;
+        depth++;
+    }
+
+    if (!child)
+        return NULL;
+
+    const radix_tree_leaf_t *const leaf = __radix_tree_get_leaf(child);
+    return strcmp(leaf->key, key) ? NULL : leaf->value;
+}
+
+/**
+ * @brief   Compares the compressed path of a node with the respective bytes of a key.
+ * @details Auxiliary method for ::__radix_tree_iter_from.
+ *
+ * @param node  Inner node whose prefix is compared.
+ * @param key   Key to compare.
+ * @param depth Index of the first byte of @p key to be compared with the prefix of @p node.
+ *
+ * @return A negative value if all keys below @p node are lower than @p key, a positive value if
+ *         they're all greater, or `0` if the whole prefix matches.
+ */
+int __radix_tree_compare_prefix(const radix_tree_node_t *node, const char *key, size_t depth) {
+    const char *leaf_key = NULL;
+    for (size_t i = 0; i < node->prefix_length; ++i) {
+        uint8_t prefix_byte;
+        if (i < RADIX_TREE_MAX_PREFIX_LENGTH) {
+            prefix_byte = node->prefix[i];
+        } else {
+            if (!leaf_key)
+                leaf_key = __radix_tree_minimum(node)->key;
+            prefix_byte = (uint8_t) leaf_key[depth + i];
+        }
+
+        /* Prefixes never contain terminators, so key isn't read past its end */
+        const uint8_t key_byte = (uint8_t) key[depth + i];
+        if (prefix_byte != key_byte)
+            return prefix_byte < key_byte ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Iterates through the keys below a child of a tree, in byte order.
+ *
+ * @param child     Inner node or tagged leaf to iterate through.
+ * @param begin     Lower bound (inclusive) of the iterated keys, or `NULL` for all keys.
+ * @param depth     Number of bytes of keys consumed to reach @p child.
+ * @param callback  Method called for every key.
+ * @param user_data Pointer passed to every @p callback.
+ *
+ * @return The return value of the last-called @p callback (`0` if none was called).
+ */
+int __radix_tree_iter_from(void                      *child,
+                           const char                *begin,
+                           size_t                     depth,
+                           radix_tree_iter_callback_t callback,
+                           void                      *user_data) {
+
+    if (__radix_tree_is_leaf(child)) {
+        const radix_tree_leaf_t *const leaf = __radix_tree_get_leaf(child);
+        if (begin && strcmp(leaf->key, begin) < 0)
+            return 0;
+        return callback(user_data, leaf->key, leaf->value);
+    }
+
+    radix_tree_node_t *const node = child;
+    if (begin) {
+        const int comparison = __radix_tree_compare_prefix(node, begin, depth);
+        if (comparison < 0)
+            return 0;
+        else if (comparison > 0)
+            begin = NULL; /* Every key below is greater */
+    }
+    depth += node->prefix_length;
+
+    /* Children before the byte of begin are skipped, and only its own child is bounded */
+    const uint8_t first = begin ? (uint8_t) begin[depth] : 0;
+    int           retval;
+    switch (node->type) {
+        case RADIX_TREE_NODE_4:
+        case RADIX_TREE_NODE_16: {
+            const uint8_t *keys;
+            void *const   *children;
+            if (node->type == RADIX_TREE_NODE_4) {
+                keys     = ((radix_tree_node_4_t *) node)->keys;
+                children = ((radix_tree_node_4_t *) node)->children;
+            } else {
+                keys     = ((radix_tree_node_16_t *) node)->keys;
+                children = ((radix_tree_node_16_t *) node)->children;
+            }
+
+            for (size_t i = 0; i < node->nchildren; ++i) {
+                if (keys[i] < first)
+                    continue;
+
+                const char *const bound = keys[i] == first ? begin : NULL;
+                if ((retval = __radix_tree_iter_from(children[i], bound, depth + 1, callback,
+                                                     user_data)))
+                    return retval;
+            }
+            break;
+        }
+        case RADIX_TREE_NODE_48: {
+            radix_tree_node_48_t *const node_48 = (radix_tree_node_48_t *) node;
+            for (size_t byte = first; byte < 256; ++byte) {
+                if (!node_48->indices[byte])
+                    continue;
+
+                const char *const bound = byte == first ? begin : NULL;
+                if ((retval = __radix_tree_iter_from(node_48->children[node_48->indices[byte] - 1],
+                                                     bound,
+                                                     depth + 1,
+                                                     callback,
+                                                     user_data)))
+                    return retval;
+            }
+            break;
+        }
+        case RADIX_TREE_NODE_256:
+        default: {
+            radix_tree_node_256_t *const node_256 = (radix_tree_node_256_t *) node;
+            for (size_t byte = first; byte < 256; ++byte) {
+                if (!node_256->children[byte])
+                    continue;
+
+                const char *const bound = byte == first ? begin : NULL;
+                if ((retval = __radix_tree_iter_from(node_256->children[byte],
+                                                     bound,
+                                                     depth + 1,
+                                                     callback,
+                                                     user_data)))
+                    return retval;
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+int radix_tree_iter_prefix(const radix_tree_t        *tree,
+                           const char                *prefix,
+                           radix_tree_iter_callback_t callback,
+                           void                      *user_data) {
+
+    /* Unlike keys, the terminator of the prefix isn't matched */
+    const size_t length = strlen(prefix);
+    void        *child  = tree->root;
+    size_t       depth  = 0;
+
+    while (child && depth < length) {
+        if (__radix_tree_is_leaf(child)) {
+            const radix_tree_leaf_t *const leaf = __radix_tree_get_leaf(child);
+            return strncmp(leaf->key, prefix, length) ? 0
+                                                      : callback(user_data, leaf->key, leaf->value);
+        }
+
+        radix_tree_node_t *const node = child;
+        const size_t matched = __radix_tree_prefix_mismatch(node, prefix, length, depth);
+        if (matched < node->prefix_length) {
+            /* Either all keys below diverge from the prefix, or the prefix ends in the path */
+            if (depth + matched < length)
+                return 0;
+            break;
+        }
+
+        depth += node->prefix_length;
+        if (depth == length)
+            break;
+
+        void *const *const next = __radix_tree_find_child(node, (uint8_t) prefix[depth]);
+        child                   = next ? *next : NULL;
+        depth++;
+    }
+
+    return child ? __radix_tree_iter_from(child, NULL, depth, callback, user_data) : 0;
+}
+
+int radix_tree_iter_from(const radix_tree_t        *tree,
+                         const char                *begin,
+                         radix_tree_iter_callback_t callback,
+                         void                      *user_data) {
+
+    return tree->root ? __radix_tree_iter_from(tree->root, begin, 0, callback, user_data) : 0;
+}
+
+size_t radix_tree_get_length(const radix_tree_t *tree) {
+    return tree->length;
+}
+
+size_t radix_tree_get_memory_usage(const radix_tree_t *tree) {
+    return sizeof(radix_tree_t) + pool_get_memory_usage(tree->leaves) + tree->nodes_size;
+}
+
+/**
+ * @brief Frees an inner node and all inner nodes below it (leaves are freed with their pool).
+ *
+ * @param tree  Tree the nodes belong to.
+ * @param child Inner node or tagged leaf.
+ */
+void __radix_tree_free_below(radix_tree_t *tree, void *child) {
+    if (!child || __radix_tree_is_leaf(child))
+        return;
+
+    radix_tree_node_t *const node = child;
+    switch (node->type) {
+        case RADIX_TREE_NODE_4:
+            for (size_t i = 0; i < node->nchildren; ++i)
+                __radix_tree_free_below(tree, ((radix_tree_node_4_t *) node)->children[i]);
+            break;
+        case RADIX_TREE_NODE_16:
+            for (size_t i = 0; i < node->nchildren; ++i)
+                __radix_tree_free_below(tree, ((radix_tree_node_16_t *) node)->children[i]);
+            break;
+        case RADIX_TREE_NODE_48:
+            for (size_t i = 0; i < node->nchildren; ++i)
+                __radix_tree_free_below(tree, ((radix_tree_node_48_t *) node)->children[i]);
+            break;
+        case RADIX_TREE_NODE_256:
+        default:
+            for (size_t byte = 0; byte < 256; ++byte)
+                __radix_tree_free_below(tree, ((radix_tree_node_256_t *) node)->children[byte]);
+            break;
+    }
+    __radix_tree_free_node(tree, node);
+}
+
+void radix_tree_free(radix_tree_t *tree) {
+    __radix_tree_free_below(tree, tree->root);
+    pool_free(tree->leaves);
+    free(tree);
+}
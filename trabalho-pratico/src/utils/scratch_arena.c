@@ -0,0 +1,120 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  scratch_arena.c
+ * @brief Implementation of methods in include/utils/scratch_arena.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref scratch_arena_examples).
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "utils/pool.h"
+#include "utils/scratch_arena.h"
+
+/** @brief Number of items in each block of the pool of every arena (1 MiB on most platforms). */
+#define SCRATCH_ARENA_BLOCK_CAPACITY (1 << 16)
+
+/**
+ * @brief Unit of allocation in an arena, whose alignment is suitable for any type.
+ *
+ * @var scratch_arena_item_t::integer
+ *     @brief Largest integer type.
+ * @var scratch_arena_item_t::floating
+ *     @brief Largest floating point type.
+ * @var scratch_arena_item_t::pointer
+ *     @brief Pointer type.
+ */
+typedef union {
+    intmax_t    integer;
+    long double floating;
+    void       *pointer;
+} scratch_arena_item_t;
+
+/**
+ * @brief   Key of the thread-specific ::pool_t of every thread (`NULL` before its first use).
+ * @details Shall not be modified apart from its creation. This global variable is justified for
+ *          the following reasons:
+ *
+ *          -# It's not modified (no mutable global state). Each thread has its own value;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# Temporary data is allocated very deep inside queries, whose callbacks don't know
+ *             which thread is running them.
+ */
+pthread_key_t __scratch_arena_pool;
+
+/** @brief Whether ::__scratch_arena_pool was successfully created. */
+int __scratch_arena_has_pool = 0;
+
+/**
+ * @brief Frees the arena of a thread when it terminates.
+ * @param pool Arena of the thread, a ::pool_t.
+ */
+void __scratch_arena_pool_destroy(void *pool) {
+    pool_free(pool);
+}
+
+/** @brief Automatically creates ::__scratch_arena_pool when the program starts. */
+void __attribute__((constructor)) __scratch_arena_pool_create(void) {
+    __scratch_arena_has_pool =
+        !pthread_key_create(&__scratch_arena_pool, __scratch_arena_pool_destroy);
+}
+
+/**
+ * @brief   Automatically deletes ::__scratch_arena_pool when the program terminates.
+ * @details Key destructors aren't run for the main thread, so its arena is freed here.
+ */
+void __attribute__((destructor)) __scratch_arena_pool_delete(void) {
+    if (__scratch_arena_has_pool) {
+        pool_t *const pool = pthread_getspecific(__scratch_arena_pool);
+        if (pool)
+            pool_free(pool);
+        pthread_key_delete(__scratch_arena_pool);
+    }
+}
+
+void *scratch_arena_allocate(size_t size) {
+    if (!__scratch_arena_has_pool)
+        return NULL;
+
+    pool_t *pool = pthread_getspecific(__scratch_arena_pool);
+    if (!pool) {
+        pool = pool_create(scratch_arena_item_t, SCRATCH_ARENA_BLOCK_CAPACITY);
+        if (!pool)
+            return NULL;
+
+        if (pthread_setspecific(__scratch_arena_pool, pool)) {
+            pool_free(pool);
+            return NULL;
+        }
+    }
+
+    const size_t nitems = (size + sizeof(scratch_arena_item_t) - 1) / sizeof(scratch_arena_item_t);
+    return pool_alloc_items(scratch_arena_item_t, pool, nitems ? nitems : 1);
+}
+
+void scratch_arena_reset(void) {
+    if (!__scratch_arena_has_pool)
+        return;
+
+    pool_t *const pool = pthread_getspecific(__scratch_arena_pool);
+    if (pool)
+        pool_empty(pool);
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  string_dictionary.c
+ * @brief Implementation of methods in include/utils/string_dictionary.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref string_dictionary_examples).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/string_dictionary.h"
+#include "utils/string_pool.h"
+#include "utils/string_pool_no_duplicates.h"
+
+/**
+ * @struct string_dictionary_entry_t
+ * @brief  An entry (bucket) in the hash table of a ::string_dictionary_t.
+ *
+ * @var string_dictionary_entry_t::hash
+ *     @brief Cached hash of the string with code ::string_dictionary_entry_t::code.
+ * @var string_dictionary_entry_t::code
+ *     @brief Code of the string in this entry, plus one. `0` for empty entries.
+ */
+typedef struct {
+    uint32_t hash;
+    uint32_t code;
+} string_dictionary_entry_t;
+
+/**
+ * @struct  string_dictionary
+ * @brief   A dictionary that encodes strings as small integer codes.
+ * @details Strings are looked up in an open-addressed hash table with linear probing, whose
+ *          entries point to ::string_dictionary::by_code.
+ *
+ * @var string_dictionary::strings
+ *     @brief Pool where the strings are stored.
+ * @var string_dictionary::by_code
+ *     @brief Array of ::string_dictionary::length strings, indexed by code.
+ * @var string_dictionary::entries
+ *     @brief Array of ::string_dictionary::capacity entries, some of which are empty.
+ * @var string_dictionary::capacity
+ *     @brief Number of elements in ::string_dictionary::entries. Always a power of two.
+ * @var string_dictionary::length
+ *     @brief Number of strings in the dictionary.
+ */
+struct string_dictionary {
+    string_pool_t             *strings;
+    const char               **by_code;
+    string_dictionary_entry_t *entries;
+    size_t                     capacity, length;
+};
+
+/** @brief Initial number of entries in ::string_dictionary::entries. */
+#define STRING_DICTIONARY_INITIAL_CAPACITY 256
+
+/**
+ * @brief Maximum number of strings in a ::string_dictionary_t whose hash table has a given
+ *        capacity (maximum load factor of `1 / 2`).
+ */
+#define STRING_DICTIONARY_MAX_LOAD(capacity) ((capacity) / 2)
+
+string_dictionary_t *string_dictionary_create(size_t block_capacity) {
+    string_dictionary_t *const dictionary = malloc(sizeof(string_dictionary_t));
+    if (!dictionary)
+        return NULL;
+
+    dictionary->strings = string_pool_create(block_capacity);
+    if (!dictionary->strings)
+        goto DEFER_1;
+
+    dictionary->capacity = STRING_DICTIONARY_INITIAL_CAPACITY;
+    dictionary->length   = 0;
+    dictionary->entries  = calloc(dictionary->capacity, sizeof(string_dictionary_entry_t));
+    if (!dictionary->entries)
+        goto DEFER_2;
+
+    dictionary->by_code = malloc(STRING_DICTIONARY_MAX_LOAD(dictionary->capacity) *
+                                 sizeof(const char *));
+    if (!dictionary->by_code)
+        goto DEFER_3;
+
+    return dictionary;
+
+DEFER_3:
+    free(dictionary->entries);
+DEFER_2:
+    string_pool_free(dictionary->strings);
+DEFER_1:
+    free(dictionary);
+    return NULL;
+}
+
+/**
+ * @brief Doubles the number of entries in a dictionary's hash table, rehashing all of its entries.
+ * @param dictionary Dictionary to be grown.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p dictionary is left unchanged).
+ */
+int __string_dictionary_grow(string_dictionary_t *dictionary) {
+    const size_t new_capacity = dictionary->capacity * 2;
+
+    const char **const new_by_code =
+        realloc(dictionary->by_code, STRING_DICTIONARY_MAX_LOAD(new_capacity) * sizeof(char *));
+    if (!new_by_code)
+        return 1;
+    dictionary->by_code = new_by_code;
+
+    string_dictionary_entry_t *const new_entries =
+        calloc(new_capacity, sizeof(string_dictionary_entry_t));
+    if (!new_entries)
+        return 1; /* A larger ::string_dictionary::by_code array isn't a problem */
+
+    for (size_t i = 0; i < dictionary->capacity; ++i) {
+        const string_dictionary_entry_t entry = dictionary->entries[i];
+        if (!entry.code)
+            continue;
+
+        size_t position = entry.hash & (new_capacity - 1);
+        while (new_entries[position].code)
+            position = (position + 1) & (new_capacity - 1);
+        new_entries[position] = entry;
+    }
+
+    free(dictionary->entries);
+    dictionary->entries  = new_entries;
+    dictionary->capacity = new_capacity;
+    return 0;
+}
+
+int string_dictionary_encode(string_dictionary_t *dictionary,
+                             const char          *str,
+                             string_code_t       *code) {
+    size_t         length;
+    const uint32_t hash = string_pool_no_duplicates_hash(str, &length);
+
+    size_t position = hash & (dictionary->capacity - 1);
+    for (;; position = (position + 1) & (dictionary->capacity - 1)) {
+        const string_dictionary_entry_t entry = dictionary->entries[position];
+        if (!entry.code)
+            break;
+
+        if (entry.hash == hash && strcmp(dictionary->by_code[entry.code - 1], str) == 0) {
+            *code = entry.code - 1;
+            return 0;
+        }
+    }
+
+    if (dictionary->length == STRING_DICTIONARY_MAX_LENGTH)
+        return 1;
+
+    if (dictionary->length + 1 > STRING_DICTIONARY_MAX_LOAD(dictionary->capacity)) {
+        if (__string_dictionary_grow(dictionary))
+            return 1;
+
+        /* Find the new empty entry */
+        position = hash & (dictionary->capacity - 1);
+        while (dictionary->entries[position].code)
+            position = (position + 1) & (dictionary->capacity - 1);
+    }
+
+    char *const pool_string = string_pool_allocate(dictionary->strings, length);
+    if (!pool_string)
+        return 1;
+    memcpy(pool_string, str, length + 1);
+
+    dictionary->by_code[dictionary->length] = pool_string;
+    dictionary->entries[position].hash      = hash;
+    dictionary->entries[position].code      = dictionary->length + 1;
+
+    *code = dictionary->length++;
+    return 0;
+}
+
+const char *string_dictionary_decode(const string_dictionary_t *dictionary, string_code_t code) {
+    return dictionary->by_code[code];
+}
+
+size_t string_dictionary_get_length(const string_dictionary_t *dictionary) {
+    return dictionary->length;
+}
+
+size_t string_dictionary_get_memory_usage(const string_dictionary_t *dictionary) {
+    return sizeof(string_dictionary_t) + string_pool_get_memory_usage(dictionary->strings) +
+           dictionary->capacity * sizeof(string_dictionary_entry_t) +
+           STRING_DICTIONARY_MAX_LOAD(dictionary->capacity) * sizeof(char *);
+}
+
+void string_dictionary_free(string_dictionary_t *dictionary) {
+    string_pool_free(dictionary->strings);
+    free(dictionary->by_code);
+    free(dictionary->entries);
+    free(dictionary);
+}
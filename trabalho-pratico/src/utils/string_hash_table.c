@@ -0,0 +1,407 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file  string_hash_table.c
+ * @brief Implementation of methods in include/utils/string_hash_table.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref string_hash_table_examples).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/bucket_builder.h"
+#include "utils/prefetch.h"
+#include "utils/string_hash_table.h"
+
+/**
+ * @struct string_hash_table_entry_t
+ * @brief  An entry (bucket) in an ::string_hash_table_t.
+ *
+ * @var string_hash_table_entry_t::key
+ *     @brief Key of this entry.
+ * @var string_hash_table_entry_t::value
+ *     @brief Value associated with ::string_hash_table_entry_t::key.
+ * @var string_hash_table_entry_t::hash
+ *     @brief Cached hash of ::string_hash_table_entry_t::key. `0` for empty entries.
+ */
+typedef struct {
+    const char *key;
+    void       *value;
+    uint32_t    hash;
+} string_hash_table_entry_t;
+
+/**
+ * @struct string_hash_table
+ * @brief  A hash table whose keys are strings.
+ *
+ * @var string_hash_table::entries
+ *     @brief Array of ::string_hash_table::capacity entries, some of which are empty.
+ * @var string_hash_table::capacity
+ *     @brief Number of elements in ::string_hash_table::entries. Always a power of two.
+ * @var string_hash_table::length
+ *     @brief Number of non-empty elements in ::string_hash_table::entries.
+ */
+struct string_hash_table {
+    string_hash_table_entry_t *entries;
+    size_t                 capacity, length;
+};
+
+/** @brief Minimum number of entries in a ::string_hash_table_t. */
+#define STRING_HASH_TABLE_MIN_CAPACITY 16
+
+/**
+ * @brief Maximum number of entries in a ::string_hash_table_t with a given capacity (maximum load
+ *        factor of `7 / 8`).
+ */
+#define STRING_HASH_TABLE_MAX_LENGTH(capacity) ((capacity) - (capacity) / 8)
+
+/**
+ * @brief Number of entries in each region of a table that keys are partitioned into, in
+ *        ::string_hash_table_lookup_batch (384 KiB of entries, that fit in a L2 cache).
+ */
+#define STRING_HASH_TABLE_PARTITION_ENTRIES (1 << 14)
+
+uint32_t string_hash_table_hash(const char *key) {
+    uint32_t hash = 0x811c9dc5;
+    for (const unsigned char *c = (const unsigned char *) key; *c; ++c) {
+        hash ^= *c;
+        hash *= 0x01000193;
+    }
+    return hash ? hash : 1;
+}
+
+/**
+ * @brief  Calculates how far an entry is from the position its hash maps to.
+ *
+ * @param table    Hash table @p entry belongs to.
+ * @param hash     Hash in the entry.
+ * @param position Index of the entry in ::string_hash_table::entries.
+ *
+ * @return The probe sequence length of the entry.
+ */
+size_t __string_hash_table_distance(const string_hash_table_t *table,
+                                     uint32_t                   hash,
+                                     size_t                     position) {
+    return (position - (hash & (table->capacity - 1))) & (table->capacity - 1);
+}
+
+/**
+ * @brief   Places an entry whose key isn't in a table, without checking its load factor.
+ * @details Richer entries (closer to their home position) are displaced by poorer ones (Robin
+ *          Hood hashing).
+ *
+ * @param table Hash table to be modified.
+ * @param entry Entry to be placed.
+ */
+void __string_hash_table_place(string_hash_table_t *table, string_hash_table_entry_t entry) {
+    size_t position = entry.hash & (table->capacity - 1), distance = 0;
+    while (table->entries[position].hash) {
+        const size_t existing_distance =
+            __string_hash_table_distance(table, table->entries[position].hash, position);
+
+        if (existing_distance < distance) {
+            const string_hash_table_entry_t tmp = table->entries[position];
+            table->entries[position]            = entry;
+            entry                               = tmp;
+            distance                            = existing_distance;
+        }
+
+        position = (position + 1) & (table->capacity - 1);
+        distance++;
+    }
+
+    table->entries[position] = entry;
+    table->length++;
+}
+
+/**
+ * @brief  Calculates the capacity needed for a number of entries.
+ * @param  n Number of entries.
+ * @return The minimum power of two that's a valid capacity for @p n entries.
+ */
+size_t __string_hash_table_capacity_for(size_t n) {
+    size_t capacity = STRING_HASH_TABLE_MIN_CAPACITY;
+    while (STRING_HASH_TABLE_MAX_LENGTH(capacity) < n)
+        capacity *= 2;
+    return capacity;
+}
+
+/**
+ * @brief Changes the number of entries in a hash table, rehashing all of its entries.
+ *
+ * @param table    Hash table to be modified.
+ * @param capacity New capacity of @p table. Must be a power of two that can hold all of its
+ *                 entries.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p table is left unchanged).
+ */
+int __string_hash_table_resize(string_hash_table_t *table, size_t capacity) {
+    string_hash_table_entry_t *const new_entries =
+        calloc(capacity, sizeof(string_hash_table_entry_t));
+    if (!new_entries)
+        return 1;
+
+    string_hash_table_entry_t *const old_entries  = table->entries;
+    const size_t                     old_capacity = table->capacity;
+
+    table->entries  = new_entries;
+    table->capacity = capacity;
+    table->length   = 0;
+    for (size_t i = 0; i < old_capacity; ++i)
+        if (old_entries[i].hash)
+            __string_hash_table_place(table, old_entries[i]);
+
+    free(old_entries);
+    return 0;
+}
+
+string_hash_table_t *string_hash_table_create(size_t capacity) {
+    string_hash_table_t *const table = malloc(sizeof(string_hash_table_t));
+    if (!table)
+        return NULL;
+
+    table->capacity = __string_hash_table_capacity_for(capacity);
+    table->length   = 0;
+    table->entries  = calloc(table->capacity, sizeof(string_hash_table_entry_t));
+    if (!table->entries) {
+        free(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+int string_hash_table_reserve(string_hash_table_t *table, size_t n) {
+    const size_t capacity = __string_hash_table_capacity_for(n);
+    if (capacity <= table->capacity)
+        return 0;
+    return __string_hash_table_resize(table, capacity);
+}
+
+int string_hash_table_shrink_to_fit(string_hash_table_t *table) {
+    const size_t capacity = __string_hash_table_capacity_for(table->length);
+    if (capacity >= table->capacity)
+        return 0;
+    return __string_hash_table_resize(table, capacity);
+}
+
+/**
+ * @brief Finds the position of a key in a hash table.
+ *
+ * @param table    Hash table where to perform the lookup.
+ * @param key      Key to look for.
+ * @param hash     Hash of @p key (see ::string_hash_table_hash).
+ * @param position Where to output the index of the entry with @p key to.
+ *
+ * @retval 0 @p key found.
+ * @retval 1 @p key not in @p table.
+ */
+int __string_hash_table_find(const string_hash_table_t *table,
+                             const char                *key,
+                             uint32_t                   hash,
+                             size_t                    *position) {
+    size_t i = hash & (table->capacity - 1);
+
+    for (size_t distance = 0;; ++distance) {
+        const string_hash_table_entry_t *const entry = &table->entries[i];
+
+        /* Robin Hood invariant: the key would have displaced any richer entry */
+        if (!entry->hash || __string_hash_table_distance(table, entry->hash, i) < distance)
+            return 1;
+
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            *position = i;
+            return 0;
+        }
+
+        i = (i + 1) & (table->capacity - 1);
+    }
+}
+
+int string_hash_table_insert(string_hash_table_t *table, const char *key, void *value) {
+    return string_hash_table_insert_with_hash(table, key, string_hash_table_hash(key), value);
+}
+
+int string_hash_table_insert_with_hash(string_hash_table_t *table,
+                                       const char          *key,
+                                       uint32_t             hash,
+                                       void                *value) {
+    size_t position;
+    if (!__string_hash_table_find(table, key, hash, &position)) {
+        table->entries[position].value = value;
+        return 2;
+    }
+
+    if (table->length + 1 > STRING_HASH_TABLE_MAX_LENGTH(table->capacity) &&
+        __string_hash_table_resize(table, table->capacity * 2))
+        return 1;
+
+    const string_hash_table_entry_t entry = {.key = key, .value = value, .hash = hash};
+    __string_hash_table_place(table, entry);
+    return 0;
+}
+
+void *string_hash_table_lookup(const string_hash_table_t *table, const char *key) {
+    return string_hash_table_lookup_with_hash(table, key, string_hash_table_hash(key));
+}
+
+void *string_hash_table_lookup_with_hash(const string_hash_table_t *table,
+                                         const char                *key,
+                                         uint32_t                   hash) {
+    size_t position;
+    if (__string_hash_table_find(table, key, hash, &position))
+        return NULL;
+    return table->entries[position].value;
+}
+
+/**
+ * @brief Gets the values associated with many keys in a hash table, in a given order.
+ *
+ * @param table  Hash table where to perform the lookups.
+ * @param n      Number of keys to look for.
+ * @param keys   Keys to look for.
+ * @param hashes Hashes of @p keys (see ::string_hash_table_hash).
+ * @param order  Indices of the keys in @p keys, in the order they must be looked up in. `NULL` for
+ *               the order of @p keys.
+ * @param values Where to write the value associated with each key to (`NULL` for missing keys).
+ */
+void __string_hash_table_lookup_ordered(const string_hash_table_t *table,
+                                        size_t                     n,
+                                        const char *const          keys[n],
+                                        const uint32_t             hashes[n],
+                                        const size_t              *order,
+                                        void                      *values[n]) {
+
+    for (size_t begin = 0; begin < n; begin += PREFETCH_BATCH_SIZE) {
+        const size_t batch = n - begin < PREFETCH_BATCH_SIZE ? n - begin : PREFETCH_BATCH_SIZE;
+
+        for (size_t i = 0; i < batch; ++i) {
+            const size_t k = order ? order[begin + i] : begin + i;
+            prefetch_read(&table->entries[hashes[k] & (table->capacity - 1)]);
+        }
+
+        for (size_t i = 0; i < batch; ++i) {
+            const size_t k = order ? order[begin + i] : begin + i;
+            values[k]      = string_hash_table_lookup_with_hash(table, keys[k], hashes[k]);
+        }
+    }
+}
+
+/**
+ * @brief  Calculates the partition of a key in ::string_hash_table_lookup_batch.
+ *
+ * @param table Hash table where the key will be looked up.
+ * @param hash  Hash of the key.
+ *
+ * @return The index of the region of ::STRING_HASH_TABLE_PARTITION_ENTRIES entries of @p table
+ *         where the key's home position is.
+ */
+size_t __string_hash_table_partition(const string_hash_table_t *table, uint32_t hash) {
+    return (hash & (table->capacity - 1)) / STRING_HASH_TABLE_PARTITION_ENTRIES;
+}
+
+void string_hash_table_lookup_batch(const string_hash_table_t *table,
+                                    size_t                     n,
+                                    const char *const          keys[n],
+                                    void                      *values[n]) {
+
+    uint32_t *const hashes = malloc(n * sizeof(uint32_t));
+    if (!hashes) {
+        for (size_t i = 0; i < n; ++i)
+            values[i] = string_hash_table_lookup(table, keys[i]);
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        hashes[i] = string_hash_table_hash(keys[i]);
+
+    /* Partition the keys by the region of the table their home position is in */
+    const size_t      npartitions = table->capacity / STRING_HASH_TABLE_PARTITION_ENTRIES;
+    size_t           *order       = NULL;
+    bucket_builder_t *builder     = NULL;
+    if (npartitions > 1)
+        builder = bucket_builder_create(npartitions, sizeof(size_t));
+
+    if (builder) {
+        for (size_t i = 0; i < n; ++i)
+            bucket_builder_count(builder, __string_hash_table_partition(table, hashes[i]), 1);
+
+        if (!bucket_builder_allocate(builder)) {
+            for (size_t i = 0; i < n; ++i)
+                *(size_t *) bucket_builder_place(builder,
+                                                 __string_hash_table_partition(table, hashes[i]),
+                                                 1) = i;
+            order = bucket_builder_steal_items(builder);
+        }
+        bucket_builder_free(builder);
+    }
+
+    __string_hash_table_lookup_ordered(table, n, keys, hashes, order, values);
+    free(order);
+    free(hashes);
+}
+
+int string_hash_table_remove(string_hash_table_t *table, const char *key) {
+    size_t position;
+    if (__string_hash_table_find(table, key, string_hash_table_hash(key), &position))
+        return 1;
+
+    /* Backward shift deletion: move following displaced entries one position back */
+    size_t next = (position + 1) & (table->capacity - 1);
+    while (table->entries[next].hash &&
+           __string_hash_table_distance(table, table->entries[next].hash, next) > 0) {
+
+        table->entries[position] = table->entries[next];
+        position                 = next;
+        next                     = (next + 1) & (table->capacity - 1);
+    }
+
+    table->entries[position].hash = 0;
+    table->length--;
+    return 0;
+}
+
+int string_hash_table_iter(const string_hash_table_t        *table,
+                           string_hash_table_iter_callback_t callback,
+                           void                             *user_data) {
+
+    for (size_t i = 0; i < table->capacity; ++i) {
+        const string_hash_table_entry_t *const entry = &table->entries[i];
+        if (entry->hash) {
+            const int retval = callback(user_data, entry->key, entry->value);
+            if (retval)
+                return retval;
+        }
+    }
+    return 0;
+}
+
+size_t string_hash_table_get_length(const string_hash_table_t *table) {
+    return table->length;
+}
+
+size_t string_hash_table_get_memory_usage(const string_hash_table_t *table) {
+    return sizeof(string_hash_table_t) + table->capacity * sizeof(string_hash_table_entry_t);
+}
+
+void string_hash_table_free(string_hash_table_t *table) {
+    free(table->entries);
+    free(table);
+}
@@ -40,11 +40,16 @@ struct string_pool {
 };
 
 string_pool_t *string_pool_create(size_t block_capacity) {
+    return string_pool_create_with_policy(block_capacity, BLOCK_ALLOCATOR_POLICY_MALLOC);
+}
+
+string_pool_t *string_pool_create_with_policy(size_t                   block_capacity,
+                                              block_allocator_policy_t policy) {
     string_pool_t *const pool = malloc(sizeof(string_pool_t));
     if (!pool)
         return NULL;
 
-    pool->pool = pool_create(char, block_capacity);
+    pool->pool = pool_create_with_policy(char, block_capacity, policy);
     if (!pool->pool) {
         free(pool);
         return NULL;
@@ -61,10 +66,18 @@ char *string_pool_put(string_pool_t *pool, const char *str) {
     return pool_put_items(char, pool->pool, str, strlen(str) + 1);
 }
 
+void string_pool_shrink_to_fit(string_pool_t *pool) {
+    pool_shrink_to_fit(pool->pool);
+}
+
 void string_pool_empty(string_pool_t *pool) {
     pool_empty(pool->pool);
 }
 
+size_t string_pool_get_memory_usage(const string_pool_t *pool) {
+    return sizeof(string_pool_t) + pool_get_memory_usage(pool->pool);
+}
+
 void string_pool_free(string_pool_t *pool) {
     pool_free(pool->pool);
     free(pool);
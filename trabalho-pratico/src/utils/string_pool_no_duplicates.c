@@ -22,25 +22,59 @@
  * See [the header file's documentation](@ref string_pool_no_duplicates_examples).
  */
 
-#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "utils/string_pool.h"
 #include "utils/string_pool_no_duplicates.h"
 
+/**
+ * @struct string_pool_no_duplicates_entry_t
+ * @brief  An entry (bucket) in the hash table of a ::string_pool_no_duplicates_t.
+ *
+ * @var string_pool_no_duplicates_entry_t::string
+ *     @brief String in ::string_pool_no_duplicates::strings. `NULL` for empty entries.
+ * @var string_pool_no_duplicates_entry_t::hash
+ *     @brief Cached hash of ::string_pool_no_duplicates_entry_t::string.
+ * @var string_pool_no_duplicates_entry_t::length
+ *     @brief Cached length of ::string_pool_no_duplicates_entry_t::string.
+ */
+typedef struct {
+    const char *string;
+    uint32_t    hash;
+    uint32_t    length;
+} string_pool_no_duplicates_entry_t;
+
 /**
  * @struct string_pool_no_duplicates
  * @brief  A string pool with an auxiliary hash table to prevent string duplicate allocations.
+ * @details The hash table uses open addressing with linear probing. Hashes and lengths are cached
+ *          in each entry, so that probing rarely needs to compare strings.
  *
  * @var string_pool_no_duplicates::strings
  *   @brief Pool where the strings are stored.
- * @var string_pool_no_duplicates::already_stored
- *   @brief Hash table that contains all the strings that have been stored.
+ * @var string_pool_no_duplicates::entries
+ *   @brief Array of ::string_pool_no_duplicates::capacity entries, some of which are empty.
+ * @var string_pool_no_duplicates::capacity
+ *   @brief Number of elements in ::string_pool_no_duplicates::entries. Always a power of two.
+ * @var string_pool_no_duplicates::length
+ *   @brief Number of strings stored in the pool.
  */
 struct string_pool_no_duplicates {
-    string_pool_t *strings;
-    GHashTable    *already_stored;
+    string_pool_t                     *strings;
+    string_pool_no_duplicates_entry_t *entries;
+    size_t                             capacity, length;
 };
 
+/** @brief Initial number of entries in ::string_pool_no_duplicates::entries. */
+#define STRING_POOL_NO_DUPLICATES_INITIAL_CAPACITY 256
+
+/**
+ * @brief Maximum number of strings in a ::string_pool_no_duplicates_t with a given capacity
+ *        (maximum load factor of `3 / 4`).
+ */
+#define STRING_POOL_NO_DUPLICATES_MAX_LENGTH(capacity) ((capacity) - (capacity) / 4)
+
 string_pool_no_duplicates_t *string_pool_no_duplicates_create(size_t block_capacity) {
     string_pool_no_duplicates_t *const no_dups_pool =
         malloc(sizeof(struct string_pool_no_duplicates));
@@ -52,27 +86,123 @@ string_pool_no_duplicates_t *string_pool_no_duplicates_create(size_t block_capac
         free(no_dups_pool);
         return NULL;
     }
-    no_dups_pool->already_stored = g_hash_table_new(g_str_hash, g_str_equal);
+
+    no_dups_pool->capacity = STRING_POOL_NO_DUPLICATES_INITIAL_CAPACITY;
+    no_dups_pool->length   = 0;
+    no_dups_pool->entries =
+        calloc(no_dups_pool->capacity, sizeof(string_pool_no_duplicates_entry_t));
+    if (!no_dups_pool->entries) {
+        string_pool_free(no_dups_pool->strings);
+        free(no_dups_pool);
+        return NULL;
+    }
 
     return no_dups_pool;
 }
 
-const char *string_pool_no_duplicates_put(string_pool_no_duplicates_t *pool, const char *str) {
-    const char *const data = g_hash_table_lookup(pool->already_stored, str);
-    if (!data) {
-        char *const pool_string = string_pool_put(pool->strings, str);
-        if (!pool_string)
-            return NULL;
-
-        g_hash_table_insert(pool->already_stored, pool_string, pool_string);
-        return pool_string;
+uint32_t string_pool_no_duplicates_hash(const char *str, size_t *length) {
+    /* 32-bit FNV-1a */
+    uint32_t    hash = 2166136261u;
+    const char *c    = str;
+    for (; *c; ++c) {
+        hash ^= (unsigned char) *c;
+        hash *= 16777619u;
+    }
+
+    *length = c - str;
+    return hash;
+}
+
+/**
+ * @brief Places an entry whose string isn't in a pool's hash table, without checking its load
+ *        factor.
+ *
+ * @param pool  Pool whose hash table is to be modified.
+ * @param entry Entry to be placed.
+ */
+void __string_pool_no_duplicates_place(string_pool_no_duplicates_t      *pool,
+                                       string_pool_no_duplicates_entry_t entry) {
+    size_t position = entry.hash & (pool->capacity - 1);
+    while (pool->entries[position].string)
+        position = (position + 1) & (pool->capacity - 1);
+
+    pool->entries[position] = entry;
+    pool->length++;
+}
+
+/**
+ * @brief Doubles the number of entries in a pool's hash table, rehashing all of its entries.
+ * @param pool Pool whose hash table is to be grown.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure (@p pool is left unchanged).
+ */
+int __string_pool_no_duplicates_grow(string_pool_no_duplicates_t *pool) {
+    const size_t                             new_capacity = pool->capacity * 2;
+    string_pool_no_duplicates_entry_t *const new_entries =
+        calloc(new_capacity, sizeof(string_pool_no_duplicates_entry_t));
+    if (!new_entries)
+        return 1;
+
+    string_pool_no_duplicates_entry_t *const old_entries  = pool->entries;
+    const size_t                             old_capacity = pool->capacity;
+
+    pool->entries  = new_entries;
+    pool->capacity = new_capacity;
+    pool->length   = 0;
+    for (size_t i = 0; i < old_capacity; ++i)
+        if (old_entries[i].string)
+            __string_pool_no_duplicates_place(pool, old_entries[i]);
+
+    free(old_entries);
+    return 0;
+}
+
+const char *string_pool_no_duplicates_put_hashed(string_pool_no_duplicates_t *pool,
+                                                 const char                  *str,
+                                                 size_t                       length,
+                                                 uint32_t                     hash) {
+
+    for (size_t i = hash & (pool->capacity - 1);; i = (i + 1) & (pool->capacity - 1)) {
+        const string_pool_no_duplicates_entry_t *const entry = &pool->entries[i];
+        if (!entry->string)
+            break;
+
+        if (entry->hash == hash && entry->length == length &&
+            memcmp(entry->string, str, length) == 0)
+            return entry->string;
     }
 
-    return data;
+    if (pool->length + 1 > STRING_POOL_NO_DUPLICATES_MAX_LENGTH(pool->capacity) &&
+        __string_pool_no_duplicates_grow(pool))
+        return NULL;
+
+    char *const pool_string = string_pool_allocate(pool->strings, length);
+    if (!pool_string)
+        return NULL;
+    memcpy(pool_string, str, length);
+    pool_string[length] = '\0';
+
+    const string_pool_no_duplicates_entry_t entry = {.string = pool_string,
+                                                     .hash   = hash,
+                                                     .length = length};
+    __string_pool_no_duplicates_place(pool, entry);
+    return pool_string;
+}
+
+const char *string_pool_no_duplicates_put(string_pool_no_duplicates_t *pool, const char *str) {
+    size_t         length;
+    const uint32_t hash = string_pool_no_duplicates_hash(str, &length);
+    return string_pool_no_duplicates_put_hashed(pool, str, length, hash);
+}
+
+size_t string_pool_no_duplicates_get_memory_usage(const string_pool_no_duplicates_t *pool) {
+    return sizeof(string_pool_no_duplicates_t) + string_pool_get_memory_usage(pool->strings) +
+           pool->capacity * sizeof(string_pool_no_duplicates_entry_t);
 }
 
 void string_pool_no_duplicates_free(string_pool_no_duplicates_t *pool) {
     string_pool_free(pool->strings);
-    g_hash_table_destroy(pool->already_stored);
+    free(pool->entries);
     free(pool);
 }
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  t_digest.c
+ * @brief Implementation of methods in include/utils/t_digest.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref t_digest_examples).
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "utils/t_digest.h"
+
+/** @brief The value of pi (`M_PI` isn't part of C99 nor POSIX). */
+#define T_DIGEST_PI 3.14159265358979323846
+
+/**
+ * @struct t_digest_centroid_t
+ * @brief  A summary of close values in a ::t_digest_t.
+ *
+ * @var t_digest_centroid_t::mean
+ *     @brief Mean of the values in the centroid.
+ * @var t_digest_centroid_t::weight
+ *     @brief Number of values in the centroid.
+ */
+typedef struct {
+    double mean, weight;
+} t_digest_centroid_t;
+
+/**
+ * @struct t_digest
+ * @brief  Approximate quantiles of a stream of values.
+ *
+ * @var t_digest::centroids
+ *     @brief   Merged centroids, followed by buffered values (centroids with a weight of `1`).
+ *     @details Only sorted by mean after ::__t_digest_compress.
+ * @var t_digest::length
+ *     @brief Number of centroids in ::t_digest::centroids.
+ * @var t_digest::capacity
+ *     @brief Number of centroids that fit in ::t_digest::centroids.
+ * @var t_digest::merged
+ *     @brief Whether ::t_digest::centroids is sorted and has no buffered values.
+ * @var t_digest::total_weight
+ *     @brief Number of values added to the digest.
+ * @var t_digest::min
+ *     @brief Minimum value added to the digest.
+ * @var t_digest::max
+ *     @brief Maximum value added to the digest.
+ */
+struct t_digest {
+    t_digest_centroid_t *centroids;
+    size_t               length, capacity;
+    int                  merged;
+    double               total_weight, min, max;
+};
+
+/**
+ * @brief   Compression factor of all digests.
+ * @details Higher values mean more centroids (more memory and accuracy). A merged digest has, at
+ *          most, this many centroids (plus one).
+ */
+#define T_DIGEST_COMPRESSION 100.0
+
+/**
+ * @brief   Maximum number of centroids (merged and buffered) in a digest.
+ * @details Must be much larger than ::T_DIGEST_COMPRESSION, so that there's always space for
+ *          buffered values after merging.
+ */
+#define T_DIGEST_MAX_CAPACITY 512
+
+/** @brief Number of centroids allocated when the first value is added. */
+#define T_DIGEST_INITIAL_CAPACITY 16
+
+t_digest_t *t_digest_create(void) {
+    t_digest_t *const digest = malloc(sizeof(t_digest_t));
+    if (!digest)
+        return NULL;
+
+    digest->centroids    = NULL;
+    digest->length       = 0;
+    digest->capacity     = 0;
+    digest->merged       = 1;
+    digest->total_weight = 0;
+    digest->min          = INFINITY;
+    digest->max          = -INFINITY;
+    return digest;
+}
+
+/**
+ * @brief Comparison function for sorting ::t_digest_centroid_t's by mean with `qsort`.
+ *
+ * @param a Pointer to a ::t_digest_centroid_t.
+ * @param b Pointer to a ::t_digest_centroid_t.
+ *
+ * @return A negative number, `0` or a positive number, as is needed by `qsort`.
+ */
+int __t_digest_centroid_compare(const void *a, const void *b) {
+    const double mean_a = ((const t_digest_centroid_t *) a)->mean;
+    const double mean_b = ((const t_digest_centroid_t *) b)->mean;
+    return (mean_a > mean_b) - (mean_a < mean_b);
+}
+
+/**
+ * @brief   Scale function (`k1` in the paper), that maps a quantile to a centroid index.
+ * @details A centroid can't span more than one unit of this function.
+ *
+ * @param q Quantile, between `0` and `1`.
+ *
+ * @return The (fractional) index of the centroid that contains @p q.
+ */
+double __t_digest_q_to_k(double q) {
+    return T_DIGEST_COMPRESSION / (2 * T_DIGEST_PI) * asin(2 * q - 1);
+}
+
+/**
+ * @brief Inverse of ::__t_digest_q_to_k.
+ * @param k Centroid index.
+ * @return The quantile where the centroid with index @p k starts.
+ */
+double __t_digest_k_to_q(double k) {
+    return (sin(k * 2 * T_DIGEST_PI / T_DIGEST_COMPRESSION) + 1) / 2;
+}
+
+/**
+ * @brief Sorts the centroids in a digest and merges the adjacent ones that are small enough.
+ * @param digest Digest to be compressed.
+ */
+void __t_digest_compress(t_digest_t *digest) {
+    if (digest->merged)
+        return;
+
+    if (digest->length == 0) {
+        digest->merged = 1;
+        return;
+    }
+
+    qsort(digest->centroids,
+          digest->length,
+          sizeof(t_digest_centroid_t),
+          __t_digest_centroid_compare);
+
+    /* Merged centroids are written in place, never ahead of the ones still being read */
+    const double total         = digest->total_weight;
+    double       weight_so_far = 0;
+    double       weight_limit  = total * __t_digest_k_to_q(__t_digest_q_to_k(0) + 1);
+
+    size_t length = 0;
+    for (size_t i = 1; i < digest->length; ++i) {
+        t_digest_centroid_t *const       current = &digest->centroids[length];
+        const t_digest_centroid_t *const next    = &digest->centroids[i];
+
+        if (weight_so_far + current->weight + next->weight <= weight_limit) {
+            const double weight = current->weight + next->weight;
+            current->mean += (next->mean - current->mean) * next->weight / weight;
+            current->weight = weight;
+        } else {
+            weight_so_far += current->weight;
+            weight_limit = total * __t_digest_k_to_q(__t_digest_q_to_k(weight_so_far / total) + 1);
+            digest->centroids[++length] = *next;
+        }
+    }
+
+    digest->length = length + 1;
+    digest->merged = 1;
+}
+
+/**
+ * @brief Adds a centroid to a digest, compressing it if it's full.
+ *
+ * @param digest   Digest to be modified.
+ * @param centroid Centroid to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __t_digest_add_centroid(t_digest_t *digest, t_digest_centroid_t centroid) {
+    if (digest->length == digest->capacity) {
+        if (digest->capacity == T_DIGEST_MAX_CAPACITY) {
+            __t_digest_compress(digest);
+        } else {
+            const size_t new_capacity =
+                digest->capacity ? digest->capacity * 2 : T_DIGEST_INITIAL_CAPACITY;
+            t_digest_centroid_t *const new_centroids =
+                realloc(digest->centroids, new_capacity * sizeof(t_digest_centroid_t));
+            if (!new_centroids)
+                return 1;
+
+            digest->centroids = new_centroids;
+            digest->capacity  = new_capacity;
+        }
+    }
+
+    digest->centroids[digest->length++] = centroid;
+    digest->merged                      = 0;
+    return 0;
+}
+
+int t_digest_add(t_digest_t *digest, double value) {
+    /* Total weight is updated first, as it's needed when compressing */
+    digest->total_weight++;
+    if (__t_digest_add_centroid(digest, (t_digest_centroid_t) {.mean = value, .weight = 1})) {
+        digest->total_weight--;
+        return 1;
+    }
+
+    digest->min = fmin(digest->min, value);
+    digest->max = fmax(digest->max, value);
+    return 0;
+}
+
+int t_digest_merge(t_digest_t *digest, const t_digest_t *other) {
+    digest->total_weight += other->total_weight;
+    for (size_t i = 0; i < other->length; ++i) {
+        if (__t_digest_add_centroid(digest, other->centroids[i])) {
+            /* Keep the digest consistent, with the centroids that were added */
+            for (size_t j = i; j < other->length; ++j)
+                digest->total_weight -= other->centroids[j].weight;
+            return 1;
+        }
+    }
+
+    digest->min = fmin(digest->min, other->min);
+    digest->max = fmax(digest->max, other->max);
+    return 0;
+}
+
+size_t t_digest_get_count(const t_digest_t *digest) {
+    return (size_t) digest->total_weight;
+}
+
+double t_digest_quantile(t_digest_t *digest, double q, double *error) {
+    __t_digest_compress(digest);
+
+    const t_digest_centroid_t *const centroids = digest->centroids;
+    const size_t                     n         = digest->length;
+    const double                     target    = q * digest->total_weight;
+
+    /* Each centroid is assumed to be centered on its cumulative weight */
+    double left_value = digest->min, left_position = 0, left_weight = 1;
+    double center = 0;
+    for (size_t i = 0; i < n; ++i) {
+        center += centroids[i].weight / 2;
+
+        if (target < center) {
+            const double right_value = centroids[i].mean;
+            const double fraction =
+                center > left_position ? (target - left_position) / (center - left_position) : 0;
+            const double estimate = left_value + (right_value - left_value) * fraction;
+
+            if (error) {
+                if (left_weight <= 1 && centroids[i].weight <= 1) /* Single values */
+                    *error = 0;
+                else
+                    *error = fmax(estimate - left_value, right_value - estimate);
+            }
+            return estimate;
+        }
+
+        left_value    = centroids[i].mean;
+        left_position = center;
+        left_weight   = centroids[i].weight;
+        center += centroids[i].weight / 2;
+    }
+
+    /* Past the last centroid's center, interpolate towards the maximum */
+    const double fraction = digest->total_weight > left_position
+                                ? (target - left_position) / (digest->total_weight - left_position)
+                                : 0;
+    const double estimate = left_value + (digest->max - left_value) * fmin(fraction, 1);
+    if (error)
+        *error = left_weight <= 1 ? estimate - left_value : digest->max - left_value;
+    return estimate;
+}
+
+size_t t_digest_get_memory_usage(const t_digest_t *digest) {
+    return sizeof(t_digest_t) + digest->capacity * sizeof(t_digest_centroid_t);
+}
+
+void t_digest_free(t_digest_t *digest) {
+    if (!digest)
+        return;
+
+    free(digest->centroids);
+    free(digest);
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  table_stream.c
+ * @brief Implementation of methods in include/utils/table_stream.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref table_stream_examples).
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+
+#include "interactive_mode/ncurses_utils.h"
+#include "utils/table_stream.h"
+
+/** @brief Maximum size of the text of a cell (including its null terminator). */
+#define TABLE_STREAM_CELL_SIZE 256
+
+/**
+ * @struct table_stream
+ * @brief  A table that is drawn one row at a time.
+ *
+ * @var table_stream::output
+ *     @brief Where the table is drawn to.
+ * @var table_stream::width
+ *     @brief Number of columns in the table.
+ * @var table_stream::column_widths
+ *     @brief Width of each column in the table, including padding.
+ * @var table_stream::cells
+ *     @brief   Text of each cell in the current row.
+ *     @details Cell `x` starts at `cells + x * TABLE_STREAM_CELL_SIZE`.
+ * @var table_stream::cell_set
+ *     @brief Whether the text of each cell in the current row has been set.
+ * @var table_stream::rows
+ *     @brief Number of rows drawn so far.
+ */
+struct table_stream {
+    FILE  *output;
+    size_t width;
+
+    size_t *column_widths;
+    char   *cells;
+    int    *cell_set;
+    size_t  rows;
+};
+
+table_stream_t *table_stream_create(FILE *output, size_t width) {
+    if (width < 2)
+        return NULL;
+
+    table_stream_t *const stream = malloc(sizeof(table_stream_t));
+    if (!stream)
+        goto DEFER_1;
+
+    stream->column_widths = malloc(sizeof(size_t) * width);
+    if (!stream->column_widths)
+        goto DEFER_2;
+
+    stream->cells = malloc(TABLE_STREAM_CELL_SIZE * width);
+    if (!stream->cells)
+        goto DEFER_3;
+
+    stream->cell_set = calloc(width, sizeof(int));
+    if (!stream->cell_set)
+        goto DEFER_4;
+
+    for (size_t i = 0; i < width; ++i)
+        stream->column_widths[i] = 3; /* " - " */
+
+    stream->output = output;
+    stream->width  = width;
+    stream->rows   = 0;
+    return stream;
+
+DEFER_4:
+    free(stream->cells);
+DEFER_3:
+    free(stream->column_widths);
+DEFER_2:
+    free(stream);
+DEFER_1:
+    return NULL;
+}
+
+void table_stream_fit_column(table_stream_t *stream, size_t x, const char *format, ...) {
+    if (x >= stream->width || stream->rows)
+        return;
+
+    va_list printf_args;
+    va_start(printf_args, format);
+
+    char text[TABLE_STREAM_CELL_SIZE];
+    vsnprintf(text, TABLE_STREAM_CELL_SIZE, format, printf_args);
+    va_end(printf_args);
+
+    const size_t width = ncurses_measure_string(text) + 2; /* + 2 -> padding */
+    if (width > stream->column_widths[x])
+        stream->column_widths[x] = width;
+}
+
+int table_stream_set_cell(table_stream_t *stream, size_t x, const char *format, ...) {
+    if (x >= stream->width)
+        return 1;
+
+    va_list printf_args;
+    va_start(printf_args, format);
+    vsnprintf(stream->cells + x * TABLE_STREAM_CELL_SIZE,
+              TABLE_STREAM_CELL_SIZE,
+              format,
+              printf_args);
+    va_end(printf_args);
+
+    stream->cell_set[x] = 1;
+    return 0;
+}
+
+/**
+ * @brief Draws a division line in a table stream.
+ *
+ * @param stream          Table stream to be drawn.
+ * @param ends            The character to be drawn at the extremities of each column.
+ * @param filler          The character to be drawn multiple times (the same as the width of the
+ *                        column), in between @p ends characters.
+ * @param starting_column Column in which to start drawing the line.
+ */
+void __table_stream_draw_line(table_stream_t *stream,
+                              char            ends,
+                              char            filler,
+                              size_t          starting_column) {
+    /* The left of the header is blank */
+    for (size_t i = 0; i < starting_column; ++i)
+        fprintf(stream->output, " %*s", (int) stream->column_widths[i], "");
+
+    for (size_t i = starting_column; i < stream->width; i++) {
+        fputc(ends, stream->output);
+        for (size_t j = 0; j < stream->column_widths[i]; j++)
+            fputc(filler, stream->output);
+    }
+
+    fprintf(stream->output, "%c\n", ends);
+}
+
+/**
+ * @brief Draws the text of the cells in the current row of a table stream.
+ *
+ * @param stream          Table stream to be drawn.
+ * @param starting_column Column in which to start drawing the text.
+ */
+void __table_stream_draw_cells(table_stream_t *stream, size_t starting_column) {
+    for (size_t i = 0; i < starting_column; ++i)
+        fprintf(stream->output, " %*s", (int) stream->column_widths[i], "");
+
+    for (size_t i = starting_column; i < stream->width; ++i) {
+        if (stream->cell_set[i]) {
+            fprintf(stream->output,
+                    "| %*s ",
+                    (int) stream->column_widths[i] - 2,
+                    stream->cells + i * TABLE_STREAM_CELL_SIZE);
+        } else {
+            const int first_half  = stream->column_widths[i] / 2;
+            const int second_half = stream->column_widths[i] - first_half - 1;
+            fprintf(stream->output, "|%*s-%*s", first_half, "", second_half, "");
+        }
+    }
+
+    fprintf(stream->output, "|\n");
+}
+
+void table_stream_end_row(table_stream_t *stream) {
+    if (!stream->rows) {
+        /* Draw the table's header */
+        __table_stream_draw_line(stream, '+', '-', 1);
+        __table_stream_draw_line(stream, '|', ' ', 1);
+        __table_stream_draw_cells(stream, 1);
+        __table_stream_draw_line(stream, '|', ' ', 1);
+        __table_stream_draw_line(stream, '+', '-', 0);
+    } else {
+        __table_stream_draw_line(stream, '|', ' ', 0);
+        __table_stream_draw_cells(stream, 0);
+        __table_stream_draw_line(stream, '|', ' ', 0);
+        __table_stream_draw_line(stream, '+', '-', 0);
+    }
+
+    for (size_t i = 0; i < stream->width; ++i)
+        stream->cell_set[i] = 0;
+    stream->rows++;
+}
+
+void table_stream_free(table_stream_t *stream) {
+    free(stream->cell_set);
+    free(stream->cells);
+    free(stream->column_widths);
+    free(stream);
+}
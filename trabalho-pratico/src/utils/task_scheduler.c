@@ -0,0 +1,411 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  task_scheduler.c
+ * @brief Implementation of methods in include/utils/task_scheduler.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref task_scheduler_examples).
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/cancellation.h"
+#include "utils/task_scheduler.h"
+#include "utils/thread_pool.h"
+
+/**
+ * @struct task_scheduler_task_t
+ * @brief  A task waiting to be run.
+ *
+ * @var task_scheduler_task_t::callback
+ *     @brief Method called to run the task.
+ * @var task_scheduler_task_t::user_data
+ *     @brief `user_data` parameter for ::task_scheduler_task_t::callback.
+ * @var task_scheduler_task_t::index
+ *     @brief `index` parameter for ::task_scheduler_task_t::callback.
+ */
+typedef struct {
+    task_scheduler_callback_t callback;
+    void                     *user_data;
+    size_t                    index;
+} task_scheduler_task_t;
+
+/**
+ * @struct  task_scheduler_worker_t
+ * @brief   A thread running tasks, and its queue of tasks.
+ * @details The queue is a slice of ::task_scheduler_worker_t::tasks, from
+ *          ::task_scheduler_worker_t::front to ::task_scheduler_worker_t::back. The owner of the
+ *          queue pushes and pops from the back, while other workers steal from the front.
+ *
+ * @var task_scheduler_worker_t::lock
+ *     @brief Lock that protects the queue from concurrent pushes, pops and steals.
+ * @var task_scheduler_worker_t::tasks
+ *     @brief Array of ::task_scheduler_worker_t::capacity tasks, containing the queue.
+ * @var task_scheduler_worker_t::front
+ *     @brief Index of the task in the front of the queue.
+ * @var task_scheduler_worker_t::back
+ *     @brief Index after the task in the back of the queue.
+ * @var task_scheduler_worker_t::capacity
+ *     @brief Number of tasks ::task_scheduler_worker_t::tasks can hold.
+ * @var task_scheduler_worker_t::scheduler
+ *     @brief Scheduler the worker belongs to.
+ * @var task_scheduler_worker_t::index
+ *     @brief Index of the worker in ::task_scheduler::workers.
+ * @var task_scheduler_worker_t::thread
+ *     @brief Thread running the worker (only if ::task_scheduler_worker_t::is_thread, and the
+ *            worker isn't running in the shared thread pool).
+ * @var task_scheduler_worker_t::future
+ *     @brief Task running the worker in the shared thread pool (only if
+ *            ::task_scheduler_worker_t::is_thread, and the pool is available).
+ * @var task_scheduler_worker_t::is_thread
+ *     @brief Whether this worker is running in a thread other than the calling one.
+ */
+typedef struct {
+    pthread_mutex_t        lock;
+    task_scheduler_task_t *tasks;
+    size_t                 front, back, capacity;
+
+    task_scheduler_t     *scheduler;
+    size_t                index;
+    pthread_t             thread;
+    thread_pool_future_t *future;
+    int                   is_thread;
+} task_scheduler_worker_t;
+
+/**
+ * @struct task_scheduler
+ * @brief  A set of workers running tasks.
+ *
+ * @var task_scheduler::workers
+ *     @brief Array of ::task_scheduler::nworkers workers.
+ * @var task_scheduler::nworkers
+ *     @brief Number of elements in ::task_scheduler::workers.
+ * @var task_scheduler::topology
+ *     @brief NUMA nodes to pin worker threads to. Can be `NULL`, for threads not to be pinned.
+ * @var task_scheduler::cancellation
+ *     @brief Current cancellation of the thread that started the scheduler, inherited by all
+ *            worker threads (see ::cancellation_set_current).
+ * @var task_scheduler::lock
+ *     @brief Lock that protects ::task_scheduler::pending and ::task_scheduler::generation.
+ * @var task_scheduler::idle
+ *     @brief Condition variable that idle workers wait on, signaled when tasks are spawned and
+ *            when all tasks are over.
+ * @var task_scheduler::pending
+ *     @brief Number of tasks that haven't finished yet (waiting or running).
+ * @var task_scheduler::generation
+ *     @brief Number of tasks spawned so far, so that idle workers know when a new task may be
+ *            available.
+ */
+struct task_scheduler {
+    task_scheduler_worker_t *workers;
+    size_t                   nworkers;
+    const numa_topology_t   *topology;
+    const cancellation_t    *cancellation;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  idle;
+    size_t          pending, generation;
+};
+
+/**
+ * @brief Adds a task to the back of the queue of a worker.
+ *
+ * @param worker Worker to add the task to.
+ * @param task   Task to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __task_scheduler_worker_push(task_scheduler_worker_t *worker, task_scheduler_task_t task) {
+    pthread_mutex_lock(&worker->lock);
+
+    if (worker->back == worker->capacity) {
+        if (worker->front > 0) {
+            /* Reuse space left by stolen tasks */
+            memmove(worker->tasks,
+                    worker->tasks + worker->front,
+                    (worker->back - worker->front) * sizeof(task_scheduler_task_t));
+            worker->back -= worker->front;
+            worker->front = 0;
+        } else {
+            const size_t new_capacity = worker->capacity ? worker->capacity * 2 : 16;
+            task_scheduler_task_t *const new_tasks =
+                realloc(worker->tasks, new_capacity * sizeof(task_scheduler_task_t));
+            if (!new_tasks) {
+                pthread_mutex_unlock(&worker->lock);
+                return 1;
+            }
+
+            worker->tasks    = new_tasks;
+            worker->capacity = new_capacity;
+        }
+    }
+
+    worker->tasks[worker->back++] = task;
+    pthread_mutex_unlock(&worker->lock);
+    return 0;
+}
+
+/**
+ * @brief Takes a task from the queue of a worker.
+ *
+ * @param worker Worker to take the task from.
+ * @param steal  Whether to take the task from the front (another worker stealing it), instead of
+ *               from the back (the owner of the queue).
+ * @param task   Where to output the task to.
+ *
+ * @retval 0 Success.
+ * @retval 1 Empty queue.
+ */
+int __task_scheduler_worker_pop(task_scheduler_worker_t *worker,
+                                int                      steal,
+                                task_scheduler_task_t   *task) {
+    pthread_mutex_lock(&worker->lock);
+
+    const int empty = worker->front == worker->back;
+    if (!empty)
+        *task = steal ? worker->tasks[worker->front++] : worker->tasks[--worker->back];
+
+    pthread_mutex_unlock(&worker->lock);
+    return empty;
+}
+
+/**
+ * @brief Finds a task to run, in the queue of a worker or, if it's empty, in other queues.
+ *
+ * @param worker Worker that will run the task.
+ * @param task   Where to output the task to.
+ *
+ * @retval 0 Success.
+ * @retval 1 All queues are empty.
+ */
+int __task_scheduler_find_task(task_scheduler_worker_t *worker, task_scheduler_task_t *task) {
+    if (!__task_scheduler_worker_pop(worker, 0, task))
+        return 0;
+
+    /* Start stealing from the next worker, so that thieves don't all pick the same victim */
+    task_scheduler_t *const scheduler = worker->scheduler;
+    for (size_t i = 1; i < scheduler->nworkers; ++i) {
+        task_scheduler_worker_t *const victim =
+            &scheduler->workers[(worker->index + i) % scheduler->nworkers];
+        if (!__task_scheduler_worker_pop(victim, 1, task))
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief  Entry point of a worker, that runs tasks until all of them are over.
+ * @param  worker_data A pointer to a ::task_scheduler_worker_t.
+ * @return `NULL`.
+ */
+void *__task_scheduler_worker(void *worker_data) {
+    task_scheduler_worker_t *const worker    = worker_data;
+    task_scheduler_t *const        scheduler = worker->scheduler;
+
+    while (1) {
+        pthread_mutex_lock(&scheduler->lock);
+        const size_t generation = scheduler->generation;
+        pthread_mutex_unlock(&scheduler->lock);
+
+        task_scheduler_task_t task;
+        if (__task_scheduler_find_task(worker, &task)) {
+            /* Wait for new tasks to be spawned, or for the running ones to finish */
+            pthread_mutex_lock(&scheduler->lock);
+            while (scheduler->pending && scheduler->generation == generation)
+                pthread_cond_wait(&scheduler->idle, &scheduler->lock);
+            const int done = scheduler->pending == 0;
+            pthread_mutex_unlock(&scheduler->lock);
+
+            if (done)
+                break;
+            continue;
+        }
+
+        task.callback(scheduler, worker->index, task.user_data, task.index);
+
+        pthread_mutex_lock(&scheduler->lock);
+        if (--scheduler->pending == 0)
+            pthread_cond_broadcast(&scheduler->idle);
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   Entry point of a worker running in its own thread.
+ * @details When there's a ::task_scheduler::topology, workers are split into contiguous blocks,
+ *          one per NUMA node, and pinned to it. Workers steal from the ones that follow them
+ *          first, so tasks tend to be stolen from workers in the same node.
+ *
+ * @param  worker_data A pointer to a ::task_scheduler_worker_t.
+ * @return `NULL`.
+ */
+void *__task_scheduler_worker_thread(void *worker_data) {
+    task_scheduler_worker_t *const worker    = worker_data;
+    task_scheduler_t *const        scheduler = worker->scheduler;
+
+    if (scheduler->topology) {
+        const size_t nnodes = numa_topology_get_node_count(scheduler->topology);
+        const size_t node   = worker->index * nnodes / scheduler->nworkers;
+        numa_topology_pin_thread(scheduler->topology, node); /* Run anyway if pinning fails */
+    }
+
+    cancellation_set_current(scheduler->cancellation);
+    return __task_scheduler_worker(worker);
+}
+
+/**
+ * @brief   Entry point of a worker running in a task of the shared thread pool.
+ * @details Threads of the pool are already pinned to NUMA nodes, and they inherit the cancellation
+ *          of the thread that started the scheduler.
+ *
+ * @param  worker_data A pointer to a ::task_scheduler_worker_t.
+ * @return `0`.
+ */
+int __task_scheduler_worker_task(void *worker_data) {
+    __task_scheduler_worker(worker_data);
+    return 0;
+}
+
+int task_scheduler_spawn(task_scheduler_t         *scheduler,
+                         size_t                    worker,
+                         task_scheduler_callback_t callback,
+                         void                     *user_data,
+                         size_t                    index) {
+
+    const task_scheduler_task_t task = {.callback  = callback,
+                                        .user_data = user_data,
+                                        .index     = index};
+    if (__task_scheduler_worker_push(&scheduler->workers[worker], task))
+        return 1;
+
+    /* The spawning task is still pending, so no worker can have stopped yet */
+    pthread_mutex_lock(&scheduler->lock);
+    scheduler->pending++;
+    scheduler->generation++;
+    pthread_cond_broadcast(&scheduler->idle);
+    pthread_mutex_unlock(&scheduler->lock);
+    return 0;
+}
+
+int task_scheduler_run(size_t                    nthreads,
+                       size_t                    ntasks,
+                       task_scheduler_callback_t callback,
+                       void                     *user_data) {
+    return task_scheduler_run_pinned(NULL, nthreads, ntasks, callback, user_data);
+}
+
+int task_scheduler_run_pinned(const numa_topology_t    *topology,
+                              size_t                    nthreads,
+                              size_t                    ntasks,
+                              task_scheduler_callback_t callback,
+                              void                     *user_data) {
+    if (ntasks == 0)
+        return 0;
+    if (nthreads == 0)
+        nthreads = 1;
+    if (nthreads > ntasks)
+        nthreads = ntasks;
+
+    int retval = 1;
+
+    task_scheduler_t scheduler = {.nworkers     = 0,
+                                  .topology     = topology,
+                                  .cancellation = cancellation_get_current(),
+                                  .pending      = ntasks,
+                                  .generation   = 0};
+    scheduler.workers          = malloc(nthreads * sizeof(task_scheduler_worker_t));
+    if (!scheduler.workers)
+        goto DEFER_1;
+
+    if (pthread_mutex_init(&scheduler.lock, NULL))
+        goto DEFER_2;
+    if (pthread_cond_init(&scheduler.idle, NULL))
+        goto DEFER_3;
+
+    for (; scheduler.nworkers < nthreads; ++scheduler.nworkers) {
+        task_scheduler_worker_t *const worker = &scheduler.workers[scheduler.nworkers];
+        if (pthread_mutex_init(&worker->lock, NULL))
+            goto DEFER_4;
+
+        worker->scheduler = &scheduler;
+        worker->index     = scheduler.nworkers;
+        worker->is_thread = 0;
+
+        /* Tasks are pushed in reverse, for each worker to run its share of tasks in order */
+        const size_t count = (ntasks - scheduler.nworkers + nthreads - 1) / nthreads;
+        worker->tasks      = malloc(count * sizeof(task_scheduler_task_t));
+        worker->front      = 0;
+        worker->back       = count;
+        worker->capacity   = count;
+        if (!worker->tasks) {
+            pthread_mutex_destroy(&worker->lock);
+            goto DEFER_4;
+        }
+
+        for (size_t k = 0; k < count; ++k)
+            worker->tasks[count - 1 - k] =
+                (task_scheduler_task_t){.callback  = callback,
+                                        .user_data = user_data,
+                                        .index     = scheduler.nworkers + k * nthreads};
+    }
+
+    /* The first worker is always the calling thread, and the others run in the shared pool */
+    thread_pool_t *const pool = scheduler.nworkers > 1 ? thread_pool_get_shared() : NULL;
+    for (size_t i = 1; i < scheduler.nworkers; ++i) {
+        task_scheduler_worker_t *const worker = &scheduler.workers[i];
+        if (pool) {
+            worker->future    = thread_pool_submit(pool, __task_scheduler_worker_task, worker);
+            worker->is_thread = worker->future != NULL;
+        } else {
+            worker->is_thread =
+                !pthread_create(&worker->thread, NULL, __task_scheduler_worker_thread, worker);
+        }
+    }
+
+    /* Tasks of workers whose threads couldn't be created will be stolen */
+    __task_scheduler_worker(&scheduler.workers[0]);
+    for (size_t i = 1; i < scheduler.nworkers; ++i) {
+        if (!scheduler.workers[i].is_thread)
+            continue;
+
+        if (pool)
+            thread_pool_future_wait(scheduler.workers[i].future); /* Runs it if it didn't start */
+        else
+            pthread_join(scheduler.workers[i].thread, NULL);
+    }
+    retval = 0;
+
+DEFER_4:
+    for (size_t i = 0; i < scheduler.nworkers; ++i) {
+        free(scheduler.workers[i].tasks);
+        pthread_mutex_destroy(&scheduler.workers[i].lock);
+    }
+    pthread_cond_destroy(&scheduler.idle);
+DEFER_3:
+    pthread_mutex_destroy(&scheduler.lock);
+DEFER_2:
+    free(scheduler.workers);
+DEFER_1:
+    return retval;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  thread_count.c
+ * @brief Implementation of methods in include/utils/thread_count.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref thread_count_examples).
+ */
+
+#include <unistd.h>
+
+#include "utils/thread_count.h"
+
+/**
+ * @brief   Limit set with ::thread_count_set (`0` for no limit).
+ * @details This global variable is justified for the following reasons:
+ *
+ *          -# It's only modified before parallel work starts;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# Thread counts are chosen deep inside many modules (e.g.: the dataset parser), that
+ *             would otherwise all need a new parameter passed down from the program's entry point.
+ */
+size_t __thread_count_limit = 0;
+
+size_t thread_count_get(void) {
+    const long   ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t count = ncpus > 0 ? (size_t) ncpus : 1;
+    return __thread_count_limit && __thread_count_limit < count ? __thread_count_limit : count;
+}
+
+void thread_count_set(size_t limit) {
+    __thread_count_limit = limit;
+}
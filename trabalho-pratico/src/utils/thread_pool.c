@@ -0,0 +1,683 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  thread_pool.c
+ * @brief Implementation of methods in include/utils/thread_pool.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref thread_pool_examples).
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/cancellation.h"
+#include "utils/thread_count.h"
+#include "utils/thread_pool.h"
+
+/** @brief State of a ::thread_pool_future_t. */
+typedef enum {
+    THREAD_POOL_FUTURE_PENDING, /**< @brief Waiting in the queue of a worker. */
+    THREAD_POOL_FUTURE_RUNNING, /**< @brief Taken from its queue, and being run. */
+    THREAD_POOL_FUTURE_DONE     /**< @brief Finished running. */
+} thread_pool_future_state_t;
+
+/**
+ * @struct thread_pool_future
+ * @brief  A task submitted to a ::thread_pool_t.
+ *
+ * @var thread_pool_future::pool
+ *     @brief Pool the task was submitted to.
+ * @var thread_pool_future::callback
+ *     @brief Method called to run the task.
+ * @var thread_pool_future::user_data
+ *     @brief `user_data` parameter for ::thread_pool_future::callback.
+ * @var thread_pool_future::cancellation
+ *     @brief Current cancellation of the thread that submitted the task, inherited by the thread
+ *            that runs it (see ::cancellation_set_current).
+ * @var thread_pool_future::queue
+ *     @brief Index of the worker whose queue the task was pushed to.
+ * @var thread_pool_future::state
+ *     @brief   State of the task.
+ *     @details Only left ::THREAD_POOL_FUTURE_PENDING while holding the lock of the task's queue,
+ *              and only set to ::THREAD_POOL_FUTURE_DONE while holding ::thread_pool::lock.
+ * @var thread_pool_future::retval
+ *     @brief Value returned by ::thread_pool_future::callback.
+ */
+struct thread_pool_future {
+    thread_pool_t         *pool;
+    thread_pool_callback_t callback;
+    void                  *user_data;
+    const cancellation_t  *cancellation;
+
+    size_t                     queue;
+    thread_pool_future_state_t state;
+    int                        retval;
+};
+
+/**
+ * @struct  thread_pool_worker_t
+ * @brief   A worker thread, and its queue of tasks.
+ * @details The queue is a slice of ::thread_pool_worker_t::tasks, from
+ *          ::thread_pool_worker_t::front to ::thread_pool_worker_t::back. The owner of the queue
+ *          pops from the back, while other workers steal from the front. Tasks run by the thread
+ *          that waits for them are removed from the middle of the queue, leaving `NULL` behind.
+ *
+ * @var thread_pool_worker_t::lock
+ *     @brief Lock that protects the queue from concurrent pushes, pops and steals.
+ * @var thread_pool_worker_t::tasks
+ *     @brief Array of ::thread_pool_worker_t::capacity tasks, containing the queue.
+ * @var thread_pool_worker_t::front
+ *     @brief Index of the task in the front of the queue.
+ * @var thread_pool_worker_t::back
+ *     @brief Index after the task in the back of the queue.
+ * @var thread_pool_worker_t::capacity
+ *     @brief Number of tasks ::thread_pool_worker_t::tasks can hold.
+ * @var thread_pool_worker_t::pool
+ *     @brief Pool the worker belongs to.
+ * @var thread_pool_worker_t::index
+ *     @brief Index of the worker in ::thread_pool::workers.
+ * @var thread_pool_worker_t::thread
+ *     @brief Thread running the worker (only if ::thread_pool_worker_t::is_thread).
+ * @var thread_pool_worker_t::is_thread
+ *     @brief   Whether the worker's thread was created.
+ *     @details Tasks in the queue of a worker without a thread are stolen by the others.
+ */
+typedef struct {
+    pthread_mutex_t        lock;
+    thread_pool_future_t **tasks;
+    size_t                 front, back, capacity;
+
+    thread_pool_t *pool;
+    size_t         index;
+    pthread_t      thread;
+    int            is_thread;
+} thread_pool_worker_t;
+
+/**
+ * @struct thread_pool
+ * @brief  A fixed set of worker threads, running submitted tasks.
+ *
+ * @var thread_pool::workers
+ *     @brief Array of ::thread_pool::nworkers workers.
+ * @var thread_pool::nworkers
+ *     @brief Number of elements in ::thread_pool::workers.
+ * @var thread_pool::nthreads
+ *     @brief Number of workers whose thread was created.
+ * @var thread_pool::topology
+ *     @brief NUMA nodes to pin worker threads to. Can be `NULL`, for threads not to be pinned.
+ * @var thread_pool::affinity
+ *     @brief How to pin worker threads to the processors in ::thread_pool::topology.
+ * @var thread_pool::lock
+ *     @brief Lock that protects ::thread_pool::generation, ::thread_pool::next_queue,
+ *            ::thread_pool::shutdown and finishing tasks.
+ * @var thread_pool::work
+ *     @brief Condition variable that idle workers wait on, signaled when tasks are submitted and
+ *            when the pool is freed.
+ * @var thread_pool::finished
+ *     @brief Condition variable that threads waiting for tasks wait on, signaled when tasks finish.
+ * @var thread_pool::generation
+ *     @brief Number of tasks submitted so far, so that idle workers know when a new task may be
+ *            available.
+ * @var thread_pool::next_queue
+ *     @brief Worker to push the next task submitted from outside the pool to.
+ * @var thread_pool::shutdown
+ *     @brief Whether ::thread_pool_free was called, and workers must stop once queues are empty.
+ */
+struct thread_pool {
+    thread_pool_worker_t  *workers;
+    size_t                 nworkers, nthreads;
+    const numa_topology_t *topology;
+    thread_pool_affinity_t affinity;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  work, finished;
+    size_t          generation, next_queue;
+    int             shutdown;
+};
+
+/**
+ * @brief   Key of the ::thread_pool_worker_t every thread is running (`NULL` outside of pools).
+ * @details Shall not be modified apart from its creation. This global variable is justified for
+ *          the following reasons:
+ *
+ *          -# It's not modified (no mutable global state). Each thread has its own value;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# Tasks submitted from inside a task should go to the queue of the worker running it,
+ *             but tasks don't know which worker that is.
+ */
+pthread_key_t __thread_pool_current_worker;
+
+/** @brief Whether ::__thread_pool_current_worker was successfully created. */
+int __thread_pool_has_current_worker = 0;
+
+/**
+ * @brief   The pool returned by ::thread_pool_get_shared (`NULL` before it's created).
+ * @details This global variable is justified for the following reasons:
+ *
+ *          -# It's only modified once (on creation, or after `fork`), while holding
+ *             ::__thread_pool_shared_lock;
+ *          -# It's module-local (no breaking of encapsulation);
+ *          -# Parallel work deep inside other modules (e.g.: iterations through pools) must share
+ *             the same workers, without all callers having to pass a pool around.
+ */
+thread_pool_t *__thread_pool_shared = NULL;
+
+/** @brief NUMA topology that workers of ::__thread_pool_shared are pinned to. */
+numa_topology_t *__thread_pool_shared_topology = NULL;
+
+/** @brief Whether ::__thread_pool_shared couldn't be created, and shouldn't be tried again. */
+int __thread_pool_shared_failed = 0;
+
+/** @brief Lock that protects ::__thread_pool_shared. */
+pthread_mutex_t __thread_pool_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief   Forgets the shared pool in a process created with `fork`.
+ * @details Only the thread that called `fork` exists in the new process, so the parent's pool has
+ *          no workers, and its locks may have been held by threads that don't exist anymore. The
+ *          memory of the parent's pool is left behind.
+ */
+void __thread_pool_after_fork(void) {
+    __thread_pool_shared        = NULL;
+    __thread_pool_shared_failed = 0;
+    pthread_mutex_init(&__thread_pool_shared_lock, NULL);
+}
+
+/**
+ * @brief Automatically creates ::__thread_pool_current_worker, and registers
+ *        ::__thread_pool_after_fork, when the program starts.
+ */
+void __attribute__((constructor)) __thread_pool_init(void) {
+    __thread_pool_has_current_worker = !pthread_key_create(&__thread_pool_current_worker, NULL);
+    pthread_atfork(NULL, NULL, __thread_pool_after_fork);
+}
+
+/** @brief Automatically deletes ::__thread_pool_current_worker when the program terminates. */
+void __attribute__((destructor)) __thread_pool_deinit(void) {
+    if (__thread_pool_has_current_worker)
+        pthread_key_delete(__thread_pool_current_worker);
+}
+
+/**
+ * @brief Adds a task to the back of the queue of a worker.
+ *
+ * @param worker Worker to add the task to.
+ * @param future Task to be added.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __thread_pool_worker_push(thread_pool_worker_t *worker, thread_pool_future_t *future) {
+    pthread_mutex_lock(&worker->lock);
+
+    if (worker->back == worker->capacity) {
+        if (worker->front > 0) {
+            /* Reuse space left by stolen tasks */
+            memmove(worker->tasks,
+                    worker->tasks + worker->front,
+                    (worker->back - worker->front) * sizeof(thread_pool_future_t *));
+            worker->back -= worker->front;
+            worker->front = 0;
+        } else {
+            const size_t new_capacity = worker->capacity ? worker->capacity * 2 : 16;
+            thread_pool_future_t **const new_tasks =
+                realloc(worker->tasks, new_capacity * sizeof(thread_pool_future_t *));
+            if (!new_tasks) {
+                pthread_mutex_unlock(&worker->lock);
+                return 1;
+            }
+
+            worker->tasks    = new_tasks;
+            worker->capacity = new_capacity;
+        }
+    }
+
+    future->queue                 = worker->index;
+    worker->tasks[worker->back++] = future;
+    pthread_mutex_unlock(&worker->lock);
+    return 0;
+}
+
+/**
+ * @brief Takes a task from the queue of a worker, marking it as running.
+ *
+ * @param worker Worker to take the task from.
+ * @param steal  Whether to take the task from the front (another worker stealing it), instead of
+ *               from the back (the owner of the queue).
+ *
+ * @return The task taken from the queue, or `NULL` if it's empty.
+ */
+thread_pool_future_t *__thread_pool_worker_pop(thread_pool_worker_t *worker, int steal) {
+    pthread_mutex_lock(&worker->lock);
+
+    /* Skip tasks already taken by the threads waiting for them */
+    thread_pool_future_t *future = NULL;
+    while (!future && worker->front != worker->back)
+        future = steal ? worker->tasks[worker->front++] : worker->tasks[--worker->back];
+
+    if (future)
+        future->state = THREAD_POOL_FUTURE_RUNNING;
+
+    pthread_mutex_unlock(&worker->lock);
+    return future;
+}
+
+/**
+ * @brief Takes a task that hasn't started yet from its queue, so that it can be run by the thread
+ *        waiting for it.
+ *
+ * @param future Task to be taken.
+ *
+ * @retval 0 The task was taken, and is now marked as running.
+ * @retval 1 The task was already taken by a worker.
+ */
+int __thread_pool_claim(thread_pool_future_t *future) {
+    thread_pool_worker_t *const worker = &future->pool->workers[future->queue];
+    pthread_mutex_lock(&worker->lock);
+
+    int retval = 1;
+    if (future->state == THREAD_POOL_FUTURE_PENDING) {
+        for (size_t i = worker->front; i < worker->back; ++i) {
+            if (worker->tasks[i] == future) {
+                worker->tasks[i] = NULL;
+                break;
+            }
+        }
+
+        future->state = THREAD_POOL_FUTURE_RUNNING;
+        retval        = 0;
+    }
+
+    pthread_mutex_unlock(&worker->lock);
+    return retval;
+}
+
+/**
+ * @brief Finds a task to run, in the queue of a worker or, if it's empty, in other queues.
+ * @param worker Worker that will run the task.
+ * @return A task marked as running, or `NULL` if all queues are empty.
+ */
+thread_pool_future_t *__thread_pool_find_task(thread_pool_worker_t *worker) {
+    thread_pool_future_t *const future = __thread_pool_worker_pop(worker, 0);
+    if (future)
+        return future;
+
+    /* Start stealing from the next worker, so that thieves don't all pick the same victim */
+    thread_pool_t *const pool = worker->pool;
+    for (size_t i = 1; i < pool->nworkers; ++i) {
+        thread_pool_worker_t *const victim  = &pool->workers[(worker->index + i) % pool->nworkers];
+        thread_pool_future_t *const stolen = __thread_pool_worker_pop(victim, 1);
+        if (stolen)
+            return stolen;
+    }
+    return NULL;
+}
+
+/**
+ * @brief   Runs a task marked as running, and marks it as done.
+ * @details @p future mustn't be accessed after this, as the thread waiting for it may free it.
+ *
+ * @param future Task to be run.
+ */
+void __thread_pool_run(thread_pool_future_t *future) {
+    thread_pool_t *const pool = future->pool;
+
+    const cancellation_t *const previous = cancellation_get_current();
+    cancellation_set_current(future->cancellation);
+    const int retval = future->callback(future->user_data);
+    cancellation_set_current(previous);
+
+    pthread_mutex_lock(&pool->lock);
+    future->retval = retval;
+    future->state  = THREAD_POOL_FUTURE_DONE;
+    pthread_cond_broadcast(&pool->finished);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief   Entry point of a worker thread, that runs tasks until the pool is freed.
+ * @details When there's a ::thread_pool::topology, workers are split into contiguous blocks, one
+ *          per NUMA node, and pinned to it (or to a processor in it). Workers steal from the ones
+ *          that follow them first, so tasks tend to be stolen from workers in the same node.
+ *
+ * @param  worker_data A pointer to a ::thread_pool_worker_t.
+ * @return `NULL`.
+ */
+void *__thread_pool_worker_thread(void *worker_data) {
+    thread_pool_worker_t *const worker = worker_data;
+    thread_pool_t *const        pool   = worker->pool;
+
+    if (__thread_pool_has_current_worker)
+        pthread_setspecific(__thread_pool_current_worker, worker);
+
+    if (pool->topology && pool->affinity != THREAD_POOL_AFFINITY_NONE) {
+        const size_t nnodes = numa_topology_get_node_count(pool->topology);
+        const size_t node   = worker->index * nnodes / pool->nworkers;
+
+        /* Run anyway if pinning fails */
+        if (pool->affinity == THREAD_POOL_AFFINITY_PROCESSOR) {
+            const size_t first = (node * pool->nworkers + nnodes - 1) / nnodes;
+            numa_topology_pin_thread_to_processor(pool->topology, node, worker->index - first);
+        } else {
+            numa_topology_pin_thread(pool->topology, node);
+        }
+    }
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        const size_t generation = pool->generation;
+        const int    shutdown   = pool->shutdown;
+        pthread_mutex_unlock(&pool->lock);
+
+        thread_pool_future_t *const future = __thread_pool_find_task(worker);
+        if (future) {
+            __thread_pool_run(future);
+            continue;
+        } else if (shutdown) {
+            break;
+        }
+
+        /* Wait for new tasks to be submitted, or for the pool to be freed */
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == generation)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+thread_pool_t *thread_pool_create(size_t                 nthreads,
+                                  const numa_topology_t *topology,
+                                  thread_pool_affinity_t affinity) {
+    if (nthreads == 0)
+        nthreads = 1;
+
+    thread_pool_t *const pool = malloc(sizeof(thread_pool_t));
+    if (!pool)
+        goto DEFER_1;
+
+    pool->workers = malloc(nthreads * sizeof(thread_pool_worker_t));
+    if (!pool->workers)
+        goto DEFER_2;
+
+    pool->nworkers   = 0;
+    pool->nthreads   = 0;
+    pool->topology   = topology;
+    pool->affinity   = affinity;
+    pool->generation = 0;
+    pool->next_queue = 0;
+    pool->shutdown   = 0;
+
+    if (pthread_mutex_init(&pool->lock, NULL))
+        goto DEFER_3;
+    if (pthread_cond_init(&pool->work, NULL))
+        goto DEFER_4;
+    if (pthread_cond_init(&pool->finished, NULL))
+        goto DEFER_5;
+
+    /* All queues must exist before any worker starts stealing */
+    for (; pool->nworkers < nthreads; ++pool->nworkers) {
+        thread_pool_worker_t *const worker = &pool->workers[pool->nworkers];
+        if (pthread_mutex_init(&worker->lock, NULL))
+            break;
+
+        worker->tasks     = NULL;
+        worker->front     = 0;
+        worker->back      = 0;
+        worker->capacity  = 0;
+        worker->pool      = pool;
+        worker->index     = pool->nworkers;
+        worker->is_thread = 0;
+    }
+
+    for (size_t i = 0; i < pool->nworkers; ++i) {
+        thread_pool_worker_t *const worker = &pool->workers[i];
+        worker->is_thread =
+            !pthread_create(&worker->thread, NULL, __thread_pool_worker_thread, worker);
+        pool->nthreads += worker->is_thread;
+    }
+
+    if (pool->nthreads == 0) {
+        thread_pool_free(pool);
+        return NULL;
+    }
+    return pool;
+
+DEFER_5:
+    pthread_cond_destroy(&pool->work);
+DEFER_4:
+    pthread_mutex_destroy(&pool->lock);
+DEFER_3:
+    free(pool->workers);
+DEFER_2:
+    free(pool);
+DEFER_1:
+    return NULL;
+}
+
+thread_pool_t *thread_pool_get_shared(void) {
+    pthread_mutex_lock(&__thread_pool_shared_lock);
+
+    if (!__thread_pool_shared && !__thread_pool_shared_failed) {
+        /* The topology survives fork, so it's kept even if a new pool has to be created */
+        if (!__thread_pool_shared_topology)
+            __thread_pool_shared_topology = numa_topology_create(); /* Unpinned on failure */
+
+        /* With a single thread, there's no one to share work with */
+        const size_t nthreads = thread_count_get();
+        if (nthreads > 1)
+            __thread_pool_shared = thread_pool_create(nthreads - 1,
+                                                      __thread_pool_shared_topology,
+                                                      THREAD_POOL_AFFINITY_NODE);
+        __thread_pool_shared_failed = !__thread_pool_shared;
+    }
+
+    thread_pool_t *const pool = __thread_pool_shared;
+    pthread_mutex_unlock(&__thread_pool_shared_lock);
+    return pool;
+}
+
+size_t thread_pool_get_thread_count(const thread_pool_t *pool) {
+    return pool->nthreads;
+}
+
+/**
+ * @brief Initializes a task, that hasn't been submitted yet.
+ *
+ * @param future    Task to be initialized.
+ * @param pool      Pool the task will be submitted to.
+ * @param callback  Method called to run the task.
+ * @param user_data Pointer passed to @p callback.
+ */
+void __thread_pool_future_init(thread_pool_future_t  *future,
+                               thread_pool_t         *pool,
+                               thread_pool_callback_t callback,
+                               void                  *user_data) {
+    future->pool         = pool;
+    future->callback     = callback;
+    future->user_data    = user_data;
+    future->cancellation = cancellation_get_current();
+    future->queue        = 0;
+    future->state        = THREAD_POOL_FUTURE_PENDING;
+    future->retval       = 0;
+}
+
+/**
+ * @brief   Submits an initialized task to its pool.
+ * @details Tasks submitted from a worker of the pool go to the worker's own queue. Other tasks are
+ *          dealt to workers in a round-robin fashion.
+ *
+ * @param future Task initialized with ::__thread_pool_future_init.
+ *
+ * @retval 0 Success.
+ * @retval 1 Allocation failure.
+ */
+int __thread_pool_push(thread_pool_future_t *future) {
+    thread_pool_t *const pool = future->pool;
+
+    thread_pool_worker_t *worker =
+        __thread_pool_has_current_worker ? pthread_getspecific(__thread_pool_current_worker) : NULL;
+    if (!worker || worker->pool != pool) {
+        pthread_mutex_lock(&pool->lock);
+        worker = &pool->workers[pool->next_queue++ % pool->nworkers];
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    if (__thread_pool_worker_push(worker, future))
+        return 1;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->generation++;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+/**
+ * @brief   Waits for a submitted task to finish, without freeing it.
+ * @details If the task hasn't started yet, it's run in the calling thread.
+ *
+ * @param future Task to wait for.
+ *
+ * @return The value returned by the task.
+ */
+int __thread_pool_wait(thread_pool_future_t *future) {
+    if (!__thread_pool_claim(future)) {
+        __thread_pool_run(future);
+        return future->retval;
+    }
+
+    thread_pool_t *const pool = future->pool;
+    pthread_mutex_lock(&pool->lock);
+    while (future->state != THREAD_POOL_FUTURE_DONE)
+        pthread_cond_wait(&pool->finished, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    return future->retval;
+}
+
+thread_pool_future_t *
+    thread_pool_submit(thread_pool_t *pool, thread_pool_callback_t callback, void *user_data) {
+
+    thread_pool_future_t *const future = malloc(sizeof(thread_pool_future_t));
+    if (!future)
+        return NULL;
+
+    __thread_pool_future_init(future, pool, callback, user_data);
+    if (__thread_pool_push(future)) {
+        free(future);
+        return NULL;
+    }
+    return future;
+}
+
+int thread_pool_future_wait(thread_pool_future_t *future) {
+    const int retval = __thread_pool_wait(future);
+    free(future);
+    return retval;
+}
+
+/**
+ * @struct thread_pool_block_t
+ * @brief  A sub-range of indices processed by a task in ::thread_pool_parallel_for.
+ *
+ * @var thread_pool_block_t::callback
+ *     @brief Method called for the sub-range.
+ * @var thread_pool_block_t::user_data
+ *     @brief `user_data` parameter for ::thread_pool_block_t::callback.
+ * @var thread_pool_block_t::begin
+ *     @brief First index in the sub-range.
+ * @var thread_pool_block_t::end
+ *     @brief Index after the last one in the sub-range.
+ */
+typedef struct {
+    parallel_for_callback_t callback;
+    void                   *user_data;
+    size_t                  begin, end;
+} thread_pool_block_t;
+
+/**
+ * @brief  Task that processes a sub-range of indices in ::thread_pool_parallel_for.
+ * @param  block_data A pointer to a ::thread_pool_block_t.
+ * @return The value returned by ::thread_pool_block_t::callback.
+ */
+int __thread_pool_block_task(void *block_data) {
+    const thread_pool_block_t *const block = block_data;
+    return block->callback(block->user_data, block->begin, block->end);
+}
+
+int thread_pool_parallel_for(thread_pool_t          *pool,
+                             size_t                  n,
+                             size_t                  nblocks,
+                             parallel_for_callback_t callback,
+                             void *const            *user_data) {
+    if (nblocks == 0)
+        nblocks = 1;
+
+    thread_pool_block_t  blocks[nblocks];
+    thread_pool_future_t futures[nblocks];
+    int                  submitted[nblocks];
+    for (size_t i = 0; i < nblocks; ++i) {
+        blocks[i] = (thread_pool_block_t){.callback  = callback,
+                                          .user_data = user_data[i],
+                                          .begin     = n * i / nblocks,
+                                          .end       = n * (i + 1) / nblocks};
+        __thread_pool_future_init(&futures[i], pool, __thread_pool_block_task, &blocks[i]);
+
+        /* The first sub-range is always processed in the calling thread */
+        submitted[i] = i > 0 && blocks[i].begin < blocks[i].end && !__thread_pool_push(&futures[i]);
+    }
+
+    int retval = 0;
+    for (size_t i = 0; i < nblocks; ++i) {
+        int block_retval = 0;
+        if (submitted[i])
+            block_retval = __thread_pool_wait(&futures[i]);
+        else if (blocks[i].begin < blocks[i].end)
+            block_retval = __thread_pool_block_task(&blocks[i]);
+
+        if (!retval)
+            retval = block_retval;
+    }
+    return retval;
+}
+
+void thread_pool_free(thread_pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    /* Workers may still be stealing from the queues of the others */
+    for (size_t i = 0; i < pool->nworkers; ++i)
+        if (pool->workers[i].is_thread)
+            pthread_join(pool->workers[i].thread, NULL);
+
+    for (size_t i = 0; i < pool->nworkers; ++i) {
+        free(pool->workers[i].tasks);
+        pthread_mutex_destroy(&pool->workers[i].lock);
+    }
+
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
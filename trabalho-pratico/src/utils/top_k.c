@@ -0,0 +1,173 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  top_k.c
+ * @brief Implementation of methods in include/utils/top_k.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref top_k_examples).
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "utils/int_utils.h"
+#include "utils/parallel_sort.h"
+#include "utils/top_k.h"
+
+/**
+ * @brief Swaps two elements of an array.
+ *
+ * @param a    Pointer to the first element.
+ * @param b    Pointer to the second element.
+ * @param size Size of each element, in bytes.
+ */
+void __top_k_swap(char *a, char *b, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        const char tmp = a[i];
+        a[i]           = b[i];
+        b[i]           = tmp;
+    }
+}
+
+/**
+ * @brief   Restores the heap property of a subtree, whose children are already heaps.
+ * @details The heap is a max-heap: its root is the element that comes last according to
+ *          @p compare.
+ *
+ * @param heap    Array of elements in the heap.
+ * @param n       Number of elements in @p heap.
+ * @param size    Size of each element, in bytes.
+ * @param i       Index of the root of the subtree.
+ * @param compare Function that establishes the order of elements.
+ */
+void __top_k_sift_down(char *heap, size_t n, size_t size, size_t i, top_k_compare_t compare) {
+    while (1) {
+        const size_t left = 2 * i + 1, right = left + 1;
+        size_t       largest = i;
+
+        if (left < n && compare(heap + left * size, heap + largest * size) > 0)
+            largest = left;
+        if (right < n && compare(heap + right * size, heap + largest * size) > 0)
+            largest = right;
+        if (largest == i)
+            return;
+
+        __top_k_swap(heap + i * size, heap + largest * size, size);
+        i = largest;
+    }
+}
+
+void top_k_select(void *base, size_t n, size_t size, size_t k, top_k_compare_t compare) {
+    /* A heap isn't worth it when most of the array is needed */
+    if (2 * k >= n) {
+        parallel_sort(base, n, size, compare, 0);
+        return;
+    }
+
+    char *const items = base;
+    if (k == 0)
+        return;
+
+    /* Keep the first k elements seen in a heap, whose root is the worst of them */
+    for (size_t i = k / 2; i-- > 0;)
+        __top_k_sift_down(items, k, size, i, compare);
+
+    for (size_t i = k; i < n; ++i) {
+        if (compare(items + i * size, items) < 0) {
+            __top_k_swap(items + i * size, items, size);
+            __top_k_sift_down(items, k, size, 0, compare);
+        }
+    }
+
+    /* Heap sort, as the worst remaining element is always at the root */
+    for (size_t end = k - 1; end > 0; --end) {
+        __top_k_swap(items, items + end * size, size);
+        __top_k_sift_down(items, end, size, 0, compare);
+    }
+}
+
+/**
+ * @struct top_k_array
+ * @brief  An array whose prefix is sorted as needed, so that it can be read by many threads.
+ *
+ * @var top_k_array::lock
+ *     @brief Lock that protects the unsorted part of ::top_k_array::items and
+ *            ::top_k_array::sorted from being modified by multiple threads at the same time.
+ * @var top_k_array::items
+ *     @brief Elements in the array.
+ * @var top_k_array::n
+ *     @brief Number of elements in ::top_k_array::items.
+ * @var top_k_array::size
+ *     @brief Size of each element, in bytes.
+ * @var top_k_array::sorted
+ *     @brief Number of elements at the beginning of ::top_k_array::items that are already sorted,
+ *            and that come before every other element.
+ * @var top_k_array::compare
+ *     @brief Function that establishes the order of elements.
+ */
+struct top_k_array {
+    pthread_mutex_t lock;
+    char           *items;
+    size_t          n, size, sorted;
+    top_k_compare_t compare;
+};
+
+top_k_array_t *top_k_array_create(void *items, size_t n, size_t size, top_k_compare_t compare) {
+    top_k_array_t *const ret = malloc(sizeof(top_k_array_t));
+    if (!ret) {
+        free(items);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&ret->lock, NULL)) {
+        free(items);
+        free(ret);
+        return NULL;
+    }
+
+    ret->items   = items;
+    ret->n       = n;
+    ret->size    = size;
+    ret->sorted  = 0;
+    ret->compare = compare;
+    return ret;
+}
+
+const void *top_k_array_get(top_k_array_t *array, size_t k, size_t *out_n) {
+    pthread_mutex_lock(&array->lock);
+    if (k > array->sorted && array->sorted < array->n) {
+        /* Only reorder what comes after the sorted prefix, as other threads may be reading it */
+        top_k_select(array->items + array->sorted * array->size,
+                     array->n - array->sorted,
+                     array->size,
+                     k - array->sorted,
+                     array->compare);
+        array->sorted = min(k, array->n);
+    }
+    pthread_mutex_unlock(&array->lock);
+
+    *out_n = min(k, array->n);
+    return array->items;
+}
+
+void top_k_array_free(top_k_array_t *array) {
+    pthread_mutex_destroy(&array->lock);
+    free(array->items);
+    free(array);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2023 Humberto Gomes, José Lopes, José Matos
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file  varint.c
+ * @brief Implementation of methods in include/utils/varint.h
+ *
+ * ### Examples
+ * See [the header file's documentation](@ref varint_examples).
+ */
+
+#include "utils/varint.h"
+
+/**
+ * @brief Zigzag-encodes the difference between two values.
+ *
+ * @param previous Value before @p value.
+ * @param value    Value to be encoded.
+ *
+ * @return `2 * (value - previous)` for non-negative differences, and
+ *         `-2 * (value - previous) - 1` for negative ones.
+ */
+uint32_t __varint_zigzag(uint32_t previous, uint32_t value) {
+    const uint32_t delta = value - previous;
+    return (delta << 1) ^ (uint32_t) -(delta >> 31);
+}
+
+size_t varint_encode_deltas(const uint32_t *values, size_t n, uint8_t *out) {
+    uint8_t *const begin    = out;
+    uint32_t       previous = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t zigzag = __varint_zigzag(previous, values[i]);
+        while (zigzag >= 0x80) {
+            *out++   = (uint8_t) (zigzag | 0x80);
+            zigzag >>= 7;
+        }
+        *out++   = (uint8_t) zigzag;
+        previous = values[i];
+    }
+    return (size_t) (out - begin);
+}
+
+size_t varint_get_encoded_length(const uint32_t *values, size_t n) {
+    size_t   length   = 0;
+    uint32_t previous = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t zigzag = __varint_zigzag(previous, values[i]);
+        do {
+            length++;
+            zigzag >>= 7;
+        } while (zigzag);
+        previous = values[i];
+    }
+    return length;
+}
+
+const uint8_t *varint_decode_deltas(const uint8_t *in, size_t n, uint32_t *out) {
+    uint32_t previous = 0;
+    for (size_t i = 0; i < n; ++i) {
+        /* Fast path for small differences, that fit in a single byte */
+        uint32_t zigzag = *in++;
+        if (zigzag & 0x80) {
+            zigzag &= 0x7f;
+            for (int shift = 7;; shift += 7) {
+                const uint8_t byte  = *in++;
+                zigzag             |= (uint32_t) (byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    break;
+            }
+        }
+
+        previous += (zigzag >> 1) ^ (uint32_t) -(zigzag & 1);
+        out[i]    = previous;
+    }
+    return in;
+}